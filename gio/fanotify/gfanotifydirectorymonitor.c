@@ -0,0 +1,518 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* A recursive directory monitor built on fanotify.
+ *
+ * Unlike inotify, which needs one watch per directory, a single
+ * FAN_MARK_FILESYSTEM mark reports every directory entry change on the
+ * filesystem holding the monitored directory.  With FAN_REPORT_DFID_NAME
+ * each event carries the file handle of the parent directory plus the
+ * name of the entry; we turn the handle back into a path with
+ * open_by_handle_at() and drop events that fall outside the monitored
+ * tree.  As the lookup happens when the event is read, a directory that
+ * was renamed in the meantime is reported under its new name.
+ * Directories mounted below the monitored one are not covered.
+ *
+ * Marking a whole filesystem and resolving handles both need
+ * CAP_SYS_ADMIN (and CAP_DAC_READ_SEARCH), so is_supported() probes for
+ * them once and the backend is only picked for G_FILE_MONITOR_RECURSIVE.
+ */
+
+#include "config.h"
+
+#include "gfanotifydirectorymonitor.h"
+#include <gio/giomodule.h>
+#include <glib-unix.h>
+#include "glib-private.h"
+
+#include <sys/fanotify.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define EVENT_BUFFER_SIZE 65536
+
+/* Handle to path lookups are cached; the cache is simply dropped when it
+ * grows past this or whenever a directory is moved or removed.
+ */
+#define DIR_CACHE_MAX_ENTRIES 4096
+
+#define FANOTIFY_INIT_FLAGS (FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME)
+
+struct _GFanotifyDirectoryMonitor
+{
+  GLocalDirectoryMonitor parent_instance;
+
+  gint        fanotify_fd;
+  gint        mount_fd;
+  GSource    *source;
+  gchar      *buffer;
+  gchar      *root;
+  gsize       root_len;
+  GHashTable *dir_cache;
+};
+
+/* Protects against the event callback running in the worker thread
+ * while the monitor is being cancelled.
+ */
+G_LOCK_DEFINE_STATIC (fanotify_lock);
+
+static gboolean g_fanotify_directory_monitor_cancel (GFileMonitor* monitor);
+
+#define g_fanotify_directory_monitor_get_type _g_fanotify_directory_monitor_get_type
+G_DEFINE_TYPE_WITH_CODE (GFanotifyDirectoryMonitor, g_fanotify_directory_monitor, G_TYPE_LOCAL_DIRECTORY_MONITOR,
+			 g_io_extension_point_implement (G_RECURSIVE_DIRECTORY_MONITOR_EXTENSION_POINT_NAME,
+							 g_define_type_id,
+							 "fanotify",
+							 20))
+
+static void
+g_fanotify_directory_monitor_stop (GFanotifyDirectoryMonitor *fanotify_monitor)
+{
+  G_LOCK (fanotify_lock);
+
+  if (fanotify_monitor->source)
+    {
+      g_source_destroy (fanotify_monitor->source);
+      g_source_unref (fanotify_monitor->source);
+      fanotify_monitor->source = NULL;
+    }
+
+  if (fanotify_monitor->fanotify_fd != -1)
+    {
+      close (fanotify_monitor->fanotify_fd);
+      fanotify_monitor->fanotify_fd = -1;
+    }
+
+  if (fanotify_monitor->mount_fd != -1)
+    {
+      close (fanotify_monitor->mount_fd);
+      fanotify_monitor->mount_fd = -1;
+    }
+
+  g_clear_pointer (&fanotify_monitor->dir_cache, g_hash_table_unref);
+  g_clear_pointer (&fanotify_monitor->buffer, g_free);
+
+  G_UNLOCK (fanotify_lock);
+}
+
+static void
+g_fanotify_directory_monitor_finalize (GObject *object)
+{
+  GFanotifyDirectoryMonitor *fanotify_monitor = G_FANOTIFY_DIRECTORY_MONITOR (object);
+
+  g_fanotify_directory_monitor_stop (fanotify_monitor);
+  g_free (fanotify_monitor->root);
+
+  G_OBJECT_CLASS (g_fanotify_directory_monitor_parent_class)->finalize (object);
+}
+
+static gchar *
+resolve_directory_handle (GFanotifyDirectoryMonitor *fanotify_monitor,
+                          struct file_handle        *handle)
+{
+  GBytes *key;
+  gchar *path;
+  gchar proc_path[32];
+  gchar buf[PATH_MAX];
+  gssize len;
+  gint fd;
+
+  key = g_bytes_new (handle, sizeof (struct file_handle) + handle->handle_bytes);
+
+  path = g_hash_table_lookup (fanotify_monitor->dir_cache, key);
+  if (path != NULL)
+    {
+      g_bytes_unref (key);
+      return g_strdup (path);
+    }
+
+  fd = open_by_handle_at (fanotify_monitor->mount_fd, handle, O_PATH | O_CLOEXEC);
+  if (fd == -1)
+    {
+      /* Typically ESTALE: the directory is already gone */
+      g_bytes_unref (key);
+      return NULL;
+    }
+
+  g_snprintf (proc_path, sizeof proc_path, "/proc/self/fd/%d", fd);
+  len = readlink (proc_path, buf, sizeof buf - 1);
+  close (fd);
+
+  if (len <= 0 || buf[0] != '/' ||
+      (len > 10 && memcmp (buf + len - 10, " (deleted)", 10) == 0))
+    {
+      g_bytes_unref (key);
+      return NULL;
+    }
+
+  path = g_strndup (buf, len);
+
+  if (g_hash_table_size (fanotify_monitor->dir_cache) >= DIR_CACHE_MAX_ENTRIES)
+    g_hash_table_remove_all (fanotify_monitor->dir_cache);
+  g_hash_table_insert (fanotify_monitor->dir_cache, key, g_strdup (path));
+
+  return path;
+}
+
+static gboolean
+is_in_tree (GFanotifyDirectoryMonitor *fanotify_monitor,
+            const gchar               *path)
+{
+  if (path == NULL)
+    return FALSE;
+
+  /* Monitoring "/" */
+  if (fanotify_monitor->root_len == 1)
+    return TRUE;
+
+  return strncmp (path, fanotify_monitor->root, fanotify_monitor->root_len) == 0 &&
+         (path[fanotify_monitor->root_len] == '\0' || path[fanotify_monitor->root_len] == '/');
+}
+
+static void
+emit_for_path (GFanotifyDirectoryMonitor *fanotify_monitor,
+               const gchar               *path,
+               const gchar               *other_path,
+               GFileMonitorEvent          event_type)
+{
+  GFile *child, *other_file;
+
+  child = g_file_new_for_path (path);
+  other_file = other_path ? g_file_new_for_path (other_path) : NULL;
+
+  g_file_monitor_emit_event (G_FILE_MONITOR (fanotify_monitor),
+                             child, other_file, event_type);
+
+  g_object_unref (child);
+  if (other_file)
+    g_object_unref (other_file);
+}
+
+static void
+handle_event (GFanotifyDirectoryMonitor      *fanotify_monitor,
+              struct fanotify_event_metadata *meta)
+{
+  gchar *paths[2] = { NULL, NULL };
+  guint64 mask = meta->mask;
+  gsize offset;
+
+  if (mask & FAN_Q_OVERFLOW)
+    {
+      /* Events were lost; all we can do is tell the user to rescan */
+      emit_for_path (fanotify_monitor, fanotify_monitor->root, NULL,
+                     G_FILE_MONITOR_EVENT_CHANGED);
+      return;
+    }
+
+  /* Collect the (directory handle, name) records.  Slot 0 holds the
+   * object the event is about (the old name for renames), slot 1 the
+   * new name of a rename.
+   */
+  offset = meta->metadata_len;
+  while (offset + sizeof (struct fanotify_event_info_header) <= meta->event_len)
+    {
+      struct fanotify_event_info_fid *fid;
+      struct file_handle *handle;
+      const gchar *name;
+      gchar *dir;
+      gint slot;
+
+      fid = (struct fanotify_event_info_fid *) ((gchar *) meta + offset);
+      if (fid->hdr.len == 0)
+        break;
+      offset += fid->hdr.len;
+
+      switch (fid->hdr.info_type)
+        {
+        case FAN_EVENT_INFO_TYPE_DFID_NAME:
+#ifdef FAN_EVENT_INFO_TYPE_OLD_DFID_NAME
+        case FAN_EVENT_INFO_TYPE_OLD_DFID_NAME:
+#endif
+          slot = 0;
+          break;
+#ifdef FAN_EVENT_INFO_TYPE_NEW_DFID_NAME
+        case FAN_EVENT_INFO_TYPE_NEW_DFID_NAME:
+          slot = 1;
+          break;
+#endif
+        default:
+          continue;
+        }
+
+      if (paths[slot] != NULL)
+        continue;
+
+      handle = (struct file_handle *) fid->handle;
+      name = (const gchar *) handle->f_handle + handle->handle_bytes;
+
+      dir = resolve_directory_handle (fanotify_monitor, handle);
+      if (dir == NULL)
+        continue;
+
+      /* Events on a directory itself are reported with the name "." */
+      if (name[0] == '\0' || strcmp (name, ".") == 0)
+        paths[slot] = dir;
+      else
+        {
+          paths[slot] = g_build_filename (dir, name, NULL);
+          g_free (dir);
+        }
+    }
+
+  /* Any directory moving or going away can change the path behind a
+   * cached handle, inside the monitored tree or not.
+   */
+  if ((mask & FAN_ONDIR) &&
+      (mask & (FAN_MOVED_FROM | FAN_MOVED_TO | FAN_DELETE
+#ifdef FAN_RENAME
+               | FAN_RENAME
+#endif
+               )))
+    g_hash_table_remove_all (fanotify_monitor->dir_cache);
+
+#ifdef FAN_RENAME
+  if (mask & FAN_RENAME)
+    {
+      gboolean old_in_tree = is_in_tree (fanotify_monitor, paths[0]);
+      gboolean new_in_tree = is_in_tree (fanotify_monitor, paths[1]);
+
+      if (old_in_tree && new_in_tree)
+        emit_for_path (fanotify_monitor, paths[0], paths[1], G_FILE_MONITOR_EVENT_MOVED);
+      else if (old_in_tree)
+        emit_for_path (fanotify_monitor, paths[0], NULL, G_FILE_MONITOR_EVENT_DELETED);
+      else if (new_in_tree)
+        emit_for_path (fanotify_monitor, paths[1], NULL, G_FILE_MONITOR_EVENT_CREATED);
+    }
+#endif
+
+  if (is_in_tree (fanotify_monitor, paths[0]))
+    {
+      /* Several kinds of events on the same object may have been merged
+       * into a single record; report them in a sensible order.
+       */
+      if (mask & (FAN_CREATE | FAN_MOVED_TO))
+        emit_for_path (fanotify_monitor, paths[0], NULL, G_FILE_MONITOR_EVENT_CREATED);
+      if (mask & FAN_MODIFY)
+        emit_for_path (fanotify_monitor, paths[0], NULL, G_FILE_MONITOR_EVENT_CHANGED);
+      if (mask & FAN_ATTRIB)
+        emit_for_path (fanotify_monitor, paths[0], NULL, G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED);
+      if (mask & FAN_CLOSE_WRITE)
+        emit_for_path (fanotify_monitor, paths[0], NULL, G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT);
+      if (mask & (FAN_DELETE | FAN_MOVED_FROM))
+        emit_for_path (fanotify_monitor, paths[0], NULL, G_FILE_MONITOR_EVENT_DELETED);
+    }
+
+  g_free (paths[0]);
+  g_free (paths[1]);
+}
+
+static gboolean
+fanotify_source_cb (gint         fd,
+                    GIOCondition condition,
+                    gpointer     user_data)
+{
+  GFanotifyDirectoryMonitor *fanotify_monitor = user_data;
+  struct fanotify_event_metadata *meta;
+  gssize len;
+
+  G_LOCK (fanotify_lock);
+
+  if (g_source_is_destroyed (g_main_current_source ()))
+    {
+      G_UNLOCK (fanotify_lock);
+      return FALSE;
+    }
+
+  while (TRUE)
+    {
+      len = read (fd, fanotify_monitor->buffer, EVENT_BUFFER_SIZE);
+      if (len < 0 && errno == EINTR)
+        continue;
+      if (len <= 0)
+        break;
+
+      for (meta = (struct fanotify_event_metadata *) fanotify_monitor->buffer;
+           FAN_EVENT_OK (meta, len);
+           meta = FAN_EVENT_NEXT (meta, len))
+        {
+          if (meta->fd >= 0)
+            close (meta->fd);
+
+          if (meta->vers == FANOTIFY_METADATA_VERSION)
+            handle_event (fanotify_monitor, meta);
+        }
+    }
+
+  G_UNLOCK (fanotify_lock);
+
+  return TRUE;
+}
+
+static void
+g_fanotify_directory_monitor_start (GLocalDirectoryMonitor *local_monitor)
+{
+  GFanotifyDirectoryMonitor *fanotify_monitor = G_FANOTIFY_DIRECTORY_MONITOR (local_monitor);
+  guint64 mask;
+  gboolean added;
+  gint fd;
+
+  g_assert (local_monitor->dirname != NULL);
+
+  fanotify_monitor->root = g_strdup (local_monitor->dirname);
+  fanotify_monitor->root_len = strlen (fanotify_monitor->root);
+  while (fanotify_monitor->root_len > 1 &&
+         fanotify_monitor->root[fanotify_monitor->root_len - 1] == '/')
+    fanotify_monitor->root[--fanotify_monitor->root_len] = '\0';
+
+  fd = fanotify_init (FANOTIFY_INIT_FLAGS, O_RDONLY | O_LARGEFILE);
+  if (fd == -1)
+    {
+      g_warning ("fanotify_init() failed: %s", g_strerror (errno));
+      return;
+    }
+
+  mask = FAN_CREATE | FAN_DELETE | FAN_MODIFY | FAN_ATTRIB | FAN_CLOSE_WRITE | FAN_ONDIR;
+
+  added = FALSE;
+#ifdef FAN_RENAME
+  /* FAN_RENAME reports both names in one event, which lets us send
+   * proper MOVED events.  It needs Linux 5.17.
+   */
+  if (local_monitor->flags & G_FILE_MONITOR_SEND_MOVED)
+    added = fanotify_mark (fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM,
+                           mask | FAN_RENAME, AT_FDCWD, fanotify_monitor->root) == 0;
+#endif
+  if (!added)
+    added = fanotify_mark (fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM,
+                           mask | FAN_MOVED_FROM | FAN_MOVED_TO,
+                           AT_FDCWD, fanotify_monitor->root) == 0;
+  if (!added)
+    {
+      g_warning ("Unable to add fanotify mark for %s: %s",
+                 fanotify_monitor->root, g_strerror (errno));
+      close (fd);
+      return;
+    }
+
+  /* open_by_handle_at() refuses O_PATH descriptors for this */
+  fanotify_monitor->mount_fd = open (fanotify_monitor->root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fanotify_monitor->mount_fd == -1)
+    {
+      g_warning ("Unable to open %s: %s", fanotify_monitor->root, g_strerror (errno));
+      close (fd);
+      return;
+    }
+
+  fanotify_monitor->fanotify_fd = fd;
+  fanotify_monitor->buffer = g_malloc (EVENT_BUFFER_SIZE);
+  fanotify_monitor->dir_cache = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+                                                       (GDestroyNotify) g_bytes_unref, g_free);
+
+  fanotify_monitor->source = g_unix_fd_source_new (fd, G_IO_IN);
+  g_source_set_callback (fanotify_monitor->source, (GSourceFunc) fanotify_source_cb,
+                         fanotify_monitor, NULL);
+  g_source_attach (fanotify_monitor->source, GLIB_PRIVATE_CALL (g_get_worker_context) ());
+}
+
+static gboolean
+g_fanotify_directory_monitor_is_supported (void)
+{
+  static gsize supported = 0;
+
+  if (g_once_init_enter (&supported))
+    {
+      union {
+        struct file_handle handle;
+        gchar buf[sizeof (struct file_handle) + MAX_HANDLE_SZ];
+      } fh;
+      gboolean ok = FALSE;
+      gint mount_id;
+      gint fd, root_fd, handle_fd;
+
+      /* Both the filesystem-wide mark and mapping the handles we get back
+       * to paths need privileges, so try them out on "/".
+       */
+      fd = fanotify_init (FANOTIFY_INIT_FLAGS, O_RDONLY | O_LARGEFILE);
+      if (fd != -1)
+        {
+          if (fanotify_mark (fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM,
+                             FAN_CREATE | FAN_ONDIR, AT_FDCWD, "/") == 0)
+            {
+              root_fd = open ("/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+              fh.handle.handle_bytes = MAX_HANDLE_SZ;
+              if (root_fd != -1 &&
+                  name_to_handle_at (AT_FDCWD, "/", &fh.handle, &mount_id, 0) == 0)
+                {
+                  handle_fd = open_by_handle_at (root_fd, &fh.handle, O_PATH | O_CLOEXEC);
+                  if (handle_fd != -1)
+                    {
+                      ok = TRUE;
+                      close (handle_fd);
+                    }
+                }
+              if (root_fd != -1)
+                close (root_fd);
+            }
+          close (fd);
+        }
+
+      g_once_init_leave (&supported, ok ? 2 : 1);
+    }
+
+  return supported == 2;
+}
+
+static void
+g_fanotify_directory_monitor_class_init (GFanotifyDirectoryMonitorClass* klass)
+{
+  GObjectClass* gobject_class = G_OBJECT_CLASS (klass);
+  GFileMonitorClass *directory_monitor_class = G_FILE_MONITOR_CLASS (klass);
+  GLocalDirectoryMonitorClass *local_directory_monitor_class = G_LOCAL_DIRECTORY_MONITOR_CLASS (klass);
+
+  gobject_class->finalize = g_fanotify_directory_monitor_finalize;
+  directory_monitor_class->cancel = g_fanotify_directory_monitor_cancel;
+
+  local_directory_monitor_class->mount_notify = TRUE;
+  local_directory_monitor_class->is_supported = g_fanotify_directory_monitor_is_supported;
+  local_directory_monitor_class->start = g_fanotify_directory_monitor_start;
+}
+
+static void
+g_fanotify_directory_monitor_init (GFanotifyDirectoryMonitor* monitor)
+{
+  monitor->fanotify_fd = -1;
+  monitor->mount_fd = -1;
+}
+
+static gboolean
+g_fanotify_directory_monitor_cancel (GFileMonitor* monitor)
+{
+  GFanotifyDirectoryMonitor *fanotify_monitor = G_FANOTIFY_DIRECTORY_MONITOR (monitor);
+
+  g_fanotify_directory_monitor_stop (fanotify_monitor);
+
+  if (G_FILE_MONITOR_CLASS (g_fanotify_directory_monitor_parent_class)->cancel)
+    (*G_FILE_MONITOR_CLASS (g_fanotify_directory_monitor_parent_class)->cancel) (monitor);
+
+  return TRUE;
+}
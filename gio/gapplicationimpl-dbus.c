@@ -327,6 +327,40 @@ application_path_from_appid (const gchar *appid)
   return appid_path;
 }
 
+typedef struct
+{
+  GDBusActionGroup *actions;
+  gboolean          actions_ok;
+  GVariant         *reply;
+  GError           *error;
+  gint              outstanding;
+} AttemptPrimaryData;
+
+static void
+g_application_impl_request_name_done (GObject      *source,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  AttemptPrimaryData *data = user_data;
+
+  data->reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &data->error);
+  data->outstanding--;
+}
+
+static void
+g_application_impl_describe_done (GObject      *source,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  AttemptPrimaryData *data = user_data;
+
+  /* An error here is not fatal: it is most likely that the name has no
+   * owner, in which case we are about to become the primary instance.
+   */
+  data->actions_ok = g_dbus_action_group_sync_finish (data->actions, result, NULL);
+  data->outstanding--;
+}
+
 /* Attempt to become the primary instance.
  *
  * Returns %TRUE if everything went OK, regardless of if we became the
@@ -335,9 +369,16 @@ application_path_from_appid (const gchar *appid)
  *
  * After a %TRUE return, impl->primary will be TRUE if we were
  * successful.
+ *
+ * If @remote_actions is non-%NULL then the action group of the
+ * existing primary instance (if any) is fetched at the same time as we
+ * request the name.  If we end up non-primary and that worked,
+ * @remote_actions is set to the populated action group; otherwise it
+ * is set to %NULL.
  */
 static gboolean
 g_application_impl_attempt_primary (GApplicationImpl  *impl,
+                                    GDBusActionGroup **remote_actions,
                                     GCancellable      *cancellable,
                                     GError           **error)
 {
@@ -347,9 +388,13 @@ g_application_impl_attempt_primary (GApplicationImpl  *impl,
     NULL /* set_property */
   };
   GApplicationClass *app_class = G_APPLICATION_GET_CLASS (impl->app);
-  GVariant *reply;
+  AttemptPrimaryData data = { NULL, };
+  GMainContext *context;
   guint32 rval;
 
+  if (remote_actions)
+    *remote_actions = NULL;
+
   if (org_gtk_Application == NULL)
     {
       GError *error = NULL;
@@ -425,21 +470,62 @@ g_application_impl_attempt_primary (GApplicationImpl  *impl,
    * the well-known name and fall back to remote mode (!is_primary)
    * in the case that we can't do that.
    */
+  if (remote_actions)
+    {
+      data.actions = g_dbus_action_group_get (impl->session_bus, impl->bus_name, impl->object_path);
+      g_dbus_action_group_subscribe (data.actions);
+    }
+
+  /* Both calls are issued at once and then waited for together, in a
+   * private main context so that we don't dispatch anything else
+   * before registration is complete.
+   *
+   * DescribeAll goes first, and without auto-starting.  The bus
+   * handles our messages in order, so it is routed to the current
+   * owner of the name (or fails immediately if there is none) and can
+   * never be routed back to ourselves.
+   */
+  context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+
+  if (data.actions)
+    {
+      g_dbus_action_group_sync_async (data.actions, G_DBUS_CALL_FLAGS_NO_AUTO_START, cancellable,
+                                      g_application_impl_describe_done, &data);
+      data.outstanding++;
+    }
+
   /* DBUS_NAME_FLAG_DO_NOT_QUEUE: 0x4 */
-  reply = g_dbus_connection_call_sync (impl->session_bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
-                                       "org.freedesktop.DBus", "RequestName",
-                                       g_variant_new ("(su)", impl->bus_name, 0x4), G_VARIANT_TYPE ("(u)"),
-                                       0, -1, cancellable, error);
+  g_dbus_connection_call (impl->session_bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                          "org.freedesktop.DBus", "RequestName",
+                          g_variant_new ("(su)", impl->bus_name, 0x4), G_VARIANT_TYPE ("(u)"),
+                          0, -1, cancellable, g_application_impl_request_name_done, &data);
+  data.outstanding++;
 
-  if (reply == NULL)
-    return FALSE;
+  while (data.outstanding)
+    g_main_context_iteration (context, TRUE);
+
+  g_main_context_pop_thread_default (context);
+  g_main_context_unref (context);
 
-  g_variant_get (reply, "(u)", &rval);
-  g_variant_unref (reply);
+  if (data.reply == NULL)
+    {
+      g_propagate_error (error, data.error);
+      g_clear_object (&data.actions);
+      return FALSE;
+    }
+
+  g_variant_get (data.reply, "(u)", &rval);
+  g_variant_unref (data.reply);
 
   /* DBUS_REQUEST_NAME_REPLY_EXISTS: 3 */
   impl->primary = (rval != 3);
 
+  if (!impl->primary && data.actions_ok)
+    *remote_actions = data.actions;
+  else if (data.actions)
+    g_object_unref (data.actions);
+
   return TRUE;
 }
 
@@ -521,7 +607,7 @@ g_application_impl_register (GApplication        *application,
                              GCancellable        *cancellable,
                              GError             **error)
 {
-  GDBusActionGroup *actions;
+  GDBusActionGroup *actions = NULL;
   GApplicationImpl *impl;
 
   g_assert ((flags & G_APPLICATION_NON_UNIQUE) || appid != NULL);
@@ -553,7 +639,11 @@ g_application_impl_register (GApplication        *application,
    */
   if (~flags & G_APPLICATION_IS_LAUNCHER)
     {
-      if (!g_application_impl_attempt_primary (impl, cancellable, error))
+      /* A service never needs the remote action group: it fails if it
+       * doesn't get the name.
+       */
+      if (!g_application_impl_attempt_primary (impl, (flags & G_APPLICATION_IS_SERVICE) ? NULL : &actions,
+                                               cancellable, error))
         {
           g_application_impl_destroy (impl);
           return NULL;
@@ -575,9 +665,20 @@ g_application_impl_register (GApplication        *application,
         }
     }
 
-  /* We are non-primary.  Try to get the primary's list of actions.
-   * This also serves as a mechanism to ensure that the primary exists
-   * (ie: DBus service files installed correctly, etc).
+  /* We are non-primary.  In the usual case of another instance
+   * already running we fetched its list of actions while requesting
+   * the name, and there is nothing more to do: the arguments are then
+   * forwarded with a single call.
+   */
+  if (actions != NULL)
+    {
+      *remote_actions = G_REMOTE_ACTION_GROUP (actions);
+      return impl;
+    }
+
+  /* Otherwise, try to get the primary's list of actions now.  This
+   * also serves as a mechanism to ensure that the primary exists (ie:
+   * DBus service files installed correctly, etc).
    */
   actions = g_dbus_action_group_get (impl->session_bus, impl->bus_name, impl->object_path);
   if (!g_dbus_action_group_sync (actions, cancellable, error))
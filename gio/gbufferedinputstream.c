@@ -58,11 +58,21 @@
 
 #define DEFAULT_BUFFER_SIZE 4096
 
+/* The buffer, once it is shared with #GBytes handed out by
+ * g_buffered_input_stream_peek_bytes()
+ */
+typedef struct {
+  gint    ref_count;
+  guint8 *data;
+} PinnedBuffer;
+
 struct _GBufferedInputStreamPrivate {
   guint8 *buffer;
   gsize   len;
   gsize   pos;
   gsize   end;
+  PinnedBuffer *pinned;
+  gsize   pinned_end;
   GAsyncReadyCallback outstanding_callback;
 };
 
@@ -130,6 +140,7 @@ static gboolean g_buffered_input_stream_truncate            (GSeekable       *se
 							     GError         **error);
 
 static void compact_buffer (GBufferedInputStream *stream);
+static void free_buffer    (GBufferedInputStream *stream);
 
 G_DEFINE_TYPE_WITH_CODE (GBufferedInputStream,
 			 g_buffered_input_stream,
@@ -224,10 +235,10 @@ g_buffered_input_stream_set_buffer_size (GBufferedInputStream *stream,
 
       buffer = g_malloc (size);
       memcpy (buffer, priv->buffer + priv->pos, in_buffer);
+      free_buffer (stream);
       priv->len = size;
       priv->pos = 0;
       priv->end = in_buffer;
-      g_free (priv->buffer);
       priv->buffer = buffer;
     }
   else
@@ -290,13 +301,11 @@ g_buffered_input_stream_get_property (GObject    *object,
 static void
 g_buffered_input_stream_finalize (GObject *object)
 {
-  GBufferedInputStreamPrivate *priv;
-  GBufferedInputStream        *stream;
+  GBufferedInputStream *stream;
 
   stream = G_BUFFERED_INPUT_STREAM (object);
-  priv = stream->priv;
 
-  g_free (priv->buffer);
+  free_buffer (stream);
 
   G_OBJECT_CLASS (g_buffered_input_stream_parent_class)->finalize (object);
 }
@@ -629,6 +638,123 @@ g_buffered_input_stream_peek_buffer (GBufferedInputStream *stream,
   return priv->buffer + priv->pos;
 }
 
+static void
+pinned_buffer_unref (PinnedBuffer *pinned)
+{
+  if (g_atomic_int_dec_and_test (&pinned->ref_count))
+    {
+      g_free (pinned->data);
+      g_slice_free (PinnedBuffer, pinned);
+    }
+}
+
+/**
+ * g_buffered_input_stream_peek_bytes:
+ * @stream: a #GBufferedInputStream
+ * @offset: offset into the available data
+ * @count: maximum number of bytes to return
+ *
+ * Like g_buffered_input_stream_peek(), but returns the data as a
+ * #GBytes that shares the memory of the stream's buffer instead of
+ * copying it.
+ *
+ * Unlike the result of g_buffered_input_stream_peek_buffer(), the
+ * returned #GBytes stays valid after reading from @stream or filling
+ * the buffer: if the stream needs to reuse that part of the buffer
+ * while the #GBytes is still alive, it moves on to a new buffer.
+ *
+ * Returns: (transfer full): a #GBytes with up to @count bytes, which
+ *     is empty if @offset is beyond the available data
+ *
+ * Since: 2.40
+ */
+GBytes *
+g_buffered_input_stream_peek_bytes (GBufferedInputStream *stream,
+                                    gsize                 offset,
+                                    gsize                 count)
+{
+  GBufferedInputStreamPrivate *priv;
+  gsize available;
+
+  g_return_val_if_fail (G_IS_BUFFERED_INPUT_STREAM (stream), NULL);
+
+  priv = stream->priv;
+  available = priv->end - priv->pos;
+
+  if (offset > available)
+    return g_bytes_new (NULL, 0);
+
+  count = MIN (count, available - offset);
+
+  if (priv->pinned == NULL)
+    {
+      priv->pinned = g_slice_new (PinnedBuffer);
+      priv->pinned->ref_count = 1;
+      priv->pinned->data = priv->buffer;
+    }
+
+  g_atomic_int_inc (&priv->pinned->ref_count);
+  priv->pinned_end = MAX (priv->pinned_end, priv->pos + offset + count);
+
+  return g_bytes_new_with_free_func (priv->buffer + priv->pos + offset, count,
+                                     (GDestroyNotify) pinned_buffer_unref,
+                                     priv->pinned);
+}
+
+static void
+free_buffer (GBufferedInputStream *stream)
+{
+  GBufferedInputStreamPrivate *priv;
+
+  priv = stream->priv;
+
+  if (priv->pinned)
+    pinned_buffer_unref (priv->pinned);
+  else
+    g_free (priv->buffer);
+
+  priv->pinned = NULL;
+  priv->pinned_end = 0;
+  priv->buffer = NULL;
+}
+
+/* Called before the buffer gets overwritten. If the data is still
+ * referenced by #GBytes from g_buffered_input_stream_peek_bytes(), the
+ * buffer is left to them and we continue with a fresh one.
+ */
+static void
+unpin_buffer (GBufferedInputStream *stream)
+{
+  GBufferedInputStreamPrivate *priv;
+  gsize current_size;
+  guint8 *buffer;
+
+  priv = stream->priv;
+
+  if (priv->pinned == NULL)
+    return;
+
+  if (g_atomic_int_get (&priv->pinned->ref_count) > 1)
+    {
+      current_size = priv->end - priv->pos;
+
+      buffer = g_malloc (priv->len);
+      memcpy (buffer, priv->buffer + priv->pos, current_size);
+      free_buffer (stream);
+
+      priv->buffer = buffer;
+      priv->pos = 0;
+      priv->end = current_size;
+    }
+  else
+    {
+      /* Nobody else can take a new reference, so the data is ours again */
+      g_slice_free (PinnedBuffer, priv->pinned);
+      priv->pinned = NULL;
+      priv->pinned_end = 0;
+    }
+}
+
 static void
 compact_buffer (GBufferedInputStream *stream)
 {
@@ -637,27 +763,37 @@ compact_buffer (GBufferedInputStream *stream)
 
   priv = stream->priv;
 
+  unpin_buffer (stream);
+
   current_size = priv->end - priv->pos;
 
-  g_memmove (priv->buffer, priv->buffer + priv->pos, current_size);
+  if (priv->pos > 0)
+    g_memmove (priv->buffer, priv->buffer + priv->pos, current_size);
 
   priv->pos = 0;
   priv->end = current_size;
 }
 
-static gssize
-g_buffered_input_stream_real_fill (GBufferedInputStream  *stream,
-                                   gssize                 count,
-                                   GCancellable          *cancellable,
-                                   GError               **error)
+/* Makes room for reading up to @count bytes at the end of the buffer,
+ * and returns how many can be read there.
+ *
+ * Moving the unread data to the front of the buffer is only worth it
+ * if that frees at least as much space as it moves, so when asked to
+ * fill as much as possible just read into whatever is left at the end
+ * instead. Each byte is then moved at most once on its way through
+ * the buffer, rather than once per refill.
+ */
+static gsize
+prepare_fill (GBufferedInputStream *stream,
+              gssize                count)
 {
   GBufferedInputStreamPrivate *priv;
-  GInputStream *base_stream;
-  gssize nread;
+  gboolean fill_all;
   gsize in_buffer;
 
   priv = stream->priv;
 
+  fill_all = (count == -1);
   if (count == -1)
     count = priv->len;
 
@@ -668,7 +804,33 @@ g_buffered_input_stream_real_fill (GBufferedInputStream  *stream,
 
   /* If requested length does not fit at end, compact */
   if (priv->len - priv->end < count)
-    compact_buffer (stream);
+    {
+      if (fill_all && priv->end < priv->len && in_buffer > priv->pos)
+        count = priv->len - priv->end;
+      else
+        compact_buffer (stream);
+    }
+
+  /* Don't read over data that was handed out with peek_bytes() */
+  if (priv->end < priv->pinned_end)
+    unpin_buffer (stream);
+
+  return count;
+}
+
+static gssize
+g_buffered_input_stream_real_fill (GBufferedInputStream  *stream,
+                                   gssize                 count,
+                                   GCancellable          *cancellable,
+                                   GError               **error)
+{
+  GBufferedInputStreamPrivate *priv;
+  GInputStream *base_stream;
+  gssize nread;
+
+  priv = stream->priv;
+
+  count = prepare_fill (stream, count);
 
   base_stream = G_FILTER_INPUT_STREAM (stream)->base_stream;
   nread = g_input_stream_read (base_stream,
@@ -1065,21 +1227,10 @@ g_buffered_input_stream_real_fill_async (GBufferedInputStream *stream,
   GBufferedInputStreamPrivate *priv;
   GInputStream *base_stream;
   GTask *task;
-  gsize in_buffer;
 
   priv = stream->priv;
 
-  if (count == -1)
-    count = priv->len;
-
-  in_buffer = priv->end - priv->pos;
-
-  /* Never fill more than can fit in the buffer */
-  count = MIN (count, priv->len - in_buffer);
-
-  /* If requested length does not fit at end, compact */
-  if (priv->len - priv->end < count)
-    compact_buffer (stream);
+  count = prepare_fill (stream, count);
 
   task = g_task_new (stream, cancellable, callback, user_data);
 
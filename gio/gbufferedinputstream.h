@@ -107,6 +107,10 @@ gsize         g_buffered_input_stream_peek            (GBufferedInputStream  *st
 GLIB_AVAILABLE_IN_ALL
 const void*   g_buffered_input_stream_peek_buffer     (GBufferedInputStream  *stream,
 						       gsize                 *count);
+GLIB_AVAILABLE_IN_2_40
+GBytes *      g_buffered_input_stream_peek_bytes      (GBufferedInputStream  *stream,
+						       gsize                  offset,
+						       gsize                  count);
 
 GLIB_AVAILABLE_IN_ALL
 gssize        g_buffered_input_stream_fill            (GBufferedInputStream  *stream,
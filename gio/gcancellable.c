@@ -25,6 +25,7 @@
 #include <gioerror.h>
 #include "glib-private.h"
 #include "gcancellable.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 
@@ -453,6 +454,83 @@ g_cancellable_release_fd (GCancellable *cancellable)
   g_mutex_unlock (&cancellable_mutex);
 }
 
+/* Blocking operations in GIO that wait for a cancellable with poll()
+ * do not need a file descriptor for each #GCancellable: every thread
+ * has a single #GWakeup, and the cancellable signals it for as long
+ * as the operation is waiting on it.
+ */
+static void
+thread_wakeup_free (gpointer wakeup)
+{
+  GLIB_PRIVATE_CALL (g_wakeup_free) (wakeup);
+}
+
+static GPrivate thread_wakeup = G_PRIVATE_INIT (thread_wakeup_free);
+
+static void
+thread_wakeup_signal (GCancellable *cancellable,
+                      gpointer      wakeup)
+{
+  GLIB_PRIVATE_CALL (g_wakeup_signal) (wakeup);
+}
+
+/*
+ * g_cancellable_make_thread_pollfd:
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @pollfd: a pointer to a #GPollFD
+ * @handler_id: return location for the id to pass to
+ *     g_cancellable_release_thread_pollfd()
+ *
+ * Like g_cancellable_make_pollfd(), but @pollfd belongs to the
+ * calling thread rather than to @cancellable, so it can only be
+ * polled from this thread, until the matching call to
+ * g_cancellable_release_thread_pollfd(). Calls may not be nested.
+ *
+ * Returns: %TRUE if @pollfd was initialized, %FALSE if @cancellable
+ *     is %NULL
+ */
+gboolean
+g_cancellable_make_thread_pollfd (GCancellable *cancellable,
+                                  GPollFD      *pollfd,
+                                  gulong       *handler_id)
+{
+  GWakeup *wakeup;
+
+  if (cancellable == NULL)
+    return FALSE;
+
+  wakeup = g_private_get (&thread_wakeup);
+  if (wakeup == NULL)
+    {
+      wakeup = GLIB_PRIVATE_CALL (g_wakeup_new) ();
+      g_private_set (&thread_wakeup, wakeup);
+    }
+
+  /* this signals the wakeup right away if already cancelled */
+  *handler_id = g_cancellable_connect (cancellable,
+                                       G_CALLBACK (thread_wakeup_signal),
+                                       wakeup, NULL);
+  GLIB_PRIVATE_CALL (g_wakeup_get_pollfd) (wakeup, pollfd);
+
+  return TRUE;
+}
+
+/*
+ * g_cancellable_release_thread_pollfd:
+ * @cancellable: a #GCancellable
+ * @handler_id: the id returned by g_cancellable_make_thread_pollfd()
+ *
+ * Stops signalling the thread's #GPollFD when @cancellable is
+ * cancelled, and resets it for the next user.
+ */
+void
+g_cancellable_release_thread_pollfd (GCancellable *cancellable,
+                                     gulong        handler_id)
+{
+  g_cancellable_disconnect (cancellable, handler_id);
+  GLIB_PRIVATE_CALL (g_wakeup_acknowledge) (g_private_get (&thread_wakeup));
+}
+
 /**
  * g_cancellable_cancel:
  * @cancellable: a #GCancellable object.
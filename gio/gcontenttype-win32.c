@@ -388,3 +388,21 @@ g_content_type_guess_for_tree (GFile *root)
   /* FIXME: implement */
   return NULL;
 }
+
+void
+g_content_type_set_sniff_cache_size (guint max_entries)
+{
+  /* Content types are never sniffed on Windows, so there is nothing
+   * to cache.
+   */
+}
+
+void
+g_content_type_get_sniff_cache_stats (guint64 *hits,
+                                      guint64 *misses)
+{
+  if (hits)
+    *hits = 0;
+  if (misses)
+    *misses = 0;
+}
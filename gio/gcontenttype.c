@@ -736,6 +736,248 @@ g_content_type_guess (const gchar  *filename,
   return mimetype;
 }
 
+/* Cache of sniffed content types, for _g_local_file_info_get().  An
+ * entry stays valid as long as the file keeps its identity, size and
+ * modification time; anything else just ages out of the LRU queue.
+ */
+typedef struct
+{
+  gchar   *basename;
+  guint64  device;
+  guint64  inode;
+  gint64   mtime;
+  guint32  mtime_nsec;
+  guint64  size;
+
+  gchar   *content_type;
+  GList    link;
+} SniffCacheEntry;
+
+G_LOCK_DEFINE_STATIC (sniff_cache);
+static GHashTable *sniff_cache;
+static GQueue      sniff_cache_lru = G_QUEUE_INIT;
+static guint       sniff_cache_max_size;
+static guint64     sniff_cache_hits;
+static guint64     sniff_cache_misses;
+
+static guint
+sniff_cache_entry_hash (gconstpointer key)
+{
+  const SniffCacheEntry *entry = key;
+
+  return g_str_hash (entry->basename) ^
+         (guint) (entry->inode ^ (entry->inode >> 32)) ^
+         (guint) entry->device ^
+         (guint) entry->mtime ^ entry->mtime_nsec ^
+         (guint) entry->size;
+}
+
+static gboolean
+sniff_cache_entry_equal (gconstpointer a,
+                         gconstpointer b)
+{
+  const SniffCacheEntry *entry_a = a;
+  const SniffCacheEntry *entry_b = b;
+
+  return entry_a->inode == entry_b->inode &&
+         entry_a->device == entry_b->device &&
+         entry_a->mtime == entry_b->mtime &&
+         entry_a->mtime_nsec == entry_b->mtime_nsec &&
+         entry_a->size == entry_b->size &&
+         strcmp (entry_a->basename, entry_b->basename) == 0;
+}
+
+static void
+sniff_cache_entry_free (gpointer data)
+{
+  SniffCacheEntry *entry = data;
+
+  g_free (entry->basename);
+  g_free (entry->content_type);
+  g_slice_free (SniffCacheEntry, entry);
+}
+
+/* Called with sniff_cache held */
+static void
+sniff_cache_trim (guint max_size)
+{
+  while (sniff_cache_lru.length > max_size)
+    {
+      GList *link;
+
+      link = g_queue_pop_tail_link (&sniff_cache_lru);
+      g_hash_table_remove (sniff_cache, link->data);
+    }
+}
+
+/* The sniffing results depend on the mime database, so throw them all
+ * away when it changes.  Called with gio_xdgmime held.
+ */
+static void
+sniff_cache_reload (void *user_data)
+{
+  G_LOCK (sniff_cache);
+  if (sniff_cache != NULL)
+    sniff_cache_trim (0);
+  G_UNLOCK (sniff_cache);
+}
+
+gchar *
+_g_unix_content_type_cache_lookup (const gchar *basename,
+                                   guint64      device,
+                                   guint64      inode,
+                                   gint64       mtime,
+                                   guint32      mtime_nsec,
+                                   guint64      size)
+{
+  SniffCacheEntry key, *entry;
+  gchar *content_type = NULL;
+
+  G_LOCK (sniff_cache);
+
+  if (sniff_cache_max_size > 0)
+    {
+      key.basename = (gchar *) basename;
+      key.device = device;
+      key.inode = inode;
+      key.mtime = mtime;
+      key.mtime_nsec = mtime_nsec;
+      key.size = size;
+
+      entry = g_hash_table_lookup (sniff_cache, &key);
+      if (entry != NULL)
+        {
+          g_queue_unlink (&sniff_cache_lru, &entry->link);
+          g_queue_push_head_link (&sniff_cache_lru, &entry->link);
+          content_type = g_strdup (entry->content_type);
+          sniff_cache_hits++;
+        }
+      else
+        sniff_cache_misses++;
+    }
+
+  G_UNLOCK (sniff_cache);
+
+  return content_type;
+}
+
+void
+_g_unix_content_type_cache_insert (const gchar *basename,
+                                   guint64      device,
+                                   guint64      inode,
+                                   gint64       mtime,
+                                   guint32      mtime_nsec,
+                                   guint64      size,
+                                   const gchar *content_type)
+{
+  SniffCacheEntry *entry;
+
+  G_LOCK (sniff_cache);
+
+  if (sniff_cache_max_size > 0)
+    {
+      entry = g_slice_new (SniffCacheEntry);
+      entry->basename = g_strdup (basename);
+      entry->device = device;
+      entry->inode = inode;
+      entry->mtime = mtime;
+      entry->mtime_nsec = mtime_nsec;
+      entry->size = size;
+      entry->content_type = g_strdup (content_type);
+      entry->link.data = entry;
+      entry->link.prev = entry->link.next = NULL;
+
+      /* Two threads may have sniffed the same file at once */
+      if (g_hash_table_contains (sniff_cache, entry))
+        sniff_cache_entry_free (entry);
+      else
+        {
+          g_hash_table_add (sniff_cache, entry);
+          g_queue_push_head_link (&sniff_cache_lru, &entry->link);
+          sniff_cache_trim (sniff_cache_max_size);
+        }
+    }
+
+  G_UNLOCK (sniff_cache);
+}
+
+/**
+ * g_content_type_set_sniff_cache_size:
+ * @max_entries: the maximum number of entries to keep, or 0
+ *
+ * Sets the size of the process-wide cache of content types that were
+ * determined by reading the start of a local file.
+ *
+ * When the #G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE of a local file
+ * cannot be determined from its name alone, GIO reads the first few
+ * kilobytes of the file and matches them against the shared-mime-info
+ * magic rules.  With the cache enabled, the result is remembered for
+ * the file's device, inode, size and modification time, so that
+ * querying the same unchanged file again, from any #GFileEnumerator or
+ * thread, does not read it again.
+ *
+ * The cache is disabled (0) by default.  When it is full, the least
+ * recently used entries are dropped.  It is also emptied whenever the
+ * mime database changes.  Setting the size to 0 disables the cache and
+ * frees all its entries.
+ *
+ * Since: 2.40
+ */
+void
+g_content_type_set_sniff_cache_size (guint max_entries)
+{
+  gboolean first_use = FALSE;
+
+  G_LOCK (sniff_cache);
+
+  if (sniff_cache == NULL)
+    {
+      sniff_cache = g_hash_table_new_full (sniff_cache_entry_hash, sniff_cache_entry_equal,
+                                           sniff_cache_entry_free, NULL);
+      first_use = TRUE;
+    }
+
+  sniff_cache_max_size = max_entries;
+  sniff_cache_trim (max_entries);
+
+  G_UNLOCK (sniff_cache);
+
+  if (first_use)
+    {
+      G_LOCK (gio_xdgmime);
+      xdg_mime_register_reload_callback (sniff_cache_reload, NULL, NULL);
+      G_UNLOCK (gio_xdgmime);
+    }
+}
+
+/**
+ * g_content_type_get_sniff_cache_stats:
+ * @hits: (out) (allow-none): return location for the number of lookups
+ *     that were answered from the cache, or %NULL
+ * @misses: (out) (allow-none): return location for the number of
+ *     lookups that had to read the file, or %NULL
+ *
+ * Gets statistics about the cache enabled with
+ * g_content_type_set_sniff_cache_size().  The counters cover every
+ * lookup made while the cache was enabled, since the start of the
+ * process.
+ *
+ * Since: 2.40
+ */
+void
+g_content_type_get_sniff_cache_stats (guint64 *hits,
+                                      guint64 *misses)
+{
+  G_LOCK (sniff_cache);
+
+  if (hits)
+    *hits = sniff_cache_hits;
+  if (misses)
+    *misses = sniff_cache_misses;
+
+  G_UNLOCK (sniff_cache);
+}
+
 static void
 enumerate_mimetypes_subdir (const char *dir,
                             const char *prefix,
@@ -68,6 +68,12 @@ gchar ** g_content_type_guess_for_tree    (GFile        *root);
 GLIB_AVAILABLE_IN_ALL
 GList *  g_content_types_get_registered   (void);
 
+GLIB_AVAILABLE_IN_2_40
+void     g_content_type_set_sniff_cache_size  (guint         max_entries);
+GLIB_AVAILABLE_IN_2_40
+void     g_content_type_get_sniff_cache_stats (guint64      *hits,
+                                               guint64      *misses);
+
 G_END_DECLS
 
 #endif /* __G_CONTENT_TYPE_H__ */
@@ -31,6 +31,20 @@ gsize  _g_unix_content_type_get_sniff_len (void);
 char * _g_unix_content_type_unalias       (const char *type);
 char **_g_unix_content_type_get_parents   (const char *type);
 
+char * _g_unix_content_type_cache_lookup  (const char *basename,
+                                           guint64     device,
+                                           guint64     inode,
+                                           gint64      mtime,
+                                           guint32     mtime_nsec,
+                                           guint64     size);
+void   _g_unix_content_type_cache_insert  (const char *basename,
+                                           guint64     device,
+                                           guint64     inode,
+                                           gint64      mtime,
+                                           guint32     mtime_nsec,
+                                           guint64     size,
+                                           const char *content_type);
+
 G_END_DECLS
 
 #endif /* __G_CONTENT_TYPE_PRIVATE_H__ */
@@ -22,6 +22,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 
 #include "gconverterinputstream.h"
@@ -30,6 +31,7 @@
 #include "gcancellable.h"
 #include "gioenumtypes.h"
 #include "gioerror.h"
+#include "glib-private.h"
 #include "glibintl.h"
 
 
@@ -44,10 +46,19 @@
  *
  * As of GLib 2.34, #GConverterInputStream implements
  * #GPollableInputStream.
+ *
+ * As of GLib 2.40, the stream can run the conversion in a worker
+ * thread, see #GConverterInputStream:pipelined.
  **/
 
 #define INITIAL_BUFFER_SIZE 4096
 
+/* In pipelined mode, the worker converts into chunks of this size
+ * and stays at most PIPELINE_DEPTH of them ahead of the reader.
+ */
+#define PIPELINE_CHUNK_SIZE (64 * 1024)
+#define PIPELINE_DEPTH 2
+
 typedef struct {
   char *data;
   gsize start;
@@ -55,18 +66,38 @@ typedef struct {
   gsize size;
 } Buffer;
 
+/* State shared between the reader and the worker thread, all
+ * protected by @lock. The worker owns the input buffer and the
+ * converter while it runs.
+ */
+typedef struct {
+  GMutex lock;
+  GCond cond;
+  GThread *thread;
+  GCancellable *cancellable;
+  GWakeup *wakeup;
+
+  GQueue ready;   /* converted chunks, oldest first */
+  GQueue spare;   /* consumed chunks, for reuse */
+  gboolean done;
+  GError *error;
+} Pipeline;
+
 struct _GConverterInputStreamPrivate {
   gboolean at_input_end;
   gboolean finished;
   gboolean need_input;
+  gboolean pipelined;
   GConverter *converter;
   Buffer input_buffer;
   Buffer converted_buffer;
+  Pipeline *pipeline;
 };
 
 enum {
   PROP_0,
-  PROP_CONVERTER
+  PROP_CONVERTER,
+  PROP_PIPELINED
 };
 
 static void   g_converter_input_stream_set_property (GObject       *object,
@@ -83,6 +114,9 @@ static gssize g_converter_input_stream_read         (GInputStream  *stream,
 						     gsize          count,
 						     GCancellable  *cancellable,
 						     GError       **error);
+static gboolean g_converter_input_stream_close      (GInputStream  *stream,
+						     GCancellable  *cancellable,
+						     GError       **error);
 
 static gboolean g_converter_input_stream_can_poll         (GPollableInputStream *stream);
 static gboolean g_converter_input_stream_is_readable      (GPollableInputStream *stream);
@@ -96,6 +130,8 @@ static GSource *g_converter_input_stream_create_source    (GPollableInputStream
 
 static void g_converter_input_stream_pollable_iface_init  (GPollableInputStreamInterface *iface);
 
+static void pipeline_free (Pipeline *pipeline);
+
 G_DEFINE_TYPE_WITH_CODE (GConverterInputStream,
 			 g_converter_input_stream,
 			 G_TYPE_FILTER_INPUT_STREAM,
@@ -116,6 +152,7 @@ g_converter_input_stream_class_init (GConverterInputStreamClass *klass)
 
   istream_class = G_INPUT_STREAM_CLASS (klass);
   istream_class->read_fn = g_converter_input_stream_read;
+  istream_class->close_fn = g_converter_input_stream_close;
 
   g_object_class_install_property (object_class,
 				   PROP_CONVERTER,
@@ -127,6 +164,31 @@ g_converter_input_stream_class_init (GConverterInputStreamClass *klass)
 							G_PARAM_CONSTRUCT_ONLY|
 							G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GConverterInputStream:pipelined:
+   *
+   * Whether reading from the base stream and converting happen in a
+   * worker thread, ahead of what is read from the stream.
+   *
+   * This lets I/O on the base stream, the conversion and whatever
+   * the reader does with the data run at the same time, and means
+   * that non-blocking and asynchronous reads never wait for the
+   * conversion. The stream is pollable in this mode even if the base
+   * stream is not. The base stream and the converter must not be
+   * used by anything else while the stream is open.
+   *
+   * This can only be changed before the first read.
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (object_class,
+				   PROP_PIPELINED,
+				   g_param_spec_boolean ("pipelined",
+							 P_("Pipelined"),
+							 P_("Whether the conversion runs in a worker thread"),
+							 FALSE,
+							 G_PARAM_READWRITE|
+							 G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -147,6 +209,8 @@ g_converter_input_stream_finalize (GObject *object)
   stream = G_CONVERTER_INPUT_STREAM (object);
   priv = stream->priv;
 
+  if (priv->pipeline)
+    pipeline_free (priv->pipeline);
   g_free (priv->input_buffer.data);
   g_free (priv->converted_buffer.data);
   if (priv->converter)
@@ -171,6 +235,10 @@ g_converter_input_stream_set_property (GObject      *object,
       cstream->priv->converter = g_value_dup_object (value);
       break;
 
+    case PROP_PIPELINED:
+      g_converter_input_stream_set_pipelined (cstream, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -196,6 +264,10 @@ g_converter_input_stream_get_property (GObject    *object,
       g_value_set_object (value, priv->converter);
       break;
 
+    case PROP_PIPELINED:
+      g_value_set_boolean (value, priv->pipelined);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -374,6 +446,418 @@ fill_input_buffer (GConverterInputStream  *stream,
 }
 
 
+static Buffer *
+chunk_new (void)
+{
+  Buffer *chunk;
+
+  chunk = g_slice_new0 (Buffer);
+  chunk->size = PIPELINE_CHUNK_SIZE;
+  chunk->data = g_malloc (chunk->size);
+
+  return chunk;
+}
+
+static void
+chunk_free (Buffer *chunk)
+{
+  g_free (chunk->data);
+  g_slice_free (Buffer, chunk);
+}
+
+static Pipeline *
+pipeline_new (void)
+{
+  Pipeline *pipeline;
+
+  pipeline = g_slice_new0 (Pipeline);
+  g_mutex_init (&pipeline->lock);
+  g_cond_init (&pipeline->cond);
+  g_queue_init (&pipeline->ready);
+  g_queue_init (&pipeline->spare);
+  pipeline->cancellable = g_cancellable_new ();
+  pipeline->wakeup = GLIB_PRIVATE_CALL (g_wakeup_new) ();
+
+  return pipeline;
+}
+
+/* Stops the worker thread, if there is one */
+static void
+pipeline_stop (Pipeline *pipeline)
+{
+  if (pipeline->thread == NULL)
+    return;
+
+  g_cancellable_cancel (pipeline->cancellable);
+
+  g_mutex_lock (&pipeline->lock);
+  pipeline->done = TRUE;
+  g_cond_broadcast (&pipeline->cond);
+  g_mutex_unlock (&pipeline->lock);
+
+  g_thread_join (pipeline->thread);
+  pipeline->thread = NULL;
+}
+
+static void
+pipeline_free (Pipeline *pipeline)
+{
+  Buffer *chunk;
+
+  pipeline_stop (pipeline);
+
+  while ((chunk = g_queue_pop_head (&pipeline->ready)))
+    chunk_free (chunk);
+  while ((chunk = g_queue_pop_head (&pipeline->spare)))
+    chunk_free (chunk);
+
+  g_clear_error (&pipeline->error);
+  g_object_unref (pipeline->cancellable);
+  GLIB_PRIVATE_CALL (g_wakeup_free) (pipeline->wakeup);
+  g_cond_clear (&pipeline->cond);
+  g_mutex_clear (&pipeline->lock);
+  g_slice_free (Pipeline, pipeline);
+}
+
+/* Called in the worker. Waits until the reader is less than
+ * PIPELINE_DEPTH chunks behind, and returns a chunk to convert
+ * into, or %NULL if the worker should stop.
+ */
+static Buffer *
+pipeline_get_chunk (Pipeline *pipeline)
+{
+  Buffer *chunk;
+  gboolean done;
+
+  g_mutex_lock (&pipeline->lock);
+
+  while (!pipeline->done && pipeline->ready.length >= PIPELINE_DEPTH)
+    g_cond_wait (&pipeline->cond, &pipeline->lock);
+
+  done = pipeline->done;
+  chunk = g_queue_pop_head (&pipeline->spare);
+
+  g_mutex_unlock (&pipeline->lock);
+
+  if (done)
+    {
+      if (chunk)
+        chunk_free (chunk);
+      return NULL;
+    }
+
+  if (chunk == NULL)
+    chunk = chunk_new ();
+
+  return chunk;
+}
+
+/* Called in the worker, to hand @chunk to the reader */
+static void
+pipeline_push_chunk (Pipeline *pipeline,
+		     Buffer   *chunk)
+{
+  g_mutex_lock (&pipeline->lock);
+  g_queue_push_tail (&pipeline->ready, chunk);
+  g_cond_broadcast (&pipeline->cond);
+  GLIB_PRIVATE_CALL (g_wakeup_signal) (pipeline->wakeup);
+  g_mutex_unlock (&pipeline->lock);
+}
+
+/* The worker thread: the same conversion loop as in read_internal(),
+ * but converting into chunks for the reader instead of into the
+ * caller's buffer. The stream is not referenced here, it joins the
+ * thread before it goes away.
+ */
+static gpointer
+pipeline_thread (gpointer user_data)
+{
+  GConverterInputStream *cstream = user_data;
+  GConverterInputStreamPrivate *priv = cstream->priv;
+  Pipeline *pipeline = priv->pipeline;
+  GInputStream *base_stream;
+  Buffer *chunk = NULL;
+  GError *error = NULL;
+  gssize nread;
+  GConverterResult res;
+  gsize bytes_read;
+  gsize bytes_written;
+  GError *my_error;
+
+  base_stream = G_FILTER_INPUT_STREAM (cstream)->base_stream;
+
+  while (!priv->finished && error == NULL)
+    {
+      if (chunk == NULL)
+	{
+	  chunk = pipeline_get_chunk (pipeline);
+	  if (chunk == NULL)
+	    break;
+	}
+
+      my_error = NULL;
+      res = g_converter_convert (priv->converter,
+				 buffer_data (&priv->input_buffer),
+				 buffer_data_size (&priv->input_buffer),
+				 chunk->data + chunk->end,
+				 buffer_tailspace (chunk),
+				 priv->at_input_end ? G_CONVERTER_INPUT_AT_END : 0,
+				 &bytes_read,
+				 &bytes_written,
+				 &my_error);
+      if (res != G_CONVERTER_ERROR)
+	{
+	  chunk->end += bytes_written;
+	  buffer_consumed (&priv->input_buffer, bytes_read);
+
+	  if (res == G_CONVERTER_FINISHED)
+	    priv->finished = TRUE;
+
+	  if (buffer_tailspace (chunk) == 0 ||
+	      (priv->finished && buffer_data_size (chunk) > 0))
+	    {
+	      pipeline_push_chunk (pipeline, chunk);
+	      chunk = NULL;
+	    }
+	  continue;
+	}
+
+      if (g_error_matches (my_error,
+			   G_IO_ERROR,
+			   G_IO_ERROR_PARTIAL_INPUT) &&
+	  !priv->at_input_end)
+	{
+	  g_error_free (my_error);
+
+	  /* Let the reader have what we have while we wait for input */
+	  if (buffer_data_size (chunk) > 0)
+	    {
+	      pipeline_push_chunk (pipeline, chunk);
+	      chunk = NULL;
+	    }
+
+	  buffer_ensure_space (&priv->input_buffer,
+			       buffer_data_size (&priv->input_buffer) + PIPELINE_CHUNK_SIZE);
+	  nread = g_input_stream_read (base_stream,
+				       priv->input_buffer.data + priv->input_buffer.end,
+				       buffer_tailspace (&priv->input_buffer),
+				       pipeline->cancellable,
+				       &error);
+	  if (nread > 0)
+	    priv->input_buffer.end += nread;
+	  else if (nread == 0)
+	    priv->at_input_end = TRUE;
+	  continue;
+	}
+
+      if (g_error_matches (my_error,
+			   G_IO_ERROR,
+			   G_IO_ERROR_NO_SPACE))
+	{
+	  g_error_free (my_error);
+
+	  /* Hand over what we have, or grow the chunk if it is empty
+	   * and still too small.
+	   */
+	  if (buffer_data_size (chunk) > 0)
+	    {
+	      pipeline_push_chunk (pipeline, chunk);
+	      chunk = NULL;
+	    }
+	  else
+	    buffer_ensure_space (chunk, chunk->size + 1);
+	  continue;
+	}
+
+      error = my_error;
+    }
+
+  g_mutex_lock (&pipeline->lock);
+  if (chunk != NULL && buffer_data_size (chunk) > 0)
+    g_queue_push_tail (&pipeline->ready, chunk);
+  else if (chunk != NULL)
+    g_queue_push_tail (&pipeline->spare, chunk);
+  /* an error from stopping the worker is of no interest to anyone */
+  if (!pipeline->done)
+    pipeline->error = error;
+  else if (error)
+    g_error_free (error);
+  pipeline->done = TRUE;
+  g_cond_broadcast (&pipeline->cond);
+  GLIB_PRIVATE_CALL (g_wakeup_signal) (pipeline->wakeup);
+  g_mutex_unlock (&pipeline->lock);
+
+  return NULL;
+}
+
+static void
+pipeline_cancelled (GCancellable *cancellable,
+		    Pipeline     *pipeline)
+{
+  g_mutex_lock (&pipeline->lock);
+  g_cond_broadcast (&pipeline->cond);
+  g_mutex_unlock (&pipeline->lock);
+}
+
+/* Called with the pipeline lock held */
+static gboolean
+pipeline_is_readable (Pipeline *pipeline)
+{
+  return pipeline->ready.length > 0 || pipeline->done;
+}
+
+static gssize
+read_pipelined (GConverterInputStream *cstream,
+		void                  *buffer,
+		gsize                  count,
+		gboolean               blocking,
+		GCancellable          *cancellable,
+		GError               **error)
+{
+  Pipeline *pipeline = cstream->priv->pipeline;
+  gsize total_bytes_read = 0;
+  gulong cancelled_id = 0;
+  Buffer *chunk;
+  gssize res;
+
+  if (blocking && cancellable)
+    cancelled_id = g_cancellable_connect (cancellable,
+					  G_CALLBACK (pipeline_cancelled),
+					  pipeline, NULL);
+
+  g_mutex_lock (&pipeline->lock);
+
+  if (pipeline->thread == NULL && !pipeline->done)
+    pipeline->thread = g_thread_new ("gconverter", pipeline_thread, cstream);
+
+  while (TRUE)
+    {
+      while (total_bytes_read < count &&
+	     (chunk = g_queue_peek_head (&pipeline->ready)) != NULL)
+	{
+	  gsize n = MIN (count - total_bytes_read, buffer_data_size (chunk));
+
+	  buffer_read (chunk, (char *) buffer + total_bytes_read, n);
+	  total_bytes_read += n;
+
+	  if (buffer_data_size (chunk) == 0)
+	    {
+	      g_queue_pop_head (&pipeline->ready);
+	      g_queue_push_tail (&pipeline->spare, chunk);
+	      g_cond_broadcast (&pipeline->cond);
+	    }
+	}
+
+      if (total_bytes_read > 0)
+	{
+	  res = total_bytes_read;
+	  break;
+	}
+
+      if (pipeline->error)
+	{
+	  g_propagate_error (error, g_error_copy (pipeline->error));
+	  res = -1;
+	  break;
+	}
+
+      if (pipeline->done)
+	{
+	  res = 0;
+	  break;
+	}
+
+      if (!blocking)
+	{
+	  /* the worker signals again when it has more */
+	  GLIB_PRIVATE_CALL (g_wakeup_acknowledge) (pipeline->wakeup);
+	  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+			       g_strerror (EAGAIN));
+	  res = -1;
+	  break;
+	}
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	{
+	  res = -1;
+	  break;
+	}
+
+      g_cond_wait (&pipeline->cond, &pipeline->lock);
+    }
+
+  g_mutex_unlock (&pipeline->lock);
+
+  if (cancelled_id)
+    g_cancellable_disconnect (cancellable, cancelled_id);
+
+  return res;
+}
+
+typedef struct {
+  GSource source;
+  GPollFD pollfd;
+} PipelineSource;
+
+static gboolean
+pipeline_source_check (GSource *source)
+{
+  PipelineSource *pipeline_source = (PipelineSource *) source;
+
+  return pipeline_source->pollfd.revents != 0;
+}
+
+static gboolean
+pipeline_source_dispatch (GSource     *source,
+			  GSourceFunc  callback,
+			  gpointer     user_data)
+{
+  return (* callback) (user_data);
+}
+
+static gboolean
+pipeline_source_closure_callback (gpointer data)
+{
+  GClosure *closure = data;
+  GValue result_value = G_VALUE_INIT;
+  gboolean result;
+
+  g_value_init (&result_value, G_TYPE_BOOLEAN);
+
+  g_closure_invoke (closure, &result_value, 0, NULL, NULL);
+
+  result = g_value_get_boolean (&result_value);
+  g_value_unset (&result_value);
+
+  return result;
+}
+
+static GSourceFuncs pipeline_source_funcs =
+{
+  NULL,
+  pipeline_source_check,
+  pipeline_source_dispatch,
+  NULL,
+  (GSourceFunc)pipeline_source_closure_callback,
+};
+
+/* A source that triggers when the worker has produced something */
+static GSource *
+pipeline_source_new (Pipeline *pipeline)
+{
+  PipelineSource *pipeline_source;
+  GSource *source;
+
+  source = g_source_new (&pipeline_source_funcs, sizeof (PipelineSource));
+  g_source_set_name (source, "GConverterInputStream pipeline");
+  pipeline_source = (PipelineSource *) source;
+
+  GLIB_PRIVATE_CALL (g_wakeup_get_pollfd) (pipeline->wakeup, &pipeline_source->pollfd);
+  g_source_add_poll (source, &pipeline_source->pollfd);
+
+  return source;
+}
+
 static gssize
 read_internal (GInputStream *stream,
 	       void         *buffer,
@@ -395,6 +879,9 @@ read_internal (GInputStream *stream,
   cstream = G_CONVERTER_INPUT_STREAM (stream);
   priv = cstream->priv;
 
+  if (priv->pipelined)
+    return read_pipelined (cstream, buffer, count, blocking, cancellable, error);
+
   available = buffer_data_size (&priv->converted_buffer);
 
   if (available > 0 &&
@@ -579,11 +1066,29 @@ g_converter_input_stream_read (GInputStream *stream,
   return read_internal (stream, buffer, count, TRUE, cancellable, error);
 }
 
+static gboolean
+g_converter_input_stream_close (GInputStream  *stream,
+				GCancellable  *cancellable,
+				GError       **error)
+{
+  GConverterInputStream *cstream = G_CONVERTER_INPUT_STREAM (stream);
+
+  /* the worker may be using the base stream */
+  if (cstream->priv->pipeline)
+    pipeline_stop (cstream->priv->pipeline);
+
+  return G_INPUT_STREAM_CLASS (g_converter_input_stream_parent_class)->
+    close_fn (stream, cancellable, error);
+}
+
 static gboolean
 g_converter_input_stream_can_poll (GPollableInputStream *stream)
 {
   GInputStream *base_stream = G_FILTER_INPUT_STREAM (stream)->base_stream;
 
+  if (G_CONVERTER_INPUT_STREAM (stream)->priv->pipelined)
+    return TRUE;
+
   return (G_IS_POLLABLE_INPUT_STREAM (base_stream) &&
 	  g_pollable_input_stream_can_poll (G_POLLABLE_INPUT_STREAM (base_stream)));
 }
@@ -594,6 +1099,18 @@ g_converter_input_stream_is_readable (GPollableInputStream *stream)
   GInputStream *base_stream = G_FILTER_INPUT_STREAM (stream)->base_stream;
   GConverterInputStream *cstream = G_CONVERTER_INPUT_STREAM (stream);
 
+  if (cstream->priv->pipelined)
+    {
+      Pipeline *pipeline = cstream->priv->pipeline;
+      gboolean readable;
+
+      g_mutex_lock (&pipeline->lock);
+      readable = pipeline_is_readable (pipeline);
+      g_mutex_unlock (&pipeline->lock);
+
+      return readable;
+    }
+
   if (buffer_data_size (&cstream->priv->converted_buffer))
     return TRUE;
   else if (buffer_data_size (&cstream->priv->input_buffer) &&
@@ -622,6 +1139,8 @@ g_converter_input_stream_create_source (GPollableInputStream *stream,
 
   if (g_pollable_input_stream_is_readable (stream))
     base_source = g_timeout_source_new (0);
+  else if (G_CONVERTER_INPUT_STREAM (stream)->priv->pipelined)
+    base_source = pipeline_source_new (G_CONVERTER_INPUT_STREAM (stream)->priv->pipeline);
   else
     base_source = g_pollable_input_stream_create_source (G_POLLABLE_INPUT_STREAM (base_stream), NULL);
 
@@ -648,3 +1167,59 @@ g_converter_input_stream_get_converter (GConverterInputStream *converter_stream)
 {
   return converter_stream->priv->converter;
 }
+
+/**
+ * g_converter_input_stream_set_pipelined:
+ * @converter_stream: a #GConverterInputStream
+ * @pipelined: whether to convert in a worker thread
+ *
+ * Sets whether @converter_stream reads from its base stream and
+ * converts in a worker thread. See #GConverterInputStream:pipelined.
+ *
+ * This must be called before the first read from @converter_stream.
+ *
+ * Since: 2.40
+ */
+void
+g_converter_input_stream_set_pipelined (GConverterInputStream *converter_stream,
+					gboolean               pipelined)
+{
+  GConverterInputStreamPrivate *priv;
+
+  g_return_if_fail (G_IS_CONVERTER_INPUT_STREAM (converter_stream));
+
+  priv = converter_stream->priv;
+  pipelined = !!pipelined;
+
+  if (priv->pipelined == pipelined)
+    return;
+
+  g_return_if_fail (priv->pipeline == NULL || priv->pipeline->thread == NULL);
+  g_return_if_fail (buffer_data_size (&priv->converted_buffer) == 0 &&
+		    buffer_data_size (&priv->input_buffer) == 0 &&
+		    !priv->at_input_end);
+
+  priv->pipelined = pipelined;
+  if (pipelined && priv->pipeline == NULL)
+    priv->pipeline = pipeline_new ();
+
+  g_object_notify (G_OBJECT (converter_stream), "pipelined");
+}
+
+/**
+ * g_converter_input_stream_get_pipelined:
+ * @converter_stream: a #GConverterInputStream
+ *
+ * Gets whether @converter_stream converts in a worker thread.
+ *
+ * Returns: %TRUE if @converter_stream is pipelined
+ *
+ * Since: 2.40
+ */
+gboolean
+g_converter_input_stream_get_pipelined (GConverterInputStream *converter_stream)
+{
+  g_return_val_if_fail (G_IS_CONVERTER_INPUT_STREAM (converter_stream), FALSE);
+
+  return converter_stream->priv->pipelined;
+}
@@ -76,6 +76,11 @@ GInputStream          *g_converter_input_stream_new           (GInputStream
                                                                GConverter            *converter);
 GLIB_AVAILABLE_IN_ALL
 GConverter            *g_converter_input_stream_get_converter (GConverterInputStream *converter_stream);
+GLIB_AVAILABLE_IN_2_40
+void                   g_converter_input_stream_set_pipelined (GConverterInputStream *converter_stream,
+                                                               gboolean               pipelined);
+GLIB_AVAILABLE_IN_2_40
+gboolean               g_converter_input_stream_get_pipelined (GConverterInputStream *converter_stream);
 
 G_END_DECLS
 
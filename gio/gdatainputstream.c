@@ -631,96 +631,102 @@ scan_for_newline (GDataInputStream *stream,
 {
   GBufferedInputStream *bstream;
   GDataInputStreamPrivate *priv;
-  const char *buffer;
-  gsize start, end, peeked;
-  int i;
+  const char *buffer, *buffer_end, *p, *lf;
+  gsize start, peeked;
   gssize found_pos;
   int newline_len;
-  gsize available, checked;
+  gsize available;
   gboolean last_saw_cr;
 
   priv = stream->priv;
-  
+
   bstream = G_BUFFERED_INPUT_STREAM (stream);
 
-  checked = *checked_out;
   last_saw_cr = *last_saw_cr_out;
   found_pos = -1;
   newline_len = 0;
-  
-  start = checked;
+
+  start = *checked_out;
   buffer = (const char*)g_buffered_input_stream_peek_buffer (bstream, &available) + start;
-  end = available;
-  peeked = end - start;
+  peeked = available - start;
+  buffer_end = buffer + peeked;
+
+  if (peeked == 0)
+    return -1;
 
-  for (i = 0; checked < available && i < peeked; i++)
+  /* Scan with memchr() rather than looking at every byte ourselves,
+   * most of the buffer is usually line content.
+   */
+  switch (priv->newline_type)
     {
-      switch (priv->newline_type)
+    case G_DATA_STREAM_NEWLINE_TYPE_LF:
+      p = memchr (buffer, 10, peeked);
+      if (p != NULL)
 	{
-	case G_DATA_STREAM_NEWLINE_TYPE_LF:
-	  if (buffer[i] == 10)
-	    {
-	      found_pos = start + i;
-	      newline_len = 1;
-	    }
-	  break;
-	case G_DATA_STREAM_NEWLINE_TYPE_CR:
-	  if (buffer[i] == 13)
-	    {
-	      found_pos = start + i;
-	      newline_len = 1;
-	    }
-	  break;
-	case G_DATA_STREAM_NEWLINE_TYPE_CR_LF:
-	  if (last_saw_cr && buffer[i] == 10)
+	  found_pos = start + (p - buffer);
+	  newline_len = 1;
+	}
+      break;
+    case G_DATA_STREAM_NEWLINE_TYPE_CR:
+      p = memchr (buffer, 13, peeked);
+      if (p != NULL)
+	{
+	  found_pos = start + (p - buffer);
+	  newline_len = 1;
+	}
+      break;
+    case G_DATA_STREAM_NEWLINE_TYPE_CR_LF:
+      for (p = buffer; (p = memchr (p, 10, buffer_end - p)) != NULL; p++)
+	{
+	  if (p == buffer ? last_saw_cr : p[-1] == 13)
 	    {
-	      found_pos = start + i - 1;
+	      found_pos = start + (p - buffer) - 1;
 	      newline_len = 2;
+	      break;
 	    }
+	}
+      break;
+    default:
+    case G_DATA_STREAM_NEWLINE_TYPE_ANY:
+      if (last_saw_cr)
+	{
+	  /* Last was cr, the end is either CR LF or just CR */
+	  found_pos = start - 1;
+	  newline_len = (buffer[0] == 10) ? 2 : 1;
 	  break;
-	default:
-	case G_DATA_STREAM_NEWLINE_TYPE_ANY:
-	  if (buffer[i] == 10) /* LF */
-	    {
-	      if (last_saw_cr)
-		{
-		  /* CR LF */
-		  found_pos = start + i - 1;
-		  newline_len = 2;
-		}
-	      else
-		{
-		  /* LF */
-		  found_pos = start + i;
-		  newline_len = 1;
-		}
-	    }
-	  else if (last_saw_cr)
+	}
+
+      /* Only look for a CR before the first LF */
+      lf = memchr (buffer, 10, peeked);
+      p = memchr (buffer, 13, (lf ? lf : buffer_end) - buffer);
+      if (p != NULL)
+	{
+	  /* Don't decide on CR until we have seen the next byte */
+	  if (p + 1 < buffer_end)
 	    {
-	      /* Last was cr, this is not LF, end is CR */
-	      found_pos = start + i - 1;
-	      newline_len = 1;
+	      found_pos = start + (p - buffer);
+	      newline_len = (p[1] == 10) ? 2 : 1;
 	    }
-	  /* Don't check for CR here, instead look at last_saw_cr on next byte */
-	  break;
 	}
-	
-      last_saw_cr = (buffer[i] == 13);
-
-      if (found_pos != -1)
+      else if (lf != NULL)
 	{
-	  *newline_len_out = newline_len;
-	  return found_pos;
+	  found_pos = start + (lf - buffer);
+	  newline_len = 1;
 	}
+      break;
     }
 
-  checked = end;
+  if (found_pos != -1)
+    {
+      *newline_len_out = newline_len;
+      return found_pos;
+    }
 
-  *checked_out = checked;
-  *last_saw_cr_out = last_saw_cr;
+  *checked_out = available;
+  *last_saw_cr_out = (buffer_end[-1] == 13);
   return -1;
 }
-		  
+
 
 /**
  * g_data_input_stream_read_line:
@@ -860,35 +866,38 @@ scan_for_chars (GDataInputStream *stream,
                 gssize            stop_chars_len)
 {
   GBufferedInputStream *bstream;
-  const char *buffer;
-  gsize start, end, peeked;
-  int i;
-  gsize available, checked;
-  const char *stop_char;
-  const char *stop_end;
+  const guchar *buffer, *p;
+  gsize start, peeked;
+  gsize available, i;
+  guint8 is_stop_char[256];
 
   bstream = G_BUFFERED_INPUT_STREAM (stream);
-  stop_end = stop_chars + stop_chars_len;
-
-  checked = *checked_out;
 
-  start = checked;
-  buffer = (const char *)g_buffered_input_stream_peek_buffer (bstream, &available) + start;
-  end = available;
-  peeked = end - start;
+  start = *checked_out;
+  buffer = (const guchar *)g_buffered_input_stream_peek_buffer (bstream, &available) + start;
+  peeked = available - start;
 
-  for (i = 0; checked < available && i < peeked; i++)
+  if (stop_chars_len == 1)
     {
-      for (stop_char = stop_chars; stop_char != stop_end; stop_char++)
-	{
-	  if (buffer[i] == *stop_char)
-	    return (start + i);
-	}
+      p = memchr (buffer, stop_chars[0], peeked);
+      if (p != NULL)
+	return start + (p - buffer);
+    }
+  else if (stop_chars_len > 1)
+    {
+      /* A lookup table makes this one test per byte, however many
+       * stop characters there are.
+       */
+      memset (is_stop_char, 0, sizeof is_stop_char);
+      for (i = 0; i < (gsize) stop_chars_len; i++)
+	is_stop_char[(guchar) stop_chars[i]] = 1;
+
+      for (i = 0; i < peeked; i++)
+	if (is_stop_char[buffer[i]])
+	  return start + i;
     }
 
-  checked = end;
-
-  *checked_out = checked;
+  *checked_out = available;
   return -1;
 }
 
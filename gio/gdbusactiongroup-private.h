@@ -32,6 +32,21 @@ g_dbus_action_group_sync (GDBusActionGroup  *group,
                           GCancellable      *cancellable,
                           GError           **error);
 
+void
+g_dbus_action_group_subscribe (GDBusActionGroup *group);
+
+void
+g_dbus_action_group_sync_async (GDBusActionGroup    *group,
+                                GDBusCallFlags       flags,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data);
+
+gboolean
+g_dbus_action_group_sync_finish (GDBusActionGroup  *group,
+                                 GAsyncResult      *result,
+                                 GError           **error);
+
 G_END_DECLS
 
 #endif 
@@ -505,6 +505,40 @@ g_dbus_action_group_get (GDBusConnection *connection,
   return group;
 }
 
+static void
+g_dbus_action_group_populate (GDBusActionGroup *group,
+                              GVariant         *reply)
+{
+  GVariantIter *iter;
+  ActionInfo *action;
+
+  g_assert (group->actions == NULL);
+  group->actions = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, action_info_free);
+
+  g_variant_get (reply, "(a{s(bgav)})", &iter);
+  while ((action = action_info_new_from_iter (iter)))
+    g_hash_table_insert (group->actions, action->name, action);
+  g_variant_iter_free (iter);
+}
+
+/* Subscribes to change notifications for @group.  The notifications are
+ * delivered in the thread-default main context of the caller.
+ *
+ * This is split from the DescribeAll call so that the subscription is
+ * always in place before the description is requested, even when the
+ * caller wants the reply delivered to a different main context.
+ */
+void
+g_dbus_action_group_subscribe (GDBusActionGroup *group)
+{
+  if (group->subscription_id != 0)
+    return;
+
+  group->subscription_id =
+    g_dbus_connection_signal_subscribe (group->connection, group->bus_name, "org.gtk.Actions", "Changed", group->object_path,
+                                        NULL, G_DBUS_SIGNAL_FLAGS_NONE, g_dbus_action_group_changed, group, NULL);
+}
+
 gboolean
 g_dbus_action_group_sync (GDBusActionGroup  *group,
                           GCancellable      *cancellable,
@@ -512,11 +546,7 @@ g_dbus_action_group_sync (GDBusActionGroup  *group,
 {
   GVariant *reply;
 
-  g_assert (group->subscription_id == 0);
-
-  group->subscription_id =
-    g_dbus_connection_signal_subscribe (group->connection, group->bus_name, "org.gtk.Actions", "Changed", group->object_path,
-                                        NULL, G_DBUS_SIGNAL_FLAGS_NONE, g_dbus_action_group_changed, group, NULL);
+  g_dbus_action_group_subscribe (group);
 
   reply = g_dbus_connection_call_sync (group->connection, group->bus_name, group->object_path, "org.gtk.Actions",
                                        "DescribeAll", NULL, G_VARIANT_TYPE ("(a{s(bgav)})"),
@@ -524,16 +554,50 @@ g_dbus_action_group_sync (GDBusActionGroup  *group,
 
   if (reply != NULL)
     {
-      GVariantIter *iter;
-      ActionInfo *action;
+      g_dbus_action_group_populate (group, reply);
+      g_variant_unref (reply);
+    }
 
-      g_assert (group->actions == NULL);
-      group->actions = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, action_info_free);
+  return reply != NULL;
+}
 
-      g_variant_get (reply, "(a{s(bgav)})", &iter);
-      while ((action = action_info_new_from_iter (iter)))
-        g_hash_table_insert (group->actions, action->name, action);
-      g_variant_iter_free (iter);
+/* Asynchronous version of g_dbus_action_group_sync().
+ *
+ * @flags are passed to the DescribeAll call; this allows the caller to
+ * pass %G_DBUS_CALL_FLAGS_NO_AUTO_START when it only wants to know
+ * about an instance that is already running.
+ *
+ * If the call fails, @group is left unpopulated and it is still valid
+ * to call g_dbus_action_group_sync() on it.
+ */
+void
+g_dbus_action_group_sync_async (GDBusActionGroup    *group,
+                                GDBusCallFlags       flags,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  g_assert (group->actions == NULL);
+
+  g_dbus_action_group_subscribe (group);
+
+  g_dbus_connection_call (group->connection, group->bus_name, group->object_path, "org.gtk.Actions",
+                          "DescribeAll", NULL, G_VARIANT_TYPE ("(a{s(bgav)})"),
+                          flags, -1, cancellable, callback, user_data);
+}
+
+gboolean
+g_dbus_action_group_sync_finish (GDBusActionGroup  *group,
+                                 GAsyncResult      *result,
+                                 GError           **error)
+{
+  GVariant *reply;
+
+  reply = g_dbus_connection_call_finish (group->connection, result, error);
+
+  if (reply != NULL)
+    {
+      g_dbus_action_group_populate (group, reply);
       g_variant_unref (reply);
     }
 
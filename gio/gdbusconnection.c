@@ -434,7 +434,7 @@ struct _GDBusConnection
   /* Maps used for managing signal subscription, protected by @lock */
   GHashTable *map_rule_to_signal_data;                      /* match rule (gchar*)    -> SignalData */
   GHashTable *map_id_to_signal_data;                        /* id (guint)             -> SignalData */
-  GHashTable *map_sender_unique_name_to_signal_data_array;  /* unique sender (gchar*) -> GPtrArray* of SignalData */
+  GHashTable *map_sender_unique_name_to_signal_data_index;  /* unique sender (gchar*) -> SignalDataIndex* */
 
   /* Maps used for managing exported objects and subtrees,
    * protected by @lock
@@ -504,6 +504,9 @@ static gboolean handle_generic_unlocked (GDBusConnection *connection,
                                          GDBusMessage    *message);
 
 
+typedef struct _SignalDataIndex SignalDataIndex;
+static void signal_data_index_free (SignalDataIndex *index);
+
 static void purge_all_signal_subscriptions (GDBusConnection *connection);
 static void purge_all_filters (GDBusConnection *connection);
 
@@ -680,7 +683,7 @@ g_dbus_connection_finalize (GObject *object)
 
   g_hash_table_unref (connection->map_rule_to_signal_data);
   g_hash_table_unref (connection->map_id_to_signal_data);
-  g_hash_table_unref (connection->map_sender_unique_name_to_signal_data_array);
+  g_hash_table_unref (connection->map_sender_unique_name_to_signal_data_index);
 
   g_hash_table_unref (connection->map_id_to_ei);
   g_hash_table_unref (connection->map_object_path_to_eo);
@@ -1086,10 +1089,10 @@ g_dbus_connection_init (GDBusConnection *connection)
                                                           g_str_equal);
   connection->map_id_to_signal_data = g_hash_table_new (g_direct_hash,
                                                         g_direct_equal);
-  connection->map_sender_unique_name_to_signal_data_array = g_hash_table_new_full (g_str_hash,
+  connection->map_sender_unique_name_to_signal_data_index = g_hash_table_new_full (g_str_hash,
                                                                                    g_str_equal,
                                                                                    g_free,
-                                                                                   (GDestroyNotify) g_ptr_array_unref);
+                                                                                   (GDestroyNotify) signal_data_index_free);
 
   connection->map_object_path_to_eo = g_hash_table_new_full (g_str_hash,
                                                              g_str_equal,
@@ -2652,6 +2655,7 @@ initable_init (GInitable     *initable,
   connection->worker = _g_dbus_worker_new (connection->stream,
                                            connection->capabilities,
                                            ((connection->flags & G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING) != 0),
+                                           ((connection->flags & G_DBUS_CONNECTION_FLAGS_DEDICATED_WORKER_THREAD) != 0),
                                            on_worker_message_received,
                                            on_worker_message_about_to_be_sent,
                                            on_worker_closed,
@@ -3260,6 +3264,7 @@ typedef struct
   gchar *arg0;
   GDBusSignalFlags flags;
   GArray *subscribers;
+  guint order; /* id of the first subscriber, used to dispatch in subscription order */
 } SignalData;
 
 typedef struct
@@ -3285,6 +3290,171 @@ signal_data_free (SignalData *signal_data)
   g_free (signal_data);
 }
 
+/* Index of the SignalData for one sender, so that an incoming signal
+ * only needs to be checked against the subscriptions that can possibly
+ * match it instead of all of them.
+ *
+ * Each SignalData lives in exactly one place, picked by the most
+ * selective thing it matches on: arg0 first (e.g. NameOwnerChanged
+ * watches, which all share path, interface and member), then the
+ * object path, then the member.  The remaining fields are still
+ * checked for every candidate.
+ */
+struct _SignalDataIndex
+{
+  GHashTable *by_arg0;            /* arg0 (gchar*)           -> GPtrArray* of SignalData */
+  GHashTable *by_arg0_namespace;  /* arg0 namespace (gchar*) -> GPtrArray* of SignalData */
+  GHashTable *by_arg0_path;       /* arg0 path (gchar*)      -> GPtrArray* of SignalData */
+  GSequence  *arg0_paths;         /* keys of @by_arg0_path, sorted */
+  GHashTable *by_object_path;     /* object path (gchar*)    -> GPtrArray* of SignalData */
+  GHashTable *by_member;          /* member (gchar*)         -> GPtrArray* of SignalData */
+  GPtrArray  *others;             /* SignalData not matching on any of the above */
+  guint       size;
+};
+
+static GHashTable *
+signal_data_table_new (void)
+{
+  return g_hash_table_new_full (g_str_hash,
+                                g_str_equal,
+                                g_free,
+                                (GDestroyNotify) g_ptr_array_unref);
+}
+
+static SignalDataIndex *
+signal_data_index_new (void)
+{
+  SignalDataIndex *index;
+
+  index = g_new0 (SignalDataIndex, 1);
+  index->by_arg0 = signal_data_table_new ();
+  index->by_arg0_namespace = signal_data_table_new ();
+  index->by_arg0_path = signal_data_table_new ();
+  index->arg0_paths = g_sequence_new (NULL);
+  index->by_object_path = signal_data_table_new ();
+  index->by_member = signal_data_table_new ();
+  index->others = g_ptr_array_new ();
+
+  return index;
+}
+
+static void
+signal_data_index_free (SignalDataIndex *index)
+{
+  g_hash_table_unref (index->by_arg0);
+  g_hash_table_unref (index->by_arg0_namespace);
+  g_sequence_free (index->arg0_paths);
+  g_hash_table_unref (index->by_arg0_path);
+  g_hash_table_unref (index->by_object_path);
+  g_hash_table_unref (index->by_member);
+  g_ptr_array_unref (index->others);
+  g_free (index);
+}
+
+/* Returns the table @signal_data goes into and its key in there, or
+ * %NULL if it goes into @others
+ */
+static GHashTable *
+signal_data_index_get_table (SignalDataIndex  *index,
+                             SignalData       *signal_data,
+                             const gchar     **out_key)
+{
+  if (signal_data->arg0 != NULL)
+    {
+      *out_key = signal_data->arg0;
+      if (signal_data->flags & G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_NAMESPACE)
+        return index->by_arg0_namespace;
+      else if (signal_data->flags & G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH)
+        return index->by_arg0_path;
+      else
+        return index->by_arg0;
+    }
+  else if (signal_data->object_path != NULL)
+    {
+      *out_key = signal_data->object_path;
+      return index->by_object_path;
+    }
+  else if (signal_data->member != NULL)
+    {
+      *out_key = signal_data->member;
+      return index->by_member;
+    }
+
+  *out_key = NULL;
+  return NULL;
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b,
+                 gpointer      user_data)
+{
+  return strcmp (a, b);
+}
+
+static void
+signal_data_index_add (SignalDataIndex *index,
+                       SignalData      *signal_data)
+{
+  GHashTable *table;
+  GPtrArray *signal_data_array;
+  const gchar *key;
+  gchar *owned_key;
+
+  table = signal_data_index_get_table (index, signal_data, &key);
+  if (table == NULL)
+    {
+      g_ptr_array_add (index->others, signal_data);
+      goto out;
+    }
+
+  signal_data_array = g_hash_table_lookup (table, key);
+  if (signal_data_array == NULL)
+    {
+      signal_data_array = g_ptr_array_new ();
+      owned_key = g_strdup (key);
+      g_hash_table_insert (table, owned_key, signal_data_array);
+      if (table == index->by_arg0_path)
+        g_sequence_insert_sorted (index->arg0_paths, owned_key, compare_strings, NULL);
+    }
+  g_ptr_array_add (signal_data_array, signal_data);
+
+ out:
+  index->size++;
+}
+
+static void
+signal_data_index_remove (SignalDataIndex *index,
+                          SignalData      *signal_data)
+{
+  GHashTable *table;
+  GPtrArray *signal_data_array;
+  const gchar *key;
+
+  table = signal_data_index_get_table (index, signal_data, &key);
+  if (table == NULL)
+    {
+      g_warn_if_fail (g_ptr_array_remove (index->others, signal_data));
+      goto out;
+    }
+
+  signal_data_array = g_hash_table_lookup (table, key);
+  g_warn_if_fail (signal_data_array != NULL);
+  if (signal_data_array == NULL)
+    goto out;
+
+  g_warn_if_fail (g_ptr_array_remove (signal_data_array, signal_data));
+  if (signal_data_array->len == 0)
+    {
+      if (table == index->by_arg0_path)
+        g_sequence_remove (g_sequence_lookup (index->arg0_paths, (gpointer) key, compare_strings, NULL));
+      g_hash_table_remove (table, key);
+    }
+
+ out:
+  index->size--;
+}
+
 static gchar *
 args_to_rule (const gchar      *sender,
               const gchar      *interface_name,
@@ -3462,7 +3632,7 @@ g_dbus_connection_signal_subscribe (GDBusConnection     *connection,
   gchar *rule;
   SignalData *signal_data;
   SignalSubscriber subscriber;
-  GPtrArray *signal_data_array;
+  SignalDataIndex *signal_data_index;
   const gchar *sender_unique_name;
 
   /* Right now we abort if AddMatch() fails since it can only fail with the bus being in
@@ -3527,6 +3697,7 @@ g_dbus_connection_signal_subscribe (GDBusConnection     *connection,
   signal_data->arg0                  = g_strdup (arg0);
   signal_data->flags                 = flags;
   signal_data->subscribers           = g_array_new (FALSE, FALSE, sizeof (SignalSubscriber));
+  signal_data->order                 = subscriber.id;
   g_array_append_val (signal_data->subscribers, subscriber);
 
   g_hash_table_insert (connection->map_rule_to_signal_data,
@@ -3544,16 +3715,16 @@ g_dbus_connection_signal_subscribe (GDBusConnection     *connection,
         add_match_rule (connection, signal_data->rule);
     }
 
-  signal_data_array = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_array,
+  signal_data_index = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_index,
                                            signal_data->sender_unique_name);
-  if (signal_data_array == NULL)
+  if (signal_data_index == NULL)
     {
-      signal_data_array = g_ptr_array_new ();
-      g_hash_table_insert (connection->map_sender_unique_name_to_signal_data_array,
+      signal_data_index = signal_data_index_new ();
+      g_hash_table_insert (connection->map_sender_unique_name_to_signal_data_index,
                            g_strdup (signal_data->sender_unique_name),
-                           signal_data_array);
+                           signal_data_index);
     }
-  g_ptr_array_add (signal_data_array, signal_data);
+  signal_data_index_add (signal_data_index, signal_data);
 
  out:
   g_hash_table_insert (connection->map_id_to_signal_data,
@@ -3575,7 +3746,7 @@ unsubscribe_id_internal (GDBusConnection *connection,
                          GArray          *out_removed_subscribers)
 {
   SignalData *signal_data;
-  GPtrArray *signal_data_array;
+  SignalDataIndex *signal_data_index;
   guint n;
 
   signal_data = g_hash_table_lookup (connection->map_id_to_signal_data,
@@ -3603,14 +3774,14 @@ unsubscribe_id_internal (GDBusConnection *connection,
         {
           g_warn_if_fail (g_hash_table_remove (connection->map_rule_to_signal_data, signal_data->rule));
 
-          signal_data_array = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_array,
+          signal_data_index = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_index,
                                                    signal_data->sender_unique_name);
-          g_warn_if_fail (signal_data_array != NULL);
-          g_warn_if_fail (g_ptr_array_remove (signal_data_array, signal_data));
+          g_warn_if_fail (signal_data_index != NULL);
+          signal_data_index_remove (signal_data_index, signal_data);
 
-          if (signal_data_array->len == 0)
+          if (signal_data_index->size == 0)
             {
-              g_warn_if_fail (g_hash_table_remove (connection->map_sender_unique_name_to_signal_data_array,
+              g_warn_if_fail (g_hash_table_remove (connection->map_sender_unique_name_to_signal_data_index,
                                                    signal_data->sender_unique_name));
             }
 
@@ -3798,10 +3969,179 @@ path_rule_matches (const gchar *path_a,
   return memcmp (path_a, path_b, MIN (len_a, len_b)) == 0;
 }
 
+static gboolean
+signal_data_matches (SignalData  *signal_data,
+                     const gchar *interface,
+                     const gchar *member,
+                     const gchar *path,
+                     const gchar *arg0)
+{
+  if (signal_data->interface_name != NULL && g_strcmp0 (signal_data->interface_name, interface) != 0)
+    return FALSE;
+
+  if (signal_data->member != NULL && g_strcmp0 (signal_data->member, member) != 0)
+    return FALSE;
+
+  if (signal_data->object_path != NULL && g_strcmp0 (signal_data->object_path, path) != 0)
+    return FALSE;
+
+  if (signal_data->arg0 != NULL)
+    {
+      if (arg0 == NULL)
+        return FALSE;
+
+      if (signal_data->flags & G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_NAMESPACE)
+        {
+          if (!namespace_rule_matches (signal_data->arg0, arg0))
+            return FALSE;
+        }
+      else if (signal_data->flags & G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH)
+        {
+          if (!path_rule_matches (signal_data->arg0, arg0))
+            return FALSE;
+        }
+      else if (!g_str_equal (signal_data->arg0, arg0))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+collect_candidates (GPtrArray   *candidates,
+                    GHashTable  *table,
+                    const gchar *key)
+{
+  GPtrArray *signal_data_array;
+  guint n;
+
+  signal_data_array = g_hash_table_lookup (table, key);
+  if (signal_data_array == NULL)
+    return;
+
+  for (n = 0; n < signal_data_array->len; n++)
+    g_ptr_array_add (candidates, signal_data_array->pdata[n]);
+}
+
+/* Looks up @table for every prefix of @str that ends right before
+ * (or, if @include_separator is %TRUE, right after) a @separator,
+ * except for @str itself.
+ */
+static void
+collect_candidates_for_prefixes (GPtrArray   *candidates,
+                                 GHashTable  *table,
+                                 const gchar *str,
+                                 gchar        separator,
+                                 gboolean     include_separator)
+{
+  gchar *prefix;
+  gsize len;
+  gsize n;
+
+  if (g_hash_table_size (table) == 0)
+    return;
+
+  len = strlen (str);
+  prefix = g_strdup (str);
+  for (n = 0; n + 1 < len; n++)
+    {
+      gsize end;
+
+      if (str[n] != separator)
+        continue;
+
+      end = include_separator ? n + 1 : n;
+      prefix[end] = '\0';
+      collect_candidates (candidates, table, prefix);
+      prefix[end] = str[end];
+    }
+  g_free (prefix);
+}
+
+static gint
+compare_signal_data_order (gconstpointer a,
+                           gconstpointer b)
+{
+  const SignalData *signal_data_a = *(SignalData * const *) a;
+  const SignalData *signal_data_b = *(SignalData * const *) b;
+
+  if (signal_data_a->order < signal_data_b->order)
+    return -1;
+  else if (signal_data_a->order > signal_data_b->order)
+    return 1;
+  return 0;
+}
+
+/* Collects the SignalData in @index matching the given signal, in the
+ * order they were subscribed
+ */
+static GPtrArray *
+signal_data_index_lookup (SignalDataIndex *index,
+                          const gchar     *interface,
+                          const gchar     *member,
+                          const gchar     *path,
+                          const gchar     *arg0)
+{
+  GPtrArray *candidates;
+  GPtrArray *matches;
+  guint n;
+
+  candidates = g_ptr_array_new ();
+
+  if (arg0 != NULL)
+    {
+      collect_candidates (candidates, index->by_arg0, arg0);
+
+      /* arg0namespace='a.b' matches 'a.b' and 'a.b.c' */
+      collect_candidates (candidates, index->by_arg0_namespace, arg0);
+      collect_candidates_for_prefixes (candidates, index->by_arg0_namespace, arg0, '.', FALSE);
+
+      /* arg0path='/a/' matches '/a/b', and arg0path='/a/b' matches '/a/' */
+      collect_candidates (candidates, index->by_arg0_path, arg0);
+      collect_candidates_for_prefixes (candidates, index->by_arg0_path, arg0, '/', TRUE);
+      if (g_str_has_suffix (arg0, "/"))
+        {
+          GSequenceIter *iter;
+
+          iter = g_sequence_search (index->arg0_paths, (gpointer) arg0, compare_strings, NULL);
+          while (!g_sequence_iter_is_end (iter) &&
+                 g_str_has_prefix (g_sequence_get (iter), arg0))
+            {
+              if (!g_str_equal (g_sequence_get (iter), arg0))
+                collect_candidates (candidates, index->by_arg0_path, g_sequence_get (iter));
+              iter = g_sequence_iter_next (iter);
+            }
+        }
+    }
+
+  if (path != NULL)
+    collect_candidates (candidates, index->by_object_path, path);
+
+  if (member != NULL)
+    collect_candidates (candidates, index->by_member, member);
+
+  for (n = 0; n < index->others->len; n++)
+    g_ptr_array_add (candidates, index->others->pdata[n]);
+
+  matches = g_ptr_array_sized_new (candidates->len);
+  for (n = 0; n < candidates->len; n++)
+    {
+      SignalData *signal_data = candidates->pdata[n];
+
+      if (signal_data_matches (signal_data, interface, member, path, arg0))
+        g_ptr_array_add (matches, signal_data);
+    }
+  g_ptr_array_unref (candidates);
+
+  g_ptr_array_sort (matches, compare_signal_data_order);
+
+  return matches;
+}
+
 /* called in GDBusWorker thread WITH lock held */
 static void
 schedule_callbacks (GDBusConnection *connection,
-                    GPtrArray       *signal_data_array,
+                    SignalDataIndex *signal_data_index,
                     GDBusMessage    *message,
                     const gchar     *sender)
 {
@@ -3810,6 +4150,7 @@ schedule_callbacks (GDBusConnection *connection,
   const gchar *member;
   const gchar *path;
   const gchar *arg0;
+  GPtrArray *matches;
 
   interface = NULL;
   member = NULL;
@@ -3835,40 +4176,10 @@ schedule_callbacks (GDBusConnection *connection,
            arg0);
 #endif
 
-  /* TODO: if this is slow, then we can change signal_data_array into
-   *       map_object_path_to_signal_data_array or something.
-   */
-  for (n = 0; n < signal_data_array->len; n++)
+  matches = signal_data_index_lookup (signal_data_index, interface, member, path, arg0);
+  for (n = 0; n < matches->len; n++)
     {
-      SignalData *signal_data = signal_data_array->pdata[n];
-
-      if (signal_data->interface_name != NULL && g_strcmp0 (signal_data->interface_name, interface) != 0)
-        continue;
-
-      if (signal_data->member != NULL && g_strcmp0 (signal_data->member, member) != 0)
-        continue;
-
-      if (signal_data->object_path != NULL && g_strcmp0 (signal_data->object_path, path) != 0)
-        continue;
-
-      if (signal_data->arg0 != NULL)
-        {
-          if (arg0 == NULL)
-            continue;
-
-          if (signal_data->flags & G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_NAMESPACE)
-            {
-              if (!namespace_rule_matches (signal_data->arg0, arg0))
-                continue;
-            }
-          else if (signal_data->flags & G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH)
-            {
-              if (!path_rule_matches (signal_data->arg0, arg0))
-                continue;
-            }
-          else if (!g_str_equal (signal_data->arg0, arg0))
-            continue;
-        }
+      SignalData *signal_data = matches->pdata[n];
 
       for (m = 0; m < signal_data->subscribers->len; m++)
         {
@@ -3899,6 +4210,7 @@ schedule_callbacks (GDBusConnection *connection,
           g_source_unref (idle_source);
         }
     }
+  g_ptr_array_unref (matches);
 }
 
 /* called in GDBusWorker thread with lock held */
@@ -3906,7 +4218,7 @@ static void
 distribute_signals (GDBusConnection *connection,
                     GDBusMessage    *message)
 {
-  GPtrArray *signal_data_array;
+  SignalDataIndex *signal_data_index;
   const gchar *sender;
 
   sender = g_dbus_message_get_sender (message);
@@ -3929,15 +4241,15 @@ distribute_signals (GDBusConnection *connection,
   /* collect subscribers that match on sender */
   if (sender != NULL)
     {
-      signal_data_array = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_array, sender);
-      if (signal_data_array != NULL)
-        schedule_callbacks (connection, signal_data_array, message, sender);
+      signal_data_index = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_index, sender);
+      if (signal_data_index != NULL)
+        schedule_callbacks (connection, signal_data_index, message, sender);
     }
 
   /* collect subscribers not matching on sender */
-  signal_data_array = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_array, "");
-  if (signal_data_array != NULL)
-    schedule_callbacks (connection, signal_data_array, message, sender);
+  signal_data_index = g_hash_table_lookup (connection->map_sender_unique_name_to_signal_data_index, "");
+  if (signal_data_index != NULL)
+    schedule_callbacks (connection, signal_data_index, message, sender);
 }
 
 /* ---------------------------------------------------------------------------------------------------- */
@@ -4050,12 +4362,60 @@ typedef struct
   GMainContext               *context;
   gpointer                    user_data;
   GDestroyNotify              user_data_free_func;
+
+  /* maps method name (gchar*) -> ExportedMethod*, built when registering */
+  GHashTable                 *map_method_name_to_em;
 } ExportedInterface;
 
+typedef struct
+{
+  GDBusMethodInfo *method_info;
+  gchar           *in_signature; /* complete signature of the in args, e.g. "(sa{sv})" */
+} ExportedMethod;
+
+static void
+exported_method_free (ExportedMethod *em)
+{
+  g_free (em->in_signature);
+  g_free (em);
+}
+
+static GHashTable *
+build_method_table (GDBusInterfaceInfo *interface_info)
+{
+  GHashTable *table;
+  guint n;
+
+  table = g_hash_table_new_full (g_str_hash,
+                                 g_str_equal,
+                                 NULL,
+                                 (GDestroyNotify) exported_method_free);
+  for (n = 0; interface_info->methods != NULL && interface_info->methods[n] != NULL; n++)
+    {
+      GDBusMethodInfo *method_info = interface_info->methods[n];
+      ExportedMethod *em;
+      GVariantType *in_type;
+
+      in_type = _g_dbus_compute_complete_signature (method_info->in_args);
+      if (in_type == NULL)
+        continue;
+
+      em = g_new0 (ExportedMethod, 1);
+      em->method_info = method_info;
+      em->in_signature = g_variant_type_dup_string (in_type);
+      g_variant_type_free (in_type);
+
+      g_hash_table_insert (table, method_info->name, em);
+    }
+
+  return table;
+}
+
 /* called with lock held */
 static void
 exported_interface_free (ExportedInterface *ei)
 {
+  g_hash_table_unref (ei->map_method_name_to_em);
   g_dbus_interface_info_cache_release (ei->interface_info);
   g_dbus_interface_info_unref ((GDBusInterfaceInfo *) ei->interface_info);
 
@@ -4929,20 +5289,34 @@ validate_and_maybe_schedule_method_call (GDBusConnection            *connection,
                                          guint                       registration_id,
                                          guint                       subtree_registration_id,
                                          GDBusInterfaceInfo         *interface_info,
+                                         GHashTable                 *method_table,
                                          const GDBusInterfaceVTable *vtable,
                                          GMainContext               *main_context,
                                          gpointer                    user_data)
 {
   GDBusMethodInfo *method_info;
+  ExportedMethod *em;
   GDBusMessage *reply;
   GVariant *parameters;
   gboolean handled;
-  GVariantType *in_type;
+  gboolean args_match;
 
   handled = FALSE;
 
-  /* TODO: the cost of this is O(n) - it might be worth caching the result */
-  method_info = g_dbus_interface_info_lookup_method (interface_info, g_dbus_message_get_member (message));
+  /* objects registered with g_dbus_connection_register_object() come
+   * with a table built at registration time, subtrees hand out their
+   * interfaces on the fly
+   */
+  em = NULL;
+  if (method_table != NULL)
+    {
+      em = g_hash_table_lookup (method_table, g_dbus_message_get_member (message));
+      method_info = em != NULL ? em->method_info : NULL;
+    }
+  else
+    {
+      method_info = g_dbus_interface_info_lookup_method (interface_info, g_dbus_message_get_member (message));
+    }
 
   /* if the method doesn't exist, return the org.freedesktop.DBus.Error.UnknownMethod
    * error to the caller
@@ -4973,11 +5347,17 @@ validate_and_maybe_schedule_method_call (GDBusConnection            *connection,
   /* Check that the incoming args are of the right type - if they are not, return
    * the org.freedesktop.DBus.Error.InvalidArgs error to the caller
    */
-  in_type = _g_dbus_compute_complete_signature (method_info->in_args);
-  if (!g_variant_is_of_type (parameters, in_type))
+  if (em != NULL)
+    args_match = g_str_equal (g_variant_get_type_string (parameters), em->in_signature);
+  else
+    args_match = _g_dbus_args_match_type_string (method_info->in_args,
+                                                 g_variant_get_type_string (parameters));
+  if (!args_match)
     {
+      GVariantType *in_type;
       gchar *type_string;
 
+      in_type = _g_dbus_compute_complete_signature (method_info->in_args);
       type_string = g_variant_type_dup_string (in_type);
 
       reply = g_dbus_message_new_method_error (message,
@@ -4993,7 +5373,6 @@ validate_and_maybe_schedule_method_call (GDBusConnection            *connection,
       handled = TRUE;
       goto out;
     }
-  g_variant_type_free (in_type);
 
   /* schedule the call in idle */
   schedule_method_call (connection, message, registration_id, subtree_registration_id,
@@ -5043,6 +5422,7 @@ obj_message_func (GDBusConnection *connection,
                                                              ei->id,
                                                              0,
                                                              ei->interface_info,
+                                                             ei->map_method_name_to_em,
                                                              ei->vtable,
                                                              ei->context,
                                                              ei->user_data);
@@ -5194,6 +5574,7 @@ g_dbus_connection_register_object (GDBusConnection            *connection,
   ei->vtable = _g_dbus_interface_vtable_copy (vtable);
   ei->interface_info = g_dbus_interface_info_ref (interface_info);
   g_dbus_interface_info_cache_build (ei->interface_info);
+  ei->map_method_name_to_em = build_method_table (ei->interface_info);
   ei->interface_name = g_strdup (interface_info->name);
   ei->context = g_main_context_ref_thread_default ();
 
@@ -6316,6 +6697,7 @@ handle_subtree_method_invocation (GDBusConnection *connection,
                                                          0,
                                                          es->id,
                                                          interface_info,
+                                                         NULL, /* method_table */
                                                          interface_vtable,
                                                          es->context,
                                                          interface_user_data);
@@ -34,6 +34,27 @@
 
 #define IDLE_TIMEOUT_MSEC 3000
 
+/* Threading
+ *
+ * The org.freedesktop.DBus methods are handled, and clients are added
+ * and removed, in the main context the daemon was created in.  Messages
+ * between clients never go through it: they are routed from the
+ * incoming filter of the sending connection, that is in the GDBus
+ * worker thread, or, if routing threads were asked for, in the routing
+ * thread the sending client was assigned to.
+ *
+ * The routing tables (@clients, @names, the owners and queues of the
+ * names, and the matches of the clients) are protected by @lock.  They
+ * are only changed in the main context, with the lock held for writing;
+ * routing takes it for reading.
+ */
+
+typedef struct {
+  GThread *thread;
+  GMainContext *context;
+  GMainLoop *loop;
+} RoutingThread;
+
 struct _GDBusDaemon
 {
   _GFreedesktopDBusSkeleton parent_instance;
@@ -43,10 +64,14 @@ struct _GDBusDaemon
   gchar *tmpdir;
   GDBusServer *server;
   gchar *guid;
+  GRWLock lock;
   GHashTable *clients;
   GHashTable *names;
   guint32 next_major_id;
   guint32 next_minor_id;
+  guint n_routing_threads;
+  RoutingThread *routing_threads;
+  guint next_routing_thread;
 };
 
 struct _GDBusDaemonClass
@@ -57,6 +82,7 @@ struct _GDBusDaemonClass
 enum {
   PROP_0,
   PROP_ADDRESS,
+  PROP_ROUTING_THREADS,
 };
 
 enum
@@ -77,10 +103,16 @@ G_DEFINE_TYPE_WITH_CODE (GDBusDaemon, g_dbus_daemon, _G_TYPE_FREEDESKTOP_DBUS_SK
 			 G_IMPLEMENT_INTERFACE (_G_TYPE_FREEDESKTOP_DBUS, g_dbus_daemon_iface_init));
 
 typedef struct {
+  volatile gint ref_count;
   GDBusDaemon *daemon;
   char *id;
   GDBusConnection *connection;
   GList *matches;
+  guint filter_id;
+  /* where messages from this client are routed, or %NULL to route
+   * them in the worker thread
+   */
+  GMainContext *routing_context;
 } Client;
 
 typedef struct {
@@ -632,6 +664,7 @@ match_matches (GDBusDaemon *daemon,
   return TRUE;
 }
 
+/* Called with daemon->lock held */
 static void
 broadcast_message (GDBusDaemon *daemon,
 		   GDBusMessage *message,
@@ -815,6 +848,24 @@ name_queue_owner (Name *name, NameOwner *owner)
   name_ref (name);
 }
 
+static Client *
+client_ref (Client *client)
+{
+  g_atomic_int_inc (&client->ref_count);
+  return client;
+}
+
+static void
+client_unref (Client *client)
+{
+  if (g_atomic_int_dec_and_test (&client->ref_count))
+    {
+      g_object_unref (client->connection);
+      g_free (client->id);
+      g_free (client);
+    }
+}
+
 static Client *
 client_new (GDBusDaemon *daemon, GDBusConnection *connection)
 {
@@ -822,6 +873,7 @@ client_new (GDBusDaemon *daemon, GDBusConnection *connection)
   GError *error = NULL;
 
   client = g_new0 (Client, 1);
+  client->ref_count = 1;
   client->daemon = daemon;
   client->id = g_strdup_printf (":%d.%d", daemon->next_major_id, daemon->next_minor_id);
   client->connection = g_object_ref (connection);
@@ -834,32 +886,55 @@ client_new (GDBusDaemon *daemon, GDBusConnection *connection)
   else
     daemon->next_minor_id++;
 
+  if (daemon->n_routing_threads > 0)
+    {
+      RoutingThread *thread;
+
+      thread = &daemon->routing_threads[daemon->next_routing_thread++ % daemon->n_routing_threads];
+      client->routing_context = thread->context;
+    }
+
   g_object_set_data (G_OBJECT (connection), "client", client);
+
+  g_rw_lock_writer_lock (&daemon->lock);
   g_hash_table_insert (daemon->clients, client->id, client);
+  g_rw_lock_writer_unlock (&daemon->lock);
 
   g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (daemon), connection,
 				    "/org/freedesktop/DBus", &error);
   g_assert_no_error (error);
 
   g_signal_connect (connection, "closed", G_CALLBACK (connection_closed), client);
-  g_dbus_connection_add_filter (connection,
-				filter_function,
-				client, NULL);
+  client->filter_id = g_dbus_connection_add_filter (connection,
+						    filter_function,
+						    client_ref (client),
+						    (GDestroyNotify) client_unref);
 
+  g_rw_lock_writer_lock (&daemon->lock);
   send_name_owner_changed (daemon, client->id, NULL, client->id);
+  g_rw_lock_writer_unlock (&daemon->lock);
 
   return client;
 }
 
+/* Takes @client off the bus.  Messages it sent that are still waiting
+ * in a routing thread keep it alive until they have been routed.
+ */
 static void
-client_free (Client *client)
+client_remove (Client *client)
 {
   GDBusDaemon *daemon = client->daemon;
   GList *l, *names;
 
+  g_signal_handlers_disconnect_by_func (client->connection, connection_closed, client);
+  g_dbus_connection_remove_filter (client->connection, client->filter_id);
+  g_object_set_data (G_OBJECT (client->connection), "client", NULL);
+
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (daemon),
 						      client->connection);
 
+  g_rw_lock_writer_lock (&daemon->lock);
+
   g_hash_table_remove (daemon->clients, client->id);
 
   names = g_hash_table_get_values (daemon->names);
@@ -880,14 +955,14 @@ client_free (Client *client)
 
   send_name_owner_changed (daemon, client->id, client->id, NULL);
 
-  g_object_unref (client->connection);
-
   for (l = client->matches; l != NULL; l = l->next)
     match_free (l->data);
   g_list_free (client->matches);
+  client->matches = NULL;
 
-  g_free (client->id);
-  g_free (client);
+  g_rw_lock_writer_unlock (&daemon->lock);
+
+  client_unref (client);
 }
 
 static gboolean
@@ -912,7 +987,7 @@ connection_closed (GDBusConnection *connection,
 {
   GDBusDaemon *daemon = client->daemon;
 
-  client_free (client);
+  client_remove (client);
 
   if (g_hash_table_size (daemon->clients) == 0)
     daemon->timeout = g_timeout_add (IDLE_TIMEOUT_MSEC,
@@ -936,7 +1011,9 @@ handle_add_match (_GFreedesktopDBus *object,
 					   "Invalid rule: %s", arg_rule);
   else
     {
+      g_rw_lock_writer_lock (&client->daemon->lock);
       client->matches = g_list_prepend (client->matches, match);
+      g_rw_lock_writer_unlock (&client->daemon->lock);
       _g_freedesktop_dbus_complete_add_match (object, invocation);
     }
   return TRUE;
@@ -1174,6 +1251,8 @@ handle_release_name (_GFreedesktopDBus *object,
       return TRUE;
     }
 
+  g_rw_lock_writer_lock (&daemon->lock);
+
   name = name_lookup (daemon, arg_name);
 
   if (name == NULL)
@@ -1188,6 +1267,8 @@ handle_release_name (_GFreedesktopDBus *object,
   else
     result = DBUS_RELEASE_NAME_REPLY_NOT_OWNER;
 
+  g_rw_lock_writer_unlock (&daemon->lock);
+
   _g_freedesktop_dbus_complete_release_name (object, invocation, result);
   return TRUE;
 }
@@ -1228,6 +1309,7 @@ handle_remove_match (_GFreedesktopDBus *object,
 					   "Invalid rule: %s", arg_rule);
   else
     {
+      g_rw_lock_writer_lock (&client->daemon->lock);
       for (l = client->matches; l != NULL; l = l->next)
 	{
 	  other_match = l->data;
@@ -1238,6 +1320,7 @@ handle_remove_match (_GFreedesktopDBus *object,
 	      break;
 	    }
 	}
+      g_rw_lock_writer_unlock (&client->daemon->lock);
 
       if (l == NULL)
 	g_dbus_method_invocation_return_error (invocation,
@@ -1288,6 +1371,8 @@ handle_request_name (_GFreedesktopDBus *object,
       return TRUE;
     }
 
+  g_rw_lock_writer_lock (&daemon->lock);
+
   name = name_ensure (daemon, arg_name);
   if (name->owner == NULL)
     {
@@ -1330,6 +1415,8 @@ handle_request_name (_GFreedesktopDBus *object,
 
   name_unref (name);
 
+  g_rw_lock_writer_unlock (&daemon->lock);
+
   _g_freedesktop_dbus_complete_request_name (object, invocation, result);
   return TRUE;
 }
@@ -1389,6 +1476,7 @@ return_error (Client *client, GDBusMessage *message,
   g_object_unref (reply);
 }
 
+/* Called in the worker thread or a routing thread */
 static GDBusMessage *
 route_message (Client *source_client, GDBusMessage *message)
 {
@@ -1398,6 +1486,8 @@ route_message (Client *source_client, GDBusMessage *message)
 
   daemon = source_client->daemon;
 
+  g_rw_lock_reader_lock (&daemon->lock);
+
   dest_client = NULL;
   dest = g_dbus_message_get_destination (message);
   if (dest != NULL && strcmp (dest, DBUS_SERVICE_NAME) != 0)
@@ -1433,6 +1523,8 @@ route_message (Client *source_client, GDBusMessage *message)
 
   broadcast_message (daemon, message, dest_client != NULL, TRUE, dest_client);
 
+  g_rw_lock_reader_unlock (&daemon->lock);
+
   /* Swallow messages not for the bus */
   if (dest == NULL || strcmp (dest, DBUS_SERVICE_NAME) != 0)
     {
@@ -1443,6 +1535,36 @@ route_message (Client *source_client, GDBusMessage *message)
   return message;
 }
 
+typedef struct {
+  Client *client;
+  GDBusMessage *message;
+} RouteData;
+
+static void
+route_data_free (RouteData *data)
+{
+  if (data->message != NULL)
+    g_object_unref (data->message);
+  client_unref (data->client);
+  g_slice_free (RouteData, data);
+}
+
+/* Called in a routing thread */
+static gboolean
+route_message_in_thread_cb (gpointer user_data)
+{
+  RouteData *data = user_data;
+  GDBusMessage *message;
+
+  message = route_message (data->client, data->message);
+  data->message = NULL;
+
+  /* Only messages for the bus come back, and those aren't sent here */
+  g_assert (message == NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
 static GDBusMessage *
 copy_if_locked (GDBusMessage *message)
 {
@@ -1488,6 +1610,26 @@ filter_function (GDBusConnection *connection,
 	}
       g_dbus_message_set_sender (message, client->id);
 
+      /* Messages for the bus itself are handled in the main context,
+       * everything else is routed in the client's routing thread, if
+       * it has one.
+       */
+      if (client->routing_context != NULL &&
+	  g_strcmp0 (g_dbus_message_get_destination (message), DBUS_SERVICE_NAME) != 0)
+	{
+	  RouteData *data;
+
+	  data = g_slice_new (RouteData);
+	  data->client = client_ref (client);
+	  data->message = message;
+	  g_main_context_invoke_full (client->routing_context,
+				      G_PRIORITY_DEFAULT,
+				      route_message_in_thread_cb,
+				      data,
+				      (GDestroyNotify) route_data_free);
+	  return NULL;
+	}
+
       return route_message (client, message);
     }
   else
@@ -1552,20 +1694,34 @@ g_dbus_daemon_finalize (GObject *object)
 {
   GDBusDaemon *daemon = G_DBUS_DAEMON (object);
   GList *clients, *l;
+  guint i;
 
   if (daemon->timeout)
     g_source_remove (daemon->timeout);
 
   clients = g_hash_table_get_values (daemon->clients);
   for (l = clients; l != NULL; l = l->next)
-    client_free (l->data);
+    client_remove (l->data);
   g_list_free (clients);
 
+  /* Messages that are still waiting to be routed are dropped */
+  for (i = 0; i < daemon->n_routing_threads; i++)
+    {
+      RoutingThread *thread = &daemon->routing_threads[i];
+
+      g_main_loop_quit (thread->loop);
+      g_thread_join (thread->thread);
+      g_main_loop_unref (thread->loop);
+      g_main_context_unref (thread->context);
+    }
+  g_free (daemon->routing_threads);
+
   g_assert (g_hash_table_size (daemon->clients) == 0);
   g_assert (g_hash_table_size (daemon->names) == 0);
 
   g_hash_table_destroy (daemon->clients);
   g_hash_table_destroy (daemon->names);
+  g_rw_lock_clear (&daemon->lock);
 
   g_object_unref (daemon->server);
 
@@ -1585,11 +1741,24 @@ static void
 g_dbus_daemon_init (GDBusDaemon *daemon)
 {
   daemon->next_major_id = 1;
+  g_rw_lock_init (&daemon->lock);
   daemon->clients = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
   daemon->names = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
   daemon->guid = g_dbus_generate_guid ();
 }
 
+static gpointer
+routing_thread_func (gpointer user_data)
+{
+  RoutingThread *thread = user_data;
+
+  g_main_context_push_thread_default (thread->context);
+  g_main_loop_run (thread->loop);
+  g_main_context_pop_thread_default (thread->context);
+
+  return NULL;
+}
+
 static gboolean
 initable_init (GInitable     *initable,
 	       GCancellable  *cancellable,
@@ -1598,6 +1767,7 @@ initable_init (GInitable     *initable,
   GDBusDaemon *daemon = G_DBUS_DAEMON (initable);
   GDBusAuthObserver *observer;
   GDBusServerFlags flags;
+  guint i;
 
   flags = G_DBUS_SERVER_FLAGS_NONE;
   if (daemon->address == NULL)
@@ -1630,6 +1800,18 @@ initable_init (GInitable     *initable,
     }
 
 
+  daemon->routing_threads = g_new0 (RoutingThread, daemon->n_routing_threads);
+  for (i = 0; i < daemon->n_routing_threads; i++)
+    {
+      RoutingThread *thread = &daemon->routing_threads[i];
+
+      thread->context = g_main_context_new ();
+      thread->loop = g_main_loop_new (thread->context, FALSE);
+      thread->thread = g_thread_new ("gdbus-daemon-routing",
+				     routing_thread_func,
+				     thread);
+    }
+
   g_dbus_server_start (daemon->server);
 
   g_signal_connect (daemon->server, "new-connection",
@@ -1660,6 +1842,10 @@ g_dbus_daemon_set_property (GObject      *object,
       daemon->address = g_value_dup_string (value);
       break;
 
+    case PROP_ROUTING_THREADS:
+      daemon->n_routing_threads = g_value_get_uint (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -1679,6 +1865,10 @@ g_dbus_daemon_get_property (GObject    *object,
 	g_value_set_string (value, daemon->address);
 	break;
 
+      case PROP_ROUTING_THREADS:
+	g_value_set_uint (value, daemon->n_routing_threads);
+	break;
+
     default:
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -1712,6 +1902,20 @@ g_dbus_daemon_class_init (GDBusDaemonClass *klass)
 							G_PARAM_READWRITE |
 							G_PARAM_CONSTRUCT_ONLY |
 							G_PARAM_STATIC_STRINGS));
+
+  /* The number of threads to shard the clients over for routing
+   * messages between them; with 0, messages are routed in the GDBus
+   * worker thread.
+   */
+  g_object_class_install_property (gobject_class,
+				   PROP_ROUTING_THREADS,
+				   g_param_spec_uint ("routing-threads",
+						      "Routing Threads",
+						      "The number of threads routing messages",
+						      0, G_MAXUINT, 0,
+						      G_PARAM_READWRITE |
+						      G_PARAM_CONSTRUCT_ONLY |
+						      G_PARAM_STATIC_STRINGS));
 }
 
 static void
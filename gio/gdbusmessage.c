@@ -1426,6 +1426,109 @@ read_string (GMemoryBuffer          *mbuf,
   return str;
 }
 
+/* Once the length prefix is stripped, arrays of fixed-size numeric types
+ * are laid out the same way in the D-Bus wire format and in GVariant, so
+ * they can be converted with a single copy instead of going through the
+ * elements one by one.  Booleans are 4 bytes on the wire but 1 in
+ * GVariant, so they don't qualify.
+ *
+ * Returns the element size for arrays of @type that qualify, or 0.
+ */
+static gsize
+fixed_array_element_size (const GVariantType *type)
+{
+  switch (g_variant_type_peek_string (type)[1])
+    {
+    case 'y':
+      return 1;
+    case 'n':
+    case 'q':
+      return 2;
+    case 'i':
+    case 'u':
+    case 'h':
+      return 4;
+    case 'x':
+    case 't':
+    case 'd':
+      return 8;
+    default:
+      return 0;
+    }
+}
+
+/* Converts fixed-size array elements between host order and
+ * @byte_order in place
+ */
+static void
+fixed_array_byteswap (gchar                *data,
+                      gsize                 len,
+                      gsize                 element_size,
+                      GDataStreamByteOrder  byte_order)
+{
+  gsize n;
+
+  if (element_size == 1 || byte_order == G_DATA_STREAM_BYTE_ORDER_HOST_ENDIAN)
+    return;
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  if (byte_order == G_DATA_STREAM_BYTE_ORDER_LITTLE_ENDIAN)
+    return;
+#else
+  if (byte_order == G_DATA_STREAM_BYTE_ORDER_BIG_ENDIAN)
+    return;
+#endif
+
+  for (n = 0; n < len; n += element_size)
+    {
+      gpointer p = data + n;
+
+      switch (element_size)
+        {
+        case 2:
+          *(guint16 *) p = GUINT16_SWAP_LE_BE (*(guint16 *) p);
+          break;
+        case 4:
+          *(guint32 *) p = GUINT32_SWAP_LE_BE (*(guint32 *) p);
+          break;
+        case 8:
+          *(guint64 *) p = GUINT64_SWAP_LE_BE (*(guint64 *) p);
+          break;
+        }
+    }
+}
+
+/* Returns a floating GVariant, or %NULL if the slow path should be used */
+static GVariant *
+parse_fixed_array_from_blob (GMemoryBuffer      *buf,
+                             const GVariantType *type,
+                             guint32             array_len)
+{
+  GVariant *ret;
+  GBytes *bytes;
+  gchar *data;
+  gsize element_size;
+
+  element_size = fixed_array_element_size (type);
+  if (element_size == 0 || array_len % element_size != 0)
+    return NULL;
+
+  /* The elements start at their own alignment after the length */
+  ensure_input_padding (buf, element_size, NULL);
+  if (buf->pos > buf->valid_len || array_len > buf->valid_len - buf->pos)
+    return NULL;
+
+  data = g_memdup (buf->data + buf->pos, array_len);
+  buf->pos += array_len;
+  fixed_array_byteswap (data, array_len, element_size, buf->byte_order);
+
+  bytes = g_bytes_new_take (data, array_len);
+  ret = g_variant_new_from_bytes (type, bytes, TRUE);
+  g_bytes_unref (bytes);
+
+  return ret;
+}
+
 /* if just_align==TRUE, don't read a value, just align the input stream wrt padding */
 
 /* returns a non-floating GVariant! */
@@ -1702,6 +1805,13 @@ parse_value_from_blob (GMemoryBuffer          *buf,
               goto fail;
             }
 
+          if (array_len > 0)
+            {
+              ret = parse_fixed_array_from_blob (buf, type, array_len);
+              if (ret != NULL)
+                break;
+            }
+
           g_variant_builder_init (&builder, type);
           element_type = g_variant_type_element (type);
 
@@ -1717,7 +1827,6 @@ parse_value_from_blob (GMemoryBuffer          *buf,
             }
           else
             {
-              /* TODO: optimize array of primitive types */
               offset = buf->pos;
               target = offset + array_len;
               while (offset < target)
@@ -2222,6 +2331,31 @@ ensure_output_padding (GMemoryBuffer  *mbuf,
   return padding_needed;
 }
 
+/* Writes the payload of a fixed-size array, that is everything after the
+ * length, and returns the length to put in front of it.
+ */
+static gsize
+append_fixed_array_to_blob (GVariant      *value,
+                            gsize          element_size,
+                            GMemoryBuffer *mbuf)
+{
+  gconstpointer elements;
+  gsize n_elements;
+  gsize array_len;
+  gsize start;
+
+  ensure_output_padding (mbuf, element_size);
+
+  elements = g_variant_get_fixed_array (value, &n_elements, element_size);
+  array_len = n_elements * element_size;
+
+  start = mbuf->pos;
+  g_memory_buffer_write (mbuf, elements, array_len);
+  fixed_array_byteswap (mbuf->data + start, array_len, element_size, mbuf->byte_order);
+
+  return array_len;
+}
+
 /* note that value can be NULL for e.g. empty arrays - type is never NULL */
 static gboolean
 append_value_to_blob (GVariant             *value,
@@ -2381,9 +2515,24 @@ append_value_to_blob (GVariant             *value,
         goffset array_payload_begin_offset;
         goffset cur_offset;
         gsize array_len;
+        gsize element_size;
 
         padding_added = ensure_output_padding (mbuf, 4);
-        if (value != NULL)
+        element_size = fixed_array_element_size (type);
+        if (value != NULL && element_size > 0)
+          {
+            /* Byte-for-byte the same as in GVariant, no need to go
+             * through the elements one at a time
+             */
+            array_len_offset = mbuf->valid_len;
+            g_memory_buffer_put_uint32 (mbuf, 0xF00DFACE);
+            array_len = append_fixed_array_to_blob (value, element_size, mbuf);
+            cur_offset = mbuf->valid_len;
+            mbuf->pos = array_len_offset;
+            g_memory_buffer_put_uint32 (mbuf, array_len);
+            mbuf->pos = cur_offset;
+          }
+        else if (value != NULL)
           {
             /* array length - will be filled in later */
             array_len_offset = mbuf->valid_len;
@@ -2606,6 +2755,13 @@ g_dbus_message_to_blob (GDBusMessage          *message,
 
   memset (&mbuf, 0, sizeof (mbuf));
   mbuf.len = MIN_ARRAY_SIZE;
+  /* Start out big enough that large bodies don't mean repeatedly growing
+   * (and copying) the buffer.  The wire form of a body is usually close
+   * to its GVariant form, plus length prefixes and padding, and the
+   * header fields take a few hundred bytes at most.
+   */
+  if (message->body != NULL)
+    mbuf.len += 256 + g_variant_get_size (message->body) + g_variant_get_size (message->body) / 8;
   mbuf.data = g_malloc (mbuf.len);
 
   mbuf.byte_order = G_DATA_STREAM_BYTE_ORDER_HOST_ENDIAN;
@@ -399,23 +399,21 @@ g_dbus_method_invocation_return_value_internal (GDBusMethodInvocation *invocatio
     parameters = g_variant_new_tuple (NULL, 0);
 
   /* if we have introspection data, check that the signature of @parameters is correct */
-  if (invocation->method_info != NULL)
+  if (invocation->method_info != NULL &&
+      !_g_dbus_args_match_type_string (invocation->method_info->out_args,
+                                       g_variant_get_type_string (parameters)))
     {
       GVariantType *type;
+      gchar *type_string;
 
       type = _g_dbus_compute_complete_signature (invocation->method_info->out_args);
+      type_string = g_variant_type_dup_string (type);
 
-      if (!g_variant_is_of_type (parameters, type))
-        {
-          gchar *type_string = g_variant_type_dup_string (type);
-
-          g_warning ("Type of return value is incorrect: expected '%s', got '%s''",
-		     type_string, g_variant_get_type_string (parameters));
-          g_variant_type_free (type);
-          g_free (type_string);
-          goto out;
-        }
+      g_warning ("Type of return value is incorrect: expected '%s', got '%s''",
+                 type_string, g_variant_get_type_string (parameters));
       g_variant_type_free (type);
+      g_free (type_string);
+      goto out;
     }
 
   /* property_info is only non-NULL if set that way from
@@ -52,6 +52,12 @@
  * intended to be used with #GDBusObjectManagerServer or any D-Bus
  * object implementing the org.freedesktop.DBus.ObjectManager
  * interface.
+ *
+ * When exporting or unexporting many objects at once, wrap the calls in
+ * g_dbus_object_manager_server_begin_batch() and
+ * g_dbus_object_manager_server_end_batch(). The InterfacesAdded and
+ * InterfacesRemoved signals are then emitted once per object when the
+ * batch ends, with changes that cancel out dropped altogether.
  */
 
 typedef struct
@@ -76,9 +82,31 @@ static void g_dbus_object_manager_server_emit_interfaces_removed (GDBusObjectMan
                                                            RegistrationData   *data,
                                                            const gchar *const *interfaces);
 
+static void emit_interfaces_added (GDBusObjectManagerServer *manager,
+                                   RegistrationData         *data,
+                                   const gchar *const       *interfaces,
+                                   const gchar              *object_path);
+
+static void emit_interfaces_removed (GDBusObjectManagerServer *manager,
+                                     const gchar *const       *interfaces,
+                                     const gchar              *object_path);
+
 static gboolean g_dbus_object_manager_server_unexport_unlocked (GDBusObjectManagerServer  *manager,
                                                                 const gchar               *object_path);
 
+static void flush_batch (GDBusObjectManagerServer *manager);
+
+/* Changes to one object while a batch is in progress */
+typedef struct
+{
+  gchar *object_path;
+  /* interface names (gchar*) to emit InterfacesRemoved() / InterfacesAdded() for */
+  GPtrArray *removed;
+  GPtrArray *added;
+} BatchedChanges;
+
+static void batched_changes_free (BatchedChanges *changes);
+
 struct _GDBusObjectManagerServerPrivate
 {
   GMutex lock;
@@ -87,6 +115,12 @@ struct _GDBusObjectManagerServerPrivate
   gchar *object_path_ending_in_slash;
   GHashTable *map_object_path_to_data;
   guint manager_reg_id;
+
+  /* see g_dbus_object_manager_server_begin_batch() */
+  guint batch_depth;
+  /* object path -> BatchedChanges*, and the same in the order first changed */
+  GHashTable *map_object_path_to_changes;
+  GPtrArray *batched_changes;
 };
 
 enum
@@ -115,6 +149,8 @@ g_dbus_object_manager_server_finalize (GObject *object)
       g_object_unref (manager->priv->connection);
     }
   g_hash_table_unref (manager->priv->map_object_path_to_data);
+  g_hash_table_unref (manager->priv->map_object_path_to_changes);
+  g_ptr_array_unref (manager->priv->batched_changes);
   g_free (manager->priv->object_path);
   g_free (manager->priv->object_path_ending_in_slash);
 
@@ -232,6 +268,8 @@ g_dbus_object_manager_server_init (GDBusObjectManagerServer *manager)
                                                                   g_str_equal,
                                                                   g_free,
                                                                   (GDestroyNotify) registration_data_free);
+  manager->priv->map_object_path_to_changes = g_hash_table_new (g_str_hash, g_str_equal);
+  manager->priv->batched_changes = g_ptr_array_new_with_free_func ((GDestroyNotify) batched_changes_free);
 }
 
 /**
@@ -284,6 +322,8 @@ g_dbus_object_manager_server_set_connection (GDBusObjectManagerServer  *manager,
 
   if (manager->priv->connection != NULL)
     {
+      /* changes made so far in a batch are for the old connection */
+      flush_batch (manager);
       unexport_all (manager, FALSE);
       g_object_unref (manager->priv->connection);
       manager->priv->connection = NULL;
@@ -695,6 +735,185 @@ g_dbus_object_manager_server_unexport (GDBusObjectManagerServer  *manager,
 }
 
 
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+batched_changes_free (BatchedChanges *changes)
+{
+  g_free (changes->object_path);
+  g_ptr_array_unref (changes->removed);
+  g_ptr_array_unref (changes->added);
+  g_slice_free (BatchedChanges, changes);
+}
+
+static BatchedChanges *
+lookup_batched_changes (GDBusObjectManagerServer *manager,
+                        const gchar              *object_path)
+{
+  BatchedChanges *changes;
+
+  changes = g_hash_table_lookup (manager->priv->map_object_path_to_changes, object_path);
+  if (changes == NULL)
+    {
+      changes = g_slice_new (BatchedChanges);
+      changes->object_path = g_strdup (object_path);
+      changes->removed = g_ptr_array_new_with_free_func (g_free);
+      changes->added = g_ptr_array_new_with_free_func (g_free);
+      g_hash_table_insert (manager->priv->map_object_path_to_changes, changes->object_path, changes);
+      g_ptr_array_add (manager->priv->batched_changes, changes);
+    }
+  return changes;
+}
+
+static gboolean
+remove_interface_name (GPtrArray   *names,
+                       const gchar *name)
+{
+  guint n;
+
+  for (n = 0; n < names->len; n++)
+    {
+      if (g_strcmp0 (names->pdata[n], name) == 0)
+        {
+          g_ptr_array_remove_index (names, n);
+          return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+static void
+batch_interfaces_added (GDBusObjectManagerServer *manager,
+                        const gchar *const       *interfaces,
+                        const gchar              *object_path)
+{
+  BatchedChanges *changes;
+  guint n;
+
+  changes = lookup_batched_changes (manager, object_path);
+  for (n = 0; interfaces[n] != NULL; n++)
+    {
+      /* An interface that was removed earlier in the batch stays in
+       * changes->removed; the new one may have other properties
+       */
+      g_ptr_array_add (changes->added, g_strdup (interfaces[n]));
+    }
+}
+
+static void
+batch_interfaces_removed (GDBusObjectManagerServer *manager,
+                          const gchar *const       *interfaces,
+                          const gchar              *object_path)
+{
+  BatchedChanges *changes;
+  guint n;
+
+  changes = lookup_batched_changes (manager, object_path);
+  for (n = 0; interfaces[n] != NULL; n++)
+    {
+      /* Nobody has heard of an interface added earlier in the batch */
+      if (!remove_interface_name (changes->added, interfaces[n]))
+        g_ptr_array_add (changes->removed, g_strdup (interfaces[n]));
+    }
+}
+
+/* emits the signals for the current batch, if any; must hold the lock */
+static void
+flush_batch (GDBusObjectManagerServer *manager)
+{
+  guint n;
+
+  for (n = 0; n < manager->priv->batched_changes->len; n++)
+    {
+      BatchedChanges *changes = manager->priv->batched_changes->pdata[n];
+
+      if (manager->priv->connection == NULL)
+        break;
+
+      if (changes->removed->len > 0)
+        {
+          g_ptr_array_add (changes->removed, NULL);
+          emit_interfaces_removed (manager,
+                                   (const gchar *const *) changes->removed->pdata,
+                                   changes->object_path);
+        }
+
+      if (changes->added->len > 0)
+        {
+          RegistrationData *data;
+
+          /* everything in changes->added is still exported here */
+          data = g_hash_table_lookup (manager->priv->map_object_path_to_data, changes->object_path);
+          g_assert (data != NULL);
+          g_ptr_array_add (changes->added, NULL);
+          emit_interfaces_added (manager, data,
+                                 (const gchar *const *) changes->added->pdata,
+                                 changes->object_path);
+        }
+    }
+
+  g_hash_table_remove_all (manager->priv->map_object_path_to_changes);
+  g_ptr_array_set_size (manager->priv->batched_changes, 0);
+}
+
+/**
+ * g_dbus_object_manager_server_begin_batch:
+ * @manager: A #GDBusObjectManagerServer.
+ *
+ * Starts a batch of changes to the objects exported by @manager.
+ *
+ * Until the matching call to g_dbus_object_manager_server_end_batch(),
+ * exporting and unexporting objects (and adding or removing interfaces
+ * on exported objects) does not emit any InterfacesAdded or
+ * InterfacesRemoved signals. Instead, @manager emits at most one of
+ * each per object when the batch ends. Interfaces that are added and
+ * removed again within the batch are not announced at all.
+ *
+ * Batches can be nested; the signals are emitted when the outermost
+ * batch ends. Method calls to GetManagedObjects() made during a batch
+ * already see its changes.
+ *
+ * Since: 2.40
+ */
+void
+g_dbus_object_manager_server_begin_batch (GDBusObjectManagerServer *manager)
+{
+  g_return_if_fail (G_IS_DBUS_OBJECT_MANAGER_SERVER (manager));
+
+  g_mutex_lock (&manager->priv->lock);
+  manager->priv->batch_depth++;
+  g_mutex_unlock (&manager->priv->lock);
+}
+
+/**
+ * g_dbus_object_manager_server_end_batch:
+ * @manager: A #GDBusObjectManagerServer.
+ *
+ * Ends a batch started with g_dbus_object_manager_server_begin_batch().
+ * If this ends the outermost batch, the InterfacesAdded and
+ * InterfacesRemoved signals for all the changes made during the batch
+ * are emitted, in the order the objects were first changed.
+ *
+ * Since: 2.40
+ */
+void
+g_dbus_object_manager_server_end_batch (GDBusObjectManagerServer *manager)
+{
+  g_return_if_fail (G_IS_DBUS_OBJECT_MANAGER_SERVER (manager));
+
+  g_mutex_lock (&manager->priv->lock);
+  if (manager->priv->batch_depth == 0)
+    {
+      g_mutex_unlock (&manager->priv->lock);
+      g_critical ("%s: no batch in progress", G_STRFUNC);
+      return;
+    }
+  manager->priv->batch_depth--;
+  if (manager->priv->batch_depth == 0)
+    flush_batch (manager);
+  g_mutex_unlock (&manager->priv->lock);
+}
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 static const GDBusArgInfo manager_interfaces_added_signal_info_arg0 =
@@ -895,18 +1114,15 @@ g_dbus_object_manager_server_constructed (GObject *object)
 }
 
 static void
-g_dbus_object_manager_server_emit_interfaces_added (GDBusObjectManagerServer *manager,
-                                                    RegistrationData   *data,
-                                                    const gchar *const *interfaces,
-                                                    const gchar *object_path)
+emit_interfaces_added (GDBusObjectManagerServer *manager,
+                       RegistrationData         *data,
+                       const gchar *const       *interfaces,
+                       const gchar              *object_path)
 {
   GVariantBuilder array_builder;
   GError *error;
   guint n;
 
-  if (data->manager->priv->connection == NULL)
-    goto out;
-
   g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a{sa{sv}}"));
   for (n = 0; interfaces[n] != NULL; n++)
     {
@@ -921,7 +1137,7 @@ g_dbus_object_manager_server_emit_interfaces_added (GDBusObjectManagerServer *ma
     }
 
   error = NULL;
-  g_dbus_connection_emit_signal (data->manager->priv->connection,
+  g_dbus_connection_emit_signal (manager->priv->connection,
                                  NULL, /* destination_bus_name */
                                  manager->priv->object_path,
                                  manager_interface_info.name,
@@ -931,30 +1147,23 @@ g_dbus_object_manager_server_emit_interfaces_added (GDBusObjectManagerServer *ma
                                                 &array_builder),
                                  &error);
   g_assert_no_error (error);
- out:
-  ;
 }
 
 static void
-g_dbus_object_manager_server_emit_interfaces_removed (GDBusObjectManagerServer *manager,
-                                                      RegistrationData   *data,
-                                                      const gchar *const *interfaces)
+emit_interfaces_removed (GDBusObjectManagerServer *manager,
+                         const gchar *const       *interfaces,
+                         const gchar              *object_path)
 {
   GVariantBuilder array_builder;
   GError *error;
   guint n;
-  const gchar *object_path;
-
-  if (data->manager->priv->connection == NULL)
-    goto out;
 
   g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("as"));
   for (n = 0; interfaces[n] != NULL; n++)
     g_variant_builder_add (&array_builder, "s", interfaces[n]);
 
   error = NULL;
-  object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (data->object));
-  g_dbus_connection_emit_signal (data->manager->priv->connection,
+  g_dbus_connection_emit_signal (manager->priv->connection,
                                  NULL, /* destination_bus_name */
                                  manager->priv->object_path,
                                  manager_interface_info.name,
@@ -964,6 +1173,40 @@ g_dbus_object_manager_server_emit_interfaces_removed (GDBusObjectManagerServer *
                                                 &array_builder),
                                  &error);
   g_assert_no_error (error);
+}
+
+static void
+g_dbus_object_manager_server_emit_interfaces_added (GDBusObjectManagerServer *manager,
+                                                    RegistrationData   *data,
+                                                    const gchar *const *interfaces,
+                                                    const gchar *object_path)
+{
+  if (data->manager->priv->connection == NULL)
+    goto out;
+
+  if (manager->priv->batch_depth > 0)
+    batch_interfaces_added (manager, interfaces, object_path);
+  else
+    emit_interfaces_added (manager, data, interfaces, object_path);
+ out:
+  ;
+}
+
+static void
+g_dbus_object_manager_server_emit_interfaces_removed (GDBusObjectManagerServer *manager,
+                                                      RegistrationData   *data,
+                                                      const gchar *const *interfaces)
+{
+  const gchar *object_path;
+
+  if (data->manager->priv->connection == NULL)
+    goto out;
+
+  object_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (data->object));
+  if (manager->priv->batch_depth > 0)
+    batch_interfaces_removed (manager, interfaces, object_path);
+  else
+    emit_interfaces_removed (manager, interfaces, object_path);
  out:
   ;
 }
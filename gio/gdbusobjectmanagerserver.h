@@ -89,6 +89,10 @@ gboolean                  g_dbus_object_manager_server_is_exported         (GDBu
 GLIB_AVAILABLE_IN_ALL
 gboolean                  g_dbus_object_manager_server_unexport            (GDBusObjectManagerServer  *manager,
                                                                             const gchar               *object_path);
+GLIB_AVAILABLE_IN_2_40
+void                      g_dbus_object_manager_server_begin_batch         (GDBusObjectManagerServer  *manager);
+GLIB_AVAILABLE_IN_2_40
+void                      g_dbus_object_manager_server_end_batch           (GDBusObjectManagerServer  *manager);
 
 G_END_DECLS
 
@@ -261,12 +261,17 @@ ensure_required_types (void)
 }
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* Also used for the threads of connections that have a dedicated one, in
+ * which case @loop is %NULL and the thread runs until @quit is set.
+ */
 typedef struct
 {
   volatile gint refcount;
   GThread *thread;
   GMainContext *context;
   GMainLoop *loop;
+  gboolean dedicated;
+  volatile gint quit;
 } SharedThreadData;
 
 static gpointer
@@ -315,9 +320,62 @@ _g_dbus_shared_thread_ref (void)
   return ret;
 }
 
+static gpointer
+gdbus_dedicated_thread_func (gpointer user_data)
+{
+  SharedThreadData *data = user_data;
+
+  g_main_context_push_thread_default (data->context);
+  while (!g_atomic_int_get (&data->quit))
+    g_main_context_iteration (data->context, TRUE);
+  g_main_context_pop_thread_default (data->context);
+
+  /* The last reference is usually dropped from this very thread, so
+   * it cleans up after itself rather than being joined.
+   */
+  g_main_context_unref (data->context);
+  g_free (data);
+
+  return NULL;
+}
+
+static SharedThreadData *
+_g_dbus_dedicated_thread_new (void)
+{
+  SharedThreadData *data;
+
+  data = g_new0 (SharedThreadData, 1);
+  data->refcount = 1;
+  data->dedicated = TRUE;
+  data->context = g_main_context_new ();
+  data->thread = g_thread_new ("gdbus-worker",
+                               gdbus_dedicated_thread_func,
+                               data);
+
+  return data;
+}
+
 static void
 _g_dbus_shared_thread_unref (SharedThreadData *data)
 {
+  if (data->dedicated)
+    {
+      if (g_atomic_int_dec_and_test (&data->refcount))
+        {
+          GMainContext *context;
+          GThread *thread;
+
+          /* data may be freed as soon as quit is set */
+          context = g_main_context_ref (data->context);
+          thread = data->thread;
+          g_atomic_int_set (&data->quit, TRUE);
+          g_main_context_wakeup (context);
+          g_main_context_unref (context);
+          g_thread_unref (thread);
+        }
+      return;
+    }
+
   /* TODO: actually destroy the shared thread here */
 #if 0
   g_assert (data != NULL);
@@ -389,6 +447,10 @@ struct GDBusWorker
   GQueue                             *write_queue;
   /* protected by write_lock */
   guint64                             write_num_messages_written;
+  /* number of messages taken off @write_queue for the write currently
+   * in progress; protected by write_lock
+   */
+  guint                               write_num_messages_in_flight;
   /* number of messages we'd written out last time we flushed;
    * protected by write_lock
    */
@@ -883,6 +945,12 @@ _g_dbus_worker_do_initial_read (gpointer data)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* Upper bounds for how much is handed to a single sendmsg() when several
+ * messages are waiting in the write queue.
+ */
+#define MAX_COALESCED_MESSAGES 64
+#define MAX_COALESCED_BYTES    (128 * 1024)
+
 struct _MessageToWriteData
 {
   GDBusWorker  *worker;
@@ -893,6 +961,12 @@ struct _MessageToWriteData
   gsize               total_written;
   GSimpleAsyncResult *simple;
 
+  /* messages written out together with this one, only set on the first
+   * message of a batch; see continue_writing()
+   */
+  GPtrArray          *coalesced;
+  /* index of the message in the batch currently being written */
+  guint               current;
 };
 
 static void
@@ -901,10 +975,38 @@ message_to_write_data_free (MessageToWriteData *data)
   _g_dbus_worker_unref (data->worker);
   if (data->message)
     g_object_unref (data->message);
+  if (data->coalesced != NULL)
+    g_ptr_array_unref (data->coalesced);
   g_free (data->blob);
   g_free (data);
 }
 
+static guint
+message_to_write_data_get_count (MessageToWriteData *data)
+{
+  return 1 + (data->coalesced != NULL ? data->coalesced->len : 0);
+}
+
+static MessageToWriteData *
+message_to_write_data_get_nth (MessageToWriteData *data,
+                               guint               n)
+{
+  if (n == 0)
+    return data;
+  return g_ptr_array_index (data->coalesced, n - 1);
+}
+
+#ifdef G_OS_UNIX
+static gboolean
+message_to_write_data_has_fds (MessageToWriteData *data)
+{
+  GUnixFDList *fd_list;
+
+  fd_list = g_dbus_message_get_unix_fd_list (data->message);
+  return fd_list != NULL && g_unix_fd_list_get_length (fd_list) > 0;
+}
+#endif
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 static void write_message_continue_writing (MessageToWriteData *data);
@@ -987,6 +1089,7 @@ write_message_continue_writing (MessageToWriteData *data)
   GOutputStream *ostream;
 #ifdef G_OS_UNIX
   GSimpleAsyncResult *simple;
+  MessageToWriteData *current;
   GUnixFDList *fd_list;
 #endif
 
@@ -999,28 +1102,52 @@ write_message_continue_writing (MessageToWriteData *data)
 
   ostream = g_io_stream_get_output_stream (data->worker->stream);
 #ifdef G_OS_UNIX
-  fd_list = g_dbus_message_get_unix_fd_list (data->message);
+  current = message_to_write_data_get_nth (data, data->current);
+  fd_list = g_dbus_message_get_unix_fd_list (current->message);
 #endif
 
   g_assert (!g_output_stream_has_pending (ostream));
-  g_assert_cmpint (data->total_written, <, data->blob_size);
 
   if (FALSE)
     {
     }
 #ifdef G_OS_UNIX
-  else if (G_IS_SOCKET_OUTPUT_STREAM (ostream) && data->total_written == 0)
+  else if (G_IS_SOCKET_OUTPUT_STREAM (ostream))
     {
-      GOutputVector vector;
+      GOutputVector vectors[MAX_COALESCED_MESSAGES];
+      guint num_vectors;
+      guint count;
+      guint n;
       GSocketControlMessage *control_message;
       gssize bytes_written;
+      gsize remaining;
       GError *error;
 
-      vector.buffer = data->blob;
-      vector.size = data->blob_size;
+      g_assert_cmpint (current->total_written, <, current->blob_size);
+
+      vectors[0].buffer = current->blob + current->total_written;
+      vectors[0].size = current->blob_size - current->total_written;
+      num_vectors = 1;
+
+      /* File descriptors have to go out with the first byte of the
+       * message they belong to, so a batch is only written up to the
+       * next message carrying any.
+       */
+      count = message_to_write_data_get_count (data);
+      for (n = data->current + 1; n < count; n++)
+        {
+          MessageToWriteData *next = message_to_write_data_get_nth (data, n);
+
+          if (message_to_write_data_has_fds (next))
+            break;
+
+          vectors[num_vectors].buffer = next->blob;
+          vectors[num_vectors].size = next->blob_size;
+          num_vectors++;
+        }
 
       control_message = NULL;
-      if (fd_list != NULL && g_unix_fd_list_get_length (fd_list) > 0)
+      if (current->total_written == 0 && fd_list != NULL && g_unix_fd_list_get_length (fd_list) > 0)
         {
           if (!(data->worker->capabilities & G_DBUS_CAPABILITY_FLAGS_UNIX_FD_PASSING))
             {
@@ -1038,8 +1165,8 @@ write_message_continue_writing (MessageToWriteData *data)
       error = NULL;
       bytes_written = g_socket_send_message (data->worker->socket,
                                              NULL, /* address */
-                                             &vector,
-                                             1,
+                                             vectors,
+                                             num_vectors,
                                              control_message != NULL ? &control_message : NULL,
                                              control_message != NULL ? 1 : 0,
                                              G_SOCKET_MSG_NONE,
@@ -1073,11 +1200,24 @@ write_message_continue_writing (MessageToWriteData *data)
         }
       g_assert (bytes_written > 0); /* zero is never returned */
 
-      write_message_print_transport_debug (bytes_written, data);
+      /* account the written bytes to the messages in the batch */
+      remaining = bytes_written;
+      while (remaining > 0)
+        {
+          gsize chunk;
+
+          current = message_to_write_data_get_nth (data, data->current);
+          chunk = MIN (remaining, current->blob_size - current->total_written);
+
+          write_message_print_transport_debug (chunk, current);
 
-      data->total_written += bytes_written;
-      g_assert (data->total_written <= data->blob_size);
-      if (data->total_written == data->blob_size)
+          current->total_written += chunk;
+          remaining -= chunk;
+          if (current->total_written == current->blob_size)
+            data->current++;
+        }
+
+      if (data->current == count)
         {
           g_simple_async_result_complete (simple);
           g_object_unref (simple);
@@ -1089,6 +1229,9 @@ write_message_continue_writing (MessageToWriteData *data)
 #endif
   else
     {
+      g_assert (data->coalesced == NULL);
+      g_assert_cmpint (data->total_written, <, data->blob_size);
+
 #ifdef G_OS_UNIX
       if (fd_list != NULL)
         {
@@ -1128,11 +1271,15 @@ write_message_async (GDBusWorker         *worker,
                      GAsyncReadyCallback  callback,
                      gpointer             user_data)
 {
+  guint n;
+
   data->simple = g_simple_async_result_new (NULL,
                                             callback,
                                             user_data,
                                             write_message_async);
-  data->total_written = 0;
+  for (n = 0; n < message_to_write_data_get_count (data); n++)
+    message_to_write_data_get_nth (data, n)->total_written = 0;
+  data->current = 0;
   write_message_continue_writing (data);
 }
 
@@ -1332,10 +1479,12 @@ write_message_cb (GObject       *source_object,
 {
   MessageToWriteData *data = user_data;
   GError *error;
+  guint n;
 
   g_mutex_lock (&data->worker->write_lock);
   g_assert (data->worker->output_pending == PENDING_WRITE);
   data->worker->output_pending = PENDING_NONE;
+  data->worker->write_num_messages_in_flight = 0;
 
   error = NULL;
   if (!write_message_finish (res, &error))
@@ -1349,7 +1498,8 @@ write_message_cb (GObject       *source_object,
       g_mutex_lock (&data->worker->write_lock);
     }
 
-  message_written_unlocked (data->worker, data);
+  for (n = 0; n < message_to_write_data_get_count (data); n++)
+    message_written_unlocked (data->worker, message_to_write_data_get_nth (data, n));
 
   g_mutex_unlock (&data->worker->write_lock);
 
@@ -1426,6 +1576,139 @@ iostream_close_cb (GObject      *source_object,
   _g_dbus_worker_unref (worker);
 }
 
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ *
+ * Runs the filters on a message taken off the write queue, re-encoding
+ * it if they changed it.  Returns %FALSE if the filters dropped it.
+ */
+static gboolean
+filter_message_to_write (GDBusWorker        *worker,
+                         MessageToWriteData *data)
+{
+  GDBusMessage *old_message;
+  guchar *new_blob;
+  gsize new_blob_size;
+  GError *error;
+
+  old_message = data->message;
+  data->message = _g_dbus_worker_emit_message_about_to_be_sent (worker, data->message);
+  if (data->message == old_message)
+    {
+      /* filters had no effect - do nothing */
+    }
+  else if (data->message == NULL)
+    {
+      /* filters dropped message */
+      return FALSE;
+    }
+  else
+    {
+      /* filters altered the message -> reencode */
+      error = NULL;
+      new_blob = g_dbus_message_to_blob (data->message,
+                                         &new_blob_size,
+                                         worker->capabilities,
+                                         &error);
+      if (new_blob == NULL)
+        {
+          /* if filter make the GDBusMessage unencodeable, just complain on stderr and send
+           * the old message instead
+           */
+          g_warning ("Error encoding GDBusMessage with serial %d altered by filter function: %s",
+                     g_dbus_message_get_serial (data->message),
+                     error->message);
+          g_error_free (error);
+        }
+      else
+        {
+          g_free (data->blob);
+          data->blob = (gchar *) new_blob;
+          data->blob_size = new_blob_size;
+        }
+    }
+
+  return TRUE;
+}
+
+#ifdef G_OS_UNIX
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is held on entry
+ *
+ * Returns: %TRUE if a flush has to happen once @num_messages more
+ * messages have been written
+ */
+static gboolean
+flush_pending_after_unlocked (GDBusWorker *worker,
+                              guint        num_messages)
+{
+  GList *l;
+
+  for (l = worker->write_pending_flushes; l != NULL; l = l->next)
+    {
+      FlushData *f = l->data;
+
+      if (f->number_to_wait_for == worker->write_num_messages_written + num_messages)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* called in private thread shared by all GDBusConnection instances
+ *
+ * write-lock is not held on entry
+ * output_pending is PENDING_WRITE on entry
+ *
+ * Takes whatever else is already waiting in the write queue and attaches
+ * it to @data, so that a burst of messages (a signal storm, say) goes out
+ * in a single sendmsg() instead of one per message.  Messages are only
+ * taken up to the next pending flush or close, so those still happen in
+ * order.
+ */
+static void
+coalesce_messages_to_write (GDBusWorker        *worker,
+                            MessageToWriteData *data)
+{
+  gsize total_size;
+
+  total_size = data->blob_size;
+  while (message_to_write_data_get_count (data) < MAX_COALESCED_MESSAGES &&
+         total_size < MAX_COALESCED_BYTES)
+    {
+      MessageToWriteData *next;
+
+      g_mutex_lock (&worker->write_lock);
+      next = NULL;
+      if (worker->pending_close_attempts == NULL &&
+          !flush_pending_after_unlocked (worker, message_to_write_data_get_count (data)))
+        next = g_queue_pop_head (worker->write_queue);
+      if (next != NULL)
+        worker->write_num_messages_in_flight += 1;
+      g_mutex_unlock (&worker->write_lock);
+
+      if (next == NULL)
+        break;
+
+      if (!filter_message_to_write (worker, next))
+        {
+          g_mutex_lock (&worker->write_lock);
+          worker->write_num_messages_in_flight -= 1;
+          g_mutex_unlock (&worker->write_lock);
+          message_to_write_data_free (next);
+          continue;
+        }
+
+      if (data->coalesced == NULL)
+        data->coalesced = g_ptr_array_new_with_free_func ((GDestroyNotify) message_to_write_data_free);
+      g_ptr_array_add (data->coalesced, next);
+      total_size += next->blob_size;
+    }
+}
+#endif
+
 /* called in private thread shared by all GDBusConnection instances
  *
  * write-lock is not held on entry
@@ -1465,7 +1748,10 @@ continue_writing (GDBusWorker *worker)
           data = g_queue_pop_head (worker->write_queue);
 
           if (data != NULL)
-            worker->output_pending = PENDING_WRITE;
+            {
+              worker->output_pending = PENDING_WRITE;
+              worker->write_num_messages_in_flight = 1;
+            }
         }
     }
 
@@ -1487,51 +1773,20 @@ continue_writing (GDBusWorker *worker)
     }
   else if (data != NULL)
     {
-      GDBusMessage *old_message;
-      guchar *new_blob;
-      gsize new_blob_size;
-      GError *error;
-
-      old_message = data->message;
-      data->message = _g_dbus_worker_emit_message_about_to_be_sent (worker, data->message);
-      if (data->message == old_message)
+      if (!filter_message_to_write (worker, data))
         {
-          /* filters had no effect - do nothing */
-        }
-      else if (data->message == NULL)
-        {
-          /* filters dropped message */
           g_mutex_lock (&worker->write_lock);
           worker->output_pending = PENDING_NONE;
+          worker->write_num_messages_in_flight = 0;
           g_mutex_unlock (&worker->write_lock);
           message_to_write_data_free (data);
           goto write_next;
         }
-      else
-        {
-          /* filters altered the message -> reencode */
-          error = NULL;
-          new_blob = g_dbus_message_to_blob (data->message,
-                                             &new_blob_size,
-                                             worker->capabilities,
-                                             &error);
-          if (new_blob == NULL)
-            {
-              /* if filter make the GDBusMessage unencodeable, just complain on stderr and send
-               * the old message instead
-               */
-              g_warning ("Error encoding GDBusMessage with serial %d altered by filter function: %s",
-                         g_dbus_message_get_serial (data->message),
-                         error->message);
-              g_error_free (error);
-            }
-          else
-            {
-              g_free (data->blob);
-              data->blob = (gchar *) new_blob;
-              data->blob_size = new_blob_size;
-            }
-        }
+
+#ifdef G_OS_UNIX
+      if (G_IS_SOCKET_OUTPUT_STREAM (g_io_stream_get_output_stream (worker->stream)))
+        coalesce_messages_to_write (worker, data);
+#endif
 
       write_message_async (worker,
                            data,
@@ -1642,6 +1897,7 @@ GDBusWorker *
 _g_dbus_worker_new (GIOStream                              *stream,
                     GDBusCapabilityFlags                    capabilities,
                     gboolean                                initially_frozen,
+                    gboolean                                dedicated_thread,
                     GDBusWorkerMessageReceivedCallback      message_received_callback,
                     GDBusWorkerMessageAboutToBeSentCallback message_about_to_be_sent_callback,
                     GDBusWorkerDisconnectedCallback         disconnected_callback,
@@ -1677,7 +1933,10 @@ _g_dbus_worker_new (GIOStream                              *stream,
   if (G_IS_SOCKET_CONNECTION (worker->stream))
     worker->socket = g_socket_connection_get_socket (G_SOCKET_CONNECTION (worker->stream));
 
-  worker->shared_thread_data = _g_dbus_shared_thread_ref ();
+  if (dedicated_thread)
+    worker->shared_thread_data = _g_dbus_dedicated_thread_new ();
+  else
+    worker->shared_thread_data = _g_dbus_shared_thread_ref ();
 
   /* begin reading */
   idle_source = g_idle_source_new ();
@@ -1777,7 +2036,7 @@ _g_dbus_worker_flush_sync (GDBusWorker    *worker,
    * flush operation that follows it
    */
   if (worker->output_pending == PENDING_WRITE)
-    pending_writes += 1;
+    pending_writes += worker->write_num_messages_in_flight;
 
   if (pending_writes > 0 ||
       worker->write_num_messages_written != worker->write_num_messages_flushed)
@@ -1983,6 +2242,34 @@ _g_dbus_compute_complete_signature (GDBusArgInfo **args)
   return g_variant_type_new_tuple (arg_types, n);
 }
 
+/* Checks whether @type_string is the tuple type made of the signatures
+ * of @args, without building a #GVariantType for it the way
+ * _g_dbus_compute_complete_signature() does.
+ */
+gboolean
+_g_dbus_args_match_type_string (GDBusArgInfo **args,
+                                const gchar   *type_string)
+{
+  const gchar *p;
+  guint n;
+
+  p = type_string;
+  if (*p++ != '(')
+    return FALSE;
+
+  for (n = 0; args != NULL && args[n] != NULL; n++)
+    {
+      gsize len;
+
+      len = strlen (args[n]->signature);
+      if (strncmp (p, args[n]->signature, len) != 0)
+        return FALSE;
+      p += len;
+    }
+
+  return p[0] == ')' && p[1] == '\0';
+}
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 #ifdef G_OS_WIN32
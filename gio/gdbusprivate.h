@@ -49,11 +49,12 @@ typedef void (*GDBusWorkerDisconnectedCallback)    (GDBusWorker   *worker,
                                                     gpointer       user_data);
 
 /* This function may be called from any thread - callbacks will be in the shared private message thread
- * and must not block.
+ * (or the worker's own thread if @dedicated_thread is %TRUE) and must not block.
  */
 GDBusWorker *_g_dbus_worker_new          (GIOStream                          *stream,
                                           GDBusCapabilityFlags                capabilities,
                                           gboolean                            initially_frozen,
+                                          gboolean                            dedicated_thread,
                                           GDBusWorkerMessageReceivedCallback  message_received_callback,
                                           GDBusWorkerMessageAboutToBeSentCallback message_about_to_be_sent_callback,
                                           GDBusWorkerDisconnectedCallback     disconnected_callback,
@@ -104,6 +105,8 @@ gboolean _g_dbus_address_parse_entry (const gchar  *address_entry,
                                       GError      **error);
 
 GVariantType * _g_dbus_compute_complete_signature (GDBusArgInfo **args);
+gboolean       _g_dbus_args_match_type_string     (GDBusArgInfo **args,
+                                                   const gchar   *type_string);
 
 gchar *_g_dbus_hexdump (const gchar *data, gsize len, guint indent);
 
@@ -157,6 +157,12 @@ struct _GDBusProxyPrivate
   GDBusObject *object;
 
   SignalSubscriptionData *signal_subscription_data;
+
+  /* for G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES */
+  GMainContext *lazy_load_context;
+  /* protected by properties_lock */
+  gboolean lazy_load_started;
+  guint lazy_load_serial;
 };
 
 enum
@@ -245,6 +251,9 @@ g_dbus_proxy_finalize (GObject *object)
   if (proxy->priv->object != NULL)
     g_object_remove_weak_pointer (G_OBJECT (proxy->priv->object), (gpointer *) &proxy->priv->object);
 
+  if (proxy->priv->lazy_load_context != NULL)
+    g_main_context_unref (proxy->priv->lazy_load_context);
+
   G_OBJECT_CLASS (g_dbus_proxy_parent_class)->finalize (object);
 }
 
@@ -650,6 +659,18 @@ g_dbus_proxy_init (GDBusProxy *proxy)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+static void maybe_start_lazy_load_unlocked (GDBusProxy *proxy);
+
+/* properties_lock must be held; the next access loads the properties
+ * again (from the new name owner)
+ */
+static void
+reset_lazy_load_unlocked (GDBusProxy *proxy)
+{
+  proxy->priv->lazy_load_serial++;
+  proxy->priv->lazy_load_started = FALSE;
+}
+
 static gint
 property_name_sort_func (const gchar **a,
                          const gchar **b)
@@ -681,6 +702,8 @@ g_dbus_proxy_get_cached_property_names (GDBusProxy  *proxy)
 
   G_LOCK (properties_lock);
 
+  maybe_start_lazy_load_unlocked (proxy);
+
   names = NULL;
   if (g_hash_table_size (proxy->priv->properties) == 0)
     goto out;
@@ -726,6 +749,10 @@ lookup_property_info (GDBusProxy  *proxy,
  * Looks up the value for a property from the cache. This call does no
  * blocking IO.
  *
+ * If @proxy was constructed with %G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES,
+ * the first call starts loading the properties in the background and
+ * returns %NULL; wait for #GDBusProxy::g-properties-changed.
+ *
  * If @proxy has an expected interface (see
  * #GDBusProxy:g-interface-info) and @property_name is referenced by
  * it, then @value is checked against the type of the property.
@@ -748,6 +775,8 @@ g_dbus_proxy_get_cached_property (GDBusProxy   *proxy,
 
   G_LOCK (properties_lock);
 
+  maybe_start_lazy_load_unlocked (proxy);
+
   value = g_hash_table_lookup (proxy->priv->properties, property_name);
   if (value == NULL)
     goto out;
@@ -1323,6 +1352,7 @@ on_name_owner_changed (GDBusConnection *connection,
       G_LOCK (properties_lock);
       g_free (proxy->priv->name_owner);
       proxy->priv->name_owner = NULL;
+      reset_lazy_load_unlocked (proxy);
 
       /* Synthesize ::g-properties-changed changed */
       if (!(proxy->priv->flags & G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES) &&
@@ -1371,10 +1401,12 @@ on_name_owner_changed (GDBusConnection *connection,
           goto out;
         }
 
-      if (proxy->priv->flags & G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES)
+      if (proxy->priv->flags & (G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                                G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES))
         {
           g_free (proxy->priv->name_owner);
           proxy->priv->name_owner = g_strdup (new_owner);
+          reset_lazy_load_unlocked (proxy);
 
           g_hash_table_remove_all (proxy->priv->properties);
           G_UNLOCK (properties_lock);
@@ -1419,6 +1451,169 @@ on_name_owner_changed (GDBusConnection *connection,
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES: all lazy proxies for the same
+ * interface on the same object (and connection and main context) that
+ * want their properties at the same time share a single GetAll() call,
+ * and their caches hold references into the same reply.
+ */
+
+G_LOCK_DEFINE_STATIC (lazy_loads_lock);
+
+/* key (gchar*) -> LazyLoad*, protected by lazy_loads_lock */
+static GHashTable *lazy_loads = NULL;
+
+typedef struct
+{
+  gchar *key;
+  GSList *proxies; /* of LazyLoadProxy, newest first */
+} LazyLoad;
+
+typedef struct
+{
+  GDBusProxy *proxy;
+  guint serial;
+} LazyLoadProxy;
+
+static void
+lazy_load_get_all_cb (GDBusConnection *connection,
+                      GAsyncResult    *res,
+                      gpointer         user_data)
+{
+  LazyLoad *load = user_data;
+  GVariant *result;
+  GSList *l;
+
+  /* nobody can join once the reply is in */
+  G_LOCK (lazy_loads_lock);
+  g_hash_table_remove (lazy_loads, load->key);
+  G_UNLOCK (lazy_loads_lock);
+
+  /* Failure is ignored just like for the GetAll() at construction */
+  result = g_dbus_connection_call_finish (connection, res, NULL);
+
+  load->proxies = g_slist_reverse (load->proxies);
+  for (l = load->proxies; l != NULL; l = l->next)
+    {
+      LazyLoadProxy *lp = l->data;
+      gboolean current;
+
+      /* skip proxies whose name owner changed while we were waiting */
+      G_LOCK (properties_lock);
+      current = lp->serial == lp->proxy->priv->lazy_load_serial;
+      G_UNLOCK (properties_lock);
+
+      if (current && result != NULL)
+        process_get_all_reply (lp->proxy, result);
+
+      g_object_unref (lp->proxy);
+      g_slice_free (LazyLoadProxy, lp);
+    }
+
+  if (result != NULL)
+    g_variant_unref (result);
+  g_slist_free (load->proxies);
+  g_free (load->key);
+  g_slice_free (LazyLoad, load);
+}
+
+/* called in the proxy's main context */
+static gboolean
+lazy_load_in_idle_cb (gpointer user_data)
+{
+  GDBusProxy *proxy = user_data;
+  LazyLoadProxy *lp;
+  LazyLoad *load;
+  gchar *name_owner;
+  gchar *key;
+
+  lp = g_slice_new0 (LazyLoadProxy);
+  lp->proxy = g_object_ref (proxy);
+
+  G_LOCK (properties_lock);
+  name_owner = g_strdup (proxy->priv->name_owner);
+  lp->serial = proxy->priv->lazy_load_serial;
+  G_UNLOCK (properties_lock);
+
+  key = g_strdup_printf ("%p %p %s %s %s",
+                         proxy->priv->connection,
+                         proxy->priv->lazy_load_context,
+                         name_owner != NULL ? name_owner : "",
+                         proxy->priv->object_path,
+                         proxy->priv->interface_name);
+
+  G_LOCK (lazy_loads_lock);
+  if (lazy_loads == NULL)
+    lazy_loads = g_hash_table_new (g_str_hash, g_str_equal);
+  load = g_hash_table_lookup (lazy_loads, key);
+  if (load != NULL)
+    {
+      /* someone is already asking - just wait for their reply */
+      load->proxies = g_slist_prepend (load->proxies, lp);
+      G_UNLOCK (lazy_loads_lock);
+      g_free (key);
+      goto out;
+    }
+  load = g_slice_new0 (LazyLoad);
+  load->key = key;
+  load->proxies = g_slist_prepend (NULL, lp);
+  g_hash_table_insert (lazy_loads, load->key, load);
+  G_UNLOCK (lazy_loads_lock);
+
+  g_main_context_push_thread_default (proxy->priv->lazy_load_context);
+  g_dbus_connection_call (proxy->priv->connection,
+                          name_owner,
+                          proxy->priv->object_path,
+                          "org.freedesktop.DBus.Properties",
+                          "GetAll",
+                          g_variant_new ("(s)", proxy->priv->interface_name),
+                          G_VARIANT_TYPE ("(a{sv})"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,           /* timeout */
+                          NULL,         /* cancellable */
+                          (GAsyncReadyCallback) lazy_load_get_all_cb,
+                          load);
+  g_main_context_pop_thread_default (proxy->priv->lazy_load_context);
+
+ out:
+  g_free (name_owner);
+  return FALSE;
+}
+
+/* properties_lock must be held */
+static void
+maybe_start_lazy_load_unlocked (GDBusProxy *proxy)
+{
+  GSource *idle_source;
+
+  if (!(proxy->priv->flags & G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES) ||
+      (proxy->priv->flags & G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES) ||
+      !proxy->priv->initialized ||
+      proxy->priv->lazy_load_started)
+    return;
+
+  /* same as for the GetAll() at construction: nothing to load from
+   * if the name isn't owned
+   */
+  if (proxy->priv->name != NULL && proxy->priv->name_owner == NULL)
+    return;
+
+  proxy->priv->lazy_load_started = TRUE;
+
+  /* the reply, and so ::g-properties-changed, has to arrive in the
+   * context the proxy was constructed in
+   */
+  idle_source = g_idle_source_new ();
+  g_source_set_priority (idle_source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (idle_source,
+                         lazy_load_in_idle_cb,
+                         g_object_ref (proxy),
+                         (GDestroyNotify) g_object_unref);
+  g_source_attach (idle_source, proxy->priv->lazy_load_context);
+  g_source_unref (idle_source);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
 typedef struct
 {
   GDBusProxy *proxy;
@@ -1497,6 +1692,11 @@ async_init_data_set_name_owner (AsyncInitData *data,
       /* Don't load properties if the API user doesn't want them */
       get_all = FALSE;
     }
+  else if (data->proxy->priv->flags & G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES)
+    {
+      /* ... or not yet, see maybe_start_lazy_load_unlocked() */
+      get_all = FALSE;
+    }
   else if (name_owner == NULL && data->proxy->priv->name != NULL)
     {
       /* Don't attempt to load properties if the name_owner is NULL (which
@@ -1772,6 +1972,9 @@ async_initable_init_first (GAsyncInitable *initable)
 {
   GDBusProxy *proxy = G_DBUS_PROXY (initable);
 
+  if (proxy->priv->flags & G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES)
+    proxy->priv->lazy_load_context = g_main_context_ref_thread_default ();
+
   if (!(proxy->priv->flags & G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES))
     {
       /* subscribe to PropertiesChanged() */
@@ -47,6 +47,8 @@
 #include "glibintl.h"
 #include "giomodule-priv.h"
 #include "gappinfo.h"
+#include "gvdb/gvdb-reader.h"
+#include "gvdb/gvdb-builder.h"
 
 
 /**
@@ -145,6 +147,11 @@ static gchar *g_desktop_env = NULL;
 typedef struct
 {
   gchar                      *path;
+
+  /* See desktop_file_dir_get_index(); protected by the index lock */
+  GvdbTable                  *index;
+  gboolean                    index_failed;
+  gboolean                    index_stale;
 } DesktopFileDir;
 
 static DesktopFileDir *desktop_file_dirs;
@@ -198,6 +205,516 @@ desktop_file_dirs_refresh (void)
     }
 }
 
+/* DesktopFileDir index {{{2 */
+
+/* Scanning a directory means reading and parsing every desktop file in
+ * it, with all of their translations.  To avoid doing that in every
+ * process, the result is kept in an index in the user's cache
+ * directory: a GVDB file per directory and set of languages holding
+ *
+ *   "dirs": a(sx), the modification time of the directory and of
+ *           every subdirectory, by relative path
+ *   "apps": a table from desktop file id to a(ssxx), every desktop file
+ *           providing that id, in the order g_desktop_app_info_new()
+ *           tries them: the relative path of the file, its contents
+ *           reduced to the groups and languages GDesktopAppInfo uses,
+ *           and its modification time and size
+ *   "ids":  as, the keys of "apps"
+ *   "mime": a{sas}, the desktop file ids by MimeType, for directories
+ *           without a mimeinfo.cache
+ *
+ * The index is rebuilt whenever one of the directories changed.  A
+ * desktop file modified in place is noticed when it is looked up, by
+ * its modification time or size, and then read from disk instead and
+ * the index rebuilt on next use.
+ */
+
+#define DESKTOP_FILE_INDEX_VERSION "2"
+
+G_LOCK_DEFINE_STATIC (desktop_file_dir_index);
+
+typedef struct
+{
+  gchar  *path;      /* relative to the DesktopFileDir */
+  gchar  *contents;
+  gchar **mime_types;
+  gint64  mtime;
+  gint64  size;
+} DesktopFileIndexEntry;
+
+static void
+desktop_file_index_entry_free (gpointer data)
+{
+  DesktopFileIndexEntry *entry = data;
+
+  g_free (entry->path);
+  g_free (entry->contents);
+  g_strfreev (entry->mime_types);
+  g_slice_free (DesktopFileIndexEntry, entry);
+}
+
+static gint64
+desktop_file_index_get_mtime (const GStatBuf *buf)
+{
+#if defined (HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+  return (gint64) buf->st_mtime * G_USEC_PER_SEC + buf->st_mtim.tv_nsec / 1000;
+#else
+  return (gint64) buf->st_mtime * G_USEC_PER_SEC;
+#endif
+}
+
+static gint64
+desktop_file_dir_get_mtime (const gchar *path)
+{
+  GStatBuf buf;
+
+  if (g_stat (path, &buf) != 0 || !S_ISDIR (buf.st_mode))
+    return -1;
+
+  return desktop_file_index_get_mtime (&buf);
+}
+
+/* Whether the desktop file at @path is still as it was indexed */
+static gboolean
+desktop_file_index_file_is_valid (const gchar *path,
+                                  gint64       mtime,
+                                  gint64       size)
+{
+  GStatBuf buf;
+
+  return g_stat (path, &buf) == 0 &&
+         desktop_file_index_get_mtime (&buf) == mtime &&
+         (gint64) buf.st_size == size;
+}
+
+/* g_desktop_app_info_new() looks for "a-b-c.desktop" as a-b-c.desktop,
+ * a/b-c.desktop and a-b/c.desktop, in that order; lower is preferred.
+ */
+static gsize
+desktop_file_index_path_rank (const gchar *path)
+{
+  const gchar *slash;
+
+  slash = strchr (path, '/');
+  if (slash == NULL)
+    return 0;
+
+  if (strchr (slash + 1, '/') == NULL)
+    return 1 + (slash - path);
+
+  return G_MAXSIZE;
+}
+
+static gint
+desktop_file_index_entry_compare (gconstpointer a,
+                                  gconstpointer b)
+{
+  const DesktopFileIndexEntry *entry_a = *(DesktopFileIndexEntry * const *) a;
+  const DesktopFileIndexEntry *entry_b = *(DesktopFileIndexEntry * const *) b;
+  gsize rank_a, rank_b;
+
+  rank_a = desktop_file_index_path_rank (entry_a->path);
+  rank_b = desktop_file_index_path_rank (entry_b->path);
+  if (rank_a != rank_b)
+    return rank_a < rank_b ? -1 : 1;
+
+  return strcmp (entry_a->path, entry_b->path);
+}
+
+static gboolean
+desktop_file_index_is_language (const gchar         *key,
+                                const gchar * const *languages)
+{
+  const gchar *bracket;
+  gsize len;
+  gint i;
+
+  bracket = strchr (key, '[');
+  if (bracket == NULL)
+    return TRUE;
+
+  len = strlen (bracket + 1);
+  if (len == 0 || bracket[len] != ']')
+    return FALSE;
+  len--;
+
+  for (i = 0; languages[i] != NULL; i++)
+    if (strlen (languages[i]) == len && strncmp (bracket + 1, languages[i], len) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Keeps what g_desktop_app_info_load_from_keyfile() and the other
+ * users of GDesktopAppInfo.keyfile can see: the desktop entry and
+ * action groups, without the translations to other languages.
+ */
+static gchar *
+desktop_file_index_reduce (GKeyFile            *key_file,
+                           const gchar * const *languages)
+{
+  GString *contents;
+  gchar **groups;
+  gint i, j;
+
+  contents = g_string_new (NULL);
+  groups = g_key_file_get_groups (key_file, NULL);
+
+  for (i = 0; groups[i] != NULL; i++)
+    {
+      gchar **keys;
+
+      if (strcmp (groups[i], G_KEY_FILE_DESKTOP_GROUP) != 0 &&
+          !g_str_has_prefix (groups[i], "Desktop Action "))
+        continue;
+
+      g_string_append_printf (contents, "[%s]\n", groups[i]);
+
+      keys = g_key_file_get_keys (key_file, groups[i], NULL, NULL);
+      for (j = 0; keys != NULL && keys[j] != NULL; j++)
+        {
+          gchar *value;
+
+          if (!desktop_file_index_is_language (keys[j], languages))
+            continue;
+
+          value = g_key_file_get_value (key_file, groups[i], keys[j], NULL);
+          g_string_append_printf (contents, "%s=%s\n", keys[j], value);
+          g_free (value);
+        }
+      g_strfreev (keys);
+    }
+
+  g_strfreev (groups);
+
+  return g_string_free (contents, FALSE);
+}
+
+/* Adds every desktop file below @path to @entries, a table from
+ * desktop file id to a #GPtrArray of #DesktopFileIndexEntry.
+ */
+static void
+desktop_file_index_scan (const gchar         *path,
+                         const gchar         *relative,
+                         const gchar * const *languages,
+                         GVariantBuilder     *dirs,
+                         GHashTable          *entries)
+{
+  const gchar *basename;
+  gint64 mtime;
+  GDir *dir;
+
+  /* Before reading it, so that changes made meanwhile are noticed */
+  mtime = desktop_file_dir_get_mtime (path);
+  if (mtime < 0)
+    return;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  g_variant_builder_add (dirs, "(sx)", relative, mtime);
+
+  while ((basename = g_dir_read_name (dir)) != NULL)
+    {
+      gchar *filename;
+
+      filename = g_build_filename (path, basename, NULL);
+
+      if (g_str_has_suffix (basename, ".desktop"))
+        {
+          DesktopFileIndexEntry *entry;
+          GKeyFile *key_file;
+          gchar *start_group;
+          GStatBuf buf;
+
+          key_file = g_key_file_new ();
+          start_group = NULL;
+
+          /* Likewise, stat before reading */
+          if (g_stat (filename, &buf) == 0 &&
+              g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, NULL) &&
+              (start_group = g_key_file_get_start_group (key_file)) != NULL &&
+              strcmp (start_group, G_KEY_FILE_DESKTOP_GROUP) == 0)
+            {
+              GPtrArray *candidates;
+              gchar *desktop_id;
+              gchar *p;
+
+              entry = g_slice_new0 (DesktopFileIndexEntry);
+              entry->path = g_strconcat (relative, basename, NULL);
+              entry->contents = desktop_file_index_reduce (key_file, languages);
+              entry->mime_types = g_key_file_get_string_list (key_file, G_KEY_FILE_DESKTOP_GROUP,
+                                                              G_KEY_FILE_DESKTOP_KEY_MIME_TYPE, NULL, NULL);
+              entry->mtime = desktop_file_index_get_mtime (&buf);
+              entry->size = buf.st_size;
+
+              desktop_id = g_strdup (entry->path);
+              for (p = desktop_id; *p; p++)
+                if (*p == '/')
+                  *p = '-';
+
+              candidates = g_hash_table_lookup (entries, desktop_id);
+              if (candidates == NULL)
+                {
+                  candidates = g_ptr_array_new_with_free_func (desktop_file_index_entry_free);
+                  g_hash_table_insert (entries, desktop_id, candidates);
+                }
+              else
+                g_free (desktop_id);
+
+              g_ptr_array_add (candidates, entry);
+            }
+
+          g_free (start_group);
+          g_key_file_unref (key_file);
+        }
+      else if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+        {
+          gchar *subdir;
+
+          subdir = g_strconcat (relative, basename, "/", NULL);
+          desktop_file_index_scan (filename, subdir, languages, dirs, entries);
+          g_free (subdir);
+        }
+
+      g_free (filename);
+    }
+
+  g_dir_close (dir);
+}
+
+static gboolean
+desktop_file_index_write (const gchar  *path,
+                          const gchar  *index_file,
+                          GError      **error)
+{
+  const gchar * const *languages;
+  GVariantBuilder dirs, ids, mime;
+  GHashTable *entries, *by_mime;
+  GHashTable *root, *apps;
+  GHashTableIter iter;
+  gpointer key, value;
+  gboolean ret;
+
+  languages = g_get_language_names ();
+  entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+  g_variant_builder_init (&dirs, G_VARIANT_TYPE ("a(sx)"));
+  desktop_file_index_scan (path, "", languages, &dirs, entries);
+
+  root = gvdb_hash_table_new (NULL, NULL);
+  gvdb_hash_table_insert_string (root, "version", DESKTOP_FILE_INDEX_VERSION);
+  gvdb_item_set_value (gvdb_hash_table_insert (root, "dirs"), g_variant_builder_end (&dirs));
+
+  apps = gvdb_hash_table_new (root, "apps");
+  by_mime = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_ptr_array_unref);
+  g_variant_builder_init (&ids, G_VARIANT_TYPE_STRING_ARRAY);
+
+  g_hash_table_iter_init (&iter, entries);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GPtrArray *candidates = value;
+      DesktopFileIndexEntry *entry;
+      GVariantBuilder files;
+      guint i;
+
+      g_ptr_array_sort (candidates, desktop_file_index_entry_compare);
+
+      g_variant_builder_init (&files, G_VARIANT_TYPE ("a(ssxx)"));
+      for (i = 0; i < candidates->len; i++)
+        {
+          entry = candidates->pdata[i];
+          g_variant_builder_add (&files, "(ssxx)", entry->path, entry->contents,
+                                 entry->mtime, entry->size);
+        }
+
+      gvdb_item_set_value (gvdb_hash_table_insert (apps, key), g_variant_builder_end (&files));
+      g_variant_builder_add (&ids, "s", key);
+
+      /* The MIME types of the file that is preferred */
+      entry = candidates->pdata[0];
+
+      for (i = 0; entry->mime_types != NULL && entry->mime_types[i] != NULL; i++)
+        {
+          GPtrArray *desktop_ids;
+
+          desktop_ids = g_hash_table_lookup (by_mime, entry->mime_types[i]);
+          if (desktop_ids == NULL)
+            {
+              desktop_ids = g_ptr_array_new ();
+              g_hash_table_insert (by_mime, entry->mime_types[i], desktop_ids);
+            }
+          g_ptr_array_add (desktop_ids, key);
+        }
+    }
+
+  gvdb_item_set_value (gvdb_hash_table_insert (root, "ids"), g_variant_builder_end (&ids));
+
+  g_variant_builder_init (&mime, G_VARIANT_TYPE ("a{sas}"));
+  g_hash_table_iter_init (&iter, by_mime);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GPtrArray *desktop_ids = value;
+
+      g_ptr_array_add (desktop_ids, NULL);
+      g_variant_builder_add (&mime, "{s^as}", key, desktop_ids->pdata);
+    }
+  gvdb_item_set_value (gvdb_hash_table_insert (root, "mime"), g_variant_builder_end (&mime));
+
+  ret = gvdb_table_write_contents (root, index_file, FALSE, error);
+
+  g_hash_table_unref (root);
+  g_hash_table_unref (by_mime);
+  g_hash_table_unref (entries);
+
+  return ret;
+}
+
+static gboolean
+desktop_file_index_is_valid (GvdbTable   *index,
+                             const gchar *path)
+{
+  GVariant *version, *dirs;
+  GVariantIter iter;
+  const gchar *relative;
+  gint64 mtime;
+  gboolean valid;
+
+  version = gvdb_table_get_value (index, "version");
+  valid = version != NULL && g_str_equal (g_variant_get_string (version, NULL), DESKTOP_FILE_INDEX_VERSION);
+  if (version)
+    g_variant_unref (version);
+
+  dirs = valid ? gvdb_table_get_value (index, "dirs") : NULL;
+  if (dirs == NULL)
+    return FALSE;
+
+  g_variant_iter_init (&iter, dirs);
+  while (valid && g_variant_iter_next (&iter, "(&sx)", &relative, &mtime))
+    {
+      gchar *subdir;
+
+      subdir = g_build_filename (path, relative, NULL);
+      valid = desktop_file_dir_get_mtime (subdir) == mtime;
+      g_free (subdir);
+    }
+
+  g_variant_unref (dirs);
+
+  return valid;
+}
+
+static gchar *
+desktop_file_dir_get_index_filename (DesktopFileDir *dir)
+{
+  gchar *languages, *key, *checksum, *basename, *filename;
+
+  languages = g_strjoinv (":", (gchar **) g_get_language_names ());
+  key = g_strconcat (dir->path, "\n", languages, NULL);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+  basename = g_strconcat (checksum, ".v" DESKTOP_FILE_INDEX_VERSION, NULL);
+  filename = g_build_filename (g_get_user_cache_dir (), "glib-2.0", "desktop-index", basename, NULL);
+
+  g_free (basename);
+  g_free (checksum);
+  g_free (key);
+  g_free (languages);
+
+  return filename;
+}
+
+/*< internal >
+ * desktop_file_dir_get_index:
+ * @dir: a #DesktopFileDir
+ *
+ * Gets the index of the desktop files in @dir, rebuilding it first if
+ * any of its directories changed since, or one of its desktop files
+ * was found modified.  The lock is not held while rebuilding, so
+ * other threads can go on using the other directories; if two threads
+ * rebuild the same index, either result will do.
+ *
+ * Returns: (transfer full): the index, or %NULL if @dir doesn't exist
+ *     or can't be indexed, in which case callers scan it themselves
+ */
+static GvdbTable *
+desktop_file_dir_get_index (DesktopFileDir *dir)
+{
+  GvdbTable *index = NULL;
+  gboolean stale, failed = FALSE;
+  gchar *index_file;
+  GError *error = NULL;
+
+  G_LOCK (desktop_file_dir_index);
+
+  if (dir->index_failed)
+    {
+      G_UNLOCK (desktop_file_dir_index);
+      return NULL;
+    }
+
+  if (dir->index != NULL && !dir->index_stale &&
+      desktop_file_index_is_valid (dir->index, dir->path))
+    {
+      index = gvdb_table_ref (dir->index);
+      G_UNLOCK (desktop_file_dir_index);
+      return index;
+    }
+
+  stale = dir->index_stale;
+
+  G_UNLOCK (desktop_file_dir_index);
+
+  if (desktop_file_dir_get_mtime (dir->path) < 0)
+    return NULL;
+
+  index_file = desktop_file_dir_get_index_filename (dir);
+
+  /* Another process may have brought it up to date */
+  if (!stale)
+    {
+      index = gvdb_table_new (index_file, FALSE, NULL);
+      if (index != NULL && !desktop_file_index_is_valid (index, dir->path))
+        g_clear_pointer (&index, gvdb_table_unref);
+    }
+
+  if (index == NULL)
+    {
+      gchar *index_dir;
+
+      index_dir = g_path_get_dirname (index_file);
+
+      if (g_mkdir_with_parents (index_dir, 0700) != 0 ||
+          !desktop_file_index_write (dir->path, index_file, &error) ||
+          (index = gvdb_table_new (index_file, FALSE, &error)) == NULL)
+        {
+          /* Most likely a read-only home directory; don't try again */
+          if (error != NULL)
+            g_debug ("Not indexing %s: %s", dir->path, error->message);
+          g_clear_error (&error);
+          failed = TRUE;
+        }
+
+      g_free (index_dir);
+    }
+
+  g_free (index_file);
+
+  G_LOCK (desktop_file_dir_index);
+
+  if (failed)
+    dir->index_failed = TRUE;
+  else
+    {
+      g_clear_pointer (&dir->index, gvdb_table_unref);
+      dir->index = gvdb_table_ref (index);
+      dir->index_stale = FALSE;
+    }
+
+  G_UNLOCK (desktop_file_dir_index);
+
+  return index;
+}
+
 /* GDesktopAppInfo implementation {{{1 */
 /* GObject implementation {{{2 */
 static void
@@ -507,6 +1024,85 @@ g_desktop_app_info_load_file (GDesktopAppInfo *self)
   return retval;
 }
 
+/*< internal >
+ * desktop_file_dir_index_get_app_info:
+ * @dir: the #DesktopFileDir @index belongs to
+ * @index: the index of @dir
+ * @desktop_id: a desktop file id
+ * @any_depth: whether the file may be more than one subdirectory deep,
+ *     which g_desktop_app_info_new() doesn't look for
+ *
+ * Like g_desktop_app_info_new_from_filename() on the files that provide
+ * @desktop_id in @dir, in order, until one of them can be used, but
+ * without reading them unless they changed since they were indexed.
+ *
+ * Returns: a new #GDesktopAppInfo, or %NULL if there is no such file or
+ *     none of them can be used
+ */
+static GDesktopAppInfo *
+desktop_file_dir_index_get_app_info (DesktopFileDir *dir,
+                                     GvdbTable      *index,
+                                     const gchar    *desktop_id,
+                                     gboolean        any_depth)
+{
+  GDesktopAppInfo *info = NULL;
+  const gchar *path, *contents;
+  gint64 mtime, size;
+  GVariantIter iter;
+  GvdbTable *apps;
+  GVariant *value;
+
+  apps = gvdb_table_get_table (index, "apps");
+  if (apps == NULL)
+    return NULL;
+
+  value = gvdb_table_get_value (apps, desktop_id);
+  gvdb_table_unref (apps);
+  if (value == NULL)
+    return NULL;
+
+  g_variant_iter_init (&iter, value);
+  while (info == NULL &&
+         g_variant_iter_next (&iter, "(&s&sxx)", &path, &contents, &mtime, &size))
+    {
+      gchar *filename;
+
+      if (!any_depth && desktop_file_index_path_rank (path) == G_MAXSIZE)
+        continue;
+
+      filename = g_build_filename (dir->path, path, NULL);
+
+      if (desktop_file_index_file_is_valid (filename, mtime, size))
+        {
+          GKeyFile *key_file;
+
+          info = g_object_new (G_TYPE_DESKTOP_APP_INFO, "filename", filename, NULL);
+          info->desktop_id = g_path_get_basename (filename);
+
+          key_file = g_key_file_new ();
+          if (!g_key_file_load_from_data (key_file, contents, -1, G_KEY_FILE_NONE, NULL) ||
+              !g_desktop_app_info_load_from_keyfile (info, key_file))
+            g_clear_object (&info);
+          g_key_file_unref (key_file);
+        }
+      else
+        {
+          /* Modified in place: the index is out of date */
+          G_LOCK (desktop_file_dir_index);
+          dir->index_stale = TRUE;
+          G_UNLOCK (desktop_file_dir_index);
+
+          info = g_desktop_app_info_new_from_filename (filename);
+        }
+
+      g_free (filename);
+    }
+
+  g_variant_unref (value);
+
+  return info;
+}
+
 /**
  * g_desktop_app_info_new_from_keyfile:
  * @key_file: an opened #GKeyFile
@@ -586,9 +1182,21 @@ g_desktop_app_info_new (const char *desktop_id)
   for (i = 0; i < n_desktop_file_dirs; i++)
     {
       const gchar *path = desktop_file_dirs[i].path;
+      GvdbTable *index;
       char *filename;
       char *p;
 
+      index = desktop_file_dir_get_index (&desktop_file_dirs[i]);
+      if (index != NULL)
+        {
+          appinfo = desktop_file_dir_index_get_app_info (&desktop_file_dirs[i], index, desktop_id, FALSE);
+          gvdb_table_unref (index);
+          if (appinfo != NULL)
+            goto found;
+
+          continue;
+        }
+
       filename = g_build_filename (path, desktop_id, NULL);
       appinfo = g_desktop_app_info_new_from_filename (filename);
       g_free (filename);
@@ -2825,6 +3433,48 @@ get_apps_from_dir (GHashTable *apps,
     }
 }
 
+static void
+get_apps_from_index (GHashTable     *apps,
+                     DesktopFileDir *dir,
+                     GvdbTable      *index)
+{
+  GVariant *ids;
+  GVariantIter iter;
+  const gchar *desktop_id;
+
+  ids = gvdb_table_get_value (index, "ids");
+  if (ids == NULL)
+    return;
+
+  g_variant_iter_init (&iter, ids);
+  while (g_variant_iter_next (&iter, "&s", &desktop_id))
+    {
+      GDesktopAppInfo *appinfo;
+
+      /* Use _extended so we catch NULLs too (hidden) */
+      if (g_hash_table_lookup_extended (apps, desktop_id, NULL, NULL))
+        continue;
+
+      appinfo = desktop_file_dir_index_get_app_info (dir, index, desktop_id, TRUE);
+      if (appinfo == NULL)
+        continue;
+
+      if (g_desktop_app_info_get_is_hidden (appinfo))
+        {
+          g_hash_table_insert (apps, g_strdup (desktop_id), NULL);
+          g_object_unref (appinfo);
+        }
+      else
+        {
+          g_free (appinfo->desktop_id);
+          appinfo->desktop_id = g_strdup (desktop_id);
+          g_hash_table_insert (apps, g_strdup (desktop_id), appinfo);
+        }
+    }
+
+  g_variant_unref (ids);
+}
+
 /* "Get all" API {{{2 */
 
 /**
@@ -2858,7 +3508,18 @@ g_app_info_get_all (void)
 
 
   for (i = 0; i < n_desktop_file_dirs; i++)
-    get_apps_from_dir (apps, desktop_file_dirs[i].path, "");
+    {
+      GvdbTable *index;
+
+      index = desktop_file_dir_get_index (&desktop_file_dirs[i]);
+      if (index != NULL)
+        {
+          get_apps_from_index (apps, &desktop_file_dirs[i], index);
+          gvdb_table_unref (index);
+        }
+      else
+        get_apps_from_dir (apps, desktop_file_dirs[i].path, "");
+    }
 
 
   infos = NULL;
@@ -2878,6 +3539,7 @@ g_app_info_get_all (void)
 
 typedef struct {
   char *path;
+  DesktopFileDir *desktop_file_dir;
   GHashTable *mime_info_cache_map;
   GHashTable *defaults_list_map;
   GHashTable *mimeapps_list_added_map;
@@ -2940,6 +3602,43 @@ mime_info_cache_dir_out_of_date (MimeInfoCacheDir *dir,
   return FALSE;
 }
 
+/* Without a mimeinfo.cache, fall back to the MimeType keys of the
+ * desktop files, as gathered by the index.  Call with lock held.
+ */
+static void
+mime_info_cache_dir_init_from_index (MimeInfoCacheDir *dir)
+{
+  GvdbTable *index;
+  GVariant *mime;
+  GVariantIter iter;
+  const gchar *mime_type;
+  gchar **desktop_file_ids;
+
+  index = desktop_file_dir_get_index (dir->desktop_file_dir);
+  if (index == NULL)
+    return;
+
+  mime = gvdb_table_get_value (index, "mime");
+  if (mime != NULL)
+    {
+      g_variant_iter_init (&iter, mime);
+      while (g_variant_iter_next (&iter, "{&s^as}", &mime_type, &desktop_file_ids))
+        {
+          char *unaliased_type;
+
+          unaliased_type = _g_unix_content_type_unalias (mime_type);
+          mime_info_cache_dir_add_desktop_entries (dir,
+                                                   unaliased_type,
+                                                   desktop_file_ids);
+          g_free (unaliased_type);
+          g_strfreev (desktop_file_ids);
+        }
+      g_variant_unref (mime);
+    }
+
+  gvdb_table_unref (index);
+}
+
 /* Call with lock held */
 static void
 mime_info_cache_dir_init (MimeInfoCacheDir *dir)
@@ -2970,7 +3669,10 @@ mime_info_cache_dir_init (MimeInfoCacheDir *dir)
   filename = g_build_filename (dir->path, "mimeinfo.cache", NULL);
 
   if (g_stat (filename, &buf) < 0)
-    goto error;
+    {
+      mime_info_cache_dir_init_from_index (dir);
+      goto error;
+    }
 
   dir->mime_info_cache_timestamp = buf.st_mtime;
 
@@ -3235,12 +3937,13 @@ mime_info_cache_dir_init_mimeapps_list (MimeInfoCacheDir *dir)
 }
 
 static MimeInfoCacheDir *
-mime_info_cache_dir_new (const char *path)
+mime_info_cache_dir_new (DesktopFileDir *desktop_file_dir)
 {
   MimeInfoCacheDir *dir;
 
   dir = g_new0 (MimeInfoCacheDir, 1);
-  dir->path = g_strdup (path);
+  dir->path = g_strdup (desktop_file_dir->path);
+  dir->desktop_file_dir = desktop_file_dir;
 
   return dir;
 }
@@ -3319,7 +4022,7 @@ mime_info_cache_init_dir_lists (void)
     {
       MimeInfoCacheDir *dir;
 
-      dir = mime_info_cache_dir_new (desktop_file_dirs[i].path);
+      dir = mime_info_cache_dir_new (&desktop_file_dirs[i]);
 
       if (dir != NULL)
         {
@@ -27,12 +27,13 @@
 #ifdef __linux__
 #include <sys/ioctl.h>
 #include <errno.h>
-/* See linux.git/fs/btrfs/ioctl.h */
+/* See linux.git/fs/btrfs/ioctl.h; the same ioctl is available as
+ * FICLONE on other file systems supporting reflinks, like XFS */
 #define BTRFS_IOCTL_MAGIC 0x94
 #define BTRFS_IOC_CLONE _IOW(BTRFS_IOCTL_MAGIC, 9, int)
 #endif
 
-#ifdef HAVE_SPLICE
+#if defined (HAVE_SPLICE) || defined (HAVE_COPY_FILE_RANGE)
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -44,6 +45,14 @@
 #ifdef HAVE_PWD_H
 #include <pwd.h>
 #endif
+#ifdef G_OS_UNIX
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "gfile.h"
 #include "glib/gstdio.h"
@@ -61,6 +70,7 @@
 #include "glocalfileoutputstream.h"
 #include "glocalfileiostream.h"
 #include "glocalfile.h"
+#include "glocalfileinfo.h"
 #include "gcancellable.h"
 #include "gasyncresult.h"
 #include "gioerror.h"
@@ -1284,6 +1294,242 @@ g_file_query_info_finish (GFile         *file,
   return (* iface->query_info_finish) (file, res, error);
 }
 
+typedef struct {
+  GFile **files;
+  guint n_files;
+  char *attributes;
+  GFileQueryInfoFlags flags;
+} QueryInfoManyData;
+
+static void
+query_info_many_data_free (QueryInfoManyData *data)
+{
+  guint i;
+
+  for (i = 0; i < data->n_files; i++)
+    g_object_unref (data->files[i]);
+  g_free (data->files);
+  g_free (data->attributes);
+  g_slice_free (QueryInfoManyData, data);
+}
+
+static void
+query_info_many_clear_info (gpointer info)
+{
+  if (info != NULL)
+    g_object_unref (info);
+}
+
+/* Queries the local files at @indices, which all live in @dirname.
+ * The parent directory info is only computed once for all of them,
+ * and if there is more than one file, the directory is opened so
+ * they can be stat()ed relative to it.
+ */
+static void
+query_info_many_local_dir (QueryInfoManyData     *data,
+                           const char            *dirname,
+                           GArray                *indices,
+                           GFileAttributeMatcher *matcher,
+                           GPtrArray             *infos,
+                           GCancellable          *cancellable)
+{
+  GLocalParentFileInfo parent_info;
+  guint i;
+
+  _g_local_file_info_get_parent_info (dirname, matcher, &parent_info);
+
+#if defined (AT_FDCWD) && defined (O_DIRECTORY) && defined (O_CLOEXEC)
+  if (indices->len > 1)
+    parent_info.dir_fd = g_open (dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+#endif
+
+  for (i = 0; i < indices->len; i++)
+    {
+      guint index = g_array_index (indices, guint, i);
+      const char *path;
+      char *basename;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      path = _g_local_file_get_filename (G_LOCAL_FILE (data->files[index]));
+      basename = g_path_get_basename (path);
+      infos->pdata[index] = _g_local_file_info_get (basename, path, matcher,
+                                                    data->flags, &parent_info,
+                                                    NULL);
+      g_free (basename);
+    }
+
+  _g_local_file_info_free_parent_info (&parent_info);
+}
+
+static void
+query_info_many_thread (GTask         *task,
+                        gpointer       object,
+                        gpointer       task_data,
+                        GCancellable  *cancellable)
+{
+  QueryInfoManyData *data = task_data;
+  GFileAttributeMatcher *matcher;
+  GHashTable *dirs;
+  GHashTableIter iter;
+  gpointer key, value;
+  GPtrArray *infos;
+  GError *error = NULL;
+  guint i;
+
+  infos = g_ptr_array_new_full (data->n_files, query_info_many_clear_info);
+  g_ptr_array_set_size (infos, data->n_files);
+
+  /* Group local files by their parent directory; query the rest
+   * one by one as we go.
+   */
+  dirs = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                g_free, (GDestroyNotify) g_array_unref);
+
+  for (i = 0; i < data->n_files; i++)
+    {
+      if (G_IS_LOCAL_FILE (data->files[i]))
+        {
+          GArray *indices;
+          char *dirname;
+
+          dirname = g_path_get_dirname (_g_local_file_get_filename (G_LOCAL_FILE (data->files[i])));
+          indices = g_hash_table_lookup (dirs, dirname);
+          if (indices == NULL)
+            {
+              indices = g_array_new (FALSE, FALSE, sizeof (guint));
+              g_hash_table_insert (dirs, dirname, indices);
+            }
+          else
+            g_free (dirname);
+
+          g_array_append_val (indices, i);
+        }
+      else
+        {
+          if (g_cancellable_is_cancelled (cancellable))
+            break;
+
+          infos->pdata[i] = g_file_query_info (data->files[i], data->attributes,
+                                               data->flags, cancellable, NULL);
+        }
+    }
+
+  matcher = g_file_attribute_matcher_new (data->attributes);
+
+  g_hash_table_iter_init (&iter, dirs);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      query_info_many_local_dir (data, key, value, matcher, infos, cancellable);
+    }
+
+  g_file_attribute_matcher_unref (matcher);
+  g_hash_table_unref (dirs);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    {
+      g_ptr_array_unref (infos);
+      g_task_return_error (task, error);
+    }
+  else
+    g_task_return_pointer (task, infos, (GDestroyNotify) g_ptr_array_unref);
+}
+
+/**
+ * g_file_query_info_many_async:
+ * @files: (array length=n_files): the files to query
+ * @n_files: the number of elements in @files
+ * @attributes: an attribute query string
+ * @flags: a set of #GFileQueryInfoFlags
+ * @io_priority: the <link linkend="io-priority">I/O priority</link>
+ *     of the request
+ * @cancellable: (allow-none): optional #GCancellable object,
+ *     %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     request is satisfied
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Asynchronously gets the requested information about each of @files,
+ * as if by calling g_file_query_info() on each of them.
+ *
+ * This is considerably cheaper than querying the files one at a time
+ * when many of them are local files in the same directories: they are
+ * grouped by directory, information about each directory is gathered
+ * only once, and the files are examined relative to the open
+ * directory.
+ *
+ * When the operation is finished, @callback will be called. You can
+ * then call g_file_query_info_many_finish() to get the result of the
+ * operation.
+ *
+ * Since: 2.40
+ */
+void
+g_file_query_info_many_async (GFile               **files,
+                              guint                 n_files,
+                              const char           *attributes,
+                              GFileQueryInfoFlags   flags,
+                              int                   io_priority,
+                              GCancellable         *cancellable,
+                              GAsyncReadyCallback   callback,
+                              gpointer              user_data)
+{
+  QueryInfoManyData *data;
+  GTask *task;
+  guint i;
+
+  g_return_if_fail (files != NULL || n_files == 0);
+  for (i = 0; i < n_files; i++)
+    g_return_if_fail (G_IS_FILE (files[i]));
+
+  data = g_slice_new0 (QueryInfoManyData);
+  data->files = g_new (GFile *, n_files);
+  data->n_files = n_files;
+  for (i = 0; i < n_files; i++)
+    data->files[i] = g_object_ref (files[i]);
+  data->attributes = g_strdup (attributes);
+  data->flags = flags;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_file_query_info_many_async);
+  g_task_set_task_data (task, data, (GDestroyNotify) query_info_many_data_free);
+  g_task_set_priority (task, io_priority);
+  g_task_run_in_thread (task, query_info_many_thread);
+  g_object_unref (task);
+}
+
+/**
+ * g_file_query_info_many_finish:
+ * @res: a #GAsyncResult
+ * @error: a #GError
+ *
+ * Finishes an asynchronous query started with
+ * g_file_query_info_many_async().
+ *
+ * The result has one element for each of the files that were passed
+ * in, in the same order.  An element is %NULL if that file could not
+ * be queried; use g_file_query_info() on it to find out why.
+ *
+ * Returns: (transfer full) (element-type GFileInfo): a #GPtrArray of
+ *     #GFileInfo, or %NULL on error (which only happens if the
+ *     operation was cancelled).  Free it with g_ptr_array_unref().
+ *
+ * Since: 2.40
+ */
+GPtrArray *
+g_file_query_info_many_finish (GAsyncResult  *res,
+                               GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (res, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (res)) == g_file_query_info_many_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * g_file_query_filesystem_info:
  * @file: input #GFile
@@ -3048,6 +3294,94 @@ btrfs_reflink_with_progress (GInputStream           *in,
 }
 #endif
 
+#ifdef HAVE_COPY_FILE_RANGE
+static gboolean
+copy_file_range_with_progress (GInputStream           *in,
+                               GOutputStream          *out,
+                               GCancellable           *cancellable,
+                               GFileProgressCallback   progress_callback,
+                               gpointer                progress_callback_data,
+                               GError                **error)
+{
+  goffset total_size;
+  loff_t offset_in;
+  loff_t offset_out;
+  int fd_in, fd_out;
+
+  fd_in = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (in));
+  fd_out = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (out));
+
+  total_size = -1;
+  /* avoid performance impact of querying total size when it's not needed */
+  if (progress_callback)
+    {
+      struct stat sbuf;
+
+      if (fstat (fd_in, &sbuf) == 0)
+        total_size = sbuf.st_size;
+    }
+
+  if (total_size == -1)
+    total_size = 0;
+
+  /* The explicit offsets leave the file positions alone, so the
+   * callers can fall back to another method from the start. */
+  offset_in = offset_out = 0;
+  while (TRUE)
+    {
+      ssize_t n_copied;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        return FALSE;
+
+      n_copied = copy_file_range (fd_in, &offset_in, fd_out, &offset_out,
+                                  1024 * 1024 * 8, 0);
+      if (n_copied == -1)
+        {
+          int errsv = errno;
+
+          if (errsv == EINTR)
+            continue;
+
+          /* Not implemented, or not between these file systems */
+          if (offset_in == 0 &&
+              (errsv == ENOSYS || errsv == EXDEV || errsv == EINVAL ||
+               errsv == EOPNOTSUPP || errsv == EBADF || errsv == ETXTBSY))
+            g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                                 _("Copying file ranges is not supported"));
+          else
+            g_set_error (error, G_IO_ERROR,
+                         g_io_error_from_errno (errsv),
+                         _("Error copying file: %s"),
+                         g_strerror (errsv));
+          return FALSE;
+        }
+
+      if (n_copied == 0)
+        {
+          /* Some pseudo file systems claim to support this but copy
+           * nothing; let the other methods handle those. */
+          if (offset_in == 0)
+            {
+              g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                                   _("Copying file ranges is not supported"));
+              return FALSE;
+            }
+          break;
+        }
+
+      if (progress_callback)
+        progress_callback (offset_in, total_size, progress_callback_data);
+    }
+
+  /* Make sure we send full copied size */
+  if (progress_callback)
+    progress_callback (offset_in, total_size, progress_callback_data);
+
+  return TRUE;
+}
+#endif
+
 static gboolean
 file_copy_fallback (GFile                  *source,
                     GFile                  *destination,
@@ -3212,6 +3546,33 @@ file_copy_fallback (GFile                  *source,
     }
 #endif
 
+#ifdef HAVE_COPY_FILE_RANGE
+  if (G_IS_FILE_DESCRIPTOR_BASED (in) && G_IS_FILE_DESCRIPTOR_BASED (out))
+    {
+      GError *copy_err = NULL;
+
+      if (!copy_file_range_with_progress (in, out, cancellable,
+                                          progress_callback, progress_callback_data,
+                                          &copy_err))
+        {
+          if (g_error_matches (copy_err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+            {
+              g_clear_error (&copy_err);
+            }
+          else
+            {
+              g_propagate_error (error, copy_err);
+              goto out;
+            }
+        }
+      else
+        {
+          ret = TRUE;
+          goto out;
+        }
+    }
+#endif
+
 #ifdef HAVE_SPLICE
   if (G_IS_FILE_DESCRIPTOR_BASED (in) && G_IS_FILE_DESCRIPTOR_BASED (out))
     {
@@ -5222,6 +5583,11 @@ g_file_eject_mountable_with_operation_finish (GFile         *file,
  * directory for changes made via hard links; if you want to do this then
  * you must register individual watches with g_file_monitor().
  *
+ * With %G_FILE_MONITOR_RECURSIVE, changes anywhere below @file are
+ * reported, with the affected file as the child.  On Linux this uses
+ * fanotify, which needs the CAP_SYS_ADMIN capability; when no backend
+ * can do it, %G_IO_ERROR_NOT_SUPPORTED is returned.
+ *
  * Virtual: monitor_dir
  * Returns: (transfer full): a #GFileMonitor for the given @file,
  *     or %NULL on error.
@@ -6903,6 +7269,36 @@ load_contents_open_callback (GObject      *obj,
     }
 }
 
+/* For local files every step of the generic implementation above (open,
+ * one read per block, query_info and close) is a separate trip through
+ * the thread pool. Do the whole load with a single one instead.
+ */
+static void
+load_contents_thread (GTask        *task,
+                      gpointer      object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  LoadContentsData *data = task_data;
+  GError *error = NULL;
+  char *contents;
+  gsize length;
+
+  if (!g_file_load_contents (G_FILE (object), cancellable,
+                             &contents, &length, &data->etag, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  /* The zero terminator is not part of the length */
+  g_byte_array_free (data->content, TRUE);
+  data->content = g_byte_array_new_take ((guint8 *) contents, length);
+  data->pos = length;
+
+  g_task_return_boolean (task, TRUE);
+}
+
 /**
  * g_file_load_partial_contents_async: (skip)
  * @file: input #GFile
@@ -6942,6 +7338,16 @@ g_file_load_partial_contents_async (GFile                 *file,
   data->task = g_task_new (file, cancellable, callback, user_data);
   g_task_set_task_data (data->task, data, (GDestroyNotify)load_contents_data_free);
 
+  /* read_more_callback must run in the caller's context, so partial
+   * loads always use the stream based implementation.
+   */
+  if (read_more_callback == NULL && G_IS_LOCAL_FILE (file))
+    {
+      g_task_run_in_thread (data->task, load_contents_thread);
+      g_object_unref (data->task);
+      return;
+    }
+
   g_file_read_async (file,
                      0,
                      g_task_get_cancellable (data->task),
@@ -7083,32 +7489,265 @@ g_file_load_contents_finish (GFile         *file,
                                               error);
 }
 
+/* Below this, copying the data is cheaper than setting up a mapping */
+#define LOAD_BYTES_MAP_THRESHOLD (64 * 1024)
+
+#ifdef G_OS_UNIX
+/* Returns %NULL if the file should be read normally instead */
+static GBytes *
+load_bytes_mapped (const char  *path,
+                   char       **etag_out)
+{
+  GMappedFile *mapped;
+  GLocalFileStat buf;
+  GBytes *bytes;
+  int fd;
+
+  fd = g_open (path, O_RDONLY, 0);
+  if (fd == -1)
+    return NULL;
+
+  if (fstat (fd, &buf) != 0 ||
+      !S_ISREG (buf.st_mode) ||
+      buf.st_size < LOAD_BYTES_MAP_THRESHOLD)
+    {
+      (void) g_close (fd, NULL);
+      return NULL;
+    }
+
+  mapped = g_mapped_file_new_from_fd (fd, FALSE, NULL);
+  (void) g_close (fd, NULL);
+
+  if (mapped == NULL)
+    return NULL;
+
+#if defined (HAVE_MMAP) && defined (MADV_SEQUENTIAL) && defined (MADV_WILLNEED)
+  madvise (g_mapped_file_get_contents (mapped), g_mapped_file_get_length (mapped), MADV_SEQUENTIAL);
+  madvise (g_mapped_file_get_contents (mapped), g_mapped_file_get_length (mapped), MADV_WILLNEED);
+#endif
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  g_mapped_file_unref (mapped);
+
+  if (etag_out)
+    *etag_out = _g_local_file_info_create_etag (&buf);
+
+  return bytes;
+}
+#endif
+
 /**
- * g_file_replace_contents:
- * @file: input #GFile
- * @contents: (element-type guint8) (array length=length): a string containing the new contents for @file
- * @length: the length of @contents in bytes
- * @etag: (allow-none): the old <link linkend="gfile-etag">entity tag</link>
- *     for the document, or %NULL
- * @make_backup: %TRUE if a backup should be created
- * @flags: a set of #GFileCreateFlags
- * @new_etag: (allow-none) (out): a location to a new <link linkend="gfile-etag">entity tag</link>
- *      for the document. This should be freed with g_free() when no longer
- *      needed, or %NULL
- * @cancellable: optional #GCancellable object, %NULL to ignore
- * @error: a #GError, or %NULL
+ * g_file_load_bytes:
+ * @file: a #GFile
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @etag_out: (out) (allow-none): a location to place the current
+ *     entity tag for the file, or %NULL if the entity tag is not needed
+ * @error: a location for a #GError or %NULL
  *
- * Replaces the contents of @file with @contents of @length bytes.
+ * Loads the contents of @file and returns it as #GBytes.
  *
- * If @etag is specified (not %NULL), any existing file must have that etag,
- * or the error %G_IO_ERROR_WRONG_ETAG will be returned.
+ * If @file is a local file of at least 64 kilobytes, the file is mapped
+ * into memory with #GMappedFile instead of being read, so that no copy
+ * of the data is made and the memory is shared with the page cache.
+ * The kernel is advised that the mapping will be read sequentially and
+ * soon.  Since the data is not copied, replacing the file in place
+ * (rather than atomically, as g_file_replace() does) while the #GBytes
+ * is alive changes its contents, and truncating it can make reading
+ * them crash.
  *
- * If @make_backup is %TRUE, this function will attempt to make a backup
- * of @file.
+ * Other files are read with g_file_load_contents() and the result is
+ * wrapped in a #GBytes without copying.
  *
- * If @cancellable is not %NULL, then the operation can be cancelled by
- * triggering the cancellable object from another thread. If the operation
- * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned.
+ * Returns: (transfer full): a #GBytes or %NULL and @error is set
+ *
+ * Since: 2.40
+ */
+GBytes *
+g_file_load_bytes (GFile         *file,
+                   GCancellable  *cancellable,
+                   gchar        **etag_out,
+                   GError       **error)
+{
+  gchar *contents;
+  gsize len;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (etag_out != NULL)
+    *etag_out = NULL;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return NULL;
+
+#ifdef G_OS_UNIX
+  if (g_file_is_native (file))
+    {
+      GBytes *bytes = NULL;
+      char *path;
+
+      path = g_file_get_path (file);
+      if (path != NULL)
+        bytes = load_bytes_mapped (path, etag_out);
+      g_free (path);
+
+      if (bytes != NULL)
+        return bytes;
+    }
+#endif
+
+  if (!g_file_load_contents (file, cancellable, &contents, &len, etag_out, error))
+    return NULL;
+
+  return g_bytes_new_take (contents, len);
+}
+
+static void
+load_bytes_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
+{
+  GError *error = NULL;
+  gchar *etag = NULL;
+  GBytes *bytes;
+
+  bytes = g_file_load_bytes (source_object, cancellable, &etag, &error);
+
+  if (bytes != NULL)
+    {
+      g_task_set_task_data (task, etag, g_free);
+      g_task_return_pointer (task, bytes, (GDestroyNotify) g_bytes_unref);
+    }
+  else
+    g_task_return_error (task, error);
+}
+
+static void
+load_bytes_contents_cb (GObject      *source_object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  GTask *task = user_data;
+  GError *error = NULL;
+  gchar *contents;
+  gchar *etag;
+  gsize len;
+
+  if (g_file_load_contents_finish (G_FILE (source_object), result, &contents, &len, &etag, &error))
+    {
+      g_task_set_task_data (task, etag, g_free);
+      g_task_return_pointer (task, g_bytes_new_take (contents, len), (GDestroyNotify) g_bytes_unref);
+    }
+  else
+    g_task_return_error (task, error);
+
+  g_object_unref (task);
+}
+
+/**
+ * g_file_load_bytes_async:
+ * @file: a #GFile
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     request is satisfied
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Asynchronously loads the contents of @file as #GBytes.
+ *
+ * Local files are mapped into memory from a worker thread, as
+ * described for g_file_load_bytes(); other files are read with
+ * g_file_load_contents_async().
+ *
+ * @callback should call g_file_load_bytes_finish() to get the result
+ * of this asynchronous operation.
+ *
+ * Since: 2.40
+ */
+void
+g_file_load_bytes_async (GFile               *file,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (file, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_file_load_bytes_async);
+
+  if (g_file_is_native (file))
+    {
+      g_task_run_in_thread (task, load_bytes_thread);
+      g_object_unref (task);
+    }
+  else
+    g_file_load_contents_async (file, cancellable, load_bytes_contents_cb, task);
+}
+
+/**
+ * g_file_load_bytes_finish:
+ * @file: a #GFile
+ * @result: a #GAsyncResult provided to the callback
+ * @etag_out: (out) (allow-none): a location to place the current
+ *     entity tag for the file, or %NULL if the entity tag is not needed
+ * @error: a location for a #GError, or %NULL
+ *
+ * Completes an asynchronous request to g_file_load_bytes_async().
+ *
+ * Returns: (transfer full): a #GBytes or %NULL and @error is set
+ *
+ * Since: 2.40
+ */
+GBytes *
+g_file_load_bytes_finish (GFile         *file,
+                          GAsyncResult  *result,
+                          gchar        **etag_out,
+                          GError       **error)
+{
+  GBytes *bytes;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (g_task_is_valid (result, file), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  bytes = g_task_propagate_pointer (G_TASK (result), error);
+
+  if (etag_out != NULL)
+    *etag_out = bytes ? g_strdup (g_task_get_task_data (G_TASK (result))) : NULL;
+
+  return bytes;
+}
+
+/**
+ * g_file_replace_contents:
+ * @file: input #GFile
+ * @contents: (element-type guint8) (array length=length): a string containing the new contents for @file
+ * @length: the length of @contents in bytes
+ * @etag: (allow-none): the old <link linkend="gfile-etag">entity tag</link>
+ *     for the document, or %NULL
+ * @make_backup: %TRUE if a backup should be created
+ * @flags: a set of #GFileCreateFlags
+ * @new_etag: (allow-none) (out): a location to a new <link linkend="gfile-etag">entity tag</link>
+ *      for the document. This should be freed with g_free() when no longer
+ *      needed, or %NULL
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @error: a #GError, or %NULL
+ *
+ * Replaces the contents of @file with @contents of @length bytes.
+ *
+ * If @etag is specified (not %NULL), any existing file must have that etag,
+ * or the error %G_IO_ERROR_WRONG_ETAG will be returned.
+ *
+ * If @make_backup is %TRUE, this function will attempt to make a backup
+ * of @file.
+ *
+ * If @cancellable is not %NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned.
  *
  * The returned @new_etag can be used to verify that the file hasn't
  * changed the next time it is saved over.
@@ -7179,12 +7818,16 @@ typedef struct {
   gsize pos;
   char *etag;
   gboolean failed;
+  char *old_etag;
+  gboolean make_backup;
+  GFileCreateFlags flags;
 } ReplaceContentsData;
 
 static void
 replace_contents_data_free (ReplaceContentsData *data)
 {
   g_free (data->etag);
+  g_free (data->old_etag);
   g_free (data);
 }
 
@@ -7280,6 +7923,26 @@ replace_contents_open_callback (GObject      *obj,
     }
 }
 
+/* Like load_contents_thread(), do local replaces in one go */
+static void
+replace_contents_thread (GTask        *task,
+                         gpointer      object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  ReplaceContentsData *data = task_data;
+  GError *error = NULL;
+
+  if (!g_file_replace_contents (G_FILE (object),
+                                data->content, data->length,
+                                data->old_etag, data->make_backup,
+                                data->flags, &data->etag,
+                                cancellable, &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
 /**
  * g_file_replace_contents_async:
  * @file: input #GFile
@@ -7331,6 +7994,17 @@ g_file_replace_contents_async  (GFile               *file,
   data->task = g_task_new (file, cancellable, callback, user_data);
   g_task_set_task_data (data->task, data, (GDestroyNotify)replace_contents_data_free);
 
+  if (G_IS_LOCAL_FILE (file))
+    {
+      data->old_etag = g_strdup (etag);
+      data->make_backup = make_backup;
+      data->flags = flags;
+
+      g_task_run_in_thread (data->task, replace_contents_thread);
+      g_object_unref (data->task);
+      return;
+    }
+
   g_file_replace_async (file,
                         etag,
                         make_backup,
@@ -7664,6 +8338,391 @@ g_file_measure_disk_usage_finish (GFile         *file,
   return G_FILE_GET_IFACE (file)->measure_disk_usage_finish (file, result, disk_usage, num_dirs, num_files, error);
 }
 
+#define WALK_TREE_MAX_THREADS 8
+#define WALK_TREE_BATCH_SIZE  100
+
+typedef struct
+{
+  char                *attributes;
+  GFileQueryInfoFlags  flags;
+  gint                 max_depth;
+  GFileWalkTreeFunc    batch_callback;
+  gpointer             batch_data;
+
+  GThreadPool         *pool;
+  GMutex               lock;
+  guint                pending;
+  GError              *error;
+} WalkTreeData;
+
+typedef struct
+{
+  GTask *task;
+  GFile *directory;
+  gint   depth;
+} WalkTreeJob;
+
+typedef struct
+{
+  GTask *task;
+  GFile *directory;
+  GList *infos;
+} WalkTreeBatch;
+
+static void
+walk_tree_data_free (gpointer user_data)
+{
+  WalkTreeData *data = user_data;
+
+  g_assert (data->pool == NULL);
+
+  g_free (data->attributes);
+  g_mutex_clear (&data->lock);
+  g_clear_error (&data->error);
+  g_free (data);
+}
+
+/* Results are always handed to the task's context via a real idle
+ * source: g_main_context_invoke() would run the callback right here in
+ * the worker if it managed to acquire the context, and we need the
+ * callbacks to be dispatched in the order that they were queued.
+ */
+static void
+walk_tree_post (GTask          *task,
+                GSourceFunc     func,
+                gpointer        user_data,
+                GDestroyNotify  notify)
+{
+  GSource *source;
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, g_task_get_priority (task));
+  g_source_set_callback (source, func, user_data, notify);
+  g_source_attach (source, g_task_get_context (task));
+  g_source_unref (source);
+}
+
+static gboolean
+walk_tree_deliver_batch (gpointer user_data)
+{
+  WalkTreeBatch *batch = user_data;
+  WalkTreeData *data;
+
+  data = g_task_get_task_data (batch->task);
+
+  if (!g_cancellable_is_cancelled (g_task_get_cancellable (batch->task)))
+    (* data->batch_callback) (batch->directory, batch->infos, data->batch_data);
+
+  return FALSE;
+}
+
+static void
+walk_tree_batch_free (gpointer user_data)
+{
+  WalkTreeBatch *batch = user_data;
+
+  g_list_free_full (batch->infos, g_object_unref);
+  g_object_unref (batch->directory);
+  g_object_unref (batch->task);
+  g_free (batch);
+}
+
+static gboolean
+walk_tree_complete (gpointer user_data)
+{
+  GTask *task = user_data;
+  WalkTreeData *data;
+
+  data = g_task_get_task_data (task);
+
+  /* Every job has finished by now; this only waits for the thread
+   * that queued us to return to the pool.
+   */
+  g_thread_pool_free (data->pool, FALSE, TRUE);
+  data->pool = NULL;
+
+  if (data->error)
+    {
+      g_task_return_error (task, data->error);
+      data->error = NULL;
+    }
+  else if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, TRUE);
+
+  return FALSE;
+}
+
+static void
+walk_tree_push (GTask *task,
+                GFile *directory,
+                gint   depth)
+{
+  WalkTreeData *data;
+  WalkTreeJob *job;
+
+  data = g_task_get_task_data (task);
+
+  job = g_new (WalkTreeJob, 1);
+  job->task = g_object_ref (task);
+  job->directory = directory;
+  job->depth = depth;
+
+  g_mutex_lock (&data->lock);
+  data->pending++;
+  g_mutex_unlock (&data->lock);
+
+  g_thread_pool_push (data->pool, job, NULL);
+}
+
+/* Queues the batch of infos found so far in @directory, and only then
+ * the subdirectories among them, so that a directory always shows up
+ * in a batch before its own contents do.
+ */
+static void
+walk_tree_flush (GTask  *task,
+                 GFile  *directory,
+                 gint    depth,
+                 GList **infos,
+                 GList **children)
+{
+  WalkTreeData *data;
+  GList *l;
+
+  data = g_task_get_task_data (task);
+
+  if (*infos)
+    {
+      if (data->batch_callback)
+        {
+          WalkTreeBatch *batch;
+
+          batch = g_new (WalkTreeBatch, 1);
+          batch->task = g_object_ref (task);
+          batch->directory = g_object_ref (directory);
+          batch->infos = g_list_reverse (*infos);
+
+          walk_tree_post (task, walk_tree_deliver_batch, batch, walk_tree_batch_free);
+        }
+      else
+        g_list_free_full (*infos, g_object_unref);
+
+      *infos = NULL;
+    }
+
+  *children = g_list_reverse (*children);
+  for (l = *children; l; l = l->next)
+    walk_tree_push (task, l->data, depth + 1);
+  g_list_free (*children);
+  *children = NULL;
+}
+
+static void
+walk_tree_directory (GTask        *task,
+                     WalkTreeData *data,
+                     GFile        *directory,
+                     gint          depth,
+                     GCancellable *cancellable)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GList *infos = NULL;
+  GList *children = NULL;
+  guint n_infos = 0;
+  GError *error = NULL;
+
+  enumerator = g_file_enumerate_children (directory, data->attributes, data->flags,
+                                          cancellable, &error);
+
+  if (enumerator != NULL)
+    {
+      while ((info = g_file_enumerator_next_file (enumerator, cancellable, &error)) != NULL)
+        {
+          /* Never descend through symlinks, even when following them
+           * for the infos: that is how you end up walking in circles.
+           */
+          if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY &&
+              !g_file_info_get_is_symlink (info) &&
+              (data->max_depth < 0 || depth < data->max_depth))
+            children = g_list_prepend (children, g_file_enumerator_get_child (enumerator, info));
+
+          infos = g_list_prepend (infos, info);
+
+          if (++n_infos == WALK_TREE_BATCH_SIZE)
+            {
+              walk_tree_flush (task, directory, depth, &infos, &children);
+              n_infos = 0;
+            }
+        }
+
+      walk_tree_flush (task, directory, depth, &infos, &children);
+
+      g_file_enumerator_close (enumerator, NULL, NULL);
+      g_object_unref (enumerator);
+    }
+
+  if (error != NULL)
+    {
+      /* As with g_file_measure_disk_usage(), only errors on the
+       * toplevel directory are reported.
+       */
+      g_mutex_lock (&data->lock);
+      if (depth == 0 && data->error == NULL)
+        {
+          data->error = error;
+          error = NULL;
+        }
+      g_mutex_unlock (&data->lock);
+
+      g_clear_error (&error);
+    }
+}
+
+static void
+walk_tree_thread (gpointer job_data,
+                  gpointer pool_data)
+{
+  WalkTreeJob *job = job_data;
+  WalkTreeData *data;
+  GCancellable *cancellable;
+  gboolean last;
+
+  data = g_task_get_task_data (job->task);
+  cancellable = g_task_get_cancellable (job->task);
+
+  if (!g_cancellable_is_cancelled (cancellable))
+    walk_tree_directory (job->task, data, job->directory, job->depth, cancellable);
+
+  g_mutex_lock (&data->lock);
+  last = --data->pending == 0;
+  g_mutex_unlock (&data->lock);
+
+  /* Queued behind every batch, since those were all queued by jobs
+   * that have finished by now.
+   */
+  if (last)
+    walk_tree_post (job->task, walk_tree_complete, g_object_ref (job->task), g_object_unref);
+
+  g_object_unref (job->directory);
+  g_object_unref (job->task);
+  g_free (job);
+}
+
+/**
+ * g_file_walk_tree_async:
+ * @file: a #GFile for a directory
+ * @attributes: (allow-none): an attribute query string, or %NULL
+ * @flags: a set of #GFileQueryInfoFlags
+ * @max_depth: the number of levels of subdirectories to descend into,
+ *     or -1 for no limit
+ * @io_priority: the <link linkend="io-priority">I/O priority</link>
+ *     of the request
+ * @cancellable: (allow-none): optional #GCancellable object,
+ *     %NULL to ignore
+ * @batch_callback: (allow-none) (scope call): a #GFileWalkTreeFunc
+ *     to receive the results, or %NULL
+ * @batch_data: (closure batch_callback): user data for @batch_callback
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     walk is complete
+ * @user_data: (closure callback): the data to pass to callback function
+ *
+ * Recursively enumerates the contents of the directory @file.
+ *
+ * Unlike enumerating each directory in turn with
+ * g_file_enumerate_children_async(), several subdirectories are read
+ * at the same time, by a small pool of worker threads.  The #GFileInfo
+ * objects found are passed in batches to @batch_callback, which is
+ * invoked in the <link linkend="g-main-context-push-thread-default">thread-default
+ * main context</link> of the thread you are calling this method from.
+ * The batches of different directories can arrive interleaved, but a
+ * directory is always listed in a batch before any batch of its own
+ * contents.
+ *
+ * The infos contain the attributes requested in @attributes (see
+ * g_file_enumerate_children()), as well as #G_FILE_ATTRIBUTE_STANDARD_NAME,
+ * #G_FILE_ATTRIBUTE_STANDARD_TYPE and #G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK,
+ * which are needed for the walk itself.
+ *
+ * If @max_depth is 0 only the immediate children of @file are listed,
+ * if it is 1 the contents of its subdirectories are listed as well,
+ * and so on.  Symbolic links to directories are never followed, but
+ * @flags decides whether they are reported as links or as the
+ * directories they point to.
+ *
+ * Errors are only reported against @file itself; subdirectories that
+ * cannot be read are silently skipped.  If @cancellable is cancelled,
+ * no further batches are delivered and the operation fails with
+ * %G_IO_ERROR_CANCELLED.
+ *
+ * When all the batches have been delivered, @callback will be called.
+ * You can then call g_file_walk_tree_finish() to get the result of the
+ * operation.
+ *
+ * Since: 2.40
+ */
+void
+g_file_walk_tree_async (GFile               *file,
+                        const char          *attributes,
+                        GFileQueryInfoFlags  flags,
+                        gint                 max_depth,
+                        gint                 io_priority,
+                        GCancellable        *cancellable,
+                        GFileWalkTreeFunc    batch_callback,
+                        gpointer             batch_data,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+  WalkTreeData *data;
+  GTask *task;
+
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  data = g_new0 (WalkTreeData, 1);
+  data->attributes = g_strconcat (G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                  G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK,
+                                  attributes && *attributes ? "," : NULL,
+                                  attributes, NULL);
+  data->flags = flags;
+  data->max_depth = max_depth;
+  data->batch_callback = batch_callback;
+  data->batch_data = batch_data;
+  g_mutex_init (&data->lock);
+  data->pool = g_thread_pool_new (walk_tree_thread, NULL, WALK_TREE_MAX_THREADS, FALSE, NULL);
+
+  task = g_task_new (file, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_file_walk_tree_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_task_data (task, data, walk_tree_data_free);
+
+  walk_tree_push (task, g_object_ref (file), 0);
+  g_object_unref (task);
+}
+
+/**
+ * g_file_walk_tree_finish:
+ * @file: input #GFile
+ * @result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Finishes a tree walk started with g_file_walk_tree_async().
+ *
+ * Returns: %TRUE if the walk completed, %FALSE on error or
+ *     cancellation, with @error set
+ *
+ * Since: 2.40
+ */
+gboolean
+g_file_walk_tree_finish (GFile         *file,
+                         GAsyncResult  *result,
+                         GError       **error)
+{
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, file), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * g_file_start_mountable:
  * @file: input #GFile
@@ -789,6 +789,18 @@ GLIB_AVAILABLE_IN_ALL
 GFileInfo *             g_file_query_info_finish          (GFile                      *file,
 							   GAsyncResult               *res,
 							   GError                    **error);
+GLIB_AVAILABLE_IN_2_40
+void                    g_file_query_info_many_async      (GFile                     **files,
+							   guint                       n_files,
+							   const char                 *attributes,
+							   GFileQueryInfoFlags         flags,
+							   int                         io_priority,
+							   GCancellable               *cancellable,
+							   GAsyncReadyCallback         callback,
+							   gpointer                    user_data);
+GLIB_AVAILABLE_IN_2_40
+GPtrArray *             g_file_query_info_many_finish     (GAsyncResult               *res,
+							   GError                    **error);
 GLIB_AVAILABLE_IN_ALL
 GFileInfo *             g_file_query_filesystem_info      (GFile                      *file,
 							   const char                 *attributes,
@@ -1138,6 +1150,23 @@ gboolean                g_file_measure_disk_usage_finish  (GFile
                                                            guint64                       *num_files,
                                                            GError                       **error);
 
+GLIB_AVAILABLE_IN_2_40
+void                    g_file_walk_tree_async            (GFile                         *file,
+                                                           const char                    *attributes,
+                                                           GFileQueryInfoFlags            flags,
+                                                           gint                           max_depth,
+                                                           gint                           io_priority,
+                                                           GCancellable                  *cancellable,
+                                                           GFileWalkTreeFunc              batch_callback,
+                                                           gpointer                       batch_data,
+                                                           GAsyncReadyCallback            callback,
+                                                           gpointer                       user_data);
+
+GLIB_AVAILABLE_IN_2_40
+gboolean                g_file_walk_tree_finish           (GFile                         *file,
+                                                           GAsyncResult                  *result,
+                                                           GError                       **error);
+
 GLIB_AVAILABLE_IN_ALL
 void                    g_file_start_mountable            (GFile                      *file,
 							   GDriveStartFlags            flags,
@@ -1209,6 +1238,21 @@ gboolean g_file_load_partial_contents_finish (GFile                  *file,
 					      gsize                  *length,
 					      char                  **etag_out,
 					      GError                **error);
+GLIB_AVAILABLE_IN_2_40
+GBytes * g_file_load_bytes                   (GFile                  *file,
+					      GCancellable           *cancellable,
+					      gchar                 **etag_out,
+					      GError                **error);
+GLIB_AVAILABLE_IN_2_40
+void     g_file_load_bytes_async             (GFile                  *file,
+					      GCancellable           *cancellable,
+					      GAsyncReadyCallback     callback,
+					      gpointer                user_data);
+GLIB_AVAILABLE_IN_2_40
+GBytes * g_file_load_bytes_finish            (GFile                  *file,
+					      GAsyncResult           *result,
+					      gchar                 **etag_out,
+					      GError                **error);
 GLIB_AVAILABLE_IN_ALL
 gboolean g_file_replace_contents             (GFile                  *file,
 					      const char             *contents,
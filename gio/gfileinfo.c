@@ -71,11 +71,22 @@ typedef struct  {
   GFileAttributeValue value;
 } GFileAttribute;
 
+/* The attribute values of a GFileInfo.  g_file_info_dup() and
+ * g_file_info_copy_into() share this between infos instead of copying
+ * it; an info makes its own copy the first time it is modified while
+ * shared (see g_file_info_make_writable()).
+ */
+typedef struct {
+  volatile gint ref_count;
+  GArray *attributes;
+} AttributeStore;
+
 struct _GFileInfo
 {
   GObject parent_instance;
 
-  GArray *attributes;
+  AttributeStore *store;
+  GSList *retired_stores;
   GFileAttributeMatcher *mask;
 };
 
@@ -92,7 +103,9 @@ typedef struct {
   guint32 attribute_id_counter;
 } NSInfo;
 
-G_LOCK_DEFINE_STATIC (attribute_hash);
+/* Attributes are registered rarely but looked up all the time, from
+ * any thread, so lookups only take the lock for reading. */
+static GRWLock attribute_hash_lock;
 static int namespace_id_counter = 0;
 static GHashTable *ns_hash = NULL;
 static GHashTable *attribute_hash = NULL;
@@ -120,6 +133,30 @@ static char ***attributes = NULL;
     ( ((((guint32) _ns) & NS_MASK) << NS_POS) |		\
       ((((guint32) _id) & ID_MASK) << ID_POS) )
 
+/* The attributes registered in ensure_attribute_hash() also get a
+ * dense index, so that matchers can keep a bitmask of them.  These
+ * tables are filled in once, before any matcher can exist.
+ */
+#define BUILTIN_MAX_NAMESPACES 32
+#define BUILTIN_MAX_ATTRIBUTES 128
+
+static guint builtin_ns_keys[BUILTIN_MAX_NAMESPACES];
+static guint builtin_ns_offset[BUILTIN_MAX_NAMESPACES];
+
+static inline gint
+builtin_attribute_bit (guint32 attr_id)
+{
+  guint32 ns, key;
+
+  ns = GET_NS (attr_id);
+  key = GET_ID (attr_id);
+
+  if (ns >= BUILTIN_MAX_NAMESPACES || key == 0 || key > builtin_ns_keys[ns])
+    return -1;
+
+  return builtin_ns_offset[ns] + key - 1;
+}
+
 static NSInfo *
 _lookup_namespace (const char *namespace)
 {
@@ -174,6 +211,8 @@ _lookup_attribute (const char *attribute)
 static void
 ensure_attribute_hash (void)
 {
+  guint ns, n_builtin;
+
   if (attribute_hash != NULL)
     return;
 
@@ -184,6 +223,8 @@ ensure_attribute_hash (void)
   guint _u = _lookup_attribute (G_FILE_ATTRIBUTE_ ## name); \
   /* use for generating the ID: g_print ("#define G_FILE_ATTRIBUTE_ID_%s (%u + %u)\n", #name + 17, _u & ~ID_MASK, _u & ID_MASK); */ \
   g_assert (_u == G_FILE_ATTRIBUTE_ID_ ## name); \
+  g_assert (GET_NS (_u) < BUILTIN_MAX_NAMESPACES); \
+  builtin_ns_keys[GET_NS (_u)] = GET_ID (_u); \
 }G_STMT_END
 
   REGISTER_ATTRIBUTE (STANDARD_TYPE);
@@ -265,6 +306,14 @@ ensure_attribute_hash (void)
   REGISTER_ATTRIBUTE (TRASH_DELETION_DATE);
 
 #undef REGISTER_ATTRIBUTE
+
+  n_builtin = 0;
+  for (ns = 0; ns < BUILTIN_MAX_NAMESPACES; ns++)
+    {
+      builtin_ns_offset[ns] = n_builtin;
+      n_builtin += builtin_ns_keys[ns];
+    }
+  g_assert (n_builtin <= BUILTIN_MAX_ATTRIBUTES);
 }
 
 static guint32
@@ -273,7 +322,14 @@ lookup_namespace (const char *namespace)
   NSInfo *ns_info;
   guint32 id;
 
-  G_LOCK (attribute_hash);
+  g_rw_lock_reader_lock (&attribute_hash_lock);
+  ns_info = ns_hash ? g_hash_table_lookup (ns_hash, namespace) : NULL;
+  g_rw_lock_reader_unlock (&attribute_hash_lock);
+
+  if (ns_info)
+    return ns_info->id;
+
+  g_rw_lock_writer_lock (&attribute_hash_lock);
 
   ensure_attribute_hash ();
 
@@ -282,7 +338,7 @@ lookup_namespace (const char *namespace)
   if (ns_info)
     id = ns_info->id;
 
-  G_UNLOCK (attribute_hash);
+  g_rw_lock_writer_unlock (&attribute_hash_lock);
 
   return id;
 }
@@ -291,9 +347,9 @@ static char *
 get_attribute_for_id (int attribute)
 {
   char *s;
-  G_LOCK (attribute_hash);
+  g_rw_lock_reader_lock (&attribute_hash_lock);
   s = attributes[GET_NS(attribute)][GET_ID(attribute)];
-  G_UNLOCK (attribute_hash);
+  g_rw_lock_reader_unlock (&attribute_hash_lock);
   return s;
 }
 
@@ -302,29 +358,112 @@ lookup_attribute (const char *attribute)
 {
   guint32 attr_id;
 
-  G_LOCK (attribute_hash);
+  g_rw_lock_reader_lock (&attribute_hash_lock);
+  attr_id = attribute_hash ? GPOINTER_TO_UINT (g_hash_table_lookup (attribute_hash, attribute)) : 0;
+  g_rw_lock_reader_unlock (&attribute_hash_lock);
+
+  if (attr_id != 0)
+    return attr_id;
+
+  g_rw_lock_writer_lock (&attribute_hash_lock);
   ensure_attribute_hash ();
 
   attr_id = _lookup_attribute (attribute);
 
-  G_UNLOCK (attribute_hash);
+  g_rw_lock_writer_unlock (&attribute_hash_lock);
 
   return attr_id;
 }
 
+static AttributeStore *
+attribute_store_new (guint reserved_size)
+{
+  AttributeStore *store;
+
+  store = g_slice_new (AttributeStore);
+  store->ref_count = 1;
+  store->attributes = g_array_sized_new (FALSE, FALSE,
+                                         sizeof (GFileAttribute),
+                                         reserved_size);
+
+  return store;
+}
+
+static AttributeStore *
+attribute_store_ref (AttributeStore *store)
+{
+  g_atomic_int_inc (&store->ref_count);
+
+  return store;
+}
+
+static void
+attribute_store_unref (AttributeStore *store)
+{
+  GFileAttribute *attrs;
+  int i;
+
+  if (!g_atomic_int_dec_and_test (&store->ref_count))
+    return;
+
+  attrs = (GFileAttribute *)store->attributes->data;
+  for (i = 0; i < store->attributes->len; i++)
+    _g_file_attribute_value_clear (&attrs[i].value);
+  g_array_free (store->attributes, TRUE);
+
+  g_slice_free (AttributeStore, store);
+}
+
+static AttributeStore *
+attribute_store_copy (AttributeStore *src)
+{
+  AttributeStore *store;
+  GFileAttribute *source, *dest;
+  int i;
+
+  store = attribute_store_new (src->attributes->len);
+  g_array_set_size (store->attributes, src->attributes->len);
+
+  source = (GFileAttribute *)src->attributes->data;
+  dest = (GFileAttribute *)store->attributes->data;
+
+  for (i = 0; i < src->attributes->len; i++)
+    {
+      dest[i].attribute = source[i].attribute;
+      dest[i].value.type = G_FILE_ATTRIBUTE_TYPE_INVALID;
+      _g_file_attribute_value_set (&dest[i].value, &source[i].value);
+    }
+
+  return store;
+}
+
+/* Must be called before modifying info->store in any way.
+ *
+ * If the store is shared with other infos, this gives @info its own
+ * copy.  The shared store is kept alive until @info is finalized, so
+ * that pointers handed out by getters before the copy stay valid for
+ * as long as they did when g_file_info_dup() copied everything up
+ * front.
+ */
+static inline void
+g_file_info_make_writable (GFileInfo *info)
+{
+  if (g_atomic_int_get (&info->store->ref_count) > 1)
+    {
+      info->retired_stores = g_slist_prepend (info->retired_stores, info->store);
+      info->store = attribute_store_copy (info->store);
+    }
+}
+
 static void
 g_file_info_finalize (GObject *object)
 {
   GFileInfo *info;
-  int i;
-  GFileAttribute *attrs;
 
   info = G_FILE_INFO (object);
 
-  attrs = (GFileAttribute *)info->attributes->data;
-  for (i = 0; i < info->attributes->len; i++)
-    _g_file_attribute_value_clear (&attrs[i].value);
-  g_array_free (info->attributes, TRUE);
+  attribute_store_unref (info->store);
+  g_slist_free_full (info->retired_stores, (GDestroyNotify) attribute_store_unref);
 
   if (info->mask != NO_ATTRIBUTE_MASK)
     g_file_attribute_matcher_unref (info->mask);
@@ -338,14 +477,19 @@ g_file_info_class_init (GFileInfoClass *klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->finalize = g_file_info_finalize;
+
+  /* The getters and setters use the precomputed G_FILE_ATTRIBUTE_ID_*
+   * values directly, so make sure their names are registered. */
+  g_rw_lock_writer_lock (&attribute_hash_lock);
+  ensure_attribute_hash ();
+  g_rw_lock_writer_unlock (&attribute_hash_lock);
 }
 
 static void
 g_file_info_init (GFileInfo *info)
 {
   info->mask = NO_ATTRIBUTE_MASK;
-  info->attributes = g_array_new (FALSE, FALSE,
-				  sizeof (GFileAttribute));
+  info->store = attribute_store_new (0);
 }
 
 /**
@@ -368,33 +512,22 @@ g_file_info_new (void)
  *
  * Copies all of the <link linkend="gio-GFileAttribute">GFileAttribute</link>s
  * from @src_info to @dest_info.
+ *
+ * This is cheap: the attribute values are shared between the two
+ * infos, and only copied when one of them is modified.
  **/
 void
 g_file_info_copy_into (GFileInfo *src_info,
                        GFileInfo *dest_info)
 {
-  GFileAttribute *source, *dest;
-  int i;
+  AttributeStore *old_store;
 
   g_return_if_fail (G_IS_FILE_INFO (src_info));
   g_return_if_fail (G_IS_FILE_INFO (dest_info));
 
-  dest = (GFileAttribute *)dest_info->attributes->data;
-  for (i = 0; i < dest_info->attributes->len; i++)
-    _g_file_attribute_value_clear (&dest[i].value);
-
-  g_array_set_size (dest_info->attributes,
-		    src_info->attributes->len);
-
-  source = (GFileAttribute *)src_info->attributes->data;
-  dest = (GFileAttribute *)dest_info->attributes->data;
-
-  for (i = 0; i < src_info->attributes->len; i++)
-    {
-      dest[i].attribute = source[i].attribute;
-      dest[i].value.type = G_FILE_ATTRIBUTE_TYPE_INVALID;
-      _g_file_attribute_value_set (&dest[i].value, &source[i].value);
-    }
+  old_store = dest_info->store;
+  dest_info->store = attribute_store_ref (src_info->store);
+  attribute_store_unref (old_store);
 
   if (dest_info->mask != NO_ATTRIBUTE_MASK)
     g_file_attribute_matcher_unref (dest_info->mask);
@@ -411,6 +544,11 @@ g_file_info_copy_into (GFileInfo *src_info,
  *
  * Duplicates a file info structure.
  *
+ * The attribute values are not copied until either @other or the
+ * duplicate is modified, so this is cheap.  Values returned by the
+ * getters of either info stay valid until that attribute is modified
+ * or the info is finalized, as if everything had been copied up front.
+ *
  * Returns: (transfer full): a duplicate #GFileInfo of @other.
  **/
 GFileInfo *
@@ -448,14 +586,16 @@ g_file_info_set_attribute_mask (GFileInfo             *info,
       info->mask = g_file_attribute_matcher_ref (mask);
 
       /* Remove non-matching attributes */
-      for (i = 0; i < info->attributes->len; i++)
+      for (i = 0; i < info->store->attributes->len; i++)
 	{
-	  attr = &g_array_index (info->attributes, GFileAttribute, i);
+	  attr = &g_array_index (info->store->attributes, GFileAttribute, i);
 	  if (!_g_file_attribute_matcher_matches_id (mask,
 						    attr->attribute))
 	    {
+	      g_file_info_make_writable (info);
+	      attr = &g_array_index (info->store->attributes, GFileAttribute, i);
 	      _g_file_attribute_value_clear (&attr->value);
-	      g_array_remove_index (info->attributes, i);
+	      g_array_remove_index (info->store->attributes, i);
 	      i--;
 	    }
 	}
@@ -493,8 +633,10 @@ g_file_info_clear_status (GFileInfo  *info)
 
   g_return_if_fail (G_IS_FILE_INFO (info));
 
-  attrs = (GFileAttribute *)info->attributes->data;
-  for (i = 0; i < info->attributes->len; i++)
+  g_file_info_make_writable (info);
+
+  attrs = (GFileAttribute *)info->store->attributes->data;
+  for (i = 0; i < info->store->attributes->len; i++)
     attrs[i].value.status = G_FILE_ATTRIBUTE_STATUS_UNSET;
 }
 
@@ -508,9 +650,13 @@ g_file_info_find_place (GFileInfo  *info,
      in the array */
 
   min = 0;
-  max = info->attributes->len;
+  max = info->store->attributes->len;
 
-  attrs = (GFileAttribute *)info->attributes->data;
+  attrs = (GFileAttribute *)info->store->attributes->data;
+
+  /* Attributes are mostly added in id order, make appending cheap */
+  if (max > 0 && attrs[max - 1].attribute < attribute)
+    return max;
 
   while (min < max)
     {
@@ -537,8 +683,8 @@ g_file_info_find_value (GFileInfo *info,
   int i;
 
   i = g_file_info_find_place (info, attr_id);
-  attrs = (GFileAttribute *)info->attributes->data;
-  if (i < info->attributes->len &&
+  attrs = (GFileAttribute *)info->store->attributes->data;
+  if (i < info->store->attributes->len &&
       attrs[i].attribute == attr_id)
     return &attrs[i].value;
 
@@ -604,8 +750,8 @@ g_file_info_has_namespace (GFileInfo  *info,
 
   ns_id = lookup_namespace (name_space);
 
-  attrs = (GFileAttribute *)info->attributes->data;
-  for (i = 0; i < info->attributes->len; i++)
+  attrs = (GFileAttribute *)info->store->attributes->data;
+  for (i = 0; i < info->store->attributes->len; i++)
     {
       if (GET_NS (attrs[i].attribute) == ns_id)
 	return TRUE;
@@ -638,8 +784,8 @@ g_file_info_list_attributes (GFileInfo  *info,
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
   names = g_ptr_array_new ();
-  attrs = (GFileAttribute *)info->attributes->data;
-  for (i = 0; i < info->attributes->len; i++)
+  attrs = (GFileAttribute *)info->store->attributes->data;
+  for (i = 0; i < info->store->attributes->len; i++)
     {
       attribute = attrs[i].attribute;
       if (ns_id == 0 || GET_NS (attribute) == ns_id)
@@ -699,12 +845,14 @@ g_file_info_remove_attribute (GFileInfo  *info,
   attr_id = lookup_attribute (attribute);
 
   i = g_file_info_find_place (info, attr_id);
-  attrs = (GFileAttribute *)info->attributes->data;
-  if (i < info->attributes->len &&
+  attrs = (GFileAttribute *)info->store->attributes->data;
+  if (i < info->store->attributes->len &&
       attrs[i].attribute == attr_id)
     {
+      g_file_info_make_writable (info);
+      attrs = (GFileAttribute *)info->store->attributes->data;
       _g_file_attribute_value_clear (&attrs[i].value);
-      g_array_remove_index (info->attributes, i);
+      g_array_remove_index (info->store->attributes, i);
     }
 }
 
@@ -803,6 +951,8 @@ g_file_info_set_attribute_status (GFileInfo  *info,
   val = g_file_info_find_value_by_name (info, attribute);
   if (val)
     {
+      g_file_info_make_writable (info);
+      val = g_file_info_find_value_by_name (info, attribute);
       val->status = status;
       return TRUE;
     }
@@ -818,6 +968,9 @@ _g_file_info_get_attribute_value (GFileInfo  *info,
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   g_return_val_if_fail (attribute != NULL && *attribute != '\0', NULL);
 
+  /* callers use this to update the status of the value */
+  g_file_info_make_writable (info);
+
   return g_file_info_find_value_by_name (info, attribute);
 }
 
@@ -1073,19 +1226,21 @@ g_file_info_create_value (GFileInfo *info,
       !_g_file_attribute_matcher_matches_id (info->mask, attr_id))
     return NULL;
 
+  g_file_info_make_writable (info);
+
   i = g_file_info_find_place (info, attr_id);
 
-  attrs = (GFileAttribute *)info->attributes->data;
-  if (i < info->attributes->len &&
+  attrs = (GFileAttribute *)info->store->attributes->data;
+  if (i < info->store->attributes->len &&
       attrs[i].attribute == attr_id)
     return &attrs[i].value;
   else
     {
       GFileAttribute attr = { 0 };
       attr.attribute = attr_id;
-      g_array_insert_val (info->attributes, i, attr);
+      g_array_insert_val (info->store->attributes, i, attr);
 
-      attrs = (GFileAttribute *)info->attributes->data;
+      attrs = (GFileAttribute *)info->store->attributes->data;
       return &attrs[i].value;
     }
 }
@@ -1455,17 +1610,13 @@ g_file_info_set_attribute_int64  (GFileInfo  *info,
 GDateTime *
 g_file_info_get_deletion_date (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   const char *date_str;
   GTimeVal tv;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_TRASH_DELETION_DATE);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_TRASH_DELETION_DATE);
   date_str = _g_file_attribute_value_get_string (value);
   if (!date_str)
     return NULL;
@@ -1488,15 +1639,11 @@ g_file_info_get_deletion_date (GFileInfo *info)
 GFileType
 g_file_info_get_file_type (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), G_FILE_TYPE_UNKNOWN);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_TYPE);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_TYPE);
   return (GFileType)_g_file_attribute_value_get_uint32 (value);
 }
 
@@ -1511,15 +1658,11 @@ g_file_info_get_file_type (GFileInfo *info)
 gboolean
 g_file_info_get_is_hidden (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_IS_HIDDEN);
   return (GFileType)_g_file_attribute_value_get_boolean (value);
 }
 
@@ -1534,15 +1677,11 @@ g_file_info_get_is_hidden (GFileInfo *info)
 gboolean
 g_file_info_get_is_backup (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_IS_BACKUP);
   return (GFileType)_g_file_attribute_value_get_boolean (value);
 }
 
@@ -1557,15 +1696,11 @@ g_file_info_get_is_backup (GFileInfo *info)
 gboolean
 g_file_info_get_is_symlink (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_IS_SYMLINK);
   return (GFileType)_g_file_attribute_value_get_boolean (value);
 }
 
@@ -1580,15 +1715,11 @@ g_file_info_get_is_symlink (GFileInfo *info)
 const char *
 g_file_info_get_name (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_NAME);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_NAME);
   return _g_file_attribute_value_get_byte_string (value);
 }
 
@@ -1603,15 +1734,11 @@ g_file_info_get_name (GFileInfo *info)
 const char *
 g_file_info_get_display_name (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_DISPLAY_NAME);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1626,15 +1753,11 @@ g_file_info_get_display_name (GFileInfo *info)
 const char *
 g_file_info_get_edit_name (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_EDIT_NAME);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_EDIT_NAME);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1649,16 +1772,12 @@ g_file_info_get_edit_name (GFileInfo *info)
 GIcon *
 g_file_info_get_icon (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   GObject *obj;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_ICON);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_ICON);
   obj = _g_file_attribute_value_get_object (value);
   if (G_IS_ICON (obj))
     return G_ICON (obj);
@@ -1678,16 +1797,12 @@ g_file_info_get_icon (GFileInfo *info)
 GIcon *
 g_file_info_get_symbolic_icon (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   GObject *obj;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SYMBOLIC_ICON);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SYMBOLIC_ICON);
   obj = _g_file_attribute_value_get_object (value);
   if (G_IS_ICON (obj))
     return G_ICON (obj);
@@ -1705,15 +1820,11 @@ g_file_info_get_symbolic_icon (GFileInfo *info)
 const char *
 g_file_info_get_content_type (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_CONTENT_TYPE);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1728,15 +1839,11 @@ g_file_info_get_content_type (GFileInfo *info)
 goffset
 g_file_info_get_size (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), (goffset) 0);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SIZE);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SIZE);
   return (goffset) _g_file_attribute_value_get_uint64 (value);
 }
 
@@ -1752,21 +1859,14 @@ void
 g_file_info_get_modification_time (GFileInfo *info,
 				   GTimeVal  *result)
 {
-  static guint32 attr_mtime = 0, attr_mtime_usec;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (result != NULL);
 
-  if (attr_mtime == 0)
-    {
-      attr_mtime = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED);
-      attr_mtime_usec = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
-    }
-
-  value = g_file_info_find_value (info, attr_mtime);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_TIME_MODIFIED);
   result->tv_sec = _g_file_attribute_value_get_uint64 (value);
-  value = g_file_info_find_value (info, attr_mtime_usec);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_TIME_MODIFIED_USEC);
   result->tv_usec = _g_file_attribute_value_get_uint32 (value);
 }
 
@@ -1781,15 +1881,11 @@ g_file_info_get_modification_time (GFileInfo *info,
 const char *
 g_file_info_get_symlink_target (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SYMLINK_TARGET);
   return _g_file_attribute_value_get_byte_string (value);
 }
 
@@ -1805,15 +1901,11 @@ g_file_info_get_symlink_target (GFileInfo *info)
 const char *
 g_file_info_get_etag (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_ETAG_VALUE);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_ETAG_VALUE);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1829,15 +1921,11 @@ g_file_info_get_etag (GFileInfo *info)
 gint32
 g_file_info_get_sort_order (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), 0);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SORT_ORDER);
-
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SORT_ORDER);
   return _g_file_attribute_value_get_int32 (value);
 }
 
@@ -1854,15 +1942,11 @@ void
 g_file_info_set_file_type (GFileInfo *info,
 			   GFileType  type)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_TYPE);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_TYPE);
   if (value)
     _g_file_attribute_value_set_uint32 (value, type);
 }
@@ -1879,15 +1963,11 @@ void
 g_file_info_set_is_hidden (GFileInfo *info,
 			   gboolean   is_hidden)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_IS_HIDDEN);
   if (value)
     _g_file_attribute_value_set_boolean (value, is_hidden);
 }
@@ -1904,15 +1984,11 @@ void
 g_file_info_set_is_symlink (GFileInfo *info,
 			    gboolean   is_symlink)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_IS_SYMLINK);
   if (value)
     _g_file_attribute_value_set_boolean (value, is_symlink);
 }
@@ -1929,16 +2005,12 @@ void
 g_file_info_set_name (GFileInfo  *info,
 		      const char *name)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (name != NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_NAME);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_NAME);
   if (value)
     _g_file_attribute_value_set_byte_string (value, name);
 }
@@ -1955,16 +2027,12 @@ void
 g_file_info_set_display_name (GFileInfo  *info,
 			      const char *display_name)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (display_name != NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_DISPLAY_NAME);
   if (value)
     _g_file_attribute_value_set_string (value, display_name);
 }
@@ -1981,16 +2049,12 @@ void
 g_file_info_set_edit_name (GFileInfo  *info,
 			   const char *edit_name)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (edit_name != NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_EDIT_NAME);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_EDIT_NAME);
   if (value)
     _g_file_attribute_value_set_string (value, edit_name);
 }
@@ -2007,16 +2071,12 @@ void
 g_file_info_set_icon (GFileInfo *info,
 		      GIcon     *icon)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (G_IS_ICON (icon));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_ICON);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_ICON);
   if (value)
     _g_file_attribute_value_set_object (value, G_OBJECT (icon));
 }
@@ -2035,16 +2095,12 @@ void
 g_file_info_set_symbolic_icon (GFileInfo *info,
                                GIcon     *icon)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (G_IS_ICON (icon));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SYMBOLIC_ICON);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SYMBOLIC_ICON);
   if (value)
     _g_file_attribute_value_set_object (value, G_OBJECT (icon));
 }
@@ -2061,16 +2117,12 @@ void
 g_file_info_set_content_type (GFileInfo  *info,
 			      const char *content_type)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (content_type != NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_CONTENT_TYPE);
   if (value)
     _g_file_attribute_value_set_string (value, content_type);
 }
@@ -2087,15 +2139,11 @@ void
 g_file_info_set_size (GFileInfo *info,
 		      goffset    size)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SIZE);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SIZE);
   if (value)
     _g_file_attribute_value_set_uint64 (value, size);
 }
@@ -2112,22 +2160,15 @@ void
 g_file_info_set_modification_time (GFileInfo *info,
 				   GTimeVal  *mtime)
 {
-  static guint32 attr_mtime = 0, attr_mtime_usec;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (mtime != NULL);
 
-  if (attr_mtime == 0)
-    {
-      attr_mtime = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED);
-      attr_mtime_usec = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
-    }
-
-  value = g_file_info_create_value (info, attr_mtime);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_TIME_MODIFIED);
   if (value)
     _g_file_attribute_value_set_uint64 (value, mtime->tv_sec);
-  value = g_file_info_create_value (info, attr_mtime_usec);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_TIME_MODIFIED_USEC);
   if (value)
     _g_file_attribute_value_set_uint32 (value, mtime->tv_usec);
 }
@@ -2144,16 +2185,12 @@ void
 g_file_info_set_symlink_target (GFileInfo  *info,
 				const char *symlink_target)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (symlink_target != NULL);
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SYMLINK_TARGET);
   if (value)
     _g_file_attribute_value_set_byte_string (value, symlink_target);
 }
@@ -2170,15 +2207,11 @@ void
 g_file_info_set_sort_order (GFileInfo *info,
 			    gint32     sort_order)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
 
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SORT_ORDER);
-
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, G_FILE_ATTRIBUTE_ID_STANDARD_SORT_ORDER);
   if (value)
     _g_file_attribute_value_set_int32 (value, sort_order);
 }
@@ -2194,6 +2227,8 @@ struct _GFileAttributeMatcher {
   gint ref;
 
   GArray *sub_matchers;
+  /* the built-in attributes matched by sub_matchers */
+  guint32 builtin_bits[BUILTIN_MAX_ATTRIBUTES / 32];
 
   /* Interator */
   guint32 iterator_ns;
@@ -2279,6 +2314,32 @@ matcher_optimize (GFileAttributeMatcher *matcher)
 
   g_array_set_size (matcher->sub_matchers, j + 1);
 
+  memset (matcher->builtin_bits, 0, sizeof (matcher->builtin_bits));
+  for (i = 0; i < matcher->sub_matchers->len; i++)
+    {
+      gint bit;
+
+      submatcher = &g_array_index (matcher->sub_matchers, SubMatcher, i);
+
+      if (submatcher->mask == 0xffffffff)
+        {
+          bit = builtin_attribute_bit (submatcher->id);
+          if (bit >= 0)
+            matcher->builtin_bits[bit / 32] |= 1u << (bit % 32);
+        }
+      else
+        {
+          guint32 ns = GET_NS (submatcher->id);
+
+          if (ns < BUILTIN_MAX_NAMESPACES)
+            for (j = 0; j < builtin_ns_keys[ns]; j++)
+              {
+                bit = builtin_ns_offset[ns] + j;
+                matcher->builtin_bits[bit / 32] |= 1u << (bit % 32);
+              }
+        }
+    }
+
   return matcher;
 }
 
@@ -2521,8 +2582,14 @@ matcher_matches_id (GFileAttributeMatcher *matcher,
                     guint32                id)
 {
   SubMatcher *sub_matchers;
+  gint bit;
   int i;
 
+  /* the common case: a single bit test */
+  bit = builtin_attribute_bit (id);
+  if (bit >= 0)
+    return (matcher->builtin_bits[bit / 32] & (1u << (bit % 32))) != 0;
+
   if (matcher->sub_matchers)
     {
       sub_matchers = (SubMatcher *)matcher->sub_matchers->data;
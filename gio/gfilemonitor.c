@@ -348,6 +348,11 @@ g_file_monitor_cancel (GFileMonitor* monitor)
  *
  * Sets the rate limit to which the @monitor will report
  * consecutive change events to the same file.
+ *
+ * Within this window, repeated %G_FILE_MONITOR_EVENT_CHANGED events
+ * for a file are merged into one, which is reported once the window
+ * has passed.  Identical events for a file that are still waiting to
+ * be dispatched are merged as well.
  */
 void
 g_file_monitor_set_rate_limit (GFileMonitor *monitor,
@@ -435,6 +440,28 @@ emit_in_idle (GFileMonitor      *monitor,
   change->event_type = event_type;
 
   g_mutex_lock (&monitor->priv->mutex);
+
+  /* Merge with the change queued just before if it is the same event on
+   * the same file: bursts of writes would otherwise flood the main loop
+   * with duplicates.
+   */
+  if (other_file == NULL && priv->pending_file_changes &&
+      (event_type == G_FILE_MONITOR_EVENT_CHANGED ||
+       event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+       event_type == G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED))
+    {
+      FileChange *last = priv->pending_file_changes->data;
+
+      if (last->event_type == event_type &&
+          last->other_file == NULL &&
+          g_file_equal (last->child, child))
+        {
+          g_mutex_unlock (&monitor->priv->mutex);
+          file_change_free (change);
+          return;
+        }
+    }
+
   if (!priv->pending_file_change_source)
     {
       source = g_idle_source_new ();
@@ -86,6 +86,23 @@ static void     g_input_stream_real_close_async  (GInputStream         *stream,
 static gboolean g_input_stream_real_close_finish (GInputStream         *stream,
 						  GAsyncResult         *result,
 						  GError              **error);
+static gboolean g_input_stream_real_readv        (GInputStream         *stream,
+						  const GInputVector   *vectors,
+						  gsize                 n_vectors,
+						  gsize                *bytes_read,
+						  GCancellable         *cancellable,
+						  GError              **error);
+static void     g_input_stream_real_readv_async  (GInputStream         *stream,
+						  const GInputVector   *vectors,
+						  gsize                 n_vectors,
+						  int                   io_priority,
+						  GCancellable         *cancellable,
+						  GAsyncReadyCallback   callback,
+						  gpointer              user_data);
+static gboolean g_input_stream_real_readv_finish (GInputStream         *stream,
+						  GAsyncResult         *result,
+						  gsize                *bytes_read,
+						  GError              **error);
 
 static void
 g_input_stream_dispose (GObject *object)
@@ -115,6 +132,9 @@ g_input_stream_class_init (GInputStreamClass *klass)
   klass->skip_finish = g_input_stream_real_skip_finish;
   klass->close_async = g_input_stream_real_close_async;
   klass->close_finish = g_input_stream_real_close_finish;
+  klass->readv_fn = g_input_stream_real_readv;
+  klass->readv_async = g_input_stream_real_readv_async;
+  klass->readv_finish = g_input_stream_real_readv_finish;
 }
 
 static void
@@ -264,6 +284,224 @@ g_input_stream_read_all (GInputStream  *stream,
   return TRUE;
 }
 
+gboolean
+g_input_vectors_check_size (const GInputVector  *vectors,
+                            gsize                n_vectors,
+                            const gchar         *function,
+                            GError             **error)
+{
+  gsize total = 0;
+  gsize i;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (vectors[i].size > G_MAXSSIZE - total)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                       _("Sum of vectors passed to %s too large"), function);
+          return FALSE;
+        }
+      total += vectors[i].size;
+    }
+
+  return TRUE;
+}
+
+/* Drops the first @n_bytes from @vectors, for g_input_stream_readv_all(). */
+static void
+input_vectors_advance (GInputVector **vectors,
+                       gsize         *n_vectors,
+                       gsize          n_bytes)
+{
+  while (*n_vectors > 0 && n_bytes >= (*vectors)[0].size)
+    {
+      n_bytes -= (*vectors)[0].size;
+      (*vectors)++;
+      (*n_vectors)--;
+    }
+
+  if (*n_vectors > 0)
+    {
+      (*vectors)[0].buffer = (guint8 *) (*vectors)[0].buffer + n_bytes;
+      (*vectors)[0].size -= n_bytes;
+    }
+  else
+    g_warn_if_fail (n_bytes == 0);
+}
+
+/**
+ * g_input_stream_readv:
+ * @stream: a #GInputStream.
+ * @vectors: (array length=n_vectors): the buffers to read data into
+ * @n_vectors: the number of elements in @vectors
+ * @bytes_read: (out) (allow-none): location to store the number of bytes
+ *     that were read from the stream
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Tries to read from the stream into the @n_vectors buffers in
+ * @vectors, filling each one before moving on to the next, as if they
+ * were one buffer. Will block during this read.
+ *
+ * If @n_vectors is 0 or the sum of all sizes in @vectors is 0, returns
+ * %TRUE and does nothing. If the sum of all sizes in @vectors is larger
+ * than %G_MAXSSIZE, a %G_IO_ERROR_INVALID_ARGUMENT error is returned.
+ *
+ * On success, @bytes_read is set to the number of bytes read. As with
+ * g_input_stream_read(), this may be less than the sum of the sizes
+ * in @vectors, and is 0 only on end of file. Streams backed by a file
+ * descriptor or a #GSocket read into all the vectors with a single
+ * system call where possible; other streams read into them one after
+ * the other.
+ *
+ * If @cancellable is not %NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned. If an
+ * operation was partially finished when the operation was cancelled the
+ * partial result will be returned, without an error.
+ *
+ * On error %FALSE is returned, @bytes_read is set to 0 and @error is
+ * set accordingly.
+ *
+ * Virtual: readv_fn
+ *
+ * Return value: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_input_stream_readv (GInputStream        *stream,
+		      const GInputVector  *vectors,
+		      gsize                n_vectors,
+		      gsize               *bytes_read,
+		      GCancellable        *cancellable,
+		      GError             **error)
+{
+  GInputStreamClass *class;
+  gsize _bytes_read = 0;
+  gboolean res;
+
+  if (bytes_read)
+    *bytes_read = 0;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+  /* trailing empty vectors would make a zero-length read look
+   * like end of file
+   */
+  while (n_vectors > 0 && vectors[n_vectors - 1].size == 0)
+    n_vectors--;
+
+  if (n_vectors == 0)
+    return TRUE;
+
+  if (!g_input_vectors_check_size (vectors, n_vectors, G_STRFUNC, error))
+    return FALSE;
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+
+  if (class->readv_fn == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Input stream doesn't implement readv"));
+      return FALSE;
+    }
+
+  if (!g_input_stream_set_pending (stream, error))
+    return FALSE;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  res = class->readv_fn (stream, vectors, n_vectors, &_bytes_read,
+                         cancellable, error);
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  g_input_stream_clear_pending (stream);
+
+  if (bytes_read)
+    *bytes_read = _bytes_read;
+
+  return res;
+}
+
+/**
+ * g_input_stream_readv_all:
+ * @stream: a #GInputStream.
+ * @vectors: (array length=n_vectors): the buffers to read data into
+ * @n_vectors: the number of elements in @vectors
+ * @bytes_read: (out) (allow-none): location to store the number of bytes
+ *     that were read from the stream
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Tries to read from the stream into the @n_vectors buffers in
+ * @vectors. Will block during this read.
+ *
+ * This function is similar to g_input_stream_readv(), except it tries to
+ * fill all the buffers, only stopping on an error or end of stream.
+ *
+ * On a successful read, or if we reached the end of the stream, %TRUE
+ * is returned, and @bytes_read is set to the number of bytes read.
+ *
+ * If there is an error during the operation %FALSE is returned and @error
+ * is set to indicate the error status, @bytes_read is updated to contain
+ * the number of bytes read before the error occurred.
+ *
+ * The elements of @vectors may be changed by this function, to keep
+ * track of what is left to read.
+ *
+ * Return value: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_input_stream_readv_all (GInputStream  *stream,
+			  GInputVector  *vectors,
+			  gsize          n_vectors,
+			  gsize         *bytes_read,
+			  GCancellable  *cancellable,
+			  GError       **error)
+{
+  gsize _bytes_read = 0;
+
+  if (bytes_read)
+    *bytes_read = 0;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+  /* skip the empty ones, so that they don't look like end of file */
+  input_vectors_advance (&vectors, &n_vectors, 0);
+
+  while (n_vectors > 0)
+    {
+      gsize n_read;
+
+      if (!g_input_stream_readv (stream, vectors, n_vectors, &n_read,
+                                 cancellable, error))
+        {
+          if (bytes_read)
+            *bytes_read = _bytes_read;
+          return FALSE;
+        }
+
+      if (n_read == 0)
+        break;
+
+      _bytes_read += n_read;
+      input_vectors_advance (&vectors, &n_vectors, n_read);
+    }
+
+  if (bytes_read)
+    *bytes_read = _bytes_read;
+
+  return TRUE;
+}
+
 /**
  * g_input_stream_read_bytes:
  * @stream: a #GInputStream.
@@ -652,6 +890,137 @@ g_input_stream_read_finish (GInputStream  *stream,
   return class->read_finish (stream, result, error);
 }
 
+static void
+async_ready_readv_callback_wrapper (GObject      *source_object,
+                                    GAsyncResult *res,
+                                    gpointer      user_data)
+{
+  GInputStream *stream = G_INPUT_STREAM (source_object);
+  GInputStreamClass *class;
+  GTask *task = user_data;
+  gsize bytes_read = 0;
+  GError *error = NULL;
+
+  g_input_stream_clear_pending (stream);
+
+  if (!g_async_result_legacy_propagate_error (res, &error))
+    {
+      class = G_INPUT_STREAM_GET_CLASS (stream);
+      class->readv_finish (stream, res, &bytes_read, &error);
+    }
+
+  if (error == NULL)
+    g_task_return_int (task, bytes_read);
+  else
+    g_task_return_error (task, error);
+  g_object_unref (task);
+}
+
+/**
+ * g_input_stream_readv_async:
+ * @stream: A #GInputStream.
+ * @vectors: (array length=n_vectors): the buffers to read data into
+ * @n_vectors: the number of elements in @vectors
+ * @io_priority: the <link linkend="io-priority">I/O priority</link>
+ *   of the request.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): callback to call when the request is satisfied
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Request an asynchronous read from the stream into the @n_vectors
+ * buffers in @vectors. When the operation is finished @callback will
+ * be called. You can then call g_input_stream_readv_finish() to get
+ * the result of the operation.
+ *
+ * This is the asynchronous version of g_input_stream_readv(), and
+ * otherwise works like g_input_stream_read_async(). @vectors and the
+ * buffers it points to must stay valid until the operation is
+ * finished.
+ *
+ * The default implementation reads into all the vectors at once with
+ * a non-blocking read if @stream is a pollable #GPollableInputStream,
+ * and calls g_input_stream_readv() in a thread otherwise.
+ *
+ * Since: 2.40
+ */
+void
+g_input_stream_readv_async (GInputStream        *stream,
+			    const GInputVector  *vectors,
+			    gsize                n_vectors,
+			    int                  io_priority,
+			    GCancellable        *cancellable,
+			    GAsyncReadyCallback  callback,
+			    gpointer             user_data)
+{
+  GInputStreamClass *class;
+  GError *error = NULL;
+  GTask *task;
+
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+  g_return_if_fail (vectors != NULL || n_vectors == 0);
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_input_stream_readv_async);
+  g_task_set_priority (task, io_priority);
+
+  while (n_vectors > 0 && vectors[n_vectors - 1].size == 0)
+    n_vectors--;
+
+  if (n_vectors == 0)
+    {
+      g_task_return_int (task, 0);
+      g_object_unref (task);
+      return;
+    }
+
+  if (!g_input_vectors_check_size (vectors, n_vectors, G_STRFUNC, &error) ||
+      !g_input_stream_set_pending (stream, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+
+  class->readv_async (stream, vectors, n_vectors, io_priority, cancellable,
+                      async_ready_readv_callback_wrapper, task);
+}
+
+/**
+ * g_input_stream_readv_finish:
+ * @stream: a #GInputStream.
+ * @result: a #GAsyncResult.
+ * @bytes_read: (out) (allow-none): location to store the number of bytes
+ *     that were read from the stream
+ * @error: a #GError location to store the error occurring, or %NULL to
+ *   ignore.
+ *
+ * Finishes an asynchronous stream readv operation.
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_input_stream_readv_finish (GInputStream  *stream,
+                             GAsyncResult  *result,
+                             gsize         *bytes_read,
+                             GError       **error)
+{
+  gssize res;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+  g_return_val_if_fail (g_async_result_is_tagged (result, g_input_stream_readv_async), FALSE);
+
+  res = g_task_propagate_int (G_TASK (result), error);
+  if (bytes_read)
+    *bytes_read = MAX (res, 0);
+
+  return res != -1;
+}
+
 static void
 read_bytes_callback (GObject      *stream,
 		     GAsyncResult *result,
@@ -1189,6 +1558,183 @@ g_input_stream_real_read_finish (GInputStream  *stream,
 }
 
 
+static gboolean
+g_input_stream_real_readv (GInputStream        *stream,
+                           const GInputVector  *vectors,
+                           gsize                n_vectors,
+                           gsize               *bytes_read,
+                           GCancellable        *cancellable,
+                           GError             **error)
+{
+  GInputStreamClass *class;
+  gsize _bytes_read = 0;
+  gsize i;
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+
+  if (class->read_fn == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Input stream doesn't implement read"));
+      return FALSE;
+    }
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      GError *err = NULL;
+      gssize res;
+
+      if (vectors[i].size == 0)
+        continue;
+
+      res = class->read_fn (stream, vectors[i].buffer, vectors[i].size,
+                            cancellable, &err);
+      if (res == -1)
+        {
+          /* a partial read, the error comes back on the next call */
+          if (_bytes_read > 0)
+            {
+              g_error_free (err);
+              break;
+            }
+
+          g_propagate_error (error, err);
+          return FALSE;
+        }
+
+      _bytes_read += res;
+      if ((gsize) res < vectors[i].size)
+        break;
+    }
+
+  *bytes_read = _bytes_read;
+
+  return TRUE;
+}
+
+typedef struct {
+  const GInputVector *vectors;
+  gsize               n_vectors;
+} ReadvData;
+
+static void
+free_readv_data (ReadvData *op)
+{
+  g_slice_free (ReadvData, op);
+}
+
+static void
+readv_async_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  GInputStream *stream = source_object;
+  ReadvData *op = task_data;
+  GInputStreamClass *class;
+  GError *error = NULL;
+  gsize bytes_read;
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+  if (class->readv_fn (stream, op->vectors, op->n_vectors, &bytes_read,
+                       cancellable, &error))
+    g_task_return_int (task, bytes_read);
+  else
+    g_task_return_error (task, error);
+}
+
+static void readv_async_pollable (GPollableInputStream *stream,
+                                  GTask                *task);
+
+static gboolean
+readv_async_pollable_ready (GPollableInputStream *stream,
+			    gpointer              user_data)
+{
+  GTask *task = user_data;
+
+  readv_async_pollable (stream, task);
+  return FALSE;
+}
+
+static void
+readv_async_pollable (GPollableInputStream *stream,
+                      GTask                *task)
+{
+  ReadvData *op = g_task_get_task_data (task);
+  GError *error = NULL;
+  gsize bytes_read;
+  gboolean res;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  res = G_POLLABLE_INPUT_STREAM_GET_INTERFACE (stream)->
+    readv_nonblocking (stream, op->vectors, op->n_vectors, &bytes_read, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+    {
+      GSource *source;
+
+      g_error_free (error);
+
+      source = g_pollable_input_stream_create_source (stream,
+                                                      g_task_get_cancellable (task));
+      g_task_attach_source (task, source,
+                            (GSourceFunc) readv_async_pollable_ready);
+      g_source_unref (source);
+      return;
+    }
+
+  if (res)
+    g_task_return_int (task, bytes_read);
+  else
+    g_task_return_error (task, error);
+  /* g_input_stream_real_readv_async() unrefs task */
+}
+
+static void
+g_input_stream_real_readv_async (GInputStream        *stream,
+                                 const GInputVector  *vectors,
+                                 gsize                n_vectors,
+                                 int                  io_priority,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  GTask *task;
+  ReadvData *op;
+
+  op = g_slice_new0 (ReadvData);
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_task_data (task, op, (GDestroyNotify) free_readv_data);
+  g_task_set_priority (task, io_priority);
+  op->vectors = vectors;
+  op->n_vectors = n_vectors;
+
+  if (G_IS_POLLABLE_INPUT_STREAM (stream) &&
+      g_pollable_input_stream_can_poll (G_POLLABLE_INPUT_STREAM (stream)))
+    readv_async_pollable (G_POLLABLE_INPUT_STREAM (stream), task);
+  else
+    g_task_run_in_thread (task, readv_async_thread);
+  g_object_unref (task);
+}
+
+static gboolean
+g_input_stream_real_readv_finish (GInputStream  *stream,
+                                  GAsyncResult  *result,
+                                  gsize         *bytes_read,
+                                  GError       **error)
+{
+  gssize res;
+
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+
+  res = g_task_propagate_int (G_TASK (result), error);
+  *bytes_read = MAX (res, 0);
+
+  return res != -1;
+}
+
 static void
 skip_async_thread (GTask        *task,
                    gpointer      source_object,
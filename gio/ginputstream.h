@@ -102,11 +102,28 @@ struct _GInputStreamClass
                              GAsyncResult        *result,
                              GError             **error);
 
+  /* Vectored reads: (optional in derived classes) */
+
+  gboolean (* readv_fn)     (GInputStream        *stream,
+                             const GInputVector  *vectors,
+                             gsize                n_vectors,
+                             gsize               *bytes_read,
+                             GCancellable        *cancellable,
+                             GError             **error);
+  void     (* readv_async)  (GInputStream        *stream,
+                             const GInputVector  *vectors,
+                             gsize                n_vectors,
+                             int                  io_priority,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data);
+  gboolean (* readv_finish) (GInputStream        *stream,
+                             GAsyncResult        *result,
+                             gsize               *bytes_read,
+                             GError             **error);
+
   /*< private >*/
   /* Padding for future expansion */
-  void (*_g_reserved1) (void);
-  void (*_g_reserved2) (void);
-  void (*_g_reserved3) (void);
   void (*_g_reserved4) (void);
   void (*_g_reserved5) (void);
 };
@@ -127,6 +144,20 @@ gboolean g_input_stream_read_all      (GInputStream          *stream,
 				       gsize                 *bytes_read,
 				       GCancellable          *cancellable,
 				       GError               **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_input_stream_readv         (GInputStream          *stream,
+				       const GInputVector    *vectors,
+				       gsize                  n_vectors,
+				       gsize                 *bytes_read,
+				       GCancellable          *cancellable,
+				       GError               **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_input_stream_readv_all     (GInputStream          *stream,
+				       GInputVector          *vectors,
+				       gsize                  n_vectors,
+				       gsize                 *bytes_read,
+				       GCancellable          *cancellable,
+				       GError               **error);
 GLIB_AVAILABLE_IN_2_34
 GBytes  *g_input_stream_read_bytes    (GInputStream          *stream,
 				       gsize                  count,
@@ -153,6 +184,19 @@ GLIB_AVAILABLE_IN_ALL
 gssize   g_input_stream_read_finish   (GInputStream          *stream,
 				       GAsyncResult          *result,
 				       GError               **error);
+GLIB_AVAILABLE_IN_2_40
+void     g_input_stream_readv_async   (GInputStream          *stream,
+				       const GInputVector    *vectors,
+				       gsize                  n_vectors,
+				       int                    io_priority,
+				       GCancellable          *cancellable,
+				       GAsyncReadyCallback    callback,
+				       gpointer               user_data);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_input_stream_readv_finish  (GInputStream          *stream,
+				       GAsyncResult          *result,
+				       gsize                 *bytes_read,
+				       GError               **error);
 GLIB_AVAILABLE_IN_2_34
 void     g_input_stream_read_bytes_async  (GInputStream          *stream,
 					   gsize                  count,
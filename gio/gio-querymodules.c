@@ -38,6 +38,50 @@ is_valid_module_name (const gchar *basename)
 #endif
 }
 
+/* Loads the module to find out which extensions it implements, so
+ * that GIO can later load just the one it needs; see
+ * g_io_modules_scan_all_in_directory_with_scope().
+ */
+static void
+append_extensions (GString     *data,
+                   const char  *name,
+                   const char  *path,
+                   char       **extension_points)
+{
+  GIOModule *module;
+  int i;
+
+  for (i = 0; extension_points[i] != NULL; i++)
+    g_io_extension_point_register (extension_points[i]);
+
+  /* Never finalized, as required for a GTypeModule that was used */
+  module = g_io_module_new (path);
+  if (!g_type_module_use (G_TYPE_MODULE (module)))
+    return;
+
+  for (i = 0; extension_points[i] != NULL; i++)
+    {
+      GIOExtensionPoint *extension_point;
+      GList *l;
+
+      extension_point = g_io_extension_point_lookup (extension_points[i]);
+      for (l = g_io_extension_point_get_extensions (extension_point); l != NULL; l = l->next)
+        {
+          GIOExtension *extension = l->data;
+
+          if (g_type_get_plugin (g_io_extension_get_type (extension)) != G_TYPE_PLUGIN (module) ||
+              g_io_extension_get_name (extension) == NULL)
+            continue;
+
+          g_string_append_printf (data, "#+ %s: %s %d %s\n", name, extension_points[i],
+                                  g_io_extension_get_priority (extension),
+                                  g_io_extension_get_name (extension));
+        }
+    }
+
+  g_type_module_unuse (G_TYPE_MODULE (module));
+}
+
 static void
 query_dir (const char *dirname)
 {
@@ -74,10 +118,10 @@ query_dir (const char *dirname)
 
       path = g_build_filename (dirname, name, NULL);
       module = g_module_open (path, G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
-      g_free (path);
 
       if (module)
 	{
+	  query = NULL;
 	  g_module_symbol (module, "g_io_module_query", (gpointer) &query);
 
 	  if (query)
@@ -86,6 +130,8 @@ query_dir (const char *dirname)
 
 	      if (extension_points)
 		{
+		  append_extensions (data, name, path, extension_points);
+
 		  g_string_append_printf (data, "%s: ", name);
 
 		  for (i = 0; extension_points[i] != NULL; i++)
@@ -98,6 +144,8 @@ query_dir (const char *dirname)
 
 	  g_module_close (module);
 	}
+
+      g_free (path);
     }
 
   g_dir_close (dir);
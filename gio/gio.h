@@ -119,6 +119,7 @@
 #include <gio/gsocketclient.h>
 #include <gio/gsocketconnectable.h>
 #include <gio/gsocketconnection.h>
+#include <gio/gsocketconnectionpool.h>
 #include <gio/gsocketcontrolmessage.h>
 #include <gio/gsocket.h>
 #include <gio/gsocketlistener.h>
@@ -142,6 +143,7 @@
 #include <gio/gtlsinteraction.h>
 #include <gio/gtlsserverconnection.h>
 #include <gio/gtlspassword.h>
+#include <gio/gvariantoutputstream.h>
 #include <gio/gvfs.h>
 #include <gio/gvolume.h>
 #include <gio/gvolumemonitor.h>
@@ -333,6 +333,10 @@ typedef enum {
  *   and CREATED events).
  * @G_FILE_MONITOR_WATCH_HARD_LINKS: Watch for changes to the file made
  *   via another hard link. Since 2.36.
+ * @G_FILE_MONITOR_RECURSIVE: Also watch everything below a monitored
+ *   directory, however deep.  Only some backends support this; if none
+ *   does, creating the monitor fails with %G_IO_ERROR_NOT_SUPPORTED.
+ *   Since 2.40.
  *
  * Flags used to set what a #GFileMonitor will watch for.
  */
@@ -340,7 +344,8 @@ typedef enum {
   G_FILE_MONITOR_NONE             = 0,
   G_FILE_MONITOR_WATCH_MOUNTS     = (1 << 0),
   G_FILE_MONITOR_SEND_MOVED       = (1 << 1),
-  G_FILE_MONITOR_WATCH_HARD_LINKS = (1 << 2)
+  G_FILE_MONITOR_WATCH_HARD_LINKS = (1 << 2),
+  G_FILE_MONITOR_RECURSIVE        = (1 << 3)
 } GFileMonitorFlags;
 
 
@@ -954,6 +959,13 @@ typedef enum
  * do not ask the bus to launch an owner during proxy initialization, but allow it to be
  * autostarted by a method call. This flag is only meaningful in proxies for well-known names,
  * and only if %G_DBUS_PROXY_FLAGS_DO_NOT_AUTOSTART is not also specified.
+ * @G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES: Don't load properties during
+ * construction. Instead, the first call to g_dbus_proxy_get_cached_property()
+ * or g_dbus_proxy_get_cached_property_names() loads them in the background;
+ * #GDBusProxy::g-properties-changed is emitted once they have arrived. Lazy
+ * proxies for the same object share the <literal>GetAll()</literal> call.
+ * Has no effect if %G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES is also
+ * specified. Since 2.40.
  *
  * Flags used when constructing an instance of a #GDBusProxy derived class.
  *
@@ -966,7 +978,8 @@ typedef enum
   G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS = (1<<1),
   G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START = (1<<2),
   G_DBUS_PROXY_FLAGS_GET_INVALIDATED_PROPERTIES = (1<<3),
-  G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START_AT_CONSTRUCTION = (1<<4)
+  G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START_AT_CONSTRUCTION = (1<<4),
+  G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES = (1<<5)
 } GDBusProxyFlags;
 
 /**
@@ -1127,6 +1140,10 @@ typedef enum
  * message bus. This means that the Hello() method will be invoked as part of the connection setup.
  * @G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING: If set, processing of D-Bus messages is
  * delayed until g_dbus_connection_start_message_processing() is called.
+ * @G_DBUS_CONNECTION_FLAGS_DEDICATED_WORKER_THREAD: Do the I/O for the
+ * connection in a thread of its own instead of the one shared by all
+ * connections in the process, so that a busy connection does not hold
+ * up the others. Since 2.40.
  *
  * Flags used when creating a new #GDBusConnection.
  *
@@ -1138,7 +1155,8 @@ typedef enum {
   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER = (1<<1),
   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_ALLOW_ANONYMOUS = (1<<2),
   G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION = (1<<3),
-  G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING = (1<<4)
+  G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING = (1<<4),
+  G_DBUS_CONNECTION_FLAGS_DEDICATED_WORKER_THREAD = (1<<5)
 } GDBusConnectionFlags;
 
 /**
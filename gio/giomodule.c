@@ -23,6 +23,7 @@
 #include "config.h"
 
 #include <string.h>
+#include <stdlib.h>
 
 #include "giomodule.h"
 #include "giomodule-priv.h"
@@ -226,6 +227,9 @@ static void      g_io_module_finalize      (GObject      *object);
 static gboolean  g_io_module_load_module   (GTypeModule  *gmodule);
 static void      g_io_module_unload_module (GTypeModule  *gmodule);
 
+static GIOExtension *get_next_extension (GIOExtensionPoint *extension_point,
+                                         GHashTable        *tried);
+
 struct _GIOExtension {
   char *name;
   GType type;
@@ -237,8 +241,18 @@ struct _GIOExtensionPoint {
   char *name;
   GList *extensions;
   GList *lazy_load_modules;
+  GList *lazy_extensions; /* protected by extension_points lock */
 };
 
+/* An extension of a module that is not loaded yet, as recorded in
+ * giomodule.cache
+ */
+typedef struct {
+  GIOModule *module;
+  char *name;
+  gint priority;
+} GIOLazyExtension;
+
 static GHashTable *extension_points = NULL;
 G_LOCK_DEFINE_STATIC(extension_points);
 
@@ -375,6 +389,101 @@ is_valid_module_name (const gchar        *basename,
 }
 
 
+/* Parses a "#+ file: extension-point priority name" line of
+ * giomodule.cache, which gio-querymodules writes for every extension
+ * a module implements.  Being comments, older versions ignore them.
+ */
+static void
+parse_cached_extension (const char *line,
+                        GHashTable *cached_extensions)
+{
+  const char *colon;
+  char **fields;
+  char *file;
+  GPtrArray *extensions;
+
+  colon = strchr (line, ':');
+  if (colon == NULL || colon == line)
+    return;
+
+  colon++;
+  while (g_ascii_isspace (*colon))
+    colon++;
+
+  fields = g_strsplit (colon, " ", 3);
+  if (g_strv_length (fields) != 3 ||
+      fields[0][0] == '\0' || fields[2][0] == '\0')
+    {
+      g_strfreev (fields);
+      return;
+    }
+
+  file = g_strndup (line, strchr (line, ':') - line);
+  extensions = g_hash_table_lookup (cached_extensions, file);
+  if (extensions == NULL)
+    {
+      extensions = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+      g_hash_table_insert (cached_extensions, file, extensions);
+    }
+  else
+    g_free (file);
+
+  g_ptr_array_add (extensions, fields);
+}
+
+static gint
+lazy_extension_prio_compare (gconstpointer a,
+                             gconstpointer b)
+{
+  const GIOLazyExtension *extension_a = a, *extension_b = b;
+
+  if (extension_a->priority > extension_b->priority)
+    return -1;
+
+  if (extension_b->priority > extension_a->priority)
+    return 1;
+
+  return 0;
+}
+
+/* Returns %FALSE if @extensions doesn't say what @module implements
+ * for @extension_point, in which case it must be loaded on any use.
+ */
+static gboolean
+add_lazy_extensions (GIOExtensionPoint *extension_point,
+                     GIOModule         *module,
+                     GPtrArray         *extensions)
+{
+  gboolean found = FALSE;
+  guint i;
+
+  if (extensions == NULL)
+    return FALSE;
+
+  for (i = 0; i < extensions->len; i++)
+    {
+      char **fields = extensions->pdata[i];
+      GIOLazyExtension *lazy;
+
+      if (strcmp (fields[0], extension_point->name) != 0)
+        continue;
+
+      lazy = g_slice_new (GIOLazyExtension);
+      lazy->module = module;
+      lazy->priority = atoi (fields[1]);
+      lazy->name = g_strdup (fields[2]);
+
+      G_LOCK (extension_points);
+      extension_point->lazy_extensions =
+        g_list_insert_sorted (extension_point->lazy_extensions,
+                              lazy, lazy_extension_prio_compare);
+      G_UNLOCK (extension_points);
+      found = TRUE;
+    }
+
+  return found;
+}
+
 /**
  * g_io_modules_scan_all_in_directory_with_scope:
  * @dirname: pathname for a directory containing modules to scan.
@@ -405,6 +514,7 @@ g_io_modules_scan_all_in_directory_with_scope (const char     *dirname,
   char *data;
   time_t cache_mtime;
   GHashTable *cache;
+  GHashTable *cached_extensions;
 
   if (!g_module_supported ())
     return;
@@ -417,6 +527,8 @@ g_io_modules_scan_all_in_directory_with_scope (const char     *dirname,
 
   cache = g_hash_table_new_full (g_str_hash, g_str_equal,
 				 g_free, (GDestroyNotify)g_strfreev);
+  cached_extensions = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, (GDestroyNotify)g_ptr_array_unref);
 
   cache_mtime = 0;
   if (g_stat (filename, &statbuf) == 0 &&
@@ -444,6 +556,12 @@ g_io_modules_scan_all_in_directory_with_scope (const char     *dirname,
 	  char *colon;
 	  char **extension_points;
 
+	  if (g_str_has_prefix (line, "#+ "))
+	    {
+	      parse_cached_extension (line + 3, cached_extensions);
+	      continue;
+	    }
+
 	  if (line[0] == '#')
 	    continue;
 
@@ -482,14 +600,21 @@ g_io_modules_scan_all_in_directory_with_scope (const char     *dirname,
 	      g_stat (path, &statbuf) == 0 &&
 	      statbuf.st_ctime <= cache_mtime)
 	    {
-	      /* Lazy load/init the library when first required */
+	      GPtrArray *extensions;
+
+	      extensions = g_hash_table_lookup (cached_extensions, name);
+
+	      /* Lazy load/init the library when first required; if the
+	       * cache knows its extensions, only when one of them is.
+	       */
 	      for (i = 0; extension_points[i] != NULL; i++)
 		{
 		  extension_point =
 		    g_io_extension_point_register (extension_points[i]);
-		  extension_point->lazy_load_modules =
-		    g_list_prepend (extension_point->lazy_load_modules,
-				    module);
+		  if (!add_lazy_extensions (extension_point, module, extensions))
+		    extension_point->lazy_load_modules =
+		      g_list_prepend (extension_point->lazy_load_modules,
+				      module);
 		}
 	    }
 	  else
@@ -513,6 +638,7 @@ g_io_modules_scan_all_in_directory_with_scope (const char     *dirname,
   g_dir_close (dir);
 
   g_hash_table_destroy (cache);
+  g_hash_table_destroy (cached_extensions);
 
   g_free (filename);
 }
@@ -679,7 +805,7 @@ _g_io_module_get_default_type (const gchar *extension_point,
   static GRecMutex default_modules_lock;
   static GHashTable *default_modules;
   const char *use_this;
-  GList *l;
+  GHashTable *tried;
   GIOExtensionPoint *ep;
   GIOExtension *extension, *preferred;
   gpointer impl;
@@ -726,18 +852,15 @@ _g_io_module_get_default_type (const gchar *extension_point,
   else
     preferred = NULL;
 
-  for (l = g_io_extension_point_get_extensions (ep); l != NULL; l = l->next)
-    {
-      extension = l->data;
-      if (extension == preferred)
-        continue;
-
-      impl = try_class (extension, is_supported_offset);
-      if (impl)
-        goto done;
-    }
+  tried = g_hash_table_new (NULL, NULL);
+  if (preferred)
+    g_hash_table_add (tried, preferred);
 
   impl = NULL;
+  while (impl == NULL && (extension = get_next_extension (ep, tried)) != NULL)
+    impl = try_class (extension, is_supported_offset);
+
+  g_hash_table_unref (tried);
 
  done:
   g_hash_table_insert (default_modules, g_strdup (extension_point), impl);
@@ -802,7 +925,7 @@ _g_io_module_get_default (const gchar         *extension_point,
   static GRecMutex default_modules_lock;
   static GHashTable *default_modules;
   const char *use_this;
-  GList *l;
+  GHashTable *tried;
   GIOExtensionPoint *ep;
   GIOExtension *extension, *preferred;
   gpointer impl;
@@ -850,18 +973,15 @@ _g_io_module_get_default (const gchar         *extension_point,
   else
     preferred = NULL;
 
-  for (l = g_io_extension_point_get_extensions (ep); l != NULL; l = l->next)
-    {
-      extension = l->data;
-      if (extension == preferred)
-	continue;
-
-      impl = try_implementation (extension, verify_func);
-      if (impl)
-	goto done;
-    }
+  tried = g_hash_table_new (NULL, NULL);
+  if (preferred)
+    g_hash_table_add (tried, preferred);
 
   impl = NULL;
+  while (impl == NULL && (extension = get_next_extension (ep, tried)) != NULL)
+    impl = try_implementation (extension, verify_func);
+
+  g_hash_table_unref (tried);
 
  done:
   g_hash_table_insert (default_modules,
@@ -879,6 +999,7 @@ extern GType _g_fen_directory_monitor_get_type (void);
 extern GType _g_fen_file_monitor_get_type (void);
 extern GType _g_inotify_directory_monitor_get_type (void);
 extern GType _g_inotify_file_monitor_get_type (void);
+extern GType _g_fanotify_directory_monitor_get_type (void);
 extern GType _g_kqueue_directory_monitor_get_type (void);
 extern GType _g_kqueue_file_monitor_get_type (void);
 extern GType _g_unix_volume_monitor_get_type (void);
@@ -977,6 +1098,9 @@ _g_io_modules_ensure_extension_points_registered (void)
       ep = g_io_extension_point_register (G_NFS_DIRECTORY_MONITOR_EXTENSION_POINT_NAME);
       g_io_extension_point_set_required_type (ep, G_TYPE_LOCAL_DIRECTORY_MONITOR);
 
+      ep = g_io_extension_point_register (G_RECURSIVE_DIRECTORY_MONITOR_EXTENSION_POINT_NAME);
+      g_io_extension_point_set_required_type (ep, G_TYPE_LOCAL_DIRECTORY_MONITOR);
+
       ep = g_io_extension_point_register (G_NFS_FILE_MONITOR_EXTENSION_POINT_NAME);
       g_io_extension_point_set_required_type (ep, G_TYPE_LOCAL_FILE_MONITOR);
 
@@ -1056,6 +1180,9 @@ _g_io_modules_ensure_loaded (void)
       g_type_ensure (_g_inotify_directory_monitor_get_type ());
       g_type_ensure (_g_inotify_file_monitor_get_type ());
 #endif
+#if defined(HAVE_FANOTIFY)
+      g_type_ensure (_g_fanotify_directory_monitor_get_type ());
+#endif
 #if defined(HAVE_KQUEUE)
       g_type_ensure (_g_kqueue_directory_monitor_get_type ());
       g_type_ensure (_g_kqueue_file_monitor_get_type ());
@@ -1195,25 +1322,106 @@ g_io_extension_point_get_required_type (GIOExtensionPoint *extension_point)
   return extension_point->required_type;
 }
 
+static void
+lazy_load_module (GIOModule *module)
+{
+  if (!module->initialized)
+    {
+      if (g_type_module_use (G_TYPE_MODULE (module)))
+        g_type_module_unuse (G_TYPE_MODULE (module)); /* Unload */
+      else
+        g_printerr ("Failed to load module: %s\n",
+                    module->filename);
+    }
+}
+
+/* Loads the module of the highest priority extension of
+ * @extension_point that is known from the cache only, if it has
+ * at least @min_priority and, unless %NULL, is called @name.
+ * Returns %FALSE if there is no such extension.
+ *
+ * The extension is taken off the list under the lock, so that only
+ * one of several threads resolving the same extension point loads
+ * it; the module itself is loaded without the lock, as that
+ * registers its extensions.
+ */
+static gboolean
+lazy_load_extension (GIOExtensionPoint *extension_point,
+                     const char        *name,
+                     gint               min_priority)
+{
+  GIOLazyExtension *lazy = NULL;
+  GList *l;
+
+  G_LOCK (extension_points);
+  for (l = extension_point->lazy_extensions; l != NULL; l = l->next)
+    {
+      GIOLazyExtension *candidate = l->data;
+
+      if (candidate->priority < min_priority)
+        break;
+
+      if (name != NULL && strcmp (candidate->name, name) != 0)
+        continue;
+
+      extension_point->lazy_extensions =
+        g_list_delete_link (extension_point->lazy_extensions, l);
+      lazy = candidate;
+      break;
+    }
+  G_UNLOCK (extension_points);
+
+  if (lazy == NULL)
+    return FALSE;
+
+  lazy_load_module (lazy->module);
+  g_free (lazy->name);
+  g_slice_free (GIOLazyExtension, lazy);
+
+  return TRUE;
+}
+
 static void
 lazy_load_modules (GIOExtensionPoint *extension_point)
 {
-  GIOModule *module;
   GList *l;
 
   for (l = extension_point->lazy_load_modules; l != NULL; l = l->next)
-    {
-      module = l->data;
+    lazy_load_module (l->data);
+}
 
-      if (!module->initialized)
-	{
-	  if (g_type_module_use (G_TYPE_MODULE (module)))
-	    g_type_module_unuse (G_TYPE_MODULE (module)); /* Unload */
-	  else
-	    g_printerr ("Failed to load module: %s\n",
-			module->filename);
-	}
+/* Returns the next extension of @extension_point not in @tried, in
+ * order of decreasing priority, and adds it to @tried.  Unlike walking
+ * g_io_extension_point_get_extensions(), this only loads the modules
+ * whose extensions are known from giomodule.cache once everything
+ * with a higher priority has been tried.
+ */
+static GIOExtension *
+get_next_extension (GIOExtensionPoint *extension_point,
+                    GHashTable        *tried)
+{
+  GIOExtension *extension;
+  GList *l;
+
+  lazy_load_modules (extension_point);
+
+  do
+    {
+      extension = NULL;
+      for (l = extension_point->extensions; l != NULL; l = l->next)
+        if (!g_hash_table_contains (tried, l->data))
+          {
+            extension = l->data;
+            break;
+          }
     }
+  while (lazy_load_extension (extension_point, NULL,
+                              extension ? extension->priority : G_MININT));
+
+  if (extension != NULL)
+    g_hash_table_add (tried, extension);
+
+  return extension;
 }
 
 /**
@@ -1231,6 +1439,8 @@ GList *
 g_io_extension_point_get_extensions (GIOExtensionPoint *extension_point)
 {
   lazy_load_modules (extension_point);
+  while (lazy_load_extension (extension_point, NULL, G_MININT))
+    ;
   return extension_point->extensions;
 }
 
@@ -1251,6 +1461,8 @@ g_io_extension_point_get_extension_by_name (GIOExtensionPoint *extension_point,
   GList *l;
 
   lazy_load_modules (extension_point);
+  while (lazy_load_extension (extension_point, name, G_MININT))
+    ;
   for (l = extension_point->extensions; l != NULL; l = l->next)
     {
       GIOExtension *e = l->data;
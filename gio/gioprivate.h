@@ -24,11 +24,78 @@
 #include "ginputstream.h"
 #include "goutputstream.h"
 
+#include <limits.h>
+
 G_BEGIN_DECLS
 
+/* The most vectors passed to readv(), writev(), recvmsg() or sendmsg()
+ * at once
+ */
+#if defined (IOV_MAX)
+#define G_IOV_MAX IOV_MAX
+#elif defined (UIO_MAXIOV)
+#define G_IOV_MAX UIO_MAXIOV
+#else
+#define G_IOV_MAX 1024
+#endif
+
 gboolean g_input_stream_async_read_is_via_threads (GInputStream *stream);
 gboolean g_output_stream_async_write_is_via_threads (GOutputStream *stream);
 
+void     g_output_stream_set_kernel_socket (GOutputStream *stream,
+                                            GSocket       *socket);
+GSocket *g_output_stream_get_kernel_socket (GOutputStream *stream);
+gboolean g_input_vectors_check_size  (const GInputVector   *vectors,
+                                      gsize                 n_vectors,
+                                      const gchar          *function,
+                                      GError              **error);
+gboolean g_output_vectors_check_size (const GOutputVector  *vectors,
+                                      gsize                 n_vectors,
+                                      const gchar          *function,
+                                      GError              **error);
+
+gboolean g_cancellable_make_thread_pollfd    (GCancellable *cancellable,
+                                              GPollFD      *pollfd,
+                                              gulong       *handler_id);
+void     g_cancellable_release_thread_pollfd (GCancellable *cancellable,
+                                              gulong        handler_id);
+
+GSource *g_socket_create_watch       (GSocket      *socket);
+void     g_socket_watch_arm          (GSource      *watch,
+                                      GIOCondition  condition,
+                                      GCancellable *cancellable);
+void     g_socket_watch_disarm       (GSource      *watch);
+
+GSocket *g_socket_accept_with_blocking (GSocket      *socket,
+                                        gboolean      blocking,
+                                        GCancellable *cancellable,
+                                        GError      **error);
+
+GSocketConnection *g_socket_listener_accept_pending (GSocketListener  *listener,
+                                                     GObject         **source_object,
+                                                     GError          **error);
+
+gssize   g_socket_send_message_with_blocking (GSocket                *socket,
+                                              GSocketAddress         *address,
+                                              GOutputVector          *vectors,
+                                              gint                    num_vectors,
+                                              GSocketControlMessage **messages,
+                                              gint                    num_messages,
+                                              gint                    flags,
+                                              gboolean                blocking,
+                                              GCancellable           *cancellable,
+                                              GError                **error);
+gssize   g_socket_receive_message_with_blocking (GSocket                 *socket,
+                                                 GSocketAddress         **address,
+                                                 GInputVector            *vectors,
+                                                 gint                     num_vectors,
+                                                 GSocketControlMessage ***messages,
+                                                 gint                    *num_messages,
+                                                 gint                    *flags,
+                                                 gboolean                 blocking,
+                                                 GCancellable            *cancellable,
+                                                 GError                 **error);
+
 G_END_DECLS
 
 #endif /* __G_IO_PRIVATE__ */
@@ -182,6 +182,14 @@ typedef struct _GSocketClient                               GSocketClient;
  * Since: 2.22
  **/
 typedef struct _GSocketConnection                           GSocketConnection;
+/**
+ * GSocketConnectionPool:
+ *
+ * A pool of idle connections that #GSocketClient can reuse.
+ *
+ * Since: 2.40
+ **/
+typedef struct _GSocketConnectionPool                       GSocketConnectionPool;
 /**
  * GSocketListener:
  *
@@ -341,6 +349,26 @@ typedef void (* GFileMeasureProgressCallback) (gboolean reporting,
                                                guint64  num_files,
                                                gpointer user_data);
 
+/**
+ * GFileWalkTreeFunc:
+ * @directory: the directory that @infos were found in
+ * @infos: (element-type GFileInfo): a list of #GFileInfo
+ * @user_data: the data passed to g_file_walk_tree_async()
+ *
+ * This callback type is used by g_file_walk_tree_async() to hand out
+ * the files found while walking a directory tree, in batches.
+ *
+ * The list and the infos in it are only valid for the duration of the
+ * call; take a reference on any #GFileInfo you want to keep. The
+ * #GFile for an entry can be obtained with g_file_get_child() on
+ * @directory and the name of the info.
+ *
+ * Since: 2.40
+ **/
+typedef void (* GFileWalkTreeFunc) (GFile    *directory,
+                                    GList    *infos,
+                                    gpointer  user_data);
+
 /**
  * GIOSchedulerJobFunc:
  * @job: a #GIOSchedulerJob.
@@ -427,6 +455,72 @@ struct _GOutputVector {
   gsize size;
 };
 
+/**
+ * GInputMessage:
+ * @address: (allow-none): return location for the source address of
+ *     the message, or %NULL
+ * @vectors: (array length=num_vectors): the buffers to scatter the
+ *     received data into
+ * @num_vectors: the number of elements in @vectors
+ * @bytes_received: will be set to the number of bytes received
+ * @flags: will be set to the #GSocketMsgFlags of the received message
+ * @control_messages: (allow-none): return location for the control
+ *     messages, as with g_socket_receive_message(), or %NULL
+ * @num_control_messages: (allow-none): return location for the number
+ *     of control messages, or %NULL
+ *
+ * Structure used to receive a single message with
+ * g_socket_receive_messages(). The messages are filled in like the
+ * arguments of g_socket_receive_message().
+ *
+ * Since: 2.40
+ */
+typedef struct _GInputMessage GInputMessage;
+
+struct _GInputMessage {
+  GSocketAddress          **address;
+
+  GInputVector             *vectors;
+  guint                     num_vectors;
+
+  gsize                     bytes_received;
+  gint                      flags;
+
+  GSocketControlMessage  ***control_messages;
+  guint                    *num_control_messages;
+};
+
+/**
+ * GOutputMessage:
+ * @address: (allow-none): the destination of the message, or %NULL
+ * @vectors: (array length=num_vectors): the buffers to gather the
+ *     data of the message from
+ * @num_vectors: the number of elements in @vectors
+ * @bytes_sent: will be set to the number of bytes sent
+ * @control_messages: (array length=num_control_messages) (allow-none):
+ *     the control messages to send, or %NULL
+ * @num_control_messages: the number of elements in @control_messages
+ *
+ * Structure used to send a single message with
+ * g_socket_send_messages(). The fields have the same meaning as
+ * the arguments of g_socket_send_message().
+ *
+ * Since: 2.40
+ */
+typedef struct _GOutputMessage GOutputMessage;
+
+struct _GOutputMessage {
+  GSocketAddress         *address;
+
+  GOutputVector          *vectors;
+  guint                   num_vectors;
+
+  guint                   bytes_sent;
+
+  GSocketControlMessage **control_messages;
+  guint                   num_control_messages;
+};
+
 typedef struct _GCredentials                  GCredentials;
 typedef struct _GUnixCredentialsMessage       GUnixCredentialsMessage;
 typedef struct _GUnixFDList                   GUnixFDList;
@@ -495,7 +495,8 @@ parse_resource_file (const gchar *filename,
 
   context = g_markup_parse_context_new (&parser,
 					G_MARKUP_TREAT_CDATA_AS_TEXT |
-					G_MARKUP_PREFIX_ERROR_POSITION,
+					G_MARKUP_PREFIX_ERROR_POSITION |
+					G_MARKUP_BORROW_TEXT,
 					&state, NULL);
 
   if (!g_markup_parse_context_parse (context, contents, size, &error) ||
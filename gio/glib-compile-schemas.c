@@ -34,6 +34,7 @@
 #endif
 
 #include "gvdb/gvdb-builder.h"
+#include "gvdb/gvdb-reader.h"
 #include "strinfo.c"
 
 #ifdef G_OS_WIN32
@@ -1674,6 +1675,7 @@ output_schema (gpointer key,
 
 static gboolean
 write_to_file (GHashTable   *schema_table,
+               const gchar  *inputs,
                const gchar  *filename,
                GError      **error)
 {
@@ -1686,6 +1688,13 @@ write_to_file (GHashTable   *schema_table,
 
   g_hash_table_foreach (schema_table, output_schema, &data);
 
+  /* Not a child of the root, so it does not show up as a schema.
+   * Only with --incremental, so that the output otherwise depends on
+   * nothing but the contents of the inputs.
+   */
+  if (inputs != NULL)
+    gvdb_hash_table_insert_string (data.root_pair.table, ".inputs", inputs);
+
   success = gvdb_table_write_contents (data.root_pair.table, filename,
                                        G_BYTE_ORDER != G_LITTLE_ENDIAN,
                                        error);
@@ -1694,6 +1703,89 @@ write_to_file (GHashTable   *schema_table,
   return success;
 }
 
+/* Incremental mode {{{1 */
+
+/* Summarises the list of input files, their contents, and the options
+ * that affect the output.  This is stored in the compiled file, so that
+ * a later run with --incremental can tell that nothing changed without
+ * parsing anything.  Hashing the contents rather than comparing
+ * modification times also catches edits made within the timestamp
+ * granularity of the file system.
+ */
+static gchar *
+checksum_inputs (gchar **schema_files,
+                 gchar **override_files)
+{
+  GChecksum *checksum;
+  gchar **lists[2];
+  gchar *result;
+  gint i, j;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (guchar *) (allow_any_name ? "a" : "-"), 1);
+
+  lists[0] = schema_files;
+  lists[1] = override_files;
+
+  for (i = 0; i < 2; i++)
+    {
+      /* separate the two lists */
+      g_checksum_update (checksum, (guchar *) "", 1);
+
+      for (j = 0; lists[i] && lists[i][j]; j++)
+        {
+          gchar *contents;
+          gsize size;
+          gchar *info;
+
+          if (g_file_get_contents (lists[i][j], &contents, &size, NULL))
+            {
+              info = g_strdup_printf ("%s:%" G_GSIZE_FORMAT, lists[i][j], size);
+              g_checksum_update (checksum, (guchar *) info, strlen (info) + 1);
+              g_checksum_update (checksum, (guchar *) contents, size);
+              g_free (contents);
+            }
+          else
+            {
+              info = g_strdup_printf ("%s:missing", lists[i][j]);
+              g_checksum_update (checksum, (guchar *) info, strlen (info) + 1);
+            }
+
+          g_free (info);
+        }
+    }
+
+  result = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  return result;
+}
+
+static gboolean
+target_is_current (const gchar *target,
+                   const gchar *inputs)
+{
+  gboolean current = FALSE;
+  GvdbTable *table;
+  GVariant *value;
+
+  table = gvdb_table_new (target, FALSE, NULL);
+  if (table == NULL)
+    return FALSE;
+
+  value = gvdb_table_get_raw_value (table, ".inputs");
+  if (value != NULL)
+    {
+      current = g_variant_is_of_type (value, G_VARIANT_TYPE_STRING) &&
+                g_str_equal (g_variant_get_string (value, NULL), inputs);
+      g_variant_unref (value);
+    }
+
+  gvdb_table_unref (table);
+
+  return current;
+}
+
 /* Parser driver {{{1 */
 static GHashTable *
 parse_gschema_files (gchar    **files,
@@ -1729,7 +1821,8 @@ parse_gschema_files (gchar    **files,
       context = g_markup_parse_context_new (&parser,
                                             G_MARKUP_TREAT_CDATA_AS_TEXT |
                                             G_MARKUP_PREFIX_ERROR_POSITION |
-                                            G_MARKUP_IGNORE_QUALIFIED,
+                                            G_MARKUP_IGNORE_QUALIFIED |
+                                            G_MARKUP_BORROW_TEXT,
                                             &state, NULL);
 
 
@@ -1993,6 +2086,8 @@ main (int argc, char **argv)
   gchar *target;
   gboolean dry_run = FALSE;
   gboolean strict = FALSE;
+  gboolean incremental = FALSE;
+  gchar *inputs;
   gchar **schema_files = NULL;
   gchar **override_files = NULL;
   GOptionContext *context;
@@ -2001,6 +2096,7 @@ main (int argc, char **argv)
     { "strict", 0, 0, G_OPTION_ARG_NONE, &strict, N_("Abort on any errors in schemas"), NULL },
     { "dry-run", 0, 0, G_OPTION_ARG_NONE, &dry_run, N_("Do not write the gschema.compiled file"), NULL },
     { "allow-any-name", 0, 0, G_OPTION_ARG_NONE, &allow_any_name, N_("Do not enforce key name restrictions") },
+    { "incremental", 0, 0, G_OPTION_ARG_NONE, &incremental, N_("Do nothing if no schema file changed since the last run"), NULL },
 
     /* These options are only for use in the gschema-compile tests */
     { "schema-file", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_FILENAME_ARRAY, &schema_files, NULL, NULL },
@@ -2104,8 +2200,18 @@ main (int argc, char **argv)
       override_files = (gchar **) g_ptr_array_free (overrides, FALSE);
     }
 
+  inputs = incremental ? checksum_inputs (schema_files, override_files) : NULL;
+
+  if (incremental && !dry_run && target_is_current (target, inputs))
+    {
+      g_free (inputs);
+      g_free (target);
+      return 0;
+    }
+
   if ((table = parse_gschema_files (schema_files, strict)) == NULL)
     {
+      g_free (inputs);
       g_free (target);
       return 1;
     }
@@ -2113,17 +2219,20 @@ main (int argc, char **argv)
   if (override_files != NULL &&
       !set_overrides (table, override_files, strict))
     {
+      g_free (inputs);
       g_free (target);
       return 1;
     }
 
-  if (!dry_run && !write_to_file (table, target, &error))
+  if (!dry_run && !write_to_file (table, inputs, target, &error))
     {
       fprintf (stderr, "%s\n", error->message);
+      g_free (inputs);
       g_free (target);
       return 1;
     }
 
+  g_free (inputs);
   g_free (target);
 
   return 0;
@@ -209,7 +209,23 @@ _g_local_directory_monitor_new (const char         *dirname,
   GFileMonitor *monitor = NULL;
   GType type = G_TYPE_INVALID;
 
-  if (is_remote_fs)
+  if (flags & G_FILE_MONITOR_RECURSIVE)
+    {
+      /* Only dedicated backends can watch a whole tree; silently falling
+       * back to a single-directory monitor would lose events.
+       */
+      type = _g_io_module_get_default_type (G_RECURSIVE_DIRECTORY_MONITOR_EXTENSION_POINT_NAME,
+                                            "GIO_USE_FILE_MONITOR",
+                                            G_STRUCT_OFFSET (GLocalDirectoryMonitorClass, is_supported));
+      if (type == G_TYPE_INVALID)
+        {
+          g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                               _("Recursive directory monitoring is not supported"));
+          return NULL;
+        }
+    }
+
+  if (type == G_TYPE_INVALID && is_remote_fs)
     type = _g_io_module_get_default_type (G_NFS_DIRECTORY_MONITOR_EXTENSION_POINT_NAME,
                                           "GIO_USE_FILE_MONITOR",
                                           G_STRUCT_OFFSET (GLocalDirectoryMonitorClass, is_supported));
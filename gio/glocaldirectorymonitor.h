@@ -38,6 +38,7 @@ G_BEGIN_DECLS
 
 #define G_LOCAL_DIRECTORY_MONITOR_EXTENSION_POINT_NAME "gio-local-directory-monitor"
 #define G_NFS_DIRECTORY_MONITOR_EXTENSION_POINT_NAME   "gio-nfs-directory-monitor"
+#define G_RECURSIVE_DIRECTORY_MONITOR_EXTENSION_POINT_NAME "gio-recursive-directory-monitor"
 
 typedef struct _GLocalDirectoryMonitor      GLocalDirectoryMonitor;
 typedef struct _GLocalDirectoryMonitorClass GLocalDirectoryMonitorClass;
@@ -29,6 +29,9 @@
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifdef HAVE_STATX
+#include <sys/sysmacros.h>
+#endif
 #include <string.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -800,6 +803,7 @@ _g_local_file_info_get_parent_info (const char            *dir,
   parent_info->is_sticky = FALSE;
   parent_info->has_trash_dir = FALSE;
   parent_info->device = 0;
+  parent_info->dir_fd = -1;
 
   if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_ACCESS_CAN_RENAME) ||
       _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_ACCESS_CAN_DELETE) ||
@@ -843,6 +847,12 @@ _g_local_file_info_free_parent_info (GLocalParentFileInfo *parent_info)
   if (parent_info->extra_data &&
       parent_info->free_extra_data)
     parent_info->free_extra_data (parent_info->extra_data);
+
+  if (parent_info->dir_fd >= 0)
+    {
+      (void) g_close (parent_info->dir_fd, NULL);
+      parent_info->dir_fd = -1;
+    }
 }
 
 static void
@@ -1248,8 +1258,33 @@ get_content_type (const char          *basename,
 	{
 	  guchar sniff_buffer[4096];
 	  gsize sniff_length;
+	  guint32 mtime_nsec;
+	  gboolean cacheable;
 	  int fd;
 
+#if defined (HAVE_STRUCT_STAT_ST_MTIMENSEC)
+	  mtime_nsec = statbuf ? statbuf->st_mtimensec : 0;
+#elif defined (HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+	  mtime_nsec = statbuf ? statbuf->st_mtim.tv_nsec : 0;
+#else
+	  mtime_nsec = 0;
+#endif
+	  cacheable = statbuf != NULL && basename != NULL && S_ISREG (statbuf->st_mode);
+
+	  if (cacheable)
+	    {
+	      char *cached;
+
+	      cached = _g_unix_content_type_cache_lookup (basename, statbuf->st_dev, statbuf->st_ino,
+	                                                  statbuf->st_mtime, mtime_nsec,
+	                                                  statbuf->st_size);
+	      if (cached != NULL)
+	        {
+	          g_free (content_type);
+	          return cached;
+	        }
+	    }
+
 	  sniff_length = _g_unix_content_type_get_sniff_len ();
 	  if (sniff_length > 4096)
 	    sniff_length = 4096;
@@ -1270,6 +1305,11 @@ get_content_type (const char          *basename,
 		{
 		  g_free (content_type);
 		  content_type = g_content_type_guess (basename, sniff_buffer, res, NULL);
+
+		  if (cacheable)
+		    _g_unix_content_type_cache_insert (basename, statbuf->st_dev, statbuf->st_ino,
+		                                       statbuf->st_mtime, mtime_nsec,
+		                                       statbuf->st_size, content_type);
 		}
 	    }
 	}
@@ -1673,6 +1713,95 @@ get_icon (const char *path,
   return icon;
 }
 
+#ifdef HAVE_STATX
+/* The type, mode, ownership, link count and inode are cheap and needed
+ * by most of the code below. Sizes and times may take a round trip to
+ * the server on network file systems, so only ask for them when the
+ * attributes derived from them were requested. */
+static unsigned int
+statx_mask_for_matcher (GFileAttributeMatcher *attribute_matcher)
+{
+  unsigned int mask;
+
+  mask = STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_INO;
+
+  if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_STANDARD_SIZE) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_THUMBNAIL_PATH))
+    mask |= STATX_SIZE;
+
+  if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_STANDARD_ALLOCATED_SIZE) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_UNIX_BLOCKS))
+    mask |= STATX_BLOCKS;
+
+  if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_TIME_MODIFIED) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_TIME_MODIFIED_USEC) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_ETAG_VALUE) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_THUMBNAIL_PATH))
+    mask |= STATX_MTIME;
+
+  if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_TIME_ACCESS) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_TIME_ACCESS_USEC))
+    mask |= STATX_ATIME;
+
+  if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_TIME_CHANGED) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_TIME_CHANGED_USEC))
+    mask |= STATX_CTIME;
+
+  /* the content type sniffing cache is keyed on these */
+  if (_g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_STANDARD_CONTENT_TYPE) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_STANDARD_ICON) ||
+      _g_file_attribute_matcher_matches_id (attribute_matcher, G_FILE_ATTRIBUTE_ID_STANDARD_SYMBOLIC_ICON))
+    mask |= STATX_SIZE | STATX_MTIME;
+
+  return mask;
+}
+
+/* Like lstat() or stat(), but only fetching the fields needed for
+ * @attribute_matcher; the others are left zeroed.  @path is relative
+ * to @dir_fd, which may be AT_FDCWD. */
+static int
+local_file_statx (int                    dir_fd,
+                  const char            *path,
+                  gboolean               follow_symlinks,
+                  GFileAttributeMatcher *attribute_matcher,
+                  GLocalFileStat        *statbuf)
+{
+  struct statx stx;
+  int flags;
+
+  flags = AT_NO_AUTOMOUNT;
+  if (!follow_symlinks)
+    flags |= AT_SYMLINK_NOFOLLOW;
+
+  if (statx (dir_fd, path, flags, statx_mask_for_matcher (attribute_matcher), &stx) != 0)
+    {
+      if (errno == ENOSYS)
+        return fstatat (dir_fd, path, statbuf, follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW);
+      return -1;
+    }
+
+  memset (statbuf, 0, sizeof (*statbuf));
+  statbuf->st_dev = makedev (stx.stx_dev_major, stx.stx_dev_minor);
+  statbuf->st_rdev = makedev (stx.stx_rdev_major, stx.stx_rdev_minor);
+  statbuf->st_ino = stx.stx_ino;
+  statbuf->st_mode = stx.stx_mode;
+  statbuf->st_nlink = stx.stx_nlink;
+  statbuf->st_uid = stx.stx_uid;
+  statbuf->st_gid = stx.stx_gid;
+  statbuf->st_size = stx.stx_size;
+  statbuf->st_blksize = stx.stx_blksize;
+  statbuf->st_blocks = stx.stx_blocks;
+  statbuf->st_atim.tv_sec = stx.stx_atime.tv_sec;
+  statbuf->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+  statbuf->st_mtim.tv_sec = stx.stx_mtime.tv_sec;
+  statbuf->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+  statbuf->st_ctim.tv_sec = stx.stx_ctime.tv_sec;
+  statbuf->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+
+  return 0;
+}
+#endif /* HAVE_STATX */
+
 GFileInfo *
 _g_local_file_info_get (const char             *basename,
 			const char             *path,
@@ -1696,6 +1825,23 @@ _g_local_file_info_get (const char             *basename,
   GVfs *vfs;
   GVfsClass *class;
   guint64 device;
+#ifdef AT_FDCWD
+  int stat_dir_fd;
+  const char *stat_path;
+
+  /* When the caller has the directory open, stat relative to it so
+   * that the kernel doesn't resolve the whole path again each time */
+  if (parent_info != NULL && parent_info->dir_fd >= 0 && basename != NULL)
+    {
+      stat_dir_fd = parent_info->dir_fd;
+      stat_path = basename;
+    }
+  else
+    {
+      stat_dir_fd = AT_FDCWD;
+      stat_path = path;
+    }
+#endif
 
   info = g_file_info_new ();
 
@@ -1710,7 +1856,11 @@ _g_local_file_info_get (const char             *basename,
       return info;
     }
 
-#ifndef G_OS_WIN32
+#if defined (HAVE_STATX)
+  res = local_file_statx (stat_dir_fd, stat_path, FALSE, attribute_matcher, &statbuf);
+#elif defined (AT_FDCWD)
+  res = fstatat (stat_dir_fd, stat_path, &statbuf, AT_SYMLINK_NOFOLLOW);
+#elif !defined (G_OS_WIN32)
   res = g_lstat (path, &statbuf);
 #else
   {
@@ -1777,7 +1927,13 @@ _g_local_file_info_get (const char             *basename,
       /* Unless NOFOLLOW was set we default to following symlinks */
       if (!(flags & G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS))
 	{
+#if defined (HAVE_STATX)
+	  res = local_file_statx (stat_dir_fd, stat_path, TRUE, attribute_matcher, &statbuf2);
+#elif defined (AT_FDCWD)
+	  res = fstatat (stat_dir_fd, stat_path, &statbuf2, 0);
+#else
 	  res = stat (path, &statbuf2);
+#endif
 
 	  /* Report broken links as symlinks */
 	  if (res != -1)
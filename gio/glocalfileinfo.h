@@ -41,6 +41,9 @@ typedef struct
   dev_t    device;
   gpointer extra_data;
   GDestroyNotify free_extra_data;
+  /* If >= 0, an open fd for the directory, owned by the parent info;
+   * files in it are then stat()ed relative to it */
+  int      dir_fd;
 } GLocalParentFileInfo;
 
 #ifdef G_OS_WIN32
@@ -36,9 +36,11 @@
 #include "gioerror.h"
 #include "glocalfileinputstream.h"
 #include "glocalfileinfo.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 #ifdef G_OS_UNIX
+#include <sys/uio.h>
 #include "glib-unix.h"
 #include "gfiledescriptorbased.h"
 #endif
@@ -72,6 +74,14 @@ static gssize     g_local_file_input_stream_read       (GInputStream      *strea
 							gsize              count,
 							GCancellable      *cancellable,
 							GError           **error);
+#ifdef G_OS_UNIX
+static gboolean   g_local_file_input_stream_readv      (GInputStream      *stream,
+							const GInputVector *vectors,
+							gsize              n_vectors,
+							gsize             *bytes_read,
+							GCancellable      *cancellable,
+							GError           **error);
+#endif
 static gssize     g_local_file_input_stream_skip       (GInputStream      *stream,
 							gsize              count,
 							GCancellable      *cancellable,
@@ -108,6 +118,9 @@ g_local_file_input_stream_class_init (GLocalFileInputStreamClass *klass)
   GFileInputStreamClass *file_stream_class = G_FILE_INPUT_STREAM_CLASS (klass);
 
   stream_class->read_fn = g_local_file_input_stream_read;
+#ifdef G_OS_UNIX
+  stream_class->readv_fn = g_local_file_input_stream_readv;
+#endif
   stream_class->skip = g_local_file_input_stream_skip;
   stream_class->close_fn = g_local_file_input_stream_close;
   file_stream_class->tell = g_local_file_input_stream_tell;
@@ -179,6 +192,58 @@ g_local_file_input_stream_read (GInputStream  *stream,
   return res;
 }
 
+#ifdef G_OS_UNIX
+static gboolean
+g_local_file_input_stream_readv (GInputStream        *stream,
+				 const GInputVector  *vectors,
+				 gsize                n_vectors,
+				 gsize               *bytes_read,
+				 GCancellable        *cancellable,
+				 GError             **error)
+{
+  GLocalFileInputStream *file;
+  struct iovec *iov;
+  gssize res;
+  gsize i;
+
+  file = G_LOCAL_FILE_INPUT_STREAM (stream);
+
+  /* the rest is reported as a short read */
+  n_vectors = MIN (n_vectors, G_IOV_MAX);
+  iov = g_newa (struct iovec, n_vectors);
+  for (i = 0; i < n_vectors; i++)
+    {
+      iov[i].iov_base = vectors[i].buffer;
+      iov[i].iov_len = vectors[i].size;
+    }
+
+  res = -1;
+  while (1)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	break;
+      res = readv (file->priv->fd, iov, n_vectors);
+      if (res == -1)
+	{
+          int errsv = errno;
+
+	  if (errsv == EINTR)
+	    continue;
+
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error reading from file: %s"),
+		       g_strerror (errsv));
+	}
+
+      break;
+    }
+
+  *bytes_read = MAX (res, 0);
+  return res != -1;
+}
+#endif
+
 static gssize
 g_local_file_input_stream_skip (GInputStream  *stream,
 				gsize          count,
@@ -44,6 +44,11 @@
  *
  * As of GLib 2.34, #GMemoryOutputStream trivially implements
  * #GPollableOutputStream: it always polls as ready.
+ *
+ * A stream created with g_memory_output_stream_new_chunked() stores
+ * its data in a list of fixed-size chunks instead of one buffer that
+ * is reallocated as it grows. The chunks can be taken without ever
+ * being joined with g_memory_output_stream_steal_chunks().
  */
 
 #define MIN_ARRAY_SIZE  16
@@ -54,7 +59,8 @@ enum {
   PROP_SIZE,
   PROP_DATA_SIZE,
   PROP_REALLOC_FUNCTION,
-  PROP_DESTROY_FUNCTION
+  PROP_DESTROY_FUNCTION,
+  PROP_CHUNK_SIZE
 };
 
 struct _GMemoryOutputStreamPrivate
@@ -67,6 +73,10 @@ struct _GMemoryOutputStreamPrivate
 
   GReallocFunc   realloc_fn;
   GDestroyNotify destroy;
+
+  gsize          chunk_size; /* Non-zero in chunked mode */
+  GPtrArray     *chunks; /* In chunked mode, holds the data instead of data.
+                            len is the total size of all chunks. */
 };
 
 static void     g_memory_output_stream_set_property (GObject      *object,
@@ -77,6 +87,7 @@ static void     g_memory_output_stream_get_property (GObject      *object,
                                                      guint         prop_id,
                                                      GValue       *value,
                                                      GParamSpec   *pspec);
+static void     g_memory_output_stream_constructed  (GObject      *object);
 static void     g_memory_output_stream_finalize     (GObject      *object);
 
 static gssize   g_memory_output_stream_write       (GOutputStream *stream,
@@ -135,6 +146,7 @@ g_memory_output_stream_class_init (GMemoryOutputStreamClass *klass)
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->set_property = g_memory_output_stream_set_property;
   gobject_class->get_property = g_memory_output_stream_get_property;
+  gobject_class->constructed  = g_memory_output_stream_constructed;
   gobject_class->finalize     = g_memory_output_stream_finalize;
 
   ostream_class = G_OUTPUT_STREAM_CLASS (klass);
@@ -220,6 +232,24 @@ g_memory_output_stream_class_init (GMemoryOutputStreamClass *klass)
                                                          P_("Function called with the buffer as argument when the stream is destroyed."),
                                                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
                                                          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GMemoryOutputStream:chunk-size:
+   *
+   * If non-zero, the stream stores its data in chunks of this size
+   * rather than in a single buffer. See
+   * g_memory_output_stream_new_chunked().
+   *
+   * Since: 2.40
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_CHUNK_SIZE,
+                                   g_param_spec_ulong ("chunk-size",
+                                                       P_("Chunk Size"),
+                                                       P_("Size of the chunks the data is stored in, or 0."),
+                                                       0, G_MAXULONG, 0,
+                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                                                       G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -255,6 +285,9 @@ g_memory_output_stream_set_property (GObject      *object,
     case PROP_DESTROY_FUNCTION:
       priv->destroy = g_value_get_pointer (value);
       break;
+    case PROP_CHUNK_SIZE:
+      priv->chunk_size = g_value_get_ulong (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -276,7 +309,7 @@ g_memory_output_stream_get_property (GObject      *object,
   switch (prop_id)
     {
     case PROP_DATA:
-      g_value_set_pointer (value, priv->data);
+      g_value_set_pointer (value, g_memory_output_stream_get_data (stream));
       break;
     case PROP_SIZE:
       g_value_set_ulong (value, priv->len);
@@ -290,12 +323,42 @@ g_memory_output_stream_get_property (GObject      *object,
     case PROP_DESTROY_FUNCTION:
       g_value_set_pointer (value, priv->destroy);
       break;
+    case PROP_CHUNK_SIZE:
+      g_value_set_ulong (value, priv->chunk_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
     }
 }
 
+static void
+g_memory_output_stream_constructed (GObject *object)
+{
+  GMemoryOutputStream        *stream;
+  GMemoryOutputStreamPrivate *priv;
+
+  stream = G_MEMORY_OUTPUT_STREAM (object);
+  priv = stream->priv;
+
+  if (priv->chunk_size > 0)
+    {
+      if (priv->data != NULL || priv->realloc_fn != g_realloc || priv->destroy != g_free)
+        {
+          g_critical ("GMemoryOutputStream:chunk-size requires g_realloc() and "
+                      "g_free() and no initial data");
+          priv->chunk_size = 0;
+        }
+      else
+        {
+          priv->chunks = g_ptr_array_new_with_free_func (g_free);
+          priv->len = 0;
+        }
+    }
+
+  G_OBJECT_CLASS (g_memory_output_stream_parent_class)->constructed (object);
+}
+
 static void
 g_memory_output_stream_finalize (GObject *object)
 {
@@ -305,6 +368,8 @@ g_memory_output_stream_finalize (GObject *object)
   stream = G_MEMORY_OUTPUT_STREAM (object);
   priv = stream->priv;
   
+  if (priv->chunks)
+    g_ptr_array_unref (priv->chunks);
   if (priv->destroy)
     priv->destroy (priv->data);
 
@@ -415,6 +480,101 @@ g_memory_output_stream_new_resizable (void)
   return g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
 }
 
+/**
+ * g_memory_output_stream_new_chunked:
+ * @chunk_size: the size of each chunk
+ *
+ * Creates a new resizable #GMemoryOutputStream that stores its data
+ * in chunks of @chunk_size bytes. Growing the stream only ever
+ * allocates another chunk, so the data written so far is never copied
+ * and the memory used is at most the data plus one chunk.
+ *
+ * Use g_memory_output_stream_steal_chunks() to get the data; for
+ * instance to pass it on to g_output_stream_writev(). The functions
+ * that return the data as a single block of memory, like
+ * g_memory_output_stream_get_data(), still work but have to join the
+ * chunks first, after which the stream continues like a stream
+ * created with g_memory_output_stream_new_resizable().
+ *
+ * Returns: (transfer full): a new #GMemoryOutputStream
+ *
+ * Since: 2.40
+ */
+GOutputStream *
+g_memory_output_stream_new_chunked (gsize chunk_size)
+{
+  g_return_val_if_fail (chunk_size > 0, NULL);
+
+  return g_object_new (G_TYPE_MEMORY_OUTPUT_STREAM,
+                       "realloc-function", g_realloc,
+                       "destroy-function", g_free,
+                       "chunk-size", (gulong) chunk_size,
+                       NULL);
+}
+
+/* Copies @count bytes from @buffer, or zeroes if it is %NULL, into
+ * the chunks at @offset. The chunks must already be there.
+ */
+static void
+chunks_copy_in (GMemoryOutputStreamPrivate *priv,
+                gsize                       offset,
+                const guint8               *buffer,
+                gsize                       count)
+{
+  gsize index, chunk_offset, n;
+  guint8 *dest;
+
+  index = offset / priv->chunk_size;
+  chunk_offset = offset % priv->chunk_size;
+
+  while (count > 0)
+    {
+      dest = (guint8 *) priv->chunks->pdata[index] + chunk_offset;
+      n = MIN (count, priv->chunk_size - chunk_offset);
+
+      if (buffer)
+        {
+          memcpy (dest, buffer, n);
+          buffer += n;
+        }
+      else
+        memset (dest, 0, n);
+
+      count -= n;
+      chunk_offset = 0;
+      index++;
+    }
+}
+
+/* Leaves chunked mode by moving the data into a single buffer */
+static void
+join_chunks (GMemoryOutputStream *ostream)
+{
+  GMemoryOutputStreamPrivate *priv;
+  gsize offset, n;
+  guint8 *data;
+  guint i;
+
+  priv = ostream->priv;
+
+  if (priv->chunks == NULL)
+    return;
+
+  data = g_malloc (MAX (priv->valid_len, MIN_ARRAY_SIZE));
+  for (i = 0, offset = 0; offset < priv->valid_len; i++, offset += n)
+    {
+      n = MIN (priv->chunk_size, priv->valid_len - offset);
+      memcpy (data + offset, priv->chunks->pdata[i], n);
+    }
+
+  g_ptr_array_unref (priv->chunks);
+  priv->chunks = NULL;
+
+  priv->data = data;
+  priv->len = MAX (priv->valid_len, MIN_ARRAY_SIZE);
+  memset (data + priv->valid_len, 0, priv->len - priv->valid_len);
+}
+
 /**
  * g_memory_output_stream_get_data:
  * @ostream: a #GMemoryOutputStream
@@ -424,6 +584,9 @@ g_memory_output_stream_new_resizable (void)
  * Note that the returned pointer may become invalid on the next
  * write or truncate operation on the stream.
  *
+ * For a stream created with g_memory_output_stream_new_chunked() this
+ * joins the chunks into a single buffer.
+ *
  * Returns: (transfer none): pointer to the stream's data
  **/
 gpointer
@@ -431,6 +594,8 @@ g_memory_output_stream_get_data (GMemoryOutputStream *ostream)
 {
   g_return_val_if_fail (G_IS_MEMORY_OUTPUT_STREAM (ostream), NULL);
 
+  join_chunks (ostream);
+
   return ostream->priv->data;
 }
 
@@ -506,6 +671,8 @@ g_memory_output_stream_steal_data (GMemoryOutputStream *ostream)
   g_return_val_if_fail (G_IS_MEMORY_OUTPUT_STREAM (ostream), NULL);
   g_return_val_if_fail (g_output_stream_is_closed (G_OUTPUT_STREAM (ostream)), NULL);
 
+  join_chunks (ostream);
+
   data = ostream->priv->data;
   ostream->priv->data = NULL;
 
@@ -531,6 +698,8 @@ g_memory_output_stream_steal_as_bytes (GMemoryOutputStream *ostream)
   g_return_val_if_fail (G_IS_MEMORY_OUTPUT_STREAM (ostream), NULL);
   g_return_val_if_fail (g_output_stream_is_closed (G_OUTPUT_STREAM (ostream)), NULL);
 
+  join_chunks (ostream);
+
   result = g_bytes_new_with_free_func (ostream->priv->data,
                                        ostream->priv->valid_len,
                                        ostream->priv->destroy,
@@ -540,6 +709,56 @@ g_memory_output_stream_steal_as_bytes (GMemoryOutputStream *ostream)
   return result;
 }
 
+/**
+ * g_memory_output_stream_steal_chunks:
+ * @ostream: a #GMemoryOutputStream
+ *
+ * Returns the data from @ostream as an array of #GBytes which, taken
+ * in order, make up the data. For a stream created with
+ * g_memory_output_stream_new_chunked() these are the chunks it stored
+ * the data in, without any copying. Otherwise the array contains the
+ * data as one #GBytes, like g_memory_output_stream_steal_as_bytes().
+ *
+ * @ostream must be closed before calling this function.
+ *
+ * Returns: (transfer full) (element-type GBytes): the stream's data
+ *
+ * Since: 2.40
+ **/
+GPtrArray *
+g_memory_output_stream_steal_chunks (GMemoryOutputStream *ostream)
+{
+  GMemoryOutputStreamPrivate *priv;
+  GPtrArray *result;
+  gsize offset, n;
+  guint i;
+
+  g_return_val_if_fail (G_IS_MEMORY_OUTPUT_STREAM (ostream), NULL);
+  g_return_val_if_fail (g_output_stream_is_closed (G_OUTPUT_STREAM (ostream)), NULL);
+
+  priv = ostream->priv;
+  result = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+
+  if (priv->chunks == NULL)
+    {
+      g_ptr_array_add (result, g_memory_output_stream_steal_as_bytes (ostream));
+      return result;
+    }
+
+  for (i = 0, offset = 0; offset < priv->valid_len; i++, offset += n)
+    {
+      n = MIN (priv->chunk_size, priv->valid_len - offset);
+      g_ptr_array_add (result, g_bytes_new_take (priv->chunks->pdata[i], n));
+      priv->chunks->pdata[i] = NULL;
+    }
+
+  g_ptr_array_unref (priv->chunks);
+  priv->chunks = NULL;
+  priv->len = 0;
+
+  return result;
+}
+
 static gboolean
 array_resize (GMemoryOutputStream  *ostream,
               gsize                 size,
@@ -630,6 +849,31 @@ g_memory_output_stream_write (GOutputStream  *stream,
   if (priv->realloc_fn && priv->pos + count < priv->pos)
     goto overflow;
 
+  if (priv->chunks)
+    {
+      /* Grow by adding chunks, leaving the data where it is */
+      while (priv->len < priv->pos + count)
+        {
+          if (priv->len + priv->chunk_size < priv->len)
+            goto overflow;
+
+          g_ptr_array_add (priv->chunks, g_malloc (priv->chunk_size));
+          priv->len += priv->chunk_size;
+        }
+
+      /* Seeking past the end and writing leaves a zero-filled gap */
+      if (priv->pos > priv->valid_len)
+        chunks_copy_in (priv, priv->valid_len, NULL, priv->pos - priv->valid_len);
+
+      chunks_copy_in (priv, priv->pos, buffer, count);
+      priv->pos += count;
+
+      if (priv->pos > priv->valid_len)
+        priv->valid_len = priv->pos;
+
+      return count;
+    }
+
   if (priv->pos + count > priv->len)
     {
       /* At least enough to fit the write, rounded up for greater than
@@ -825,6 +1069,8 @@ g_memory_output_stream_truncate (GSeekable     *seekable,
 {
   GMemoryOutputStream *ostream = G_MEMORY_OUTPUT_STREAM (seekable);
 
+  join_chunks (ostream);
+
   if (!array_resize (ostream, offset, FALSE, error))
     return FALSE;
 
@@ -92,6 +92,8 @@ GOutputStream *g_memory_output_stream_new           (gpointer             data,
                                                      GDestroyNotify       destroy_function);
 GLIB_AVAILABLE_IN_2_36
 GOutputStream *g_memory_output_stream_new_resizable (void);
+GLIB_AVAILABLE_IN_2_40
+GOutputStream *g_memory_output_stream_new_chunked   (gsize                chunk_size);
 GLIB_AVAILABLE_IN_ALL
 gpointer       g_memory_output_stream_get_data      (GMemoryOutputStream *ostream);
 GLIB_AVAILABLE_IN_ALL
@@ -103,6 +105,8 @@ gpointer       g_memory_output_stream_steal_data    (GMemoryOutputStream *ostrea
 
 GLIB_AVAILABLE_IN_2_34
 GBytes *       g_memory_output_stream_steal_as_bytes (GMemoryOutputStream *ostream);
+GLIB_AVAILABLE_IN_2_40
+GPtrArray *    g_memory_output_stream_steal_chunks   (GMemoryOutputStream *ostream);
 
 G_END_DECLS
 
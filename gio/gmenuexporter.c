@@ -28,6 +28,8 @@
 #include "gdbusnamewatching.h"
 #include "gdbuserror.h"
 
+#include <string.h>
+
 /**
  * SECTION:gmenuexporter
  * @title: GMenuModel exporter
@@ -89,6 +91,7 @@ typedef struct _GMenuExporterLink                           GMenuExporterLink;
 typedef struct _GMenuExporterGroup                          GMenuExporterGroup;
 typedef struct _GMenuExporterRemote                         GMenuExporterRemote;
 typedef struct _GMenuExporterWatch                          GMenuExporterWatch;
+typedef struct _GMenuExporterChange                         GMenuExporterChange;
 typedef struct _GMenuExporter                               GMenuExporter;
 
 static gboolean                 g_menu_exporter_group_is_subscribed    (GMenuExporterGroup *group);
@@ -103,7 +106,10 @@ static GMenuExporterGroup *     g_menu_exporter_create_group           (GMenuExp
 static GMenuExporterGroup *     g_menu_exporter_lookup_group           (GMenuExporter      *exporter,
                                                                         guint               group_id);
 static void                     g_menu_exporter_report                 (GMenuExporter      *exporter,
-                                                                        GVariant           *report);
+                                                                        GMenuExporterMenu  *menu,
+                                                                        gint                position,
+                                                                        gint                removed,
+                                                                        GPtrArray          *added);
 static void                     g_menu_exporter_remove_group           (GMenuExporter      *exporter,
                                                                         guint               id);
 
@@ -117,6 +123,9 @@ struct _GMenuExporterMenu
   GMenuModel *model;
   gulong      handler_id;
   GSequence  *item_links;
+
+  /* The change to this menu that is waiting to be emitted, if any */
+  GMenuExporterChange *pending;
 };
 
 struct _GMenuExporterLink
@@ -126,11 +135,40 @@ struct _GMenuExporterLink
   GMenuExporterLink *next;
 };
 
+/* One entry of a Changed signal.  @menu, if it still exists, points
+ * back at this as long as it is pending.
+ */
+struct _GMenuExporterChange
+{
+  GMenuExporterMenu *menu;
+  guint              group_id;
+  guint              menu_id;
+  gint               position;
+  gint               removed;
+  GPtrArray         *added;
+};
+
+static void
+g_menu_exporter_change_free (gpointer data)
+{
+  GMenuExporterChange *change = data;
+
+  if (change->menu != NULL)
+    change->menu->pending = NULL;
+
+  g_ptr_array_unref (change->added);
+
+  g_slice_free (GMenuExporterChange, change);
+}
+
 static void
 g_menu_exporter_menu_free (GMenuExporterMenu *menu)
 {
   g_menu_exporter_group_remove_menu (menu->group, menu->id);
 
+  if (menu->pending != NULL)
+    menu->pending->menu = NULL;
+
   if (menu->handler_id != 0)
     g_signal_handler_disconnect (menu->model, menu->handler_id);
 
@@ -264,20 +302,13 @@ g_menu_exporter_menu_items_changed (GMenuModel *model,
 
   if (g_menu_exporter_group_is_subscribed (menu->group))
     {
-      GVariantBuilder builder;
+      GPtrArray *items;
 
-      g_variant_builder_init (&builder, G_VARIANT_TYPE ("(uuuuaa{sv})"));
-      g_variant_builder_add (&builder, "u", g_menu_exporter_group_get_id (menu->group));
-      g_variant_builder_add (&builder, "u", menu->id);
-      g_variant_builder_add (&builder, "u", position);
-      g_variant_builder_add (&builder, "u", removed);
-
-      g_variant_builder_open (&builder, G_VARIANT_TYPE ("aa{sv}"));
+      items = g_ptr_array_new_full (added, (GDestroyNotify) g_variant_unref);
       for (i = position; i < position + added; i++)
-        g_variant_builder_add_value (&builder, g_menu_exporter_menu_describe_item (menu, i));
-      g_variant_builder_close (&builder);
+        g_ptr_array_add (items, g_variant_ref_sink (g_menu_exporter_menu_describe_item (menu, i)));
 
-      g_menu_exporter_report (g_menu_exporter_group_get_exporter (menu->group), g_variant_builder_end (&builder));
+      g_menu_exporter_report (g_menu_exporter_group_get_exporter (menu->group), menu, position, removed, items);
     }
 }
 
@@ -558,8 +589,72 @@ struct _GMenuExporter
 
   GMenuExporterMenu *root;
   GHashTable *remotes;
+
+  /* Changes are collected here and emitted together from an idle */
+  GMainContext *context;
+  GPtrArray *changes;
+  GSource *changes_source;
 };
 
+static void
+g_menu_exporter_emit_changes (GMenuExporter *exporter)
+{
+  GVariantBuilder builder;
+  guint i, j;
+
+  if (exporter->changes_source != NULL)
+    {
+      g_source_destroy (exporter->changes_source);
+      g_source_unref (exporter->changes_source);
+      exporter->changes_source = NULL;
+    }
+
+  if (exporter->changes->len == 0)
+    return;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("(a(uuuuaa{sv}))"));
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(uuuuaa{sv})"));
+
+  for (i = 0; i < exporter->changes->len; i++)
+    {
+      GMenuExporterChange *change = exporter->changes->pdata[i];
+
+      g_variant_builder_open (&builder, G_VARIANT_TYPE ("(uuuuaa{sv})"));
+      g_variant_builder_add (&builder, "u", change->group_id);
+      g_variant_builder_add (&builder, "u", change->menu_id);
+      g_variant_builder_add (&builder, "u", change->position);
+      g_variant_builder_add (&builder, "u", change->removed);
+
+      g_variant_builder_open (&builder, G_VARIANT_TYPE ("aa{sv}"));
+      for (j = 0; j < change->added->len; j++)
+        g_variant_builder_add_value (&builder, change->added->pdata[j]);
+      g_variant_builder_close (&builder);
+
+      g_variant_builder_close (&builder);
+    }
+
+  g_variant_builder_close (&builder);
+
+  g_ptr_array_set_size (exporter->changes, 0);
+
+  g_dbus_connection_emit_signal (exporter->connection,
+                                 NULL,
+                                 exporter->object_path,
+                                 "org.gtk.Menus", "Changed",
+                                 g_variant_builder_end (&builder),
+                                 NULL);
+}
+
+static gboolean
+g_menu_exporter_emit_changes_cb (gpointer user_data)
+{
+  GMenuExporter *exporter = user_data;
+
+  g_menu_exporter_emit_changes (exporter);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 g_menu_exporter_name_vanished (GDBusConnection *connection,
                                const gchar     *name,
@@ -583,6 +678,12 @@ g_menu_exporter_subscribe (GMenuExporter *exporter,
   GVariantIter iter;
   guint32 id;
 
+  /* The reply describes the menus as they are now, so anything still
+   * pending must reach the bus first; the remote ignores it, as it is
+   * not online yet.
+   */
+  g_menu_exporter_emit_changes (exporter);
+
   remote = g_hash_table_lookup (exporter->remotes, sender);
 
   if (remote == NULL)
@@ -630,23 +731,69 @@ g_menu_exporter_unsubscribe (GMenuExporter *exporter,
     g_hash_table_remove (exporter->remotes, sender);
 }
 
+/* Takes ownership of @added.  Rebuilding a menu tends to come as a
+ * burst of changes next to each other, so a change that starts within
+ * or right after the items added by the pending change to the same
+ * menu is folded into that one.
+ */
 static void
-g_menu_exporter_report (GMenuExporter *exporter,
-                        GVariant      *report)
+g_menu_exporter_report (GMenuExporter     *exporter,
+                        GMenuExporterMenu *menu,
+                        gint               position,
+                        gint               removed,
+                        GPtrArray         *added)
 {
-  GVariantBuilder builder;
+  GMenuExporterChange *change = menu->pending;
 
-  g_variant_builder_init (&builder, G_VARIANT_TYPE_TUPLE);
-  g_variant_builder_open (&builder, G_VARIANT_TYPE_ARRAY);
-  g_variant_builder_add_value (&builder, report);
-  g_variant_builder_close (&builder);
+  if (change != NULL &&
+      change->position <= position && position <= change->position + (gint) change->added->len)
+    {
+      gint offset = position - change->position;
+      gint overlap = MIN (removed, (gint) change->added->len - offset);
+      guint tail;
 
-  g_dbus_connection_emit_signal (exporter->connection,
-                                 NULL,
-                                 exporter->object_path,
-                                 "org.gtk.Menus", "Changed",
-                                 g_variant_builder_end (&builder),
-                                 NULL);
+      /* Removing items that are only being added cancels out; the rest
+       * were there before the pending change.
+       */
+      if (overlap > 0)
+        g_ptr_array_remove_range (change->added, offset, overlap);
+      change->removed += removed - overlap;
+
+      tail = change->added->len - offset;
+      g_ptr_array_set_size (change->added, change->added->len + added->len);
+      memmove (change->added->pdata + offset + added->len, change->added->pdata + offset,
+               tail * sizeof (gpointer));
+      memcpy (change->added->pdata + offset, added->pdata, added->len * sizeof (gpointer));
+
+      g_ptr_array_set_free_func (added, NULL);
+      g_ptr_array_unref (added);
+    }
+  else
+    {
+      change = g_slice_new (GMenuExporterChange);
+      change->group_id = g_menu_exporter_group_get_id (menu->group);
+      change->menu_id = menu->id;
+      change->position = position;
+      change->removed = removed;
+      change->added = added;
+      g_ptr_array_add (exporter->changes, change);
+
+      /* Further changes can only be merged into the last one for this
+       * menu, or they would overtake those in between.
+       */
+      if (menu->pending != NULL)
+        menu->pending->menu = NULL;
+      change->menu = menu;
+      menu->pending = change;
+    }
+
+  if (exporter->changes_source == NULL)
+    {
+      exporter->changes_source = g_idle_source_new ();
+      g_source_set_priority (exporter->changes_source, G_PRIORITY_DEFAULT);
+      g_source_set_callback (exporter->changes_source, g_menu_exporter_emit_changes_cb, exporter, NULL);
+      g_source_attach (exporter->changes_source, exporter->context);
+    }
 }
 
 static void
@@ -691,7 +838,15 @@ g_menu_exporter_free (gpointer user_data)
 {
   GMenuExporter *exporter = user_data;
 
+  if (exporter->changes_source != NULL)
+    {
+      g_source_destroy (exporter->changes_source);
+      g_source_unref (exporter->changes_source);
+    }
+
   g_menu_exporter_menu_free (exporter->root);
+  g_ptr_array_unref (exporter->changes);
+  g_main_context_unref (exporter->context);
   g_hash_table_unref (exporter->remotes);
   g_hash_table_unref (exporter->groups);
   g_object_unref (exporter->connection);
@@ -782,6 +937,8 @@ g_dbus_connection_export_menu_model (GDBusConnection  *connection,
   exporter->connection = g_object_ref (connection);
   exporter->object_path = g_strdup (object_path);
   exporter->groups = g_hash_table_new (NULL, NULL);
+  exporter->context = g_main_context_ref_thread_default ();
+  exporter->changes = g_ptr_array_new_with_free_func (g_menu_exporter_change_free);
   exporter->remotes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_menu_exporter_remote_free);
   exporter->root = g_menu_exporter_group_add_menu (g_menu_exporter_create_group (exporter), menu);
 
@@ -36,6 +36,8 @@ gchar *  _g_uri_from_authority             (const gchar      *protocol,
 
 guint64  g_resolver_get_serial             (GResolver        *resolver);
 
+void     _g_proxy_resolver_enable_cache    (GProxyResolver   *resolver);
+
 gint g_socket (gint     domain,
                gint     type,
                gint     protocol,
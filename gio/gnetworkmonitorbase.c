@@ -493,17 +493,34 @@ g_network_monitor_base_remove_network (GNetworkMonitorBase *monitor,
  *
  * Drops @monitor's current list of available networks and replaces
  * it with @networks.
+ *
+ * Only the networks that actually differ between the two lists are
+ * removed or added, so #GNetworkMonitor::network-changed is not
+ * emitted if @networks matches the current list.
  */
 void
 g_network_monitor_base_set_networks (GNetworkMonitorBase  *monitor,
                                      GInetAddressMask    **networks,
                                      gint                  length)
 {
-  int i;
+  int i, j;
 
-  g_ptr_array_set_size (monitor->priv->networks, 0);
-  monitor->priv->have_ipv4_default_route = FALSE;
-  monitor->priv->have_ipv6_default_route = FALSE;
+  for (i = monitor->priv->networks->len - 1; i >= 0; i--)
+    {
+      GInetAddressMask *network = monitor->priv->networks->pdata[i];
+
+      for (j = 0; j < length; j++)
+        {
+          if (g_inet_address_mask_equal (network, networks[j]))
+            break;
+        }
+      if (j == length)
+        {
+          g_object_ref (network);
+          g_network_monitor_base_remove_network (monitor, network);
+          g_object_unref (network);
+        }
+    }
 
   for (i = 0; i < length; i++)
     g_network_monitor_base_add_network (monitor, networks[i]);
@@ -47,11 +47,17 @@ static void g_network_monitor_netlink_initable_iface_init (GInitableIface *iface
 struct _GNetworkMonitorNetlinkPrivate
 {
   GSocket *sock;
-  GSource *source, *dump_source;
+  GSource *source, *dump_source, *flush_source;
 
+  GPtrArray *networks;
   GPtrArray *dump_networks;
 };
 
+/* Route changes arriving within this many milliseconds of each other
+ * are applied to the base monitor as a single update.
+ */
+#define ROUTE_CHANGE_COALESCE_MS 100
+
 static gboolean read_netlink_messages (GSocket             *socket,
                                        GIOCondition         condition,
                                        gpointer             user_data);
@@ -75,6 +81,7 @@ static void
 g_network_monitor_netlink_init (GNetworkMonitorNetlink *nl)
 {
   nl->priv = g_network_monitor_netlink_get_instance_private (nl);
+  nl->priv->networks = g_ptr_array_new_with_free_func (g_object_unref);
 }
 
 
@@ -199,15 +206,12 @@ timeout_request_dump (gpointer user_data)
 static void
 queue_request_dump (GNetworkMonitorNetlink *nl)
 {
-  if (nl->priv->dump_networks)
+  /* If a resync is already scheduled, leave it be rather than pushing
+   * it back; under constant route churn it would otherwise never run.
+   */
+  if (nl->priv->dump_networks || nl->priv->dump_source)
     return;
 
-  if (nl->priv->dump_source)
-    {
-      g_source_destroy (nl->priv->dump_source);
-      g_source_unref (nl->priv->dump_source);
-    }
-
   nl->priv->dump_source = g_timeout_source_new (1000);
   g_source_set_callback (nl->priv->dump_source,
                          (GSourceFunc) timeout_request_dump, nl, NULL);
@@ -215,6 +219,49 @@ queue_request_dump (GNetworkMonitorNetlink *nl)
                    g_main_context_get_thread_default ());
 }
 
+static void
+flush_networks (GNetworkMonitorNetlink *nl)
+{
+  if (nl->priv->flush_source)
+    {
+      g_source_destroy (nl->priv->flush_source);
+      g_source_unref (nl->priv->flush_source);
+      nl->priv->flush_source = NULL;
+    }
+
+  g_network_monitor_base_set_networks (G_NETWORK_MONITOR_BASE (nl),
+                                       (GInetAddressMask **)nl->priv->networks->pdata,
+                                       nl->priv->networks->len);
+}
+
+static gboolean
+timeout_flush_networks (gpointer user_data)
+{
+  GNetworkMonitorNetlink *nl = user_data;
+
+  flush_networks (nl);
+
+  return FALSE;
+}
+
+/* Rather than passing each route change on to the base monitor as it
+ * arrives, we apply it to our own copy of the routing table and hand
+ * the result over once the burst is over, so that a storm of changes
+ * turns into (at most) one network-changed emission.
+ */
+static void
+queue_flush_networks (GNetworkMonitorNetlink *nl)
+{
+  if (nl->priv->flush_source)
+    return;
+
+  nl->priv->flush_source = g_timeout_source_new (ROUTE_CHANGE_COALESCE_MS);
+  g_source_set_callback (nl->priv->flush_source,
+                         (GSourceFunc) timeout_flush_networks, nl, NULL);
+  g_source_attach (nl->priv->flush_source,
+                   g_main_context_get_thread_default ());
+}
+
 static void
 add_network (GNetworkMonitorNetlink *nl,
              GSocketFamily           family,
@@ -236,8 +283,20 @@ add_network (GNetworkMonitorNetlink *nl,
     g_ptr_array_add (nl->priv->dump_networks, network);
   else
     {
-      g_network_monitor_base_add_network (G_NETWORK_MONITOR_BASE (nl), network);
-      g_object_unref (network);
+      GInetAddressMask **networks = (GInetAddressMask **)nl->priv->networks->pdata;
+      int i;
+
+      for (i = 0; i < nl->priv->networks->len; i++)
+        {
+          if (g_inet_address_mask_equal (network, networks[i]))
+            {
+              g_object_unref (network);
+              return;
+            }
+        }
+
+      g_ptr_array_add (nl->priv->networks, network);
+      queue_flush_networks (nl);
     }
 }
 
@@ -268,23 +327,33 @@ remove_network (GNetworkMonitorNetlink *nl,
           if (g_inet_address_mask_equal (network, dump_networks[i]))
             g_ptr_array_remove_index_fast (nl->priv->dump_networks, i--);
         }
-      g_object_unref (network);
     }
   else
     {
-      g_network_monitor_base_remove_network (G_NETWORK_MONITOR_BASE (nl), network);
-      g_object_unref (network);
+      GInetAddressMask **networks = (GInetAddressMask **)nl->priv->networks->pdata;
+      int i;
+
+      for (i = 0; i < nl->priv->networks->len; i++)
+        {
+          if (g_inet_address_mask_equal (network, networks[i]))
+            {
+              g_ptr_array_remove_index_fast (nl->priv->networks, i);
+              queue_flush_networks (nl);
+              break;
+            }
+        }
     }
+  g_object_unref (network);
 }
 
 static void
 finish_dump (GNetworkMonitorNetlink *nl)
 {
-  g_network_monitor_base_set_networks (G_NETWORK_MONITOR_BASE (nl),
-                                       (GInetAddressMask **)nl->priv->dump_networks->pdata,
-                                       nl->priv->dump_networks->len);
-  g_ptr_array_free (nl->priv->dump_networks, TRUE);
+  g_ptr_array_free (nl->priv->networks, TRUE);
+  nl->priv->networks = nl->priv->dump_networks;
   nl->priv->dump_networks = NULL;
+
+  flush_networks (nl);
 }
 
 static gboolean
@@ -443,6 +512,16 @@ g_network_monitor_netlink_finalize (GObject *object)
       g_source_unref (nl->priv->dump_source);
     }
 
+  if (nl->priv->flush_source)
+    {
+      g_source_destroy (nl->priv->flush_source);
+      g_source_unref (nl->priv->flush_source);
+    }
+
+  g_ptr_array_free (nl->priv->networks, TRUE);
+  if (nl->priv->dump_networks)
+    g_ptr_array_free (nl->priv->dump_networks, TRUE);
+
   G_OBJECT_CLASS (g_network_monitor_netlink_parent_class)->finalize (object);
 }
 
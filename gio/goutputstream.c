@@ -31,6 +31,16 @@
 #include "glibintl.h"
 #include "gpollableoutputstream.h"
 
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include "gfiledescriptorbased.h"
+#include "gsocket.h"
+#include "gsocketoutputstream.h"
+#endif
+
 /**
  * SECTION:goutputstream
  * @short_description: Base class for implementing streaming output
@@ -96,6 +106,23 @@ static void     g_output_stream_real_close_async   (GOutputStream             *s
 static gboolean g_output_stream_real_close_finish  (GOutputStream             *stream,
 						    GAsyncResult              *result,
 						    GError                   **error);
+static gboolean g_output_stream_real_writev        (GOutputStream             *stream,
+						    const GOutputVector       *vectors,
+						    gsize                      n_vectors,
+						    gsize                     *bytes_written,
+						    GCancellable              *cancellable,
+						    GError                   **error);
+static void     g_output_stream_real_writev_async  (GOutputStream             *stream,
+						    const GOutputVector       *vectors,
+						    gsize                      n_vectors,
+						    int                        io_priority,
+						    GCancellable              *cancellable,
+						    GAsyncReadyCallback        callback,
+						    gpointer                   data);
+static gboolean g_output_stream_real_writev_finish (GOutputStream             *stream,
+						    GAsyncResult              *result,
+						    gsize                     *bytes_written,
+						    GError                   **error);
 static gboolean g_output_stream_internal_close     (GOutputStream             *stream,
                                                     GCancellable              *cancellable,
                                                     GError                   **error);
@@ -138,6 +165,9 @@ g_output_stream_class_init (GOutputStreamClass *klass)
   klass->flush_finish = g_output_stream_real_flush_finish;
   klass->close_async = g_output_stream_real_close_async;
   klass->close_finish = g_output_stream_real_close_finish;
+  klass->writev_fn = g_output_stream_real_writev;
+  klass->writev_async = g_output_stream_real_writev_async;
+  klass->writev_finish = g_output_stream_real_writev_finish;
 }
 
 static void
@@ -290,6 +320,216 @@ g_output_stream_write_all (GOutputStream  *stream,
   return TRUE;
 }
 
+gboolean
+g_output_vectors_check_size (const GOutputVector  *vectors,
+                             gsize                 n_vectors,
+                             const gchar          *function,
+                             GError              **error)
+{
+  gsize total = 0;
+  gsize i;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (vectors[i].size > G_MAXSSIZE - total)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                       _("Sum of vectors passed to %s too large"), function);
+          return FALSE;
+        }
+      total += vectors[i].size;
+    }
+
+  return TRUE;
+}
+
+/* Drops the first @n_bytes from @vectors, for the *_all variants. */
+static void
+output_vectors_advance (GOutputVector **vectors,
+                        gsize          *n_vectors,
+                        gsize           n_bytes)
+{
+  while (*n_vectors > 0 && n_bytes >= (*vectors)[0].size)
+    {
+      n_bytes -= (*vectors)[0].size;
+      (*vectors)++;
+      (*n_vectors)--;
+    }
+
+  if (*n_vectors > 0)
+    {
+      (*vectors)[0].buffer = (const guint8 *) (*vectors)[0].buffer + n_bytes;
+      (*vectors)[0].size -= n_bytes;
+    }
+  else
+    g_warn_if_fail (n_bytes == 0);
+}
+
+/**
+ * g_output_stream_writev:
+ * @stream: a #GOutputStream.
+ * @vectors: (array length=n_vectors): the buffers containing the data to write.
+ * @n_vectors: the number of elements in @vectors
+ * @bytes_written: (out) (allow-none): location to store the number of bytes
+ *     that were written to the stream
+ * @cancellable: (allow-none): optional cancellable object
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Tries to write the bytes contained in the @n_vectors @vectors into the
+ * stream, as if they were one buffer. Will block during the operation.
+ *
+ * If @n_vectors is 0 or the sum of all bytes in @vectors is 0, returns
+ * %TRUE and does nothing. If the sum of all bytes in @vectors is larger
+ * than %G_MAXSSIZE, a %G_IO_ERROR_INVALID_ARGUMENT error is returned.
+ *
+ * On success, @bytes_written is set to the number of bytes written to
+ * the stream. As with g_output_stream_write(), this may be less than
+ * the sum of all bytes in @vectors. Streams backed by a file
+ * descriptor or a #GSocket write all the vectors with a single system
+ * call where possible; other streams write them one after the other.
+ *
+ * If @cancellable is not %NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned. If an
+ * operation was partially finished when the operation was cancelled the
+ * partial result will be returned, without an error.
+ *
+ * On error %FALSE is returned, @bytes_written is set to 0 and @error
+ * is set accordingly.
+ *
+ * Virtual: writev_fn
+ *
+ * Return value: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_output_stream_writev (GOutputStream        *stream,
+			const GOutputVector  *vectors,
+			gsize                 n_vectors,
+			gsize                *bytes_written,
+			GCancellable         *cancellable,
+			GError              **error)
+{
+  GOutputStreamClass *class;
+  gsize _bytes_written = 0;
+  gboolean res;
+
+  if (bytes_written)
+    *bytes_written = 0;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+  if (n_vectors == 0)
+    return TRUE;
+
+  if (!g_output_vectors_check_size (vectors, n_vectors, G_STRFUNC, error))
+    return FALSE;
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  if (class->writev_fn == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Output stream doesn't implement writev"));
+      return FALSE;
+    }
+
+  if (!g_output_stream_set_pending (stream, error))
+    return FALSE;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  res = class->writev_fn (stream, vectors, n_vectors, &_bytes_written,
+                          cancellable, error);
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  g_output_stream_clear_pending (stream);
+
+  if (bytes_written)
+    *bytes_written = _bytes_written;
+
+  return res;
+}
+
+/**
+ * g_output_stream_writev_all:
+ * @stream: a #GOutputStream.
+ * @vectors: (array length=n_vectors): the buffers containing the data to write.
+ * @n_vectors: the number of elements in @vectors
+ * @bytes_written: (out) (allow-none): location to store the number of bytes
+ *     that were written to the stream
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Tries to write the bytes contained in the @n_vectors @vectors into the
+ * stream. Will block during the operation.
+ *
+ * This function is similar to g_output_stream_writev(), except it tries to
+ * write as many bytes as requested, only stopping on an error.
+ *
+ * On a successful write of all bytes, %TRUE is returned, and
+ * @bytes_written is set to the sum of all the sizes of @vectors.
+ *
+ * If there is an error during the operation %FALSE is returned and @error
+ * is set to indicate the error status, @bytes_written is updated to contain
+ * the number of bytes written into the stream before the error occurred.
+ *
+ * The elements of @vectors may be changed by this function, to keep
+ * track of what is left to write.
+ *
+ * Return value: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_output_stream_writev_all (GOutputStream  *stream,
+			    GOutputVector  *vectors,
+			    gsize           n_vectors,
+			    gsize          *bytes_written,
+			    GCancellable   *cancellable,
+			    GError        **error)
+{
+  gsize _bytes_written = 0;
+
+  if (bytes_written)
+    *bytes_written = 0;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+  /* skip the empty ones, so that they don't count as a zero write */
+  output_vectors_advance (&vectors, &n_vectors, 0);
+
+  while (n_vectors > 0)
+    {
+      gsize n_written;
+
+      if (!g_output_stream_writev (stream, vectors, n_vectors, &n_written,
+                                   cancellable, error))
+        {
+          if (bytes_written)
+            *bytes_written = _bytes_written;
+          return FALSE;
+        }
+
+      if (n_written == 0)
+        g_warning ("Write returned zero without error");
+
+      _bytes_written += n_written;
+      output_vectors_advance (&vectors, &n_vectors, n_written);
+    }
+
+  if (bytes_written)
+    *bytes_written = _bytes_written;
+
+  return TRUE;
+}
+
 /**
  * g_output_stream_write_bytes:
  * @stream: a #GOutputStream.
@@ -434,6 +674,300 @@ g_output_stream_splice (GOutputStream             *stream,
   return bytes_copied;
 }
 
+static GQuark
+kernel_socket_quark (void)
+{
+  static GQuark quark;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("g-output-stream-kernel-socket");
+
+  return quark;
+}
+
+/*< internal >
+ * g_output_stream_set_kernel_socket:
+ * @stream: a #GOutputStream
+ * @socket: the socket that @stream's data can be written to
+ *
+ * Records that the data written to @stream may instead be written
+ * to @socket directly, for example because a TLS backend has handed
+ * the encryption of @socket's records over to the kernel.
+ */
+void
+g_output_stream_set_kernel_socket (GOutputStream *stream,
+                                   GSocket       *socket)
+{
+  g_object_set_qdata_full (G_OBJECT (stream), kernel_socket_quark (),
+                           g_object_ref (socket), g_object_unref);
+}
+
+GSocket *
+g_output_stream_get_kernel_socket (GOutputStream *stream)
+{
+  return g_object_get_qdata (G_OBJECT (stream), kernel_socket_quark ());
+}
+
+#ifdef __linux__
+/* The descriptor that the kernel can write @stream's data to */
+static int
+g_output_stream_get_sendfile_fd (GOutputStream *stream)
+{
+  GSocket *socket;
+
+  if (G_IS_FILE_DESCRIPTOR_BASED (stream))
+    return g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (stream));
+
+  socket = g_output_stream_get_kernel_socket (stream);
+  if (socket)
+    return g_socket_get_fd (socket);
+
+  return -1;
+}
+
+/* Whether the data of @source can be sent to @stream by the kernel,
+ * without going through a buffer: this works from regular files to
+ * sockets (including those with kernel TLS) and to other file
+ * descriptors.
+ */
+static gboolean
+g_output_stream_can_sendfile (GOutputStream *stream,
+                              GInputStream  *source)
+{
+  struct stat buf;
+
+  if (!G_IS_FILE_DESCRIPTOR_BASED (source) ||
+      g_output_stream_get_sendfile_fd (stream) == -1)
+    return FALSE;
+
+  if (fstat (g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (source)), &buf) != 0)
+    return FALSE;
+
+  return S_ISREG (buf.st_mode);
+}
+
+#ifdef HAVE_SPLICE
+/* Whether the data of @source can be moved to @stream with splice():
+ * that needs both to be file descriptors, at least one of them a pipe.
+ */
+static gboolean
+g_output_stream_can_splice_pipe (GOutputStream *stream,
+                                 GInputStream  *source)
+{
+  struct stat buf_in, buf_out;
+
+  if (!G_IS_FILE_DESCRIPTOR_BASED (source) ||
+      !G_IS_FILE_DESCRIPTOR_BASED (stream))
+    return FALSE;
+
+  if (fstat (g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (source)), &buf_in) != 0 ||
+      fstat (g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (stream)), &buf_out) != 0)
+    return FALSE;
+
+  return S_ISFIFO (buf_in.st_mode) || S_ISFIFO (buf_out.st_mode);
+}
+#endif
+
+static gboolean
+g_output_stream_wait_fd (int            fd,
+                         GIOCondition   condition,
+                         GCancellable  *cancellable,
+                         GError       **error)
+{
+  GPollFD poll_fds[2];
+  gulong cancel_handler;
+  gint nfds;
+  gint result;
+
+  poll_fds[0].fd = fd;
+  poll_fds[0].events = condition;
+  if (g_cancellable_make_thread_pollfd (cancellable, &poll_fds[1],
+                                        &cancel_handler))
+    nfds = 2;
+  else
+    nfds = 1;
+
+  do
+    result = g_poll (poll_fds, nfds, -1);
+  while (result == -1 && errno == EINTR);
+
+  if (nfds == 2)
+    g_cancellable_release_thread_pollfd (cancellable, cancel_handler);
+
+  if (result == -1)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_IO_ERROR,
+                   g_io_error_from_errno (errsv),
+                   _("Error splicing file: %s"),
+                   g_strerror (errsv));
+      return FALSE;
+    }
+
+  return !g_cancellable_set_error_if_cancelled (cancellable, error);
+}
+
+static gboolean
+g_output_stream_wait_writable (GOutputStream  *stream,
+                               int             fd,
+                               GCancellable   *cancellable,
+                               GError        **error)
+{
+  /* this takes care of the socket's timeout */
+  if (G_IS_SOCKET_OUTPUT_STREAM (stream))
+    {
+      GSocket *socket;
+      gboolean ret;
+
+      g_object_get (stream, "socket", &socket, NULL);
+      ret = g_socket_condition_wait (socket, G_IO_OUT, cancellable, error);
+      g_object_unref (socket);
+
+      return ret;
+    }
+  else if (g_output_stream_get_kernel_socket (stream))
+    return g_socket_condition_wait (g_output_stream_get_kernel_socket (stream),
+                                    G_IO_OUT, cancellable, error);
+
+  return g_output_stream_wait_fd (fd, G_IO_OUT, cancellable, error);
+}
+
+/* Sends the rest of @source with sendfile(). Returns the number of
+ * bytes sent, and sets @fallback if the rest of the data has to be
+ * copied by hand.
+ */
+static gssize
+g_output_stream_sendfile (GOutputStream  *stream,
+                          GInputStream   *source,
+                          gboolean       *fallback,
+                          GCancellable   *cancellable,
+                          GError        **error)
+{
+  int fd_in, fd_out;
+  gsize bytes_copied = 0;
+
+  fd_in = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (source));
+  fd_out = g_output_stream_get_sendfile_fd (stream);
+
+  *fallback = FALSE;
+  while (TRUE)
+    {
+      gssize res;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        return -1;
+
+      /* in chunks, to check for cancellation once in a while */
+      res = sendfile (fd_out, fd_in, NULL, 1024 * 1024);
+      if (res > 0)
+        {
+          bytes_copied += res;
+          continue;
+        }
+      else if (res == 0)
+        break;
+
+      if (errno == EINTR)
+        continue;
+      else if (errno == EAGAIN)
+        {
+          if (!g_output_stream_wait_writable (stream, fd_out, cancellable, error))
+            return -1;
+        }
+      else if (errno == EINVAL || errno == ENOSYS)
+        {
+          /* the file position is where sendfile() stopped */
+          *fallback = TRUE;
+          break;
+        }
+      else
+        {
+          int errsv = errno;
+
+          g_set_error (error, G_IO_ERROR,
+                       g_io_error_from_errno (errsv),
+                       _("Error splicing file: %s"),
+                       g_strerror (errsv));
+          return -1;
+        }
+    }
+
+  return MIN (bytes_copied, G_MAXSSIZE);
+}
+
+#ifdef HAVE_SPLICE
+/* Moves the rest of @source to @stream with splice(), so that the data
+ * never has to be copied to and from userspace. The pipe ends are
+ * driven non-blocking so that we can notice cancellation. Returns the
+ * number of bytes moved, and sets @fallback if the rest of the data
+ * has to be copied by hand.
+ */
+static gssize
+g_output_stream_splice_pipe (GOutputStream  *stream,
+                             GInputStream   *source,
+                             gboolean       *fallback,
+                             GCancellable   *cancellable,
+                             GError        **error)
+{
+  int fd_in, fd_out;
+  gsize bytes_copied = 0;
+
+  fd_in = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (source));
+  fd_out = g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (stream));
+
+  *fallback = FALSE;
+  while (TRUE)
+    {
+      gssize res;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        return -1;
+
+      res = splice (fd_in, NULL, fd_out, NULL, 1024 * 1024,
+                    SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+      if (res > 0)
+        {
+          bytes_copied += res;
+          continue;
+        }
+      else if (res == 0)
+        break;
+
+      if (errno == EINTR)
+        continue;
+      else if (errno == EAGAIN)
+        {
+          /* We can't tell which side would have blocked, so wait for
+           * the input first; if it has data, it's the output.
+           */
+          if (!g_output_stream_wait_fd (fd_in, G_IO_IN, cancellable, error) ||
+              !g_output_stream_wait_fd (fd_out, G_IO_OUT, cancellable, error))
+            return -1;
+        }
+      else if (errno == EINVAL || errno == ENOSYS)
+        {
+          /* Nothing was consumed by the failed call */
+          *fallback = TRUE;
+          break;
+        }
+      else
+        {
+          int errsv = errno;
+
+          g_set_error (error, G_IO_ERROR,
+                       g_io_error_from_errno (errsv),
+                       _("Error splicing file: %s"),
+                       g_strerror (errsv));
+          return -1;
+        }
+    }
+
+  return MIN (bytes_copied, G_MAXSSIZE);
+}
+#endif
+#endif
+
 static gssize
 g_output_stream_real_splice (GOutputStream             *stream,
                              GInputStream              *source,
@@ -453,10 +987,51 @@ g_output_stream_real_splice (GOutputStream             *stream,
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
                            _("Output stream doesn't implement write"));
       res = FALSE;
-      goto notsupported;
+      goto out;
     }
 
   res = TRUE;
+
+#ifdef __linux__
+#ifdef HAVE_SPLICE
+  if (g_output_stream_can_splice_pipe (stream, source))
+    {
+      gboolean fallback;
+      gssize sent;
+
+      sent = g_output_stream_splice_pipe (stream, source, &fallback,
+                                          cancellable, error);
+      if (sent == -1)
+        {
+          res = FALSE;
+          goto out;
+        }
+
+      bytes_copied = sent;
+      if (!fallback)
+        goto out;
+    }
+  else
+#endif
+  if (g_output_stream_can_sendfile (stream, source))
+    {
+      gboolean fallback;
+      gssize sent;
+
+      sent = g_output_stream_sendfile (stream, source, &fallback,
+                                       cancellable, error);
+      if (sent == -1)
+        {
+          res = FALSE;
+          goto out;
+        }
+
+      bytes_copied = sent;
+      if (!fallback)
+        goto out;
+    }
+#endif
+
   do
     {
       n_read = g_input_stream_read (source, buffer, sizeof (buffer), cancellable, error);
@@ -489,7 +1064,7 @@ g_output_stream_real_splice (GOutputStream             *stream,
     }
   while (res);
 
- notsupported:
+ out:
   if (!res)
     error = NULL; /* Ignore further errors */
 
@@ -854,6 +1429,287 @@ g_output_stream_write_bytes_finish (GOutputStream  *stream,
   return g_task_propagate_int (G_TASK (result), error);
 }
 
+static void
+async_ready_writev_callback_wrapper (GObject      *source_object,
+                                     GAsyncResult *res,
+                                     gpointer      user_data)
+{
+  GOutputStream *stream = G_OUTPUT_STREAM (source_object);
+  GOutputStreamClass *class;
+  GTask *task = user_data;
+  gsize bytes_written = 0;
+  GError *error = NULL;
+
+  g_output_stream_clear_pending (stream);
+
+  if (!g_async_result_legacy_propagate_error (res, &error))
+    {
+      class = G_OUTPUT_STREAM_GET_CLASS (stream);
+      class->writev_finish (stream, res, &bytes_written, &error);
+    }
+
+  if (error == NULL)
+    g_task_return_int (task, bytes_written);
+  else
+    g_task_return_error (task, error);
+  g_object_unref (task);
+}
+
+/**
+ * g_output_stream_writev_async:
+ * @stream: A #GOutputStream.
+ * @vectors: (array length=n_vectors): the buffers containing the data to write.
+ * @n_vectors: the number of elements in @vectors
+ * @io_priority: the io priority of the request.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): callback to call when the request is satisfied
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Request an asynchronous write of the bytes contained in @n_vectors
+ * @vectors into the stream. When the operation is finished @callback
+ * will be called. You can then call g_output_stream_writev_finish() to
+ * get the result of the operation.
+ *
+ * This is the asynchronous version of g_output_stream_writev(), and
+ * otherwise works like g_output_stream_write_async(). @vectors and
+ * the buffers it points to must stay valid until the operation is
+ * finished.
+ *
+ * The default implementation writes all the vectors at once with a
+ * non-blocking write if @stream is a pollable #GPollableOutputStream,
+ * and calls g_output_stream_writev() in a thread otherwise.
+ *
+ * Since: 2.40
+ */
+void
+g_output_stream_writev_async (GOutputStream       *stream,
+			      const GOutputVector *vectors,
+			      gsize                n_vectors,
+			      int                  io_priority,
+			      GCancellable        *cancellable,
+			      GAsyncReadyCallback  callback,
+			      gpointer             user_data)
+{
+  GOutputStreamClass *class;
+  GError *error = NULL;
+  GTask *task;
+
+  g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+  g_return_if_fail (vectors != NULL || n_vectors == 0);
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_output_stream_writev_async);
+  g_task_set_priority (task, io_priority);
+
+  if (n_vectors == 0)
+    {
+      g_task_return_int (task, 0);
+      g_object_unref (task);
+      return;
+    }
+
+  if (!g_output_vectors_check_size (vectors, n_vectors, G_STRFUNC, &error) ||
+      !g_output_stream_set_pending (stream, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  class->writev_async (stream, vectors, n_vectors, io_priority, cancellable,
+                       async_ready_writev_callback_wrapper, task);
+}
+
+/**
+ * g_output_stream_writev_finish:
+ * @stream: a #GOutputStream.
+ * @result: a #GAsyncResult.
+ * @bytes_written: (out) (allow-none): location to store the number of bytes
+ *     that were written to the stream
+ * @error: a #GError location to store the error occurring, or %NULL to
+ * ignore.
+ *
+ * Finishes a stream writev operation.
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_output_stream_writev_finish (GOutputStream  *stream,
+                               GAsyncResult   *result,
+                               gsize          *bytes_written,
+                               GError        **error)
+{
+  gssize res;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+  g_return_val_if_fail (g_async_result_is_tagged (result, g_output_stream_writev_async), FALSE);
+
+  res = g_task_propagate_int (G_TASK (result), error);
+  if (bytes_written)
+    *bytes_written = MAX (res, 0);
+
+  return res != -1;
+}
+
+typedef struct
+{
+  GOutputVector *vectors;
+  gsize n_vectors;
+  gsize bytes_written;
+} WritevAllData;
+
+static void
+free_writev_all_data (WritevAllData *data)
+{
+  g_slice_free (WritevAllData, data);
+}
+
+static void writev_all_async_next (GTask *task);
+
+static void
+writev_all_callback (GObject      *stream,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  GTask *task = user_data;
+  WritevAllData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+  gsize n_written;
+
+  if (!g_output_stream_writev_finish (G_OUTPUT_STREAM (stream), result,
+                                      &n_written, &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  if (n_written == 0)
+    g_warning ("Write returned zero without error");
+
+  data->bytes_written += n_written;
+  output_vectors_advance (&data->vectors, &data->n_vectors, n_written);
+
+  writev_all_async_next (task);
+}
+
+static void
+writev_all_async_next (GTask *task)
+{
+  WritevAllData *data = g_task_get_task_data (task);
+
+  if (data->n_vectors == 0)
+    {
+      g_task_return_boolean (task, TRUE);
+      g_object_unref (task);
+      return;
+    }
+
+  g_output_stream_writev_async (g_task_get_source_object (task),
+                                data->vectors, data->n_vectors,
+                                g_task_get_priority (task),
+                                g_task_get_cancellable (task),
+                                writev_all_callback, task);
+}
+
+/**
+ * g_output_stream_writev_all_async:
+ * @stream: A #GOutputStream.
+ * @vectors: (array length=n_vectors): the buffers containing the data to write.
+ * @n_vectors: the number of elements in @vectors
+ * @io_priority: the io priority of the request.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): callback to call when the request is satisfied
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Request an asynchronous write of all the bytes contained in
+ * @n_vectors @vectors into the stream. When the operation is finished
+ * @callback will be called. You can then call
+ * g_output_stream_writev_all_finish() to get the result of the operation.
+ *
+ * This is the asynchronous version of g_output_stream_writev_all(). As
+ * with that function, the elements of @vectors may be changed, and
+ * @vectors must stay valid until the operation is finished.
+ *
+ * Since: 2.40
+ */
+void
+g_output_stream_writev_all_async (GOutputStream       *stream,
+				  GOutputVector       *vectors,
+				  gsize                n_vectors,
+				  int                  io_priority,
+				  GCancellable        *cancellable,
+				  GAsyncReadyCallback  callback,
+				  gpointer             user_data)
+{
+  WritevAllData *data;
+  GTask *task;
+
+  g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+  g_return_if_fail (vectors != NULL || n_vectors == 0);
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_output_stream_writev_all_async);
+  g_task_set_priority (task, io_priority);
+
+  data = g_slice_new0 (WritevAllData);
+  data->vectors = vectors;
+  data->n_vectors = n_vectors;
+  g_task_set_task_data (task, data, (GDestroyNotify) free_writev_all_data);
+
+  /* skip the empty ones, so that they don't count as a zero write */
+  output_vectors_advance (&data->vectors, &data->n_vectors, 0);
+
+  writev_all_async_next (task);
+}
+
+/**
+ * g_output_stream_writev_all_finish:
+ * @stream: a #GOutputStream.
+ * @result: a #GAsyncResult.
+ * @bytes_written: (out) (allow-none): location to store the number of bytes
+ *     that were written to the stream
+ * @error: a #GError location to store the error occurring, or %NULL to
+ * ignore.
+ *
+ * Finishes an asynchronous stream write operation started with
+ * g_output_stream_writev_all_async(). As with
+ * g_output_stream_writev_all(), @bytes_written is set to the number of
+ * bytes that were written before an error, if there was one.
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_output_stream_writev_all_finish (GOutputStream  *stream,
+                                   GAsyncResult   *result,
+                                   gsize          *bytes_written,
+                                   GError        **error)
+{
+  GTask *task;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+  g_return_val_if_fail (g_async_result_is_tagged (result, g_output_stream_writev_all_async), FALSE);
+
+  task = G_TASK (result);
+
+  if (bytes_written)
+    {
+      WritevAllData *data = g_task_get_task_data (task);
+
+      *bytes_written = data->bytes_written;
+    }
+
+  return g_task_propagate_boolean (task, error);
+}
+
 static void
 async_ready_splice_callback_wrapper (GObject      *source_object,
                                      GAsyncResult *res,
@@ -1536,6 +2392,182 @@ g_output_stream_real_write_finish (GOutputStream  *stream,
   return g_task_propagate_int (G_TASK (result), error);
 }
 
+static gboolean
+g_output_stream_real_writev (GOutputStream        *stream,
+                             const GOutputVector  *vectors,
+                             gsize                 n_vectors,
+                             gsize                *bytes_written,
+                             GCancellable         *cancellable,
+                             GError              **error)
+{
+  GOutputStreamClass *class;
+  gsize _bytes_written = 0;
+  gsize i;
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  if (class->write_fn == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Output stream doesn't implement write"));
+      return FALSE;
+    }
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      GError *err = NULL;
+      gssize res;
+
+      if (vectors[i].size == 0)
+        continue;
+
+      res = class->write_fn (stream, vectors[i].buffer, vectors[i].size,
+                             cancellable, &err);
+      if (res == -1)
+        {
+          /* a partial write, the error comes back on the next call */
+          if (_bytes_written > 0)
+            {
+              g_error_free (err);
+              break;
+            }
+
+          g_propagate_error (error, err);
+          return FALSE;
+        }
+
+      _bytes_written += res;
+      if ((gsize) res < vectors[i].size)
+        break;
+    }
+
+  *bytes_written = _bytes_written;
+
+  return TRUE;
+}
+
+typedef struct {
+  const GOutputVector *vectors;
+  gsize                n_vectors;
+} WritevData;
+
+static void
+free_writev_data (WritevData *op)
+{
+  g_slice_free (WritevData, op);
+}
+
+static void
+writev_async_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+  GOutputStream *stream = source_object;
+  WritevData *op = task_data;
+  GOutputStreamClass *class;
+  GError *error = NULL;
+  gsize bytes_written;
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+  if (class->writev_fn (stream, op->vectors, op->n_vectors, &bytes_written,
+                        cancellable, &error))
+    g_task_return_int (task, bytes_written);
+  else
+    g_task_return_error (task, error);
+}
+
+static void writev_async_pollable (GPollableOutputStream *stream,
+                                   GTask                 *task);
+
+static gboolean
+writev_async_pollable_ready (GPollableOutputStream *stream,
+			     gpointer               user_data)
+{
+  GTask *task = user_data;
+
+  writev_async_pollable (stream, task);
+  return FALSE;
+}
+
+static void
+writev_async_pollable (GPollableOutputStream *stream,
+                       GTask                 *task)
+{
+  GError *error = NULL;
+  WritevData *op = g_task_get_task_data (task);
+  gsize bytes_written;
+  gboolean res;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  res = G_POLLABLE_OUTPUT_STREAM_GET_INTERFACE (stream)->
+    writev_nonblocking (stream, op->vectors, op->n_vectors, &bytes_written, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+    {
+      GSource *source;
+
+      g_error_free (error);
+
+      source = g_pollable_output_stream_create_source (stream,
+                                                       g_task_get_cancellable (task));
+      g_task_attach_source (task, source,
+                            (GSourceFunc) writev_async_pollable_ready);
+      g_source_unref (source);
+      return;
+    }
+
+  if (res)
+    g_task_return_int (task, bytes_written);
+  else
+    g_task_return_error (task, error);
+}
+
+static void
+g_output_stream_real_writev_async (GOutputStream       *stream,
+                                   const GOutputVector *vectors,
+                                   gsize                n_vectors,
+                                   int                  io_priority,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  GTask *task;
+  WritevData *op;
+
+  op = g_slice_new0 (WritevData);
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_check_cancellable (task, FALSE);
+  g_task_set_task_data (task, op, (GDestroyNotify) free_writev_data);
+  op->vectors = vectors;
+  op->n_vectors = n_vectors;
+
+  if (G_IS_POLLABLE_OUTPUT_STREAM (stream) &&
+      g_pollable_output_stream_can_poll (G_POLLABLE_OUTPUT_STREAM (stream)))
+    writev_async_pollable (G_POLLABLE_OUTPUT_STREAM (stream), task);
+  else
+    g_task_run_in_thread (task, writev_async_thread);
+  g_object_unref (task);
+}
+
+static gboolean
+g_output_stream_real_writev_finish (GOutputStream  *stream,
+                                    GAsyncResult   *result,
+                                    gsize          *bytes_written,
+                                    GError        **error)
+{
+  gssize res;
+
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+
+  res = g_task_propagate_int (G_TASK (result), error);
+  *bytes_written = MAX (res, 0);
+
+  return res != -1;
+}
+
 typedef struct {
   GInputStream *source;
   GOutputStreamSpliceFlags flags;
@@ -1752,8 +2784,20 @@ g_output_stream_real_splice_async (GOutputStream             *stream,
   op->flags = flags;
   op->source = g_object_ref (source);
 
-  if (g_input_stream_async_read_is_via_threads (source) &&
-      g_output_stream_async_write_is_via_threads (stream))
+  /* A sendfile() or splice() in a thread beats copying everything
+   * through the main loop.
+   */
+  if ((g_input_stream_async_read_is_via_threads (source) &&
+       g_output_stream_async_write_is_via_threads (stream))
+#ifdef __linux__
+      || (G_OUTPUT_STREAM_GET_CLASS (stream)->splice == g_output_stream_real_splice &&
+          (g_output_stream_can_sendfile (stream, source)
+#ifdef HAVE_SPLICE
+           || g_output_stream_can_splice_pipe (stream, source)
+#endif
+           ))
+#endif
+      )
     {
       g_task_run_in_thread (task, splice_async_thread);
       g_object_unref (task);
@@ -24,6 +24,7 @@
 
 #include "gpollableinputstream.h"
 #include "gasynchelper.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 /**
@@ -47,12 +48,18 @@ static gssize   g_pollable_input_stream_default_read_nonblocking (GPollableInput
 								  void                  *buffer,
 								  gsize                  count,
 								  GError               **error);
+static gboolean g_pollable_input_stream_default_readv_nonblocking (GPollableInputStream  *stream,
+								   const GInputVector    *vectors,
+								   gsize                  n_vectors,
+								   gsize                 *bytes_read,
+								   GError               **error);
 
 static void
 g_pollable_input_stream_default_init (GPollableInputStreamInterface *iface)
 {
-  iface->can_poll         = g_pollable_input_stream_default_can_poll;
-  iface->read_nonblocking = g_pollable_input_stream_default_read_nonblocking;
+  iface->can_poll          = g_pollable_input_stream_default_can_poll;
+  iface->read_nonblocking  = g_pollable_input_stream_default_read_nonblocking;
+  iface->readv_nonblocking = g_pollable_input_stream_default_readv_nonblocking;
 }
 
 static gboolean
@@ -219,3 +226,121 @@ g_pollable_input_stream_read_nonblocking (GPollableInputStream  *stream,
 
   return res;
 }
+
+static gboolean
+g_pollable_input_stream_default_readv_nonblocking (GPollableInputStream  *stream,
+						   const GInputVector    *vectors,
+						   gsize                  n_vectors,
+						   gsize                 *bytes_read,
+						   GError               **error)
+{
+  GPollableInputStreamInterface *iface = G_POLLABLE_INPUT_STREAM_GET_INTERFACE (stream);
+  gsize _bytes_read = 0;
+  gsize i;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      GError *err = NULL;
+      gssize res;
+
+      if (vectors[i].size == 0)
+        continue;
+
+      res = iface->read_nonblocking (stream, vectors[i].buffer, vectors[i].size, &err);
+      if (res == -1)
+        {
+          /* report what was read so far, the error comes back
+           * on the next call
+           */
+          if (_bytes_read > 0)
+            {
+              g_error_free (err);
+              break;
+            }
+
+          g_propagate_error (error, err);
+          *bytes_read = 0;
+          return FALSE;
+        }
+
+      _bytes_read += res;
+      if ((gsize) res < vectors[i].size)
+        break;
+    }
+
+  *bytes_read = _bytes_read;
+  return TRUE;
+}
+
+/**
+ * g_pollable_input_stream_readv_nonblocking:
+ * @stream: a #GPollableInputStream
+ * @vectors: (array length=n_vectors): the buffers to read data into
+ * @n_vectors: the number of elements in @vectors
+ * @bytes_read: (out) (allow-none): location to store the number of
+ *     bytes that were read from the stream
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: #GError for error reporting, or %NULL to ignore.
+ *
+ * Attempts to read from @stream into the @n_vectors buffers in
+ * @vectors, as with g_input_stream_readv(). If @stream is not
+ * currently readable, this will immediately return
+ * %G_IO_ERROR_WOULD_BLOCK, and you can use
+ * g_pollable_input_stream_create_source() to create a #GSource
+ * that will be triggered when @stream is readable.
+ *
+ * As with g_pollable_input_stream_read_nonblocking(), @cancellable
+ * can not actually cancel the operation.
+ *
+ * Virtual: readv_nonblocking
+ * Return value: %TRUE on success, %FALSE if there was an error
+ *   (including %G_IO_ERROR_WOULD_BLOCK).
+ *
+ * Since: 2.40
+ */
+gboolean
+g_pollable_input_stream_readv_nonblocking (GPollableInputStream  *stream,
+					   const GInputVector    *vectors,
+					   gsize                  n_vectors,
+					   gsize                 *bytes_read,
+					   GCancellable          *cancellable,
+					   GError               **error)
+{
+  gsize _bytes_read = 0;
+  gboolean res;
+
+  if (bytes_read)
+    *bytes_read = 0;
+
+  g_return_val_if_fail (G_IS_POLLABLE_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
+
+  /* trailing empty vectors would make a zero-length read look
+   * like end of file
+   */
+  while (n_vectors > 0 && vectors[n_vectors - 1].size == 0)
+    n_vectors--;
+
+  if (n_vectors == 0)
+    return TRUE;
+
+  if (!g_input_vectors_check_size (vectors, n_vectors, G_STRFUNC, error))
+    return FALSE;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  res = G_POLLABLE_INPUT_STREAM_GET_INTERFACE (stream)->
+    readv_nonblocking (stream, vectors, n_vectors, &_bytes_read, error);
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  if (bytes_read)
+    *bytes_read = _bytes_read;
+
+  return res;
+}
@@ -51,6 +51,8 @@ typedef struct _GPollableInputStreamInterface GPollableInputStreamInterface;
  * @create_source: Creates a #GSource to poll the stream
  * @read_nonblocking: Does a non-blocking read or returns
  *   %G_IO_ERROR_WOULD_BLOCK
+ * @readv_nonblocking: Does a vectored non-blocking read, or returns
+ *   %G_IO_ERROR_WOULD_BLOCK. Since 2.40.
  *
  * The interface for pollable input streams.
  *
@@ -63,6 +65,9 @@ typedef struct _GPollableInputStreamInterface GPollableInputStreamInterface;
  * implementation may return %TRUE when the stream is not actually
  * readable.
  *
+ * The default implementation of @readv_nonblocking calls
+ * @read_nonblocking for each vector in turn.
+ *
  * Since: 2.28
  */
 struct _GPollableInputStreamInterface
@@ -79,6 +84,11 @@ struct _GPollableInputStreamInterface
 				    void                  *buffer,
 				    gsize                  count,
 				    GError               **error);
+  gboolean     (*readv_nonblocking) (GPollableInputStream  *stream,
+				     const GInputVector    *vectors,
+				     gsize                  n_vectors,
+				     gsize                 *bytes_read,
+				     GError               **error);
 };
 
 GLIB_AVAILABLE_IN_ALL
@@ -99,6 +109,13 @@ gssize   g_pollable_input_stream_read_nonblocking (GPollableInputStream  *stream
 						   gsize                  count,
 						   GCancellable          *cancellable,
 						   GError               **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_pollable_input_stream_readv_nonblocking (GPollableInputStream  *stream,
+						    const GInputVector    *vectors,
+						    gsize                  n_vectors,
+						    gsize                 *bytes_read,
+						    GCancellable          *cancellable,
+						    GError               **error);
 
 G_END_DECLS
 
@@ -25,6 +25,7 @@
 #include "gpollableoutputstream.h"
 #include "gasynchelper.h"
 #include "gfiledescriptorbased.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 /**
@@ -48,12 +49,18 @@ static gssize   g_pollable_output_stream_default_write_nonblocking (GPollableOut
 								    const void             *buffer,
 								    gsize                   count,
 								    GError                **error);
+static gboolean g_pollable_output_stream_default_writev_nonblocking (GPollableOutputStream  *stream,
+								     const GOutputVector    *vectors,
+								     gsize                   n_vectors,
+								     gsize                  *bytes_written,
+								     GError                **error);
 
 static void
 g_pollable_output_stream_default_init (GPollableOutputStreamInterface *iface)
 {
-  iface->can_poll          = g_pollable_output_stream_default_can_poll;
-  iface->write_nonblocking = g_pollable_output_stream_default_write_nonblocking;
+  iface->can_poll           = g_pollable_output_stream_default_can_poll;
+  iface->write_nonblocking  = g_pollable_output_stream_default_write_nonblocking;
+  iface->writev_nonblocking = g_pollable_output_stream_default_writev_nonblocking;
 }
 
 static gboolean
@@ -220,3 +227,116 @@ g_pollable_output_stream_write_nonblocking (GPollableOutputStream  *stream,
 
   return res;
 }
+
+static gboolean
+g_pollable_output_stream_default_writev_nonblocking (GPollableOutputStream  *stream,
+						     const GOutputVector    *vectors,
+						     gsize                   n_vectors,
+						     gsize                  *bytes_written,
+						     GError                **error)
+{
+  GPollableOutputStreamInterface *iface = G_POLLABLE_OUTPUT_STREAM_GET_INTERFACE (stream);
+  gsize _bytes_written = 0;
+  gsize i;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      GError *err = NULL;
+      gssize res;
+
+      if (vectors[i].size == 0)
+        continue;
+
+      res = iface->write_nonblocking (stream, vectors[i].buffer, vectors[i].size, &err);
+      if (res == -1)
+        {
+          /* report what was written so far, the error comes back
+           * on the next call
+           */
+          if (_bytes_written > 0)
+            {
+              g_error_free (err);
+              break;
+            }
+
+          g_propagate_error (error, err);
+          *bytes_written = 0;
+          return FALSE;
+        }
+
+      _bytes_written += res;
+      if ((gsize) res < vectors[i].size)
+        break;
+    }
+
+  *bytes_written = _bytes_written;
+  return TRUE;
+}
+
+/**
+ * g_pollable_output_stream_writev_nonblocking:
+ * @stream: a #GPollableOutputStream
+ * @vectors: (array length=n_vectors): the buffers containing the data
+ *     to write
+ * @n_vectors: the number of elements in @vectors
+ * @bytes_written: (out) (allow-none): location to store the number of
+ *     bytes that were written to the stream
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: #GError for error reporting, or %NULL to ignore.
+ *
+ * Attempts to write the bytes contained in the @n_vectors @vectors to
+ * @stream, as with g_output_stream_writev(). If @stream is not
+ * currently writable, this will immediately return
+ * %G_IO_ERROR_WOULD_BLOCK, and you can use
+ * g_pollable_output_stream_create_source() to create a #GSource
+ * that will be triggered when @stream is writable.
+ *
+ * As with g_pollable_output_stream_write_nonblocking(), @cancellable
+ * can not actually cancel the operation.
+ *
+ * Virtual: writev_nonblocking
+ * Return value: %TRUE on success, %FALSE if there was an error
+ *   (including %G_IO_ERROR_WOULD_BLOCK).
+ *
+ * Since: 2.40
+ */
+gboolean
+g_pollable_output_stream_writev_nonblocking (GPollableOutputStream  *stream,
+					     const GOutputVector    *vectors,
+					     gsize                   n_vectors,
+					     gsize                  *bytes_written,
+					     GCancellable           *cancellable,
+					     GError                **error)
+{
+  gsize _bytes_written = 0;
+  gboolean res;
+
+  if (bytes_written)
+    *bytes_written = 0;
+
+  g_return_val_if_fail (G_IS_POLLABLE_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return FALSE;
+
+  if (n_vectors == 0)
+    return TRUE;
+
+  if (!g_output_vectors_check_size (vectors, n_vectors, G_STRFUNC, error))
+    return FALSE;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  res = G_POLLABLE_OUTPUT_STREAM_GET_INTERFACE (stream)->
+    writev_nonblocking (stream, vectors, n_vectors, &_bytes_written, error);
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  if (bytes_written)
+    *bytes_written = _bytes_written;
+
+  return res;
+}
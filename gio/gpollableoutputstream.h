@@ -51,6 +51,8 @@ typedef struct _GPollableOutputStreamInterface GPollableOutputStreamInterface;
  * @create_source: Creates a #GSource to poll the stream
  * @write_nonblocking: Does a non-blocking write or returns
  *   %G_IO_ERROR_WOULD_BLOCK
+ * @writev_nonblocking: Does a vectored non-blocking write, or returns
+ *   %G_IO_ERROR_WOULD_BLOCK. Since 2.40.
  *
  * The interface for pollable output streams.
  *
@@ -63,6 +65,9 @@ typedef struct _GPollableOutputStreamInterface GPollableOutputStreamInterface;
  * implementation may return %TRUE when the stream is not actually
  * writable.
  *
+ * The default implementation of @writev_nonblocking calls
+ * @write_nonblocking for each vector in turn.
+ *
  * Since: 2.28
  */
 struct _GPollableOutputStreamInterface
@@ -79,6 +84,11 @@ struct _GPollableOutputStreamInterface
 				     const void             *buffer,
 				     gsize                   count,
 				     GError                **error);
+  gboolean     (*writev_nonblocking) (GPollableOutputStream  *stream,
+				      const GOutputVector    *vectors,
+				      gsize                   n_vectors,
+				      gsize                  *bytes_written,
+				      GError                **error);
 };
 
 GLIB_AVAILABLE_IN_ALL
@@ -99,6 +109,13 @@ gssize   g_pollable_output_stream_write_nonblocking (GPollableOutputStream  *str
 						     gsize                   count,
 						     GCancellable           *cancellable,
 						     GError                **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_pollable_output_stream_writev_nonblocking (GPollableOutputStream  *stream,
+						      const GOutputVector    *vectors,
+						      gsize                   n_vectors,
+						      gsize                  *bytes_written,
+						      GCancellable           *cancellable,
+						      GError                **error);
 
 G_END_DECLS
 
@@ -32,6 +32,8 @@
 #include "giomodule.h"
 #include "giomodule-priv.h"
 #include "gsimpleasyncresult.h"
+#include "gnetworkingprivate.h"
+#include "gtask.h"
 
 /**
  * SECTION:gproxyresolver
@@ -45,6 +47,173 @@
 
 G_DEFINE_INTERFACE (GProxyResolver, g_proxy_resolver, G_TYPE_OBJECT)
 
+/* Resolvers may have to evaluate a PAC script or ask another process
+ * for every lookup, while the answer for a given scheme, host and port
+ * rarely changes. The default resolver and #GSimpleProxyResolver keep
+ * successful results for a few seconds; implementations clear them
+ * with g_proxy_resolver_invalidate_cache() when their settings change.
+ */
+#define PROXY_CACHE_TTL         (5 * G_TIME_SPAN_SECOND)
+#define PROXY_CACHE_MAX_ENTRIES 128
+
+typedef struct {
+  GMutex lock;
+  GHashTable *entries;
+} ProxyCache;
+
+typedef struct {
+  gchar **proxies;
+  gint64 expiry;
+} ProxyCacheEntry;
+
+static GQuark
+proxy_cache_quark (void)
+{
+  static GQuark quark;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("g-proxy-resolver-cache");
+
+  return quark;
+}
+
+static void
+proxy_cache_entry_free (gpointer data)
+{
+  ProxyCacheEntry *entry = data;
+
+  g_strfreev (entry->proxies);
+  g_slice_free (ProxyCacheEntry, entry);
+}
+
+static void
+proxy_cache_free (gpointer data)
+{
+  ProxyCache *cache = data;
+
+  g_hash_table_unref (cache->entries);
+  g_mutex_clear (&cache->lock);
+  g_slice_free (ProxyCache, cache);
+}
+
+/*< internal >
+ * _g_proxy_resolver_enable_cache:
+ * @resolver: a #GProxyResolver
+ *
+ * Makes the lookup functions cache the results of @resolver.
+ */
+void
+_g_proxy_resolver_enable_cache (GProxyResolver *resolver)
+{
+  static GMutex enable_lock;
+  ProxyCache *cache;
+
+  g_mutex_lock (&enable_lock);
+  if (g_object_get_qdata (G_OBJECT (resolver), proxy_cache_quark ()) == NULL)
+    {
+      cache = g_slice_new (ProxyCache);
+      g_mutex_init (&cache->lock);
+      cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, proxy_cache_entry_free);
+      g_object_set_qdata_full (G_OBJECT (resolver), proxy_cache_quark (),
+                               cache, proxy_cache_free);
+    }
+  g_mutex_unlock (&enable_lock);
+}
+
+/* Returns the cache key for @uri, or %NULL if @resolver's results are
+ * not cached or @uri has no host to key them on.
+ */
+static gchar *
+proxy_cache_key (GProxyResolver  *resolver,
+                 const gchar     *uri,
+                 ProxyCache     **cache)
+{
+  gchar *scheme, *host, *key;
+  guint16 port;
+
+  *cache = g_object_get_qdata (G_OBJECT (resolver), proxy_cache_quark ());
+  if (*cache == NULL)
+    return NULL;
+
+  scheme = g_uri_parse_scheme (uri);
+  if (scheme == NULL)
+    return NULL;
+
+  if (!_g_uri_parse_authority (uri, &host, &port, NULL) || host == NULL)
+    {
+      g_free (scheme);
+      return NULL;
+    }
+
+  key = g_strdup_printf ("%s://%s:%u", scheme, host, port);
+  g_free (scheme);
+  g_free (host);
+
+  return g_ascii_strdown (key, -1);
+}
+
+static gchar **
+proxy_cache_lookup (ProxyCache  *cache,
+                    const gchar *key)
+{
+  ProxyCacheEntry *entry;
+  gchar **proxies = NULL;
+
+  g_mutex_lock (&cache->lock);
+  entry = g_hash_table_lookup (cache->entries, key);
+  if (entry && entry->expiry > g_get_monotonic_time ())
+    proxies = g_strdupv (entry->proxies);
+  g_mutex_unlock (&cache->lock);
+
+  return proxies;
+}
+
+static void
+proxy_cache_insert (ProxyCache   *cache,
+                    const gchar  *key,
+                    gchar       **proxies)
+{
+  ProxyCacheEntry *entry;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&cache->lock);
+
+  if (g_hash_table_size (cache->entries) >= PROXY_CACHE_MAX_ENTRIES)
+    {
+      GHashTableIter iter;
+
+      g_hash_table_iter_init (&iter, cache->entries);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+        if (entry->expiry <= now)
+          g_hash_table_iter_remove (&iter);
+
+      if (g_hash_table_size (cache->entries) >= PROXY_CACHE_MAX_ENTRIES)
+        g_hash_table_remove_all (cache->entries);
+    }
+
+  entry = g_slice_new (ProxyCacheEntry);
+  entry->proxies = g_strdupv (proxies);
+  entry->expiry = now + PROXY_CACHE_TTL;
+  g_hash_table_replace (cache->entries, g_strdup (key), entry);
+
+  g_mutex_unlock (&cache->lock);
+}
+
+typedef struct {
+  ProxyCache *cache;
+  gchar *key;
+} ProxyCacheLookup;
+
+static void
+proxy_cache_lookup_free (gpointer data)
+{
+  ProxyCacheLookup *lookup = data;
+
+  g_free (lookup->key);
+  g_slice_free (ProxyCacheLookup, lookup);
+}
+
 static void
 g_proxy_resolver_default_init (GProxyResolverInterface *iface)
 {
@@ -62,9 +231,20 @@ g_proxy_resolver_default_init (GProxyResolverInterface *iface)
 GProxyResolver *
 g_proxy_resolver_get_default (void)
 {
-  return _g_io_module_get_default (G_PROXY_RESOLVER_EXTENSION_POINT_NAME,
-				   "GIO_USE_PROXY_RESOLVER",
-				   (GIOModuleVerifyFunc)g_proxy_resolver_is_supported);
+  static gsize cache_enabled;
+  GProxyResolver *resolver;
+
+  resolver = _g_io_module_get_default (G_PROXY_RESOLVER_EXTENSION_POINT_NAME,
+				       "GIO_USE_PROXY_RESOLVER",
+				       (GIOModuleVerifyFunc)g_proxy_resolver_is_supported);
+
+  if (resolver && g_once_init_enter (&cache_enabled))
+    {
+      _g_proxy_resolver_enable_cache (resolver);
+      g_once_init_leave (&cache_enabled, 1);
+    }
+
+  return resolver;
 }
 
 /**
@@ -127,13 +307,55 @@ g_proxy_resolver_lookup (GProxyResolver  *resolver,
 			 GError         **error)
 {
   GProxyResolverInterface *iface;
+  ProxyCache *cache;
+  gchar **proxies;
+  gchar *key;
 
   g_return_val_if_fail (G_IS_PROXY_RESOLVER (resolver), NULL);
   g_return_val_if_fail (uri != NULL, NULL);
 
+  key = proxy_cache_key (resolver, uri, &cache);
+  if (key)
+    {
+      proxies = proxy_cache_lookup (cache, key);
+      if (proxies)
+        {
+          g_free (key);
+          return proxies;
+        }
+    }
+
   iface = G_PROXY_RESOLVER_GET_IFACE (resolver);
 
-  return (* iface->lookup) (resolver, uri, cancellable, error);
+  proxies = (* iface->lookup) (resolver, uri, cancellable, error);
+  if (key && proxies)
+    proxy_cache_insert (cache, key, proxies);
+  g_free (key);
+
+  return proxies;
+}
+
+static void
+proxy_resolver_lookup_async_cb (GObject      *source,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  GProxyResolver *resolver = G_PROXY_RESOLVER (source);
+  GTask *task = user_data;
+  ProxyCacheLookup *lookup = g_task_get_task_data (task);
+  GError *error = NULL;
+  gchar **proxies;
+
+  proxies = G_PROXY_RESOLVER_GET_IFACE (resolver)->lookup_finish (resolver, result, &error);
+  if (proxies)
+    {
+      proxy_cache_insert (lookup->cache, lookup->key, proxies);
+      g_task_return_pointer (task, proxies, (GDestroyNotify) g_strfreev);
+    }
+  else
+    g_task_return_error (task, error);
+
+  g_object_unref (task);
 }
 
 /**
@@ -157,13 +379,43 @@ g_proxy_resolver_lookup_async (GProxyResolver      *resolver,
 			       gpointer             user_data)
 {
   GProxyResolverInterface *iface;
+  ProxyCacheLookup *lookup;
+  ProxyCache *cache;
+  gchar **proxies;
+  gchar *key;
+  GTask *task;
 
   g_return_if_fail (G_IS_PROXY_RESOLVER (resolver));
   g_return_if_fail (uri != NULL);
 
   iface = G_PROXY_RESOLVER_GET_IFACE (resolver);
 
-  (* iface->lookup_async) (resolver, uri, cancellable, callback, user_data);
+  key = proxy_cache_key (resolver, uri, &cache);
+  if (key == NULL)
+    {
+      (* iface->lookup_async) (resolver, uri, cancellable, callback, user_data);
+      return;
+    }
+
+  task = g_task_new (resolver, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_proxy_resolver_lookup_async);
+
+  proxies = proxy_cache_lookup (cache, key);
+  if (proxies)
+    {
+      g_free (key);
+      g_task_return_pointer (task, proxies, (GDestroyNotify) g_strfreev);
+      g_object_unref (task);
+      return;
+    }
+
+  lookup = g_slice_new (ProxyCacheLookup);
+  lookup->cache = cache;
+  lookup->key = key;
+  g_task_set_task_data (task, lookup, proxy_cache_lookup_free);
+
+  (* iface->lookup_async) (resolver, uri, cancellable,
+                           proxy_resolver_lookup_async_cb, task);
 }
 
 /**
@@ -191,7 +443,41 @@ g_proxy_resolver_lookup_finish (GProxyResolver     *resolver,
 
   g_return_val_if_fail (G_IS_PROXY_RESOLVER (resolver), NULL);
 
+  if (g_async_result_is_tagged (result, g_proxy_resolver_lookup_async))
+    return g_task_propagate_pointer (G_TASK (result), error);
+
   iface = G_PROXY_RESOLVER_GET_IFACE (resolver);
 
   return (* iface->lookup_finish) (resolver, result, error);
 }
+
+/**
+ * g_proxy_resolver_invalidate_cache:
+ * @resolver: a #GProxyResolver
+ *
+ * Forgets the results of earlier lookups on @resolver.
+ *
+ * The results of the default resolver, and of #GSimpleProxyResolver,
+ * are kept for a few seconds for each scheme, host and port, so that
+ * making many connections does not cost a proxy lookup (and perhaps
+ * a PAC script evaluation) each. #GProxyResolver implementations
+ * should call this when their configuration changes, so that the new
+ * settings apply immediately.
+ *
+ * Since: 2.40
+ */
+void
+g_proxy_resolver_invalidate_cache (GProxyResolver *resolver)
+{
+  ProxyCache *cache;
+
+  g_return_if_fail (G_IS_PROXY_RESOLVER (resolver));
+
+  cache = g_object_get_qdata (G_OBJECT (resolver), proxy_cache_quark ());
+  if (cache == NULL)
+    return;
+
+  g_mutex_lock (&cache->lock);
+  g_hash_table_remove_all (cache->entries);
+  g_mutex_unlock (&cache->lock);
+}
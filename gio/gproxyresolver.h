@@ -90,6 +90,8 @@ GLIB_AVAILABLE_IN_ALL
 gchar	      **g_proxy_resolver_lookup_finish  (GProxyResolver       *resolver,
 						 GAsyncResult         *result,
 						 GError              **error);
+GLIB_AVAILABLE_IN_2_40
+void            g_proxy_resolver_invalidate_cache (GProxyResolver     *resolver);
 
 
 G_END_DECLS
@@ -36,8 +36,29 @@ struct _GResource
   int ref_count;
 
   GvdbTable *table;
+
+  /* Recently decompressed files, most recently used first */
+  GMutex cache_lock;
+  GHashTable *cache;
+  GQueue cache_lru;
+  gsize cache_size;
+
+  /* The directory holding all files, see resource_index_update_unlocked() */
+  gchar *root;
 };
 
+/* Upper bound on the uncompressed bytes kept around per resource, and
+ * on the size of a single cached file.
+ */
+#define RESOURCE_CACHE_SIZE       (1024 * 1024)
+#define RESOURCE_CACHE_MAX_ENTRY  (RESOURCE_CACHE_SIZE / 4)
+
+typedef struct
+{
+  gchar *path;
+  GBytes *bytes;
+} CachedData;
+
 static void register_lazy_static_resources (void);
 
 G_DEFINE_BOXED_TYPE (GResource, g_resource, g_resource_ref, g_resource_unref)
@@ -174,6 +195,20 @@ g_resource_unref (GResource *resource)
 {
   if (g_atomic_int_dec_and_test (&resource->ref_count))
     {
+      CachedData *cached;
+
+      while ((cached = g_queue_pop_head (&resource->cache_lru)))
+        {
+          g_bytes_unref (cached->bytes);
+          g_free (cached->path);
+          g_slice_free (CachedData, cached);
+        }
+
+      if (resource->cache)
+        g_hash_table_unref (resource->cache);
+
+      g_mutex_clear (&resource->cache_lock);
+      g_free (resource->root);
       gvdb_table_unref (resource->table);
       g_free (resource);
     }
@@ -190,9 +225,11 @@ g_resource_new_from_table (GvdbTable *table)
 {
   GResource *resource;
 
-  resource = g_new (GResource, 1);
+  resource = g_new0 (GResource, 1);
   resource->ref_count = 1;
   resource->table = table;
+  g_mutex_init (&resource->cache_lock);
+  g_queue_init (&resource->cache_lru);
 
   return resource;
 }
@@ -378,6 +415,74 @@ g_resource_open_stream (GResource             *resource,
   return stream;
 }
 
+static GBytes *
+g_resource_cache_lookup (GResource   *resource,
+                         const gchar *path)
+{
+  GBytes *bytes = NULL;
+  GList *link;
+
+  g_mutex_lock (&resource->cache_lock);
+
+  if (resource->cache &&
+      (link = g_hash_table_lookup (resource->cache, path)))
+    {
+      CachedData *cached = link->data;
+
+      g_queue_unlink (&resource->cache_lru, link);
+      g_queue_push_head_link (&resource->cache_lru, link);
+      bytes = g_bytes_ref (cached->bytes);
+    }
+
+  g_mutex_unlock (&resource->cache_lock);
+
+  return bytes;
+}
+
+static void
+g_resource_cache_insert (GResource   *resource,
+                         const gchar *path,
+                         GBytes      *bytes)
+{
+  CachedData *cached;
+  gsize size;
+
+  size = g_bytes_get_size (bytes);
+  if (size > RESOURCE_CACHE_MAX_ENTRY)
+    return;
+
+  g_mutex_lock (&resource->cache_lock);
+
+  if (resource->cache == NULL)
+    resource->cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  /* Another thread may have decompressed the same file meanwhile */
+  if (g_hash_table_contains (resource->cache, path))
+    {
+      g_mutex_unlock (&resource->cache_lock);
+      return;
+    }
+
+  cached = g_slice_new (CachedData);
+  cached->path = g_strdup (path);
+  cached->bytes = g_bytes_ref (bytes);
+  g_queue_push_head (&resource->cache_lru, cached);
+  g_hash_table_insert (resource->cache, cached->path, resource->cache_lru.head);
+  resource->cache_size += size;
+
+  while (resource->cache_size > RESOURCE_CACHE_SIZE)
+    {
+      cached = g_queue_pop_tail (&resource->cache_lru);
+      g_hash_table_remove (resource->cache, cached->path);
+      resource->cache_size -= g_bytes_get_size (cached->bytes);
+      g_bytes_unref (cached->bytes);
+      g_free (cached->path);
+      g_slice_free (CachedData, cached);
+    }
+
+  g_mutex_unlock (&resource->cache_lock);
+}
+
 /**
  * g_resource_lookup_data:
  * @resource: A #GResource
@@ -396,7 +501,9 @@ g_resource_open_stream (GResource             *resource,
  * For uncompressed resource files this is a pointer directly into
  * the resource bundle, which is typically in some readonly data section
  * in the program binary. For compressed files we allocate memory on
- * the heap and automatically uncompress the data.
+ * the heap and automatically uncompress the data. Recently used
+ * compressed files are kept in uncompressed form, so looking them up
+ * again is cheap.
  *
  * @lookup_flags controls the behaviour of the lookup.
  *
@@ -426,10 +533,13 @@ g_resource_lookup_data (GResource             *resource,
       GConverterResult res;
       gsize d_size, s_size;
       gsize bytes_read, bytes_written;
+      GZlibDecompressor *decompressor;
+      GBytes *bytes;
 
+      if ((bytes = g_resource_cache_lookup (resource, path)))
+        return bytes;
 
-      GZlibDecompressor *decompressor =
-        g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_ZLIB);
+      decompressor = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_ZLIB);
 
       uncompressed = g_malloc (size + 1);
 
@@ -469,7 +579,10 @@ g_resource_lookup_data (GResource             *resource,
 
       g_object_unref (decompressor);
 
-      return g_bytes_new_take (uncompressed, size);
+      bytes = g_bytes_new_take (uncompressed, size);
+      g_resource_cache_insert (resource, path, bytes);
+
+      return bytes;
     }
   else
     return g_bytes_new_with_free_func (data, data_size, (GDestroyNotify)g_resource_unref, g_resource_ref (resource));
@@ -568,6 +681,216 @@ static GList *registered_resources;
    lock, but all other accesses are done under the write lock */
 static GStaticResource *lazy_register_resources;
 
+/* Lookups in the set of registered resources don't use resources_lock
+ * nor registered_resources.  Instead, every change to the set replaces
+ * resource_index with a new, immutable snapshot of it.  Getting a
+ * reference to the current snapshot only takes the bit lock in the
+ * pointer, and the snapshot in turn keeps its resources alive.
+ *
+ * Besides the list, a snapshot indexes the resources by their root:
+ * the deepest directory that contains all of their files, which is
+ * usually the prefix of a library or plugin.  Only the resources with
+ * a root along a path are tried for it, still most recently registered
+ * first.
+ */
+#define RESOURCE_INDEX_LOCK_BIT   0
+#define RESOURCE_INDEX_MAX_DEPTH  8
+
+typedef struct
+{
+  gint ref_count;
+  guint n_resources;
+  GResource **resources;  /* most recently registered first */
+  GHashTable *roots;      /* root -> GArray of guint indexes into resources */
+} ResourceIndex;
+
+typedef struct
+{
+  ResourceIndex *index;
+  GArray *levels[RESOURCE_INDEX_MAX_DEPTH];
+  guint positions[RESOURCE_INDEX_MAX_DEPTH];
+  guint n_levels;
+} ResourceIndexIter;
+
+static ResourceIndex *resource_index;
+
+static gchar *
+g_resource_find_root (GResource *resource)
+{
+  GString *root;
+  guint depth;
+
+  root = g_string_new ("/");
+
+  for (depth = 1; depth < RESOURCE_INDEX_MAX_DEPTH; depth++)
+    {
+      gchar **children;
+      gboolean descend;
+
+      children = gvdb_table_list (resource->table, root->str);
+      descend = children != NULL && children[0] != NULL && children[1] == NULL &&
+                g_str_has_suffix (children[0], "/");
+      if (descend)
+        g_string_append (root, children[0]);
+      g_strfreev (children);
+
+      if (!descend)
+        break;
+    }
+
+  return g_string_free (root, FALSE);
+}
+
+static ResourceIndex *
+resource_index_acquire (void)
+{
+  ResourceIndex *index;
+
+  register_lazy_static_resources ();
+
+  g_pointer_bit_lock (&resource_index, RESOURCE_INDEX_LOCK_BIT);
+  index = (ResourceIndex *) ((gsize) resource_index & ~(gsize) (1 << RESOURCE_INDEX_LOCK_BIT));
+  if (index != NULL)
+    g_atomic_int_inc (&index->ref_count);
+  g_pointer_bit_unlock (&resource_index, RESOURCE_INDEX_LOCK_BIT);
+
+  return index;
+}
+
+static void
+resource_index_release (ResourceIndex *index)
+{
+  guint i;
+
+  if (index == NULL || !g_atomic_int_dec_and_test (&index->ref_count))
+    return;
+
+  g_hash_table_unref (index->roots);
+  for (i = 0; i < index->n_resources; i++)
+    g_resource_unref (index->resources[i]);
+  g_free (index->resources);
+  g_free (index);
+}
+
+/* HOLDS: resources_lock for writing */
+static void
+resource_index_update_unlocked (void)
+{
+  ResourceIndex *index, *old_index;
+  GList *l;
+  guint i;
+
+  index = g_new0 (ResourceIndex, 1);
+  index->ref_count = 1;
+  index->n_resources = g_list_length (registered_resources);
+  index->resources = g_new (GResource *, index->n_resources);
+  index->roots = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                        NULL, (GDestroyNotify) g_array_unref);
+
+  for (l = registered_resources, i = 0; l != NULL; l = l->next, i++)
+    {
+      GResource *resource = l->data;
+      GArray *level;
+
+      if (resource->root == NULL)
+        resource->root = g_resource_find_root (resource);
+
+      index->resources[i] = g_resource_ref (resource);
+
+      level = g_hash_table_lookup (index->roots, resource->root);
+      if (level == NULL)
+        {
+          level = g_array_new (FALSE, FALSE, sizeof (guint));
+          g_hash_table_insert (index->roots, resource->root, level);
+        }
+      g_array_append_val (level, i);
+    }
+
+  g_pointer_bit_lock (&resource_index, RESOURCE_INDEX_LOCK_BIT);
+  old_index = (ResourceIndex *) ((gsize) resource_index & ~(gsize) (1 << RESOURCE_INDEX_LOCK_BIT));
+  g_atomic_pointer_set (&resource_index, (gpointer) ((gsize) index | (1 << RESOURCE_INDEX_LOCK_BIT)));
+  g_pointer_bit_unlock (&resource_index, RESOURCE_INDEX_LOCK_BIT);
+
+  if (old_index == NULL)
+    return;
+
+  /* Wait for the lookups still using the old snapshot, as taking the
+   * writer lock used to: g_static_resource_fini() is typically followed
+   * by unloading the module that holds the data.
+   */
+  while (g_atomic_int_get (&old_index->ref_count) > 1)
+    g_thread_yield ();
+
+  resource_index_release (old_index);
+}
+
+/* Finds the resources with a root along @path */
+static void
+resource_index_iter_init (ResourceIndexIter *iter,
+                          ResourceIndex     *index,
+                          const gchar       *path)
+{
+  gchar *prefix;
+  gchar *p;
+
+  iter->index = index;
+  iter->n_levels = 0;
+
+  if (index == NULL)
+    return;
+
+  prefix = g_strdup (path);
+  for (p = prefix; *p != '\0' && iter->n_levels < RESOURCE_INDEX_MAX_DEPTH; p++)
+    {
+      GArray *level;
+      gchar c;
+
+      if (*p != '/')
+        continue;
+
+      c = p[1];
+      p[1] = '\0';
+      level = g_hash_table_lookup (index->roots, prefix);
+      p[1] = c;
+
+      if (level != NULL)
+        {
+          iter->levels[iter->n_levels] = level;
+          iter->positions[iter->n_levels] = 0;
+          iter->n_levels++;
+        }
+    }
+  g_free (prefix);
+}
+
+/* Returns the candidates in the order they were registered, newest first */
+static GResource *
+resource_index_iter_next (ResourceIndexIter *iter)
+{
+  guint best = G_MAXUINT;
+  guint best_level = 0;
+  guint i;
+
+  for (i = 0; i < iter->n_levels; i++)
+    {
+      GArray *level = iter->levels[i];
+
+      if (iter->positions[i] < level->len &&
+          g_array_index (level, guint, iter->positions[i]) < best)
+        {
+          best = g_array_index (level, guint, iter->positions[i]);
+          best_level = i;
+        }
+    }
+
+  if (best == G_MAXUINT)
+    return NULL;
+
+  iter->positions[best_level]++;
+
+  return iter->index->resources[best];
+}
+
 static void
 g_resources_register_unlocked (GResource *resource)
 {
@@ -603,6 +926,7 @@ g_resources_register (GResource *resource)
 {
   g_rw_lock_writer_lock (&resources_lock);
   g_resources_register_unlocked (resource);
+  resource_index_update_unlocked ();
   g_rw_lock_writer_unlock (&resources_lock);
 }
 
@@ -619,6 +943,7 @@ g_resources_unregister (GResource *resource)
 {
   g_rw_lock_writer_lock (&resources_lock);
   g_resources_unregister_unlocked (resource);
+  resource_index_update_unlocked ();
   g_rw_lock_writer_unlock (&resources_lock);
 }
 
@@ -645,16 +970,16 @@ g_resources_open_stream (const gchar           *path,
                          GError               **error)
 {
   GInputStream *res = NULL;
-  GList *l;
+  ResourceIndex *index;
+  ResourceIndexIter iter;
+  GResource *r;
   GInputStream *stream;
 
-  register_lazy_static_resources ();
-
-  g_rw_lock_reader_lock (&resources_lock);
+  index = resource_index_acquire ();
+  resource_index_iter_init (&iter, index, path);
 
-  for (l = registered_resources; l != NULL; l = l->next)
+  while ((r = resource_index_iter_next (&iter)) != NULL)
     {
-      GResource *r = l->data;
       GError *my_error = NULL;
 
       stream = g_resource_open_stream (r, path, lookup_flags, &my_error);
@@ -672,12 +997,12 @@ g_resources_open_stream (const gchar           *path,
         }
     }
 
-  if (l == NULL)
+  if (r == NULL)
     g_set_error (error, G_RESOURCE_ERROR, G_RESOURCE_ERROR_NOT_FOUND,
                  _("The resource at '%s' does not exist"),
                  path);
 
-  g_rw_lock_reader_unlock (&resources_lock);
+  resource_index_release (index);
 
   return res;
 }
@@ -714,16 +1039,16 @@ g_resources_lookup_data (const gchar           *path,
                          GError               **error)
 {
   GBytes *res = NULL;
-  GList *l;
+  ResourceIndex *index;
+  ResourceIndexIter iter;
+  GResource *r;
   GBytes *data;
 
-  register_lazy_static_resources ();
-
-  g_rw_lock_reader_lock (&resources_lock);
+  index = resource_index_acquire ();
+  resource_index_iter_init (&iter, index, path);
 
-  for (l = registered_resources; l != NULL; l = l->next)
+  while ((r = resource_index_iter_next (&iter)) != NULL)
     {
-      GResource *r = l->data;
       GError *my_error = NULL;
 
       data = g_resource_lookup_data (r, path, lookup_flags, &my_error);
@@ -741,12 +1066,12 @@ g_resources_lookup_data (const gchar           *path,
         }
     }
 
-  if (l == NULL)
+  if (r == NULL)
     g_set_error (error, G_RESOURCE_ERROR, G_RESOURCE_ERROR_NOT_FOUND,
                  _("The resource at '%s' does not exist"),
                  path);
 
-  g_rw_lock_reader_unlock (&resources_lock);
+  resource_index_release (index);
 
   return res;
 }
@@ -774,17 +1099,17 @@ g_resources_enumerate_children (const gchar           *path,
                                 GError               **error)
 {
   GHashTable *hash = NULL;
-  GList *l;
+  ResourceIndex *index;
+  guint j;
   char **children;
   int i;
 
-  register_lazy_static_resources ();
-
-  g_rw_lock_reader_lock (&resources_lock);
+  /* Any resource can have children here, whatever its root */
+  index = resource_index_acquire ();
 
-  for (l = registered_resources; l != NULL; l = l->next)
+  for (j = 0; index != NULL && j < index->n_resources; j++)
     {
-      GResource *r = l->data;
+      GResource *r = index->resources[j];
 
       children = g_resource_enumerate_children (r, path, 0, NULL);
 
@@ -799,7 +1124,7 @@ g_resources_enumerate_children (const gchar           *path,
         }
     }
 
-  g_rw_lock_reader_unlock (&resources_lock);
+  resource_index_release (index);
 
   if (hash == NULL)
     {
@@ -855,16 +1180,16 @@ g_resources_get_info (const gchar           *path,
                       GError               **error)
 {
   gboolean res = FALSE;
-  GList *l;
+  ResourceIndex *index;
+  ResourceIndexIter iter;
+  GResource *r;
   gboolean r_res;
 
-  register_lazy_static_resources ();
-
-  g_rw_lock_reader_lock (&resources_lock);
+  index = resource_index_acquire ();
+  resource_index_iter_init (&iter, index, path);
 
-  for (l = registered_resources; l != NULL; l = l->next)
+  while ((r = resource_index_iter_next (&iter)) != NULL)
     {
-      GResource *r = l->data;
       GError *my_error = NULL;
 
       r_res = g_resource_get_info (r, path, lookup_flags, size, flags, &my_error);
@@ -882,12 +1207,12 @@ g_resources_get_info (const gchar           *path,
         }
     }
 
-  if (l == NULL)
+  if (r == NULL)
     g_set_error (error, G_RESOURCE_ERROR, G_RESOURCE_ERROR_NOT_FOUND,
                  _("The resource at '%s' does not exist"),
                  path);
 
-  g_rw_lock_reader_unlock (&resources_lock);
+  resource_index_release (index);
 
   return res;
 }
@@ -921,6 +1246,9 @@ register_lazy_static_resources_unlocked (void)
     list = lazy_register_resources;
   while (!g_atomic_pointer_compare_and_exchange (&lazy_register_resources, list, NULL));
 
+  if (list == NULL)
+    return;
+
   while (list != NULL)
     {
       GBytes *bytes = g_bytes_new_static (list->data, list->data_len);
@@ -934,6 +1262,8 @@ register_lazy_static_resources_unlocked (void)
 
       list = list->next;
     }
+
+  resource_index_update_unlocked ();
 }
 
 static void
@@ -1000,6 +1330,7 @@ g_static_resource_fini (GStaticResource *static_resource)
       g_atomic_pointer_set (&static_resource->resource, NULL);
       g_resources_unregister_unlocked (resource);
       g_resource_unref (resource);
+      resource_index_update_unlocked ();
     }
 
   g_rw_lock_writer_unlock (&resources_lock);
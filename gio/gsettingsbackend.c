@@ -35,10 +35,12 @@
 
 typedef struct _GSettingsBackendClosure GSettingsBackendClosure;
 typedef struct _GSettingsBackendWatch   GSettingsBackendWatch;
+typedef struct _GSettingsBackendBatch   GSettingsBackendBatch;
 
 struct _GSettingsBackendPrivate
 {
   GSettingsBackendWatch *watches;
+  GHashTable *batches;            /* GMainContext -> GSettingsBackendBatch */
   GMutex lock;
 };
 
@@ -132,6 +134,16 @@ struct _GSettingsBackendWatch
   GSettingsBackendWatch         *next;
 };
 
+/* The copy of data1 made for a dispatch, shared by all the closures
+ * it creates instead of being copied for each watch.
+ */
+typedef struct
+{
+  gpointer       data;
+  GBoxedFreeFunc free_func;
+  gint           ref_count;
+} GSettingsBackendData;
+
 struct _GSettingsBackendClosure
 {
   void (*function) (GObject          *target,
@@ -140,12 +152,25 @@ struct _GSettingsBackendClosure
                     gpointer          data1,
                     gpointer          data2);
 
+  GSettingsBackend     *backend;
+  GObject              *target;
+  gchar                *name;
+  GSettingsBackendData *data1;
+  gpointer              data2;
+  gboolean              mergeable;
+};
+
+/* Notifications for watches with a main context are queued in a batch
+ * per context, which is flushed by a single invocation in that context.
+ * Notifications that only carry a name (everything but keys_changed)
+ * are merged with an identical one that is still pending.
+ */
+struct _GSettingsBackendBatch
+{
   GSettingsBackend *backend;
-  GObject          *target;
-  gchar            *name;
-  gpointer          data1;
-  GBoxedFreeFunc    data1_free;
-  gpointer          data2;
+  GMainContext     *context;
+  GQueue            closures;
+  GHashTable       *pending;   /* set of mergeable closures */
 };
 
 static void
@@ -263,24 +288,127 @@ g_settings_backend_unwatch (GSettingsBackend *backend,
   g_settings_backend_watch_weak_notify (backend, target);
 }
 
-static gboolean
-g_settings_backend_invoke_closure (gpointer user_data)
+static void
+g_settings_backend_data_unref (GSettingsBackendData *data)
 {
-  GSettingsBackendClosure *closure = user_data;
-
-  closure->function (closure->target, closure->backend, closure->name,
-                     closure->data1, closure->data2);
+  if (g_atomic_int_dec_and_test (&data->ref_count))
+    {
+      data->free_func (data->data);
+      g_slice_free (GSettingsBackendData, data);
+    }
+}
 
-  closure->data1_free (closure->data1);
+static void
+g_settings_backend_closure_free (GSettingsBackendClosure *closure)
+{
+  g_settings_backend_data_unref (closure->data1);
   g_object_unref (closure->backend);
   g_object_unref (closure->target);
   g_free (closure->name);
 
   g_slice_free (GSettingsBackendClosure, closure);
+}
+
+static void
+g_settings_backend_invoke_closure (GSettingsBackendClosure *closure)
+{
+  closure->function (closure->target, closure->backend, closure->name,
+                     closure->data1->data, closure->data2);
+
+  g_settings_backend_closure_free (closure);
+}
+
+static guint
+g_settings_backend_closure_hash (gconstpointer key)
+{
+  const GSettingsBackendClosure *closure = key;
+
+  return g_str_hash (closure->name) ^ GPOINTER_TO_UINT (closure->target);
+}
+
+static gboolean
+g_settings_backend_closure_equal (gconstpointer a,
+                                  gconstpointer b)
+{
+  const GSettingsBackendClosure *closure_a = a;
+  const GSettingsBackendClosure *closure_b = b;
+
+  return closure_a->target == closure_b->target &&
+         closure_a->function == closure_b->function &&
+         strcmp (closure_a->name, closure_b->name) == 0;
+}
+
+static gboolean
+g_settings_backend_flush_batch (gpointer user_data)
+{
+  GSettingsBackendBatch *batch = user_data;
+  GSettingsBackend *backend = batch->backend;
+  GSettingsBackendClosure *closure;
+
+  /* Once the batch is out of the table, notifications that come in
+   * while we deliver these start a new one.
+   */
+  g_mutex_lock (&backend->priv->lock);
+  g_hash_table_remove (backend->priv->batches, batch->context);
+  g_mutex_unlock (&backend->priv->lock);
+
+  while ((closure = g_queue_pop_head (&batch->closures)))
+    g_settings_backend_invoke_closure (closure);
+
+  g_hash_table_unref (batch->pending);
+  g_main_context_unref (batch->context);
+  g_object_unref (batch->backend);
+  g_slice_free (GSettingsBackendBatch, batch);
 
   return FALSE;
 }
 
+static void
+g_settings_backend_queue_closure (GSettingsBackend        *backend,
+                                  GMainContext            *context,
+                                  GSettingsBackendClosure *closure)
+{
+  GSettingsBackendBatch *batch;
+  gboolean new_batch = FALSE;
+
+  g_mutex_lock (&backend->priv->lock);
+
+  if (backend->priv->batches == NULL)
+    backend->priv->batches = g_hash_table_new (NULL, NULL);
+
+  batch = g_hash_table_lookup (backend->priv->batches, context);
+  if (batch == NULL)
+    {
+      batch = g_slice_new (GSettingsBackendBatch);
+      batch->backend = g_object_ref (backend);
+      batch->context = g_main_context_ref (context);
+      g_queue_init (&batch->closures);
+      batch->pending = g_hash_table_new (g_settings_backend_closure_hash,
+                                         g_settings_backend_closure_equal);
+      g_hash_table_insert (backend->priv->batches, context, batch);
+      new_batch = TRUE;
+    }
+
+  if (closure->mergeable && g_hash_table_contains (batch->pending, closure))
+    {
+      g_mutex_unlock (&backend->priv->lock);
+      g_settings_backend_closure_free (closure);
+      return;
+    }
+
+  g_queue_push_tail (&batch->closures, closure);
+  if (closure->mergeable)
+    g_hash_table_add (batch->pending, closure);
+
+  g_mutex_unlock (&backend->priv->lock);
+
+  /* This runs the batch right away if we are in its context, so
+   * notifications are only deferred when they cross threads.
+   */
+  if (new_batch)
+    g_main_context_invoke (context, g_settings_backend_flush_batch, batch);
+}
+
 static gpointer
 pointer_id (gpointer a)
 {
@@ -302,6 +430,8 @@ g_settings_backend_dispatch_signal (GSettingsBackend *backend,
                                     gpointer          data2)
 {
   GSettingsBackendWatch *suffix, *watch, *next;
+  GSettingsBackendData *shared;
+  gboolean mergeable;
 
   if (data1_copy == NULL)
     data1_copy = pointer_id;
@@ -329,6 +459,17 @@ g_settings_backend_dispatch_signal (GSettingsBackend *backend,
     g_object_ref (watch->target);
   g_mutex_unlock (&backend->priv->lock);
 
+  if (suffix == NULL)
+    return;
+
+  shared = g_slice_new (GSettingsBackendData);
+  shared->data = data1_copy (data1);
+  shared->free_func = data1_free;
+  shared->ref_count = 1;
+
+  mergeable = function_offset != G_STRUCT_OFFSET (GSettingsListenerVTable,
+                                                  keys_changed);
+
   /* The suffix is now immutable, so this is safe. */
   for (watch = suffix; watch; watch = next)
     {
@@ -340,9 +481,10 @@ g_settings_backend_dispatch_signal (GSettingsBackend *backend,
       closure->function = G_STRUCT_MEMBER (void *, watch->vtable,
                                            function_offset);
       closure->name = g_strdup (name);
-      closure->data1 = data1_copy (data1);
-      closure->data1_free = data1_free;
+      closure->data1 = shared;
+      g_atomic_int_inc (&shared->ref_count);
       closure->data2 = data2;
+      closure->mergeable = mergeable;
 
       /* we do this here because 'watch' may not live to the end of this
        * iteration of the loop (since we may unref the target below).
@@ -350,12 +492,12 @@ g_settings_backend_dispatch_signal (GSettingsBackend *backend,
       next = watch->next;
 
       if (watch->context)
-        g_main_context_invoke (watch->context,
-                               g_settings_backend_invoke_closure,
-                               closure);
+        g_settings_backend_queue_closure (backend, watch->context, closure);
       else
         g_settings_backend_invoke_closure (closure);
     }
+
+  g_settings_backend_data_unref (shared);
 }
 
 /**
@@ -928,6 +1070,9 @@ g_settings_backend_finalize (GObject *object)
 {
   GSettingsBackend *backend = G_SETTINGS_BACKEND (object);
 
+  /* pending batches hold a reference, so this is empty */
+  if (backend->priv->batches)
+    g_hash_table_unref (backend->priv->batches);
   g_mutex_clear (&backend->priv->lock);
 
   G_OBJECT_CLASS (g_settings_backend_parent_class)
@@ -148,6 +148,9 @@ struct _GSettingsSchema
 
   GSettingsSchema *extends;
 
+  /* interned key name -> parsed GSettingsSchemaKey (with no schema) */
+  GHashTable *keys;
+
   gint ref_count;
 };
 
@@ -182,12 +185,21 @@ struct _GSettingsSchemaSource
   gchar *directory;
   GvdbTable *table;
   GHashTable **text_tables;
+  gchar ***schema_lists;
+
+  /* schema id -> GSettingsSchema, not holding a reference */
+  GHashTable *schemas;
 
   gint ref_count;
 };
 
 static GSettingsSchemaSource *schema_sources;
 
+/* Protects the 'schemas' table of each source and the 'keys' table of
+ * each schema.
+ */
+G_LOCK_DEFINE_STATIC (schema_cache);
+
 /**
  * g_settings_schema_source_ref:
  * @source: a #GSettingsSchemaSource
@@ -234,6 +246,15 @@ g_settings_schema_source_unref (GSettingsSchemaSource *source)
           g_free (source->text_tables);
         }
 
+      if (source->schema_lists)
+        {
+          g_strfreev (source->schema_lists[0]);
+          g_strfreev (source->schema_lists[1]);
+          g_free (source->schema_lists);
+        }
+
+      g_hash_table_unref (source->schemas);
+
       g_slice_free (GSettingsSchemaSource, source);
     }
 }
@@ -299,6 +320,8 @@ g_settings_schema_source_new_from_directory (const gchar            *directory,
   source->directory = g_strdup (directory);
   source->parent = parent ? g_settings_schema_source_ref (parent) : NULL;
   source->text_tables = NULL;
+  source->schema_lists = NULL;
+  source->schemas = g_hash_table_new (g_str_hash, g_str_equal);
   source->table = table;
   source->ref_count = 1;
 
@@ -381,45 +404,52 @@ g_settings_schema_source_get_default (void)
   return schema_sources;
 }
 
-/**
- * g_settings_schema_source_lookup:
- * @source: a #GSettingsSchemaSource
- * @schema_id: a schema ID
- * @recursive: %TRUE if the lookup should be recursive
- *
- * Looks up a schema with the identifier @schema_id in @source.
- *
- * This function is not required for normal uses of #GSettings but it
- * may be useful to authors of plugin management systems or to those who
- * want to introspect the content of schemas.
- *
- * If the schema isn't found directly in @source and @recursive is %TRUE
- * then the parent sources will also be checked.
- *
- * If the schema isn't found, %NULL is returned.
- *
- * Returns: (transfer full): a new #GSettingsSchema
+/* Takes a new reference on @schema, unless it has already started being
+ * destroyed.  Must be called with the schema_cache lock held.
+ */
+static gboolean
+g_settings_schema_ref_if_alive (GSettingsSchema *schema)
+{
+  gint old;
+
+  do
+    {
+      old = g_atomic_int_get (&schema->ref_count);
+
+      if (old == 0)
+        return FALSE;
+    }
+  while (!g_atomic_int_compare_and_exchange (&schema->ref_count, old, old + 1));
+
+  return TRUE;
+}
+
+/* Looks up @schema_id in @source alone.
  *
- * Since: 2.32
- **/
-GSettingsSchema *
-g_settings_schema_source_lookup (GSettingsSchemaSource *source,
-                                 const gchar           *schema_id,
-                                 gboolean               recursive)
+ * Each source remembers the schemas that are currently in use so that
+ * all lookups of the same id share one #GSettingsSchema (and its cache
+ * of parsed keys) instead of re-reading the gvdb table every time a
+ * #GSettings object is created.
+ */
+static GSettingsSchema *
+g_settings_schema_source_lookup_one (GSettingsSchemaSource *source,
+                                     const gchar           *schema_id)
 {
   GSettingsSchema *schema;
+  GSettingsSchema *existing;
   GvdbTable *table;
   const gchar *extends;
 
-  g_return_val_if_fail (source != NULL, NULL);
-  g_return_val_if_fail (schema_id != NULL, NULL);
+  G_LOCK (schema_cache);
+  schema = g_hash_table_lookup (source->schemas, schema_id);
+  if (schema && !g_settings_schema_ref_if_alive (schema))
+    schema = NULL;
+  G_UNLOCK (schema_cache);
 
-  table = gvdb_table_get_table (source->table, schema_id);
+  if (schema)
+    return schema;
 
-  if (table == NULL && recursive)
-    for (source = source->parent; source; source = source->parent)
-      if ((table = gvdb_table_get_table (source->table, schema_id)))
-        break;
+  table = gvdb_table_get_table (source->table, schema_id);
 
   if (table == NULL)
     return NULL;
@@ -443,9 +473,62 @@ g_settings_schema_source_lookup (GSettingsSchemaSource *source,
         g_warning ("Schema '%s' extends schema '%s' but we could not find it", schema_id, extends);
     }
 
+  /* Someone else may have created the same schema in the meantime */
+  G_LOCK (schema_cache);
+  existing = g_hash_table_lookup (source->schemas, schema_id);
+  if (existing && g_settings_schema_ref_if_alive (existing))
+    {
+      G_UNLOCK (schema_cache);
+      g_settings_schema_unref (schema);
+
+      return existing;
+    }
+
+  g_hash_table_replace (source->schemas, schema->id, schema);
+  G_UNLOCK (schema_cache);
+
   return schema;
 }
 
+/**
+ * g_settings_schema_source_lookup:
+ * @source: a #GSettingsSchemaSource
+ * @schema_id: a schema ID
+ * @recursive: %TRUE if the lookup should be recursive
+ *
+ * Looks up a schema with the identifier @schema_id in @source.
+ *
+ * This function is not required for normal uses of #GSettings but it
+ * may be useful to authors of plugin management systems or to those who
+ * want to introspect the content of schemas.
+ *
+ * If the schema isn't found directly in @source and @recursive is %TRUE
+ * then the parent sources will also be checked.
+ *
+ * If the schema isn't found, %NULL is returned.
+ *
+ * Returns: (transfer full): a new #GSettingsSchema
+ *
+ * Since: 2.32
+ **/
+GSettingsSchema *
+g_settings_schema_source_lookup (GSettingsSchemaSource *source,
+                                 const gchar           *schema_id,
+                                 gboolean               recursive)
+{
+  GSettingsSchema *schema;
+  GSettingsSchemaSource *s;
+
+  g_return_val_if_fail (source != NULL, NULL);
+  g_return_val_if_fail (schema_id != NULL, NULL);
+
+  for (s = source; s; s = recursive ? s->parent : NULL)
+    if ((schema = g_settings_schema_source_lookup_one (s, schema_id)))
+      return schema;
+
+  return NULL;
+}
+
 typedef struct
 {
   GHashTable *summaries;
@@ -723,6 +806,60 @@ g_settings_schema_source_get_text_tables (GSettingsSchemaSource *source)
   return source->text_tables;
 }
 
+/* Sorts the schemas of one source into non-relocatable ones (index 0)
+ * and relocatable ones (index 1).  This requires opening the table of
+ * every schema, so it is only done once per source, and only when
+ * somebody actually asks for a listing.
+ */
+static gchar ***
+g_settings_schema_source_get_schema_lists (GSettingsSchemaSource *source)
+{
+  if (g_once_init_enter (&source->schema_lists))
+    {
+      GPtrArray *single, *reloc;
+      gchar ***schema_lists;
+      gchar **list;
+      gint i;
+
+      single = g_ptr_array_new ();
+      reloc = g_ptr_array_new ();
+
+      list = gvdb_table_list (source->table, "");
+
+      /* empty schema cache file? */
+      if (list != NULL)
+        {
+          for (i = 0; list[i]; i++)
+            {
+              GvdbTable *table;
+
+              table = gvdb_table_get_table (source->table, list[i]);
+              g_assert (table != NULL);
+
+              if (gvdb_table_has_value (table, ".path"))
+                g_ptr_array_add (single, list[i]); /* transfer ownership */
+              else
+                g_ptr_array_add (reloc, list[i]);
+
+              gvdb_table_unref (table);
+            }
+
+          g_free (list); /* free container only */
+        }
+
+      g_ptr_array_add (single, NULL);
+      g_ptr_array_add (reloc, NULL);
+
+      schema_lists = g_new (gchar **, 2);
+      schema_lists[0] = (gchar **) g_ptr_array_free (single, FALSE);
+      schema_lists[1] = (gchar **) g_ptr_array_free (reloc, FALSE);
+
+      g_once_init_leave (&source->schema_lists, schema_lists);
+    }
+
+  return source->schema_lists;
+}
+
 /**
  * g_settings_schema_source_list_schemas:
  * @source: a #GSettingsSchemaSource
@@ -763,35 +900,16 @@ g_settings_schema_source_list_schemas (GSettingsSchemaSource   *source,
 
   for (s = source; s; s = s->parent)
     {
-      gchar **list;
-      gint i;
-
-      list = gvdb_table_list (s->table, "");
-
-      /* empty schema cache file? */
-      if (list == NULL)
-        continue;
-
-      for (i = 0; list[i]; i++)
-        {
-          if (!g_hash_table_lookup (single, list[i]) &&
-              !g_hash_table_lookup (reloc, list[i]))
-            {
-              GvdbTable *table;
+      gchar ***lists;
+      gint i, j;
 
-              table = gvdb_table_get_table (s->table, list[i]);
-              g_assert (table != NULL);
-
-              if (gvdb_table_has_value (table, ".path"))
-                g_hash_table_insert (single, g_strdup (list[i]), NULL);
-              else
-                g_hash_table_insert (reloc, g_strdup (list[i]), NULL);
-
-              gvdb_table_unref (table);
-            }
-        }
+      lists = g_settings_schema_source_get_schema_lists (s);
 
-      g_strfreev (list);
+      for (i = 0; i < 2; i++)
+        for (j = 0; lists[i][j]; j++)
+          if (!g_hash_table_lookup (single, lists[i][j]) &&
+              !g_hash_table_lookup (reloc, lists[i][j]))
+            g_hash_table_insert (i == 0 ? single : reloc, g_strdup (lists[i][j]), NULL);
 
       /* Only the first source if recursive not requested */
       if (!recursive)
@@ -902,9 +1020,18 @@ g_settings_schema_unref (GSettingsSchema *schema)
 {
   if (g_atomic_int_dec_and_test (&schema->ref_count))
     {
+      /* Nobody can revive the schema from the cache at this point */
+      G_LOCK (schema_cache);
+      if (g_hash_table_lookup (schema->source->schemas, schema->id) == schema)
+        g_hash_table_remove (schema->source->schemas, schema->id);
+      G_UNLOCK (schema_cache);
+
       if (schema->extends)
         g_settings_schema_unref (schema->extends);
 
+      if (schema->keys)
+        g_hash_table_unref (schema->keys);
+
       g_settings_schema_source_unref (schema->source);
       gvdb_table_unref (schema->table);
       g_free (schema->items);
@@ -1005,11 +1132,13 @@ const GQuark *
 g_settings_schema_list (GSettingsSchema *schema,
                         gint            *n_items)
 {
-  if (schema->items == NULL)
+  /* schemas are shared, so this may race with other threads */
+  if (g_once_init_enter (&schema->items))
     {
       GSettingsSchema *s;
       GHashTableIter iter;
       GHashTable *items;
+      GQuark *quarks;
       gpointer name;
       gint len;
       gint i;
@@ -1089,16 +1218,18 @@ g_settings_schema_list (GSettingsSchema *schema,
 
       /* Now create the list */
       len = g_hash_table_size (items);
-      schema->items = g_new (GQuark, len);
+      quarks = g_new (GQuark, len);
       i = 0;
       g_hash_table_iter_init (&iter, items);
 
       while (g_hash_table_iter_next (&iter, &name, NULL))
-        schema->items[i++] = g_quark_from_string (name);
+        quarks[i++] = g_quark_from_string (name);
       schema->n_items = i;
       g_assert (i == len);
 
       g_hash_table_unref (items);
+
+      g_once_init_leave (&schema->items, quarks);
     }
 
   *n_items = schema->n_items;
@@ -1131,20 +1262,22 @@ endian_fixup (GVariant **value)
 #endif
 }
 
-void
-g_settings_schema_key_init (GSettingsSchemaKey *key,
-                            GSettingsSchema    *schema,
-                            const gchar        *name)
+/* Parses the information about key @name out of @schema.  The result is
+ * stored in the key cache of @schema, so it does not hold a reference
+ * on the schema itself.
+ */
+static GSettingsSchemaKey *
+g_settings_schema_parse_key (GSettingsSchema *schema,
+                             const gchar     *name)
 {
+  GSettingsSchemaKey *key;
   GVariantIter *iter;
   GVariant *data;
   guchar code;
 
-  memset (key, 0, sizeof *key);
-
   iter = g_settings_schema_get_value (schema, name);
 
-  key->schema = g_settings_schema_ref (schema);
+  key = g_slice_new0 (GSettingsSchemaKey);
   key->default_value = g_variant_iter_next_value (iter);
   endian_fixup (&key->default_value);
   key->type = g_variant_get_type (key->default_value);
@@ -1189,6 +1322,55 @@ g_settings_schema_key_init (GSettingsSchemaKey *key,
     }
 
   g_variant_iter_free (iter);
+
+  return key;
+}
+
+static void
+g_settings_schema_free_parsed_key (gpointer data)
+{
+  GSettingsSchemaKey *key = data;
+
+  if (key->minimum)
+    g_variant_unref (key->minimum);
+
+  if (key->maximum)
+    g_variant_unref (key->maximum);
+
+  g_variant_unref (key->default_value);
+
+  g_slice_free (GSettingsSchemaKey, key);
+}
+
+void
+g_settings_schema_key_init (GSettingsSchemaKey *key,
+                            GSettingsSchema    *schema,
+                            const gchar        *name)
+{
+  GSettingsSchemaKey *parsed;
+
+  G_LOCK (schema_cache);
+
+  if (schema->keys == NULL)
+    schema->keys = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_settings_schema_free_parsed_key);
+
+  parsed = g_hash_table_lookup (schema->keys, name);
+
+  if (parsed == NULL)
+    {
+      parsed = g_settings_schema_parse_key (schema, name);
+      g_hash_table_insert (schema->keys, (gpointer) parsed->name, parsed);
+    }
+
+  *key = *parsed;
+  key->schema = g_settings_schema_ref (schema);
+  g_variant_ref (key->default_value);
+  if (key->minimum)
+    g_variant_ref (key->minimum);
+  if (key->maximum)
+    g_variant_ref (key->maximum);
+
+  G_UNLOCK (schema_cache);
 }
 
 void
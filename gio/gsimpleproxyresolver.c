@@ -100,6 +100,7 @@ g_simple_proxy_resolver_init (GSimpleProxyResolver *resolver)
   resolver->priv = g_simple_proxy_resolver_get_instance_private (resolver);
   resolver->priv->uri_proxies = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                        g_free, g_free);
+  _g_proxy_resolver_enable_cache (G_PROXY_RESOLVER (resolver));
 }
 
 static void
@@ -547,6 +548,7 @@ g_simple_proxy_resolver_set_default_proxy (GSimpleProxyResolver  *resolver,
 
   g_free (resolver->priv->default_proxy);
   resolver->priv->default_proxy = g_strdup (default_proxy);
+  g_proxy_resolver_invalidate_cache (G_PROXY_RESOLVER (resolver));
   g_object_notify (G_OBJECT (resolver), "default-proxy");
 }
 
@@ -572,6 +574,7 @@ g_simple_proxy_resolver_set_ignore_hosts (GSimpleProxyResolver  *resolver,
   g_strfreev (resolver->priv->ignore_hosts);
   resolver->priv->ignore_hosts = g_strdupv (ignore_hosts);
   reparse_ignore_hosts (resolver);
+  g_proxy_resolver_invalidate_cache (G_PROXY_RESOLVER (resolver));
   g_object_notify (G_OBJECT (resolver), "ignore-hosts");
 }
 
@@ -603,4 +606,5 @@ g_simple_proxy_resolver_set_uri_proxy (GSimpleProxyResolver *resolver,
   g_hash_table_replace (resolver->priv->uri_proxies,
                         g_ascii_strdown (uri_scheme, -1),
                         g_strdup (proxy));
+  g_proxy_resolver_invalidate_cache (G_PROXY_RESOLVER (resolver));
 }
@@ -64,6 +64,7 @@
 #include "gsocketcontrolmessage.h"
 #include "gcredentials.h"
 #include "gcredentialsprivate.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 /**
@@ -1922,7 +1923,11 @@ g_socket_bind (GSocket         *socket,
    */
   g_socket_set_option (socket, SOL_SOCKET, SO_REUSEADDR, so_reuseaddr, NULL);
 #ifdef SO_REUSEPORT
-  g_socket_set_option (socket, SOL_SOCKET, SO_REUSEPORT, so_reuseport, NULL);
+  /* but leave it alone if it was set on purpose, see
+   * g_socket_service_add_sharded_address()
+   */
+  if (so_reuseport)
+    g_socket_set_option (socket, SOL_SOCKET, SO_REUSEPORT, TRUE, NULL);
 #endif
 
   if (bind (socket->priv->fd, (struct sockaddr *) &addr,
@@ -2225,8 +2230,27 @@ GSocket *
 g_socket_accept (GSocket       *socket,
 		 GCancellable  *cancellable,
 		 GError       **error)
+{
+  g_return_val_if_fail (G_IS_SOCKET (socket), NULL);
+
+  return g_socket_accept_with_blocking (socket, socket->priv->blocking,
+					cancellable, error);
+}
+
+/* Like g_socket_accept(), but lets the caller override the blocking
+ * mode of @socket, so that a listener can drain all pending
+ * connections after a single readiness notification.
+ */
+GSocket *
+g_socket_accept_with_blocking (GSocket       *socket,
+			       gboolean       blocking,
+			       GCancellable  *cancellable,
+			       GError       **error)
 {
   GSocket *new_socket;
+#ifndef G_OS_WIN32
+  gboolean have_flags = FALSE;
+#endif
   gint ret;
 
   g_return_val_if_fail (G_IS_SOCKET (socket), NULL);
@@ -2236,12 +2260,27 @@ g_socket_accept (GSocket       *socket,
 
   while (TRUE)
     {
-      if (socket->priv->blocking &&
+      if (blocking &&
 	  !g_socket_condition_wait (socket,
 				    G_IO_IN, cancellable, error))
 	return NULL;
 
-      if ((ret = accept (socket->priv->fd, NULL, 0)) < 0)
+#ifdef HAVE_ACCEPT4
+      /* Get close-on-exec and non-blocking for free, saving the
+       * fcntl() calls below and in g_socket_constructed().
+       */
+      ret = accept4 (socket->priv->fd, NULL, 0, SOCK_CLOEXEC | SOCK_NONBLOCK);
+      have_flags = TRUE;
+      if (ret < 0 && (errno == ENOSYS || errno == EINVAL))
+	{
+	  ret = accept (socket->priv->fd, NULL, 0);
+	  have_flags = FALSE;
+	}
+#else
+      ret = accept (socket->priv->fd, NULL, 0);
+#endif
+
+      if (ret < 0)
 	{
 	  int errsv = get_socket_errno ();
 
@@ -2250,7 +2289,7 @@ g_socket_accept (GSocket       *socket,
 	  if (errsv == EINTR)
 	    continue;
 
-	  if (socket->priv->blocking)
+	  if (blocking)
 	    {
 #ifdef WSAEWOULDBLOCK
 	      if (errsv == WSAEWOULDBLOCK)
@@ -2279,6 +2318,7 @@ g_socket_accept (GSocket       *socket,
     WSAEventSelect (ret, NULL, 0);
   }
 #else
+  if (!have_flags)
   {
     int flags;
 
@@ -3198,7 +3238,7 @@ typedef struct {
   GSocket      *socket;
   GIOCondition  condition;
   GCancellable *cancellable;
-  GPollFD       cancel_pollfd;
+  GSource      *cancellable_source;
   gint64        timeout_time;
 } GSocketSource;
 
@@ -3291,10 +3331,7 @@ socket_source_finalize (GSource *source)
   g_object_unref (socket);
 
   if (socket_source->cancellable)
-    {
-      g_cancellable_release_fd (socket_source->cancellable);
-      g_object_unref (socket_source->cancellable);
-    }
+    g_object_unref (socket_source->cancellable);
 }
 
 static gboolean
@@ -3334,6 +3371,16 @@ static GSourceFuncs socket_source_funcs =
   (GSourceFunc)socket_source_closure_callback,
 };
 
+static gboolean
+socket_source_cancelled (GCancellable *cancellable,
+                         gpointer      user_data)
+{
+  /* The socket source notices the cancellation itself, this only
+   * wakes up its context.
+   */
+  return G_SOURCE_CONTINUE;
+}
+
 static GSource *
 socket_source_new (GSocket      *socket,
 		   GIOCondition  condition,
@@ -3361,11 +3408,20 @@ socket_source_new (GSocket      *socket,
   socket_source->socket = g_object_ref (socket);
   socket_source->condition = condition;
 
-  if (g_cancellable_make_pollfd (cancellable,
-                                 &socket_source->cancel_pollfd))
+  /* A child source is woken up through the context when the
+   * cancellable is cancelled, so no file descriptor is needed for it.
+   */
+  if (cancellable)
     {
+      GSource *cancellable_source;
+
       socket_source->cancellable = g_object_ref (cancellable);
-      g_source_add_poll (source, &socket_source->cancel_pollfd);
+      cancellable_source = g_cancellable_source_new (cancellable);
+      g_source_set_callback (cancellable_source,
+                             (GSourceFunc) socket_source_cancelled,
+                             NULL, NULL);
+      g_source_add_child_source (source, cancellable_source);
+      g_source_unref (cancellable_source);
     }
 
 #ifdef G_OS_WIN32
@@ -3389,6 +3445,93 @@ socket_source_new (GSocket      *socket,
   return source;
 }
 
+/* A watch is a socket source that stays attached between operations.
+ * It starts out disarmed, never dispatching, and is armed for one
+ * condition at a time by whoever owns it, normally one of the socket
+ * streams. This saves creating, attaching and destroying a source for
+ * every operation that would block.
+ *
+ * The watch must only be armed and disarmed from the thread running
+ * its context.
+ */
+GSource *
+g_socket_create_watch (GSocket *socket)
+{
+  GSource *source;
+
+  g_return_val_if_fail (G_IS_SOCKET (socket), NULL);
+
+  source = socket_source_new (socket, 0, NULL);
+  g_socket_watch_disarm (source);
+  g_source_set_name (source, "GSocket watch");
+
+  return source;
+}
+
+void
+g_socket_watch_arm (GSource      *watch,
+                    GIOCondition  condition,
+                    GCancellable *cancellable)
+{
+  GSocketSource *socket_source = (GSocketSource *)watch;
+  GSocket *socket = socket_source->socket;
+
+  g_socket_watch_disarm (watch);
+
+  condition |= G_IO_HUP | G_IO_ERR | G_IO_NVAL;
+
+  socket_source->condition = condition;
+#ifndef G_OS_WIN32
+  socket_source->pollfd.fd = socket->priv->fd;
+#endif
+  socket_source->pollfd.events = condition;
+  socket_source->pollfd.revents = 0;
+
+  if (cancellable)
+    {
+      GSource *cancellable_source;
+
+      socket_source->cancellable = g_object_ref (cancellable);
+      cancellable_source = g_cancellable_source_new (cancellable);
+      g_source_set_callback (cancellable_source,
+                             (GSourceFunc) socket_source_cancelled,
+                             NULL, NULL);
+      g_source_add_child_source (watch, cancellable_source);
+      g_source_unref (cancellable_source);
+      socket_source->cancellable_source = cancellable_source;
+    }
+
+  if (socket->priv->timeout)
+    socket_source->timeout_time = g_get_monotonic_time () +
+                                  socket->priv->timeout * 1000000;
+  else
+    socket_source->timeout_time = 0;
+}
+
+void
+g_socket_watch_disarm (GSource *watch)
+{
+  GSocketSource *socket_source = (GSocketSource *)watch;
+
+  /* poll() reports hangups even for no events, so take the file
+   * descriptor out altogether
+   */
+  socket_source->condition = 0;
+#ifndef G_OS_WIN32
+  socket_source->pollfd.fd = -1;
+#endif
+  socket_source->pollfd.events = 0;
+  socket_source->pollfd.revents = 0;
+  socket_source->timeout_time = 0;
+
+  if (socket_source->cancellable_source)
+    {
+      g_source_remove_child_source (watch, socket_source->cancellable_source);
+      socket_source->cancellable_source = NULL;
+    }
+  g_clear_object (&socket_source->cancellable);
+}
+
 /**
  * g_socket_create_source: (skip)
  * @socket: a #GSocket
@@ -3587,6 +3730,7 @@ g_socket_condition_timed_wait (GSocket       *socket,
     WSAEVENT events[2];
     DWORD res;
     GPollFD cancel_fd;
+    gulong cancel_handler;
     int num_events;
 
     /* Always check these */
@@ -3597,7 +3741,8 @@ g_socket_condition_timed_wait (GSocket       *socket,
     num_events = 0;
     events[num_events++] = socket->priv->event;
 
-    if (g_cancellable_make_pollfd (cancellable, &cancel_fd))
+    if (g_cancellable_make_thread_pollfd (cancellable, &cancel_fd,
+                                          &cancel_handler))
       events[num_events++] = (WSAEVENT)cancel_fd.fd;
 
     if (timeout == -1)
@@ -3639,13 +3784,14 @@ g_socket_condition_timed_wait (GSocket       *socket,
       }
     remove_condition_watch (socket, &condition);
     if (num_events > 1)
-      g_cancellable_release_fd (cancellable);
+      g_cancellable_release_thread_pollfd (cancellable, cancel_handler);
 
     return (condition & current_condition) != 0;
   }
 #else
   {
     GPollFD poll_fd[2];
+    gulong cancel_handler;
     gint result;
     gint num;
 
@@ -3653,7 +3799,8 @@ g_socket_condition_timed_wait (GSocket       *socket,
     poll_fd[0].events = condition;
     num = 1;
 
-    if (g_cancellable_make_pollfd (cancellable, &poll_fd[1]))
+    if (g_cancellable_make_thread_pollfd (cancellable, &poll_fd[1],
+                                          &cancel_handler))
       num++;
 
     while (TRUE)
@@ -3671,7 +3818,7 @@ g_socket_condition_timed_wait (GSocket       *socket,
       }
     
     if (num > 1)
-      g_cancellable_release_fd (cancellable);
+      g_cancellable_release_thread_pollfd (cancellable, cancel_handler);
 
     if (result == 0)
       {
@@ -3751,6 +3898,31 @@ g_socket_send_message (GSocket                *socket,
 		       gint                    flags,
 		       GCancellable           *cancellable,
 		       GError                **error)
+{
+  g_return_val_if_fail (G_IS_SOCKET (socket), -1);
+
+  return g_socket_send_message_with_blocking (socket, address,
+                                              vectors, num_vectors,
+                                              messages, num_messages,
+                                              flags, socket->priv->blocking,
+                                              cancellable, error);
+}
+
+/* Like g_socket_send_message(), but with the choice of blocking or
+ * non-blocking behavior given by @blocking, as with
+ * g_socket_send_with_blocking().
+ */
+gssize
+g_socket_send_message_with_blocking (GSocket                *socket,
+                                     GSocketAddress         *address,
+                                     GOutputVector          *vectors,
+                                     gint                    num_vectors,
+                                     GSocketControlMessage **messages,
+                                     gint                    num_messages,
+                                     gint                    flags,
+                                     gboolean                blocking,
+                                     GCancellable           *cancellable,
+                                     GError                **error)
 {
   GOutputVector one_vector;
   char zero;
@@ -3872,7 +4044,7 @@ g_socket_send_message (GSocket                *socket,
 
     while (1)
       {
-	if (socket->priv->blocking &&
+	if (blocking &&
 	    !g_socket_condition_wait (socket,
 				      G_IO_OUT, cancellable, error))
 	  return -1;
@@ -3885,7 +4057,7 @@ g_socket_send_message (GSocket                *socket,
 	    if (errsv == EINTR)
 	      continue;
 
-	    if (socket->priv->blocking &&
+	    if (blocking &&
 		(errsv == EWOULDBLOCK ||
 		 errsv == EAGAIN))
 	      continue;
@@ -3940,7 +4112,7 @@ g_socket_send_message (GSocket                *socket,
 
     while (1)
       {
-	if (socket->priv->blocking &&
+	if (blocking &&
 	    !g_socket_condition_wait (socket,
 				      G_IO_OUT, cancellable, error))
 	  return -1;
@@ -3967,7 +4139,7 @@ g_socket_send_message (GSocket                *socket,
 	    if (errsv == WSAEWOULDBLOCK)
 	      win32_unset_event_mask (socket, FD_WRITE);
 
-	    if (socket->priv->blocking &&
+	    if (blocking &&
 		errsv == WSAEWOULDBLOCK)
 	      continue;
 
@@ -4039,6 +4211,68 @@ cache_recv_address (GSocket *socket, struct sockaddr *native, int native_len)
   return saddr;
 }
 
+#ifndef G_OS_WIN32
+static void
+decode_control_messages (struct msghdr            *msg,
+                         GSocketControlMessage  ***messages,
+                         gint                     *num_messages)
+{
+  GPtrArray *my_messages = NULL;
+  struct cmsghdr *cmsg;
+
+  if (msg->msg_controllen >= sizeof (struct cmsghdr))
+    {
+      for (cmsg = CMSG_FIRSTHDR (msg); cmsg; cmsg = CMSG_NXTHDR (msg, cmsg))
+        {
+          GSocketControlMessage *message;
+
+          message = g_socket_control_message_deserialize (cmsg->cmsg_level,
+                                                          cmsg->cmsg_type,
+                                                          cmsg->cmsg_len - ((char *)CMSG_DATA (cmsg) - (char *)cmsg),
+                                                          CMSG_DATA (cmsg));
+          if (message == NULL)
+            /* We've already spewed about the problem in the
+               deserialization code, so just continue */
+            continue;
+
+          if (messages == NULL)
+            {
+              /* we have to do it this way if the user ignores the
+               * messages so that we will close any received fds.
+               */
+              g_object_unref (message);
+            }
+          else
+            {
+              if (my_messages == NULL)
+                my_messages = g_ptr_array_new ();
+              g_ptr_array_add (my_messages, message);
+            }
+        }
+    }
+
+  if (num_messages)
+    *num_messages = my_messages != NULL ? my_messages->len : 0;
+
+  if (messages)
+    {
+      if (my_messages == NULL)
+        {
+          *messages = NULL;
+        }
+      else
+        {
+          g_ptr_array_add (my_messages, NULL);
+          *messages = (GSocketControlMessage **) g_ptr_array_free (my_messages, FALSE);
+        }
+    }
+  else
+    {
+      g_assert (my_messages == NULL);
+    }
+}
+#endif
+
 /**
  * g_socket_receive_message:
  * @socket: a #GSocket
@@ -4127,6 +4361,31 @@ g_socket_receive_message (GSocket                 *socket,
 			  gint                    *flags,
 			  GCancellable            *cancellable,
 			  GError                 **error)
+{
+  g_return_val_if_fail (G_IS_SOCKET (socket), -1);
+
+  return g_socket_receive_message_with_blocking (socket, address,
+                                                 vectors, num_vectors,
+                                                 messages, num_messages,
+                                                 flags, socket->priv->blocking,
+                                                 cancellable, error);
+}
+
+/* Like g_socket_receive_message(), but with the choice of blocking or
+ * non-blocking behavior given by @blocking, as with
+ * g_socket_receive_with_blocking().
+ */
+gssize
+g_socket_receive_message_with_blocking (GSocket                 *socket,
+                                        GSocketAddress         **address,
+                                        GInputVector            *vectors,
+                                        gint                     num_vectors,
+                                        GSocketControlMessage ***messages,
+                                        gint                    *num_messages,
+                                        gint                    *flags,
+                                        gboolean                 blocking,
+                                        GCancellable            *cancellable,
+                                        GError                 **error)
 {
   GInputVector one_vector;
   char one_byte;
@@ -4222,7 +4481,7 @@ g_socket_receive_message (GSocket                 *socket,
     /* do it */
     while (1)
       {
-	if (socket->priv->blocking &&
+	if (blocking &&
 	    !g_socket_condition_wait (socket,
 				      G_IO_IN, cancellable, error))
 	  return -1;
@@ -4244,7 +4503,7 @@ g_socket_receive_message (GSocket                 *socket,
 	    if (errsv == EINTR)
 	      continue;
 
-	    if (socket->priv->blocking &&
+	    if (blocking &&
 		(errsv == EWOULDBLOCK ||
 		 errsv == EAGAIN))
 	      continue;
@@ -4265,61 +4524,7 @@ g_socket_receive_message (GSocket                 *socket,
       }
 
     /* decode control messages */
-    {
-      GPtrArray *my_messages = NULL;
-      struct cmsghdr *cmsg;
-
-      if (msg.msg_controllen >= sizeof (struct cmsghdr))
-        {
-          for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg))
-            {
-              GSocketControlMessage *message;
-
-              message = g_socket_control_message_deserialize (cmsg->cmsg_level,
-                                                              cmsg->cmsg_type,
-                                                              cmsg->cmsg_len - ((char *)CMSG_DATA (cmsg) - (char *)cmsg),
-                                                              CMSG_DATA (cmsg));
-              if (message == NULL)
-                /* We've already spewed about the problem in the
-                   deserialization code, so just continue */
-                continue;
-
-              if (messages == NULL)
-                {
-                  /* we have to do it this way if the user ignores the
-                   * messages so that we will close any received fds.
-                   */
-                  g_object_unref (message);
-                }
-              else
-                {
-                  if (my_messages == NULL)
-                    my_messages = g_ptr_array_new ();
-                  g_ptr_array_add (my_messages, message);
-                }
-            }
-        }
-
-      if (num_messages)
-	*num_messages = my_messages != NULL ? my_messages->len : 0;
-
-      if (messages)
-	{
-	  if (my_messages == NULL)
-	    {
-	      *messages = NULL;
-	    }
-	  else
-	    {
-	      g_ptr_array_add (my_messages, NULL);
-	      *messages = (GSocketControlMessage **) g_ptr_array_free (my_messages, FALSE);
-	    }
-	}
-      else
-	{
-	  g_assert (my_messages == NULL);
-	}
-    }
+    decode_control_messages (&msg, messages, num_messages);
 
     /* capture the flags */
     if (flags != NULL)
@@ -4354,7 +4559,7 @@ g_socket_receive_message (GSocket                 *socket,
     /* do it */
     while (1)
       {
-	if (socket->priv->blocking &&
+	if (blocking &&
 	    !g_socket_condition_wait (socket,
 				      G_IO_IN, cancellable, error))
 	  return -1;
@@ -4380,7 +4585,7 @@ g_socket_receive_message (GSocket                 *socket,
 
 	    win32_unset_event_mask (socket, FD_READ);
 
-	    if (socket->priv->blocking &&
+	    if (blocking &&
 		errsv == WSAEWOULDBLOCK)
 	      continue;
 
@@ -4414,6 +4619,527 @@ g_socket_receive_message (GSocket                 *socket,
 #endif
 }
 
+/* The number of messages that g_socket_send_messages() and
+ * g_socket_receive_messages() pass to the kernel at once.
+ */
+#define MMSG_CHUNK_SIZE 64
+
+#if !defined (G_OS_WIN32) && (defined (HAVE_SENDMMSG) || defined (HAVE_RECVMMSG))
+static struct iovec *
+vectors_to_iovec (gpointer  vectors,
+                  guint     num_vectors,
+                  GArray   *iov_storage)
+{
+  /* this entire expression will be evaluated at compile time */
+  if (sizeof (struct iovec) == sizeof (GInputVector) &&
+      sizeof ((struct iovec *) 0)->iov_base == sizeof ((GInputVector *) 0)->buffer &&
+      G_STRUCT_OFFSET (struct iovec, iov_base) ==
+      G_STRUCT_OFFSET (GInputVector, buffer) &&
+      sizeof ((struct iovec *) 0)->iov_len == sizeof ((GInputVector *) 0)->size &&
+      G_STRUCT_OFFSET (struct iovec, iov_len) ==
+      G_STRUCT_OFFSET (GInputVector, size) &&
+      G_STRUCT_OFFSET (GInputVector, buffer) ==
+      G_STRUCT_OFFSET (GOutputVector, buffer) &&
+      G_STRUCT_OFFSET (GInputVector, size) ==
+      G_STRUCT_OFFSET (GOutputVector, size))
+    /* ABI is compatible */
+    return vectors;
+  else
+    /* ABI is incompatible */
+    {
+      GInputVector *input_vectors = vectors;
+      guint i;
+
+      for (i = 0; i < num_vectors; i++)
+        {
+          struct iovec iov;
+
+          iov.iov_base = input_vectors[i].buffer;
+          iov.iov_len = input_vectors[i].size;
+          g_array_append_val (iov_storage, iov);
+        }
+
+      /* only the caller knows where its vectors start */
+      return NULL;
+    }
+}
+#endif
+
+/**
+ * g_socket_send_messages:
+ * @socket: a #GSocket
+ * @messages: (array length=num_messages): an array of #GOutputMessage structs
+ * @num_messages: the number of elements in @messages
+ * @flags: an int containing #GSocketMsgFlags flags
+ * @cancellable: (allow-none): a %GCancellable or %NULL
+ * @error: #GError for error reporting, or %NULL to ignore.
+ *
+ * Sends several messages on @socket at once. Each #GOutputMessage is
+ * sent like with g_socket_send_message(), and its @bytes_sent field
+ * is set to the number of bytes sent for it.
+ *
+ * This is meant for datagram sockets, where it saves system calls
+ * when lots of small messages are sent: on Linux, the messages are
+ * handed to the kernel in batches with sendmmsg(). Elsewhere, they
+ * are sent one after another.
+ *
+ * If the socket is in blocking mode the call will block until all of
+ * @messages are sent. In non-blocking mode it sends as many messages
+ * as there is space for in the socket queue, and returns
+ * %G_IO_ERROR_WOULD_BLOCK if it could not send any.
+ *
+ * On error -1 is returned and @error is set accordingly. An error is
+ * only returned if no message at all could be sent; otherwise the
+ * number of messages sent before the error is returned.
+ *
+ * Returns: the number of messages sent, or -1 on error
+ *
+ * Since: 2.40
+ */
+gint
+g_socket_send_messages (GSocket         *socket,
+                        GOutputMessage  *messages,
+                        guint            num_messages,
+                        gint             flags,
+                        GCancellable    *cancellable,
+                        GError         **error)
+{
+  GError *child_error = NULL;
+  guint sent = 0;
+
+  g_return_val_if_fail (G_IS_SOCKET (socket), -1);
+  g_return_val_if_fail (num_messages == 0 || messages != NULL, -1);
+  g_return_val_if_fail (num_messages <= G_MAXINT, -1);
+
+  if (!check_socket (socket, error))
+    return -1;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return -1;
+
+#if !defined (G_OS_WIN32) && defined (HAVE_SENDMMSG)
+  {
+    struct mmsghdr msgvec[MMSG_CHUNK_SIZE];
+    struct sockaddr_storage names[MMSG_CHUNK_SIZE];
+    GArray *iov_storage = NULL;
+    gchar zero = '\0';
+    struct iovec zero_iov;
+
+    zero_iov.iov_base = &zero;
+    zero_iov.iov_len = 1;
+
+    while (sent < num_messages)
+      {
+        guint n = MIN (num_messages - sent, MMSG_CHUNK_SIZE);
+        gint result;
+        guint i;
+
+        memset (msgvec, 0, n * sizeof msgvec[0]);
+
+        if (iov_storage)
+          g_array_set_size (iov_storage, 0);
+
+        for (i = 0; i < n; i++)
+          {
+            GOutputMessage *message = &messages[sent + i];
+            struct msghdr *msg = &msgvec[i].msg_hdr;
+
+            if (message->address)
+              {
+                msg->msg_namelen = g_socket_address_get_native_size (message->address);
+                msg->msg_name = &names[i];
+                if (!g_socket_address_to_native (message->address, msg->msg_name,
+                                                 sizeof names[i], &child_error))
+                  goto out;
+              }
+
+            /* as with g_socket_send_message() */
+            if (message->num_vectors == 0)
+              {
+                msg->msg_iov = &zero_iov;
+                msg->msg_iovlen = 1;
+              }
+            else
+              {
+                if (iov_storage == NULL)
+                  iov_storage = g_array_new (FALSE, FALSE, sizeof (struct iovec));
+
+                msg->msg_iov = vectors_to_iovec (message->vectors,
+                                                 message->num_vectors,
+                                                 iov_storage);
+                msg->msg_iovlen = message->num_vectors;
+              }
+
+            if (message->num_control_messages > 0)
+              {
+                struct cmsghdr *cmsg;
+                guint j;
+
+                for (j = 0; j < message->num_control_messages; j++)
+                  msg->msg_controllen += CMSG_SPACE (g_socket_control_message_get_size (message->control_messages[j]));
+                msg->msg_control = g_malloc0 (msg->msg_controllen);
+
+                cmsg = CMSG_FIRSTHDR (msg);
+                for (j = 0; j < message->num_control_messages; j++)
+                  {
+                    GSocketControlMessage *control = message->control_messages[j];
+
+                    cmsg->cmsg_level = g_socket_control_message_get_level (control);
+                    cmsg->cmsg_type = g_socket_control_message_get_msg_type (control);
+                    cmsg->cmsg_len = CMSG_LEN (g_socket_control_message_get_size (control));
+                    g_socket_control_message_serialize (control, CMSG_DATA (cmsg));
+                    cmsg = CMSG_NXTHDR (msg, cmsg);
+                  }
+              }
+          }
+
+        /* the converted vectors are only complete now */
+        if (iov_storage && iov_storage->len > 0)
+          {
+            struct iovec *iov = (struct iovec *) iov_storage->data;
+
+            for (i = 0; i < n; i++)
+              if (msgvec[i].msg_hdr.msg_iov == NULL)
+                {
+                  msgvec[i].msg_hdr.msg_iov = iov;
+                  iov += msgvec[i].msg_hdr.msg_iovlen;
+                }
+          }
+
+        while (1)
+          {
+            if (socket->priv->blocking &&
+                !g_socket_condition_wait (socket,
+                                          G_IO_OUT, cancellable, &child_error))
+              goto out;
+
+            result = sendmmsg (socket->priv->fd, msgvec, n,
+                               flags | G_SOCKET_DEFAULT_SEND_FLAGS);
+            if (result < 0)
+              {
+                int errsv = get_socket_errno ();
+
+                if (errsv == EINTR)
+                  continue;
+
+                if (socket->priv->blocking &&
+                    (errsv == EWOULDBLOCK ||
+                     errsv == EAGAIN))
+                  continue;
+
+                g_set_error (&child_error, G_IO_ERROR,
+                             socket_io_error_from_errno (errsv),
+                             _("Error sending message: %s"), socket_strerror (errsv));
+                goto out;
+              }
+            break;
+          }
+
+        for (i = 0; i < n; i++)
+          {
+            if (i < (guint) result)
+              messages[sent + i].bytes_sent = msgvec[i].msg_len;
+            g_free (msgvec[i].msg_hdr.msg_control);
+            msgvec[i].msg_hdr.msg_control = NULL;
+          }
+
+        sent += result;
+
+        /* the socket queue is full */
+        if ((guint) result < n && !socket->priv->blocking)
+          break;
+      }
+
+  out:
+    if (child_error)
+      {
+        guint i;
+
+        for (i = 0; i < MIN (num_messages - sent, MMSG_CHUNK_SIZE); i++)
+          g_free (msgvec[i].msg_hdr.msg_control);
+      }
+    if (iov_storage)
+      g_array_unref (iov_storage);
+  }
+#else
+  for (sent = 0; sent < num_messages; sent++)
+    {
+      GOutputMessage *message = &messages[sent];
+      gssize result;
+
+      result = g_socket_send_message (socket, message->address,
+                                      message->vectors, message->num_vectors,
+                                      message->control_messages,
+                                      message->num_control_messages,
+                                      flags, cancellable, &child_error);
+      if (result < 0)
+        break;
+
+      message->bytes_sent = result;
+    }
+#endif
+
+  if (child_error)
+    {
+      if (sent > 0)
+        {
+          g_error_free (child_error);
+          return sent;
+        }
+
+      g_propagate_error (error, child_error);
+      return -1;
+    }
+
+  return sent;
+}
+
+/**
+ * g_socket_receive_messages:
+ * @socket: a #GSocket
+ * @messages: (array length=num_messages): an array of #GInputMessage structs
+ * @num_messages: the number of elements in @messages
+ * @flags: an int containing #GSocketMsgFlags flags for the overall operation
+ * @cancellable: (allow-none): a %GCancellable or %NULL
+ * @error: #GError for error reporting, or %NULL to ignore.
+ *
+ * Receives several messages from @socket at once. Each #GInputMessage
+ * is filled in like the arguments of g_socket_receive_message(), and
+ * its @bytes_received and @flags fields are set for the message that
+ * was received into it.
+ *
+ * This is meant for datagram sockets, where it saves system calls
+ * when lots of small messages come in: on Linux, the messages are
+ * taken from the kernel in batches with recvmmsg(). Elsewhere, they
+ * are received one after another.
+ *
+ * If the socket is in blocking mode the call will block until there
+ * is at least one message to receive, and then returns all the
+ * messages that are available, up to @num_messages. In non-blocking
+ * mode, %G_IO_ERROR_WOULD_BLOCK is returned if there is no message
+ * to receive.
+ *
+ * On error -1 is returned and @error is set accordingly. An error is
+ * only returned if no message at all could be received; otherwise the
+ * number of messages received before the error is returned.
+ *
+ * Returns: the number of messages received, or -1 on error
+ *
+ * Since: 2.40
+ */
+gint
+g_socket_receive_messages (GSocket        *socket,
+                           GInputMessage  *messages,
+                           guint           num_messages,
+                           gint            flags,
+                           GCancellable   *cancellable,
+                           GError        **error)
+{
+  GError *child_error = NULL;
+  guint received = 0;
+
+  g_return_val_if_fail (G_IS_SOCKET (socket), -1);
+  g_return_val_if_fail (num_messages == 0 || messages != NULL, -1);
+  g_return_val_if_fail (num_messages <= G_MAXINT, -1);
+
+  if (!check_socket (socket, error))
+    return -1;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return -1;
+
+#if !defined (G_OS_WIN32) && defined (HAVE_RECVMMSG)
+  {
+    struct mmsghdr msgvec[MMSG_CHUNK_SIZE];
+    struct sockaddr_storage names[MMSG_CHUNK_SIZE];
+    GArray *iov_storage = NULL;
+    gboolean wait = socket->priv->blocking;
+
+    while (received < num_messages)
+      {
+        guint n = MIN (num_messages - received, MMSG_CHUNK_SIZE);
+        gint result = 0;
+        gint mmsg_flags = flags;
+        guint i;
+
+        memset (msgvec, 0, n * sizeof msgvec[0]);
+
+        if (iov_storage)
+          g_array_set_size (iov_storage, 0);
+
+        for (i = 0; i < n; i++)
+          {
+            GInputMessage *message = &messages[received + i];
+            struct msghdr *msg = &msgvec[i].msg_hdr;
+
+            if (message->address)
+              {
+                msg->msg_name = &names[i];
+                msg->msg_namelen = sizeof names[i];
+              }
+
+            if (message->num_vectors > 0)
+              {
+                if (iov_storage == NULL)
+                  iov_storage = g_array_new (FALSE, FALSE, sizeof (struct iovec));
+
+                msg->msg_iov = vectors_to_iovec (message->vectors,
+                                                 message->num_vectors,
+                                                 iov_storage);
+                msg->msg_iovlen = message->num_vectors;
+              }
+
+            /* Without a control buffer, the kernel drops any control
+             * messages, closing the fds that were passed.
+             */
+            if (message->control_messages || message->num_control_messages)
+              {
+                msg->msg_controllen = 2048;
+                msg->msg_control = g_malloc (msg->msg_controllen);
+#ifdef MSG_CMSG_CLOEXEC
+                mmsg_flags |= MSG_CMSG_CLOEXEC;
+#endif
+              }
+          }
+
+        /* the converted vectors are only complete now */
+        if (iov_storage && iov_storage->len > 0)
+          {
+            struct iovec *iov = (struct iovec *) iov_storage->data;
+
+            for (i = 0; i < n; i++)
+              if (msgvec[i].msg_hdr.msg_iov == NULL &&
+                  msgvec[i].msg_hdr.msg_iovlen > 0)
+                {
+                  msgvec[i].msg_hdr.msg_iov = iov;
+                  iov += msgvec[i].msg_hdr.msg_iovlen;
+                }
+          }
+
+        while (1)
+          {
+            if (wait &&
+                !g_socket_condition_wait (socket,
+                                          G_IO_IN, cancellable, &child_error))
+              break;
+
+            result = recvmmsg (socket->priv->fd, msgvec, n, mmsg_flags, NULL);
+#ifdef MSG_CMSG_CLOEXEC
+            if (result < 0 && get_socket_errno () == EINVAL &&
+                (mmsg_flags & MSG_CMSG_CLOEXEC))
+              {
+                /* We must be running on an old kernel.  Call without the flag. */
+                mmsg_flags &= ~(MSG_CMSG_CLOEXEC);
+                result = recvmmsg (socket->priv->fd, msgvec, n, mmsg_flags, NULL);
+              }
+#endif
+
+            if (result < 0)
+              {
+                int errsv = get_socket_errno ();
+
+                if (errsv == EINTR)
+                  continue;
+
+                if (wait &&
+                    (errsv == EWOULDBLOCK ||
+                     errsv == EAGAIN))
+                  continue;
+
+                g_set_error (&child_error, G_IO_ERROR,
+                             socket_io_error_from_errno (errsv),
+                             _("Error receiving message: %s"), socket_strerror (errsv));
+              }
+            break;
+          }
+
+        if (child_error)
+          result = 0;
+
+        for (i = 0; i < n; i++)
+          {
+            GInputMessage *message = &messages[received + i];
+            struct msghdr *msg = &msgvec[i].msg_hdr;
+
+            if (i < (guint) result)
+              {
+                message->bytes_received = msgvec[i].msg_len;
+                message->flags = msg->msg_flags;
+
+                if (message->address)
+                  *message->address = cache_recv_address (socket, msg->msg_name,
+                                                          msg->msg_namelen);
+
+                if (msg->msg_control)
+                  {
+                    gint num_control_messages;
+
+                    decode_control_messages (msg, message->control_messages,
+                                             &num_control_messages);
+                    if (message->num_control_messages)
+                      *message->num_control_messages = num_control_messages;
+                  }
+              }
+
+            g_free (msg->msg_control);
+          }
+
+        received += result;
+
+        /* only wait for the first message, then take what is there */
+        if (child_error || (guint) result < n)
+          break;
+        wait = FALSE;
+      }
+
+    if (iov_storage)
+      g_array_unref (iov_storage);
+  }
+#else
+  for (received = 0; received < num_messages; received++)
+    {
+      GInputMessage *message = &messages[received];
+      gint msg_flags = flags;
+      gint num_control_messages;
+      gssize result;
+
+      /* only wait for the first message, then take what is there */
+      if (received > 0 &&
+          !(g_socket_condition_check (socket, G_IO_IN) & G_IO_IN))
+        break;
+
+      result = g_socket_receive_message (socket, message->address,
+                                         message->vectors,
+                                         message->num_vectors,
+                                         message->control_messages,
+                                         &num_control_messages,
+                                         &msg_flags, cancellable,
+                                         &child_error);
+      if (result < 0)
+        break;
+
+      message->bytes_received = result;
+      message->flags = msg_flags;
+      if (message->num_control_messages)
+        *message->num_control_messages = num_control_messages;
+    }
+#endif
+
+  if (child_error)
+    {
+      if (received > 0)
+        {
+          g_error_free (child_error);
+          return received;
+        }
+
+      g_propagate_error (error, child_error);
+      return -1;
+    }
+
+  return received;
+}
+
 /**
  * g_socket_get_credentials:
  * @socket: a #GSocket.
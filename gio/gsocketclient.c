@@ -48,6 +48,7 @@
 #include <gio/gtlscertificate.h>
 #include <gio/gtlsclientconnection.h>
 #include <gio/ginetaddress.h>
+#include "gsocketconnectionpool-private.h"
 #include "glibintl.h"
 
 
@@ -94,7 +95,8 @@ enum
   PROP_ENABLE_PROXY,
   PROP_TLS,
   PROP_TLS_VALIDATION_FLAGS,
-  PROP_PROXY_RESOLVER
+  PROP_PROXY_RESOLVER,
+  PROP_CONNECTION_POOL
 };
 
 struct _GSocketClientPrivate
@@ -109,6 +111,7 @@ struct _GSocketClientPrivate
   gboolean tls;
   GTlsCertificateFlags tls_validation_flags;
   GProxyResolver *proxy_resolver;
+  GSocketConnectionPool *connection_pool;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GSocketClient, g_socket_client, G_TYPE_OBJECT)
@@ -230,6 +233,7 @@ g_socket_client_finalize (GObject *object)
 
   g_clear_object (&client->priv->local_address);
   g_clear_object (&client->priv->proxy_resolver);
+  g_clear_object (&client->priv->connection_pool);
 
   G_OBJECT_CLASS (g_socket_client_parent_class)->finalize (object);
 
@@ -282,6 +286,10 @@ g_socket_client_get_property (GObject    *object,
 	g_value_set_object (value, g_socket_client_get_proxy_resolver (client));
 	break;
 
+      case PROP_CONNECTION_POOL:
+	g_value_set_object (value, client->priv->connection_pool);
+	break;
+
       default:
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -333,6 +341,10 @@ g_socket_client_set_property (GObject      *object,
       g_socket_client_set_proxy_resolver (client, g_value_get_object (value));
       break;
 
+    case PROP_CONNECTION_POOL:
+      g_socket_client_set_connection_pool (client, g_value_get_object (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -754,6 +766,110 @@ g_socket_client_set_proxy_resolver (GSocketClient  *client,
     g_object_ref (client->priv->proxy_resolver);
 }
 
+/**
+ * g_socket_client_get_connection_pool:
+ * @client: a #GSocketClient.
+ *
+ * Gets the #GSocketConnectionPool used by @client, if any.
+ *
+ * Returns: (transfer none) (allow-none): the connection pool, or %NULL
+ *
+ * Since: 2.40
+ */
+GSocketConnectionPool *
+g_socket_client_get_connection_pool (GSocketClient *client)
+{
+  g_return_val_if_fail (G_IS_SOCKET_CLIENT (client), NULL);
+
+  return client->priv->connection_pool;
+}
+
+/**
+ * g_socket_client_set_connection_pool:
+ * @client: a #GSocketClient.
+ * @pool: (allow-none): a #GSocketConnectionPool, or %NULL
+ *
+ * Makes @client reuse the idle connections kept by @pool.
+ *
+ * Connecting to a #GNetworkAddress, #GNetworkService or
+ * #GInetSocketAddress first looks in @pool for an idle connection to
+ * the same destination, made with the same socket, proxy and TLS
+ * settings, and returns it if there is one. New connections are
+ * remembered by @pool, so that they can be given back with
+ * g_socket_connection_pool_release() when you are done with them.
+ * Clients with a #GSocketClient:local-address do not use the pool.
+ *
+ * Since: 2.40
+ */
+void
+g_socket_client_set_connection_pool (GSocketClient         *client,
+                                     GSocketConnectionPool *pool)
+{
+  g_return_if_fail (G_IS_SOCKET_CLIENT (client));
+  g_return_if_fail (pool == NULL || G_IS_SOCKET_CONNECTION_POOL (pool));
+
+  if (client->priv->connection_pool == pool)
+    return;
+
+  g_clear_object (&client->priv->connection_pool);
+  if (pool)
+    client->priv->connection_pool = g_object_ref (pool);
+
+  g_object_notify (G_OBJECT (client), "connection-pool");
+}
+
+/* Identifies the destination of a connection, and the client settings
+ * that affect what the connection ends up being.
+ */
+static gchar *
+connection_pool_key (GSocketClient      *client,
+                     GSocketConnectable *connectable)
+{
+  GSocketClientPrivate *priv = client->priv;
+  gchar *destination, *key;
+
+  if (priv->connection_pool == NULL || priv->local_address != NULL)
+    return NULL;
+
+  if (G_IS_NETWORK_ADDRESS (connectable))
+    {
+      GNetworkAddress *addr = G_NETWORK_ADDRESS (connectable);
+
+      destination = g_strdup_printf ("%s:%u",
+                                     g_network_address_get_hostname (addr),
+                                     g_network_address_get_port (addr));
+    }
+  else if (G_IS_NETWORK_SERVICE (connectable))
+    {
+      GNetworkService *srv = G_NETWORK_SERVICE (connectable);
+
+      destination = g_strdup_printf ("_%s._%s.%s",
+                                     g_network_service_get_service (srv),
+                                     g_network_service_get_protocol (srv),
+                                     g_network_service_get_domain (srv));
+    }
+  else if (G_IS_INET_SOCKET_ADDRESS (connectable))
+    {
+      GInetSocketAddress *addr = G_INET_SOCKET_ADDRESS (connectable);
+      gchar *host;
+
+      host = g_inet_address_to_string (g_inet_socket_address_get_address (addr));
+      destination = g_strdup_printf ("[%s]:%u", host,
+                                     g_inet_socket_address_get_port (addr));
+      g_free (host);
+    }
+  else
+    return NULL;
+
+  key = g_strdup_printf ("%s %d %d %d %d %p %d %u", destination,
+                         priv->family, priv->type, priv->protocol,
+                         can_use_proxy (client), priv->proxy_resolver,
+                         priv->tls, priv->tls_validation_flags);
+  g_free (destination);
+
+  return key;
+}
+
 static void
 g_socket_client_class_init (GSocketClientClass *class)
 {
@@ -963,6 +1079,22 @@ g_socket_client_class_init (GSocketClientClass *class)
                                                         G_PARAM_CONSTRUCT |
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GSocketClient:connection-pool:
+   *
+   * The pool of idle connections to reuse, see
+   * g_socket_client_set_connection_pool().
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class, PROP_CONNECTION_POOL,
+                                   g_param_spec_object ("connection-pool",
+                                                        P_("Connection pool"),
+                                                        P_("The pool of idle connections to reuse"),
+                                                        G_TYPE_SOCKET_CONNECTION_POOL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -1014,9 +1146,23 @@ g_socket_client_connect (GSocketClient       *client,
   GIOStream *connection = NULL;
   GSocketAddressEnumerator *enumerator = NULL;
   GError *last_error, *tmp_error;
+  gchar *pool_key;
 
   last_error = NULL;
 
+  pool_key = connection_pool_key (client, connectable);
+  if (pool_key)
+    {
+      connection = (GIOStream *) g_socket_connection_pool_take (client->priv->connection_pool,
+                                                                pool_key);
+      if (connection)
+        {
+          g_free (pool_key);
+          g_socket_client_emit_event (client, G_SOCKET_CLIENT_COMPLETE, connectable, connection);
+          return G_SOCKET_CONNECTION (connection);
+        }
+    }
+
   if (can_use_proxy (client))
     {
       enumerator = g_socket_connectable_proxy_enumerate (connectable);
@@ -1194,6 +1340,11 @@ g_socket_client_connect (GSocketClient       *client,
     }
   g_object_unref (enumerator);
 
+  if (connection && pool_key)
+    g_socket_connection_pool_track (client->priv->connection_pool,
+                                    G_SOCKET_CONNECTION (connection), pool_key);
+  g_free (pool_key);
+
   g_socket_client_emit_event (client, G_SOCKET_CLIENT_COMPLETE, connectable, connection);
   return G_SOCKET_CONNECTION (connection);
 }
@@ -1360,6 +1511,11 @@ g_socket_client_connect_to_uri (GSocketClient  *client,
   return connection;
 }
 
+/* How long an async connection attempt gets to itself before the next
+ * address is tried alongside it; see RFC 8305 ("Happy Eyeballs").
+ */
+#define CONNECTION_ATTEMPT_DELAY_MS 250
+
 typedef struct
 {
   GTask *task;
@@ -1372,24 +1528,109 @@ typedef struct
   GSocket *current_socket;
   GIOStream *connection;
 
+  /* Attempts still racing to connect; once one of them wins, its
+   * state is moved into the fields above.
+   */
+  GSList *connection_attempts;
+  GSocketAddress *next_addr;
+  GSource *delay_source;
+  gboolean enumerating;
+  gboolean enumeration_completed;
+  gboolean completed;
+
+  gchar *pool_key;
   GError *last_error;
 } GSocketClientAsyncConnectData;
 
+typedef struct
+{
+  GSocketClientAsyncConnectData *data;
+  GSocketAddress *address;
+  GProxyAddress *proxy_addr;
+  GSocket *socket;
+  GIOStream *connection;
+  GCancellable *cancellable;
+  gulong cancelled_id;
+} ConnectionAttempt;
+
+static void
+clear_connection_attempt_delay (GSocketClientAsyncConnectData *data)
+{
+  if (data->delay_source)
+    {
+      g_source_destroy (data->delay_source);
+      g_source_unref (data->delay_source);
+      data->delay_source = NULL;
+    }
+}
+
 static void
 g_socket_client_async_connect_data_free (GSocketClientAsyncConnectData *data)
 {
+  g_assert (data->connection_attempts == NULL);
+
+  clear_connection_attempt_delay (data);
+
   g_clear_object (&data->connectable);
   g_clear_object (&data->enumerator);
   g_clear_object (&data->proxy_addr);
   g_clear_object (&data->current_addr);
   g_clear_object (&data->current_socket);
   g_clear_object (&data->connection);
+  g_clear_object (&data->next_addr);
 
+  g_free (data->pool_key);
   g_clear_error (&data->last_error);
 
   g_slice_free (GSocketClientAsyncConnectData, data);
 }
 
+/* Each attempt holds a reference on the task, and so on @data */
+static void
+connection_attempt_free (ConnectionAttempt *attempt)
+{
+  GTask *task = attempt->data->task;
+
+  if (attempt->cancelled_id)
+    g_cancellable_disconnect (g_task_get_cancellable (task),
+                              attempt->cancelled_id);
+
+  g_clear_object (&attempt->address);
+  g_clear_object (&attempt->proxy_addr);
+  g_clear_object (&attempt->socket);
+  g_clear_object (&attempt->connection);
+  g_clear_object (&attempt->cancellable);
+
+  g_slice_free (ConnectionAttempt, attempt);
+  g_object_unref (task);
+}
+
+static void
+connection_attempt_parent_cancelled (GCancellable *cancellable,
+                                     gpointer      user_data)
+{
+  g_cancellable_cancel (user_data);
+}
+
+/* The attempts are freed by their own callbacks, which will find
+ * that they are no longer on the list.
+ */
+static void
+cancel_connection_attempts (GSocketClientAsyncConnectData *data)
+{
+  GSList *l;
+
+  for (l = data->connection_attempts; l; l = l->next)
+    {
+      ConnectionAttempt *attempt = l->data;
+
+      g_cancellable_cancel (attempt->cancellable);
+    }
+
+  g_slist_free (data->connection_attempts);
+  data->connection_attempts = NULL;
+}
+
 static void
 g_socket_client_async_connect_complete (GSocketClientAsyncConnectData *data)
 {
@@ -1405,18 +1646,52 @@ g_socket_client_async_connect_complete (GSocketClientAsyncConnectData *data)
       data->connection = (GIOStream *)wrapper_connection;
     }
 
+  if (data->pool_key)
+    g_socket_connection_pool_track (data->client->priv->connection_pool,
+                                    G_SOCKET_CONNECTION (data->connection),
+                                    data->pool_key);
+
+  data->completed = TRUE;
   g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_COMPLETE, data->connectable, data->connection);
   g_task_return_pointer (data->task, data->connection, g_object_unref);
   data->connection = NULL;
   g_object_unref (data->task);
 }
 
+static void
+g_socket_client_async_connect_fail (GSocketClientAsyncConnectData *data,
+                                    GError                        *error)
+{
+  data->completed = TRUE;
+  clear_connection_attempt_delay (data);
+  cancel_connection_attempts (data);
+
+  g_task_return_error (data->task, error);
+  g_object_unref (data->task);
+}
+
+static gboolean
+g_socket_client_async_connect_return_if_cancelled (GSocketClientAsyncConnectData *data)
+{
+  GError *error = NULL;
+
+  if (!g_cancellable_set_error_if_cancelled (g_task_get_cancellable (data->task),
+                                             &error))
+    return FALSE;
+
+  g_socket_client_async_connect_fail (data, error);
+  return TRUE;
+}
 
 static void
 g_socket_client_enumerator_callback (GObject      *object,
 				     GAsyncResult *result,
 				     gpointer      user_data);
 
+static void
+start_connection_attempt (GSocketClientAsyncConnectData *data,
+                          GSocketAddress                *address);
+
 static void
 set_last_error (GSocketClientAsyncConnectData *data,
 		GError *error)
@@ -1434,6 +1709,45 @@ enumerator_next_async (GSocketClientAsyncConnectData *data)
   g_clear_object (&data->proxy_addr);
   g_clear_object (&data->connection);
 
+  /* An address that turned up while the previous winner was still
+   * negotiating its proxy or TLS handshake.
+   */
+  if (data->next_addr)
+    {
+      GSocketAddress *address = data->next_addr;
+
+      data->next_addr = NULL;
+      start_connection_attempt (data, address);
+      return;
+    }
+
+  if (data->enumerating)
+    return;
+
+  if (data->enumeration_completed)
+    {
+      if (data->connection_attempts == NULL)
+        {
+          GError *error;
+
+          g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_COMPLETE, data->connectable, NULL);
+          if (data->last_error)
+            {
+              error = data->last_error;
+              data->last_error = NULL;
+            }
+          else
+            {
+              error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+                                           _("Unknown error on connect"));
+            }
+          g_socket_client_async_connect_fail (data, error);
+        }
+      return;
+    }
+
+  data->enumerating = TRUE;
+  g_object_ref (data->task);
   g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_RESOLVING, data->connectable, NULL);
   g_socket_address_enumerator_next_async (data->enumerator,
 					  g_task_get_cancellable (data->task),
@@ -1525,23 +1839,59 @@ g_socket_client_connected_callback (GObject      *source,
 				    GAsyncResult *result,
 				    gpointer      user_data)
 {
-  GSocketClientAsyncConnectData *data = user_data;
+  ConnectionAttempt *attempt = user_data;
+  GSocketClientAsyncConnectData *data = attempt->data;
+  GSList *link;
   GError *error = NULL;
   GProxy *proxy;
   const gchar *protocol;
 
+  link = g_slist_find (data->connection_attempts, attempt);
+  if (link == NULL)
+    {
+      /* Another attempt won, or the whole operation is over */
+      g_socket_connection_connect_finish (G_SOCKET_CONNECTION (source),
+                                          result, NULL);
+      connection_attempt_free (attempt);
+      return;
+    }
+  data->connection_attempts = g_slist_delete_link (data->connection_attempts, link);
+
   if (!g_socket_connection_connect_finish (G_SOCKET_CONNECTION (source),
 					   result, &error))
     {
+      if (g_socket_client_async_connect_return_if_cancelled (data))
+        {
+          g_error_free (error);
+          connection_attempt_free (attempt);
+          return;
+        }
+
       clarify_connect_error (error, data->connectable,
-			     data->current_addr);
+			     attempt->address);
       set_last_error (data, error);
+      connection_attempt_free (attempt);
 
-      /* try next one */
+      /* try next one, without waiting for the delay */
+      clear_connection_attempt_delay (data);
       enumerator_next_async (data);
       return;
     }
 
+  /* We have a winner; the others can stop */
+  clear_connection_attempt_delay (data);
+  cancel_connection_attempts (data);
+
+  data->current_addr = attempt->address;
+  attempt->address = NULL;
+  data->proxy_addr = attempt->proxy_addr;
+  attempt->proxy_addr = NULL;
+  data->current_socket = attempt->socket;
+  attempt->socket = NULL;
+  data->connection = attempt->connection;
+  attempt->connection = NULL;
+  connection_attempt_free (attempt);
+
   g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_CONNECTED, data->connectable, data->connection);
 
   /* wrong, but backward compatible */
@@ -1600,68 +1950,121 @@ g_socket_client_connected_callback (GObject      *source,
     }
 }
 
-static void
-g_socket_client_enumerator_callback (GObject      *object,
-				     GAsyncResult *result,
-				     gpointer      user_data)
+static gboolean
+connection_attempt_delay_reached (gpointer user_data)
 {
   GSocketClientAsyncConnectData *data = user_data;
-  GSocketAddress *address = NULL;
-  GSocket *socket;
-  GError *error = NULL;
 
-  if (g_task_return_error_if_cancelled (data->task))
-    return;
+  g_source_unref (data->delay_source);
+  data->delay_source = NULL;
 
-  address = g_socket_address_enumerator_next_finish (data->enumerator,
-						     result, &error);
-  if (address == NULL)
-    {
-      g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_COMPLETE, data->connectable, NULL);
-      if (!error)
-	{
-	  if (data->last_error)
-	    {
-	      error = data->last_error;
-	      data->last_error = NULL;
-	    }
-	  else
-	    {
-	      g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_FAILED,
-				   _("Unknown error on connect"));
-	    }
-	}
-      g_task_return_error (data->task, error);
-      g_object_unref (data->task);
-      return;
-    }
+  /* The current attempt is taking a while; race the next address
+   * against it rather than waiting for it to time out.
+   */
+  enumerator_next_async (data);
 
-  g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_RESOLVED,
-			      data->connectable, NULL);
+  return FALSE;
+}
 
-  if (G_IS_PROXY_ADDRESS (address) &&
-      data->client->priv->enable_proxy)
-    data->proxy_addr = g_object_ref (G_PROXY_ADDRESS (address));
+/* Takes ownership of @address */
+static void
+start_connection_attempt (GSocketClientAsyncConnectData *data,
+                          GSocketAddress                *address)
+{
+  ConnectionAttempt *attempt;
+  GCancellable *cancellable;
+  GSocket *socket;
+  GError *error = NULL;
 
-  g_clear_error (&data->last_error);
+  g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_RESOLVED,
+			      data->connectable, NULL);
 
-  socket = create_socket (data->client, address, &data->last_error);
+  socket = create_socket (data->client, address, &error);
   if (socket == NULL)
     {
+      set_last_error (data, error);
       g_object_unref (address);
       enumerator_next_async (data);
       return;
     }
 
-  data->current_socket = socket;
-  data->current_addr = address;
-  data->connection = (GIOStream *) g_socket_connection_factory_create_connection (socket);
+  attempt = g_slice_new0 (ConnectionAttempt);
+  attempt->data = data;
+  g_object_ref (data->task);
+  attempt->address = address;
+  if (G_IS_PROXY_ADDRESS (address) &&
+      data->client->priv->enable_proxy)
+    attempt->proxy_addr = g_object_ref (G_PROXY_ADDRESS (address));
+  attempt->socket = socket;
+  attempt->connection = (GIOStream *) g_socket_connection_factory_create_connection (socket);
 
-  g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_CONNECTING, data->connectable, data->connection);
-  g_socket_connection_connect_async (G_SOCKET_CONNECTION (data->connection),
+  /* Each attempt gets its own cancellable so that the losers of the
+   * race can be stopped without cancelling the whole operation.
+   */
+  attempt->cancellable = g_cancellable_new ();
+  cancellable = g_task_get_cancellable (data->task);
+  if (cancellable)
+    attempt->cancelled_id = g_cancellable_connect (cancellable,
+                                                   G_CALLBACK (connection_attempt_parent_cancelled),
+                                                   g_object_ref (attempt->cancellable),
+                                                   g_object_unref);
+
+  data->connection_attempts = g_slist_append (data->connection_attempts, attempt);
+
+  clear_connection_attempt_delay (data);
+  data->delay_source = g_timeout_source_new (CONNECTION_ATTEMPT_DELAY_MS);
+  g_source_set_callback (data->delay_source, connection_attempt_delay_reached, data, NULL);
+  g_source_attach (data->delay_source, g_task_get_context (data->task));
+
+  g_socket_client_emit_event (data->client, G_SOCKET_CLIENT_CONNECTING, data->connectable, attempt->connection);
+  g_socket_connection_connect_async (G_SOCKET_CONNECTION (attempt->connection),
 				     address,
-				     g_task_get_cancellable (data->task),
-				     g_socket_client_connected_callback, data);
+				     attempt->cancellable,
+				     g_socket_client_connected_callback, attempt);
+}
+
+static void
+g_socket_client_enumerator_callback (GObject      *object,
+				     GAsyncResult *result,
+				     gpointer      user_data)
+{
+  GSocketClientAsyncConnectData *data = user_data;
+  GTask *task = data->task;
+  GSocketAddress *address = NULL;
+  GError *error = NULL;
+
+  data->enumerating = FALSE;
+  address = g_socket_address_enumerator_next_finish (data->enumerator,
+						     result, &error);
+
+  if (data->completed || g_socket_client_async_connect_return_if_cancelled (data))
+    {
+      g_clear_object (&address);
+      g_clear_error (&error);
+    }
+  else if (address == NULL)
+    {
+      data->enumeration_completed = TRUE;
+      if (error)
+        set_last_error (data, error);
+
+      /* Unless some attempt is still in progress, this fails the
+       * operation with the last error.
+       */
+      if (data->connection == NULL)
+        enumerator_next_async (data);
+    }
+  else if (data->connection != NULL)
+    {
+      /* Wait for the current connection to finish negotiating; it
+       * will come back for this address if it fails.
+       */
+      data->next_addr = address;
+    }
+  else
+    start_connection_attempt (data, address);
+
+  g_object_unref (task);
 }
 
 /**
@@ -1674,6 +2077,11 @@ g_socket_client_enumerator_callback (GObject      *object,
  *
  * This is the asynchronous version of g_socket_client_connect().
  *
+ * Unlike g_socket_client_connect(), if an address takes more than a
+ * short while to connect, the next one is tried alongside it, and the
+ * first to succeed is used (as described in RFC 8305). Attempts that
+ * lose the race are cancelled.
+ *
  * When the operation is finished @callback will be
  * called. You can then call g_socket_client_connect_finish() to get
  * the result of the operation.
@@ -1688,10 +2096,30 @@ g_socket_client_connect_async (GSocketClient       *client,
 			       gpointer             user_data)
 {
   GSocketClientAsyncConnectData *data;
+  GSocketConnection *pooled;
+  gchar *pool_key;
+  GTask *task;
 
   g_return_if_fail (G_IS_SOCKET_CLIENT (client));
 
+  pool_key = connection_pool_key (client, connectable);
+  if (pool_key)
+    {
+      pooled = g_socket_connection_pool_take (client->priv->connection_pool,
+                                              pool_key);
+      if (pooled)
+        {
+          g_free (pool_key);
+          g_socket_client_emit_event (client, G_SOCKET_CLIENT_COMPLETE, connectable, G_IO_STREAM (pooled));
+          task = g_task_new (client, cancellable, callback, user_data);
+          g_task_return_pointer (task, pooled, g_object_unref);
+          g_object_unref (task);
+          return;
+        }
+    }
+
   data = g_slice_new0 (GSocketClientAsyncConnectData);
+  data->pool_key = pool_key;
   data->client = client;
   data->connectable = g_object_ref (connectable);
 
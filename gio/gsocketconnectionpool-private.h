@@ -0,0 +1,31 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_SOCKET_CONNECTION_POOL_PRIVATE_H__
+#define __G_SOCKET_CONNECTION_POOL_PRIVATE_H__
+
+#include "gsocketconnectionpool.h"
+
+GSocketConnection *     g_socket_connection_pool_take                   (GSocketConnectionPool *pool,
+                                                                         const gchar           *key);
+
+void                    g_socket_connection_pool_track                  (GSocketConnectionPool *pool,
+                                                                         GSocketConnection     *connection,
+                                                                         const gchar           *key);
+
+#endif
@@ -0,0 +1,608 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include "gsocketconnectionpool.h"
+#include "gsocketconnectionpool-private.h"
+#include "gsocketconnection.h"
+#include "gsocket.h"
+#include "glibintl.h"
+
+/**
+ * SECTION:gsocketconnectionpool
+ * @short_description: Keep idle connections for reuse
+ * @include: gio/gio.h
+ * @see_also: #GSocketClient
+ *
+ * #GSocketConnectionPool keeps connections that their users are done
+ * with open, so that a later connection to the same destination can
+ * skip the name lookup and the TCP and TLS handshakes.
+ *
+ * Set a pool on a #GSocketClient with
+ * g_socket_client_set_connection_pool(). Connections made by the
+ * client are then remembered by destination (the #GSocketConnectable,
+ * plus the client's proxy and TLS settings), and when you are done
+ * with one, in a state where the protocol allows another request to
+ * be sent on it, hand it back with g_socket_connection_pool_release().
+ * The next connect to the same destination returns it instead of
+ * opening a new connection.
+ *
+ * Idle connections are checked before they are handed out: one that
+ * has been closed by the peer, or that has unexpected data waiting to
+ * be read, is closed and skipped. The pool keeps at most
+ * #GSocketConnectionPool:max-idle-per-host idle connections per
+ * destination, and closes those that have been idle for longer than
+ * #GSocketConnectionPool:idle-timeout the next time it is used.
+ *
+ * A pool can be shared between several clients and threads.
+ *
+ * Since: 2.40
+ */
+
+#define DEFAULT_MAX_IDLE_PER_HOST 4
+#define DEFAULT_IDLE_TIMEOUT      60
+
+enum
+{
+  PROP_0,
+  PROP_MAX_IDLE_PER_HOST,
+  PROP_IDLE_TIMEOUT
+};
+
+typedef struct
+{
+  GSocketConnection *connection;
+  gint64 idle_since;
+} IdleConnection;
+
+struct _GSocketConnectionPoolPrivate
+{
+  GMutex lock;
+
+  /* key → GQueue of IdleConnection, most recently released first */
+  GHashTable *idle;
+  guint n_idle;
+
+  guint max_idle_per_host;
+  guint idle_timeout;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GSocketConnectionPool, g_socket_connection_pool, G_TYPE_OBJECT)
+
+static GQuark
+pool_key_quark (void)
+{
+  static GQuark quark;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("g-socket-connection-pool-key");
+
+  return quark;
+}
+
+static void
+close_connections (GSList *connections)
+{
+  GSList *l;
+
+  for (l = connections; l; l = l->next)
+    {
+      g_io_stream_close (l->data, NULL, NULL);
+      g_object_unref (l->data);
+    }
+
+  g_slist_free (connections);
+}
+
+static void
+idle_queue_free (gpointer data)
+{
+  GQueue *queue = data;
+  IdleConnection *idle;
+
+  while ((idle = g_queue_pop_head (queue)))
+    {
+      g_object_unref (idle->connection);
+      g_slice_free (IdleConnection, idle);
+    }
+
+  g_queue_free (queue);
+}
+
+/* Pops the oldest connection of @queue onto @closing */
+static void
+idle_queue_drop_tail (GSocketConnectionPool  *pool,
+                      GQueue                 *queue,
+                      GSList                **closing)
+{
+  IdleConnection *idle;
+
+  idle = g_queue_pop_tail (queue);
+  *closing = g_slist_prepend (*closing, idle->connection);
+  g_slice_free (IdleConnection, idle);
+  pool->priv->n_idle--;
+}
+
+/* Must be called with the lock held; the expired connections are
+ * added to @closing, to be closed once it is released.
+ */
+static void
+g_socket_connection_pool_expire (GSocketConnectionPool  *pool,
+                                 GSList                **closing)
+{
+  GHashTableIter iter;
+  GQueue *queue;
+  gint64 cutoff;
+
+  if (pool->priv->idle_timeout == 0)
+    return;
+
+  cutoff = g_get_monotonic_time () - pool->priv->idle_timeout * G_TIME_SPAN_SECOND;
+
+  g_hash_table_iter_init (&iter, pool->priv->idle);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &queue))
+    {
+      IdleConnection *idle;
+
+      while ((idle = g_queue_peek_tail (queue)) && idle->idle_since < cutoff)
+        idle_queue_drop_tail (pool, queue, closing);
+
+      if (g_queue_is_empty (queue))
+        g_hash_table_iter_remove (&iter);
+    }
+}
+
+/* An idle connection has nothing to read; if it does, the peer has
+ * closed it or sent something that no request is waiting for.
+ */
+static gboolean
+connection_is_reusable (GSocketConnection *connection)
+{
+  GSocket *socket;
+
+  if (g_io_stream_is_closed (G_IO_STREAM (connection)) ||
+      g_io_stream_has_pending (G_IO_STREAM (connection)))
+    return FALSE;
+
+  socket = g_socket_connection_get_socket (connection);
+  if (g_socket_is_closed (socket) || !g_socket_is_connected (socket))
+    return FALSE;
+
+  return g_socket_condition_check (socket, G_IO_IN | G_IO_ERR | G_IO_HUP) == 0;
+}
+
+static void
+g_socket_connection_pool_init (GSocketConnectionPool *pool)
+{
+  pool->priv = g_socket_connection_pool_get_instance_private (pool);
+
+  g_mutex_init (&pool->priv->lock);
+  pool->priv->idle = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, idle_queue_free);
+  pool->priv->max_idle_per_host = DEFAULT_MAX_IDLE_PER_HOST;
+  pool->priv->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+}
+
+static void
+g_socket_connection_pool_finalize (GObject *object)
+{
+  GSocketConnectionPool *pool = G_SOCKET_CONNECTION_POOL (object);
+
+  g_socket_connection_pool_clear (pool);
+  g_hash_table_unref (pool->priv->idle);
+  g_mutex_clear (&pool->priv->lock);
+
+  G_OBJECT_CLASS (g_socket_connection_pool_parent_class)->finalize (object);
+}
+
+static void
+g_socket_connection_pool_get_property (GObject    *object,
+                                       guint       prop_id,
+                                       GValue     *value,
+                                       GParamSpec *pspec)
+{
+  GSocketConnectionPool *pool = G_SOCKET_CONNECTION_POOL (object);
+
+  switch (prop_id)
+    {
+    case PROP_MAX_IDLE_PER_HOST:
+      g_value_set_uint (value, g_socket_connection_pool_get_max_idle_per_host (pool));
+      break;
+
+    case PROP_IDLE_TIMEOUT:
+      g_value_set_uint (value, g_socket_connection_pool_get_idle_timeout (pool));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+g_socket_connection_pool_set_property (GObject      *object,
+                                       guint         prop_id,
+                                       const GValue *value,
+                                       GParamSpec   *pspec)
+{
+  GSocketConnectionPool *pool = G_SOCKET_CONNECTION_POOL (object);
+
+  switch (prop_id)
+    {
+    case PROP_MAX_IDLE_PER_HOST:
+      g_socket_connection_pool_set_max_idle_per_host (pool, g_value_get_uint (value));
+      break;
+
+    case PROP_IDLE_TIMEOUT:
+      g_socket_connection_pool_set_idle_timeout (pool, g_value_get_uint (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+g_socket_connection_pool_class_init (GSocketConnectionPoolClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+  gobject_class->finalize = g_socket_connection_pool_finalize;
+  gobject_class->get_property = g_socket_connection_pool_get_property;
+  gobject_class->set_property = g_socket_connection_pool_set_property;
+
+  /**
+   * GSocketConnectionPool:max-idle-per-host:
+   *
+   * The number of idle connections kept for each destination. When
+   * another one is released, the one that has been idle longest is
+   * closed. 0 disables keeping connections.
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_IDLE_PER_HOST,
+                                   g_param_spec_uint ("max-idle-per-host",
+                                                      P_("Maximum idle connections per host"),
+                                                      P_("The number of idle connections kept for each destination"),
+                                                      0, G_MAXUINT, DEFAULT_MAX_IDLE_PER_HOST,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GSocketConnectionPool:idle-timeout:
+   *
+   * The time in seconds after which an idle connection is closed
+   * rather than reused, or 0 to keep idle connections indefinitely.
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+                                   g_param_spec_uint ("idle-timeout",
+                                                      P_("Idle timeout"),
+                                                      P_("The time in seconds after which an idle connection is closed"),
+                                                      0, G_MAXUINT, DEFAULT_IDLE_TIMEOUT,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS));
+}
+
+/**
+ * g_socket_connection_pool_new:
+ *
+ * Creates a new, empty #GSocketConnectionPool.
+ *
+ * Returns: (transfer full): a new #GSocketConnectionPool
+ *
+ * Since: 2.40
+ */
+GSocketConnectionPool *
+g_socket_connection_pool_new (void)
+{
+  return g_object_new (G_TYPE_SOCKET_CONNECTION_POOL, NULL);
+}
+
+/**
+ * g_socket_connection_pool_get_max_idle_per_host:
+ * @pool: a #GSocketConnectionPool
+ *
+ * Gets the #GSocketConnectionPool:max-idle-per-host property.
+ *
+ * Returns: the number of idle connections kept per destination
+ *
+ * Since: 2.40
+ */
+guint
+g_socket_connection_pool_get_max_idle_per_host (GSocketConnectionPool *pool)
+{
+  g_return_val_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool), 0);
+
+  return pool->priv->max_idle_per_host;
+}
+
+/**
+ * g_socket_connection_pool_set_max_idle_per_host:
+ * @pool: a #GSocketConnectionPool
+ * @max_idle: the number of idle connections to keep per destination
+ *
+ * Sets the #GSocketConnectionPool:max-idle-per-host property.
+ * Connections above the new limit are closed.
+ *
+ * Since: 2.40
+ */
+void
+g_socket_connection_pool_set_max_idle_per_host (GSocketConnectionPool *pool,
+                                                guint                  max_idle)
+{
+  GHashTableIter iter;
+  GQueue *queue;
+  GSList *closing = NULL;
+
+  g_return_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool));
+
+  g_mutex_lock (&pool->priv->lock);
+  if (pool->priv->max_idle_per_host == max_idle)
+    {
+      g_mutex_unlock (&pool->priv->lock);
+      return;
+    }
+
+  pool->priv->max_idle_per_host = max_idle;
+
+  g_hash_table_iter_init (&iter, pool->priv->idle);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &queue))
+    {
+      while (g_queue_get_length (queue) > max_idle)
+        idle_queue_drop_tail (pool, queue, &closing);
+
+      if (g_queue_is_empty (queue))
+        g_hash_table_iter_remove (&iter);
+    }
+  g_mutex_unlock (&pool->priv->lock);
+
+  close_connections (closing);
+  g_object_notify (G_OBJECT (pool), "max-idle-per-host");
+}
+
+/**
+ * g_socket_connection_pool_get_idle_timeout:
+ * @pool: a #GSocketConnectionPool
+ *
+ * Gets the #GSocketConnectionPool:idle-timeout property.
+ *
+ * Returns: the idle timeout in seconds, or 0 for none
+ *
+ * Since: 2.40
+ */
+guint
+g_socket_connection_pool_get_idle_timeout (GSocketConnectionPool *pool)
+{
+  g_return_val_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool), 0);
+
+  return pool->priv->idle_timeout;
+}
+
+/**
+ * g_socket_connection_pool_set_idle_timeout:
+ * @pool: a #GSocketConnectionPool
+ * @timeout: the idle timeout in seconds, or 0 for none
+ *
+ * Sets the #GSocketConnectionPool:idle-timeout property.
+ *
+ * Since: 2.40
+ */
+void
+g_socket_connection_pool_set_idle_timeout (GSocketConnectionPool *pool,
+                                           guint                  timeout)
+{
+  g_return_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool));
+
+  g_mutex_lock (&pool->priv->lock);
+  if (pool->priv->idle_timeout == timeout)
+    {
+      g_mutex_unlock (&pool->priv->lock);
+      return;
+    }
+  pool->priv->idle_timeout = timeout;
+  g_mutex_unlock (&pool->priv->lock);
+
+  g_object_notify (G_OBJECT (pool), "idle-timeout");
+}
+
+/**
+ * g_socket_connection_pool_release:
+ * @pool: a #GSocketConnectionPool
+ * @connection: a #GSocketConnection returned by a #GSocketClient
+ *   using @pool
+ *
+ * Hands @connection back to @pool once you are done with it, so that
+ * the next connect to the same destination can reuse it. @pool takes
+ * its own reference; drop yours as usual.
+ *
+ * Only release a connection when the protocol spoken on it allows
+ * another exchange to start, for example after a complete HTTP
+ * response with keep-alive. If @connection was not made through
+ * @pool, is closed, or has data waiting to be read, it is closed
+ * instead of being kept.
+ *
+ * Since: 2.40
+ */
+void
+g_socket_connection_pool_release (GSocketConnectionPool *pool,
+                                  GSocketConnection     *connection)
+{
+  const gchar *key;
+  GSList *closing = NULL;
+  IdleConnection *idle;
+  GQueue *queue;
+
+  g_return_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool));
+  g_return_if_fail (G_IS_SOCKET_CONNECTION (connection));
+
+  key = g_object_get_qdata (G_OBJECT (connection), pool_key_quark ());
+  if (key == NULL || !connection_is_reusable (connection))
+    {
+      g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+      return;
+    }
+
+  g_mutex_lock (&pool->priv->lock);
+  g_socket_connection_pool_expire (pool, &closing);
+
+  if (pool->priv->max_idle_per_host == 0)
+    {
+      closing = g_slist_prepend (closing, g_object_ref (connection));
+      g_mutex_unlock (&pool->priv->lock);
+      close_connections (closing);
+      return;
+    }
+
+  queue = g_hash_table_lookup (pool->priv->idle, key);
+  if (queue == NULL)
+    {
+      queue = g_queue_new ();
+      g_hash_table_insert (pool->priv->idle, g_strdup (key), queue);
+    }
+
+  while (g_queue_get_length (queue) >= pool->priv->max_idle_per_host)
+    idle_queue_drop_tail (pool, queue, &closing);
+
+  idle = g_slice_new (IdleConnection);
+  idle->connection = g_object_ref (connection);
+  idle->idle_since = g_get_monotonic_time ();
+  g_queue_push_head (queue, idle);
+  pool->priv->n_idle++;
+  g_mutex_unlock (&pool->priv->lock);
+
+  close_connections (closing);
+}
+
+/**
+ * g_socket_connection_pool_get_n_idle:
+ * @pool: a #GSocketConnectionPool
+ *
+ * Gets the number of idle connections currently kept by @pool, over
+ * all destinations.
+ *
+ * Returns: the number of idle connections
+ *
+ * Since: 2.40
+ */
+guint
+g_socket_connection_pool_get_n_idle (GSocketConnectionPool *pool)
+{
+  guint n_idle;
+
+  g_return_val_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool), 0);
+
+  g_mutex_lock (&pool->priv->lock);
+  n_idle = pool->priv->n_idle;
+  g_mutex_unlock (&pool->priv->lock);
+
+  return n_idle;
+}
+
+/**
+ * g_socket_connection_pool_clear:
+ * @pool: a #GSocketConnectionPool
+ *
+ * Closes all of the idle connections kept by @pool, for example when
+ * the network configuration has changed.
+ *
+ * Since: 2.40
+ */
+void
+g_socket_connection_pool_clear (GSocketConnectionPool *pool)
+{
+  GHashTableIter iter;
+  GQueue *queue;
+  GSList *closing = NULL;
+
+  g_return_if_fail (G_IS_SOCKET_CONNECTION_POOL (pool));
+
+  g_mutex_lock (&pool->priv->lock);
+  g_hash_table_iter_init (&iter, pool->priv->idle);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &queue))
+    {
+      while (!g_queue_is_empty (queue))
+        idle_queue_drop_tail (pool, queue, &closing);
+      g_hash_table_iter_remove (&iter);
+    }
+  g_mutex_unlock (&pool->priv->lock);
+
+  close_connections (closing);
+}
+
+/*< internal >
+ * g_socket_connection_pool_take:
+ * @pool: a #GSocketConnectionPool
+ * @key: the destination key
+ *
+ * Returns the most recently released idle connection for @key that
+ * is still usable, closing any unusable ones on the way.
+ *
+ * Returns: (transfer full) (nullable): a connection, or %NULL
+ */
+GSocketConnection *
+g_socket_connection_pool_take (GSocketConnectionPool *pool,
+                               const gchar           *key)
+{
+  GSocketConnection *connection = NULL;
+  GSList *closing = NULL;
+  GQueue *queue;
+
+  g_mutex_lock (&pool->priv->lock);
+  g_socket_connection_pool_expire (pool, &closing);
+
+  queue = g_hash_table_lookup (pool->priv->idle, key);
+  while (queue && connection == NULL && !g_queue_is_empty (queue))
+    {
+      IdleConnection *idle = g_queue_pop_head (queue);
+
+      pool->priv->n_idle--;
+      if (connection_is_reusable (idle->connection))
+        connection = idle->connection;
+      else
+        closing = g_slist_prepend (closing, idle->connection);
+      g_slice_free (IdleConnection, idle);
+    }
+
+  if (queue && g_queue_is_empty (queue))
+    g_hash_table_remove (pool->priv->idle, key);
+  g_mutex_unlock (&pool->priv->lock);
+
+  close_connections (closing);
+
+  return connection;
+}
+
+/*< internal >
+ * g_socket_connection_pool_track:
+ * @pool: a #GSocketConnectionPool
+ * @connection: a new connection
+ * @key: the destination @connection was made to
+ *
+ * Remembers the destination of @connection, so that it can be filed
+ * under @key when it is released.
+ */
+void
+g_socket_connection_pool_track (GSocketConnectionPool *pool,
+                                GSocketConnection     *connection,
+                                const gchar           *key)
+{
+  g_object_set_qdata_full (G_OBJECT (connection), pool_key_quark (),
+                           g_strdup (key), g_free);
+}
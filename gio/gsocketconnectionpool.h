@@ -0,0 +1,86 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_SOCKET_CONNECTION_POOL_H__
+#define __G_SOCKET_CONNECTION_POOL_H__
+
+#if !defined (__GIO_GIO_H_INSIDE__) && !defined (GIO_COMPILATION)
+#error "Only <gio/gio.h> can be included directly."
+#endif
+
+#include <gio/giotypes.h>
+
+G_BEGIN_DECLS
+
+#define G_TYPE_SOCKET_CONNECTION_POOL         (g_socket_connection_pool_get_type ())
+#define G_SOCKET_CONNECTION_POOL(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_TYPE_SOCKET_CONNECTION_POOL, GSocketConnectionPool))
+#define G_SOCKET_CONNECTION_POOL_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_TYPE_SOCKET_CONNECTION_POOL, GSocketConnectionPoolClass))
+#define G_IS_SOCKET_CONNECTION_POOL(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_TYPE_SOCKET_CONNECTION_POOL))
+#define G_IS_SOCKET_CONNECTION_POOL_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_TYPE_SOCKET_CONNECTION_POOL))
+#define G_SOCKET_CONNECTION_POOL_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_TYPE_SOCKET_CONNECTION_POOL, GSocketConnectionPoolClass))
+
+typedef struct _GSocketConnectionPoolClass    GSocketConnectionPoolClass;
+typedef struct _GSocketConnectionPoolPrivate  GSocketConnectionPoolPrivate;
+
+struct _GSocketConnectionPool
+{
+  GObject parent_instance;
+
+  /*< private >*/
+  GSocketConnectionPoolPrivate *priv;
+};
+
+struct _GSocketConnectionPoolClass
+{
+  GObjectClass parent_class;
+
+  /*< private >*/
+  /* Padding for future expansion */
+  void (*_g_reserved1) (void);
+  void (*_g_reserved2) (void);
+  void (*_g_reserved3) (void);
+  void (*_g_reserved4) (void);
+};
+
+GLIB_AVAILABLE_IN_2_40
+GType                   g_socket_connection_pool_get_type              (void) G_GNUC_CONST;
+GLIB_AVAILABLE_IN_2_40
+GSocketConnectionPool * g_socket_connection_pool_new                   (void);
+
+GLIB_AVAILABLE_IN_2_40
+guint                   g_socket_connection_pool_get_max_idle_per_host (GSocketConnectionPool *pool);
+GLIB_AVAILABLE_IN_2_40
+void                    g_socket_connection_pool_set_max_idle_per_host (GSocketConnectionPool *pool,
+                                                                        guint                  max_idle);
+GLIB_AVAILABLE_IN_2_40
+guint                   g_socket_connection_pool_get_idle_timeout      (GSocketConnectionPool *pool);
+GLIB_AVAILABLE_IN_2_40
+void                    g_socket_connection_pool_set_idle_timeout      (GSocketConnectionPool *pool,
+                                                                        guint                  timeout);
+
+GLIB_AVAILABLE_IN_2_40
+void                    g_socket_connection_pool_release               (GSocketConnectionPool *pool,
+                                                                        GSocketConnection     *connection);
+GLIB_AVAILABLE_IN_2_40
+guint                   g_socket_connection_pool_get_n_idle            (GSocketConnectionPool *pool);
+GLIB_AVAILABLE_IN_2_40
+void                    g_socket_connection_pool_clear                 (GSocketConnectionPool *pool);
+
+G_END_DECLS
+
+#endif /* __G_SOCKET_CONNECTION_POOL_H__ */
@@ -30,15 +30,23 @@
 #include "gcancellable.h"
 #include "gpollableinputstream.h"
 #include "gioerror.h"
+#include "gioprivate.h"
+#include "gtask.h"
 #include "gfiledescriptorbased.h"
 
 struct _GSocketInputStreamPrivate
 {
   GSocket *socket;
 
-  /* pending operation metadata */
+  /* reused by all the reads that have to wait */
+  GSource *watch;
+
+  /* pending operation metadata, either a buffer or vectors */
+  GTask *task;
   gpointer buffer;
   gsize count;
+  const GInputVector *vectors;
+  gsize n_vectors;
 };
 
 static void g_socket_input_stream_pollable_iface_init (GPollableInputStreamInterface *iface);
@@ -110,6 +118,12 @@ g_socket_input_stream_finalize (GObject *object)
 {
   GSocketInputStream *stream = G_SOCKET_INPUT_STREAM (object);
 
+  if (stream->priv->watch)
+    {
+      g_source_destroy (stream->priv->watch);
+      g_source_unref (stream->priv->watch);
+    }
+
   if (stream->priv->socket)
     g_object_unref (stream->priv->socket);
 
@@ -130,6 +144,208 @@ g_socket_input_stream_read (GInputStream  *stream,
 					 cancellable, error);
 }
 
+/* one recvmsg() for all of them, or as many as it can take */
+static gboolean
+g_socket_input_stream_readv_with_blocking (GSocketInputStream  *input_stream,
+                                           const GInputVector  *vectors,
+                                           gsize                n_vectors,
+                                           gsize               *bytes_read,
+                                           gboolean             blocking,
+                                           GCancellable        *cancellable,
+                                           GError             **error)
+{
+  gssize res;
+
+  res = g_socket_receive_message_with_blocking (input_stream->priv->socket, NULL,
+                                                (GInputVector *) vectors,
+                                                MIN (n_vectors, G_IOV_MAX),
+                                                NULL, NULL, NULL, blocking,
+                                                cancellable, error);
+  if (res == -1)
+    {
+      *bytes_read = 0;
+      return FALSE;
+    }
+
+  *bytes_read = res;
+  return TRUE;
+}
+
+static gboolean
+g_socket_input_stream_readv (GInputStream        *stream,
+                             const GInputVector  *vectors,
+                             gsize                n_vectors,
+                             gsize               *bytes_read,
+                             GCancellable        *cancellable,
+                             GError             **error)
+{
+  return g_socket_input_stream_readv_with_blocking (G_SOCKET_INPUT_STREAM (stream),
+                                                    vectors, n_vectors,
+                                                    bytes_read, TRUE,
+                                                    cancellable, error);
+}
+
+static gboolean g_socket_input_stream_watch_ready (GSocket      *socket,
+                                                   GIOCondition  condition,
+                                                   gpointer      user_data);
+
+static void
+g_socket_input_stream_read_async_try (GSocketInputStream *input_stream,
+                                      GTask              *task)
+{
+  GSocketInputStreamPrivate *priv = input_stream->priv;
+  GMainContext *context;
+  GError *error = NULL;
+  gssize res;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  if (priv->vectors)
+    {
+      gsize bytes_read;
+
+      if (g_socket_input_stream_readv_with_blocking (input_stream,
+                                                     priv->vectors, priv->n_vectors,
+                                                     &bytes_read, FALSE,
+                                                     NULL, &error))
+        res = bytes_read;
+      else
+        res = -1;
+    }
+  else
+    res = g_socket_receive_with_blocking (priv->socket, priv->buffer, priv->count,
+                                          FALSE, NULL, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+    {
+      g_error_free (error);
+
+      context = g_task_get_context (task);
+      if (priv->watch && g_source_get_context (priv->watch) != context)
+        {
+          g_source_destroy (priv->watch);
+          g_clear_pointer (&priv->watch, g_source_unref);
+        }
+
+      if (priv->watch == NULL)
+        {
+          priv->watch = g_socket_create_watch (priv->socket);
+          g_source_set_callback (priv->watch,
+                                 (GSourceFunc) g_socket_input_stream_watch_ready,
+                                 input_stream, NULL);
+          g_source_attach (priv->watch, context);
+        }
+
+      priv->task = task;
+      g_source_set_priority (priv->watch, g_task_get_priority (task));
+      g_socket_watch_arm (priv->watch, G_IO_IN, g_task_get_cancellable (task));
+      return;
+    }
+
+  if (res == -1)
+    g_task_return_error (task, error);
+  else
+    g_task_return_int (task, res);
+  g_object_unref (task);
+}
+
+static gboolean
+g_socket_input_stream_watch_ready (GSocket      *socket,
+                                   GIOCondition  condition,
+                                   gpointer      user_data)
+{
+  GSocketInputStream *input_stream = user_data;
+  GTask *task;
+
+  task = input_stream->priv->task;
+  input_stream->priv->task = NULL;
+  g_socket_watch_disarm (input_stream->priv->watch);
+
+  g_socket_input_stream_read_async_try (input_stream, task);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+g_socket_input_stream_read_async (GInputStream        *stream,
+                                  void                *buffer,
+                                  gsize                count,
+                                  int                  io_priority,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  GSocketInputStream *input_stream = G_SOCKET_INPUT_STREAM (stream);
+  GTask *task;
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_socket_input_stream_read_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_check_cancellable (task, FALSE);
+
+  input_stream->priv->buffer = buffer;
+  input_stream->priv->count = count;
+  input_stream->priv->vectors = NULL;
+  input_stream->priv->n_vectors = 0;
+
+  g_socket_input_stream_read_async_try (input_stream, task);
+}
+
+static gssize
+g_socket_input_stream_read_finish (GInputStream  *stream,
+                                   GAsyncResult  *result,
+                                   GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, stream), -1);
+
+  return g_task_propagate_int (G_TASK (result), error);
+}
+
+static void
+g_socket_input_stream_readv_async (GInputStream        *stream,
+                                   const GInputVector  *vectors,
+                                   gsize                n_vectors,
+                                   int                  io_priority,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  GSocketInputStream *input_stream = G_SOCKET_INPUT_STREAM (stream);
+  GTask *task;
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_socket_input_stream_readv_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_check_cancellable (task, FALSE);
+
+  input_stream->priv->buffer = NULL;
+  input_stream->priv->count = 0;
+  input_stream->priv->vectors = vectors;
+  input_stream->priv->n_vectors = n_vectors;
+
+  g_socket_input_stream_read_async_try (input_stream, task);
+}
+
+static gboolean
+g_socket_input_stream_readv_finish (GInputStream  *stream,
+                                    GAsyncResult  *result,
+                                    gsize         *bytes_read,
+                                    GError       **error)
+{
+  gssize res;
+
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+
+  res = g_task_propagate_int (G_TASK (result), error);
+  *bytes_read = MAX (res, 0);
+
+  return res != -1;
+}
+
 static gboolean
 g_socket_input_stream_pollable_is_readable (GPollableInputStream *pollable)
 {
@@ -168,6 +384,19 @@ g_socket_input_stream_pollable_read_nonblocking (GPollableInputStream  *pollable
 					 NULL, error);
 }
 
+static gboolean
+g_socket_input_stream_pollable_readv_nonblocking (GPollableInputStream  *pollable,
+						  const GInputVector    *vectors,
+						  gsize                  n_vectors,
+						  gsize                 *bytes_read,
+						  GError               **error)
+{
+  return g_socket_input_stream_readv_with_blocking (G_SOCKET_INPUT_STREAM (pollable),
+                                                    vectors, n_vectors,
+                                                    bytes_read, FALSE,
+                                                    NULL, error);
+}
+
 #ifdef G_OS_UNIX
 static int
 g_socket_input_stream_get_fd (GFileDescriptorBased *fd_based)
@@ -189,6 +418,11 @@ g_socket_input_stream_class_init (GSocketInputStreamClass *klass)
   gobject_class->set_property = g_socket_input_stream_set_property;
 
   ginputstream_class->read_fn = g_socket_input_stream_read;
+  ginputstream_class->read_async = g_socket_input_stream_read_async;
+  ginputstream_class->read_finish = g_socket_input_stream_read_finish;
+  ginputstream_class->readv_fn = g_socket_input_stream_readv;
+  ginputstream_class->readv_async = g_socket_input_stream_readv_async;
+  ginputstream_class->readv_finish = g_socket_input_stream_readv_finish;
 
   g_object_class_install_property (gobject_class, PROP_SOCKET,
 				   g_param_spec_object ("socket",
@@ -212,6 +446,7 @@ g_socket_input_stream_pollable_iface_init (GPollableInputStreamInterface *iface)
   iface->is_readable = g_socket_input_stream_pollable_is_readable;
   iface->create_source = g_socket_input_stream_pollable_create_source;
   iface->read_nonblocking = g_socket_input_stream_pollable_read_nonblocking;
+  iface->readv_nonblocking = g_socket_input_stream_pollable_readv_nonblocking;
 }
 
 static void
@@ -36,6 +36,7 @@
 #include <gio/gsocket.h>
 #include <gio/gsocketconnection.h>
 #include <gio/ginetsocketaddress.h>
+#include "gioprivate.h"
 #include "glibintl.h"
 
 
@@ -839,6 +840,54 @@ g_socket_listener_accept_finish (GSocketListener  *listener,
   return connection;
 }
 
+/* Accepts a connection that is already pending on one of the sockets
+ * of @listener without blocking, or fails with %G_IO_ERROR_WOULD_BLOCK
+ * if there is none. This lets #GSocketService drain a burst of
+ * connections after a single wakeup instead of one per main loop
+ * iteration.
+ */
+GSocketConnection *
+g_socket_listener_accept_pending (GSocketListener  *listener,
+				  GObject         **source_object,
+				  GError          **error)
+{
+  GSocketConnection *connection;
+  GSocket *accept_socket, *socket;
+  GError *my_error = NULL;
+  guint i;
+
+  g_return_val_if_fail (G_IS_SOCKET_LISTENER (listener), NULL);
+
+  for (i = 0; i < listener->priv->sockets->len; i++)
+    {
+      accept_socket = listener->priv->sockets->pdata[i];
+
+      socket = g_socket_accept_with_blocking (accept_socket, FALSE,
+					      NULL, &my_error);
+      if (socket != NULL)
+	{
+	  if (source_object)
+	    *source_object = g_object_get_qdata (G_OBJECT (accept_socket),
+						 source_quark);
+
+	  connection = g_socket_connection_factory_create_connection (socket);
+	  g_object_unref (socket);
+	  return connection;
+	}
+
+      if (!g_error_matches (my_error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+	{
+	  g_propagate_error (error, my_error);
+	  return NULL;
+	}
+      g_clear_error (&my_error);
+    }
+
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+		       _("No pending connections"));
+  return NULL;
+}
+
 /**
  * g_socket_listener_set_backlog:
  * @listener: a #GSocketListener
@@ -33,6 +33,8 @@
 #include "gpollableinputstream.h"
 #include "gpollableoutputstream.h"
 #include "gioerror.h"
+#include "gioprivate.h"
+#include "gtask.h"
 #include "glibintl.h"
 #include "gfiledescriptorbased.h"
 
@@ -40,9 +42,15 @@ struct _GSocketOutputStreamPrivate
 {
   GSocket *socket;
 
-  /* pending operation metadata */
+  /* reused by all the writes that have to wait */
+  GSource *watch;
+
+  /* pending operation metadata, either a buffer or vectors */
+  GTask *task;
   gconstpointer buffer;
   gsize count;
+  const GOutputVector *vectors;
+  gsize n_vectors;
 };
 
 static void g_socket_output_stream_pollable_iface_init (GPollableOutputStreamInterface *iface);
@@ -114,6 +122,12 @@ g_socket_output_stream_finalize (GObject *object)
 {
   GSocketOutputStream *stream = G_SOCKET_OUTPUT_STREAM (object);
 
+  if (stream->priv->watch)
+    {
+      g_source_destroy (stream->priv->watch);
+      g_source_unref (stream->priv->watch);
+    }
+
   if (stream->priv->socket)
     g_object_unref (stream->priv->socket);
 
@@ -134,6 +148,208 @@ g_socket_output_stream_write (GOutputStream  *stream,
 				      cancellable, error);
 }
 
+/* one sendmsg() for all of them, or as many as it can take */
+static gboolean
+g_socket_output_stream_writev_with_blocking (GSocketOutputStream  *output_stream,
+                                             const GOutputVector  *vectors,
+                                             gsize                 n_vectors,
+                                             gsize                *bytes_written,
+                                             gboolean              blocking,
+                                             GCancellable         *cancellable,
+                                             GError              **error)
+{
+  gssize res;
+
+  res = g_socket_send_message_with_blocking (output_stream->priv->socket, NULL,
+                                             (GOutputVector *) vectors,
+                                             MIN (n_vectors, G_IOV_MAX),
+                                             NULL, 0, 0, blocking,
+                                             cancellable, error);
+  if (res == -1)
+    {
+      *bytes_written = 0;
+      return FALSE;
+    }
+
+  *bytes_written = res;
+  return TRUE;
+}
+
+static gboolean
+g_socket_output_stream_writev (GOutputStream        *stream,
+                               const GOutputVector  *vectors,
+                               gsize                 n_vectors,
+                               gsize                *bytes_written,
+                               GCancellable         *cancellable,
+                               GError              **error)
+{
+  return g_socket_output_stream_writev_with_blocking (G_SOCKET_OUTPUT_STREAM (stream),
+                                                      vectors, n_vectors,
+                                                      bytes_written, TRUE,
+                                                      cancellable, error);
+}
+
+static gboolean g_socket_output_stream_watch_ready (GSocket      *socket,
+                                                    GIOCondition  condition,
+                                                    gpointer      user_data);
+
+static void
+g_socket_output_stream_write_async_try (GSocketOutputStream *output_stream,
+                                        GTask               *task)
+{
+  GSocketOutputStreamPrivate *priv = output_stream->priv;
+  GMainContext *context;
+  GError *error = NULL;
+  gssize res;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  if (priv->vectors)
+    {
+      gsize bytes_written;
+
+      if (g_socket_output_stream_writev_with_blocking (output_stream,
+                                                       priv->vectors, priv->n_vectors,
+                                                       &bytes_written, FALSE,
+                                                       NULL, &error))
+        res = bytes_written;
+      else
+        res = -1;
+    }
+  else
+    res = g_socket_send_with_blocking (priv->socket, priv->buffer, priv->count,
+                                       FALSE, NULL, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+    {
+      g_error_free (error);
+
+      context = g_task_get_context (task);
+      if (priv->watch && g_source_get_context (priv->watch) != context)
+        {
+          g_source_destroy (priv->watch);
+          g_clear_pointer (&priv->watch, g_source_unref);
+        }
+
+      if (priv->watch == NULL)
+        {
+          priv->watch = g_socket_create_watch (priv->socket);
+          g_source_set_callback (priv->watch,
+                                 (GSourceFunc) g_socket_output_stream_watch_ready,
+                                 output_stream, NULL);
+          g_source_attach (priv->watch, context);
+        }
+
+      priv->task = task;
+      g_source_set_priority (priv->watch, g_task_get_priority (task));
+      g_socket_watch_arm (priv->watch, G_IO_OUT, g_task_get_cancellable (task));
+      return;
+    }
+
+  if (res == -1)
+    g_task_return_error (task, error);
+  else
+    g_task_return_int (task, res);
+  g_object_unref (task);
+}
+
+static gboolean
+g_socket_output_stream_watch_ready (GSocket      *socket,
+                                    GIOCondition  condition,
+                                    gpointer      user_data)
+{
+  GSocketOutputStream *output_stream = user_data;
+  GTask *task;
+
+  task = output_stream->priv->task;
+  output_stream->priv->task = NULL;
+  g_socket_watch_disarm (output_stream->priv->watch);
+
+  g_socket_output_stream_write_async_try (output_stream, task);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+g_socket_output_stream_write_async (GOutputStream       *stream,
+                                    const void          *buffer,
+                                    gsize                count,
+                                    int                  io_priority,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  GSocketOutputStream *output_stream = G_SOCKET_OUTPUT_STREAM (stream);
+  GTask *task;
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_socket_output_stream_write_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_check_cancellable (task, FALSE);
+
+  output_stream->priv->buffer = buffer;
+  output_stream->priv->count = count;
+  output_stream->priv->vectors = NULL;
+  output_stream->priv->n_vectors = 0;
+
+  g_socket_output_stream_write_async_try (output_stream, task);
+}
+
+static gssize
+g_socket_output_stream_write_finish (GOutputStream  *stream,
+                                     GAsyncResult   *result,
+                                     GError        **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, stream), -1);
+
+  return g_task_propagate_int (G_TASK (result), error);
+}
+
+static void
+g_socket_output_stream_writev_async (GOutputStream       *stream,
+                                     const GOutputVector *vectors,
+                                     gsize                n_vectors,
+                                     int                  io_priority,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  GSocketOutputStream *output_stream = G_SOCKET_OUTPUT_STREAM (stream);
+  GTask *task;
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, g_socket_output_stream_writev_async);
+  g_task_set_priority (task, io_priority);
+  g_task_set_check_cancellable (task, FALSE);
+
+  output_stream->priv->buffer = NULL;
+  output_stream->priv->count = 0;
+  output_stream->priv->vectors = vectors;
+  output_stream->priv->n_vectors = n_vectors;
+
+  g_socket_output_stream_write_async_try (output_stream, task);
+}
+
+static gboolean
+g_socket_output_stream_writev_finish (GOutputStream  *stream,
+                                      GAsyncResult   *result,
+                                      gsize          *bytes_written,
+                                      GError        **error)
+{
+  gssize res;
+
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+
+  res = g_task_propagate_int (G_TASK (result), error);
+  *bytes_written = MAX (res, 0);
+
+  return res != -1;
+}
+
 static gboolean
 g_socket_output_stream_pollable_is_writable (GPollableOutputStream *pollable)
 {
@@ -155,6 +371,19 @@ g_socket_output_stream_pollable_write_nonblocking (GPollableOutputStream  *polla
 				      NULL, error);
 }
 
+static gboolean
+g_socket_output_stream_pollable_writev_nonblocking (GPollableOutputStream  *pollable,
+						    const GOutputVector    *vectors,
+						    gsize                   n_vectors,
+						    gsize                  *bytes_written,
+						    GError                **error)
+{
+  return g_socket_output_stream_writev_with_blocking (G_SOCKET_OUTPUT_STREAM (pollable),
+                                                      vectors, n_vectors,
+                                                      bytes_written, FALSE,
+                                                      NULL, error);
+}
+
 static GSource *
 g_socket_output_stream_pollable_create_source (GPollableOutputStream *pollable,
 					       GCancellable          *cancellable)
@@ -193,6 +422,11 @@ g_socket_output_stream_class_init (GSocketOutputStreamClass *klass)
   gobject_class->set_property = g_socket_output_stream_set_property;
 
   goutputstream_class->write_fn = g_socket_output_stream_write;
+  goutputstream_class->writev_fn = g_socket_output_stream_writev;
+  goutputstream_class->write_async = g_socket_output_stream_write_async;
+  goutputstream_class->write_finish = g_socket_output_stream_write_finish;
+  goutputstream_class->writev_async = g_socket_output_stream_writev_async;
+  goutputstream_class->writev_finish = g_socket_output_stream_writev_finish;
 
   g_object_class_install_property (gobject_class, PROP_SOCKET,
 				   g_param_spec_object ("socket",
@@ -216,6 +450,7 @@ g_socket_output_stream_pollable_iface_init (GPollableOutputStreamInterface *ifac
   iface->is_writable = g_socket_output_stream_pollable_is_writable;
   iface->create_source = g_socket_output_stream_pollable_create_source;
   iface->write_nonblocking = g_socket_output_stream_pollable_write_nonblocking;
+  iface->writev_nonblocking = g_socket_output_stream_pollable_writev_nonblocking;
 }
 
 static void
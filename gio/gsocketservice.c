@@ -55,6 +55,12 @@
  * service are thread-safe so these can be used from threads that
  * handle incoming clients.
  *
+ * A busy service can spread the work of accepting connections over
+ * several threads with g_socket_service_add_sharded_address(). This
+ * makes several sockets listen on the same address, each in a thread
+ * of its own, and lets the kernel pick the socket that a new
+ * connection goes to.
+ *
  * Since: 2.22
  */
 
@@ -64,15 +70,40 @@
 #include <gio/gio.h>
 #include "gsocketlistener.h"
 #include "gsocketconnection.h"
+#include "gnetworking.h"
+#include "gioprivate.h"
+#include "glibintl.h"
+
+/* How many connections to accept after a single wakeup before giving
+ * the rest of the main loop a chance to run.
+ */
+#define ACCEPT_BATCH_SIZE 32
 
 struct _GSocketServicePrivate
 {
   GCancellable *cancellable;
   guint active : 1;
   guint outstanding_accept : 1;
+
+  GPtrArray *shards;
 };
 
+/* A thread with a main context of its own, which accepts connections
+ * on its own sockets. Apart from creating and quitting it, everything
+ * about a shard is only touched from its thread.
+ */
+typedef struct
+{
+  GSocketService *service;
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+  GSList *sockets;
+  GSList *sources;
+} GSocketServiceShard;
+
 static guint g_socket_service_incoming_signal;
+static GQuark shard_source_quark;
 
 G_LOCK_DEFINE_STATIC(active);
 
@@ -98,11 +129,23 @@ g_socket_service_init (GSocketService *service)
   service->priv->active = TRUE;
 }
 
+static void shard_start (GSocketServiceShard *shard);
+static void shard_quit  (GSocketServiceShard *shard);
+
 static void
 g_socket_service_finalize (GObject *object)
 {
   GSocketService *service = G_SOCKET_SERVICE (object);
 
+  if (service->priv->shards)
+    {
+      guint i;
+
+      for (i = 0; i < service->priv->shards->len; i++)
+        shard_quit (g_ptr_array_index (service->priv->shards, i));
+      g_ptr_array_unref (service->priv->shards);
+    }
+
   g_object_unref (service->priv->cancellable);
 
   G_OBJECT_CLASS (g_socket_service_parent_class)
@@ -183,12 +226,17 @@ g_socket_service_start (GSocketService *service)
 
   if (!service->priv->active)
     {
+      guint i;
+
       service->priv->active = TRUE;
 
       if (service->priv->outstanding_accept)
 	g_cancellable_cancel (service->priv->cancellable);
       else
 	do_accept (service);
+
+      for (i = 0; service->priv->shards && i < service->priv->shards->len; i++)
+        shard_start (g_ptr_array_index (service->priv->shards, i));
     }
 
   G_UNLOCK (active);
@@ -235,6 +283,371 @@ g_socket_service_incoming (GSocketService    *service,
   return result;
 }
 
+static gboolean shard_accept (GSocket      *socket,
+                              GIOCondition  condition,
+                              gpointer      user_data);
+
+/* Runs @func in the thread of @shard, even if it is not running
+ * its main loop yet.
+ */
+static void
+shard_run (GSocketServiceShard *shard,
+           GSourceFunc          func,
+           gpointer             data,
+           GDestroyNotify       notify)
+{
+  GSource *source;
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, G_PRIORITY_HIGH);
+  g_source_set_callback (source, func, data, notify);
+  g_source_attach (source, shard->context);
+  g_source_unref (source);
+}
+
+static void
+shard_watch_socket (GSocketServiceShard *shard,
+                    GSocket             *socket)
+{
+  GSource *source;
+
+  source = g_socket_create_source (socket, G_IO_IN, NULL);
+  g_source_set_callback (source, (GSourceFunc) shard_accept, shard, NULL);
+  g_source_attach (source, shard->context);
+  shard->sources = g_slist_prepend (shard->sources, source);
+}
+
+static void
+shard_unwatch (GSocketServiceShard *shard)
+{
+  GSList *l;
+
+  for (l = shard->sources; l; l = l->next)
+    {
+      g_source_destroy (l->data);
+      g_source_unref (l->data);
+    }
+  g_slist_free (shard->sources);
+  shard->sources = NULL;
+}
+
+static gboolean
+shard_is_active (GSocketServiceShard *shard)
+{
+  gboolean active;
+
+  if (shard->service == NULL)
+    return FALSE;
+
+  G_LOCK (active);
+  active = shard->service->priv->active;
+  G_UNLOCK (active);
+
+  return active;
+}
+
+static gboolean
+shard_start_cb (gpointer user_data)
+{
+  GSocketServiceShard *shard = user_data;
+  GSList *l;
+
+  if (shard->sources == NULL && shard_is_active (shard))
+    for (l = shard->sockets; l; l = l->next)
+      shard_watch_socket (shard, l->data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+shard_start (GSocketServiceShard *shard)
+{
+  shard_run (shard, shard_start_cb, shard, NULL);
+}
+
+static gboolean
+shard_accept (GSocket      *socket,
+              GIOCondition  condition,
+              gpointer      user_data)
+{
+  GSocketServiceShard *shard = user_data;
+  GSocketService *service;
+  GSocketConnection *connection;
+  GSocket *new_socket;
+  GError *error = NULL;
+  guint i;
+
+  /* connections queue up until the service is started again */
+  if (!shard_is_active (shard))
+    {
+      shard_unwatch (shard);
+      return G_SOURCE_REMOVE;
+    }
+
+  /* the handler may drop the last reference to the service */
+  service = g_object_ref (shard->service);
+
+  for (i = 0; i < ACCEPT_BATCH_SIZE && (i == 0 || shard_is_active (shard)); i++)
+    {
+      /* another shard may have been faster */
+      new_socket = g_socket_accept (socket, NULL, &error);
+      if (new_socket == NULL)
+	{
+	  if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+	    g_warning ("fail: %s", error->message);
+	  g_error_free (error);
+	  break;
+	}
+
+      connection = g_socket_connection_factory_create_connection (new_socket);
+      g_object_unref (new_socket);
+
+      g_socket_service_incoming (service, connection,
+				 g_object_get_qdata (G_OBJECT (socket), shard_source_quark));
+      g_object_unref (connection);
+    }
+
+  g_object_unref (service);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gpointer
+shard_thread (gpointer user_data)
+{
+  GSocketServiceShard *shard = user_data;
+
+  g_main_context_push_thread_default (shard->context);
+  g_main_loop_run (shard->loop);
+
+  shard_unwatch (shard);
+  g_slist_free_full (shard->sockets, g_object_unref);
+  g_main_loop_unref (shard->loop);
+  g_main_context_pop_thread_default (shard->context);
+  g_main_context_unref (shard->context);
+  g_slice_free (GSocketServiceShard, shard);
+
+  return NULL;
+}
+
+static GSocketServiceShard *
+shard_new (GSocketService *service)
+{
+  GSocketServiceShard *shard;
+  gchar *name;
+
+  shard = g_slice_new0 (GSocketServiceShard);
+  shard->service = service;
+  shard->context = g_main_context_new ();
+  shard->loop = g_main_loop_new (shard->context, FALSE);
+
+  name = g_strdup_printf ("gsocketservice-%u", service->priv->shards->len);
+  shard->thread = g_thread_new (name, shard_thread, shard);
+  g_free (name);
+
+  return shard;
+}
+
+static gboolean
+shard_quit_cb (gpointer user_data)
+{
+  GSocketServiceShard *shard = user_data;
+
+  g_main_loop_quit (shard->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* The shard frees itself once its thread is done. */
+static void
+shard_quit (GSocketServiceShard *shard)
+{
+  GThread *thread = shard->thread;
+
+  shard_run (shard, shard_quit_cb, shard, NULL);
+
+  if (thread == g_thread_self ())
+    {
+      /* the service is being finalized from one of the handlers */
+      shard->service = NULL;
+      g_thread_unref (thread);
+    }
+  else
+    g_thread_join (thread);
+}
+
+typedef struct
+{
+  GSocketServiceShard *shard;
+  GSocket *socket;
+} ShardAddSocket;
+
+static gboolean
+shard_add_socket_cb (gpointer user_data)
+{
+  ShardAddSocket *data = user_data;
+  GSocketServiceShard *shard = data->shard;
+
+  shard->sockets = g_slist_prepend (shard->sockets, g_object_ref (data->socket));
+  if (shard->sources != NULL || shard_is_active (shard))
+    shard_watch_socket (shard, data->socket);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+shard_add_socket_free (gpointer user_data)
+{
+  ShardAddSocket *data = user_data;
+
+  g_object_unref (data->socket);
+  g_slice_free (ShardAddSocket, data);
+}
+
+/**
+ * g_socket_service_add_sharded_address:
+ * @service: a #GSocketService
+ * @address: a #GSocketAddress
+ * @n_shards: the number of sockets to listen on @address with
+ * @source_object: (allow-none): Optional #GObject identifying this source
+ * @effective_address: (out) (allow-none): location to store the address
+ *     that was bound to, or %NULL.
+ * @error: #GError for error reporting, or %NULL to ignore.
+ *
+ * Creates @n_shards TCP sockets which all listen on @address, using
+ * the SO_REUSEPORT socket option. The kernel then spreads incoming
+ * connections over the sockets.
+ *
+ * The sockets are not added to the sockets of the #GSocketListener.
+ * Instead, the service keeps a number of threads, the shards, each
+ * running a #GMainContext of its own. Each socket is handled by a
+ * different shard, which accepts the connections arriving at it, and
+ * emits #GSocketService::incoming for them in its thread, with its
+ * main context as the thread-default context. Shards are created as
+ * needed, and they are shared by all the sharded addresses of
+ * @service.
+ *
+ * Starting and stopping @service also applies to the shards. They
+ * stop when @service is finalized, which must not happen from a
+ * thread of one of the other shards.
+ *
+ * This is only supported on platforms that have SO_REUSEPORT with
+ * load balancing semantics, such as Linux 3.9 and later. Elsewhere,
+ * %G_IO_ERROR_NOT_SUPPORTED is returned.
+ *
+ * @source_object and @effective_address work as with
+ * g_socket_listener_add_address(). If @address has a port of 0, all
+ * the sockets share the port that the first one is bound to.
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 2.40
+ */
+gboolean
+g_socket_service_add_sharded_address (GSocketService  *service,
+                                      GSocketAddress  *address,
+                                      guint            n_shards,
+                                      GObject         *source_object,
+                                      GSocketAddress **effective_address,
+                                      GError         **error)
+{
+#if defined (SO_REUSEPORT) && defined (__linux__)
+  GSocketAddress *bind_address;
+  GPtrArray *sockets;
+  gboolean result = TRUE;
+  gint backlog;
+  guint i;
+
+  g_return_val_if_fail (G_IS_SOCKET_SERVICE (service), FALSE);
+  g_return_val_if_fail (G_IS_SOCKET_ADDRESS (address), FALSE);
+  g_return_val_if_fail (n_shards > 0, FALSE);
+
+  if (G_UNLIKELY (shard_source_quark == 0))
+    shard_source_quark = g_quark_from_static_string ("g-socket-service-shard-source");
+
+  g_object_get (service, "listen-backlog", &backlog, NULL);
+
+  /* bind them all before handing out any */
+  sockets = g_ptr_array_new_with_free_func (g_object_unref);
+  bind_address = g_object_ref (address);
+  for (i = 0; i < n_shards && result; i++)
+    {
+      GSocket *socket;
+
+      socket = g_socket_new (g_socket_address_get_family (address),
+                             G_SOCKET_TYPE_STREAM,
+                             G_SOCKET_PROTOCOL_DEFAULT,
+                             error);
+      if (socket == NULL)
+        {
+          result = FALSE;
+          break;
+        }
+      g_ptr_array_add (sockets, socket);
+
+      g_socket_set_blocking (socket, FALSE);
+      g_socket_set_listen_backlog (socket, backlog);
+      result = g_socket_set_option (socket, SOL_SOCKET, SO_REUSEPORT, TRUE, error) &&
+               g_socket_bind (socket, bind_address, TRUE, error) &&
+               g_socket_listen (socket, error);
+
+      if (result && i == 0)
+        {
+          GSocketAddress *local_address;
+
+          /* for port 0 */
+          local_address = g_socket_get_local_address (socket, error);
+          if (local_address == NULL)
+            {
+              result = FALSE;
+              break;
+            }
+          g_object_unref (bind_address);
+          bind_address = local_address;
+        }
+
+      if (source_object)
+        g_object_set_qdata_full (G_OBJECT (socket), shard_source_quark,
+                                 g_object_ref (source_object),
+                                 g_object_unref);
+    }
+
+  if (result)
+    {
+      if (service->priv->shards == NULL)
+        service->priv->shards = g_ptr_array_new ();
+
+      for (i = 0; i < n_shards; i++)
+        {
+          ShardAddSocket *data;
+
+          if (i == service->priv->shards->len)
+            g_ptr_array_add (service->priv->shards, shard_new (service));
+
+          data = g_slice_new (ShardAddSocket);
+          data->shard = g_ptr_array_index (service->priv->shards, i);
+          data->socket = g_object_ref (g_ptr_array_index (sockets, i));
+          shard_run (data->shard, shard_add_socket_cb, data, shard_add_socket_free);
+        }
+
+      if (effective_address)
+        *effective_address = g_object_ref (bind_address);
+    }
+
+  g_object_unref (bind_address);
+  g_ptr_array_unref (sockets);
+
+  return result;
+#else
+  g_return_val_if_fail (G_IS_SOCKET_SERVICE (service), FALSE);
+  g_return_val_if_fail (G_IS_SOCKET_ADDRESS (address), FALSE);
+
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       _("Sharded socket services are not supported on this platform"));
+  return FALSE;
+#endif
+}
+
 static void
 g_socket_service_class_init (GSocketServiceClass *class)
 {
@@ -292,8 +705,33 @@ g_socket_service_ready (GObject      *object,
     }
   else
     {
+      guint n_accepted = 1;
+
       g_socket_service_incoming (service, connection, source_object);
       g_object_unref (connection);
+
+      /* During a connection storm more clients are likely to be
+       * queued already, so take them without going back to the main
+       * loop for each one.
+       */
+      while (n_accepted < ACCEPT_BATCH_SIZE &&
+	     g_socket_service_is_active (service))
+	{
+	  connection = g_socket_listener_accept_pending (listener,
+							 &source_object,
+							 &error);
+	  if (connection == NULL)
+	    {
+	      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+		g_warning ("fail: %s", error->message);
+	      g_clear_error (&error);
+	      break;
+	    }
+
+	  g_socket_service_incoming (service, connection, source_object);
+	  g_object_unref (connection);
+	  n_accepted++;
+	}
     }
 
   G_LOCK (active);
@@ -86,6 +86,13 @@ GLIB_AVAILABLE_IN_ALL
 void            g_socket_service_stop      (GSocketService *service);
 GLIB_AVAILABLE_IN_ALL
 gboolean        g_socket_service_is_active (GSocketService *service);
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_socket_service_add_sharded_address (GSocketService  *service,
+                                                      GSocketAddress  *address,
+                                                      guint            n_shards,
+                                                      GObject         *source_object,
+                                                      GSocketAddress **effective_address,
+                                                      GError         **error);
 
 
 G_END_DECLS
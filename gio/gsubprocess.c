@@ -1368,6 +1368,10 @@ typedef struct
   GMemoryOutputStream *stdout_buf;
   GMemoryOutputStream *stderr_buf;
 
+  /* for g_subprocess_communicate_streams() */
+  GOutputStream *stdout_target;
+  GBytesList *stdout_chunks;
+
   GCancellable *cancellable;
   GSource      *cancellable_source;
 
@@ -1375,6 +1379,39 @@ typedef struct
   gboolean      reported_error;
 } CommunicateState;
 
+static void
+g_subprocess_communicate_op_done (GTask  *task,
+                                  GError *error)
+{
+  CommunicateState *state = g_task_get_task_data (task);
+
+  state->outstanding_ops--;
+
+  if (error)
+    {
+      /* Only report the first error we see.
+       *
+       * We might be seeing an error as a result of the cancellation
+       * done when the process quits.
+       */
+      if (!state->reported_error)
+        {
+          state->reported_error = TRUE;
+          g_cancellable_cancel (state->cancellable);
+          g_task_return_error (task, error);
+        }
+      else
+        g_error_free (error);
+    }
+  else if (state->outstanding_ops == 0)
+    {
+      g_task_return_boolean (task, TRUE);
+    }
+
+  /* And drop the original ref */
+  g_object_unref (task);
+}
+
 static void
 g_subprocess_communicate_made_progress (GObject      *source_object,
                                         GAsyncResult *result,
@@ -1393,11 +1430,14 @@ g_subprocess_communicate_made_progress (GObject      *source_object,
   state = g_task_get_task_data (task);
   source = source_object;
 
-  state->outstanding_ops--;
-
-  if (source == subprocess->stdin_pipe ||
-      source == state->stdout_buf ||
-      source == state->stderr_buf)
+  if (source == state->stdout_target)
+    {
+      /* The caller's stream: spliced into, but not closed by us */
+      (void) g_output_stream_splice_finish ((GOutputStream*)source, result, &error);
+    }
+  else if (source == subprocess->stdin_pipe ||
+           source == state->stdout_buf ||
+           source == state->stderr_buf)
     {
       if (!g_output_stream_splice_finish ((GOutputStream*)source, result, &error))
         goto out;
@@ -1427,29 +1467,44 @@ g_subprocess_communicate_made_progress (GObject      *source_object,
     g_assert_not_reached ();
 
  out:
-  if (error)
+  g_subprocess_communicate_op_done (task, error);
+}
+
+/* Reads stdout as a series of #GBytes, which end up in the result
+ * as they are, instead of being copied into one growing buffer.
+ */
+static void
+g_subprocess_communicate_read_chunk (GObject      *source_object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  GInputStream *stdout_pipe = G_INPUT_STREAM (source_object);
+  GTask *task = user_data;
+  CommunicateState *state = g_task_get_task_data (task);
+  GError *error = NULL;
+  GBytes *bytes;
+
+  bytes = g_input_stream_read_bytes_finish (stdout_pipe, result, &error);
+  if (bytes == NULL)
     {
-      /* Only report the first error we see.
-       *
-       * We might be seeing an error as a result of the cancellation
-       * done when the process quits.
-       */
-      if (!state->reported_error)
-        {
-          state->reported_error = TRUE;
-          g_cancellable_cancel (state->cancellable);
-          g_task_return_error (task, error);
-        }
-      else
-        g_error_free (error);
+      g_subprocess_communicate_op_done (task, error);
+      return;
     }
-  else if (state->outstanding_ops == 0)
+
+  if (g_bytes_get_size (bytes) == 0)
     {
-      g_task_return_boolean (task, TRUE);
+      g_bytes_unref (bytes);
+      (void) g_input_stream_close (stdout_pipe, NULL, &error);
+      g_subprocess_communicate_op_done (task, error);
+      return;
     }
 
-  /* And drop the original ref */
-  g_object_unref (task);
+  g_bytes_list_append (state->stdout_chunks, bytes);
+  g_bytes_unref (bytes);
+
+  g_input_stream_read_bytes_async (stdout_pipe, 64 * 1024, G_PRIORITY_DEFAULT,
+                                   state->cancellable,
+                                   g_subprocess_communicate_read_chunk, task);
 }
 
 static gboolean
@@ -1470,6 +1525,8 @@ g_subprocess_communicate_state_free (gpointer data)
   g_clear_object (&state->stdin_buf);
   g_clear_object (&state->stdout_buf);
   g_clear_object (&state->stderr_buf);
+  g_clear_object (&state->stdout_target);
+  g_clear_pointer (&state->stdout_chunks, g_bytes_list_free);
 
   if (!g_source_is_destroyed (state->cancellable_source))
     g_source_destroy (state->cancellable_source);
@@ -1482,6 +1539,9 @@ static CommunicateState *
 g_subprocess_communicate_internal (GSubprocess         *subprocess,
                                    gboolean             add_nul,
                                    GBytes              *stdin_buf,
+                                   GInputStream        *stdin_stream,
+                                   GOutputStream       *stdout_stream,
+                                   gboolean             stdout_chunked,
                                    GCancellable        *cancellable,
                                    GAsyncReadyCallback  callback,
                                    gpointer             user_data)
@@ -1504,9 +1564,23 @@ g_subprocess_communicate_internal (GSubprocess         *subprocess,
       g_source_attach (state->cancellable_source, g_main_context_get_thread_default ());
     }
 
-  if (subprocess->stdin_pipe)
+  if (subprocess->stdin_pipe && stdin_stream)
+    {
+      /* The caller's stream is left open. When both ends are file
+       * descriptors this is done with splice() or sendfile().
+       */
+      g_output_stream_splice_async (subprocess->stdin_pipe, stdin_stream,
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                    G_PRIORITY_DEFAULT, state->cancellable,
+                                    g_subprocess_communicate_made_progress, g_object_ref (task));
+      state->outstanding_ops++;
+    }
+  else if (subprocess->stdin_pipe && stdin_buf == NULL)
+    {
+      (void) g_output_stream_close (subprocess->stdin_pipe, NULL, NULL);
+    }
+  else if (subprocess->stdin_pipe)
     {
-      g_assert (stdin_buf != NULL);
       state->stdin_buf = g_memory_input_stream_new_from_bytes (stdin_buf);
       g_output_stream_splice_async (subprocess->stdin_pipe, (GInputStream*)state->stdin_buf,
                                     G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
@@ -1515,7 +1589,24 @@ g_subprocess_communicate_internal (GSubprocess         *subprocess,
       state->outstanding_ops++;
     }
 
-  if (subprocess->stdout_pipe)
+  if (subprocess->stdout_pipe && stdout_stream)
+    {
+      state->stdout_target = g_object_ref (stdout_stream);
+      g_output_stream_splice_async (stdout_stream, subprocess->stdout_pipe,
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE,
+                                    G_PRIORITY_DEFAULT, state->cancellable,
+                                    g_subprocess_communicate_made_progress, g_object_ref (task));
+      state->outstanding_ops++;
+    }
+  else if (subprocess->stdout_pipe && stdout_chunked)
+    {
+      state->stdout_chunks = g_bytes_list_new ();
+      g_input_stream_read_bytes_async (subprocess->stdout_pipe, 64 * 1024, G_PRIORITY_DEFAULT,
+                                       state->cancellable,
+                                       g_subprocess_communicate_read_chunk, g_object_ref (task));
+      state->outstanding_ops++;
+    }
+  else if (subprocess->stdout_pipe)
     {
       state->stdout_buf = (GMemoryOutputStream*)g_memory_output_stream_new_resizable ();
       g_output_stream_splice_async ((GOutputStream*)state->stdout_buf, subprocess->stdout_pipe,
@@ -1614,8 +1705,8 @@ g_subprocess_communicate (GSubprocess   *subprocess,
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   g_subprocess_sync_setup ();
-  g_subprocess_communicate_internal (subprocess, FALSE, stdin_buf, cancellable,
-                                     g_subprocess_sync_done, &result);
+  g_subprocess_communicate_internal (subprocess, FALSE, stdin_buf, NULL, NULL, FALSE,
+                                     cancellable, g_subprocess_sync_done, &result);
   g_subprocess_sync_complete (&result);
   success = g_subprocess_communicate_finish (subprocess, result, stdout_buf, stderr_buf, error);
   g_object_unref (result);
@@ -1645,7 +1736,8 @@ g_subprocess_communicate_async (GSubprocess         *subprocess,
   g_return_if_fail (stdin_buf == NULL || (subprocess->flags & G_SUBPROCESS_FLAGS_STDIN_PIPE));
   g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
-  g_subprocess_communicate_internal (subprocess, FALSE, stdin_buf, cancellable, callback, user_data);
+  g_subprocess_communicate_internal (subprocess, FALSE, stdin_buf, NULL, NULL, FALSE,
+                                     cancellable, callback, user_data);
 }
 
 /**
@@ -1689,6 +1781,161 @@ g_subprocess_communicate_finish (GSubprocess   *subprocess,
   return success;
 }
 
+/**
+ * g_subprocess_communicate_streams:
+ * @subprocess: a #GSubprocess
+ * @stdin_stream: (allow-none): stream to feed to the stdin of the subprocess, or %NULL
+ * @stdout_stream: (allow-none): stream to write the stdout of the subprocess to, or %NULL
+ * @cancellable: a #GCancellable
+ * @stdout_chunks: (out) (allow-none): data read from the subprocess stdout
+ * @stderr_buf: (out) (allow-none): data read from the subprocess stderr
+ * @error: a pointer to a %NULL #GError pointer, or %NULL
+ *
+ * Like g_subprocess_communicate(), but for large amounts of data.
+ *
+ * If @stdin_stream is given, the subprocess must have been created
+ * with %G_SUBPROCESS_FLAGS_STDIN_PIPE. The contents of @stdin_stream
+ * are fed to the stdin of the subprocess, after which the pipe is
+ * closed; @stdin_stream itself is not closed. If @stdin_stream is
+ * %NULL, the stdin pipe (if any) is closed right away.
+ *
+ * If @stdout_stream is given, the subprocess must have been created
+ * with %G_SUBPROCESS_FLAGS_STDOUT_PIPE, and everything the subprocess
+ * writes to stdout is written to @stdout_stream, which is not closed.
+ * Otherwise, the stdout data is returned in @stdout_chunks, as a list
+ * of the buffers it was read into, without copying them together.
+ *
+ * When the streams are backed by file descriptors, as for example the
+ * streams returned by g_file_read() and g_file_replace() on local
+ * files or #GUnixInputStream and #GUnixOutputStream, the data is moved
+ * between them and the pipes of the subprocess by the kernel, with
+ * splice() or sendfile(), and never copied through this process.
+ *
+ * Error handling and the use of the pipes are as for
+ * g_subprocess_communicate(); in particular, some of the data may have
+ * been consumed from @stdin_stream or written to @stdout_stream when
+ * an error is returned.
+ *
+ * Returns: %TRUE if successful
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_subprocess_communicate_streams (GSubprocess    *subprocess,
+                                  GInputStream   *stdin_stream,
+                                  GOutputStream  *stdout_stream,
+                                  GCancellable   *cancellable,
+                                  GBytesList    **stdout_chunks,
+                                  GBytes        **stderr_buf,
+                                  GError        **error)
+{
+  GAsyncResult *result = NULL;
+  gboolean success;
+
+  g_return_val_if_fail (G_IS_SUBPROCESS (subprocess), FALSE);
+  g_return_val_if_fail (stdin_stream == NULL || G_IS_INPUT_STREAM (stdin_stream), FALSE);
+  g_return_val_if_fail (stdin_stream == NULL || (subprocess->flags & G_SUBPROCESS_FLAGS_STDIN_PIPE), FALSE);
+  g_return_val_if_fail (stdout_stream == NULL || G_IS_OUTPUT_STREAM (stdout_stream), FALSE);
+  g_return_val_if_fail (stdout_stream == NULL || (subprocess->flags & G_SUBPROCESS_FLAGS_STDOUT_PIPE), FALSE);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  g_subprocess_sync_setup ();
+  g_subprocess_communicate_internal (subprocess, FALSE, NULL, stdin_stream, stdout_stream, TRUE,
+                                     cancellable, g_subprocess_sync_done, &result);
+  g_subprocess_sync_complete (&result);
+  success = g_subprocess_communicate_streams_finish (subprocess, result, stdout_chunks, stderr_buf, error);
+  g_object_unref (result);
+
+  return success;
+}
+
+/**
+ * g_subprocess_communicate_streams_async:
+ * @subprocess: a #GSubprocess
+ * @stdin_stream: (allow-none): stream to feed to the stdin of the subprocess, or %NULL
+ * @stdout_stream: (allow-none): stream to write the stdout of the subprocess to, or %NULL
+ * @cancellable: a #GCancellable
+ * @callback: Callback
+ * @user_data: User data
+ *
+ * Asynchronous version of g_subprocess_communicate_streams().  Complete
+ * invocation with g_subprocess_communicate_streams_finish().
+ *
+ * Since: 2.40
+ */
+void
+g_subprocess_communicate_streams_async (GSubprocess         *subprocess,
+                                        GInputStream        *stdin_stream,
+                                        GOutputStream       *stdout_stream,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data)
+{
+  g_return_if_fail (G_IS_SUBPROCESS (subprocess));
+  g_return_if_fail (stdin_stream == NULL || G_IS_INPUT_STREAM (stdin_stream));
+  g_return_if_fail (stdin_stream == NULL || (subprocess->flags & G_SUBPROCESS_FLAGS_STDIN_PIPE));
+  g_return_if_fail (stdout_stream == NULL || G_IS_OUTPUT_STREAM (stdout_stream));
+  g_return_if_fail (stdout_stream == NULL || (subprocess->flags & G_SUBPROCESS_FLAGS_STDOUT_PIPE));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  g_subprocess_communicate_internal (subprocess, FALSE, NULL, stdin_stream, stdout_stream, TRUE,
+                                     cancellable, callback, user_data);
+}
+
+/**
+ * g_subprocess_communicate_streams_finish:
+ * @subprocess: Self
+ * @result: Result
+ * @stdout_chunks: (out) (allow-none): Return location for stdout data
+ * @stderr_buf: (out) (allow-none): Return location for stderr data
+ * @error: Error
+ *
+ * Complete an invocation of g_subprocess_communicate_streams_async().
+ *
+ * @stdout_chunks is set to %NULL if the subprocess was not created with
+ * %G_SUBPROCESS_FLAGS_STDOUT_PIPE or if its stdout was written to a
+ * stream; likewise @stderr_buf is set to %NULL if the subprocess was
+ * not created with %G_SUBPROCESS_FLAGS_STDERR_PIPE.
+ *
+ * Returns: %TRUE if successful
+ *
+ * Since: 2.40
+ */
+gboolean
+g_subprocess_communicate_streams_finish (GSubprocess   *subprocess,
+                                         GAsyncResult  *result,
+                                         GBytesList   **stdout_chunks,
+                                         GBytes       **stderr_buf,
+                                         GError       **error)
+{
+  gboolean success;
+  CommunicateState *state;
+
+  g_return_val_if_fail (G_IS_SUBPROCESS (subprocess), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, subprocess), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  g_object_ref (result);
+
+  state = g_task_get_task_data ((GTask*)result);
+  success = g_task_propagate_boolean ((GTask*)result, error);
+
+  if (success)
+    {
+      if (stdout_chunks)
+        {
+          *stdout_chunks = state->stdout_chunks;
+          state->stdout_chunks = NULL;
+        }
+      if (stderr_buf)
+        *stderr_buf = state->stderr_buf ? g_memory_output_stream_steal_as_bytes (state->stderr_buf) : NULL;
+    }
+
+  g_object_unref (result);
+  return success;
+}
+
 /**
  * g_subprocess_communicate_utf8:
  * @subprocess: a #GSubprocess
@@ -1721,8 +1968,8 @@ g_subprocess_communicate_utf8 (GSubprocess   *subprocess,
   stdin_bytes = g_bytes_new (stdin_buf, strlen (stdin_buf));
 
   g_subprocess_sync_setup ();
-  g_subprocess_communicate_internal (subprocess, TRUE, stdin_bytes, cancellable,
-                                     g_subprocess_sync_done, &result);
+  g_subprocess_communicate_internal (subprocess, TRUE, stdin_bytes, NULL, NULL, FALSE,
+                                     cancellable, g_subprocess_sync_done, &result);
   g_subprocess_sync_complete (&result);
   success = g_subprocess_communicate_utf8_finish (subprocess, result, stdout_buf, stderr_buf, error);
   g_object_unref (result);
@@ -1756,7 +2003,8 @@ g_subprocess_communicate_utf8_async (GSubprocess         *subprocess,
   g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
   stdin_bytes = g_bytes_new (stdin_buf, strlen (stdin_buf));
-  g_subprocess_communicate_internal (subprocess, TRUE, stdin_bytes, cancellable, callback, user_data);
+  g_subprocess_communicate_internal (subprocess, TRUE, stdin_bytes, NULL, NULL, FALSE,
+                                     cancellable, callback, user_data);
   g_bytes_unref (stdin_bytes);
 }
 
@@ -143,6 +143,29 @@ gboolean        g_subprocess_communicate_finish         (GSubprocess          *s
                                                          GBytes              **stderr_buf,
                                                          GError              **error);
 
+GLIB_AVAILABLE_IN_2_40
+gboolean         g_subprocess_communicate_streams       (GSubprocess          *subprocess,
+                                                         GInputStream         *stdin_stream,
+                                                         GOutputStream        *stdout_stream,
+                                                         GCancellable         *cancellable,
+                                                         GBytesList          **stdout_chunks,
+                                                         GBytes              **stderr_buf,
+                                                         GError              **error);
+GLIB_AVAILABLE_IN_2_40
+void            g_subprocess_communicate_streams_async  (GSubprocess          *subprocess,
+                                                         GInputStream         *stdin_stream,
+                                                         GOutputStream        *stdout_stream,
+                                                         GCancellable         *cancellable,
+                                                         GAsyncReadyCallback   callback,
+                                                         gpointer              user_data);
+
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_subprocess_communicate_streams_finish (GSubprocess          *subprocess,
+                                                         GAsyncResult         *result,
+                                                         GBytesList          **stdout_chunks,
+                                                         GBytes              **stderr_buf,
+                                                         GError              **error);
+
 GLIB_AVAILABLE_IN_2_40
 gboolean         g_subprocess_communicate_utf8          (GSubprocess          *subprocess,
                                                          const char           *stdin_buf,
@@ -24,6 +24,7 @@
 
 #include "gasyncresult.h"
 #include "gcancellable.h"
+#include "glib-private.h"
 
 /**
  * SECTION:gtask
@@ -617,6 +618,44 @@ static GThreadPool *task_pool;
 static GMutex task_pool_mutex;
 static GPrivate task_private = G_PRIVATE_INIT (NULL);
 
+/* The pool starts with G_TASK_POOL_SIZE threads. When all of them
+ * have been busy for a while and tasks are queued up, they are
+ * probably blocked on I/O, so the pool manager adds a thread, and
+ * waits a bit longer before it adds another one. The extra threads
+ * go away again once the queue is empty. Everything here is
+ * protected by task_pool_mutex.
+ */
+#define G_TASK_POOL_SIZE 10
+#define G_TASK_POOL_MAX_SIZE 256
+#define G_TASK_WAIT_TIME_BASE 100000
+#define G_TASK_WAIT_TIME_MULTIPLIER 1.03
+#define G_TASK_WAIT_TIME_MAX (30 * G_USEC_PER_SEC)
+
+static guint task_pool_size = G_TASK_POOL_SIZE;
+static guint task_pool_max_size = G_TASK_POOL_MAX_SIZE;
+static gint64 task_wait_time_base = G_TASK_WAIT_TIME_BASE;
+static guint task_pool_extra;           /* added by the pool manager */
+static guint task_pool_nested;          /* see g_task_start_task_thread() */
+static guint tasks_running;
+static gint64 task_wait_time;
+static GSource *task_pool_manager;
+static gboolean task_pool_manager_armed;
+static gboolean task_trace_buffer_enabled;
+
+static void
+g_task_trace (GTask           *task,
+              GTraceEventType  type,
+              GTracePhase      phase,
+              gint64           arg)
+{
+  if (G_LIKELY (!task_trace_buffer_enabled))
+    return;
+
+  GLIB_PRIVATE_CALL (g_trace_buffer_record) (type, phase,
+                                             task->source_object ? G_OBJECT_TYPE_NAME (task->source_object) : NULL,
+                                             task, arg);
+}
+
 static void
 g_task_init (GTask *task)
 {
@@ -702,6 +741,8 @@ g_task_new (gpointer              source_object,
   if (source)
     task->creation_time = g_source_get_time (source);
 
+  g_task_trace (task, G_TRACE_EVENT_TASK_NEW, G_TRACE_PHASE_INSTANT, 0);
+
   return task;
 }
 
@@ -1104,11 +1145,15 @@ g_task_get_source_tag (GTask *task)
 static void
 g_task_return_now (GTask *task)
 {
+  g_task_trace (task, G_TRACE_EVENT_TASK_CALLBACK, G_TRACE_PHASE_BEGIN, 0);
+
   g_main_context_push_thread_default (task->context);
   task->callback (task->source_object,
                   G_ASYNC_RESULT (task),
                   task->callback_data);
   g_main_context_pop_thread_default (task->context);
+
+  g_task_trace (task, G_TRACE_EVENT_TASK_CALLBACK, G_TRACE_PHASE_END, 0);
 }
 
 static gboolean
@@ -1119,6 +1164,135 @@ complete_in_idle_cb (gpointer task)
   return FALSE;
 }
 
+/* Tasks that are returned from another thread are not each given an
+ * idle source of their own. Instead, they are queued up on a single
+ * completion source per context and priority, which completes all of
+ * the tasks that are waiting in one dispatch. The sources stay around
+ * for as long as their context does, and are ready only while their
+ * queue is non-empty.
+ */
+typedef struct
+{
+  GSource       source;
+  GMainContext *context;
+  gint          priority;
+  GQueue        tasks;          /* protected by task_completion_lock */
+} GTaskCompletionSource;
+
+static GMutex task_completion_lock;
+static GHashTable *task_completion_sources;   /* GMainContext -> GSList of sources */
+
+static gboolean
+task_completion_source_dispatch (GSource     *source,
+                                 GSourceFunc  callback,
+                                 gpointer     user_data)
+{
+  GTaskCompletionSource *completion = (GTaskCompletionSource *) source;
+  GQueue tasks;
+  GTask *task;
+
+  /* Tasks queued up while these are being completed have to wait
+   * for the next iteration, as with an idle source.
+   */
+  g_mutex_lock (&task_completion_lock);
+  tasks = completion->tasks;
+  g_queue_init (&completion->tasks);
+  g_source_set_ready_time (source, -1);
+  g_mutex_unlock (&task_completion_lock);
+
+  while ((task = g_queue_pop_head (&tasks)))
+    {
+      g_task_return_now (task);
+      g_object_unref (task);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+task_completion_source_finalize (GSource *source)
+{
+  GTaskCompletionSource *completion = (GTaskCompletionSource *) source;
+  GSList *sources;
+
+  g_mutex_lock (&task_completion_lock);
+  sources = g_hash_table_lookup (task_completion_sources, completion->context);
+  sources = g_slist_remove (sources, completion);
+  if (sources)
+    g_hash_table_insert (task_completion_sources, completion->context, sources);
+  else
+    g_hash_table_remove (task_completion_sources, completion->context);
+  g_mutex_unlock (&task_completion_lock);
+
+  /* a context with tasks pending can not go away */
+  g_assert (g_queue_is_empty (&completion->tasks));
+}
+
+static GSourceFuncs task_completion_source_funcs = {
+  NULL,
+  NULL,
+  task_completion_source_dispatch,
+  task_completion_source_finalize
+};
+
+/* Takes over the reference on @task. */
+static void
+g_task_queue_completion (GTask *task)
+{
+  GTaskCompletionSource *completion = NULL;
+  GMainContext *context = task->context;
+  gboolean was_empty;
+  GSList *sources, *l;
+
+  g_mutex_lock (&task_completion_lock);
+
+  if (G_UNLIKELY (task_completion_sources == NULL))
+    task_completion_sources = g_hash_table_new (NULL, NULL);
+
+  sources = g_hash_table_lookup (task_completion_sources, context);
+  for (l = sources; l; l = l->next)
+    {
+      completion = l->data;
+      if (completion->priority == task->priority)
+        break;
+    }
+
+  if (l == NULL)
+    {
+      GSource *source;
+
+      source = g_source_new (&task_completion_source_funcs,
+                             sizeof (GTaskCompletionSource));
+      g_source_set_name (source, "GTaskCompletionSource");
+      g_source_set_priority (source, task->priority);
+      completion = (GTaskCompletionSource *) source;
+      completion->context = context;
+      completion->priority = task->priority;
+      g_queue_init (&completion->tasks);
+      g_hash_table_insert (task_completion_sources, context,
+                           g_slist_prepend (sources, completion));
+      g_source_attach (source, context);
+      g_source_unref (source);
+    }
+
+  was_empty = g_queue_is_empty (&completion->tasks);
+  g_queue_push_tail (&completion->tasks, task);
+  if (was_empty)
+    g_source_ref ((GSource *) completion);
+
+  g_mutex_unlock (&task_completion_lock);
+
+  /* The task holds a reference on the context, so the source can not
+   * be destroyed under us. If the source is dispatched before this, it
+   * just wakes up once more for nothing.
+   */
+  if (was_empty)
+    {
+      g_source_set_ready_time ((GSource *) completion, 0);
+      g_source_unref ((GSource *) completion);
+    }
+}
+
 typedef enum {
   G_TASK_RETURN_SUCCESS,
   G_TASK_RETURN_ERROR,
@@ -1134,6 +1308,8 @@ g_task_return (GTask           *task,
   if (type == G_TASK_RETURN_SUCCESS)
     task->result_set = TRUE;
 
+  g_task_trace (task, G_TRACE_EVENT_TASK_RETURN, G_TRACE_PHASE_INSTANT, type);
+
   if (task->synchronous || !task->callback)
     return;
 
@@ -1164,7 +1340,16 @@ g_task_return (GTask           *task,
         }
     }
 
-  /* Otherwise, complete in the next iteration */
+  /* Otherwise, complete in the next iteration. Returns from other
+   * threads are batched up, since there may be a lot of them.
+   */
+  if (type == G_TASK_RETURN_FROM_THREAD ||
+      !g_main_context_is_owner (task->context))
+    {
+      g_task_queue_completion (task);
+      return;
+    }
+
   source = g_idle_source_new ();
   g_task_attach_source (task, source, complete_in_idle_cb);
   g_source_unref (source);
@@ -1200,6 +1385,110 @@ g_task_return (GTask           *task,
 static void task_thread_cancelled (GCancellable *cancellable,
                                    gpointer      user_data);
 
+/* Called with task_pool_mutex held */
+static gboolean
+g_task_thread_pool_update_limit (void)
+{
+  guint size;
+
+  size = MIN (task_pool_size + task_pool_extra, task_pool_max_size);
+
+  return g_thread_pool_set_max_threads (task_pool, size + task_pool_nested, NULL);
+}
+
+/* Called with task_pool_mutex held, when all threads of the pool are
+ * busy, to have the pool manager check on them after a while.
+ */
+static void
+g_task_thread_pool_arm_manager (void)
+{
+  if (task_pool_manager_armed)
+    return;
+
+  if (task_wait_time == 0)
+    task_wait_time = task_wait_time_base;
+
+  task_pool_manager_armed = TRUE;
+  g_source_set_ready_time (task_pool_manager, g_get_monotonic_time () + task_wait_time);
+}
+
+static gboolean
+task_pool_manager_timeout (gpointer user_data)
+{
+  g_mutex_lock (&task_pool_mutex);
+
+  task_pool_manager_armed = FALSE;
+  g_source_set_ready_time (task_pool_manager, -1);
+
+  if (tasks_running >= (guint) g_thread_pool_get_max_threads (task_pool) &&
+      g_thread_pool_unprocessed (task_pool) > 0 &&
+      task_pool_size + task_pool_extra < task_pool_max_size)
+    {
+      /* Everything is stuck, add a thread, and wait a little longer
+       * each time before adding the next one.
+       */
+      task_pool_extra++;
+      g_task_thread_pool_update_limit ();
+
+      task_wait_time = MIN (task_wait_time * G_TASK_WAIT_TIME_MULTIPLIER,
+                            G_TASK_WAIT_TIME_MAX);
+      g_task_thread_pool_arm_manager ();
+    }
+
+  g_mutex_unlock (&task_pool_mutex);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+task_pool_manager_dispatch (GSource     *source,
+                            GSourceFunc  callback,
+                            gpointer     user_data)
+{
+  return callback (user_data);
+}
+
+static GSourceFuncs task_pool_manager_funcs = {
+  NULL,
+  NULL,
+  task_pool_manager_dispatch,
+  NULL
+};
+
+static void
+g_task_thread_setup (void)
+{
+  g_mutex_lock (&task_pool_mutex);
+
+  tasks_running++;
+  if (tasks_running >= (guint) g_thread_pool_get_max_threads (task_pool))
+    g_task_thread_pool_arm_manager ();
+
+  g_mutex_unlock (&task_pool_mutex);
+}
+
+static void
+g_task_thread_cleanup (void)
+{
+  g_mutex_lock (&task_pool_mutex);
+
+  tasks_running--;
+
+  /* Once nothing is waiting anymore, the blocked tasks are over */
+  if (g_thread_pool_unprocessed (task_pool) == 0)
+    {
+      if (task_pool_extra > 0)
+        {
+          task_pool_extra--;
+          g_task_thread_pool_update_limit ();
+        }
+      if (task_pool_extra == 0)
+        task_wait_time = 0;
+    }
+
+  g_mutex_unlock (&task_pool_mutex);
+}
+
 static void
 g_task_thread_complete (GTask *task)
 {
@@ -1218,9 +1507,8 @@ g_task_thread_complete (GTask *task)
   if (task->blocking_other_task)
     {
       g_mutex_lock (&task_pool_mutex);
-      g_thread_pool_set_max_threads (task_pool,
-                                     g_thread_pool_get_max_threads (task_pool) - 1,
-                                     NULL);
+      task_pool_nested--;
+      g_task_thread_pool_update_limit ();
       g_mutex_unlock (&task_pool_mutex);
     }
   g_mutex_unlock (&task->lock);
@@ -1241,11 +1529,13 @@ g_task_thread_pool_thread (gpointer thread_data,
   GTask *task = thread_data;
 
   g_private_set (&task_private, task);
+  g_task_thread_setup ();
 
   task->task_func (task, task->source_object, task->task_data,
                    task->cancellable);
   g_task_thread_complete (task);
 
+  g_task_thread_cleanup ();
   g_private_set (&task_private, NULL);
   g_object_unref (task);
 }
@@ -1319,10 +1609,18 @@ g_task_start_task_thread (GTask           *task,
        * bump up max-threads so we don't starve.
        */
       g_mutex_lock (&task_pool_mutex);
-      if (g_thread_pool_set_max_threads (task_pool,
-                                         g_thread_pool_get_max_threads (task_pool) + 1,
-                                         NULL))
+      task_pool_nested++;
+      if (g_task_thread_pool_update_limit ())
         task->blocking_other_task = TRUE;
+      else
+        task_pool_nested--;
+      g_mutex_unlock (&task_pool_mutex);
+    }
+  else
+    {
+      g_mutex_lock (&task_pool_mutex);
+      if (tasks_running >= (guint) g_thread_pool_get_max_threads (task_pool))
+        g_task_thread_pool_arm_manager ();
       g_mutex_unlock (&task_pool_mutex);
     }
 }
@@ -1399,6 +1697,72 @@ g_task_run_in_thread_sync (GTask           *task,
   g_object_unref (task);
 }
 
+/**
+ * g_task_get_thread_pool_stats:
+ * @stats: (out caller-allocates): return location for the stats
+ *
+ * Fills in @stats with the #GThreadPoolStats of the thread pool that
+ * runs the functions passed to g_task_run_in_thread() and
+ * g_task_run_in_thread_sync(), including the times, which are always
+ * measured for it. This tells whether work is backing up in the pool,
+ * see g_thread_pool_get_stats().
+ *
+ * Since: 2.40
+ */
+void
+g_task_get_thread_pool_stats (GThreadPoolStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_type_ensure (G_TYPE_TASK);
+  g_thread_pool_get_stats (task_pool, stats);
+}
+
+/**
+ * g_task_set_thread_pool_size:
+ * @base_size: the number of threads to run tasks with, or 0 for
+ *     the default of 10
+ * @max_size: the number of threads the pool may grow to, or 0 for
+ *     the default of 256
+ * @block_time: how long all threads must have been busy before
+ *     another one is added, in microseconds, or 0 for the default
+ *     of 100 milliseconds
+ *
+ * Tunes the thread pool that runs the functions passed to
+ * g_task_run_in_thread() and g_task_run_in_thread_sync().
+ *
+ * The pool runs up to @base_size tasks at a time. If all of its
+ * threads are busy for @block_time while other tasks are waiting,
+ * they are assumed to be blocked, for instance on disk or network
+ * I/O, and another thread is started. This repeats, a little more
+ * slowly each time, until @max_size threads run. The additional
+ * threads stop once no tasks are waiting anymore.
+ *
+ * g_task_get_thread_pool_stats() shows how the pool copes.
+ *
+ * Since: 2.40
+ */
+void
+g_task_set_thread_pool_size (guint   base_size,
+                             guint   max_size,
+                             guint64 block_time)
+{
+  g_type_ensure (G_TYPE_TASK);
+
+  g_mutex_lock (&task_pool_mutex);
+
+  task_pool_size = base_size ? base_size : G_TASK_POOL_SIZE;
+  task_pool_max_size = max_size ? max_size : G_TASK_POOL_MAX_SIZE;
+  task_pool_max_size = MAX (task_pool_max_size, task_pool_size);
+  task_wait_time_base = block_time ? (gint64) MIN (block_time, G_TASK_WAIT_TIME_MAX) : G_TASK_WAIT_TIME_BASE;
+  task_wait_time = 0;
+  if (task_pool_size + task_pool_extra > task_pool_max_size)
+    task_pool_extra = task_pool_max_size - task_pool_size;
+  g_task_thread_pool_update_limit ();
+
+  g_mutex_unlock (&task_pool_mutex);
+}
+
 /**
  * g_task_attach_source:
  * @task: a #GTask
@@ -1804,10 +2168,18 @@ static void
 g_task_thread_pool_init (void)
 {
   task_pool = g_thread_pool_new (g_task_thread_pool_thread, NULL,
-                                 10, FALSE, NULL);
+                                 G_TASK_POOL_SIZE, FALSE, NULL);
   g_assert (task_pool != NULL);
 
+  g_thread_pool_set_timing_stats (task_pool, TRUE);
   g_thread_pool_set_sort_function (task_pool, g_task_compare_priority, NULL);
+
+  task_pool_manager = g_source_new (&task_pool_manager_funcs, sizeof (GSource));
+  g_source_set_callback (task_pool_manager, task_pool_manager_timeout, NULL, NULL);
+  g_source_set_ready_time (task_pool_manager, -1);
+  g_source_attach (task_pool_manager,
+                   GLIB_PRIVATE_CALL (g_get_worker_context) ());
+  g_source_unref (task_pool_manager);
 }
 
 static void
@@ -1822,6 +2194,8 @@ g_task_class_init (GTaskClass *klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->finalize = g_task_finalize;
+
+  task_trace_buffer_enabled = GLIB_PRIVATE_CALL (g_trace_buffer_enabled) ();
 }
 
 static gpointer
@@ -107,6 +107,12 @@ void          g_task_run_in_thread        (GTask           *task,
 GLIB_AVAILABLE_IN_2_36
 void          g_task_run_in_thread_sync   (GTask           *task,
                                            GTaskThreadFunc  task_func);
+GLIB_AVAILABLE_IN_2_40
+void          g_task_get_thread_pool_stats (GThreadPoolStats *stats);
+GLIB_AVAILABLE_IN_2_40
+void          g_task_set_thread_pool_size  (guint             base_size,
+                                            guint             max_size,
+                                            guint64           block_time);
 GLIB_AVAILABLE_IN_2_36
 gboolean      g_task_set_return_on_cancel (GTask           *task,
                                            gboolean         return_on_cancel);
@@ -34,15 +34,179 @@
 #include "ginetaddress.h"
 #include "ginetsocketaddress.h"
 #include "gtask.h"
+#include "gsocket.h"
 #include "gsocketaddress.h"
 #include "gsrvtarget.h"
 
 
 G_DEFINE_TYPE (GThreadedResolver, g_threaded_resolver, G_TYPE_RESOLVER)
 
+/* Results of getaddrinfo() don't come with a TTL, so successful lookups
+ * are remembered for a fixed time, and lookups of names that don't
+ * exist for a shorter one.  Temporary failures are never cached.  The
+ * cache is flushed whenever resolv.conf changes.
+ */
+#define LOOKUP_CACHE_TTL           30
+#define LOOKUP_CACHE_NEGATIVE_TTL  5
+#define LOOKUP_CACHE_MAX_ENTRIES   256
+
+typedef struct {
+  GList *addresses;
+  GError *error;
+  gint64 expires;
+} CachedLookup;
+
+/* A getaddrinfo() call in progress.  Threads asking for the same name
+ * in the meantime wait for it instead of making their own.  Protected
+ * by lookup_lock.
+ */
+typedef struct {
+  gint ref_count;
+  gboolean done;
+  GList *addresses;
+  GError *error;
+} InFlightLookup;
+
+static void
+cached_lookup_free (gpointer data)
+{
+  CachedLookup *cached = data;
+
+  g_resolver_free_addresses (cached->addresses);
+  if (cached->error)
+    g_error_free (cached->error);
+  g_slice_free (CachedLookup, cached);
+}
+
+static void
+in_flight_lookup_unref (InFlightLookup *in_flight)
+{
+  if (--in_flight->ref_count == 0)
+    {
+      g_resolver_free_addresses (in_flight->addresses);
+      if (in_flight->error)
+        g_error_free (in_flight->error);
+      g_slice_free (InFlightLookup, in_flight);
+    }
+}
+
 static void
 g_threaded_resolver_init (GThreadedResolver *gtr)
 {
+  g_mutex_init (&gtr->lookup_lock);
+  g_cond_init (&gtr->lookup_cond);
+  gtr->lookup_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, cached_lookup_free);
+  gtr->lookups_in_flight = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  g_free, NULL);
+}
+
+static void
+g_threaded_resolver_finalize (GObject *object)
+{
+  GThreadedResolver *gtr = G_THREADED_RESOLVER (object);
+
+  /* Every lookup holds a reference on the resolver while it runs */
+  g_assert (g_hash_table_size (gtr->lookups_in_flight) == 0);
+
+  g_hash_table_unref (gtr->lookup_cache);
+  g_hash_table_unref (gtr->lookups_in_flight);
+  if (gtr->nameservers)
+    g_ptr_array_unref (gtr->nameservers);
+  g_cond_clear (&gtr->lookup_cond);
+  g_mutex_clear (&gtr->lookup_lock);
+
+  G_OBJECT_CLASS (g_threaded_resolver_parent_class)->finalize (object);
+}
+
+static void
+g_threaded_resolver_reload (GResolver *resolver)
+{
+  GThreadedResolver *gtr = G_THREADED_RESOLVER (resolver);
+
+  g_mutex_lock (&gtr->lookup_lock);
+  g_hash_table_remove_all (gtr->lookup_cache);
+  if (gtr->nameservers)
+    {
+      g_ptr_array_unref (gtr->nameservers);
+      gtr->nameservers = NULL;
+    }
+  g_mutex_unlock (&gtr->lookup_lock);
+}
+
+static GList *
+copy_addresses (GList *addresses)
+{
+  return g_list_copy_deep (addresses, (GCopyFunc) g_object_ref, NULL);
+}
+
+/* Must be called with lookup_lock held */
+static void
+cache_lookup_result (GThreadedResolver *gtr,
+                     const gchar       *hostname,
+                     GList             *addresses,
+                     const GError      *error)
+{
+  CachedLookup *cached;
+  gint64 now;
+  gint ttl;
+
+  if (error && !g_error_matches (error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND))
+    return;
+
+  now = g_get_monotonic_time ();
+
+  if (g_hash_table_size (gtr->lookup_cache) >= LOOKUP_CACHE_MAX_ENTRIES)
+    {
+      GHashTableIter iter;
+      gpointer value;
+
+      g_hash_table_iter_init (&iter, gtr->lookup_cache);
+      while (g_hash_table_iter_next (&iter, NULL, &value))
+        if (((CachedLookup *) value)->expires <= now)
+          g_hash_table_iter_remove (&iter);
+
+      if (g_hash_table_size (gtr->lookup_cache) >= LOOKUP_CACHE_MAX_ENTRIES)
+        g_hash_table_remove_all (gtr->lookup_cache);
+    }
+
+  ttl = error ? LOOKUP_CACHE_NEGATIVE_TTL : LOOKUP_CACHE_TTL;
+
+  cached = g_slice_new (CachedLookup);
+  cached->addresses = copy_addresses (addresses);
+  cached->error = error ? g_error_copy (error) : NULL;
+  cached->expires = now + ttl * G_USEC_PER_SEC;
+  g_hash_table_replace (gtr->lookup_cache, g_strdup (hostname), cached);
+}
+
+/* Returns a result for @hostname from the cache, if there is a current
+ * one, in the same form as the lookup_by_name() vfunc.
+ */
+static gboolean
+lookup_cached (GThreadedResolver  *gtr,
+               const gchar        *hostname,
+               GList             **addresses,
+               GError            **error)
+{
+  CachedLookup *cached;
+  gboolean found = FALSE;
+
+  g_mutex_lock (&gtr->lookup_lock);
+
+  cached = g_hash_table_lookup (gtr->lookup_cache, hostname);
+  if (cached && cached->expires > g_get_monotonic_time ())
+    {
+      *addresses = copy_addresses (cached->addresses);
+      if (cached->error)
+        g_propagate_error (error, g_error_copy (cached->error));
+      found = TRUE;
+    }
+  else if (cached)
+    g_hash_table_remove (gtr->lookup_cache, hostname);
+
+  g_mutex_unlock (&gtr->lookup_lock);
+
+  return found;
 }
 
 static GResolverError
@@ -67,15 +231,12 @@ g_resolver_error_from_addrinfo_error (gint err)
 
 static struct addrinfo addrinfo_hints;
 
-static void
-do_lookup_by_name (GTask         *task,
-                   gpointer       source_object,
-                   gpointer       task_data,
-                   GCancellable  *cancellable)
+static GList *
+resolve_name (const gchar  *hostname,
+              GError      **error)
 {
-  const char *hostname = task_data;
   struct addrinfo *res = NULL;
-  GList *addresses;
+  GList *addresses = NULL;
   gint retval;
 
   retval = getaddrinfo (hostname, NULL, &addrinfo_hints, &res);
@@ -86,7 +247,6 @@ do_lookup_by_name (GTask         *task,
       GSocketAddress *sockaddr;
       GInetAddress *addr;
 
-      addresses = NULL;
       for (ai = res; ai; ai = ai->ai_next)
         {
           sockaddr = g_socket_address_new_from_native (ai->ai_addr, ai->ai_addrlen);
@@ -99,20 +259,75 @@ do_lookup_by_name (GTask         *task,
         }
 
       addresses = g_list_reverse (addresses);
-      g_task_return_pointer (task, addresses,
-                             (GDestroyNotify)g_resolver_free_addresses);
     }
   else
     {
-      g_task_return_new_error (task,
-                               G_RESOLVER_ERROR,
-                               g_resolver_error_from_addrinfo_error (retval),
-                               _("Error resolving '%s': %s"),
-                               hostname, gai_strerror (retval));
+      g_set_error (error,
+                   G_RESOLVER_ERROR,
+                   g_resolver_error_from_addrinfo_error (retval),
+                   _("Error resolving '%s': %s"),
+                   hostname, gai_strerror (retval));
     }
 
   if (res)
     freeaddrinfo (res);
+
+  return addresses;
+}
+
+static void
+do_lookup_by_name (GTask         *task,
+                   gpointer       source_object,
+                   gpointer       task_data,
+                   GCancellable  *cancellable)
+{
+  GThreadedResolver *gtr = source_object;
+  const char *hostname = task_data;
+  InFlightLookup *in_flight;
+  GList *addresses = NULL;
+  GError *error = NULL;
+
+  if (!lookup_cached (gtr, hostname, &addresses, &error))
+    {
+      g_mutex_lock (&gtr->lookup_lock);
+
+      in_flight = g_hash_table_lookup (gtr->lookups_in_flight, hostname);
+
+      if (in_flight)
+        {
+          in_flight->ref_count++;
+          while (!in_flight->done)
+            g_cond_wait (&gtr->lookup_cond, &gtr->lookup_lock);
+        }
+      else
+        {
+          in_flight = g_slice_new0 (InFlightLookup);
+          in_flight->ref_count = 1;
+          g_hash_table_insert (gtr->lookups_in_flight, g_strdup (hostname), in_flight);
+          g_mutex_unlock (&gtr->lookup_lock);
+
+          in_flight->addresses = resolve_name (hostname, &in_flight->error);
+
+          g_mutex_lock (&gtr->lookup_lock);
+          in_flight->done = TRUE;
+          g_hash_table_remove (gtr->lookups_in_flight, hostname);
+          cache_lookup_result (gtr, hostname, in_flight->addresses, in_flight->error);
+          g_cond_broadcast (&gtr->lookup_cond);
+        }
+
+      addresses = copy_addresses (in_flight->addresses);
+      if (in_flight->error)
+        error = g_error_copy (in_flight->error);
+      in_flight_lookup_unref (in_flight);
+
+      g_mutex_unlock (&gtr->lookup_lock);
+    }
+
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_pointer (task, addresses,
+                           (GDestroyNotify)g_resolver_free_addresses);
 }
 
 static GList *
@@ -122,7 +337,11 @@ lookup_by_name (GResolver     *resolver,
                 GError       **error)
 {
   GTask *task;
-  GList *addresses;
+  GList *addresses = NULL;
+
+  /* Avoid the thread dispatch if we already know the answer */
+  if (lookup_cached (G_THREADED_RESOLVER (resolver), hostname, &addresses, error))
+    return addresses;
 
   task = g_task_new (resolver, cancellable, NULL, NULL);
   g_task_set_task_data (task, g_strdup (hostname), g_free);
@@ -142,8 +361,22 @@ lookup_by_name_async (GResolver           *resolver,
                       gpointer             user_data)
 {
   GTask *task;
+  GList *addresses = NULL;
+  GError *error = NULL;
 
   task = g_task_new (resolver, cancellable, callback, user_data);
+
+  if (lookup_cached (G_THREADED_RESOLVER (resolver), hostname, &addresses, &error))
+    {
+      if (error)
+        g_task_return_error (task, error);
+      else
+        g_task_return_pointer (task, addresses,
+                               (GDestroyNotify)g_resolver_free_addresses);
+      g_object_unref (task);
+      return;
+    }
+
   g_task_set_task_data (task, g_strdup (hostname), g_free);
   g_task_set_return_on_cancel (task, TRUE);
   g_task_run_in_thread (task, do_lookup_by_name);
@@ -803,6 +1036,512 @@ int res_query(const char *, int, int, u_char *, int);
 #endif
 #endif
 
+#if defined(G_OS_UNIX)
+
+static void do_lookup_records (GTask         *task,
+                               gpointer       source_object,
+                               gpointer       task_data,
+                               GCancellable  *cancellable);
+
+/* Asynchronous record lookups talk to the name servers directly, over
+ * UDP sockets watched from the task's main context, so that they don't
+ * need a thread each.  Anything out of the ordinary (a truncated reply
+ * that needs TCP, a name we can't encode) is handed over to
+ * res_query() in a thread as before.
+ */
+
+#define DNS_HEADER_SIZE  12
+#define DNS_MAX_QUERY    512
+#define DNS_MAX_PACKET   4096
+
+/* More than this many queries at once and we mostly measure how many
+ * packets the name server drops; the rest wait for their turn.
+ */
+#define DNS_MAX_RUNNING  64
+
+/* Reads the name servers and options from resolv.conf, using the same
+ * defaults as the libc resolver.  Must be called with lookup_lock held.
+ */
+static void
+load_dns_config (GThreadedResolver *gtr)
+{
+  gchar *contents;
+  gchar **lines;
+  gint i;
+
+  gtr->nameservers = g_ptr_array_new_with_free_func (g_object_unref);
+  gtr->dns_timeout = 5;
+  gtr->dns_attempts = 2;
+
+  if (g_file_get_contents (_PATH_RESCONF, &contents, NULL, NULL))
+    {
+      lines = g_strsplit (contents, "\n", -1);
+      g_free (contents);
+
+      for (i = 0; lines[i]; i++)
+        {
+          gchar **words;
+
+          words = g_strsplit_set (lines[i], " \t", -1);
+
+          if (words[0] && g_str_equal (words[0], "nameserver") && words[1] != NULL)
+            {
+              GInetAddress *address;
+
+              /* zone ids are not supported by g_inet_address_new_from_string() */
+              if (strchr (words[1], '%'))
+                *strchr (words[1], '%') = '\0';
+
+              address = g_inet_address_new_from_string (words[1]);
+              if (address)
+                {
+                  g_ptr_array_add (gtr->nameservers, g_inet_socket_address_new (address, 53));
+                  g_object_unref (address);
+                }
+            }
+          else if (words[0] && g_str_equal (words[0], "options"))
+            {
+              gint j;
+
+              for (j = 1; words[j]; j++)
+                {
+                  if (g_str_has_prefix (words[j], "timeout:"))
+                    gtr->dns_timeout = CLAMP (g_ascii_strtoull (words[j] + 8, NULL, 10), 1, 30);
+                  else if (g_str_has_prefix (words[j], "attempts:"))
+                    gtr->dns_attempts = CLAMP (g_ascii_strtoull (words[j] + 9, NULL, 10), 1, 5);
+                }
+            }
+
+          g_strfreev (words);
+        }
+
+      g_strfreev (lines);
+    }
+
+  if (gtr->nameservers->len == 0)
+    {
+      GInetAddress *loopback;
+
+      loopback = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+      g_ptr_array_add (gtr->nameservers, g_inet_socket_address_new (loopback, 53));
+      g_object_unref (loopback);
+    }
+}
+
+typedef struct {
+  GTask *task;
+  gint rrtype;
+
+  guchar packet[DNS_MAX_QUERY];
+  gsize packet_len;
+
+  GPtrArray *nameservers;
+  guint timeout;
+  guint attempts;
+
+  guint server;
+  guint attempt;
+  gboolean server_failure;
+
+  GSocket *socket;
+  GSource *read_source;
+  GSource *timeout_source;
+
+  /* only while on dns_queries_waiting */
+  GSource *cancel_source;
+} DnsQuery;
+
+static void
+dns_query_stop_waiting (DnsQuery *query)
+{
+  if (query->read_source)
+    {
+      g_source_destroy (query->read_source);
+      g_source_unref (query->read_source);
+      query->read_source = NULL;
+    }
+
+  if (query->timeout_source)
+    {
+      g_source_destroy (query->timeout_source);
+      g_source_unref (query->timeout_source);
+      query->timeout_source = NULL;
+    }
+
+  g_clear_object (&query->socket);
+}
+
+static void dns_query_send (DnsQuery *query);
+
+static void
+dns_query_destroy (DnsQuery *query)
+{
+  dns_query_stop_waiting (query);
+
+  if (query->cancel_source)
+    {
+      g_source_destroy (query->cancel_source);
+      g_source_unref (query->cancel_source);
+    }
+
+  g_ptr_array_unref (query->nameservers);
+  g_object_unref (query->task);
+  g_slice_free (DnsQuery, query);
+}
+
+/* Frees a running query and hands its place over to the next waiting
+ * one, skipping any that were cancelled while they waited.
+ */
+static void
+dns_query_free (DnsQuery *query)
+{
+  GThreadedResolver *gtr = g_task_get_source_object (query->task);
+  DnsQuery *next;
+
+  dns_query_destroy (query);
+
+  for (;;)
+    {
+      g_mutex_lock (&gtr->lookup_lock);
+      next = g_queue_pop_head (&gtr->dns_queries_waiting);
+      if (next == NULL)
+        gtr->dns_queries_running--;
+      g_mutex_unlock (&gtr->lookup_lock);
+
+      if (next == NULL)
+        break;
+
+      if (next->cancel_source)
+        {
+          g_source_destroy (next->cancel_source);
+          g_source_unref (next->cancel_source);
+          next->cancel_source = NULL;
+        }
+
+      if (!g_task_return_error_if_cancelled (next->task))
+        {
+          dns_query_send (next);
+          break;
+        }
+
+      dns_query_destroy (next);
+    }
+}
+
+static gint
+dns_query_has_task (gconstpointer query,
+                    gconstpointer task)
+{
+  return ((const DnsQuery *) query)->task == task ? 0 : 1;
+}
+
+/* The task's cancellable fired while its query was still waiting for
+ * a turn.  The source holds a reference on the task rather than on the
+ * query, which may already have been dequeued and freed by now.
+ */
+static gboolean
+dns_query_cancelled_while_waiting (GCancellable *cancellable,
+                                   gpointer      user_data)
+{
+  GTask *task = user_data;
+  GThreadedResolver *gtr = g_task_get_source_object (task);
+  DnsQuery *query = NULL;
+  GList *link;
+
+  g_mutex_lock (&gtr->lookup_lock);
+  link = g_queue_find_custom (&gtr->dns_queries_waiting, task, dns_query_has_task);
+  if (link)
+    {
+      query = link->data;
+      g_queue_delete_link (&gtr->dns_queries_waiting, link);
+    }
+  g_mutex_unlock (&gtr->lookup_lock);
+
+  if (query)
+    {
+      g_task_return_error_if_cancelled (task);
+      dns_query_destroy (query);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+dns_query_finish (DnsQuery *query,
+                  guchar   *answer,
+                  gint      len,
+                  gint      herr)
+{
+  LookupRecordsData *lrd = g_task_get_task_data (query->task);
+  GError *error = NULL;
+  GList *records;
+
+  records = g_resolver_records_from_res_query (lrd->rrname, query->rrtype, answer, len, herr, &error);
+
+  if (records)
+    g_task_return_pointer (query->task, records, (GDestroyNotify) free_records);
+  else
+    g_task_return_error (query->task, error);
+
+  dns_query_free (query);
+}
+
+static void
+dns_query_try_next_server (DnsQuery *query)
+{
+  dns_query_stop_waiting (query);
+
+  if (++query->server == query->nameservers->len)
+    {
+      query->server = 0;
+      query->attempt++;
+    }
+
+  dns_query_send (query);
+}
+
+static gboolean
+dns_query_timed_out (gpointer user_data)
+{
+  dns_query_try_next_server (user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Checks that @answer is a reply to our question */
+static gboolean
+dns_query_matches (DnsQuery *query,
+                   guchar   *answer,
+                   gsize     len)
+{
+  gsize i;
+
+  if (len < query->packet_len)
+    return FALSE;
+
+  /* same id, and the "response" bit is set */
+  if (answer[0] != query->packet[0] || answer[1] != query->packet[1] || !(answer[2] & 0x80))
+    return FALSE;
+
+  /* one question, the same as ours */
+  if (answer[4] != 0 || answer[5] != 1)
+    return FALSE;
+
+  for (i = DNS_HEADER_SIZE; i < query->packet_len; i++)
+    if (g_ascii_tolower (answer[i]) != g_ascii_tolower (query->packet[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+dns_query_readable (GSocket      *socket,
+                    GIOCondition  condition,
+                    gpointer      user_data)
+{
+  DnsQuery *query = user_data;
+  guchar answer[DNS_MAX_PACKET];
+  gssize len;
+  guint rcode;
+
+  if (g_task_return_error_if_cancelled (query->task))
+    {
+      dns_query_free (query);
+      return G_SOURCE_REMOVE;
+    }
+
+  len = g_socket_receive (socket, (gchar *) answer, sizeof answer, NULL, NULL);
+
+  if (len < 0)
+    {
+      /* eg: ICMP port unreachable */
+      dns_query_try_next_server (query);
+      return G_SOURCE_REMOVE;
+    }
+
+  if (!dns_query_matches (query, answer, len))
+    return G_SOURCE_CONTINUE;
+
+  /* truncated: needs TCP, which res_query() knows how to do */
+  if (answer[2] & 0x02)
+    {
+      GTask *task = g_object_ref (query->task);
+
+      dns_query_free (query);
+      g_task_run_in_thread (task, do_lookup_records);
+      g_object_unref (task);
+
+      return G_SOURCE_REMOVE;
+    }
+
+  rcode = answer[3] & 0x0f;
+
+  if (rcode == 0)
+    dns_query_finish (query, answer, len, 0);
+  else if (rcode == 3)
+    dns_query_finish (query, NULL, -1, HOST_NOT_FOUND);
+  else
+    {
+      /* SERVFAIL, REFUSED, ...: ask someone else */
+      query->server_failure = TRUE;
+      dns_query_try_next_server (query);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+dns_query_send (DnsQuery *query)
+{
+  GMainContext *context;
+
+  context = g_task_get_context (query->task);
+
+  while (query->attempt < query->attempts)
+    {
+      GSocketAddress *server;
+
+      server = query->nameservers->pdata[query->server];
+      query->socket = g_socket_new (g_socket_address_get_family (server),
+                                    G_SOCKET_TYPE_DATAGRAM,
+                                    G_SOCKET_PROTOCOL_UDP, NULL);
+
+      /* connecting means we only hear back from the server we asked */
+      if (query->socket &&
+          g_socket_connect (query->socket, server, NULL, NULL) &&
+          g_socket_send (query->socket, (gchar *) query->packet, query->packet_len, NULL, NULL) > 0)
+        {
+          g_socket_set_blocking (query->socket, FALSE);
+
+          query->read_source = g_socket_create_source (query->socket, G_IO_IN,
+                                                       g_task_get_cancellable (query->task));
+          g_source_set_callback (query->read_source, (GSourceFunc) dns_query_readable, query, NULL);
+          g_source_attach (query->read_source, context);
+
+          query->timeout_source = g_timeout_source_new_seconds (query->timeout);
+          g_source_set_callback (query->timeout_source, dns_query_timed_out, query, NULL);
+          g_source_attach (query->timeout_source, context);
+
+          return;
+        }
+
+      g_clear_object (&query->socket);
+
+      if (++query->server == query->nameservers->len)
+        {
+          query->server = 0;
+          query->attempt++;
+        }
+    }
+
+  /* nobody answered, or only with errors */
+  dns_query_finish (query, NULL, -1, TRY_AGAIN);
+}
+
+/* Encodes a query for @rrname into @packet.  Returns the length, or 0
+ * if @rrname is not something we can put on the wire.
+ */
+static gsize
+dns_query_encode (guchar      *packet,
+                  const gchar *rrname,
+                  gint         rrtype)
+{
+  guint32 id;
+  gsize len;
+
+  id = g_random_int ();
+  memset (packet, 0, DNS_HEADER_SIZE);
+  packet[0] = id >> 8;
+  packet[1] = id;
+  packet[2] = 0x01;   /* recursion desired */
+  packet[5] = 1;      /* one question */
+  len = DNS_HEADER_SIZE;
+
+  while (*rrname)
+    {
+      const gchar *dot;
+      gsize label;
+
+      dot = strchr (rrname, '.');
+      label = dot ? dot - rrname : strlen (rrname);
+
+      if (label == 0 || label > 63 || len + 1 + label > DNS_HEADER_SIZE + 254)
+        return 0;
+
+      packet[len++] = label;
+      memcpy (packet + len, rrname, label);
+      len += label;
+
+      rrname += label;
+      if (*rrname == '.')
+        rrname++;
+    }
+
+  if (len == DNS_HEADER_SIZE)
+    return 0;
+
+  packet[len++] = 0;
+  packet[len++] = rrtype >> 8;
+  packet[len++] = rrtype;
+  packet[len++] = 0;
+  packet[len++] = C_IN;
+
+  return len;
+}
+
+static gboolean
+dns_query_start (GThreadedResolver *gtr,
+                 GTask             *task,
+                 LookupRecordsData *lrd)
+{
+  DnsQuery *query;
+
+  query = g_slice_new0 (DnsQuery);
+  query->rrtype = g_resolver_record_type_to_rrtype (lrd->record_type);
+  query->packet_len = dns_query_encode (query->packet, lrd->rrname, query->rrtype);
+
+  if (query->packet_len == 0)
+    {
+      g_slice_free (DnsQuery, query);
+      return FALSE;
+    }
+
+  g_mutex_lock (&gtr->lookup_lock);
+  if (gtr->nameservers == NULL)
+    load_dns_config (gtr);
+  query->nameservers = g_ptr_array_ref (gtr->nameservers);
+  query->timeout = gtr->dns_timeout;
+  query->attempts = gtr->dns_attempts;
+  query->task = g_object_ref (task);
+
+  if (gtr->dns_queries_running == DNS_MAX_RUNNING)
+    {
+      GCancellable *cancellable = g_task_get_cancellable (task);
+
+      if (cancellable)
+        {
+          query->cancel_source = g_cancellable_source_new (cancellable);
+          g_source_set_callback (query->cancel_source,
+                                 (GSourceFunc) dns_query_cancelled_while_waiting,
+                                 g_object_ref (task), g_object_unref);
+          g_source_attach (query->cancel_source, g_task_get_context (task));
+        }
+
+      g_queue_push_tail (&gtr->dns_queries_waiting, query);
+      query = NULL;
+    }
+  else
+    gtr->dns_queries_running++;
+  g_mutex_unlock (&gtr->lookup_lock);
+
+  if (query)
+    dns_query_send (query);
+
+  return TRUE;
+}
+
+#endif /* G_OS_UNIX */
+
 static void
 do_lookup_records (GTask         *task,
                    gpointer       source_object,
@@ -905,7 +1644,12 @@ lookup_records_async (GResolver           *resolver,
   g_task_set_task_data (task, lrd, (GDestroyNotify) free_lookup_records_data);
 
   g_task_set_return_on_cancel (task, TRUE);
-  g_task_run_in_thread (task, do_lookup_records);
+
+#if defined(G_OS_UNIX)
+  if (!dns_query_start (G_THREADED_RESOLVER (resolver), task, lrd))
+#endif
+    g_task_run_in_thread (task, do_lookup_records);
+
   g_object_unref (task);
 }
 
@@ -923,8 +1667,12 @@ lookup_records_finish (GResolver     *resolver,
 static void
 g_threaded_resolver_class_init (GThreadedResolverClass *threaded_class)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (threaded_class);
   GResolverClass *resolver_class = G_RESOLVER_CLASS (threaded_class);
 
+  object_class->finalize = g_threaded_resolver_finalize;
+
+  resolver_class->reload                   = g_threaded_resolver_reload;
   resolver_class->lookup_by_name           = lookup_by_name;
   resolver_class->lookup_by_name_async     = lookup_by_name_async;
   resolver_class->lookup_by_name_finish    = lookup_by_name_finish;
@@ -36,6 +36,17 @@ typedef struct {
   GResolver parent_instance;
 
   GThreadPool *thread_pool;
+
+  GMutex lookup_lock;
+  GCond lookup_cond;
+  GHashTable *lookup_cache;
+  GHashTable *lookups_in_flight;
+
+  GPtrArray *nameservers;
+  guint dns_timeout;
+  guint dns_attempts;
+  guint dns_queries_running;
+  GQueue dns_queries_waiting;
 } GThreadedResolver;
 
 typedef struct {
@@ -43,6 +43,17 @@
  *
  * As with #GSocketService, you may connect to #GThreadedSocketService::run,
  * or subclass and override the default handler.
+ *
+ * Since each connection keeps a thread busy, this works badly for a
+ * large number of connections which are idle most of the time. A
+ * service created with g_threaded_socket_service_new_with_workers()
+ * instead runs a fixed number of worker threads, each with a
+ * #GMainContext of its own, and spreads the connections over them.
+ * Rather than #GThreadedSocketService::run, it emits
+ * #GThreadedSocketService::readable in the worker thread of a
+ * connection every time it has something to read. The handler should
+ * deal with what is there without blocking and then return, so that
+ * the other connections of the worker can be served.
  */
 
 #include "config.h"
@@ -50,14 +61,26 @@
 #include "gthreadedsocketservice.h"
 #include "glibintl.h"
 
+typedef struct
+{
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+  gint n_connections;
+} GThreadedSocketServiceWorker;
+
 struct _GThreadedSocketServicePrivate
 {
   GThreadPool *thread_pool;
   int max_threads;
   gint job_count;
+
+  guint n_workers;
+  GThreadedSocketServiceWorker **workers;
 };
 
 static guint g_threaded_socket_service_run_signal;
+static guint g_threaded_socket_service_readable_signal;
 
 G_DEFINE_TYPE_WITH_PRIVATE (GThreadedSocketService,
                             g_threaded_socket_service,
@@ -66,7 +89,8 @@ G_DEFINE_TYPE_WITH_PRIVATE (GThreadedSocketService,
 enum
 {
   PROP_0,
-  PROP_MAX_THREADS
+  PROP_MAX_THREADS,
+  PROP_N_WORKERS
 };
 
 G_LOCK_DEFINE_STATIC(job_count);
@@ -101,6 +125,122 @@ g_threaded_socket_service_func (gpointer _data,
   G_UNLOCK (job_count);
 }
 
+typedef struct
+{
+  GThreadedSocketService *service;
+  GThreadedSocketServiceWorker *worker;
+  GSocketConnection *connection;
+  GObject *source_object;
+} GThreadedSocketServiceWatch;
+
+static gboolean
+worker_readable (GSocket      *socket,
+                 GIOCondition  condition,
+                 gpointer      user_data)
+{
+  GThreadedSocketServiceWatch *watch = user_data;
+  gboolean result;
+
+  g_signal_emit (watch->service, g_threaded_socket_service_readable_signal,
+                 0, watch->connection, watch->source_object, &result);
+
+  return result ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static void
+worker_watch_free (gpointer user_data)
+{
+  GThreadedSocketServiceWatch *watch = user_data;
+
+  g_atomic_int_add (&watch->worker->n_connections, -1);
+
+  /* may finalize the service, in this very worker */
+  g_object_unref (watch->service);
+  g_object_unref (watch->connection);
+  if (watch->source_object)
+    g_object_unref (watch->source_object);
+  g_slice_free (GThreadedSocketServiceWatch, watch);
+}
+
+static gpointer
+worker_thread (gpointer user_data)
+{
+  GThreadedSocketServiceWorker *worker = user_data;
+
+  g_main_context_push_thread_default (worker->context);
+  g_main_loop_run (worker->loop);
+  g_main_context_pop_thread_default (worker->context);
+
+  g_main_loop_unref (worker->loop);
+  g_main_context_unref (worker->context);
+  g_slice_free (GThreadedSocketServiceWorker, worker);
+
+  return NULL;
+}
+
+static gboolean
+worker_quit (gpointer user_data)
+{
+  GThreadedSocketServiceWorker *worker = user_data;
+
+  g_main_loop_quit (worker->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+worker_stop (GThreadedSocketServiceWorker *worker)
+{
+  GThread *thread = worker->thread;
+  GSource *source;
+
+  /* the loop might not be running yet, so quit from inside of it */
+  source = g_idle_source_new ();
+  g_source_set_callback (source, worker_quit, worker, NULL);
+  g_source_attach (source, worker->context);
+  g_source_unref (source);
+
+  if (thread == g_thread_self ())
+    g_thread_unref (thread);
+  else
+    g_thread_join (thread);
+}
+
+static void
+g_threaded_socket_service_watch (GThreadedSocketService *threaded,
+                                 GSocketConnection      *connection,
+                                 GObject                *source_object)
+{
+  GThreadedSocketServiceWorker *worker;
+  GThreadedSocketServiceWatch *watch;
+  GSource *source;
+  guint i;
+
+  /* the least busy one */
+  worker = threaded->priv->workers[0];
+  for (i = 1; i < threaded->priv->n_workers; i++)
+    if (g_atomic_int_get (&threaded->priv->workers[i]->n_connections) <
+        g_atomic_int_get (&worker->n_connections))
+      worker = threaded->priv->workers[i];
+  g_atomic_int_inc (&worker->n_connections);
+
+  watch = g_slice_new (GThreadedSocketServiceWatch);
+  watch->service = g_object_ref (threaded);
+  watch->worker = worker;
+  watch->connection = g_object_ref (connection);
+  if (source_object)
+    watch->source_object = g_object_ref (source_object);
+  else
+    watch->source_object = NULL;
+
+  source = g_socket_create_source (g_socket_connection_get_socket (connection),
+                                   G_IO_IN, NULL);
+  g_source_set_callback (source, (GSourceFunc) worker_readable,
+                         watch, worker_watch_free);
+  g_source_attach (source, worker->context);
+  g_source_unref (source);
+}
+
 static gboolean
 g_threaded_socket_service_incoming (GSocketService    *service,
                                     GSocketConnection *connection,
@@ -111,6 +251,12 @@ g_threaded_socket_service_incoming (GSocketService    *service,
 
   threaded = G_THREADED_SOCKET_SERVICE (service);
 
+  if (threaded->priv->n_workers > 0)
+    {
+      g_threaded_socket_service_watch (threaded, connection, source_object);
+      return FALSE;
+    }
+
   data = g_slice_new (GThreadedSocketServiceData);
   data->service = g_object_ref (service);
   data->connection = g_object_ref (connection);
@@ -142,6 +288,26 @@ static void
 g_threaded_socket_service_constructed (GObject *object)
 {
   GThreadedSocketService *service = G_THREADED_SOCKET_SERVICE (object);
+  guint i;
+
+  if (service->priv->n_workers > 0)
+    {
+      service->priv->workers = g_new (GThreadedSocketServiceWorker *,
+                                      service->priv->n_workers);
+      for (i = 0; i < service->priv->n_workers; i++)
+        {
+          GThreadedSocketServiceWorker *worker;
+
+          worker = g_slice_new (GThreadedSocketServiceWorker);
+          worker->context = g_main_context_new ();
+          worker->loop = g_main_loop_new (worker->context, FALSE);
+          worker->n_connections = 0;
+          worker->thread = g_thread_new ("gthreadedsocketservice",
+                                         worker_thread, worker);
+          service->priv->workers[i] = worker;
+        }
+      return;
+    }
 
   service->priv->thread_pool =
     g_thread_pool_new  (g_threaded_socket_service_func,
@@ -156,8 +322,14 @@ static void
 g_threaded_socket_service_finalize (GObject *object)
 {
   GThreadedSocketService *service = G_THREADED_SOCKET_SERVICE (object);
+  guint i;
 
-  g_thread_pool_free (service->priv->thread_pool, FALSE, TRUE);
+  if (service->priv->thread_pool)
+    g_thread_pool_free (service->priv->thread_pool, FALSE, TRUE);
+
+  for (i = 0; i < service->priv->n_workers; i++)
+    worker_stop (service->priv->workers[i]);
+  g_free (service->priv->workers);
 
   G_OBJECT_CLASS (g_threaded_socket_service_parent_class)
     ->finalize (object);
@@ -177,6 +349,10 @@ g_threaded_socket_service_get_property (GObject    *object,
 	g_value_set_int (value, service->priv->max_threads);
 	break;
 
+      case PROP_N_WORKERS:
+	g_value_set_uint (value, service->priv->n_workers);
+	break;
+
       default:
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -196,6 +372,10 @@ g_threaded_socket_service_set_property (GObject      *object,
 	service->priv->max_threads = g_value_get_int (value);
 	break;
 
+      case PROP_N_WORKERS:
+	service->priv->n_workers = g_value_get_uint (value);
+	break;
+
       default:
 	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -235,6 +415,36 @@ g_threaded_socket_service_class_init (GThreadedSocketServiceClass *class)
 		  NULL, G_TYPE_BOOLEAN,
 		  2, G_TYPE_SOCKET_CONNECTION, G_TYPE_OBJECT);
 
+  /**
+   * GThreadedSocketService::readable:
+   * @service: the #GThreadedSocketService.
+   * @connection: a #GSocketConnection with data to read.
+   * @source_object: the source_object passed to g_socket_listener_add_address().
+   *
+   * The ::readable signal is emitted by services created with
+   * g_threaded_socket_service_new_with_workers() instead of
+   * #GThreadedSocketService::run. It is emitted in the worker thread
+   * of @connection whenever there is something to read from it, or
+   * when it was closed by the other side.
+   *
+   * The thread is shared with other connections, so the handler
+   * should not block. The #GMainContext of the worker is the
+   * thread-default context during the emission, so asynchronous
+   * operations started by the handler are run in the worker as well.
+   *
+   * Returns: %TRUE if the service should keep on watching @connection,
+   *     %FALSE to drop its reference on @connection. This also stops
+   *     further signal handlers from being called.
+   *
+   * Since: 2.40
+   */
+  g_threaded_socket_service_readable_signal =
+    g_signal_new ("readable", G_TYPE_FROM_CLASS (class), G_SIGNAL_RUN_LAST,
+		  G_STRUCT_OFFSET (GThreadedSocketServiceClass, readable),
+		  g_signal_accumulator_true_handled, NULL,
+		  NULL, G_TYPE_BOOLEAN,
+		  2, G_TYPE_SOCKET_CONNECTION, G_TYPE_OBJECT);
+
   g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
 				   g_param_spec_int ("max-threads",
 						     P_("Max threads"),
@@ -243,6 +453,24 @@ g_threaded_socket_service_class_init (GThreadedSocketServiceClass *class)
 						     G_MAXINT,
 						     10,
 						     G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GThreadedSocketService:n-workers:
+   *
+   * The number of worker threads that the connections are spread
+   * over, or 0 to handle each connection in a thread of its own.
+   * See g_threaded_socket_service_new_with_workers().
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class, PROP_N_WORKERS,
+				   g_param_spec_uint ("n-workers",
+						      P_("Number of workers"),
+						      P_("The number of threads multiplexing the clients of this service"),
+						      0,
+						      G_MAXUINT,
+						      0,
+						      G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 /**
@@ -264,3 +492,31 @@ g_threaded_socket_service_new (int max_threads)
 		       "max-threads", max_threads,
 		       NULL);
 }
+
+/**
+ * g_threaded_socket_service_new_with_workers:
+ * @n_workers: the number of worker threads, at least 1
+ *
+ * Creates a new #GThreadedSocketService with no listeners, which
+ * spreads its connections over @n_workers threads, each running a
+ * #GMainContext of its own. Connections are handled in
+ * #GThreadedSocketService::readable rather than in
+ * #GThreadedSocketService::run, and the number of connections is not
+ * limited by the number of threads.
+ *
+ * Listeners must be added with one of the #GSocketListener "add"
+ * methods.
+ *
+ * Returns: a new #GSocketService.
+ *
+ * Since: 2.40
+ */
+GSocketService *
+g_threaded_socket_service_new_with_workers (guint n_workers)
+{
+  g_return_val_if_fail (n_workers > 0, NULL);
+
+  return g_object_new (G_TYPE_THREADED_SOCKET_SERVICE,
+		       "n-workers", n_workers,
+		       NULL);
+}
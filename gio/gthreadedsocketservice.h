@@ -58,9 +58,11 @@ struct _GThreadedSocketServiceClass
   gboolean (* run) (GThreadedSocketService *service,
                     GSocketConnection      *connection,
                     GObject                *source_object);
+  gboolean (* readable) (GThreadedSocketService *service,
+                         GSocketConnection      *connection,
+                         GObject                *source_object);
 
   /* Padding for future expansion */
-  void (*_g_reserved1) (void);
   void (*_g_reserved2) (void);
   void (*_g_reserved3) (void);
   void (*_g_reserved4) (void);
@@ -77,6 +79,8 @@ GLIB_AVAILABLE_IN_ALL
 GType                   g_threaded_socket_service_get_type              (void);
 GLIB_AVAILABLE_IN_ALL
 GSocketService *        g_threaded_socket_service_new                   (int max_threads);
+GLIB_AVAILABLE_IN_2_40
+GSocketService *        g_threaded_socket_service_new_with_workers      (guint n_workers);
 
 G_END_DECLS
 
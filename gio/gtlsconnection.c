@@ -30,6 +30,8 @@
 #include "gtlsclientconnection.h"
 #include "gtlsdatabase.h"
 #include "gtlsinteraction.h"
+#include "gsocketconnection.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 /**
@@ -822,6 +824,91 @@ g_tls_connection_handshake_finish (GTlsConnection  *conn,
   return G_TLS_CONNECTION_GET_CLASS (conn)->handshake_finish (conn, result, error);
 }
 
+/**
+ * g_tls_connection_enable_kernel_offload:
+ * @conn: a #GTlsConnection
+ * @error: a #GError, or %NULL
+ *
+ * Asks the TLS backend to hand the record layer of @conn over to the
+ * operating system kernel, where that is supported (such as with
+ * kernel TLS on Linux). Afterwards, data written to the underlying
+ * #GSocket is encrypted by the kernel, so copying a file to @conn's
+ * output stream with g_output_stream_splice() can send it straight
+ * from the page cache to the socket without passing through the
+ * application.
+ *
+ * This must be called after the handshake has completed, while no
+ * I/O is pending on @conn, and only works if the
+ * #GTlsConnection:base-io-stream of @conn is a #GSocketConnection.
+ * If the backend or the kernel cannot offload this connection, an
+ * error is returned and @conn keeps working as before, so failing
+ * here is not a reason to give up on the connection.
+ *
+ * Returns: %TRUE if the record layer is now handled by the kernel
+ *
+ * Since: 2.40
+ */
+gboolean
+g_tls_connection_enable_kernel_offload (GTlsConnection  *conn,
+					GError         **error)
+{
+  GTlsConnectionClass *klass;
+  GIOStream *base_io_stream;
+  GSocket *socket;
+  gboolean ret;
+
+  g_return_val_if_fail (G_IS_TLS_CONNECTION (conn), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (g_tls_connection_get_kernel_offload (conn))
+    return TRUE;
+
+  klass = G_TLS_CONNECTION_GET_CLASS (conn);
+  if (klass->enable_kernel_offload == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			   _("The TLS backend does not support kernel offload"));
+      return FALSE;
+    }
+
+  g_object_get (conn, "base-io-stream", &base_io_stream, NULL);
+  if (!G_IS_SOCKET_CONNECTION (base_io_stream))
+    {
+      g_clear_object (&base_io_stream);
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			   _("Kernel offload needs a TLS connection over a socket"));
+      return FALSE;
+    }
+
+  socket = g_socket_connection_get_socket (G_SOCKET_CONNECTION (base_io_stream));
+  ret = klass->enable_kernel_offload (conn, socket, error);
+  if (ret)
+    g_output_stream_set_kernel_socket (g_io_stream_get_output_stream (G_IO_STREAM (conn)),
+				       socket);
+  g_object_unref (base_io_stream);
+
+  return ret;
+}
+
+/**
+ * g_tls_connection_get_kernel_offload:
+ * @conn: a #GTlsConnection
+ *
+ * Gets whether the record layer of @conn has been handed to the
+ * kernel with g_tls_connection_enable_kernel_offload().
+ *
+ * Returns: %TRUE if the kernel encrypts the data written to @conn
+ *
+ * Since: 2.40
+ */
+gboolean
+g_tls_connection_get_kernel_offload (GTlsConnection *conn)
+{
+  g_return_val_if_fail (G_IS_TLS_CONNECTION (conn), FALSE);
+
+  return g_output_stream_get_kernel_socket (g_io_stream_get_output_stream (G_IO_STREAM (conn))) != NULL;
+}
+
 /**
  * g_tls_error_quark:
  *
@@ -68,9 +68,13 @@ struct _GTlsConnectionClass
 				  GAsyncResult         *result,
 				  GError              **error);
 
+  gboolean ( *enable_kernel_offload ) (GTlsConnection  *conn,
+				       GSocket         *socket,
+				       GError         **error);
+
   /*< private >*/
   /* Padding for future expansion */
-  gpointer padding[8];
+  gpointer padding[7];
 };
 
 GLIB_AVAILABLE_IN_ALL
@@ -145,6 +149,12 @@ GLIB_AVAILABLE_IN_ALL
 GQuark g_tls_error_quark (void);
 
 
+GLIB_AVAILABLE_IN_2_40
+gboolean              g_tls_connection_enable_kernel_offload       (GTlsConnection       *conn,
+								    GError              **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean              g_tls_connection_get_kernel_offload          (GTlsConnection       *conn);
+
 /*< protected >*/
 GLIB_AVAILABLE_IN_ALL
 gboolean              g_tls_connection_emit_accept_certificate     (GTlsConnection       *conn,
@@ -37,11 +37,32 @@
 #include <fcntl.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include "gunixfdlist.h"
 #include "gnetworking.h"
 #include "gioerror.h"
 
+#if defined(__linux__) && defined(SYS_memfd_create)
+#define HAVE_MEMFD 1
+/* The kernel may be newer than the headers we were built with */
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC       0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS       1033
+#define F_GET_SEALS       1034
+#define F_SEAL_SEAL       0x0001
+#define F_SEAL_SHRINK     0x0002
+#define F_SEAL_GROW       0x0004
+#define F_SEAL_WRITE      0x0008
+#endif
+#endif
+
 struct _GUnixFDListPrivate
 {
   gint *fds;
@@ -390,3 +411,232 @@ g_unix_fd_list_get_length (GUnixFDList *list)
 
   return list->priv->nfd;
 }
+
+/* Takes ownership of @fd */
+static gint
+append_fd_take (GUnixFDList *list,
+                gint         fd)
+{
+  list->priv->fds = g_realloc (list->priv->fds,
+                                  sizeof (gint) *
+                                   (list->priv->nfd + 2));
+  list->priv->fds[list->priv->nfd++] = fd;
+  list->priv->fds[list->priv->nfd] = -1;
+
+  return list->priv->nfd - 1;
+}
+
+static gboolean
+write_all (gint           fd,
+           const guint8  *data,
+           gsize          size,
+           GError       **error)
+{
+  while (size > 0)
+    {
+      gssize n;
+
+      n = write (fd, data, size);
+      if (n < 0)
+        {
+          int saved_errno = errno;
+
+          if (saved_errno == EINTR)
+            continue;
+
+          g_set_error (error, G_IO_ERROR,
+                       g_io_error_from_errno (saved_errno),
+                       "write: %s", g_strerror (saved_errno));
+          return FALSE;
+        }
+      data += n;
+      size -= n;
+    }
+
+  return TRUE;
+}
+
+/**
+ * g_unix_fd_list_append_bytes:
+ * @list: a #GUnixFDList
+ * @bytes: the data to append
+ * @error: a #GError pointer
+ *
+ * Copies @bytes into a new anonymous file and adds a file descriptor
+ * for it to @list.  On the receiving side, use
+ * g_unix_fd_list_get_bytes() to get the data back.
+ *
+ * This is meant for passing large payloads over D-Bus (as a
+ * <literal>h</literal> argument, using for example
+ * g_dbus_connection_call_with_unix_fd_list()) without copying them
+ * into the message, through the socket and out of the message again.
+ *
+ * Where the kernel supports it, the file is a sealed memfd: neither the
+ * sender nor the receiver can modify it anymore, so the receiver can
+ * safely map it instead of reading it.
+ *
+ * Returns: the index of the appended fd in case of success, else -1
+ *          (and @error is set)
+ *
+ * Since: 2.40
+ */
+gint
+g_unix_fd_list_append_bytes (GUnixFDList  *list,
+                             GBytes       *bytes,
+                             GError      **error)
+{
+  gconstpointer data;
+  gsize size;
+  gint fd;
+
+  g_return_val_if_fail (G_IS_UNIX_FD_LIST (list), -1);
+  g_return_val_if_fail (bytes != NULL, -1);
+  g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+  data = g_bytes_get_data (bytes, &size);
+
+  fd = -1;
+#ifdef HAVE_MEMFD
+  fd = syscall (SYS_memfd_create, "gio-fd-list-bytes", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+
+  if (fd < 0)
+    {
+      gchar *path;
+
+      /* No memfd (old kernel or not Linux): an unlinked temporary file
+       * works too, but the receiver will have to copy it.
+       */
+      fd = g_file_open_tmp ("gio-fd-list-bytes-XXXXXX", &path, error);
+      if (fd < 0)
+        return -1;
+      unlink (path);
+      g_free (path);
+      fcntl (fd, F_SETFD, FD_CLOEXEC);
+    }
+
+  if (!write_all (fd, data, size, error))
+    {
+      close (fd);
+      return -1;
+    }
+
+#ifdef HAVE_MEMFD
+  /* fails harmlessly for the temporary file */
+  fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+#endif
+
+  return append_fd_take (list, fd);
+}
+
+static GBytes *
+read_bytes (gint     fd,
+            GError **error)
+{
+  struct stat st;
+  guint8 *data;
+  gsize size;
+  gsize pos;
+
+  if (fstat (fd, &st) != 0)
+    {
+      int saved_errno = errno;
+
+      g_set_error (error, G_IO_ERROR,
+                   g_io_error_from_errno (saved_errno),
+                   "fstat: %s", g_strerror (saved_errno));
+      return NULL;
+    }
+
+  /* The file can still change under us; whatever we read is what we
+   * return.  pread() leaves the offset shared with the sender alone.
+   */
+  size = st.st_size;
+  data = g_malloc (size);
+  pos = 0;
+  while (pos < size)
+    {
+      gssize n;
+
+      n = pread (fd, data + pos, size - pos, pos);
+      if (n < 0)
+        {
+          int saved_errno = errno;
+
+          if (saved_errno == EINTR)
+            continue;
+
+          g_set_error (error, G_IO_ERROR,
+                       g_io_error_from_errno (saved_errno),
+                       "read: %s", g_strerror (saved_errno));
+          g_free (data);
+          return NULL;
+        }
+      if (n == 0)
+        break;
+      pos += n;
+    }
+
+  return g_bytes_new_take (data, pos);
+}
+
+/**
+ * g_unix_fd_list_get_bytes:
+ * @list: a #GUnixFDList
+ * @index_: the index into the list
+ * @error: a #GError pointer
+ *
+ * Gets the contents of the file referred to by the file descriptor at
+ * @index_ in @list, typically one added with
+ * g_unix_fd_list_append_bytes() by the sender.
+ *
+ * If the file is sealed against writing and shrinking, it is mapped
+ * into memory rather than copied, and the returned #GBytes keeps the
+ * mapping alive.  Otherwise its current contents are read.
+ *
+ * It is a programmer error for @index_ to be out of range; see
+ * g_unix_fd_list_get_length().
+ *
+ * Returns: (transfer full): the contents, or %NULL in case of error
+ *
+ * Since: 2.40
+ */
+GBytes *
+g_unix_fd_list_get_bytes (GUnixFDList  *list,
+                          gint          index_,
+                          GError      **error)
+{
+  GBytes *bytes;
+  gint fd;
+
+  g_return_val_if_fail (G_IS_UNIX_FD_LIST (list), NULL);
+  g_return_val_if_fail (index_ < list->priv->nfd, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  fd = list->priv->fds[index_];
+
+#ifdef HAVE_MEMFD
+  {
+    gint seals;
+
+    seals = fcntl (fd, F_GET_SEALS);
+    if (seals >= 0 &&
+        (seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) == (F_SEAL_SHRINK | F_SEAL_WRITE))
+      {
+        GMappedFile *mapped;
+
+        mapped = g_mapped_file_new_from_fd (fd, FALSE, error);
+        if (mapped == NULL)
+          return NULL;
+        bytes = g_mapped_file_get_bytes (mapped);
+        g_mapped_file_unref (mapped);
+
+        return bytes;
+      }
+  }
+#endif
+
+  bytes = read_bytes (fd, error);
+
+  return bytes;
+}
@@ -91,6 +91,16 @@ GLIB_AVAILABLE_IN_ALL
 gint *                  g_unix_fd_list_steal_fds                        (GUnixFDList  *list,
                                                                          gint         *length);
 
+GLIB_AVAILABLE_IN_2_40
+gint                    g_unix_fd_list_append_bytes                     (GUnixFDList  *list,
+                                                                         GBytes       *bytes,
+                                                                         GError      **error);
+
+GLIB_AVAILABLE_IN_2_40
+GBytes *                g_unix_fd_list_get_bytes                        (GUnixFDList  *list,
+                                                                         gint          index_,
+                                                                         GError      **error);
+
 G_END_DECLS
 
 #endif /* __G_UNIX_FD_LIST_H__ */
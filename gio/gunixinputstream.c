@@ -24,6 +24,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdio.h>
@@ -38,6 +39,7 @@
 #include "gcancellable.h"
 #include "gasynchelper.h"
 #include "gfiledescriptorbased.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 
@@ -94,6 +96,12 @@ static gssize   g_unix_input_stream_read         (GInputStream         *stream,
 						  gsize                 count,
 						  GCancellable         *cancellable,
 						  GError              **error);
+static gboolean g_unix_input_stream_readv        (GInputStream         *stream,
+						  const GInputVector   *vectors,
+						  gsize                 n_vectors,
+						  gsize                *bytes_read,
+						  GCancellable         *cancellable,
+						  GError              **error);
 static gboolean g_unix_input_stream_close        (GInputStream         *stream,
 						  GCancellable         *cancellable,
 						  GError              **error);
@@ -119,6 +127,11 @@ static gboolean g_unix_input_stream_pollable_can_poll      (GPollableInputStream
 static gboolean g_unix_input_stream_pollable_is_readable   (GPollableInputStream *stream);
 static GSource *g_unix_input_stream_pollable_create_source (GPollableInputStream *stream,
 							    GCancellable         *cancellable);
+static gboolean g_unix_input_stream_pollable_readv_nonblocking (GPollableInputStream *stream,
+								const GInputVector   *vectors,
+								gsize                 n_vectors,
+								gsize                *bytes_read,
+								GError              **error);
 
 static void
 g_unix_input_stream_class_init (GUnixInputStreamClass *klass)
@@ -130,6 +143,7 @@ g_unix_input_stream_class_init (GUnixInputStreamClass *klass)
   gobject_class->set_property = g_unix_input_stream_set_property;
 
   stream_class->read_fn = g_unix_input_stream_read;
+  stream_class->readv_fn = g_unix_input_stream_readv;
   stream_class->close_fn = g_unix_input_stream_close;
   if (0)
     {
@@ -177,6 +191,7 @@ g_unix_input_stream_pollable_iface_init (GPollableInputStreamInterface *iface)
   iface->can_poll = g_unix_input_stream_pollable_can_poll;
   iface->is_readable = g_unix_input_stream_pollable_is_readable;
   iface->create_source = g_unix_input_stream_pollable_create_source;
+  iface->readv_nonblocking = g_unix_input_stream_pollable_readv_nonblocking;
 }
 
 static void
@@ -333,25 +348,83 @@ g_unix_input_stream_get_fd (GUnixInputStream *stream)
   return stream->priv->fd;
 }
 
+/* Returns @vectors as an array of struct iovec, of at most G_IOV_MAX
+ * elements. @iov is used if the two are not the same thing already.
+ */
+static const struct iovec *
+vectors_as_iovec (const GInputVector *vectors,
+                  gsize              *n_vectors,
+                  struct iovec       *iov)
+{
+  gsize i;
+
+  *n_vectors = MIN (*n_vectors, G_IOV_MAX);
+
+  /* this entire expression will be evaluated at compile time */
+  if (sizeof *iov == sizeof *vectors &&
+      sizeof iov->iov_base == sizeof vectors->buffer &&
+      G_STRUCT_OFFSET (struct iovec, iov_base) ==
+      G_STRUCT_OFFSET (GInputVector, buffer) &&
+      sizeof iov->iov_len == sizeof vectors->size &&
+      G_STRUCT_OFFSET (struct iovec, iov_len) ==
+      G_STRUCT_OFFSET (GInputVector, size))
+    return (const struct iovec *) vectors;
+
+  for (i = 0; i < *n_vectors; i++)
+    {
+      iov[i].iov_base = vectors[i].buffer;
+      iov[i].iov_len = vectors[i].size;
+    }
+
+  return iov;
+}
+
 static gssize
 g_unix_input_stream_read (GInputStream  *stream,
 			  void          *buffer,
 			  gsize          count,
 			  GCancellable  *cancellable,
 			  GError       **error)
+{
+  GInputVector vector;
+  gsize bytes_read;
+
+  vector.buffer = buffer;
+  vector.size = count;
+
+  if (!g_unix_input_stream_readv (stream, &vector, 1, &bytes_read,
+                                  cancellable, error))
+    return -1;
+
+  return bytes_read;
+}
+
+static gboolean
+g_unix_input_stream_readv (GInputStream        *stream,
+			   const GInputVector  *vectors,
+			   gsize                n_vectors,
+			   gsize               *bytes_read,
+			   GCancellable        *cancellable,
+			   GError             **error)
 {
   GUnixInputStream *unix_stream;
+  const struct iovec *iov;
   gssize res = -1;
   GPollFD poll_fds[2];
+  gulong cancel_handler;
   int nfds;
   int poll_ret;
 
   unix_stream = G_UNIX_INPUT_STREAM (stream);
 
+  iov = vectors_as_iovec (vectors, &n_vectors,
+                          g_newa (struct iovec, MIN (n_vectors, G_IOV_MAX)));
+
   poll_fds[0].fd = unix_stream->priv->fd;
   poll_fds[0].events = G_IO_IN;
   if (unix_stream->priv->is_pipe_or_socket &&
-      g_cancellable_make_pollfd (cancellable, &poll_fds[1]))
+      g_cancellable_make_thread_pollfd (cancellable, &poll_fds[1],
+                                        &cancel_handler))
     nfds = 2;
   else
     nfds = 1;
@@ -380,7 +453,10 @@ g_unix_input_stream_read (GInputStream  *stream,
       if (!poll_fds[0].revents)
 	continue;
 
-      res = read (unix_stream->priv->fd, buffer, count);
+      if (n_vectors == 1)
+        res = read (unix_stream->priv->fd, iov[0].iov_base, iov[0].iov_len);
+      else
+        res = readv (unix_stream->priv->fd, iov, n_vectors);
       if (res == -1)
 	{
           int errsv = errno;
@@ -398,8 +474,10 @@ g_unix_input_stream_read (GInputStream  *stream,
     }
 
   if (nfds == 2)
-    g_cancellable_release_fd (cancellable);
-  return res;
+    g_cancellable_release_thread_pollfd (cancellable, cancel_handler);
+
+  *bytes_read = MAX (res, 0);
+  return res != -1;
 }
 
 static gboolean
@@ -506,6 +584,48 @@ g_unix_input_stream_pollable_is_readable (GPollableInputStream *stream)
   return poll_fd.revents != 0;
 }
 
+static gboolean
+g_unix_input_stream_pollable_readv_nonblocking (GPollableInputStream  *stream,
+						const GInputVector    *vectors,
+						gsize                  n_vectors,
+						gsize                 *bytes_read,
+						GError               **error)
+{
+  GUnixInputStream *unix_stream = G_UNIX_INPUT_STREAM (stream);
+  const struct iovec *iov;
+  gssize res;
+
+  *bytes_read = 0;
+
+  if (!g_unix_input_stream_pollable_is_readable (stream))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+                           g_strerror (EAGAIN));
+      return FALSE;
+    }
+
+  iov = vectors_as_iovec (vectors, &n_vectors,
+                          g_newa (struct iovec, MIN (n_vectors, G_IOV_MAX)));
+
+  do
+    res = readv (unix_stream->priv->fd, iov, n_vectors);
+  while (res == -1 && errno == EINTR);
+
+  if (res == -1)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_IO_ERROR,
+		   g_io_error_from_errno (errsv),
+		   _("Error reading from file descriptor: %s"),
+		   g_strerror (errsv));
+      return FALSE;
+    }
+
+  *bytes_read = res;
+  return TRUE;
+}
+
 static GSource *
 g_unix_input_stream_pollable_create_source (GPollableInputStream *stream,
 					    GCancellable         *cancellable)
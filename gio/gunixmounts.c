@@ -39,6 +39,7 @@
 #include <poll.h>
 #endif
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <errno.h>
@@ -144,11 +145,18 @@ struct _GUnixMountPoint {
 enum {
   MOUNTS_CHANGED,
   MOUNTPOINTS_CHANGED,
+  MOUNT_ADDED,
+  MOUNT_REMOVED,
+  MOUNT_CHANGED,
   LAST_SIGNAL
 };
 
 static guint signals[LAST_SIGNAL];
 
+#ifdef __linux__
+typedef struct _MountInfoSnapshot MountInfoSnapshot;
+#endif
+
 struct _GUnixMountMonitor {
   GObject parent;
 
@@ -156,6 +164,11 @@ struct _GUnixMountMonitor {
   GFileMonitor *mtab_monitor;
 
   GSource *proc_mounts_watch_source;
+
+#ifdef __linux__
+  /* What we last read from /proc/self/mountinfo */
+  MountInfoSnapshot *mountinfo;
+#endif
 };
 
 struct _GUnixMountMonitorClass {
@@ -366,6 +379,311 @@ get_mtab_monitor_file (void)
 #endif
 }
 
+#ifdef __linux__
+
+/* /proc/self/mountinfo gives every mount a unique ID.  We keep the
+ * entries parsed from the previous read, keyed by that ID, so only the
+ * lines that differ from last time need to be parsed again; this also
+ * tells us exactly which mounts were added, removed or changed.
+ */
+
+#define PROC_MOUNTINFO "/proc/self/mountinfo"
+
+typedef struct {
+  gchar           *line;
+  GUnixMountEntry *entry;
+} MountInfoLine;
+
+struct _MountInfoSnapshot {
+  GHashTable *lines;  /* mount ID -> MountInfoLine */
+  GArray     *order;  /* mount IDs, in the order the kernel lists them */
+};
+
+G_LOCK_DEFINE_STATIC (mountinfo);
+static MountInfoSnapshot *mountinfo_cache = NULL;
+
+static void
+mountinfo_line_free (gpointer data)
+{
+  MountInfoLine *info = data;
+
+  g_free (info->line);
+  if (info->entry)
+    g_unix_mount_free (info->entry);
+  g_slice_free (MountInfoLine, info);
+}
+
+static MountInfoSnapshot *
+mountinfo_snapshot_new (void)
+{
+  MountInfoSnapshot *snapshot;
+
+  snapshot = g_slice_new (MountInfoSnapshot);
+  snapshot->lines = g_hash_table_new_full (NULL, NULL, NULL, mountinfo_line_free);
+  snapshot->order = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return snapshot;
+}
+
+static void
+mountinfo_snapshot_free (MountInfoSnapshot *snapshot)
+{
+  g_hash_table_unref (snapshot->lines);
+  g_array_unref (snapshot->order);
+  g_slice_free (MountInfoSnapshot, snapshot);
+}
+
+/* Undoes the octal escaping of spaces, tabs, newlines and backslashes */
+static void
+unescape_mountinfo_field (gchar *field)
+{
+  gchar *in, *out;
+
+  for (in = out = field; *in != '\0'; in++, out++)
+    {
+      if (in[0] == '\\' &&
+          in[1] >= '0' && in[1] <= '3' &&
+          in[2] >= '0' && in[2] <= '7' &&
+          in[3] >= '0' && in[3] <= '7')
+        {
+          *out = ((in[1] - '0') << 6) | ((in[2] - '0') << 3) | (in[3] - '0');
+          in += 3;
+        }
+      else
+        *out = *in;
+    }
+  *out = '\0';
+}
+
+static gboolean
+mount_options_are_read_only (const gchar *options)
+{
+  return strcmp (options, "ro") == 0 || g_str_has_prefix (options, "ro,");
+}
+
+/* A line looks like
+ * 36 35 98:0 /mnt1 /mnt2 rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+ * with any number of optional fields before the "-" separator.
+ */
+static GUnixMountEntry *
+parse_mountinfo_line (const gchar *line)
+{
+  GUnixMountEntry *mount_entry;
+  gchar **fields;
+  guint n_fields, sep;
+
+  fields = g_strsplit (line, " ", -1);
+  n_fields = g_strv_length (fields);
+
+  for (sep = 6; sep < n_fields; sep++)
+    if (strcmp (fields[sep], "-") == 0)
+      break;
+
+  if (n_fields < 10 || sep + 3 >= n_fields)
+    {
+      g_strfreev (fields);
+      return NULL;
+    }
+
+  unescape_mountinfo_field (fields[4]);
+  unescape_mountinfo_field (fields[sep + 2]);
+
+  mount_entry = g_new0 (GUnixMountEntry, 1);
+  mount_entry->mount_path = g_strdup (fields[4]);
+  if (strcmp (fields[sep + 2], "/dev/root") == 0)
+    mount_entry->device_path = g_strdup (_resolve_dev_root ());
+  else
+    mount_entry->device_path = g_strdup (fields[sep + 2]);
+  mount_entry->filesystem_type = g_strdup (fields[sep + 1]);
+  mount_entry->is_read_only = mount_options_are_read_only (fields[5]) ||
+                              mount_options_are_read_only (fields[sep + 3]);
+  mount_entry->is_system_internal =
+    guess_system_internal (mount_entry->mount_path,
+                           mount_entry->filesystem_type,
+                           mount_entry->device_path);
+
+  g_strfreev (fields);
+
+  return mount_entry;
+}
+
+/* Replaces the contents of @snapshot with @contents, the text of
+ * /proc/self/mountinfo, which is modified in the process.  The entries
+ * in @added and @changed belong to the snapshot; those in @removed to
+ * the caller.  Any of the lists may be %NULL.
+ */
+static void
+mountinfo_snapshot_apply (MountInfoSnapshot  *snapshot,
+                          gchar              *contents,
+                          GList             **added,
+                          GList             **removed,
+                          GList             **changed)
+{
+  GHashTable *old_lines;
+  GHashTableIter iter;
+  MountInfoLine *info;
+  gchar *line, *next, *end;
+  guint id;
+
+  old_lines = snapshot->lines;
+  snapshot->lines = g_hash_table_new_full (NULL, NULL, NULL, mountinfo_line_free);
+  g_array_set_size (snapshot->order, 0);
+
+  for (line = contents; *line != '\0'; line = next)
+    {
+      next = strchr (line, '\n');
+      if (next != NULL)
+        *next++ = '\0';
+      else
+        next = line + strlen (line);
+
+      id = strtoul (line, &end, 10);
+      if (end == line)
+        continue;
+
+      info = g_hash_table_lookup (old_lines, GUINT_TO_POINTER (id));
+      if (info != NULL && strcmp (info->line, line) == 0)
+        g_hash_table_steal (old_lines, GUINT_TO_POINTER (id));
+      else
+        {
+          GUnixMountEntry *mount_entry;
+
+          mount_entry = parse_mountinfo_line (line);
+          if (mount_entry == NULL)
+            {
+              /* The mount is still there; keep what we knew about it
+               * rather than report it removed
+               */
+              if (info == NULL)
+                continue;
+
+              g_hash_table_steal (old_lines, GUINT_TO_POINTER (id));
+            }
+          else
+            {
+              if (info != NULL)
+                {
+                  g_hash_table_remove (old_lines, GUINT_TO_POINTER (id));
+                  if (changed)
+                    *changed = g_list_prepend (*changed, mount_entry);
+                }
+              else if (added)
+                *added = g_list_prepend (*added, mount_entry);
+
+              info = g_slice_new (MountInfoLine);
+              info->line = g_strdup (line);
+              info->entry = mount_entry;
+            }
+        }
+
+      g_hash_table_insert (snapshot->lines, GUINT_TO_POINTER (id), info);
+      g_array_append_val (snapshot->order, id);
+    }
+
+  /* Whatever is left was not listed any more */
+  if (removed)
+    {
+      g_hash_table_iter_init (&iter, old_lines);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
+        {
+          *removed = g_list_prepend (*removed, info->entry);
+          info->entry = NULL;
+        }
+    }
+  g_hash_table_unref (old_lines);
+
+  if (added)
+    *added = g_list_reverse (*added);
+  if (changed)
+    *changed = g_list_reverse (*changed);
+}
+
+/* Rereads /proc/self/mountinfo into @snapshot, as
+ * mountinfo_snapshot_apply().
+ */
+static gboolean
+mountinfo_snapshot_update (MountInfoSnapshot  *snapshot,
+                           GList             **added,
+                           GList             **removed,
+                           GList             **changed)
+{
+  gchar *contents;
+
+  if (!g_file_get_contents (PROC_MOUNTINFO, &contents, NULL, NULL))
+    return FALSE;
+
+  mountinfo_snapshot_apply (snapshot, contents, added, removed, changed);
+  g_free (contents);
+
+  return TRUE;
+}
+
+static GUnixMountEntry *
+copy_mount_entry (GUnixMountEntry *mount_entry)
+{
+  GUnixMountEntry *copy;
+
+  copy = g_new0 (GUnixMountEntry, 1);
+  copy->mount_path = g_strdup (mount_entry->mount_path);
+  copy->device_path = g_strdup (mount_entry->device_path);
+  copy->filesystem_type = g_strdup (mount_entry->filesystem_type);
+  copy->is_read_only = mount_entry->is_read_only;
+  copy->is_system_internal = mount_entry->is_system_internal;
+
+  return copy;
+}
+
+static gboolean
+_g_get_unix_mounts_from_mountinfo (GList **mounts)
+{
+  GHashTable *mounts_hash;
+  GList *return_list;
+  guint i;
+
+  G_LOCK (mountinfo);
+
+  if (mountinfo_cache == NULL)
+    mountinfo_cache = mountinfo_snapshot_new ();
+
+  if (!mountinfo_snapshot_update (mountinfo_cache, NULL, NULL, NULL))
+    {
+      G_UNLOCK (mountinfo);
+      return FALSE;
+    }
+
+  return_list = NULL;
+  mounts_hash = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < mountinfo_cache->order->len; i++)
+    {
+      MountInfoLine *info;
+      guint id;
+
+      id = g_array_index (mountinfo_cache->order, guint, i);
+      info = g_hash_table_lookup (mountinfo_cache->lines, GUINT_TO_POINTER (id));
+
+      /* Skip --bind mounts, as in the mntent code below */
+      if (info->entry->device_path[0] == '/' &&
+          g_hash_table_lookup (mounts_hash, info->entry->device_path))
+        continue;
+
+      g_hash_table_insert (mounts_hash,
+                           info->entry->device_path,
+                           info->entry->device_path);
+
+      return_list = g_list_prepend (return_list, copy_mount_entry (info->entry));
+    }
+  g_hash_table_destroy (mounts_hash);
+
+  G_UNLOCK (mountinfo);
+
+  *mounts = g_list_reverse (return_list);
+
+  return TRUE;
+}
+
+#endif /* __linux__ */
+
 #ifndef HAVE_GETMNTENT_R
 G_LOCK_DEFINE_STATIC(getmntent);
 #endif
@@ -383,7 +701,12 @@ _g_get_unix_mounts (void)
   GUnixMountEntry *mount_entry;
   GHashTable *mounts_hash;
   GList *return_list;
-  
+
+#ifdef __linux__
+  if (_g_get_unix_mounts_from_mountinfo (&return_list))
+    return return_list;
+#endif
+
   read_file = get_mtab_read_file ();
 
   file = setmntent (read_file, "r");
@@ -1273,6 +1596,11 @@ g_unix_mount_monitor_finalize (GObject *object)
       g_object_unref (monitor->mtab_monitor);
     }
 
+#ifdef __linux__
+  if (monitor->mountinfo)
+    mountinfo_snapshot_free (monitor->mountinfo);
+#endif
+
   the_mount_monitor = NULL;
 
   G_OBJECT_CLASS (g_unix_mount_monitor_parent_class)->finalize (object);
@@ -1315,6 +1643,70 @@ g_unix_mount_monitor_class_init (GUnixMountMonitorClass *klass)
 		  NULL, NULL,
 		  g_cclosure_marshal_VOID__VOID,
 		  G_TYPE_NONE, 0);
+
+  /**
+   * GUnixMountMonitor::mount-added:
+   * @monitor: the object on which the signal is emitted
+   * @mount_entry: the #GUnixMountEntry that appeared; it is owned by
+   *     @monitor and only valid during the emission
+   *
+   * Emitted for each mount that appeared, before
+   * #GUnixMountMonitor::mounts-changed.  Only emitted on systems that
+   * allow telling individual mounts apart (currently Linux).
+   *
+   * Since: 2.40
+   */
+  signals[MOUNT_ADDED] =
+    g_signal_new ("mount-added",
+		  G_TYPE_FROM_CLASS (klass),
+		  G_SIGNAL_RUN_LAST,
+		  0,
+		  NULL, NULL,
+		  g_cclosure_marshal_VOID__POINTER,
+		  G_TYPE_NONE, 1, G_TYPE_POINTER);
+
+  /**
+   * GUnixMountMonitor::mount-removed:
+   * @monitor: the object on which the signal is emitted
+   * @mount_entry: the #GUnixMountEntry that went away; it is owned by
+   *     @monitor and only valid during the emission
+   *
+   * Emitted for each mount that went away, before
+   * #GUnixMountMonitor::mounts-changed.  Only emitted on systems that
+   * allow telling individual mounts apart (currently Linux).
+   *
+   * Since: 2.40
+   */
+  signals[MOUNT_REMOVED] =
+    g_signal_new ("mount-removed",
+		  G_TYPE_FROM_CLASS (klass),
+		  G_SIGNAL_RUN_LAST,
+		  0,
+		  NULL, NULL,
+		  g_cclosure_marshal_VOID__POINTER,
+		  G_TYPE_NONE, 1, G_TYPE_POINTER);
+
+  /**
+   * GUnixMountMonitor::mount-changed:
+   * @monitor: the object on which the signal is emitted
+   * @mount_entry: the updated #GUnixMountEntry; it is owned by
+   *     @monitor and only valid during the emission
+   *
+   * Emitted for each mount whose details changed, for instance when it
+   * was remounted read-only, before #GUnixMountMonitor::mounts-changed.
+   * Only emitted on systems that allow telling individual mounts apart
+   * (currently Linux).
+   *
+   * Since: 2.40
+   */
+  signals[MOUNT_CHANGED] =
+    g_signal_new ("mount-changed",
+		  G_TYPE_FROM_CLASS (klass),
+		  G_SIGNAL_RUN_LAST,
+		  0,
+		  NULL, NULL,
+		  g_cclosure_marshal_VOID__POINTER,
+		  G_TYPE_NONE, 1, G_TYPE_POINTER);
 }
 
 static void
@@ -1359,8 +1751,38 @@ proc_mounts_changed (GIOChannel   *channel,
                      gpointer      user_data)
 {
   GUnixMountMonitor *mount_monitor = G_UNIX_MOUNT_MONITOR (user_data);
-  if (cond & G_IO_ERR)
-    g_signal_emit (mount_monitor, signals[MOUNTS_CHANGED], 0);
+
+  if ((cond & G_IO_ERR) == 0)
+    return TRUE;
+
+#ifdef __linux__
+  if (mount_monitor->mountinfo)
+    {
+      GList *added = NULL, *removed = NULL, *changed = NULL, *l;
+
+      if (mountinfo_snapshot_update (mount_monitor->mountinfo,
+                                     &added, &removed, &changed))
+        {
+          for (l = removed; l != NULL; l = l->next)
+            g_signal_emit (mount_monitor, signals[MOUNT_REMOVED], 0, l->data);
+          for (l = changed; l != NULL; l = l->next)
+            g_signal_emit (mount_monitor, signals[MOUNT_CHANGED], 0, l->data);
+          for (l = added; l != NULL; l = l->next)
+            g_signal_emit (mount_monitor, signals[MOUNT_ADDED], 0, l->data);
+
+          /* The table was rewritten without any visible difference */
+          if (added == NULL && removed == NULL && changed == NULL)
+            return TRUE;
+
+          g_list_free (added);
+          g_list_free (changed);
+          g_list_free_full (removed, (GDestroyNotify) g_unix_mount_free);
+        }
+    }
+#endif
+
+  g_signal_emit (mount_monitor, signals[MOUNTS_CHANGED], 0);
+
   return TRUE;
 }
 
@@ -1408,6 +1830,15 @@ g_unix_mount_monitor_init (GUnixMountMonitor *monitor)
                                g_main_context_get_thread_default ());
               g_source_unref (monitor->proc_mounts_watch_source);
               g_io_channel_unref (proc_mounts_channel);
+
+#ifdef __linux__
+              monitor->mountinfo = mountinfo_snapshot_new ();
+              if (!mountinfo_snapshot_update (monitor->mountinfo, NULL, NULL, NULL))
+                {
+                  mountinfo_snapshot_free (monitor->mountinfo);
+                  monitor->mountinfo = NULL;
+                }
+#endif
             }
         }
       else
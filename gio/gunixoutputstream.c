@@ -24,6 +24,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdio.h>
@@ -38,6 +39,7 @@
 #include "gsimpleasyncresult.h"
 #include "gasynchelper.h"
 #include "gfiledescriptorbased.h"
+#include "gioprivate.h"
 #include "glibintl.h"
 
 
@@ -94,6 +96,12 @@ static gssize   g_unix_output_stream_write        (GOutputStream        *stream,
 						   gsize                 count,
 						   GCancellable         *cancellable,
 						   GError              **error);
+static gboolean g_unix_output_stream_writev       (GOutputStream        *stream,
+						   const GOutputVector  *vectors,
+						   gsize                 n_vectors,
+						   gsize                *bytes_written,
+						   GCancellable         *cancellable,
+						   GError              **error);
 static gboolean g_unix_output_stream_close        (GOutputStream        *stream,
 						   GCancellable         *cancellable,
 						   GError              **error);
@@ -110,6 +118,11 @@ static gboolean g_unix_output_stream_pollable_can_poll      (GPollableOutputStre
 static gboolean g_unix_output_stream_pollable_is_writable   (GPollableOutputStream *stream);
 static GSource *g_unix_output_stream_pollable_create_source (GPollableOutputStream *stream,
 							     GCancellable         *cancellable);
+static gboolean g_unix_output_stream_pollable_writev_nonblocking (GPollableOutputStream *stream,
+								  const GOutputVector   *vectors,
+								  gsize                  n_vectors,
+								  gsize                 *bytes_written,
+								  GError               **error);
 
 static void
 g_unix_output_stream_class_init (GUnixOutputStreamClass *klass)
@@ -121,6 +134,7 @@ g_unix_output_stream_class_init (GUnixOutputStreamClass *klass)
   gobject_class->set_property = g_unix_output_stream_set_property;
 
   stream_class->write_fn = g_unix_output_stream_write;
+  stream_class->writev_fn = g_unix_output_stream_writev;
   stream_class->close_fn = g_unix_output_stream_close;
   stream_class->close_async = g_unix_output_stream_close_async;
   stream_class->close_finish = g_unix_output_stream_close_finish;
@@ -162,6 +176,7 @@ g_unix_output_stream_pollable_iface_init (GPollableOutputStreamInterface *iface)
   iface->can_poll = g_unix_output_stream_pollable_can_poll;
   iface->is_writable = g_unix_output_stream_pollable_is_writable;
   iface->create_source = g_unix_output_stream_pollable_create_source;
+  iface->writev_nonblocking = g_unix_output_stream_pollable_writev_nonblocking;
 }
 
 static void
@@ -318,26 +333,84 @@ g_unix_output_stream_get_fd (GUnixOutputStream *stream)
   return stream->priv->fd;
 }
 
+/* Returns @vectors as an array of struct iovec, of at most G_IOV_MAX
+ * elements. @iov is used if the two are not the same thing already.
+ */
+static const struct iovec *
+vectors_as_iovec (const GOutputVector *vectors,
+                  gsize               *n_vectors,
+                  struct iovec        *iov)
+{
+  gsize i;
+
+  *n_vectors = MIN (*n_vectors, G_IOV_MAX);
+
+  /* this entire expression will be evaluated at compile time */
+  if (sizeof *iov == sizeof *vectors &&
+      sizeof iov->iov_base == sizeof vectors->buffer &&
+      G_STRUCT_OFFSET (struct iovec, iov_base) ==
+      G_STRUCT_OFFSET (GOutputVector, buffer) &&
+      sizeof iov->iov_len == sizeof vectors->size &&
+      G_STRUCT_OFFSET (struct iovec, iov_len) ==
+      G_STRUCT_OFFSET (GOutputVector, size))
+    return (const struct iovec *) vectors;
+
+  for (i = 0; i < *n_vectors; i++)
+    {
+      iov[i].iov_base = (void *) vectors[i].buffer;
+      iov[i].iov_len = vectors[i].size;
+    }
+
+  return iov;
+}
+
 static gssize
 g_unix_output_stream_write (GOutputStream  *stream,
 			    const void     *buffer,
 			    gsize           count,
 			    GCancellable   *cancellable,
 			    GError        **error)
+{
+  GOutputVector vector;
+  gsize bytes_written;
+
+  vector.buffer = buffer;
+  vector.size = count;
+
+  if (!g_unix_output_stream_writev (stream, &vector, 1, &bytes_written,
+                                    cancellable, error))
+    return -1;
+
+  return bytes_written;
+}
+
+static gboolean
+g_unix_output_stream_writev (GOutputStream        *stream,
+			     const GOutputVector  *vectors,
+			     gsize                 n_vectors,
+			     gsize                *bytes_written,
+			     GCancellable         *cancellable,
+			     GError              **error)
 {
   GUnixOutputStream *unix_stream;
+  const struct iovec *iov;
   gssize res = -1;
   GPollFD poll_fds[2];
+  gulong cancel_handler;
   int nfds;
   int poll_ret;
 
   unix_stream = G_UNIX_OUTPUT_STREAM (stream);
 
+  iov = vectors_as_iovec (vectors, &n_vectors,
+                          g_newa (struct iovec, MIN (n_vectors, G_IOV_MAX)));
+
   poll_fds[0].fd = unix_stream->priv->fd;
   poll_fds[0].events = G_IO_OUT;
 
   if (unix_stream->priv->is_pipe_or_socket &&
-      g_cancellable_make_pollfd (cancellable, &poll_fds[1]))
+      g_cancellable_make_thread_pollfd (cancellable, &poll_fds[1],
+                                        &cancel_handler))
     nfds = 2;
   else
     nfds = 1;
@@ -366,7 +439,10 @@ g_unix_output_stream_write (GOutputStream  *stream,
       if (!poll_fds[0].revents)
 	continue;
 
-      res = write (unix_stream->priv->fd, buffer, count);
+      if (n_vectors == 1)
+        res = write (unix_stream->priv->fd, iov[0].iov_base, iov[0].iov_len);
+      else
+        res = writev (unix_stream->priv->fd, iov, n_vectors);
       if (res == -1)
 	{
           int errsv = errno;
@@ -384,8 +460,10 @@ g_unix_output_stream_write (GOutputStream  *stream,
     }
 
   if (nfds == 2)
-    g_cancellable_release_fd (cancellable);
-  return res;
+    g_cancellable_release_thread_pollfd (cancellable, cancel_handler);
+
+  *bytes_written = MAX (res, 0);
+  return res != -1;
 }
 
 static gboolean
@@ -470,6 +548,48 @@ g_unix_output_stream_pollable_is_writable (GPollableOutputStream *stream)
   return poll_fd.revents != 0;
 }
 
+static gboolean
+g_unix_output_stream_pollable_writev_nonblocking (GPollableOutputStream  *stream,
+						  const GOutputVector    *vectors,
+						  gsize                   n_vectors,
+						  gsize                  *bytes_written,
+						  GError                **error)
+{
+  GUnixOutputStream *unix_stream = G_UNIX_OUTPUT_STREAM (stream);
+  const struct iovec *iov;
+  gssize res;
+
+  *bytes_written = 0;
+
+  if (!g_unix_output_stream_pollable_is_writable (stream))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+                           g_strerror (EAGAIN));
+      return FALSE;
+    }
+
+  iov = vectors_as_iovec (vectors, &n_vectors,
+                          g_newa (struct iovec, MIN (n_vectors, G_IOV_MAX)));
+
+  do
+    res = writev (unix_stream->priv->fd, iov, n_vectors);
+  while (res == -1 && errno == EINTR);
+
+  if (res == -1)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_IO_ERROR,
+		   g_io_error_from_errno (errsv),
+		   _("Error writing to file descriptor: %s"),
+		   g_strerror (errsv));
+      return FALSE;
+    }
+
+  *bytes_written = res;
+  return TRUE;
+}
+
 static GSource *
 g_unix_output_stream_pollable_create_source (GPollableOutputStream *stream,
 					     GCancellable          *cancellable)
@@ -0,0 +1,678 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <string.h>
+#include "gvariantoutputstream.h"
+#include "gioerror.h"
+#include "glibintl.h"
+
+
+/**
+ * SECTION:gvariantoutputstream
+ * @short_description: Streaming GVariant serialiser
+ * @include: gio/gio.h
+ * @see_also: #GOutputStream, #GVariantBuilder
+ *
+ * #GVariantOutputStream writes the serialised form of a #GVariant to
+ * its base stream incrementally, so that very large values can be
+ * exported without ever being held in memory as a whole.
+ *
+ * The value is described in the same way as with a #GVariantBuilder:
+ * containers are opened with g_variant_output_stream_open_container()
+ * and closed with g_variant_output_stream_close_container(), and
+ * complete child values are added with
+ * g_variant_output_stream_put_value().  The items of an array with a
+ * fixed-sized element type, such as the contents of a large
+ * bytestring, can be written in bulk with
+ * g_variant_output_stream_put_array_data().
+ *
+ * Every item is written to the base stream as soon as it is added.
+ * Only the framing offsets of the containers that are currently open
+ * are kept in memory, since the serialised form stores them after the
+ * items they describe.
+ *
+ * The data that is written is exactly what g_variant_get_data() would
+ * return for the equivalent value, in the byte order of the machine.
+ * Once the outermost container is closed, another value may be
+ * written.  Each value is aligned relative to its own start, so the
+ * reader must know where each one begins.
+ *
+ * If any write fails, the stream is left in an undefined state and
+ * should be closed.
+ *
+ * Since: 2.40
+ **/
+
+typedef struct
+{
+  GVariantType       *type;
+  const GVariantType *next;            /* array/maybe: element; tuple: next member */
+  gsize               element_alignment;
+  gsize               element_size;    /* fixed size of the element, or 0 */
+  gsize               start;
+  gsize               n_children;
+  GArray             *offsets;         /* end offsets of variable-sized children */
+  GVariantType       *child_type;      /* variant: the type of its child */
+} GVariantOutputFrame;
+
+struct _GVariantOutputStreamPrivate {
+  GPtrArray *frames;
+
+  /* bytes written since the start of the current outermost value */
+  gsize      position;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GVariantOutputStream,
+                            g_variant_output_stream,
+                            G_TYPE_FILTER_OUTPUT_STREAM)
+
+static void
+g_variant_output_frame_free (GVariantOutputFrame *frame)
+{
+  g_variant_type_free (frame->type);
+  if (frame->child_type)
+    g_variant_type_free (frame->child_type);
+  g_array_unref (frame->offsets);
+  g_slice_free (GVariantOutputFrame, frame);
+}
+
+static void
+g_variant_output_stream_finalize (GObject *object)
+{
+  GVariantOutputStream *stream = G_VARIANT_OUTPUT_STREAM (object);
+
+  g_ptr_array_unref (stream->priv->frames);
+
+  G_OBJECT_CLASS (g_variant_output_stream_parent_class)->finalize (object);
+}
+
+static void
+g_variant_output_stream_class_init (GVariantOutputStreamClass *klass)
+{
+  GObjectClass *object_class;
+
+  object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = g_variant_output_stream_finalize;
+}
+
+static void
+g_variant_output_stream_init (GVariantOutputStream *stream)
+{
+  stream->priv = g_variant_output_stream_get_instance_private (stream);
+  stream->priv->frames = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_output_frame_free);
+}
+
+/**
+ * g_variant_output_stream_new:
+ * @base_stream: a #GOutputStream.
+ *
+ * Creates a new variant output stream for the @base_stream.
+ *
+ * Returns: #GVariantOutputStream.
+ *
+ * Since: 2.40
+ **/
+GVariantOutputStream *
+g_variant_output_stream_new (GOutputStream *base_stream)
+{
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (base_stream), NULL);
+
+  return g_object_new (G_TYPE_VARIANT_OUTPUT_STREAM,
+                       "base-stream", base_stream,
+                       NULL);
+}
+
+/* Determines the alignment and fixed size (0 if variable-sized) of
+ * @type the same way as gvarianttypeinfo.c does.
+ */
+static void
+g_variant_output_type_layout (const GVariantType *type,
+                              gsize              *alignment,
+                              gsize              *fixed_size)
+{
+  switch (g_variant_type_peek_string (type)[0])
+    {
+    case 'b': case 'y':
+      *alignment = *fixed_size = 1;
+      break;
+
+    case 'n': case 'q':
+      *alignment = *fixed_size = 2;
+      break;
+
+    case 'i': case 'u': case 'h':
+      *alignment = *fixed_size = 4;
+      break;
+
+    case 'x': case 't': case 'd':
+      *alignment = *fixed_size = 8;
+      break;
+
+    case 's': case 'o': case 'g':
+      *alignment = 1;
+      *fixed_size = 0;
+      break;
+
+    case 'v':
+      *alignment = 8;
+      *fixed_size = 0;
+      break;
+
+    case 'a': case 'm':
+      g_variant_output_type_layout (g_variant_type_element (type),
+                                    alignment, fixed_size);
+      *fixed_size = 0;
+      break;
+
+    case '(': case '{':
+      {
+        const GVariantType *member;
+        gboolean fixed = TRUE;
+        gsize offset = 0;
+
+        *alignment = 1;
+
+        for (member = g_variant_type_first (type);
+             member != NULL;
+             member = g_variant_type_next (member))
+          {
+            gsize member_alignment, member_size;
+
+            g_variant_output_type_layout (member, &member_alignment, &member_size);
+            *alignment = MAX (*alignment, member_alignment);
+            offset += (-offset) & (member_alignment - 1);
+            offset += member_size;
+
+            if (member_size == 0)
+              fixed = FALSE;
+          }
+
+        if (!fixed)
+          *fixed_size = 0;
+        else if (offset == 0)
+          /* the unit tuple has a size of 1 */
+          *fixed_size = 1;
+        else
+          *fixed_size = offset + ((-offset) & (*alignment - 1));
+      }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gboolean
+g_variant_output_stream_write (GVariantOutputStream  *stream,
+                               gconstpointer          data,
+                               gsize                  size,
+                               GCancellable          *cancellable,
+                               GError               **error)
+{
+  gsize bytes_written;
+
+  if (size == 0)
+    return TRUE;
+
+  if (!g_output_stream_write_all (G_OUTPUT_STREAM (stream),
+                                  data, size,
+                                  &bytes_written,
+                                  cancellable, error))
+    return FALSE;
+
+  stream->priv->position += size;
+
+  return TRUE;
+}
+
+static gboolean
+g_variant_output_stream_write_zeros (GVariantOutputStream  *stream,
+                                     gsize                  size,
+                                     GCancellable          *cancellable,
+                                     GError               **error)
+{
+  static const guchar zeros[8];
+
+  while (size)
+    {
+      gsize chunk = MIN (size, sizeof zeros);
+
+      if (!g_variant_output_stream_write (stream, zeros, chunk,
+                                          cancellable, error))
+        return FALSE;
+
+      size -= chunk;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+g_variant_output_stream_align (GVariantOutputStream  *stream,
+                               gsize                  alignment,
+                               GCancellable          *cancellable,
+                               GError               **error)
+{
+  return g_variant_output_stream_write_zeros (stream,
+                                              (-stream->priv->position) & (alignment - 1),
+                                              cancellable, error);
+}
+
+/* Writes the framing offsets of @frame, in reverse order for tuples.
+ * The offset size depends on the total size of the container, so this
+ * is the one part that can only be done once all of its items are out.
+ */
+static gboolean
+g_variant_output_stream_write_offsets (GVariantOutputStream  *stream,
+                                       GVariantOutputFrame   *frame,
+                                       gboolean               reverse,
+                                       GCancellable          *cancellable,
+                                       GError               **error)
+{
+  guchar buffer[256];
+  gsize body_size;
+  gsize offset_size;
+  gsize n_offsets;
+  gsize filled;
+  gsize i;
+
+  body_size = stream->priv->position - frame->start;
+  n_offsets = frame->offsets->len;
+
+  if (body_size + n_offsets <= G_MAXUINT8)
+    offset_size = 1;
+  else if (body_size + 2 * n_offsets <= G_MAXUINT16)
+    offset_size = 2;
+  else if (body_size + 4 * n_offsets <= G_MAXUINT32)
+    offset_size = 4;
+  else
+    offset_size = 8;
+
+  filled = 0;
+  for (i = 0; i < n_offsets; i++)
+    {
+      gsize offset;
+      gsize j;
+
+      offset = g_array_index (frame->offsets, gsize,
+                              reverse ? n_offsets - i - 1 : i);
+
+      /* offsets are always little endian */
+      for (j = 0; j < offset_size; j++)
+        buffer[filled++] = (guchar) (((guint64) offset) >> (8 * j));
+
+      if (filled + offset_size > sizeof buffer)
+        {
+          if (!g_variant_output_stream_write (stream, buffer, filled,
+                                              cancellable, error))
+            return FALSE;
+
+          filled = 0;
+        }
+    }
+
+  return g_variant_output_stream_write (stream, buffer, filled,
+                                        cancellable, error);
+}
+
+/* Checks that an item of @type may be added to the innermost open
+ * container and writes the padding in front of it.
+ */
+static gboolean
+g_variant_output_stream_begin_item (GVariantOutputStream  *stream,
+                                    const GVariantType    *type,
+                                    gsize                 *fixed_size,
+                                    GCancellable          *cancellable,
+                                    GError               **error)
+{
+  GPtrArray *frames = stream->priv->frames;
+  gsize alignment;
+
+  if (frames->len)
+    {
+      GVariantOutputFrame *frame = frames->pdata[frames->len - 1];
+
+      switch (g_variant_type_peek_string (frame->type)[0])
+        {
+        case 'm':
+          g_return_val_if_fail (frame->n_children == 0, FALSE);
+          /* fall through */
+
+        case 'a':
+          g_return_val_if_fail (g_variant_type_equal (type, frame->next), FALSE);
+          break;
+
+        case '(': case '{':
+          g_return_val_if_fail (frame->next != NULL, FALSE);
+          g_return_val_if_fail (g_variant_type_equal (type, frame->next), FALSE);
+          break;
+
+        case 'v':
+          g_return_val_if_fail (frame->n_children == 0, FALSE);
+          break;
+        }
+    }
+
+  g_variant_output_type_layout (type, &alignment, fixed_size);
+
+  return g_variant_output_stream_align (stream, alignment, cancellable, error);
+}
+
+/* Records an item of @type that has just been written in full. */
+static void
+g_variant_output_stream_end_item (GVariantOutputStream *stream,
+                                  const GVariantType   *type,
+                                  gsize                 fixed_size)
+{
+  GPtrArray *frames = stream->priv->frames;
+  GVariantOutputFrame *frame;
+  gsize end;
+
+  if (frames->len == 0)
+    {
+      /* the outermost value is complete */
+      stream->priv->position = 0;
+      return;
+    }
+
+  frame = frames->pdata[frames->len - 1];
+  end = stream->priv->position - frame->start;
+  frame->n_children++;
+
+  switch (g_variant_type_peek_string (frame->type)[0])
+    {
+    case 'a':
+      if (frame->element_size == 0)
+        g_array_append_val (frame->offsets, end);
+      break;
+
+    case '(': case '{':
+      frame->next = g_variant_type_next (frame->next);
+
+      /* no offset is stored for the last member */
+      if (fixed_size == 0 && frame->next != NULL)
+        g_array_append_val (frame->offsets, end);
+      break;
+
+    case 'v':
+      frame->child_type = g_variant_type_copy (type);
+      break;
+    }
+}
+
+/**
+ * g_variant_output_stream_open_container:
+ * @stream: a #GVariantOutputStream
+ * @type: a definite container type
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: a #GError, %NULL to ignore.
+ *
+ * Opens a container of type @type as the next item of @stream.
+ *
+ * @type must be definite and must be what the innermost open container
+ * expects next, in the same way as for g_variant_builder_open().  If
+ * no container is open, this starts a new value.
+ *
+ * The items of the container are added with subsequent calls to this
+ * function, g_variant_output_stream_put_value() and
+ * g_variant_output_stream_put_array_data(), after which the container
+ * must be closed with g_variant_output_stream_close_container().
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error.
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_output_stream_open_container (GVariantOutputStream  *stream,
+                                        const GVariantType    *type,
+                                        GCancellable          *cancellable,
+                                        GError               **error)
+{
+  GVariantOutputFrame *frame;
+  gsize fixed_size;
+
+  g_return_val_if_fail (G_IS_VARIANT_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (g_variant_type_is_definite (type), FALSE);
+  g_return_val_if_fail (g_variant_type_is_container (type), FALSE);
+
+  if (!g_variant_output_stream_begin_item (stream, type, &fixed_size,
+                                           cancellable, error))
+    return FALSE;
+
+  frame = g_slice_new0 (GVariantOutputFrame);
+  frame->type = g_variant_type_copy (type);
+  frame->start = stream->priv->position;
+  frame->offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+  switch (g_variant_type_peek_string (type)[0])
+    {
+    case 'a': case 'm':
+      frame->next = g_variant_type_element (frame->type);
+      g_variant_output_type_layout (frame->next,
+                                    &frame->element_alignment,
+                                    &frame->element_size);
+      break;
+
+    case '(': case '{':
+      frame->next = g_variant_type_first (frame->type);
+      break;
+    }
+
+  g_ptr_array_add (stream->priv->frames, frame);
+
+  return TRUE;
+}
+
+/**
+ * g_variant_output_stream_close_container:
+ * @stream: a #GVariantOutputStream
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: a #GError, %NULL to ignore.
+ *
+ * Closes the container that was most recently opened with
+ * g_variant_output_stream_open_container(), writing its framing
+ * offsets.
+ *
+ * A tuple or dictionary entry must have had all of its members added
+ * and a variant must have had its child added.
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error.
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_output_stream_close_container (GVariantOutputStream  *stream,
+                                         GCancellable          *cancellable,
+                                         GError               **error)
+{
+  GPtrArray *frames;
+  GVariantOutputFrame *frame;
+  GVariantType *type;
+  gsize alignment;
+  gsize fixed_size;
+  gboolean success;
+
+  g_return_val_if_fail (G_IS_VARIANT_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (stream->priv->frames->len > 0, FALSE);
+
+  frames = stream->priv->frames;
+  frame = frames->pdata[frames->len - 1];
+  g_variant_output_type_layout (frame->type, &alignment, &fixed_size);
+
+  switch (g_variant_type_peek_string (frame->type)[0])
+    {
+    case 'a':
+      if (frame->element_size == 0)
+        success = g_variant_output_stream_write_offsets (stream, frame, FALSE,
+                                                         cancellable, error);
+      else
+        success = TRUE;
+      break;
+
+    case 'm':
+      /* a variable-sized child is followed by a zero byte */
+      if (frame->n_children && frame->element_size == 0)
+        success = g_variant_output_stream_write_zeros (stream, 1,
+                                                       cancellable, error);
+      else
+        success = TRUE;
+      break;
+
+    case '(': case '{':
+      g_return_val_if_fail (frame->next == NULL, FALSE);
+
+      if (fixed_size)
+        success = g_variant_output_stream_write_zeros (stream,
+                                                       frame->start + fixed_size -
+                                                       stream->priv->position,
+                                                       cancellable, error);
+      else
+        success = g_variant_output_stream_write_offsets (stream, frame, TRUE,
+                                                         cancellable, error);
+      break;
+
+    case 'v':
+      {
+        const gchar *type_string;
+
+        g_return_val_if_fail (frame->n_children == 1, FALSE);
+
+        type_string = g_variant_type_peek_string (frame->child_type);
+        success = g_variant_output_stream_write_zeros (stream, 1,
+                                                       cancellable, error) &&
+                  g_variant_output_stream_write (stream, type_string,
+                                                 g_variant_type_get_string_length (frame->child_type),
+                                                 cancellable, error);
+      }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  type = frame->type;
+  frame->type = NULL;
+  g_ptr_array_set_size (frames, frames->len - 1);
+
+  if (success)
+    g_variant_output_stream_end_item (stream, type, fixed_size);
+
+  g_variant_type_free (type);
+
+  return success;
+}
+
+/**
+ * g_variant_output_stream_put_value:
+ * @stream: a #GVariantOutputStream
+ * @value: a #GVariant
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: a #GError, %NULL to ignore.
+ *
+ * Writes @value as the next item of @stream, in the same way as
+ * g_variant_builder_add_value().  If no container is open, @value is
+ * written as a complete value of its own.
+ *
+ * If @value is a floating reference it is consumed.
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error.
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_output_stream_put_value (GVariantOutputStream  *stream,
+                                   GVariant              *value,
+                                   GCancellable          *cancellable,
+                                   GError               **error)
+{
+  const GVariantType *type;
+  gsize fixed_size;
+  gboolean success;
+
+  g_return_val_if_fail (G_IS_VARIANT_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  g_variant_ref_sink (value);
+  type = g_variant_get_type (value);
+
+  success = g_variant_output_stream_begin_item (stream, type, &fixed_size,
+                                                cancellable, error) &&
+            g_variant_output_stream_write (stream,
+                                           g_variant_get_data (value),
+                                           g_variant_get_size (value),
+                                           cancellable, error);
+
+  if (success)
+    g_variant_output_stream_end_item (stream, type, fixed_size);
+
+  g_variant_unref (value);
+
+  return success;
+}
+
+/**
+ * g_variant_output_stream_put_array_data:
+ * @stream: a #GVariantOutputStream
+ * @data: (array length=size) (element-type guint8): the serialised items
+ * @size: the size of @data, in bytes
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @error: a #GError, %NULL to ignore.
+ *
+ * Appends a run of items to the innermost open container, which must
+ * be an array with a fixed-sized element type, such as a bytestring.
+ *
+ * @data is the serialised form of the items, in the byte order of the
+ * machine, and @size must be a multiple of the element size.  This is
+ * equivalent to calling g_variant_output_stream_put_value() once for
+ * each item, but a lot faster.
+ *
+ * Returns: %TRUE on success, %FALSE if there was an error.
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_output_stream_put_array_data (GVariantOutputStream  *stream,
+                                        gconstpointer          data,
+                                        gsize                  size,
+                                        GCancellable          *cancellable,
+                                        GError               **error)
+{
+  GPtrArray *frames;
+  GVariantOutputFrame *frame;
+
+  g_return_val_if_fail (G_IS_VARIANT_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (data != NULL || size == 0, FALSE);
+  g_return_val_if_fail (stream->priv->frames->len > 0, FALSE);
+
+  frames = stream->priv->frames;
+  frame = frames->pdata[frames->len - 1];
+
+  g_return_val_if_fail (g_variant_type_is_array (frame->type), FALSE);
+  g_return_val_if_fail (frame->element_size != 0, FALSE);
+  g_return_val_if_fail (size % frame->element_size == 0, FALSE);
+
+  if (!g_variant_output_stream_align (stream, frame->element_alignment,
+                                      cancellable, error) ||
+      !g_variant_output_stream_write (stream, data, size, cancellable, error))
+    return FALSE;
+
+  frame->n_children += size / frame->element_size;
+
+  return TRUE;
+}
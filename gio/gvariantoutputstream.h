@@ -0,0 +1,99 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_VARIANT_OUTPUT_STREAM_H__
+#define __G_VARIANT_OUTPUT_STREAM_H__
+
+#if !defined (__GIO_GIO_H_INSIDE__) && !defined (GIO_COMPILATION)
+#error "Only <gio/gio.h> can be included directly."
+#endif
+
+#include <gio/gfilteroutputstream.h>
+
+G_BEGIN_DECLS
+
+#define G_TYPE_VARIANT_OUTPUT_STREAM         (g_variant_output_stream_get_type ())
+#define G_VARIANT_OUTPUT_STREAM(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_TYPE_VARIANT_OUTPUT_STREAM, GVariantOutputStream))
+#define G_VARIANT_OUTPUT_STREAM_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_TYPE_VARIANT_OUTPUT_STREAM, GVariantOutputStreamClass))
+#define G_IS_VARIANT_OUTPUT_STREAM(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_TYPE_VARIANT_OUTPUT_STREAM))
+#define G_IS_VARIANT_OUTPUT_STREAM_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_TYPE_VARIANT_OUTPUT_STREAM))
+#define G_VARIANT_OUTPUT_STREAM_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_TYPE_VARIANT_OUTPUT_STREAM, GVariantOutputStreamClass))
+
+/**
+ * GVariantOutputStream:
+ *
+ * An implementation of #GFilterOutputStream that writes #GVariant
+ * values in serialised form, one container item at a time.
+ *
+ * Since: 2.40
+ **/
+typedef struct _GVariantOutputStream         GVariantOutputStream;
+typedef struct _GVariantOutputStreamClass    GVariantOutputStreamClass;
+typedef struct _GVariantOutputStreamPrivate  GVariantOutputStreamPrivate;
+
+struct _GVariantOutputStream
+{
+  GFilterOutputStream parent_instance;
+
+  /*< private >*/
+  GVariantOutputStreamPrivate *priv;
+};
+
+struct _GVariantOutputStreamClass
+{
+  GFilterOutputStreamClass parent_class;
+
+  /*< private >*/
+  /* Padding for future expansion */
+  void (*_g_reserved1) (void);
+  void (*_g_reserved2) (void);
+  void (*_g_reserved3) (void);
+  void (*_g_reserved4) (void);
+  void (*_g_reserved5) (void);
+};
+
+
+GLIB_AVAILABLE_IN_2_40
+GType                  g_variant_output_stream_get_type          (void) G_GNUC_CONST;
+GLIB_AVAILABLE_IN_2_40
+GVariantOutputStream * g_variant_output_stream_new               (GOutputStream         *base_stream);
+
+GLIB_AVAILABLE_IN_2_40
+gboolean               g_variant_output_stream_open_container    (GVariantOutputStream  *stream,
+                                                                  const GVariantType    *type,
+                                                                  GCancellable          *cancellable,
+                                                                  GError               **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean               g_variant_output_stream_close_container   (GVariantOutputStream  *stream,
+                                                                  GCancellable          *cancellable,
+                                                                  GError               **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean               g_variant_output_stream_put_value         (GVariantOutputStream  *stream,
+                                                                  GVariant              *value,
+                                                                  GCancellable          *cancellable,
+                                                                  GError               **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean               g_variant_output_stream_put_array_data    (GVariantOutputStream  *stream,
+                                                                  gconstpointer          data,
+                                                                  gsize                  size,
+                                                                  GCancellable          *cancellable,
+                                                                  GError               **error);
+
+G_END_DECLS
+
+#endif /* __G_VARIANT_OUTPUT_STREAM_H__ */
@@ -342,6 +342,28 @@ file_builder_allocate_for_hash (FileBuilder            *fb,
   memset (*bloom_filter, 0, n_bloom_words * sizeof (guint32_le));
 }
 
+/* Each key sets two bits in one word of the bloom filter: the word is
+ * picked by the low bits of the hash value (above the first five),
+ * the second bit by its top bits.  About 16 bits per key let most
+ * lookups of missing keys stop at the filter, touching one cache line.
+ */
+#define BLOOM_SHIFT 27
+#define BLOOM_BITS_PER_ITEM 16
+
+static void
+file_builder_add_to_bloom_filter (guint32_le *bloom_filter,
+                                  gsize       n_bloom_words,
+                                  guint32     hash_value)
+{
+  guint32 word, mask;
+
+  word = (hash_value / 32) % n_bloom_words;
+  mask = 1 << (hash_value & 31);
+  mask |= 1 << ((hash_value >> BLOOM_SHIFT) & 31);
+
+  bloom_filter[word] = guint32_to_le (guint32_from_le (bloom_filter[word]) | mask);
+}
+
 static void
 file_builder_add_hash (FileBuilder         *fb,
                        GHashTable          *table,
@@ -351,6 +373,7 @@ file_builder_add_hash (FileBuilder         *fb,
   struct gvdb_hash_item *items;
   HashTable *mytable;
   GvdbItem *item;
+  gsize n_bloom_words;
   guint32 index;
   gint bucket;
 
@@ -362,9 +385,14 @@ file_builder_add_hash (FileBuilder         *fb,
     for (item = mytable->buckets[bucket]; item; item = item->next)
       item->assigned_index = guint32_to_le (index++);
 
-  file_builder_allocate_for_hash (fb, mytable->n_buckets, index, 5, 0,
+  n_bloom_words = (index * BLOOM_BITS_PER_ITEM + 31) / 32;
+  file_builder_allocate_for_hash (fb, mytable->n_buckets, index,
+                                  BLOOM_SHIFT, n_bloom_words,
                                   &bloom_filter, &buckets, &items, pointer);
 
+  /* The keys go right after the table, ahead of any values, so that
+   * comparing them during a lookup stays close to the hash items.
+   */
   index = 0;
   for (bucket = 0; bucket < mytable->n_buckets; bucket++)
     {
@@ -372,7 +400,7 @@ file_builder_add_hash (FileBuilder         *fb,
 
       for (item = mytable->buckets[bucket]; item; item = item->next)
         {
-          struct gvdb_hash_item *entry = items++;
+          struct gvdb_hash_item *entry = &items[index];
           const gchar *basename;
 
           g_assert (index == guint32_from_le (item->assigned_index));
@@ -380,6 +408,9 @@ file_builder_add_hash (FileBuilder         *fb,
           entry->parent = item_to_index (item->parent);
           entry->unused = 0;
 
+          file_builder_add_to_bloom_filter (bloom_filter, n_bloom_words,
+                                            item->hash_value);
+
           if (item->parent != NULL)
             basename = item->key + strlen (item->parent->key);
           else
@@ -389,44 +420,51 @@ file_builder_add_hash (FileBuilder         *fb,
                                    &entry->key_start,
                                    &entry->key_size);
 
-          if (item->value != NULL)
-            {
-              g_assert (item->child == NULL && item->table == NULL);
+          index++;
+        }
+    }
+
+  index = 0;
+  for (bucket = 0; bucket < mytable->n_buckets; bucket++)
+    for (item = mytable->buckets[bucket]; item; item = item->next)
+      {
+        struct gvdb_hash_item *entry = &items[index++];
 
-              file_builder_add_value (fb, item->value, &entry->value.pointer);
-              entry->type = 'v';
-            }
+        if (item->value != NULL)
+          {
+            g_assert (item->child == NULL && item->table == NULL);
 
-          if (item->child != NULL)
-            {
-              guint32 children = 0, i = 0;
-              guint32_le *offsets;
-              GvdbItem *child;
+            file_builder_add_value (fb, item->value, &entry->value.pointer);
+            entry->type = 'v';
+          }
 
-              g_assert (item->table == NULL);
+        if (item->child != NULL)
+          {
+            guint32 children = 0, i = 0;
+            guint32_le *offsets;
+            GvdbItem *child;
 
-              for (child = item->child; child; child = child->sibling)
-                children++;
+            g_assert (item->table == NULL);
 
-              offsets = file_builder_allocate (fb, 4, 4 * children,
-                                               &entry->value.pointer);
-              entry->type = 'L';
+            for (child = item->child; child; child = child->sibling)
+              children++;
 
-              for (child = item->child; child; child = child->sibling)
-                offsets[i++] = child->assigned_index;
+            offsets = file_builder_allocate (fb, 4, 4 * children,
+                                             &entry->value.pointer);
+            entry->type = 'L';
 
-              g_assert (children == i);
-            }
+            for (child = item->child; child; child = child->sibling)
+              offsets[i++] = child->assigned_index;
 
-          if (item->table != NULL)
-            {
-              entry->type = 'H';
-              file_builder_add_hash (fb, item->table, &entry->value.pointer);
-            }
+            g_assert (children == i);
+          }
 
-          index++;
-        }
-    }
+        if (item->table != NULL)
+          {
+            entry->type = 'H';
+            file_builder_add_hash (fb, item->table, &entry->value.pointer);
+          }
+      }
 
   hash_table_free (mytable);
 }
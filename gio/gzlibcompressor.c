@@ -39,9 +39,15 @@ enum {
   PROP_0,
   PROP_FORMAT,
   PROP_LEVEL,
-  PROP_FILE_INFO
+  PROP_FILE_INFO,
+  PROP_DICTIONARY,
+  PROP_PARALLEL
 };
 
+/* Input block size and deflate window for the parallel mode */
+#define PARALLEL_BLOCK_SIZE (128 * 1024)
+#define PARALLEL_WINDOW_SIZE (32 * 1024)
+
 /**
  * SECTION:gzcompressor
  * @short_description: Zlib compressor
@@ -49,6 +55,12 @@ enum {
  *
  * #GZlibCompressor is an implementation of #GConverter that
  * compresses data using zlib.
+ *
+ * Since 2.40, the compressor can spread the work over several threads
+ * by setting #GZlibCompressor:parallel. The input is then cut into
+ * blocks which are deflated independently, each primed with the end
+ * of the block before it, and concatenated into a single valid stream
+ * in the requested format.
  */
 
 static void g_zlib_compressor_iface_init          (GConverterIface *iface);
@@ -67,8 +79,56 @@ struct _GZlibCompressor
   z_stream zstream;
   gz_header gzheader;
   GFileInfo *file_info;
+  GBytes *dictionary;
+
+  /* parallel mode */
+  gboolean parallel;
+  GThreadPool *pool;
+  guint max_jobs;
+  GMutex lock;
+  GCond cond;
+  GQueue jobs;
+  GByteArray *block;
+  GByteArray *window;
+  GByteArray *pending;
+  gsize pending_offset;
+  gsize job_offset;
+  guint32 check;
+  guint64 total_in;
+  guint started : 1;
+  guint ended : 1;
+  guint trailer_queued : 1;
 };
 
+typedef struct
+{
+  GZlibCompressor *compressor;
+  GBytes *input;
+  GBytes *dictionary;
+  gboolean last;
+  GByteArray *output;
+  guint32 check;
+  gboolean done;
+} ParallelJob;
+
+static void parallel_clear (GZlibCompressor *compressor);
+
+static void
+g_zlib_compressor_set_dictionary (GZlibCompressor *compressor)
+{
+  gconstpointer data;
+  gsize size;
+
+  /* The gzip format has no way to reference a preset dictionary */
+  if (compressor->dictionary == NULL ||
+      compressor->format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    return;
+
+  data = g_bytes_get_data (compressor->dictionary, &size);
+  if (deflateSetDictionary (&compressor->zstream, data, size) != Z_OK)
+    g_warning ("unexpected zlib error: %s\n", compressor->zstream.msg);
+}
+
 static void
 g_zlib_compressor_set_gzheader (GZlibCompressor *compressor)
 {
@@ -109,9 +169,24 @@ g_zlib_compressor_finalize (GObject *object)
 
   deflateEnd (&compressor->zstream);
 
+  if (compressor->parallel)
+    {
+      if (compressor->pool)
+        g_thread_pool_free (compressor->pool, FALSE, TRUE);
+      parallel_clear (compressor);
+      g_byte_array_unref (compressor->block);
+      g_byte_array_unref (compressor->window);
+      g_byte_array_unref (compressor->pending);
+      g_mutex_clear (&compressor->lock);
+      g_cond_clear (&compressor->cond);
+    }
+
   if (compressor->file_info)
     g_object_unref (compressor->file_info);
 
+  if (compressor->dictionary)
+    g_bytes_unref (compressor->dictionary);
+
   G_OBJECT_CLASS (g_zlib_compressor_parent_class)->finalize (object);
 }
 
@@ -140,6 +215,14 @@ g_zlib_compressor_set_property (GObject      *object,
       g_zlib_compressor_set_file_info (compressor, g_value_get_object (value));
       break;
 
+    case PROP_DICTIONARY:
+      compressor->dictionary = g_value_dup_boxed (value);
+      break;
+
+    case PROP_PARALLEL:
+      compressor->parallel = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -171,6 +254,14 @@ g_zlib_compressor_get_property (GObject    *object,
       g_value_set_object (value, compressor->file_info);
       break;
 
+    case PROP_DICTIONARY:
+      g_value_set_boxed (value, compressor->dictionary);
+      break;
+
+    case PROP_PARALLEL:
+      g_value_set_boolean (value, compressor->parallel);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -216,6 +307,19 @@ g_zlib_compressor_constructed (GObject *object)
     g_warning ("unexpected zlib error: %s\n", compressor->zstream.msg);
 
   g_zlib_compressor_set_gzheader (compressor);
+  g_zlib_compressor_set_dictionary (compressor);
+
+  if (compressor->parallel)
+    {
+      g_mutex_init (&compressor->lock);
+      g_cond_init (&compressor->cond);
+      g_queue_init (&compressor->jobs);
+      compressor->block = g_byte_array_sized_new (PARALLEL_BLOCK_SIZE);
+      compressor->window = g_byte_array_sized_new (PARALLEL_WINDOW_SIZE);
+      compressor->pending = g_byte_array_new ();
+      compressor->max_jobs = 2 * MAX (g_get_num_processors (), 1);
+      parallel_clear (compressor);
+    }
 }
 
 static void
@@ -265,6 +369,54 @@ g_zlib_compressor_class_init (GZlibCompressorClass *klass)
                                                        G_TYPE_FILE_INFO,
                                                        G_PARAM_READWRITE |
                                                        G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GZlibCompressor:dictionary:
+   *
+   * If set to a non-%NULL #GBytes, the contents are used as a preset
+   * dictionary for the compression. This can considerably improve the
+   * compression of short payloads that share a lot of content with the
+   * dictionary; the data must be decompressed with a #GZlibDecompressor
+   * whose #GZlibDecompressor:dictionary property is set to the same
+   * bytes.
+   *
+   * The dictionary is ignored if #GZlibCompressor:format is
+   * %G_ZLIB_COMPRESSOR_FORMAT_GZIP, since that format cannot express it.
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_DICTIONARY,
+                                   g_param_spec_boxed ("dictionary",
+                                                       P_("dictionary"),
+                                                       P_("Preset dictionary for the compression"),
+                                                       G_TYPE_BYTES,
+                                                       G_PARAM_READWRITE |
+                                                       G_PARAM_CONSTRUCT_ONLY |
+                                                       G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GZlibCompressor:parallel:
+   *
+   * Whether to compress blocks of the input concurrently on a pool of
+   * threads, one per processor. This speeds up compressing large
+   * amounts of data considerably, at the price of a slightly worse
+   * compression ratio and of buffering up to a few megabytes of input.
+   *
+   * The output is a regular stream in the requested
+   * #GZlibCompressor:format that any decompressor can read.
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_PARALLEL,
+                                   g_param_spec_boolean ("parallel",
+                                                         P_("parallel"),
+                                                         P_("Whether to compress blocks of input in parallel"),
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT_ONLY |
+                                                         G_PARAM_STATIC_STRINGS));
 }
 
 /**
@@ -351,12 +503,445 @@ g_zlib_compressor_reset (GConverter *converter)
   GZlibCompressor *compressor = G_ZLIB_COMPRESSOR (converter);
   int res;
 
+  if (compressor->parallel)
+    {
+      parallel_clear (compressor);
+      return;
+    }
+
   res = deflateReset (&compressor->zstream);
   if (res != Z_OK)
     g_warning ("unexpected zlib error: %s\n", compressor->zstream.msg);
 
-  /* deflateReset reset the header too, so re-set it */
+  /* deflateReset reset the header and dictionary too, so re-set them */
   g_zlib_compressor_set_gzheader (compressor);
+  g_zlib_compressor_set_dictionary (compressor);
+}
+
+static void
+parallel_job_free (ParallelJob *job)
+{
+  g_bytes_unref (job->input);
+  if (job->dictionary)
+    g_bytes_unref (job->dictionary);
+  if (job->output)
+    g_byte_array_unref (job->output);
+  g_slice_free (ParallelJob, job);
+}
+
+/* Runs in the thread pool */
+static void
+parallel_job_run (gpointer data,
+                  gpointer user_data)
+{
+  ParallelJob *job = data;
+  GZlibCompressor *compressor = job->compressor;
+  z_stream zstream;
+  gconstpointer input;
+  gsize input_size, produced;
+  int res;
+
+  input = g_bytes_get_data (job->input, &input_size);
+
+  memset (&zstream, 0, sizeof (zstream));
+  res = deflateInit2 (&zstream, compressor->level, Z_DEFLATED,
+                      -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  if (res == Z_MEM_ERROR)
+    g_error ("GZlibCompressor: Not enough memory for zlib use");
+
+  if (job->dictionary)
+    {
+      gconstpointer dict;
+      gsize dict_size;
+
+      dict = g_bytes_get_data (job->dictionary, &dict_size);
+      deflateSetDictionary (&zstream, dict, dict_size);
+    }
+
+  job->output = g_byte_array_sized_new (deflateBound (&zstream, input_size) + 16);
+  g_byte_array_set_size (job->output, deflateBound (&zstream, input_size) + 16);
+
+  zstream.next_in = (void *)input;
+  zstream.avail_in = input_size;
+  produced = 0;
+
+  /* Every block but the last ends with a sync flush, which aligns
+   * it to a byte boundary so the blocks can simply be concatenated. */
+  while (TRUE)
+    {
+      zstream.next_out = job->output->data + produced;
+      zstream.avail_out = job->output->len - produced;
+      res = deflate (&zstream, job->last ? Z_FINISH : Z_SYNC_FLUSH);
+      produced = job->output->len - zstream.avail_out;
+
+      if (job->last ? res == Z_STREAM_END : zstream.avail_out > 0)
+        break;
+
+      g_byte_array_set_size (job->output, job->output->len * 2);
+    }
+
+  g_byte_array_set_size (job->output, produced);
+  deflateEnd (&zstream);
+
+  if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    job->check = crc32 (0, input, input_size);
+  else
+    job->check = adler32 (1, input, input_size);
+
+  g_mutex_lock (&compressor->lock);
+  job->done = TRUE;
+  g_cond_broadcast (&compressor->cond);
+  g_mutex_unlock (&compressor->lock);
+}
+
+static void
+parallel_append_uint32 (GByteArray *array,
+                        guint32     value,
+                        gboolean    big_endian)
+{
+  guint8 bytes[4];
+  gint i;
+
+  for (i = 0; i < 4; i++)
+    bytes[big_endian ? 3 - i : i] = (value >> (8 * i)) & 0xff;
+
+  g_byte_array_append (array, bytes, 4);
+}
+
+static void
+parallel_queue_header (GZlibCompressor *compressor)
+{
+  if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    {
+      guint8 header[10] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 0x03 };
+      const gchar *filename = NULL;
+      guint32 mtime = 0;
+
+      if (compressor->file_info)
+        {
+          filename = g_file_info_get_name (compressor->file_info);
+          mtime = g_file_info_get_attribute_uint64 (compressor->file_info,
+                                                    G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        }
+
+      if (filename)
+        header[3] |= 0x08; /* FNAME */
+      header[4] = mtime & 0xff;
+      header[5] = (mtime >> 8) & 0xff;
+      header[6] = (mtime >> 16) & 0xff;
+      header[7] = (mtime >> 24) & 0xff;
+      if (compressor->level == 9)
+        header[8] = 2;
+      else if (compressor->level == 1)
+        header[8] = 4;
+
+      g_byte_array_append (compressor->pending, header, sizeof header);
+      if (filename)
+        g_byte_array_append (compressor->pending,
+                             (const guint8 *) filename, strlen (filename) + 1);
+    }
+  else if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_ZLIB)
+    {
+      guint8 header[2];
+      guint flevel;
+
+      if (compressor->level == 0 || compressor->level == 1)
+        flevel = 0;
+      else if (compressor->level >= 2 && compressor->level <= 5)
+        flevel = 1;
+      else if (compressor->level >= 7)
+        flevel = 3;
+      else
+        flevel = 2;
+
+      header[0] = 0x78; /* deflate, 32k window */
+      header[1] = flevel << 6;
+      if (compressor->dictionary)
+        header[1] |= 0x20; /* FDICT */
+      header[1] += 31 - ((header[0] << 8) + header[1]) % 31;
+
+      g_byte_array_append (compressor->pending, header, sizeof header);
+      if (compressor->dictionary)
+        {
+          gconstpointer dict;
+          gsize dict_size;
+
+          dict = g_bytes_get_data (compressor->dictionary, &dict_size);
+          parallel_append_uint32 (compressor->pending,
+                                  adler32 (1, dict, dict_size), TRUE);
+        }
+    }
+}
+
+static void
+parallel_queue_trailer (GZlibCompressor *compressor)
+{
+  if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    {
+      parallel_append_uint32 (compressor->pending, compressor->check, FALSE);
+      parallel_append_uint32 (compressor->pending, compressor->total_in & 0xffffffff, FALSE);
+    }
+  else if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_ZLIB)
+    parallel_append_uint32 (compressor->pending, compressor->check, TRUE);
+
+  compressor->trailer_queued = TRUE;
+}
+
+static void
+parallel_window_append (GByteArray   *window,
+                        const guint8 *data,
+                        gsize         size)
+{
+  if (size >= PARALLEL_WINDOW_SIZE)
+    {
+      g_byte_array_set_size (window, 0);
+      g_byte_array_append (window, data + size - PARALLEL_WINDOW_SIZE,
+                           PARALLEL_WINDOW_SIZE);
+      return;
+    }
+
+  g_byte_array_append (window, data, size);
+  if (window->len > PARALLEL_WINDOW_SIZE)
+    g_byte_array_remove_range (window, 0, window->len - PARALLEL_WINDOW_SIZE);
+}
+
+/* Resets the parallel state, waiting for outstanding jobs */
+static void
+parallel_clear (GZlibCompressor *compressor)
+{
+  ParallelJob *job;
+
+  while ((job = g_queue_pop_head (&compressor->jobs)) != NULL)
+    {
+      g_mutex_lock (&compressor->lock);
+      while (!job->done)
+        g_cond_wait (&compressor->cond, &compressor->lock);
+      g_mutex_unlock (&compressor->lock);
+
+      parallel_job_free (job);
+    }
+
+  g_byte_array_set_size (compressor->block, 0);
+  g_byte_array_set_size (compressor->window, 0);
+  g_byte_array_set_size (compressor->pending, 0);
+  compressor->pending_offset = 0;
+  compressor->job_offset = 0;
+  compressor->total_in = 0;
+  compressor->started = FALSE;
+  compressor->ended = FALSE;
+  compressor->trailer_queued = FALSE;
+
+  if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    compressor->check = crc32 (0, NULL, 0);
+  else
+    compressor->check = adler32 (0, NULL, 0);
+
+  /* The gzip format has no way to reference a preset dictionary */
+  if (compressor->dictionary &&
+      compressor->format != G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    {
+      gconstpointer dict;
+      gsize dict_size;
+
+      dict = g_bytes_get_data (compressor->dictionary, &dict_size);
+      parallel_window_append (compressor->window, dict, dict_size);
+    }
+}
+
+static void
+parallel_submit (GZlibCompressor *compressor,
+                 gboolean         last)
+{
+  ParallelJob *job;
+
+  if (compressor->pool == NULL)
+    compressor->pool = g_thread_pool_new (parallel_job_run, NULL,
+                                          compressor->max_jobs / 2,
+                                          FALSE, NULL);
+
+  job = g_slice_new0 (ParallelJob);
+  job->compressor = compressor;
+  job->last = last;
+  if (compressor->window->len > 0)
+    job->dictionary = g_bytes_new (compressor->window->data,
+                                   compressor->window->len);
+
+  parallel_window_append (compressor->window,
+                          compressor->block->data, compressor->block->len);
+  compressor->total_in += compressor->block->len;
+
+  job->input = g_byte_array_free_to_bytes (compressor->block);
+  compressor->block = g_byte_array_sized_new (PARALLEL_BLOCK_SIZE);
+
+  g_queue_push_tail (&compressor->jobs, job);
+  g_thread_pool_push (compressor->pool, job, NULL);
+}
+
+/* Copies out whatever compressed data is ready, in order. If @wait
+ * is set, waits for outstanding jobs until @outbuf is full or
+ * everything has been written. */
+static gsize
+parallel_write_out (GZlibCompressor *compressor,
+                    guint8          *outbuf,
+                    gsize            outbuf_size,
+                    gboolean         wait)
+{
+  gsize written = 0;
+  gsize n;
+
+  while (written < outbuf_size)
+    {
+      ParallelJob *job;
+      gboolean done;
+
+      if (compressor->pending_offset < compressor->pending->len)
+        {
+          n = MIN (outbuf_size - written,
+                   compressor->pending->len - compressor->pending_offset);
+          memcpy (outbuf + written,
+                  compressor->pending->data + compressor->pending_offset, n);
+          compressor->pending_offset += n;
+          written += n;
+          continue;
+        }
+
+      job = g_queue_peek_head (&compressor->jobs);
+      if (job == NULL)
+        {
+          if (compressor->ended && !compressor->trailer_queued)
+            {
+              parallel_queue_trailer (compressor);
+              continue;
+            }
+          break;
+        }
+
+      g_mutex_lock (&compressor->lock);
+      while (wait && !job->done)
+        g_cond_wait (&compressor->cond, &compressor->lock);
+      done = job->done;
+      g_mutex_unlock (&compressor->lock);
+
+      if (!done)
+        break;
+
+      n = MIN (outbuf_size - written, job->output->len - compressor->job_offset);
+      memcpy (outbuf + written, job->output->data + compressor->job_offset, n);
+      compressor->job_offset += n;
+      written += n;
+
+      if (compressor->job_offset == job->output->len)
+        {
+          if (compressor->format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+            compressor->check = crc32_combine (compressor->check, job->check,
+                                               g_bytes_get_size (job->input));
+          else
+            compressor->check = adler32_combine (compressor->check, job->check,
+                                                 g_bytes_get_size (job->input));
+
+          g_queue_pop_head (&compressor->jobs);
+          parallel_job_free (job);
+          compressor->job_offset = 0;
+        }
+    }
+
+  return written;
+}
+
+static gboolean
+parallel_has_output (GZlibCompressor *compressor)
+{
+  return compressor->pending_offset < compressor->pending->len ||
+    !g_queue_is_empty (&compressor->jobs) ||
+    (compressor->ended && !compressor->trailer_queued);
+}
+
+static GConverterResult
+g_zlib_compressor_convert_parallel (GZlibCompressor *compressor,
+                                    const guint8    *inbuf,
+                                    gsize            inbuf_size,
+                                    guint8          *outbuf,
+                                    gsize            outbuf_size,
+                                    GConverterFlags  flags,
+                                    gsize           *bytes_read,
+                                    gsize           *bytes_written,
+                                    GError         **error)
+{
+  gsize read = 0, written = 0;
+  gboolean draining;
+
+  if (!compressor->started)
+    {
+      parallel_queue_header (compressor);
+      compressor->started = TRUE;
+    }
+
+  written += parallel_write_out (compressor, outbuf, outbuf_size, FALSE);
+
+  /* Take as much input as we have room for in the job queue */
+  while (read < inbuf_size)
+    {
+      gsize n;
+
+      if (compressor->block->len == PARALLEL_BLOCK_SIZE)
+        {
+          if (g_queue_get_length (&compressor->jobs) >= compressor->max_jobs)
+            break;
+          parallel_submit (compressor, FALSE);
+        }
+
+      n = MIN (inbuf_size - read, PARALLEL_BLOCK_SIZE - compressor->block->len);
+      g_byte_array_append (compressor->block, inbuf + read, n);
+      read += n;
+    }
+
+  draining = FALSE;
+  if (read == inbuf_size &&
+      (flags & (G_CONVERTER_INPUT_AT_END | G_CONVERTER_FLUSH)) &&
+      !compressor->ended)
+    {
+      if (g_queue_get_length (&compressor->jobs) < compressor->max_jobs)
+        {
+          if (flags & G_CONVERTER_INPUT_AT_END)
+            {
+              parallel_submit (compressor, TRUE);
+              compressor->ended = TRUE;
+            }
+          else if (compressor->block->len > 0)
+            parallel_submit (compressor, FALSE);
+        }
+      draining = TRUE;
+    }
+  else if (compressor->block->len == PARALLEL_BLOCK_SIZE &&
+           g_queue_get_length (&compressor->jobs) < compressor->max_jobs)
+    parallel_submit (compressor, FALSE);
+
+  written += parallel_write_out (compressor, outbuf + written,
+                                 outbuf_size - written,
+                                 draining || (read == 0 && written == 0));
+
+  *bytes_read = read;
+  *bytes_written = written;
+
+  if (compressor->ended && !parallel_has_output (compressor))
+    return G_CONVERTER_FINISHED;
+
+  if ((flags & G_CONVERTER_FLUSH) && draining &&
+      compressor->block->len == 0 && !parallel_has_output (compressor))
+    return G_CONVERTER_FLUSHED;
+
+  if (read == 0 && written == 0)
+    {
+      if (parallel_has_output (compressor))
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+                             _("Not enough space in destination"));
+      else
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                             _("Need more input"));
+      return G_CONVERTER_ERROR;
+    }
+
+  return G_CONVERTER_CONVERTED;
 }
 
 static GConverterResult
@@ -376,6 +961,12 @@ g_zlib_compressor_convert (GConverter *converter,
 
   compressor = G_ZLIB_COMPRESSOR (converter);
 
+  if (compressor->parallel)
+    return g_zlib_compressor_convert_parallel (compressor, inbuf, inbuf_size,
+                                               outbuf, outbuf_size, flags,
+                                               bytes_read, bytes_written,
+                                               error);
+
   compressor->zstream.next_in = (void *)inbuf;
   compressor->zstream.avail_in = inbuf_size;
 
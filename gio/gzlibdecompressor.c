@@ -38,7 +38,8 @@
 enum {
   PROP_0,
   PROP_FORMAT,
-  PROP_FILE_INFO
+  PROP_FILE_INFO,
+  PROP_DICTIONARY
 };
 
 /**
@@ -70,8 +71,33 @@ struct _GZlibDecompressor
   GZlibCompressorFormat format;
   z_stream zstream;
   HeaderData *header_data;
+  GBytes *dictionary;
 };
 
+static int
+g_zlib_decompressor_set_dictionary (GZlibDecompressor *decompressor)
+{
+  gconstpointer data;
+  gsize size;
+
+  data = g_bytes_get_data (decompressor->dictionary, &size);
+
+  return inflateSetDictionary (&decompressor->zstream, data, size);
+}
+
+static void
+g_zlib_decompressor_set_raw_dictionary (GZlibDecompressor *decompressor)
+{
+  /* Raw streams carry no dictionary id, so the dictionary has to be
+   * installed up front; zlib streams ask for it via Z_NEED_DICT. */
+  if (decompressor->dictionary == NULL ||
+      decompressor->format != G_ZLIB_COMPRESSOR_FORMAT_RAW)
+    return;
+
+  if (g_zlib_decompressor_set_dictionary (decompressor) != Z_OK)
+    g_warning ("unexpected zlib error: %s\n", decompressor->zstream.msg);
+}
+
 static void
 g_zlib_decompressor_set_gzheader (GZlibDecompressor *decompressor)
 {
@@ -121,6 +147,9 @@ g_zlib_decompressor_finalize (GObject *object)
       g_free (decompressor->header_data);
     }
 
+  if (decompressor->dictionary)
+    g_bytes_unref (decompressor->dictionary);
+
   G_OBJECT_CLASS (g_zlib_decompressor_parent_class)->finalize (object);
 }
 
@@ -141,6 +170,10 @@ g_zlib_decompressor_set_property (GObject      *object,
       decompressor->format = g_value_get_enum (value);
       break;
 
+    case PROP_DICTIONARY:
+      decompressor->dictionary = g_value_dup_boxed (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -171,6 +204,10 @@ g_zlib_decompressor_get_property (GObject    *object,
         g_value_set_object (value, NULL);
       break;
 
+    case PROP_DICTIONARY:
+      g_value_set_boxed (value, decompressor->dictionary);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -210,6 +247,7 @@ g_zlib_decompressor_constructed (GObject *object)
     g_warning ("unexpected zlib error: %s\n", decompressor->zstream.msg);
 
   g_zlib_decompressor_set_gzheader (decompressor);
+  g_zlib_decompressor_set_raw_dictionary (decompressor);
 }
 
 static void
@@ -250,6 +288,26 @@ g_zlib_decompressor_class_init (GZlibDecompressorClass *klass)
                                                        G_TYPE_FILE_INFO,
                                                        G_PARAM_READABLE |
                                                        G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GZlibDecompressor:dictionary:
+   *
+   * The preset dictionary the data was compressed with, see
+   * #GZlibCompressor:dictionary. If the compressed data requires a
+   * dictionary and none, or a different one, is set, decompression
+   * fails with %G_IO_ERROR_INVALID_DATA.
+   *
+   * Since: 2.40
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_DICTIONARY,
+                                   g_param_spec_boxed ("dictionary",
+                                                       P_("dictionary"),
+                                                       P_("Preset dictionary for the decompression"),
+                                                       G_TYPE_BYTES,
+                                                       G_PARAM_READWRITE |
+                                                       G_PARAM_CONSTRUCT_ONLY |
+                                                       G_PARAM_STATIC_STRINGS));
 }
 
 /**
@@ -310,6 +368,7 @@ g_zlib_decompressor_reset (GConverter *converter)
     g_warning ("unexpected zlib error: %s\n", decompressor->zstream.msg);
 
   g_zlib_decompressor_set_gzheader (decompressor);
+  g_zlib_decompressor_set_raw_dictionary (decompressor);
 }
 
 static GConverterResult
@@ -336,6 +395,17 @@ g_zlib_decompressor_convert (GConverter *converter,
 
   res = inflate (&decompressor->zstream, Z_NO_FLUSH);
 
+  if (res == Z_NEED_DICT && decompressor->dictionary != NULL &&
+      g_zlib_decompressor_set_dictionary (decompressor) == Z_OK)
+    {
+      /* The header was consumed, so progress has been made even if
+       * there is no more input to feed to inflate() right now. */
+      if (decompressor->zstream.avail_in > 0)
+        res = inflate (&decompressor->zstream, Z_NO_FLUSH);
+      else
+        res = Z_OK;
+    }
+
   if (res == Z_DATA_ERROR || res == Z_NEED_DICT)
     {
       g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
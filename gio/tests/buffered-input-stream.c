@@ -83,6 +83,54 @@ test_peek_buffer (void)
   g_object_unref (base);
 }
 
+static void
+test_peek_bytes (void)
+{
+  GInputStream *base;
+  GInputStream *in;
+  GBytes *bytes, *empty;
+  const char *start, *buffer;
+  char data[16];
+  gsize size;
+
+  base = g_memory_input_stream_new_from_data ("abcdefghijklmnopqrstuvwxyz", -1, NULL);
+  in = g_buffered_input_stream_new_sized (base, 16);
+
+  g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (in), 8, NULL, NULL);
+  start = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (in), NULL);
+
+  /* filling more only compacts the buffer when that is worth it */
+  g_assert_cmpint (g_input_stream_read (in, data, 1, NULL, NULL), ==, 1);
+  g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (in), -1, NULL, NULL);
+  buffer = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (in), &size);
+  g_assert (buffer == start + 1);
+  g_assert_cmpint (size, ==, 15);
+  g_assert (strncmp (buffer, "bcdefghijklmnop", size) == 0);
+
+  bytes = g_buffered_input_stream_peek_bytes (G_BUFFERED_INPUT_STREAM (in), 2, 4);
+  g_assert_cmpint (g_bytes_get_size (bytes), ==, 4);
+  g_assert (g_bytes_get_data (bytes, NULL) == buffer + 2);
+  g_assert (strncmp (g_bytes_get_data (bytes, NULL), "defg", 4) == 0);
+
+  empty = g_buffered_input_stream_peek_bytes (G_BUFFERED_INPUT_STREAM (in), 20, 4);
+  g_assert_cmpint (g_bytes_get_size (empty), ==, 0);
+  g_bytes_unref (empty);
+
+  /* the peeked data survives the buffer being reused */
+  g_assert_cmpint (g_input_stream_read (in, data, 15, NULL, NULL), ==, 15);
+  g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (in), -1, NULL, NULL);
+  buffer = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (in), &size);
+  g_assert_cmpint (size, ==, 10);
+  g_assert (strncmp (buffer, "qrstuvwxyz", size) == 0);
+  g_assert (strncmp (g_bytes_get_data (bytes, NULL), "defg", 4) == 0);
+
+  /* and also outlives the stream */
+  g_object_unref (in);
+  g_object_unref (base);
+  g_assert (strncmp (g_bytes_get_data (bytes, NULL), "defg", 4) == 0);
+  g_bytes_unref (bytes);
+}
+
 static void
 test_set_buffer_size (void)
 {
@@ -540,6 +588,7 @@ main (int   argc,
 
   g_test_add_func ("/buffered-input-stream/peek", test_peek);
   g_test_add_func ("/buffered-input-stream/peek-buffer", test_peek_buffer);
+  g_test_add_func ("/buffered-input-stream/peek-bytes", test_peek_bytes);
   g_test_add_func ("/buffered-input-stream/set-buffer-size", test_set_buffer_size);
   g_test_add_func ("/buffered-input-stream/read-byte", test_read_byte);
   g_test_add_func ("/buffered-input-stream/read", test_read);
@@ -198,6 +198,76 @@ test_icon (void)
   g_free (type);
 }
 
+static gchar *
+query_content_type (GFile *file)
+{
+  GFileInfo *info;
+  GError *error = NULL;
+  gchar *type;
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE, 0, NULL, &error);
+  g_assert_no_error (error);
+  type = g_strdup (g_file_info_get_content_type (info));
+  g_object_unref (info);
+
+  return type;
+}
+
+static void
+test_sniff_cache (void)
+{
+  GFile *file;
+  GFileIOStream *stream;
+  GError *error = NULL;
+  guint64 hits, misses, hits0, misses0;
+  gchar *type, *type2;
+  const gchar binary[] = { 0, 1, 2, 3, 0, 1, 2, 3, 0 };
+
+  /* no extension, so the file has to be read */
+  file = g_file_new_tmp ("sniff-cacheXXXXXX", &stream, &error);
+  g_assert_no_error (error);
+  g_object_unref (stream);
+  g_file_replace_contents (file, "hello world\n", 12, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  g_content_type_set_sniff_cache_size (16);
+  g_content_type_get_sniff_cache_stats (&hits0, &misses0);
+
+  type = query_content_type (file);
+  g_content_type_get_sniff_cache_stats (&hits, &misses);
+  g_assert_cmpuint (hits, ==, hits0);
+  g_assert_cmpuint (misses, ==, misses0 + 1);
+
+  type2 = query_content_type (file);
+  g_assert_cmpstr (type, ==, type2);
+  g_content_type_get_sniff_cache_stats (&hits, &misses);
+  g_assert_cmpuint (hits, ==, hits0 + 1);
+  g_assert_cmpuint (misses, ==, misses0 + 1);
+  g_free (type2);
+
+  /* a changed file is sniffed again */
+  g_file_replace_contents (file, binary, sizeof binary, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  type2 = query_content_type (file);
+  g_assert_cmpstr (type, !=, type2);
+  g_content_type_get_sniff_cache_stats (&hits, &misses);
+  g_assert_cmpuint (hits, ==, hits0 + 1);
+  g_assert_cmpuint (misses, ==, misses0 + 2);
+  g_free (type2);
+  g_free (type);
+
+  /* disabled again: nothing is counted */
+  g_content_type_set_sniff_cache_size (0);
+  type = query_content_type (file);
+  g_content_type_get_sniff_cache_stats (&hits, &misses);
+  g_assert_cmpuint (hits, ==, hits0 + 1);
+  g_assert_cmpuint (misses, ==, misses0 + 2);
+  g_free (type);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
 
 int
 main (int argc, char *argv[])
@@ -211,6 +281,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/contenttype/executable", test_executable);
   g_test_add_func ("/contenttype/description", test_description);
   g_test_add_func ("/contenttype/icon", test_icon);
+  g_test_add_func ("/contenttype/sniff-cache", test_sniff_cache);
 
   return g_test_run ();
 }
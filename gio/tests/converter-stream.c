@@ -1163,6 +1163,326 @@ test_truncation (gconstpointer data)
   g_free (data0);
 }
 
+typedef struct {
+  GByteArray *received;
+  gchar buffer[1000];
+  gboolean done;
+} PipelinedData;
+
+static void
+pipelined_read_cb (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  PipelinedData *data = user_data;
+  GError *error = NULL;
+  gssize nread;
+
+  nread = g_input_stream_read_finish (G_INPUT_STREAM (source), result, &error);
+  g_assert_no_error (error);
+
+  if (nread == 0)
+    {
+      data->done = TRUE;
+      return;
+    }
+
+  g_byte_array_append (data->received, (guint8 *) data->buffer, nread);
+  g_input_stream_read_async (G_INPUT_STREAM (source),
+                             data->buffer, sizeof data->buffer,
+                             G_PRIORITY_DEFAULT, NULL,
+                             pipelined_read_cb, data);
+}
+
+static GInputStream *
+pipelined_stream_new (gconstpointer data,
+                      gsize         size)
+{
+  GInputStream *base, *stream;
+  GConverter *decompressor;
+
+  base = g_memory_input_stream_new_from_data (data, size, NULL);
+  decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+  stream = g_converter_input_stream_new (base, decompressor);
+  g_object_unref (decompressor);
+  g_object_unref (base);
+
+  g_assert (!g_converter_input_stream_get_pipelined (G_CONVERTER_INPUT_STREAM (stream)));
+  g_converter_input_stream_set_pipelined (G_CONVERTER_INPUT_STREAM (stream), TRUE);
+  g_assert (g_converter_input_stream_get_pipelined (G_CONVERTER_INPUT_STREAM (stream)));
+
+  return stream;
+}
+
+static void
+test_pipelined (void)
+{
+  GOutputStream *compressed, *costream, *ostream;
+  GInputStream *istream, *cistream;
+  GConverter *compressor;
+  PipelinedData data;
+  GError *error = NULL;
+  guint32 *data0;
+  gchar buffer[100];
+  gsize size;
+  gint i;
+
+  /* compressible, and large enough to need many chunks */
+  data0 = g_malloc (DATA_LENGTH * sizeof (guint32));
+  for (i = 0; i < DATA_LENGTH; i++)
+    data0[i] = g_random_int_range (0, 256);
+
+  istream = g_memory_input_stream_new_from_data (data0, DATA_LENGTH * sizeof (guint32), NULL);
+  compressed = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+  compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+  costream = g_converter_output_stream_new (compressed, compressor);
+  g_output_stream_splice (costream, istream, G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                          G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (costream);
+  g_object_unref (compressor);
+  g_object_unref (istream);
+  size = g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (compressed));
+
+  /* blocking reads */
+  cistream = pipelined_stream_new (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (compressed)), size);
+  ostream = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+  g_output_stream_splice (ostream, cistream, 0, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (ostream)), ==,
+                    DATA_LENGTH * sizeof (guint32));
+  g_assert (memcmp (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (ostream)),
+                    data0, DATA_LENGTH * sizeof (guint32)) == 0);
+  g_object_unref (ostream);
+  g_object_unref (cistream);
+
+  /* asynchronous reads go through the pollable interface */
+  cistream = pipelined_stream_new (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (compressed)), size);
+  g_assert (g_pollable_input_stream_can_poll (G_POLLABLE_INPUT_STREAM (cistream)));
+  data.received = g_byte_array_new ();
+  data.done = FALSE;
+  g_input_stream_read_async (cistream, data.buffer, sizeof data.buffer,
+                             G_PRIORITY_DEFAULT, NULL,
+                             pipelined_read_cb, &data);
+  while (!data.done)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (data.received->len, ==, DATA_LENGTH * sizeof (guint32));
+  g_assert (memcmp (data.received->data, data0, data.received->len) == 0);
+  g_byte_array_unref (data.received);
+  g_object_unref (cistream);
+
+  /* closing stops the worker, also while it is ahead of the reader */
+  cistream = pipelined_stream_new (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (compressed)), size);
+  g_input_stream_read_all (cistream, buffer, sizeof buffer, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (memcmp (buffer, data0, sizeof buffer) == 0);
+  g_input_stream_close (cistream, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (cistream);
+
+  /* errors come after the data converted before them */
+  cistream = pipelined_stream_new (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (compressed)), size / 2);
+  ostream = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+  g_output_stream_splice (ostream, cistream, 0, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT);
+  g_clear_error (&error);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (ostream)), >, 0);
+  g_object_unref (ostream);
+  g_object_unref (cistream);
+
+  g_object_unref (compressed);
+  g_free (data0);
+}
+
+static GBytes *
+convert_bytes (GConverter    *converter,
+               GBytes        *input,
+               GError       **error)
+{
+  GInputStream *base, *cstream;
+  GOutputStream *ostream;
+  GBytes *output = NULL;
+
+  base = g_memory_input_stream_new_from_bytes (input);
+  cstream = g_converter_input_stream_new (base, converter);
+  ostream = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+  if (g_output_stream_splice (ostream, cstream, 0, NULL, error) >= 0 &&
+      g_output_stream_close (ostream, NULL, error))
+    output = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+
+  g_object_unref (ostream);
+  g_object_unref (cstream);
+  g_object_unref (base);
+
+  return output;
+}
+
+static void
+test_dictionary (gconstpointer data)
+{
+  GZlibCompressorFormat format = GPOINTER_TO_INT (data);
+  const gchar *dict_text = "{\"level\":\"info\",\"service\":\"frontend\",\"message\":\"request served\"}";
+  const gchar *text = "{\"level\":\"info\",\"service\":\"frontend\",\"message\":\"request failed\"}";
+  GConverter *compressor, *decompressor;
+  GBytes *dictionary, *input, *plain, *compressed, *output;
+  GError *error = NULL;
+
+  dictionary = g_bytes_new_static (dict_text, strlen (dict_text));
+  input = g_bytes_new_static (text, strlen (text));
+
+  compressor = G_CONVERTER (g_zlib_compressor_new (format, 9));
+  plain = convert_bytes (compressor, input, &error);
+  g_assert_no_error (error);
+  g_object_unref (compressor);
+
+  compressor = g_object_new (G_TYPE_ZLIB_COMPRESSOR,
+                             "format", format,
+                             "level", 9,
+                             "dictionary", dictionary,
+                             NULL);
+  compressed = convert_bytes (compressor, input, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_bytes_get_size (compressed), <, g_bytes_get_size (plain));
+
+  /* the dictionary survives a reset */
+  g_converter_reset (compressor);
+  output = convert_bytes (compressor, input, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_equal (output, compressed));
+  g_bytes_unref (output);
+  g_object_unref (compressor);
+
+  decompressor = g_object_new (G_TYPE_ZLIB_DECOMPRESSOR,
+                               "format", format,
+                               "dictionary", dictionary,
+                               NULL);
+  output = convert_bytes (decompressor, compressed, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_equal (output, input));
+  g_bytes_unref (output);
+
+  g_converter_reset (decompressor);
+  output = convert_bytes (decompressor, compressed, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_equal (output, input));
+  g_bytes_unref (output);
+  g_object_unref (decompressor);
+
+  if (format == G_ZLIB_COMPRESSOR_FORMAT_ZLIB)
+    {
+      /* the stream says it needs a dictionary */
+      decompressor = G_CONVERTER (g_zlib_decompressor_new (format));
+      output = convert_bytes (decompressor, compressed, &error);
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+      g_assert (output == NULL);
+      g_clear_error (&error);
+      g_object_unref (decompressor);
+    }
+
+  g_bytes_unref (compressed);
+  g_bytes_unref (plain);
+  g_bytes_unref (input);
+  g_bytes_unref (dictionary);
+}
+
+static void
+test_parallel (gconstpointer data)
+{
+  GZlibCompressorFormat format = GPOINTER_TO_INT (data);
+  GConverter *compressor, *decompressor;
+  GOutputStream *ostream, *costream;
+  GBytes *input, *compressed, *output, *dictionary;
+  GFileInfo *info;
+  GError *error = NULL;
+  guint8 *data0;
+  gsize size;
+  gboolean parallel;
+  gint i;
+
+  /* compressible, and spanning many blocks */
+  size = DATA_LENGTH * sizeof (guint32);
+  data0 = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data0[i] = g_random_int_range (0, 4);
+  input = g_bytes_new_take (data0, size);
+
+  compressor = g_object_new (G_TYPE_ZLIB_COMPRESSOR,
+                             "format", format,
+                             "parallel", TRUE,
+                             NULL);
+  g_object_get (compressor, "parallel", &parallel, NULL);
+  g_assert (parallel);
+  info = g_file_info_new ();
+  g_file_info_set_name (info, "foo");
+  g_zlib_compressor_set_file_info (G_ZLIB_COMPRESSOR (compressor), info);
+  g_object_unref (info);
+
+  /* through an output stream, flushing in the middle */
+  ostream = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+  costream = g_converter_output_stream_new (ostream, compressor);
+  g_output_stream_write_all (costream, data0, size / 3, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_flush (costream, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_write_all (costream, data0 + size / 3, size - size / 3, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_close (costream, NULL, &error);
+  g_assert_no_error (error);
+  compressed = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+  g_assert_cmpuint (g_bytes_get_size (compressed), <, size / 2);
+  g_object_unref (costream);
+  g_object_unref (ostream);
+
+  decompressor = G_CONVERTER (g_zlib_decompressor_new (format));
+  output = convert_bytes (decompressor, compressed, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_equal (output, input));
+  if (format == G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    g_assert_cmpstr (g_file_info_get_name (g_zlib_decompressor_get_file_info (G_ZLIB_DECOMPRESSOR (decompressor))), ==, "foo");
+  g_bytes_unref (output);
+  g_bytes_unref (compressed);
+
+  /* through an input stream, after a reset */
+  g_converter_reset (compressor);
+  g_converter_reset (decompressor);
+  compressed = convert_bytes (compressor, input, &error);
+  g_assert_no_error (error);
+  output = convert_bytes (decompressor, compressed, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_equal (output, input));
+  g_bytes_unref (output);
+  g_bytes_unref (compressed);
+  g_object_unref (decompressor);
+  g_object_unref (compressor);
+
+  /* primed with a preset dictionary */
+  if (format != G_ZLIB_COMPRESSOR_FORMAT_GZIP)
+    {
+      dictionary = g_bytes_new_from_bytes (input, 0, 1000);
+      compressor = g_object_new (G_TYPE_ZLIB_COMPRESSOR,
+                                 "format", format,
+                                 "parallel", TRUE,
+                                 "dictionary", dictionary,
+                                 NULL);
+      decompressor = g_object_new (G_TYPE_ZLIB_DECOMPRESSOR,
+                                   "format", format,
+                                   "dictionary", dictionary,
+                                   NULL);
+      compressed = convert_bytes (compressor, input, &error);
+      g_assert_no_error (error);
+      output = convert_bytes (decompressor, compressed, &error);
+      g_assert_no_error (error);
+      g_assert (g_bytes_equal (output, input));
+      g_bytes_unref (output);
+      g_bytes_unref (compressed);
+      g_object_unref (decompressor);
+      g_object_unref (compressor);
+      g_bytes_unref (dictionary);
+    }
+
+  g_bytes_unref (input);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -1206,6 +1526,17 @@ main (int   argc,
 
   g_test_add_func ("/converter-stream/pollable", test_converter_pollable);
   g_test_add_func ("/converter-stream/leftover", test_converter_leftover);
+  g_test_add_func ("/converter-input-stream/pipelined", test_pipelined);
+  g_test_add_data_func ("/converter-stream/dictionary/zlib",
+                        GINT_TO_POINTER (G_ZLIB_COMPRESSOR_FORMAT_ZLIB), test_dictionary);
+  g_test_add_data_func ("/converter-stream/dictionary/raw",
+                        GINT_TO_POINTER (G_ZLIB_COMPRESSOR_FORMAT_RAW), test_dictionary);
+  g_test_add_data_func ("/converter-stream/parallel/zlib",
+                        GINT_TO_POINTER (G_ZLIB_COMPRESSOR_FORMAT_ZLIB), test_parallel);
+  g_test_add_data_func ("/converter-stream/parallel/gzip",
+                        GINT_TO_POINTER (G_ZLIB_COMPRESSOR_FORMAT_GZIP), test_parallel);
+  g_test_add_data_func ("/converter-stream/parallel/raw",
+                        GINT_TO_POINTER (G_ZLIB_COMPRESSOR_FORMAT_RAW), test_parallel);
 
   return g_test_run();
 }
@@ -222,6 +222,54 @@ test_read_lines_LF_invalid_utf8 (void)
   g_object_unref (stream);
 }
 
+static void
+test_read_lines_split (void)
+{
+  const gchar *data = "a\r\nbb\rccc\n\r\nd\r";
+  const struct {
+    GDataStreamNewlineType type;
+    const gchar *lines[6];
+  } tests[] = {
+    { G_DATA_STREAM_NEWLINE_TYPE_LF, { "a\r", "bb\rccc", "\r", "d\r", NULL } },
+    { G_DATA_STREAM_NEWLINE_TYPE_CR, { "a", "\nbb", "ccc\n", "\nd", NULL } },
+    { G_DATA_STREAM_NEWLINE_TYPE_CR_LF, { "a", "bb\rccc\n", "d\r", NULL } },
+    { G_DATA_STREAM_NEWLINE_TYPE_ANY, { "a", "bb", "ccc", "", "d\r", NULL } }
+  };
+  const gsize buffer_sizes[] = { 1, 2, 3, 5, 64 };
+  GInputStream *base_stream;
+  GDataInputStream *stream;
+  GError *error = NULL;
+  gsize i, j, k, length;
+  char *line;
+
+  /* newlines have to be found wherever the buffer boundaries fall */
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    for (j = 0; j < G_N_ELEMENTS (buffer_sizes); j++)
+      {
+        base_stream = g_memory_input_stream_new_from_data (data, -1, NULL);
+        stream = g_data_input_stream_new (base_stream);
+        g_data_input_stream_set_newline_type (stream, tests[i].type);
+        g_buffered_input_stream_set_buffer_size (G_BUFFERED_INPUT_STREAM (stream),
+                                                 buffer_sizes[j]);
+
+        for (k = 0; tests[i].lines[k]; k++)
+          {
+            line = g_data_input_stream_read_line (stream, &length, NULL, &error);
+            g_assert_no_error (error);
+            g_assert_cmpstr (line, ==, tests[i].lines[k]);
+            g_assert_cmpint (length, ==, strlen (tests[i].lines[k]));
+            g_free (line);
+          }
+
+        line = g_data_input_stream_read_line (stream, &length, NULL, &error);
+        g_assert_no_error (error);
+        g_assert (line == NULL);
+
+        g_object_unref (stream);
+        g_object_unref (base_stream);
+      }
+}
+
 static void
 test_read_until (void)
 {
@@ -494,6 +542,7 @@ main (int   argc,
   g_test_add_func ("/data-input-stream/read-lines-CR", test_read_lines_CR);
   g_test_add_func ("/data-input-stream/read-lines-CR-LF", test_read_lines_CR_LF);
   g_test_add_func ("/data-input-stream/read-lines-any", test_read_lines_any);
+  g_test_add_func ("/data-input-stream/read-lines-split", test_read_lines_split);
   g_test_add_func ("/data-input-stream/read-until", test_read_until);
   g_test_add_func ("/data-input-stream/read-upto", test_read_upto);
   g_test_add_func ("/data-input-stream/read-int", test_read_int);
@@ -22,6 +22,7 @@
 #include <glib/glib.h>
 #include <gio/gio.h>
 #include <gio/gdesktopappinfo.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -349,6 +350,9 @@ cleanup_subdirs (const char *base_dir)
   file = g_file_get_child (base, "mime");
   cleanup_dir_recurse (file, file);
   g_object_unref (file);
+  file = g_file_get_child (base, "cache");
+  cleanup_dir_recurse (file, file);
+  g_object_unref (file);
 }
 
 static void
@@ -450,16 +454,129 @@ test_actions (void)
   g_object_unref (appinfo);
 }
 
+static void
+write_desktop_file (const gchar *relative,
+                    const gchar *contents)
+{
+  GError *error = NULL;
+  gchar *filename, *dirname;
+
+  filename = g_build_filename (basedir, "applications", relative, NULL);
+  dirname = g_path_get_dirname (filename);
+  g_assert_cmpint (g_mkdir_with_parents (dirname, 0755), ==, 0);
+  g_file_set_contents (filename, contents, -1, &error);
+  g_assert_no_error (error);
+
+  g_free (dirname);
+  g_free (filename);
+}
+
+static void
+test_index (void)
+{
+  GDesktopAppInfo *appinfo;
+  gchar *filename, *index_dir;
+  FILE *file;
+  GDir *dir;
+
+  write_desktop_file ("index-test.desktop",
+                      "[Desktop Entry]\n"
+                      "Type=Application\n"
+                      "Name=Before\n"
+                      "Exec=true\n");
+
+  appinfo = g_desktop_app_info_new ("index-test.desktop");
+  g_assert (appinfo != NULL);
+  g_assert_cmpstr (g_app_info_get_name (G_APP_INFO (appinfo)), ==, "Before");
+  g_object_unref (appinfo);
+
+  /* the lookup went through an index in the cache directory */
+  index_dir = g_build_filename (basedir, "cache", "glib-2.0", "desktop-index", NULL);
+  dir = g_dir_open (index_dir, 0, NULL);
+  g_assert (dir != NULL);
+  g_assert (g_dir_read_name (dir) != NULL);
+  g_dir_close (dir);
+  g_free (index_dir);
+
+  /* a file rewritten in place leaves the directory alone, but is
+   * still noticed
+   */
+  filename = g_build_filename (basedir, "applications", "index-test.desktop", NULL);
+  file = fopen (filename, "w");
+  g_assert (file != NULL);
+  fputs ("[Desktop Entry]\n"
+         "Type=Application\n"
+         "Name=After editing\n"
+         "Exec=true\n", file);
+  fclose (file);
+  g_free (filename);
+
+  appinfo = g_desktop_app_info_new ("index-test.desktop");
+  g_assert (appinfo != NULL);
+  g_assert_cmpstr (g_app_info_get_name (G_APP_INFO (appinfo)), ==, "After editing");
+  g_object_unref (appinfo);
+
+  /* and the index is rebuilt with it */
+  appinfo = g_desktop_app_info_new ("index-test.desktop");
+  g_assert (appinfo != NULL);
+  g_assert_cmpstr (g_app_info_get_name (G_APP_INFO (appinfo)), ==, "After editing");
+  g_object_unref (appinfo);
+
+  /* new files are noticed too */
+  write_desktop_file ("index-test2.desktop",
+                      "[Desktop Entry]\n"
+                      "Type=Application\n"
+                      "Name=Added\n"
+                      "Exec=true\n");
+
+  appinfo = g_desktop_app_info_new ("index-test2.desktop");
+  g_assert (appinfo != NULL);
+  g_assert_cmpstr (g_app_info_get_name (G_APP_INFO (appinfo)), ==, "Added");
+  g_object_unref (appinfo);
+}
+
+static void
+test_index_candidates (void)
+{
+  GDesktopAppInfo *appinfo;
+
+  /* "candidates-test.desktop" can't be used, so its id is looked for
+   * as candidates/test.desktop instead
+   */
+  write_desktop_file ("candidates-test.desktop",
+                      "[Desktop Entry]\n"
+                      "Type=Application\n"
+                      "Name=Unusable\n"
+                      "TryExec=/nonexistent/candidates-test\n"
+                      "Exec=true\n");
+  write_desktop_file ("candidates/test.desktop",
+                      "[Desktop Entry]\n"
+                      "Type=Application\n"
+                      "Name=Usable\n"
+                      "Exec=true\n");
+
+  appinfo = g_desktop_app_info_new ("candidates-test.desktop");
+  g_assert (appinfo != NULL);
+  g_assert_cmpstr (g_app_info_get_name (G_APP_INFO (appinfo)), ==, "Usable");
+  g_assert_cmpstr (g_app_info_get_id (G_APP_INFO (appinfo)), ==, "candidates-test.desktop");
+  g_assert (g_str_has_suffix (g_desktop_app_info_get_filename (appinfo), "candidates/test.desktop"));
+  g_object_unref (appinfo);
+}
+
 int
 main (int   argc,
       char *argv[])
 {
+  gchar *cachedir;
   gint result;
 
   g_test_init (&argc, &argv, NULL);
   
   basedir = g_get_current_dir ();
   g_setenv ("XDG_DATA_HOME", basedir, TRUE);
+  cachedir = g_build_filename (basedir, "cache", NULL);
+  g_setenv ("XDG_CACHE_HOME", cachedir, TRUE);
+  g_free (cachedir);
   cleanup_subdirs (basedir);
   
   g_test_add_func ("/desktop-app-info/delete", test_delete);
@@ -468,6 +585,8 @@ main (int   argc,
   g_test_add_func ("/desktop-app-info/lastused", test_last_used);
   g_test_add_func ("/desktop-app-info/extra-getters", test_extra_getters);
   g_test_add_func ("/desktop-app-info/actions", test_actions);
+  g_test_add_func ("/desktop-app-info/index", test_index);
+  g_test_add_func ("/desktop-app-info/index-candidates", test_index_candidates);
 
   result = g_test_run ();
 
@@ -636,6 +636,81 @@ test_replace_load (void)
   free (path);
 }
 
+static void
+async_result_cb (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+  GAsyncResult **result = user_data;
+
+  *result = g_object_ref (res);
+}
+
+static void
+test_replace_load_etag (void)
+{
+  GFile *file;
+  GFileIOStream *iostream;
+  GAsyncResult *result = NULL;
+  GError *error = NULL;
+  gchar *contents, *etag, *new_etag;
+  gsize length;
+  gboolean ret;
+
+  file = g_file_new_tmp ("g_file_replace_load_etag_XXXXXX", &iostream, NULL);
+  g_assert (file != NULL);
+  g_object_unref (iostream);
+
+  g_file_replace_contents_async (file, replace_data, strlen (replace_data),
+                                 NULL, FALSE, 0, NULL,
+                                 async_result_cb, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  ret = g_file_replace_contents_finish (file, result, &new_etag, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_assert (new_etag != NULL);
+  g_clear_object (&result);
+
+  g_file_load_contents_async (file, NULL, async_result_cb, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  ret = g_file_load_contents_finish (file, result, &contents, &length, &etag, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_assert_cmpint (length, ==, strlen (replace_data));
+  g_assert_cmpstr (contents, ==, replace_data);
+  g_assert_cmpstr (etag, ==, new_etag);
+  g_clear_object (&result);
+  g_free (contents);
+  g_free (new_etag);
+
+  /* a stale etag must be rejected */
+  g_file_replace_contents_async (file, "x", 1, "0:0", FALSE, 0, NULL,
+                                 async_result_cb, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  ret = g_file_replace_contents_finish (file, result, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WRONG_ETAG);
+  g_assert (!ret);
+  g_clear_error (&error);
+  g_clear_object (&result);
+
+  /* while the current one is accepted */
+  g_file_replace_contents_async (file, "x", 1, etag, FALSE, 0, NULL,
+                                 async_result_cb, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  ret = g_file_replace_contents_finish (file, result, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_clear_object (&result);
+  g_free (etag);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
 static void
 test_replace_cancel (void)
 {
@@ -804,8 +879,492 @@ test_copy_preserve_mode (void)
   g_clear_object (&dest_tmpfile);
   g_clear_object (&dest_info);
 }
+
+typedef struct
+{
+  goffset current;
+  goffset total;
+  gint calls;
+} CopyProgress;
+
+static void
+copy_progress_cb (goffset  current_num_bytes,
+                  goffset  total_num_bytes,
+                  gpointer user_data)
+{
+  CopyProgress *progress = user_data;
+
+  g_assert_cmpint (current_num_bytes, >=, progress->current);
+  progress->current = current_num_bytes;
+  progress->total = total_num_bytes;
+  progress->calls++;
+}
+
+static void
+test_copy_progress (void)
+{
+  GError *error = NULL;
+  GFile *source, *dest;
+  GFileIOStream *iostream;
+  CopyProgress progress;
+  gchar *data, *contents;
+  gsize size, length;
+  gsize i;
+
+  size = 10 * 1024 * 1024 + 17;
+  data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = g_random_int_range (0, 256);
+
+  source = g_file_new_tmp ("tmp-copy-progressXXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_io_stream_close ((GIOStream *) iostream, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  g_file_replace_contents (source, data, size, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  dest = g_file_new_tmp ("tmp-copy-progressXXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_io_stream_close ((GIOStream *) iostream, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+
+  memset (&progress, 0, sizeof progress);
+  g_file_copy (source, dest, G_FILE_COPY_OVERWRITE, NULL,
+               copy_progress_cb, &progress, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (progress.calls, >, 0);
+  g_assert_cmpint (progress.current, ==, size);
+  g_assert_cmpint (progress.total, ==, size);
+
+  g_file_load_contents (dest, NULL, &contents, &length, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (length, ==, size);
+  g_assert (memcmp (contents, data, size) == 0);
+  g_free (contents);
+
+  /* empty files take the fallback paths */
+  g_file_replace_contents (source, "", 0, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_file_copy (source, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_file_load_contents (dest, NULL, &contents, &length, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (length, ==, 0);
+  g_free (contents);
+
+  g_file_delete (source, NULL, NULL);
+  g_file_delete (dest, NULL, NULL);
+  g_object_unref (source);
+  g_object_unref (dest);
+  g_free (data);
+}
+
+static void
+test_query_info_subset (void)
+{
+  GError *error = NULL;
+  GFileEnumerator *enumerator;
+  GFile *dir, *file, *link;
+  GFileInfo *full, *info;
+  gchar *dir_path;
+  guint64 mtime;
+  gint n;
+
+  dir_path = g_dir_make_tmp ("query-info-subsetXXXXXX", &error);
+  g_assert_no_error (error);
+  dir = g_file_new_for_path (dir_path);
+  file = g_file_get_child (dir, "file");
+  link = g_file_get_child (dir, "link");
+
+  g_file_replace_contents (file, "hello", 5, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_file_make_symbolic_link (link, "file", NULL, &error);
+  g_assert_no_error (error);
+
+  full = g_file_query_info (file, "*", 0, NULL, &error);
+  g_assert_no_error (error);
+  mtime = g_file_info_get_attribute_uint64 (full, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  g_assert_cmpuint (mtime, >, 0);
+
+  /* each stat field is still right when only a few are asked for */
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE, 0, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_file_info_get_size (info), ==, 5);
+  g_assert (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+  g_object_unref (info);
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_ETAG_VALUE,
+                            0, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED), ==, mtime);
+  g_assert_cmpstr (g_file_info_get_etag (info), ==, g_file_info_get_etag (full));
+  g_object_unref (info);
+
+  info = g_file_query_info (link, G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_UNIX_INODE,
+                            0, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_file_info_get_size (info), ==, 5);
+  g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE), ==,
+                    g_file_info_get_attribute_uint64 (full, G_FILE_ATTRIBUTE_UNIX_INODE));
+  g_object_unref (info);
+
+  enumerator = g_file_enumerate_children (dir, G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          NULL, &error);
+  g_assert_no_error (error);
+  n = 0;
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, &error)) != NULL)
+    {
+      if (strcmp (g_file_info_get_name (info), "file") == 0)
+        g_assert_cmpint (g_file_info_get_size (info), ==, 5);
+      else
+        g_assert_cmpint (g_file_info_get_size (info), ==, 4);
+      g_object_unref (info);
+      n++;
+    }
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 2);
+  g_object_unref (enumerator);
+
+  g_file_delete (link, NULL, NULL);
+  g_file_delete (file, NULL, NULL);
+  g_file_delete (dir, NULL, NULL);
+  g_object_unref (full);
+  g_object_unref (link);
+  g_object_unref (file);
+  g_object_unref (dir);
+  g_free (dir_path);
+}
+
+typedef struct
+{
+  GHashTable *seen;
+  gint        batches;
+  gint        entries;
+  gboolean    done;
+  GError     *error;
+} WalkTreeResult;
+
+static void
+walk_tree_batch_cb (GFile    *directory,
+                    GList    *infos,
+                    gpointer  user_data)
+{
+  WalkTreeResult *result = user_data;
+  GList *l;
+
+  /* parents are always listed before their contents */
+  if (g_hash_table_size (result->seen) > 0)
+    g_assert (g_hash_table_contains (result->seen, directory));
+
+  for (l = infos; l; l = l->next)
+    {
+      GFileInfo *info = l->data;
+
+      g_assert (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_TYPE));
+      g_assert (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE));
+      g_hash_table_add (result->seen, g_file_get_child (directory, g_file_info_get_name (info)));
+      result->entries++;
+    }
+
+  result->batches++;
+}
+
+static void
+walk_tree_done_cb (GObject      *source,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  WalkTreeResult *result = user_data;
+
+  g_file_walk_tree_finish (G_FILE (source), res, &result->error);
+  result->done = TRUE;
+}
+
+static void
+walk_tree (GFile          *root,
+           gint            max_depth,
+           WalkTreeResult *result)
+{
+  memset (result, 0, sizeof *result);
+  result->seen = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                        g_object_unref, NULL);
+  g_hash_table_add (result->seen, g_object_ref (root));
+
+  g_file_walk_tree_async (root, G_FILE_ATTRIBUTE_STANDARD_SIZE, 0, max_depth,
+                          G_PRIORITY_DEFAULT, NULL,
+                          walk_tree_batch_cb, result,
+                          walk_tree_done_cb, result);
+  while (!result->done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_walk_tree (void)
+{
+  GError *error = NULL;
+  WalkTreeResult result;
+  GFile *root, *a, *b, *c, *file;
+  gchar *root_path, *name;
+  gint i;
+
+  root_path = g_dir_make_tmp ("walk-treeXXXXXX", &error);
+  g_assert_no_error (error);
+  root = g_file_new_for_path (root_path);
+  a = g_file_get_child (root, "a");
+  b = g_file_get_child (a, "b");
+  c = g_file_get_child (b, "c");
+  g_file_make_directory_with_parents (c, NULL, &error);
+  g_assert_no_error (error);
+
+  /* enough entries for the toplevel to need more than one batch */
+  for (i = 0; i < 150; i++)
+    {
+      name = g_strdup_printf ("f%03d", i);
+      file = g_file_get_child (root, name);
+      g_file_replace_contents (file, "x", 1, NULL, FALSE, 0, NULL, NULL, &error);
+      g_assert_no_error (error);
+      g_object_unref (file);
+      g_free (name);
+    }
+  file = g_file_get_child (a, "x");
+  g_file_replace_contents (file, "x", 1, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (file);
+
+  /* reported, but not followed */
+  file = g_file_get_child (a, "loop");
+  g_file_make_symbolic_link (file, root_path, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (file);
+
+  walk_tree (root, -1, &result);
+  g_assert_no_error (result.error);
+  g_assert_cmpint (result.entries, ==, 150 + 1 + 3 + 1);
+  g_assert_cmpint (result.batches, >=, 4);
+  g_assert (g_hash_table_contains (result.seen, c));
+  g_hash_table_unref (result.seen);
+
+  walk_tree (root, 0, &result);
+  g_assert_no_error (result.error);
+  g_assert_cmpint (result.entries, ==, 151);
+  g_hash_table_unref (result.seen);
+
+  walk_tree (root, 1, &result);
+  g_assert_no_error (result.error);
+  g_assert_cmpint (result.entries, ==, 151 + 3);
+  g_assert (!g_hash_table_contains (result.seen, c));
+  g_hash_table_unref (result.seen);
+
+  walk_tree (c, -1, &result);
+  g_assert_no_error (result.error);
+  g_assert_cmpint (result.entries, ==, 0);
+  g_hash_table_unref (result.seen);
+
+  file = g_file_get_child (root, "missing");
+  walk_tree (file, -1, &result);
+  g_assert_error (result.error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+  g_clear_error (&result.error);
+  g_hash_table_unref (result.seen);
+  g_object_unref (file);
+
+  for (i = 0; i < 150; i++)
+    {
+      name = g_strdup_printf ("f%03d", i);
+      file = g_file_get_child (root, name);
+      g_file_delete (file, NULL, NULL);
+      g_object_unref (file);
+      g_free (name);
+    }
+  file = g_file_get_child (a, "x");
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  file = g_file_get_child (a, "loop");
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_file_delete (c, NULL, NULL);
+  g_file_delete (b, NULL, NULL);
+  g_file_delete (a, NULL, NULL);
+  g_file_delete (root, NULL, NULL);
+  g_object_unref (c);
+  g_object_unref (b);
+  g_object_unref (a);
+  g_object_unref (root);
+  g_free (root_path);
+}
 #endif
 
+static void
+load_bytes_cb (GObject      *source,
+               GAsyncResult *res,
+               gpointer      user_data)
+{
+  GBytes **bytes = user_data;
+  GError *error = NULL;
+
+  *bytes = g_file_load_bytes_finish (G_FILE (source), res, NULL, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_load_bytes (void)
+{
+  GError *error = NULL;
+  GFile *file, *missing;
+  GFileIOStream *iostream;
+  GFileInfo *info;
+  GBytes *bytes;
+  gchar *data, *etag;
+  gsize sizes[] = { 0, 5, 1024 * 1024 };
+  gsize i, j;
+
+  file = g_file_new_tmp ("tmp-load-bytesXXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_io_stream_close ((GIOStream *) iostream, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+
+  /* small files are read, large ones are mapped */
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      data = g_malloc (sizes[i] + 1);
+      for (j = 0; j < sizes[i]; j++)
+        data[j] = g_random_int_range (0, 256);
+      g_file_replace_contents (file, data, sizes[i], NULL, FALSE, 0, NULL, NULL, &error);
+      g_assert_no_error (error);
+
+      bytes = g_file_load_bytes (file, NULL, &etag, &error);
+      g_assert_no_error (error);
+      g_assert_cmpuint (g_bytes_get_size (bytes), ==, sizes[i]);
+      g_assert (memcmp (g_bytes_get_data (bytes, NULL), data, sizes[i]) == 0);
+      g_bytes_unref (bytes);
+
+      info = g_file_query_info (file, G_FILE_ATTRIBUTE_ETAG_VALUE, 0, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpstr (etag, ==, g_file_info_get_etag (info));
+      g_object_unref (info);
+      g_free (etag);
+
+      bytes = NULL;
+      g_file_load_bytes_async (file, NULL, load_bytes_cb, &bytes);
+      while (bytes == NULL)
+        g_main_context_iteration (NULL, TRUE);
+      g_assert_cmpuint (g_bytes_get_size (bytes), ==, sizes[i]);
+      g_assert (memcmp (g_bytes_get_data (bytes, NULL), data, sizes[i]) == 0);
+      g_bytes_unref (bytes);
+
+      g_free (data);
+    }
+
+  missing = g_file_get_child (file, "missing");
+  bytes = g_file_load_bytes (missing, NULL, NULL, &error);
+  g_assert (bytes == NULL);
+  g_assert (error != NULL);
+  g_clear_error (&error);
+  g_object_unref (missing);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static void
+query_info_many_cb (GObject      *source,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  GPtrArray **infos = user_data;
+  GError *error = NULL;
+
+  g_assert (source == NULL);
+  *infos = g_file_query_info_many_finish (res, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_query_info_many (void)
+{
+  GError *error = NULL;
+  GFile *files[6];
+  GFile *dir;
+  GFileInfo *info, *expected;
+  GPtrArray *infos;
+  gchar *dir_path, *name;
+  guint i;
+
+  dir_path = g_dir_make_tmp ("query-info-manyXXXXXX", &error);
+  g_assert_no_error (error);
+  dir = g_file_new_for_path (dir_path);
+
+  /* four siblings with one missing among them, plus the directory
+   * itself and a file somewhere else
+   */
+  for (i = 0; i < 4; i++)
+    {
+      name = g_strdup_printf ("file%u", i);
+      files[i] = g_file_get_child (dir, name);
+      g_free (name);
+
+      if (i != 2)
+        {
+          g_file_replace_contents (files[i], "hello", i, NULL, FALSE, 0, NULL, NULL, &error);
+          g_assert_no_error (error);
+        }
+    }
+  files[4] = g_object_ref (dir);
+  files[5] = g_file_new_for_path (g_get_tmp_dir ());
+
+  infos = NULL;
+  g_file_query_info_many_async (files, G_N_ELEMENTS (files), "standard::*,time::modified,unix::inode",
+                                0, G_PRIORITY_DEFAULT, NULL, query_info_many_cb, &infos);
+  while (infos == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpuint (infos->len, ==, G_N_ELEMENTS (files));
+  for (i = 0; i < G_N_ELEMENTS (files); i++)
+    {
+      info = g_ptr_array_index (infos, i);
+      if (i == 2)
+        {
+          g_assert (info == NULL);
+          continue;
+        }
+
+      expected = g_file_query_info (files[i], "standard::*,time::modified,unix::inode",
+                                    0, NULL, &error);
+      g_assert_no_error (error);
+      g_assert (G_IS_FILE_INFO (info));
+      g_assert_cmpstr (g_file_info_get_name (info), ==, g_file_info_get_name (expected));
+      g_assert_cmpint (g_file_info_get_file_type (info), ==, g_file_info_get_file_type (expected));
+      g_assert_cmpint (g_file_info_get_size (info), ==, g_file_info_get_size (expected));
+      g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE), ==,
+                        g_file_info_get_attribute_uint64 (expected, G_FILE_ATTRIBUTE_UNIX_INODE));
+      g_assert_cmpuint (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED), ==,
+                        g_file_info_get_attribute_uint64 (expected, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+      g_object_unref (expected);
+    }
+  g_ptr_array_unref (infos);
+
+  /* an empty request still completes */
+  infos = NULL;
+  g_file_query_info_many_async (NULL, 0, "standard::name", 0, G_PRIORITY_DEFAULT,
+                                NULL, query_info_many_cb, &infos);
+  while (infos == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (infos->len, ==, 0);
+  g_ptr_array_unref (infos);
+
+  for (i = 0; i < 4; i++)
+    g_file_delete (files[i], NULL, NULL);
+  g_file_delete (dir, NULL, NULL);
+  for (i = 0; i < G_N_ELEMENTS (files); i++)
+    g_object_unref (files[i]);
+  g_object_unref (dir);
+  g_free (dir_path);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -824,10 +1383,16 @@ main (int argc, char *argv[])
   g_test_add_data_func ("/file/async-create-delete/25", GINT_TO_POINTER (25), test_create_delete);
   g_test_add_data_func ("/file/async-create-delete/4096", GINT_TO_POINTER (4096), test_create_delete);
   g_test_add_func ("/file/replace-load", test_replace_load);
+  g_test_add_func ("/file/replace-load-etag", test_replace_load_etag);
   g_test_add_func ("/file/replace-cancel", test_replace_cancel);
   g_test_add_func ("/file/async-delete", test_async_delete);
+  g_test_add_func ("/file/load-bytes", test_load_bytes);
+  g_test_add_func ("/file/query-info-many", test_query_info_many);
 #ifdef G_OS_UNIX
   g_test_add_func ("/file/copy-preserve-mode", test_copy_preserve_mode);
+  g_test_add_func ("/file/query-info-subset", test_query_info_subset);
+  g_test_add_func ("/file/copy-progress", test_copy_progress);
+  g_test_add_func ("/file/walk-tree", test_walk_tree);
 #endif
 
   return g_test_run ();
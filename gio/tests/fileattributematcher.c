@@ -163,6 +163,57 @@ test_subtract (void)
     }
 }
 
+static void
+test_matches (void)
+{
+  struct {
+    char *matcher;
+    char *attribute;
+    gboolean matches;
+  } tests[] = {
+    { "standard::type", "standard::type", TRUE },
+    { "standard::type", "standard::name", FALSE },
+    { "standard::type", "unix::mode", FALSE },
+    { "standard::*", "standard::name", TRUE },
+    { "standard::*", "standard::not-builtin", TRUE },
+    { "standard::*", "unix::mode", FALSE },
+    { "unix::*,standard::size", "unix::mode", TRUE },
+    { "unix::*,standard::size", "standard::size", TRUE },
+    { "unix::*,standard::size", "standard::type", FALSE },
+    { "standard::type,xattr::foo", "xattr::foo", TRUE },
+    { "standard::type,xattr::foo", "xattr::bar", FALSE },
+    { "xattr::*", "xattr::bar", TRUE },
+    { "xattr::*", "standard::type", FALSE },
+    { "*", "standard::type", TRUE },
+    { "*", "a::b", TRUE },
+  };
+  GFileAttributeMatcher *matcher, *subtract, *result;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      matcher = g_file_attribute_matcher_new (tests[i].matcher);
+      if (g_file_attribute_matcher_matches (matcher, tests[i].attribute) != tests[i].matches)
+        {
+          g_test_fail ();
+          g_test_message ("%s should %smatch %s", tests[i].matcher,
+                          tests[i].matches ? "" : "not ", tests[i].attribute);
+        }
+      g_file_attribute_matcher_unref (matcher);
+    }
+
+  /* the result of a subtraction is matched the same way */
+  matcher = g_file_attribute_matcher_new ("standard::type,standard::size,unix::*");
+  subtract = g_file_attribute_matcher_new ("standard::type");
+  result = g_file_attribute_matcher_subtract (matcher, subtract);
+  g_assert (!g_file_attribute_matcher_matches (result, "standard::type"));
+  g_assert (g_file_attribute_matcher_matches (result, "standard::size"));
+  g_assert (g_file_attribute_matcher_matches (result, "unix::uid"));
+  g_file_attribute_matcher_unref (matcher);
+  g_file_attribute_matcher_unref (subtract);
+  g_file_attribute_matcher_unref (result);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -171,6 +222,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/fileattributematcher/exact", test_exact);
   g_test_add_func ("/fileattributematcher/equality", test_equality);
   g_test_add_func ("/fileattributematcher/subtract", test_subtract);
+  g_test_add_func ("/fileattributematcher/matches", test_matches);
 
   return g_test_run ();
 }
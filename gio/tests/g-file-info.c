@@ -132,6 +132,114 @@ test_g_file_info (void)
   g_object_unref (info_copy);
 }
 
+static void
+test_copy_on_write (void)
+{
+  GFileInfo *info, *info_dup, *info_copy;
+  const char *name;
+  gint i;
+
+  info = g_file_info_new ();
+  g_file_info_set_name (info, "original");
+  g_file_info_set_size (info, 42);
+
+  info_dup = g_file_info_dup (info);
+  info_copy = g_file_info_new ();
+  g_file_info_set_name (info_copy, "overwritten");
+  g_file_info_copy_into (info, info_copy);
+  g_assert_cmpstr (g_file_info_get_name (info_copy), ==, "original");
+
+  /* modifying one copy leaves the others alone */
+  name = g_file_info_get_name (info_dup);
+  g_file_info_set_size (info_dup, 7);
+  g_file_info_set_attribute_status (info_copy, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    G_FILE_ATTRIBUTE_STATUS_ERROR_SETTING);
+  g_file_info_remove_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+
+  g_assert_cmpint (g_file_info_get_size (info_dup), ==, 7);
+  g_assert_cmpint (g_file_info_get_size (info_copy), ==, 42);
+  g_assert (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE));
+  g_assert_cmpint (g_file_info_get_attribute_status (info_copy, G_FILE_ATTRIBUTE_STANDARD_NAME),
+                   ==, G_FILE_ATTRIBUTE_STATUS_ERROR_SETTING);
+  g_assert_cmpint (g_file_info_get_attribute_status (info, G_FILE_ATTRIBUTE_STANDARD_NAME),
+                   ==, G_FILE_ATTRIBUTE_STATUS_UNSET);
+  g_assert_cmpint (g_file_info_get_attribute_status (info_dup, G_FILE_ATTRIBUTE_STANDARD_NAME),
+                   ==, G_FILE_ATTRIBUTE_STATUS_UNSET);
+
+  /* strings returned before the copy stay valid while their info lives */
+  g_object_unref (info);
+  g_object_unref (info_copy);
+  g_assert_cmpstr (name, ==, "original");
+  g_assert_cmpstr (g_file_info_get_name (info_dup), ==, "original");
+
+  /* and across more than one copy of the same info */
+  g_file_info_set_display_name (info_dup, "display");
+  name = g_file_info_get_name (info_dup);
+  for (i = 0; i < 2; i++)
+    {
+      info = g_file_info_dup (info_dup);
+      g_file_info_set_size (info_dup, i);
+      g_object_unref (info);
+      g_assert_cmpint (g_file_info_get_size (info_dup), ==, i);
+    }
+  g_assert_cmpstr (name, ==, "original");
+
+  g_object_unref (info_dup);
+}
+
+static gpointer
+register_attributes_thread (gpointer data)
+{
+  gint n = GPOINTER_TO_INT (data);
+  GFileInfo *info;
+  gchar *name;
+  gchar **list;
+  gint i;
+
+  for (i = 0; i < 200; i++)
+    {
+      info = g_file_info_new ();
+
+      /* out of id order, and interleaved with new registrations */
+      g_file_info_set_size (info, i);
+      name = g_strdup_printf ("test-%d::attr-%d", n, i);
+      g_file_info_set_attribute_uint32 (info, name, i);
+      g_file_info_set_name (info, "name");
+      g_file_info_set_file_type (info, G_FILE_TYPE_REGULAR);
+
+      g_assert_cmpuint (g_file_info_get_attribute_uint32 (info, name), ==, i);
+      g_assert_cmpint (g_file_info_get_size (info), ==, i);
+      g_assert_cmpstr (g_file_info_get_name (info), ==, "name");
+      g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_REGULAR);
+      g_assert (g_file_info_has_namespace (info, "standard"));
+
+      list = g_file_info_list_attributes (info, NULL);
+      g_assert_cmpuint (g_strv_length (list), ==, 4);
+      g_assert_cmpstr (list[0], ==, G_FILE_ATTRIBUTE_STANDARD_TYPE);
+      g_assert_cmpstr (list[1], ==, G_FILE_ATTRIBUTE_STANDARD_NAME);
+      g_assert_cmpstr (list[2], ==, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+      g_assert_cmpstr (list[3], ==, name);
+      g_strfreev (list);
+
+      g_free (name);
+      g_object_unref (info);
+    }
+
+  return NULL;
+}
+
+static void
+test_attribute_registry_threads (void)
+{
+  GThread *threads[4];
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("register", register_attributes_thread, GINT_TO_POINTER (i));
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -139,6 +247,8 @@ main (int   argc,
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/g-file-info/test_g_file_info", test_g_file_info);
+  g_test_add_func ("/g-file-info/copy-on-write", test_copy_on_write);
+  g_test_add_func ("/g-file-info/attribute-registry-threads", test_attribute_registry_threads);
   
   return g_test_run();
 }
@@ -457,6 +457,135 @@ test_actions (void)
   g_free (binpath);
 }
 
+/* The remote instance: it learns the primary's actions while
+ * registering, and forwards its arguments.
+ */
+static void
+test_remote_subprocess (void)
+{
+  const gchar *argv[] = { "remote", "/a", NULL };
+  GApplication *app;
+  GError *error = NULL;
+  gint status;
+
+  g_setenv ("DBUS_SESSION_BUS_ADDRESS", g_getenv ("GAPPLICATION_TEST_BUS_ADDRESS"), TRUE);
+
+  app = g_application_new ("org.gtk.TestApplication.Remote", G_APPLICATION_HANDLES_OPEN);
+  g_application_register (app, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (g_application_get_is_remote (app));
+
+  /* already known, without waiting for anything */
+  g_assert (g_action_group_has_action (G_ACTION_GROUP (app), "greet"));
+  g_assert (g_variant_type_equal (g_action_group_get_action_parameter_type (G_ACTION_GROUP (app), "greet"),
+                                  G_VARIANT_TYPE_STRING));
+  g_action_group_activate_action (G_ACTION_GROUP (app), "greet", g_variant_new_string ("hello"));
+
+  status = g_application_run (app, 2, (gchar **) argv);
+  g_assert_cmpint (status, ==, 0);
+
+  g_dbus_connection_flush_sync (g_application_get_dbus_connection (app), NULL, &error);
+  g_assert_no_error (error);
+
+  g_object_unref (app);
+}
+
+static gint remote_outstanding;
+static gchar *remote_greeting;
+static gchar *remote_opened;
+
+static void
+remote_greet (GSimpleAction *action,
+              GVariant      *parameter,
+              gpointer       user_data)
+{
+  remote_greeting = g_variant_dup_string (parameter, NULL);
+  if (--remote_outstanding == 0)
+    g_main_loop_quit (main_loop);
+}
+
+static void
+remote_open (GApplication  *application,
+             GFile        **files,
+             gint           n_files,
+             const gchar   *hint)
+{
+  g_assert_cmpint (n_files, ==, 1);
+  remote_opened = g_file_get_path (files[0]);
+  if (--remote_outstanding == 0)
+    g_main_loop_quit (main_loop);
+}
+
+static void
+remote_quit (GPid     pid,
+             gint     status,
+             gpointer user_data)
+{
+  GError *error = NULL;
+
+  g_spawn_check_exit_status (status, &error);
+  g_assert_no_error (error);
+  g_spawn_close_pid (pid);
+
+  if (--remote_outstanding == 0)
+    g_main_loop_quit (main_loop);
+}
+
+static void
+test_remote (void)
+{
+  GApplication *app;
+  GSimpleAction *action;
+  GError *error = NULL;
+  gchar **envp;
+  gchar *argv[4];
+  GPid pid;
+
+  session_bus_up ();
+
+  /* The primary instance */
+  app = g_application_new ("org.gtk.TestApplication.Remote", G_APPLICATION_HANDLES_OPEN);
+  action = g_simple_action_new ("greet", G_VARIANT_TYPE_STRING);
+  g_signal_connect (action, "activate", G_CALLBACK (remote_greet), NULL);
+  g_action_map_add_action (G_ACTION_MAP (app), G_ACTION (action));
+  g_object_unref (action);
+  g_signal_connect (app, "open", G_CALLBACK (remote_open), NULL);
+
+  g_application_register (app, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (!g_application_get_is_remote (app));
+  g_assert (g_action_group_has_action (G_ACTION_GROUP (app), "greet"));
+
+  /* g_test_dbus_unset() in main() clears the bus address */
+  envp = g_environ_setenv (g_get_environ (), "GAPPLICATION_TEST_BUS_ADDRESS",
+                           g_getenv ("DBUS_SESSION_BUS_ADDRESS"), TRUE);
+  argv[0] = g_test_build_filename (G_TEST_BUILT, "gapplication", NULL);
+  argv[1] = "-p";
+  argv[2] = "/gapplication/remote/subprocess";
+  argv[3] = NULL;
+
+  g_spawn_async (NULL, argv, envp, G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL,
+                 NULL, NULL, &pid, &error);
+  g_assert_no_error (error);
+  g_child_watch_add (pid, remote_quit, NULL);
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+  remote_outstanding = 3;
+  g_main_loop_run (main_loop);
+  g_main_loop_unref (main_loop);
+
+  g_assert_cmpstr (remote_greeting, ==, "hello");
+  g_assert_cmpstr (remote_opened, ==, "/a");
+
+  g_free (remote_greeting);
+  g_free (remote_opened);
+  g_free (argv[0]);
+  g_strfreev (envp);
+  g_object_unref (app);
+
+  session_bus_down ();
+}
+
 typedef GApplication TestLocCmdApp;
 typedef GApplicationClass TestLocCmdAppClass;
 
@@ -527,6 +656,8 @@ main (int argc, char **argv)
   g_test_add_func ("/gapplication/app-id", appid);
   g_test_add_func ("/gapplication/quit", test_quit);
   g_test_add_func ("/gapplication/actions", test_actions);
+  g_test_add_func ("/gapplication/remote", test_remote);
+  g_test_add_func ("/gapplication/remote/subprocess", test_remote_subprocess);
   g_test_add_func ("/gapplication/local-command-line", test_local_command_line);
 
   return g_test_run ();
@@ -0,0 +1,726 @@
+/* GDBus - GLib D-Bus Library
+ *
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Latency and throughput benchmarks for GDBus.
+ *
+ * Every benchmark runs against a service living in its own thread,
+ * either connected peer-to-peer (through a GDBusServer) or through the
+ * bus daemon from gdbusdaemon.c, which then runs in a thread of its own.
+ *
+ * Results are printed one per line, tab separated:
+ *
+ *   transport  benchmark  parameter  metric  value  unit
+ *
+ * so that runs can be compared with standard tools.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gdbusdaemon.h"
+
+static gint opt_iterations = 10000;
+static gchar *opt_transport = NULL;
+static gboolean opt_quick = FALSE;
+static gint opt_routing_threads = 0;
+
+static const gchar introspection_xml[] =
+  "<node>"
+  "  <interface name='org.gtk.GDBus.Benchmark'>"
+  "    <method name='Ping'/>"
+  "    <method name='Sink'>"
+  "      <arg type='ay' name='data' direction='in'/>"
+  "    </method>"
+  "    <method name='EmitTicks'>"
+  "      <arg type='u' name='count' direction='in'/>"
+  "    </method>"
+  "    <signal name='Tick'>"
+  "      <arg type='u' name='n'/>"
+  "    </signal>"
+  "  </interface>"
+  "</node>";
+
+static GDBusNodeInfo *introspection_data = NULL;
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct
+{
+  gboolean use_bus;
+  gchar *client_address;
+  GDBusConnectionFlags client_flags;
+  /* the unique name of the service when going through the bus */
+  gchar *service_name;
+
+  GThread *daemon_thread;
+  GMainContext *daemon_context;
+  GMainLoop *daemon_loop;
+
+  GThread *service_thread;
+  GMainContext *service_context;
+  GMainLoop *service_loop;
+  GDBusServer *server;
+  /* connections the service talks on; protected by @lock since
+   * connections accepted by @server emit ::closed in the main thread
+   */
+  GPtrArray *service_connections;
+
+  GMutex lock;
+  GCond cond;
+  gboolean ready;
+} Setup;
+
+static void
+setup_signal_ready (Setup *setup)
+{
+  g_mutex_lock (&setup->lock);
+  setup->ready = TRUE;
+  g_cond_broadcast (&setup->cond);
+  g_mutex_unlock (&setup->lock);
+}
+
+static void
+setup_wait_ready (Setup *setup)
+{
+  g_mutex_lock (&setup->lock);
+  while (!setup->ready)
+    g_cond_wait (&setup->cond, &setup->lock);
+  setup->ready = FALSE;
+  g_mutex_unlock (&setup->lock);
+}
+
+static void
+handle_method_call (GDBusConnection       *connection,
+                    const gchar           *sender,
+                    const gchar           *object_path,
+                    const gchar           *interface_name,
+                    const gchar           *method_name,
+                    GVariant              *parameters,
+                    GDBusMethodInvocation *invocation,
+                    gpointer               user_data)
+{
+  Setup *setup = user_data;
+
+  if (g_strcmp0 (method_name, "EmitTicks") == 0)
+    {
+      GPtrArray *connections;
+      guint count;
+      guint n;
+      guint m;
+
+      connections = g_ptr_array_new_with_free_func (g_object_unref);
+      g_mutex_lock (&setup->lock);
+      for (m = 0; m < setup->service_connections->len; m++)
+        g_ptr_array_add (connections, g_object_ref (setup->service_connections->pdata[m]));
+      g_mutex_unlock (&setup->lock);
+
+      g_variant_get (parameters, "(u)", &count);
+      for (n = 0; n < count; n++)
+        {
+          for (m = 0; m < connections->len; m++)
+            g_dbus_connection_emit_signal (connections->pdata[m],
+                                           NULL,
+                                           "/org/gtk/GDBus/Benchmark",
+                                           "org.gtk.GDBus.Benchmark",
+                                           "Tick",
+                                           g_variant_new ("(u)", n),
+                                           NULL);
+        }
+      g_ptr_array_unref (connections);
+    }
+
+  /* Ping and Sink don't do anything */
+  g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static const GDBusInterfaceVTable interface_vtable =
+{
+  handle_method_call,
+  NULL,
+  NULL
+};
+
+static void
+on_service_connection_closed (GDBusConnection *connection,
+                              gboolean         remote_peer_vanished,
+                              GError          *error,
+                              gpointer         user_data)
+{
+  Setup *setup = user_data;
+
+  g_mutex_lock (&setup->lock);
+  if (setup->service_connections != NULL)
+    g_ptr_array_remove (setup->service_connections, connection);
+  g_mutex_unlock (&setup->lock);
+}
+
+/* called in the service thread */
+static void
+service_add_connection (Setup           *setup,
+                        GDBusConnection *connection)
+{
+  GError *error = NULL;
+  guint id;
+
+  id = g_dbus_connection_register_object (connection,
+                                          "/org/gtk/GDBus/Benchmark",
+                                          introspection_data->interfaces[0],
+                                          &interface_vtable,
+                                          setup,
+                                          NULL,
+                                          &error);
+  g_assert_no_error (error);
+  g_assert (id > 0);
+  g_mutex_lock (&setup->lock);
+  g_ptr_array_add (setup->service_connections, g_object_ref (connection));
+  g_mutex_unlock (&setup->lock);
+  g_signal_connect (connection, "closed", G_CALLBACK (on_service_connection_closed), setup);
+}
+
+static gboolean
+on_new_connection (GDBusServer     *server,
+                   GDBusConnection *connection,
+                   gpointer         user_data)
+{
+  service_add_connection (user_data, connection);
+  return TRUE;
+}
+
+static gpointer
+service_thread_func (gpointer user_data)
+{
+  Setup *setup = user_data;
+  GError *error = NULL;
+  guint n;
+
+  g_main_context_push_thread_default (setup->service_context);
+
+  if (setup->use_bus)
+    {
+      GDBusConnection *connection;
+
+      connection = g_dbus_connection_new_for_address_sync (setup->client_address,
+                                                           setup->client_flags,
+                                                           NULL, NULL, &error);
+      g_assert_no_error (error);
+      setup->service_name = g_strdup (g_dbus_connection_get_unique_name (connection));
+      service_add_connection (setup, connection);
+      g_object_unref (connection);
+    }
+  else
+    {
+      gchar *address;
+      gchar *guid;
+
+      address = g_strdup_printf ("unix:tmpdir=%s", g_get_tmp_dir ());
+      guid = g_dbus_generate_guid ();
+      setup->server = g_dbus_server_new_sync (address,
+                                              G_DBUS_SERVER_FLAGS_NONE,
+                                              guid,
+                                              NULL, /* GDBusAuthObserver */
+                                              NULL, /* GCancellable */
+                                              &error);
+      g_assert_no_error (error);
+      g_signal_connect (setup->server, "new-connection", G_CALLBACK (on_new_connection), setup);
+      g_dbus_server_start (setup->server);
+      setup->client_address = g_strdup (g_dbus_server_get_client_address (setup->server));
+      g_free (guid);
+      g_free (address);
+    }
+
+  setup_signal_ready (setup);
+  g_main_loop_run (setup->service_loop);
+
+  if (setup->server != NULL)
+    {
+      g_dbus_server_stop (setup->server);
+      g_object_unref (setup->server);
+    }
+  g_mutex_lock (&setup->lock);
+  for (n = 0; n < setup->service_connections->len; n++)
+    g_signal_handlers_disconnect_by_func (setup->service_connections->pdata[n],
+                                          on_service_connection_closed,
+                                          setup);
+  g_ptr_array_unref (setup->service_connections);
+  setup->service_connections = NULL;
+  g_mutex_unlock (&setup->lock);
+
+  g_main_context_pop_thread_default (setup->service_context);
+
+  return NULL;
+}
+
+static gpointer
+daemon_thread_func (gpointer user_data)
+{
+  Setup *setup = user_data;
+  GDBusDaemon *daemon;
+  GError *error = NULL;
+  gchar *address;
+
+  g_main_context_push_thread_default (setup->daemon_context);
+
+  address = g_strdup_printf ("unix:tmpdir=%s", g_get_tmp_dir ());
+  daemon = g_initable_new (G_TYPE_DBUS_DAEMON,
+                           NULL,
+                           &error,
+                           "address", address,
+                           "routing-threads", (guint) MAX (opt_routing_threads, 0),
+                           NULL);
+  g_assert_no_error (error);
+  setup->client_address = g_strdup (_g_dbus_daemon_get_address (daemon));
+  g_free (address);
+
+  setup_signal_ready (setup);
+  g_main_loop_run (setup->daemon_loop);
+
+  g_object_unref (daemon);
+  g_main_context_pop_thread_default (setup->daemon_context);
+
+  return NULL;
+}
+
+static Setup *
+setup_new (gboolean use_bus)
+{
+  Setup *setup;
+
+  setup = g_new0 (Setup, 1);
+  setup->use_bus = use_bus;
+  g_mutex_init (&setup->lock);
+  g_cond_init (&setup->cond);
+
+  if (use_bus)
+    {
+      setup->client_flags = G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION;
+      setup->daemon_context = g_main_context_new ();
+      setup->daemon_loop = g_main_loop_new (setup->daemon_context, FALSE);
+      setup->daemon_thread = g_thread_new ("benchmark-daemon", daemon_thread_func, setup);
+      setup_wait_ready (setup);
+    }
+  else
+    {
+      setup->client_flags = G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT;
+    }
+
+  setup->service_connections = g_ptr_array_new_with_free_func (g_object_unref);
+  setup->service_context = g_main_context_new ();
+  setup->service_loop = g_main_loop_new (setup->service_context, FALSE);
+  setup->service_thread = g_thread_new ("benchmark-service", service_thread_func, setup);
+  setup_wait_ready (setup);
+
+  return setup;
+}
+
+static void
+setup_free (Setup *setup)
+{
+  g_main_loop_quit (setup->service_loop);
+  g_thread_join (setup->service_thread);
+  g_main_loop_unref (setup->service_loop);
+  g_main_context_unref (setup->service_context);
+
+  if (setup->daemon_thread != NULL)
+    {
+      g_main_loop_quit (setup->daemon_loop);
+      g_thread_join (setup->daemon_thread);
+      g_main_loop_unref (setup->daemon_loop);
+      g_main_context_unref (setup->daemon_context);
+    }
+
+  g_mutex_clear (&setup->lock);
+  g_cond_clear (&setup->cond);
+  g_free (setup->client_address);
+  g_free (setup->service_name);
+  g_free (setup);
+}
+
+static GDBusConnection *
+setup_connect (Setup *setup)
+{
+  GDBusConnection *connection;
+  GError *error = NULL;
+
+  connection = g_dbus_connection_new_for_address_sync (setup->client_address,
+                                                       setup->client_flags,
+                                                       NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  return connection;
+}
+
+static GVariant *
+setup_call (Setup           *setup,
+            GDBusConnection *connection,
+            const gchar     *method_name,
+            GVariant        *parameters)
+{
+  GVariant *result;
+  GError *error = NULL;
+
+  result = g_dbus_connection_call_sync (connection,
+                                        setup->service_name,
+                                        "/org/gtk/GDBus/Benchmark",
+                                        "org.gtk.GDBus.Benchmark",
+                                        method_name,
+                                        parameters,
+                                        G_VARIANT_TYPE_UNIT,
+                                        G_DBUS_CALL_FLAGS_NONE,
+                                        -1,
+                                        NULL,
+                                        &error);
+  g_assert_no_error (error);
+
+  return result;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static const gchar *current_transport;
+
+static void
+report (const gchar *benchmark,
+        const gchar *parameter,
+        const gchar *metric,
+        gdouble      value,
+        const gchar *unit)
+{
+  g_print ("%s\t%s\t%s\t%s\t%.3f\t%s\n",
+           current_transport, benchmark, parameter, metric, value, unit);
+}
+
+static gint
+compare_gint64 (gconstpointer a,
+                gconstpointer b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void
+benchmark_latency (Setup *setup)
+{
+  GDBusConnection *connection;
+  gint64 *samples;
+  gint64 total;
+  gint n;
+
+  connection = setup_connect (setup);
+  samples = g_new (gint64, opt_iterations);
+
+  /* warm up */
+  for (n = 0; n < 100; n++)
+    g_variant_unref (setup_call (setup, connection, "Ping", NULL));
+
+  total = 0;
+  for (n = 0; n < opt_iterations; n++)
+    {
+      gint64 start = g_get_monotonic_time ();
+      g_variant_unref (setup_call (setup, connection, "Ping", NULL));
+      samples[n] = g_get_monotonic_time () - start;
+      total += samples[n];
+    }
+
+  qsort (samples, opt_iterations, sizeof (gint64), compare_gint64);
+  report ("latency", "-", "mean", (gdouble) total / opt_iterations, "us");
+  report ("latency", "-", "p50", samples[opt_iterations / 2], "us");
+  report ("latency", "-", "p90", samples[opt_iterations * 9 / 10], "us");
+  report ("latency", "-", "p99", samples[opt_iterations * 99 / 100], "us");
+  report ("latency", "-", "max", samples[opt_iterations - 1], "us");
+
+  g_free (samples);
+  g_dbus_connection_close_sync (connection, NULL, NULL);
+  g_object_unref (connection);
+}
+
+typedef struct
+{
+  guint received;
+  guint expected;
+  gboolean replied;
+  GMainLoop *loop;
+} FanOutData;
+
+static void
+on_tick (GDBusConnection *connection,
+         const gchar     *sender_name,
+         const gchar     *object_path,
+         const gchar     *interface_name,
+         const gchar     *signal_name,
+         GVariant        *parameters,
+         gpointer         user_data)
+{
+  FanOutData *data = user_data;
+
+  if (++data->received == data->expected && data->replied)
+    g_main_loop_quit (data->loop);
+}
+
+static void
+on_emit_ticks_done (GObject      *source,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  FanOutData *data = user_data;
+  GVariant *result;
+  GError *error = NULL;
+
+  result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), res, &error);
+  g_assert_no_error (error);
+  g_variant_unref (result);
+
+  data->replied = TRUE;
+  if (data->received == data->expected)
+    g_main_loop_quit (data->loop);
+}
+
+static void
+benchmark_fan_out (Setup *setup,
+                   guint  n_subscribers)
+{
+  GDBusConnection **subscribers;
+  FanOutData data;
+  gchar *parameter;
+  guint count;
+  gint64 start;
+  gdouble elapsed;
+  guint n;
+
+  count = MAX (opt_iterations / n_subscribers, 1);
+  data.received = 0;
+  data.expected = count * n_subscribers;
+  data.replied = FALSE;
+  data.loop = g_main_loop_new (NULL, FALSE);
+
+  subscribers = g_new (GDBusConnection *, n_subscribers);
+  for (n = 0; n < n_subscribers; n++)
+    {
+      subscribers[n] = setup_connect (setup);
+      g_dbus_connection_signal_subscribe (subscribers[n],
+                                          setup->service_name,
+                                          "org.gtk.GDBus.Benchmark",
+                                          "Tick",
+                                          "/org/gtk/GDBus/Benchmark",
+                                          NULL,
+                                          G_DBUS_SIGNAL_FLAGS_NONE,
+                                          on_tick,
+                                          &data,
+                                          NULL);
+      /* make sure the service knows about us (peer) or the match rule
+       * is in place (bus) before we start
+       */
+      g_variant_unref (setup_call (setup, subscribers[n], "Ping", NULL));
+    }
+
+  start = g_get_monotonic_time ();
+  g_dbus_connection_call (subscribers[0],
+                          setup->service_name,
+                          "/org/gtk/GDBus/Benchmark",
+                          "org.gtk.GDBus.Benchmark",
+                          "EmitTicks",
+                          g_variant_new ("(u)", count),
+                          G_VARIANT_TYPE_UNIT,
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,
+                          NULL,
+                          on_emit_ticks_done,
+                          &data);
+  g_main_loop_run (data.loop);
+  elapsed = (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+
+  parameter = g_strdup_printf ("subscribers=%u", n_subscribers);
+  report ("signal-fan-out", parameter, "delivered", data.received / elapsed, "signals/s");
+  g_free (parameter);
+
+  for (n = 0; n < n_subscribers; n++)
+    {
+      g_dbus_connection_close_sync (subscribers[n], NULL, NULL);
+      g_object_unref (subscribers[n]);
+    }
+  g_free (subscribers);
+  g_main_loop_unref (data.loop);
+}
+
+static void
+benchmark_bandwidth (Setup *setup,
+                     gsize  size)
+{
+  GDBusConnection *connection;
+  GVariant *payload;
+  GBytes *bytes;
+  gchar *parameter;
+  gint64 start;
+  gdouble elapsed;
+  guint repeats;
+  guint n;
+
+  connection = setup_connect (setup);
+
+  bytes = g_bytes_new_take (g_malloc0 (size), size);
+  payload = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING, bytes, TRUE));
+  repeats = MAX ((opt_quick ? 16 : 256) * 1024 * 1024 / size, 4);
+
+  start = g_get_monotonic_time ();
+  for (n = 0; n < repeats; n++)
+    g_variant_unref (setup_call (setup, connection, "Sink", g_variant_new_tuple (&payload, 1)));
+  elapsed = (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+
+  parameter = g_strdup_printf ("size=%" G_GSIZE_FORMAT, size);
+  report ("bandwidth", parameter, "throughput", (gdouble) size * repeats / elapsed / (1024 * 1024), "MiB/s");
+  g_free (parameter);
+
+  g_variant_unref (payload);
+  g_bytes_unref (bytes);
+  g_dbus_connection_close_sync (connection, NULL, NULL);
+  g_object_unref (connection);
+}
+
+typedef struct
+{
+  Setup *setup;
+  GDBusConnection *connection;
+  gint calls;
+} ScalingData;
+
+static gpointer
+scaling_thread_func (gpointer user_data)
+{
+  ScalingData *data = user_data;
+  gint n;
+
+  for (n = 0; n < data->calls; n++)
+    g_variant_unref (setup_call (data->setup, data->connection, "Ping", NULL));
+
+  return NULL;
+}
+
+static void
+benchmark_scaling (Setup *setup,
+                   guint  n_connections)
+{
+  ScalingData *data;
+  GThread **threads;
+  gchar *parameter;
+  gint64 start;
+  gdouble elapsed;
+  guint n;
+
+  data = g_new (ScalingData, n_connections);
+  threads = g_new (GThread *, n_connections);
+  for (n = 0; n < n_connections; n++)
+    {
+      data[n].setup = setup;
+      data[n].connection = setup_connect (setup);
+      data[n].calls = MAX (opt_iterations / n_connections, 1);
+    }
+
+  start = g_get_monotonic_time ();
+  for (n = 0; n < n_connections; n++)
+    threads[n] = g_thread_new ("benchmark-client", scaling_thread_func, &data[n]);
+  for (n = 0; n < n_connections; n++)
+    g_thread_join (threads[n]);
+  elapsed = (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+
+  parameter = g_strdup_printf ("connections=%u", n_connections);
+  report ("connection-scaling", parameter, "calls",
+          data[0].calls * n_connections / elapsed, "calls/s");
+  g_free (parameter);
+
+  for (n = 0; n < n_connections; n++)
+    {
+      g_dbus_connection_close_sync (data[n].connection, NULL, NULL);
+      g_object_unref (data[n].connection);
+    }
+  g_free (threads);
+  g_free (data);
+}
+
+static void
+run_benchmarks (gboolean use_bus)
+{
+  static const guint fan_out[] = { 1, 4, 16 };
+  static const gsize sizes[] = { 4096, 65536, 1024 * 1024, 16 * 1024 * 1024 };
+  static const guint scaling[] = { 1, 2, 4, 8, 32 };
+  Setup *setup;
+  guint n;
+
+  current_transport = use_bus ? "bus" : "peer";
+  setup = setup_new (use_bus);
+
+  benchmark_latency (setup);
+  for (n = 0; n < G_N_ELEMENTS (fan_out); n++)
+    benchmark_fan_out (setup, fan_out[n]);
+  for (n = 0; n < G_N_ELEMENTS (sizes); n++)
+    benchmark_bandwidth (setup, sizes[n]);
+  for (n = 0; n < G_N_ELEMENTS (scaling); n++)
+    benchmark_scaling (setup, scaling[n]);
+
+  setup_free (setup);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GOptionEntry entries[] = {
+    { "transport", 't', 0, G_OPTION_ARG_STRING, &opt_transport, "Only run over TRANSPORT (peer or bus)", "TRANSPORT" },
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iterations, "Number of calls or signals per benchmark", "N" },
+    { "quick", 'q', 0, G_OPTION_ARG_NONE, &opt_quick, "Do fewer iterations, for a smoke test", NULL },
+    { "routing-threads", 0, 0, G_OPTION_ARG_INT, &opt_routing_threads, "Number of threads the bus routes messages in", "N" },
+    { NULL }
+  };
+
+  context = g_option_context_new ("- GDBus benchmarks");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if (opt_quick)
+    opt_iterations = MIN (opt_iterations, 500);
+  if (opt_iterations < 1)
+    opt_iterations = 1;
+
+  introspection_data = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+  g_assert (introspection_data != NULL);
+
+  g_print ("# transport\tbenchmark\tparameter\tmetric\tvalue\tunit\n");
+  if (opt_transport == NULL || g_strcmp0 (opt_transport, "peer") == 0)
+    run_benchmarks (FALSE);
+  if (opt_transport == NULL || g_strcmp0 (opt_transport, "bus") == 0)
+    run_benchmarks (TRUE);
+
+  g_dbus_node_info_unref (introspection_data);
+  g_free (opt_transport);
+
+  return 0;
+}
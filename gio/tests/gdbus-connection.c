@@ -790,6 +790,105 @@ test_connection_signal_match_rules (void)
   session_bus_down ();
 }
 
+static void
+emit_foo_and_wait (GDBusConnection *connection,
+                   const gchar     *arg0)
+{
+  GError *error = NULL;
+
+  g_dbus_connection_emit_signal (connection,
+                                 NULL, "/", "org.gtk.ExampleInterface",
+                                 "Foo", g_variant_new ("(s)", arg0),
+                                 &error);
+  g_assert_no_error (error);
+
+  /* synchronously ping a non-existent method to make sure the signals are dispatched */
+  g_dbus_connection_call_sync (connection, "org.gtk.ExampleInterface", "/", "org.gtk.ExampleInterface",
+                               "Bar", g_variant_new ("()"), G_VARIANT_TYPE_UNIT, G_DBUS_CALL_FLAGS_NONE,
+                               -1, NULL, NULL);
+
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+/* Checks that each signal reaches exactly the matching subscriptions
+ * when there are many of them of all kinds
+ */
+static void
+test_connection_signal_match_rules_many (void)
+{
+  GDBusConnection *con;
+  guint name_ids[50];
+  gint name_matches[50];
+  const gchar *rules[] = { "org.gtk", "org.gtk.Example", "/org/", "/org/gtk/Example/Foo" };
+  GDBusSignalFlags rule_flags[] = { G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_NAMESPACE,
+                                    G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_NAMESPACE,
+                                    G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH,
+                                    G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH };
+  guint rule_ids[G_N_ELEMENTS (rules)];
+  gint rule_matches[G_N_ELEMENTS (rules)];
+  guint n;
+
+  session_bus_up ();
+  con = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+
+  for (n = 0; n < G_N_ELEMENTS (name_ids); n++)
+    {
+      gchar *name;
+
+      name = g_strdup_printf ("name%u", n);
+      name_matches[n] = 0;
+      name_ids[n] = g_dbus_connection_signal_subscribe (con,
+                                                        NULL, "org.gtk.ExampleInterface", "Foo", "/",
+                                                        name,
+                                                        G_DBUS_SIGNAL_FLAGS_NONE,
+                                                        test_connection_signal_handler,
+                                                        &name_matches[n], NULL);
+      g_assert_cmpint (name_ids[n], !=, 0);
+      g_free (name);
+    }
+  for (n = 0; n < G_N_ELEMENTS (rules); n++)
+    {
+      rule_matches[n] = 0;
+      rule_ids[n] = g_dbus_connection_signal_subscribe (con,
+                                                        NULL, "org.gtk.ExampleInterface", "Foo", "/",
+                                                        rules[n],
+                                                        rule_flags[n],
+                                                        test_connection_signal_handler,
+                                                        &rule_matches[n], NULL);
+      g_assert_cmpint (rule_ids[n], !=, 0);
+    }
+
+  emit_foo_and_wait (con, "name7");
+  emit_foo_and_wait (con, "org.gtk.Example");
+  emit_foo_and_wait (con, "/org/gtk/");
+
+  for (n = 0; n < G_N_ELEMENTS (name_ids); n++)
+    g_assert_cmpint (name_matches[n], ==, n == 7 ? 1 : 0);
+  g_assert_cmpint (rule_matches[0], ==, 1);
+  g_assert_cmpint (rule_matches[1], ==, 1);
+  g_assert_cmpint (rule_matches[2], ==, 1);
+  g_assert_cmpint (rule_matches[3], ==, 1);
+
+  /* unsubscribing must take the rules out of the index */
+  g_dbus_connection_signal_unsubscribe (con, name_ids[7]);
+  g_dbus_connection_signal_unsubscribe (con, rule_ids[3]);
+  emit_foo_and_wait (con, "name7");
+  emit_foo_and_wait (con, "/org/gtk/");
+  g_assert_cmpint (name_matches[7], ==, 1);
+  g_assert_cmpint (rule_matches[2], ==, 2);
+  g_assert_cmpint (rule_matches[3], ==, 1);
+
+  for (n = 0; n < G_N_ELEMENTS (name_ids); n++)
+    if (n != 7)
+      g_dbus_connection_signal_unsubscribe (con, name_ids[n]);
+  for (n = 0; n < G_N_ELEMENTS (rules) - 1; n++)
+    g_dbus_connection_signal_unsubscribe (con, rule_ids[n]);
+
+  g_object_unref (con);
+  session_bus_down ();
+}
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 typedef struct
@@ -1232,6 +1331,7 @@ main (int   argc,
   g_test_add_func ("/gdbus/connection/send", test_connection_send);
   g_test_add_func ("/gdbus/connection/signals", test_connection_signals);
   g_test_add_func ("/gdbus/connection/signal-match-rules", test_connection_signal_match_rules);
+  g_test_add_func ("/gdbus/connection/signal-match-rules-many", test_connection_signal_match_rules_many);
   g_test_add_func ("/gdbus/connection/filter", test_connection_filter);
   g_test_add_func ("/gdbus/connection/serials", test_connection_serials);
   return g_test_run();
@@ -13,12 +13,14 @@ main (int argc, char *argv[])
   GError *error = NULL;
   gboolean print_address = FALSE;
   gboolean print_env = FALSE;
+  gint routing_threads = 0;
   GOptionContext *context;
   GOptionEntry entries[] = {
     { "address", 0, 0, G_OPTION_ARG_STRING, &address, N_("Address to listen on"), NULL },
     { "config-file", 0, 0, G_OPTION_ARG_STRING, &config_file, N_("Ignored, for compat with GTestDbus"), NULL },
     { "print-address", 0, 0, G_OPTION_ARG_NONE, &print_address, N_("Print address"), NULL },
     { "print-env", 0, 0, G_OPTION_ARG_NONE, &print_env, N_("Print address in shell mode"), NULL },
+    { "routing-threads", 0, 0, G_OPTION_ARG_INT, &routing_threads, N_("Number of threads routing messages"), N_("N") },
     { NULL }
   };
 
@@ -49,7 +51,12 @@ main (int argc, char *argv[])
   if (argc >= 2)
     address = argv[1];
 
-  daemon = _g_dbus_daemon_new (address, NULL, &error);
+  daemon = g_initable_new (G_TYPE_DBUS_DAEMON,
+                           NULL,
+                           &error,
+                           "address", address,
+                           "routing-threads", (guint) MAX (routing_threads, 0),
+                           NULL);
   if (daemon == NULL)
     {
       g_printerr ("Can't init bus: %s\n", error->message);
@@ -143,6 +143,54 @@ message_copy (void)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+static void
+message_fixed_arrays (void)
+{
+  GDBusMessage *m;
+  GDBusMessage *recovered;
+  GVariant *body;
+  GError *error;
+  guchar *blob;
+  gsize blob_size;
+  guint n;
+
+  /* The odd-sized members in between check that element alignment
+   * after the array length is honoured.
+   */
+  body = g_variant_new_parsed ("(byte 1, @ay [1, 2, 3], byte 4, [int64 -1, 1099511627776],"
+                               " [2.5, -0.125], byte 5, [int16 -2, 3], [uint16 65535],"
+                               " [int32 -4], [uint32 4000000000], [uint64 1, 2],"
+                               " @ai [], [true, false])");
+
+  m = g_dbus_message_new_method_call ("org.example.Name",
+                                      "/org/example/Object",
+                                      "org.example.Interface",
+                                      "Method");
+  g_dbus_message_set_serial (m, 42);
+  g_dbus_message_set_body (m, body);
+
+  for (n = 0; n < 2; n++)
+    {
+      g_dbus_message_set_byte_order (m, n == 0 ? G_DBUS_MESSAGE_BYTE_ORDER_BIG_ENDIAN
+                                               : G_DBUS_MESSAGE_BYTE_ORDER_LITTLE_ENDIAN);
+
+      error = NULL;
+      blob = g_dbus_message_to_blob (m, &blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+
+      recovered = g_dbus_message_new_from_blob (blob, blob_size, G_DBUS_CAPABILITY_FLAGS_NONE, &error);
+      g_assert_no_error (error);
+      g_assert (g_variant_equal (g_dbus_message_get_body (recovered), body));
+
+      g_object_unref (recovered);
+      g_free (blob);
+    }
+
+  g_object_unref (m);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
 int
 main (int   argc,
       char *argv[])
@@ -153,6 +201,7 @@ main (int   argc,
 
   g_test_add_func ("/gdbus/message/lock", message_lock);
   g_test_add_func ("/gdbus/message/copy", message_copy);
+  g_test_add_func ("/gdbus/message/fixed-arrays", message_fixed_arrays);
   return g_test_run();
 }
 
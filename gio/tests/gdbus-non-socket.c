@@ -128,8 +128,9 @@ static const GDBusInterfaceVTable pokee_vtable = {
  * See https://bugzilla.gnome.org/show_bug.cgi?id=658999 for why that's bad.
  */
 static void
-test_non_socket (void)
+test_non_socket (gconstpointer data)
 {
+  GDBusConnectionFlags extra_flags = GPOINTER_TO_UINT (data);
   GIOStream *streams[2];
   GDBusConnection *connection;
   GError *error;
@@ -185,7 +186,8 @@ test_non_socket (void)
       connection = g_dbus_connection_new_sync (streams[0],
                                                guid,
                                                G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER |
-                                               G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING,
+                                               G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING |
+                                               extra_flags,
                                                NULL, /* GDBusAuthObserver */
                                                NULL,
                                                &error);
@@ -247,7 +249,8 @@ test_non_socket (void)
 
   connection = g_dbus_connection_new_sync (streams[1],
                                            NULL, /* guid */
-                                           G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                           G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                           extra_flags,
                                            NULL, /* GDBusAuthObserver */
                                            NULL,
                                            &error);
@@ -280,7 +283,7 @@ test_non_socket (void)
 #else /* G_OS_UNIX */
 
 static void
-test_non_socket (void)
+test_non_socket (gconstpointer data)
 {
   /* TODO: test this with e.g. GWin32InputStream/GWin32OutputStream */
 }
@@ -296,7 +299,10 @@ main (int   argc,
 
   g_test_init (&argc, &argv, NULL);
 
-  g_test_add_func ("/gdbus/non-socket", test_non_socket);
+  g_test_add_data_func ("/gdbus/non-socket", GUINT_TO_POINTER (0), test_non_socket);
+  g_test_add_data_func ("/gdbus/non-socket/dedicated-worker-thread",
+                        GUINT_TO_POINTER (G_DBUS_CONNECTION_FLAGS_DEDICATED_WORKER_THREAD),
+                        test_non_socket);
 
   ret = g_test_run();
 
@@ -353,6 +353,132 @@ test_object_manager (Test *test,
   g_object_unref (client);
 }
 
+static void
+on_manager_signal (GDBusConnection *connection,
+                   const gchar     *sender_name,
+                   const gchar     *object_path,
+                   const gchar     *interface_name,
+                   const gchar     *signal_name,
+                   GVariant        *parameters,
+                   gpointer         user_data)
+{
+  GPtrArray *signals = user_data;
+  const gchar *path;
+
+  g_variant_get_child (parameters, 0, "&o", &path);
+  g_ptr_array_add (signals, g_strdup_printf ("%s %s", signal_name, path));
+}
+
+static GDBusObjectSkeleton *
+new_mock_object (const gchar *object_path,
+                 gint         number)
+{
+  GDBusObjectSkeleton *skeleton;
+  MockInterface *mock;
+
+  mock = g_object_new (mock_interface_get_type (), NULL);
+  mock->number = number;
+  skeleton = g_dbus_object_skeleton_new (object_path);
+  g_dbus_object_skeleton_add_interface (skeleton, G_DBUS_INTERFACE_SKELETON (mock));
+  g_object_unref (mock);
+
+  return skeleton;
+}
+
+static GVariant *
+get_managed_objects (Test *test)
+{
+  GVariant *reply;
+  GError *error = NULL;
+
+  g_dbus_connection_call (test->client, NULL, "/objects",
+                          "org.freedesktop.DBus.ObjectManager",
+                          "GetManagedObjects", NULL,
+                          G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+                          G_DBUS_CALL_FLAGS_NONE, -1, NULL, on_result, test);
+  g_main_loop_run (test->loop);
+  reply = g_dbus_connection_call_finish (test->client, test->result, &error);
+  g_assert_no_error (error);
+  g_clear_object (&test->result);
+
+  return reply;
+}
+
+static void
+test_object_manager_batch (Test *test,
+                           gconstpointer unused)
+{
+  GDBusObjectManagerServer *server;
+  GDBusObjectSkeleton *skeleton;
+  GPtrArray *signals;
+  GVariant *reply;
+  GVariant *objects;
+  guint id;
+
+  server = g_dbus_object_manager_server_new ("/objects");
+  g_dbus_object_manager_server_set_connection (server, test->server);
+
+  signals = g_ptr_array_new_with_free_func (g_free);
+  id = g_dbus_connection_signal_subscribe (test->client, NULL,
+                                           "org.freedesktop.DBus.ObjectManager",
+                                           NULL, "/objects", NULL,
+                                           G_DBUS_SIGNAL_FLAGS_NONE,
+                                           on_manager_signal, signals, NULL);
+
+  skeleton = new_mock_object ("/objects/old", 0);
+  g_dbus_object_manager_server_export (server, skeleton);
+  g_object_unref (skeleton);
+
+  g_dbus_object_manager_server_begin_batch (server);
+  g_dbus_object_manager_server_begin_batch (server);
+
+  skeleton = new_mock_object ("/objects/number_1", 1);
+  g_dbus_object_manager_server_export (server, skeleton);
+  g_object_unref (skeleton);
+
+  /* exported and gone again within the batch: never announced */
+  skeleton = new_mock_object ("/objects/number_2", 2);
+  g_dbus_object_manager_server_export (server, skeleton);
+  g_object_unref (skeleton);
+  g_assert (g_dbus_object_manager_server_unexport (server, "/objects/number_2"));
+
+  g_assert (g_dbus_object_manager_server_unexport (server, "/objects/old"));
+
+  skeleton = new_mock_object ("/objects/number_3", 3);
+  g_dbus_object_manager_server_export (server, skeleton);
+  g_object_unref (skeleton);
+
+  g_dbus_object_manager_server_end_batch (server);
+
+  /* GetManagedObjects() sees the changes before they are announced */
+  reply = get_managed_objects (test);
+  objects = g_variant_get_child_value (reply, 0);
+  g_assert_cmpint (g_variant_n_children (objects), ==, 2);
+  g_variant_unref (objects);
+  g_variant_unref (reply);
+
+  /* the signals before the reply have been dispatched by now */
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+  g_assert_cmpint (signals->len, ==, 1);
+  g_assert_cmpstr (signals->pdata[0], ==, "InterfacesAdded /objects/old");
+
+  g_dbus_object_manager_server_end_batch (server);
+
+  reply = get_managed_objects (test);
+  g_variant_unref (reply);
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+  g_assert_cmpint (signals->len, ==, 4);
+  g_assert_cmpstr (signals->pdata[1], ==, "InterfacesAdded /objects/number_1");
+  g_assert_cmpstr (signals->pdata[2], ==, "InterfacesRemoved /objects/old");
+  g_assert_cmpstr (signals->pdata[3], ==, "InterfacesAdded /objects/number_3");
+
+  g_dbus_connection_signal_unsubscribe (test->client, id);
+  g_ptr_array_unref (signals);
+  g_object_unref (server);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -360,6 +486,7 @@ main (int   argc,
   g_test_init (&argc, &argv, NULL);
 
   g_test_add ("/gdbus/peer-object-manager", Test, NULL, setup, test_object_manager, teardown);
+  g_test_add ("/gdbus/peer-object-manager/batch", Test, NULL, setup, test_object_manager_batch, teardown);
 
   return g_test_run();
 }
@@ -870,6 +870,101 @@ test_no_properties (void)
   g_object_unref (proxy);
 }
 
+static void
+on_lazy_properties_changed (GDBusProxy *proxy,
+                            GVariant   *changed_properties,
+                            GStrv       invalidated_properties,
+                            gpointer    user_data)
+{
+  gint *count = user_data;
+
+  *count += 1;
+  if (*count == 2)
+    g_main_loop_quit (loop);
+}
+
+static GDBusProxy *
+new_lazy_proxy (GDBusConnection *connection)
+{
+  GDBusProxy *proxy;
+  GError *error = NULL;
+
+  proxy = g_dbus_proxy_new_sync (connection,
+                                 G_DBUS_PROXY_FLAGS_LAZY_LOAD_PROPERTIES,
+                                 NULL,                      /* GDBusInterfaceInfo */
+                                 "com.example.TestService", /* name */
+                                 "/com/example/TestObject", /* object path */
+                                 "com.example.Frob",        /* interface */
+                                 NULL, /* GCancellable */
+                                 &error);
+  g_assert_no_error (error);
+
+  return proxy;
+}
+
+static void
+test_lazy_properties (void)
+{
+  GDBusConnection *connection;
+  GDBusProxy *proxy;
+  GDBusProxy *lazy1;
+  GDBusProxy *lazy2;
+  GVariant *value1;
+  GVariant *value2;
+  GError *error;
+  gint count;
+
+  error = NULL;
+  connection = g_bus_get_sync (G_BUS_TYPE_SESSION,
+                               NULL,
+                               &error);
+  g_assert_no_error (error);
+  proxy = g_dbus_proxy_new_sync (connection,
+                                 G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+                                 NULL,                      /* GDBusInterfaceInfo */
+                                 "com.example.TestService", /* name */
+                                 "/com/example/TestObject", /* object path */
+                                 "com.example.Frob",        /* interface */
+                                 NULL, /* GCancellable */
+                                 &error);
+  g_assert_no_error (error);
+
+  /* this is safe; testserver will exit once the bus goes away */
+  g_assert (g_spawn_command_line_async (g_test_get_filename (G_TEST_BUILT, "gdbus-testserver", NULL), NULL));
+
+  _g_assert_property_notify (proxy, "g-name-owner");
+
+  /* nothing is loaded until asked for */
+  lazy1 = new_lazy_proxy (connection);
+  lazy2 = new_lazy_proxy (connection);
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+  g_assert (g_dbus_proxy_get_cached_property_names (lazy1) == NULL);
+  g_assert (g_dbus_proxy_get_cached_property (lazy2, "y") == NULL);
+
+  count = 0;
+  g_signal_connect (lazy1, "g-properties-changed", G_CALLBACK (on_lazy_properties_changed), &count);
+  g_signal_connect (lazy2, "g-properties-changed", G_CALLBACK (on_lazy_properties_changed), &count);
+  g_main_loop_run (loop);
+  g_assert_cmpint (count, ==, 2);
+
+  value1 = g_dbus_proxy_get_cached_property (lazy1, "y");
+  value2 = g_dbus_proxy_get_cached_property (lazy2, "y");
+  g_assert (value1 != NULL);
+  g_assert (value2 != NULL);
+  g_assert_cmpint (g_variant_get_byte (value1), ==, 1);
+  /* both caches come from the same GetAll() reply */
+  g_assert (g_variant_get_data (value1) == g_variant_get_data (value2));
+  g_variant_unref (value1);
+  g_variant_unref (value2);
+
+  g_object_unref (lazy1);
+  g_object_unref (lazy2);
+  g_object_unref (proxy);
+  kill_test_service (connection);
+  g_object_unref (connection);
+}
+
 static void
 check_error (GObject      *source,
              GAsyncResult *result,
@@ -923,6 +1018,7 @@ main (int   argc,
 
   g_test_add_func ("/gdbus/proxy", test_proxy);
   g_test_add_func ("/gdbus/proxy/no-properties", test_no_properties);
+  g_test_add_func ("/gdbus/proxy/lazy-properties", test_lazy_properties);
   g_test_add_func ("/gdbus/proxy/wellknown-noauto", test_wellknown_noauto);
   g_test_add_func ("/gdbus/proxy/async", test_async);
 
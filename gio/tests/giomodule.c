@@ -0,0 +1,110 @@
+/* GLib testing framework examples and tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#define G_SETTINGS_ENABLE_BACKEND
+#include <gio/gio.h>
+#include <gio/gsettingsbackend.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+static void
+link_module (const gchar *module_dir,
+             const gchar *name)
+{
+  gchar *built, *link;
+
+  /* uninstalled modules live in .libs */
+  built = g_test_build_filename (G_TEST_BUILT, ".libs", name, NULL);
+  if (!g_file_test (built, G_FILE_TEST_EXISTS))
+    {
+      g_free (built);
+      built = g_test_build_filename (G_TEST_BUILT, name, NULL);
+    }
+
+  link = g_build_filename (module_dir, name, NULL);
+  g_assert_cmpint (symlink (built, link), ==, 0);
+
+  g_free (built);
+  g_free (link);
+}
+
+static void
+test_lazy_default (void)
+{
+  GIOExtensionPoint *ep;
+  GSettingsBackend *backend;
+
+  /* the module of the highest priority backend is loaded... */
+  backend = g_settings_backend_get_default ();
+  g_assert_cmpstr (G_OBJECT_TYPE_NAME (backend), ==, "TestBackendA");
+  g_object_unref (backend);
+
+  /* ...but not the one of the backend that wasn't needed */
+  g_assert (g_type_from_name ("TestBackendB") == G_TYPE_INVALID);
+
+  /* until it is asked for */
+  ep = g_io_extension_point_lookup (G_SETTINGS_BACKEND_EXTENSION_POINT_NAME);
+  g_assert (g_io_extension_point_get_extension_by_name (ep, "test-backend-b") != NULL);
+  g_assert (g_type_from_name ("TestBackendB") != G_TYPE_INVALID);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  gchar *module_dir, *cache;
+  gint ret;
+
+  g_test_init (&argc, &argv, NULL);
+
+  module_dir = g_dir_make_tmp ("giomodule-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  link_module (module_dir, "libtestmodulea.so");
+  link_module (module_dir, "libtestmoduleb.so");
+
+  /* As written by gio-querymodules, after the modules were built */
+  cache = g_build_filename (module_dir, "giomodule.cache", NULL);
+  g_file_set_contents (cache,
+                       "libtestmodulea.so: gsettings-backend\n"
+                       "libtestmoduleb.so: gsettings-backend\n"
+                       "#+ libtestmodulea.so: gsettings-backend 1000 test-backend-a\n"
+                       "#+ libtestmoduleb.so: gsettings-backend 900 test-backend-b\n",
+                       -1, &error);
+  g_assert_no_error (error);
+
+  g_setenv ("GIO_EXTRA_MODULES", module_dir, TRUE);
+  g_unsetenv ("GSETTINGS_BACKEND");
+
+  g_test_add_func ("/giomodule/lazy-default", test_lazy_default);
+
+  ret = g_test_run ();
+
+  g_unlink (cache);
+  g_free (cache);
+  cache = g_build_filename (module_dir, "libtestmodulea.so", NULL);
+  g_unlink (cache);
+  g_free (cache);
+  cache = g_build_filename (module_dir, "libtestmoduleb.so", NULL);
+  g_unlink (cache);
+  g_free (cache);
+  g_rmdir (module_dir);
+  g_free (module_dir);
+
+  return ret;
+}
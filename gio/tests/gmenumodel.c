@@ -862,7 +862,8 @@ test_dbus_subscriptions (void)
   g_timeout_add (200, stop_loop, loop);
   g_main_loop_run (loop);
 
-  g_assert_cmpint (items_changed_count, ==, 6);
+  /* The appends and the removals are each sent as one change */
+  g_assert_cmpint (items_changed_count, ==, 3);
 
   g_assert_cmpint (g_menu_model_get_n_items (G_MENU_MODEL (proxy)), ==, 4);
   g_object_unref (proxy);
@@ -876,7 +877,7 @@ test_dbus_subscriptions (void)
   g_timeout_add (100, stop_loop, loop);
   g_main_loop_run (loop);
 
-  g_assert_cmpint (items_changed_count, ==, 6);
+  g_assert_cmpint (items_changed_count, ==, 3);
 
   g_dbus_connection_unexport_menu_model (bus, export_id);
   g_object_unref (menu);
@@ -885,6 +886,69 @@ test_dbus_subscriptions (void)
   g_object_unref (bus);
 }
 
+static void
+test_dbus_batched (void)
+{
+  GDBusConnection *bus;
+  GMenu *menu;
+  GDBusMenuModel *proxy;
+  GMainLoop *loop;
+  guint export_id;
+  gint i;
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+
+  menu = g_menu_new ();
+  g_menu_append (menu, "item1", NULL);
+  g_menu_append (menu, "item2", NULL);
+  g_menu_append (menu, "item3", NULL);
+
+  export_id = g_dbus_connection_export_menu_model (bus, "/", G_MENU_MODEL (menu), NULL);
+  proxy = g_dbus_menu_model_get (bus, g_dbus_connection_get_unique_name (bus), "/");
+  g_menu_model_get_n_items (G_MENU_MODEL (proxy));
+
+  g_timeout_add (100, stop_loop, loop);
+  g_main_loop_run (loop);
+
+  g_assert_cmpint (g_menu_model_get_n_items (G_MENU_MODEL (proxy)), ==, 3);
+
+  items_changed_count = 0;
+  g_signal_connect (proxy, "items-changed",
+                    G_CALLBACK (items_changed), NULL);
+
+  /* Changes within or next to the ones before are merged... */
+  for (i = 0; i < 100; i++)
+    {
+      gchar *label;
+
+      label = g_strdup_printf ("new%d", i);
+      g_menu_append (menu, label, NULL);
+      g_free (label);
+    }
+  g_menu_insert (menu, 3, "inserted", NULL);
+  g_menu_remove (menu, 4);
+  g_menu_remove (menu, 50);
+
+  /* ...others are not */
+  g_menu_remove (menu, 0);
+  g_menu_remove (menu, 0);
+
+  g_timeout_add (100, stop_loop, loop);
+  g_main_loop_run (loop);
+
+  g_assert_cmpint (items_changed_count, ==, 2);
+  assert_menus_equal (G_MENU_MODEL (menu), G_MENU_MODEL (proxy));
+
+  g_object_unref (proxy);
+  g_dbus_connection_unexport_menu_model (bus, export_id);
+  g_object_unref (menu);
+
+  g_main_loop_unref (loop);
+  g_object_unref (bus);
+}
+
 static gpointer
 do_modify (gpointer data)
 {
@@ -1167,6 +1231,7 @@ main (int argc, char **argv)
   g_test_add_func ("/gmenu/random", test_random);
   g_test_add_func ("/gmenu/dbus/roundtrip", test_dbus_roundtrip);
   g_test_add_func ("/gmenu/dbus/subscriptions", test_dbus_subscriptions);
+  g_test_add_func ("/gmenu/dbus/batched", test_dbus_batched);
   g_test_add_func ("/gmenu/dbus/threaded", test_dbus_threaded);
   g_test_add_func ("/gmenu/attributes", test_attributes);
   g_test_add_func ("/gmenu/links", test_links);
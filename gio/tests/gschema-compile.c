@@ -131,6 +131,112 @@ static const SchemaTest tests[] = {
   { "cdata",                        NULL, NULL                                                  }
 };
 
+static void
+compile_schemas (const gchar *dir,
+                 gboolean     incremental)
+{
+  gchar *argv[] = {
+    "../glib-compile-schemas",
+    (gchar *) dir,
+    incremental ? "--incremental" : NULL,
+    NULL
+  };
+  GError *error = NULL;
+  gint status;
+
+  g_spawn_sync (NULL, argv, NULL, 0, NULL, NULL, NULL, NULL, &status, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (status, ==, 0);
+}
+
+static void
+write_schema (const gchar *filename,
+              gint         value)
+{
+  GError *error = NULL;
+  gchar *contents;
+
+  contents = g_strdup_printf ("<schemalist>\n"
+                              "  <schema id='org.gtk.test.incremental'>\n"
+                              "    <key name='test' type='i'>\n"
+                              "      <default>%d</default>\n"
+                              "    </key>\n"
+                              "  </schema>\n"
+                              "</schemalist>\n", value);
+  g_file_set_contents (filename, contents, -1, &error);
+  g_assert_no_error (error);
+  g_free (contents);
+}
+
+static GBytes *
+read_compiled (const gchar *compiled,
+               ino_t       *inode)
+{
+  GError *error = NULL;
+  GStatBuf buf;
+  gchar *contents;
+  gsize size;
+
+  g_assert_cmpint (g_stat (compiled, &buf), ==, 0);
+  *inode = buf.st_ino;
+
+  g_file_get_contents (compiled, &contents, &size, &error);
+  g_assert_no_error (error);
+
+  return g_bytes_new_take (contents, size);
+}
+
+static void
+test_incremental (void)
+{
+  GError *error = NULL;
+  GBytes *first, *second;
+  gchar *dir, *schema, *compiled;
+  ino_t inode, inode2;
+
+  dir = g_dir_make_tmp ("gschema-compile-XXXXXX", &error);
+  g_assert_no_error (error);
+  schema = g_build_filename (dir, "org.gtk.test.incremental.gschema.xml", NULL);
+  compiled = g_build_filename (dir, "gschemas.compiled", NULL);
+
+  /* Without --incremental, the output only depends on the schemas */
+  write_schema (schema, 1);
+  compile_schemas (dir, FALSE);
+  first = read_compiled (compiled, &inode);
+  g_usleep (10000);
+  write_schema (schema, 1);
+  compile_schemas (dir, FALSE);
+  second = read_compiled (compiled, &inode);
+  g_assert (g_bytes_equal (first, second));
+  g_bytes_unref (first);
+  g_bytes_unref (second);
+
+  /* With it, the output isn't written again if nothing changed... */
+  compile_schemas (dir, TRUE);
+  first = read_compiled (compiled, &inode);
+  compile_schemas (dir, TRUE);
+  second = read_compiled (compiled, &inode2);
+  g_assert (inode == inode2);
+  g_assert (g_bytes_equal (first, second));
+  g_bytes_unref (second);
+
+  /* ...but it is as soon as a schema changes, even without changing
+   * its size, and right away
+   */
+  write_schema (schema, 2);
+  compile_schemas (dir, TRUE);
+  second = read_compiled (compiled, &inode2);
+  g_assert (!g_bytes_equal (first, second));
+  g_bytes_unref (first);
+  g_bytes_unref (second);
+
+  g_unlink (compiled);
+  g_unlink (schema);
+  g_rmdir (dir);
+  g_free (compiled);
+  g_free (schema);
+  g_free (dir);
+}
 
 int
 main (int argc, char *argv[])
@@ -154,5 +260,7 @@ main (int argc, char *argv[])
       g_free (name);
     }
 
+  g_test_add_func ("/gschema/incremental", test_incremental);
+
   return g_test_run ();
 }
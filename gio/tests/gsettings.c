@@ -402,6 +402,72 @@ test_changes (void)
   g_object_unref (settings);
 }
 
+static gint greeting_changes;
+
+static void
+count_greeting_cb (GSettings   *settings,
+                   const gchar *key,
+                   gpointer     data)
+{
+  if (g_str_equal (key, "greeting"))
+    greeting_changes++;
+}
+
+static gpointer
+write_greetings (gpointer data)
+{
+  GSettings *settings;
+  gint i;
+
+  settings = g_settings_new ("org.gtk.test");
+
+  for (i = 0; i < 100; i++)
+    {
+      gchar *greeting = g_strdup_printf ("greeting %d", i);
+      g_settings_set (settings, "greeting", "s", greeting);
+      g_free (greeting);
+    }
+
+  g_object_unref (settings);
+
+  return NULL;
+}
+
+/* Test that changes made in another thread are delivered in one batch,
+ * with repeated changes of the same key merged.
+ */
+static void
+test_batched_changes (void)
+{
+  GSettings *settings;
+  GThread *thread;
+  gchar *str;
+
+  settings = g_settings_new ("org.gtk.test");
+  g_signal_connect (settings, "changed",
+                    G_CALLBACK (count_greeting_cb), NULL);
+  greeting_changes = 0;
+
+  /* make sure the notifications can't be dispatched by the writer */
+  g_assert (g_main_context_acquire (NULL));
+
+  thread = g_thread_new ("writer", write_greetings, NULL);
+  g_thread_join (thread);
+  g_assert_cmpint (greeting_changes, ==, 0);
+
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (greeting_changes, ==, 1);
+
+  g_main_context_release (NULL);
+
+  g_settings_get (settings, "greeting", "s", &str);
+  g_assert_cmpstr (str, ==, "greeting 99");
+  g_free (str);
+
+  g_settings_reset (settings, "greeting");
+  g_object_unref (settings);
+}
+
 static gboolean changed_cb_called2;
 
 static void
@@ -2226,6 +2292,67 @@ test_schema_source (void)
   g_settings_schema_source_unref (source);
 }
 
+static void
+test_schema_sharing (void)
+{
+  GSettingsSchemaSource *source;
+  GSettingsSchema *schema1, *schema2;
+  GSettingsSchemaKey *key1, *key2;
+  GVariant *value1, *value2;
+  GSettings *settings;
+  gchar **non_relocatable;
+  gchar **relocatable;
+
+  source = g_settings_schema_source_get_default ();
+
+  /* lookups of a schema that is in use give the same object... */
+  schema1 = g_settings_schema_source_lookup (source, "org.gtk.test", TRUE);
+  schema2 = g_settings_schema_source_lookup (source, "org.gtk.test", TRUE);
+  g_assert (schema1 == schema2);
+  g_settings_schema_unref (schema2);
+
+  settings = g_settings_new ("org.gtk.test");
+  g_object_get (settings, "settings-schema", &schema2, NULL);
+  g_assert (schema1 == schema2);
+  g_settings_schema_unref (schema2);
+  g_object_unref (settings);
+
+  /* ...and the parsed keys are shared too */
+  key1 = g_settings_schema_get_key (schema1, "greeting");
+  key2 = g_settings_schema_get_key (schema1, "greeting");
+  g_assert (key1 != key2);
+  value1 = g_settings_schema_key_get_default_value (key1);
+  value2 = g_settings_schema_key_get_default_value (key2);
+  g_assert (g_variant_equal (value1, value2));
+  g_assert_cmpstr (g_variant_get_string (value1, NULL), ==, "Hello, earthlings");
+  g_variant_unref (value1);
+  g_variant_unref (value2);
+  g_settings_schema_key_unref (key1);
+  g_settings_schema_key_unref (key2);
+
+  key1 = g_settings_schema_get_key (schema1, "greeting");
+  g_settings_schema_unref (schema1);
+
+  /* the key keeps the schema alive */
+  schema2 = g_settings_schema_source_lookup (source, "org.gtk.test", TRUE);
+  g_assert (schema1 == schema2);
+  g_settings_schema_unref (schema2);
+  g_settings_schema_key_unref (key1);
+
+  /* listing twice gives the same results */
+  g_settings_schema_source_list_schemas (source, TRUE, &non_relocatable, &relocatable);
+  g_assert (strv_has_string (non_relocatable, "org.gtk.test"));
+  g_assert (strv_has_string (relocatable, "org.gtk.test.no-path"));
+  g_strfreev (non_relocatable);
+  g_strfreev (relocatable);
+
+  g_settings_schema_source_list_schemas (source, FALSE, &non_relocatable, &relocatable);
+  g_assert (strv_has_string (non_relocatable, "org.gtk.test"));
+  g_assert (strv_has_string (relocatable, "org.gtk.test.no-path"));
+  g_strfreev (non_relocatable);
+  g_strfreev (relocatable);
+}
+
 static void
 test_actions (void)
 {
@@ -2445,6 +2572,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/gsettings/basic-types", test_basic_types);
   g_test_add_func ("/gsettings/complex-types", test_complex_types);
   g_test_add_func ("/gsettings/changes", test_changes);
+  g_test_add_func ("/gsettings/batched-changes", test_batched_changes);
 
   g_test_add_func ("/gsettings/l10n", test_l10n);
   g_test_add_func ("/gsettings/l10n-context", test_l10n_context);
@@ -2493,6 +2621,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/gsettings/mapped", test_get_mapped);
   g_test_add_func ("/gsettings/get-range", test_get_range);
   g_test_add_func ("/gsettings/schema-source", test_schema_source);
+  g_test_add_func ("/gsettings/schema-sharing", test_schema_sharing);
   g_test_add_func ("/gsettings/actions", test_actions);
   g_test_add_func ("/gsettings/null-backend", test_null_backend);
   g_test_add_func ("/gsettings/memory-backend", test_memory_backend);
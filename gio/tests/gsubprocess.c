@@ -628,6 +628,105 @@ test_communicate (void)
   g_object_unref (proc);
 }
 
+static void
+test_communicate_streams (void)
+{
+  GError *error = NULL;
+  GPtrArray *args;
+  GSubprocess *proc;
+  GFile *in_file, *out_file;
+  GFileIOStream *iostream;
+  GFileInputStream *in_stream;
+  GFileOutputStream *out_stream;
+  GBytesList *chunks = NULL;
+  GBytes *input, *output;
+  GString *data;
+  gchar *contents;
+  gsize len;
+  guint i;
+  gboolean ret;
+
+  data = g_string_new (NULL);
+  for (i = 0; g_string_append_printf (data, "line %u\n", i), data->len < 1024 * 1024; i++)
+    ;
+  input = g_string_free_to_bytes (data);
+
+  in_file = g_file_new_tmp ("gsubprocess-in-XXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  ret = g_file_replace_contents (in_file, g_bytes_get_data (input, NULL), g_bytes_get_size (input),
+                                 NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+
+  /* From a file, with stdout collected in chunks */
+  args = get_test_subprocess_args ("cat", NULL);
+  proc = g_subprocess_newv ((const gchar* const*)args->pdata,
+                            G_SUBPROCESS_FLAGS_STDIN_PIPE | G_SUBPROCESS_FLAGS_STDOUT_PIPE,
+                            &error);
+  g_assert_no_error (error);
+
+  in_stream = g_file_read (in_file, NULL, &error);
+  g_assert_no_error (error);
+
+  ret = g_subprocess_communicate_streams (proc, (GInputStream*)in_stream, NULL, NULL,
+                                          &chunks, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_assert (!g_input_stream_is_closed ((GInputStream*)in_stream));
+  g_assert_cmpuint (g_bytes_list_get_n_bytes (chunks), >, 1);
+
+  output = g_bytes_list_flatten (chunks);
+  g_assert (g_bytes_equal (input, output));
+  g_bytes_unref (output);
+  g_bytes_list_free (chunks);
+  g_object_unref (in_stream);
+  g_object_unref (proc);
+
+  /* From a file to a file */
+  proc = g_subprocess_newv ((const gchar* const*)args->pdata,
+                            G_SUBPROCESS_FLAGS_STDIN_PIPE | G_SUBPROCESS_FLAGS_STDOUT_PIPE,
+                            &error);
+  g_assert_no_error (error);
+
+  in_stream = g_file_read (in_file, NULL, &error);
+  g_assert_no_error (error);
+  out_file = g_file_new_tmp ("gsubprocess-out-XXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  out_stream = g_file_replace (out_file, NULL, FALSE, 0, NULL, &error);
+  g_assert_no_error (error);
+
+  chunks = (GBytesList *) 0x1;
+  ret = g_subprocess_communicate_streams (proc, (GInputStream*)in_stream, (GOutputStream*)out_stream,
+                                          NULL, &chunks, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_assert (chunks == NULL);
+
+  ret = g_output_stream_close ((GOutputStream*)out_stream, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+
+  ret = g_file_load_contents (out_file, NULL, &contents, &len, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_assert_cmpuint (len, ==, g_bytes_get_size (input));
+  g_assert (memcmp (contents, g_bytes_get_data (input, NULL), len) == 0);
+  g_free (contents);
+
+  g_object_unref (in_stream);
+  g_object_unref (out_stream);
+  g_object_unref (proc);
+  g_ptr_array_free (args, TRUE);
+
+  g_file_delete (in_file, NULL, NULL);
+  g_file_delete (out_file, NULL, NULL);
+  g_object_unref (in_file);
+  g_object_unref (out_file);
+  g_bytes_unref (input);
+}
+
 static void
 test_communicate_utf8 (void)
 {
@@ -992,6 +1091,7 @@ main (int argc, char **argv)
   g_test_add_func ("/gsubprocess/cat-eof", test_cat_eof);
   g_test_add_func ("/gsubprocess/multi1", test_multi_1);
   g_test_add_func ("/gsubprocess/communicate", test_communicate);
+  g_test_add_func ("/gsubprocess/communicate-streams", test_communicate_streams);
   g_test_add_func ("/gsubprocess/communicate-utf8", test_communicate_utf8);
   g_test_add_func ("/gsubprocess/communicate-utf8-invalid", test_communicate_utf8_invalid);
   g_test_add_func ("/gsubprocess/terminate", test_terminate);
@@ -285,6 +285,62 @@ test_from_bytes (void)
   g_bytes_unref (bytes);
 }
 
+static void
+readv_cb (GObject      *source,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  gsize *nread = user_data;
+  GError *error = NULL;
+
+  g_assert (g_input_stream_readv_finish (G_INPUT_STREAM (source), result,
+                                         nread, &error));
+  g_assert_no_error (error);
+}
+
+static void
+test_readv (void)
+{
+  const char *data = "abcdefghijklmnopqrstuvwxyz";
+  GInputStream *stream;
+  GInputVector vectors[3];
+  GError *error = NULL;
+  char buffer1[10], buffer2[20];
+  gsize nread;
+
+  stream = g_memory_input_stream_new_from_data (data, -1, NULL);
+
+  vectors[0].buffer = buffer1;
+  vectors[0].size = sizeof buffer1;
+  vectors[1].buffer = NULL;
+  vectors[1].size = 0;
+  vectors[2].buffer = buffer2;
+  vectors[2].size = sizeof buffer2;
+
+  g_assert (g_input_stream_readv (stream, vectors, 3, &nread, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (nread, ==, 26);
+  g_assert (memcmp (buffer1, data, 10) == 0);
+  g_assert (memcmp (buffer2, data + 10, 16) == 0);
+
+  g_seekable_seek (G_SEEKABLE (stream), 20, G_SEEK_SET, NULL, &error);
+  g_assert_no_error (error);
+
+  nread = 0;
+  g_input_stream_readv_async (stream, vectors, 3, G_PRIORITY_DEFAULT, NULL,
+                              readv_cb, &nread);
+  while (nread == 0)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (nread, ==, 6);
+  g_assert (memcmp (buffer1, data + 20, 6) == 0);
+
+  g_assert (g_input_stream_readv (stream, vectors, 3, &nread, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (nread, ==, 0);
+
+  g_object_unref (stream);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -297,6 +353,7 @@ main (int   argc,
   g_test_add_func ("/memory-input-stream/truncate", test_truncate);
   g_test_add_func ("/memory-input-stream/read-bytes", test_read_bytes);
   g_test_add_func ("/memory-input-stream/from-bytes", test_from_bytes);
+  g_test_add_func ("/memory-input-stream/readv", test_readv);
 
   return g_test_run();
 }
@@ -312,6 +312,132 @@ test_steal_as_bytes (void)
   g_object_unref (o);
 }
 
+static void
+writev_cb (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  gboolean *done = user_data;
+  GError *error = NULL;
+  gsize written;
+
+  g_assert (g_output_stream_writev_finish (G_OUTPUT_STREAM (source), result,
+                                           &written, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (written, ==, strlen ("hello world!"));
+  *done = TRUE;
+}
+
+static void
+test_writev (void)
+{
+  GOutputStream *mo;
+  GOutputVector vectors[3];
+  GError *error = NULL;
+  gboolean done = FALSE;
+  gsize written;
+
+  vectors[0].buffer = "hello";
+  vectors[0].size = 5;
+  vectors[1].buffer = NULL;
+  vectors[1].size = 0;
+  vectors[2].buffer = " world!";
+  vectors[2].size = 7;
+
+  mo = g_memory_output_stream_new_resizable ();
+
+  g_assert (g_output_stream_writev (mo, vectors, 3, &written, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (written, ==, 12);
+
+  g_output_stream_writev_async (mo, vectors, 3, G_PRIORITY_DEFAULT, NULL,
+                                writev_cb, &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert (g_output_stream_writev (mo, vectors, 0, &written, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (written, ==, 0);
+
+  g_output_stream_close (mo, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (mo)), ==, 24);
+  g_assert (memcmp (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (mo)),
+                    "hello world!hello world!", 24) == 0);
+
+  g_object_unref (mo);
+}
+
+static void
+test_chunked (void)
+{
+  GOutputStream *mo;
+  GPtrArray *chunks;
+  GError *error = NULL;
+  GBytes *bytes;
+  gsize i, size;
+  gchar *data;
+  gsize written;
+
+  mo = g_memory_output_stream_new_chunked (8);
+
+  g_output_stream_write_all (mo, "abcdefghijklm", 13, &written, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (written, ==, 13);
+  g_assert_cmpuint (g_memory_output_stream_get_size (G_MEMORY_OUTPUT_STREAM (mo)), ==, 16);
+
+  /* overwrite across a chunk boundary */
+  g_seekable_seek (G_SEEKABLE (mo), 6, G_SEEK_SET, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_write_all (mo, "GHIJ", 4, &written, NULL, &error);
+  g_assert_no_error (error);
+
+  /* seeking past the end leaves a zero-filled gap */
+  g_seekable_seek (G_SEEKABLE (mo), 18, G_SEEK_SET, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_write_all (mo, "xyz", 3, &written, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (mo)), ==, 21);
+
+  g_output_stream_close (mo, NULL, &error);
+  g_assert_no_error (error);
+
+  chunks = g_memory_output_stream_steal_chunks (G_MEMORY_OUTPUT_STREAM (mo));
+  g_assert_cmpuint (chunks->len, ==, 3);
+  data = g_malloc (21);
+  for (i = 0, size = 0; i < chunks->len; i++)
+    {
+      bytes = chunks->pdata[i];
+      g_assert_cmpuint (g_bytes_get_size (bytes), ==, i < 2 ? 8 : 5);
+      memcpy (data + size, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+      size += g_bytes_get_size (bytes);
+    }
+  g_assert_cmpuint (size, ==, 21);
+  g_assert (memcmp (data, "abcdefGHIJklm\0\0\0\0\0xyz", 21) == 0);
+  g_free (data);
+  g_ptr_array_unref (chunks);
+  g_object_unref (mo);
+
+  /* the data can still be had in one piece */
+  mo = g_memory_output_stream_new_chunked (4);
+  g_output_stream_write_all (mo, "hello world", 11, &written, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (memcmp (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (mo)),
+                    "hello world", 11) == 0);
+  g_output_stream_write_all (mo, "!", 1, &written, NULL, &error);
+  g_assert_no_error (error);
+  g_output_stream_close (mo, NULL, &error);
+  g_assert_no_error (error);
+
+  chunks = g_memory_output_stream_steal_chunks (G_MEMORY_OUTPUT_STREAM (mo));
+  g_assert_cmpuint (chunks->len, ==, 1);
+  bytes = chunks->pdata[0];
+  g_assert_cmpuint (g_bytes_get_size (bytes), ==, 12);
+  g_assert (memcmp (g_bytes_get_data (bytes, NULL), "hello world!", 12) == 0);
+  g_ptr_array_unref (chunks);
+  g_object_unref (mo);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -326,6 +452,8 @@ main (int   argc,
   g_test_add_func ("/memory-output-stream/properties", test_properties);
   g_test_add_func ("/memory-output-stream/write-bytes", test_write_bytes);
   g_test_add_func ("/memory-output-stream/steal_as_bytes", test_steal_as_bytes);
+  g_test_add_func ("/memory-output-stream/writev", test_writev);
+  g_test_add_func ("/memory-output-stream/chunked", test_chunked);
 
   return g_test_run();
 }
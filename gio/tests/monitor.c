@@ -1,3 +1,5 @@
+#include <string.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 
 typedef struct {
@@ -173,12 +175,105 @@ test_directory_monitor (void)
   g_free (path);
 }
 
+typedef struct {
+  GFile *expected;
+  gboolean seen;
+  GMainLoop *loop;
+} RecursiveData;
+
+static void
+recursive_changed_cb (GFileMonitor      *monitor,
+                      GFile             *file,
+                      GFile             *other_file,
+                      GFileMonitorEvent  event,
+                      gpointer           user_data)
+{
+  RecursiveData *d = user_data;
+
+  if (event == G_FILE_MONITOR_EVENT_CREATED && g_file_equal (file, d->expected))
+    {
+      d->seen = TRUE;
+      g_main_loop_quit (d->loop);
+    }
+}
+
+static gboolean
+recursive_timeout_cb (gpointer user_data)
+{
+  RecursiveData *d = user_data;
+
+  g_main_loop_quit (d->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_recursive_monitor (void)
+{
+  gchar *path, *deep, *target;
+  GFile *file;
+  GFileMonitor *monitor;
+  GError *error = NULL;
+  RecursiveData data;
+  guint id;
+
+  path = g_mkdtemp (g_strdup ("file_monitor_XXXXXX"));
+  deep = g_build_filename (path, "a", "b", "c", NULL);
+  g_assert_cmpint (g_mkdir_with_parents (deep, 0700), ==, 0);
+
+  file = g_file_new_for_path (path);
+  monitor = g_file_monitor_directory (file, G_FILE_MONITOR_RECURSIVE, NULL, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+    {
+      g_test_skip ("recursive monitoring not supported");
+      g_clear_error (&error);
+      goto out;
+    }
+  g_assert_no_error (error);
+
+  data.loop = g_main_loop_new (NULL, FALSE);
+  data.seen = FALSE;
+  target = g_build_filename (deep, "test-file", NULL);
+  data.expected = g_file_new_for_path (target);
+  g_free (target);
+  g_signal_connect (monitor, "changed", G_CALLBACK (recursive_changed_cb), &data);
+
+  /* The file is three levels down, in directories that existed before
+   * the monitor was created.
+   */
+  g_file_replace_contents (data.expected, "x", 1, NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  id = g_timeout_add_seconds (10, recursive_timeout_cb, &data);
+  g_main_loop_run (data.loop);
+
+  g_assert (data.seen);
+  g_source_remove (id);
+
+  g_file_delete (data.expected, NULL, NULL);
+  g_object_unref (data.expected);
+  g_main_loop_unref (data.loop);
+  g_object_unref (monitor);
+
+ out:
+  while (strlen (deep) > strlen (path))
+    {
+      g_rmdir (deep);
+      *strrchr (deep, '/') = '\0';
+    }
+  g_rmdir (path);
+  g_object_unref (file);
+  g_free (deep);
+  g_free (path);
+}
+
 int
 main (int argc, char *argv[])
 {
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/monitor/directory", test_directory_monitor);
+  g_test_add_func ("/monitor/recursive", test_recursive_monitor);
 
   return g_test_run ();
 }
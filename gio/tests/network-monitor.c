@@ -456,6 +456,47 @@ test_remove_networks (void)
 }
 
 
+static void
+test_set_networks (void)
+{
+  GNetworkMonitor *monitor;
+  GInetAddressMask *networks[3];
+  GError *error = NULL;
+
+  monitor = g_initable_new (G_TYPE_NETWORK_MONITOR_BASE, NULL, &error, NULL);
+  g_assert_no_error (error);
+  assert_signals (monitor, FALSE, FALSE, TRUE);
+
+  /* Setting the same list (in a different order) changes nothing */
+  networks[0] = ip6_default;
+  networks[1] = ip4_default;
+  g_network_monitor_base_set_networks (G_NETWORK_MONITOR_BASE (monitor),
+                                       networks, 2);
+  assert_signals (monitor, FALSE, FALSE, TRUE);
+
+  /* A burst of changes is reported once */
+  networks[0] = net127.mask;
+  networks[1] = net10.mask;
+  networks[2] = ip6_default;
+  g_network_monitor_base_set_networks (G_NETWORK_MONITOR_BASE (monitor),
+                                       networks, 3);
+  assert_signals (monitor, FALSE, TRUE, TRUE);
+  run_tests (monitor, net127.addresses, TRUE);
+  run_tests (monitor, net10.addresses, TRUE);
+  run_tests (monitor, unmatched, FALSE);
+
+  g_network_monitor_base_set_networks (G_NETWORK_MONITOR_BASE (monitor),
+                                       networks, 3);
+  assert_signals (monitor, FALSE, FALSE, TRUE);
+
+  g_network_monitor_base_set_networks (G_NETWORK_MONITOR_BASE (monitor),
+                                       networks, 2);
+  assert_signals (monitor, TRUE, TRUE, FALSE);
+
+  g_object_unref (monitor);
+}
+
+
 static void
 init_test (TestMask *test)
 {
@@ -534,6 +575,7 @@ main (int argc, char **argv)
   g_test_add_func ("/network-monitor/remove_default", test_remove_default);
   g_test_add_func ("/network-monitor/add_networks", test_add_networks);
   g_test_add_func ("/network-monitor/remove_networks", test_remove_networks);
+  g_test_add_func ("/network-monitor/set_networks", test_set_networks);
 
   ret = g_test_run ();
 
@@ -815,6 +815,9 @@ teardown_test (gpointer fixture,
     }
   g_clear_error (&proxy_a.last_error);
   g_clear_error (&proxy_b.last_error);
+
+  /* so that each test sees the resolver being called */
+  g_proxy_resolver_invalidate_cache (g_proxy_resolver_get_default ());
 }
 
 
@@ -1316,6 +1319,52 @@ test_proxy_enumerator_ports (void)
   teardown_test (NULL, NULL);
 }
 
+static void
+cache_lookup_cb (GObject      *source,
+		 GAsyncResult *result,
+		 gpointer      user_data)
+{
+  gchar ***proxies = user_data;
+  GError *error = NULL;
+
+  *proxies = g_proxy_resolver_lookup_finish (G_PROXY_RESOLVER (source), result, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_cache (gpointer fixture,
+	    gconstpointer user_data)
+{
+  GProxyResolver *resolver = g_proxy_resolver_get_default ();
+  gchar **proxies, **cached = NULL;
+  GError *error = NULL;
+
+  proxies = g_proxy_resolver_lookup (resolver, "beta://example.com:80/a", NULL, &error);
+  g_assert_no_error (error);
+  g_assert (last_proxies != NULL);
+  g_strfreev (last_proxies);
+  last_proxies = NULL;
+
+  /* the same scheme, host and port is answered without the resolver */
+  g_proxy_resolver_lookup_async (resolver, "beta://EXAMPLE.com:80/b", NULL,
+				 cache_lookup_cb, &cached);
+  while (cached == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert (last_proxies == NULL);
+  g_assert_cmpint (g_strv_length (cached), ==, g_strv_length (proxies));
+  g_assert_cmpstr (cached[0], ==, proxies[0]);
+  g_strfreev (cached);
+
+  /* but not after the cache has been invalidated */
+  g_proxy_resolver_invalidate_cache (resolver);
+  cached = g_proxy_resolver_lookup (resolver, "beta://example.com:80/a", NULL, &error);
+  g_assert_no_error (error);
+  g_assert (last_proxies != NULL);
+  g_strfreev (cached);
+
+  g_strfreev (proxies);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -1356,6 +1405,7 @@ main (int   argc,
   g_test_add_vtable ("/proxy/multiple_async", 0, NULL, setup_test, test_multiple_async, teardown_test);
   g_test_add_vtable ("/proxy/dns", 0, NULL, setup_test, test_dns, teardown_test);
   g_test_add_vtable ("/proxy/override", 0, NULL, setup_test, test_override, teardown_test);
+  g_test_add_vtable ("/proxy/cache", 0, NULL, setup_test, test_cache, teardown_test);
   g_test_add_func ("/proxy/enumerator-ports", test_proxy_enumerator_ports);
 
   result = g_test_run();
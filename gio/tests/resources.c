@@ -30,7 +30,7 @@ test_resource (GResource *resource)
   gboolean found, success;
   gsize size;
   guint32 flags;
-  GBytes *data;
+  GBytes *data, *data2;
   char **children;
   GInputStream *in;
   char buffer[128];
@@ -76,6 +76,15 @@ test_resource (GResource *resource)
 				 &error);
   g_assert_cmpstr (g_bytes_get_data (data, NULL), ==, "test1\n");
   g_assert_no_error (error);
+
+  /* compressed data is only decompressed once */
+  data2 = g_resource_lookup_data (resource,
+				  "/test1.txt",
+				  G_RESOURCE_LOOKUP_FLAGS_NONE,
+				  &error);
+  g_assert_no_error (error);
+  g_assert (data2 == data);
+  g_bytes_unref (data2);
   g_bytes_unref (data);
 
   in = g_resource_open_stream (resource,
@@ -304,6 +313,65 @@ test_resource_registered (void)
   g_clear_error (&error);
 }
 
+static void
+test_resource_registered_order (void)
+{
+  GResource *resource1, *resource2;
+  GError *error = NULL;
+  GBytes *data, *data1, *data2;
+  gboolean found;
+
+  resource1 = g_resource_load (g_test_get_filename (G_TEST_BUILT, "test.gresource", NULL), &error);
+  g_assert_no_error (error);
+  resource2 = g_resource_load (g_test_get_filename (G_TEST_BUILT, "test.gresource", NULL), &error);
+  g_assert_no_error (error);
+
+  /* Uncompressed data points into the resource it came from */
+  data1 = g_resource_lookup_data (resource1, "/a_prefix/test2.txt", 0, &error);
+  g_assert_no_error (error);
+  data2 = g_resource_lookup_data (resource2, "/a_prefix/test2.txt", 0, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_get_data (data1, NULL) != g_bytes_get_data (data2, NULL));
+
+  g_resources_register (resource1);
+  g_resources_register (resource2);
+
+  /* The most recently registered resource wins */
+  data = g_resources_lookup_data ("/a_prefix/test2.txt", 0, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_get_data (data, NULL) == g_bytes_get_data (data2, NULL));
+  g_bytes_unref (data);
+
+  /* Resources with other roots are still found */
+  found = g_resources_get_info ("/auto_loaded/test1.txt", 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (found);
+
+  found = g_resources_get_info ("/auto_loaded/not-there.txt", 0, NULL, NULL, &error);
+  g_assert_error (error, G_RESOURCE_ERROR, G_RESOURCE_ERROR_NOT_FOUND);
+  g_assert (!found);
+  g_clear_error (&error);
+
+  g_resources_unregister (resource2);
+
+  data = g_resources_lookup_data ("/a_prefix/test2.txt", 0, &error);
+  g_assert_no_error (error);
+  g_assert (g_bytes_get_data (data, NULL) == g_bytes_get_data (data1, NULL));
+  g_bytes_unref (data);
+
+  g_resources_unregister (resource1);
+
+  data = g_resources_lookup_data ("/a_prefix/test2.txt", 0, &error);
+  g_assert_error (error, G_RESOURCE_ERROR, G_RESOURCE_ERROR_NOT_FOUND);
+  g_assert (data == NULL);
+  g_clear_error (&error);
+
+  g_bytes_unref (data1);
+  g_bytes_unref (data2);
+  g_resource_unref (resource1);
+  g_resource_unref (resource2);
+}
+
 static void
 test_resource_automatic (void)
 {
@@ -631,6 +699,7 @@ main (int   argc,
   g_test_add_func ("/resource/file", test_resource_file);
   g_test_add_func ("/resource/data", test_resource_data);
   g_test_add_func ("/resource/registered", test_resource_registered);
+  g_test_add_func ("/resource/registered-order", test_resource_registered_order);
   g_test_add_func ("/resource/manual", test_resource_manual);
   g_test_add_func ("/resource/manual2", test_resource_manual2);
 #ifdef G_HAS_CONSTRUCTORS
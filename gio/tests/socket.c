@@ -640,6 +640,187 @@ test_timed_wait (void)
   g_slice_free (IPTestData, data);
 }
 
+static gpointer
+cancel_thread (gpointer cancellable)
+{
+  g_usleep (G_USEC_PER_SEC / 100);
+  g_cancellable_cancel (cancellable);
+
+  return NULL;
+}
+
+static gboolean
+cancelled_source_cb (GSocket      *socket,
+                     GIOCondition  condition,
+                     gpointer      user_data)
+{
+  GMainLoop *loop = user_data;
+
+  g_main_loop_quit (loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_cancelled_wait (void)
+{
+  GSocket *socket;
+  GCancellable *cancellable;
+  GMainLoop *loop;
+  GSource *source;
+  GThread *thread;
+  GError *error = NULL;
+  int round;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4,
+                         G_SOCKET_TYPE_DATAGRAM,
+                         G_SOCKET_PROTOCOL_DEFAULT,
+                         &error);
+  g_assert_no_error (error);
+
+  cancellable = g_cancellable_new ();
+
+  /* a blocking wait is woken up from another thread, also when the
+   * thread has waited for a cancellable before
+   */
+  for (round = 0; round < 2; round++)
+    {
+      thread = g_thread_new ("cancel", cancel_thread, cancellable);
+      g_assert (!g_socket_condition_wait (socket, G_IO_IN, cancellable, &error));
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+      g_clear_error (&error);
+      g_thread_join (thread);
+
+      g_cancellable_reset (cancellable);
+      g_assert (!g_socket_condition_timed_wait (socket, G_IO_IN, 10000,
+                                                cancellable, &error));
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+      g_clear_error (&error);
+    }
+
+  /* and so is a socket source */
+  loop = g_main_loop_new (NULL, FALSE);
+  source = g_socket_create_source (socket, G_IO_IN, cancellable);
+  g_source_set_callback (source, (GSourceFunc) cancelled_source_cb, loop, NULL);
+  g_source_attach (source, NULL);
+  g_source_unref (source);
+
+  thread = g_thread_new ("cancel", cancel_thread, cancellable);
+  g_main_loop_run (loop);
+  g_assert (g_cancellable_is_cancelled (cancellable));
+  g_thread_join (thread);
+
+  g_main_loop_unref (loop);
+  g_object_unref (cancellable);
+  g_object_unref (socket);
+}
+
+#define N_MESSAGES 100
+
+static void
+test_send_receive_messages (void)
+{
+  GSocket *server, *client;
+  GInetAddress *iaddr;
+  GSocketAddress *addr, *server_addr;
+  GOutputMessage out_messages[N_MESSAGES];
+  GOutputVector out_vectors[N_MESSAGES][2];
+  GInputMessage in_messages[N_MESSAGES];
+  GInputVector in_vectors[N_MESSAGES];
+  GSocketAddress *in_addresses[N_MESSAGES];
+  gchar in_buffers[N_MESSAGES][16];
+  gchar out_buffers[N_MESSAGES][16];
+  GError *error = NULL;
+  gint n, received;
+  gint i;
+
+  server = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+                         G_SOCKET_PROTOCOL_DEFAULT, &error);
+  g_assert_no_error (error);
+  client = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+                         G_SOCKET_PROTOCOL_DEFAULT, &error);
+  g_assert_no_error (error);
+
+  iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (iaddr, 0);
+  g_object_unref (iaddr);
+  g_socket_bind (server, addr, TRUE, &error);
+  g_assert_no_error (error);
+  g_object_unref (addr);
+  server_addr = g_socket_get_local_address (server, &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i < N_MESSAGES; i++)
+    {
+      g_snprintf (out_buffers[i], sizeof out_buffers[i], "message %d", i);
+      out_vectors[i][0].buffer = "head ";
+      out_vectors[i][0].size = 5;
+      out_vectors[i][1].buffer = out_buffers[i];
+      out_vectors[i][1].size = strlen (out_buffers[i]);
+
+      out_messages[i].address = server_addr;
+      out_messages[i].vectors = out_vectors[i];
+      out_messages[i].num_vectors = 2;
+      out_messages[i].bytes_sent = 0;
+      out_messages[i].control_messages = NULL;
+      out_messages[i].num_control_messages = 0;
+
+      in_vectors[i].buffer = in_buffers[i];
+      in_vectors[i].size = sizeof in_buffers[i] - 1;
+
+      in_messages[i].address = &in_addresses[i];
+      in_messages[i].vectors = &in_vectors[i];
+      in_messages[i].num_vectors = 1;
+      in_messages[i].bytes_received = 0;
+      in_messages[i].flags = 0;
+      in_messages[i].control_messages = NULL;
+      in_messages[i].num_control_messages = NULL;
+    }
+
+  /* nothing to receive yet */
+  g_socket_set_blocking (server, FALSE);
+  n = g_socket_receive_messages (server, in_messages, N_MESSAGES, 0, NULL, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+  g_assert_cmpint (n, ==, -1);
+  g_clear_error (&error);
+
+  n = g_socket_send_messages (client, out_messages, N_MESSAGES, 0, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, N_MESSAGES);
+  for (i = 0; i < N_MESSAGES; i++)
+    g_assert_cmpuint (out_messages[i].bytes_sent, ==, 5 + strlen (out_buffers[i]));
+
+  /* all of them are there, the blocking call takes them at once */
+  g_socket_set_blocking (server, TRUE);
+  received = 0;
+  while (received < N_MESSAGES)
+    {
+      n = g_socket_receive_messages (server, in_messages + received,
+                                     N_MESSAGES - received, 0, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpint (n, >, 0);
+      received += n;
+    }
+  g_assert_cmpint (received, ==, N_MESSAGES);
+
+  for (i = 0; i < N_MESSAGES; i++)
+    {
+      gchar *expected = g_strdup_printf ("head %s", out_buffers[i]);
+
+      /* the message is truncated to the buffer */
+      g_assert_cmpuint (in_messages[i].bytes_received, ==, MIN (strlen (expected), sizeof in_buffers[i] - 1));
+      in_buffers[i][in_messages[i].bytes_received] = '\0';
+      g_assert (g_str_has_prefix (expected, in_buffers[i]));
+      g_assert (G_IS_INET_SOCKET_ADDRESS (in_addresses[i]));
+      g_object_unref (in_addresses[i]);
+      g_free (expected);
+    }
+
+  g_object_unref (server_addr);
+  g_object_unref (server);
+  g_object_unref (client);
+}
+
 static void
 test_sockaddr (void)
 {
@@ -818,6 +999,229 @@ test_unix_connection_ancillary_data (void)
    * g_unix_connection_receive_credentials().
    */
 }
+
+static void
+writev_all_cb (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  gsize *written = user_data;
+  GError *error = NULL;
+
+  g_assert (g_output_stream_writev_all_finish (G_OUTPUT_STREAM (source), result,
+                                               written, &error));
+  g_assert_no_error (error);
+}
+
+static void
+test_unix_connection_writev (void)
+{
+  GSocketConnection *writer, *reader;
+  GOutputStream *out;
+  GOutputVector vectors[3];
+  GError *error = NULL;
+  gchar buffer[2 * sizeof (TEST_DATA)];
+  gsize written, nread;
+  gint status, sv[2];
+
+  status = socketpair (PF_UNIX, SOCK_STREAM, 0, sv);
+  g_assert_cmpint (status, ==, 0);
+  writer = create_connection_for_fd (sv[0]);
+  reader = create_connection_for_fd (sv[1]);
+  out = g_io_stream_get_output_stream (G_IO_STREAM (writer));
+
+  vectors[0].buffer = TEST_DATA;
+  vectors[0].size = 8;
+  vectors[1].buffer = TEST_DATA;
+  vectors[1].size = 0;
+  vectors[2].buffer = TEST_DATA + 8;
+  vectors[2].size = sizeof (TEST_DATA) - 8;
+
+  g_assert (g_output_stream_writev (out, vectors, 3, &written, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (written, ==, sizeof (TEST_DATA));
+
+  written = 0;
+  g_output_stream_writev_all_async (out, vectors, 3, G_PRIORITY_DEFAULT, NULL,
+                                    writev_all_cb, &written);
+  while (written == 0)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (written, ==, sizeof (TEST_DATA));
+
+  g_input_stream_read_all (g_io_stream_get_input_stream (G_IO_STREAM (reader)),
+                           buffer, sizeof buffer, &nread, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (nread, ==, sizeof buffer);
+  g_assert_cmpstr (buffer, ==, TEST_DATA);
+  g_assert_cmpstr (buffer + sizeof (TEST_DATA), ==, TEST_DATA);
+
+  g_object_unref (writer);
+  g_object_unref (reader);
+}
+
+typedef struct {
+  GSource *source;
+  gssize nread;
+  gboolean cancelled;
+} WatchReuseData;
+
+static void
+watch_reuse_read_cb (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  WatchReuseData *data = user_data;
+  GError *error = NULL;
+
+  data->source = g_main_current_source ();
+  data->nread = g_input_stream_read_finish (G_INPUT_STREAM (source), result, &error);
+  if (data->nread == -1)
+    {
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+      g_error_free (error);
+      data->cancelled = TRUE;
+    }
+}
+
+/* Reads that have to wait all come back through the same source */
+static void
+test_unix_connection_watch_reuse (void)
+{
+  GSocketConnection *writer, *reader;
+  GInputStream *in;
+  GOutputStream *out;
+  GCancellable *cancellable;
+  GSource *first_source = NULL;
+  WatchReuseData data;
+  GError *error = NULL;
+  gchar buffer[16];
+  gint status, sv[2];
+  gint i;
+
+  status = socketpair (PF_UNIX, SOCK_STREAM, 0, sv);
+  g_assert_cmpint (status, ==, 0);
+  writer = create_connection_for_fd (sv[0]);
+  reader = create_connection_for_fd (sv[1]);
+  in = g_io_stream_get_input_stream (G_IO_STREAM (reader));
+  out = g_io_stream_get_output_stream (G_IO_STREAM (writer));
+
+  for (i = 0; i < 20; i++)
+    {
+      memset (&data, 0, sizeof data);
+      g_input_stream_read_async (in, buffer, sizeof buffer, G_PRIORITY_DEFAULT,
+                                 NULL, watch_reuse_read_cb, &data);
+      while (g_main_context_iteration (NULL, FALSE))
+        ;
+      g_assert (data.source == NULL);
+
+      g_output_stream_write_all (out, "ping", 4, NULL, NULL, &error);
+      g_assert_no_error (error);
+      while (data.source == NULL)
+        g_main_context_iteration (NULL, TRUE);
+      g_assert_cmpint (data.nread, ==, 4);
+
+      if (first_source == NULL)
+        first_source = g_source_ref (data.source);
+      g_assert (data.source == first_source);
+    }
+
+  /* the watch can be cancelled, and armed again after that */
+  cancellable = g_cancellable_new ();
+  memset (&data, 0, sizeof data);
+  g_input_stream_read_async (in, buffer, sizeof buffer, G_PRIORITY_DEFAULT,
+                             cancellable, watch_reuse_read_cb, &data);
+  g_cancellable_cancel (cancellable);
+  while (!data.cancelled)
+    g_main_context_iteration (NULL, TRUE);
+  g_object_unref (cancellable);
+
+  memset (&data, 0, sizeof data);
+  g_input_stream_read_async (in, buffer, sizeof buffer, G_PRIORITY_DEFAULT,
+                             NULL, watch_reuse_read_cb, &data);
+  g_output_stream_write_all (out, "pong", 4, NULL, NULL, &error);
+  g_assert_no_error (error);
+  while (data.source == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpint (data.nread, ==, 4);
+  g_assert (data.source == first_source);
+  g_assert (!g_source_is_destroyed (first_source));
+
+  g_object_unref (writer);
+  g_object_unref (reader);
+  g_assert (g_source_is_destroyed (first_source));
+  g_source_unref (first_source);
+}
+
+static void
+readv_cb (GObject      *source,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  gsize *nread = user_data;
+  GError *error = NULL;
+
+  g_assert (g_input_stream_readv_finish (G_INPUT_STREAM (source), result,
+                                         nread, &error));
+  g_assert_no_error (error);
+}
+
+static void
+test_unix_connection_readv (void)
+{
+  GSocketConnection *writer, *reader;
+  GOutputStream *out;
+  GInputStream *in;
+  GInputVector vectors[3];
+  GError *error = NULL;
+  gchar header[8], body[sizeof (TEST_DATA) - 8];
+  gsize nread;
+  gint status, sv[2];
+
+  status = socketpair (PF_UNIX, SOCK_STREAM, 0, sv);
+  g_assert_cmpint (status, ==, 0);
+  writer = create_connection_for_fd (sv[0]);
+  reader = create_connection_for_fd (sv[1]);
+  out = g_io_stream_get_output_stream (G_IO_STREAM (writer));
+  in = g_io_stream_get_input_stream (G_IO_STREAM (reader));
+
+  vectors[0].buffer = header;
+  vectors[0].size = sizeof header;
+  vectors[1].buffer = NULL;
+  vectors[1].size = 0;
+  vectors[2].buffer = body;
+  vectors[2].size = sizeof body;
+
+  g_output_stream_write_all (out, TEST_DATA, sizeof (TEST_DATA), NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  g_assert (g_input_stream_readv (in, vectors, 3, &nread, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (nread, ==, sizeof (TEST_DATA));
+  g_assert (memcmp (header, TEST_DATA, sizeof header) == 0);
+  g_assert_cmpstr (body, ==, TEST_DATA + sizeof header);
+
+  memset (header, 0, sizeof header);
+  memset (body, 0, sizeof body);
+
+  /* this time the read has to wait for the data */
+  nread = 0;
+  g_input_stream_readv_async (in, vectors, 3, G_PRIORITY_DEFAULT, NULL,
+                              readv_cb, &nread);
+  g_main_context_iteration (NULL, FALSE);
+  g_assert_cmpuint (nread, ==, 0);
+
+  g_output_stream_write_all (out, TEST_DATA, sizeof (TEST_DATA), NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  while (nread == 0)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (nread, ==, sizeof (TEST_DATA));
+  g_assert (memcmp (header, TEST_DATA, sizeof header) == 0);
+  g_assert_cmpstr (body, ==, TEST_DATA + sizeof header);
+
+  g_object_unref (writer);
+  g_object_unref (reader);
+}
 #endif /* G_OS_UNIX */
 
 static void
@@ -972,6 +1376,555 @@ test_datagram_get_available (void)
   g_object_unref (client);
 }
 
+#define N_SHARDED_CLIENTS 20
+
+static gint sharded_incoming_count;
+
+static gboolean
+sharded_incoming_cb (GSocketService    *service,
+                     GSocketConnection *connection,
+                     GObject           *source_object,
+                     gpointer           user_data)
+{
+  GThread *main_thread = user_data;
+  GMainContext *context;
+
+  g_assert (g_thread_self () != main_thread);
+  context = g_main_context_get_thread_default ();
+  g_assert (context != NULL);
+  g_assert (context != g_main_context_default ());
+  g_assert (g_main_context_is_owner (context));
+  g_assert (source_object == G_OBJECT (service));
+
+  g_atomic_int_inc (&sharded_incoming_count);
+
+  return FALSE;
+}
+
+static void
+wait_for_sharded_incoming (gint count)
+{
+  gint i;
+
+  for (i = 0; i < 1000 && g_atomic_int_get (&sharded_incoming_count) < count; i++)
+    g_usleep (10000);
+  g_assert_cmpint (g_atomic_int_get (&sharded_incoming_count), ==, count);
+}
+
+static void
+test_sharded_service (void)
+{
+  GSocketService *service;
+  GSocketClient *client;
+  GSocketConnection *connections[N_SHARDED_CLIENTS + 1];
+  GInetAddress *iaddr;
+  GSocketAddress *addr, *effective_address;
+  GError *error = NULL;
+  gboolean ok;
+  gint i;
+
+  service = g_socket_service_new ();
+  g_signal_connect (service, "incoming",
+                    G_CALLBACK (sharded_incoming_cb), g_thread_self ());
+
+  iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (iaddr, 0);
+  g_object_unref (iaddr);
+  ok = g_socket_service_add_sharded_address (service, addr, 4,
+                                             G_OBJECT (service),
+                                             &effective_address, &error);
+  g_object_unref (addr);
+#if !defined (SO_REUSEPORT) || !defined (__linux__)
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+  g_assert (!ok);
+  g_error_free (error);
+  g_object_unref (service);
+  return;
+#endif
+  g_assert_no_error (error);
+  g_assert (ok);
+  g_assert_cmpint (g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (effective_address)), !=, 0);
+
+  sharded_incoming_count = 0;
+  client = g_socket_client_new ();
+  for (i = 0; i < N_SHARDED_CLIENTS; i++)
+    {
+      connections[i] = g_socket_client_connect (client,
+                                                G_SOCKET_CONNECTABLE (effective_address),
+                                                NULL, &error);
+      g_assert_no_error (error);
+    }
+  wait_for_sharded_incoming (N_SHARDED_CLIENTS);
+
+  /* connections wait in the backlog while the service is stopped */
+  g_socket_service_stop (service);
+  connections[i] = g_socket_client_connect (client,
+                                            G_SOCKET_CONNECTABLE (effective_address),
+                                            NULL, &error);
+  g_assert_no_error (error);
+  g_usleep (100000);
+  g_assert_cmpint (g_atomic_int_get (&sharded_incoming_count), ==, N_SHARDED_CLIENTS);
+
+  g_socket_service_start (service);
+  wait_for_sharded_incoming (N_SHARDED_CLIENTS + 1);
+
+  for (i = 0; i < N_SHARDED_CLIENTS + 1; i++)
+    g_object_unref (connections[i]);
+  g_object_unref (client);
+  g_object_unref (effective_address);
+  g_object_unref (service);
+}
+
+#define N_BATCHED_CLIENTS 40
+
+static gboolean
+batched_incoming_cb (GSocketService    *service,
+                     GSocketConnection *connection,
+                     GObject           *source_object,
+                     gpointer           user_data)
+{
+  GPtrArray *accepted = user_data;
+
+  g_ptr_array_add (accepted, g_object_ref (connection));
+
+  return FALSE;
+}
+
+static void
+test_batched_accept (void)
+{
+  GSocketService *service;
+  GSocketClient *client;
+  GSocketConnection *connections[N_BATCHED_CLIENTS];
+  GPtrArray *accepted;
+  GInetAddress *iaddr;
+  GSocketAddress *addr, *effective_address;
+  GError *error = NULL;
+  gint i, iterations;
+
+  service = g_socket_service_new ();
+  accepted = g_ptr_array_new_with_free_func (g_object_unref);
+  g_signal_connect (service, "incoming",
+                    G_CALLBACK (batched_incoming_cb), accepted);
+  g_socket_listener_set_backlog (G_SOCKET_LISTENER (service), 2 * N_BATCHED_CLIENTS);
+
+  iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (iaddr, 0);
+  g_object_unref (iaddr);
+  g_socket_listener_add_address (G_SOCKET_LISTENER (service), addr,
+                                 G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP,
+                                 NULL, &effective_address, &error);
+  g_assert_no_error (error);
+  g_object_unref (addr);
+
+  /* queue up a storm of clients before the service gets to run */
+  client = g_socket_client_new ();
+  for (i = 0; i < N_BATCHED_CLIENTS; i++)
+    {
+      connections[i] = g_socket_client_connect (client,
+                                                G_SOCKET_CONNECTABLE (effective_address),
+                                                NULL, &error);
+      g_assert_no_error (error);
+    }
+
+  for (iterations = 0; accepted->len < N_BATCHED_CLIENTS && iterations < 100; iterations++)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (accepted->len, ==, N_BATCHED_CLIENTS);
+
+  /* one connection per iteration would need N_BATCHED_CLIENTS */
+  g_assert_cmpint (iterations, <=, 10);
+
+  for (i = 0; i < N_BATCHED_CLIENTS; i++)
+    g_object_unref (connections[i]);
+  g_ptr_array_unref (accepted);
+  g_object_unref (client);
+  g_object_unref (effective_address);
+  g_socket_service_stop (service);
+  g_object_unref (service);
+}
+
+#define N_WORKER_CLIENTS 30
+
+static gint worker_dropped_count;
+
+static gboolean
+worker_readable_cb (GThreadedSocketService *service,
+                    GSocketConnection      *connection,
+                    GObject                *source_object,
+                    gpointer                user_data)
+{
+  GThread *main_thread = user_data;
+  GSocket *socket;
+  GMainContext *context;
+  GError *error = NULL;
+  gchar buf[128];
+  gssize nread;
+
+  g_assert (g_thread_self () != main_thread);
+  context = g_main_context_get_thread_default ();
+  g_assert (context != NULL);
+  g_assert (context != g_main_context_default ());
+
+  socket = g_socket_connection_get_socket (connection);
+  nread = g_socket_receive_with_blocking (socket, buf, sizeof buf, FALSE, NULL, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+    {
+      g_error_free (error);
+      return TRUE;
+    }
+  g_assert_no_error (error);
+
+  if (nread == 0)
+    {
+      g_atomic_int_inc (&worker_dropped_count);
+      return FALSE;
+    }
+
+  g_socket_send (socket, buf, nread, NULL, &error);
+  g_assert_no_error (error);
+
+  return TRUE;
+}
+
+static gboolean
+quit_loop (gpointer user_data)
+{
+  g_main_loop_quit (user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+worker_client_thread (gpointer user_data)
+{
+  GSocketAddress *address = user_data;
+  GSocketClient *client;
+  GSocketConnection *connections[N_WORKER_CLIENTS];
+  GError *error = NULL;
+  gint i, round;
+
+  client = g_socket_client_new ();
+  for (i = 0; i < N_WORKER_CLIENTS; i++)
+    {
+      connections[i] = g_socket_client_connect (client,
+                                                G_SOCKET_CONNECTABLE (address),
+                                                NULL, &error);
+      g_assert_no_error (error);
+    }
+
+  /* all connections stay open, with far fewer threads than that */
+  for (round = 0; round < 3; round++)
+    for (i = 0; i < N_WORKER_CLIENTS; i++)
+      {
+        GSocket *socket = g_socket_connection_get_socket (connections[i]);
+        gchar msg[16], buf[16];
+        gssize len, nread;
+
+        len = g_snprintf (msg, sizeof msg, "%d-%d", round, i);
+        g_socket_send (socket, msg, len, NULL, &error);
+        g_assert_no_error (error);
+        nread = g_socket_receive (socket, buf, sizeof buf, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpint (nread, ==, len);
+        g_assert (memcmp (buf, msg, len) == 0);
+      }
+
+  for (i = 0; i < N_WORKER_CLIENTS; i++)
+    g_object_unref (connections[i]);
+  g_object_unref (client);
+
+  return NULL;
+}
+
+static void
+test_threaded_service_workers (void)
+{
+  GSocketService *service;
+  GInetAddress *iaddr;
+  GSocketAddress *addr, *effective_address;
+  GMainLoop *loop;
+  GThread *thread;
+  GError *error = NULL;
+  guint n_workers;
+
+  service = g_threaded_socket_service_new_with_workers (2);
+  g_object_get (service, "n-workers", &n_workers, NULL);
+  g_assert_cmpuint (n_workers, ==, 2);
+  g_signal_connect (service, "readable",
+                    G_CALLBACK (worker_readable_cb), g_thread_self ());
+
+  iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (iaddr, 0);
+  g_object_unref (iaddr);
+  g_socket_listener_add_address (G_SOCKET_LISTENER (service), addr,
+                                 G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                 NULL, &effective_address, &error);
+  g_assert_no_error (error);
+  g_object_unref (addr);
+
+  worker_dropped_count = 0;
+  loop = g_main_loop_new (NULL, FALSE);
+  thread = g_thread_new ("client", worker_client_thread, effective_address);
+  while (g_atomic_int_get (&worker_dropped_count) < N_WORKER_CLIENTS)
+    {
+      g_timeout_add (10, quit_loop, loop);
+      g_main_loop_run (loop);
+    }
+  g_thread_join (thread);
+  g_main_loop_unref (loop);
+
+  g_object_unref (effective_address);
+  g_object_unref (service);
+}
+
+/* A connectable that yields a fixed list of addresses, in order */
+typedef GSocketAddressEnumerator ListEnumerator;
+typedef GSocketAddressEnumeratorClass ListEnumeratorClass;
+
+static GType list_enumerator_get_type (void);
+G_DEFINE_TYPE (ListEnumerator, list_enumerator, G_TYPE_SOCKET_ADDRESS_ENUMERATOR)
+
+static GSocketAddress *
+list_enumerator_next (GSocketAddressEnumerator  *enumerator,
+                      GCancellable              *cancellable,
+                      GError                   **error)
+{
+  GList **addresses = g_object_get_data (G_OBJECT (enumerator), "addresses");
+  GSocketAddress *address;
+
+  if (*addresses == NULL)
+    return NULL;
+
+  address = g_object_ref ((*addresses)->data);
+  *addresses = (*addresses)->next;
+  return address;
+}
+
+static void
+list_enumerator_init (ListEnumerator *enumerator)
+{
+}
+
+static void
+list_enumerator_class_init (ListEnumeratorClass *class)
+{
+  class->next = list_enumerator_next;
+}
+
+typedef GObject ListConnectable;
+typedef GObjectClass ListConnectableClass;
+
+static GType list_connectable_get_type (void);
+static void list_connectable_iface_init (GSocketConnectableIface *iface);
+G_DEFINE_TYPE_WITH_CODE (ListConnectable, list_connectable, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_SOCKET_CONNECTABLE,
+                                                list_connectable_iface_init))
+
+static GSocketAddressEnumerator *
+list_connectable_enumerate (GSocketConnectable *connectable)
+{
+  GSocketAddressEnumerator *enumerator;
+  GList **addresses;
+
+  enumerator = g_object_new (list_enumerator_get_type (), NULL);
+  addresses = g_new (GList *, 1);
+  *addresses = g_object_get_data (G_OBJECT (connectable), "addresses");
+  g_object_set_data_full (G_OBJECT (enumerator), "addresses", addresses, g_free);
+
+  return enumerator;
+}
+
+static void
+list_connectable_init (ListConnectable *connectable)
+{
+}
+
+static void
+list_connectable_class_init (ListConnectableClass *class)
+{
+}
+
+static void
+list_connectable_iface_init (GSocketConnectableIface *iface)
+{
+  iface->enumerate = list_connectable_enumerate;
+  iface->proxy_enumerate = list_connectable_enumerate;
+}
+
+static GSocket *
+listen_on_loopback (gint backlog)
+{
+  GSocket *socket;
+  GInetAddress *iaddr;
+  GSocketAddress *addr;
+  GError *error = NULL;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_STREAM,
+                         G_SOCKET_PROTOCOL_DEFAULT, &error);
+  g_assert_no_error (error);
+
+  iaddr = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (iaddr, 0);
+  g_object_unref (iaddr);
+  g_socket_bind (socket, addr, TRUE, &error);
+  g_assert_no_error (error);
+  g_object_unref (addr);
+
+  g_socket_set_listen_backlog (socket, backlog);
+  g_socket_listen (socket, &error);
+  g_assert_no_error (error);
+
+  return socket;
+}
+
+static void
+happy_eyeballs_connected (GObject      *source,
+                          GAsyncResult *result,
+                          gpointer      user_data)
+{
+  GSocketConnection **connection = user_data;
+  GError *error = NULL;
+
+  *connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source),
+                                                result, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_client_happy_eyeballs (void)
+{
+  GSocket *blackhole, *server;
+  GSocket *fillers[4];
+  GSocketAddress *blackhole_addr, *server_addr, *remote_addr;
+  GObject *connectable;
+  GSocketClient *client;
+  GSocketConnection *connection = NULL;
+  GList *addresses;
+  GError *error = NULL;
+  gint64 start;
+  gint i;
+
+  /* Once its accept queue is full, a listening socket silently drops
+   * further SYNs, so connecting to it stalls until the timeout.
+   */
+  blackhole = listen_on_loopback (0);
+  blackhole_addr = g_socket_get_local_address (blackhole, &error);
+  g_assert_no_error (error);
+  for (i = 0; i < G_N_ELEMENTS (fillers); i++)
+    {
+      fillers[i] = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_STREAM,
+                                 G_SOCKET_PROTOCOL_DEFAULT, &error);
+      g_assert_no_error (error);
+      g_socket_set_blocking (fillers[i], FALSE);
+      g_socket_connect (fillers[i], blackhole_addr, NULL, NULL);
+    }
+
+  server = listen_on_loopback (10);
+  server_addr = g_socket_get_local_address (server, &error);
+  g_assert_no_error (error);
+
+  addresses = g_list_append (NULL, blackhole_addr);
+  addresses = g_list_append (addresses, server_addr);
+  connectable = g_object_new (list_connectable_get_type (), NULL);
+  g_object_set_data (connectable, "addresses", addresses);
+
+  client = g_socket_client_new ();
+  start = g_get_monotonic_time ();
+  g_socket_client_connect_async (client, G_SOCKET_CONNECTABLE (connectable), NULL,
+                                 happy_eyeballs_connected, &connection);
+  while (connection == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* the second address was raced against the first, not tried after it */
+  g_assert_cmpint (g_get_monotonic_time () - start, <, 5 * G_TIME_SPAN_SECOND);
+
+  remote_addr = g_socket_connection_get_remote_address (connection, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (remote_addr)), ==,
+                   g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (server_addr)));
+  g_object_unref (remote_addr);
+
+  g_object_unref (connection);
+  g_object_unref (client);
+  g_object_unref (connectable);
+  g_list_free (addresses);
+  for (i = 0; i < G_N_ELEMENTS (fillers); i++)
+    g_object_unref (fillers[i]);
+  g_object_unref (blackhole_addr);
+  g_object_unref (server_addr);
+  g_object_unref (blackhole);
+  g_object_unref (server);
+}
+
+static void
+test_client_connection_pool (void)
+{
+  GSocketConnectionPool *pool;
+  GSocketClient *client;
+  GSocket *server, *accepted;
+  GSocketAddress *server_addr;
+  GSocketConnection *conn1, *conn2, *conn3;
+  GError *error = NULL;
+
+  server = listen_on_loopback (10);
+  server_addr = g_socket_get_local_address (server, &error);
+  g_assert_no_error (error);
+
+  pool = g_socket_connection_pool_new ();
+  client = g_socket_client_new ();
+  g_socket_client_set_connection_pool (client, pool);
+  g_assert (g_socket_client_get_connection_pool (client) == pool);
+
+  conn1 = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (server_addr), NULL, &error);
+  g_assert_no_error (error);
+  g_socket_connection_pool_release (pool, conn1);
+  g_assert_cmpuint (g_socket_connection_pool_get_n_idle (pool), ==, 1);
+
+  /* the idle connection is handed out again */
+  conn2 = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (server_addr), NULL, &error);
+  g_assert_no_error (error);
+  g_assert (conn2 == conn1);
+  g_assert_cmpuint (g_socket_connection_pool_get_n_idle (pool), ==, 0);
+  g_object_unref (conn2);
+
+  /* ...unless the peer has closed it in the meantime */
+  g_socket_connection_pool_release (pool, conn1);
+  accepted = g_socket_accept (server, NULL, &error);
+  g_assert_no_error (error);
+  g_socket_close (accepted, &error);
+  g_assert_no_error (error);
+  g_object_unref (accepted);
+  g_socket_condition_timed_wait (g_socket_connection_get_socket (conn1), G_IO_IN,
+                                 G_USEC_PER_SEC, NULL, &error);
+  g_assert_no_error (error);
+
+  conn2 = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (server_addr), NULL, &error);
+  g_assert_no_error (error);
+  g_assert (conn2 != conn1);
+  g_assert (g_io_stream_is_closed (G_IO_STREAM (conn1)));
+  g_object_unref (conn1);
+
+  /* only max-idle-per-host connections are kept */
+  g_socket_connection_pool_set_max_idle_per_host (pool, 1);
+  conn3 = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (server_addr), NULL, &error);
+  g_assert_no_error (error);
+  g_socket_connection_pool_release (pool, conn2);
+  g_socket_connection_pool_release (pool, conn3);
+  g_assert_cmpuint (g_socket_connection_pool_get_n_idle (pool), ==, 1);
+  g_assert (g_io_stream_is_closed (G_IO_STREAM (conn2)));
+  g_assert (!g_io_stream_is_closed (G_IO_STREAM (conn3)));
+  g_object_unref (conn2);
+  g_object_unref (conn3);
+
+  g_socket_connection_pool_clear (pool);
+  g_assert_cmpuint (g_socket_connection_pool_get_n_idle (pool), ==, 0);
+
+  g_object_unref (client);
+  g_object_unref (pool);
+  g_object_unref (server_addr);
+  g_object_unref (server);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -987,15 +1940,25 @@ main (int   argc,
 #endif
   g_test_add_func ("/socket/close_graceful", test_close_graceful);
   g_test_add_func ("/socket/timed_wait", test_timed_wait);
+  g_test_add_func ("/socket/cancelled_wait", test_cancelled_wait);
+  g_test_add_func ("/socket/send_receive_messages", test_send_receive_messages);
   g_test_add_func ("/socket/address", test_sockaddr);
 #ifdef G_OS_UNIX
   g_test_add_func ("/socket/unix-from-fd", test_unix_from_fd);
   g_test_add_func ("/socket/unix-connection", test_unix_connection);
   g_test_add_func ("/socket/unix-connection-ancillary-data", test_unix_connection_ancillary_data);
+  g_test_add_func ("/socket/unix-connection-writev", test_unix_connection_writev);
+  g_test_add_func ("/socket/unix-connection-readv", test_unix_connection_readv);
+  g_test_add_func ("/socket/unix-connection-watch-reuse", test_unix_connection_watch_reuse);
 #endif
   g_test_add_func ("/socket/reuse/tcp", test_reuse_tcp);
   g_test_add_func ("/socket/reuse/udp", test_reuse_udp);
   g_test_add_func ("/socket/datagram_get_available", test_datagram_get_available);
+  g_test_add_func ("/socket/sharded-service", test_sharded_service);
+  g_test_add_func ("/socket/batched-accept", test_batched_accept);
+  g_test_add_func ("/socket/threaded-service-workers", test_threaded_service_workers);
+  g_test_add_func ("/socket/client-happy-eyeballs", test_client_happy_eyeballs);
+  g_test_add_func ("/socket/client-connection-pool", test_client_connection_pool);
 
   return g_test_run();
 }
@@ -781,12 +781,18 @@ test_run_in_thread_sync (void)
   gboolean thread_ran = FALSE;
   gssize ret;
   GError *error = NULL;
+  GThreadPoolStats before, after;
+
+  g_task_get_thread_pool_stats (&before);
 
   task = g_task_new (NULL, NULL, run_in_thread_sync_callback, NULL);
 
   g_task_set_task_data (task, &thread_ran, NULL);
   g_task_run_in_thread_sync (task, run_in_thread_sync_thread);
 
+  g_task_get_thread_pool_stats (&after);
+  g_assert_cmpuint (after.tasks_pushed, ==, before.tasks_pushed + 1);
+
   g_assert (thread_ran == TRUE);
   g_assert (task != NULL);
   g_assert (!g_task_had_error (task));
@@ -905,6 +911,9 @@ test_run_in_thread_priority (void)
   GCancellable *cancellable;
   int seq_a, seq_b, seq_c, seq_d;
 
+  /* Don't let the pool grow while it is clogged up */
+  g_task_set_thread_pool_size (G_TASK_THREAD_POOL_SIZE, G_TASK_THREAD_POOL_SIZE, 0);
+
   clog_up_thread_pool ();
 
   /* Queue three more tasks that we'll arrange to have run serially */
@@ -946,6 +955,8 @@ test_run_in_thread_priority (void)
   g_assert_cmpint (seq_b, ==, 4);
 
   unclog_thread_pool ();
+
+  g_task_set_thread_pool_size (0, 0, 0);
 }
 
 /* test_run_in_thread_nested: task threads that block waiting on
@@ -991,6 +1002,131 @@ test_run_in_thread_nested (void)
   unclog_thread_pool ();
 }
 
+/* test_thread_pool_grow: tasks that block for long make the thread
+ * pool start more threads.
+ */
+
+static gint blocked_tasks;
+
+static void
+blocking_task_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  GMutex *mutex = task_data;
+
+  g_atomic_int_inc (&blocked_tasks);
+  g_mutex_lock (mutex);
+  g_mutex_unlock (mutex);
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+test_thread_pool_grow (void)
+{
+  GTask *task;
+  GMutex mutex;
+  gint64 end_time;
+  int i;
+
+  g_task_set_thread_pool_size (2, 4, G_USEC_PER_SEC / 100);
+
+  g_mutex_init (&mutex);
+  g_mutex_lock (&mutex);
+  for (i = 0; i < 4; i++)
+    {
+      task = g_task_new (NULL, NULL, fake_task_callback, NULL);
+      g_task_set_task_data (task, &mutex, NULL);
+      g_task_run_in_thread (task, blocking_task_thread);
+      g_object_unref (task);
+      fake_tasks_running++;
+    }
+
+  /* Only 2 tasks can run at first, the other 2 need new threads */
+  end_time = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+  while (g_atomic_int_get (&blocked_tasks) < 4 &&
+         g_get_monotonic_time () < end_time)
+    g_usleep (1000);
+  g_assert_cmpint (g_atomic_int_get (&blocked_tasks), ==, 4);
+
+  g_mutex_unlock (&mutex);
+  g_main_loop_run (loop);
+  g_mutex_clear (&mutex);
+
+  g_task_set_thread_pool_size (0, 0, 0);
+}
+
+/* test_return_batched: tasks returning from threads are completed
+ * by a single source per context.
+ */
+
+#define N_BATCHED_TASKS 50
+
+static void
+batched_callback (GObject      *object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GSource **sources = user_data;
+  GError *error = NULL;
+  gint i;
+
+  g_assert (g_main_context_get_thread_default () == g_task_get_context (G_TASK (result)));
+  g_assert (g_task_propagate_boolean (G_TASK (result), &error));
+  g_assert_no_error (error);
+
+  /* keep the first source alive, so that its address is not reused */
+  for (i = 0; sources[i]; i++)
+    ;
+  sources[i] = g_main_current_source ();
+  if (i == 0)
+    g_source_ref (sources[0]);
+}
+
+static void
+batched_thread (GTask        *task,
+                gpointer      source_object,
+                gpointer      task_data,
+                GCancellable *cancellable)
+{
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+test_return_batched (void)
+{
+  GMainContext *context;
+  GSource *sources[2 * N_BATCHED_TASKS + 1] = { NULL, };
+  GTask *task;
+  int i, round;
+
+  context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+
+  for (round = 0; round < 2; round++)
+    {
+      GSource **round_sources = sources + round * N_BATCHED_TASKS;
+
+      for (i = 0; i < N_BATCHED_TASKS; i++)
+        {
+          task = g_task_new (NULL, NULL, batched_callback, sources);
+          g_task_run_in_thread (task, batched_thread);
+          g_object_unref (task);
+        }
+
+      while (round_sources[N_BATCHED_TASKS - 1] == NULL)
+        g_main_context_iteration (context, TRUE);
+
+      for (i = 0; i < N_BATCHED_TASKS; i++)
+        g_assert (round_sources[i] == sources[0]);
+    }
+
+  g_source_unref (sources[0]);
+  g_main_context_pop_thread_default (context);
+  g_main_context_unref (context);
+}
+
 /* test_return_on_cancel */
 
 GMutex roc_init_mutex, roc_finish_mutex;
@@ -1752,6 +1888,8 @@ main (int argc, char **argv)
   g_test_add_func ("/gtask/run-in-thread-sync", test_run_in_thread_sync);
   g_test_add_func ("/gtask/run-in-thread-priority", test_run_in_thread_priority);
   g_test_add_func ("/gtask/run-in-thread-nested", test_run_in_thread_nested);
+  g_test_add_func ("/gtask/thread-pool-grow", test_thread_pool_grow);
+  g_test_add_func ("/gtask/return-batched", test_return_batched);
   g_test_add_func ("/gtask/return-on-cancel", test_return_on_cancel);
   g_test_add_func ("/gtask/return-on-cancel-sync", test_return_on_cancel_sync);
   g_test_add_func ("/gtask/return-on-cancel-atomic", test_return_on_cancel_atomic);
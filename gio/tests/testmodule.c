@@ -0,0 +1,47 @@
+/* Built twice, as libtestmodulea and libtestmoduleb, each providing a
+ * settings backend with its own name and priority: see giomodule.c.
+ */
+
+#define G_SETTINGS_ENABLE_BACKEND
+#include <gio/gio.h>
+#include <gio/gsettingsbackend.h>
+
+#ifdef TEST_MODULE_A
+#define TEST_BACKEND_TYPE_NAME "TestBackendA"
+#define TEST_BACKEND_NAME      "test-backend-a"
+#define TEST_BACKEND_PRIORITY  1000
+#else
+#define TEST_BACKEND_TYPE_NAME "TestBackendB"
+#define TEST_BACKEND_NAME      "test-backend-b"
+#define TEST_BACKEND_PRIORITY  900
+#endif
+
+void
+g_io_module_load (GIOModule *module)
+{
+  static const GTypeInfo info = {
+    sizeof (GSettingsBackendClass),
+    NULL, NULL, NULL, NULL, NULL,
+    sizeof (GSettingsBackend),
+    0, NULL, NULL
+  };
+  GType type;
+
+  type = g_type_module_register_type (G_TYPE_MODULE (module),
+                                      G_TYPE_SETTINGS_BACKEND,
+                                      TEST_BACKEND_TYPE_NAME, &info, 0);
+  g_io_extension_point_implement (G_SETTINGS_BACKEND_EXTENSION_POINT_NAME,
+                                  type, TEST_BACKEND_NAME,
+                                  TEST_BACKEND_PRIORITY);
+}
+
+void
+g_io_module_unload (GIOModule   *module)
+{
+}
+
+char **
+g_io_module_query (void)
+{
+  return NULL;
+}
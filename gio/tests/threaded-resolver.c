@@ -0,0 +1,602 @@
+/* GLib testing framework examples and tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "gnetworkingprivate.h"
+
+/* getaddrinfo() as the resolver sees it: every name resolves to
+ * 127.0.0.1 except for a couple of failing ones, calls are counted,
+ * and closing the gate holds them up.
+ */
+static gint n_getaddrinfo_calls;
+static GMutex gate_lock;
+static GCond gate_cond;
+static gboolean gate_closed;
+
+static int
+fake_getaddrinfo (const char             *node,
+                  const char             *service,
+                  const struct addrinfo  *hints,
+                  struct addrinfo       **res)
+{
+  struct addrinfo numeric_hints;
+
+  g_mutex_lock (&gate_lock);
+  n_getaddrinfo_calls++;
+  while (gate_closed)
+    g_cond_wait (&gate_cond, &gate_lock);
+  g_mutex_unlock (&gate_lock);
+
+  if (g_str_equal (node, "missing.test"))
+    return EAI_NONAME;
+  if (g_str_equal (node, "unavailable.test"))
+    return EAI_AGAIN;
+
+  numeric_hints = *hints;
+  numeric_hints.ai_flags = AI_NUMERICHOST;
+
+  return getaddrinfo ("127.0.0.1", service, &numeric_hints, res);
+}
+
+#define getaddrinfo fake_getaddrinfo
+
+#include "../gthreadedresolver.c"
+
+/* A name server on a local UDP socket, answering every TXT question
+ * with "hello" unless told otherwise.
+ */
+typedef struct {
+  GSocket *socket;
+  GSocketAddress *address;
+  GSource *source;
+  gint n_queries;
+  gint ignore;
+  guchar rcode;
+  gboolean truncate;
+} FakeNameServer;
+
+static gboolean
+fake_name_server_readable (GSocket      *socket,
+                           GIOCondition  condition,
+                           gpointer      user_data)
+{
+  FakeNameServer *server = user_data;
+  static const guchar answer[] = {
+    0xc0, 0x0c,               /* name: pointer to the question */
+    0x00, 0x10, 0x00, 0x01,   /* TXT, IN */
+    0x00, 0x00, 0x0e, 0x10,   /* ttl */
+    0x00, 0x06,               /* rdlength */
+    0x05, 'h', 'e', 'l', 'l', 'o'
+  };
+  GSocketAddress *sender;
+  guchar packet[DNS_MAX_PACKET];
+  gssize len;
+
+  len = g_socket_receive_from (socket, &sender, (gchar *) packet, DNS_MAX_QUERY, NULL, NULL);
+  g_assert_cmpint (len, >, DNS_HEADER_SIZE);
+
+  server->n_queries++;
+  if (server->n_queries <= server->ignore)
+    {
+      g_object_unref (sender);
+      return G_SOURCE_CONTINUE;
+    }
+
+  packet[2] = 0x80 | (packet[2] & 0x01) | (server->truncate ? 0x02 : 0);
+  packet[3] = 0x80 | server->rcode;
+
+  if (server->rcode == 0 && !server->truncate)
+    {
+      packet[7] = 1;
+      memcpy (packet + len, answer, sizeof answer);
+      len += sizeof answer;
+    }
+
+  g_socket_send_to (socket, sender, (gchar *) packet, len, NULL, NULL);
+  g_object_unref (sender);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static FakeNameServer *
+fake_name_server_new (void)
+{
+  FakeNameServer *server;
+  GInetAddress *loopback;
+  GSocketAddress *any;
+  GError *error = NULL;
+
+  server = g_new0 (FakeNameServer, 1);
+
+  server->socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+                                 G_SOCKET_PROTOCOL_UDP, &error);
+  g_assert_no_error (error);
+
+  loopback = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  any = g_inet_socket_address_new (loopback, 0);
+  g_socket_bind (server->socket, any, TRUE, &error);
+  g_assert_no_error (error);
+  g_object_unref (any);
+  g_object_unref (loopback);
+
+  server->address = g_socket_get_local_address (server->socket, &error);
+  g_assert_no_error (error);
+
+  server->source = g_socket_create_source (server->socket, G_IO_IN, NULL);
+  g_source_set_callback (server->source, (GSourceFunc) fake_name_server_readable, server, NULL);
+  g_source_attach (server->source, NULL);
+
+  return server;
+}
+
+static void
+fake_name_server_free (FakeNameServer *server)
+{
+  g_source_destroy (server->source);
+  g_source_unref (server->source);
+  g_object_unref (server->address);
+  g_object_unref (server->socket);
+  g_free (server);
+}
+
+static GResolver *
+resolver_new (FakeNameServer **servers,
+              guint            n_servers,
+              guint            timeout,
+              guint            attempts)
+{
+  GThreadedResolver *gtr;
+  guint i;
+
+  gtr = g_object_new (G_TYPE_THREADED_RESOLVER, NULL);
+
+  /* stands in for load_dns_config() */
+  gtr->nameservers = g_ptr_array_new_with_free_func (g_object_unref);
+  for (i = 0; i < n_servers; i++)
+    g_ptr_array_add (gtr->nameservers, g_object_ref (servers[i]->address));
+  gtr->dns_timeout = timeout;
+  gtr->dns_attempts = attempts;
+
+  return G_RESOLVER (gtr);
+}
+
+typedef struct {
+  gboolean done;
+  GList *records;
+  GError *error;
+} LookupResult;
+
+static void
+lookup_records_cb (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  LookupResult *lookup = user_data;
+
+  lookup->records = g_resolver_lookup_records_finish (G_RESOLVER (source), result, &lookup->error);
+  lookup->done = TRUE;
+}
+
+static void
+lookup_txt (GResolver     *resolver,
+            GCancellable  *cancellable,
+            LookupResult  *lookup)
+{
+  memset (lookup, 0, sizeof *lookup);
+  g_resolver_lookup_records_async (resolver, "example.test", G_RESOLVER_RECORD_TXT,
+                                   cancellable, lookup_records_cb, lookup);
+}
+
+static void
+lookup_txt_sync (GResolver    *resolver,
+                 LookupResult *lookup)
+{
+  lookup_txt (resolver, NULL, lookup);
+  while (!lookup->done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+assert_hello (LookupResult *lookup)
+{
+  const gchar **strings;
+
+  g_assert_no_error (lookup->error);
+  g_assert_cmpint (g_list_length (lookup->records), ==, 1);
+
+  g_variant_get (lookup->records->data, "(^a&s)", &strings);
+  g_assert_cmpint (g_strv_length ((gchar **) strings), ==, 1);
+  g_assert_cmpstr (strings[0], ==, "hello");
+  g_free (strings);
+
+  g_list_free_full (lookup->records, (GDestroyNotify) g_variant_unref);
+}
+
+static void
+test_records_answer (void)
+{
+  FakeNameServer *server;
+  GResolver *resolver;
+  LookupResult lookup;
+
+  server = fake_name_server_new ();
+  resolver = resolver_new (&server, 1, 5, 2);
+
+  lookup_txt_sync (resolver, &lookup);
+  assert_hello (&lookup);
+  g_assert_cmpint (server->n_queries, ==, 1);
+
+  server->rcode = 3;
+  lookup_txt_sync (resolver, &lookup);
+  g_assert_error (lookup.error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+  g_assert (lookup.records == NULL);
+  g_clear_error (&lookup.error);
+  g_assert_cmpint (server->n_queries, ==, 2);
+
+  g_object_unref (resolver);
+  fake_name_server_free (server);
+}
+
+static void
+test_records_server_failure (void)
+{
+  FakeNameServer *servers[2];
+  GResolver *resolver;
+  LookupResult lookup;
+
+  servers[0] = fake_name_server_new ();
+  servers[0]->rcode = 2;
+  servers[1] = fake_name_server_new ();
+  resolver = resolver_new (servers, 2, 5, 2);
+
+  /* SERVFAIL from the first server: ask the second one */
+  lookup_txt_sync (resolver, &lookup);
+  assert_hello (&lookup);
+  g_assert_cmpint (servers[0]->n_queries, ==, 1);
+  g_assert_cmpint (servers[1]->n_queries, ==, 1);
+
+  g_object_unref (resolver);
+  fake_name_server_free (servers[0]);
+  fake_name_server_free (servers[1]);
+}
+
+static void
+test_records_timeout (void)
+{
+  FakeNameServer *server;
+  GResolver *resolver;
+  LookupResult lookup;
+
+  server = fake_name_server_new ();
+  resolver = resolver_new (&server, 1, 1, 2);
+
+  /* the first query is lost; the retry gets through */
+  server->ignore = 1;
+  lookup_txt_sync (resolver, &lookup);
+  assert_hello (&lookup);
+  g_assert_cmpint (server->n_queries, ==, 2);
+
+  /* every attempt is lost */
+  server->n_queries = 0;
+  server->ignore = G_MAXINT;
+  lookup_txt_sync (resolver, &lookup);
+  g_assert_error (lookup.error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_TEMPORARY_FAILURE);
+  g_assert (lookup.records == NULL);
+  g_clear_error (&lookup.error);
+  g_assert_cmpint (server->n_queries, ==, 2);
+
+  g_object_unref (resolver);
+  fake_name_server_free (server);
+}
+
+static void
+test_records_truncated (void)
+{
+  FakeNameServer *server;
+  GResolver *resolver;
+  LookupResult lookup;
+
+  server = fake_name_server_new ();
+  server->truncate = TRUE;
+  resolver = resolver_new (&server, 1, 5, 2);
+
+  /* The truncated reply is handed over to res_query(), which asks the
+   * system's name servers rather than ours, and never gets "hello".
+   */
+  lookup_txt_sync (resolver, &lookup);
+  g_assert (lookup.records == NULL);
+  g_assert (lookup.error != NULL);
+  g_clear_error (&lookup.error);
+  g_assert_cmpint (server->n_queries, ==, 1);
+
+  g_object_unref (resolver);
+  fake_name_server_free (server);
+}
+
+static void
+test_records_cancel_waiting (void)
+{
+  FakeNameServer *server;
+  GResolver *resolver;
+  GThreadedResolver *gtr;
+  GCancellable *others, *cancellable;
+  LookupResult *running, waiting, cancelled;
+  gint i, n_done;
+
+  server = fake_name_server_new ();
+  server->ignore = G_MAXINT;
+  resolver = resolver_new (&server, 1, 2, 1);
+  gtr = G_THREADED_RESOLVER (resolver);
+
+  others = g_cancellable_new ();
+  cancellable = g_cancellable_new ();
+
+  running = g_new (LookupResult, DNS_MAX_RUNNING);
+  for (i = 0; i < DNS_MAX_RUNNING; i++)
+    lookup_txt (resolver, others, &running[i]);
+  lookup_txt (resolver, others, &waiting);
+  lookup_txt (resolver, cancellable, &cancelled);
+  g_assert_cmpint (g_queue_get_length (&gtr->dns_queries_waiting), ==, 2);
+
+  /* a query waiting for its turn finishes as soon as it is cancelled,
+   * without being sent or waiting for the ones ahead of it
+   */
+  g_cancellable_cancel (cancellable);
+  while (!cancelled.done)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_error (cancelled.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&cancelled.error);
+
+  for (i = 0; i < DNS_MAX_RUNNING; i++)
+    g_assert (!running[i].done);
+  g_assert (!waiting.done);
+  g_assert_cmpint (g_queue_get_length (&gtr->dns_queries_waiting), ==, 1);
+
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (server->n_queries, ==, DNS_MAX_RUNNING);
+
+  g_cancellable_cancel (others);
+  do
+    {
+      g_main_context_iteration (NULL, TRUE);
+
+      n_done = waiting.done;
+      for (i = 0; i < DNS_MAX_RUNNING; i++)
+        n_done += running[i].done;
+    }
+  while (n_done < DNS_MAX_RUNNING + 1);
+
+  for (i = 0; i < DNS_MAX_RUNNING; i++)
+    {
+      g_assert_error (running[i].error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+      g_clear_error (&running[i].error);
+    }
+  g_assert_error (waiting.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&waiting.error);
+
+  g_assert_cmpint (g_queue_get_length (&gtr->dns_queries_waiting), ==, 0);
+  g_assert_cmpint (gtr->dns_queries_running, ==, 0);
+
+  g_free (running);
+  g_object_unref (others);
+  g_object_unref (cancellable);
+  g_object_unref (resolver);
+  fake_name_server_free (server);
+}
+
+static void
+assert_loopback (GList *addresses)
+{
+  gchar *str;
+
+  g_assert_cmpint (g_list_length (addresses), ==, 1);
+  str = g_inet_address_to_string (addresses->data);
+  g_assert_cmpstr (str, ==, "127.0.0.1");
+  g_free (str);
+
+  g_resolver_free_addresses (addresses);
+}
+
+static void
+lookup_by_name_cb (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  GList **addresses = user_data;
+  GError *error = NULL;
+
+  *addresses = g_resolver_lookup_by_name_finish (G_RESOLVER (source), result, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_cache_hit (void)
+{
+  GResolver *resolver;
+  GList *addresses = NULL;
+  GError *error = NULL;
+
+  resolver = g_object_new (G_TYPE_THREADED_RESOLVER, NULL);
+  n_getaddrinfo_calls = 0;
+
+  assert_loopback (g_resolver_lookup_by_name (resolver, "cached.test", NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 1);
+
+  assert_loopback (g_resolver_lookup_by_name (resolver, "cached.test", NULL, &error));
+  g_assert_no_error (error);
+  g_resolver_lookup_by_name_async (resolver, "cached.test", NULL, lookup_by_name_cb, &addresses);
+  while (addresses == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  assert_loopback (addresses);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 1);
+
+  /* names that don't exist are remembered too... */
+  g_assert (g_resolver_lookup_by_name (resolver, "missing.test", NULL, &error) == NULL);
+  g_assert_error (error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+  g_clear_error (&error);
+  g_assert (g_resolver_lookup_by_name (resolver, "missing.test", NULL, &error) == NULL);
+  g_assert_error (error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+  g_clear_error (&error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 2);
+
+  /* ...but temporary failures are not */
+  g_assert (g_resolver_lookup_by_name (resolver, "unavailable.test", NULL, &error) == NULL);
+  g_assert_error (error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_TEMPORARY_FAILURE);
+  g_clear_error (&error);
+  g_assert (g_resolver_lookup_by_name (resolver, "unavailable.test", NULL, &error) == NULL);
+  g_assert_error (error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_TEMPORARY_FAILURE);
+  g_clear_error (&error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 4);
+
+  g_object_unref (resolver);
+}
+
+static void
+test_cache_expiry (void)
+{
+  GThreadedResolver *gtr;
+  GResolver *resolver;
+  CachedLookup *cached;
+  GError *error = NULL;
+
+  resolver = g_object_new (G_TYPE_THREADED_RESOLVER, NULL);
+  gtr = G_THREADED_RESOLVER (resolver);
+  n_getaddrinfo_calls = 0;
+
+  assert_loopback (g_resolver_lookup_by_name (resolver, "cached.test", NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 1);
+
+  cached = g_hash_table_lookup (gtr->lookup_cache, "cached.test");
+  g_assert (cached != NULL);
+  g_assert_cmpint (cached->expires, >, g_get_monotonic_time () + (LOOKUP_CACHE_TTL - 1) * G_USEC_PER_SEC);
+  cached->expires = g_get_monotonic_time ();
+
+  assert_loopback (g_resolver_lookup_by_name (resolver, "cached.test", NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 2);
+
+  g_assert (g_resolver_lookup_by_name (resolver, "missing.test", NULL, &error) == NULL);
+  g_clear_error (&error);
+  cached = g_hash_table_lookup (gtr->lookup_cache, "missing.test");
+  g_assert (cached != NULL);
+  g_assert_cmpint (cached->expires, <=, g_get_monotonic_time () + LOOKUP_CACHE_NEGATIVE_TTL * G_USEC_PER_SEC);
+  cached->expires = g_get_monotonic_time ();
+
+  g_assert (g_resolver_lookup_by_name (resolver, "missing.test", NULL, &error) == NULL);
+  g_clear_error (&error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 4);
+
+  g_object_unref (resolver);
+}
+
+static void
+test_cache_reload (void)
+{
+  GResolver *resolver;
+  GError *error = NULL;
+
+  resolver = g_object_new (G_TYPE_THREADED_RESOLVER, NULL);
+  n_getaddrinfo_calls = 0;
+
+  assert_loopback (g_resolver_lookup_by_name (resolver, "cached.test", NULL, &error));
+  g_assert_no_error (error);
+  g_assert (g_resolver_lookup_by_name (resolver, "missing.test", NULL, &error) == NULL);
+  g_clear_error (&error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 2);
+
+  /* what GResolver does when resolv.conf changes */
+  g_signal_emit_by_name (resolver, "reload");
+
+  assert_loopback (g_resolver_lookup_by_name (resolver, "cached.test", NULL, &error));
+  g_assert_no_error (error);
+  g_assert (g_resolver_lookup_by_name (resolver, "missing.test", NULL, &error) == NULL);
+  g_clear_error (&error);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 4);
+
+  g_object_unref (resolver);
+}
+
+static void
+test_cache_in_flight (void)
+{
+  GThreadedResolver *gtr;
+  GResolver *resolver;
+  InFlightLookup *in_flight;
+  GList *addresses[2] = { NULL, NULL };
+  gint waiting = 0;
+
+  resolver = g_object_new (G_TYPE_THREADED_RESOLVER, NULL);
+  gtr = G_THREADED_RESOLVER (resolver);
+  n_getaddrinfo_calls = 0;
+
+  g_mutex_lock (&gate_lock);
+  gate_closed = TRUE;
+  g_mutex_unlock (&gate_lock);
+
+  g_resolver_lookup_by_name_async (resolver, "shared.test", NULL, lookup_by_name_cb, &addresses[0]);
+  g_resolver_lookup_by_name_async (resolver, "shared.test", NULL, lookup_by_name_cb, &addresses[1]);
+
+  /* wait for the second lookup to join the first */
+  while (waiting < 2)
+    {
+      g_usleep (1000);
+
+      g_mutex_lock (&gtr->lookup_lock);
+      in_flight = g_hash_table_lookup (gtr->lookups_in_flight, "shared.test");
+      waiting = in_flight ? in_flight->ref_count : 0;
+      g_mutex_unlock (&gtr->lookup_lock);
+    }
+
+  g_mutex_lock (&gate_lock);
+  gate_closed = FALSE;
+  g_cond_broadcast (&gate_cond);
+  g_mutex_unlock (&gate_lock);
+
+  while (addresses[0] == NULL || addresses[1] == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  assert_loopback (addresses[0]);
+  assert_loopback (addresses[1]);
+  g_assert_cmpint (n_getaddrinfo_calls, ==, 1);
+  g_assert_cmpint (g_hash_table_size (gtr->lookups_in_flight), ==, 0);
+
+  g_object_unref (resolver);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/threaded-resolver/records/answer", test_records_answer);
+  g_test_add_func ("/threaded-resolver/records/server-failure", test_records_server_failure);
+  g_test_add_func ("/threaded-resolver/records/timeout", test_records_timeout);
+  g_test_add_func ("/threaded-resolver/records/truncated", test_records_truncated);
+  g_test_add_func ("/threaded-resolver/records/cancel-waiting", test_records_cancel_waiting);
+  g_test_add_func ("/threaded-resolver/cache/hit", test_cache_hit);
+  g_test_add_func ("/threaded-resolver/cache/expiry", test_cache_expiry);
+  g_test_add_func ("/threaded-resolver/cache/reload", test_cache_reload);
+  g_test_add_func ("/threaded-resolver/cache/in-flight", test_cache_in_flight);
+
+  return g_test_run ();
+}
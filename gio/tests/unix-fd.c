@@ -230,12 +230,68 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   check_fd_list (fd_list);
 }
 
+static void
+test_fd_list_bytes (void)
+{
+  GError *err = NULL;
+  GUnixFDList *list, *l2;
+  GBytes *bytes, *received;
+  const gint *peek;
+  guint8 *data;
+  gint fd_list[40];
+  gint nfd;
+  gint i;
+
+  create_fd_list (fd_list);
+
+  data = g_malloc (1024 * 1024);
+  for (i = 0; i < 1024 * 1024; i++)
+    data[i] = i % 251;
+  bytes = g_bytes_new_take (data, 1024 * 1024);
+
+  list = g_unix_fd_list_new ();
+  i = g_unix_fd_list_append_bytes (list, bytes, &err);
+  g_assert_no_error (err);
+  g_assert_cmpint (i, ==, 0);
+
+  /* what the receiving end sees */
+  peek = g_unix_fd_list_peek_fds (list, &nfd);
+  l2 = g_unix_fd_list_new_from_array (peek, nfd);
+  g_unix_fd_list_steal_fds (list, NULL);
+  g_object_unref (list);
+
+  received = g_unix_fd_list_get_bytes (l2, 0, &err);
+  g_assert_no_error (err);
+  g_assert (g_bytes_equal (bytes, received));
+  g_object_unref (l2);
+
+  /* still valid after the list closed the fd */
+  g_assert (g_bytes_equal (bytes, received));
+  g_bytes_unref (received);
+  g_bytes_unref (bytes);
+
+  /* empty payloads work too */
+  list = g_unix_fd_list_new ();
+  bytes = g_bytes_new_static ("", 0);
+  i = g_unix_fd_list_append_bytes (list, bytes, &err);
+  g_assert_no_error (err);
+  received = g_unix_fd_list_get_bytes (list, i, &err);
+  g_assert_no_error (err);
+  g_assert_cmpuint (g_bytes_get_size (received), ==, 0);
+  g_bytes_unref (received);
+  g_bytes_unref (bytes);
+  g_object_unref (list);
+
+  check_fd_list (fd_list);
+}
+
 int
 main (int argc, char **argv)
 {
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/unix-streams/file-descriptors", test_fds);
+  g_test_add_func ("/unix-streams/fd-list-bytes", test_fd_list_bytes);
 
   return g_test_run();
 
@@ -0,0 +1,124 @@
+/* GLib testing framework examples and tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "../gunixmounts.c"
+
+#ifdef __linux__
+
+static void
+apply (MountInfoSnapshot  *snapshot,
+       const gchar        *text,
+       GList             **added,
+       GList             **removed,
+       GList             **changed)
+{
+  gchar *contents;
+
+  *added = *removed = *changed = NULL;
+
+  contents = g_strdup (text);
+  mountinfo_snapshot_apply (snapshot, contents, added, removed, changed);
+  g_free (contents);
+}
+
+static void
+test_mountinfo_diff (void)
+{
+  MountInfoSnapshot *snapshot;
+  GList *added, *removed, *changed;
+  GUnixMountEntry *entry;
+  MountInfoLine *info;
+
+  snapshot = mountinfo_snapshot_new ();
+
+  apply (snapshot,
+         "15 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+         "16 15 0:4 / /proc rw,nosuid - proc proc rw\n"
+         "17 15 8:2 / /home rw - ext4 /dev/sda2 rw,errors=continue\n",
+         &added, &removed, &changed);
+  g_assert_cmpint (g_list_length (added), ==, 3);
+  g_assert (removed == NULL);
+  g_assert (changed == NULL);
+  g_list_free (added);
+
+  /* / stays, /proc goes, /home is remounted read-only, a mount point
+   * with an escaped space appears, and a line that can't be parsed is
+   * left out
+   */
+  apply (snapshot,
+         "15 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+         "17 15 8:2 / /home ro - ext4 /dev/sda2 ro,errors=continue\n"
+         "18 15 8:3 / /mnt/usb\\040disk rw - vfat /dev/sdb1 rw\n"
+         "19 15 8:4 /\n",
+         &added, &removed, &changed);
+
+  g_assert_cmpint (g_list_length (added), ==, 1);
+  entry = added->data;
+  g_assert_cmpstr (g_unix_mount_get_mount_path (entry), ==, "/mnt/usb disk");
+  g_assert_cmpstr (g_unix_mount_get_device_path (entry), ==, "/dev/sdb1");
+  g_assert_cmpstr (g_unix_mount_get_fs_type (entry), ==, "vfat");
+  g_assert (!g_unix_mount_is_readonly (entry));
+  g_list_free (added);
+
+  g_assert_cmpint (g_list_length (removed), ==, 1);
+  entry = removed->data;
+  g_assert_cmpstr (g_unix_mount_get_mount_path (entry), ==, "/proc");
+  g_assert (g_unix_mount_is_system_internal (entry));
+  g_list_free_full (removed, (GDestroyNotify) g_unix_mount_free);
+
+  g_assert_cmpint (g_list_length (changed), ==, 1);
+  entry = changed->data;
+  g_assert_cmpstr (g_unix_mount_get_mount_path (entry), ==, "/home");
+  g_assert (g_unix_mount_is_readonly (entry));
+  g_list_free (changed);
+
+  g_assert_cmpint (snapshot->order->len, ==, 3);
+
+  /* A mount whose line can no longer be parsed is kept as it was, not
+   * reported removed
+   */
+  apply (snapshot,
+         "15 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+         "17 15 8:2 garbage\n"
+         "18 15 8:3 / /mnt/usb\\040disk rw - vfat /dev/sdb1 rw\n",
+         &added, &removed, &changed);
+  g_assert (added == NULL);
+  g_assert (removed == NULL);
+  g_assert (changed == NULL);
+
+  info = g_hash_table_lookup (snapshot->lines, GUINT_TO_POINTER (17));
+  g_assert (info != NULL);
+  g_assert_cmpstr (g_unix_mount_get_mount_path (info->entry), ==, "/home");
+  g_assert_cmpint (snapshot->order->len, ==, 3);
+
+  mountinfo_snapshot_free (snapshot);
+}
+
+#endif
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#ifdef __linux__
+  g_test_add_func ("/unix-mounts/mountinfo-diff", test_mountinfo_diff);
+#endif
+
+  return g_test_run ();
+}
@@ -26,6 +26,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #define DATA "abcdefghijklmnopqrstuvwxyz"
@@ -349,6 +350,503 @@ test_basic (void)
   g_object_unref (os);
 }
 
+#define SPLICE_SIZE (512 * 1024)
+
+static gpointer
+splice_reader_thread (gpointer user_data)
+{
+  GString *received = g_string_new (NULL);
+  int fd = GPOINTER_TO_INT (user_data);
+  gchar buffer[8192];
+  gssize n;
+
+  while ((n = read (fd, buffer, sizeof buffer)) > 0)
+    g_string_append_len (received, buffer, n);
+  g_assert_cmpint (n, ==, 0);
+  close (fd);
+
+  return received;
+}
+
+static void
+splice_file_cb (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  gssize *spliced = user_data;
+  GError *error = NULL;
+
+  *spliced = g_output_stream_splice_finish (G_OUTPUT_STREAM (source), result, &error);
+  g_assert_no_error (error);
+  g_main_loop_quit (loop);
+}
+
+/* Splicing from a file to a pipe goes through the kernel, also with
+ * part of the file read already.
+ */
+static void
+test_splice_file (gconstpointer nonblocking)
+{
+  GFile *file;
+  GFileIOStream *iostream;
+  GInputStream *in;
+  GOutputStream *out;
+  GThread *thread;
+  GString *received;
+  GError *error = NULL;
+  gchar *contents, head[10];
+  gssize spliced;
+  int fds[2];
+  int i;
+
+  contents = g_malloc (SPLICE_SIZE);
+  for (i = 0; i < SPLICE_SIZE; i++)
+    contents[i] = 'a' + (i * 7) % 26;
+
+  file = g_file_new_tmp ("unix-streams-spliceXXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  g_file_replace_contents (file, contents, SPLICE_SIZE, NULL, FALSE,
+                           G_FILE_CREATE_NONE, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  g_assert (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+  g_assert_no_error (error);
+  if (nonblocking)
+    {
+      g_assert (g_unix_set_fd_nonblocking (fds[1], TRUE, &error));
+      g_assert_no_error (error);
+    }
+  thread = g_thread_new ("reader", splice_reader_thread, GINT_TO_POINTER (fds[0]));
+
+  in = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (g_input_stream_read (in, head, sizeof head, NULL, &error), ==, sizeof head);
+  g_assert_no_error (error);
+
+  out = g_unix_output_stream_new (fds[1], TRUE);
+
+  if (nonblocking)
+    {
+      spliced = 0;
+      loop = g_main_loop_new (NULL, FALSE);
+      g_output_stream_splice_async (out, in,
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                    G_PRIORITY_DEFAULT, NULL,
+                                    splice_file_cb, &spliced);
+      g_main_loop_run (loop);
+      g_main_loop_unref (loop);
+    }
+  else
+    {
+      spliced = g_output_stream_splice (out, in,
+                                        G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+                                        G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                        NULL, &error);
+      g_assert_no_error (error);
+    }
+  g_assert_cmpint (spliced, ==, SPLICE_SIZE - sizeof head);
+  g_assert (g_output_stream_is_closed (out));
+
+  received = g_thread_join (thread);
+  g_assert_cmpuint (received->len, ==, SPLICE_SIZE - sizeof head);
+  g_assert (memcmp (received->str, contents + sizeof head, received->len) == 0);
+  g_string_free (received, TRUE);
+
+  g_object_unref (in);
+  g_object_unref (out);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_free (contents);
+}
+
+/* A TLS connection whose backend pretends to hand its records to the
+ * kernel; its own output stream cannot take any data.
+ */
+typedef struct {
+  GTlsConnection parent_instance;
+
+  GIOStream *base_io_stream;
+  GOutputStream *output;
+} OffloadTlsConnection;
+typedef GTlsConnectionClass OffloadTlsConnectionClass;
+
+enum {
+  PROP_OFFLOAD_0,
+  PROP_OFFLOAD_BASE_IO_STREAM,
+  PROP_OFFLOAD_REQUIRE_CLOSE_NOTIFY,
+  PROP_OFFLOAD_REHANDSHAKE_MODE,
+  PROP_OFFLOAD_USE_SYSTEM_CERTDB
+};
+
+static GType offload_tls_connection_get_type (void);
+G_DEFINE_TYPE (OffloadTlsConnection, offload_tls_connection, G_TYPE_TLS_CONNECTION)
+
+static void
+offload_tls_connection_get_property (GObject    *object,
+                                     guint       prop_id,
+                                     GValue     *value,
+                                     GParamSpec *pspec)
+{
+  OffloadTlsConnection *conn = (OffloadTlsConnection *) object;
+
+  if (prop_id == PROP_OFFLOAD_BASE_IO_STREAM)
+    g_value_set_object (value, conn->base_io_stream);
+}
+
+static void
+offload_tls_connection_set_property (GObject      *object,
+                                     guint         prop_id,
+                                     const GValue *value,
+                                     GParamSpec   *pspec)
+{
+  OffloadTlsConnection *conn = (OffloadTlsConnection *) object;
+
+  if (prop_id == PROP_OFFLOAD_BASE_IO_STREAM)
+    conn->base_io_stream = g_value_dup_object (value);
+}
+
+static GInputStream *
+offload_tls_connection_get_input_stream (GIOStream *stream)
+{
+  return g_io_stream_get_input_stream (((OffloadTlsConnection *) stream)->base_io_stream);
+}
+
+static GOutputStream *
+offload_tls_connection_get_output_stream (GIOStream *stream)
+{
+  return ((OffloadTlsConnection *) stream)->output;
+}
+
+static gboolean
+offload_tls_connection_enable_kernel_offload (GTlsConnection  *conn,
+                                              GSocket         *socket,
+                                              GError         **error)
+{
+  return TRUE;
+}
+
+static void
+offload_tls_connection_finalize (GObject *object)
+{
+  OffloadTlsConnection *conn = (OffloadTlsConnection *) object;
+
+  g_object_unref (conn->output);
+  g_object_unref (conn->base_io_stream);
+
+  G_OBJECT_CLASS (offload_tls_connection_parent_class)->finalize (object);
+}
+
+static void
+offload_tls_connection_init (OffloadTlsConnection *conn)
+{
+  conn->output = g_memory_output_stream_new (NULL, 0, NULL, NULL);
+}
+
+static void
+offload_tls_connection_class_init (OffloadTlsConnectionClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+  GIOStreamClass *io_stream_class = G_IO_STREAM_CLASS (class);
+
+  gobject_class->get_property = offload_tls_connection_get_property;
+  gobject_class->set_property = offload_tls_connection_set_property;
+  gobject_class->finalize = offload_tls_connection_finalize;
+  io_stream_class->get_input_stream = offload_tls_connection_get_input_stream;
+  io_stream_class->get_output_stream = offload_tls_connection_get_output_stream;
+  class->enable_kernel_offload = offload_tls_connection_enable_kernel_offload;
+
+  g_object_class_override_property (gobject_class, PROP_OFFLOAD_BASE_IO_STREAM, "base-io-stream");
+  g_object_class_override_property (gobject_class, PROP_OFFLOAD_REQUIRE_CLOSE_NOTIFY, "require-close-notify");
+  g_object_class_override_property (gobject_class, PROP_OFFLOAD_REHANDSHAKE_MODE, "rehandshake-mode");
+  g_object_class_override_property (gobject_class, PROP_OFFLOAD_USE_SYSTEM_CERTDB, "use-system-certdb");
+}
+
+static void
+test_splice_file_tls_offload (void)
+{
+  GTlsConnection *conn;
+  GSocket *socket;
+  GIOStream *base;
+  GFile *file;
+  GFileIOStream *iostream;
+  GInputStream *in;
+  GThread *thread;
+  GString *received;
+  GError *error = NULL;
+  gchar *contents;
+  gssize spliced;
+  int fds[2];
+  int i;
+
+  contents = g_malloc (SPLICE_SIZE);
+  for (i = 0; i < SPLICE_SIZE; i++)
+    contents[i] = 'a' + (i * 7) % 26;
+
+  file = g_file_new_tmp ("unix-streams-spliceXXXXXX", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+  g_file_replace_contents (file, contents, SPLICE_SIZE, NULL, FALSE,
+                           G_FILE_CREATE_NONE, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM, 0, fds), ==, 0);
+  socket = g_socket_new_from_fd (fds[1], &error);
+  g_assert_no_error (error);
+  base = G_IO_STREAM (g_socket_connection_factory_create_connection (socket));
+  conn = g_object_new (offload_tls_connection_get_type (),
+                       "base-io-stream", base,
+                       NULL);
+
+  g_assert (!g_tls_connection_get_kernel_offload (conn));
+  g_assert (g_tls_connection_enable_kernel_offload (conn, &error));
+  g_assert_no_error (error);
+  g_assert (g_tls_connection_get_kernel_offload (conn));
+
+  thread = g_thread_new ("reader", splice_reader_thread, GINT_TO_POINTER (fds[0]));
+
+  /* the data bypasses the TLS output stream, straight to the socket */
+  in = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  g_assert_no_error (error);
+  spliced = g_output_stream_splice (g_io_stream_get_output_stream (G_IO_STREAM (conn)), in,
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE,
+                                    NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (spliced, ==, SPLICE_SIZE);
+
+  g_socket_shutdown (socket, FALSE, TRUE, &error);
+  g_assert_no_error (error);
+  received = g_thread_join (thread);
+  g_assert_cmpuint (received->len, ==, SPLICE_SIZE);
+  g_assert (memcmp (received->str, contents, received->len) == 0);
+  g_string_free (received, TRUE);
+
+  g_object_unref (in);
+  g_object_unref (conn);
+  g_object_unref (base);
+  g_object_unref (socket);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_free (contents);
+}
+
+static void
+writev_cb (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  gsize *written = user_data;
+  GError *error = NULL;
+
+  g_output_stream_writev_all_finish (G_OUTPUT_STREAM (source), result, written, &error);
+  g_assert_no_error (error);
+  g_main_loop_quit (loop);
+}
+
+#define N_WRITEV_VECTORS 1500
+
+/* Many vectors, some of them empty, more than the pipe can take at once */
+static void
+test_writev (gconstpointer nonblocking)
+{
+  GOutputStream *out;
+  GOutputVector vectors[N_WRITEV_VECTORS];
+  GThread *thread;
+  GString *received;
+  GError *error = NULL;
+  gchar *contents;
+  gsize written, offset;
+  int fds[2];
+  int i;
+
+  contents = g_malloc (SPLICE_SIZE);
+  for (i = 0; i < SPLICE_SIZE; i++)
+    contents[i] = 'a' + (i * 7) % 26;
+
+  offset = 0;
+  for (i = 0; i < G_N_ELEMENTS (vectors) - 1; i++)
+    {
+      vectors[i].buffer = contents + offset;
+      vectors[i].size = (i % 3 == 0) ? 0 : i * 17 % 600;
+      offset += vectors[i].size;
+    }
+  g_assert_cmpuint (offset, <, SPLICE_SIZE);
+  vectors[i].buffer = contents + offset;
+  vectors[i].size = SPLICE_SIZE - offset;
+
+  g_assert (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+  g_assert_no_error (error);
+  if (nonblocking)
+    {
+      g_assert (g_unix_set_fd_nonblocking (fds[1], TRUE, &error));
+      g_assert_no_error (error);
+    }
+  thread = g_thread_new ("reader", splice_reader_thread, GINT_TO_POINTER (fds[0]));
+
+  out = g_unix_output_stream_new (fds[1], TRUE);
+
+  if (nonblocking)
+    {
+      written = 0;
+      loop = g_main_loop_new (NULL, FALSE);
+      g_output_stream_writev_all_async (out, vectors, G_N_ELEMENTS (vectors),
+                                        G_PRIORITY_DEFAULT, NULL,
+                                        writev_cb, &written);
+      g_main_loop_run (loop);
+      g_main_loop_unref (loop);
+    }
+  else
+    {
+      g_output_stream_writev_all (out, vectors, G_N_ELEMENTS (vectors),
+                                  &written, NULL, &error);
+      g_assert_no_error (error);
+    }
+  g_assert_cmpuint (written, ==, SPLICE_SIZE);
+
+  g_output_stream_close (out, NULL, &error);
+  g_assert_no_error (error);
+
+  received = g_thread_join (thread);
+  g_assert_cmpuint (received->len, ==, SPLICE_SIZE);
+  g_assert (memcmp (received->str, contents, received->len) == 0);
+  g_string_free (received, TRUE);
+
+  g_object_unref (out);
+  g_free (contents);
+}
+
+typedef struct {
+  GInputVector *vectors;
+  gsize n_vectors;
+  gsize bytes_read;
+} ReadvState;
+
+static gpointer
+readv_writer_thread (gpointer user_data)
+{
+  int fd = GPOINTER_TO_INT (user_data);
+  gchar buffer[SPLICE_SIZE / 16];
+  gssize n;
+  int i, j;
+
+  for (i = 0; i < 16; i++)
+    {
+      for (j = 0; j < sizeof buffer; j++)
+        buffer[j] = 'a' + ((i * sizeof buffer + j) * 7) % 26;
+
+      for (j = 0; j < sizeof buffer; j += n)
+        {
+          n = write (fd, buffer + j, sizeof buffer - j);
+          g_assert_cmpint (n, >, 0);
+        }
+    }
+  close (fd);
+
+  return NULL;
+}
+
+static void
+readv_cb (GObject      *source,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  ReadvState *state = user_data;
+  GError *error = NULL;
+  gsize n_read;
+
+  g_input_stream_readv_finish (G_INPUT_STREAM (source), result, &n_read, &error);
+  g_assert_no_error (error);
+
+  if (n_read == 0)
+    {
+      g_main_loop_quit (loop);
+      return;
+    }
+
+  state->bytes_read += n_read;
+  while (n_read >= state->vectors[0].size)
+    {
+      n_read -= state->vectors[0].size;
+      state->vectors++;
+      state->n_vectors--;
+    }
+  state->vectors[0].buffer = (gchar *) state->vectors[0].buffer + n_read;
+  state->vectors[0].size -= n_read;
+
+  g_input_stream_readv_async (G_INPUT_STREAM (source),
+                              state->vectors, state->n_vectors,
+                              G_PRIORITY_DEFAULT, NULL,
+                              readv_cb, state);
+}
+
+/* Many vectors, some of them empty, and one more than there is data for */
+static void
+test_readv (gconstpointer nonblocking)
+{
+  GInputStream *in;
+  GInputVector vectors[N_WRITEV_VECTORS];
+  GThread *thread;
+  GError *error = NULL;
+  gchar *received;
+  gsize nread, offset;
+  int fds[2];
+  int i;
+
+  received = g_malloc0 (SPLICE_SIZE + 1);
+
+  offset = 0;
+  for (i = 0; i < G_N_ELEMENTS (vectors) - 1; i++)
+    {
+      vectors[i].buffer = received + offset;
+      vectors[i].size = (i % 3 == 0) ? 0 : i * 17 % 600;
+      offset += vectors[i].size;
+    }
+  g_assert_cmpuint (offset, <, SPLICE_SIZE);
+  vectors[i].buffer = received + offset;
+  vectors[i].size = SPLICE_SIZE + 1 - offset;
+
+  g_assert (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+  g_assert_no_error (error);
+  if (nonblocking)
+    {
+      g_assert (g_unix_set_fd_nonblocking (fds[0], TRUE, &error));
+      g_assert_no_error (error);
+    }
+  thread = g_thread_new ("writer", readv_writer_thread, GINT_TO_POINTER (fds[1]));
+
+  in = g_unix_input_stream_new (fds[0], TRUE);
+
+  if (nonblocking)
+    {
+      ReadvState state = { vectors, G_N_ELEMENTS (vectors), 0 };
+
+      loop = g_main_loop_new (NULL, FALSE);
+      g_input_stream_readv_async (in, state.vectors, state.n_vectors,
+                                  G_PRIORITY_DEFAULT, NULL,
+                                  readv_cb, &state);
+      g_main_loop_run (loop);
+      g_main_loop_unref (loop);
+      nread = state.bytes_read;
+    }
+  else
+    {
+      g_input_stream_readv_all (in, vectors, G_N_ELEMENTS (vectors),
+                                &nread, NULL, &error);
+      g_assert_no_error (error);
+    }
+  g_assert_cmpuint (nread, ==, SPLICE_SIZE);
+
+  g_thread_join (thread);
+
+  for (i = 0; i < SPLICE_SIZE; i++)
+    g_assert_cmpint (received[i], ==, 'a' + (i * 7) % 26);
+  g_assert_cmpint (received[SPLICE_SIZE], ==, 0);
+
+  g_object_unref (in);
+  g_free (received);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -362,6 +860,25 @@ main (int   argc,
   g_test_add_data_func ("/unix-streams/nonblocking-io-test",
 			GINT_TO_POINTER (TRUE),
 			test_pipe_io);
+  g_test_add_data_func ("/unix-streams/splice-file",
+			GINT_TO_POINTER (FALSE),
+			test_splice_file);
+  g_test_add_data_func ("/unix-streams/splice-file-async",
+			GINT_TO_POINTER (TRUE),
+			test_splice_file);
+  g_test_add_func ("/unix-streams/splice-file-tls-offload", test_splice_file_tls_offload);
+  g_test_add_data_func ("/unix-streams/writev",
+			GINT_TO_POINTER (FALSE),
+			test_writev);
+  g_test_add_data_func ("/unix-streams/writev-async",
+			GINT_TO_POINTER (TRUE),
+			test_writev);
+  g_test_add_data_func ("/unix-streams/readv",
+			GINT_TO_POINTER (FALSE),
+			test_readv);
+  g_test_add_data_func ("/unix-streams/readv-async",
+			GINT_TO_POINTER (TRUE),
+			test_readv);
 
   return g_test_run();
 }
@@ -0,0 +1,237 @@
+/* GLib testing framework examples and tests
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <gio/gio.h>
+#include <string.h>
+
+/* writes @value through @stream one item at a time */
+static void
+write_value (GVariantOutputStream *stream,
+             GVariant             *value)
+{
+  GError *error = NULL;
+
+  if (g_variant_is_container (value))
+    {
+      GVariantIter iter;
+      GVariant *child;
+
+      g_variant_output_stream_open_container (stream, g_variant_get_type (value),
+                                              NULL, &error);
+      g_assert_no_error (error);
+
+      g_variant_iter_init (&iter, value);
+      while ((child = g_variant_iter_next_value (&iter)))
+        {
+          write_value (stream, child);
+          g_variant_unref (child);
+        }
+
+      g_variant_output_stream_close_container (stream, NULL, &error);
+      g_assert_no_error (error);
+    }
+  else
+    {
+      g_variant_output_stream_put_value (stream, value, NULL, &error);
+      g_assert_no_error (error);
+    }
+}
+
+static void
+assert_written (GOutputStream *base,
+                gconstpointer  expected,
+                gsize          expected_size)
+{
+  GBytes *bytes;
+
+  g_output_stream_close (base, NULL, NULL);
+  bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (base));
+  g_assert_cmpuint (g_bytes_get_size (bytes), ==, expected_size);
+  g_assert (memcmp (g_bytes_get_data (bytes, NULL), expected, expected_size) == 0);
+  g_bytes_unref (bytes);
+}
+
+static void
+check_value (GVariant *value)
+{
+  GVariantOutputStream *stream;
+  GOutputStream *base;
+
+  g_variant_ref_sink (value);
+
+  base = g_memory_output_stream_new_resizable ();
+  stream = g_variant_output_stream_new (base);
+  write_value (stream, value);
+  g_object_unref (stream);
+
+  assert_written (base, g_variant_get_data (value), g_variant_get_size (value));
+  g_object_unref (base);
+
+  g_variant_unref (value);
+}
+
+static void
+test_containers (void)
+{
+  const gchar *values[] = {
+    "@a(sxay) [('a', 1, b'xyz'), ('hello', -5, b'')]",
+    "@a{sv} {'x': <1>, 'y': <('a', @ay [])>}",
+    "()",
+    "@a() [(), ()]",
+    "(1, 'x', true)",
+    "@(yqt) (1, 2, 3)",
+    "@(ysyt) (1, 'a', 2, 3)",
+    "@ms nothing",
+    "@ms 'x'",
+    "@mi 5",
+    "@maai [[1], []]",
+    "<<'x'>>",
+    "@aas [[], ['a'], ['bc', 'd']]",
+    "@a{yd} {1: 1.5, 2: 2.5}",
+    "@av []"
+  };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      GError *error = NULL;
+      GVariant *value;
+
+      value = g_variant_parse (NULL, values[i], NULL, NULL, &error);
+      g_assert_no_error (error);
+      check_value (value);
+    }
+}
+
+static void
+test_large_offsets (void)
+{
+  GVariantBuilder builder;
+  gint i;
+
+  /* enough data to need 2 and then 4 byte framing offsets */
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+  for (i = 0; i < 300; i++)
+    g_variant_builder_add (&builder, "s", "item");
+  check_value (g_variant_builder_end (&builder));
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(si)"));
+  for (i = 0; i < 10000; i++)
+    g_variant_builder_add (&builder, "(si)", "item", i);
+  check_value (g_variant_builder_end (&builder));
+}
+
+static void
+test_array_data (void)
+{
+  GVariantOutputStream *stream;
+  GVariantBuilder builder;
+  GOutputStream *base;
+  GError *error = NULL;
+  GVariant *expected;
+  guchar *data;
+  gint i;
+
+  data = g_malloc (10000);
+  for (i = 0; i < 10000; i++)
+    data[i] = i;
+
+  base = g_memory_output_stream_new_resizable ();
+  stream = g_variant_output_stream_new (base);
+
+  g_variant_output_stream_open_container (stream, G_VARIANT_TYPE ("a(sxay)"), NULL, &error);
+  g_assert_no_error (error);
+  g_variant_output_stream_open_container (stream, G_VARIANT_TYPE ("(sxay)"), NULL, &error);
+  g_assert_no_error (error);
+  g_variant_output_stream_put_value (stream, g_variant_new_string ("blob"), NULL, &error);
+  g_assert_no_error (error);
+  g_variant_output_stream_put_value (stream, g_variant_new_int64 (10000), NULL, &error);
+  g_assert_no_error (error);
+  g_variant_output_stream_open_container (stream, G_VARIANT_TYPE_BYTESTRING, NULL, &error);
+  g_assert_no_error (error);
+  for (i = 0; i < 10; i++)
+    {
+      g_variant_output_stream_put_array_data (stream, data + i * 1000, 1000, NULL, &error);
+      g_assert_no_error (error);
+    }
+  g_variant_output_stream_close_container (stream, NULL, &error);
+  g_assert_no_error (error);
+  g_variant_output_stream_close_container (stream, NULL, &error);
+  g_assert_no_error (error);
+  g_variant_output_stream_close_container (stream, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (stream);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sxay)"));
+  g_variant_builder_add (&builder, "(sx@ay)", "blob", (gint64) 10000,
+                         g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                                    data, 10000, 1));
+  expected = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  assert_written (base, g_variant_get_data (expected), g_variant_get_size (expected));
+  g_variant_unref (expected);
+  g_object_unref (base);
+  g_free (data);
+}
+
+static void
+test_consecutive (void)
+{
+  GVariantOutputStream *stream;
+  GOutputStream *base;
+  GError *error = NULL;
+  GVariant *first, *second;
+  GString *expected;
+
+  first = g_variant_ref_sink (g_variant_new_bytestring ("abc"));
+  second = g_variant_ref_sink (g_variant_new ("(ix)", 1, (gint64) 2));
+
+  base = g_memory_output_stream_new_resizable ();
+  stream = g_variant_output_stream_new (base);
+  g_variant_output_stream_put_value (stream, first, NULL, &error);
+  g_assert_no_error (error);
+  write_value (stream, second);
+  g_object_unref (stream);
+
+  /* each value is aligned relative to its own start */
+  expected = g_string_new (NULL);
+  g_string_append_len (expected, g_variant_get_data (first), g_variant_get_size (first));
+  g_string_append_len (expected, g_variant_get_data (second), g_variant_get_size (second));
+  assert_written (base, expected->str, expected->len);
+
+  g_string_free (expected, TRUE);
+  g_variant_unref (first);
+  g_variant_unref (second);
+  g_object_unref (base);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/variant-output-stream/containers", test_containers);
+  g_test_add_func ("/variant-output-stream/large-offsets", test_large_offsets);
+  g_test_add_func ("/variant-output-stream/array-data", test_array_data);
+  g_test_add_func ("/variant-output-stream/consecutive", test_consecutive);
+
+  return g_test_run();
+}
@@ -49,6 +49,9 @@
 #define	TRUE	(!FALSE)
 #endif
 
+/* Number of buckets in the literal glob hash */
+#define XDG_GLOB_LITERAL_BUCKETS 256
+
 typedef struct XdgGlobHashNode XdgGlobHashNode;
 typedef struct XdgGlobList XdgGlobList;
 
@@ -68,6 +71,15 @@ struct XdgGlobList
   int weight;
   int case_sensitive;
   XdgGlobList *next;
+
+  /* Index chain; entries of one bucket are kept in append order */
+  XdgGlobList *index_next;
+  unsigned int serial;
+  /* Full globs: length of the literal text before the first and after
+   * the last wildcard.  Any matching file name starts and ends with it.
+   */
+  int prefix_len;
+  int suffix_len;
 };
 
 struct XdgGlobHash
@@ -75,6 +87,16 @@ struct XdgGlobHash
   XdgGlobList *literal_list;
   XdgGlobHashNode *simple_node;
   XdgGlobList *full_list;
+
+  /* Literals hashed by name, full globs by the first byte of their
+   * literal prefix, or failing that the last byte of their literal
+   * suffix.  Full globs with neither go on full_unanchored.
+   */
+  XdgGlobList *literal_index[XDG_GLOB_LITERAL_BUCKETS];
+  XdgGlobList *full_prefix_index[256];
+  XdgGlobList *full_suffix_index[256];
+  XdgGlobList *full_unanchored;
+  unsigned int n_full;
 };
 
 
@@ -112,24 +134,25 @@ _xdg_glob_list_free (XdgGlobList *glob_list)
     }
 }
 
+/* Returns the new element, or NULL if glob_list already has this glob */
 static XdgGlobList *
-_xdg_glob_list_append (XdgGlobList *glob_list,
-		       void        *data,
-		       const char  *mime_type,
-		       int          weight,
-		       int          case_sensitive)
+_xdg_glob_list_append (XdgGlobList **glob_list,
+		       void         *data,
+		       const char   *mime_type,
+		       int           weight,
+		       int           case_sensitive)
 {
   XdgGlobList *new_element;
-  XdgGlobList *tmp_element;
+  XdgGlobList **tmp_element;
 
   tmp_element = glob_list;
-  while (tmp_element != NULL)
+  while (*tmp_element != NULL)
     {
-      if (strcmp (tmp_element->data, data) == 0 &&
-	  strcmp (tmp_element->mime_type, mime_type) == 0)
-	return glob_list;
+      if (strcmp ((*tmp_element)->data, data) == 0 &&
+	  strcmp ((*tmp_element)->mime_type, mime_type) == 0)
+	return NULL;
 
-      tmp_element = tmp_element->next;
+      tmp_element = &(*tmp_element)->next;
     }
 
   new_element = _xdg_glob_list_new ();
@@ -137,16 +160,58 @@ _xdg_glob_list_append (XdgGlobList *glob_list,
   new_element->mime_type = mime_type;
   new_element->weight = weight;
   new_element->case_sensitive = case_sensitive;
-  if (glob_list == NULL)
-    return new_element;
+  *tmp_element = new_element;
 
-  tmp_element = glob_list;
-  while (tmp_element->next != NULL)
-    tmp_element = tmp_element->next;
+  return new_element;
+}
 
-  tmp_element->next = new_element;
+static void
+_xdg_glob_index_append (XdgGlobList **bucket,
+			XdgGlobList  *element)
+{
+  while (*bucket != NULL)
+    bucket = &(*bucket)->index_next;
 
-  return glob_list;
+  *bucket = element;
+}
+
+/* Removes and returns the earliest appended entry at the heads of
+ * the index chains in lists.
+ */
+static XdgGlobList *
+_xdg_glob_index_pop_first (XdgGlobList *lists[],
+			   int          n_lists)
+{
+  XdgGlobList *first;
+  int i, first_i;
+
+  first_i = -1;
+  for (i = 0; i < n_lists; i++)
+    {
+      if (lists[i] != NULL &&
+	  (first_i < 0 || lists[i]->serial < lists[first_i]->serial))
+	first_i = i;
+    }
+
+  if (first_i < 0)
+    return NULL;
+
+  first = lists[first_i];
+  lists[first_i] = first->index_next;
+
+  return first;
+}
+
+static unsigned int
+_xdg_glob_literal_hash (const char *str)
+{
+  const unsigned char *p;
+  unsigned int h = 5381;
+
+  for (p = (const unsigned char *) str; *p != 0; p++)
+    h = (h << 5) + h + *p;
+
+  return h % XDG_GLOB_LITERAL_BUCKETS;
 }
 
 /* XdgGlobHashNode
@@ -443,6 +508,7 @@ _xdg_glob_hash_lookup_file_name (XdgGlobHash *glob_hash,
 				 int          n_mime_types)
 {
   XdgGlobList *list;
+  XdgGlobList *full_lists[3];
   int i, n;
   MimeWeight mimes[10];
   int n_mimes = 10;
@@ -457,7 +523,8 @@ _xdg_glob_hash_lookup_file_name (XdgGlobHash *glob_hash,
 
   lower_case = ascii_tolower (file_name);
 
-  for (list = glob_hash->literal_list; list; list = list->next)
+  for (list = glob_hash->literal_index[_xdg_glob_literal_hash (file_name)];
+       list; list = list->index_next)
     {
       if (strcmp ((const char *)list->data, file_name) == 0)
 	{
@@ -467,7 +534,8 @@ _xdg_glob_hash_lookup_file_name (XdgGlobHash *glob_hash,
 	}
     }
 
-  for (list = glob_hash->literal_list; list; list = list->next)
+  for (list = glob_hash->literal_index[_xdg_glob_literal_hash (lower_case)];
+       list; list = list->index_next)
     {
       if (!list->case_sensitive &&
 	  strcmp ((const char *)list->data, lower_case) == 0)
@@ -486,11 +554,27 @@ _xdg_glob_hash_lookup_file_name (XdgGlobHash *glob_hash,
     n += _xdg_glob_hash_node_lookup_file_name (glob_hash->simple_node, file_name, len, TRUE,
 					       mimes + n, n_mimes - n);
 
-  if (n < 2)
+  if (n < 2 && len > 0)
     {
-      for (list = glob_hash->full_list; list && n < n_mime_types; list = list->next)
+      /* Only full globs whose literal prefix or suffix could match are
+       * candidates; visit them in the order they were appended.
+       */
+      full_lists[0] = glob_hash->full_prefix_index[(unsigned char) file_name[0]];
+      full_lists[1] = glob_hash->full_suffix_index[(unsigned char) file_name[len - 1]];
+      full_lists[2] = glob_hash->full_unanchored;
+
+      while (n < n_mime_types &&
+	     (list = _xdg_glob_index_pop_first (full_lists, 3)) != NULL)
         {
-          if (fnmatch ((const char *)list->data, file_name, 0) == 0)
+	  const char *glob = list->data;
+
+	  if (len < list->prefix_len + list->suffix_len ||
+	      strncmp (glob, file_name, list->prefix_len) != 0 ||
+	      strncmp (glob + strlen (glob) - list->suffix_len,
+		       file_name + len - list->suffix_len, list->suffix_len) != 0)
+	    continue;
+
+          if (fnmatch (glob, file_name, 0) == 0)
 	    {
 	      mimes[n].mime = list->mime_type;
 	      mimes[n].weight = list->weight;
@@ -587,6 +671,9 @@ _xdg_glob_hash_append_glob (XdgGlobHash *glob_hash,
 			    int          case_sensitive)
 {
   XdgGlobType type;
+  XdgGlobList *element;
+  const char *ptr, *suffix;
+  int len;
 
   assert (glob_hash != NULL);
   assert (glob != NULL);
@@ -596,13 +683,38 @@ _xdg_glob_hash_append_glob (XdgGlobHash *glob_hash,
   switch (type)
     {
     case XDG_GLOB_LITERAL:
-      glob_hash->literal_list = _xdg_glob_list_append (glob_hash->literal_list, strdup (glob), strdup (mime_type), weight, case_sensitive);
+      element = _xdg_glob_list_append (&glob_hash->literal_list, strdup (glob), strdup (mime_type), weight, case_sensitive);
+      if (element)
+	_xdg_glob_index_append (&glob_hash->literal_index[_xdg_glob_literal_hash (glob)], element);
       break;
     case XDG_GLOB_SIMPLE:
       glob_hash->simple_node = _xdg_glob_hash_insert_text (glob_hash->simple_node, glob + 1, mime_type, weight, case_sensitive);
       break;
     case XDG_GLOB_FULL:
-      glob_hash->full_list = _xdg_glob_list_append (glob_hash->full_list, strdup (glob), strdup (mime_type), weight, case_sensitive);
+      element = _xdg_glob_list_append (&glob_hash->full_list, strdup (glob), strdup (mime_type), weight, case_sensitive);
+      if (element == NULL)
+	break;
+
+      /* The suffix starts after the last character that may belong to
+       * a wildcard, which is conservative for stray brackets.
+       */
+      len = strlen (glob);
+      element->prefix_len = strcspn (glob, "\\[?*");
+      suffix = glob + element->prefix_len;
+      for (ptr = suffix; *ptr != '\0'; ptr++)
+	{
+	  if (*ptr == '\\' || *ptr == '[' || *ptr == ']' || *ptr == '?' || *ptr == '*')
+	    suffix = ptr + 1;
+	}
+      element->suffix_len = glob + len - suffix;
+      element->serial = glob_hash->n_full++;
+
+      if (element->prefix_len > 0)
+	_xdg_glob_index_append (&glob_hash->full_prefix_index[(unsigned char) glob[0]], element);
+      else if (element->suffix_len > 0)
+	_xdg_glob_index_append (&glob_hash->full_suffix_index[(unsigned char) glob[len - 1]], element);
+      else
+	_xdg_glob_index_append (&glob_hash->full_unanchored, element);
       break;
     }
 }
@@ -0,0 +1,393 @@
+/* GLIB - Library of useful routines for C programming
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "garena.h"
+
+#include "gmem.h"
+#include "gmessages.h"
+
+/**
+ * SECTION:arenas
+ * @title: Memory Arenas
+ * @short_description: fast allocation of memory that is freed all at once
+ *
+ * A #GArena hands out memory from large blocks by simply moving a
+ * pointer forward, which is much cheaper than g_malloc() or
+ * g_slice_alloc(). Individual allocations are never freed: instead,
+ * all of them are released together by g_arena_reset() or
+ * g_arena_free().
+ *
+ * This suits code that builds up lots of small temporary structures
+ * which all go away at the same time, such as the data made while
+ * handling a single request or parsing a single document.
+ * g_arena_reset() takes constant time and keeps the blocks around, so
+ * that an arena can be reused without going back to the system
+ * allocator.
+ *
+ * #GPtrArray and #GHashTable can also keep their storage in an arena,
+ * see g_ptr_array_new_in_arena() and g_hash_table_new_in_arena().
+ * Freeing such a container is then almost free, and it may even be
+ * left to the arena if it has no destroy notifiers to run.
+ *
+ * A #GArena is not thread safe: it must not be used from several
+ * threads at the same time without locking.
+ */
+
+/**
+ * GArena:
+ *
+ * An opaque data structure representing a memory arena.
+ * It should only be accessed by using the following functions.
+ *
+ * Since: 2.40
+ */
+
+typedef struct _GArenaBlock GArenaBlock;
+
+struct _GArenaBlock
+{
+  GArenaBlock *next;
+  gsize        size;            /* usable bytes after the header */
+};
+
+struct _GArena
+{
+  GArenaBlock *blocks;          /* all blocks in use, newest first */
+  GArenaBlock *last_block;      /* so that they can be released in O(1) */
+  GArenaBlock *free_blocks;     /* kept by g_arena_reset() */
+  guint8      *next;            /* bump pointer into the current block */
+  guint8      *end;
+  guint8      *last_alloc;      /* the last allocation from [next, end) */
+  gsize        block_size;
+};
+
+#define ARENA_ALIGNMENT         (2 * sizeof (gsize))
+#define ARENA_ALIGN(size)       (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+#define ARENA_BLOCK_HEADER      ARENA_ALIGN (sizeof (GArenaBlock))
+#define ARENA_BLOCK_DATA(block) (((guint8 *) (block)) + ARENA_BLOCK_HEADER)
+#define ARENA_MIN_BLOCK_SIZE    (256)
+
+static void
+arena_blocks_free (GArenaBlock *block)
+{
+  while (block)
+    {
+      GArenaBlock *next = block->next;
+
+      g_free (block);
+      block = next;
+    }
+}
+
+static void
+arena_push_block (GArena      *arena,
+                  GArenaBlock *block)
+{
+  block->next = arena->blocks;
+  arena->blocks = block;
+  if (arena->last_block == NULL)
+    arena->last_block = block;
+}
+
+/* A block with at least @size usable bytes, reusing a block from
+ * before the last reset if its size is right.
+ */
+static GArenaBlock *
+arena_get_block (GArena *arena,
+                 gsize   size)
+{
+  GArenaBlock *block = arena->free_blocks;
+
+  if (block != NULL && block->size >= size)
+    arena->free_blocks = block->next;
+  else
+    {
+      if (G_UNLIKELY (size > G_MAXSIZE - ARENA_BLOCK_HEADER))
+        g_error ("%s: failed to allocate %"G_GSIZE_FORMAT" bytes", G_STRLOC, size);
+
+      block = g_malloc (ARENA_BLOCK_HEADER + size);
+      block->size = size;
+    }
+
+  return block;
+}
+
+/**
+ * g_arena_new:
+ * @block_size: the size of the blocks of memory which are allocated
+ *     to take allocations from, or 0 to use the default. Allocations
+ *     that are large compared to it get a block of their own.
+ *
+ * Creates a new #GArena. No memory is allocated until the first call
+ * to g_arena_alloc().
+ *
+ * Returns: a new #GArena, free it with g_arena_free()
+ *
+ * Since: 2.40
+ */
+GArena *
+g_arena_new (gsize block_size)
+{
+  GArena *arena = g_new0 (GArena, 1);
+
+  if (block_size == 0)
+    block_size = 4096 - ARENA_BLOCK_HEADER;
+
+  arena->block_size = ARENA_ALIGN (MAX (block_size, ARENA_MIN_BLOCK_SIZE));
+
+  return arena;
+}
+
+/**
+ * g_arena_free:
+ * @arena: a #GArena
+ *
+ * Frees all memory allocated from @arena, and @arena itself.
+ *
+ * Since: 2.40
+ */
+void
+g_arena_free (GArena *arena)
+{
+  g_return_if_fail (arena != NULL);
+
+  arena_blocks_free (arena->blocks);
+  arena_blocks_free (arena->free_blocks);
+  g_free (arena);
+}
+
+/**
+ * g_arena_reset:
+ * @arena: a #GArena
+ *
+ * Releases all memory allocated from @arena at once, so that it can
+ * be handed out again. This takes constant time: the blocks are kept
+ * for reuse instead of being returned to the system, use
+ * g_arena_free() for that.
+ *
+ * Any containers that were created in @arena must not be used anymore
+ * after this. Their destroy notifiers will not be called.
+ *
+ * Since: 2.40
+ */
+void
+g_arena_reset (GArena *arena)
+{
+  g_return_if_fail (arena != NULL);
+
+  if (arena->blocks != NULL)
+    {
+      arena->last_block->next = arena->free_blocks;
+      arena->free_blocks = arena->blocks;
+      arena->blocks = NULL;
+      arena->last_block = NULL;
+    }
+
+  arena->next = NULL;
+  arena->end = NULL;
+  arena->last_alloc = NULL;
+}
+
+/**
+ * g_arena_alloc:
+ * @arena: a #GArena
+ * @size: the number of bytes to allocate
+ *
+ * Allocates @size bytes from @arena. The memory is aligned like the
+ * memory returned by g_malloc(), and stays valid until @arena is
+ * reset or freed. It can not be freed on its own.
+ *
+ * If @size is 0 it returns %NULL.
+ *
+ * Returns: a pointer to the allocated memory
+ *
+ * Since: 2.40
+ */
+gpointer
+g_arena_alloc (GArena *arena,
+               gsize   size)
+{
+  GArenaBlock *block;
+  guint8 *mem;
+
+  g_return_val_if_fail (arena != NULL, NULL);
+
+  if (G_UNLIKELY (size == 0))
+    return NULL;
+
+  if (G_LIKELY (size <= (gsize) (arena->end - arena->next)))
+    {
+      mem = arena->next;
+      arena->next = MIN (mem + ARENA_ALIGN (size), arena->end);
+      arena->last_alloc = mem;
+
+      return mem;
+    }
+
+  if (size > arena->block_size / 4)
+    {
+      /* large allocations get their own block, and leave the current
+       * one alone so that its remaining space does not go to waste
+       */
+      block = arena_get_block (arena, size);
+      if (arena->blocks != NULL)
+        {
+          block->next = arena->blocks->next;
+          arena->blocks->next = block;
+          if (arena->last_block == arena->blocks)
+            arena->last_block = block;
+        }
+      else
+        arena_push_block (arena, block);
+
+      return ARENA_BLOCK_DATA (block);
+    }
+
+  block = arena_get_block (arena, arena->block_size);
+  arena_push_block (arena, block);
+
+  mem = ARENA_BLOCK_DATA (block);
+  arena->end = mem + block->size;
+  arena->next = mem + ARENA_ALIGN (size);
+  arena->last_alloc = mem;
+
+  return mem;
+}
+
+/**
+ * g_arena_alloc0:
+ * @arena: a #GArena
+ * @size: the number of bytes to allocate
+ *
+ * Allocates @size bytes from @arena, like g_arena_alloc(), and
+ * initializes them to 0.
+ *
+ * Returns: a pointer to the allocated memory
+ *
+ * Since: 2.40
+ */
+gpointer
+g_arena_alloc0 (GArena *arena,
+                gsize   size)
+{
+  gpointer mem = g_arena_alloc (arena, size);
+
+  if (mem)
+    memset (mem, 0, size);
+
+  return mem;
+}
+
+/**
+ * g_arena_realloc:
+ * @arena: a #GArena
+ * @mem: (allow-none): memory allocated from @arena, or %NULL
+ * @old_size: the size @mem was allocated with
+ * @new_size: the new size
+ *
+ * Changes the size of memory allocated from @arena. If @mem was the
+ * last allocation made, it is grown in place when there is room for
+ * it. Otherwise @new_size bytes are allocated and the contents of
+ * @mem are copied over; the old memory is not reused until @arena is
+ * reset.
+ *
+ * Returns: the new address of the memory
+ *
+ * Since: 2.40
+ */
+gpointer
+g_arena_realloc (GArena   *arena,
+                 gpointer  mem,
+                 gsize     old_size,
+                 gsize     new_size)
+{
+  gpointer new_mem;
+
+  g_return_val_if_fail (arena != NULL, NULL);
+
+  if (mem == NULL)
+    return g_arena_alloc (arena, new_size);
+
+  if (new_size <= old_size)
+    return mem;
+
+  if (mem == arena->last_alloc &&
+      new_size <= (gsize) (arena->end - arena->last_alloc))
+    {
+      arena->next = MIN (arena->last_alloc + ARENA_ALIGN (new_size), arena->end);
+
+      return mem;
+    }
+
+  new_mem = g_arena_alloc (arena, new_size);
+  memcpy (new_mem, mem, old_size);
+
+  return new_mem;
+}
+
+/**
+ * g_arena_dup:
+ * @arena: a #GArena
+ * @mem: the memory to copy
+ * @size: the number of bytes to copy
+ *
+ * Allocates @size bytes from @arena and copies @size bytes from @mem
+ * into them.
+ *
+ * Returns: a pointer to the copy, or %NULL if @size is 0
+ *
+ * Since: 2.40
+ */
+gpointer
+g_arena_dup (GArena        *arena,
+             gconstpointer  mem,
+             gsize          size)
+{
+  gpointer new_mem = g_arena_alloc (arena, size);
+
+  if (new_mem)
+    memcpy (new_mem, mem, size);
+
+  return new_mem;
+}
+
+/**
+ * g_arena_strdup:
+ * @arena: a #GArena
+ * @str: (allow-none): the string to copy
+ *
+ * Copies a nul-terminated string into @arena.
+ * See also g_string_chunk_insert().
+ *
+ * Returns: the copy of @str, or %NULL if @str is %NULL
+ *
+ * Since: 2.40
+ */
+gchar *
+g_arena_strdup (GArena      *arena,
+                const gchar *str)
+{
+  if (str == NULL)
+    return NULL;
+
+  return g_arena_dup (arena, str, strlen (str) + 1);
+}
@@ -0,0 +1,59 @@
+/* GLIB - Library of useful routines for C programming
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_ARENA_H__
+#define __G_ARENA_H__
+
+#if !defined (__GLIB_H_INSIDE__) && !defined (GLIB_COMPILATION)
+#error "Only <glib.h> can be included directly."
+#endif
+
+#include <glib/gtypes.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GArena GArena;
+
+GLIB_AVAILABLE_IN_2_40
+GArena*   g_arena_new     (gsize          block_size);
+GLIB_AVAILABLE_IN_2_40
+void      g_arena_free    (GArena        *arena);
+GLIB_AVAILABLE_IN_2_40
+void      g_arena_reset   (GArena        *arena);
+GLIB_AVAILABLE_IN_2_40
+gpointer  g_arena_alloc   (GArena        *arena,
+                           gsize          size) G_GNUC_MALLOC G_GNUC_ALLOC_SIZE(2);
+GLIB_AVAILABLE_IN_2_40
+gpointer  g_arena_alloc0  (GArena        *arena,
+                           gsize          size) G_GNUC_MALLOC G_GNUC_ALLOC_SIZE(2);
+GLIB_AVAILABLE_IN_2_40
+gpointer  g_arena_realloc (GArena        *arena,
+                           gpointer       mem,
+                           gsize          old_size,
+                           gsize          new_size) G_GNUC_WARN_UNUSED_RESULT;
+GLIB_AVAILABLE_IN_2_40
+gpointer  g_arena_dup     (GArena        *arena,
+                           gconstpointer  mem,
+                           gsize          size);
+GLIB_AVAILABLE_IN_2_40
+gchar*    g_arena_strdup  (GArena        *arena,
+                           const gchar   *str);
+
+G_END_DECLS
+
+#endif /* __G_ARENA_H__ */
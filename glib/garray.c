@@ -40,6 +40,7 @@
 #include "gmem.h"
 #include "gtestutils.h"
 #include "gthread.h"
+#include "gthreadpool.h"
 #include "gmessages.h"
 #include "gqsort.h"
 
@@ -725,6 +726,193 @@ g_array_sort (GArray       *farray,
 		     NULL);
 }
 
+/* Parallel sorting: the array is cut into one chunk per processor
+ * (rounded down to a power of 2), the chunks are sorted concurrently
+ * with g_qsort_with_data(), and then merged pairwise, again
+ * concurrently, until one run is left.  Merging takes the left
+ * element on ties, so the result is stable just like the serial sort.
+ */
+
+/* Below this many elements, the thread handoffs cost more than
+ * sorting serially.
+ */
+#define PARALLEL_SORT_THRESHOLD 65536
+
+typedef struct
+{
+  gsize             elt_size;
+  GCompareDataFunc  compare_func;
+  gpointer          user_data;
+
+  GMutex            mutex;
+  GCond             cond;
+  guint             pending;
+} ParallelSort;
+
+typedef struct
+{
+  ParallelSort *sort;
+  gchar        *src;  /* two adjacent runs to merge, or one to sort */
+  gchar        *dest; /* where to merge to, or %NULL to sort @src */
+  gsize         n1;
+  gsize         n2;
+} ParallelSortTask;
+
+static void
+parallel_sort_merge (ParallelSort *sort,
+                     gchar        *src,
+                     gchar        *dest,
+                     gsize         n1,
+                     gsize         n2)
+{
+  const gsize s = sort->elt_size;
+  gchar *b1 = src;
+  gchar *b2 = src + n1 * s;
+
+  /* the runs are already in order */
+  if (sort->compare_func (b2 - s, b2, sort->user_data) <= 0)
+    {
+      memcpy (dest, src, (n1 + n2) * s);
+      return;
+    }
+
+  while (n1 > 0 && n2 > 0)
+    {
+      if (sort->compare_func (b1, b2, sort->user_data) <= 0)
+        {
+          memcpy (dest, b1, s);
+          b1 += s;
+          n1--;
+        }
+      else
+        {
+          memcpy (dest, b2, s);
+          b2 += s;
+          n2--;
+        }
+      dest += s;
+    }
+
+  memcpy (dest, b1, n1 * s);
+  memcpy (dest + n1 * s, b2, n2 * s);
+}
+
+static void
+parallel_sort_task (gpointer data,
+                    gpointer user_data)
+{
+  ParallelSortTask *task = data;
+  ParallelSort *sort = task->sort;
+
+  if (task->dest)
+    parallel_sort_merge (sort, task->src, task->dest, task->n1, task->n2);
+  else
+    g_qsort_with_data (task->src, task->n1, sort->elt_size,
+                       sort->compare_func, sort->user_data);
+
+  g_mutex_lock (&sort->mutex);
+  if (--sort->pending == 0)
+    g_cond_signal (&sort->cond);
+  g_mutex_unlock (&sort->mutex);
+}
+
+static void
+parallel_sort_run (ParallelSort     *sort,
+                   GThreadPool      *pool,
+                   ParallelSortTask *tasks,
+                   guint             n_tasks)
+{
+  guint i;
+
+  sort->pending = n_tasks;
+  for (i = 0; i < n_tasks; i++)
+    g_thread_pool_push (pool, &tasks[i], NULL);
+
+  g_mutex_lock (&sort->mutex);
+  while (sort->pending > 0)
+    g_cond_wait (&sort->cond, &sort->mutex);
+  g_mutex_unlock (&sort->mutex);
+}
+
+static void
+parallel_sort (gpointer          data,
+               gsize             len,
+               gsize             elt_size,
+               GCompareDataFunc  compare_func,
+               gpointer          user_data)
+{
+  ParallelSort sort;
+  ParallelSortTask *tasks;
+  GThreadPool *pool;
+  gchar *src, *dest, *tmp;
+  gsize *bounds;
+  guint n_runs, n_procs, i;
+
+  n_procs = g_get_num_processors ();
+  if (len < PARALLEL_SORT_THRESHOLD || n_procs < 2)
+    {
+      g_qsort_with_data (data, len, elt_size, compare_func, user_data);
+      return;
+    }
+
+  for (n_runs = 1; n_runs * 2 <= n_procs; n_runs *= 2);
+
+  sort.elt_size = elt_size;
+  sort.compare_func = compare_func;
+  sort.user_data = user_data;
+  g_mutex_init (&sort.mutex);
+  g_cond_init (&sort.cond);
+
+  pool = g_thread_pool_new (parallel_sort_task, NULL, n_runs, FALSE, NULL);
+  tasks = g_new (ParallelSortTask, n_runs);
+
+  /* bounds[i] is the index of the first element of run i */
+  bounds = g_new (gsize, n_runs + 1);
+  for (i = 0; i <= n_runs; i++)
+    bounds[i] = len * i / n_runs;
+
+  for (i = 0; i < n_runs; i++)
+    {
+      tasks[i].sort = &sort;
+      tasks[i].src = (gchar *) data + bounds[i] * elt_size;
+      tasks[i].dest = NULL;
+      tasks[i].n1 = bounds[i + 1] - bounds[i];
+      tasks[i].n2 = 0;
+    }
+  parallel_sort_run (&sort, pool, tasks, n_runs);
+
+  src = data;
+  dest = tmp = g_malloc (len * elt_size);
+
+  for (; n_runs > 1; n_runs /= 2)
+    {
+      for (i = 0; i < n_runs / 2; i++)
+        {
+          tasks[i].src = src + bounds[2 * i] * elt_size;
+          tasks[i].dest = dest + bounds[2 * i] * elt_size;
+          tasks[i].n1 = bounds[2 * i + 1] - bounds[2 * i];
+          tasks[i].n2 = bounds[2 * i + 2] - bounds[2 * i + 1];
+        }
+      parallel_sort_run (&sort, pool, tasks, n_runs / 2);
+
+      for (i = 0; i <= n_runs / 2; i++)
+        bounds[i] = bounds[2 * i];
+
+      src = dest;
+      dest = (src == tmp) ? data : tmp;
+    }
+
+  if (src != data)
+    memcpy (data, src, len * elt_size);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_free (bounds);
+  g_free (tasks);
+  g_free (tmp);
+  g_mutex_clear (&sort.mutex);
+  g_cond_clear (&sort.cond);
+}
+
 /**
  * g_array_sort_with_data:
  * @array: a #GArray.
@@ -756,6 +944,34 @@ g_array_sort_with_data (GArray           *farray,
 		     user_data);
 }
 
+/**
+ * g_array_sort_parallel:
+ * @array: a #GArray.
+ * @compare_func: comparison function.
+ * @user_data: data to pass to @compare_func.
+ *
+ * Like g_array_sort_with_data(), but large arrays are sorted using
+ * several threads.  @compare_func must therefore be safe to call from
+ * multiple threads at the same time.  Small arrays, and arrays on
+ * machines with a single processor, are sorted in the calling thread.
+ *
+ * Like g_array_sort_with_data(), this is a stable sort.
+ *
+ * Since: 2.40
+ **/
+void
+g_array_sort_parallel (GArray           *farray,
+                       GCompareDataFunc  compare_func,
+                       gpointer          user_data)
+{
+  GRealArray *array = (GRealArray*) farray;
+
+  g_return_if_fail (array != NULL);
+
+  parallel_sort (array->data, array->len, array->elt_size,
+                 compare_func, user_data);
+}
+
 /* Returns the smallest power of 2 greater than n, or n if
  * such power does not fit in a guint
  */
@@ -856,6 +1072,7 @@ struct _GRealPtrArray
   guint         alloc;
   gint          ref_count;
   GDestroyNotify element_free_func;
+  GArena       *arena;          /* see g_ptr_array_new_in_arena() */
 };
 
 /**
@@ -905,6 +1122,7 @@ g_ptr_array_sized_new (guint reserved_size)
   array->alloc = 0;
   array->ref_count = 1;
   array->element_free_func = NULL;
+  array->arena = NULL;
 
   if (reserved_size != 0)
     g_ptr_array_maybe_expand (array, reserved_size);
@@ -912,6 +1130,50 @@ g_ptr_array_sized_new (guint reserved_size)
   return (GPtrArray*) array;  
 }
 
+/**
+ * g_ptr_array_new_in_arena:
+ * @arena: a #GArena
+ * @reserved_size: number of pointers preallocated.
+ * @element_free_func: (allow-none): A function to free elements with destroy @array or %NULL.
+ *
+ * Creates a new #GPtrArray like g_ptr_array_new_full(), but allocates
+ * it and its pointer storage from @arena. Growing the array leaves the
+ * old storage behind in @arena, unless it was the last allocation made.
+ *
+ * The array is reference counted and freed as usual, which does not
+ * give back any memory; if @element_free_func is %NULL it may also
+ * simply be dropped when @arena is reset. It must not be used after
+ * that. The pointer array returned by g_ptr_array_free() with
+ * @free_seg set to %FALSE belongs to @arena as well.
+ *
+ * Returns: A new #GPtrArray.
+ *
+ * Since: 2.40
+ **/
+GPtrArray *
+g_ptr_array_new_in_arena (GArena         *arena,
+                          guint           reserved_size,
+                          GDestroyNotify  element_free_func)
+{
+  GRealPtrArray *array;
+
+  g_return_val_if_fail (arena != NULL, NULL);
+
+  array = g_arena_alloc (arena, sizeof (GRealPtrArray));
+
+  array->pdata = NULL;
+  array->len = 0;
+  array->alloc = 0;
+  array->ref_count = 1;
+  array->element_free_func = element_free_func;
+  array->arena = arena;
+
+  if (reserved_size != 0)
+    g_ptr_array_maybe_expand (array, reserved_size);
+
+  return (GPtrArray*) array;
+}
+
 /**
  * g_ptr_array_new_with_free_func:
  * @element_free_func: (allow-none): A function to free elements with destroy @array or %NULL.
@@ -1079,7 +1341,8 @@ ptr_array_free (GPtrArray      *farray,
     {
       if (array->element_free_func != NULL)
         g_ptr_array_foreach (farray, (GFunc) array->element_free_func, NULL);
-      g_free (array->pdata);
+      if (!array->arena)
+        g_free (array->pdata);
       segment = NULL;
     }
   else
@@ -1091,7 +1354,7 @@ ptr_array_free (GPtrArray      *farray,
       array->len = 0;
       array->alloc = 0;
     }
-  else
+  else if (!array->arena)
     {
       g_slice_free1 (sizeof (GRealPtrArray), array);
     }
@@ -1108,7 +1371,12 @@ g_ptr_array_maybe_expand (GRealPtrArray *array,
       guint old_alloc = array->alloc;
       array->alloc = g_nearest_pow (array->len + len);
       array->alloc = MAX (array->alloc, MIN_ARRAY_SIZE);
-      array->pdata = g_realloc (array->pdata, sizeof (gpointer) * array->alloc);
+      if (array->arena)
+        array->pdata = g_arena_realloc (array->arena, array->pdata,
+                                        sizeof (gpointer) * old_alloc,
+                                        sizeof (gpointer) * array->alloc);
+      else
+        array->pdata = g_realloc (array->pdata, sizeof (gpointer) * array->alloc);
       if (G_UNLIKELY (g_mem_gc_friendly))
         for ( ; old_alloc < array->alloc; old_alloc++)
           array->pdata [old_alloc] = NULL;
@@ -1433,6 +1701,33 @@ g_ptr_array_sort_with_data (GPtrArray        *array,
 		     user_data);
 }
 
+/**
+ * g_ptr_array_sort_parallel:
+ * @array: a #GPtrArray.
+ * @compare_func: comparison function.
+ * @user_data: data to pass to @compare_func.
+ *
+ * Like g_ptr_array_sort_with_data(), but large arrays are sorted using
+ * several threads.  @compare_func must therefore be safe to call from
+ * multiple threads at the same time.  Small arrays, and arrays on
+ * machines with a single processor, are sorted in the calling thread.
+ *
+ * As with g_ptr_array_sort_with_data(), @compare_func takes pointers
+ * to the pointers in the array, and the sort is stable.
+ *
+ * Since: 2.40
+ **/
+void
+g_ptr_array_sort_parallel (GPtrArray        *array,
+                           GCompareDataFunc  compare_func,
+                           gpointer          user_data)
+{
+  g_return_if_fail (array != NULL);
+
+  parallel_sort (array->pdata, array->len, sizeof (gpointer),
+                 compare_func, user_data);
+}
+
 /**
  * g_ptr_array_foreach:
  * @array: a #GPtrArray
@@ -1545,6 +1840,7 @@ g_byte_array_new_take (guint8 *data,
 
   real->data = data;
   real->len = len;
+  real->alloc = len;
 
   return array;
 }
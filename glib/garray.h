@@ -32,6 +32,7 @@
 #endif
 
 #include <glib/gtypes.h>
+#include <glib/garena.h>
 
 G_BEGIN_DECLS
 
@@ -119,6 +120,10 @@ GLIB_AVAILABLE_IN_ALL
 void    g_array_sort_with_data    (GArray           *array,
 				   GCompareDataFunc  compare_func,
 				   gpointer          user_data);
+GLIB_AVAILABLE_IN_2_40
+void    g_array_sort_parallel     (GArray           *array,
+				   GCompareDataFunc  compare_func,
+				   gpointer          user_data);
 GLIB_AVAILABLE_IN_ALL
 void    g_array_set_clear_func    (GArray           *array,
                                    GDestroyNotify    clear_func);
@@ -137,6 +142,10 @@ GPtrArray* g_ptr_array_sized_new          (guint             reserved_size);
 GLIB_AVAILABLE_IN_ALL
 GPtrArray* g_ptr_array_new_full           (guint             reserved_size,
 					   GDestroyNotify    element_free_func);
+GLIB_AVAILABLE_IN_2_40
+GPtrArray* g_ptr_array_new_in_arena       (GArena           *arena,
+					   guint             reserved_size,
+					   GDestroyNotify    element_free_func);
 GLIB_AVAILABLE_IN_ALL
 gpointer*  g_ptr_array_free               (GPtrArray        *array,
 					   gboolean          free_seg);
@@ -176,6 +185,10 @@ GLIB_AVAILABLE_IN_ALL
 void       g_ptr_array_sort_with_data     (GPtrArray        *array,
 					   GCompareDataFunc  compare_func,
 					   gpointer          user_data);
+GLIB_AVAILABLE_IN_2_40
+void       g_ptr_array_sort_parallel      (GPtrArray        *array,
+					   GCompareDataFunc  compare_func,
+					   gpointer          user_data);
 GLIB_AVAILABLE_IN_ALL
 void       g_ptr_array_foreach            (GPtrArray        *array,
 					   GFunc             func,
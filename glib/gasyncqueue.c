@@ -29,6 +29,7 @@
 #include "gasyncqueue.h"
 #include "gasyncqueueprivate.h"
 
+#include "gatomic.h"
 #include "gmain.h"
 #include "gmem.h"
 #include "gqueue.h"
@@ -318,6 +319,70 @@ g_async_queue_push_unlocked (GAsyncQueue *queue,
     g_cond_signal (&queue->cond);
 }
 
+/**
+ * g_async_queue_push_many:
+ * @queue: a #GAsyncQueue
+ * @data: (array length=n_data): the items to push into the @queue
+ * @n_data: the number of items in @data
+ *
+ * Pushes all items of @data into the @queue, in order, as if
+ * g_async_queue_push() had been called for each of them. None of
+ * them may be %NULL.
+ *
+ * This only takes the lock of @queue once and wakes up the waiting
+ * threads at once, which is cheaper than pushing the items one by
+ * one when many of them are moved at a time.
+ *
+ * Since: 2.40
+ */
+void
+g_async_queue_push_many (GAsyncQueue *queue,
+                         gpointer    *data,
+                         guint        n_data)
+{
+  g_return_if_fail (queue);
+  g_return_if_fail (data || n_data == 0);
+
+  g_mutex_lock (&queue->mutex);
+  g_async_queue_push_many_unlocked (queue, data, n_data);
+  g_mutex_unlock (&queue->mutex);
+}
+
+/**
+ * g_async_queue_push_many_unlocked:
+ * @queue: a #GAsyncQueue
+ * @data: (array length=n_data): the items to push into the @queue
+ * @n_data: the number of items in @data
+ *
+ * Pushes all items of @data into the @queue, like
+ * g_async_queue_push_many().
+ *
+ * This function must be called while holding the @queue's lock.
+ *
+ * Since: 2.40
+ */
+void
+g_async_queue_push_many_unlocked (GAsyncQueue *queue,
+                                  gpointer    *data,
+                                  guint        n_data)
+{
+  guint i;
+
+  g_return_if_fail (queue);
+  g_return_if_fail (data || n_data == 0);
+
+  for (i = 0; i < n_data; i++)
+    {
+      g_return_if_fail (data[i]);
+      g_queue_push_head (&queue->queue, data[i]);
+    }
+
+  if (queue->waiting_threads > 1 && n_data > 1)
+    g_cond_broadcast (&queue->cond);
+  else if (queue->waiting_threads > 0 && n_data > 0)
+    g_cond_signal (&queue->cond);
+}
+
 /**
  * g_async_queue_push_sorted:
  * @queue: a #GAsyncQueue
@@ -572,6 +637,63 @@ g_async_queue_timeout_pop_unlocked (GAsyncQueue *queue,
   return g_async_queue_pop_intern_unlocked (queue, TRUE, end_time);
 }
 
+/**
+ * g_async_queue_pop_many:
+ * @queue: a #GAsyncQueue
+ * @data: (array length=max_data) (out caller-allocates): return location
+ *     for the items
+ * @max_data: the maximum number of items to pop
+ * @timeout: the number of microseconds to wait for the first item
+ *
+ * Pops up to @max_data items from the @queue into @data, in the order
+ * g_async_queue_pop() would have returned them. If the @queue is
+ * empty, blocks for @timeout microseconds, or until an item becomes
+ * available; a @timeout of 0 does not wait at all. Once there is at
+ * least one item, all items that are available right away are
+ * returned, up to @max_data.
+ *
+ * This only takes the lock of @queue once, which is cheaper than
+ * popping the items one by one when many of them are moved at a time.
+ *
+ * Return value: the number of items stored in @data, 0 if none were
+ *     received before the timeout
+ *
+ * Since: 2.40
+ */
+guint
+g_async_queue_pop_many (GAsyncQueue *queue,
+                        gpointer    *data,
+                        guint        max_data,
+                        guint64      timeout)
+{
+  gint64 end_time;
+  gpointer item;
+  guint n_data = 0;
+
+  g_return_val_if_fail (queue, 0);
+  g_return_val_if_fail (data || max_data == 0, 0);
+
+  if (max_data == 0)
+    return 0;
+
+  end_time = g_get_monotonic_time () + timeout;
+
+  g_mutex_lock (&queue->mutex);
+
+  item = g_async_queue_pop_intern_unlocked (queue, timeout > 0, end_time);
+  while (item)
+    {
+      data[n_data++] = item;
+      if (n_data == max_data)
+        break;
+      item = g_queue_pop_tail (&queue->queue);
+    }
+
+  g_mutex_unlock (&queue->mutex);
+
+  return n_data;
+}
+
 /**
  * g_async_queue_timed_pop:
  * @queue: a #GAsyncQueue
@@ -789,6 +911,715 @@ g_async_queue_sort_unlocked (GAsyncQueue      *queue,
                 &sd);
 }
 
+/**
+ * SECTION:concurrent_queues
+ * @title: Concurrent Queues
+ * @short_description: lock-free FIFO communication between threads
+ * @see_also: #GAsyncQueue
+ *
+ * A #GConcurrentQueue is a first-in first-out queue that any number of
+ * threads can push to and pop from at the same time. Unlike
+ * #GAsyncQueue it does not take a lock for every operation: items are
+ * kept in a fixed size ring buffer whose slots are claimed with atomic
+ * operations, so that producers and consumers only contend on a cache
+ * line each instead of on a mutex.
+ *
+ * Threads only sleep when there is nothing to do: g_concurrent_queue_pop()
+ * blocks while the queue is empty, and g_concurrent_queue_push() blocks
+ * while it is full. As long as neither happens, no locks are taken and
+ * no system calls are made.
+ *
+ * The price for this is that the capacity of the queue is fixed when it
+ * is created, and that items can not be sorted or inspected while they
+ * are queued. Use #GAsyncQueue if you need g_async_queue_push_sorted()
+ * or the ability to lock the queue.
+ *
+ * When it is known that only one thread pushes, or only one thread
+ * pops, g_concurrent_queue_new_with_flags() creates a queue that skips
+ * the atomic read-modify-write operations on that side. Moving several
+ * items at once with g_concurrent_queue_push_many() and
+ * g_concurrent_queue_pop_many() claims all of their slots in one go.
+ */
+
+/**
+ * GConcurrentQueue:
+ *
+ * The GConcurrentQueue struct is an opaque data structure which
+ * represents a lock-free queue. It should only be accessed through
+ * the <function>g_concurrent_queue_*</function> functions.
+ *
+ * Since: 2.40
+ */
+
+/* This is the bounded queue from Dmitry Vyukov, see
+ * http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ *
+ * Every cell carries a sequence number, which tells whether it is free
+ * for the producer that claims position @pos (sequence == pos) or holds
+ * an item for the consumer at position @pos (sequence == pos + 1).  The
+ * positions and sequence numbers are free running unsigned counters
+ * that wrap around; two of them never drift more than the capacity
+ * apart, so they are compared by their unsigned difference read back
+ * as a signed number.
+ */
+typedef struct
+{
+  guint    sequence;
+  gpointer data;
+} GConcurrentQueueCell;
+
+/* The sequence number orders the accesses to the data of a cell, so
+ * acquire/release is enough for it where the compiler supports that.
+ */
+#ifdef __ATOMIC_ACQUIRE
+#define CELL_LOAD_SEQUENCE(c_)      __atomic_load_n (&(c_)->sequence, __ATOMIC_ACQUIRE)
+#define CELL_STORE_SEQUENCE(c_, v_) __atomic_store_n (&(c_)->sequence, (v_), __ATOMIC_RELEASE)
+#else
+#define CELL_LOAD_SEQUENCE(c_)      g_atomic_int_get (&(c_)->sequence)
+#define CELL_STORE_SEQUENCE(c_, v_) g_atomic_int_set (&(c_)->sequence, (v_))
+#endif
+
+/* A position that only one thread moves needs no barrier of its own */
+#ifdef __ATOMIC_RELAXED
+#define POSITION_STORE(p_, v_)      __atomic_store_n ((p_), (v_), __ATOMIC_RELAXED)
+#else
+#define POSITION_STORE(p_, v_)      g_atomic_int_set ((p_), (v_))
+#endif
+
+#define CONCURRENT_QUEUE_DEFAULT_CAPACITY 1024
+#define CONCURRENT_QUEUE_MAX_CAPACITY     (1 << 28)
+#define CONCURRENT_QUEUE_PAD              (64 / sizeof (gint) - 1)
+
+struct _GConcurrentQueue
+{
+  guint enqueue_pos;
+  gint pad1[CONCURRENT_QUEUE_PAD];
+  guint dequeue_pos;
+  gint pad2[CONCURRENT_QUEUE_PAD];
+
+  /* only used to sleep when the queue is empty or full */
+  gint waiting_consumers;
+  gint waiting_producers;
+  GMutex mutex;
+  GCond not_empty;
+  GCond not_full;
+
+  GConcurrentQueueCell *cells;
+  guint mask;
+  GConcurrentQueueFlags flags;
+  GDestroyNotify item_free_func;
+  gint ref_count;
+};
+
+/**
+ * g_concurrent_queue_new:
+ * @capacity: the number of items the queue can hold, or 0 to use
+ *     the default. It is rounded up to a power of 2.
+ *
+ * Creates a new concurrent queue.
+ *
+ * Return value: a new #GConcurrentQueue. Free with g_concurrent_queue_unref()
+ *
+ * Since: 2.40
+ */
+GConcurrentQueue *
+g_concurrent_queue_new (guint capacity)
+{
+  return g_concurrent_queue_new_full (capacity, NULL);
+}
+
+/**
+ * g_concurrent_queue_new_full:
+ * @capacity: the number of items the queue can hold, or 0 to use
+ *     the default. It is rounded up to a power of 2.
+ * @item_free_func: (allow-none): function to free queue elements
+ *
+ * Creates a new concurrent queue and sets up a destroy notify
+ * function that is used to free any remaining queue items when
+ * the queue is destroyed after the final unref.
+ *
+ * Return value: a new #GConcurrentQueue. Free with g_concurrent_queue_unref()
+ *
+ * Since: 2.40
+ */
+GConcurrentQueue *
+g_concurrent_queue_new_full (guint          capacity,
+                             GDestroyNotify item_free_func)
+{
+  return g_concurrent_queue_new_with_flags (capacity, G_CONCURRENT_QUEUE_DEFAULT,
+                                            item_free_func);
+}
+
+/**
+ * g_concurrent_queue_new_with_flags:
+ * @capacity: the number of items the queue can hold, or 0 to use
+ *     the default. It is rounded up to a power of 2.
+ * @flags: #GConcurrentQueueFlags
+ * @item_free_func: (allow-none): function to free queue elements
+ *
+ * Creates a new concurrent queue like g_concurrent_queue_new_full().
+ *
+ * If @flags contains %G_CONCURRENT_QUEUE_SINGLE_PRODUCER, the caller
+ * promises that the queue is never pushed to by two threads at the
+ * same time, and likewise for %G_CONCURRENT_QUEUE_SINGLE_CONSUMER and
+ * popping. This makes pushing or popping cheaper, but breaking the
+ * promise corrupts the queue.
+ *
+ * Return value: a new #GConcurrentQueue. Free with g_concurrent_queue_unref()
+ *
+ * Since: 2.40
+ */
+GConcurrentQueue *
+g_concurrent_queue_new_with_flags (guint                 capacity,
+                                   GConcurrentQueueFlags flags,
+                                   GDestroyNotify        item_free_func)
+{
+  GConcurrentQueue *queue;
+  guint size, i;
+
+  g_return_val_if_fail (capacity <= CONCURRENT_QUEUE_MAX_CAPACITY, NULL);
+
+  if (capacity == 0)
+    capacity = CONCURRENT_QUEUE_DEFAULT_CAPACITY;
+
+  size = 2;
+  while (size < capacity)
+    size <<= 1;
+
+  queue = g_new0 (GConcurrentQueue, 1);
+  queue->cells = g_new (GConcurrentQueueCell, size);
+  for (i = 0; i < size; i++)
+    {
+      queue->cells[i].sequence = i;
+      queue->cells[i].data = NULL;
+    }
+  queue->mask = size - 1;
+  queue->flags = flags;
+  g_mutex_init (&queue->mutex);
+  g_cond_init (&queue->not_empty);
+  g_cond_init (&queue->not_full);
+  queue->item_free_func = item_free_func;
+  queue->ref_count = 1;
+
+  return queue;
+}
+
+/**
+ * g_concurrent_queue_ref:
+ * @queue: a #GConcurrentQueue
+ *
+ * Increases the reference count of @queue by 1.
+ *
+ * Returns: the @queue that was passed in
+ *
+ * Since: 2.40
+ */
+GConcurrentQueue *
+g_concurrent_queue_ref (GConcurrentQueue *queue)
+{
+  g_return_val_if_fail (queue, NULL);
+
+  g_atomic_int_inc (&queue->ref_count);
+
+  return queue;
+}
+
+/* Claims up to @n cells starting at the position @pos, whose sequence
+ * numbers must be @pos + @offset, @pos + 1 + @offset, ...  Returns the
+ * number of cells claimed, and the first position in @pos.
+ */
+static guint
+g_concurrent_queue_claim (GConcurrentQueue *queue,
+                          guint            *position,
+                          gboolean          single,
+                          guint            *pos,
+                          guint             offset,
+                          guint             n)
+{
+  GConcurrentQueueCell *cell;
+  guint seq;
+  gint dif = 0;
+  guint i;
+
+  if (n == 0)
+    return 0;
+
+  *pos = single ? *position : g_atomic_int_get (position);
+  for (;;)
+    {
+      for (i = 0; i < n; i++)
+        {
+          cell = &queue->cells[(*pos + i) & queue->mask];
+          seq = CELL_LOAD_SEQUENCE (cell);
+          dif = (gint) (seq - (*pos + i + offset));
+
+          if (dif != 0)
+            break;
+        }
+
+      if (i == 0 && dif < 0)
+        return 0;
+
+      if (i > 0)
+        {
+          if (single)
+            {
+              POSITION_STORE (position, *pos + i);
+              return i;
+            }
+          if (g_atomic_int_compare_and_exchange (position, *pos, *pos + i))
+            return i;
+        }
+
+      *pos = g_atomic_int_get (position);
+    }
+}
+
+static guint
+g_concurrent_queue_enqueue_many (GConcurrentQueue *queue,
+                                 gpointer         *data,
+                                 guint             n)
+{
+  GConcurrentQueueCell *cell;
+  guint pos;
+  guint i;
+
+  n = g_concurrent_queue_claim (queue, &queue->enqueue_pos,
+                                queue->flags & G_CONCURRENT_QUEUE_SINGLE_PRODUCER,
+                                &pos, 0, n);
+
+  for (i = 0; i < n; i++)
+    {
+      cell = &queue->cells[(pos + i) & queue->mask];
+      cell->data = data[i];
+      CELL_STORE_SEQUENCE (cell, pos + i + 1);
+    }
+
+  return n;
+}
+
+static guint
+g_concurrent_queue_dequeue_many (GConcurrentQueue *queue,
+                                 gpointer         *data,
+                                 guint             n)
+{
+  GConcurrentQueueCell *cell;
+  guint pos;
+  guint i;
+
+  n = g_concurrent_queue_claim (queue, &queue->dequeue_pos,
+                                queue->flags & G_CONCURRENT_QUEUE_SINGLE_CONSUMER,
+                                &pos, 1, n);
+
+  for (i = 0; i < n; i++)
+    {
+      cell = &queue->cells[(pos + i) & queue->mask];
+      data[i] = cell->data;
+      CELL_STORE_SEQUENCE (cell, pos + i + queue->mask + 1);
+    }
+
+  return n;
+}
+
+static inline gboolean
+g_concurrent_queue_enqueue (GConcurrentQueue *queue,
+                            gpointer          data)
+{
+  return g_concurrent_queue_enqueue_many (queue, &data, 1) == 1;
+}
+
+static inline gboolean
+g_concurrent_queue_dequeue (GConcurrentQueue *queue,
+                            gpointer         *data)
+{
+  return g_concurrent_queue_dequeue_many (queue, data, 1) == 1;
+}
+
+/* The waiting counters are raised before the sleeping thread checks
+ * the queue once more, and checked by the other side right after it
+ * updated the queue. Both are full barriers, so either the sleeper
+ * sees the change or the other side sees the sleeper.
+ */
+static void
+g_concurrent_queue_wake (GConcurrentQueue *queue,
+                         gint             *waiting,
+                         GCond            *cond,
+                         guint             n_items)
+{
+  if (g_atomic_int_get (waiting) > 0)
+    {
+      g_mutex_lock (&queue->mutex);
+      if (n_items > 1)
+        g_cond_broadcast (cond);
+      else
+        g_cond_signal (cond);
+      g_mutex_unlock (&queue->mutex);
+    }
+}
+
+/**
+ * g_concurrent_queue_unref:
+ * @queue: a #GConcurrentQueue.
+ *
+ * Decreases the reference count of @queue by 1. If the reference
+ * count went to 0, the @queue will be destroyed and the memory
+ * allocated will be freed. If an item free function was set when
+ * creating the queue, it is called for the remaining items.
+ *
+ * Since: 2.40
+ */
+void
+g_concurrent_queue_unref (GConcurrentQueue *queue)
+{
+  gpointer data;
+
+  g_return_if_fail (queue);
+
+  if (g_atomic_int_dec_and_test (&queue->ref_count))
+    {
+      g_return_if_fail (queue->waiting_consumers == 0);
+      g_return_if_fail (queue->waiting_producers == 0);
+
+      while (g_concurrent_queue_dequeue (queue, &data))
+        if (queue->item_free_func)
+          queue->item_free_func (data);
+
+      g_mutex_clear (&queue->mutex);
+      g_cond_clear (&queue->not_empty);
+      g_cond_clear (&queue->not_full);
+      g_free (queue->cells);
+      g_free (queue);
+    }
+}
+
+/**
+ * g_concurrent_queue_try_push:
+ * @queue: a #GConcurrentQueue
+ * @data: @data to push into the @queue
+ *
+ * Pushes the @data into the @queue, unless it is full. @data must
+ * not be %NULL.
+ *
+ * Return value: %TRUE if @data was pushed, %FALSE if @queue was full
+ *
+ * Since: 2.40
+ */
+gboolean
+g_concurrent_queue_try_push (GConcurrentQueue *queue,
+                             gpointer          data)
+{
+  g_return_val_if_fail (queue, FALSE);
+  g_return_val_if_fail (data, FALSE);
+
+  if (!g_concurrent_queue_enqueue (queue, data))
+    return FALSE;
+
+  g_concurrent_queue_wake (queue, &queue->waiting_consumers, &queue->not_empty, 1);
+
+  return TRUE;
+}
+
+/**
+ * g_concurrent_queue_push:
+ * @queue: a #GConcurrentQueue
+ * @data: @data to push into the @queue
+ *
+ * Pushes the @data into the @queue. @data must not be %NULL. If the
+ * @queue is full, this function blocks until another thread pops an
+ * item from it.
+ *
+ * Since: 2.40
+ */
+void
+g_concurrent_queue_push (GConcurrentQueue *queue,
+                         gpointer          data)
+{
+  g_return_if_fail (queue);
+  g_return_if_fail (data);
+
+  if (!g_concurrent_queue_enqueue (queue, data))
+    {
+      g_mutex_lock (&queue->mutex);
+      g_atomic_int_inc (&queue->waiting_producers);
+      while (!g_concurrent_queue_enqueue (queue, data))
+        g_cond_wait (&queue->not_full, &queue->mutex);
+      g_atomic_int_add (&queue->waiting_producers, -1);
+      g_mutex_unlock (&queue->mutex);
+    }
+
+  g_concurrent_queue_wake (queue, &queue->waiting_consumers, &queue->not_empty, 1);
+}
+
+/**
+ * g_concurrent_queue_try_push_many:
+ * @queue: a #GConcurrentQueue
+ * @data: (array length=n_data): the items to push
+ * @n_data: the number of items in @data
+ *
+ * Pushes as many of the items in @data into the @queue as there is
+ * room for, in order, without blocking. None of them may be %NULL.
+ *
+ * The slots for the items are claimed all at once, which is cheaper
+ * than pushing them one by one.
+ *
+ * Return value: the number of items pushed, which are the first ones
+ *     of @data
+ *
+ * Since: 2.40
+ */
+guint
+g_concurrent_queue_try_push_many (GConcurrentQueue *queue,
+                                  gpointer         *data,
+                                  guint             n_data)
+{
+  guint n;
+
+  g_return_val_if_fail (queue, 0);
+  g_return_val_if_fail (n_data == 0 || data, 0);
+
+  n = g_concurrent_queue_enqueue_many (queue, data, n_data);
+  if (n > 0)
+    g_concurrent_queue_wake (queue, &queue->waiting_consumers, &queue->not_empty, n);
+
+  return n;
+}
+
+/**
+ * g_concurrent_queue_push_many:
+ * @queue: a #GConcurrentQueue
+ * @data: (array length=n_data): the items to push
+ * @n_data: the number of items in @data
+ *
+ * Pushes all the items in @data into the @queue, in order, as if by
+ * calling g_concurrent_queue_push() for each of them. None of them
+ * may be %NULL. If the @queue gets full, this function blocks until
+ * other threads make room for the rest.
+ *
+ * Since: 2.40
+ */
+void
+g_concurrent_queue_push_many (GConcurrentQueue *queue,
+                              gpointer         *data,
+                              guint             n_data)
+{
+  guint n;
+
+  g_return_if_fail (queue);
+  g_return_if_fail (n_data == 0 || data);
+
+  n = g_concurrent_queue_enqueue_many (queue, data, n_data);
+  if (n < n_data)
+    {
+      g_mutex_lock (&queue->mutex);
+      g_atomic_int_inc (&queue->waiting_producers);
+      for (;;)
+        {
+          guint pushed;
+
+          pushed = g_concurrent_queue_enqueue_many (queue, data + n, n_data - n);
+          if (pushed > 0)
+            {
+              n += pushed;
+              /* consumers may be asleep waiting for these */
+              if (g_atomic_int_get (&queue->waiting_consumers) > 0)
+                g_cond_broadcast (&queue->not_empty);
+            }
+          if (n == n_data)
+            break;
+          g_cond_wait (&queue->not_full, &queue->mutex);
+        }
+      g_atomic_int_add (&queue->waiting_producers, -1);
+      g_mutex_unlock (&queue->mutex);
+    }
+
+  g_concurrent_queue_wake (queue, &queue->waiting_consumers, &queue->not_empty, n);
+}
+
+static gpointer
+g_concurrent_queue_pop_intern (GConcurrentQueue *queue,
+                               gboolean          wait,
+                               gint64            end_time)
+{
+  gpointer data = NULL;
+
+  if (!g_concurrent_queue_dequeue (queue, &data) && wait)
+    {
+      g_mutex_lock (&queue->mutex);
+      g_atomic_int_inc (&queue->waiting_consumers);
+      while (!g_concurrent_queue_dequeue (queue, &data))
+        {
+          if (end_time == -1)
+            g_cond_wait (&queue->not_empty, &queue->mutex);
+          else if (!g_cond_wait_until (&queue->not_empty, &queue->mutex, end_time))
+            {
+              g_concurrent_queue_dequeue (queue, &data);
+              break;
+            }
+        }
+      g_atomic_int_add (&queue->waiting_consumers, -1);
+      g_mutex_unlock (&queue->mutex);
+    }
+
+  if (data)
+    g_concurrent_queue_wake (queue, &queue->waiting_producers, &queue->not_full, 1);
+
+  return data;
+}
+
+/**
+ * g_concurrent_queue_pop:
+ * @queue: a #GConcurrentQueue
+ *
+ * Pops data from the @queue. If @queue is empty, this function
+ * blocks until data becomes available.
+ *
+ * Return value: data from the queue
+ *
+ * Since: 2.40
+ */
+gpointer
+g_concurrent_queue_pop (GConcurrentQueue *queue)
+{
+  g_return_val_if_fail (queue, NULL);
+
+  return g_concurrent_queue_pop_intern (queue, TRUE, -1);
+}
+
+/**
+ * g_concurrent_queue_try_pop:
+ * @queue: a #GConcurrentQueue
+ *
+ * Tries to pop data from the @queue. If no data is available,
+ * %NULL is returned.
+ *
+ * Return value: data from the queue or %NULL, when no data is
+ *     available immediately.
+ *
+ * Since: 2.40
+ */
+gpointer
+g_concurrent_queue_try_pop (GConcurrentQueue *queue)
+{
+  g_return_val_if_fail (queue, NULL);
+
+  return g_concurrent_queue_pop_intern (queue, FALSE, -1);
+}
+
+/**
+ * g_concurrent_queue_timeout_pop:
+ * @queue: a #GConcurrentQueue
+ * @timeout: the number of microseconds to wait
+ *
+ * Pops data from the @queue. If the queue is empty, blocks for
+ * @timeout microseconds, or until data becomes available.
+ *
+ * If no data is received before the timeout, %NULL is returned.
+ *
+ * Return value: data from the queue or %NULL, when no data is
+ *     received before the timeout.
+ *
+ * Since: 2.40
+ */
+gpointer
+g_concurrent_queue_timeout_pop (GConcurrentQueue *queue,
+                                guint64           timeout)
+{
+  gint64 end_time = g_get_monotonic_time () + timeout;
+
+  g_return_val_if_fail (queue, NULL);
+
+  return g_concurrent_queue_pop_intern (queue, TRUE, end_time);
+}
+
+/**
+ * g_concurrent_queue_pop_many:
+ * @queue: a #GConcurrentQueue
+ * @data: (array length=max_data) (out caller-allocates): return location
+ *     for the items
+ * @max_data: the maximum number of items to pop
+ * @timeout: the number of microseconds to wait for the first item
+ *
+ * Pops up to @max_data items from the @queue into @data, in the order
+ * g_concurrent_queue_pop() would have returned them. If the @queue is
+ * empty, blocks for @timeout microseconds, or until an item becomes
+ * available; a @timeout of 0 does not wait at all. Once there is at
+ * least one item, all items that are available right away are
+ * returned, up to @max_data.
+ *
+ * The slots of the items are released all at once, which is cheaper
+ * than popping them one by one.
+ *
+ * Return value: the number of items stored in @data, 0 if none were
+ *     received before the timeout
+ *
+ * Since: 2.40
+ */
+guint
+g_concurrent_queue_pop_many (GConcurrentQueue *queue,
+                             gpointer         *data,
+                             guint             max_data,
+                             guint64           timeout)
+{
+  gint64 end_time;
+  guint n;
+
+  g_return_val_if_fail (queue, 0);
+  g_return_val_if_fail (max_data == 0 || data, 0);
+
+  if (max_data == 0)
+    return 0;
+
+  n = g_concurrent_queue_dequeue_many (queue, data, max_data);
+  if (n == 0 && timeout > 0)
+    {
+      end_time = g_get_monotonic_time () + timeout;
+
+      g_mutex_lock (&queue->mutex);
+      g_atomic_int_inc (&queue->waiting_consumers);
+      while ((n = g_concurrent_queue_dequeue_many (queue, data, max_data)) == 0)
+        {
+          if (!g_cond_wait_until (&queue->not_empty, &queue->mutex, end_time))
+            {
+              n = g_concurrent_queue_dequeue_many (queue, data, max_data);
+              break;
+            }
+        }
+      g_atomic_int_add (&queue->waiting_consumers, -1);
+      g_mutex_unlock (&queue->mutex);
+    }
+
+  if (n > 0)
+    g_concurrent_queue_wake (queue, &queue->waiting_producers, &queue->not_full, n);
+
+  return n;
+}
+
+/**
+ * g_concurrent_queue_length:
+ * @queue: a #GConcurrentQueue
+ *
+ * Returns the number of items in the queue. As other threads may
+ * push and pop at the same time, this is only a snapshot, and items
+ * that are being pushed or popped right now may or may not be
+ * counted.
+ *
+ * Returns: the number of items in the @queue
+ *
+ * Since: 2.40
+ */
+gint
+g_concurrent_queue_length (GConcurrentQueue *queue)
+{
+  gint length;
+
+  g_return_val_if_fail (queue, 0);
+
+  length = (gint) ((guint) g_atomic_int_get (&queue->enqueue_pos) -
+                   (guint) g_atomic_int_get (&queue->dequeue_pos));
+
+  return CLAMP (length, 0, (gint) queue->mask + 1);
+}
+
 /*
  * Private API
  */
@@ -62,6 +62,14 @@ void         g_async_queue_push                 (GAsyncQueue      *queue,
 GLIB_AVAILABLE_IN_ALL
 void         g_async_queue_push_unlocked        (GAsyncQueue      *queue,
                                                  gpointer          data);
+GLIB_AVAILABLE_IN_2_40
+void         g_async_queue_push_many            (GAsyncQueue      *queue,
+                                                 gpointer         *data,
+                                                 guint             n_data);
+GLIB_AVAILABLE_IN_2_40
+void         g_async_queue_push_many_unlocked   (GAsyncQueue      *queue,
+                                                 gpointer         *data,
+                                                 guint             n_data);
 GLIB_AVAILABLE_IN_ALL
 void         g_async_queue_push_sorted          (GAsyncQueue      *queue,
                                                  gpointer          data,
@@ -86,6 +94,11 @@ gpointer     g_async_queue_timeout_pop          (GAsyncQueue      *queue,
 GLIB_AVAILABLE_IN_ALL
 gpointer     g_async_queue_timeout_pop_unlocked (GAsyncQueue      *queue,
                                                  guint64           timeout);
+GLIB_AVAILABLE_IN_2_40
+guint        g_async_queue_pop_many             (GAsyncQueue      *queue,
+                                                 gpointer         *data,
+                                                 guint             max_data,
+                                                 guint64           timeout);
 GLIB_AVAILABLE_IN_ALL
 gint         g_async_queue_length               (GAsyncQueue      *queue);
 GLIB_AVAILABLE_IN_ALL
@@ -106,6 +119,67 @@ GLIB_DEPRECATED_FOR(g_async_queue_timeout_pop_unlocked)
 gpointer     g_async_queue_timed_pop_unlocked   (GAsyncQueue      *queue,
                                                  GTimeVal         *end_time);
 
+typedef struct _GConcurrentQueue GConcurrentQueue;
+
+/**
+ * GConcurrentQueueFlags:
+ * @G_CONCURRENT_QUEUE_DEFAULT: any number of threads may push and pop
+ * @G_CONCURRENT_QUEUE_SINGLE_PRODUCER: only one thread at a time pushes
+ * @G_CONCURRENT_QUEUE_SINGLE_CONSUMER: only one thread at a time pops
+ *
+ * Flags passed to g_concurrent_queue_new_with_flags().
+ *
+ * Since: 2.40
+ */
+typedef enum
+{
+  G_CONCURRENT_QUEUE_DEFAULT         = 0,
+  G_CONCURRENT_QUEUE_SINGLE_PRODUCER = 1 << 0,
+  G_CONCURRENT_QUEUE_SINGLE_CONSUMER = 1 << 1
+} GConcurrentQueueFlags;
+
+GLIB_AVAILABLE_IN_2_40
+GConcurrentQueue *g_concurrent_queue_new         (guint             capacity);
+GLIB_AVAILABLE_IN_2_40
+GConcurrentQueue *g_concurrent_queue_new_full    (guint             capacity,
+                                                  GDestroyNotify    item_free_func);
+GLIB_AVAILABLE_IN_2_40
+GConcurrentQueue *g_concurrent_queue_new_with_flags (guint                 capacity,
+                                                     GConcurrentQueueFlags flags,
+                                                     GDestroyNotify        item_free_func);
+GLIB_AVAILABLE_IN_2_40
+GConcurrentQueue *g_concurrent_queue_ref         (GConcurrentQueue *queue);
+GLIB_AVAILABLE_IN_2_40
+void              g_concurrent_queue_unref       (GConcurrentQueue *queue);
+GLIB_AVAILABLE_IN_2_40
+void              g_concurrent_queue_push        (GConcurrentQueue *queue,
+                                                  gpointer          data);
+GLIB_AVAILABLE_IN_2_40
+gboolean          g_concurrent_queue_try_push    (GConcurrentQueue *queue,
+                                                  gpointer          data);
+GLIB_AVAILABLE_IN_2_40
+void              g_concurrent_queue_push_many   (GConcurrentQueue *queue,
+                                                  gpointer         *data,
+                                                  guint             n_data);
+GLIB_AVAILABLE_IN_2_40
+guint             g_concurrent_queue_try_push_many (GConcurrentQueue *queue,
+                                                    gpointer         *data,
+                                                    guint             n_data);
+GLIB_AVAILABLE_IN_2_40
+gpointer          g_concurrent_queue_pop         (GConcurrentQueue *queue);
+GLIB_AVAILABLE_IN_2_40
+gpointer          g_concurrent_queue_try_pop     (GConcurrentQueue *queue);
+GLIB_AVAILABLE_IN_2_40
+gpointer          g_concurrent_queue_timeout_pop (GConcurrentQueue *queue,
+                                                  guint64           timeout);
+GLIB_AVAILABLE_IN_2_40
+guint             g_concurrent_queue_pop_many    (GConcurrentQueue *queue,
+                                                  gpointer         *data,
+                                                  guint             max_data,
+                                                  guint64           timeout);
+GLIB_AVAILABLE_IN_2_40
+gint              g_concurrent_queue_length      (GConcurrentQueue *queue);
+
 G_END_DECLS
 
 #endif /* __G_ASYNCQUEUE_H__ */
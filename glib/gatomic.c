@@ -46,9 +46,13 @@
  * 'xor' operations operate on (and return) unsigned integer values
  * (#guint and #gsize).
  *
- * All of the operations act as a full compiler and (where appropriate)
- * hardware memory barrier.  Acquire and release or producer and
- * consumer barrier semantics are not available through this API.
+ * Unless their name says otherwise, the operations act as a full
+ * compiler and (where appropriate) hardware memory barrier.  The
+ * _load_acquire() and _store_release() variants only order the memory
+ * accesses on one side of them, which is all that publishing data to
+ * another thread needs, and is cheaper on most architectures.  The
+ * _relaxed() variants are atomic but do not order any other memory
+ * access at all.
  *
  * It is very important that all accesses to a particular integer or
  * pointer be performed using only this API and that different sizes of
@@ -464,6 +468,209 @@ gsize
   return g_atomic_pointer_xor ((volatile gpointer *) atomic, val);
 }
 
+
+/**
+ * g_atomic_int_load_acquire:
+ * @atomic: a pointer to a #gint or #guint
+ *
+ * Gets the current value of @atomic, with acquire semantics: no read
+ * or write that follows in program order can be moved before it.  This
+ * pairs with g_atomic_int_store_release() in another thread: once the
+ * stored value is seen, so is everything written before the store.
+ *
+ * On most architectures this is cheaper than g_atomic_int_get(), which
+ * acts as a full memory barrier.
+ *
+ * Returns: the value of the integer
+ *
+ * Since: 2.40
+ **/
+gint
+(g_atomic_int_load_acquire) (const volatile gint *atomic)
+{
+  return g_atomic_int_load_acquire (atomic);
+}
+
+/**
+ * g_atomic_int_load_relaxed:
+ * @atomic: a pointer to a #gint or #guint
+ *
+ * Gets the current value of @atomic.  The read itself is atomic, but
+ * it does not order any other memory access; this is suitable for
+ * statistics counters, or for re-checking a value before an operation
+ * that does provide ordering, such as
+ * g_atomic_int_compare_and_exchange().
+ *
+ * Returns: the value of the integer
+ *
+ * Since: 2.40
+ **/
+gint
+(g_atomic_int_load_relaxed) (const volatile gint *atomic)
+{
+  return g_atomic_int_load_relaxed (atomic);
+}
+
+/**
+ * g_atomic_int_store_release:
+ * @atomic: a pointer to a #gint or #guint
+ * @newval: a new value to store
+ *
+ * Sets the value of @atomic to @newval, with release semantics: no
+ * read or write that precedes it in program order can be moved after
+ * it.  See g_atomic_int_load_acquire().
+ *
+ * Since: 2.40
+ **/
+void
+(g_atomic_int_store_release) (volatile gint *atomic,
+                              gint           newval)
+{
+  g_atomic_int_store_release (atomic, newval);
+}
+
+/**
+ * g_atomic_int_store_relaxed:
+ * @atomic: a pointer to a #gint or #guint
+ * @newval: a new value to store
+ *
+ * Sets the value of @atomic to @newval.  The write itself is atomic,
+ * but it does not order any other memory access.
+ *
+ * Since: 2.40
+ **/
+void
+(g_atomic_int_store_relaxed) (volatile gint *atomic,
+                              gint           newval)
+{
+  g_atomic_int_store_relaxed (atomic, newval);
+}
+
+/**
+ * g_atomic_int_compare_and_exchange_full:
+ * @atomic: a pointer to a #gint or #guint
+ * @oldval: the value to compare with
+ * @newval: the value to conditionally replace with
+ * @preval: (out): the contents of @atomic before this operation
+ *
+ * Compares @atomic to @oldval and, if equal, sets it to @newval, like
+ * g_atomic_int_compare_and_exchange().  In addition, the value @atomic
+ * had is returned in @preval, which saves the separate read a retry
+ * loop would otherwise need after a failed exchange.
+ *
+ * This call acts as a full compiler and hardware memory barrier.
+ *
+ * Returns: %TRUE if the exchange took place
+ *
+ * Since: 2.40
+ **/
+gboolean
+(g_atomic_int_compare_and_exchange_full) (volatile gint *atomic,
+                                          gint           oldval,
+                                          gint           newval,
+                                          gint          *preval)
+{
+  return g_atomic_int_compare_and_exchange_full (atomic, oldval, newval, preval);
+}
+
+/**
+ * g_atomic_pointer_load_acquire:
+ * @atomic: (type gpointer): a pointer to a #gpointer-sized value
+ *
+ * Gets the current value of @atomic, with acquire semantics.  See
+ * g_atomic_int_load_acquire().
+ *
+ * Returns: the value of the pointer
+ *
+ * Since: 2.40
+ **/
+gpointer
+(g_atomic_pointer_load_acquire) (const volatile void *atomic)
+{
+  return g_atomic_pointer_load_acquire ((const volatile gpointer *) atomic);
+}
+
+/**
+ * g_atomic_pointer_load_relaxed:
+ * @atomic: (type gpointer): a pointer to a #gpointer-sized value
+ *
+ * Gets the current value of @atomic, without ordering any other memory
+ * access.  See g_atomic_int_load_relaxed().
+ *
+ * Returns: the value of the pointer
+ *
+ * Since: 2.40
+ **/
+gpointer
+(g_atomic_pointer_load_relaxed) (const volatile void *atomic)
+{
+  return g_atomic_pointer_load_relaxed ((const volatile gpointer *) atomic);
+}
+
+/**
+ * g_atomic_pointer_store_release:
+ * @atomic: (type gpointer): a pointer to a #gpointer-sized value
+ * @newval: a new value to store
+ *
+ * Sets the value of @atomic to @newval, with release semantics.  This
+ * is what publishing a newly initialised structure to other threads
+ * needs; they read it with g_atomic_pointer_load_acquire().
+ *
+ * Since: 2.40
+ **/
+void
+(g_atomic_pointer_store_release) (volatile void *atomic,
+                                  gpointer       newval)
+{
+  g_atomic_pointer_store_release ((volatile gpointer *) atomic, newval);
+}
+
+/**
+ * g_atomic_pointer_store_relaxed:
+ * @atomic: (type gpointer): a pointer to a #gpointer-sized value
+ * @newval: a new value to store
+ *
+ * Sets the value of @atomic to @newval, without ordering any other
+ * memory access.
+ *
+ * Since: 2.40
+ **/
+void
+(g_atomic_pointer_store_relaxed) (volatile void *atomic,
+                                  gpointer       newval)
+{
+  g_atomic_pointer_store_relaxed ((volatile gpointer *) atomic, newval);
+}
+
+/**
+ * g_atomic_pointer_compare_and_exchange_full:
+ * @atomic: (type gpointer): a pointer to a #gpointer-sized value
+ * @oldval: the value to compare with
+ * @newval: the value to conditionally replace with
+ * @preval: (type gpointer) (out): the contents of @atomic before this
+ *     operation
+ *
+ * Compares @atomic to @oldval and, if equal, sets it to @newval, like
+ * g_atomic_pointer_compare_and_exchange().  In addition, the value
+ * @atomic had is returned in @preval.
+ *
+ * This call acts as a full compiler and hardware memory barrier.
+ *
+ * Returns: %TRUE if the exchange took place
+ *
+ * Since: 2.40
+ **/
+gboolean
+(g_atomic_pointer_compare_and_exchange_full) (volatile void *atomic,
+                                              gpointer       oldval,
+                                              gpointer       newval,
+                                              void          *preval)
+{
+  return g_atomic_pointer_compare_and_exchange_full ((volatile gpointer *) atomic,
+                                                     oldval, newval,
+                                                     (gpointer *) preval);
+}
+
 #elif defined (G_PLATFORM_WIN32)
 
 #include <windows.h>
@@ -660,6 +867,95 @@ gsize
   return InterlockedXor (atomic, val);
 #endif
 }
+
+gint
+(g_atomic_int_load_acquire) (const volatile gint *atomic)
+{
+  gint value = *atomic;
+
+  MemoryBarrier ();
+  return value;
+}
+
+gint
+(g_atomic_int_load_relaxed) (const volatile gint *atomic)
+{
+  return *atomic;
+}
+
+void
+(g_atomic_int_store_release) (volatile gint *atomic,
+                              gint           newval)
+{
+  MemoryBarrier ();
+  *atomic = newval;
+}
+
+void
+(g_atomic_int_store_relaxed) (volatile gint *atomic,
+                              gint           newval)
+{
+  *atomic = newval;
+}
+
+gboolean
+(g_atomic_int_compare_and_exchange_full) (volatile gint *atomic,
+                                          gint           oldval,
+                                          gint           newval,
+                                          gint          *preval)
+{
+  *preval = InterlockedCompareExchange (atomic, newval, oldval);
+  return *preval == oldval;
+}
+
+gpointer
+(g_atomic_pointer_load_acquire) (const volatile void *atomic)
+{
+  const volatile gpointer *ptr = atomic;
+  gpointer value = *ptr;
+
+  MemoryBarrier ();
+  return value;
+}
+
+gpointer
+(g_atomic_pointer_load_relaxed) (const volatile void *atomic)
+{
+  const volatile gpointer *ptr = atomic;
+
+  return *ptr;
+}
+
+void
+(g_atomic_pointer_store_release) (volatile void *atomic,
+                                  gpointer       newval)
+{
+  volatile gpointer *ptr = atomic;
+
+  MemoryBarrier ();
+  *ptr = newval;
+}
+
+void
+(g_atomic_pointer_store_relaxed) (volatile void *atomic,
+                                  gpointer       newval)
+{
+  volatile gpointer *ptr = atomic;
+
+  *ptr = newval;
+}
+
+gboolean
+(g_atomic_pointer_compare_and_exchange_full) (volatile void *atomic,
+                                              gpointer       oldval,
+                                              gpointer       newval,
+                                              void          *preval)
+{
+  gpointer *pre = preval;
+
+  *pre = InterlockedCompareExchangePointer (atomic, newval, oldval);
+  return *pre == oldval;
+}
 #else
 
 /* This error occurs when ./configure decided that we should be capable
@@ -898,6 +1194,98 @@ gsize
   return oldval;
 }
 
+gint
+(g_atomic_int_load_acquire) (const volatile gint *atomic)
+{
+  return (g_atomic_int_get) (atomic);
+}
+
+gint
+(g_atomic_int_load_relaxed) (const volatile gint *atomic)
+{
+  return (g_atomic_int_get) (atomic);
+}
+
+void
+(g_atomic_int_store_release) (volatile gint *atomic,
+                              gint           newval)
+{
+  (g_atomic_int_set) (atomic, newval);
+}
+
+void
+(g_atomic_int_store_relaxed) (volatile gint *atomic,
+                              gint           newval)
+{
+  (g_atomic_int_set) (atomic, newval);
+}
+
+gboolean
+(g_atomic_int_compare_and_exchange_full) (volatile gint *atomic,
+                                          gint           oldval,
+                                          gint           newval,
+                                          gint          *preval)
+{
+  gboolean success;
+
+  pthread_mutex_lock (&g_atomic_lock);
+
+  *preval = *atomic;
+  if ((success = (*atomic == oldval)))
+    *atomic = newval;
+
+  pthread_mutex_unlock (&g_atomic_lock);
+
+  return success;
+}
+
+gpointer
+(g_atomic_pointer_load_acquire) (const volatile void *atomic)
+{
+  return (g_atomic_pointer_get) (atomic);
+}
+
+gpointer
+(g_atomic_pointer_load_relaxed) (const volatile void *atomic)
+{
+  return (g_atomic_pointer_get) (atomic);
+}
+
+void
+(g_atomic_pointer_store_release) (volatile void *atomic,
+                                  gpointer       newval)
+{
+  (g_atomic_pointer_set) (atomic, newval);
+}
+
+void
+(g_atomic_pointer_store_relaxed) (volatile void *atomic,
+                                  gpointer       newval)
+{
+  (g_atomic_pointer_set) (atomic, newval);
+}
+
+gboolean
+(g_atomic_pointer_compare_and_exchange_full) (volatile void *atomic,
+                                              gpointer       oldval,
+                                              gpointer       newval,
+                                              void          *preval)
+{
+  volatile gpointer *ptr = atomic;
+  gpointer *pre = preval;
+  gboolean success;
+
+  pthread_mutex_lock (&g_atomic_lock);
+
+  *pre = *ptr;
+  if ((success = (*ptr == oldval)))
+    *ptr = newval;
+
+  pthread_mutex_unlock (&g_atomic_lock);
+
+  return success;
+}
+
 #endif
 
 /**
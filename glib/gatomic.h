@@ -55,6 +55,21 @@ guint                   g_atomic_int_or                       (volatile guint *a
 GLIB_AVAILABLE_IN_ALL
 guint                   g_atomic_int_xor                      (volatile guint *atomic,
                                                                guint           val);
+GLIB_AVAILABLE_IN_2_40
+gint                    g_atomic_int_load_acquire             (const volatile gint *atomic);
+GLIB_AVAILABLE_IN_2_40
+gint                    g_atomic_int_load_relaxed             (const volatile gint *atomic);
+GLIB_AVAILABLE_IN_2_40
+void                    g_atomic_int_store_release            (volatile gint  *atomic,
+                                                               gint            newval);
+GLIB_AVAILABLE_IN_2_40
+void                    g_atomic_int_store_relaxed            (volatile gint  *atomic,
+                                                               gint            newval);
+GLIB_AVAILABLE_IN_2_40
+gboolean                g_atomic_int_compare_and_exchange_full (volatile gint *atomic,
+                                                                gint           oldval,
+                                                                gint           newval,
+                                                                gint          *preval);
 
 GLIB_AVAILABLE_IN_ALL
 gpointer                g_atomic_pointer_get                  (const volatile void *atomic);
@@ -77,6 +92,21 @@ gsize                   g_atomic_pointer_or                   (volatile void  *a
 GLIB_AVAILABLE_IN_ALL
 gsize                   g_atomic_pointer_xor                  (volatile void  *atomic,
                                                                gsize           val);
+GLIB_AVAILABLE_IN_2_40
+gpointer                g_atomic_pointer_load_acquire         (const volatile void *atomic);
+GLIB_AVAILABLE_IN_2_40
+gpointer                g_atomic_pointer_load_relaxed         (const volatile void *atomic);
+GLIB_AVAILABLE_IN_2_40
+void                    g_atomic_pointer_store_release        (volatile void  *atomic,
+                                                               gpointer        newval);
+GLIB_AVAILABLE_IN_2_40
+void                    g_atomic_pointer_store_relaxed        (volatile void  *atomic,
+                                                               gpointer        newval);
+GLIB_AVAILABLE_IN_2_40
+gboolean                g_atomic_pointer_compare_and_exchange_full (volatile void *atomic,
+                                                                    gpointer       oldval,
+                                                                    gpointer       newval,
+                                                                    void          *preval);
 
 GLIB_DEPRECATED_IN_2_30_FOR(g_atomic_add)
 gint                    g_atomic_int_exchange_and_add         (volatile gint  *atomic,
@@ -191,6 +221,141 @@ G_END_DECLS
     (gsize) __sync_fetch_and_xor ((atomic), (val));                          \
   }))
 
+#define g_atomic_int_compare_and_exchange_full(atomic, oldval, newval, preval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    gint gaicae_oldval = (oldval);                                           \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    G_STATIC_ASSERT (sizeof *(preval) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ (newval) ^ (oldval) ^ *(preval) : 0);            \
+    *(preval) = __sync_val_compare_and_swap ((atomic), gaicae_oldval, (newval)); \
+    (gboolean) (*(preval) == gaicae_oldval);                                 \
+  }))
+#define g_atomic_pointer_compare_and_exchange_full(atomic, oldval, newval, preval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    __typeof__ (*(atomic)) gapcae_oldval = (oldval);                         \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    G_STATIC_ASSERT (sizeof *(preval) == sizeof (gpointer));                 \
+    (void) (0 ? (gpointer) *(atomic) : 0);                                   \
+    (void) (0 ? (gpointer) *(preval) : 0);                                   \
+    *(preval) = __sync_val_compare_and_swap ((atomic), gapcae_oldval, (newval)); \
+    (gboolean) (*(preval) == gapcae_oldval);                                 \
+  }))
+
+#if defined(__ATOMIC_SEQ_CST)
+
+#define g_atomic_int_load_acquire(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ *(atomic) : 0);                                  \
+    (gint) __atomic_load_n ((atomic), __ATOMIC_ACQUIRE);                     \
+  }))
+#define g_atomic_int_load_relaxed(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ *(atomic) : 0);                                  \
+    (gint) __atomic_load_n ((atomic), __ATOMIC_RELAXED);                     \
+  }))
+#define g_atomic_int_store_release(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ (newval) : 0);                                   \
+    __atomic_store_n ((atomic), (newval), __ATOMIC_RELEASE);                 \
+  }))
+#define g_atomic_int_store_relaxed(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ (newval) : 0);                                   \
+    __atomic_store_n ((atomic), (newval), __ATOMIC_RELAXED);                 \
+  }))
+
+#define g_atomic_pointer_load_acquire(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (gpointer) __atomic_load_n ((atomic), __ATOMIC_ACQUIRE);                 \
+  }))
+#define g_atomic_pointer_load_relaxed(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (gpointer) __atomic_load_n ((atomic), __ATOMIC_RELAXED);                 \
+  }))
+#define g_atomic_pointer_store_release(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (void) (0 ? (gpointer) *(atomic) : 0);                                   \
+    __atomic_store_n ((atomic), (__typeof__ (*(atomic))) (gsize) (newval),   \
+                      __ATOMIC_RELEASE);                                     \
+  }))
+#define g_atomic_pointer_store_relaxed(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (void) (0 ? (gpointer) *(atomic) : 0);                                   \
+    __atomic_store_n ((atomic), (__typeof__ (*(atomic))) (gsize) (newval),   \
+                      __ATOMIC_RELAXED);                                     \
+  }))
+
+#else /* defined(__ATOMIC_SEQ_CST) */
+
+/* Before the __atomic builtins, only full barriers are available */
+#define g_atomic_int_load_acquire(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    gint gailoa_value;                                                       \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ *(atomic) : 0);                                  \
+    gailoa_value = *(volatile __typeof__ (*(atomic)) *) (atomic);            \
+    __sync_synchronize ();                                                   \
+    gailoa_value;                                                            \
+  }))
+#define g_atomic_int_load_relaxed(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ *(atomic) : 0);                                  \
+    (gint) *(volatile __typeof__ (*(atomic)) *) (atomic);                    \
+  }))
+#define g_atomic_int_store_release(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ (newval) : 0);                                   \
+    __sync_synchronize ();                                                   \
+    *(volatile __typeof__ (*(atomic)) *) (atomic) = (newval);                \
+  }))
+#define g_atomic_int_store_relaxed(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gint));                     \
+    (void) (0 ? *(atomic) ^ (newval) : 0);                                   \
+    *(volatile __typeof__ (*(atomic)) *) (atomic) = (newval);                \
+  }))
+
+#define g_atomic_pointer_load_acquire(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    gpointer gaploa_value;                                                   \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    gaploa_value = (gpointer) *(volatile __typeof__ (*(atomic)) *) (atomic); \
+    __sync_synchronize ();                                                   \
+    gaploa_value;                                                            \
+  }))
+#define g_atomic_pointer_load_relaxed(atomic) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (gpointer) *(volatile __typeof__ (*(atomic)) *) (atomic);                \
+  }))
+#define g_atomic_pointer_store_release(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (void) (0 ? (gpointer) *(atomic) : 0);                                   \
+    __sync_synchronize ();                                                   \
+    *(volatile __typeof__ (*(atomic)) *) (atomic) =                          \
+      (__typeof__ (*(atomic))) (gsize) (newval);                             \
+  }))
+#define g_atomic_pointer_store_relaxed(atomic, newval) \
+  (G_GNUC_EXTENSION ({                                                          \
+    G_STATIC_ASSERT (sizeof *(atomic) == sizeof (gpointer));                 \
+    (void) (0 ? (gpointer) *(atomic) : 0);                                   \
+    *(volatile __typeof__ (*(atomic)) *) (atomic) =                          \
+      (__typeof__ (*(atomic))) (gsize) (newval);                             \
+  }))
+
+#endif /* defined(__ATOMIC_SEQ_CST) */
+
 #else /* defined(G_ATOMIC_LOCK_FREE) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4) */
 
 #define g_atomic_int_get(atomic) \
@@ -211,6 +376,16 @@ G_END_DECLS
   (g_atomic_int_inc ((gint *) (atomic)))
 #define g_atomic_int_dec_and_test(atomic) \
   (g_atomic_int_dec_and_test ((gint *) (atomic)))
+#define g_atomic_int_load_acquire(atomic) \
+  (g_atomic_int_load_acquire ((gint *) (atomic)))
+#define g_atomic_int_load_relaxed(atomic) \
+  (g_atomic_int_load_relaxed ((gint *) (atomic)))
+#define g_atomic_int_store_release(atomic, newval) \
+  (g_atomic_int_store_release ((gint *) (atomic), (gint) (newval)))
+#define g_atomic_int_store_relaxed(atomic, newval) \
+  (g_atomic_int_store_relaxed ((gint *) (atomic), (gint) (newval)))
+#define g_atomic_int_compare_and_exchange_full(atomic, oldval, newval, preval) \
+  (g_atomic_int_compare_and_exchange_full ((gint *) (atomic), (oldval), (newval), (gint *) (preval)))
 
 #define g_atomic_pointer_get(atomic) \
   (g_atomic_pointer_get (atomic))
@@ -226,6 +401,16 @@ G_END_DECLS
   (g_atomic_pointer_or ((atomic), (gsize) (val)))
 #define g_atomic_pointer_xor(atomic, val) \
   (g_atomic_pointer_xor ((atomic), (gsize) (val)))
+#define g_atomic_pointer_load_acquire(atomic) \
+  (g_atomic_pointer_load_acquire (atomic))
+#define g_atomic_pointer_load_relaxed(atomic) \
+  (g_atomic_pointer_load_relaxed (atomic))
+#define g_atomic_pointer_store_release(atomic, newval) \
+  (g_atomic_pointer_store_release ((atomic), (gpointer) (newval)))
+#define g_atomic_pointer_store_relaxed(atomic, newval) \
+  (g_atomic_pointer_store_relaxed ((atomic), (gpointer) (newval)))
+#define g_atomic_pointer_compare_and_exchange_full(atomic, oldval, newval, preval) \
+  (g_atomic_pointer_compare_and_exchange_full ((atomic), (gpointer) (oldval), (gpointer) (newval), (preval)))
 
 #endif /* defined(__GNUC__) && defined(G_ATOMIC_OP_USE_GCC_BUILTINS) */
 
@@ -29,8 +29,18 @@
 
 #include "gbase64.h"
 #include "gtestutils.h"
+#include "gthread.h"
 #include "glibintl.h"
 
+/* On x86 processors with SSSE3, long runs are encoded and decoded 16
+ * characters at a time; base64_init_accel() picks the implementation.
+ */
+#if defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined (__x86_64__) || defined (__i386__))
+#define BASE64_X86_ACCEL 1
+#include <immintrin.h>
+#endif
+
 
 /**
  * SECTION:base64
@@ -56,6 +66,141 @@
 static const char base64_alphabet[] =
         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/* Encodes @n_blocks blocks of 12 bytes into 16 characters each.  Up
+ * to 4 bytes past the end of the last block may be read.
+ */
+typedef void  (* Base64EncodeBlocks) (const guchar *in,
+                                      gsize         n_blocks,
+                                      gchar        *out);
+
+/* Decodes up to @n_blocks blocks of 16 characters into 12 bytes each,
+ * stopping at the first block which contains anything other than the
+ * 64 characters of the alphabet.  Returns the number of blocks decoded.
+ */
+typedef gsize (* Base64DecodeBlocks) (const guchar *in,
+                                      gsize         n_blocks,
+                                      guchar       *out);
+
+static Base64EncodeBlocks base64_encode_blocks;
+static Base64DecodeBlocks base64_decode_blocks;
+
+#ifdef BASE64_X86_ACCEL
+/* See Wojciech Muła and Daniel Lemire, "Faster Base64 Encoding and
+ * Decoding Using AVX2 Instructions", and http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+ */
+__attribute__ ((target ("ssse3")))
+static void
+base64_encode_blocks_ssse3 (const guchar *in,
+                            gsize         n_blocks,
+                            gchar        *out)
+{
+  const __m128i spread = _mm_set_epi8 (10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m128i shift_lut = _mm_setr_epi8 ('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+
+  while (n_blocks--)
+    {
+      __m128i v, t0, t1, t2, t3, indices, result, less;
+
+      /* the 4 groups of 3 bytes, each spread over 32 bits */
+      v = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) in), spread);
+
+      /* move each 6 bit index into its own byte */
+      t0 = _mm_and_si128 (v, _mm_set1_epi32 (0x0fc0fc00));
+      t1 = _mm_mulhi_epu16 (t0, _mm_set1_epi32 (0x04000040));
+      t2 = _mm_and_si128 (v, _mm_set1_epi32 (0x003f03f0));
+      t3 = _mm_mullo_epi16 (t2, _mm_set1_epi32 (0x01000010));
+      indices = _mm_or_si128 (t1, t3);
+
+      /* and turn the indices into characters by adding an offset
+       * which depends on their range
+       */
+      result = _mm_subs_epu8 (indices, _mm_set1_epi8 (51));
+      less = _mm_cmpgt_epi8 (_mm_set1_epi8 (26), indices);
+      result = _mm_or_si128 (result, _mm_and_si128 (less, _mm_set1_epi8 (13)));
+      result = _mm_add_epi8 (_mm_shuffle_epi8 (shift_lut, result), indices);
+
+      _mm_storeu_si128 ((__m128i *) out, result);
+
+      in += 12;
+      out += 16;
+    }
+}
+
+__attribute__ ((target ("ssse3")))
+static gsize
+base64_decode_blocks_ssse3 (const guchar *in,
+                            gsize         n_blocks,
+                            guchar       *out)
+{
+  const __m128i lut_lo = _mm_setr_epi8 (0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lut_hi = _mm_setr_epi8 (0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71,
+                                          0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i pack = _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  gsize done;
+
+  for (done = 0; done < n_blocks; done++)
+    {
+      __m128i v, hi_nibbles, lo_nibbles, lo, hi, roll;
+      guint32 tail;
+
+      v = _mm_loadu_si128 ((const __m128i *) in);
+      hi_nibbles = _mm_and_si128 (_mm_srli_epi32 (v, 4), _mm_set1_epi8 (0x0f));
+      lo_nibbles = _mm_and_si128 (v, _mm_set1_epi8 (0x0f));
+
+      /* a character is in the alphabet if the bits for its low and its
+       * high nibble don't overlap
+       */
+      lo = _mm_shuffle_epi8 (lut_lo, lo_nibbles);
+      hi = _mm_shuffle_epi8 (lut_hi, hi_nibbles);
+      if (_mm_movemask_epi8 (_mm_cmpgt_epi8 (_mm_and_si128 (lo, hi), _mm_setzero_si128 ())))
+        break;
+
+      /* characters to 6 bit values, then 4 values to 3 bytes */
+      roll = _mm_shuffle_epi8 (lut_roll,
+                               _mm_add_epi8 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 ('/')), hi_nibbles));
+      v = _mm_add_epi8 (v, roll);
+      v = _mm_maddubs_epi16 (v, _mm_set1_epi32 (0x01400140));
+      v = _mm_madd_epi16 (v, _mm_set1_epi32 (0x00011000));
+      v = _mm_shuffle_epi8 (v, pack);
+
+      /* only 12 of the 16 bytes are output */
+      _mm_storel_epi64 ((__m128i *) out, v);
+      tail = _mm_cvtsi128_si32 (_mm_srli_si128 (v, 8));
+      memcpy (out + 8, &tail, 4);
+
+      in += 16;
+      out += 12;
+    }
+
+  return done;
+}
+#endif /* BASE64_X86_ACCEL */
+
+static void
+base64_init_accel (void)
+{
+  static gsize initialised = 0;
+
+  if (g_once_init_enter (&initialised))
+    {
+#ifdef BASE64_X86_ACCEL
+      if (__builtin_cpu_supports ("ssse3"))
+        {
+          base64_encode_blocks = base64_encode_blocks_ssse3;
+          base64_decode_blocks = base64_decode_blocks_ssse3;
+        }
+#endif
+
+      g_once_init_leave (&initialised, 1);
+    }
+}
+
 /**
  * g_base64_encode_step:
  * @in: (array length=len) (element-type guint8): the binary data to encode
@@ -108,6 +253,8 @@ g_base64_encode_step (const guchar *in,
   if (len <= 0)
     return 0;
 
+  base64_init_accel ();
+
   inptr = in;
   outptr = out;
 
@@ -136,6 +283,30 @@ g_base64_encode_step (const guchar *in,
        */
       while (inptr < inend)
         {
+          /* 16 bytes must be readable for a block of 12 */
+          if (base64_encode_blocks != NULL && inend + 2 - inptr >= 16)
+            {
+              gsize n_blocks = (inend + 2 - inptr - 4) / 12;
+
+              /* a block is 4 groups, and lines are 19 groups long */
+              if (break_lines)
+                n_blocks = MIN (n_blocks, (19 - already) / 4);
+
+              if (n_blocks > 0)
+                {
+                  base64_encode_blocks (inptr, n_blocks, outptr);
+                  inptr += n_blocks * 12;
+                  outptr += n_blocks * 16;
+
+                  if (break_lines && (already += n_blocks * 4) >= 19)
+                    {
+                      *outptr++ = '\n';
+                      already = 0;
+                    }
+                  continue;
+                }
+            }
+
           c1 = *inptr++;
         skip1:
           c2 = *inptr++;
@@ -220,6 +391,7 @@ g_base64_encode_close (gboolean  break_lines,
       goto skip;
     case 1:
       outptr[2] = '=';
+      c2 = 0;  /* only the first saved byte is valid */
     skip:
       outptr [0] = base64_alphabet [ c1 >> 2 ];
       outptr [1] = base64_alphabet [ c2 >> 4 | ( (c1&0x3) << 4 )];
@@ -338,6 +510,8 @@ g_base64_decode_step (const gchar  *in,
   if (len <= 0)
     return 0;
 
+  base64_init_accel ();
+
   inend = (const guchar *)in+len;
   outptr = out;
 
@@ -358,6 +532,23 @@ g_base64_decode_step (const gchar  *in,
   inptr = (const guchar *)in;
   while (inptr < inend)
     {
+      /* whole groups of 16 characters without padding, whitespace or
+       * other characters to skip can be decoded in bulk
+       */
+      if (i == 0 && base64_decode_blocks != NULL && inend - inptr >= 16)
+        {
+          gsize n_blocks;
+
+          n_blocks = base64_decode_blocks (inptr, (inend - inptr) / 16, outptr);
+          if (n_blocks > 0)
+            {
+              inptr += n_blocks * 16;
+              outptr += n_blocks * 12;
+              last[0] = last[1] = 0;
+              continue;
+            }
+        }
+
       c = *inptr++;
       rank = mime_base64_rank [c];
       if (rank != 0xff)
@@ -0,0 +1,394 @@
+/* GLIB - Library of useful routines for C programming
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gbyteslist.h"
+
+#include "gmem.h"
+#include "gmessages.h"
+#include "gslice.h"
+
+/**
+ * SECTION:bytes_lists
+ * @title: Byte Lists
+ * @short_description: a sequence of #GBytes treated as one buffer
+ *
+ * A #GBytesList holds a sequence of #GBytes that together make up one
+ * logical buffer, such as a protocol message assembled from a header,
+ * a payload and a trailer. Adding to the list only takes a reference
+ * on the #GBytes, so nothing is copied until the data is needed in a
+ * single contiguous block, which g_bytes_list_flatten() provides.
+ *
+ * g_bytes_list_split() cuts the buffer in two at any byte offset,
+ * sharing the data of the #GBytes that straddles the cut.
+ *
+ * The pieces can be handed to a vectored write without copying:
+ * |[
+ * GOutputVector *vectors;
+ * guint i, n;
+ *
+ * n = g_bytes_list_get_n_bytes (list);
+ * vectors = g_new (GOutputVector, n);
+ * for (i = 0; i < n; i++)
+ *   vectors[i].buffer = g_bytes_get_data (g_bytes_list_get_nth (list, i),
+ *                                         &amp;vectors[i].size);
+ * g_output_stream_writev_all (stream, vectors, n, NULL, NULL, &amp;error);
+ * ]|
+ *
+ * A #GBytesList is not thread safe, but the #GBytes in it may of
+ * course be shared with other threads.
+ */
+
+/**
+ * GBytesList:
+ *
+ * An opaque data structure representing a list of #GBytes.
+ * It should only be accessed by using the following functions.
+ *
+ * Since: 2.40
+ */
+
+struct _GBytesList
+{
+  GBytes **items;               /* items[first] .. items[first + n_items - 1] */
+  guint    first;
+  guint    n_items;
+  guint    alloc;
+  gsize    size;
+};
+
+#define MIN_BYTES_LIST_SIZE 8
+
+/* Makes sure there are at least @n_front free slots before the first
+ * item and @n_back after the last one.  The items are kept centred in
+ * the array, so that appending and prepending are both amortised O(1).
+ */
+static void
+bytes_list_make_room (GBytesList *list,
+                      guint       n_front,
+                      guint       n_back)
+{
+  guint needed, alloc, first;
+
+  if (list->first >= n_front &&
+      list->alloc - list->first - list->n_items >= n_back)
+    return;
+
+  needed = list->n_items + n_front + n_back;
+  alloc = list->alloc;
+  if (needed > alloc / 2)
+    {
+      alloc = MAX (alloc, MIN_BYTES_LIST_SIZE);
+      while (alloc < 2 * needed)
+        alloc *= 2;
+    }
+
+  first = n_front + (alloc - needed) / 2;
+
+  if (alloc == list->alloc)
+    memmove (list->items + first, list->items + list->first,
+             list->n_items * sizeof (GBytes *));
+  else
+    {
+      GBytes **items = g_new (GBytes *, alloc);
+
+      if (list->n_items > 0)
+        memcpy (items + first, list->items + list->first,
+                list->n_items * sizeof (GBytes *));
+      g_free (list->items);
+      list->items = items;
+      list->alloc = alloc;
+    }
+
+  list->first = first;
+}
+
+/**
+ * g_bytes_list_new:
+ *
+ * Creates a new, empty #GBytesList.
+ *
+ * Returns: a new #GBytesList
+ *
+ * Since: 2.40
+ */
+GBytesList *
+g_bytes_list_new (void)
+{
+  return g_slice_new0 (GBytesList);
+}
+
+/**
+ * g_bytes_list_free:
+ * @list: a #GBytesList
+ *
+ * Releases the references @list holds on its #GBytes and frees @list.
+ *
+ * Since: 2.40
+ */
+void
+g_bytes_list_free (GBytesList *list)
+{
+  guint i;
+
+  g_return_if_fail (list != NULL);
+
+  for (i = 0; i < list->n_items; i++)
+    g_bytes_unref (list->items[list->first + i]);
+
+  g_free (list->items);
+  g_slice_free (GBytesList, list);
+}
+
+/**
+ * g_bytes_list_append:
+ * @list: a #GBytesList
+ * @bytes: a #GBytes
+ *
+ * Adds @bytes at the end of @list. @list takes a reference on @bytes;
+ * the data is not copied. Empty #GBytes are ignored.
+ *
+ * Since: 2.40
+ */
+void
+g_bytes_list_append (GBytesList *list,
+                     GBytes     *bytes)
+{
+  gsize size;
+
+  g_return_if_fail (list != NULL);
+  g_return_if_fail (bytes != NULL);
+
+  size = g_bytes_get_size (bytes);
+  if (size == 0)
+    return;
+
+  bytes_list_make_room (list, 0, 1);
+  list->items[list->first + list->n_items] = g_bytes_ref (bytes);
+  list->n_items++;
+  list->size += size;
+}
+
+/**
+ * g_bytes_list_prepend:
+ * @list: a #GBytesList
+ * @bytes: a #GBytes
+ *
+ * Adds @bytes at the start of @list. @list takes a reference on
+ * @bytes; the data is not copied. Empty #GBytes are ignored.
+ *
+ * Since: 2.40
+ */
+void
+g_bytes_list_prepend (GBytesList *list,
+                      GBytes     *bytes)
+{
+  gsize size;
+
+  g_return_if_fail (list != NULL);
+  g_return_if_fail (bytes != NULL);
+
+  size = g_bytes_get_size (bytes);
+  if (size == 0)
+    return;
+
+  bytes_list_make_room (list, 1, 1);
+  list->first--;
+  list->items[list->first] = g_bytes_ref (bytes);
+  list->n_items++;
+  list->size += size;
+}
+
+/**
+ * g_bytes_list_get_n_bytes:
+ * @list: a #GBytesList
+ *
+ * Gets the number of #GBytes in @list.
+ *
+ * Returns: the number of #GBytes in @list
+ *
+ * Since: 2.40
+ */
+guint
+g_bytes_list_get_n_bytes (GBytesList *list)
+{
+  g_return_val_if_fail (list != NULL, 0);
+
+  return list->n_items;
+}
+
+/**
+ * g_bytes_list_get_nth:
+ * @list: a #GBytesList
+ * @n: the index of the #GBytes to get
+ *
+ * Gets the @n'th #GBytes in @list. Together with
+ * g_bytes_list_get_n_bytes(), this can be used to iterate over the
+ * pieces of the buffer.
+ *
+ * Returns: (transfer none): the @n'th #GBytes in @list
+ *
+ * Since: 2.40
+ */
+GBytes *
+g_bytes_list_get_nth (GBytesList *list,
+                      guint       n)
+{
+  g_return_val_if_fail (list != NULL, NULL);
+  g_return_val_if_fail (n < list->n_items, NULL);
+
+  return list->items[list->first + n];
+}
+
+/**
+ * g_bytes_list_get_size:
+ * @list: a #GBytesList
+ *
+ * Gets the total size of the data in @list.
+ *
+ * Returns: the sum of the sizes of the #GBytes in @list
+ *
+ * Since: 2.40
+ */
+gsize
+g_bytes_list_get_size (GBytesList *list)
+{
+  g_return_val_if_fail (list != NULL, 0);
+
+  return list->size;
+}
+
+/**
+ * g_bytes_list_split:
+ * @list: a #GBytesList
+ * @offset: the byte offset to split @list at
+ *
+ * Splits @list in two: @list keeps the first @offset bytes, and
+ * everything after them is moved to a new #GBytesList. If the split
+ * falls inside a #GBytes, both halves get a #GBytes sharing its data,
+ * as made by g_bytes_new_from_bytes().
+ *
+ * Returns: (transfer full): a new #GBytesList holding the data after @offset
+ *
+ * Since: 2.40
+ */
+GBytesList *
+g_bytes_list_split (GBytesList *list,
+                    gsize       offset)
+{
+  GBytesList *tail;
+  gsize pos;
+  guint i;
+
+  g_return_val_if_fail (list != NULL, NULL);
+  g_return_val_if_fail (offset <= list->size, NULL);
+
+  tail = g_bytes_list_new ();
+
+  /* find the item containing @offset */
+  pos = 0;
+  for (i = 0; i < list->n_items; i++)
+    {
+      gsize size = g_bytes_get_size (list->items[list->first + i]);
+
+      if (pos + size > offset)
+        break;
+      pos += size;
+    }
+
+  if (i == list->n_items)
+    return tail;
+
+  bytes_list_make_room (tail, 0, list->n_items - i);
+
+  if (pos < offset)
+    {
+      GBytes *bytes = list->items[list->first + i];
+      gsize size = g_bytes_get_size (bytes);
+
+      list->items[list->first + i] = g_bytes_new_from_bytes (bytes, 0, offset - pos);
+      tail->items[tail->first] = g_bytes_new_from_bytes (bytes, offset - pos,
+                                                         size - (offset - pos));
+      tail->n_items = 1;
+      g_bytes_unref (bytes);
+      i++;
+    }
+
+  memcpy (tail->items + tail->first + tail->n_items, list->items + list->first + i,
+          (list->n_items - i) * sizeof (GBytes *));
+  tail->n_items += list->n_items - i;
+  tail->size = list->size - offset;
+
+  list->n_items = i;
+  list->size = offset;
+
+  return tail;
+}
+
+/**
+ * g_bytes_list_flatten:
+ * @list: a #GBytesList
+ *
+ * Gets the contents of @list as a single contiguous #GBytes.
+ *
+ * If @list holds more than one #GBytes, their data is copied into a
+ * new #GBytes, which then replaces them in @list, so that flattening
+ * again is free. Otherwise no data is copied.
+ *
+ * Returns: (transfer full): a #GBytes with all the data in @list
+ *
+ * Since: 2.40
+ */
+GBytes *
+g_bytes_list_flatten (GBytesList *list)
+{
+  GBytes *bytes;
+  guint8 *data;
+  gsize pos;
+  guint i;
+
+  g_return_val_if_fail (list != NULL, NULL);
+
+  if (list->n_items == 0)
+    return g_bytes_new (NULL, 0);
+
+  if (list->n_items == 1)
+    return g_bytes_ref (list->items[list->first]);
+
+  data = g_malloc (list->size);
+  pos = 0;
+  for (i = 0; i < list->n_items; i++)
+    {
+      gsize size;
+      gconstpointer piece;
+
+      piece = g_bytes_get_data (list->items[list->first + i], &size);
+      memcpy (data + pos, piece, size);
+      pos += size;
+      g_bytes_unref (list->items[list->first + i]);
+    }
+
+  bytes = g_bytes_new_take (data, list->size);
+  list->items[list->first] = g_bytes_ref (bytes);
+  list->n_items = 1;
+
+  return bytes;
+}
@@ -0,0 +1,57 @@
+/* GLIB - Library of useful routines for C programming
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_BYTES_LIST_H__
+#define __G_BYTES_LIST_H__
+
+#if !defined (__GLIB_H_INSIDE__) && !defined (GLIB_COMPILATION)
+#error "Only <glib.h> can be included directly."
+#endif
+
+#include <glib/gbytes.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GBytesList GBytesList;
+
+GLIB_AVAILABLE_IN_2_40
+GBytesList * g_bytes_list_new         (void);
+GLIB_AVAILABLE_IN_2_40
+void         g_bytes_list_free        (GBytesList *list);
+GLIB_AVAILABLE_IN_2_40
+void         g_bytes_list_append      (GBytesList *list,
+                                       GBytes     *bytes);
+GLIB_AVAILABLE_IN_2_40
+void         g_bytes_list_prepend     (GBytesList *list,
+                                       GBytes     *bytes);
+GLIB_AVAILABLE_IN_2_40
+guint        g_bytes_list_get_n_bytes (GBytesList *list);
+GLIB_AVAILABLE_IN_2_40
+GBytes *     g_bytes_list_get_nth     (GBytesList *list,
+                                       guint       n);
+GLIB_AVAILABLE_IN_2_40
+gsize        g_bytes_list_get_size    (GBytesList *list);
+GLIB_AVAILABLE_IN_2_40
+GBytesList * g_bytes_list_split       (GBytesList *list,
+                                       gsize       offset);
+GLIB_AVAILABLE_IN_2_40
+GBytes *     g_bytes_list_flatten     (GBytesList *list);
+
+G_END_DECLS
+
+#endif /* __G_BYTES_LIST_H__ */
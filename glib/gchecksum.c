@@ -28,9 +28,21 @@
 #include "gmem.h"
 #include "gstrfuncs.h"
 #include "gtestutils.h"
+#include "gthread.h"
+#include "gthreadpool.h"
 #include "gtypes.h"
 #include "glibintl.h"
 
+/* SHA-256 and CRC32C have versions using the SHA and SSE4.2 extensions
+ * of x86 processors, chosen at runtime by checksum_init_accel().
+ */
+#if defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined (__x86_64__) || defined (__i386__))
+#define CHECKSUM_X86_ACCEL 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 
 /**
  * SECTION:checksum
@@ -51,10 +63,18 @@
  * one go, use the convenience functions g_compute_checksum_for_data()
  * and g_compute_checksum_for_string(), respectively.
  *
+ * Besides the cryptographic hashes, %G_CHECKSUM_CRC32C and
+ * %G_CHECKSUM_XXH64 are provided for detecting accidental corruption
+ * of large amounts of data, where they are much faster. They offer no
+ * protection against deliberate tampering.
+ *
+ * Where the processor supports it, SHA-256 and CRC32C are computed
+ * with dedicated instructions.
+ *
  * Support for checksums has been added in GLib 2.16
  **/
 
-#define IS_VALID_TYPE(type)     ((type) >= G_CHECKSUM_MD5 && (type) <= G_CHECKSUM_SHA512)
+#define IS_VALID_TYPE(type)     ((type) >= G_CHECKSUM_MD5 && (type) <= G_CHECKSUM_XXH64)
 
 /* The fact that these are lower case characters is part of the ABI */
 static const gchar hex_digits[] = "0123456789abcdef";
@@ -117,6 +137,29 @@ typedef struct
   guchar digest[SHA512_DIGEST_LEN];
 } Sha512sum;
 
+#define CRC32C_DIGEST_LEN       4
+
+typedef struct
+{
+  guint32 crc;
+
+  guchar digest[CRC32C_DIGEST_LEN];
+} Crc32csum;
+
+#define XXH64_BLOCK_LEN         32
+#define XXH64_DIGEST_LEN        8
+
+typedef struct
+{
+  guint64 v[4];
+  guint64 total_len;
+
+  guint8 block[XXH64_BLOCK_LEN];
+  guint8 block_len;
+
+  guchar digest[XXH64_DIGEST_LEN];
+} Xxh64sum;
+
 struct _GChecksum
 {
   GChecksumType type;
@@ -128,9 +171,30 @@ struct _GChecksum
     Sha1sum sha1;
     Sha256sum sha256;
     Sha512sum sha512;
+    Crc32csum crc32c;
+    Xxh64sum xxh64;
   } sum;
 };
 
+static void    sha256_transform_blocks_generic (guint32       buf[8],
+                                                const guint8 *data,
+                                                gsize         n_blocks);
+static guint32 crc32c_update_generic           (guint32       crc,
+                                                const guint8 *data,
+                                                gsize         length);
+
+static void    (* sha256_transform_blocks) (guint32       buf[8],
+                                            const guint8 *data,
+                                            gsize         n_blocks);
+static guint32 (* crc32c_update)           (guint32       crc,
+                                            const guint8 *data,
+                                            gsize         length);
+
+/* whether g_compute_checksum_for_data_many() should hash SHA-256
+ * inputs side by side in SIMD lanes
+ */
+static gboolean sha256_use_multi_buffer;
+
 /* we need different byte swapping functions because MD5 expects buffers
  * to be little-endian, while SHA1 and SHA256 expect them in big-endian
  * form.
@@ -985,6 +1049,303 @@ sha256_transform (guint32      buf[8],
   buf[7] += H;
 }
 
+static void
+sha256_transform_blocks_generic (guint32       buf[8],
+                                 const guint8 *data,
+                                 gsize         n_blocks)
+{
+  while (n_blocks--)
+    {
+      sha256_transform (buf, data);
+      data += SHA256_DATASIZE;
+    }
+}
+
+#ifdef CHECKSUM_X86_ACCEL
+static const guint32 sha256_k[64] = {
+  0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+  0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+  0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+  0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+  0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+  0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+  0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+  0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+  0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+  0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+  0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+  0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+  0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+  0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+  0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+  0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+/* The SHA extensions keep the state as the two vectors ABEF and CDGH,
+ * and do two rounds per sha256rnds2 instruction.
+ */
+__attribute__ ((target ("sha,sse4.1")))
+static void
+sha256_transform_blocks_shani (guint32       buf[8],
+                               const guint8 *data,
+                               gsize         n_blocks)
+{
+  const __m128i bswap_mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                             0x0405060700010203ULL);
+  __m128i state0, state1, abef, cdgh, msg, tmp;
+  __m128i w[4];
+  gint i;
+
+  tmp = _mm_loadu_si128 ((const __m128i *) &buf[0]);
+  state1 = _mm_loadu_si128 ((const __m128i *) &buf[4]);
+  tmp = _mm_shuffle_epi32 (tmp, 0xB1);              /* CDAB */
+  state1 = _mm_shuffle_epi32 (state1, 0x1B);        /* EFGH */
+  state0 = _mm_alignr_epi8 (tmp, state1, 8);        /* ABEF */
+  state1 = _mm_blend_epi16 (state1, tmp, 0xF0);     /* CDGH */
+
+  while (n_blocks--)
+    {
+      abef = state0;
+      cdgh = state1;
+
+      /* w[i & 3] holds message words 4i..4i+3; the older ones it
+       * replaces are the ones the schedule needs to compute them
+       */
+      for (i = 0; i < 16; i++)
+        {
+          if (i < 4)
+            w[i] = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 16 * i)),
+                                     bswap_mask);
+          else
+            w[i & 3] = _mm_sha256msg2_epu32 (_mm_add_epi32 (_mm_sha256msg1_epu32 (w[i & 3], w[(i + 1) & 3]),
+                                                            _mm_alignr_epi8 (w[(i + 3) & 3], w[(i + 2) & 3], 4)),
+                                             w[(i + 3) & 3]);
+
+          msg = _mm_add_epi32 (w[i & 3], _mm_loadu_si128 ((const __m128i *) &sha256_k[4 * i]));
+          state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+          msg = _mm_shuffle_epi32 (msg, 0x0E);
+          state0 = _mm_sha256rnds2_epu32 (state0, state1, msg);
+        }
+
+      state0 = _mm_add_epi32 (state0, abef);
+      state1 = _mm_add_epi32 (state1, cdgh);
+
+      data += SHA256_DATASIZE;
+    }
+
+  tmp = _mm_shuffle_epi32 (state0, 0x1B);           /* FEBA */
+  state1 = _mm_shuffle_epi32 (state1, 0xB1);        /* DCHG */
+  state0 = _mm_blend_epi16 (tmp, state1, 0xF0);     /* DCBA */
+  state1 = _mm_alignr_epi8 (state1, tmp, 8);        /* HGFE */
+
+  _mm_storeu_si128 ((__m128i *) &buf[0], state0);
+  _mm_storeu_si128 ((__m128i *) &buf[4], state1);
+}
+
+/* Multi-buffer SHA-256: each of the 8 lanes of the AVX2 registers
+ * hashes a block of a different message.  @state holds word j of the
+ * state of lane l in state[j * 8 + l].
+ */
+#define SHA256_LANES 8
+
+__attribute__ ((target ("avx2")))
+static void
+sha256_transform_x8_avx2 (guint32       state[8 * SHA256_LANES],
+                          const guint8 *blocks[SHA256_LANES])
+{
+  __m256i s[8], w[16];
+  __m256i a, b, c, d, e, f, g, h, t1, t2;
+  gint t, l;
+
+#define ROTR(x,n)  _mm256_or_si256 (_mm256_srli_epi32 (x, n), _mm256_slli_epi32 (x, 32 - (n)))
+#define XOR3(x,y,z) _mm256_xor_si256 (_mm256_xor_si256 (x, y), z)
+
+  for (t = 0; t < 16; t++)
+    {
+      guint32 words[SHA256_LANES];
+
+      for (l = 0; l < SHA256_LANES; l++)
+        {
+          memcpy (&words[l], blocks[l] + 4 * t, 4);
+          words[l] = GUINT32_FROM_BE (words[l]);
+        }
+      w[t] = _mm256_loadu_si256 ((const __m256i *) words);
+    }
+
+  for (t = 0; t < 8; t++)
+    s[t] = _mm256_loadu_si256 ((const __m256i *) &state[t * SHA256_LANES]);
+
+  a = s[0]; b = s[1]; c = s[2]; d = s[3];
+  e = s[4]; f = s[5]; g = s[6]; h = s[7];
+
+  for (t = 0; t < 64; t++)
+    {
+      __m256i wt;
+
+      if (t < 16)
+        wt = w[t];
+      else
+        {
+          __m256i w2 = w[(t - 2) & 15], w15 = w[(t - 15) & 15];
+
+          wt = _mm256_add_epi32 (_mm256_add_epi32 (w[t & 15], w[(t - 7) & 15]),
+                                 _mm256_add_epi32 (XOR3 (ROTR (w15, 7), ROTR (w15, 18), _mm256_srli_epi32 (w15, 3)),
+                                                   XOR3 (ROTR (w2, 17), ROTR (w2, 19), _mm256_srli_epi32 (w2, 10))));
+          w[t & 15] = wt;
+        }
+
+      t1 = _mm256_add_epi32 (_mm256_add_epi32 (h, XOR3 (ROTR (e, 6), ROTR (e, 11), ROTR (e, 25))),
+                             _mm256_add_epi32 (_mm256_xor_si256 (g, _mm256_and_si256 (e, _mm256_xor_si256 (f, g))),
+                                               _mm256_add_epi32 (_mm256_set1_epi32 (sha256_k[t]), wt)));
+      t2 = _mm256_add_epi32 (XOR3 (ROTR (a, 2), ROTR (a, 13), ROTR (a, 22)),
+                             _mm256_or_si256 (_mm256_and_si256 (a, b), _mm256_and_si256 (c, _mm256_or_si256 (a, b))));
+
+      h = g; g = f; f = e;
+      e = _mm256_add_epi32 (d, t1);
+      d = c; c = b; b = a;
+      a = _mm256_add_epi32 (t1, t2);
+    }
+
+#undef ROTR
+#undef XOR3
+
+  s[0] = _mm256_add_epi32 (s[0], a);
+  s[1] = _mm256_add_epi32 (s[1], b);
+  s[2] = _mm256_add_epi32 (s[2], c);
+  s[3] = _mm256_add_epi32 (s[3], d);
+  s[4] = _mm256_add_epi32 (s[4], e);
+  s[5] = _mm256_add_epi32 (s[5], f);
+  s[6] = _mm256_add_epi32 (s[6], g);
+  s[7] = _mm256_add_epi32 (s[7], h);
+
+  for (t = 0; t < 8; t++)
+    _mm256_storeu_si256 ((__m256i *) &state[t * SHA256_LANES], s[t]);
+}
+
+typedef struct
+{
+  gsize         index;      /* which input the lane is hashing */
+  const guint8 *data;       /* the next full block of the input */
+  gsize         n_blocks;   /* full blocks left in the input */
+  guint8        tail[2 * SHA256_DATASIZE];
+  guint         n_tail;     /* tail blocks, with padding and length */
+  guint         tail_pos;
+} Sha256Lane;
+
+static void
+sha256_lane_start (Sha256Lane   *lane,
+                   guint32      *state,
+                   guint         l,
+                   gsize         index,
+                   const guint8 *data,
+                   gsize         length)
+{
+  static const guint32 iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  gsize rest = length % SHA256_DATASIZE;
+  guint64 bits = (guint64) length * 8;
+  guint i;
+
+  lane->index = index;
+  lane->data = data;
+  lane->n_blocks = length / SHA256_DATASIZE;
+  lane->n_tail = (rest < 56) ? 1 : 2;
+  lane->tail_pos = 0;
+
+  memset (lane->tail, 0, sizeof lane->tail);
+  if (rest > 0)
+    memcpy (lane->tail, data + length - rest, rest);
+  lane->tail[rest] = 0x80;
+  for (i = 0; i < 8; i++)
+    lane->tail[lane->n_tail * SHA256_DATASIZE - 1 - i] = bits >> (8 * i);
+
+  for (i = 0; i < 8; i++)
+    state[i * SHA256_LANES + l] = iv[i];
+}
+
+/* hashes @n_data SHA-256 inputs, SHA256_LANES at a time */
+static void
+sha256_many_x8 (const guchar * const *data,
+                const gsize          *lengths,
+                gsize                 n_data,
+                guint8               *digests)
+{
+  static const guint8 idle_block[SHA256_DATASIZE];
+  Sha256Lane lanes[SHA256_LANES];
+  guint32 state[8 * SHA256_LANES];
+  const guint8 *blocks[SHA256_LANES];
+  gboolean active[SHA256_LANES];
+  gsize next = 0;
+  guint n_active = 0;
+  guint l, i;
+
+  for (l = 0; l < SHA256_LANES; l++)
+    {
+      active[l] = next < n_data;
+      if (active[l])
+        {
+          sha256_lane_start (&lanes[l], state, l, next, data[next], lengths[next]);
+          next++;
+          n_active++;
+        }
+    }
+
+  while (n_active > 0)
+    {
+      for (l = 0; l < SHA256_LANES; l++)
+        {
+          Sha256Lane *lane = &lanes[l];
+
+          if (!active[l])
+            blocks[l] = idle_block;
+          else if (lane->n_blocks > 0)
+            {
+              blocks[l] = lane->data;
+              lane->data += SHA256_DATASIZE;
+              lane->n_blocks--;
+            }
+          else
+            blocks[l] = lane->tail + SHA256_DATASIZE * lane->tail_pos++;
+        }
+
+      sha256_transform_x8_avx2 (state, blocks);
+
+      for (l = 0; l < SHA256_LANES; l++)
+        {
+          Sha256Lane *lane = &lanes[l];
+          guint8 *digest;
+
+          if (!active[l] || lane->n_blocks > 0 || lane->tail_pos < lane->n_tail)
+            continue;
+
+          digest = digests + lane->index * SHA256_DIGEST_LEN;
+          for (i = 0; i < 8; i++)
+            {
+              guint32 word = state[i * SHA256_LANES + l];
+
+              digest[4 * i] = word >> 24;
+              digest[4 * i + 1] = word >> 16;
+              digest[4 * i + 2] = word >> 8;
+              digest[4 * i + 3] = word;
+            }
+
+          if (next < n_data)
+            {
+              sha256_lane_start (lane, state, l, next, data[next], lengths[next]);
+              next++;
+            }
+          else
+            {
+              active[l] = FALSE;
+              n_active--;
+            }
+        }
+    }
+}
+#endif /* CHECKSUM_X86_ACCEL */
+
 static void
 sha256_sum_update (Sha256sum    *sha256,
                    const guchar *buffer,
@@ -1009,19 +1370,21 @@ sha256_sum_update (Sha256sum    *sha256,
     {
       memcpy ((sha256->data + left), input, fill);
 
-      sha256_transform (sha256->buf, sha256->data);
+      sha256_transform_blocks (sha256->buf, sha256->data, 1);
       length -= fill;
       input += fill;
 
       left = 0;
     }
 
-  while (length >= SHA256_DATASIZE)
+  if (length >= SHA256_DATASIZE)
     {
-      sha256_transform (sha256->buf, input);
+      gsize n_blocks = length / SHA256_DATASIZE;
+
+      sha256_transform_blocks (sha256->buf, input, n_blocks);
 
-      length -= 64;
-      input += 64;
+      length -= n_blocks * SHA256_DATASIZE;
+      input += n_blocks * SHA256_DATASIZE;
     }
 
   if (length)
@@ -1364,6 +1727,354 @@ sha512_sum_digest (Sha512sum *sha512,
 
 #undef PUT_UINT64
 
+/*
+ * CRC32C Checksum
+ *
+ * The Castagnoli CRC (reflected polynomial 0x82F63B78), as used by
+ * iSCSI, SCTP, ext4 and btrfs among others. The digest is the CRC in
+ * big-endian byte order.
+ */
+
+#define CRC32C_POLY 0x82F63B78
+
+static guint32 crc32c_table[256];
+
+static void
+crc32c_init_table (void)
+{
+  guint32 i, j, crc;
+
+  for (i = 0; i < 256; i++)
+    {
+      crc = i;
+      for (j = 0; j < 8; j++)
+        crc = (crc >> 1) ^ (CRC32C_POLY & (0 - (crc & 1)));
+      crc32c_table[i] = crc;
+    }
+}
+
+static guint32
+crc32c_update_generic (guint32       crc,
+                       const guint8 *data,
+                       gsize         length)
+{
+  while (length--)
+    crc = (crc >> 8) ^ crc32c_table[(crc ^ *data++) & 0xFF];
+
+  return crc;
+}
+
+#ifdef CHECKSUM_X86_ACCEL
+__attribute__ ((target ("sse4.2")))
+static guint32
+crc32c_update_sse42 (guint32       crc,
+                     const guint8 *data,
+                     gsize         length)
+{
+#ifdef __x86_64__
+  guint64 crc64 = crc;
+
+  while (length >= 8)
+    {
+      guint64 word;
+
+      memcpy (&word, data, 8);
+      crc64 = _mm_crc32_u64 (crc64, word);
+      data += 8;
+      length -= 8;
+    }
+
+  crc = crc64;
+#endif
+
+  while (length >= 4)
+    {
+      guint32 word;
+
+      memcpy (&word, data, 4);
+      crc = _mm_crc32_u32 (crc, word);
+      data += 4;
+      length -= 4;
+    }
+
+  while (length--)
+    crc = _mm_crc32_u8 (crc, *data++);
+
+  return crc;
+}
+#endif /* CHECKSUM_X86_ACCEL */
+
+static void
+crc32c_sum_init (Crc32csum *crc32c)
+{
+  crc32c->crc = 0xFFFFFFFF;
+}
+
+static void
+crc32c_sum_update (Crc32csum    *crc32c,
+                   const guchar *buffer,
+                   gsize         length)
+{
+  crc32c->crc = crc32c_update (crc32c->crc, buffer, length);
+}
+
+static void
+crc32c_sum_close (Crc32csum *crc32c)
+{
+  guint32 crc = crc32c->crc ^ 0xFFFFFFFF;
+
+  crc32c->digest[0] = crc >> 24;
+  crc32c->digest[1] = crc >> 16;
+  crc32c->digest[2] = crc >> 8;
+  crc32c->digest[3] = crc;
+}
+
+static gchar *
+crc32c_sum_to_string (Crc32csum *crc32c)
+{
+  return digest_to_string (crc32c->digest, CRC32C_DIGEST_LEN);
+}
+
+static void
+crc32c_sum_digest (Crc32csum *crc32c,
+                   guint8    *digest)
+{
+  memcpy (digest, crc32c->digest, CRC32C_DIGEST_LEN);
+}
+
+/*
+ * XXH64 Checksum
+ *
+ * The 64 bit xxHash by Yann Collet, with a seed of 0, following
+ * https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md.
+ * The digest is the hash in big-endian byte order, which is the
+ * canonical representation.
+ */
+
+#define XXH_PRIME64_1 G_GUINT64_CONSTANT (0x9E3779B185EBCA87)
+#define XXH_PRIME64_2 G_GUINT64_CONSTANT (0xC2B2AE3D27D4EB4F)
+#define XXH_PRIME64_3 G_GUINT64_CONSTANT (0x165667B19E3779F9)
+#define XXH_PRIME64_4 G_GUINT64_CONSTANT (0x85EBCA77C2B2AE63)
+#define XXH_PRIME64_5 G_GUINT64_CONSTANT (0x27D4EB2F165667C5)
+
+#define XXH_ROTL64(x,r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline guint64
+xxh64_read64 (const guint8 *p)
+{
+  guint64 v;
+
+  memcpy (&v, p, 8);
+
+  return GUINT64_FROM_LE (v);
+}
+
+static inline guint32
+xxh64_read32 (const guint8 *p)
+{
+  guint32 v;
+
+  memcpy (&v, p, 4);
+
+  return GUINT32_FROM_LE (v);
+}
+
+static inline guint64
+xxh64_round (guint64 acc,
+             guint64 input)
+{
+  acc += input * XXH_PRIME64_2;
+  acc = XXH_ROTL64 (acc, 31);
+
+  return acc * XXH_PRIME64_1;
+}
+
+static inline guint64
+xxh64_merge_round (guint64 acc,
+                   guint64 val)
+{
+  acc ^= xxh64_round (0, val);
+
+  return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void
+xxh64_sum_init (Xxh64sum *xxh64)
+{
+  xxh64->v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+  xxh64->v[1] = XXH_PRIME64_2;
+  xxh64->v[2] = 0;
+  xxh64->v[3] = -XXH_PRIME64_1;
+  xxh64->total_len = 0;
+  xxh64->block_len = 0;
+}
+
+static void
+xxh64_process (guint64       v[4],
+               const guint8 *data,
+               gsize         n_blocks)
+{
+  guint64 v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+
+  while (n_blocks--)
+    {
+      v0 = xxh64_round (v0, xxh64_read64 (data));
+      v1 = xxh64_round (v1, xxh64_read64 (data + 8));
+      v2 = xxh64_round (v2, xxh64_read64 (data + 16));
+      v3 = xxh64_round (v3, xxh64_read64 (data + 24));
+      data += XXH64_BLOCK_LEN;
+    }
+
+  v[0] = v0;
+  v[1] = v1;
+  v[2] = v2;
+  v[3] = v3;
+}
+
+static void
+xxh64_sum_update (Xxh64sum     *xxh64,
+                  const guchar *buffer,
+                  gsize         length)
+{
+  gsize n_blocks;
+
+  xxh64->total_len += length;
+
+  if (xxh64->block_len > 0)
+    {
+      gsize fill = MIN (length, (gsize) (XXH64_BLOCK_LEN - xxh64->block_len));
+
+      memcpy (xxh64->block + xxh64->block_len, buffer, fill);
+      xxh64->block_len += fill;
+      buffer += fill;
+      length -= fill;
+
+      if (xxh64->block_len < XXH64_BLOCK_LEN)
+        return;
+
+      xxh64_process (xxh64->v, xxh64->block, 1);
+      xxh64->block_len = 0;
+    }
+
+  n_blocks = length / XXH64_BLOCK_LEN;
+  xxh64_process (xxh64->v, buffer, n_blocks);
+  buffer += n_blocks * XXH64_BLOCK_LEN;
+  length -= n_blocks * XXH64_BLOCK_LEN;
+
+  memcpy (xxh64->block, buffer, length);
+  xxh64->block_len = length;
+}
+
+static void
+xxh64_sum_close (Xxh64sum *xxh64)
+{
+  const guint8 *p = xxh64->block;
+  const guint8 *end = xxh64->block + xxh64->block_len;
+  guint64 h;
+  gint i;
+
+  if (xxh64->total_len >= XXH64_BLOCK_LEN)
+    {
+      h = XXH_ROTL64 (xxh64->v[0], 1) + XXH_ROTL64 (xxh64->v[1], 7) +
+          XXH_ROTL64 (xxh64->v[2], 12) + XXH_ROTL64 (xxh64->v[3], 18);
+      for (i = 0; i < 4; i++)
+        h = xxh64_merge_round (h, xxh64->v[i]);
+    }
+  else
+    h = XXH_PRIME64_5;
+
+  h += xxh64->total_len;
+
+  for (; p + 8 <= end; p += 8)
+    {
+      h ^= xxh64_round (0, xxh64_read64 (p));
+      h = XXH_ROTL64 (h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+
+  if (p + 4 <= end)
+    {
+      h ^= xxh64_read32 (p) * XXH_PRIME64_1;
+      h = XXH_ROTL64 (h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+      p += 4;
+    }
+
+  for (; p < end; p++)
+    {
+      h ^= *p * XXH_PRIME64_5;
+      h = XXH_ROTL64 (h, 11) * XXH_PRIME64_1;
+    }
+
+  h ^= h >> 33;
+  h *= XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= XXH_PRIME64_3;
+  h ^= h >> 32;
+
+  for (i = 0; i < XXH64_DIGEST_LEN; i++)
+    xxh64->digest[i] = h >> (56 - 8 * i);
+}
+
+static gchar *
+xxh64_sum_to_string (Xxh64sum *xxh64)
+{
+  return digest_to_string (xxh64->digest, XXH64_DIGEST_LEN);
+}
+
+static void
+xxh64_sum_digest (Xxh64sum *xxh64,
+                  guint8   *digest)
+{
+  memcpy (digest, xxh64->digest, XXH64_DIGEST_LEN);
+}
+
+#undef XXH_ROTL64
+
+/* picks the fastest implementations the processor supports */
+static void
+checksum_init_accel (void)
+{
+  static gsize initialised = 0;
+
+  if (g_once_init_enter (&initialised))
+    {
+      gboolean have_sha = FALSE, have_sse42 = FALSE;
+
+#ifdef CHECKSUM_X86_ACCEL
+      guint eax, ebx, ecx, edx;
+
+      if (__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+        {
+          gboolean have_sse41 = (ecx & bit_SSE4_1) != 0;
+
+          have_sse42 = (ecx & bit_SSE4_2) != 0;
+
+          if (have_sse41 && __get_cpuid_max (0, NULL) >= 7)
+            {
+              __cpuid_count (7, 0, eax, ebx, ecx, edx);
+              have_sha = (ebx & (1 << 29)) != 0;
+            }
+        }
+
+      if (have_sha)
+        sha256_transform_blocks = sha256_transform_blocks_shani;
+      else
+        sha256_use_multi_buffer = __builtin_cpu_supports ("avx2");
+      if (have_sse42)
+        crc32c_update = crc32c_update_sse42;
+#endif
+
+      if (!have_sha)
+        sha256_transform_blocks = sha256_transform_blocks_generic;
+      if (!have_sse42)
+        {
+          crc32c_init_table ();
+          crc32c_update = crc32c_update_generic;
+        }
+
+      g_once_init_leave (&initialised, 1);
+    }
+}
+
 /*
  * Public API
  */
@@ -1398,6 +2109,12 @@ g_checksum_type_get_length (GChecksumType checksum_type)
     case G_CHECKSUM_SHA512:
       len = SHA512_DIGEST_LEN;
       break;
+    case G_CHECKSUM_CRC32C:
+      len = CRC32C_DIGEST_LEN;
+      break;
+    case G_CHECKSUM_XXH64:
+      len = XXH64_DIGEST_LEN;
+      break;
     default:
       len = -1;
       break;
@@ -1437,6 +2154,8 @@ g_checksum_new (GChecksumType checksum_type)
   if (! IS_VALID_TYPE (checksum_type))
     return NULL;
 
+  checksum_init_accel ();
+
   checksum = g_slice_new0 (GChecksum);
   checksum->type = checksum_type;
 
@@ -1475,6 +2194,12 @@ g_checksum_reset (GChecksum *checksum)
     case G_CHECKSUM_SHA512:
       sha512_sum_init (&(checksum->sum.sha512));
       break;
+    case G_CHECKSUM_CRC32C:
+      crc32c_sum_init (&(checksum->sum.crc32c));
+      break;
+    case G_CHECKSUM_XXH64:
+      xxh64_sum_init (&(checksum->sum.xxh64));
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -1573,6 +2298,12 @@ g_checksum_update (GChecksum    *checksum,
     case G_CHECKSUM_SHA512:
       sha512_sum_update (&(checksum->sum.sha512), data, length);
       break;
+    case G_CHECKSUM_CRC32C:
+      crc32c_sum_update (&(checksum->sum.crc32c), data, length);
+      break;
+    case G_CHECKSUM_XXH64:
+      xxh64_sum_update (&(checksum->sum.xxh64), data, length);
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -1624,6 +2355,14 @@ g_checksum_get_string (GChecksum *checksum)
       sha512_sum_close (&(checksum->sum.sha512));
       str = sha512_sum_to_string (&(checksum->sum.sha512));
       break;
+    case G_CHECKSUM_CRC32C:
+      crc32c_sum_close (&(checksum->sum.crc32c));
+      str = crc32c_sum_to_string (&(checksum->sum.crc32c));
+      break;
+    case G_CHECKSUM_XXH64:
+      xxh64_sum_close (&(checksum->sum.xxh64));
+      str = xxh64_sum_to_string (&(checksum->sum.xxh64));
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -1699,6 +2438,22 @@ g_checksum_get_digest (GChecksum  *checksum,
         }
       sha512_sum_digest (&(checksum->sum.sha512), buffer);
       break;
+    case G_CHECKSUM_CRC32C:
+      if (checksum_open)
+        {
+          crc32c_sum_close (&(checksum->sum.crc32c));
+          str = crc32c_sum_to_string (&(checksum->sum.crc32c));
+        }
+      crc32c_sum_digest (&(checksum->sum.crc32c), buffer);
+      break;
+    case G_CHECKSUM_XXH64:
+      if (checksum_open)
+        {
+          xxh64_sum_close (&(checksum->sum.xxh64));
+          str = xxh64_sum_to_string (&(checksum->sum.xxh64));
+        }
+      xxh64_sum_digest (&(checksum->sum.xxh64), buffer);
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -1807,3 +2562,202 @@ g_compute_checksum_for_bytes (GChecksumType  checksum_type,
   byte_data = g_bytes_get_data (data, &length);
   return g_compute_checksum_for_data (checksum_type, byte_data, length);
 }
+
+/* Below this many bytes in total, hashing a batch of inputs on one
+ * thread is faster than handing it out to several.
+ */
+#define CHECKSUM_PARALLEL_THRESHOLD (1 << 20)
+
+static void
+compute_digest (GChecksumType  checksum_type,
+                const guchar  *data,
+                gsize          length,
+                guint8        *digest)
+{
+  GChecksum checksum;
+
+  checksum.type = checksum_type;
+  checksum.digest_str = NULL;
+  g_checksum_reset (&checksum);
+  g_checksum_update (&checksum, data, length);
+
+  switch (checksum_type)
+    {
+    case G_CHECKSUM_MD5:
+      md5_sum_close (&(checksum.sum.md5));
+      md5_sum_digest (&(checksum.sum.md5), digest);
+      break;
+    case G_CHECKSUM_SHA1:
+      sha1_sum_close (&(checksum.sum.sha1));
+      sha1_sum_digest (&(checksum.sum.sha1), digest);
+      break;
+    case G_CHECKSUM_SHA256:
+      sha256_sum_close (&(checksum.sum.sha256));
+      sha256_sum_digest (&(checksum.sum.sha256), digest);
+      break;
+    case G_CHECKSUM_SHA512:
+      sha512_sum_close (&(checksum.sum.sha512));
+      sha512_sum_digest (&(checksum.sum.sha512), digest);
+      break;
+    case G_CHECKSUM_CRC32C:
+      crc32c_sum_close (&(checksum.sum.crc32c));
+      crc32c_sum_digest (&(checksum.sum.crc32c), digest);
+      break;
+    case G_CHECKSUM_XXH64:
+      xxh64_sum_close (&(checksum.sum.xxh64));
+      xxh64_sum_digest (&(checksum.sum.xxh64), digest);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+    }
+}
+
+static void
+compute_digests (GChecksumType         checksum_type,
+                 const guchar * const *data,
+                 const gsize          *lengths,
+                 gsize                 n_data,
+                 guint8               *digests)
+{
+  gsize digest_len = g_checksum_type_get_length (checksum_type);
+  gsize i;
+
+#ifdef CHECKSUM_X86_ACCEL
+  if (checksum_type == G_CHECKSUM_SHA256 && sha256_use_multi_buffer && n_data > 1)
+    {
+      sha256_many_x8 (data, lengths, n_data, digests);
+      return;
+    }
+#endif
+
+  for (i = 0; i < n_data; i++)
+    compute_digest (checksum_type, data[i], lengths[i], digests + i * digest_len);
+}
+
+typedef struct
+{
+  GChecksumType         checksum_type;
+  const guchar * const *data;
+  const gsize          *lengths;
+  guint8               *digests;
+
+  GMutex                mutex;
+  GCond                 cond;
+  guint                 pending;
+} ChecksumBatch;
+
+typedef struct
+{
+  ChecksumBatch *batch;
+  gsize          start;
+  gsize          end;
+} ChecksumBatchTask;
+
+static void
+checksum_batch_task (gpointer data,
+                     gpointer user_data)
+{
+  ChecksumBatchTask *task = data;
+  ChecksumBatch *batch = task->batch;
+  gsize digest_len = g_checksum_type_get_length (batch->checksum_type);
+
+  compute_digests (batch->checksum_type,
+                   batch->data + task->start,
+                   batch->lengths + task->start,
+                   task->end - task->start,
+                   batch->digests + task->start * digest_len);
+
+  g_mutex_lock (&batch->mutex);
+  if (--batch->pending == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->mutex);
+}
+
+/**
+ * g_compute_checksum_for_data_many:
+ * @checksum_type: a #GChecksumType
+ * @data: (array length=n_data): the binary blobs to compute the digests of
+ * @lengths: (array length=n_data): the lengths of the blobs in @data
+ * @n_data: the number of blobs
+ * @digests: return location for the digests, with room for @n_data
+ *   times g_checksum_type_get_length() bytes
+ *
+ * Computes the digests of @n_data independent binary blobs, storing
+ * the raw digest of @data[i] at @digests + i * g_checksum_type_get_length().
+ * The result is the same as computing each with a #GChecksum and
+ * g_checksum_get_digest(), but large numbers of small blobs are hashed
+ * considerably faster: no #GChecksum or hexadecimal string is created,
+ * several SHA-256 blobs are hashed at once in SIMD registers where
+ * the processor allows it, and large batches are spread over several
+ * threads.
+ *
+ * Since: 2.40
+ */
+void
+g_compute_checksum_for_data_many (GChecksumType         checksum_type,
+                                  const guchar * const *data,
+                                  const gsize          *lengths,
+                                  gsize                 n_data,
+                                  guint8               *digests)
+{
+  ChecksumBatch batch;
+  ChecksumBatchTask *tasks;
+  GThreadPool *pool;
+  gsize total, done, i;
+  guint n_tasks, n_procs, t;
+
+  g_return_if_fail (IS_VALID_TYPE (checksum_type));
+  g_return_if_fail (n_data == 0 || (data != NULL && lengths != NULL && digests != NULL));
+
+  checksum_init_accel ();
+
+  total = 0;
+  for (i = 0; i < n_data; i++)
+    total += lengths[i];
+
+  n_procs = g_get_num_processors ();
+  if (total < CHECKSUM_PARALLEL_THRESHOLD || n_procs < 2 || n_data < 2)
+    {
+      compute_digests (checksum_type, data, lengths, n_data, digests);
+      return;
+    }
+
+  n_tasks = MIN (n_procs, n_data);
+
+  batch.checksum_type = checksum_type;
+  batch.data = data;
+  batch.lengths = lengths;
+  batch.digests = digests;
+  g_mutex_init (&batch.mutex);
+  g_cond_init (&batch.cond);
+
+  /* give each task a contiguous range with about the same number of bytes */
+  tasks = g_new (ChecksumBatchTask, n_tasks);
+  done = 0;
+  i = 0;
+  for (t = 0; t < n_tasks; t++)
+    {
+      tasks[t].batch = &batch;
+      tasks[t].start = i;
+      while (i < n_data && (t == n_tasks - 1 || done < total / n_tasks * (t + 1)))
+        done += lengths[i++];
+      tasks[t].end = i;
+    }
+
+  pool = g_thread_pool_new (checksum_batch_task, NULL, n_tasks, FALSE, NULL);
+
+  batch.pending = n_tasks;
+  for (t = 0; t < n_tasks; t++)
+    g_thread_pool_push (pool, &tasks[t], NULL);
+
+  g_mutex_lock (&batch.mutex);
+  while (batch.pending > 0)
+    g_cond_wait (&batch.cond, &batch.mutex);
+  g_mutex_unlock (&batch.mutex);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_free (tasks);
+  g_mutex_clear (&batch.mutex);
+  g_cond_clear (&batch.cond);
+}
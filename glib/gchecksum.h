@@ -36,6 +36,10 @@ G_BEGIN_DECLS
  * @G_CHECKSUM_SHA1: Use the SHA-1 hashing algorithm
  * @G_CHECKSUM_SHA256: Use the SHA-256 hashing algorithm
  * @G_CHECKSUM_SHA512: Use the SHA-512 hashing algorithm
+ * @G_CHECKSUM_CRC32C: Use the CRC-32C (Castagnoli) checksum; not a
+ *   cryptographic hash. Since 2.40
+ * @G_CHECKSUM_XXH64: Use the 64 bit xxHash algorithm; not a
+ *   cryptographic hash. Since 2.40
  *
  * The hashing algorithm to be used by #GChecksum when performing the
  * digest of some data.
@@ -49,7 +53,9 @@ typedef enum {
   G_CHECKSUM_MD5,
   G_CHECKSUM_SHA1,
   G_CHECKSUM_SHA256,
-  G_CHECKSUM_SHA512
+  G_CHECKSUM_SHA512,
+  G_CHECKSUM_CRC32C,
+  G_CHECKSUM_XXH64
 } GChecksumType;
 
 /**
@@ -98,6 +104,13 @@ GLIB_AVAILABLE_IN_2_34
 gchar                *g_compute_checksum_for_bytes  (GChecksumType    checksum_type,
                                                      GBytes          *data);
 
+GLIB_AVAILABLE_IN_2_40
+void                  g_compute_checksum_for_data_many (GChecksumType         checksum_type,
+                                                        const guchar * const *data,
+                                                        const gsize          *lengths,
+                                                        gsize                 n_data,
+                                                        guint8               *digests);
+
 G_END_DECLS
 
 #endif /* __G_CHECKSUM_H__ */
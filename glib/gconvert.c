@@ -325,13 +325,112 @@ g_iconv_close (GIConv converter)
   return iconv_close (cd);
 }
 
+/* Opening a converter is expensive with many iconv implementations, so
+ * each thread keeps a few of the converters it has recently closed
+ * around for reuse.  open_converter() takes a converter out of the
+ * cache, so nested conversions never share one.
+ */
+#define ICONV_CACHE_SIZE 4
+
+typedef struct _GIConvCacheEntry GIConvCacheEntry;
+
+struct _GIConvCacheEntry {
+  gchar *to_codeset;
+  gchar *from_codeset;
+  GIConv cd;
+};
+
+typedef struct _GIConvCache GIConvCache;
+
+struct _GIConvCache {
+  /* most recently used first */
+  GIConvCacheEntry entries[ICONV_CACHE_SIZE];
+  guint n_entries;
+};
+
+static void
+iconv_cache_entry_clear (GIConvCacheEntry *entry)
+{
+  g_iconv_close (entry->cd);
+  g_free (entry->to_codeset);
+  g_free (entry->from_codeset);
+}
+
+static void
+iconv_cache_free (gpointer data)
+{
+  GIConvCache *cache = data;
+  guint i;
+
+  for (i = 0; i < cache->n_entries; i++)
+    iconv_cache_entry_clear (&cache->entries[i]);
+  g_free (cache);
+}
+
+static GPrivate iconv_cache_private = G_PRIVATE_INIT (iconv_cache_free);
+
+/* Resetting a converter restores its shift state, but a converter for
+ * one of the Unicode encodings with a byte order mark also remembers
+ * whether it has already read or written the mark.  Those are never
+ * reused.
+ */
+static gboolean
+codeset_is_cacheable (const gchar *codeset)
+{
+  static const gchar * const bom_codesets[] = {
+    "UTF16", "UTF32", "UCS2", "UCS4", "UNICODE"
+  };
+  gchar name[16];
+  gsize i, n = 0;
+
+  for (; *codeset; codeset++)
+    {
+      if (*codeset == '-' || *codeset == '_')
+        continue;
+      if (n == sizeof (name) - 1)
+        return TRUE;
+      name[n++] = g_ascii_toupper (*codeset);
+    }
+  name[n] = '\0';
+
+  for (i = 0; i < G_N_ELEMENTS (bom_codesets); i++)
+    if (strcmp (name, bom_codesets[i]) == 0)
+      return FALSE;
+
+  return TRUE;
+}
+
 static GIConv
 open_converter (const gchar *to_codeset,
 		const gchar *from_codeset,
 		GError     **error)
 {
+  GIConvCache *cache = g_private_get (&iconv_cache_private);
   GIConv cd;
 
+  if (cache)
+    {
+      guint i;
+
+      for (i = 0; i < cache->n_entries; i++)
+        {
+          GIConvCacheEntry *entry = &cache->entries[i];
+
+          if (strcmp (entry->to_codeset, to_codeset) == 0 &&
+              strcmp (entry->from_codeset, from_codeset) == 0)
+            {
+              cd = entry->cd;
+              g_free (entry->to_codeset);
+              g_free (entry->from_codeset);
+
+              cache->n_entries--;
+              memmove (entry, entry + 1, (cache->n_entries - i) * sizeof (GIConvCacheEntry));
+
+              return cd;
+            }
+        }
+    }
+
   cd = g_iconv_open (to_codeset, from_codeset);
 
   if (cd == (GIConv) -1)
@@ -354,12 +453,43 @@ open_converter (const gchar *to_codeset,
 }
 
 static int
-close_converter (GIConv cd)
+close_converter (GIConv       cd,
+		 const gchar *to_codeset,
+		 const gchar *from_codeset)
 {
+  GIConvCache *cache;
+  GIConvCacheEntry *entry;
+
   if (cd == (GIConv) -1)
     return 0;
-  
-  return g_iconv_close (cd);  
+
+  if (!codeset_is_cacheable (to_codeset) ||
+      !codeset_is_cacheable (from_codeset))
+    return g_iconv_close (cd);
+
+  /* reset the shift state for the next user */
+  if (g_iconv (cd, NULL, NULL, NULL, NULL) == (gsize) -1)
+    return g_iconv_close (cd);
+
+  cache = g_private_get (&iconv_cache_private);
+  if (!cache)
+    {
+      cache = g_new0 (GIConvCache, 1);
+      g_private_set (&iconv_cache_private, cache);
+    }
+
+  if (cache->n_entries == ICONV_CACHE_SIZE)
+    iconv_cache_entry_clear (&cache->entries[--cache->n_entries]);
+
+  memmove (cache->entries + 1, cache->entries, cache->n_entries * sizeof (GIConvCacheEntry));
+  cache->n_entries++;
+
+  entry = &cache->entries[0];
+  entry->to_codeset = g_strdup (to_codeset);
+  entry->from_codeset = g_strdup (from_codeset);
+  entry->cd = cd;
+
+  return 0;
 }
 
 /**
@@ -586,7 +716,7 @@ g_convert (const gchar *str,
 			      bytes_read, bytes_written,
 			      error);
 
-  close_converter (cd);
+  close_converter (cd, to_codeset, from_codeset);
 
   return res;
 }
@@ -699,7 +829,7 @@ g_convert_with_fallback (const gchar *str,
 		    bytes_read, &inbytes_remaining, error);
   if (!utf8)
     {
-      close_converter (cd);
+      close_converter (cd, to_codeset, "UTF-8");
       if (bytes_written)
         *bytes_written = 0;
       return NULL;
@@ -811,7 +941,7 @@ g_convert_with_fallback (const gchar *str,
    */
   memset (outp, 0, NUL_TERMINATOR_LENGTH);
   
-  close_converter (cd);
+  close_converter (cd, to_codeset, "UTF-8");
 
   if (bytes_written)
     *bytes_written = outp - dest;	/* Doesn't include '\0' */
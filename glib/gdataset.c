@@ -165,6 +165,7 @@ struct _GData
 {
   guint32  len;     /* Number of elements */
   guint32  alloc;   /* Number of allocated elements */
+  guint32 *index;   /* Hash index into data, see datalist_find() */
   GDataElt data[1]; /* Flexible array */
 };
 
@@ -219,6 +220,153 @@ g_datalist_unlock (GData **datalist)
   g_pointer_bit_unlock ((void **)datalist, DATALIST_LOCK_BIT);
 }
 
+/* Objects commonly carry more than a handful of qdata keys, so once a
+ * datalist has room for more than DATALIST_INDEX_THRESHOLD elements, it
+ * gets an open addressing hash index with DATALIST_INDEX_SIZE slots
+ * that map keys to their position in data (plus one, 0 marks an empty
+ * slot).  Smaller lists are searched linearly.
+ */
+#define DATALIST_INDEX_THRESHOLD 8
+#define DATALIST_INDEX_SIZE(d)   ((d)->alloc * 2)
+
+static inline guint
+datalist_index_hash (GQuark key_id,
+                     guint  mask)
+{
+  /* quarks are sequential, multiplying by an odd constant keeps
+   * consecutive ones in different slots
+   */
+  return (key_id * 2654435769u) & mask;
+}
+
+static void
+datalist_index_insert (GData *d,
+                       guint  pos)
+{
+  guint mask = DATALIST_INDEX_SIZE (d) - 1;
+  guint i;
+
+  i = datalist_index_hash (d->data[pos].key, mask);
+  while (d->index[i] != 0)
+    i = (i + 1) & mask;
+  d->index[i] = pos + 1;
+}
+
+static void
+datalist_index_rebuild (GData *d)
+{
+  guint i;
+
+  if (d->alloc <= DATALIST_INDEX_THRESHOLD)
+    return;
+
+  if (d->index == NULL)
+    d->index = g_new0 (guint32, DATALIST_INDEX_SIZE (d));
+  else
+    memset (d->index, 0, DATALIST_INDEX_SIZE (d) * sizeof (guint32));
+
+  for (i = 0; i < d->len; i++)
+    datalist_index_insert (d, i);
+}
+
+static inline GDataElt *
+datalist_find (GData  *d,
+               GQuark  key_id)
+{
+  GDataElt *data, *data_end;
+
+  if (d == NULL)
+    return NULL;
+
+  if (d->index)
+    {
+      guint mask = DATALIST_INDEX_SIZE (d) - 1;
+      guint i;
+
+      for (i = datalist_index_hash (key_id, mask); d->index[i] != 0; i = (i + 1) & mask)
+        {
+          data = &d->data[d->index[i] - 1];
+          if (data->key == key_id)
+            return data;
+        }
+
+      return NULL;
+    }
+
+  data = d->data;
+  data_end = data + d->len;
+  while (data < data_end)
+    {
+      if (data->key == key_id)
+        return data;
+      data++;
+    }
+
+  return NULL;
+}
+
+/* Returns the new location of d, which the caller has to store
+ * in the datalist pointer if it changed.
+ */
+static GData *
+datalist_append (GData          *d,
+                 GQuark          key_id,
+                 gpointer        new_data,
+                 GDestroyNotify  new_destroy_func)
+{
+  gboolean grown = FALSE;
+
+  if (d == NULL)
+    {
+      d = g_malloc (sizeof (GData));
+      d->len = 0;
+      d->alloc = 1;
+      d->index = NULL;
+    }
+  else if (d->len == d->alloc)
+    {
+      d->alloc = d->alloc * 2;
+      d = g_realloc (d, sizeof (GData) + (d->alloc - 1) * sizeof (GDataElt));
+      g_free (d->index);
+      d->index = NULL;
+      grown = TRUE;
+    }
+
+  d->data[d->len].key = key_id;
+  d->data[d->len].data = new_data;
+  d->data[d->len].destroy = new_destroy_func;
+  d->len++;
+
+  if (grown)
+    datalist_index_rebuild (d);
+  else if (d->index)
+    datalist_index_insert (d, d->len - 1);
+
+  return d;
+}
+
+/* Removes @data from @d by moving the last element into its place */
+static void
+datalist_remove (GData    *d,
+                 GDataElt *data)
+{
+  GDataElt *data_last = d->data + d->len - 1;
+
+  if (data != data_last)
+    *data = *data_last;
+  d->len--;
+
+  if (d->index)
+    datalist_index_rebuild (d);
+}
+
+static void
+datalist_free (GData *d)
+{
+  g_free (d->index);
+  g_free (d);
+}
+
 /* Called with the datalist lock held, or the dataset global
  * lock for dataset lists
  */
@@ -241,7 +389,7 @@ g_datalist_clear_i (GData **datalist)
         }
       G_LOCK (g_dataset_global);
 
-      g_free (data);
+      datalist_free (data);
     }
 
 }
@@ -277,7 +425,7 @@ g_datalist_clear (GData **datalist)
             data->data[i].destroy (data->data[i].data);
         }
 
-      g_free (data);
+      datalist_free (data);
     }
 }
 
@@ -353,134 +501,99 @@ g_data_set_internal (GData	  **datalist,
 		     GDataset	   *dataset)
 {
   GData *d, *old_d;
-  GDataElt old, *data, *data_last, *data_end;
+  GDataElt old, *data;
 
   g_datalist_lock (datalist);
 
   d = G_DATALIST_GET_POINTER (datalist);
+  data = datalist_find (d, key_id);
 
   if (new_data == NULL) /* remove */
     {
-      if (d)
+      if (data)
 	{
-	  data = d->data;
-	  data_last = data + d->len - 1;
-	  while (data <= data_last)
+	  old = *data;
+	  datalist_remove (d, data);
+
+	  /* We don't bother to shrink, but if all data are now gone
+	   * we at least free the memory
+	   */
+	  if (d->len == 0)
+	    {
+	      G_DATALIST_SET_POINTER (datalist, NULL);
+	      datalist_free (d);
+	      /* datalist may be situated in dataset, so must not be
+	       * unlocked after we free it
+	       */
+	      g_datalist_unlock (datalist);
+
+	      /* the dataset destruction *must* be done
+	       * prior to invocation of the data destroy function
+	       */
+	      if (dataset)
+		g_dataset_destroy_internal (dataset);
+	    }
+	  else
+	    {
+	      g_datalist_unlock (datalist);
+	    }
+
+	  /* We found and removed an old value
+	   * the GData struct *must* already be unlinked
+	   * when invoking the destroy function.
+	   * we use (new_data==NULL && new_destroy_func!=NULL) as
+	   * a special hint combination to "steal"
+	   * data without destroy notification
+	   */
+	  if (old.destroy && !new_destroy_func)
 	    {
-	      if (data->key == key_id)
-		{
-		  old = *data;
-		  if (data != data_last)
-		    *data = *data_last;
-		  d->len--;
-
-		  /* We don't bother to shrink, but if all data are now gone
-		   * we at least free the memory
-                   */
-		  if (d->len == 0)
-		    {
-		      G_DATALIST_SET_POINTER (datalist, NULL);
-		      g_free (d);
-		      /* datalist may be situated in dataset, so must not be
-		       * unlocked after we free it
-		       */
-		      g_datalist_unlock (datalist);
-
-		      /* the dataset destruction *must* be done
-		       * prior to invocation of the data destroy function
-		       */
-		      if (dataset)
-			g_dataset_destroy_internal (dataset);
-		    }
-		  else
-		    {
-		      g_datalist_unlock (datalist);
-		    }
-
-		  /* We found and removed an old value
-		   * the GData struct *must* already be unlinked
-		   * when invoking the destroy function.
-		   * we use (new_data==NULL && new_destroy_func!=NULL) as
-		   * a special hint combination to "steal"
-		   * data without destroy notification
-		   */
-		  if (old.destroy && !new_destroy_func)
-		    {
-		      if (dataset)
-			G_UNLOCK (g_dataset_global);
-		      old.destroy (old.data);
-		      if (dataset)
-			G_LOCK (g_dataset_global);
-		      old.data = NULL;
-		    }
-
-		  return old.data;
-		}
-	      data++;
+	      if (dataset)
+		G_UNLOCK (g_dataset_global);
+	      old.destroy (old.data);
+	      if (dataset)
+		G_LOCK (g_dataset_global);
+	      old.data = NULL;
 	    }
+
+	  return old.data;
 	}
     }
   else
     {
-      old.data = NULL;
-      if (d)
+      if (data)
 	{
-	  data = d->data;
-	  data_end = data + d->len;
-	  while (data < data_end)
+	  if (!data->destroy)
+	    {
+	      data->data = new_data;
+	      data->destroy = new_destroy_func;
+	      g_datalist_unlock (datalist);
+	    }
+	  else
 	    {
-	      if (data->key == key_id)
-		{
-		  if (!data->destroy)
-		    {
-		      data->data = new_data;
-		      data->destroy = new_destroy_func;
-		      g_datalist_unlock (datalist);
-		    }
-		  else
-		    {
-		      old = *data;
-		      data->data = new_data;
-		      data->destroy = new_destroy_func;
-
-		      g_datalist_unlock (datalist);
-
-		      /* We found and replaced an old value
-		       * the GData struct *must* already be unlinked
-		       * when invoking the destroy function.
-		       */
-		      if (dataset)
-			G_UNLOCK (g_dataset_global);
-		      old.destroy (old.data);
-		      if (dataset)
-			G_LOCK (g_dataset_global);
-		    }
-		  return NULL;
-		}
-	      data++;
+	      old = *data;
+	      data->data = new_data;
+	      data->destroy = new_destroy_func;
+
+	      g_datalist_unlock (datalist);
+
+	      /* We found and replaced an old value
+	       * the GData struct *must* already be unlinked
+	       * when invoking the destroy function.
+	       */
+	      if (dataset)
+		G_UNLOCK (g_dataset_global);
+	      old.destroy (old.data);
+	      if (dataset)
+		G_LOCK (g_dataset_global);
 	    }
+	  return NULL;
 	}
 
       /* The key was not found, insert it */
       old_d = d;
-      if (d == NULL)
-	{
-	  d = g_malloc (sizeof (GData));
-	  d->len = 0;
-	  d->alloc = 1;
-	}
-      else if (d->len == d->alloc)
-	{
-	  d->alloc = d->alloc * 2;
-	  d = g_realloc (d, sizeof (GData) + (d->alloc - 1) * sizeof (GDataElt));
-	}
+      d = datalist_append (d, key_id, new_data, new_destroy_func);
       if (old_d != d)
 	G_DATALIST_SET_POINTER (datalist, d);
-
-      d->data[d->len].key = key_id;
-      d->data[d->len].data = new_data;
-      d->data[d->len].destroy = new_destroy_func;
-      d->len++;
     }
 
   g_datalist_unlock (datalist);
@@ -850,29 +963,16 @@ g_datalist_id_dup_data (GData          **datalist,
 {
   gpointer val = NULL;
   gpointer retval = NULL;
-  GData *d;
-  GDataElt *data, *data_end;
+  GDataElt *data;
 
   g_return_val_if_fail (datalist != NULL, NULL);
   g_return_val_if_fail (key_id != 0, NULL);
 
   g_datalist_lock (datalist);
 
-  d = G_DATALIST_GET_POINTER (datalist);
-  if (d)
-    {
-      data = d->data;
-      data_end = data + d->len - 1;
-      while (data <= data_end)
-        {
-          if (data->key == key_id)
-            {
-              val = data->data;
-              break;
-            }
-          data++;
-        }
-    }
+  data = datalist_find (G_DATALIST_GET_POINTER (datalist), key_id);
+  if (data)
+    val = data->data;
 
   if (dup_func)
     retval = dup_func (val, user_data);
@@ -922,7 +1022,7 @@ g_datalist_id_replace_data (GData          **datalist,
 {
   gpointer val = NULL;
   GData *d;
-  GDataElt *data, *data_end;
+  GDataElt *data;
 
   g_return_val_if_fail (datalist != NULL, FALSE);
   g_return_val_if_fail (key_id != 0, FALSE);
@@ -933,43 +1033,32 @@ g_datalist_id_replace_data (GData          **datalist,
   g_datalist_lock (datalist);
 
   d = G_DATALIST_GET_POINTER (datalist);
-  if (d)
+  data = datalist_find (d, key_id);
+  if (data)
     {
-      data = d->data;
-      data_end = data + d->len - 1;
-      while (data <= data_end)
+      val = data->data;
+      if (val == oldval)
         {
-          if (data->key == key_id)
+          if (old_destroy)
+            *old_destroy = data->destroy;
+          if (newval != NULL)
             {
-              val = data->data;
-              if (val == oldval)
+              data->data = newval;
+              data->destroy = destroy;
+            }
+          else
+            {
+              datalist_remove (d, data);
+
+              /* We don't bother to shrink, but if all data are now gone
+               * we at least free the memory
+               */
+              if (d->len == 0)
                 {
-                  if (old_destroy)
-                    *old_destroy = data->destroy;
-                  if (newval != NULL)
-                    {
-                      data->data = newval;
-                      data->destroy = destroy;
-                    }
-                  else
-                   {
-                     if (data != data_end)
-                       *data = *data_end;
-                     d->len--;
-
-                     /* We don't bother to shrink, but if all data are now gone
-                      * we at least free the memory
-                      */
-                     if (d->len == 0)
-                       {
-                         G_DATALIST_SET_POINTER (datalist, NULL);
-                         g_free (d);
-                       }
-                   }
+                  G_DATALIST_SET_POINTER (datalist, NULL);
+                  datalist_free (d);
                 }
-              break;
             }
-          data++;
         }
     }
 
@@ -979,24 +1068,9 @@ g_datalist_id_replace_data (GData          **datalist,
 
       /* insert newval */
       old_d = d;
-      if (d == NULL)
-	{
-          d = g_malloc (sizeof (GData));
-          d->len = 0;
-          d->alloc = 1;
-        }
-      else if (d->len == d->alloc)
-        {
-          d->alloc = d->alloc * 2;
-          d = g_realloc (d, sizeof (GData) + (d->alloc - 1) * sizeof (GDataElt));
-        }
+      d = datalist_append (d, key_id, newval, destroy);
       if (old_d != d)
         G_DATALIST_SET_POINTER (datalist, d);
-
-      d->data[d->len].key = key_id;
-      d->data[d->len].data = newval;
-      d->data[d->len].destroy = destroy;
-      d->len++;
     }
 
   g_datalist_unlock (datalist);
@@ -1019,28 +1093,21 @@ g_datalist_get_data (GData	 **datalist,
 		     const gchar *key)
 {
   gpointer res = NULL;
-  GData *d;
-  GDataElt *data, *data_end;
+  GDataElt *data;
+  GQuark key_id;
 
   g_return_val_if_fail (datalist != NULL, NULL);
 
+  /* data can only be stored under a key that is a quark */
+  key_id = g_quark_try_string (key);
+  if (key_id == 0)
+    return NULL;
+
   g_datalist_lock (datalist);
 
-  d = G_DATALIST_GET_POINTER (datalist);
-  if (d)
-    {
-      data = d->data;
-      data_end = data + d->len;
-      while (data < data_end)
-	{
-	  if (strcmp (g_quark_to_string (data->key), key) == 0)
-	    {
-	      res = data->data;
-	      break;
-	    }
-	  data++;
-	}
-    }
+  data = datalist_find (G_DATALIST_GET_POINTER (datalist), key_id);
+  if (data)
+    res = data->data;
 
   g_datalist_unlock (datalist);
 
@@ -171,9 +171,8 @@ static const guint16 days_in_year[2][13] =
 
 #ifdef HAVE_LANGINFO_TIME
 
-#define GET_AMPM(d) ((g_date_time_get_hour (d) < 12) ? \
-                     nl_langinfo (AM_STR) : \
-                     nl_langinfo (PM_STR))
+#define GET_AM nl_langinfo (AM_STR)
+#define GET_PM nl_langinfo (PM_STR)
 
 #define PREFERRED_DATE_TIME_FMT nl_langinfo (D_T_FMT)
 #define PREFERRED_DATE_FMT nl_langinfo (D_FMT)
@@ -200,11 +199,10 @@ static const gint month_item[2][12] =
 
 #else
 
-#define GET_AMPM(d)          ((g_date_time_get_hour (d) < 12)  \
-                                       /* Translators: 'before midday' indicator */ \
-                                ? C_("GDateTime", "AM") \
-                                  /* Translators: 'after midday' indicator */ \
-                                : C_("GDateTime", "PM"))
+/* Translators: 'before midday' indicator */
+#define GET_AM C_("GDateTime", "AM")
+/* Translators: 'after midday' indicator */
+#define GET_PM C_("GDateTime", "PM")
 
 /* Translators: this is the preferred format for expressing the date and the time */
 #define PREFERRED_DATE_TIME_FMT C_("GDateTime", "%a %b %e %H:%M:%S %Y")
@@ -2147,11 +2145,11 @@ format_z (GString *outstr,
 }
 
 static void
-format_number (GString  *str,
-               gboolean  use_alt_digits,
-               gchar    *pad,
-               gint      width,
-               guint32   number)
+format_number (GString     *str,
+               gboolean     use_alt_digits,
+               const gchar *pad,
+               gint         width,
+               guint32      number)
 {
   const gchar *ascii_digits[10] = {
     "0", "1", "2", "3", "4", "5", "6", "7", "8", "9"
@@ -2162,6 +2160,26 @@ format_number (GString  *str,
 
   g_return_if_fail (width <= 10);
 
+  if (!use_alt_digits)
+    {
+      gchar buf[10];
+
+      /* 2^32 has 10 digits */
+      do
+        {
+          buf[9 - i++] = '0' + number % 10;
+          number /= 10;
+        }
+      while (number);
+
+      if (pad && *pad)
+        while (i < width)
+          buf[9 - i++] = *pad;
+
+      g_string_append_len (str, buf + 10 - i, i);
+      return;
+    }
+
 #ifdef HAVE_LANGINFO_OUTDIGIT
   if (use_alt_digits)
     {
@@ -2200,81 +2218,348 @@ format_number (GString  *str,
     g_string_append (str, tmp[--i]);
 }
 
-static gboolean g_date_time_format_locale (GDateTime   *datetime,
-					   const gchar *format,
-					   GString     *outstr,
-					   gboolean     locale_is_utf8);
+/* A format string is compiled into a list of operations, each either
+ * a run of literal text or a single conversion with its modifiers.
+ * Everything that only depends on the format and the locale (literal
+ * text in the locale encoding, the expansion of the preferred date and
+ * time representations, the case-converted AM/PM strings) is worked
+ * out once, so formatting a date only has to look at the date.
+ */
+typedef struct
+{
+  gchar        conversion;  /* 0 for literal text */
+  gboolean     alt_digits;
+  guint        colons;
+  const gchar *pad;
+  gint         width;
+  guint        offset;      /* into strings: literal text, or AM string */
+  guint        length;
+  guint        offset2;     /* into strings: PM string */
+  guint        length2;
+} FormatOp;
+
+typedef struct
+{
+  GDateTime *datetime;
+  gint       year;
+  gint       month;
+  gint       day;
+} FormatDate;
+
+struct _GDateTimeFormatter
+{
+  GArray   *ops;            /* FormatOp */
+  GString  *strings;        /* locale-encoded */
+  gboolean  locale_is_utf8;
+
+  /* g_date_time_format() formats a single date, so instead of recording
+   * the operations they are performed into outstr as they are parsed.
+   */
+  const FormatDate *date;
+  GString  *outstr;
+};
+
+/* nested preferred formats beyond this are considered broken */
+#define MAX_FORMAT_DEPTH 4
+
+static gboolean
+g_date_time_formatter_add_literal (GDateTimeFormatter *formatter,
+                                   const gchar        *text,
+                                   gssize              length)
+{
+  GString *target;
+  FormatOp *last;
+  gsize offset;
+
+  if (length < 0)
+    length = strlen (text);
+
+  if (length == 0)
+    return TRUE;
+
+  target = formatter->outstr ? formatter->outstr : formatter->strings;
+  offset = target->len;
+
+  if (formatter->locale_is_utf8)
+    g_string_append_len (target, text, length);
+  else
+    {
+      gchar *tmp;
+
+      tmp = g_locale_from_utf8 (text, length, NULL, NULL, NULL);
+      if (!tmp)
+        return FALSE;
+      g_string_append (target, tmp);
+      g_free (tmp);
+    }
+
+  if (formatter->outstr)
+    return TRUE;
+
+  if (formatter->ops->len > 0)
+    {
+      last = &g_array_index (formatter->ops, FormatOp, formatter->ops->len - 1);
+      if (last->conversion == 0 && last->offset + last->length == offset)
+        {
+          last->length = formatter->strings->len - last->offset;
+          return TRUE;
+        }
+    }
+
+  g_array_set_size (formatter->ops, formatter->ops->len + 1);
+  last = &g_array_index (formatter->ops, FormatOp, formatter->ops->len - 1);
+  last->offset = offset;
+  last->length = formatter->strings->len - offset;
 
-/* g_date_time_format() subroutine that takes a locale-encoded format
- * string and produces a locale-encoded date/time string.
+  return TRUE;
+}
+
+/* Appends @ampm, which is in the locale encoding, to the strings of
+ * @formatter after converting it to upper or lower case.
  */
 static gboolean
-g_date_time_locale_format_locale (GDateTime   *datetime,
-				  const gchar *format,
-				  GString     *outstr,
-				  gboolean     locale_is_utf8)
+g_date_time_formatter_add_ampm (GDateTimeFormatter *formatter,
+                                const gchar        *ampm,
+                                gboolean            upper,
+                                guint              *offset,
+                                guint              *length)
+{
+  gchar *utf8, *converted, *tmp;
+
+  if (formatter->locale_is_utf8)
+    utf8 = g_strdup (ampm);
+  else if (!(utf8 = g_locale_to_utf8 (ampm, -1, NULL, NULL, NULL)))
+    return FALSE;
+
+  if (upper)
+    converted = g_utf8_strup (utf8, -1);
+  else
+    converted = g_utf8_strdown (utf8, -1);
+  g_free (utf8);
+
+  if (!formatter->locale_is_utf8)
+    {
+      tmp = g_locale_from_utf8 (converted, -1, NULL, NULL, NULL);
+      g_free (converted);
+      if (!tmp)
+        return FALSE;
+      converted = tmp;
+    }
+
+  if (formatter->strings == NULL)
+    formatter->strings = g_string_new (NULL);
+
+  *offset = formatter->strings->len;
+  g_string_append (formatter->strings, converted);
+  *length = formatter->strings->len - *offset;
+  g_free (converted);
+
+  return TRUE;
+}
+
+/* Performs @op for @date, appending to @outstr in the locale encoding. */
+static gboolean
+g_date_time_formatter_perform (const GDateTimeFormatter *formatter,
+                               const FormatOp           *op,
+                               const FormatDate         *date,
+                               GString                  *outstr)
+{
+  GDateTime *datetime = date->datetime;
+  const gchar *tz;
+  gchar *tmp = NULL;
+
+  switch (op->conversion)
+    {
+    case 0:
+      g_string_append_len (outstr, formatter->strings->str + op->offset, op->length);
+      break;
+    case 'a':
+      g_string_append (outstr, WEEKDAY_ABBR (datetime));
+      break;
+    case 'A':
+      g_string_append (outstr, WEEKDAY_FULL (datetime));
+      break;
+    case 'b':
+    case 'h':
+      g_string_append (outstr, MONTH_ABBR (datetime));
+      break;
+    case 'B':
+      g_string_append (outstr, MONTH_FULL (datetime));
+      break;
+    case 'C':
+      format_number (outstr, op->alt_digits, op->pad, op->width, date->year / 100);
+      break;
+    case 'd':
+    case 'e':
+      format_number (outstr, op->alt_digits, op->pad, op->width, date->day);
+      break;
+    case 'F':
+      format_number (outstr, FALSE, NULL, 0, date->year);
+      g_string_append_c (outstr, '-');
+      format_number (outstr, FALSE, "0", 2, date->month);
+      g_string_append_c (outstr, '-');
+      format_number (outstr, FALSE, "0", 2, date->day);
+      break;
+    case 'g':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_week_numbering_year (datetime) % 100);
+      break;
+    case 'G':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_week_numbering_year (datetime));
+      break;
+    case 'H':
+    case 'k':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_hour (datetime));
+      break;
+    case 'I':
+    case 'l':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     (g_date_time_get_hour (datetime) + 11) % 12 + 1);
+      break;
+    case 'j':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_day_of_year (datetime));
+      break;
+    case 'm':
+      format_number (outstr, op->alt_digits, op->pad, op->width, date->month);
+      break;
+    case 'M':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_minute (datetime));
+      break;
+    case 'p':
+    case 'P':
+      if (g_date_time_get_hour (datetime) < 12)
+        g_string_append_len (outstr, formatter->strings->str + op->offset, op->length);
+      else
+        g_string_append_len (outstr, formatter->strings->str + op->offset2, op->length2);
+      break;
+    case 'R':
+      format_number (outstr, FALSE, "0", 2, g_date_time_get_hour (datetime));
+      g_string_append_c (outstr, ':');
+      format_number (outstr, FALSE, "0", 2, g_date_time_get_minute (datetime));
+      break;
+    case 's':
+      g_string_append_printf (outstr, "%" G_GINT64_FORMAT, g_date_time_to_unix (datetime));
+      break;
+    case 'S':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_second (datetime));
+      break;
+    case 'T':
+      format_number (outstr, FALSE, "0", 2, g_date_time_get_hour (datetime));
+      g_string_append_c (outstr, ':');
+      format_number (outstr, FALSE, "0", 2, g_date_time_get_minute (datetime));
+      g_string_append_c (outstr, ':');
+      format_number (outstr, FALSE, "0", 2, g_date_time_get_second (datetime));
+      break;
+    case 'u':
+      format_number (outstr, op->alt_digits, 0, 0,
+                     g_date_time_get_day_of_week (datetime));
+      break;
+    case 'V':
+      format_number (outstr, op->alt_digits, op->pad, op->width,
+                     g_date_time_get_week_of_year (datetime));
+      break;
+    case 'w':
+      format_number (outstr, op->alt_digits, 0, 0,
+                     g_date_time_get_day_of_week (datetime) % 7);
+      break;
+    case 'y':
+      format_number (outstr, op->alt_digits, op->pad, op->width, date->year % 100);
+      break;
+    case 'Y':
+      format_number (outstr, op->alt_digits, 0, 0, date->year);
+      break;
+    case 'z':
+      {
+        gint64 offset;
+        if (datetime->tz != NULL)
+          offset = g_date_time_get_utc_offset (datetime) / USEC_PER_SECOND;
+        else
+          offset = 0;
+        if (!format_z (outstr, (int) offset, op->colons))
+          return FALSE;
+      }
+      break;
+    case 'Z':
+      tz = g_date_time_get_timezone_abbreviation (datetime);
+      if (!formatter->locale_is_utf8)
+        {
+          tz = tmp = g_locale_from_utf8 (tz, -1, NULL, NULL, NULL);
+          if (!tmp)
+            return FALSE;
+        }
+      g_string_append (outstr, tz);
+      if (!formatter->locale_is_utf8)
+        g_free (tmp);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  return TRUE;
+}
+
+static gboolean g_date_time_formatter_compile (GDateTimeFormatter *formatter,
+                                               const gchar        *format,
+                                               gint                depth);
+
+/* Compiles one of the locale's preferred formats, which is in the
+ * locale encoding.
+ */
+static gboolean
+g_date_time_formatter_compile_locale (GDateTimeFormatter *formatter,
+                                      const gchar        *format,
+                                      gint                depth)
 {
   gchar *utf8_format;
   gboolean success;
 
-  if (locale_is_utf8)
-    return g_date_time_format_locale (datetime, format, outstr,
-				      locale_is_utf8);
+  if (depth >= MAX_FORMAT_DEPTH)
+    return FALSE;
+
+  if (formatter->locale_is_utf8)
+    return g_date_time_formatter_compile (formatter, format, depth + 1);
 
   utf8_format = g_locale_to_utf8 (format, -1, NULL, NULL, NULL);
   if (!utf8_format)
     return FALSE;
 
-  success = g_date_time_format_locale (datetime, utf8_format, outstr,
-				       locale_is_utf8);
+  success = g_date_time_formatter_compile (formatter, utf8_format, depth + 1);
   g_free (utf8_format);
   return success;
 }
 
-/* g_date_time_format() subroutine that takes a UTF-8 format
- * string and produces a locale-encoded date/time string.
- */
 static gboolean
-g_date_time_format_locale (GDateTime   *datetime,
-			   const gchar *format,
-			   GString     *outstr,
-			   gboolean     locale_is_utf8)
+g_date_time_formatter_compile (GDateTimeFormatter *formatter,
+                               const gchar        *format,
+                               gint                depth)
 {
   guint     len;
   guint     colons;
-  gchar    *tmp;
   gunichar  c;
   gboolean  alt_digits = FALSE;
   gboolean  pad_set = FALSE;
-  gchar    *pad = "";
-  gchar    *ampm;
-  const gchar *tz;
+  const gchar *pad = "";
+  FormatOp  op;
 
   while (*format)
     {
       len = strcspn (format, "%");
-      if (len)
-	{
-	  if (locale_is_utf8)
-	    g_string_append_len (outstr, format, len);
-	  else
-	    {
-	      tmp = g_locale_from_utf8 (format, len, NULL, NULL, NULL);
-	      if (!tmp)
-		return FALSE;
-	      g_string_append (outstr, tmp);
-	      g_free (tmp);
-	    }
-	}
+      if (!g_date_time_formatter_add_literal (formatter, format, len))
+        return FALSE;
 
       format += len;
       if (!*format)
-	break;
+        break;
 
       g_assert (*format == '%');
       format++;
       if (!*format)
-	break;
+        break;
 
       colons = 0;
       alt_digits = FALSE;
@@ -2283,246 +2568,322 @@ g_date_time_format_locale (GDateTime   *datetime,
     next_mod:
       c = g_utf8_get_char (format);
       format = g_utf8_next_char (format);
+
+      memset (&op, 0, sizeof op);
+      op.conversion = c;
+      op.alt_digits = alt_digits;
+
       switch (c)
-	{
-	case 'a':
-	  g_string_append (outstr, WEEKDAY_ABBR (datetime));
-	  break;
-	case 'A':
-	  g_string_append (outstr, WEEKDAY_FULL (datetime));
-	  break;
-	case 'b':
-	  g_string_append (outstr, MONTH_ABBR (datetime));
-	  break;
-	case 'B':
-	  g_string_append (outstr, MONTH_FULL (datetime));
-	  break;
-	case 'c':
-	  {
-	    if (!g_date_time_locale_format_locale (datetime, PREFERRED_DATE_TIME_FMT,
-						   outstr, locale_is_utf8))
-	      return FALSE;
-	  }
-	  break;
-	case 'C':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_year (datetime) / 100);
-	  break;
-	case 'd':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_day_of_month (datetime));
-	  break;
-	case 'e':
-	  format_number (outstr, alt_digits, pad_set ? pad : " ", 2,
-			 g_date_time_get_day_of_month (datetime));
-	  break;
-	case 'F':
-	  g_string_append_printf (outstr, "%d-%02d-%02d",
-				  g_date_time_get_year (datetime),
-				  g_date_time_get_month (datetime),
-				  g_date_time_get_day_of_month (datetime));
-	  break;
-	case 'g':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_week_numbering_year (datetime) % 100);
-	  break;
-	case 'G':
-	  format_number (outstr, alt_digits, pad_set ? pad : 0, 0,
-			 g_date_time_get_week_numbering_year (datetime));
-	  break;
-	case 'h':
-	  g_string_append (outstr, MONTH_ABBR (datetime));
-	  break;
-	case 'H':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_hour (datetime));
-	  break;
-	case 'I':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 (g_date_time_get_hour (datetime) + 11) % 12 + 1);
-	  break;
-	case 'j':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 3,
-			 g_date_time_get_day_of_year (datetime));
-	  break;
-	case 'k':
-	  format_number (outstr, alt_digits, pad_set ? pad : " ", 2,
-			 g_date_time_get_hour (datetime));
-	  break;
-	case 'l':
-	  format_number (outstr, alt_digits, pad_set ? pad : " ", 2,
-			 (g_date_time_get_hour (datetime) + 11) % 12 + 1);
-	  break;
-	case 'n':
-	  g_string_append_c (outstr, '\n');
-	  break;
-	case 'm':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_month (datetime));
-	  break;
-	case 'M':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_minute (datetime));
-	  break;
-	case 'O':
-	  alt_digits = TRUE;
-	  goto next_mod;
-	case 'p':
-	  ampm = (gchar *) GET_AMPM (datetime);
-	  if (!locale_is_utf8)
-	    {
-	      ampm = tmp = g_locale_to_utf8 (ampm, -1, NULL, NULL, NULL);
-	      if (!tmp)
-		return FALSE;
-	    }
-	  ampm = g_utf8_strup (ampm, -1);
-	  if (!locale_is_utf8)
-	    {
-	      g_free (tmp);
-	      tmp = g_locale_from_utf8 (ampm, -1, NULL, NULL, NULL);
-	      g_free (ampm);
-	      if (!tmp)
-		return FALSE;
-	      ampm = tmp;
-	    }
-	  g_string_append (outstr, ampm);
-	  g_free (ampm);
-	  break;
-	case 'P':
-	  ampm = (gchar *) GET_AMPM (datetime);
-	  if (!locale_is_utf8)
-	    {
-	      ampm = tmp = g_locale_to_utf8 (ampm, -1, NULL, NULL, NULL);
-	      if (!tmp)
-		return FALSE;
-	    }
-	  ampm = g_utf8_strdown (ampm, -1);
-	  if (!locale_is_utf8)
-	    {
-	      g_free (tmp);
-	      tmp = g_locale_from_utf8 (ampm, -1, NULL, NULL, NULL);
-	      g_free (ampm);
-	      if (!tmp)
-		return FALSE;
-	      ampm = tmp;
-	    }
-	  g_string_append (outstr, ampm);
-	  g_free (ampm);
-	  break;
-	case 'r':
-	  {
-	    if (!g_date_time_locale_format_locale (datetime, PREFERRED_12HR_TIME_FMT,
-						   outstr, locale_is_utf8))
-	      return FALSE;
-	  }
-	  break;
-	case 'R':
-	  g_string_append_printf (outstr, "%02d:%02d",
-				  g_date_time_get_hour (datetime),
-				  g_date_time_get_minute (datetime));
-	  break;
-	case 's':
-	  g_string_append_printf (outstr, "%" G_GINT64_FORMAT, g_date_time_to_unix (datetime));
-	  break;
-	case 'S':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_second (datetime));
-	  break;
-	case 't':
-	  g_string_append_c (outstr, '\t');
-	  break;
-	case 'T':
-	  g_string_append_printf (outstr, "%02d:%02d:%02d",
-				  g_date_time_get_hour (datetime),
-				  g_date_time_get_minute (datetime),
-				  g_date_time_get_second (datetime));
-	  break;
-	case 'u':
-	  format_number (outstr, alt_digits, 0, 0,
-			 g_date_time_get_day_of_week (datetime));
-	  break;
-	case 'V':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_week_of_year (datetime));
-	  break;
-	case 'w':
-	  format_number (outstr, alt_digits, 0, 0,
-			 g_date_time_get_day_of_week (datetime) % 7);
-	  break;
-	case 'x':
-	  {
-	    if (!g_date_time_locale_format_locale (datetime, PREFERRED_DATE_FMT,
-						   outstr, locale_is_utf8))
-	      return FALSE;
-	  }
-	  break;
-	case 'X':
-	  {
-	    if (!g_date_time_locale_format_locale (datetime, PREFERRED_TIME_FMT,
-						   outstr, locale_is_utf8))
-	      return FALSE;
-	  }
-	  break;
-	case 'y':
-	  format_number (outstr, alt_digits, pad_set ? pad : "0", 2,
-			 g_date_time_get_year (datetime) % 100);
-	  break;
-	case 'Y':
-	  format_number (outstr, alt_digits, 0, 0,
-			 g_date_time_get_year (datetime));
-	  break;
-	case 'z':
-	  {
-	    gint64 offset;
-	    if (datetime->tz != NULL)
-	      offset = g_date_time_get_utc_offset (datetime) / USEC_PER_SECOND;
-	    else
-	      offset = 0;
-	    if (!format_z (outstr, (int) offset, colons))
-	      return FALSE;
-	  }
-	  break;
-	case 'Z':
-	  tz = g_date_time_get_timezone_abbreviation (datetime);
-	  if (!locale_is_utf8)
-	    {
-	      tz = tmp = g_locale_from_utf8 (tz, -1, NULL, NULL, NULL);
-	      if (!tmp)
-		return FALSE;
-	    }
-	  g_string_append (outstr, tz);
-	  if (!locale_is_utf8)
-	    g_free (tmp);
-	  break;
-	case '%':
-	  g_string_append_c (outstr, '%');
-	  break;
-	case '-':
-	  pad_set = TRUE;
-	  pad = "";
-	  goto next_mod;
-	case '_':
-	  pad_set = TRUE;
-	  pad = " ";
-	  goto next_mod;
-	case '0':
-	  pad_set = TRUE;
-	  pad = "0";
-	  goto next_mod;
-	case ':':
-	  /* Colons are only allowed before 'z' */
-	  if (*format && *format != 'z' && *format != ':')
-	    return FALSE;
-	  colons++;
-	  goto next_mod;
-	default:
-	  return FALSE;
-	}
+        {
+        case 'a':
+        case 'A':
+        case 'b':
+        case 'B':
+        case 'h':
+        case 'F':
+        case 'R':
+        case 's':
+        case 'T':
+        case 'Z':
+          break;
+        case 'c':
+          if (!g_date_time_formatter_compile_locale (formatter, PREFERRED_DATE_TIME_FMT, depth))
+            return FALSE;
+          continue;
+        case 'C':
+        case 'd':
+        case 'g':
+        case 'H':
+        case 'I':
+        case 'm':
+        case 'M':
+        case 'S':
+        case 'V':
+        case 'y':
+          op.pad = pad_set ? pad : "0";
+          op.width = 2;
+          break;
+        case 'e':
+        case 'k':
+        case 'l':
+          op.pad = pad_set ? pad : " ";
+          op.width = 2;
+          break;
+        case 'j':
+          op.pad = pad_set ? pad : "0";
+          op.width = 3;
+          break;
+        case 'G':
+          op.pad = pad_set ? pad : NULL;
+          break;
+        case 'u':
+        case 'w':
+        case 'Y':
+          break;
+        case 'n':
+          if (!g_date_time_formatter_add_literal (formatter, "\n", 1))
+            return FALSE;
+          continue;
+        case 'O':
+          alt_digits = TRUE;
+          goto next_mod;
+        case 'p':
+        case 'P':
+          if (!g_date_time_formatter_add_ampm (formatter, GET_AM, c == 'p',
+                                               &op.offset, &op.length) ||
+              !g_date_time_formatter_add_ampm (formatter, GET_PM, c == 'p',
+                                               &op.offset2, &op.length2))
+            return FALSE;
+          break;
+        case 'r':
+          if (!g_date_time_formatter_compile_locale (formatter, PREFERRED_12HR_TIME_FMT, depth))
+            return FALSE;
+          continue;
+        case 't':
+          if (!g_date_time_formatter_add_literal (formatter, "\t", 1))
+            return FALSE;
+          continue;
+        case 'x':
+          if (!g_date_time_formatter_compile_locale (formatter, PREFERRED_DATE_FMT, depth))
+            return FALSE;
+          continue;
+        case 'X':
+          if (!g_date_time_formatter_compile_locale (formatter, PREFERRED_TIME_FMT, depth))
+            return FALSE;
+          continue;
+        case 'z':
+          if (colons > 3)
+            return FALSE;
+          op.colons = colons;
+          break;
+        case '%':
+          if (!g_date_time_formatter_add_literal (formatter, "%", 1))
+            return FALSE;
+          continue;
+        case '-':
+          pad_set = TRUE;
+          pad = "";
+          goto next_mod;
+        case '_':
+          pad_set = TRUE;
+          pad = " ";
+          goto next_mod;
+        case '0':
+          pad_set = TRUE;
+          pad = "0";
+          goto next_mod;
+        case ':':
+          /* Colons are only allowed before 'z' */
+          if (*format && *format != 'z' && *format != ':')
+            return FALSE;
+          colons++;
+          goto next_mod;
+        default:
+          return FALSE;
+        }
+
+      if (formatter->outstr == NULL)
+        g_array_append_val (formatter->ops, op);
+      else if (!g_date_time_formatter_perform (formatter, &op, formatter->date,
+                                               formatter->outstr))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Formats @datetime into @outstr in the locale encoding. */
+static gboolean
+g_date_time_formatter_format_locale (const GDateTimeFormatter *formatter,
+                                     GDateTime                *datetime,
+                                     GString                  *outstr)
+{
+  FormatDate date;
+  guint i;
+
+  date.datetime = datetime;
+  g_date_time_get_ymd (datetime, &date.year, &date.month, &date.day);
+
+  for (i = 0; i < formatter->ops->len; i++)
+    if (!g_date_time_formatter_perform (formatter,
+                                        &g_array_index (formatter->ops, FormatOp, i),
+                                        &date, outstr))
+      return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+g_date_time_formatter_init (GDateTimeFormatter *formatter,
+                            const gchar        *format)
+{
+  formatter->ops = g_array_new (FALSE, TRUE, sizeof (FormatOp));
+  formatter->strings = g_string_new (NULL);
+  formatter->locale_is_utf8 = g_get_charset (NULL);
+  formatter->date = NULL;
+  formatter->outstr = NULL;
+
+  return g_date_time_formatter_compile (formatter, format, 0);
+}
+
+static void
+g_date_time_formatter_clear (GDateTimeFormatter *formatter)
+{
+  if (formatter->ops)
+    g_array_unref (formatter->ops);
+  if (formatter->strings)
+    g_string_free (formatter->strings, TRUE);
+}
+
+/**
+ * g_date_time_formatter_new:
+ * @format: a valid UTF-8 string, containing the format for the
+ *          #GDateTime
+ *
+ * Parses @format, which uses the same syntax as for
+ * g_date_time_format(), into a #GDateTimeFormatter that can format
+ * any number of #GDateTime values without having to look at @format
+ * again.
+ *
+ * The locale's preferred date and time representations and its AM/PM
+ * strings are looked up here rather than for each date, so a
+ * formatter should be created again after the locale changes.
+ *
+ * A #GDateTimeFormatter can be used from multiple threads at once.
+ *
+ * Returns: a new #GDateTimeFormatter, or %NULL if @format is not
+ *     valid.  Free with g_date_time_formatter_free().
+ *
+ * Since: 2.40
+ */
+GDateTimeFormatter *
+g_date_time_formatter_new (const gchar *format)
+{
+  GDateTimeFormatter *formatter;
+
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (g_utf8_validate (format, -1, NULL), NULL);
+
+  formatter = g_slice_new (GDateTimeFormatter);
+  if (!g_date_time_formatter_init (formatter, format))
+    {
+      g_date_time_formatter_free (formatter);
+      return NULL;
+    }
+
+  return formatter;
+}
+
+/**
+ * g_date_time_formatter_free:
+ * @formatter: a #GDateTimeFormatter
+ *
+ * Frees @formatter.
+ *
+ * Since: 2.40
+ */
+void
+g_date_time_formatter_free (GDateTimeFormatter *formatter)
+{
+  g_return_if_fail (formatter != NULL);
+
+  g_date_time_formatter_clear (formatter);
+  g_slice_free (GDateTimeFormatter, formatter);
+}
+
+/**
+ * g_date_time_formatter_append:
+ * @formatter: a #GDateTimeFormatter
+ * @datetime: a #GDateTime
+ * @string: a #GString
+ *
+ * Formats @datetime and appends the result to @string.  Reusing
+ * @string for many dates avoids allocating memory for each of them.
+ *
+ * If formatting fails, @string is left unchanged.
+ *
+ * Returns: %TRUE on success, %FALSE in the case that there was an
+ *     error
+ *
+ * Since: 2.40
+ */
+gboolean
+g_date_time_formatter_append (const GDateTimeFormatter *formatter,
+                              GDateTime                *datetime,
+                              GString                  *string)
+{
+  GString *outstr;
+  gchar *utf8;
+  gsize len;
+
+  g_return_val_if_fail (formatter != NULL, FALSE);
+  g_return_val_if_fail (datetime != NULL, FALSE);
+  g_return_val_if_fail (string != NULL, FALSE);
+
+  if (formatter->locale_is_utf8)
+    {
+      len = string->len;
+      if (!g_date_time_formatter_format_locale (formatter, datetime, string))
+        {
+          g_string_truncate (string, len);
+          return FALSE;
+        }
+
+      return TRUE;
     }
 
+  outstr = g_string_sized_new (formatter->strings->len * 2);
+  if (!g_date_time_formatter_format_locale (formatter, datetime, outstr))
+    {
+      g_string_free (outstr, TRUE);
+      return FALSE;
+    }
+
+  utf8 = g_locale_to_utf8 (outstr->str, outstr->len, NULL, &len, NULL);
+  g_string_free (outstr, TRUE);
+  if (!utf8)
+    return FALSE;
+
+  g_string_append_len (string, utf8, len);
+  g_free (utf8);
+
   return TRUE;
 }
 
+/**
+ * g_date_time_formatter_format:
+ * @formatter: a #GDateTimeFormatter
+ * @datetime: a #GDateTime
+ *
+ * Formats @datetime like g_date_time_format() would with the format
+ * @formatter was created for.
+ *
+ * Returns: a newly allocated string formatted to the requested format
+ *          or %NULL in the case that there was an error.  The string
+ *          should be freed with g_free().
+ *
+ * Since: 2.40
+ */
+gchar *
+g_date_time_formatter_format (const GDateTimeFormatter *formatter,
+                              GDateTime                *datetime)
+{
+  GString *outstr;
+
+  g_return_val_if_fail (formatter != NULL, NULL);
+  g_return_val_if_fail (datetime != NULL, NULL);
+
+  outstr = g_string_sized_new (formatter->strings->len * 2 + 16);
+
+  if (!g_date_time_formatter_append (formatter, datetime, outstr))
+    {
+      g_string_free (outstr, TRUE);
+      return NULL;
+    }
+
+  return g_string_free (outstr, FALSE);
+}
+
 /**
  * g_date_time_format:
  * @datetime: A #GDateTime
@@ -2811,23 +3172,34 @@ gchar *
 g_date_time_format (GDateTime   *datetime,
                     const gchar *format)
 {
+  GDateTimeFormatter formatter = { NULL, };
+  FormatDate date;
   GString  *outstr;
   gchar *utf8;
-  gboolean locale_is_utf8 = g_get_charset (NULL);
+  gboolean success;
 
   g_return_val_if_fail (datetime != NULL, NULL);
   g_return_val_if_fail (format != NULL, NULL);
   g_return_val_if_fail (g_utf8_validate (format, -1, NULL), NULL);
 
+  date.datetime = datetime;
+  g_date_time_get_ymd (datetime, &date.year, &date.month, &date.day);
+
   outstr = g_string_sized_new (strlen (format) * 2);
 
-  if (!g_date_time_format_locale (datetime, format, outstr, locale_is_utf8))
+  formatter.locale_is_utf8 = g_get_charset (NULL);
+  formatter.date = &date;
+  formatter.outstr = outstr;
+  success = g_date_time_formatter_compile (&formatter, format, 0);
+  g_date_time_formatter_clear (&formatter);
+
+  if (!success)
     {
       g_string_free (outstr, TRUE);
       return NULL;
     }
 
-  if (locale_is_utf8)
+  if (formatter.locale_is_utf8)
     return g_string_free (outstr, FALSE);
 
   utf8 = g_locale_to_utf8 (outstr->str, outstr->len, NULL, NULL, NULL);
@@ -2835,6 +3207,91 @@ g_date_time_format (GDateTime   *datetime,
   return utf8;
 }
 
+static inline gchar *
+put_digits (gchar *p,
+            gint   width,
+            guint  number)
+{
+  gint i;
+
+  for (i = width - 1; i >= 0; i--)
+    {
+      p[i] = '0' + number % 10;
+      number /= 10;
+    }
+
+  return p + width;
+}
+
+/**
+ * g_date_time_format_iso8601:
+ * @datetime: A #GDateTime
+ *
+ * Formats @datetime in the ISO 8601 extended format, for example
+ * <literal>2014-02-28T13:01:27+01:00</literal>.  Microseconds are
+ * added as a fraction of the seconds when they are not zero, and
+ * UTC is written as <literal>Z</literal>.  Offsets that aren't a whole
+ * number of minutes, which only occur for historical local mean time,
+ * are written with seconds.
+ *
+ * This gives the same result as g_date_time_format() with
+ * <literal>"\%Y-\%m-\%dT\%H:\%M:\%S"</literal> and a suitable suffix,
+ * but is much faster and independent of the locale.
+ *
+ * Returns: a newly allocated string, to be freed with g_free()
+ *
+ * Since: 2.40
+ */
+gchar *
+g_date_time_format_iso8601 (GDateTime *datetime)
+{
+  gchar buffer[sizeof "YYYY-MM-DDTHH:MM:SS.uuuuuu+hh:mm:ss"];
+  gint year, month, day;
+  gint usec, offset;
+  gchar *p = buffer;
+
+  g_return_val_if_fail (datetime != NULL, NULL);
+
+  g_date_time_get_ymd (datetime, &year, &month, &day);
+  p = put_digits (p, 4, year);
+  *p++ = '-';
+  p = put_digits (p, 2, month);
+  *p++ = '-';
+  p = put_digits (p, 2, day);
+  *p++ = 'T';
+  p = put_digits (p, 2, g_date_time_get_hour (datetime));
+  *p++ = ':';
+  p = put_digits (p, 2, g_date_time_get_minute (datetime));
+  *p++ = ':';
+  p = put_digits (p, 2, g_date_time_get_second (datetime));
+
+  usec = g_date_time_get_microsecond (datetime);
+  if (usec != 0)
+    {
+      *p++ = '.';
+      p = put_digits (p, 6, usec);
+    }
+
+  offset = g_date_time_get_utc_offset (datetime) / USEC_PER_SECOND;
+  if (offset == 0)
+    *p++ = 'Z';
+  else
+    {
+      *p++ = offset < 0 ? '-' : '+';
+      offset = ABS (offset);
+      p = put_digits (p, 2, offset / 3600);
+      *p++ = ':';
+      p = put_digits (p, 2, offset / 60 % 60);
+      if (offset % 60 != 0)
+        {
+          *p++ = ':';
+          p = put_digits (p, 2, offset % 60);
+        }
+    }
+
+  return g_strndup (buffer, p - buffer);
+}
+
 
 /* Epilogue {{{1 */
 /* vim:set foldmethod=marker: */
@@ -30,6 +30,7 @@
 #error "Only <glib.h> can be included directly."
 #endif
 
+#include <glib/gstring.h>
 #include <glib/gtimezone.h>
 
 G_BEGIN_DECLS
@@ -98,6 +99,17 @@ typedef gint64 GTimeSpan;
  */
 typedef struct _GDateTime GDateTime;
 
+/**
+ * GDateTimeFormatter:
+ *
+ * A compiled format string for formatting #GDateTime values
+ * repeatedly.  It is an opaque structure whose members cannot be
+ * accessed directly.
+ *
+ * Since: 2.40
+ */
+typedef struct _GDateTimeFormatter GDateTimeFormatter;
+
 GLIB_AVAILABLE_IN_ALL
 void                    g_date_time_unref                               (GDateTime      *datetime);
 GLIB_AVAILABLE_IN_ALL
@@ -258,6 +270,20 @@ GDateTime *             g_date_time_to_utc                              (GDateTi
 GLIB_AVAILABLE_IN_ALL
 gchar *                 g_date_time_format                              (GDateTime      *datetime,
                                                                          const gchar    *format) G_GNUC_MALLOC;
+GLIB_AVAILABLE_IN_2_40
+gchar *                 g_date_time_format_iso8601                      (GDateTime      *datetime) G_GNUC_MALLOC;
+
+GLIB_AVAILABLE_IN_2_40
+GDateTimeFormatter *    g_date_time_formatter_new                       (const gchar    *format);
+GLIB_AVAILABLE_IN_2_40
+void                    g_date_time_formatter_free                      (GDateTimeFormatter *formatter);
+GLIB_AVAILABLE_IN_2_40
+gchar *                 g_date_time_formatter_format                    (const GDateTimeFormatter *formatter,
+                                                                         GDateTime      *datetime) G_GNUC_MALLOC;
+GLIB_AVAILABLE_IN_2_40
+gboolean                g_date_time_formatter_append                    (const GDateTimeFormatter *formatter,
+                                                                         GDateTime      *datetime,
+                                                                         GString        *string);
 
 G_END_DECLS
 
@@ -193,6 +193,33 @@
  * A test to perform on a file using g_file_test().
  */
 
+/**
+ * GFileSetContentsFlags:
+ * @G_FILE_SET_CONTENTS_NONE: no flushing to disk; fastest, but after a
+ *     crash the file may be empty
+ * @G_FILE_SET_CONTENTS_CONSISTENT: flush the new contents to disk
+ *     before they replace the old ones
+ * @G_FILE_SET_CONTENTS_DURABLE: also make the replacement itself
+ *     reach the disk; implies %G_FILE_SET_CONTENTS_CONSISTENT
+ * @G_FILE_SET_CONTENTS_ONLY_EXISTING: only flush when an existing,
+ *     non-empty file is replaced
+ * @G_FILE_SET_CONTENTS_ANONYMOUS: create the temporary file without a
+ *     name, where the system supports it
+ *
+ * Flags for g_file_set_contents_full() and g_file_sync_group_new().
+ *
+ * Since: 2.40
+ */
+
+/**
+ * GFileSyncGroup:
+ *
+ * An opaque structure for replacing the contents of many files with
+ * one flush to disk.  See g_file_sync_group_new().
+ *
+ * Since: 2.40
+ */
+
 /**
  * g_mkdir_with_parents:
  * @pathname: a pathname in the GLib file name encoding
@@ -1022,54 +1049,173 @@ set_file_error (GError      **error,
   g_free (msg);
 }
 
-static gchar *
-write_to_temp_file (const gchar  *contents,
-		    gssize        length,
-		    const gchar  *dest_file,
-		    GError      **err)
+typedef gint (*GTmpFileCallback) (const gchar *, gint, gint);
+
+static gint get_tmp_file (gchar            *tmpl,
+                          GTmpFileCallback  f,
+                          int               flags,
+                          int               mode);
+
+/* A file written by g_file_sync_group_set_contents() which has not been
+ * moved into place yet.
+ */
+typedef struct
 {
-  gchar *tmp_name;
-  gchar *retval;
-  gint fd;
+  gchar    *filename;
+  gchar    *tmp_filename;  /* NULL while the file is anonymous */
+  gint      fd;            /* -1 once closed */
+  gboolean  needs_sync;
+} PendingFile;
+
+struct _GFileSyncGroup
+{
+  GFileSetContentsFlags  flags;
+  GPtrArray             *pending;
+};
 
-  retval = NULL;
+static void
+pending_file_free (gpointer data)
+{
+  PendingFile *file = data;
+
+  if (file->fd != -1)
+    close (file->fd);
+  if (file->tmp_filename)
+    g_unlink (file->tmp_filename);
+
+  g_free (file->filename);
+  g_free (file->tmp_filename);
+  g_slice_free (PendingFile, file);
+}
 
-  tmp_name = g_strdup_printf ("%s.XXXXXX", dest_file);
+/* Flushes the data, and the size, of the file open at @fd */
+static gint
+sync_file_data (gint fd)
+{
+#if defined (HAVE_FDATASYNC)
+  return fdatasync (fd);
+#elif defined (HAVE_FSYNC)
+  return fsync (fd);
+#else
+  return 0;
+#endif
+}
+
+/* Decides whether the data written for @file has to reach the disk
+ * before it replaces the destination.
+ */
+static gboolean
+pending_file_needs_sync (PendingFile           *file,
+                         GFileSetContentsFlags  flags)
+{
+  /* a durable rename of unflushed data could leave an empty file */
+  if (!(flags & (G_FILE_SET_CONTENTS_CONSISTENT | G_FILE_SET_CONTENTS_DURABLE)))
+    return FALSE;
+
+  if ((flags & G_FILE_SET_CONTENTS_ONLY_EXISTING) &&
+      !(flags & G_FILE_SET_CONTENTS_DURABLE))
+    {
+      struct stat statbuf;
+
+#ifdef BTRFS_SUPER_MAGIC
+      {
+        struct statfs buf;
+
+        /* On Linux, on btrfs, skip the fsync since rename-over-existing is
+         * guaranteed to be atomic and this is the only case in which we
+         * would fsync() anyway.
+         */
+        if (fstatfs (file->fd, &buf) == 0 && buf.f_type == BTRFS_SUPER_MAGIC)
+          return FALSE;
+      }
+#endif
+
+      /* If the final destination exists and is > 0 bytes, we want to sync the
+       * newly written file to ensure the data is on disk when we rename over
+       * the destination. Otherwise if we get a system crash we can lose both
+       * the new and the old file on some filesystems. (I.E. those that don't
+       * guarantee the data is written to the disk before the metadata.)
+       */
+      if (g_lstat (file->filename, &statbuf) != 0 || statbuf.st_size == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Creates the temporary file for @file, either without a name or as
+ * its file name followed by 7 characters.
+ */
+static gboolean
+pending_file_create (PendingFile           *file,
+                     GFileSetContentsFlags  flags,
+                     gint                   mode,
+                     GError               **err)
+{
+#ifdef O_TMPFILE
+  if (flags & G_FILE_SET_CONTENTS_ANONYMOUS)
+    {
+      gchar *dirname = g_path_get_dirname (file->filename);
+
+      /* falls back to a named file if the kernel or the file system
+       * does not support O_TMPFILE
+       */
+      file->fd = g_open (dirname, O_TMPFILE | O_WRONLY | O_CLOEXEC, mode);
+      g_free (dirname);
+
+      if (file->fd != -1)
+        return TRUE;
+    }
+#endif
+
+  file->tmp_filename = g_strdup_printf ("%s.XXXXXX", file->filename);
 
   errno = 0;
-  fd = g_mkstemp_full (tmp_name, O_RDWR | O_BINARY, 0666);
+  file->fd = g_mkstemp_full (file->tmp_filename, O_RDWR | O_BINARY, mode);
 
-  if (fd == -1)
+  if (file->fd == -1)
     {
-      set_file_error (err, tmp_name, _("Failed to create file '%s': %s"));
-      goto out;
+      set_file_error (err, file->tmp_filename, _("Failed to create file '%s': %s"));
+      g_free (file->tmp_filename);
+      file->tmp_filename = NULL;
+
+      return FALSE;
     }
 
+  return TRUE;
+}
+
+static gboolean
+pending_file_write (PendingFile  *file,
+                    const gchar  *contents,
+                    gssize        length,
+                    GError      **err)
+{
+  const gchar *display_name = file->tmp_filename ? file->tmp_filename : file->filename;
+
 #ifdef HAVE_FALLOCATE
   if (length > 0)
     {
       /* We do this on a 'best effort' basis... It may not be supported
        * on the underlying filesystem.
        */
-      (void) fallocate (fd, 0, 0, length);
+      (void) fallocate (file->fd, 0, 0, length);
     }
 #endif
   while (length > 0)
     {
       gssize s;
 
-      s = write (fd, contents, length);
+      s = write (file->fd, contents, length);
 
       if (s < 0)
         {
           if (errno == EINTR)
             continue;
 
-          set_file_error (err, tmp_name, _("Failed to write file '%s': write() failed: %s"));
-          close (fd);
-          g_unlink (tmp_name);
+          set_file_error (err, display_name, _("Failed to write file '%s': write() failed: %s"));
 
-          goto out;
+          return FALSE;
         }
 
       g_assert (s <= length);
@@ -1078,58 +1224,420 @@ write_to_temp_file (const gchar  *contents,
       length -= s;
     }
 
-#ifdef BTRFS_SUPER_MAGIC
-  {
-    struct statfs buf;
+  return TRUE;
+}
 
-    /* On Linux, on btrfs, skip the fsync since rename-over-existing is
-     * guaranteed to be atomic and this is the only case in which we
-     * would fsync() anyway.
-     */
+#ifdef O_TMPFILE
+/* A GTmpFileCallback which gives the name @filename to the anonymous
+ * file open at @fd.  linkat() with AT_EMPTY_PATH would need
+ * CAP_DAC_READ_SEARCH, so this goes through /proc instead.
+ */
+static gint
+wrap_linkat (const gchar *filename,
+             int          fd,
+             int          mode G_GNUC_UNUSED)
+{
+  gchar proc_path[64];
 
-    if (fstatfs (fd, &buf) == 0 && buf.f_type == BTRFS_SUPER_MAGIC)
-      goto no_fsync;
-  }
+  g_snprintf (proc_path, sizeof proc_path, "/proc/self/fd/%d", fd);
+
+  return linkat (AT_FDCWD, proc_path, AT_FDCWD, filename, AT_SYMLINK_FOLLOW);
+}
 #endif
 
-#ifdef HAVE_FSYNC
-  {
-    struct stat statbuf;
-
-    errno = 0;
-    /* If the final destination exists and is > 0 bytes, we want to sync the
-     * newly written file to ensure the data is on disk when we rename over
-     * the destination. Otherwise if we get a system crash we can lose both
-     * the new and the old file on some filesystems. (I.E. those that don't
-     * guarantee the data is written to the disk before the metadata.)
-     */
-    if (g_lstat (dest_file, &statbuf) == 0 && statbuf.st_size > 0 && fsync (fd) != 0)
-      {
-        set_file_error (err, tmp_name, _("Failed to write file '%s': fsync() failed: %s"));
-        close (fd);
-        g_unlink (tmp_name);
+/* Moves @file into place, naming and closing it first */
+static gboolean
+pending_file_replace (PendingFile  *file,
+                      GError      **err)
+{
+  GError *rename_error = NULL;
 
-        goto out;
-      }
-  }
-#endif
+#ifdef O_TMPFILE
+  if (file->tmp_filename == NULL)
+    {
+      gchar *tmp_filename = g_strdup_printf ("%s.XXXXXX", file->filename);
 
-#ifdef BTRFS_SUPER_MAGIC
- no_fsync:
+      errno = 0;
+      if (get_tmp_file (tmp_filename, wrap_linkat, file->fd, 0) == -1)
+        {
+          set_file_error (err, file->filename, _("Failed to create file '%s': %s"));
+          g_free (tmp_filename);
+
+          return FALSE;
+        }
+
+      file->tmp_filename = tmp_filename;
+    }
 #endif
 
   errno = 0;
-  if (!g_close (fd, err))
+  if (!g_close (file->fd, err))
+    {
+      file->fd = -1;
+
+      return FALSE;
+    }
+  file->fd = -1;
+
+  if (!rename_file (file->tmp_filename, file->filename, &rename_error))
+    {
+#ifndef G_OS_WIN32
+
+      g_propagate_error (err, rename_error);
+      return FALSE;
+
+#else /* G_OS_WIN32 */
+
+      /* Renaming failed, but on Windows this may just mean
+       * the file already exists. So if the target file
+       * exists, try deleting it and do the rename again.
+       */
+      if (!g_file_test (file->filename, G_FILE_TEST_EXISTS))
+	{
+	  g_propagate_error (err, rename_error);
+	  return FALSE;
+	}
+
+      g_error_free (rename_error);
+
+      if (g_unlink (file->filename) == -1)
+	{
+          gchar *display_filename = g_filename_display_name (file->filename);
+
+	  int save_errno = errno;
+
+	  g_set_error (err,
+		       G_FILE_ERROR,
+		       g_file_error_from_errno (save_errno),
+		       _("Existing file '%s' could not be removed: g_unlink() failed: %s"),
+		       display_filename,
+		       g_strerror (save_errno));
+
+	  g_free (display_filename);
+	  return FALSE;
+	}
+
+      if (!rename_file (file->tmp_filename, file->filename, err))
+	return FALSE;
+
+#endif
+    }
+
+  g_free (file->tmp_filename);
+  file->tmp_filename = NULL;
+
+  return TRUE;
+}
+
+/**
+ * g_file_sync_group_new:
+ * @flags: how the files written with the group are flushed to disk
+ *
+ * Creates a #GFileSyncGroup, for replacing the contents of many files
+ * with a single flush to disk.
+ *
+ * g_file_sync_group_set_contents() writes each file to a temporary
+ * file, and g_file_sync_group_commit() then flushes all of them and
+ * moves them into place.  When several of the files need flushing and
+ * are on the same file system, the whole file system is flushed once
+ * with syncfs() where available, rather than each file separately.
+ * That also flushes data written by other programs, so it pays off
+ * when there are many files.
+ *
+ * Return value: a new #GFileSyncGroup.  Free with g_file_sync_group_free().
+ *
+ * Since: 2.40
+ */
+GFileSyncGroup *
+g_file_sync_group_new (GFileSetContentsFlags flags)
+{
+  GFileSyncGroup *group;
+
+  group = g_slice_new (GFileSyncGroup);
+  group->flags = flags;
+  group->pending = g_ptr_array_new_with_free_func (pending_file_free);
+
+  return group;
+}
+
+/**
+ * g_file_sync_group_free:
+ * @group: a #GFileSyncGroup
+ *
+ * Frees @group.  Files written with the group since the last
+ * g_file_sync_group_commit() are discarded, and their destinations
+ * keep their old contents.
+ *
+ * Since: 2.40
+ */
+void
+g_file_sync_group_free (GFileSyncGroup *group)
+{
+  g_return_if_fail (group != NULL);
+
+  g_ptr_array_unref (group->pending);
+  g_slice_free (GFileSyncGroup, group);
+}
+
+/**
+ * g_file_sync_group_set_contents:
+ * @group: a #GFileSyncGroup
+ * @filename: (type filename): name of a file to write @contents to, in the GLib file name
+ *   encoding
+ * @contents: (array length=length) (element-type guint8): string to write to the file
+ * @length: length of @contents, or -1 if @contents is a nul-terminated string
+ * @mode: file mode, as passed to open(), for the new file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes all of @contents to a temporary file, which replaces @filename
+ * when @group is committed with g_file_sync_group_commit().  Until then
+ * @filename is left alone.
+ *
+ * See g_file_set_contents_full() for the meaning of the flags of
+ * @group.
+ *
+ * Return value: %TRUE on success, %FALSE if an error occurred
+ *
+ * Since: 2.40
+ */
+gboolean
+g_file_sync_group_set_contents (GFileSyncGroup  *group,
+                                const gchar     *filename,
+                                const gchar     *contents,
+                                gssize           length,
+                                gint             mode,
+                                GError         **error)
+{
+  PendingFile *file;
+
+  g_return_val_if_fail (group != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  g_return_val_if_fail (contents != NULL || length == 0, FALSE);
+  g_return_val_if_fail (length >= -1, FALSE);
+
+  if (length == -1)
+    length = strlen (contents);
+
+  file = g_slice_new0 (PendingFile);
+  file->filename = g_strdup (filename);
+  file->fd = -1;
+
+  if (!pending_file_create (file, group->flags, mode, error) ||
+      !pending_file_write (file, contents, length, error))
     {
-      g_unlink (tmp_name);
+      pending_file_free (file);
+      return FALSE;
+    }
+
+  file->needs_sync = pending_file_needs_sync (file, group->flags);
+  g_ptr_array_add (group->pending, file);
 
+  return TRUE;
+}
+
+/* Flushes the pending files of @group that need it */
+static gboolean
+sync_group_flush (GFileSyncGroup  *group,
+                  GError         **err)
+{
+  guint i;
+#ifdef HAVE_SYNCFS
+  guint n_sync = 0;
+
+  for (i = 0; i < group->pending->len; i++)
+    n_sync += ((PendingFile *) group->pending->pdata[i])->needs_sync;
+
+  /* one syncfs() per file system */
+  if (n_sync > 1)
+    {
+      GArray *devices;
+
+      devices = g_array_new (FALSE, FALSE, sizeof (dev_t));
+
+      for (i = 0; i < group->pending->len; i++)
+        {
+          PendingFile *file = group->pending->pdata[i];
+          struct stat statbuf;
+          guint j;
+
+          if (!file->needs_sync)
+            continue;
+
+          errno = 0;
+          if (fstat (file->fd, &statbuf) == 0)
+            {
+              for (j = 0; j < devices->len; j++)
+                if (g_array_index (devices, dev_t, j) == statbuf.st_dev)
+                  break;
+
+              if (j < devices->len)
+                continue;
+
+              g_array_append_val (devices, statbuf.st_dev);
+
+              if (syncfs (file->fd) == 0)
+                continue;
+            }
+
+          set_file_error (err, file->filename, _("Failed to write file '%s': fsync() failed: %s"));
+          g_array_unref (devices);
+
+          return FALSE;
+        }
+
+      g_array_unref (devices);
+
+      return TRUE;
+    }
+#endif
+
+  for (i = 0; i < group->pending->len; i++)
+    {
+      PendingFile *file = group->pending->pdata[i];
+
+      errno = 0;
+      if (file->needs_sync && sync_file_data (file->fd) != 0)
+        {
+          set_file_error (err, file->filename, _("Failed to write file '%s': fsync() failed: %s"));
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/**
+ * g_file_sync_group_commit:
+ * @group: a #GFileSyncGroup
+ * @error: return location for a #GError, or %NULL
+ *
+ * Flushes the files written with @group to disk, as the flags of
+ * @group ask for, and then moves each of them into place.
+ *
+ * If an error occurs, the files that were not moved into place yet
+ * are discarded.  Either way @group is empty afterwards and can be
+ * used again.
+ *
+ * Return value: %TRUE on success, %FALSE if an error occurred
+ *
+ * Since: 2.40
+ */
+gboolean
+g_file_sync_group_commit (GFileSyncGroup  *group,
+                          GError         **error)
+{
+  gboolean retval = FALSE;
+  guint i;
+
+  g_return_val_if_fail (group != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (!sync_group_flush (group, error))
+    goto out;
+
+  for (i = 0; i < group->pending->len; i++)
+    if (!pending_file_replace (group->pending->pdata[i], error))
       goto out;
+
+#if defined (HAVE_FSYNC) && !defined (G_OS_WIN32)
+  if (group->flags & G_FILE_SET_CONTENTS_DURABLE)
+    {
+      GHashTable *dirs;
+
+      /* make the renames themselves durable, once per directory */
+      dirs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+      for (i = 0; i < group->pending->len; i++)
+        {
+          PendingFile *file = group->pending->pdata[i];
+          gchar *dirname = g_path_get_dirname (file->filename);
+          gint fd;
+
+          if (g_hash_table_contains (dirs, dirname))
+            {
+              g_free (dirname);
+              continue;
+            }
+          g_hash_table_add (dirs, dirname);
+
+          errno = 0;
+          fd = g_open (dirname, O_RDONLY, 0);
+          if (fd == -1 || fsync (fd) != 0)
+            {
+              set_file_error (error, dirname, _("Failed to write file '%s': fsync() failed: %s"));
+              if (fd != -1)
+                close (fd);
+              g_hash_table_unref (dirs);
+              goto out;
+            }
+          close (fd);
+        }
+
+      g_hash_table_unref (dirs);
     }
+#endif
 
-  retval = g_strdup (tmp_name);
+  retval = TRUE;
 
  out:
-  g_free (tmp_name);
+  g_ptr_array_set_size (group->pending, 0);
+
+  return retval;
+}
+
+/**
+ * g_file_set_contents_full:
+ * @filename: (type filename): name of a file to write @contents to, in the GLib file name
+ *   encoding
+ * @contents: (array length=length) (element-type guint8): string to write to the file
+ * @length: length of @contents, or -1 if @contents is a nul-terminated string
+ * @flags: flags controlling how the file is flushed to disk
+ * @mode: file mode, as passed to open(), for the new file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes all of @contents to a file named @filename, like
+ * g_file_set_contents(), with control over flushing it to disk.
+ *
+ * With %G_FILE_SET_CONTENTS_CONSISTENT, the new contents are flushed to
+ * disk before they replace the old ones, so that after a crash
+ * @filename has either the old or the new contents.  Add
+ * %G_FILE_SET_CONTENTS_ONLY_EXISTING to only do this when an existing,
+ * non-empty file is replaced, as g_file_set_contents() does.  With
+ * %G_FILE_SET_CONTENTS_DURABLE, which implies
+ * %G_FILE_SET_CONTENTS_CONSISTENT, the replacement itself is also on
+ * disk when this function returns.
+ *
+ * With %G_FILE_SET_CONTENTS_ANONYMOUS the temporary file has no name
+ * until it is complete, where the system supports it (O_TMPFILE on
+ * Linux), so nothing is left behind if the program dies while writing.
+ *
+ * Use a #GFileSyncGroup to replace many files with one flush.
+ *
+ * Return value: %TRUE on success, %FALSE if an error occurred
+ *
+ * Since: 2.40
+ */
+gboolean
+g_file_set_contents_full (const gchar            *filename,
+                          const gchar            *contents,
+                          gssize                  length,
+                          GFileSetContentsFlags   flags,
+                          gint                    mode,
+                          GError                **error)
+{
+  GFileSyncGroup *group;
+  gboolean retval;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  g_return_val_if_fail (contents != NULL || length == 0, FALSE);
+  g_return_val_if_fail (length >= -1, FALSE);
+
+  group = g_file_sync_group_new (flags);
+  retval = g_file_sync_group_set_contents (group, filename, contents, length, mode, error) &&
+           g_file_sync_group_commit (group, error);
+  g_file_sync_group_free (group);
 
   return retval;
 }
@@ -1183,93 +1691,16 @@ g_file_set_contents (const gchar  *filename,
 		     gssize	   length,
 		     GError	 **error)
 {
-  gchar *tmp_filename;
-  gboolean retval;
-  GError *rename_error = NULL;
-  
-  g_return_val_if_fail (filename != NULL, FALSE);
-  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-  g_return_val_if_fail (contents != NULL || length == 0, FALSE);
-  g_return_val_if_fail (length >= -1, FALSE);
-  
-  if (length == -1)
-    length = strlen (contents);
-
-  tmp_filename = write_to_temp_file (contents, length, filename, error);
-  
-  if (!tmp_filename)
-    {
-      retval = FALSE;
-      goto out;
-    }
-
-  if (!rename_file (tmp_filename, filename, &rename_error))
-    {
-#ifndef G_OS_WIN32
-
-      g_unlink (tmp_filename);
-      g_propagate_error (error, rename_error);
-      retval = FALSE;
-      goto out;
-
-#else /* G_OS_WIN32 */
-      
-      /* Renaming failed, but on Windows this may just mean
-       * the file already exists. So if the target file
-       * exists, try deleting it and do the rename again.
-       */
-      if (!g_file_test (filename, G_FILE_TEST_EXISTS))
-	{
-	  g_unlink (tmp_filename);
-	  g_propagate_error (error, rename_error);
-	  retval = FALSE;
-	  goto out;
-	}
-
-      g_error_free (rename_error);
-      
-      if (g_unlink (filename) == -1)
-	{
-          gchar *display_filename = g_filename_display_name (filename);
-
-	  int save_errno = errno;
-	  
-	  g_set_error (error,
-		       G_FILE_ERROR,
-		       g_file_error_from_errno (save_errno),
-		       _("Existing file '%s' could not be removed: g_unlink() failed: %s"),
-		       display_filename,
-		       g_strerror (save_errno));
-
-	  g_free (display_filename);
-	  g_unlink (tmp_filename);
-	  retval = FALSE;
-	  goto out;
-	}
-      
-      if (!rename_file (tmp_filename, filename, error))
-	{
-	  g_unlink (tmp_filename);
-	  retval = FALSE;
-	  goto out;
-	}
-
-#endif
-    }
-
-  retval = TRUE;
-  
- out:
-  g_free (tmp_filename);
-  return retval;
+  return g_file_set_contents_full (filename, contents, length,
+                                   G_FILE_SET_CONTENTS_CONSISTENT |
+                                   G_FILE_SET_CONTENTS_ONLY_EXISTING,
+                                   0666, error);
 }
 
 /*
  * get_tmp_file based on the mkstemp implementation from the GNU C library.
  * Copyright (C) 1991,92,93,94,95,96,97,98,99 Free Software Foundation, Inc.
  */
-typedef gint (*GTmpFileCallback) (const gchar *, gint, gint);
-
 static gint
 get_tmp_file (gchar            *tmpl,
               GTmpFileCallback  f,
@@ -73,6 +73,17 @@ typedef enum
   G_FILE_TEST_EXISTS        = 1 << 4
 } GFileTest;
 
+typedef enum
+{
+  G_FILE_SET_CONTENTS_NONE          = 0,
+  G_FILE_SET_CONTENTS_CONSISTENT    = 1 << 0,
+  G_FILE_SET_CONTENTS_DURABLE       = 1 << 1,
+  G_FILE_SET_CONTENTS_ONLY_EXISTING = 1 << 2,
+  G_FILE_SET_CONTENTS_ANONYMOUS     = 1 << 3
+} GFileSetContentsFlags;
+
+typedef struct _GFileSyncGroup GFileSyncGroup;
+
 GLIB_AVAILABLE_IN_ALL
 GQuark     g_file_error_quark      (void);
 /* So other code can generate a GFileError */
@@ -92,6 +103,28 @@ gboolean g_file_set_contents (const gchar *filename,
                               const gchar *contents,
                               gssize         length,
                               GError       **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_file_set_contents_full (const gchar            *filename,
+                                   const gchar            *contents,
+                                   gssize                  length,
+                                   GFileSetContentsFlags   flags,
+                                   gint                    mode,
+                                   GError                **error);
+
+GLIB_AVAILABLE_IN_2_40
+GFileSyncGroup *g_file_sync_group_new          (GFileSetContentsFlags   flags);
+GLIB_AVAILABLE_IN_2_40
+void            g_file_sync_group_free         (GFileSyncGroup         *group);
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_file_sync_group_set_contents (GFileSyncGroup         *group,
+                                                const gchar            *filename,
+                                                const gchar            *contents,
+                                                gssize                  length,
+                                                gint                    mode,
+                                                GError                **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_file_sync_group_commit       (GFileSyncGroup         *group,
+                                                GError                **error);
 GLIB_AVAILABLE_IN_ALL
 gchar   *g_file_read_link    (const gchar  *filename,
                               GError      **error);
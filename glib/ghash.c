@@ -31,13 +31,19 @@
 #include "config.h"
 
 #include <string.h>  /* memset */
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ghash.h"
+#include "ghashprivate.h"
 
 #include "gstrfuncs.h"
 #include "gatomic.h"
 #include "gtestutils.h"
 #include "gslice.h"
+#include "gthread.h"
+#include "grand.h"
 
 
 /**
@@ -203,12 +209,48 @@
 
 #define HASH_TABLE_MIN_SHIFT 3  /* 1 << 3 == 8 buckets */
 
+/* Tables of at least this many buckets are resized a few buckets at a
+ * time; see g_hash_table_maybe_resize().
+ */
+#define HASH_TABLE_INCREMENTAL_SHIFT 16
+#define HASH_TABLE_RESIZE_STEP 32
+
 #define UNUSED_HASH_VALUE 0
 #define TOMBSTONE_HASH_VALUE 1
 #define HASH_IS_UNUSED(h_) ((h_) == UNUSED_HASH_VALUE)
 #define HASH_IS_TOMBSTONE(h_) ((h_) == TOMBSTONE_HASH_VALUE)
 #define HASH_IS_REAL(h_) ((h_) >= 2)
 
+/* Next to hashes[], every node has a control byte: either CTRL_EMPTY
+ * (for UNUSED_HASH_VALUE), CTRL_DELETED (for TOMBSTONE_HASH_VALUE) or
+ * seven bits of the hash value.  Lookups probe a group of CTRL_GROUP
+ * consecutive control bytes at a time, and only look at hashes[] and
+ * keys[] for the nodes whose byte matches.  The first CTRL_GROUP bytes
+ * are mirrored after the end of the array, so that a group can start
+ * at any node.
+ */
+#define CTRL_EMPTY   0x80
+#define CTRL_DELETED 0xfe
+#define CTRL_H2(h_)  ((guint8) (((h_) * 0x9e3779b1U) >> 25))
+
+/* Tables of the minimum size are instead searched linearly and have
+ * no control bytes (ctrl is NULL): lots of tables never hold more than
+ * a handful of entries, and this saves them an allocation.  Their
+ * hashes[] also share a block with keys[], and removals leave no
+ * tombstones behind.
+ */
+#define HASH_TABLE_IS_SMALL(size_) ((size_) == 1 << HASH_TABLE_MIN_SHIFT)
+
+#ifdef __SSE2__
+#define CTRL_GROUP 16
+typedef guint32 CtrlMask;
+#else
+#define CTRL_GROUP 8
+typedef guint64 CtrlMask;
+#endif
+
+typedef struct _GHashTableResize GHashTableResize;
+
 struct _GHashTable
 {
   gint             size;
@@ -220,6 +262,7 @@ struct _GHashTable
   gpointer        *keys;
   guint           *hashes;
   gpointer        *values;
+  guint8          *ctrl;       /* size + CTRL_GROUP control bytes, or NULL */
 
   GHashFunc        hash_func;
   GEqualFunc       key_equal_func;
@@ -234,6 +277,32 @@ struct _GHashTable
 #endif
   GDestroyNotify   key_destroy_func;
   GDestroyNotify   value_destroy_func;
+
+  GHashTableResize *resize;    /* incremental resize in progress, or NULL */
+  gint             reserved;   /* g_hash_table_reserve(), until reached */
+  GArena          *arena;      /* see g_hash_table_new_in_arena() */
+};
+
+/* The arrays a table is being moved to.  Until all the old nodes have
+ * been moved, the old arrays stay authoritative for lookups and
+ * iteration; changes to old nodes that were already moved are mirrored
+ * into the new arrays.
+ */
+struct _GHashTableResize
+{
+  gint             size;
+  gint             mod;
+  guint            mask;
+  gint             nnodes;
+  gint             noccupied;
+
+  gpointer        *keys;
+  guint           *hashes;
+  gpointer        *values;
+  guint8          *ctrl;
+
+  guint           *new_index;  /* new position of each moved old node */
+  gint             position;   /* old nodes below this have been moved */
 };
 
 typedef struct
@@ -246,6 +315,16 @@ typedef struct
   int          version;
 } RealIter;
 
+static void g_hash_table_resize_free          (GHashTable       *hash_table,
+                                               GHashTableResize *resize);
+static GHashTable *g_hash_table_new_internal  (GArena           *arena,
+                                               GHashFunc         hash_func,
+                                               GEqualFunc        key_equal_func,
+                                               GDestroyNotify    key_destroy_func,
+                                               GDestroyNotify    value_destroy_func);
+static void g_hash_table_resize_mirror_remove (GHashTable       *hash_table,
+                                               gint              i);
+
 /* Each table size has an associated prime modulo (the first prime
  * lower than the table size) used to find the initial bucket. Probing
  * then works modulo 2^n. The prime modulo is necessary to get a
@@ -316,15 +395,222 @@ g_hash_table_find_closest_shift (gint n)
   return i;
 }
 
+/* Each group is turned into a bitmask of the nodes of interest.  With
+ * SSE2 there is one bit per node; otherwise the group is read as a
+ * 64-bit word and there is one bit (the top one) per byte.
+ */
+#ifdef __SSE2__
+#define CTRL_MASK_SHIFT 0
+
+static inline CtrlMask
+ctrl_match (const guint8 *group,
+            guint8        h2)
+{
+  __m128i ctrl = _mm_loadu_si128 ((const __m128i *) group);
+
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 (h2)));
+}
+
+static inline CtrlMask
+ctrl_match_empty (const guint8 *group)
+{
+  return ctrl_match (group, CTRL_EMPTY);
+}
+
+static inline CtrlMask
+ctrl_match_free (const guint8 *group)
+{
+  return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) group));
+}
+#else
+#define CTRL_MASK_SHIFT 3
+#define CTRL_LSBS G_GUINT64_CONSTANT (0x0101010101010101)
+#define CTRL_MSBS G_GUINT64_CONSTANT (0x8080808080808080)
+
+static inline guint64
+ctrl_load (const guint8 *group)
+{
+  guint64 word;
+
+  memcpy (&word, group, sizeof word);
+
+  return GUINT64_FROM_LE (word);
+}
+
+/* May report false positives.  Lookups don't compare full hash values,
+ * so those are only rejected by the key comparison, like any other node
+ * whose control byte happens to match.
+ */
+static inline CtrlMask
+ctrl_match (const guint8 *group,
+            guint8        h2)
+{
+  guint64 x = ctrl_load (group) ^ (CTRL_LSBS * h2);
+
+  return (x - CTRL_LSBS) & ~x & CTRL_MSBS;
+}
+
+static inline CtrlMask
+ctrl_match_empty (const guint8 *group)
+{
+  guint64 word = ctrl_load (group);
+
+  /* CTRL_EMPTY is the only value with bit 7 set and bit 1 clear */
+  return word & ~(word << 6) & CTRL_MSBS;
+}
+
+static inline CtrlMask
+ctrl_match_free (const guint8 *group)
+{
+  return ctrl_load (group) & CTRL_MSBS;
+}
+#endif
+
+/* Offset within the group of the lowest node in @mask */
+static inline guint
+ctrl_mask_first (CtrlMask mask)
+{
+#if defined (__GNUC__) && (__GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4))
+  return __builtin_ctzll (mask) >> CTRL_MASK_SHIFT;
+#else
+  guint n = 0;
+
+  while (!(mask & 1))
+    {
+      mask >>= 1;
+      n++;
+    }
+
+  return n >> CTRL_MASK_SHIFT;
+#endif
+}
+
+static inline CtrlMask
+ctrl_mask_next (CtrlMask mask)
+{
+  return mask & (mask - 1);
+}
+
+static inline void
+ctrl_set (guint8 *ctrl,
+          gint    size,
+          guint   i,
+          guint8  value)
+{
+  guint j;
+
+  if (ctrl == NULL)
+    return;
+
+  ctrl[i] = value;
+
+  /* Keep the mirror (of which there are several for tables smaller
+   * than a group) up to date.
+   */
+  for (j = i + size; j < (guint) size + CTRL_GROUP; j += size)
+    ctrl[j] = value;
+}
+
+/* The node arrays of tables made by g_hash_table_new_in_arena() come
+ * from the arena, and are never freed on their own.
+ */
+static inline gpointer
+g_hash_table_mem_alloc0 (GArena *arena,
+                         gsize   size)
+{
+  return arena ? g_arena_alloc0 (arena, size) : g_malloc0 (size);
+}
+
+static inline gpointer
+g_hash_table_mem_dup (GArena        *arena,
+                      gconstpointer  mem,
+                      gsize          size)
+{
+  return arena ? g_arena_dup (arena, mem, size) : g_memdup (mem, size);
+}
+
+static inline void
+g_hash_table_mem_free (GArena   *arena,
+                       gpointer  mem)
+{
+  if (!arena)
+    g_free (mem);
+}
+
+static guint8 *
+ctrl_new (GArena *arena,
+          gint    size)
+{
+  guint8 *ctrl = arena ? g_arena_alloc (arena, size + CTRL_GROUP) : g_malloc (size + CTRL_GROUP);
+
+  memset (ctrl, CTRL_EMPTY, size + CTRL_GROUP);
+
+  return ctrl;
+}
+
+/* Allocates empty arrays for @size nodes, with values sharing keys */
 static void
-g_hash_table_set_shift_from_size (GHashTable *hash_table, gint size)
+g_hash_table_arrays_new (GArena    *arena,
+                         gint       size,
+                         gpointer **keys,
+                         guint    **hashes,
+                         guint8   **ctrl)
 {
-  gint shift;
+  if (HASH_TABLE_IS_SMALL (size))
+    {
+      *keys = g_hash_table_mem_alloc0 (arena, size * (sizeof (gpointer) + sizeof (guint)));
+      *hashes = (guint *) (*keys + size);
+      *ctrl = NULL;
+    }
+  else
+    {
+      *keys = g_hash_table_mem_alloc0 (arena, size * sizeof (gpointer));
+      *hashes = g_hash_table_mem_alloc0 (arena, size * sizeof (guint));
+      *ctrl = ctrl_new (arena, size);
+    }
+}
 
-  shift = g_hash_table_find_closest_shift (size);
-  shift = MAX (shift, HASH_TABLE_MIN_SHIFT);
+static void
+g_hash_table_arrays_free (GArena   *arena,
+                          gpointer *keys,
+                          gpointer *values,
+                          guint    *hashes,
+                          guint8   *ctrl)
+{
+  if (arena)
+    return;
+
+  if (keys != values)
+    g_free (values);
+
+  g_free (keys);
+
+  if (ctrl != NULL)
+    {
+      g_free (hashes);
+      g_free (ctrl);
+    }
+}
+
+/* Groups are probed by triangular steps, which on a power-of-two table
+ * visit every group start; the table always has at least one empty
+ * node (see g_hash_table_maybe_resize()), so probing terminates.
+ */
+static inline guint
+ctrl_find_empty (const guint8 *ctrl,
+                 guint         mask,
+                 guint         node_index)
+{
+  guint step = 0;
+  CtrlMask free_nodes;
+
+  while (!(free_nodes = ctrl_match_empty (ctrl + node_index)))
+    {
+      step += CTRL_GROUP;
+      node_index = (node_index + step) & mask;
+    }
 
-  g_hash_table_set_shift (hash_table, shift);
+  return (node_index + ctrl_mask_first (free_nodes)) & mask;
 }
 
 /*
@@ -356,11 +642,11 @@ g_hash_table_lookup_node (GHashTable    *hash_table,
                           guint         *hash_return)
 {
   guint node_index;
-  guint node_hash;
   guint hash_value;
-  guint first_tombstone = 0;
-  gboolean have_tombstone = FALSE;
+  guint first_free = 0;
+  gboolean have_free = FALSE;
   guint step = 0;
+  guint8 h2;
 
   hash_value = hash_table->hash_func (key);
   if (G_UNLIKELY (!HASH_IS_REAL (hash_value)))
@@ -369,44 +655,90 @@ g_hash_table_lookup_node (GHashTable    *hash_table,
   *hash_return = hash_value;
 
   node_index = hash_value % hash_table->mod;
-  node_hash = hash_table->hashes[node_index];
 
-  while (!HASH_IS_UNUSED (node_hash))
+  /* Small tables: look at every node, starting where the group probe
+   * would, so that nodes end up where they would in a hashed table.
+   */
+  if (hash_table->ctrl == NULL)
     {
-      /* We first check if our full hash values
-       * are equal so we can avoid calling the full-blown
-       * key equality function in most cases.
-       */
-      if (node_hash == hash_value)
+      for (step = 0; step < (guint) hash_table->size; step++)
         {
-          gpointer node_key = hash_table->keys[node_index];
+          guint node_hash = hash_table->hashes[node_index];
+
+          if (node_hash == hash_value)
+            {
+              gpointer node_key = hash_table->keys[node_index];
+
+              if (hash_table->key_equal_func)
+                {
+                  if (hash_table->key_equal_func (node_key, key))
+                    return node_index;
+                }
+              else if (node_key == key)
+                {
+                  return node_index;
+                }
+            }
+          else if (HASH_IS_UNUSED (node_hash) && !have_free)
+            {
+              first_free = node_index;
+              have_free = TRUE;
+            }
+
+          node_index = (node_index + 1) & hash_table->mask;
+        }
+
+      return first_free;
+    }
+
+  h2 = CTRL_H2 (hash_value);
 
+  while (TRUE)
+    {
+      const guint8 *group = hash_table->ctrl + node_index;
+      CtrlMask matches;
+
+      for (matches = ctrl_match (group, h2); matches; matches = ctrl_mask_next (matches))
+        {
+          guint i = (node_index + ctrl_mask_first (matches)) & hash_table->mask;
+          gpointer node_key = hash_table->keys[i];
+
+          /* The seven bits of hash in the control byte already rule out
+           * nearly all other keys, so the full hash values are not
+           * compared here: on large tables that would mean one more
+           * cache miss per lookup.
+           */
           if (hash_table->key_equal_func)
             {
               if (hash_table->key_equal_func (node_key, key))
-                return node_index;
+                return i;
             }
           else if (node_key == key)
             {
-              return node_index;
+              return i;
             }
         }
-      else if (HASH_IS_TOMBSTONE (node_hash) && !have_tombstone)
+
+      /* Insertions go to the first tombstone or empty node on the way */
+      if (!have_free)
         {
-          first_tombstone = node_index;
-          have_tombstone = TRUE;
+          CtrlMask free_nodes = ctrl_match_free (group);
+
+          if (free_nodes)
+            {
+              first_free = (node_index + ctrl_mask_first (free_nodes)) & hash_table->mask;
+              have_free = TRUE;
+            }
         }
 
-      step++;
-      node_index += step;
-      node_index &= hash_table->mask;
-      node_hash = hash_table->hashes[node_index];
-    }
+      if (ctrl_match_empty (group))
+        break;
 
-  if (have_tombstone)
-    return first_tombstone;
+      step += CTRL_GROUP;
+      node_index = (node_index + step) & hash_table->mask;
+    }
 
-  return node_index;
+  return first_free;
 }
 
 /*
@@ -432,8 +764,20 @@ g_hash_table_remove_node (GHashTable   *hash_table,
   key = hash_table->keys[i];
   value = hash_table->values[i];
 
-  /* Erect tombstone */
-  hash_table->hashes[i] = TOMBSTONE_HASH_VALUE;
+  /* Erect tombstone, unless the table is searched linearly */
+  if (hash_table->ctrl == NULL)
+    {
+      hash_table->hashes[i] = UNUSED_HASH_VALUE;
+      hash_table->noccupied--;
+    }
+  else
+    {
+      hash_table->hashes[i] = TOMBSTONE_HASH_VALUE;
+      ctrl_set (hash_table->ctrl, hash_table->size, i, CTRL_DELETED);
+    }
+
+  if (G_UNLIKELY (hash_table->resize))
+    g_hash_table_resize_mirror_remove (hash_table, i);
 
   /* Be GC friendly */
   hash_table->keys[i] = NULL;
@@ -471,11 +815,19 @@ g_hash_table_remove_all_nodes (GHashTable *hash_table,
   hash_table->nnodes = 0;
   hash_table->noccupied = 0;
 
+  if (hash_table->resize)
+    {
+      g_hash_table_resize_free (hash_table, hash_table->resize);
+      hash_table->resize = NULL;
+    }
+
   if (!notify ||
       (hash_table->key_destroy_func == NULL &&
        hash_table->value_destroy_func == NULL))
     {
       memset (hash_table->hashes, 0, hash_table->size * sizeof (guint));
+      if (hash_table->ctrl != NULL)
+        memset (hash_table->ctrl, CTRL_EMPTY, hash_table->size + CTRL_GROUP);
       memset (hash_table->keys, 0, hash_table->size * sizeof (gpointer));
       memset (hash_table->values, 0, hash_table->size * sizeof (gpointer));
 
@@ -490,6 +842,7 @@ g_hash_table_remove_all_nodes (GHashTable *hash_table,
           value = hash_table->values[i];
 
           hash_table->hashes[i] = UNUSED_HASH_VALUE;
+          ctrl_set (hash_table->ctrl, hash_table->size, i, CTRL_EMPTY);
           hash_table->keys[i] = NULL;
           hash_table->values[i] = NULL;
 
@@ -502,76 +855,205 @@ g_hash_table_remove_all_nodes (GHashTable *hash_table,
       else if (HASH_IS_TOMBSTONE (hash_table->hashes[i]))
         {
           hash_table->hashes[i] = UNUSED_HASH_VALUE;
+          ctrl_set (hash_table->ctrl, hash_table->size, i, CTRL_EMPTY);
         }
     }
 }
 
-/*
- * g_hash_table_resize:
- * @hash_table: our #GHashTable
- *
- * Resizes the hash table to the optimal size based on the number of
- * nodes currently held. If you call this function then a resize will
- * occur, even if one does not need to occur.
- * Use g_hash_table_maybe_resize() instead.
- *
- * This function may "resize" the hash table to its current size, with
- * the side effect of cleaning up tombstones and otherwise optimizing
- * the probe sequences.
- */
-static void
-g_hash_table_resize (GHashTable *hash_table)
+/* New arrays sized for @n_nodes */
+static GHashTableResize *
+g_hash_table_resize_new (GHashTable *hash_table,
+                         gint        n_nodes,
+                         gboolean    incremental)
 {
-  gpointer *new_keys;
-  gpointer *new_values;
-  guint *new_hashes;
-  gint old_size;
-  gint i;
+  GHashTableResize *resize;
+  gint shift;
+
+  shift = g_hash_table_find_closest_shift (n_nodes * 2);
+  shift = MAX (shift, HASH_TABLE_MIN_SHIFT);
 
-  old_size = hash_table->size;
-  g_hash_table_set_shift_from_size (hash_table, hash_table->nnodes * 2);
+  resize = g_slice_new0 (GHashTableResize);
+  resize->size = 1 << shift;
+  resize->mod = prime_mod [shift];
+  resize->mask = resize->size - 1;
 
-  new_keys = g_new0 (gpointer, hash_table->size);
+  g_hash_table_arrays_new (hash_table->arena, resize->size,
+                           &resize->keys, &resize->hashes, &resize->ctrl);
   if (hash_table->keys == hash_table->values)
-    new_values = new_keys;
+    resize->values = resize->keys;
+  else
+    resize->values = g_hash_table_mem_alloc0 (hash_table->arena, resize->size * sizeof (gpointer));
+
+  if (incremental)
+    resize->new_index = g_new (guint, hash_table->size);
+
+  return resize;
+}
+
+static void
+g_hash_table_resize_free (GHashTable       *hash_table,
+                          GHashTableResize *resize)
+{
+  g_hash_table_arrays_free (hash_table->arena, resize->keys, resize->values,
+                            resize->hashes, resize->ctrl);
+  g_free (resize->new_index);
+  g_slice_free (GHashTableResize, resize);
+}
+
+static inline guint
+g_hash_table_resize_add (GHashTableResize *resize,
+                         guint             key_hash,
+                         gpointer          key,
+                         gpointer          value)
+{
+  guint i;
+
+  if (resize->ctrl == NULL)
+    {
+      for (i = key_hash % resize->mod; !HASH_IS_UNUSED (resize->hashes[i]); i = (i + 1) & resize->mask)
+        ;
+    }
   else
-    new_values = g_new0 (gpointer, hash_table->size);
-  new_hashes = g_new0 (guint, hash_table->size);
+    i = ctrl_find_empty (resize->ctrl, resize->mask, key_hash % resize->mod);
+
+  ctrl_set (resize->ctrl, resize->size, i, CTRL_H2 (key_hash));
+  resize->hashes[i] = key_hash;
+  resize->keys[i] = key;
+  resize->values[i] = value;
+  resize->nnodes++;
+  resize->noccupied++;
+
+  return i;
+}
+
+/* Moves (up to) @n more old nodes over */
+static void
+g_hash_table_resize_move (GHashTable       *hash_table,
+                          GHashTableResize *resize,
+                          gint              n)
+{
+  gint end = MIN (resize->position + n, hash_table->size);
+  gint i;
 
-  for (i = 0; i < old_size; i++)
+  for (i = resize->position; i < end; i++)
     {
       guint node_hash = hash_table->hashes[i];
-      guint hash_val;
-      guint step = 0;
+      guint new_i;
 
       if (!HASH_IS_REAL (node_hash))
         continue;
 
-      hash_val = node_hash % hash_table->mod;
+      new_i = g_hash_table_resize_add (resize, node_hash,
+                                       hash_table->keys[i],
+                                       hash_table->values[i]);
+      if (resize->new_index)
+        resize->new_index[i] = new_i;
+    }
 
-      while (!HASH_IS_UNUSED (new_hashes[hash_val]))
-        {
-          step++;
-          hash_val += step;
-          hash_val &= hash_table->mask;
-        }
+  resize->position = end;
+}
+
+/* Replaces the old arrays by the new ones, once all nodes are moved */
+static void
+g_hash_table_resize_finish (GHashTable       *hash_table,
+                            GHashTableResize *resize)
+{
+  g_hash_table_arrays_free (hash_table->arena, hash_table->keys, hash_table->values,
+                            hash_table->hashes, hash_table->ctrl);
+
+  hash_table->size = resize->size;
+  hash_table->mod = resize->mod;
+  hash_table->mask = resize->mask;
+  hash_table->noccupied = resize->noccupied;
+
+  hash_table->keys = resize->keys;
+  hash_table->values = resize->values;
+  hash_table->hashes = resize->hashes;
+  hash_table->ctrl = resize->ctrl;
+
+  g_free (resize->new_index);
+  g_slice_free (GHashTableResize, resize);
+}
+
+/* Called after the old node @i has been written to.  Nodes that were
+ * not moved yet will be picked up as they are.
+ */
+static void
+g_hash_table_resize_mirror_insert (GHashTable *hash_table,
+                                   gint        i,
+                                   gboolean    already_exists)
+{
+  GHashTableResize *resize = hash_table->resize;
+
+  /* Keep sharing the keys and values arrays for as long as the old
+   * table does.  This must happen even if node @i has not been moved
+   * yet, or it would later be moved into a shared array.
+   */
+  if (G_UNLIKELY (hash_table->keys != hash_table->values && resize->keys == resize->values))
+    resize->values = g_hash_table_mem_dup (hash_table->arena, resize->keys,
+                                           sizeof (gpointer) * resize->size);
 
-      new_hashes[hash_val] = hash_table->hashes[i];
-      new_keys[hash_val] = hash_table->keys[i];
-      new_values[hash_val] = hash_table->values[i];
+  if (i >= resize->position)
+    return;
+
+  if (already_exists)
+    {
+      resize->keys[resize->new_index[i]] = hash_table->keys[i];
+      resize->values[resize->new_index[i]] = hash_table->values[i];
     }
+  else
+    resize->new_index[i] = g_hash_table_resize_add (resize, hash_table->hashes[i],
+                                                    hash_table->keys[i],
+                                                    hash_table->values[i]);
+}
 
-  if (hash_table->keys != hash_table->values)
-    g_free (hash_table->values);
+static void
+g_hash_table_resize_mirror_remove (GHashTable *hash_table,
+                                   gint        i)
+{
+  GHashTableResize *resize = hash_table->resize;
+  guint new_i;
 
-  g_free (hash_table->keys);
-  g_free (hash_table->hashes);
+  if (i >= resize->position)
+    return;
 
-  hash_table->keys = new_keys;
-  hash_table->values = new_values;
-  hash_table->hashes = new_hashes;
+  new_i = resize->new_index[i];
+  if (resize->ctrl == NULL)
+    {
+      resize->hashes[new_i] = UNUSED_HASH_VALUE;
+      resize->noccupied--;
+    }
+  else
+    {
+      resize->hashes[new_i] = TOMBSTONE_HASH_VALUE;
+      ctrl_set (resize->ctrl, resize->size, new_i, CTRL_DELETED);
+    }
+  resize->keys[new_i] = NULL;
+  resize->values[new_i] = NULL;
+  resize->nnodes--;
+}
 
-  hash_table->noccupied = hash_table->nnodes;
+/*
+ * g_hash_table_resize:
+ * @hash_table: our #GHashTable
+ *
+ * Resizes the hash table to the optimal size based on the number of
+ * nodes currently held. If you call this function then a resize will
+ * occur, even if one does not need to occur.
+ * Use g_hash_table_maybe_resize() instead.
+ *
+ * This function may "resize" the hash table to its current size, with
+ * the side effect of cleaning up tombstones and otherwise optimizing
+ * the probe sequences.
+ */
+static void
+g_hash_table_resize (GHashTable *hash_table)
+{
+  GHashTableResize *resize;
+
+  resize = g_hash_table_resize_new (hash_table, hash_table->nnodes, FALSE);
+  g_hash_table_resize_move (hash_table, resize, hash_table->size);
+  g_hash_table_resize_finish (hash_table, resize);
 }
 
 /*
@@ -582,31 +1064,82 @@ g_hash_table_resize (GHashTable *hash_table)
  *
  * Essentially, calls g_hash_table_resize() if the table has strayed
  * too far from its ideal size for its number of nodes.
+ *
+ * Large tables instead start moving to new arrays somewhat earlier
+ * (at three quarters full, rather than at nearly full), and then move
+ * HASH_TABLE_RESIZE_STEP more buckets on each call, so that no single
+ * insertion or removal has to rehash the whole table.  Since calls
+ * only come from operations which invalidate iterators anyway, the
+ * arrays are never swapped under an iterator.
  */
 static inline void
 g_hash_table_maybe_resize (GHashTable *hash_table)
 {
   gint noccupied = hash_table->noccupied;
   gint size = hash_table->size;
+  gboolean full = size <= noccupied + (noccupied / 16);
+  GHashTableResize *resize = hash_table->resize;
 
-  if ((size > hash_table->nnodes * 4 && size > 1 << HASH_TABLE_MIN_SHIFT) ||
-      (size <= noccupied + (noccupied / 16)))
-    g_hash_table_resize (hash_table);
-}
+  if (G_UNLIKELY (resize))
+    {
+      /* What the new arrays will hold once the rest is moved over */
+      gint projected = resize->noccupied + (hash_table->nnodes - resize->nnodes);
 
-/**
- * g_hash_table_new:
- * @hash_func: a function to create a hash value from a key
- * @key_equal_func: a function to check two keys for equality
- *
- * Creates a new #GHashTable with a reference count of 1.
- *
- * Hash values returned by @hash_func are used to determine where keys
- * are stored within the #GHashTable data structure. The g_direct_hash(),
- * g_int_hash(), g_int64_hash(), g_double_hash() and g_str_hash()
- * functions are provided for some common types of keys.
- * If @hash_func is %NULL, g_direct_hash() is used.
- *
+      if (resize->size <= projected + (projected / 16))
+        {
+          /* So many nodes were added since we started that the new
+           * arrays are too small: start over.
+           */
+          hash_table->resize = NULL;
+          g_hash_table_resize_free (hash_table, resize);
+        }
+      else
+        {
+          /* If the old arrays are full before we are done, finish in
+           * one go.
+           */
+          g_hash_table_resize_move (hash_table, resize,
+                                    full ? size : HASH_TABLE_RESIZE_STEP);
+
+          if (resize->position == size)
+            {
+              hash_table->resize = NULL;
+              g_hash_table_resize_finish (hash_table, resize);
+            }
+
+          return;
+        }
+    }
+
+  /* Don't shrink below what was reserved, until it has been used */
+  if (G_UNLIKELY (hash_table->reserved) && hash_table->nnodes >= hash_table->reserved)
+    hash_table->reserved = 0;
+
+  if ((size > MAX (hash_table->nnodes, hash_table->reserved) * 4 && size > 1 << HASH_TABLE_MIN_SHIFT) ||
+      (size >= 1 << HASH_TABLE_INCREMENTAL_SHIFT && noccupied >= size / 4 * 3))
+    {
+      if (size >= 1 << HASH_TABLE_INCREMENTAL_SHIFT && !full)
+        hash_table->resize = g_hash_table_resize_new (hash_table, hash_table->nnodes, TRUE);
+      else
+        g_hash_table_resize (hash_table);
+    }
+  else if (full)
+    g_hash_table_resize (hash_table);
+}
+
+/**
+ * g_hash_table_new:
+ * @hash_func: a function to create a hash value from a key
+ * @key_equal_func: a function to check two keys for equality
+ *
+ * Creates a new #GHashTable with a reference count of 1.
+ *
+ * Hash values returned by @hash_func are used to determine where keys
+ * are stored within the #GHashTable data structure. The g_direct_hash(),
+ * g_int_hash(), g_int64_hash(), g_double_hash() and g_str_hash()
+ * functions are provided for some common types of keys.
+ * If @hash_func is %NULL, g_direct_hash() is used.
+ *
  * @key_equal_func is used when looking up keys in the #GHashTable.
  * The g_direct_equal(), g_int_equal(), g_int64_equal(), g_double_equal()
  * and g_str_equal() functions are provided for the most common types
@@ -647,10 +1180,63 @@ g_hash_table_new_full (GHashFunc      hash_func,
                        GEqualFunc     key_equal_func,
                        GDestroyNotify key_destroy_func,
                        GDestroyNotify value_destroy_func)
+{
+  return g_hash_table_new_internal (NULL, hash_func, key_equal_func,
+                                    key_destroy_func, value_destroy_func);
+}
+
+/**
+ * g_hash_table_new_in_arena:
+ * @arena: a #GArena
+ * @hash_func: a function to create a hash value from a key
+ * @key_equal_func: a function to check two keys for equality
+ * @key_destroy_func: (allow-none): a function to free the memory allocated for the key
+ *     used when removing the entry from the #GHashTable, or %NULL
+ *     if you don't want to supply such a function.
+ * @value_destroy_func: (allow-none): a function to free the memory allocated for the
+ *     value used when removing the entry from the #GHashTable, or %NULL
+ *     if you don't want to supply such a function.
+ *
+ * Creates a new #GHashTable like g_hash_table_new_full(), but
+ * allocates it and its node arrays from @arena. Growing the table
+ * leaves the old arrays behind in @arena until it is reset.
+ *
+ * The table is reference counted and destroyed as usual, which does
+ * not give back any memory; if it has no destroy notifiers it may
+ * also simply be dropped when @arena is reset. It must not be used
+ * after that.
+ *
+ * Return value: a new #GHashTable
+ *
+ * Since: 2.40
+ */
+GHashTable *
+g_hash_table_new_in_arena (GArena         *arena,
+                           GHashFunc       hash_func,
+                           GEqualFunc      key_equal_func,
+                           GDestroyNotify  key_destroy_func,
+                           GDestroyNotify  value_destroy_func)
+{
+  g_return_val_if_fail (arena != NULL, NULL);
+
+  return g_hash_table_new_internal (arena, hash_func, key_equal_func,
+                                    key_destroy_func, value_destroy_func);
+}
+
+static GHashTable *
+g_hash_table_new_internal (GArena         *arena,
+                           GHashFunc       hash_func,
+                           GEqualFunc      key_equal_func,
+                           GDestroyNotify  key_destroy_func,
+                           GDestroyNotify  value_destroy_func)
 {
   GHashTable *hash_table;
 
-  hash_table = g_slice_new (GHashTable);
+  if (arena)
+    hash_table = g_arena_alloc (arena, sizeof (GHashTable));
+  else
+    hash_table = g_slice_new (GHashTable);
+  hash_table->arena              = arena;
   g_hash_table_set_shift (hash_table, HASH_TABLE_MIN_SHIFT);
   hash_table->nnodes             = 0;
   hash_table->noccupied          = 0;
@@ -662,9 +1248,11 @@ g_hash_table_new_full (GHashFunc      hash_func,
 #endif
   hash_table->key_destroy_func   = key_destroy_func;
   hash_table->value_destroy_func = value_destroy_func;
-  hash_table->keys               = g_new0 (gpointer, hash_table->size);
+  g_hash_table_arrays_new (arena, hash_table->size, &hash_table->keys,
+                           &hash_table->hashes, &hash_table->ctrl);
   hash_table->values             = hash_table->keys;
-  hash_table->hashes             = g_new0 (guint, hash_table->size);
+  hash_table->resize             = NULL;
+  hash_table->reserved           = 0;
 
   return hash_table;
 }
@@ -829,8 +1417,11 @@ g_hash_table_iter_remove (GHashTableIter *iter)
  * If @key has been taken out of the existing node (ie it is not
  * passed in via a g_hash_table_insert/replace) call, then @reusing_key
  * should be %TRUE.
+ *
+ * Returns: %TRUE if a new node was added, in which case the caller
+ *   should give g_hash_table_maybe_resize() a chance to run
  */
-static void
+static gboolean
 g_hash_table_insert_node (GHashTable *hash_table,
                           guint       node_index,
                           guint       key_hash,
@@ -884,6 +1475,7 @@ g_hash_table_insert_node (GHashTable *hash_table,
   else
     {
       hash_table->hashes[node_index] = key_hash;
+      ctrl_set (hash_table->ctrl, hash_table->size, node_index, CTRL_H2 (key_hash));
       hash_table->keys[node_index] = new_key;
     }
 
@@ -892,22 +1484,23 @@ g_hash_table_insert_node (GHashTable *hash_table,
    * split the table.
    */
   if (G_UNLIKELY (hash_table->keys == hash_table->values && hash_table->keys[node_index] != new_value))
-    hash_table->values = g_memdup (hash_table->keys, sizeof (gpointer) * hash_table->size);
+    hash_table->values = g_hash_table_mem_dup (hash_table->arena, hash_table->keys,
+                                               sizeof (gpointer) * hash_table->size);
 
   /* Step 3: Actually do the write */
   hash_table->values[node_index] = new_value;
 
+  if (G_UNLIKELY (hash_table->resize))
+    g_hash_table_resize_mirror_insert (hash_table, node_index, already_exists);
+
   /* Now, the bookkeeping... */
   if (!already_exists)
     {
       hash_table->nnodes++;
 
+      /* We replaced an empty node, and not a tombstone */
       if (HASH_IS_UNUSED (old_hash))
-        {
-          /* We replaced an empty node, and not a tombstone */
-          hash_table->noccupied++;
-          g_hash_table_maybe_resize (hash_table);
-        }
+        hash_table->noccupied++;
 
 #ifndef G_DISABLE_ASSERT
       hash_table->version++;
@@ -921,6 +1514,8 @@ g_hash_table_insert_node (GHashTable *hash_table,
       if (hash_table->value_destroy_func)
         (* hash_table->value_destroy_func) (value_to_free);
     }
+
+  return !already_exists;
 }
 
 /**
@@ -1024,11 +1619,10 @@ g_hash_table_unref (GHashTable *hash_table)
   if (g_atomic_int_dec_and_test (&hash_table->ref_count))
     {
       g_hash_table_remove_all_nodes (hash_table, TRUE);
-      if (hash_table->keys != hash_table->values)
-        g_free (hash_table->values);
-      g_free (hash_table->keys);
-      g_free (hash_table->hashes);
-      g_slice_free (GHashTable, hash_table);
+      g_hash_table_arrays_free (hash_table->arena, hash_table->keys, hash_table->values,
+                                hash_table->hashes, hash_table->ctrl);
+      if (!hash_table->arena)
+        g_slice_free (GHashTable, hash_table);
     }
 }
 
@@ -1152,7 +1746,8 @@ g_hash_table_insert_internal (GHashTable *hash_table,
 
   node_index = g_hash_table_lookup_node (hash_table, key, &key_hash);
 
-  g_hash_table_insert_node (hash_table, node_index, key_hash, key, value, keep_new_key, FALSE);
+  if (g_hash_table_insert_node (hash_table, node_index, key_hash, key, value, keep_new_key, FALSE))
+    g_hash_table_maybe_resize (hash_table);
 }
 
 /**
@@ -1222,6 +1817,117 @@ g_hash_table_add (GHashTable *hash_table,
   g_hash_table_insert_internal (hash_table, key, key, TRUE);
 }
 
+/**
+ * g_hash_table_reserve:
+ * @hash_table: a #GHashTable
+ * @n_elements: the number of elements to make room for
+ *
+ * Makes room for @hash_table to hold @n_elements elements in total, so
+ * that adding elements up to that number does not cause the table to
+ * be resized.  This is useful when building a table whose final size
+ * is known in advance.
+ *
+ * Until it holds @n_elements elements, the table is not shrunk below
+ * that size either, even if elements are removed.  If @hash_table
+ * already has room for @n_elements elements, nothing happens.
+ *
+ * Since: 2.40
+ */
+void
+g_hash_table_reserve (GHashTable *hash_table,
+                      guint       n_elements)
+{
+  GHashTableResize *resize;
+  gint noccupied;
+  gint shift;
+
+  g_return_if_fail (hash_table != NULL);
+  g_return_if_fail (n_elements <= G_MAXINT / 2);
+
+  if ((gint) n_elements <= hash_table->nnodes)
+    return;
+
+  hash_table->reserved = MAX (hash_table->reserved, (gint) n_elements);
+
+  /* Finish an incremental resize first, as it may already be enough */
+  if (hash_table->resize)
+    {
+      resize = hash_table->resize;
+      hash_table->resize = NULL;
+      g_hash_table_resize_move (hash_table, resize, hash_table->size);
+      g_hash_table_resize_finish (hash_table, resize);
+    }
+
+  /* Tombstones count too, since new elements may not land on them */
+  noccupied = hash_table->noccupied + (n_elements - hash_table->nnodes);
+  shift = g_hash_table_find_closest_shift (n_elements * 2);
+  if (1 << shift <= hash_table->size && hash_table->size > noccupied + (noccupied / 16))
+    return;
+
+  resize = g_hash_table_resize_new (hash_table, n_elements, FALSE);
+  g_hash_table_resize_move (hash_table, resize, hash_table->size);
+  g_hash_table_resize_finish (hash_table, resize);
+
+#ifndef G_DISABLE_ASSERT
+  hash_table->version++;
+#endif
+}
+
+/**
+ * g_hash_table_insert_bulk:
+ * @hash_table: a #GHashTable
+ * @keys: (array length=n_pairs): the keys to insert
+ * @values: (array length=n_pairs) (allow-none): the values to associate
+ *     with @keys, or %NULL to use each key as its own value
+ * @n_pairs: the number of elements in @keys (and @values)
+ *
+ * Inserts @n_pairs keys and values into @hash_table.  This is the same
+ * as calling g_hash_table_insert() for each pair in turn (or
+ * g_hash_table_add() for each key, if @values is %NULL), except that
+ * the table is resized at most twice: once up front, to make room for
+ * all of @keys, and once at the end if @keys held many duplicates.
+ *
+ * Since: 2.40
+ */
+void
+g_hash_table_insert_bulk (GHashTable *hash_table,
+                          gpointer   *keys,
+                          gpointer   *values,
+                          guint       n_pairs)
+{
+  gint reserved;
+  guint i;
+
+  g_return_if_fail (hash_table != NULL);
+  g_return_if_fail (keys != NULL || n_pairs == 0);
+  g_return_if_fail (n_pairs <= (guint) (G_MAXINT / 2 - hash_table->nnodes));
+
+  if (n_pairs == 0)
+    return;
+
+  reserved = hash_table->reserved;
+  g_hash_table_reserve (hash_table, hash_table->nnodes + n_pairs);
+
+  for (i = 0; i < n_pairs; i++)
+    {
+      guint key_hash;
+      guint node_index;
+
+      node_index = g_hash_table_lookup_node (hash_table, keys[i], &key_hash);
+
+      if (values)
+        g_hash_table_insert_node (hash_table, node_index, key_hash,
+                                  keys[i], values[i], FALSE, FALSE);
+      else
+        g_hash_table_insert_node (hash_table, node_index, key_hash,
+                                  keys[i], keys[i], TRUE, FALSE);
+    }
+
+  /* Our own reservation was only for the duration of the loop */
+  hash_table->reserved = reserved;
+  g_hash_table_maybe_resize (hash_table);
+}
+
 /**
  * g_hash_table_contains:
  * @hash_table: a #GHashTable
@@ -1371,6 +2077,20 @@ g_hash_table_steal_all (GHashTable *hash_table)
   g_hash_table_maybe_resize (hash_table);
 }
 
+/* Like g_hash_table_steal_all(), but keeps the storage at its current
+ * size, for tables that are about to be filled up again.
+ */
+void
+_g_hash_table_steal_all_keep_size (GHashTable *hash_table)
+{
+#ifndef G_DISABLE_ASSERT
+  if (hash_table->nnodes != 0)
+    hash_table->version++;
+#endif
+
+  g_hash_table_remove_all_nodes (hash_table, FALSE);
+}
+
 /*
  * g_hash_table_foreach_remove_or_steal:
  * @hash_table: a #GHashTable
@@ -1723,64 +2443,1027 @@ g_hash_table_get_values (GHashTable *hash_table)
   return retval;
 }
 
-/* Hash functions.
+/* Concurrent hash tables.
  */
 
 /**
- * g_str_equal:
- * @v1: a key
- * @v2: a key to compare with @v1
- *
- * Compares two strings for byte-by-byte equality and returns %TRUE
- * if they are equal. It can be passed to g_hash_table_new() as the
- * @key_equal_func parameter, when using non-%NULL strings as keys in a
- * #GHashTable.
+ * SECTION:concurrent_hash_tables
+ * @title: Concurrent Hash Tables
+ * @short_description: hash tables for lookups from many threads
+ * @see_also: #GHashTable
+ *
+ * A #GConcurrentHashTable is a hash table that can be used from
+ * several threads at once without any locking by the caller.  It is
+ * meant for tables that are read a lot more often than they are
+ * changed: lookups never take a lock and never write to memory shared
+ * with other readers, so they scale with the number of threads.
+ * Changes are serialised by a mutex inside the table.
+ *
+ * Like #GHashTable, the table stores pointers and does not copy keys
+ * or values.  A key or value that is replaced or removed is only
+ * passed to its destroy function once no lookup that might have seen
+ * it is still running.  A value returned by
+ * g_concurrent_hash_table_lookup() can however be removed and
+ * destroyed by another thread as soon as the function returns; use
+ * g_concurrent_hash_table_lookup_copy() to take a reference to it (or
+ * a copy) if that can happen.
+ *
+ * The functions that change the table wait for running lookups to
+ * finish before freeing anything, so they must not be called from the
+ * functions passed to g_concurrent_hash_table_lookup_copy() or
+ * g_concurrent_hash_table_foreach(), and they are noticeably slower
+ * than their #GHashTable counterparts.
+ */
+
+/**
+ * GConcurrentHashTable:
  *
- * Note that this function is primarily meant as a hash table comparison
- * function. For a general-purpose, %NULL-safe string comparison function,
- * see g_strcmp0().
+ * The #GConcurrentHashTable struct is an opaque data structure to
+ * represent a <link linkend="glib-Concurrent-Hash-Tables">Concurrent
+ * Hash Table</link>.  It should only be accessed via the following
+ * functions.
  *
- * Returns: %TRUE if the two keys match
+ * Since: 2.40
  */
-gboolean
-g_str_equal (gconstpointer v1,
-             gconstpointer v2)
+
+/* The buckets use the same layout and probing as GHashTable, but hold
+ * pointers to immutable nodes so that a reader always sees a key
+ * together with its value.  Writers publish a new node (or a new
+ * bucket array, when resizing) with a single pointer store, and free
+ * the old one after a grace period.
+ *
+ * Readers announce themselves by incrementing one of two counters in
+ * their slot of readers[], selected by the current epoch.  A writer
+ * waits for a grace period by flipping the epoch and waiting for the
+ * counters of the previous one to drain, twice, so that readers that
+ * picked up the old epoch just before a flip are waited for too.
+ * Threads are spread over the slots so that readers running on
+ * different CPUs do not share cache lines.
+ */
+#define CONCURRENT_READER_SLOTS 32
+
+typedef struct
 {
-  const gchar *string1 = v1;
-  const gchar *string2 = v2;
+  guint            hash;
+  gpointer         key;
+  gpointer         value;
+} GConcurrentNode;
 
-  return strcmp (string1, string2) == 0;
+typedef struct
+{
+  gint             size;
+  gint             mod;
+  guint            mask;
+  gpointer         nodes[1];     /* NULL, CONCURRENT_TOMBSTONE or a node */
+} GConcurrentBuckets;
+
+typedef union
+{
+  gint             count[2];
+  guint8           padding[64];  /* one cache line per slot */
+} GConcurrentReaders;
+
+struct _GConcurrentHashTable
+{
+  GConcurrentBuckets *buckets;
+  gint                nnodes;
+  gint                noccupied;   /* nnodes + tombstones */
+
+  GHashFunc           hash_func;
+  GEqualFunc          key_equal_func;
+  gint                ref_count;
+  GDestroyNotify      key_destroy_func;
+  GDestroyNotify      value_destroy_func;
+
+  GMutex              lock;        /* serialises writers */
+  gint                epoch;
+  GConcurrentReaders *readers;     /* CONCURRENT_READER_SLOTS slots */
+  gpointer            readers_mem;
+};
+
+/* Past the barrier in g_concurrent_hash_table_read_begin(), readers
+ * only load pointers and then what they point to, which does not need
+ * a full barrier per load.
+ */
+#ifdef __ATOMIC_CONSUME
+#define CONCURRENT_LOAD(p_) __atomic_load_n ((p_), __ATOMIC_CONSUME)
+#else
+#define CONCURRENT_LOAD(p_) g_atomic_pointer_get (p_)
+#endif
+
+static GConcurrentNode concurrent_tombstone;
+#define CONCURRENT_TOMBSTONE ((gpointer) &concurrent_tombstone)
+#define CONCURRENT_NODE_IS_REAL(n_) ((n_) != NULL && (n_) != CONCURRENT_TOMBSTONE)
+
+static GPrivate concurrent_reader_slot = G_PRIVATE_INIT (NULL);
+static gint concurrent_next_reader_slot;
+
+static GConcurrentBuckets *
+g_concurrent_hash_table_buckets_new (gint shift)
+{
+  GConcurrentBuckets *buckets;
+  gint size = 1 << shift;
+
+  buckets = g_malloc0 (G_STRUCT_OFFSET (GConcurrentBuckets, nodes) +
+                       size * sizeof (gpointer));
+  buckets->size = size;
+  buckets->mod = prime_mod [shift];
+  buckets->mask = size - 1;
+
+  return buckets;
 }
 
-/**
- * g_str_hash:
- * @v: a string key
- *
- * Converts a string to a hash value.
- *
- * This function implements the widely used "djb" hash apparently posted
- * by Daniel Bernstein to comp.lang.c some time ago.  The 32 bit
- * unsigned hash value starts at 5381 and for each byte 'c' in the
- * string, is updated: <literal>hash = hash * 33 + c</literal>.  This
- * function uses the signed value of each byte.
- *
- * It can be passed to g_hash_table_new() as the @hash_func parameter,
- * when using non-%NULL strings as keys in a #GHashTable.
- *
- * Returns: a hash value corresponding to the key
+static void
+g_concurrent_hash_table_buckets_free (GConcurrentHashTable *hash_table,
+                                      GConcurrentBuckets   *buckets)
+{
+  gint i;
+
+  for (i = 0; i < buckets->size; i++)
+    {
+      GConcurrentNode *node = buckets->nodes[i];
+
+      if (!CONCURRENT_NODE_IS_REAL (node))
+        continue;
+
+      if (hash_table->key_destroy_func)
+        hash_table->key_destroy_func (node->key);
+      if (hash_table->value_destroy_func)
+        hash_table->value_destroy_func (node->value);
+      g_slice_free (GConcurrentNode, node);
+    }
+
+  g_free (buckets);
+}
+
+static inline guint
+g_concurrent_hash_table_hash (GConcurrentHashTable *hash_table,
+                              gconstpointer         key)
+{
+  guint hash_value;
+
+  hash_value = hash_table->hash_func (key);
+  if (G_UNLIKELY (!HASH_IS_REAL (hash_value)))
+    hash_value = 2;
+
+  return hash_value;
+}
+
+static inline gboolean
+g_concurrent_hash_table_node_matches (GConcurrentHashTable *hash_table,
+                                      GConcurrentNode      *node,
+                                      gconstpointer         key,
+                                      guint                 hash_value)
+{
+  if (node->hash != hash_value)
+    return FALSE;
+
+  if (hash_table->key_equal_func)
+    return hash_table->key_equal_func (node->key, key);
+
+  return node->key == key;
+}
+
+static inline GConcurrentReaders *
+g_concurrent_hash_table_read_begin (GConcurrentHashTable *hash_table,
+                                    gint                 *epoch)
+{
+  GConcurrentReaders *readers;
+  gpointer slot;
+
+  slot = g_private_get (&concurrent_reader_slot);
+  if (G_UNLIKELY (slot == NULL))
+    {
+      guint i;
+
+      i = (guint) g_atomic_int_add (&concurrent_next_reader_slot, 1);
+      slot = GUINT_TO_POINTER (i % CONCURRENT_READER_SLOTS + 1);
+      g_private_set (&concurrent_reader_slot, slot);
+    }
+
+  readers = &hash_table->readers[GPOINTER_TO_UINT (slot) - 1];
+  *epoch = g_atomic_int_get (&hash_table->epoch) & 1;
+  g_atomic_int_inc (&readers->count[*epoch]);
+
+  return readers;
+}
+
+static inline void
+g_concurrent_hash_table_read_end (GConcurrentReaders *readers,
+                                  gint                epoch)
+{
+  g_atomic_int_add (&readers->count[epoch], -1);
+}
+
+/* Called with the lock held, after unpublishing something: returns
+ * once every reader that might still see it has finished.
  */
-guint
-g_str_hash (gconstpointer v)
+static void
+g_concurrent_hash_table_synchronize (GConcurrentHashTable *hash_table)
 {
-  const signed char *p;
-  guint32 h = 5381;
+  gint pass;
+  gint i;
 
-  for (p = v; *p != '\0'; p++)
-    h = (h << 5) + h + *p;
+  for (pass = 0; pass < 2; pass++)
+    {
+      gint epoch;
 
-  return h;
+      epoch = g_atomic_int_xor (&hash_table->epoch, 1) & 1;
+
+      for (i = 0; i < CONCURRENT_READER_SLOTS; i++)
+        while (g_atomic_int_get (&hash_table->readers[i].count[epoch]) != 0)
+          g_thread_yield ();
+    }
+}
+
+static GConcurrentNode *
+g_concurrent_hash_table_lookup_node (GConcurrentHashTable *hash_table,
+                                     GConcurrentBuckets   *buckets,
+                                     gconstpointer         key,
+                                     guint                 hash_value)
+{
+  GConcurrentNode *node;
+  guint node_index;
+  guint step = 0;
+
+  node_index = hash_value % buckets->mod;
+
+  while ((node = CONCURRENT_LOAD (&buckets->nodes[node_index])) != NULL)
+    {
+      if (node != CONCURRENT_TOMBSTONE &&
+          g_concurrent_hash_table_node_matches (hash_table, node, key, hash_value))
+        return node;
+
+      step++;
+      node_index += step;
+      node_index &= buckets->mask;
+    }
+
+  return NULL;
 }
 
+/* Called with the lock held.  Returns TRUE and the index of the node
+ * for @key if there is one; otherwise, the index where it should be
+ * inserted (the first tombstone or the empty bucket).
+ */
+static gboolean
+g_concurrent_hash_table_find_slot (GConcurrentHashTable *hash_table,
+                                   GConcurrentBuckets   *buckets,
+                                   gconstpointer         key,
+                                   guint                 hash_value,
+                                   guint                *index_return)
+{
+  GConcurrentNode *node;
+  guint node_index;
+  guint first_tombstone = 0;
+  gboolean have_tombstone = FALSE;
+  guint step = 0;
+
+  node_index = hash_value % buckets->mod;
+
+  while ((node = buckets->nodes[node_index]) != NULL)
+    {
+      if (node == CONCURRENT_TOMBSTONE)
+        {
+          if (!have_tombstone)
+            {
+              first_tombstone = node_index;
+              have_tombstone = TRUE;
+            }
+        }
+      else if (g_concurrent_hash_table_node_matches (hash_table, node, key, hash_value))
+        {
+          *index_return = node_index;
+          return TRUE;
+        }
+
+      step++;
+      node_index += step;
+      node_index &= buckets->mask;
+    }
+
+  *index_return = have_tombstone ? first_tombstone : node_index;
+
+  return FALSE;
+}
+
+/* Called with the lock held.  If the table needs resizing, publishes a
+ * new bucket array and returns the old one, to be freed after a grace
+ * period.
+ */
+static GConcurrentBuckets *
+g_concurrent_hash_table_maybe_resize (GConcurrentHashTable *hash_table)
+{
+  GConcurrentBuckets *old_buckets = hash_table->buckets;
+  GConcurrentBuckets *new_buckets;
+  gint size = old_buckets->size;
+  gint shift;
+  gint i;
+
+  if (!(size > hash_table->nnodes * 4 && size > 1 << HASH_TABLE_MIN_SHIFT) &&
+      hash_table->noccupied < size / 4 * 3)
+    return NULL;
+
+  shift = g_hash_table_find_closest_shift (hash_table->nnodes * 2);
+  shift = MAX (shift, HASH_TABLE_MIN_SHIFT);
+  new_buckets = g_concurrent_hash_table_buckets_new (shift);
+
+  for (i = 0; i < size; i++)
+    {
+      GConcurrentNode *node = old_buckets->nodes[i];
+      guint node_index;
+      guint step = 0;
+
+      if (!CONCURRENT_NODE_IS_REAL (node))
+        continue;
+
+      node_index = node->hash % new_buckets->mod;
+      while (new_buckets->nodes[node_index] != NULL)
+        {
+          step++;
+          node_index += step;
+          node_index &= new_buckets->mask;
+        }
+
+      new_buckets->nodes[node_index] = node;
+    }
+
+  hash_table->noccupied = hash_table->nnodes;
+  g_atomic_pointer_set (&hash_table->buckets, new_buckets);
+
+  return old_buckets;
+}
+
+/**
+ * g_concurrent_hash_table_new:
+ * @hash_func: a function to create a hash value from a key
+ * @key_equal_func: a function to check two keys for equality
+ *
+ * Creates a new #GConcurrentHashTable with a reference count of 1.
+ * @hash_func and @key_equal_func are used as for g_hash_table_new(),
+ * and may be called from several threads at once.
+ *
+ * Return value: a new #GConcurrentHashTable
+ *
+ * Since: 2.40
+ */
+GConcurrentHashTable *
+g_concurrent_hash_table_new (GHashFunc  hash_func,
+                             GEqualFunc key_equal_func)
+{
+  return g_concurrent_hash_table_new_full (hash_func, key_equal_func, NULL, NULL);
+}
+
+/**
+ * g_concurrent_hash_table_new_full:
+ * @hash_func: a function to create a hash value from a key
+ * @key_equal_func: a function to check two keys for equality
+ * @key_destroy_func: (allow-none): a function to free the memory
+ *     allocated for the key used when removing the entry from the
+ *     table, or %NULL if you don't want to supply such a function
+ * @value_destroy_func: (allow-none): a function to free the memory
+ *     allocated for the value used when removing the entry from the
+ *     table, or %NULL if you don't want to supply such a function
+ *
+ * Creates a new #GConcurrentHashTable like
+ * g_concurrent_hash_table_new() and allows to specify functions to
+ * free the memory allocated for the key and value that get called
+ * when removing the entry from the table.
+ *
+ * The destroy functions are called from the thread that removed or
+ * replaced the entry, outside of the table's lock.
+ *
+ * Return value: a new #GConcurrentHashTable
+ *
+ * Since: 2.40
+ */
+GConcurrentHashTable *
+g_concurrent_hash_table_new_full (GHashFunc      hash_func,
+                                  GEqualFunc     key_equal_func,
+                                  GDestroyNotify key_destroy_func,
+                                  GDestroyNotify value_destroy_func)
+{
+  GConcurrentHashTable *hash_table;
+  gsize align = sizeof (GConcurrentReaders);
+
+  hash_table = g_slice_new0 (GConcurrentHashTable);
+  hash_table->buckets            = g_concurrent_hash_table_buckets_new (HASH_TABLE_MIN_SHIFT);
+  hash_table->hash_func          = hash_func ? hash_func : g_direct_hash;
+  hash_table->key_equal_func     = key_equal_func;
+  hash_table->ref_count          = 1;
+  hash_table->key_destroy_func   = key_destroy_func;
+  hash_table->value_destroy_func = value_destroy_func;
+  g_mutex_init (&hash_table->lock);
+
+  hash_table->readers_mem = g_malloc0 ((CONCURRENT_READER_SLOTS + 1) * align);
+  hash_table->readers = (GConcurrentReaders *)
+    (((gsize) hash_table->readers_mem + align - 1) & ~(align - 1));
+
+  return hash_table;
+}
+
+/**
+ * g_concurrent_hash_table_ref:
+ * @hash_table: a valid #GConcurrentHashTable
+ *
+ * Atomically increments the reference count of @hash_table by one.
+ *
+ * Return value: the passed in #GConcurrentHashTable
+ *
+ * Since: 2.40
+ */
+GConcurrentHashTable *
+g_concurrent_hash_table_ref (GConcurrentHashTable *hash_table)
+{
+  g_return_val_if_fail (hash_table != NULL, NULL);
+
+  g_atomic_int_inc (&hash_table->ref_count);
+
+  return hash_table;
+}
+
+/**
+ * g_concurrent_hash_table_unref:
+ * @hash_table: a valid #GConcurrentHashTable
+ *
+ * Atomically decrements the reference count of @hash_table by one.
+ * If the reference count drops to 0, all keys and values will be
+ * destroyed, and all memory allocated by the hash table is released.
+ *
+ * Since: 2.40
+ */
+void
+g_concurrent_hash_table_unref (GConcurrentHashTable *hash_table)
+{
+  g_return_if_fail (hash_table != NULL);
+
+  if (g_atomic_int_dec_and_test (&hash_table->ref_count))
+    {
+      g_concurrent_hash_table_buckets_free (hash_table, hash_table->buckets);
+      g_mutex_clear (&hash_table->lock);
+      g_free (hash_table->readers_mem);
+      g_slice_free (GConcurrentHashTable, hash_table);
+    }
+}
+
+static gboolean
+g_concurrent_hash_table_insert_internal (GConcurrentHashTable *hash_table,
+                                         gpointer              key,
+                                         gpointer              value,
+                                         gboolean              keep_new_key)
+{
+  GConcurrentBuckets *buckets;
+  GConcurrentBuckets *old_buckets;
+  GConcurrentNode *new_node;
+  GConcurrentNode *old_node;
+  gpointer key_to_free;
+  guint node_index;
+
+  new_node = g_slice_new (GConcurrentNode);
+  new_node->hash = g_concurrent_hash_table_hash (hash_table, key);
+  new_node->key = key;
+  new_node->value = value;
+
+  g_mutex_lock (&hash_table->lock);
+
+  buckets = hash_table->buckets;
+
+  if (g_concurrent_hash_table_find_slot (hash_table, buckets, key,
+                                         new_node->hash, &node_index))
+    {
+      old_node = buckets->nodes[node_index];
+
+      if (keep_new_key)
+        key_to_free = old_node->key;
+      else
+        {
+          key_to_free = key;
+          new_node->key = old_node->key;
+        }
+
+      g_atomic_pointer_set (&buckets->nodes[node_index], new_node);
+      g_concurrent_hash_table_synchronize (hash_table);
+
+      g_mutex_unlock (&hash_table->lock);
+
+      if (hash_table->key_destroy_func)
+        hash_table->key_destroy_func (key_to_free);
+      if (hash_table->value_destroy_func)
+        hash_table->value_destroy_func (old_node->value);
+      g_slice_free (GConcurrentNode, old_node);
+
+      return FALSE;
+    }
+
+  if (buckets->nodes[node_index] == NULL)
+    hash_table->noccupied++;
+  g_atomic_int_inc (&hash_table->nnodes);
+  g_atomic_pointer_set (&buckets->nodes[node_index], new_node);
+
+  old_buckets = g_concurrent_hash_table_maybe_resize (hash_table);
+  if (old_buckets)
+    g_concurrent_hash_table_synchronize (hash_table);
+
+  g_mutex_unlock (&hash_table->lock);
+
+  g_free (old_buckets);
+
+  return TRUE;
+}
+
+/**
+ * g_concurrent_hash_table_insert:
+ * @hash_table: a #GConcurrentHashTable
+ * @key: a key to insert
+ * @value: the value to associate with the key
+ *
+ * Inserts a new key and value into a #GConcurrentHashTable, like
+ * g_hash_table_insert(): if the key already exists, its value is
+ * replaced by the new one and the passed key is freed.
+ *
+ * Lookups in other threads see either the old or the new value, never
+ * a mix of both.
+ *
+ * Return value: %TRUE if the key did not exist yet
+ *
+ * Since: 2.40
+ */
+gboolean
+g_concurrent_hash_table_insert (GConcurrentHashTable *hash_table,
+                                gpointer              key,
+                                gpointer              value)
+{
+  g_return_val_if_fail (hash_table != NULL, FALSE);
+
+  return g_concurrent_hash_table_insert_internal (hash_table, key, value, FALSE);
+}
+
+/**
+ * g_concurrent_hash_table_replace:
+ * @hash_table: a #GConcurrentHashTable
+ * @key: a key to insert
+ * @value: the value to associate with the key
+ *
+ * Inserts a new key and value into a #GConcurrentHashTable similar to
+ * g_concurrent_hash_table_insert(). The difference is that if the key
+ * already exists in the table, it gets replaced by the new key, as in
+ * g_hash_table_replace().
+ *
+ * Return value: %TRUE if the key did not exist yet
+ *
+ * Since: 2.40
+ */
+gboolean
+g_concurrent_hash_table_replace (GConcurrentHashTable *hash_table,
+                                 gpointer              key,
+                                 gpointer              value)
+{
+  g_return_val_if_fail (hash_table != NULL, FALSE);
+
+  return g_concurrent_hash_table_insert_internal (hash_table, key, value, TRUE);
+}
+
+/**
+ * g_concurrent_hash_table_remove:
+ * @hash_table: a #GConcurrentHashTable
+ * @key: the key to remove
+ *
+ * Removes a key and its associated value from a #GConcurrentHashTable.
+ *
+ * If the table was created using g_concurrent_hash_table_new_full(),
+ * the key and value are freed using the supplied destroy functions,
+ * once the lookups that were running in other threads have finished.
+ *
+ * Return value: %TRUE if the key was found and removed
+ *
+ * Since: 2.40
+ */
+gboolean
+g_concurrent_hash_table_remove (GConcurrentHashTable *hash_table,
+                                gconstpointer         key)
+{
+  GConcurrentBuckets *buckets;
+  GConcurrentBuckets *old_buckets;
+  GConcurrentNode *node;
+  guint node_index;
+  guint hash_value;
+
+  g_return_val_if_fail (hash_table != NULL, FALSE);
+
+  hash_value = g_concurrent_hash_table_hash (hash_table, key);
+
+  g_mutex_lock (&hash_table->lock);
+
+  buckets = hash_table->buckets;
+
+  if (!g_concurrent_hash_table_find_slot (hash_table, buckets, key,
+                                          hash_value, &node_index))
+    {
+      g_mutex_unlock (&hash_table->lock);
+      return FALSE;
+    }
+
+  node = buckets->nodes[node_index];
+  g_atomic_pointer_set (&buckets->nodes[node_index], CONCURRENT_TOMBSTONE);
+  g_atomic_int_add (&hash_table->nnodes, -1);
+
+  old_buckets = g_concurrent_hash_table_maybe_resize (hash_table);
+  g_concurrent_hash_table_synchronize (hash_table);
+
+  g_mutex_unlock (&hash_table->lock);
+
+  g_free (old_buckets);
+
+  if (hash_table->key_destroy_func)
+    hash_table->key_destroy_func (node->key);
+  if (hash_table->value_destroy_func)
+    hash_table->value_destroy_func (node->value);
+  g_slice_free (GConcurrentNode, node);
+
+  return TRUE;
+}
+
+/**
+ * g_concurrent_hash_table_remove_all:
+ * @hash_table: a #GConcurrentHashTable
+ *
+ * Removes all keys and their associated values from a
+ * #GConcurrentHashTable, calling the destroy functions as
+ * g_concurrent_hash_table_remove() does.
+ *
+ * Since: 2.40
+ */
+void
+g_concurrent_hash_table_remove_all (GConcurrentHashTable *hash_table)
+{
+  GConcurrentBuckets *old_buckets;
+
+  g_return_if_fail (hash_table != NULL);
+
+  g_mutex_lock (&hash_table->lock);
+
+  old_buckets = hash_table->buckets;
+  g_atomic_pointer_set (&hash_table->buckets,
+                        g_concurrent_hash_table_buckets_new (HASH_TABLE_MIN_SHIFT));
+  g_atomic_int_set (&hash_table->nnodes, 0);
+  hash_table->noccupied = 0;
+  g_concurrent_hash_table_synchronize (hash_table);
+
+  g_mutex_unlock (&hash_table->lock);
+
+  g_concurrent_hash_table_buckets_free (hash_table, old_buckets);
+}
+
+/**
+ * g_concurrent_hash_table_lookup:
+ * @hash_table: a #GConcurrentHashTable
+ * @key: the key to look up
+ *
+ * Looks up a key in a #GConcurrentHashTable, without taking any lock.
+ *
+ * Nothing keeps the returned value alive: if another thread can
+ * remove or replace @key while it is being used, use
+ * g_concurrent_hash_table_lookup_copy() instead.
+ *
+ * Return value: (allow-none): the associated value, or %NULL if the
+ *     key is not found
+ *
+ * Since: 2.40
+ */
+gpointer
+g_concurrent_hash_table_lookup (GConcurrentHashTable *hash_table,
+                                gconstpointer         key)
+{
+  GConcurrentReaders *readers;
+  GConcurrentNode *node;
+  gpointer value;
+  guint hash_value;
+  gint epoch;
+
+  g_return_val_if_fail (hash_table != NULL, NULL);
+
+  hash_value = g_concurrent_hash_table_hash (hash_table, key);
+
+  readers = g_concurrent_hash_table_read_begin (hash_table, &epoch);
+  node = g_concurrent_hash_table_lookup_node (hash_table,
+                                              CONCURRENT_LOAD (&hash_table->buckets),
+                                              key, hash_value);
+  value = node ? node->value : NULL;
+  g_concurrent_hash_table_read_end (readers, epoch);
+
+  return value;
+}
+
+/**
+ * g_concurrent_hash_table_lookup_copy:
+ * @hash_table: a #GConcurrentHashTable
+ * @key: the key to look up
+ * @copy_func: a function to copy the value
+ * @user_data: user data to pass to @copy_func
+ *
+ * Looks up a key in a #GConcurrentHashTable and returns the result of
+ * calling @copy_func on its value.  @copy_func is called before the
+ * value can be destroyed by another thread, so it can safely take a
+ * reference to it (for instance with g_object_ref()) or copy it.
+ *
+ * @copy_func must not change @hash_table.
+ *
+ * Return value: (allow-none): the value returned by @copy_func, or
+ *     %NULL if the key is not found
+ *
+ * Since: 2.40
+ */
+gpointer
+g_concurrent_hash_table_lookup_copy (GConcurrentHashTable *hash_table,
+                                     gconstpointer         key,
+                                     GCopyFunc             copy_func,
+                                     gpointer              user_data)
+{
+  GConcurrentReaders *readers;
+  GConcurrentNode *node;
+  gpointer value;
+  guint hash_value;
+  gint epoch;
+
+  g_return_val_if_fail (hash_table != NULL, NULL);
+  g_return_val_if_fail (copy_func != NULL, NULL);
+
+  hash_value = g_concurrent_hash_table_hash (hash_table, key);
+
+  readers = g_concurrent_hash_table_read_begin (hash_table, &epoch);
+  node = g_concurrent_hash_table_lookup_node (hash_table,
+                                              CONCURRENT_LOAD (&hash_table->buckets),
+                                              key, hash_value);
+  value = node ? copy_func (node->value, user_data) : NULL;
+  g_concurrent_hash_table_read_end (readers, epoch);
+
+  return value;
+}
+
+/**
+ * g_concurrent_hash_table_contains:
+ * @hash_table: a #GConcurrentHashTable
+ * @key: a key to check
+ *
+ * Checks if @key is in @hash_table, without taking any lock.
+ *
+ * Return value: %TRUE if @key is in @hash_table, %FALSE otherwise.
+ *
+ * Since: 2.40
+ */
+gboolean
+g_concurrent_hash_table_contains (GConcurrentHashTable *hash_table,
+                                  gconstpointer         key)
+{
+  GConcurrentReaders *readers;
+  GConcurrentNode *node;
+  guint hash_value;
+  gint epoch;
+
+  g_return_val_if_fail (hash_table != NULL, FALSE);
+
+  hash_value = g_concurrent_hash_table_hash (hash_table, key);
+
+  readers = g_concurrent_hash_table_read_begin (hash_table, &epoch);
+  node = g_concurrent_hash_table_lookup_node (hash_table,
+                                              CONCURRENT_LOAD (&hash_table->buckets),
+                                              key, hash_value);
+  g_concurrent_hash_table_read_end (readers, epoch);
+
+  return node != NULL;
+}
+
+/**
+ * g_concurrent_hash_table_foreach:
+ * @hash_table: a #GConcurrentHashTable
+ * @func: the function to call for each key/value pair
+ * @user_data: user data to pass to the function
+ *
+ * Calls the given function for each of the key/value pairs in the
+ * #GConcurrentHashTable, without taking any lock.  Pairs inserted or
+ * removed by other threads while this runs may or may not be seen,
+ * but no pair is seen twice.
+ *
+ * @func must not change @hash_table, and it delays the destruction of
+ * keys and values removed by other threads until it returns, so it
+ * should be quick.
+ *
+ * Since: 2.40
+ */
+void
+g_concurrent_hash_table_foreach (GConcurrentHashTable *hash_table,
+                                 GHFunc                func,
+                                 gpointer              user_data)
+{
+  GConcurrentReaders *readers;
+  GConcurrentBuckets *buckets;
+  gint epoch;
+  gint i;
+
+  g_return_if_fail (hash_table != NULL);
+  g_return_if_fail (func != NULL);
+
+  readers = g_concurrent_hash_table_read_begin (hash_table, &epoch);
+  buckets = CONCURRENT_LOAD (&hash_table->buckets);
+
+  for (i = 0; i < buckets->size; i++)
+    {
+      GConcurrentNode *node = CONCURRENT_LOAD (&buckets->nodes[i]);
+
+      if (CONCURRENT_NODE_IS_REAL (node))
+        (* func) (node->key, node->value, user_data);
+    }
+
+  g_concurrent_hash_table_read_end (readers, epoch);
+}
+
+/**
+ * g_concurrent_hash_table_size:
+ * @hash_table: a #GConcurrentHashTable
+ *
+ * Returns the number of elements contained in the
+ * #GConcurrentHashTable.
+ *
+ * Return value: the number of key/value pairs in the table
+ *
+ * Since: 2.40
+ */
+guint
+g_concurrent_hash_table_size (GConcurrentHashTable *hash_table)
+{
+  g_return_val_if_fail (hash_table != NULL, 0);
+
+  return g_atomic_int_get (&hash_table->nnodes);
+}
+
+/* Hash functions.
+ */
+
+/**
+ * g_str_equal:
+ * @v1: a key
+ * @v2: a key to compare with @v1
+ *
+ * Compares two strings for byte-by-byte equality and returns %TRUE
+ * if they are equal. It can be passed to g_hash_table_new() as the
+ * @key_equal_func parameter, when using non-%NULL strings as keys in a
+ * #GHashTable.
+ *
+ * Note that this function is primarily meant as a hash table comparison
+ * function. For a general-purpose, %NULL-safe string comparison function,
+ * see g_strcmp0().
+ *
+ * Returns: %TRUE if the two keys match
+ */
+gboolean
+g_str_equal (gconstpointer v1,
+             gconstpointer v2)
+{
+  const gchar *string1 = v1;
+  const gchar *string2 = v2;
+
+  return strcmp (string1, string2) == 0;
+}
+
+/**
+ * g_str_hash:
+ * @v: a string key
+ *
+ * Converts a string to a hash value.
+ *
+ * This function implements the widely used "djb" hash apparently posted
+ * by Daniel Bernstein to comp.lang.c some time ago.  The 32 bit
+ * unsigned hash value starts at 5381 and for each byte 'c' in the
+ * string, is updated: <literal>hash = hash * 33 + c</literal>.  This
+ * function uses the signed value of each byte.
+ *
+ * It can be passed to g_hash_table_new() as the @hash_func parameter,
+ * when using non-%NULL strings as keys in a #GHashTable.
+ *
+ * Returns: a hash value corresponding to the key
+ */
+guint
+g_str_hash (gconstpointer v)
+{
+  const signed char *p;
+  guint32 h = 5381;
+
+  for (p = v; *p != '\0'; p++)
+    h = (h << 5) + h + *p;
+
+  return h;
+}
+
+/* SipHash-1-3, keyed with a per-process random seed */
+#define SIP_ROTL(x, b) (guint64) (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIP_ROUND(v0, v1, v2, v3)                                     \
+  G_STMT_START {                                                      \
+    v0 += v1; v1 = SIP_ROTL (v1, 13); v1 ^= v0; v0 = SIP_ROTL (v0, 32); \
+    v2 += v3; v3 = SIP_ROTL (v3, 16); v3 ^= v2;                       \
+    v0 += v3; v3 = SIP_ROTL (v3, 21); v3 ^= v0;                       \
+    v2 += v1; v1 = SIP_ROTL (v1, 17); v1 ^= v2; v2 = SIP_ROTL (v2, 32); \
+  } G_STMT_END
+
+static guint64 str_hash_seed[2];
+
+static const guint64 *
+str_hash_get_seed (void)
+{
+  static gsize initialised;
+
+  if (g_once_init_enter (&initialised))
+    {
+      GRand *rand;
+
+      /* g_rand_new() seeds itself from /dev/urandom where available */
+      rand = g_rand_new ();
+      str_hash_seed[0] = ((guint64) g_rand_int (rand) << 32) | g_rand_int (rand);
+      str_hash_seed[1] = ((guint64) g_rand_int (rand) << 32) | g_rand_int (rand);
+      g_rand_free (rand);
+
+      g_once_init_leave (&initialised, 1);
+    }
+
+  return str_hash_seed;
+}
+
+/**
+ * g_str_hash_fast:
+ * @v: a string key
+ *
+ * Converts a string to a hash value, like g_str_hash(), but using
+ * SipHash-1-3 keyed with a random seed chosen once per process.
+ *
+ * The string is hashed 8 bytes at a time, which makes it several times
+ * faster than g_str_hash() on long keys; on keys shorter than a couple
+ * of dozen bytes the fixed finalisation cost makes it slower.  Because the
+ * seed is secret and differs between runs, an attacker who controls
+ * the keys (for example the header names of an incoming HTTP request)
+ * can not choose them so that they all collide.  For the same reason
+ * the hash value of a given string is not stable across processes, so
+ * it must not be stored or sent elsewhere.
+ *
+ * It can be passed to g_hash_table_new() as the @hash_func parameter,
+ * when using non-%NULL strings as keys in a #GHashTable.
+ *
+ * Returns: a hash value corresponding to the key
+ *
+ * Since: 2.40
+ */
+guint
+g_str_hash_fast (gconstpointer v)
+{
+  const guint64 *seed = str_hash_get_seed ();
+  const guchar *p = v;
+  gsize len = strlen (v);
+  const guchar *end = p + (len & ~(gsize) 7);
+  guint64 v0, v1, v2, v3, m;
+  guint64 b = (guint64) len << 56;
+
+  v0 = seed[0] ^ G_GUINT64_CONSTANT (0x736f6d6570736575);
+  v1 = seed[1] ^ G_GUINT64_CONSTANT (0x646f72616e646f6d);
+  v2 = seed[0] ^ G_GUINT64_CONSTANT (0x6c7967656e657261);
+  v3 = seed[1] ^ G_GUINT64_CONSTANT (0x7465646279746573);
+
+  for (; p != end; p += 8)
+    {
+      memcpy (&m, p, sizeof m);
+      m = GUINT64_FROM_LE (m);
+      v3 ^= m;
+      SIP_ROUND (v0, v1, v2, v3);
+      v0 ^= m;
+    }
+
+  switch (len & 7)
+    {
+    case 7: b |= (guint64) p[6] << 48;
+    case 6: b |= (guint64) p[5] << 40;
+    case 5: b |= (guint64) p[4] << 32;
+    case 4: b |= (guint64) p[3] << 24;
+    case 3: b |= (guint64) p[2] << 16;
+    case 2: b |= (guint64) p[1] << 8;
+    case 1: b |= (guint64) p[0];
+    case 0: break;
+    }
+
+  v3 ^= b;
+  SIP_ROUND (v0, v1, v2, v3);
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIP_ROUND (v0, v1, v2, v3);
+  SIP_ROUND (v0, v1, v2, v3);
+  SIP_ROUND (v0, v1, v2, v3);
+
+  m = v0 ^ v1 ^ v2 ^ v3;
+
+  return (guint) (m ^ (m >> 32));
+}
+
+#undef SIP_ROUND
+#undef SIP_ROTL
+
 /**
  * g_direct_hash:
  * @v: (allow-none): a #gpointer key
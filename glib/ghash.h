@@ -32,11 +32,14 @@
 #endif
 
 #include <glib/gtypes.h>
+#include <glib/garena.h>
 #include <glib/glist.h>
+#include <glib/gnode.h>
 
 G_BEGIN_DECLS
 
 typedef struct _GHashTable  GHashTable;
+typedef struct _GConcurrentHashTable GConcurrentHashTable;
 
 typedef gboolean  (*GHRFunc)  (gpointer  key,
                                gpointer  value,
@@ -63,6 +66,12 @@ GHashTable* g_hash_table_new_full          (GHashFunc       hash_func,
                                             GEqualFunc      key_equal_func,
                                             GDestroyNotify  key_destroy_func,
                                             GDestroyNotify  value_destroy_func);
+GLIB_AVAILABLE_IN_2_40
+GHashTable* g_hash_table_new_in_arena      (GArena         *arena,
+                                            GHashFunc       hash_func,
+                                            GEqualFunc      key_equal_func,
+                                            GDestroyNotify  key_destroy_func,
+                                            GDestroyNotify  value_destroy_func);
 GLIB_AVAILABLE_IN_ALL
 void        g_hash_table_destroy           (GHashTable     *hash_table);
 GLIB_AVAILABLE_IN_ALL
@@ -76,6 +85,14 @@ void        g_hash_table_replace           (GHashTable     *hash_table,
 GLIB_AVAILABLE_IN_ALL
 void        g_hash_table_add               (GHashTable     *hash_table,
                                             gpointer        key);
+GLIB_AVAILABLE_IN_2_40
+void        g_hash_table_reserve           (GHashTable     *hash_table,
+                                            guint           n_elements);
+GLIB_AVAILABLE_IN_2_40
+void        g_hash_table_insert_bulk       (GHashTable     *hash_table,
+                                            gpointer       *keys,
+                                            gpointer       *values,
+                                            guint           n_pairs);
 GLIB_AVAILABLE_IN_ALL
 gboolean    g_hash_table_remove            (GHashTable     *hash_table,
                                             gconstpointer   key);
@@ -155,8 +172,56 @@ void        g_hash_table_unref             (GHashTable     *hash_table);
 GLIB_AVAILABLE_IN_ALL
 gboolean g_str_equal    (gconstpointer  v1,
                          gconstpointer  v2);
+GLIB_AVAILABLE_IN_2_40
+GConcurrentHashTable *
+            g_concurrent_hash_table_new         (GHashFunc              hash_func,
+                                                 GEqualFunc             key_equal_func);
+GLIB_AVAILABLE_IN_2_40
+GConcurrentHashTable *
+            g_concurrent_hash_table_new_full    (GHashFunc              hash_func,
+                                                 GEqualFunc             key_equal_func,
+                                                 GDestroyNotify         key_destroy_func,
+                                                 GDestroyNotify         value_destroy_func);
+GLIB_AVAILABLE_IN_2_40
+GConcurrentHashTable *
+            g_concurrent_hash_table_ref         (GConcurrentHashTable  *hash_table);
+GLIB_AVAILABLE_IN_2_40
+void        g_concurrent_hash_table_unref       (GConcurrentHashTable  *hash_table);
+GLIB_AVAILABLE_IN_2_40
+gboolean    g_concurrent_hash_table_insert      (GConcurrentHashTable  *hash_table,
+                                                 gpointer               key,
+                                                 gpointer               value);
+GLIB_AVAILABLE_IN_2_40
+gboolean    g_concurrent_hash_table_replace     (GConcurrentHashTable  *hash_table,
+                                                 gpointer               key,
+                                                 gpointer               value);
+GLIB_AVAILABLE_IN_2_40
+gboolean    g_concurrent_hash_table_remove      (GConcurrentHashTable  *hash_table,
+                                                 gconstpointer          key);
+GLIB_AVAILABLE_IN_2_40
+void        g_concurrent_hash_table_remove_all  (GConcurrentHashTable  *hash_table);
+GLIB_AVAILABLE_IN_2_40
+gpointer    g_concurrent_hash_table_lookup      (GConcurrentHashTable  *hash_table,
+                                                 gconstpointer          key);
+GLIB_AVAILABLE_IN_2_40
+gpointer    g_concurrent_hash_table_lookup_copy (GConcurrentHashTable  *hash_table,
+                                                 gconstpointer          key,
+                                                 GCopyFunc              copy_func,
+                                                 gpointer               user_data);
+GLIB_AVAILABLE_IN_2_40
+gboolean    g_concurrent_hash_table_contains    (GConcurrentHashTable  *hash_table,
+                                                 gconstpointer          key);
+GLIB_AVAILABLE_IN_2_40
+void        g_concurrent_hash_table_foreach     (GConcurrentHashTable  *hash_table,
+                                                 GHFunc                 func,
+                                                 gpointer               user_data);
+GLIB_AVAILABLE_IN_2_40
+guint       g_concurrent_hash_table_size        (GConcurrentHashTable  *hash_table);
+
 GLIB_AVAILABLE_IN_ALL
 guint    g_str_hash     (gconstpointer  v);
+GLIB_AVAILABLE_IN_2_40
+guint    g_str_hash_fast (gconstpointer v);
 
 GLIB_AVAILABLE_IN_ALL
 gboolean g_int_equal    (gconstpointer  v1,
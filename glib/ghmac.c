@@ -50,6 +50,16 @@
  *
  * Both the key and data are arbitrary byte arrays of bytes or characters.
  *
+ * Setting up a #GHmac hashes the key, which costs at least one block of
+ * the digest algorithm. When many messages are authenticated with the
+ * same key, create a #GHmac for the key once and keep it unused as a
+ * template: g_hmac_copy() of it starts from the already keyed state,
+ * and g_hmac_verify_for_data() checks a message against it in one call.
+ *
+ * When checking a received HMAC, always use g_hmac_verify_digest() or
+ * g_hmac_verify_for_data() rather than memcmp(), which leaks through
+ * its timing how much of a forged digest was right.
+ *
  * Support for HMAC Digests has been added in GLib 2.30.
  */
 
@@ -323,6 +333,108 @@ g_hmac_get_digest (GHmac  *hmac,
   g_checksum_get_digest (hmac->digesto, buffer, digest_len);
 }
 
+/* compares @len bytes in a time independent of their contents */
+static gboolean
+digest_equal (const guint8 *a,
+              const guint8 *b,
+              gsize         len)
+{
+  guint8 diff = 0;
+  gsize i;
+
+  for (i = 0; i < len; i++)
+    diff |= a[i] ^ b[i];
+
+  return diff == 0;
+}
+
+/**
+ * g_hmac_verify_digest:
+ * @hmac: a #GHmac
+ * @digest: (array length=digest_len): the expected digest
+ * @digest_len: the length of @digest
+ *
+ * Checks whether the HMAC of the data fed to @hmac so far is @digest.
+ * The comparison takes the same time wherever the digests differ, so
+ * that it can be used to check HMACs received from untrusted parties.
+ *
+ * Like g_hmac_get_digest(), this closes @hmac.
+ *
+ * Return value: %TRUE if @digest is the HMAC of the data
+ *
+ * Since: 2.40
+ */
+gboolean
+g_hmac_verify_digest (GHmac        *hmac,
+                      const guint8 *digest,
+                      gsize         digest_len)
+{
+  guint8 *buffer;
+  gsize len;
+
+  g_return_val_if_fail (hmac != NULL, FALSE);
+  g_return_val_if_fail (digest != NULL || digest_len == 0, FALSE);
+
+  len = g_checksum_type_get_length (hmac->digest_type);
+  buffer = g_alloca (len);
+  g_hmac_get_digest (hmac, buffer, &len);
+
+  /* the length is no secret */
+  if (digest_len != len)
+    return FALSE;
+
+  return digest_equal (buffer, digest, len);
+}
+
+/**
+ * g_hmac_verify_for_data:
+ * @hmac: a #GHmac to use as a template
+ * @data: (array length=length): the message
+ * @length: the length of @data
+ * @digest: (array length=digest_len): the expected digest
+ * @digest_len: the length of @digest
+ *
+ * Checks whether @digest is the HMAC of @data, continuing from the
+ * state of @hmac, which is not modified. This is the same as calling
+ * g_hmac_copy(), g_hmac_update() and g_hmac_verify_digest() on the
+ * copy, but without allocating a #GHmac.
+ *
+ * @hmac is usually a #GHmac which has just been created with
+ * g_hmac_new(), so that the key is only hashed once for any number of
+ * messages. It must not have been closed.
+ *
+ * Return value: %TRUE if @digest is the HMAC of @data
+ *
+ * Since: 2.40
+ */
+gboolean
+g_hmac_verify_for_data (const GHmac  *hmac,
+                        const guchar *data,
+                        gsize         length,
+                        const guint8 *digest,
+                        gsize         digest_len)
+{
+  GHmac tmp;
+  gboolean result;
+
+  g_return_val_if_fail (hmac != NULL, FALSE);
+  g_return_val_if_fail (data != NULL || length == 0, FALSE);
+  g_return_val_if_fail (digest != NULL || digest_len == 0, FALSE);
+
+  tmp.ref_count = 1;
+  tmp.digest_type = hmac->digest_type;
+  tmp.digesti = g_checksum_copy (hmac->digesti);
+  tmp.digesto = g_checksum_copy (hmac->digesto);
+
+  g_checksum_update (tmp.digesti, data, length);
+  result = g_hmac_verify_digest (&tmp, digest, digest_len);
+
+  g_checksum_free (tmp.digesti);
+  g_checksum_free (tmp.digesto);
+
+  return result;
+}
+
 /**
  * g_compute_hmac_for_data:
  * @digest_type: a #GChecksumType to use for the HMAC
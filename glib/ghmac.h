@@ -61,6 +61,16 @@ GLIB_AVAILABLE_IN_2_30
 void                  g_hmac_get_digest             (GHmac         *hmac,
                                                      guint8        *buffer,
                                                      gsize         *digest_len);
+GLIB_AVAILABLE_IN_2_40
+gboolean              g_hmac_verify_digest          (GHmac         *hmac,
+                                                     const guint8  *digest,
+                                                     gsize          digest_len);
+GLIB_AVAILABLE_IN_2_40
+gboolean              g_hmac_verify_for_data        (const GHmac   *hmac,
+                                                     const guchar  *data,
+                                                     gsize          length,
+                                                     const guint8  *digest,
+                                                     gsize          digest_len);
 
 GLIB_AVAILABLE_IN_2_30
 gchar                *g_compute_hmac_for_data       (GChecksumType  digest_type,
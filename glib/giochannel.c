@@ -1599,44 +1599,45 @@ reencode:
     }
   else if (channel->encoding) /* UTF-8 */
     {
-      gchar *nextchar, *lastchar;
+      const gchar *nextchar, *lastchar;
 
       g_assert (channel->encoded_read_buf);
 
       nextchar = channel->read_buf->str;
       lastchar = channel->read_buf->str + channel->read_buf->len;
 
-      while (nextchar < lastchar)
-        {
-          gunichar val_char;
-
-          val_char = g_utf8_get_char_validated (nextchar, lastchar - nextchar);
+      /* g_utf8_validate() stops at embedded nuls, which are valid here */
+      while (!g_utf8_validate (nextchar, lastchar - nextchar, &nextchar) &&
+             *nextchar == '\0')
+        nextchar++;
 
-          switch (val_char)
+      if (nextchar < lastchar)
+        {
+          /* Otherwise, stop and leave the partial character in the buffer */
+          if (g_utf8_get_char_validated (nextchar, lastchar - nextchar) == (gunichar) -1)
             {
-              case -2:
-                /* stop, leave partial character in buffer */
-                lastchar = nextchar;
-                break;
-              case -1:
-                if (oldlen < channel->encoded_read_buf->len)
-                  status = G_IO_STATUS_NORMAL;
-                else
-                  {
-                    g_set_error_literal (err, G_CONVERT_ERROR,
-                      G_CONVERT_ERROR_ILLEGAL_SEQUENCE,
-                      _("Invalid byte sequence in conversion input"));
-                    status = G_IO_STATUS_ERROR;
-                  }
-                lastchar = nextchar;
-                break;
-              default:
-                nextchar = g_utf8_next_char (nextchar);
-                break;
+              if (oldlen < channel->encoded_read_buf->len)
+                status = G_IO_STATUS_NORMAL;
+              else
+                {
+                  g_set_error_literal (err, G_CONVERT_ERROR,
+                    G_CONVERT_ERROR_ILLEGAL_SEQUENCE,
+                    _("Invalid byte sequence in conversion input"));
+                  status = G_IO_STATUS_ERROR;
+                }
             }
+          lastchar = nextchar;
         }
 
-      if (lastchar > channel->read_buf->str)
+      if (oldlen == 0 && lastchar == channel->read_buf->str + channel->read_buf->len)
+        {
+          GString *empty = channel->encoded_read_buf;
+
+          /* All of it is valid, so hand it over instead of copying it */
+          channel->encoded_read_buf = channel->read_buf;
+          channel->read_buf = empty;
+        }
+      else if (lastchar > channel->read_buf->str)
         {
           gint copy_len = lastchar - channel->read_buf->str;
 
@@ -1746,6 +1747,58 @@ g_io_channel_read_line_string (GIOChannel  *channel,
 }
 
 
+/* Returns the first line terminator in [@str, @end), or %NULL if
+ * there is none.  If the channel has an encoding the buffer holds valid
+ * UTF-8, in which no character starts with a byte that can continue
+ * another, so searching bytewise gives the same result as stepping
+ * through the characters.
+ */
+static gchar *
+g_io_channel_find_line_term (GIOChannel *channel,
+                             gchar      *str,
+                             gchar      *end)
+{
+  gchar *term, *last;
+
+  if (channel->line_term)
+    {
+      gsize line_term_len = channel->line_term_len;
+
+      while ((term = memchr (str, channel->line_term[0], end - str)) != NULL &&
+             (gsize) (end - term) >= line_term_len)
+        {
+          if (memcmp (channel->line_term, term, line_term_len) == 0)
+            return term;
+          str = term + 1;
+        }
+
+      return NULL;
+    }
+
+  /* Auto detect; each search only needs to go as far as the earliest
+   * terminator found so far.
+   */
+  last = end;
+
+  term = memchr (str, '\n', end - str);
+  if (term != NULL)
+    end = term;
+
+  term = memchr (str, '\r', end - str);
+  if (term != NULL)
+    end = term;
+
+  term = memchr (str, '\0', end - str);
+  if (term != NULL)
+    end = term;
+
+  for (term = str; (term = memchr (term, '\xe2', end - term)) != NULL; term++)
+    if (strncmp ("\xe2\x80\xa9", term, 3) == 0)
+      return term;
+
+  return end < last ? end : NULL;
+}
+
 static GIOStatus
 g_io_channel_read_line_backend (GIOChannel  *channel,
                                 gsize       *length,
@@ -1830,57 +1883,35 @@ read_again:
 
       lastchar = use_buf->str + use_buf->len;
 
-      for (nextchar = use_buf->str + checked_to; nextchar < lastchar;
-           channel->encoding ? nextchar = g_utf8_next_char (nextchar) : nextchar++)
+      nextchar = g_io_channel_find_line_term (channel, use_buf->str + checked_to,
+                                              lastchar);
+      if (nextchar != NULL)
         {
+          line_length = nextchar - use_buf->str;
+
           if (channel->line_term)
-            {
-              if (memcmp (channel->line_term, nextchar, line_term_len) == 0)
-                {
-                  line_length = nextchar - use_buf->str;
-                  got_term_len = line_term_len;
-                  goto done;
-                }
-            }
-          else /* auto detect */
-            {
-              switch (*nextchar)
-                {
-                  case '\n': /* unix */
-                    line_length = nextchar - use_buf->str;
-                    got_term_len = 1;
-                    goto done;
-                  case '\r': /* Warning: do not use with sockets */
-                    line_length = nextchar - use_buf->str;
-                    if ((nextchar == lastchar - 1) && (status != G_IO_STATUS_EOF)
-                       && (lastchar == use_buf->str + use_buf->len))
-                      goto read_again; /* Try to read more data */
-                    if ((nextchar < lastchar - 1) && (*(nextchar + 1) == '\n')) /* dos */
-                      got_term_len = 2;
-                    else /* mac */
-                      got_term_len = 1;
-                    goto done;
-                  case '\xe2': /* Unicode paragraph separator */
-                    if (strncmp ("\xe2\x80\xa9", nextchar, 3) == 0)
-                      {
-                        line_length = nextchar - use_buf->str;
-                        got_term_len = 3;
-                        goto done;
-                      }
-                    break;
-                  case '\0': /* Embeded null in input */
-                    line_length = nextchar - use_buf->str;
+            got_term_len = line_term_len;
+          else
+            switch (*nextchar)
+              {
+                case '\r': /* Warning: do not use with sockets */
+                  if ((nextchar == lastchar - 1) && (status != G_IO_STATUS_EOF))
+                    goto read_again; /* Try to read more data */
+                  if ((nextchar < lastchar - 1) && (*(nextchar + 1) == '\n')) /* dos */
+                    got_term_len = 2;
+                  else /* mac */
                     got_term_len = 1;
-                    goto done;
-                  default: /* no match */
-                    break;
-                }
-            }
+                  break;
+                case '\xe2': /* Unicode paragraph separator */
+                  got_term_len = 3;
+                  break;
+                default: /* unix, or embedded nul in input */
+                  got_term_len = 1;
+                  break;
+              }
+          goto done;
         }
 
-      /* If encoding != NULL, valid UTF-8, didn't overshoot */
-      g_assert (nextchar == lastchar);
-
       /* Check for EOF */
 
       if (status == G_IO_STATUS_EOF)
@@ -61,6 +61,7 @@
 #include "glibintl.h"
 #include "glist.h"
 #include "gslist.h"
+#include "gmappedfile.h"
 #include "gmem.h"
 #include "gmessages.h"
 #include "gstdio.h"
@@ -190,6 +191,16 @@
  *     (possibly modified) contents of the key file back to a file;
  *     otherwise only the translations for the current language will be
  *     written back.
+ * @G_KEY_FILE_READ_ONLY: Use this flag if you only plan to read values
+ *     from a large key file. The file is mapped into memory instead of
+ *     being read, and only its group headers are indexed when it is
+ *     loaded; the keys of a group are parsed the first time the group
+ *     is used. The lines of the file are still checked when it is
+ *     loaded. This only applies to g_key_file_load_from_file() and the
+ *     functions loading files from directories, and is ignored
+ *     together with %G_KEY_FILE_KEEP_COMMENTS. A key file loaded with
+ *     this flag can be modified, but it must not be accessed from more
+ *     than one thread at a time, even for reading. Since: 2.40
  *
  * Flags which influence the parsing.
  */
@@ -446,6 +457,8 @@ struct _GKeyFile
 
   gchar **locales;
 
+  GMappedFile *mapped; /* Holds the data of groups that are not parsed yet */
+
   volatile gint ref_count;
 };
 
@@ -460,9 +473,15 @@ struct _GKeyFileGroup
   GList *key_value_pairs;
 
   /* Used in parallel with key_value_pairs for
-   * increased lookup performance
+   * increased lookup performance, created with the first key
    */
   GHashTable *lookup_map;
+
+  /* The lines of the group that still need to be parsed, with
+   * G_KEY_FILE_READ_ONLY
+   */
+  const gchar *unparsed_data;
+  gsize        unparsed_length;
 };
 
 struct _GKeyFileKeyValuePair
@@ -555,6 +574,12 @@ static void                  g_key_file_parse_data             (GKeyFile
 								GError                **error);
 static void                  g_key_file_flush_parse_buffer     (GKeyFile               *key_file,
 								GError                **error);
+static void                  g_key_file_index_data             (GKeyFile               *key_file,
+								const gchar            *data,
+								gsize                   length,
+								GError                **error);
+static void                  g_key_file_ensure_parsed          (GKeyFile               *key_file,
+								GKeyFileGroup          *group);
 
 G_DEFINE_QUARK (g-key-file-error-quark, g_key_file_error)
 
@@ -602,6 +627,12 @@ g_key_file_clear (GKeyFile *key_file)
       key_file->group_hash = NULL;
     }
 
+  if (key_file->mapped != NULL)
+    {
+      g_mapped_file_unref (key_file->mapped);
+      key_file->mapped = NULL;
+    }
+
   g_warn_if_fail (key_file->groups == NULL);
 }
 
@@ -765,6 +796,26 @@ g_key_file_load_from_fd (GKeyFile       *key_file,
   key_file->list_separator = list_separator;
   key_file->flags = flags;
 
+  if ((flags & G_KEY_FILE_READ_ONLY) && !(flags & G_KEY_FILE_KEEP_COMMENTS))
+    {
+      /* if the file can't be mapped, just read it */
+      key_file->mapped = g_mapped_file_new_from_fd (fd, FALSE, NULL);
+      if (key_file->mapped != NULL)
+        {
+          g_key_file_index_data (key_file,
+                                 g_mapped_file_get_contents (key_file->mapped),
+                                 g_mapped_file_get_length (key_file->mapped),
+                                 &key_file_error);
+          if (key_file_error)
+            {
+              g_propagate_error (error, key_file_error);
+              return FALSE;
+            }
+
+          return TRUE;
+        }
+    }
+
   do
     {
       bytes_read = read (fd, read_buf, 4096);
@@ -1423,6 +1474,186 @@ g_key_file_flush_parse_buffer (GKeyFile  *key_file,
     }
 }
 
+/* Checks a line of a group whose parsing is deferred, so that loading
+ * still reports the errors that g_key_file_parse_line() would.  This
+ * assumes all leading whitespace has been stripped.
+ */
+static void
+g_key_file_check_line (GKeyFile     *key_file,
+                       gchar        *line,
+                       GError      **error)
+{
+  if (g_key_file_line_is_comment (line))
+    return;
+
+  if (g_key_file_line_is_key_value_pair (line))
+    {
+      gchar *key_end, saved;
+
+      key_end = strchr (line, '=');
+      while (key_end > line && g_ascii_isspace (key_end[-1]))
+        key_end--;
+
+      saved = *key_end;
+      *key_end = '\0';
+      if (!g_key_file_is_key_name (line))
+        g_set_error (error, G_KEY_FILE_ERROR,
+                     G_KEY_FILE_ERROR_PARSE,
+                     _("Invalid key name: %s"), line);
+      *key_end = saved;
+    }
+  else
+    {
+      gchar *line_utf8 = _g_utf8_make_valid (line);
+      g_set_error (error, G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_PARSE,
+                   _("Key file contains line '%s' which is not "
+                     "a key-value pair, group, or comment"),
+                   line_utf8);
+      g_free (line_utf8);
+    }
+}
+
+/* Ends the section of data before the group header at @section_end:
+ * either leaves it for later, or parses it now if the section belongs
+ * to a group that was already parsed.
+ */
+static void
+g_key_file_end_section (GKeyFile       *key_file,
+                        GKeyFileGroup  *unparsed_group,
+                        const gchar    *section,
+                        const gchar    *section_end,
+                        GError        **error)
+{
+  GError *parse_error = NULL;
+
+  if (unparsed_group != NULL)
+    {
+      unparsed_group->unparsed_data = section;
+      unparsed_group->unparsed_length = section_end - section;
+      return;
+    }
+
+  g_key_file_parse_data (key_file, section, section_end - section, &parse_error);
+  if (!parse_error)
+    g_key_file_flush_parse_buffer (key_file, &parse_error);
+
+  if (parse_error)
+    g_propagate_error (error, parse_error);
+}
+
+/* Loads @data for G_KEY_FILE_READ_ONLY.  The start of the file up to
+ * the second group header is parsed as usual, so that the encoding is
+ * checked.  The lines of the following groups are only checked, and
+ * left to g_key_file_ensure_parsed().  A group that appears more than
+ * once in the file is parsed right away.
+ */
+static void
+g_key_file_index_data (GKeyFile     *key_file,
+                       const gchar  *data,
+                       gsize         length,
+                       GError      **error)
+{
+  GError *parse_error = NULL;
+  GKeyFileGroup *unparsed_group = NULL;
+  const gchar *section = data;
+  const gchar *data_end = data + length;
+  const gchar *line_start;
+  gboolean seen_group = FALSE;
+  GString *line;
+
+  line = g_string_sized_new (128);
+
+  line_start = data;
+  while (line_start < data_end && !parse_error)
+    {
+      const gchar *line_end, *next_line;
+      gchar *p;
+
+      line_end = memchr (line_start, '\n', data_end - line_start);
+      if (line_end != NULL)
+        next_line = line_end + 1;
+      else
+        next_line = line_end = data_end;
+
+      g_string_truncate (line, 0);
+      g_string_append_len (line, line_start, line_end - line_start);
+      if (line_end < data_end && line->len > 0 && line->str[line->len - 1] == '\r')
+        g_string_truncate (line, line->len - 1);
+
+      p = line->str;
+      while (g_ascii_isspace (*p))
+        p++;
+
+      if (!g_key_file_line_is_comment (p) && g_key_file_line_is_group (p))
+        {
+          if (seen_group)
+            {
+              guint n_groups = g_hash_table_size (key_file->group_hash);
+
+              g_key_file_end_section (key_file, unparsed_group,
+                                      section, line_start, &parse_error);
+              if (parse_error)
+                break;
+
+              g_key_file_parse_group (key_file, p, line->len - (p - line->str),
+                                      &parse_error);
+              if (parse_error)
+                break;
+
+              if (g_hash_table_size (key_file->group_hash) > n_groups)
+                unparsed_group = key_file->current_group;
+              else
+                {
+                  g_key_file_ensure_parsed (key_file, key_file->current_group);
+                  unparsed_group = NULL;
+                }
+
+              section = next_line;
+            }
+
+          seen_group = TRUE;
+        }
+      else if (unparsed_group != NULL)
+        g_key_file_check_line (key_file, p, &parse_error);
+
+      line_start = next_line;
+    }
+
+  if (!parse_error)
+    g_key_file_end_section (key_file, unparsed_group,
+                            section, data_end, &parse_error);
+
+  g_string_free (line, TRUE);
+
+  if (parse_error)
+    g_propagate_error (error, parse_error);
+}
+
+/* Parses the keys of @group if that was deferred, see
+ * g_key_file_index_data().
+ */
+static void
+g_key_file_ensure_parsed (GKeyFile      *key_file,
+                          GKeyFileGroup *group)
+{
+  GKeyFileGroup *current_group;
+  const gchar *data;
+
+  if (group == NULL || group->unparsed_data == NULL)
+    return;
+
+  data = group->unparsed_data;
+  group->unparsed_data = NULL;
+
+  /* the lines have already been checked, so this can't fail */
+  current_group = key_file->current_group;
+  key_file->current_group = group;
+  g_key_file_parse_data (key_file, data, group->unparsed_length, NULL);
+  g_key_file_flush_parse_buffer (key_file, NULL);
+  key_file->current_group = current_group;
+}
+
 /**
  * g_key_file_to_data:
  * @key_file: a #GKeyFile
@@ -1459,6 +1690,7 @@ g_key_file_to_data (GKeyFile  *key_file,
       GKeyFileGroup *group;
 
       group = (GKeyFileGroup *) group_node->data;
+      g_key_file_ensure_parsed (key_file, group);
 
       /* separate groups by at least an empty line */
       if (data_string->len >= 2 &&
@@ -3513,7 +3745,7 @@ g_key_file_has_group (GKeyFile    *key_file,
   g_return_val_if_fail (key_file != NULL, FALSE);
   g_return_val_if_fail (group_name != NULL, FALSE);
 
-  return g_key_file_lookup_group (key_file, group_name) != NULL;
+  return g_hash_table_lookup (key_file->group_hash, group_name) != NULL;
 }
 
 /* This code remains from a historical attempt to add a new public API
@@ -3613,7 +3845,6 @@ g_key_file_add_group (GKeyFile    *key_file,
 
   group = g_slice_new0 (GKeyFileGroup);
   group->name = g_strdup (group_name);
-  group->lookup_map = g_hash_table_new (g_str_hash, g_str_equal);
   key_file->groups = g_list_prepend (key_file->groups, group);
   key_file->current_group = group;
 
@@ -3784,6 +4015,9 @@ g_key_file_add_key_value_pair (GKeyFile             *key_file,
                                GKeyFileGroup        *group,
                                GKeyFileKeyValuePair *pair)
 {
+  if (group->lookup_map == NULL)
+    group->lookup_map = g_hash_table_new (g_str_hash, g_str_equal);
+
   g_hash_table_replace (group->lookup_map, pair->key, pair);
   group->key_value_pairs = g_list_prepend (group->key_value_pairs, pair);
 }
@@ -3881,7 +4115,12 @@ static GKeyFileGroup *
 g_key_file_lookup_group (GKeyFile    *key_file,
 			 const gchar *group_name)
 {
-  return (GKeyFileGroup *)g_hash_table_lookup (key_file->group_hash, group_name);
+  GKeyFileGroup *group;
+
+  group = (GKeyFileGroup *)g_hash_table_lookup (key_file->group_hash, group_name);
+  g_key_file_ensure_parsed (key_file, group);
+
+  return group;
 }
 
 static GList *
@@ -3911,6 +4150,9 @@ g_key_file_lookup_key_value_pair (GKeyFile      *key_file,
 				  GKeyFileGroup *group,
 				  const gchar   *key)
 {
+  if (group->lookup_map == NULL)
+    return NULL;
+
   return (GKeyFileKeyValuePair *) g_hash_table_lookup (group->lookup_map, key);
 }
 
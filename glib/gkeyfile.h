@@ -52,7 +52,8 @@ typedef enum
 {
   G_KEY_FILE_NONE              = 0,
   G_KEY_FILE_KEEP_COMMENTS     = 1 << 0,
-  G_KEY_FILE_KEEP_TRANSLATIONS = 1 << 1
+  G_KEY_FILE_KEEP_TRANSLATIONS = 1 << 1,
+  G_KEY_FILE_READ_ONLY         = 1 << 2
 } GKeyFileFlags;
 
 GLIB_AVAILABLE_IN_ALL
@@ -26,6 +26,7 @@
 #include "gutils.h"     /* for GDebugKey */
 #include "gconstructor.h"
 #include "gmem.h"       /* for g_mem_gc_friendly */
+#include "gmem-internal.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -220,6 +221,7 @@ glib_init (void)
 {
   g_messages_prefixed_init ();
   g_debug_init ();
+  g_mem_profiler_init ();
 }
 
 #if defined (G_OS_WIN32)
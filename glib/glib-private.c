@@ -46,7 +46,11 @@ glib__private__ (void)
     g_main_context_new_with_next_id,
 
     g_dir_open_with_errno,
-    g_dir_new_from_dirp
+    g_dir_new_from_dirp,
+
+    g_trace_buffer_enabled,
+    g_trace_buffer_record,
+    g_trace_buffer_dump
   };
 
   return &table;
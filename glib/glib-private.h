@@ -22,6 +22,7 @@
 
 #include <glib.h>
 #include "gwakeup.h"
+#include "gtracebuffer.h"
 
 GMainContext *          g_get_worker_context            (void);
 gboolean                g_check_setuid                  (void);
@@ -57,6 +58,16 @@ typedef struct {
                                                          guint        flags);
   GDir *                (* g_dir_new_from_dirp)         (gpointer dirp);
 
+  /* See gtracebuffer.c */
+  gboolean              (* g_trace_buffer_enabled)      (void);
+  void                  (* g_trace_buffer_record)       (GTraceEventType  type,
+                                                         GTracePhase      phase,
+                                                         const gchar     *name,
+                                                         gconstpointer    object,
+                                                         gint64           arg);
+  gboolean              (* g_trace_buffer_dump)         (const gchar     *filename,
+                                                         GError         **error);
+
   /* Add other private functions here, initialize them in glib-private.c */
 } GLibPrivateVTable;
 
@@ -153,12 +153,14 @@ g_unix_set_fd_nonblocking (gint       fd,
                            GError   **error)
 {
 #ifdef F_GETFL
-  glong fcntl_flags;
+  glong fcntl_flags, old_flags;
   fcntl_flags = fcntl (fd, F_GETFL);
 
   if (fcntl_flags == -1)
     return g_unix_set_error_from_errno (error, errno);
 
+  old_flags = fcntl_flags;
+
   if (nonblock)
     {
 #ifdef O_NONBLOCK
@@ -176,6 +178,11 @@ g_unix_set_fd_nonblocking (gint       fd,
 #endif
     }
 
+  /* Avoid a syscall if the flags are already what we want, which is
+   * common for sockets created with SOCK_NONBLOCK. */
+  if (fcntl_flags == old_flags)
+    return TRUE;
+
   if (fcntl (fd, F_SETFL, fcntl_flags) == -1)
     return g_unix_set_error_from_errno (error, errno);
   return TRUE;
@@ -30,6 +30,7 @@
 #define __GLIB_H_INSIDE__
 
 #include <glib/galloca.h>
+#include <glib/garena.h>
 #include <glib/garray.h>
 #include <glib/gasyncqueue.h>
 #include <glib/gatomic.h>
@@ -38,6 +39,7 @@
 #include <glib/gbitlock.h>
 #include <glib/gbookmarkfile.h>
 #include <glib/gbytes.h>
+#include <glib/gbyteslist.h>
 #include <glib/gcharset.h>
 #include <glib/gchecksum.h>
 #include <glib/gconvert.h>
@@ -53,6 +53,15 @@
 #ifdef HAVE_EVENTFD
 #include <sys/eventfd.h>
 #endif
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_TIMERFD
+#include <sys/timerfd.h>
+#endif
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
 #endif
 
 #include <signal.h>
@@ -100,6 +109,7 @@
 #include "gmain-internal.h"
 #include "glib-init.h"
 #include "glib-private.h"
+#include "gthreadprivate.h"
 
 /**
  * SECTION:main
@@ -187,13 +197,18 @@ typedef struct _GTimeoutSource GTimeoutSource;
 typedef struct _GChildWatchSource GChildWatchSource;
 typedef struct _GUnixSignalWatchSource GUnixSignalWatchSource;
 typedef struct _GPollRec GPollRec;
+typedef struct _GEpollRec GEpollRec;
 typedef struct _GSourceCallback GSourceCallback;
+typedef struct _GMainInvocation GMainInvocation;
+typedef struct _GInvokeSource GInvokeSource;
 
 typedef enum
 {
   G_SOURCE_READY = 1 << G_HOOK_FLAG_USER_SHIFT,
   G_SOURCE_CAN_RECURSE = 1 << (G_HOOK_FLAG_USER_SHIFT + 1),
-  G_SOURCE_BLOCKED = 1 << (G_HOOK_FLAG_USER_SHIFT + 2)
+  G_SOURCE_BLOCKED = 1 << (G_HOOK_FLAG_USER_SHIFT + 2),
+  G_SOURCE_DEFERRED = 1 << (G_HOOK_FLAG_USER_SHIFT + 3),
+  G_SOURCE_SECONDS = 1 << (G_HOOK_FLAG_USER_SHIFT + 4)
 } GSourceFlags;
 
 typedef struct _GSourceList GSourceList;
@@ -202,6 +217,13 @@ struct _GSourceList
 {
   GSource *head, *tail;
   gint priority;
+
+  /* The check pass only walks the lists that have sources with a check
+   * function, or that were flagged as possibly holding a ready source
+   * (see g_source_list_mark()) since it last went all the way through.
+   */
+  guint n_check_funcs;
+  gboolean maybe_ready;
 };
 
 typedef struct _GMainWaiter GMainWaiter;
@@ -240,6 +262,14 @@ struct _GMainContext
   GPtrArray *pending_dispatches;
   gint timeout;			/* Timeout for current iteration */
 
+  /* Sources which were ready but left over once the dispatch budget
+   * ran out; they are dispatched first on the next iteration.
+   */
+  GPtrArray *deferred_dispatches;
+  guint max_dispatches;
+  gint64 max_dispatch_time;
+  guint64 n_deferred_dispatches;
+
   guint next_id;
   GHashTable *overflow_used_source_ids; /* set<guint> */
   GList *source_lists;
@@ -261,6 +291,69 @@ struct _GMainContext
 
   gint64   time;
   gboolean time_is_fresh;
+
+  /* A CLOCK_MONOTONIC_COARSE reading, for the seconds timeouts; see
+   * g_source_get_coarse_time().
+   */
+  gint64   coarse_time;
+  gboolean coarse_time_is_fresh;
+
+  GMainContextFlags flags;
+
+  gboolean statistics_enabled;
+
+  /* Stall watchdog, see g_main_context_set_watchdog().  The thread
+   * samples watchdog_source/watchdog_start under the lock; the serial
+   * tells it whether the callback it already reported is still the
+   * one running.
+   */
+  guint watchdog_threshold;         /* milliseconds, 0 if disabled */
+  GThread *watchdog_thread;
+  GCond watchdog_cond;
+  GSource *watchdog_source;
+  const gchar *watchdog_phase;
+  gint64 watchdog_start;
+  guint64 watchdog_serial;
+  guint64 watchdog_reported_serial;
+  guint64 n_stalls;
+#ifdef G_OS_UNIX
+  pthread_t watchdog_owner;
+#endif
+
+  /* Binary min-heap of the attached sources with a ready time, ordered
+   * by that ready time.  Each source knows its own position in it
+   * (GSourcePrivate.timer_heap_index) so it can be moved or removed in
+   * O(log n).
+   */
+  GPtrArray *timer_heap;
+
+  /* The same for the timeouts made by g_timeout_source_new_seconds() */
+  GPtrArray *seconds_heap;
+
+#ifdef HAVE_TIMERFD
+  /* One-shot timerfd armed at the next seconds timeout, so that those
+   * don't count towards the poll timeout.  Created on first use.
+   */
+  GPollFD seconds_timer_rec;
+  gint64 seconds_timer_deadline;
+  gboolean seconds_timer_failed;
+#endif
+
+  /* One GInvokeSource per priority used with g_main_context_invoke_full()
+   * from other threads.  Only ever prepended to (under the lock), so it
+   * can be walked without the lock.
+   */
+  GInvokeSource * volatile invoke_sources;
+
+#ifdef HAVE_EPOLL_CREATE1
+  /* Persistent epoll set mirroring poll_records, or -1 if unused */
+  gint epoll_fd;
+  GHashTable *epoll_records;          /* fd -> GEpollRec */
+  GSList *epoll_unpollable;           /* GEpollRec refused by epoll_ctl() */
+  GPtrArray *epoll_ready;             /* GPollRec with revents set */
+  struct epoll_event *epoll_events;
+  guint epoll_events_size;
+#endif
 };
 
 struct _GSourceCallback
@@ -278,6 +371,25 @@ struct _GMainLoop
   gint ref_count;
 };
 
+struct _GMainInvocation
+{
+  GSourceFunc      function;
+  gpointer         data;
+  GDestroyNotify   notify;
+  GMainInvocation *next;
+};
+
+struct _GInvokeSource
+{
+  GSource          source;
+  /* Pushed onto by any thread, newest first, without taking any lock */
+  GMainInvocation * volatile incoming;
+  /* Oldest first; only touched from the dispatch function */
+  GMainInvocation *pending_head;
+  GMainInvocation *pending_tail;
+  GInvokeSource   *next;
+};
+
 struct _GTimeoutSource
 {
   GSource     source;
@@ -310,6 +422,20 @@ struct _GPollRec
   GPollRec *prev;
   GPollRec *next;
   gint priority;
+  GSource *source;      /* owner of a g_source_add_unix_fd() fd, or NULL */
+};
+
+/* One per distinct fd number in an epoll-backed context: the kernel
+ * only lets us register each fd once, so the GPollRecs sharing it are
+ * merged here.
+ */
+struct _GEpollRec
+{
+  gint fd;
+  gushort events;            /* events currently registered, or for
+                              * unpollable fds, the events requested */
+  gushort unpollable_revents; /* non-zero if epoll_ctl() refused the fd */
+  GSList *poll_records;
 };
 
 struct _GSourcePrivate
@@ -318,6 +444,12 @@ struct _GSourcePrivate
   GSource *parent_source;
 
   gint64 ready_time;
+  guint timer_heap_index;       /* 1-based; 0 if not in the timer heap */
+
+  /* Only used while statistics are enabled on the context */
+  GSourceStatistics *statistics;
+  gint64 ready_since;
+  gint64 last_dispatch_end;
 
   /* This is currently only used on UNIX, but we always declare it (and
    * let it remain empty on Windows) to avoid #ifdef all over the place.
@@ -329,6 +461,7 @@ typedef struct _GSourceIter
 {
   GMainContext *context;
   gboolean may_modify;
+  gboolean skip_idle_lists;
   GList *current_list;
   GSource *source;
 } GSourceIter;
@@ -348,6 +481,16 @@ typedef struct _GSourceIter
       g_source_unref_internal ((source), (context), TRUE);  \
    } G_STMT_END
 
+/* Brackets a prepare, check or dispatch callback for the stall
+ * watchdog.  HOLDS: context's lock
+ */
+#define WATCHDOG_ENTER(context, source, phase)                      \
+   G_STMT_START {                                                   \
+    if (G_UNLIKELY ((context)->watchdog_threshold != 0))            \
+      g_main_context_watchdog_enter ((context), (source), (phase)); \
+   } G_STMT_END
+#define WATCHDOG_LEAVE(context) ((context)->watchdog_source = NULL)
+
 
 /* Forward declarations */
 
@@ -370,9 +513,36 @@ static void g_main_context_poll                 (GMainContext *context,
 						 gint          n_fds);
 static void g_main_context_add_poll_unlocked    (GMainContext *context,
 						 gint          priority,
-						 GPollFD      *fd);
+						 GPollFD      *fd,
+						 GSource      *source);
 static void g_main_context_remove_poll_unlocked (GMainContext *context,
 						 GPollFD      *fd);
+static void g_source_record_dispatch            (GSource      *source,
+						 gint64        dispatch_start,
+						 gint64        dispatch_end);
+static gboolean g_main_context_budget_exhausted (GMainContext *context,
+						 guint         n_dispatched,
+						 gint64        budget_start);
+static void g_main_context_defer_from           (GMainContext *context,
+						 guint         first);
+static void g_main_context_take_deferred        (GMainContext *context);
+static void g_main_context_watchdog_enter       (GMainContext *context,
+						 GSource      *source,
+						 const gchar  *phase);
+static void g_main_context_stop_watchdog        (GMainContext *context);
+static gboolean g_main_context_check_sources    (GMainContext *context,
+						 gint          max_priority);
+static void     timer_heap_update               (GMainContext *context,
+						 GSource      *source);
+static void     timer_heap_remove               (GMainContext *context,
+						 GSource      *source);
+#ifdef HAVE_EPOLL_CREATE1
+static void     g_main_context_epoll_update     (GMainContext *context,
+						 gint          fd);
+static gboolean g_main_context_epoll_poll       (GMainContext *context,
+						 gboolean      block,
+						 gint          max_priority);
+#endif
 
 static void     g_source_iter_init  (GSourceIter   *iter,
 				     GMainContext  *context,
@@ -401,6 +571,10 @@ static gboolean g_unix_signal_watch_dispatch (GSource     *source,
 					      gpointer     user_data);
 static void     g_unix_signal_watch_finalize  (GSource     *source);
 #endif
+static gboolean g_invoke_dispatch  (GSource     *source,
+				    GSourceFunc  callback,
+				    gpointer     user_data);
+static void     g_invoke_finalize  (GSource     *source);
 static gboolean g_idle_prepare     (GSource     *source,
 				    gint        *timeout);
 static gboolean g_idle_check       (GSource     *source);
@@ -462,6 +636,14 @@ GSourceFuncs g_child_watch_funcs =
   g_child_watch_finalize
 };
 
+static GSourceFuncs g_invoke_funcs =
+{
+  NULL, /* prepare */
+  NULL, /* check */
+  g_invoke_dispatch,
+  g_invoke_finalize
+};
+
 GSourceFuncs g_idle_funcs =
 {
   g_idle_prepare,
@@ -489,6 +671,44 @@ g_main_context_ref (GMainContext *context)
   return context;
 }
 
+/* The context caches its clock readings until it next polls, since
+ * sources look at the time over and over again in between.
+ */
+static inline void
+g_main_context_expire_time (GMainContext *context)
+{
+  context->time_is_fresh = FALSE;
+  context->coarse_time_is_fresh = FALSE;
+}
+
+static inline gint64
+g_main_context_get_time_unlocked (GMainContext *context)
+{
+  if (!context->time_is_fresh)
+    {
+      context->time = g_get_monotonic_time ();
+      context->time_is_fresh = TRUE;
+    }
+
+  return context->time;
+}
+
+static inline gint64
+g_main_context_get_coarse_time_unlocked (GMainContext *context)
+{
+  /* A fine reading that is already there is as cheap and better */
+  if (context->time_is_fresh)
+    return context->time;
+
+  if (!context->coarse_time_is_fresh)
+    {
+      context->coarse_time = g_get_coarse_monotonic_time ();
+      context->coarse_time_is_fresh = TRUE;
+    }
+
+  return context->coarse_time;
+}
+
 static inline void
 poll_rec_list_free (GMainContext *context,
 		    GPollRec     *list)
@@ -510,6 +730,7 @@ g_main_context_unref (GMainContext *context)
   GSource *source;
   GList *sl_iter;
   GSourceList *list;
+  guint i;
 
   g_return_if_fail (context != NULL);
   g_return_if_fail (g_atomic_int_get (&context->ref_count) > 0); 
@@ -521,6 +742,8 @@ g_main_context_unref (GMainContext *context)
   main_context_list = g_slist_remove (main_context_list, context);
   G_UNLOCK (main_context_list);
 
+  g_main_context_stop_watchdog (context);
+
   /* g_source_iter_next() assumes the context is locked. */
   LOCK_CONTEXT (context);
   g_source_iter_init (&iter, context, TRUE);
@@ -529,8 +752,20 @@ g_main_context_unref (GMainContext *context)
       source->context = NULL;
       g_source_destroy_internal (source, context, TRUE);
     }
+
+  for (i = 0; i < context->deferred_dispatches->len; i++)
+    g_source_unref_internal (context->deferred_dispatches->pdata[i], context, TRUE);
+  g_ptr_array_set_size (context->deferred_dispatches, 0);
   UNLOCK_CONTEXT (context);
 
+  while (context->invoke_sources)
+    {
+      GInvokeSource *invoke_source = context->invoke_sources;
+
+      context->invoke_sources = invoke_source->next;
+      g_source_unref ((GSource *) invoke_source);
+    }
+
   for (sl_iter = context->source_lists; sl_iter; sl_iter = sl_iter->next)
     {
       list = sl_iter->data;
@@ -544,12 +779,32 @@ g_main_context_unref (GMainContext *context)
   g_mutex_clear (&context->mutex);
 
   g_ptr_array_free (context->pending_dispatches, TRUE);
+  g_ptr_array_free (context->deferred_dispatches, TRUE);
+  g_ptr_array_free (context->timer_heap, TRUE);
+  g_ptr_array_free (context->seconds_heap, TRUE);
   g_free (context->cached_poll_array);
 
   poll_rec_list_free (context, context->poll_records);
 
+#ifdef HAVE_TIMERFD
+  if (context->seconds_timer_rec.fd >= 0)
+    close (context->seconds_timer_rec.fd);
+#endif
+
+#ifdef HAVE_EPOLL_CREATE1
+  if (context->epoll_fd >= 0)
+    {
+      close (context->epoll_fd);
+      g_hash_table_destroy (context->epoll_records);
+      g_slist_free (context->epoll_unpollable);
+      g_ptr_array_free (context->epoll_ready, TRUE);
+      g_free (context->epoll_events);
+    }
+#endif
+
   g_wakeup_free (context->wakeup);
   g_cond_clear (&context->cond);
+  g_cond_clear (&context->watchdog_cond);
 
   g_free (context);
 }
@@ -575,6 +830,51 @@ g_main_context_new_with_next_id (guint next_id)
  **/
 GMainContext *
 g_main_context_new (void)
+{
+  return g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_NONE);
+}
+
+#ifdef HAVE_EPOLL_CREATE1
+static void
+epoll_rec_free (gpointer data)
+{
+  GEpollRec *erec = data;
+
+  g_slist_free (erec->poll_records);
+  g_slice_free (GEpollRec, erec);
+}
+#endif
+
+/**
+ * g_main_context_new_with_flags:
+ * @flags: a bitwise-OR combination of #GMainContextFlags flags that can only be
+ *         set at creation time.
+ *
+ * Creates a new #GMainContext structure.
+ *
+ * If @flags contains %G_MAIN_CONTEXT_FLAGS_EPOLL and the platform
+ * supports it, the file descriptors of the context are kept registered
+ * in an epoll set for the lifetime of the context, so that an iteration
+ * costs time proportional to the number of ready file descriptors rather
+ * than to the number of watched ones.  This is only used while the
+ * default poll function is in effect; after a call to
+ * g_main_context_set_poll_func() (and for external users of
+ * g_main_context_query() and g_main_context_check()) the context behaves
+ * exactly as one made with g_main_context_new().
+ *
+ * With the epoll backend, changes to the events of a file descriptor
+ * are only noticed if they are made through g_source_modify_unix_fd(),
+ * or by removing and re-adding the #GPollFD; modifying
+ * <literal>events</literal> of a #GPollFD behind GLib's back is not
+ * supported.  The epoll set is shared with a child after fork(), so the
+ * child must not use such a context.
+ *
+ * Return value: the new #GMainContext
+ *
+ * Since: 2.40
+ **/
+GMainContext *
+g_main_context_new_with_flags (GMainContextFlags flags)
 {
   static gsize initialised;
   GMainContext *context;
@@ -593,6 +893,7 @@ g_main_context_new (void)
 
   g_mutex_init (&context->mutex);
   g_cond_init (&context->cond);
+  g_cond_init (&context->watchdog_cond);
 
   context->owner = NULL;
   context->waiters = NULL;
@@ -609,12 +910,36 @@ g_main_context_new (void)
   context->cached_poll_array_size = 0;
   
   context->pending_dispatches = g_ptr_array_new ();
+  context->deferred_dispatches = g_ptr_array_new ();
+  context->timer_heap = g_ptr_array_new ();
+  context->seconds_heap = g_ptr_array_new ();
   
-  context->time_is_fresh = FALSE;
+  g_main_context_expire_time (context);
+
+  context->flags = flags;
+
+#ifdef HAVE_TIMERFD
+  context->seconds_timer_rec.fd = -1;
+  context->seconds_timer_deadline = -1;
+#endif
+
+#ifdef HAVE_EPOLL_CREATE1
+  context->epoll_fd = -1;
+  if (flags & G_MAIN_CONTEXT_FLAGS_EPOLL)
+    {
+      /* If this fails we silently fall back to poll() */
+      context->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+      if (context->epoll_fd >= 0)
+        {
+          context->epoll_records = g_hash_table_new_full (NULL, NULL, NULL, epoll_rec_free);
+          context->epoll_ready = g_ptr_array_new ();
+        }
+    }
+#endif
   
   context->wakeup = g_wakeup_new ();
   g_wakeup_get_pollfd (context->wakeup, &context->wake_up_rec);
-  g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec);
+  g_main_context_add_poll_unlocked (context, 0, &context->wake_up_rec, NULL);
 
   G_LOCK (main_context_list);
   main_context_list = g_slist_append (main_context_list, context);
@@ -676,7 +1001,7 @@ free_context_stack (gpointer data)
   g_queue_free_full((GQueue *) data, (GDestroyNotify) free_context);
 }
 
-static GPrivate thread_context_stack = G_PRIVATE_INIT (free_context_stack);
+G_PRIVATE_TLS_DEFINE_STATIC (GQueue *, thread_context_stack, free_context_stack)
 
 /**
  * g_main_context_push_thread_default:
@@ -727,11 +1052,11 @@ g_main_context_push_thread_default (GMainContext *context)
   else if (context)
     g_main_context_ref (context);
 
-  stack = g_private_get (&thread_context_stack);
+  stack = thread_context_stack_get ();
   if (!stack)
     {
       stack = g_queue_new ();
-      g_private_set (&thread_context_stack, stack);
+      thread_context_stack_set (stack);
     }
 
   g_queue_push_head (stack, context);
@@ -754,7 +1079,7 @@ g_main_context_pop_thread_default (GMainContext *context)
   if (context == g_main_context_default ())
     context = NULL;
 
-  stack = g_private_get (&thread_context_stack);
+  stack = thread_context_stack_get ();
 
   g_return_if_fail (stack != NULL);
   g_return_if_fail (g_queue_peek_head (stack) == context);
@@ -791,7 +1116,7 @@ g_main_context_get_thread_default (void)
 {
   GQueue *stack;
 
-  stack = g_private_get (&thread_context_stack);
+  stack = thread_context_stack_get ();
   if (stack)
     return g_queue_peek_head (stack);
   else
@@ -878,6 +1203,7 @@ g_source_iter_init (GSourceIter  *iter,
   iter->current_list = NULL;
   iter->source = NULL;
   iter->may_modify = may_modify;
+  iter->skip_idle_lists = FALSE;
 }
 
 /* Holds context's lock */
@@ -894,10 +1220,28 @@ g_source_iter_next (GSourceIter *iter, GSource **source)
   if (!next_source)
     {
       if (iter->current_list)
-	iter->current_list = iter->current_list->next;
+        {
+          if (iter->skip_idle_lists)
+            ((GSourceList *) iter->current_list->data)->maybe_ready = FALSE;
+
+          iter->current_list = iter->current_list->next;
+        }
       else
 	iter->current_list = iter->context->source_lists;
 
+      if (iter->skip_idle_lists)
+        {
+          while (iter->current_list)
+            {
+              GSourceList *source_list = iter->current_list->data;
+
+              if (source_list->n_check_funcs > 0 || source_list->maybe_ready)
+                break;
+
+              iter->current_list = iter->current_list->next;
+            }
+        }
+
       if (iter->current_list)
 	{
 	  GSourceList *source_list = iter->current_list->data;
@@ -985,6 +1329,37 @@ find_source_list_for_priority (GMainContext *context,
   return source_list;
 }
 
+/* Holds context's lock
+ *
+ * Makes sure the next check pass looks at the priority list of @source.
+ */
+static void
+g_source_list_mark (GMainContext *context,
+                    GSource      *source)
+{
+  GSourceList *source_list;
+
+  source_list = find_source_list_for_priority (context, source->priority, FALSE);
+  if (source_list)
+    source_list->maybe_ready = TRUE;
+}
+
+/* Holds context's lock
+ *
+ * Flags @source and its ancestors as ready.
+ */
+static void
+g_source_mark_ready (GMainContext *context,
+                     GSource      *source)
+{
+  while (source)
+    {
+      source->flags |= G_SOURCE_READY;
+      g_source_list_mark (context, source);
+      source = source->priv->parent_source;
+    }
+}
+
 /* Holds context's lock
  */
 static void
@@ -995,6 +1370,10 @@ source_add_to_context (GSource      *source,
   GSource *prev, *next;
 
   source_list = find_source_list_for_priority (context, source->priority, TRUE);
+  if (source->source_funcs->check)
+    source_list->n_check_funcs++;
+  /* It may already have been flagged ready, eg. before a priority change */
+  source_list->maybe_ready = TRUE;
 
   if (source->priv->parent_source)
     {
@@ -1034,6 +1413,9 @@ source_remove_from_context (GSource      *source,
   source_list = find_source_list_for_priority (context, source->priority, FALSE);
   g_return_if_fail (source_list != NULL);
 
+  if (source->source_funcs->check)
+    source_list->n_check_funcs--;
+
   if (source->prev)
     source->prev->next = source->next;
   else
@@ -1119,18 +1501,19 @@ g_source_attach_unlocked (GSource      *source,
   assign_source_id_unlocked (context, source);
   source->ref_count++;
   source_add_to_context (source, context);
+  timer_heap_update (context, source);
 
   if (!SOURCE_BLOCKED (source))
     {
       tmp_list = source->poll_fds;
       while (tmp_list)
         {
-          g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data);
+          g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data, NULL);
           tmp_list = tmp_list->next;
         }
 
       for (tmp_list = source->priv->fds; tmp_list; tmp_list = tmp_list->next)
-        g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data);
+        g_main_context_add_poll_unlocked (context, source->priority, tmp_list->data, source);
     }
 
   tmp_list = source->priv->child_sources;
@@ -1196,6 +1579,7 @@ g_source_destroy_internal (GSource      *source,
       GSourceCallbackFuncs *old_cb_funcs;
       
       source->flags &= ~G_HOOK_FLAG_ACTIVE;
+      timer_heap_remove (context, source);
 
       old_cb_data = source->callback_data;
       old_cb_funcs = source->callback_funcs;
@@ -1346,7 +1730,7 @@ g_source_add_poll (GSource *source,
   if (context)
     {
       if (!SOURCE_BLOCKED (source))
-	g_main_context_add_poll_unlocked (context, source->priority, fd);
+	g_main_context_add_poll_unlocked (context, source->priority, fd, NULL);
       UNLOCK_CONTEXT (context);
     }
 }
@@ -1660,7 +2044,7 @@ g_source_set_priority_unlocked (GSource      *source,
 	  while (tmp_list)
 	    {
 	      g_main_context_remove_poll_unlocked (context, tmp_list->data);
-	      g_main_context_add_poll_unlocked (context, priority, tmp_list->data);
+	      g_main_context_add_poll_unlocked (context, priority, tmp_list->data, NULL);
 	      
 	      tmp_list = tmp_list->next;
 	    }
@@ -1668,7 +2052,7 @@ g_source_set_priority_unlocked (GSource      *source,
           for (tmp_list = source->priv->fds; tmp_list; tmp_list = tmp_list->next)
             {
               g_main_context_remove_poll_unlocked (context, tmp_list->data);
-              g_main_context_add_poll_unlocked (context, priority, tmp_list->data);
+              g_main_context_add_poll_unlocked (context, priority, tmp_list->data, source);
             }
 	}
     }
@@ -1773,6 +2157,9 @@ g_source_set_ready_time (GSource *source,
 
   if (context)
     {
+      if (!SOURCE_DESTROYED (source))
+        timer_heap_update (context, source);
+
       /* Quite likely that we need to change the timeout on the poll */
       if (!SOURCE_BLOCKED (source))
         g_wakeup_signal (context->wakeup);
@@ -1987,6 +2374,7 @@ g_source_unref_internal (GSource      *source,
 	{
 	  if (!SOURCE_DESTROYED (source))
 	    g_warning (G_STRLOC ": ref_count == 0, but source was still attached to a context!");
+	  timer_heap_remove (context, source);
 	  source_remove_from_context (source, context);
 	}
 
@@ -2007,6 +2395,9 @@ g_source_unref_internal (GSource      *source,
 
       g_slist_free_full (source->priv->fds, g_free);
 
+      if (source->priv->statistics)
+        g_slice_free (GSourceStatistics, source->priv->statistics);
+
       g_slice_free (GSourcePrivate, source->priv);
       source->priv = NULL;
 
@@ -2313,7 +2704,7 @@ g_source_add_unix_fd (GSource      *source,
   if (context)
     {
       if (!SOURCE_BLOCKED (source))
-        g_main_context_add_poll_unlocked (context, source->priority, poll_fd);
+        g_main_context_add_poll_unlocked (context, source->priority, poll_fd, source);
       UNLOCK_CONTEXT (context);
     }
 
@@ -2354,7 +2745,17 @@ g_source_modify_unix_fd (GSource      *source,
   poll_fd->events = new_events;
 
   if (context)
-    g_main_context_wakeup (context);
+    {
+#ifdef HAVE_EPOLL_CREATE1
+      if (context->epoll_fd >= 0)
+        {
+          LOCK_CONTEXT (context);
+          g_main_context_epoll_update (context, poll_fd->fd);
+          UNLOCK_CONTEXT (context);
+        }
+#endif
+      g_main_context_wakeup (context);
+    }
 }
 
 /**
@@ -2698,6 +3099,36 @@ g_get_monotonic_time (void)
 #endif
 }
 
+/**
+ * g_get_coarse_monotonic_time:
+ *
+ * Queries the same clock as g_get_monotonic_time(), but is allowed to
+ * return a value that lags behind by up to one tick of the kernel's
+ * timer interrupt (a few milliseconds).
+ *
+ * On Linux, this reads <literal>CLOCK_MONOTONIC_COARSE</literal>,
+ * which is considerably cheaper than a precise reading.  Elsewhere it
+ * is the same as g_get_monotonic_time().  That makes it a good fit for
+ * timeouts with a granularity of seconds, such as those created by
+ * g_timeout_add_seconds(); see also g_source_get_coarse_time().
+ *
+ * Returns: the monotonic time, in microseconds
+ *
+ * Since: 2.40
+ **/
+gint64
+g_get_coarse_monotonic_time (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC) && defined (CLOCK_MONOTONIC_COARSE)
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_MONOTONIC_COARSE, &ts) == 0)
+    return (((gint64) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+#endif
+
+  return g_get_monotonic_time ();
+}
+
 static void
 g_main_dispatch_free (gpointer dispatch)
 {
@@ -2706,18 +3137,19 @@ g_main_dispatch_free (gpointer dispatch)
 
 /* Running the main loop */
 
+G_PRIVATE_TLS_DEFINE_STATIC (GMainDispatch *, main_dispatch, g_main_dispatch_free)
+
 static GMainDispatch *
 get_dispatch (void)
 {
-  static GPrivate depth_private = G_PRIVATE_INIT (g_main_dispatch_free);
   GMainDispatch *dispatch;
 
-  dispatch = g_private_get (&depth_private);
+  dispatch = main_dispatch_get ();
 
   if (!dispatch)
     {
       dispatch = g_slice_new0 (GMainDispatch);
-      g_private_set (&depth_private, dispatch);
+      main_dispatch_set (dispatch);
     }
 
   return dispatch;
@@ -2985,16 +3417,17 @@ unblock_source (GSource *source)
   g_return_if_fail (!SOURCE_DESTROYED (source));
   
   source->flags &= ~G_SOURCE_BLOCKED;
+  g_source_list_mark (source->context, source);
 
   tmp_list = source->poll_fds;
   while (tmp_list)
     {
-      g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data);
+      g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data, NULL);
       tmp_list = tmp_list->next;
     }
 
   for (tmp_list = source->priv->fds; tmp_list; tmp_list = tmp_list->next)
-    g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data);
+    g_main_context_add_poll_unlocked (source->context, source->priority, tmp_list->data, source);
 
   if (source->priv && source->priv->child_sources)
     {
@@ -3012,12 +3445,25 @@ static void
 g_main_dispatch (GMainContext *context)
 {
   GMainDispatch *current = get_dispatch ();
+  gint64 budget_start = 0;
   guint i;
 
+  if (context->deferred_dispatches->len > 0)
+    g_main_context_take_deferred (context);
+
+  if (context->max_dispatch_time > 0)
+    budget_start = g_get_monotonic_time ();
+
   for (i = 0; i < context->pending_dispatches->len; i++)
     {
       GSource *source = context->pending_dispatches->pdata[i];
 
+      if (i > 0 && g_main_context_budget_exhausted (context, i, budget_start))
+        {
+          g_main_context_defer_from (context, i);
+          break;
+        }
+
       context->pending_dispatches->pdata[i] = NULL;
       g_assert (source);
 
@@ -3036,6 +3482,7 @@ g_main_dispatch (GMainContext *context)
 				GSourceFunc,
 				gpointer);
           GSource *prev_source;
+          gint64 dispatch_start = 0;
 
 	  dispatch = source->source_funcs->dispatch;
 	  cb_funcs = source->callback_funcs;
@@ -3053,6 +3500,14 @@ g_main_dispatch (GMainContext *context)
 	  if (cb_funcs)
 	    cb_funcs->get (cb_data, source, &callback, &user_data);
 
+          if (G_UNLIKELY (context->statistics_enabled))
+            dispatch_start = g_get_monotonic_time ();
+
+          if (G_UNLIKELY (g_trace_buffer_enabled ()))
+            g_trace_buffer_record (G_TRACE_EVENT_SOURCE_DISPATCH, G_TRACE_PHASE_BEGIN,
+                                   source->name, source, 0);
+
+          WATCHDOG_ENTER (context, source, "dispatch");
 	  UNLOCK_CONTEXT (context);
 
           /* These operations are safe because 'current' is thread-local
@@ -3071,10 +3526,18 @@ g_main_dispatch (GMainContext *context)
 	    cb_funcs->unref (cb_data);
 
  	  LOCK_CONTEXT (context);
+          WATCHDOG_LEAVE (context);
 	  
 	  if (!was_in_call)
 	    source->flags &= ~G_HOOK_FLAG_IN_CALL;
 
+          if (dispatch_start != 0)
+            g_source_record_dispatch (source, dispatch_start, g_get_monotonic_time ());
+
+          if (G_UNLIKELY (g_trace_buffer_enabled ()))
+            g_trace_buffer_record (G_TRACE_EVENT_SOURCE_DISPATCH, G_TRACE_PHASE_END,
+                                   source->name, source, 0);
+
 	  if (SOURCE_BLOCKED (source) && !SOURCE_DESTROYED (source))
 	    unblock_source (source);
 	  
@@ -3094,71 +3557,768 @@ g_main_dispatch (GMainContext *context)
   g_ptr_array_set_size (context->pending_dispatches, 0);
 }
 
-/**
- * g_main_context_acquire:
- * @context: a #GMainContext
- * 
- * Tries to become the owner of the specified context.
- * If some other thread is the owner of the context,
- * returns %FALSE immediately. Ownership is properly
- * recursive: the owner can require ownership again
- * and will release ownership when g_main_context_release()
- * is called as many times as g_main_context_acquire().
+/* Dispatch budget
  *
- * You must be the owner of a context before you
- * can call g_main_context_prepare(), g_main_context_query(),
- * g_main_context_check(), g_main_context_dispatch().
- * 
- * Return value: %TRUE if the operation succeeded, and
- *   this thread is now the owner of @context.
- **/
-gboolean 
-g_main_context_acquire (GMainContext *context)
+ * HOLDS: context's lock for all of these.
+ */
+static gboolean
+g_main_context_budget_exhausted (GMainContext *context,
+                                 guint         n_dispatched,
+                                 gint64        budget_start)
 {
-  gboolean result = FALSE;
-  GThread *self = G_THREAD_SELF;
+  if (context->max_dispatches > 0 && n_dispatched >= context->max_dispatches)
+    return TRUE;
 
-  if (context == NULL)
-    context = g_main_context_default ();
-  
-  LOCK_CONTEXT (context);
+  if (context->max_dispatch_time > 0 &&
+      g_get_monotonic_time () - budget_start >= context->max_dispatch_time)
+    return TRUE;
 
-  if (!context->owner)
+  return FALSE;
+}
+
+/* Moves the pending dispatches from @first on over to the deferred ones */
+static void
+g_main_context_defer_from (GMainContext *context,
+                           guint         first)
+{
+  guint i;
+
+  for (i = first; i < context->pending_dispatches->len; i++)
     {
-      context->owner = self;
-      g_assert (context->owner_count == 0);
+      GSource *source = context->pending_dispatches->pdata[i];
+
+      if (source == NULL)
+        continue;
+
+      context->pending_dispatches->pdata[i] = NULL;
+
+      /* It is dispatched only if the next check still finds it ready */
+      source->flags &= ~G_SOURCE_READY;
+      source->flags |= G_SOURCE_DEFERRED;
+      g_ptr_array_add (context->deferred_dispatches, source);
+
+      context->n_deferred_dispatches++;
+      if (G_UNLIKELY (context->statistics_enabled))
+        {
+          if (source->priv->statistics == NULL)
+            source->priv->statistics = g_slice_new0 (GSourceStatistics);
+          source->priv->statistics->n_deferrals++;
+        }
     }
+}
 
-  if (context->owner == self)
+/* Puts the deferred sources that check found ready again at the front
+ * of the pending dispatches, dropping the duplicates it added.  Those
+ * that check did not get to stay deferred; see
+ * g_main_context_check_sources().
+ */
+static void
+g_main_context_take_deferred (GMainContext *context)
+{
+  GPtrArray *pending = context->pending_dispatches;
+  GPtrArray *deferred = context->deferred_dispatches;
+  GPtrArray *dispatches;
+  guint i, n_left = 0;
+
+  dispatches = g_ptr_array_sized_new (deferred->len + pending->len);
+
+  for (i = 0; i < deferred->len; i++)
     {
-      context->owner_count++;
-      result = TRUE;
+      GSource *source = deferred->pdata[i];
+
+      if (source->flags & G_SOURCE_READY)
+        g_ptr_array_add (dispatches, source);
+      else
+        deferred->pdata[n_left++] = source;
     }
+  g_ptr_array_set_size (deferred, n_left);
 
-  UNLOCK_CONTEXT (context); 
-  
-  return result;
+  for (i = 0; i < pending->len; i++)
+    {
+      GSource *source = pending->pdata[i];
+
+      if (source == NULL)
+        continue;
+
+      if (source->flags & G_SOURCE_DEFERRED)
+        SOURCE_UNREF (source, context);
+      else
+        g_ptr_array_add (dispatches, source);
+    }
+
+  for (i = 0; i < dispatches->len; i++)
+    ((GSource *) dispatches->pdata[i])->flags &= ~G_SOURCE_DEFERRED;
+
+  context->pending_dispatches = dispatches;
+  g_ptr_array_free (pending, TRUE);
 }
 
 /**
- * g_main_context_release:
- * @context: a #GMainContext
- * 
- * Releases ownership of a context previously acquired by this thread
- * with g_main_context_acquire(). If the context was acquired multiple
- * times, the ownership will be released only when g_main_context_release()
- * is called as many times as it was acquired.
+ * g_main_context_set_dispatch_budget:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ * @max_dispatches: the maximum number of sources to dispatch per
+ *     iteration, or 0 for no limit
+ * @max_time: the time, in microseconds, after which no more sources are
+ *     dispatched in the same iteration, or 0 for no limit
+ *
+ * Limits the amount of work done by a single iteration of @context.
+ *
+ * Normally an iteration dispatches every ready source of the highest
+ * ready priority.  With a budget, it stops once @max_dispatches sources
+ * have been dispatched, or once dispatching has taken @max_time or
+ * more; at least one source is always dispatched.  The ready sources
+ * that are left over are carried to the next iteration, which doesn't
+ * block in poll() and dispatches those that are still ready before any
+ * newly ready sources.
+ *
+ * This keeps a flood of ready sources from holding up everything else
+ * for too long.  The number of times a source was left over is counted;
+ * see g_main_context_get_deferred_dispatches().
+ *
+ * Since: 2.40
  **/
 void
-g_main_context_release (GMainContext *context)
+g_main_context_set_dispatch_budget (GMainContext *context,
+                                    guint         max_dispatches,
+                                    gint64        max_time)
 {
-  if (context == NULL)
+  if (!context)
     context = g_main_context_default ();
-  
-  LOCK_CONTEXT (context);
 
-  context->owner_count--;
-  if (context->owner_count == 0)
+  g_return_if_fail (g_atomic_int_get (&context->ref_count) > 0);
+  g_return_if_fail (max_time >= 0);
+
+  LOCK_CONTEXT (context);
+  context->max_dispatches = max_dispatches;
+  context->max_dispatch_time = max_time;
+  UNLOCK_CONTEXT (context);
+}
+
+/**
+ * g_main_context_get_dispatch_budget:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ * @max_dispatches: (out) (allow-none): return location for the maximum
+ *     number of dispatches per iteration, or %NULL
+ * @max_time: (out) (allow-none): return location for the maximum
+ *     dispatch time per iteration, or %NULL
+ *
+ * Gets the dispatch budget set with g_main_context_set_dispatch_budget().
+ *
+ * Since: 2.40
+ **/
+void
+g_main_context_get_dispatch_budget (GMainContext *context,
+                                    guint        *max_dispatches,
+                                    gint64       *max_time)
+{
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_if_fail (g_atomic_int_get (&context->ref_count) > 0);
+
+  LOCK_CONTEXT (context);
+  if (max_dispatches)
+    *max_dispatches = context->max_dispatches;
+  if (max_time)
+    *max_time = context->max_dispatch_time;
+  UNLOCK_CONTEXT (context);
+}
+
+/**
+ * g_main_context_get_deferred_dispatches:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ *
+ * Gets the number of times a ready source of @context was carried over
+ * to the next iteration because the dispatch budget set with
+ * g_main_context_set_dispatch_budget() ran out.  The same count is
+ * kept per source as part of its #GSourceStatistics while statistics
+ * are enabled.
+ *
+ * Returns: the number of deferred dispatches since @context was created
+ *
+ * Since: 2.40
+ **/
+guint64
+g_main_context_get_deferred_dispatches (GMainContext *context)
+{
+  guint64 result;
+
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_val_if_fail (g_atomic_int_get (&context->ref_count) > 0, 0);
+
+  LOCK_CONTEXT (context);
+  result = context->n_deferred_dispatches;
+  UNLOCK_CONTEXT (context);
+
+  return result;
+}
+
+#if defined (G_OS_UNIX) && defined (HAVE_EXECINFO_H) && defined (SIGRTMIN)
+#define G_MAIN_WATCHDOG_BACKTRACE
+
+static gboolean watchdog_backtrace_installed;
+
+/* Runs in the thread that owns the stalled callback */
+static void
+watchdog_backtrace_handler (int signum)
+{
+  static const char header[] = "GLib: backtrace of the stalled thread:\n";
+  gpointer frames[64];
+  int n_frames;
+  int errsv = errno;
+
+  if (write (STDERR_FILENO, header, sizeof header - 1) < 0)
+    goto out;
+
+  n_frames = backtrace (frames, G_N_ELEMENTS (frames));
+  backtrace_symbols_fd (frames, n_frames, STDERR_FILENO);
+
+ out:
+  errno = errsv;
+}
+
+static void
+watchdog_backtrace_init (void)
+{
+  static gsize initialised;
+
+  if (g_once_init_enter (&initialised))
+    {
+      struct sigaction action, old_action;
+      gpointer frame;
+
+      /* Loads the unwinder now: it may allocate, which must not
+       * happen for the first time inside the signal handler.
+       */
+      backtrace (&frame, 1);
+
+      /* Don't take the signal away from the application */
+      if (sigaction (SIGRTMIN, NULL, &old_action) == 0 &&
+          old_action.sa_handler == SIG_DFL)
+        {
+          memset (&action, 0, sizeof action);
+          action.sa_handler = watchdog_backtrace_handler;
+          action.sa_flags = SA_RESTART;
+          sigemptyset (&action.sa_mask);
+          watchdog_backtrace_installed = sigaction (SIGRTMIN, &action, NULL) == 0;
+        }
+
+      g_once_init_leave (&initialised, 1);
+    }
+}
+#endif
+
+/* HOLDS: context's lock */
+static void
+g_main_context_watchdog_enter (GMainContext *context,
+                               GSource      *source,
+                               const gchar  *phase)
+{
+  context->watchdog_source = source;
+  context->watchdog_phase = phase;
+  context->watchdog_start = g_get_monotonic_time ();
+  context->watchdog_serial++;
+#ifdef G_OS_UNIX
+  context->watchdog_owner = pthread_self ();
+#endif
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_watchdog_report (GMainContext *context,
+                                gint64        elapsed)
+{
+  GSource *source = context->watchdog_source;
+  const gchar *phase = context->watchdog_phase;
+  guint64 serial = context->watchdog_serial;
+  gchar *name;
+
+  context->watchdog_reported_serial = serial;
+  context->n_stalls++;
+
+  if (context->statistics_enabled)
+    {
+      if (source->priv->statistics == NULL)
+        source->priv->statistics = g_slice_new0 (GSourceStatistics);
+      source->priv->statistics->n_stalls++;
+    }
+
+  name = g_strdup (source->name ? source->name : "(unnamed)");
+
+  UNLOCK_CONTEXT (context);
+  g_printerr ("GLib: main context %p stalled: %s of source '%s' (%p) "
+              "has been running for %" G_GINT64_FORMAT " ms\n",
+              context, phase, name, source, elapsed / 1000);
+  g_free (name);
+  LOCK_CONTEXT (context);
+
+#ifdef G_MAIN_WATCHDOG_BACKTRACE
+  /* The owner can't leave the callback without the lock, so as long
+   * as it is still in the same one the thread is certainly alive.
+   */
+  if (watchdog_backtrace_installed &&
+      context->watchdog_source != NULL &&
+      context->watchdog_serial == serial)
+    pthread_kill (context->watchdog_owner, SIGRTMIN);
+#endif
+}
+
+static gpointer
+g_main_context_watchdog_thread (gpointer data)
+{
+  GMainContext *context = data;
+
+  LOCK_CONTEXT (context);
+
+  /* Re-enabling the watchdog before this thread noticed it was
+   * disabled starts a new thread, so check for being the current one.
+   */
+  while (context->watchdog_thread == g_thread_self ())
+    {
+      gint64 threshold = context->watchdog_threshold * (gint64) 1000;
+      gint64 now = g_get_monotonic_time ();
+      gint64 deadline;
+
+      if (context->watchdog_source != NULL &&
+          context->watchdog_reported_serial != context->watchdog_serial)
+        {
+          if (now - context->watchdog_start >= threshold)
+            {
+              g_main_context_watchdog_report (context, now - context->watchdog_start);
+              continue;
+            }
+
+          deadline = context->watchdog_start + threshold;
+        }
+      else
+        {
+          /* Entering a callback doesn't wake us up, so a stall is
+           * noticed up to a quarter of the threshold late.
+           */
+          deadline = now + MAX (threshold / 4, 1000);
+        }
+
+      g_cond_wait_until (&context->watchdog_cond, &context->mutex, deadline);
+    }
+
+  UNLOCK_CONTEXT (context);
+
+  return NULL;
+}
+
+static void
+g_main_context_stop_watchdog (GMainContext *context)
+{
+  GThread *thread;
+
+  LOCK_CONTEXT (context);
+  thread = context->watchdog_thread;
+  context->watchdog_thread = NULL;
+  context->watchdog_threshold = 0;
+  g_cond_signal (&context->watchdog_cond);
+  UNLOCK_CONTEXT (context);
+
+  if (thread != NULL)
+    g_thread_join (thread);
+}
+
+/**
+ * g_main_context_set_watchdog:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ * @threshold_ms: the longest time, in milliseconds, a single prepare,
+ *     check or dispatch callback may run, or 0 to disable the watchdog
+ *
+ * Starts a watchdog thread that reports when a source of @context
+ * blocks its main loop: whenever one of its callbacks has been running
+ * for longer than @threshold_ms, the context, the phase and the name of
+ * the source (see g_source_set_name()) are printed to stderr.  Where
+ * supported, a backtrace of the thread running the callback follows,
+ * unless the application handles SIGRTMIN itself.
+ *
+ * Every callback is reported at most once.  The number of stalls is
+ * available from g_main_context_get_stalls() and, while statistics are
+ * enabled, per source as part of its #GSourceStatistics.
+ *
+ * This is a debugging aid: while it is enabled, each callback costs an
+ * extra g_get_monotonic_time() call.  The watchdog of a context is
+ * stopped when the context is finalized.
+ *
+ * Since: 2.40
+ **/
+void
+g_main_context_set_watchdog (GMainContext *context,
+                             guint         threshold_ms)
+{
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_if_fail (g_atomic_int_get (&context->ref_count) > 0);
+
+  if (threshold_ms == 0)
+    {
+      g_main_context_stop_watchdog (context);
+      return;
+    }
+
+#ifdef G_MAIN_WATCHDOG_BACKTRACE
+  watchdog_backtrace_init ();
+#endif
+
+  LOCK_CONTEXT (context);
+  context->watchdog_threshold = threshold_ms;
+  if (context->watchdog_thread == NULL)
+    context->watchdog_thread = g_thread_new ("gmain-watchdog",
+                                             g_main_context_watchdog_thread,
+                                             context);
+  g_cond_signal (&context->watchdog_cond);
+  UNLOCK_CONTEXT (context);
+}
+
+/**
+ * g_main_context_get_watchdog:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ *
+ * Gets the threshold set with g_main_context_set_watchdog().
+ *
+ * Returns: the threshold in milliseconds, or 0 if the watchdog is
+ *     disabled
+ *
+ * Since: 2.40
+ **/
+guint
+g_main_context_get_watchdog (GMainContext *context)
+{
+  guint result;
+
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_val_if_fail (g_atomic_int_get (&context->ref_count) > 0, 0);
+
+  LOCK_CONTEXT (context);
+  result = context->watchdog_threshold;
+  UNLOCK_CONTEXT (context);
+
+  return result;
+}
+
+/**
+ * g_main_context_get_stalls:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ *
+ * Gets the number of callbacks of @context that the watchdog found
+ * running for longer than its threshold; see
+ * g_main_context_set_watchdog().
+ *
+ * Returns: the number of stalls since @context was created
+ *
+ * Since: 2.40
+ **/
+guint64
+g_main_context_get_stalls (GMainContext *context)
+{
+  guint64 result;
+
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_val_if_fail (g_atomic_int_get (&context->ref_count) > 0, 0);
+
+  LOCK_CONTEXT (context);
+  result = context->n_stalls;
+  UNLOCK_CONTEXT (context);
+
+  return result;
+}
+
+/* HOLDS: context's lock */
+static void
+g_source_record_dispatch (GSource *source,
+                          gint64   dispatch_start,
+                          gint64   dispatch_end)
+{
+  GSourceStatistics *statistics;
+  gint64 duration;
+
+  statistics = source->priv->statistics;
+  if (statistics == NULL)
+    statistics = source->priv->statistics = g_slice_new0 (GSourceStatistics);
+
+  duration = dispatch_end - dispatch_start;
+  statistics->n_dispatches++;
+  statistics->total_dispatch_time += duration;
+  statistics->max_dispatch_time = MAX (statistics->max_dispatch_time, duration);
+
+  /* Not known if statistics were enabled between check and dispatch */
+  if (source->priv->ready_since != 0 && source->priv->ready_since <= dispatch_start)
+    {
+      gint64 latency = dispatch_start - source->priv->ready_since;
+
+      statistics->total_latency += latency;
+      statistics->max_latency = MAX (statistics->max_latency, latency);
+    }
+
+  source->priv->ready_since = 0;
+  source->priv->last_dispatch_end = dispatch_end;
+}
+
+/**
+ * g_main_context_set_statistics_enabled:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ * @enabled: whether to collect dispatch statistics
+ *
+ * Enables or disables the collection of dispatch statistics for the
+ * sources of @context.  While enabled, every dispatch records how long
+ * the dispatch function ran and how long the source had been ready
+ * before being dispatched; see g_source_get_statistics() and
+ * g_main_context_dump_statistics().  Giving sources a name with
+ * g_source_set_name() makes the results easier to interpret.
+ *
+ * Collection is disabled by default, and costs nothing in that case.
+ * Statistics already collected for a source are kept when it is
+ * disabled again.
+ *
+ * Since: 2.40
+ **/
+void
+g_main_context_set_statistics_enabled (GMainContext *context,
+                                       gboolean      enabled)
+{
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_if_fail (g_atomic_int_get (&context->ref_count) > 0);
+
+  LOCK_CONTEXT (context);
+  context->statistics_enabled = !!enabled;
+  UNLOCK_CONTEXT (context);
+}
+
+/**
+ * g_main_context_get_statistics_enabled:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ *
+ * Gets whether dispatch statistics are being collected for @context.
+ * See g_main_context_set_statistics_enabled().
+ *
+ * Returns: %TRUE if statistics are being collected
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_main_context_get_statistics_enabled (GMainContext *context)
+{
+  gboolean result;
+
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_val_if_fail (g_atomic_int_get (&context->ref_count) > 0, FALSE);
+
+  LOCK_CONTEXT (context);
+  result = context->statistics_enabled;
+  UNLOCK_CONTEXT (context);
+
+  return result;
+}
+
+/**
+ * g_source_get_statistics:
+ * @source: a #GSource
+ * @statistics: (out caller-allocates): return location for the statistics
+ *
+ * Gets the dispatch statistics collected for @source while statistics
+ * were enabled on its #GMainContext.  See
+ * g_main_context_set_statistics_enabled().
+ *
+ * Returns: %TRUE if @statistics was filled in, %FALSE if nothing has
+ *   been collected for @source
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_source_get_statistics (GSource           *source,
+                         GSourceStatistics *statistics)
+{
+  GMainContext *context;
+  gboolean result = FALSE;
+
+  g_return_val_if_fail (source != NULL, FALSE);
+  g_return_val_if_fail (source->ref_count > 0, FALSE);
+  g_return_val_if_fail (statistics != NULL, FALSE);
+
+  context = source->context;
+
+  if (context)
+    LOCK_CONTEXT (context);
+
+  if (source->priv->statistics)
+    {
+      *statistics = *source->priv->statistics;
+      result = TRUE;
+    }
+
+  if (context)
+    UNLOCK_CONTEXT (context);
+
+  return result;
+}
+
+static gint
+compare_dispatch_time (gconstpointer a,
+                       gconstpointer b)
+{
+  const GSource *source_a = *(GSource **) a;
+  const GSource *source_b = *(GSource **) b;
+  gint64 time_a = source_a->priv->statistics->total_dispatch_time;
+  gint64 time_b = source_b->priv->statistics->total_dispatch_time;
+
+  return (time_a < time_b) - (time_a > time_b);
+}
+
+/**
+ * g_main_context_dump_statistics:
+ * @context: (allow-none): a #GMainContext (if %NULL, the default context will be used)
+ *
+ * Formats the dispatch statistics of all the sources attached to
+ * @context which have any, as a table with one line per source, the
+ * sources which spent the most time dispatching coming first.  Times are
+ * given in microseconds.
+ *
+ * This is meant as a debugging aid; the format of the result may change
+ * between releases.  Use g_source_get_statistics() to read the numbers
+ * programmatically.
+ *
+ * Returns: a newly allocated string. Free with g_free().
+ *
+ * Since: 2.40
+ **/
+gchar *
+g_main_context_dump_statistics (GMainContext *context)
+{
+  GSourceIter iter;
+  GSource *source;
+  GPtrArray *sources;
+  GString *string;
+  guint i;
+
+  if (!context)
+    context = g_main_context_default ();
+
+  g_return_val_if_fail (g_atomic_int_get (&context->ref_count) > 0, NULL);
+
+  sources = g_ptr_array_new ();
+  string = g_string_new (NULL);
+  g_string_append_printf (string, "%-32s %10s %10s %12s %10s %10s %10s %10s %10s\n",
+                          "source", "id", "dispatches", "total", "max",
+                          "avg-lat", "max-lat", "deferred", "stalls");
+
+  LOCK_CONTEXT (context);
+
+  g_source_iter_init (&iter, context, FALSE);
+  while (g_source_iter_next (&iter, &source))
+    if (!SOURCE_DESTROYED (source) && source->priv->statistics)
+      g_ptr_array_add (sources, source);
+  g_source_iter_clear (&iter);
+
+  g_ptr_array_sort (sources, compare_dispatch_time);
+
+  for (i = 0; i < sources->len; i++)
+    {
+      GSourceStatistics *statistics;
+
+      source = sources->pdata[i];
+      statistics = source->priv->statistics;
+
+      g_string_append_printf (string, "%-32s %10u %10" G_GUINT64_FORMAT " %12" G_GINT64_FORMAT
+                              " %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT
+                              " %10" G_GUINT64_FORMAT " %10" G_GUINT64_FORMAT "\n",
+                              source->name ? source->name : "(unnamed)",
+                              source->source_id,
+                              statistics->n_dispatches,
+                              statistics->total_dispatch_time,
+                              statistics->max_dispatch_time,
+                              statistics->n_dispatches ?
+                                (gint64) (statistics->total_latency / statistics->n_dispatches) : 0,
+                              statistics->max_latency,
+                              statistics->n_deferrals,
+                              statistics->n_stalls);
+    }
+
+  UNLOCK_CONTEXT (context);
+
+  g_ptr_array_free (sources, TRUE);
+
+  return g_string_free (string, FALSE);
+}
+
+/**
+ * g_main_context_acquire:
+ * @context: a #GMainContext
+ * 
+ * Tries to become the owner of the specified context.
+ * If some other thread is the owner of the context,
+ * returns %FALSE immediately. Ownership is properly
+ * recursive: the owner can require ownership again
+ * and will release ownership when g_main_context_release()
+ * is called as many times as g_main_context_acquire().
+ *
+ * You must be the owner of a context before you
+ * can call g_main_context_prepare(), g_main_context_query(),
+ * g_main_context_check(), g_main_context_dispatch().
+ * 
+ * Return value: %TRUE if the operation succeeded, and
+ *   this thread is now the owner of @context.
+ **/
+gboolean 
+g_main_context_acquire (GMainContext *context)
+{
+  gboolean result = FALSE;
+  GThread *self = G_THREAD_SELF;
+
+  if (context == NULL)
+    context = g_main_context_default ();
+  
+  LOCK_CONTEXT (context);
+
+  if (!context->owner)
+    {
+      context->owner = self;
+      g_assert (context->owner_count == 0);
+    }
+
+  if (context->owner == self)
+    {
+      context->owner_count++;
+      result = TRUE;
+    }
+
+  UNLOCK_CONTEXT (context); 
+  
+  return result;
+}
+
+/**
+ * g_main_context_release:
+ * @context: a #GMainContext
+ * 
+ * Releases ownership of a context previously acquired by this thread
+ * with g_main_context_acquire(). If the context was acquired multiple
+ * times, the ownership will be released only when g_main_context_release()
+ * is called as many times as it was acquired.
+ **/
+void
+g_main_context_release (GMainContext *context)
+{
+  if (context == NULL)
+    context = g_main_context_default ();
+  
+  LOCK_CONTEXT (context);
+
+  context->owner_count--;
+  if (context->owner_count == 0)
     {
       context->owner = NULL;
 
@@ -3249,6 +4409,304 @@ g_main_context_wait (GMainContext *context,
   return result;
 }
 
+/* Timer heap
+ *
+ * Rather than having every iteration look at the ready time of every
+ * source, the sources that have one are kept in a min-heap.  The
+ * expired ones are then found by walking down from the root until the
+ * ready times pass the current time, which also yields the next
+ * deadline, so that the cost of an iteration depends on the number of
+ * expired timers rather than on the total.
+ *
+ * HOLDS: context's lock for all of these.
+ */
+#define TIMER_HEAP_SOURCE(heap, i) ((GSource *) (heap)->pdata[i])
+
+/* Seconds timeouts live in a heap of their own, so that their deadlines
+ * can be left to the seconds timer without getting in the way of
+ * finding the next fine-grained one.
+ */
+#define TIMER_HEAP_FOR(context, source) \
+  (((source)->flags & G_SOURCE_SECONDS) ? (context)->seconds_heap : (context)->timer_heap)
+
+static void
+timer_heap_set (GPtrArray *heap,
+                guint      i,
+                GSource   *source)
+{
+  heap->pdata[i] = source;
+  source->priv->timer_heap_index = i + 1;
+}
+
+static void
+timer_heap_sift_up (GPtrArray *heap,
+                    guint      i)
+{
+  GSource *source = TIMER_HEAP_SOURCE (heap, i);
+
+  while (i > 0)
+    {
+      guint parent = (i - 1) / 2;
+      GSource *parent_source = TIMER_HEAP_SOURCE (heap, parent);
+
+      if (parent_source->priv->ready_time <= source->priv->ready_time)
+        break;
+
+      timer_heap_set (heap, i, parent_source);
+      i = parent;
+    }
+
+  timer_heap_set (heap, i, source);
+}
+
+static void
+timer_heap_sift_down (GPtrArray *heap,
+                      guint      i)
+{
+  GSource *source = TIMER_HEAP_SOURCE (heap, i);
+  guint len = heap->len;
+
+  while (2 * i + 1 < len)
+    {
+      guint child = 2 * i + 1;
+      GSource *child_source = TIMER_HEAP_SOURCE (heap, child);
+
+      if (child + 1 < len &&
+          TIMER_HEAP_SOURCE (heap, child + 1)->priv->ready_time < child_source->priv->ready_time)
+        child_source = TIMER_HEAP_SOURCE (heap, ++child);
+
+      if (source->priv->ready_time <= child_source->priv->ready_time)
+        break;
+
+      timer_heap_set (heap, i, child_source);
+      i = child;
+    }
+
+  timer_heap_set (heap, i, source);
+}
+
+static void
+timer_heap_remove (GMainContext *context,
+                   GSource      *source)
+{
+  GPtrArray *heap = TIMER_HEAP_FOR (context, source);
+  GSource *last;
+  guint i;
+
+  if (source->priv->timer_heap_index == 0)
+    return;
+
+  i = source->priv->timer_heap_index - 1;
+  source->priv->timer_heap_index = 0;
+
+  last = g_ptr_array_remove_index (heap, heap->len - 1);
+  if (last == source)
+    return;
+
+  timer_heap_set (heap, i, last);
+  timer_heap_sift_up (heap, i);
+  timer_heap_sift_down (heap, last->priv->timer_heap_index - 1);
+}
+
+/* Inserts, moves or removes @source according to its ready time */
+static void
+timer_heap_update (GMainContext *context,
+                   GSource      *source)
+{
+  GPtrArray *heap = TIMER_HEAP_FOR (context, source);
+  guint i;
+
+  if (source->priv->ready_time == -1)
+    {
+      timer_heap_remove (context, source);
+      return;
+    }
+
+  if (source->priv->timer_heap_index == 0)
+    {
+      g_ptr_array_add (heap, source);
+      i = heap->len - 1;
+      source->priv->timer_heap_index = i + 1;
+    }
+  else
+    i = source->priv->timer_heap_index - 1;
+
+  timer_heap_sift_up (heap, i);
+  timer_heap_sift_down (heap, source->priv->timer_heap_index - 1);
+}
+
+static gint64
+timer_heap_scan_one (GMainContext *context,
+                     GPtrArray    *heap,
+                     gint64        now,
+                     gboolean      checking)
+{
+  gint64 next_ready_time = -1;
+  GArray *stack;
+  guint i = 0;
+
+  if (heap->len == 0)
+    return -1;
+
+  /* Fast path for the common case of nothing having expired yet */
+  if (TIMER_HEAP_SOURCE (heap, 0)->priv->ready_time > now &&
+      !SOURCE_BLOCKED (TIMER_HEAP_SOURCE (heap, 0)))
+    return TIMER_HEAP_SOURCE (heap, 0)->priv->ready_time;
+
+  stack = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_array_append_val (stack, i);
+
+  while (stack->len > 0)
+    {
+      GSource *source;
+      gboolean expired;
+
+      i = g_array_index (stack, guint, stack->len - 1);
+      g_array_set_size (stack, stack->len - 1);
+
+      source = TIMER_HEAP_SOURCE (heap, i);
+      expired = source->priv->ready_time <= now;
+
+      if (!SOURCE_BLOCKED (source))
+        {
+          if (!expired)
+            {
+              /* Everything below has a later ready time */
+              if (next_ready_time == -1 || source->priv->ready_time < next_ready_time)
+                next_ready_time = source->priv->ready_time;
+              continue;
+            }
+
+          if (!(source->flags & G_SOURCE_READY) &&
+              (checking ? source->source_funcs->check == NULL : source->source_funcs->prepare == NULL))
+            g_source_mark_ready (context, source);
+        }
+
+      /* Blocked sources are ignored, but their descendants are not */
+      if (2 * i + 1 < heap->len)
+        {
+          guint child = 2 * i + 1;
+
+          g_array_append_val (stack, child);
+          if (++child < heap->len)
+            g_array_append_val (stack, child);
+        }
+    }
+
+  g_array_free (stack, TRUE);
+
+  return next_ready_time;
+}
+
+/* Flags all unblocked expired sources as ready, except those which
+ * have a @prepare (or @check, if @checking) function: they are still
+ * handled in the source loop, since their ready time only counts once
+ * that function has returned %FALSE.
+ *
+ * Returns the earliest ready time in the future of any unblocked
+ * source other than a seconds timeout, or -1 if there is none; that
+ * of the seconds timeouts is stored in @next_seconds_time.
+ */
+static gint64
+timer_heap_scan (GMainContext *context,
+                 gboolean      checking,
+                 gint64       *next_seconds_time)
+{
+  gint64 next_ready_time;
+  gint64 seconds_time;
+
+  if (context->timer_heap->len == 0 && context->seconds_heap->len == 0)
+    {
+      if (next_seconds_time)
+        *next_seconds_time = -1;
+      return -1;
+    }
+
+  /* The seconds timeouts are happy with the coarse clock, so a context
+   * with only those gets away without reading the fine one.
+   */
+  next_ready_time = -1;
+  if (context->timer_heap->len > 0)
+    next_ready_time = timer_heap_scan_one (context, context->timer_heap,
+                                           g_main_context_get_time_unlocked (context),
+                                           checking);
+
+  seconds_time = -1;
+  if (context->seconds_heap->len > 0)
+    seconds_time = timer_heap_scan_one (context, context->seconds_heap,
+                                        g_main_context_get_coarse_time_unlocked (context),
+                                        checking);
+  if (next_seconds_time)
+    *next_seconds_time = seconds_time;
+
+  return next_ready_time;
+}
+
+/* HOLDS: context's lock
+ *
+ * Arms the seconds timer of @context for @deadline, or disarms it if
+ * @deadline is -1.  Since seconds timeouts are all aligned to the same
+ * point within the second, the timers of all the contexts in the
+ * process (and of other processes in the session) then expire
+ * together, instead of each context waking up on its own after a
+ * millisecond-rounded poll timeout.
+ *
+ * Returns %FALSE if there is no seconds timer, in which case the
+ * deadline has to go into the poll timeout instead.
+ */
+static gboolean
+g_main_context_set_seconds_timer (GMainContext *context,
+                                  gint64        deadline)
+{
+#ifdef HAVE_TIMERFD
+  struct itimerspec its;
+
+  if (context->seconds_timer_rec.fd < 0)
+    {
+      gint fd;
+
+      if (deadline == -1)
+        return TRUE;
+
+      if (context->seconds_timer_failed)
+        return FALSE;
+
+      fd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+      if (fd < 0)
+        {
+          context->seconds_timer_failed = TRUE;
+          return FALSE;
+        }
+
+      context->seconds_timer_rec.fd = fd;
+      context->seconds_timer_rec.events = G_IO_IN;
+      g_main_context_add_poll_unlocked (context, 0, &context->seconds_timer_rec, NULL);
+    }
+
+  if (deadline == context->seconds_timer_deadline)
+    return TRUE;
+
+  memset (&its, 0, sizeof its);
+  if (deadline != -1)
+    {
+      its.it_value.tv_sec = deadline / G_USEC_PER_SEC;
+      its.it_value.tv_nsec = (deadline % G_USEC_PER_SEC) * 1000;
+    }
+
+  if (timerfd_settime (context->seconds_timer_rec.fd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+    {
+      context->seconds_timer_deadline = -1;
+      return deadline == -1;
+    }
+
+  context->seconds_timer_deadline = deadline;
+
+  return TRUE;
+#else
+  return deadline == -1;
+#endif
+}
+
 /**
  * g_main_context_prepare:
  * @context: a #GMainContext
@@ -3268,6 +4726,8 @@ g_main_context_prepare (GMainContext *context,
   gint i;
   gint n_ready = 0;
   gint current_priority = G_MAXINT;
+  gint64 next_ready_time;
+  gint64 next_seconds_time;
   GSource *source;
   GSourceIter iter;
 
@@ -3276,7 +4736,7 @@ g_main_context_prepare (GMainContext *context,
   
   LOCK_CONTEXT (context);
 
-  context->time_is_fresh = FALSE;
+  g_main_context_expire_time (context);
 
   if (context->in_check_or_prepare)
     {
@@ -3302,14 +4762,50 @@ g_main_context_prepare (GMainContext *context,
 
   for (i = 0; i < context->pending_dispatches->len; i++)
     {
-      if (context->pending_dispatches->pdata[i])
-	SOURCE_UNREF ((GSource *)context->pending_dispatches->pdata[i], context);
+      GSource *pending = context->pending_dispatches->pdata[i];
+
+      if (pending)
+        {
+          /* Still flagged ready, so the check pass must see it again */
+          g_source_list_mark (context, pending);
+          SOURCE_UNREF (pending, context);
+        }
     }
   g_ptr_array_set_size (context->pending_dispatches, 0);
   
   /* Prepare all sources */
 
   context->timeout = -1;
+
+  next_ready_time = timer_heap_scan (context, FALSE, &next_seconds_time);
+  if (!g_main_context_set_seconds_timer (context, next_seconds_time) &&
+      (next_ready_time == -1 || next_seconds_time < next_ready_time))
+    next_ready_time = next_seconds_time;
+
+  if (next_ready_time != -1)
+    {
+      gint64 now;
+
+      /* Only the seconds timeouts were scanned if the fine clock was
+       * not read.  rounding down will lead to spinning, so always round
+       * up.
+       */
+      now = context->time_is_fresh ? context->time : context->coarse_time;
+      context->timeout = (next_ready_time - now + 999) / 1000;
+    }
+
+  /* Sources left over from the last dispatch are still ready */
+  for (i = 0; i < context->deferred_dispatches->len; i++)
+    {
+      source = context->deferred_dispatches->pdata[i];
+
+      if (SOURCE_DESTROYED (source))
+        continue;
+
+      n_ready++;
+      current_priority = MIN (current_priority, source->priority);
+      context->timeout = 0;
+    }
   
   g_source_iter_init (&iter, context, TRUE);
   while (g_source_iter_next (&iter, &source))
@@ -3332,11 +4828,13 @@ g_main_context_prepare (GMainContext *context,
           if (prepare)
             {
               context->in_check_or_prepare++;
+              WATCHDOG_ENTER (context, source, "prepare");
               UNLOCK_CONTEXT (context);
 
               result = (* prepare) (source, &source_timeout);
 
               LOCK_CONTEXT (context);
+              WATCHDOG_LEAVE (context);
               context->in_check_or_prepare--;
             }
           else
@@ -3345,15 +4843,10 @@ g_main_context_prepare (GMainContext *context,
               result = FALSE;
             }
 
-          if (result == FALSE && source->priv->ready_time != -1)
+          /* Without a prepare function, timer_heap_scan() took care of it */
+          if (result == FALSE && prepare != NULL && source->priv->ready_time != -1)
             {
-              if (!context->time_is_fresh)
-                {
-                  context->time = g_get_monotonic_time ();
-                  context->time_is_fresh = TRUE;
-                }
-
-              if (source->priv->ready_time <= context->time)
+              if (source->priv->ready_time <= g_main_context_get_time_unlocked (context))
                 {
                   source_timeout = 0;
                   result = TRUE;
@@ -3363,7 +4856,7 @@ g_main_context_prepare (GMainContext *context,
                   gint timeout;
 
                   /* rounding down will lead to spinning, so always round up */
-                  timeout = (source->priv->ready_time - context->time + 999) / 1000;
+                  timeout = (source->priv->ready_time - g_main_context_get_time_unlocked (context) + 999) / 1000;
 
                   if (source_timeout < 0 || timeout < source_timeout)
                     source_timeout = timeout;
@@ -3371,19 +4864,12 @@ g_main_context_prepare (GMainContext *context,
             }
 
 	  if (result)
-	    {
-	      GSource *ready_source = source;
-
-	      while (ready_source)
-		{
-		  ready_source->flags |= G_SOURCE_READY;
-		  ready_source = ready_source->priv->parent_source;
-		}
-	    }
+	    g_source_mark_ready (context, source);
 	}
 
       if (source->flags & G_SOURCE_READY)
 	{
+          ((GSourceList *) iter.current_list->data)->maybe_ready = TRUE;
 	  n_ready++;
 	  current_priority = source->priority;
 	  context->timeout = 0;
@@ -3465,7 +4951,7 @@ g_main_context_query (GMainContext *context,
     {
       *timeout = context->timeout;
       if (*timeout != 0)
-        context->time_is_fresh = FALSE;
+        g_main_context_expire_time (context);
     }
   
   UNLOCK_CONTEXT (context);
@@ -3491,10 +4977,8 @@ g_main_context_check (GMainContext *context,
 		      GPollFD      *fds,
 		      gint          n_fds)
 {
-  GSource *source;
-  GSourceIter iter;
   GPollRec *pollrec;
-  gint n_ready = 0;
+  gboolean result;
   gint i;
    
   LOCK_CONTEXT (context);
@@ -3524,13 +5008,76 @@ g_main_context_check (GMainContext *context,
   while (i < n_fds)
     {
       if (pollrec->fd->events)
-	pollrec->fd->revents = fds[i].revents;
+        {
+          pollrec->fd->revents = fds[i].revents;
+          if (pollrec->fd->revents && pollrec->source)
+            g_source_list_mark (context, pollrec->source);
+        }
+
+      pollrec = pollrec->next;
+      i++;
+    }
+
+  result = g_main_context_check_sources (context, max_priority);
+
+  UNLOCK_CONTEXT (context);
+
+  return result;
+}
+
+/* HOLDS: context's lock
+ *
+ * Runs the check phase over all sources, once the revents of the
+ * context's GPollFDs have been filled in.
+ */
+static gboolean
+g_main_context_check_sources (GMainContext *context,
+                              gint          max_priority)
+{
+  GSource *source;
+  GSourceIter iter;
+  gint n_ready = 0;
+  gint64 now = -1;
+  guint i;
+
+#ifdef HAVE_TIMERFD
+  if (context->seconds_timer_rec.revents)
+    {
+      guint64 expirations;
+      gssize res;
+
+      /* The timer is one-shot, so the next prepare has to re-arm it */
+      do
+        res = read (context->seconds_timer_rec.fd, &expirations, sizeof expirations);
+      while (G_UNLIKELY (res == -1 && errno == EINTR));
+
+      context->seconds_timer_rec.revents = 0;
+      context->seconds_timer_deadline = -1;
+    }
+#endif
+
+  timer_heap_scan (context, TRUE, NULL);
+
+  /* No lower priority source may be dispatched alongside the sources
+   * left over from the last dispatch.  They are checked again below.
+   */
+  for (i = 0; i < context->deferred_dispatches->len; i++)
+    {
+      source = context->deferred_dispatches->pdata[i];
+
+      if (SOURCE_DESTROYED (source))
+        continue;
 
-      pollrec = pollrec->next;
-      i++;
+      n_ready++;
+      max_priority = MIN (max_priority, source->priority);
     }
 
+  /* Only lists that can hold a ready source are worth walking: those
+   * with a check function to run, and those g_source_list_mark() was
+   * called for since (ready sources, fds with revents, and so on).
+   */
   g_source_iter_init (&iter, context, TRUE);
+  iter.skip_idle_lists = TRUE;
   while (g_source_iter_next (&iter, &source))
     {
       if (SOURCE_DESTROYED (source) || SOURCE_BLOCKED (source))
@@ -3549,11 +5096,13 @@ g_main_context_check (GMainContext *context,
             {
               /* If the check function is set, call it. */
               context->in_check_or_prepare++;
+              WATCHDOG_ENTER (context, source, "check");
               UNLOCK_CONTEXT (context);
 
               result = (* check) (source);
 
               LOCK_CONTEXT (context);
+              WATCHDOG_LEAVE (context);
               context->in_check_or_prepare--;
             }
           else
@@ -3579,28 +5128,15 @@ g_main_context_check (GMainContext *context,
                 }
             }
 
-          if (result == FALSE && source->priv->ready_time != -1)
+          /* Without a check function, timer_heap_scan() took care of it */
+          if (result == FALSE && check != NULL && source->priv->ready_time != -1)
             {
-              if (!context->time_is_fresh)
-                {
-                  context->time = g_get_monotonic_time ();
-                  context->time_is_fresh = TRUE;
-                }
-
-              if (source->priv->ready_time <= context->time)
+              if (source->priv->ready_time <= g_main_context_get_time_unlocked (context))
                 result = TRUE;
             }
 
 	  if (result)
-	    {
-	      GSource *ready_source = source;
-
-	      while (ready_source)
-		{
-		  ready_source->flags |= G_SOURCE_READY;
-		  ready_source = ready_source->priv->parent_source;
-		}
-	    }
+	    g_source_mark_ready (context, source);
 	}
 
       if (source->flags & G_SOURCE_READY)
@@ -3608,6 +5144,23 @@ g_main_context_check (GMainContext *context,
 	  source->ref_count++;
 	  g_ptr_array_add (context->pending_dispatches, source);
 
+          if (G_UNLIKELY (context->statistics_enabled))
+            {
+              gint64 ready_time = source->priv->ready_time;
+
+              if (now == -1)
+                now = g_main_context_get_time_unlocked (context);
+
+              /* A source that became ready through its ready time has
+               * been waiting since then (or since it was last
+               * dispatched, if that was later); others since the poll.
+               */
+              if (ready_time > 0 && ready_time <= now)
+                source->priv->ready_since = MAX (ready_time, source->priv->last_dispatch_end);
+              else
+                source->priv->ready_since = now;
+            }
+
 	  n_ready++;
 
           /* never dispatch sources with less priority than the first
@@ -3618,7 +5171,29 @@ g_main_context_check (GMainContext *context,
     }
   g_source_iter_clear (&iter);
 
-  UNLOCK_CONTEXT (context);
+  /* Deferred sources that were checked and are no longer ready are
+   * dropped, instead of being dispatched with the revents of an earlier
+   * poll.  Those of a lower priority than what is dispatched now were
+   * not checked, and stay deferred.
+   */
+  for (i = 0; i < context->deferred_dispatches->len; )
+    {
+      source = context->deferred_dispatches->pdata[i];
+
+      if ((source->flags & G_SOURCE_READY) ||
+          (!SOURCE_DESTROYED (source) && source->priority > max_priority))
+        {
+          i++;
+          continue;
+        }
+
+      if (!SOURCE_DESTROYED (source))
+        n_ready--;
+
+      g_ptr_array_remove_index (context->deferred_dispatches, i);
+      source->flags &= ~G_SOURCE_DEFERRED;
+      SOURCE_UNREF (source, context);
+    }
 
   return n_ready > 0;
 }
@@ -3634,6 +5209,7 @@ g_main_context_dispatch (GMainContext *context)
 {
   LOCK_CONTEXT (context);
 
+  /* Deferred sources are in here too if they are still ready */
   if (context->pending_dispatches->len > 0)
     {
       g_main_dispatch (context);
@@ -3675,6 +5251,26 @@ g_main_context_iterate (GMainContext *context,
     }
   else
     LOCK_CONTEXT (context);
+
+#ifdef HAVE_EPOLL_CREATE1
+  if (context->epoll_fd >= 0 && context->poll_func == g_poll)
+    {
+      UNLOCK_CONTEXT (context);
+
+      g_main_context_prepare (context, &max_priority);
+
+      some_ready = g_main_context_epoll_poll (context, block, max_priority);
+
+      if (dispatch)
+        g_main_context_dispatch (context);
+
+      g_main_context_release (context);
+
+      LOCK_CONTEXT (context);
+
+      return some_ready;
+    }
+#endif
   
   if (!context->cached_poll_array)
     {
@@ -4001,6 +5597,10 @@ g_main_context_poll (GMainContext *context,
       poll_func = context->poll_func;
       
       UNLOCK_CONTEXT (context);
+
+      if (G_UNLIKELY (g_trace_buffer_enabled ()))
+        g_trace_buffer_record (G_TRACE_EVENT_POLL, G_TRACE_PHASE_BEGIN, NULL, context, timeout);
+
       if ((*poll_func) (fds, n_fds, timeout) < 0 && errno != EINTR)
 	{
 #ifndef G_OS_WIN32
@@ -4010,6 +5610,9 @@ g_main_context_poll (GMainContext *context,
 	  /* If g_poll () returns -1, it has already called g_warning() */
 #endif
 	}
+
+      if (G_UNLIKELY (g_trace_buffer_enabled ()))
+        g_trace_buffer_record (G_TRACE_EVENT_POLL, G_TRACE_PHASE_END, NULL, context, 0);
       
 #ifdef	G_MAIN_POLL_DEBUG
       if (_g_main_poll_debug)
@@ -4084,7 +5687,7 @@ g_main_context_add_poll (GMainContext *context,
   g_return_if_fail (fd);
 
   LOCK_CONTEXT (context);
-  g_main_context_add_poll_unlocked (context, priority, fd);
+  g_main_context_add_poll_unlocked (context, priority, fd, NULL);
   UNLOCK_CONTEXT (context);
 }
 
@@ -4092,7 +5695,8 @@ g_main_context_add_poll (GMainContext *context,
 static void 
 g_main_context_add_poll_unlocked (GMainContext *context,
 				  gint          priority,
-				  GPollFD      *fd)
+				  GPollFD      *fd,
+				  GSource      *source)
 {
   GPollRec *prevrec, *nextrec;
   GPollRec *newrec = g_slice_new (GPollRec);
@@ -4101,6 +5705,7 @@ g_main_context_add_poll_unlocked (GMainContext *context,
   fd->revents = 0;
   newrec->fd = fd;
   newrec->priority = priority;
+  newrec->source = source;
 
   prevrec = context->poll_records_tail;
   nextrec = NULL;
@@ -4125,6 +5730,23 @@ g_main_context_add_poll_unlocked (GMainContext *context,
 
   context->n_poll_records++;
 
+#ifdef HAVE_EPOLL_CREATE1
+  if (context->epoll_fd >= 0)
+    {
+      GEpollRec *erec;
+
+      erec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd->fd));
+      if (erec == NULL)
+        {
+          erec = g_slice_new0 (GEpollRec);
+          erec->fd = fd->fd;
+          g_hash_table_insert (context->epoll_records, GINT_TO_POINTER (fd->fd), erec);
+        }
+      erec->poll_records = g_slist_prepend (erec->poll_records, newrec);
+      g_main_context_epoll_update (context, fd->fd);
+    }
+#endif
+
   context->poll_changed = TRUE;
 
   /* Now wake up the main loop if it is waiting in the poll() */
@@ -4178,6 +5800,21 @@ g_main_context_remove_poll_unlocked (GMainContext *context,
 	  else
 	    context->poll_records_tail = prevrec;
 
+#ifdef HAVE_EPOLL_CREATE1
+          if (context->epoll_fd >= 0)
+            {
+              GEpollRec *erec;
+
+              erec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd->fd));
+              if (erec != NULL)
+                {
+                  erec->poll_records = g_slist_remove (erec->poll_records, pollrec);
+                  g_main_context_epoll_update (context, fd->fd);
+                }
+              g_ptr_array_remove_fast (context->epoll_ready, pollrec);
+            }
+#endif
+
 	  g_slice_free (GPollRec, pollrec);
 
 	  context->n_poll_records--;
@@ -4193,6 +5830,225 @@ g_main_context_remove_poll_unlocked (GMainContext *context,
   g_wakeup_signal (context->wakeup);
 }
 
+#ifdef HAVE_EPOLL_CREATE1
+/* HOLDS: context's lock
+ *
+ * Brings the kernel's registration of @fd in line with the union of
+ * the events of all GPollRecs that currently use it, dropping the
+ * GEpollRec once the last of them is gone.
+ */
+static void
+g_main_context_epoll_update (GMainContext *context,
+                             gint          fd)
+{
+  struct epoll_event ev = { 0, };
+  GEpollRec *erec;
+  gushort events = 0;
+  GSList *l;
+  gint op;
+
+  erec = g_hash_table_lookup (context->epoll_records, GINT_TO_POINTER (fd));
+  if (erec == NULL)
+    return;
+
+  for (l = erec->poll_records; l; l = l->next)
+    {
+      GPollRec *pollrec = l->data;
+
+      events |= pollrec->fd->events & ~(G_IO_ERR|G_IO_HUP|G_IO_NVAL);
+    }
+
+  if (erec->unpollable_revents)
+    {
+      /* Nothing is registered with the kernel for this fd */
+      erec->events = events;
+      if (erec->poll_records == NULL)
+        {
+          context->epoll_unpollable = g_slist_remove (context->epoll_unpollable, erec);
+          g_hash_table_remove (context->epoll_records, GINT_TO_POINTER (fd));
+        }
+      return;
+    }
+
+  if (erec->poll_records == NULL || events == 0)
+    {
+      /* The fd may already have been closed, in which case the kernel
+       * has dropped it from the set by itself and this fails harmlessly.
+       */
+      if (erec->events)
+        epoll_ctl (context->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+      erec->events = 0;
+
+      if (erec->poll_records == NULL)
+        g_hash_table_remove (context->epoll_records, GINT_TO_POINTER (fd));
+      return;
+    }
+
+  if (events == erec->events)
+    return;
+
+  /* The G_IO_* values are the poll() ones, which epoll shares */
+  ev.events = events;
+  ev.data.fd = fd;
+
+  op = erec->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (epoll_ctl (context->epoll_fd, op, fd, &ev) < 0)
+    {
+      /* The fd number may have been closed and reused behind our back,
+       * in which case the kernel forgot about it (ENOENT) or still has
+       * the old registration (EEXIST).
+       */
+      if (errno == ENOENT)
+        op = EPOLL_CTL_ADD;
+      else if (errno == EEXIST)
+        op = EPOLL_CTL_MOD;
+      else
+        op = -1;
+
+      if (op == -1 || epoll_ctl (context->epoll_fd, op, fd, &ev) < 0)
+        {
+          /* epoll refuses regular files (EPERM) which poll() always
+           * reports as ready, and bad fds (EBADF) which poll() reports
+           * as G_IO_NVAL.  Emulate that from here on.
+           */
+          erec->unpollable_revents = (errno == EPERM) ? G_IO_IN | G_IO_OUT : G_IO_NVAL;
+          context->epoll_unpollable = g_slist_prepend (context->epoll_unpollable, erec);
+        }
+    }
+
+  erec->events = events;
+}
+
+static void
+epoll_rec_set_revents (GMainContext *context,
+                       GEpollRec    *erec,
+                       gushort       revents,
+                       gint          max_priority)
+{
+  GSList *l;
+
+  for (l = erec->poll_records; l; l = l->next)
+    {
+      GPollRec *pollrec = l->data;
+
+      /* Like the poll() path, only report fds of the priorities that
+       * were asked for; epoll is level-triggered, so the others will be
+       * reported again once they are.
+       */
+      if (pollrec->priority > max_priority || pollrec->fd->events == 0)
+        continue;
+
+      pollrec->fd->revents = revents & (pollrec->fd->events | G_IO_ERR | G_IO_HUP | G_IO_NVAL);
+      if (pollrec->fd->revents)
+        {
+          g_ptr_array_add (context->epoll_ready, pollrec);
+          if (pollrec->source)
+            g_source_list_mark (context, pollrec->source);
+        }
+    }
+}
+
+/* Replaces g_main_context_query(), g_main_context_poll() and
+ * g_main_context_check() for epoll-backed contexts.  Rather than
+ * copying every GPollFD around, it only touches the ones the kernel
+ * flags as ready.
+ */
+static gboolean
+g_main_context_epoll_poll (GMainContext *context,
+                           gboolean      block,
+                           gint          max_priority)
+{
+  gboolean some_ready;
+  gint timeout;
+  gint n_events;
+  guint size;
+  GSList *l;
+  gint i;
+
+  LOCK_CONTEXT (context);
+
+  context->poll_changed = FALSE;
+
+  timeout = block ? context->timeout : 0;
+  if (context->epoll_unpollable)
+    timeout = 0;
+  if (timeout != 0)
+    g_main_context_expire_time (context);
+
+  /* Anything that doesn't fit is reported by the next epoll_wait() */
+  size = CLAMP (g_hash_table_size (context->epoll_records), 1, 1024);
+  if (size > context->epoll_events_size)
+    {
+      g_free (context->epoll_events);
+      context->epoll_events = g_new (struct epoll_event, size);
+      context->epoll_events_size = size;
+    }
+  size = context->epoll_events_size;
+
+  UNLOCK_CONTEXT (context);
+
+  if (G_UNLIKELY (g_trace_buffer_enabled ()))
+    g_trace_buffer_record (G_TRACE_EVENT_POLL, G_TRACE_PHASE_BEGIN, NULL, context, timeout);
+
+  n_events = epoll_wait (context->epoll_fd, context->epoll_events, size, timeout);
+  if (n_events < 0)
+    {
+      if (errno != EINTR)
+        g_warning ("epoll_wait(2) failed due to: %s.", g_strerror (errno));
+      n_events = 0;
+    }
+
+  if (G_UNLIKELY (g_trace_buffer_enabled ()))
+    g_trace_buffer_record (G_TRACE_EVENT_POLL, G_TRACE_PHASE_END, NULL, context, 0);
+
+  LOCK_CONTEXT (context);
+
+  /* Forget the results of the previous iteration */
+  for (i = 0; i < context->epoll_ready->len; i++)
+    {
+      GPollRec *pollrec = context->epoll_ready->pdata[i];
+
+      pollrec->fd->revents = 0;
+    }
+  g_ptr_array_set_size (context->epoll_ready, 0);
+
+  /* If the set of poll file descriptors changed, bail out
+   * and let the main loop rerun
+   */
+  if (context->poll_changed)
+    {
+      UNLOCK_CONTEXT (context);
+      return FALSE;
+    }
+
+  for (i = 0; i < n_events; i++)
+    {
+      GEpollRec *erec;
+
+      erec = g_hash_table_lookup (context->epoll_records,
+                                  GINT_TO_POINTER (context->epoll_events[i].data.fd));
+      if (erec != NULL)
+        epoll_rec_set_revents (context, erec, context->epoll_events[i].events, max_priority);
+    }
+
+  for (l = context->epoll_unpollable; l; l = l->next)
+    {
+      GEpollRec *erec = l->data;
+
+      epoll_rec_set_revents (context, erec, erec->unpollable_revents, max_priority);
+    }
+
+  if (context->wake_up_rec.revents)
+    g_wakeup_acknowledge (context->wakeup);
+
+  some_ready = g_main_context_check_sources (context, max_priority);
+
+  UNLOCK_CONTEXT (context);
+
+  return some_ready;
+}
+#endif
+
 /**
  * g_source_get_current_time:
  * @source:  a #GSource
@@ -4237,15 +6093,41 @@ g_source_get_time (GSource *source)
   context = source->context;
 
   LOCK_CONTEXT (context);
+  result = g_main_context_get_time_unlocked (context);
+  UNLOCK_CONTEXT (context);
 
-  if (!context->time_is_fresh)
-    {
-      context->time = g_get_monotonic_time ();
-      context->time_is_fresh = TRUE;
-    }
+  return result;
+}
+
+/**
+ * g_source_get_coarse_time:
+ * @source: a #GSource
+ *
+ * Like g_source_get_time(), but the time returned may lag behind by up
+ * to a few milliseconds, as with g_get_coarse_monotonic_time().  In
+ * exchange, it only reads the coarse clock, and only once per main loop
+ * iteration at most, and not at all if the precise time is already
+ * known.
+ *
+ * Sources whose timeouts are measured in seconds can use this to
+ * compute their next ready time; the seconds timeouts of GLib do.
+ *
+ * Returns: the monotonic time in microseconds
+ *
+ * Since: 2.40
+ **/
+gint64
+g_source_get_coarse_time (GSource *source)
+{
+  GMainContext *context;
+  gint64 result;
+
+  g_return_val_if_fail (source->context != NULL, 0);
 
-  result = context->time;
+  context = source->context;
 
+  LOCK_CONTEXT (context);
+  result = g_main_context_get_coarse_time_unlocked (context);
   UNLOCK_CONTEXT (context);
 
   return result;
@@ -4448,7 +6330,9 @@ g_timeout_dispatch (GSource     *source,
   again = callback (user_data);
 
   if (again)
-    g_timeout_set_expiration (timeout_source, g_source_get_time (source));
+    g_timeout_set_expiration (timeout_source,
+                              timeout_source->seconds ? g_source_get_coarse_time (source)
+                                                      : g_source_get_time (source));
 
   return again;
 }
@@ -4491,7 +6375,9 @@ g_timeout_source_new (guint interval)
  * executed.
  *
  * The scheduling granularity/accuracy of this timeout source will be
- * in seconds.
+ * in seconds.  Where the platform supports it, all such timeouts in the
+ * process are woken up by timers that expire at the same moment, rather
+ * than by the poll timeout of each context.
  *
  * The interval given in terms of monotonic time, not wall clock time.
  * See g_get_monotonic_time().
@@ -4508,8 +6394,9 @@ g_timeout_source_new_seconds (guint interval)
 
   timeout_source->interval = 1000 * interval;
   timeout_source->seconds = TRUE;
+  source->flags |= G_SOURCE_SECONDS;
 
-  g_timeout_set_expiration (timeout_source, g_get_monotonic_time ());
+  g_timeout_set_expiration (timeout_source, g_get_coarse_monotonic_time ());
 
   return source;
 }
@@ -5356,6 +7243,164 @@ g_idle_remove_by_data (gpointer data)
   return g_source_remove_by_funcs_user_data (&g_idle_funcs, data);
 }
 
+/* Cross-thread invocations
+ *
+ * Calls queued with g_main_context_invoke_full() from threads that
+ * can't acquire the context go onto a lock-free stack in a long-lived
+ * source per priority, instead of each getting an idle source of its
+ * own.  Only the push that finds the stack empty needs to lock the
+ * context and wake it up; the whole stack is then taken in one go by
+ * the next dispatch.
+ */
+static void
+g_main_invocation_free (GMainInvocation *invocation)
+{
+  if (invocation->notify)
+    invocation->notify (invocation->data);
+
+  g_slice_free (GMainInvocation, invocation);
+}
+
+static gboolean
+g_invoke_dispatch (GSource     *source,
+                   GSourceFunc  callback,
+                   gpointer     user_data)
+{
+  GInvokeSource *invoke_source = (GInvokeSource *) source;
+  GMainInvocation *incoming;
+  GMainInvocation *batch;
+  GMainInvocation *next;
+
+  /* This must happen before taking the stack: anything pushed after
+   * that makes the source ready again.
+   */
+  g_source_set_ready_time (source, -1);
+
+  do
+    incoming = g_atomic_pointer_get (&invoke_source->incoming);
+  while (!g_atomic_pointer_compare_and_exchange (&invoke_source->incoming, incoming, NULL));
+
+  /* Append the stack to the pending queue, reversing it into
+   * submission order.
+   */
+  batch = NULL;
+  while (incoming)
+    {
+      next = incoming->next;
+      incoming->next = batch;
+      batch = incoming;
+      incoming = next;
+    }
+  if (invoke_source->pending_tail)
+    invoke_source->pending_tail->next = batch;
+  else
+    invoke_source->pending_head = batch;
+
+  batch = invoke_source->pending_head;
+  invoke_source->pending_head = invoke_source->pending_tail = NULL;
+
+  for (; batch; batch = next)
+    {
+      next = batch->next;
+
+      if (batch->function (batch->data))
+        {
+          /* Like an idle, run it again on the next iteration */
+          batch->next = NULL;
+          if (invoke_source->pending_tail)
+            invoke_source->pending_tail->next = batch;
+          else
+            invoke_source->pending_head = batch;
+          invoke_source->pending_tail = batch;
+        }
+      else
+        g_main_invocation_free (batch);
+    }
+
+  if (invoke_source->pending_head)
+    g_source_set_ready_time (source, 0);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+g_invoke_finalize (GSource *source)
+{
+  GInvokeSource *invoke_source = (GInvokeSource *) source;
+  GMainInvocation *invocation;
+
+  while ((invocation = invoke_source->pending_head))
+    {
+      invoke_source->pending_head = invocation->next;
+      g_main_invocation_free (invocation);
+    }
+
+  while ((invocation = invoke_source->incoming))
+    {
+      invoke_source->incoming = invocation->next;
+      g_main_invocation_free (invocation);
+    }
+}
+
+static GInvokeSource *
+g_main_context_get_invoke_source (GMainContext *context,
+                                  gint          priority)
+{
+  GInvokeSource *invoke_source;
+
+  for (invoke_source = g_atomic_pointer_get (&context->invoke_sources);
+       invoke_source; invoke_source = invoke_source->next)
+    if (invoke_source->source.priority == priority)
+      return invoke_source;
+
+  LOCK_CONTEXT (context);
+
+  /* Someone may have beaten us to it */
+  for (invoke_source = context->invoke_sources; invoke_source; invoke_source = invoke_source->next)
+    if (invoke_source->source.priority == priority)
+      break;
+
+  if (invoke_source == NULL)
+    {
+      GSource *source;
+
+      source = g_source_new (&g_invoke_funcs, sizeof (GInvokeSource));
+      g_source_set_name (source, "GMainContext invocations");
+      source->priority = priority;
+      g_source_attach_unlocked (source, context);
+
+      invoke_source = (GInvokeSource *) source;
+      invoke_source->next = context->invoke_sources;
+      g_atomic_pointer_set (&context->invoke_sources, invoke_source);
+    }
+
+  UNLOCK_CONTEXT (context);
+
+  return invoke_source;
+}
+
+static void
+g_main_context_push_invocation (GMainContext    *context,
+                                gint             priority,
+                                GMainInvocation *invocation)
+{
+  GInvokeSource *invoke_source;
+  GMainInvocation *head;
+
+  invoke_source = g_main_context_get_invoke_source (context, priority);
+
+  do
+    {
+      head = g_atomic_pointer_get (&invoke_source->incoming);
+      invocation->next = head;
+    }
+  while (!g_atomic_pointer_compare_and_exchange (&invoke_source->incoming, head, invocation));
+
+  /* Only the transition from empty needs a wakeup */
+  if (head == NULL)
+    g_source_set_ready_time ((GSource *) invoke_source, 0);
+}
+
 /**
  * g_main_context_invoke:
  * @context: (allow-none): a #GMainContext, or %NULL
@@ -5374,11 +7419,12 @@ g_idle_remove_by_data (gpointer data)
  * @function is called and g_main_context_release() is called
  * afterwards.
  *
- * In any other case, an idle source is created to call @function and
- * that source is attached to @context (presumably to be run in another
- * thread).  The idle source is attached with #G_PRIORITY_DEFAULT
- * priority.  If you want a different priority, use
- * g_main_context_invoke_full().
+ * In any other case, @function is queued to be called like an idle
+ * source attached to @context (presumably to be run in another
+ * thread), at #G_PRIORITY_DEFAULT priority.  If you want a different
+ * priority, use g_main_context_invoke_full().  Queueing does not
+ * create a new #GSource, and all the functions queued between two
+ * iterations of @context are run in the same one.
  *
  * Note that, as with normal idle functions, @function should probably
  * return %FALSE.  If it returns %TRUE, it will be continuously run in a
@@ -5455,13 +7501,14 @@ g_main_context_invoke_full (GMainContext   *context,
         }
       else
         {
-          GSource *source;
+          GMainInvocation *invocation;
+
+          invocation = g_slice_new (GMainInvocation);
+          invocation->function = function;
+          invocation->data = data;
+          invocation->notify = notify;
 
-          source = g_idle_source_new ();
-          g_source_set_priority (source, priority);
-          g_source_set_callback (source, function, data, notify);
-          g_source_attach (source, context);
-          g_source_unref (source);
+          g_main_context_push_invocation (context, priority, invocation);
         }
     }
 }
@@ -40,6 +40,24 @@ typedef enum /*< flags >*/
   G_IO_NVAL	GLIB_SYSDEF_POLLNVAL
 } GIOCondition;
 
+/**
+ * GMainContextFlags:
+ * @G_MAIN_CONTEXT_FLAGS_NONE: Default behaviour.
+ * @G_MAIN_CONTEXT_FLAGS_EPOLL: Use a persistent epoll(7) set to wait for
+ *     file descriptors instead of rebuilding a #GPollFD array and calling
+ *     poll() on every iteration.  Ignored where epoll is not available.
+ *
+ * Flags to pass to g_main_context_new_with_flags() which affect the
+ * behaviour of a #GMainContext.
+ *
+ * Since: 2.40
+ */
+typedef enum /*< flags >*/
+{
+  G_MAIN_CONTEXT_FLAGS_NONE = 0,
+  G_MAIN_CONTEXT_FLAGS_EPOLL = 1
+} GMainContextFlags;
+
 
 /**
  * GMainContext:
@@ -129,6 +147,42 @@ typedef struct _GSourceCallbackFuncs    GSourceCallbackFuncs;
  */
 typedef struct _GSourceFuncs            GSourceFuncs;
 
+/**
+ * GSourceStatistics:
+ * @n_dispatches: the number of times the source has been dispatched
+ * @total_dispatch_time: the total time spent in the dispatch function,
+ *     in microseconds
+ * @max_dispatch_time: the longest time spent in a single dispatch,
+ *     in microseconds
+ * @total_latency: the total time, in microseconds, between the source
+ *     becoming ready and its dispatch starting
+ * @max_latency: the longest such latency, in microseconds
+ * @n_deferrals: the number of times the source was ready but left for
+ *     the next iteration because the dispatch budget ran out; see
+ *     g_main_context_set_dispatch_budget()
+ * @n_stalls: the number of times a callback of the source ran for
+ *     longer than the watchdog threshold; see
+ *     g_main_context_set_watchdog()
+ *
+ * Dispatch statistics of a #GSource, as collected while statistics are
+ * enabled on its #GMainContext.  See
+ * g_main_context_set_statistics_enabled().
+ *
+ * Since: 2.40
+ */
+typedef struct _GSourceStatistics       GSourceStatistics;
+
+struct _GSourceStatistics
+{
+  guint64 n_dispatches;
+  gint64  total_dispatch_time;
+  gint64  max_dispatch_time;
+  gint64  total_latency;
+  gint64  max_latency;
+  guint64 n_deferrals;
+  guint64 n_stalls;
+};
+
 /**
  * GPid:
  *
@@ -304,6 +358,8 @@ struct _GSourceFuncs
 
 GLIB_AVAILABLE_IN_ALL
 GMainContext *g_main_context_new       (void);
+GLIB_AVAILABLE_IN_2_40
+GMainContext *g_main_context_new_with_flags (GMainContextFlags flags);
 GLIB_AVAILABLE_IN_ALL
 GMainContext *g_main_context_ref       (GMainContext *context);
 GLIB_AVAILABLE_IN_ALL
@@ -330,6 +386,32 @@ GSource      *g_main_context_find_source_by_funcs_user_data (GMainContext *conte
                                                              GSourceFuncs *funcs,
                                                              gpointer      user_data);
 
+GLIB_AVAILABLE_IN_2_40
+void          g_main_context_set_statistics_enabled (GMainContext *context,
+                                                     gboolean      enabled);
+GLIB_AVAILABLE_IN_2_40
+gboolean      g_main_context_get_statistics_enabled (GMainContext *context);
+GLIB_AVAILABLE_IN_2_40
+gchar        *g_main_context_dump_statistics        (GMainContext *context);
+
+GLIB_AVAILABLE_IN_2_40
+void          g_main_context_set_dispatch_budget    (GMainContext *context,
+                                                     guint         max_dispatches,
+                                                     gint64        max_time);
+GLIB_AVAILABLE_IN_2_40
+void          g_main_context_get_dispatch_budget    (GMainContext *context,
+                                                     guint        *max_dispatches,
+                                                     gint64       *max_time);
+GLIB_AVAILABLE_IN_2_40
+guint64       g_main_context_get_deferred_dispatches (GMainContext *context);
+GLIB_AVAILABLE_IN_2_40
+void          g_main_context_set_watchdog           (GMainContext *context,
+                                                     guint         threshold_ms);
+GLIB_AVAILABLE_IN_2_40
+guint         g_main_context_get_watchdog           (GMainContext *context);
+GLIB_AVAILABLE_IN_2_40
+guint64       g_main_context_get_stalls             (GMainContext *context);
+
 /* Low level functions for implementing custom main loops.
  */
 GLIB_AVAILABLE_IN_ALL
@@ -471,6 +553,10 @@ void                 g_source_set_ready_time (GSource        *source,
 GLIB_AVAILABLE_IN_2_36
 gint64               g_source_get_ready_time (GSource        *source);
 
+GLIB_AVAILABLE_IN_2_40
+gboolean             g_source_get_statistics (GSource           *source,
+                                              GSourceStatistics *statistics);
+
 #ifdef G_OS_UNIX
 GLIB_AVAILABLE_IN_2_36
 gpointer             g_source_add_unix_fd    (GSource        *source,
@@ -514,6 +600,8 @@ void     g_source_get_current_time (GSource        *source,
 
 GLIB_AVAILABLE_IN_ALL
 gint64   g_source_get_time         (GSource        *source);
+GLIB_AVAILABLE_IN_2_40
+gint64   g_source_get_coarse_time  (GSource        *source);
 
  /* void g_source_connect_closure (GSource        *source,
                                   GClosure       *closure);
@@ -536,6 +624,8 @@ GLIB_AVAILABLE_IN_ALL
 void   g_get_current_time                 (GTimeVal       *result);
 GLIB_AVAILABLE_IN_ALL
 gint64 g_get_monotonic_time               (void);
+GLIB_AVAILABLE_IN_2_40
+gint64 g_get_coarse_monotonic_time        (void);
 GLIB_AVAILABLE_IN_ALL
 gint64 g_get_real_time                    (void);
 
@@ -84,21 +84,28 @@ struct _GMappedFile
   gsize  length;
   gpointer free_func;
   int    ref_count;
+  /* the actual mapping; it starts before @contents when the requested
+   * offset was not aligned */
+  gchar *map;
+  gsize  map_length;
 #ifdef G_OS_WIN32
   HANDLE mapping;
 #endif
 };
 
+/* the size transparent huge pages come in on the common architectures */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 static void
 g_mapped_file_destroy (GMappedFile *file)
 {
-  if (file->length)
+  if (file->map_length)
     {
 #ifdef HAVE_MMAP
-      munmap (file->contents, file->length);
+      munmap (file->map, file->map_length);
 #endif
 #ifdef G_OS_WIN32
-      UnmapViewOfFile (file->contents);
+      UnmapViewOfFile (file->map);
       CloseHandle (file->mapping);
 #endif
     }
@@ -106,14 +113,71 @@ g_mapped_file_destroy (GMappedFile *file)
   g_slice_free (GMappedFile, file);
 }
 
+#if defined (HAVE_MMAP) && defined (MAP_ANONYMOUS)
+/* Maps @length bytes at @offset such that the address and the file
+ * offset are congruent modulo the huge page size, which is what the
+ * kernel needs to back a file mapping with transparent huge pages.
+ * Returns MAP_FAILED if that did not work out; the caller then falls
+ * back to a normal mapping.
+ */
+static gchar *
+map_huge_page_aligned (int    fd,
+                       gsize  length,
+                       off_t  offset,
+                       int    prot,
+                       int    flags)
+{
+  gchar *reserved, *aligned, *mem;
+  gsize reserved_length;
+  gsize phase;
+
+  if (length < HUGE_PAGE_SIZE || length > G_MAXSIZE - HUGE_PAGE_SIZE)
+    return MAP_FAILED;
+
+  reserved_length = length + HUGE_PAGE_SIZE;
+  reserved = mmap (NULL, reserved_length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED)
+    return MAP_FAILED;
+
+  phase = offset % HUGE_PAGE_SIZE;
+  aligned = (gchar *) (((gsize) reserved - phase + HUGE_PAGE_SIZE - 1) & ~((gsize) HUGE_PAGE_SIZE - 1)) + phase;
+  if (aligned < reserved)
+    aligned += HUGE_PAGE_SIZE;
+
+  mem = mmap (aligned, length, prot, flags | MAP_FIXED, fd, offset);
+  if (mem == MAP_FAILED)
+    {
+      munmap (reserved, reserved_length);
+      return MAP_FAILED;
+    }
+
+  if (aligned > reserved)
+    munmap (reserved, aligned - reserved);
+  if (aligned + length < reserved + reserved_length)
+    munmap (aligned + length, reserved + reserved_length - (aligned + length));
+
+#ifdef MADV_HUGEPAGE
+  madvise (mem, length, MADV_HUGEPAGE);
+#endif
+
+  return mem;
+}
+#endif
+
 static GMappedFile*
-mapped_file_new_from_fd (int           fd,
-			 gboolean      writable,
-                         const gchar  *filename,
-                         GError      **error)
+mapped_file_new_from_fd (int               fd,
+                         GMappedFileFlags  flags,
+                         goffset           offset,
+                         gsize             length,
+                         const gchar      *filename,
+                         GError          **error)
 {
   GMappedFile *file;
   struct stat st;
+  gboolean writable;
+  gsize delta;
+
+  writable = (flags & G_MAPPED_FILE_FLAGS_WRITABLE) != 0;
 
   file = g_slice_new0 (GMappedFile);
   file->ref_count = 1;
@@ -137,11 +201,28 @@ mapped_file_new_from_fd (int           fd,
       goto out;
     }
 
+  if (S_ISREG (st.st_mode) &&
+      (offset > st.st_size || (goffset) length > st.st_size - offset))
+    {
+      gchar *display_filename = filename ? g_filename_display_name (filename) : NULL;
+
+      g_set_error (error,
+                   G_FILE_ERROR,
+                   G_FILE_ERROR_INVAL,
+                   _("Failed to map %s%s%s%s: the range is outside of the file"),
+		   display_filename ? display_filename : "fd",
+		   display_filename ? "' " : "",
+		   display_filename ? display_filename : "",
+		   display_filename ? "'" : "");
+      g_free (display_filename);
+      goto out;
+    }
+
   /* mmap() on size 0 will fail with EINVAL, so we avoid calling mmap()
    * in that case -- but only if we have a regular file; we still want
    * attempts to mmap a character device to fail, for example.
    */
-  if (st.st_size == 0 && S_ISREG (st.st_mode))
+  if (st.st_size - offset == 0 && S_ISREG (st.st_mode))
     {
       file->length = 0;
       file->contents = NULL;
@@ -151,36 +232,86 @@ mapped_file_new_from_fd (int           fd,
   file->contents = MAP_FAILED;
 
 #ifdef HAVE_MMAP
-  if (st.st_size > G_MAXSIZE)
+  if (length == 0 && st.st_size - offset > G_MAXSIZE)
     {
       errno = EINVAL;
     }
   else
-    {      
-      file->length = (gsize) st.st_size;
-      file->contents = (gchar *) mmap (NULL,  file->length,
-				       writable ? PROT_READ|PROT_WRITE : PROT_READ,
-				       MAP_PRIVATE, fd, 0);
+    {
+      int prot, mmap_flags;
+      off_t map_offset;
+      gsize page_size;
+
+      if (length == 0)
+        length = (gsize) (st.st_size - offset);
+
+      page_size = sysconf (_SC_PAGESIZE);
+      map_offset = offset & ~((goffset) page_size - 1);
+      delta = offset - map_offset;
+
+      prot = writable ? PROT_READ|PROT_WRITE : PROT_READ;
+      mmap_flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+      if (flags & G_MAPPED_FILE_FLAGS_POPULATE)
+        mmap_flags |= MAP_POPULATE;
+#endif
+
+      file->length = length;
+      file->map_length = length + delta;
+      file->map = MAP_FAILED;
+#ifdef MAP_ANONYMOUS
+      if (flags & G_MAPPED_FILE_FLAGS_HUGEPAGES)
+        file->map = map_huge_page_aligned (fd, file->map_length, map_offset, prot, mmap_flags);
+#endif
+      if (file->map == MAP_FAILED)
+        file->map = (gchar *) mmap (NULL, file->map_length, prot, mmap_flags, fd, map_offset);
+
+      if (file->map != MAP_FAILED)
+        {
+#if defined (MADV_SEQUENTIAL) && defined (MADV_RANDOM) && defined (MADV_WILLNEED)
+          if (flags & G_MAPPED_FILE_FLAGS_SEQUENTIAL)
+            madvise (file->map, file->map_length, MADV_SEQUENTIAL);
+          else if (flags & G_MAPPED_FILE_FLAGS_RANDOM)
+            madvise (file->map, file->map_length, MADV_RANDOM);
+          if (flags & G_MAPPED_FILE_FLAGS_WILLNEED)
+            madvise (file->map, file->map_length, MADV_WILLNEED);
+#endif
+          file->contents = file->map + delta;
+        }
+      else
+        file->map_length = 0;
     }
 #endif
 #ifdef G_OS_WIN32
-  file->length = st.st_size;
+  if (length == 0)
+    length = st.st_size - offset;
   file->mapping = CreateFileMapping ((HANDLE) _get_osfhandle (fd), NULL,
 				     writable ? PAGE_WRITECOPY : PAGE_READONLY,
 				     0, 0,
 				     NULL);
   if (file->mapping != NULL)
     {
-      file->contents = MapViewOfFile (file->mapping,
-				      writable ? FILE_MAP_COPY : FILE_MAP_READ,
-				      0, 0,
-				      0);
-      if (file->contents == NULL)
+      SYSTEM_INFO info;
+      guint64 map_offset;
+
+      GetSystemInfo (&info);
+      map_offset = offset - offset % info.dwAllocationGranularity;
+      delta = offset - map_offset;
+
+      file->length = length;
+      file->map_length = length + delta;
+      file->map = MapViewOfFile (file->mapping,
+				 writable ? FILE_MAP_COPY : FILE_MAP_READ,
+				 (DWORD) (map_offset >> 32), (DWORD) map_offset,
+				 file->map_length);
+      if (file->map == NULL)
 	{
-	  file->contents = MAP_FAILED;
+	  file->map_length = 0;
 	  CloseHandle (file->mapping);
 	  file->mapping = NULL;
 	}
+      else
+        file->contents = file->map + delta;
     }
 #endif
 
@@ -211,6 +342,39 @@ mapped_file_new_from_fd (int           fd,
   return NULL;
 }
 
+static GMappedFile *
+mapped_file_new (const gchar       *filename,
+                 GMappedFileFlags   flags,
+                 goffset            offset,
+                 gsize              length,
+                 GError           **error)
+{
+  GMappedFile *file;
+  int fd;
+
+  fd = g_open (filename, ((flags & G_MAPPED_FILE_FLAGS_WRITABLE) ? O_RDWR : O_RDONLY) | _O_BINARY, 0);
+  if (fd == -1)
+    {
+      int save_errno = errno;
+      gchar *display_filename = g_filename_display_name (filename);
+
+      g_set_error (error,
+                   G_FILE_ERROR,
+                   g_file_error_from_errno (save_errno),
+                   _("Failed to open file '%s': open() failed: %s"),
+                   display_filename,
+		   g_strerror (save_errno));
+      g_free (display_filename);
+      return NULL;
+    }
+
+  file = mapped_file_new_from_fd (fd, flags, offset, length, filename, error);
+
+  close (fd);
+
+  return file;
+}
+
 /**
  * g_mapped_file_new:
  * @filename: The path of the file to load, in the GLib filename encoding
@@ -244,36 +408,59 @@ g_mapped_file_new (const gchar  *filename,
 		   gboolean      writable,
 		   GError      **error)
 {
-  GMappedFile *file;
-  int fd;
-
   g_return_val_if_fail (filename != NULL, NULL);
   g_return_val_if_fail (!error || *error == NULL, NULL);
 
-  fd = g_open (filename, (writable ? O_RDWR : O_RDONLY) | _O_BINARY, 0);
-  if (fd == -1)
-    {
-      int save_errno = errno;
-      gchar *display_filename = g_filename_display_name (filename);
-
-      g_set_error (error,
-                   G_FILE_ERROR,
-                   g_file_error_from_errno (save_errno),
-                   _("Failed to open file '%s': open() failed: %s"),
-                   display_filename,
-		   g_strerror (save_errno));
-      g_free (display_filename);
-      return NULL;
-    }
+  return mapped_file_new (filename,
+                          writable ? G_MAPPED_FILE_FLAGS_WRITABLE : G_MAPPED_FILE_FLAGS_NONE,
+                          0, 0, error);
+}
 
-  file = mapped_file_new_from_fd (fd, writable, filename, error);
 
-  close (fd);
+/**
+ * g_mapped_file_new_full:
+ * @filename: The path of the file to load, in the GLib filename encoding
+ * @flags: #GMappedFileFlags for the mapping
+ * @offset: the offset in the file of the first byte to map
+ * @length: the number of bytes to map, or 0 to map up to the end of
+ *     the file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Maps all or part of a file into memory, like g_mapped_file_new(),
+ * but with more control over how the mapping is set up.
+ *
+ * @offset does not need to be aligned to anything; the contents of the
+ * returned #GMappedFile start exactly at @offset.  If the requested
+ * range does not lie within the file, @error will be set to
+ * #G_FILE_ERROR_INVAL.  Mapping only the part of a large file that is
+ * needed keeps the address space use and the amount of page table
+ * setup down.
+ *
+ * The access pattern and prefaulting flags are hints for the kernel
+ * and are silently ignored where they are not supported, as is
+ * %G_MAPPED_FILE_FLAGS_HUGEPAGES.
+ *
+ * Return value: a newly allocated #GMappedFile which must be unref'd
+ *    with g_mapped_file_unref(), or %NULL if the mapping failed.
+ *
+ * Since: 2.40
+ */
+GMappedFile *
+g_mapped_file_new_full (const gchar       *filename,
+                        GMappedFileFlags   flags,
+                        goffset            offset,
+                        gsize              length,
+                        GError           **error)
+{
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (offset >= 0, NULL);
+  g_return_val_if_fail ((flags & (G_MAPPED_FILE_FLAGS_SEQUENTIAL | G_MAPPED_FILE_FLAGS_RANDOM)) !=
+                        (G_MAPPED_FILE_FLAGS_SEQUENTIAL | G_MAPPED_FILE_FLAGS_RANDOM), NULL);
+  g_return_val_if_fail (!error || *error == NULL, NULL);
 
-  return file;
+  return mapped_file_new (filename, flags, offset, length, error);
 }
 
-
 /**
  * g_mapped_file_new_from_fd:
  * @fd: The file descriptor of the file to load
@@ -302,7 +489,9 @@ g_mapped_file_new_from_fd (gint          fd,
 			   gboolean      writable,
 			   GError      **error)
 {
-  return mapped_file_new_from_fd (fd, writable, NULL, error);
+  return mapped_file_new_from_fd (fd,
+                                  writable ? G_MAPPED_FILE_FLAGS_WRITABLE : G_MAPPED_FILE_FLAGS_NONE,
+                                  0, 0, NULL, error);
 }
 
 /**
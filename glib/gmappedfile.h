@@ -33,10 +33,48 @@ G_BEGIN_DECLS
 
 typedef struct _GMappedFile GMappedFile;
 
+/**
+ * GMappedFileFlags:
+ * @G_MAPPED_FILE_FLAGS_NONE: No flags.
+ * @G_MAPPED_FILE_FLAGS_WRITABLE: The mapped buffer may be modified; see
+ *     g_mapped_file_new().
+ * @G_MAPPED_FILE_FLAGS_SEQUENTIAL: The contents will be read mostly
+ *     from start to end, so aggressive read-ahead pays off.
+ * @G_MAPPED_FILE_FLAGS_RANDOM: The contents will be accessed in random
+ *     order, so read-ahead is wasted.
+ * @G_MAPPED_FILE_FLAGS_WILLNEED: Start reading the contents in now, in
+ *     the background.
+ * @G_MAPPED_FILE_FLAGS_POPULATE: Fault all of the mapping in before
+ *     returning, so that later accesses do not page fault.
+ * @G_MAPPED_FILE_FLAGS_HUGEPAGES: Align the mapping so that the kernel
+ *     can back it with transparent huge pages, where the file system
+ *     supports that.
+ *
+ * Flags for g_mapped_file_new_full().
+ *
+ * Since: 2.40
+ */
+typedef enum
+{
+  G_MAPPED_FILE_FLAGS_NONE       = 0,
+  G_MAPPED_FILE_FLAGS_WRITABLE   = 1 << 0,
+  G_MAPPED_FILE_FLAGS_SEQUENTIAL = 1 << 1,
+  G_MAPPED_FILE_FLAGS_RANDOM     = 1 << 2,
+  G_MAPPED_FILE_FLAGS_WILLNEED   = 1 << 3,
+  G_MAPPED_FILE_FLAGS_POPULATE   = 1 << 4,
+  G_MAPPED_FILE_FLAGS_HUGEPAGES  = 1 << 5
+} GMappedFileFlags;
+
 GLIB_AVAILABLE_IN_ALL
 GMappedFile *g_mapped_file_new          (const gchar  *filename,
 				         gboolean      writable,
 				         GError      **error) G_GNUC_MALLOC;
+GLIB_AVAILABLE_IN_2_40
+GMappedFile *g_mapped_file_new_full     (const gchar      *filename,
+                                         GMappedFileFlags  flags,
+                                         goffset           offset,
+                                         gsize             length,
+                                         GError          **error) G_GNUC_MALLOC;
 GLIB_AVAILABLE_IN_ALL
 GMappedFile *g_mapped_file_new_from_fd  (gint          fd,
 					 gboolean      writable,
@@ -805,6 +805,63 @@ advance_char (GMarkupParseContext *context)
   return TRUE;
 }
 
+/* Same as calling advance_char() until reaching @pos, but counts the
+ * lines with memchr().
+ */
+static void
+advance_to (GMarkupParseContext *context,
+            const gchar         *pos)
+{
+  const gchar *last, *p, *newline;
+
+  /* advance_char() looks at each character it moves to, except the
+   * end of the text
+   */
+  last = MIN (pos, context->current_text_end - 1);
+  p = context->iter + 1;
+
+  context->char_number += pos - context->iter;
+  while (p <= last && (newline = memchr (p, '\n', last - p + 1)) != NULL)
+    {
+      context->line_number++;
+      context->char_number = pos - newline + 1;
+      p = newline + 1;
+    }
+
+  context->iter = pos;
+}
+
+/* Moves to the next @c, or the end of the text */
+static void
+advance_to_char (GMarkupParseContext *context,
+                 gchar                c)
+{
+  const gchar *pos;
+
+  pos = memchr (context->iter, c, context->current_text_end - context->iter);
+  advance_to (context, pos ? pos : context->current_text_end);
+}
+
+/* Whether the text between @start and @end can be passed as it is:
+ * if there is nothing to unescape and it is valid.
+ */
+static gboolean
+text_is_verbatim (const gchar *start,
+                  const gchar *end)
+{
+  const gchar *p;
+  gchar mask = 0;
+
+  for (p = start; p < end; p++)
+    {
+      if (*p == '&' || *p == '\r' || *p == '\0')
+        return FALSE;
+      mask |= *p;
+    }
+
+  return !(mask & 0x80) || g_utf8_validate (start, end - start, NULL);
+}
+
 static inline gboolean
 xml_isspace (char c)
 {
@@ -1447,12 +1504,7 @@ g_markup_parse_context_parse (GMarkupParseContext  *context,
                 delim = '"';
               }
 
-            do
-              {
-                if (*context->iter == delim)
-                  break;
-              }
-            while (advance_char (context));
+            advance_to_char (context, delim);
           }
           if (context->iter == context->current_text_end)
             {
@@ -1490,12 +1542,36 @@ g_markup_parse_context_parse (GMarkupParseContext  *context,
 
         case STATE_INSIDE_TEXT:
           /* Possible next states: AFTER_OPEN_ANGLE */
-          do
+          advance_to_char (context, '<');
+
+          if ((context->flags & G_MARKUP_BORROW_TEXT) &&
+              context->iter != context->current_text_end &&
+              (context->partial_chunk == NULL || context->partial_chunk->len == 0) &&
+              text_is_verbatim (context->start, context->iter))
             {
-              if (*context->iter == '<')
-                break;
+              /* The whole text is in the current chunk and needs
+               * no unescaping, pass it without copying.
+               */
+              GError *tmp_error = NULL;
+
+              if (context->parser->text)
+                (*context->parser->text) (context,
+                                          context->start,
+                                          context->iter - context->start,
+                                          context->user_data,
+                                          &tmp_error);
+
+              if (tmp_error == NULL)
+                {
+                  advance_char (context);
+                  context->state = STATE_AFTER_OPEN_ANGLE;
+                  context->start = context->iter;
+                }
+              else
+                propagate_error (context, error, tmp_error);
+
+              break;
             }
-          while (advance_char (context));
 
           /* The text hasn't necessarily ended. Merge with
            * partial chunk, leave state unchanged.
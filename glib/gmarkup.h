@@ -91,6 +91,12 @@ GQuark g_markup_error_quark (void);
  *     attributes and tags, along with their contents.  A qualified
  *     attribute or tag is one that contains ':' in its name (ie: is in
  *     another namespace).  Since: 2.40.
+ * @G_MARKUP_BORROW_TEXT: Allow the text passed to the @text function of
+ *     the parser to point into the data given to
+ *     g_markup_parse_context_parse(), instead of a copy. This is done
+ *     when the text needs no unescaping and is entirely contained in
+ *     that data; the text is then not nul-terminated, so the @text
+ *     function must use the length it is given. Since: 2.40.
  *
  * Flags that affect the behaviour of the parser.
  */
@@ -99,7 +105,8 @@ typedef enum
   G_MARKUP_DO_NOT_USE_THIS_UNSUPPORTED_FLAG = 1 << 0,
   G_MARKUP_TREAT_CDATA_AS_TEXT              = 1 << 1,
   G_MARKUP_PREFIX_ERROR_POSITION            = 1 << 2,
-  G_MARKUP_IGNORE_QUALIFIED                 = 1 << 3
+  G_MARKUP_IGNORE_QUALIFIED                 = 1 << 3,
+  G_MARKUP_BORROW_TEXT                      = 1 << 4
 } GMarkupParseFlags;
 
 /**
@@ -0,0 +1,54 @@
+/* gmem-internal.h - GLib-internal memory API
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_MEM_INTERNAL_H__
+#define __G_MEM_INTERNAL_H__
+
+#if !defined (GLIB_COMPILATION)
+#error "This is a private header"
+#endif
+
+#include "gmem.h"
+
+G_BEGIN_DECLS
+
+/* The sampling heap profiler, see g_mem_profiler_start() */
+extern gboolean g_mem_profiler_active;
+
+void    g_mem_profiler_sample   (gpointer mem,
+                                 gsize    n_bytes);
+void    g_mem_profiler_forget   (gpointer mem);
+void    g_mem_profiler_init     (void);
+
+#define G_MEM_PROFILER_ALLOC(mem, n_bytes) G_STMT_START {       \
+  if (G_UNLIKELY (g_mem_profiler_active) && (mem) != NULL)      \
+    g_mem_profiler_sample ((mem), (n_bytes));                   \
+} G_STMT_END
+
+/* Must come before the memory is released, or it could be handed
+ * out, and sampled, again before it is forgotten.
+ */
+#define G_MEM_PROFILER_FREE(mem) G_STMT_START {                 \
+  if (G_UNLIKELY (g_mem_profiler_active) && (mem) != NULL)      \
+    g_mem_profiler_forget (mem);                                \
+} G_STMT_END
+
+G_END_DECLS
+
+#endif /* __G_MEM_INTERNAL_H__ */
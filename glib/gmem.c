@@ -35,9 +35,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
 
 #include "gslice.h"
 #include "gbacktrace.h"
+#include "gfileutils.h"
+#include "gmem-internal.h"
+#include "gstdio.h"
+#include "gstrfuncs.h"
 #include "gtestutils.h"
 #include "gthread.h"
 #include "glib_trace.h"
@@ -101,6 +112,7 @@ g_malloc (gsize n_bytes)
 
       mem = glib_mem_vtable.malloc (n_bytes);
       TRACE (GLIB_MEM_ALLOC((void*) mem, (unsigned int) n_bytes, 0, 0));
+      G_MEM_PROFILER_ALLOC (mem, n_bytes);
       if (mem)
 	return mem;
 
@@ -131,6 +143,7 @@ g_malloc0 (gsize n_bytes)
 
       mem = glib_mem_vtable.calloc (1, n_bytes);
       TRACE (GLIB_MEM_ALLOC((void*) mem, (unsigned int) n_bytes, 1, 0));
+      G_MEM_PROFILER_ALLOC (mem, n_bytes);
       if (mem)
 	return mem;
 
@@ -162,10 +175,13 @@ g_realloc (gpointer mem,
 {
   gpointer newmem;
 
+  G_MEM_PROFILER_FREE (mem);
+
   if (G_LIKELY (n_bytes))
     {
       newmem = glib_mem_vtable.realloc (mem, n_bytes);
       TRACE (GLIB_MEM_REALLOC((void*) newmem, (void*)mem, (unsigned int) n_bytes, 0));
+      G_MEM_PROFILER_ALLOC (newmem, n_bytes);
       if (newmem)
 	return newmem;
 
@@ -191,6 +207,7 @@ g_realloc (gpointer mem,
 void
 g_free (gpointer mem)
 {
+  G_MEM_PROFILER_FREE (mem);
   if (G_LIKELY (mem))
     glib_mem_vtable.free (mem);
   TRACE(GLIB_MEM_FREE((void*) mem));
@@ -255,6 +272,7 @@ g_try_malloc (gsize n_bytes)
     mem = NULL;
 
   TRACE (GLIB_MEM_ALLOC((void*) mem, (unsigned int) n_bytes, 0, 1));
+  G_MEM_PROFILER_ALLOC (mem, n_bytes);
 
   return mem;
 }
@@ -279,6 +297,8 @@ g_try_malloc0 (gsize n_bytes)
   else
     mem = NULL;
 
+  G_MEM_PROFILER_ALLOC (mem, n_bytes);
+
   if (mem)
     memset (mem, 0, n_bytes);
 
@@ -302,6 +322,9 @@ g_try_realloc (gpointer mem,
 {
   gpointer newmem;
 
+  /* If this fails @mem is kept, but is no longer sampled */
+  G_MEM_PROFILER_FREE (mem);
+
   if (G_LIKELY (n_bytes))
     newmem = glib_mem_vtable.try_realloc (mem, n_bytes);
   else
@@ -312,6 +335,7 @@ g_try_realloc (gpointer mem,
     }
 
   TRACE (GLIB_MEM_REALLOC((void*) newmem, (void*)mem, (unsigned int) n_bytes, 1));
+  G_MEM_PROFILER_ALLOC (newmem, n_bytes);
 
   return newmem;
 }
@@ -652,6 +676,9 @@ profile_print_locked (guint   *local_data,
  * 
  * Note that this function will not output anything unless you have
  * previously installed the #glib_mem_profiler_table with g_mem_set_vtable().
+ *
+ * See g_mem_profiler_start() for a profiler that attributes memory to
+ * the code allocating it and doesn't need to replace the allocator.
  */
 
 void
@@ -860,3 +887,459 @@ static GMemVTable profiler_table = {
 GMemVTable *glib_mem_profiler_table = &profiler_table;
 
 #endif	/* !G_DISABLE_CHECKS */
+
+
+/* --- sampling heap profiler --- */
+
+/* Unlike the profiler table above this doesn't replace the allocator,
+ * so it can be turned on in a running program.  Roughly one allocation
+ * in every mem_profiler_interval bytes is sampled, with the call stack
+ * it came from, and stands in for the allocations between it and the
+ * previous sample.  Everything allocated here is allocated with the
+ * system malloc(), so that the profiler never samples itself.
+ */
+
+#define MEM_PROFILER_DEFAULT_INTERVAL   (512 * 1024)
+#define MEM_PROFILER_MAX_FRAMES         16
+#define MEM_PROFILER_N_SITE_BUCKETS     4096
+#define MEM_PROFILER_N_SAMPLE_BUCKETS   65536
+#define MEM_PROFILER_BUSY               G_MAXSIZE
+
+typedef struct _MemSite MemSite;
+typedef struct _MemSample MemSample;
+
+struct _MemSite
+{
+  MemSite  *next;
+  guint     hash;
+  guint     n_frames;
+  gpointer  frames[MEM_PROFILER_MAX_FRAMES];
+  gsize     n_samples;
+  gsize     total_bytes;
+  gsize     live_bytes;
+};
+
+struct _MemSample
+{
+  MemSample *next;
+  gpointer   mem;
+  MemSite   *site;
+  gsize      weight;
+};
+
+gboolean g_mem_profiler_active = FALSE;
+
+static gsize       mem_profiler_interval;
+static GMutex      mem_profiler_lock;
+static MemSite   **mem_profiler_sites;
+/* Read without the lock by g_mem_profiler_forget() to skip the common
+ * case of memory that wasn't sampled.
+ */
+static MemSample **mem_profiler_samples;
+
+/* The number of bytes this thread can allocate before its next sample,
+ * plus one so that a thread that hasn't allocated yet can be told
+ * apart, or MEM_PROFILER_BUSY while the thread is in the profiler.
+ */
+static GPrivate    mem_profiler_countdown;
+
+static gchar      *mem_profiler_filename;
+static volatile sig_atomic_t mem_profiler_dump_requested;
+
+static inline guint
+mem_profiler_sample_bucket (gpointer mem)
+{
+  return ((guint32) ((GPOINTER_TO_SIZE (mem) >> 4) * 2654435761u)) >> 16;
+}
+
+static gsize
+mem_profiler_next_countdown (gpointer mem)
+{
+  /* The distance to the next sample is jittered, so that allocation
+   * patterns repeating with the interval are not always or never
+   * sampled.  The address just allocated is random enough.
+   */
+  return mem_profiler_interval / 2 +
+         (gsize) ((guint32) (GPOINTER_TO_SIZE (mem) >> 4) * 2654435761u) % mem_profiler_interval;
+}
+
+static void
+mem_profiler_record (gpointer mem,
+                     gsize    n_bytes)
+{
+  gpointer frames[MEM_PROFILER_MAX_FRAMES + 1];
+  MemSample *sample;
+  MemSite *site;
+  guint n_frames = 0;
+  guint hash = 0;
+  guint i;
+
+#ifdef HAVE_EXECINFO_H
+  /* The first frame is the profiler itself */
+  n_frames = MAX (backtrace (frames, G_N_ELEMENTS (frames)), 1) - 1;
+#endif
+  for (i = 0; i < n_frames; i++)
+    hash = hash * 31 + (guint) (GPOINTER_TO_SIZE (frames[i + 1]) >> 2);
+
+  sample = malloc (sizeof (MemSample));
+  if (sample == NULL)
+    return;
+
+  g_mutex_lock (&mem_profiler_lock);
+
+  if (!g_mem_profiler_active)
+    {
+      g_mutex_unlock (&mem_profiler_lock);
+      free (sample);
+      return;
+    }
+
+  for (site = mem_profiler_sites[hash % MEM_PROFILER_N_SITE_BUCKETS]; site; site = site->next)
+    if (site->hash == hash && site->n_frames == n_frames &&
+        memcmp (site->frames, frames + 1, n_frames * sizeof (gpointer)) == 0)
+      break;
+
+  if (site == NULL)
+    {
+      site = calloc (1, sizeof (MemSite));
+      if (site == NULL)
+        {
+          g_mutex_unlock (&mem_profiler_lock);
+          free (sample);
+          return;
+        }
+
+      site->hash = hash;
+      site->n_frames = n_frames;
+      memcpy (site->frames, frames + 1, n_frames * sizeof (gpointer));
+      site->next = mem_profiler_sites[hash % MEM_PROFILER_N_SITE_BUCKETS];
+      mem_profiler_sites[hash % MEM_PROFILER_N_SITE_BUCKETS] = site;
+    }
+
+  sample->mem = mem;
+  sample->site = site;
+  sample->weight = MAX (n_bytes, mem_profiler_interval);
+  site->n_samples++;
+  site->total_bytes += sample->weight;
+  site->live_bytes += sample->weight;
+
+  i = mem_profiler_sample_bucket (mem);
+  sample->next = mem_profiler_samples[i];
+  g_atomic_pointer_set (&mem_profiler_samples[i], sample);
+
+  g_mutex_unlock (&mem_profiler_lock);
+}
+
+void
+g_mem_profiler_sample (gpointer mem,
+                       gsize    n_bytes)
+{
+  gsize countdown;
+
+  countdown = GPOINTER_TO_SIZE (g_private_get (&mem_profiler_countdown));
+  if (countdown == MEM_PROFILER_BUSY)
+    return;
+
+  if (countdown == 0)
+    countdown = mem_profiler_next_countdown (mem) + 1;
+
+  if (n_bytes < countdown - 1)
+    {
+      g_private_set (&mem_profiler_countdown, GSIZE_TO_POINTER (countdown - n_bytes));
+      return;
+    }
+
+  g_private_set (&mem_profiler_countdown, GSIZE_TO_POINTER (MEM_PROFILER_BUSY));
+
+  mem_profiler_record (mem, n_bytes);
+
+  if (G_UNLIKELY (mem_profiler_dump_requested))
+    {
+      mem_profiler_dump_requested = FALSE;
+      g_mem_profiler_dump (mem_profiler_filename, NULL);
+    }
+
+  g_private_set (&mem_profiler_countdown, GSIZE_TO_POINTER (mem_profiler_next_countdown (mem) + 1));
+}
+
+void
+g_mem_profiler_forget (gpointer mem)
+{
+  MemSample **bucket;
+  MemSample **prev;
+  MemSample *sample = NULL;
+
+  bucket = &mem_profiler_samples[mem_profiler_sample_bucket (mem)];
+  if (g_atomic_pointer_get (bucket) == NULL)
+    return;
+
+  g_mutex_lock (&mem_profiler_lock);
+
+  for (prev = bucket; *prev; prev = &(*prev)->next)
+    if ((*prev)->mem == mem)
+      {
+        sample = *prev;
+        *prev = sample->next;
+        sample->site->live_bytes -= sample->weight;
+        break;
+      }
+
+  g_mutex_unlock (&mem_profiler_lock);
+
+  free (sample);
+}
+
+/**
+ * g_mem_profiler_start:
+ * @sample_bytes: the average number of bytes allocated between two
+ *     samples, or 0 for the default of 512 kiB
+ *
+ * Starts the sampling heap profiler, discarding anything it recorded
+ * before.
+ *
+ * While the profiler runs, about one allocation made with g_malloc()
+ * or g_slice_alloc() and their variants in every @sample_bytes bytes
+ * is sampled, together with the call stack it was made from.  Each
+ * sample counts as @sample_bytes bytes, or as its size if that is
+ * larger, towards the totals of its call stack until it is freed.
+ * Use g_mem_profiler_dump() to get at the results.
+ *
+ * Allocations that are not sampled cost one extra branch, so unlike
+ * with #glib_mem_profiler_table this is cheap enough to be used on
+ * programs in production.  The profiler can also be started by setting
+ * the <link linkend="G_MEM_PROFILER"><envar>G_MEM_PROFILER</envar></link>
+ * environment variable.
+ *
+ * Since: 2.40
+ */
+void
+g_mem_profiler_start (gsize sample_bytes)
+{
+  guint i;
+
+  g_mutex_lock (&mem_profiler_lock);
+
+  if (mem_profiler_sites == NULL)
+    {
+      mem_profiler_sites = calloc (MEM_PROFILER_N_SITE_BUCKETS, sizeof (MemSite *));
+      mem_profiler_samples = calloc (MEM_PROFILER_N_SAMPLE_BUCKETS, sizeof (MemSample *));
+      if (mem_profiler_sites == NULL || mem_profiler_samples == NULL)
+        g_error ("%s: failed to allocate the heap profiler tables", G_STRLOC);
+    }
+
+  /* Memory freed while the profiler was stopped may have been sampled */
+  for (i = 0; i < MEM_PROFILER_N_SAMPLE_BUCKETS; i++)
+    while (mem_profiler_samples[i])
+      {
+        MemSample *sample = mem_profiler_samples[i];
+
+        mem_profiler_samples[i] = sample->next;
+        free (sample);
+      }
+
+  for (i = 0; i < MEM_PROFILER_N_SITE_BUCKETS; i++)
+    while (mem_profiler_sites[i])
+      {
+        MemSite *site = mem_profiler_sites[i];
+
+        mem_profiler_sites[i] = site->next;
+        free (site);
+      }
+
+  mem_profiler_interval = sample_bytes ? sample_bytes : MEM_PROFILER_DEFAULT_INTERVAL;
+  g_atomic_int_set (&g_mem_profiler_active, TRUE);
+
+  g_mutex_unlock (&mem_profiler_lock);
+}
+
+/**
+ * g_mem_profiler_stop:
+ *
+ * Stops the sampling heap profiler started with g_mem_profiler_start().
+ * What it recorded so far can still be dumped with g_mem_profiler_dump().
+ *
+ * Since: 2.40
+ */
+void
+g_mem_profiler_stop (void)
+{
+  g_mutex_lock (&mem_profiler_lock);
+  g_atomic_int_set (&g_mem_profiler_active, FALSE);
+  g_mutex_unlock (&mem_profiler_lock);
+}
+
+static int
+mem_site_compare (const void *a,
+                  const void *b)
+{
+  const MemSite *site_a = *(MemSite * const *) a;
+  const MemSite *site_b = *(MemSite * const *) b;
+
+  if (site_a->live_bytes != site_b->live_bytes)
+    return site_a->live_bytes < site_b->live_bytes ? 1 : -1;
+  if (site_a->total_bytes != site_b->total_bytes)
+    return site_a->total_bytes < site_b->total_bytes ? 1 : -1;
+  return 0;
+}
+
+/**
+ * g_mem_profiler_dump:
+ * @filename: the file to write the profile to
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes what the sampling heap profiler has recorded to @filename.
+ *
+ * The file is text.  After two comment lines starting with '#', there
+ * is an entry for every call stack that allocations were sampled
+ * from, the ones holding the most memory first.  An entry is a line
+ * with the estimated number of bytes allocated from the call stack
+ * that are still live, the estimated number of bytes ever allocated
+ * from it and the number of samples, followed by the call stack, one
+ * frame per line, and an empty line.
+ *
+ * Returns: %TRUE if the profile was written
+ *
+ * Since: 2.40
+ */
+gboolean
+g_mem_profiler_dump (const gchar  *filename,
+                     GError      **error)
+{
+  gpointer countdown;
+  MemSite **sites = NULL;
+  gsize n_sites = 0;
+  gboolean ret;
+  FILE *file;
+  int errsv;
+  gsize i;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* Don't sample stdio's allocations while holding the lock */
+  countdown = g_private_get (&mem_profiler_countdown);
+  g_private_set (&mem_profiler_countdown, GSIZE_TO_POINTER (MEM_PROFILER_BUSY));
+
+  file = g_fopen (filename, "w");
+  if (file == NULL)
+    {
+      errsv = errno;
+      g_private_set (&mem_profiler_countdown, countdown);
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                   "Failed to open '%s' for writing: %s",
+                   filename, g_strerror (errsv));
+      return FALSE;
+    }
+
+  g_mutex_lock (&mem_profiler_lock);
+
+  if (mem_profiler_sites != NULL)
+    {
+      MemSite *site;
+
+      for (i = 0; i < MEM_PROFILER_N_SITE_BUCKETS; i++)
+        for (site = mem_profiler_sites[i]; site; site = site->next)
+          n_sites++;
+
+      sites = malloc (MAX (n_sites, 1) * sizeof (MemSite *));
+      n_sites = 0;
+      if (sites != NULL)
+        for (i = 0; i < MEM_PROFILER_N_SITE_BUCKETS; i++)
+          for (site = mem_profiler_sites[i]; site; site = site->next)
+            sites[n_sites++] = site;
+
+      qsort (sites, n_sites, sizeof (MemSite *), mem_site_compare);
+    }
+
+  fprintf (file, "# GLib heap profile, one sample every %" G_GSIZE_FORMAT " bytes\n"
+           "# live-bytes total-bytes samples, then the call stack\n",
+           mem_profiler_interval);
+
+  for (i = 0; i < n_sites; i++)
+    {
+      fprintf (file, "%" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT "\n",
+               sites[i]->live_bytes, sites[i]->total_bytes, sites[i]->n_samples);
+#ifdef HAVE_EXECINFO_H
+      fflush (file);
+      backtrace_symbols_fd (sites[i]->frames, sites[i]->n_frames, fileno (file));
+#endif
+      fputc ('\n', file);
+    }
+
+  g_mutex_unlock (&mem_profiler_lock);
+
+  free (sites);
+
+  ret = !ferror (file);
+  errsv = errno;
+  if (fclose (file) != 0 && ret)
+    {
+      ret = FALSE;
+      errsv = errno;
+    }
+
+  g_private_set (&mem_profiler_countdown, countdown);
+
+  if (!ret)
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                 "Failed to write '%s': %s",
+                 filename, g_strerror (errsv));
+
+  return ret;
+}
+
+static void
+mem_profiler_dump_at_exit (void)
+{
+  g_mem_profiler_dump (mem_profiler_filename, NULL);
+}
+
+#ifdef G_OS_UNIX
+static void
+mem_profiler_request_dump (int signum)
+{
+  /* Dumping isn't async-signal safe, so the next sample does it */
+  mem_profiler_dump_requested = TRUE;
+}
+#endif
+
+/* Called from glib_init(), see G_MEM_PROFILER in running.xml */
+void
+g_mem_profiler_init (void)
+{
+  const gchar *value;
+  const gchar *filename;
+  gchar *end;
+  gsize sample_bytes;
+
+  value = getenv ("G_MEM_PROFILER");
+  if (value == NULL)
+    return;
+
+  sample_bytes = strtoul (value, &end, 10);
+  if (end == value)
+    sample_bytes = 0;
+
+  filename = getenv ("G_MEM_PROFILER_FILE");
+#ifdef G_OS_UNIX
+  if (filename == NULL)
+    mem_profiler_filename = g_strdup_printf ("glib-heap-profile.%d", (int) getpid ());
+  else
+#endif
+    mem_profiler_filename = g_strdup (filename ? filename : "glib-heap-profile");
+
+  g_mem_profiler_start (sample_bytes);
+  atexit (mem_profiler_dump_at_exit);
+
+#ifdef G_OS_UNIX
+  {
+    struct sigaction action;
+
+    memset (&action, 0, sizeof action);
+    action.sa_handler = mem_profiler_request_dump;
+    action.sa_flags = SA_RESTART;
+    sigemptyset (&action.sa_mask);
+    sigaction (SIGUSR2, &action, NULL);
+  }
+#endif
+}
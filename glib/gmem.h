@@ -31,6 +31,7 @@
 #error "Only <glib.h> can be included directly."
 #endif
 
+#include <glib/gerror.h>
 #include <glib/gtypes.h>
 
 G_BEGIN_DECLS
@@ -296,6 +297,16 @@ GLIB_VAR GMemVTable	*glib_mem_profiler_table;
 GLIB_AVAILABLE_IN_ALL
 void	g_mem_profile	(void);
 
+/* Sampling heap profiler
+ */
+GLIB_AVAILABLE_IN_2_40
+void     g_mem_profiler_start (gsize         sample_bytes);
+GLIB_AVAILABLE_IN_2_40
+void     g_mem_profiler_stop  (void);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_mem_profiler_dump  (const gchar  *filename,
+                               GError      **error);
+
 G_END_DECLS
 
 #endif /* __G_MEM_H__ */
@@ -23,9 +23,12 @@
 
 #include "gpattern.h"
 
+#include "garray.h"
+#include "ghash.h"
 #include "gmacros.h"
 #include "gmessages.h"
 #include "gmem.h"
+#include "gstrfuncs.h"
 #include "gunicode.h"
 #include "gutils.h" 
 
@@ -79,86 +82,137 @@ struct _GPatternSpec
   guint      min_length;
   guint      max_length;
   gchar     *pattern;
+  gchar     *forward;    /* G_MATCH_ALL_TAIL: the pattern, not reversed */
 };
 
 
 /* --- functions --- */
-static inline gboolean
-g_pattern_ph_match (const gchar *match_pattern,
-		    const gchar *match_string,
-		    gboolean    *wildcard_reached_p)
+
+/* Matches the wildcard free @segment at the start of @string, returning
+ * the end of the match, or %NULL.
+ */
+static inline const gchar *
+g_pattern_segment_match (const gchar *segment,
+                         guint        segment_length,
+                         const gchar *string,
+                         const gchar *string_end)
 {
-  register const gchar *pattern, *string;
-  register gchar ch;
+  guint i;
+
+  for (i = 0; i < segment_length; i++)
+    {
+      if (string >= string_end)
+        return NULL;
+      if (segment[i] == '?')
+        string = g_utf8_next_char (string);
+      else if (segment[i] == *string)
+        string++;
+      else
+        return NULL;
+    }
 
-  pattern = match_pattern;
-  string = match_string;
+  return string <= string_end ? string : NULL;
+}
 
-  ch = *pattern;
-  pattern++;
-  while (ch)
+/* Matches @segment at the end of the string between @string and
+ * @string_end, returning the start of the match, or %NULL.
+ */
+static inline const gchar *
+g_pattern_segment_match_tail (const gchar *segment,
+                              guint        segment_length,
+                              const gchar *string,
+                              const gchar *string_end)
+{
+  guint i;
+
+  for (i = segment_length; i > 0; i--)
     {
-      switch (ch)
-	{
-	case '?':
-	  if (!*string)
-	    return FALSE;
-	  string = g_utf8_next_char (string);
-	  break;
+      if (string_end <= string)
+        return NULL;
+      if (segment[i - 1] == '?')
+        {
+          string_end = g_utf8_find_prev_char (string, string_end);
+          if (string_end == NULL)
+            return NULL;
+        }
+      else if (segment[i - 1] == string_end[-1])
+        string_end--;
+      else
+        return NULL;
+    }
 
-	case '*':
-	  *wildcard_reached_p = TRUE;
-	  do
-	    {
-	      ch = *pattern;
-	      pattern++;
-	      if (ch == '?')
-		{
-		  if (!*string)
-		    return FALSE;
-		  string = g_utf8_next_char (string);
-		}
-	    }
-	  while (ch == '*' || ch == '?');
-	  if (!ch)
-	    return TRUE;
-	  do
-	    {
-              gboolean next_wildcard_reached = FALSE;
-	      while (ch != *string)
-		{
-		  if (!*string)
-		    return FALSE;
-		  string = g_utf8_next_char (string);
-		}
-	      string++;
-	      if (g_pattern_ph_match (pattern, string, &next_wildcard_reached))
-		return TRUE;
-              if (next_wildcard_reached)
-                /* the forthcoming pattern substring up to the next wildcard has
-                 * been matched, but a mismatch occoured for the rest of the
-                 * pattern, following the next wildcard.
-                 * there's no need to advance the current match position any
-                 * further if the rest pattern will not match.
-                 */
-		return FALSE;
-	    }
-	  while (*string);
-	  break;
+  return string_end;
+}
 
-	default:
-	  if (ch == *string)
-	    string++;
-	  else
-	    return FALSE;
-	  break;
-	}
+/* Matches a canonical pattern, i.e. one without consecutive '*', by
+ * splitting it into the segments between the wildcards.  The first
+ * segment is anchored at the start of the string and the last one at
+ * the end.  The ones in between each match at a fixed number of
+ * characters, so placing each of them as far to the left as possible
+ * leaves the most room for the rest and no backtracking is needed.
+ */
+static gboolean
+g_pattern_ph_match (const gchar *pattern,
+                    guint        pattern_length,
+                    const gchar *string,
+                    guint        string_length)
+{
+  const gchar *pattern_end = pattern + pattern_length;
+  const gchar *string_end = string + string_length;
+  const gchar *first_wildcard, *last_wildcard;
+
+  first_wildcard = memchr (pattern, '*', pattern_length);
+  if (first_wildcard == NULL)
+    return g_pattern_segment_match (pattern, pattern_length,
+                                    string, string_end) == string_end;
+
+  string = g_pattern_segment_match (pattern, first_wildcard - pattern,
+                                    string, string_end);
+  if (string == NULL)
+    return FALSE;
+
+  last_wildcard = pattern_end - 1;
+  while (*last_wildcard != '*')
+    last_wildcard--;
+
+  string_end = g_pattern_segment_match_tail (last_wildcard + 1,
+                                             pattern_end - last_wildcard - 1,
+                                             string, string_end);
+  if (string_end == NULL)
+    return FALSE;
 
-      ch = *pattern;
-      pattern++;
+  pattern = first_wildcard + 1;
+  while (pattern < last_wildcard)
+    {
+      const gchar *segment_end = memchr (pattern, '*', last_wildcard + 1 - pattern);
+      guint segment_length = segment_end - pattern;
+      const gchar *match = NULL;
+      const gchar *s = string;
+
+      if (pattern[0] != '?')
+        {
+          /* skip ahead to the candidates quickly */
+          while (match == NULL &&
+                 (s = memchr (s, pattern[0], string_end - s)) != NULL)
+            {
+              match = g_pattern_segment_match (pattern, segment_length, s, string_end);
+              s++;
+            }
+        }
+      else
+        {
+          for (; match == NULL && s < string_end; s = g_utf8_next_char (s))
+            match = g_pattern_segment_match (pattern, segment_length, s, string_end);
+        }
+
+      if (match == NULL)
+        return FALSE;
+
+      string = match;
+      pattern = segment_end + 1;
     }
 
-  return *string == 0;
+  return TRUE;
 }
 
 /**
@@ -170,23 +224,12 @@ g_pattern_ph_match (const gchar *match_pattern,
  * @string_reversed: (allow-none): the reverse of @string or %NULL
  *
  * Matches a string against a compiled pattern. Passing the correct
- * length of the string given is mandatory. The reversed string can be
- * omitted by passing %NULL, this is more efficient if the reversed
- * version of the string to be matched is not at hand, as
- * g_pattern_match() will only construct it if the compiled pattern
- * requires reverse matches.
- *
- * Note that, if the user code will (possibly) match a string against a
- * multitude of patterns containing wildcards, chances are high that
- * some patterns will require a reversed string. In this case, it's
- * more efficient to provide the reversed string to avoid multiple
- * constructions thereof in the various calls to g_pattern_match().
- *
- * Note also that the reverse of a UTF-8 encoded string can in general
- * <emphasis>not</emphasis> be obtained by g_strreverse(). This works
- * only if the string doesn't contain any multibyte characters. GLib
- * offers the g_utf8_strreverse() function to reverse UTF-8 encoded
- * strings.
+ * length of the string given is mandatory.
+ *
+ * Since GLib 2.40, @string_reversed is not used any more: patterns are
+ * matched without reversing the string, and passing %NULL costs
+ * nothing. To match a string against many patterns, consider using a
+ * #GPatternSpecSet.
  *
  * Returns: %TRUE if @string matches @pspec
  **/
@@ -205,21 +248,12 @@ g_pattern_match (GPatternSpec *pspec,
 
   switch (pspec->match_type)
     {
-      gboolean dummy;
     case G_MATCH_ALL:
-      return g_pattern_ph_match (pspec->pattern, string, &dummy);
+      return g_pattern_ph_match (pspec->pattern, pspec->pattern_length,
+                                 string, string_length);
     case G_MATCH_ALL_TAIL:
-      if (string_reversed)
-	return g_pattern_ph_match (pspec->pattern, string_reversed, &dummy);
-      else
-	{
-          gboolean result;
-          gchar *tmp;
-	  tmp = g_utf8_strreverse (string, string_length);
-	  result = g_pattern_ph_match (pspec->pattern, tmp, &dummy);
-	  g_free (tmp);
-	  return result;
-	}
+      return g_pattern_ph_match (pspec->forward, pspec->pattern_length,
+                                 string, string_length);
     case G_MATCH_HEAD:
       if (pspec->pattern_length == string_length)
 	return strcmp (pspec->pattern, string) == 0;
@@ -271,6 +305,7 @@ g_pattern_spec_new (const gchar *pattern)
   pspec->min_length = 0;
   pspec->max_length = 0;
   pspec->pattern = g_new (gchar, pspec->pattern_length + 1);
+  pspec->forward = NULL;
   d = pspec->pattern;
   for (i = 0, s = pattern; *s != 0; s++)
     {
@@ -352,9 +387,8 @@ g_pattern_spec_new (const gchar *pattern)
   else /* seen_joker */
     pspec->match_type = tj_pos > hj_pos ? G_MATCH_ALL_TAIL : G_MATCH_ALL;
   if (pspec->match_type == G_MATCH_ALL_TAIL) {
-    gchar *tmp = pspec->pattern;
+    pspec->forward = pspec->pattern;
     pspec->pattern = g_utf8_strreverse (pspec->pattern, pspec->pattern_length);
-    g_free (tmp);
   }
   return pspec;
 }
@@ -371,6 +405,7 @@ g_pattern_spec_free (GPatternSpec *pspec)
   g_return_if_fail (pspec != NULL);
 
   g_free (pspec->pattern);
+  g_free (pspec->forward);
   g_free (pspec);
 }
 
@@ -402,8 +437,8 @@ g_pattern_spec_equal (GPatternSpec *pspec1,
  * @string: the UTF-8 encoded string to match
  *
  * Matches a string against a compiled pattern. If the string is to be
- * matched against more than one pattern, consider using
- * g_pattern_match() instead while supplying the reversed string.
+ * matched against more than one pattern, consider using a
+ * #GPatternSpecSet.
  *
  * Returns: %TRUE if @string matches @pspec
  **/
@@ -445,3 +480,291 @@ g_pattern_match_simple (const gchar *pattern,
 
   return ergo;
 }
+
+/**
+ * GPatternSpecSet:
+ *
+ * A <structname>GPatternSpecSet</structname> is a collection of
+ * patterns that are matched against a string together, see
+ * g_pattern_spec_set_match(). This structure is opaque and its fields
+ * cannot be accessed directly.
+ *
+ * Since: 2.40
+ **/
+
+/* Patterns that start or end with literal text are filed in a hash
+ * table under (at most PATTERN_SET_MAX_KEY bytes of) that text, so
+ * that matching a string only has to look at the patterns filed under
+ * the string's own beginnings and endings of the few key lengths in
+ * use.  Patterns with wildcards at both ends are tried one by one.
+ */
+#define PATTERN_SET_MAX_KEY 8
+
+struct _GPatternSpecSet
+{
+  GPtrArray  *specs;
+  GHashTable *prefixes;        /* key -> GArray of indexes */
+  GHashTable *suffixes;
+  guint       prefix_lengths;  /* bit n set if a key of length n is used */
+  guint       suffix_lengths;
+  GArray     *unkeyed;
+};
+
+/**
+ * g_pattern_spec_set_new:
+ *
+ * Creates a new, empty #GPatternSpecSet. Add patterns to it with
+ * g_pattern_spec_set_add().
+ *
+ * Returns: a newly-allocated #GPatternSpecSet
+ *
+ * Since: 2.40
+ **/
+GPatternSpecSet *
+g_pattern_spec_set_new (void)
+{
+  GPatternSpecSet *set;
+
+  set = g_new (GPatternSpecSet, 1);
+  set->specs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_pattern_spec_free);
+  set->prefixes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, (GDestroyNotify) g_array_unref);
+  set->suffixes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, (GDestroyNotify) g_array_unref);
+  set->prefix_lengths = 0;
+  set->suffix_lengths = 0;
+  set->unkeyed = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return set;
+}
+
+/**
+ * g_pattern_spec_set_free:
+ * @set: a #GPatternSpecSet
+ *
+ * Frees the memory allocated for the #GPatternSpecSet and its patterns.
+ *
+ * Since: 2.40
+ **/
+void
+g_pattern_spec_set_free (GPatternSpecSet *set)
+{
+  g_return_if_fail (set != NULL);
+
+  g_ptr_array_unref (set->specs);
+  g_hash_table_unref (set->prefixes);
+  g_hash_table_unref (set->suffixes);
+  g_array_unref (set->unkeyed);
+  g_free (set);
+}
+
+static void
+g_pattern_spec_set_file (GHashTable  *table,
+                         const gchar *key,
+                         guint        key_length,
+                         guint        index)
+{
+  GArray *indexes;
+  gchar *tmp;
+
+  tmp = g_strndup (key, key_length);
+  indexes = g_hash_table_lookup (table, tmp);
+  if (indexes == NULL)
+    {
+      indexes = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (table, tmp, indexes);
+    }
+  else
+    g_free (tmp);
+
+  g_array_append_val (indexes, index);
+}
+
+/**
+ * g_pattern_spec_set_add:
+ * @set: a #GPatternSpecSet
+ * @pattern: a zero-terminated UTF-8 encoded pattern
+ *
+ * Compiles @pattern and adds it to @set.
+ *
+ * Returns: the index of the pattern in @set, as reported by
+ *     g_pattern_spec_set_match(). Patterns are numbered from 0 in the
+ *     order they are added.
+ *
+ * Since: 2.40
+ **/
+guint
+g_pattern_spec_set_add (GPatternSpecSet *set,
+                        const gchar     *pattern)
+{
+  GPatternSpec *pspec;
+  const gchar *forward;
+  guint prefix_length, suffix_length;
+  guint index;
+
+  g_return_val_if_fail (set != NULL, 0);
+  g_return_val_if_fail (pattern != NULL, 0);
+
+  pspec = g_pattern_spec_new (pattern);
+  index = set->specs->len;
+  g_ptr_array_add (set->specs, pspec);
+
+  forward = pspec->forward ? pspec->forward : pspec->pattern;
+  switch (pspec->match_type)
+    {
+    case G_MATCH_HEAD:
+      prefix_length = pspec->pattern_length;
+      suffix_length = 0;
+      break;
+    case G_MATCH_TAIL:
+      prefix_length = 0;
+      suffix_length = pspec->pattern_length;
+      break;
+    case G_MATCH_EXACT:
+      prefix_length = pspec->pattern_length;
+      suffix_length = pspec->pattern_length;
+      break;
+    default:
+      prefix_length = strcspn (forward, "*?");
+      for (suffix_length = 0; suffix_length < pspec->pattern_length; suffix_length++)
+        {
+          gchar c = forward[pspec->pattern_length - 1 - suffix_length];
+          if (c == '*' || c == '?')
+            break;
+        }
+      break;
+    }
+
+  prefix_length = MIN (prefix_length, PATTERN_SET_MAX_KEY);
+  suffix_length = MIN (suffix_length, PATTERN_SET_MAX_KEY);
+
+  if (prefix_length > 0 && prefix_length >= suffix_length)
+    {
+      g_pattern_spec_set_file (set->prefixes, forward, prefix_length, index);
+      set->prefix_lengths |= 1 << prefix_length;
+    }
+  else if (suffix_length > 0)
+    {
+      g_pattern_spec_set_file (set->suffixes,
+                               forward + pspec->pattern_length - suffix_length,
+                               suffix_length, index);
+      set->suffix_lengths |= 1 << suffix_length;
+    }
+  else
+    g_array_append_val (set->unkeyed, index);
+
+  return index;
+}
+
+/* Matches the patterns in @indexes, returns TRUE if one of them
+ * matched and @matches is %NULL.
+ */
+static gboolean
+g_pattern_spec_set_try (GPatternSpecSet *set,
+                        GArray          *indexes,
+                        guint            string_length,
+                        const gchar     *string,
+                        GArray          *matches)
+{
+  guint i;
+
+  if (indexes == NULL)
+    return FALSE;
+
+  for (i = 0; i < indexes->len; i++)
+    {
+      guint index = g_array_index (indexes, guint, i);
+
+      if (g_pattern_match (g_ptr_array_index (set->specs, index),
+                           string_length, string, NULL))
+        {
+          if (matches == NULL)
+            return TRUE;
+          g_array_append_val (matches, index);
+        }
+    }
+
+  return FALSE;
+}
+
+static gint
+compare_index (gconstpointer a,
+               gconstpointer b)
+{
+  guint index_a = *(const guint *) a;
+  guint index_b = *(const guint *) b;
+
+  return index_a < index_b ? -1 : index_a > index_b;
+}
+
+/**
+ * g_pattern_spec_set_match:
+ * @set: a #GPatternSpecSet
+ * @string_length: the length of @string (in bytes, i.e. strlen(),
+ *                 <emphasis>not</emphasis> g_utf8_strlen())
+ * @string: the UTF-8 encoded string to match
+ * @matches: (allow-none) (element-type guint): a #GArray of #guint to
+ *     store the indexes of the matching patterns in, or %NULL
+ *
+ * Finds the patterns of @set that match @string.
+ *
+ * Only the patterns that can possibly match are tried: the ones
+ * starting or ending with literal text are looked up by the beginning
+ * and the end of @string, so the cost of a match mostly depends on the
+ * number of patterns that start and end with wildcards, not on the
+ * size of @set.
+ *
+ * If @matches is not %NULL, it is cleared and then filled with the
+ * indexes of all the matching patterns, in increasing order. If
+ * @matches is %NULL, matching stops at the first pattern that matches.
+ *
+ * Returns: %TRUE if at least one pattern matched
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_pattern_spec_set_match (GPatternSpecSet *set,
+                          guint            string_length,
+                          const gchar     *string,
+                          GArray          *matches)
+{
+  gchar key[PATTERN_SET_MAX_KEY + 1];
+  guint length;
+
+  g_return_val_if_fail (set != NULL, FALSE);
+  g_return_val_if_fail (string != NULL, FALSE);
+
+  if (matches != NULL)
+    g_array_set_size (matches, 0);
+
+  for (length = 1; length <= MIN (string_length, PATTERN_SET_MAX_KEY); length++)
+    {
+      if (set->prefix_lengths & (1 << length))
+        {
+          memcpy (key, string, length);
+          key[length] = 0;
+          if (g_pattern_spec_set_try (set, g_hash_table_lookup (set->prefixes, key),
+                                      string_length, string, matches))
+            return TRUE;
+        }
+
+      if (set->suffix_lengths & (1 << length))
+        {
+          memcpy (key, string + string_length - length, length);
+          key[length] = 0;
+          if (g_pattern_spec_set_try (set, g_hash_table_lookup (set->suffixes, key),
+                                      string_length, string, matches))
+            return TRUE;
+        }
+    }
+
+  if (g_pattern_spec_set_try (set, set->unkeyed, string_length, string, matches))
+    return TRUE;
+
+  if (matches == NULL)
+    return FALSE;
+
+  g_array_sort (matches, compare_index);
+
+  return matches->len > 0;
+}
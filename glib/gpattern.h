@@ -24,12 +24,13 @@
 #error "Only <glib.h> can be included directly."
 #endif
 
-#include <glib/gtypes.h>
+#include <glib/garray.h>
 
 G_BEGIN_DECLS
 
 
 typedef struct _GPatternSpec    GPatternSpec;
+typedef struct _GPatternSpecSet GPatternSpecSet;
 
 GLIB_AVAILABLE_IN_ALL
 GPatternSpec* g_pattern_spec_new       (const gchar  *pattern);
@@ -50,6 +51,19 @@ GLIB_AVAILABLE_IN_ALL
 gboolean      g_pattern_match_simple   (const gchar  *pattern,
 					const gchar  *string);
 
+GLIB_AVAILABLE_IN_2_40
+GPatternSpecSet * g_pattern_spec_set_new   (void);
+GLIB_AVAILABLE_IN_2_40
+void              g_pattern_spec_set_free  (GPatternSpecSet *set);
+GLIB_AVAILABLE_IN_2_40
+guint             g_pattern_spec_set_add   (GPatternSpecSet *set,
+                                            const gchar     *pattern);
+GLIB_AVAILABLE_IN_2_40
+gboolean          g_pattern_spec_set_match (GPatternSpecSet *set,
+                                            guint            string_length,
+                                            const gchar     *string,
+                                            GArray          *matches);
+
 G_END_DECLS
 
 #endif /* __G_PATTERN_H__ */
@@ -66,6 +66,54 @@ struct msort_param
 
 static void msort_with_tmp (const struct msort_param *p, void *b, size_t n);
 
+/* Runs of at most this many elements are sorted by binary insertion,
+   which needs about as many comparisons as merging them but no
+   recursion and no copying through the temporary array.  */
+#define MSORT_INSERTION_THRESHOLD 16
+
+static inline int
+msort_cmp (const struct msort_param *p, const void *a, const void *b)
+{
+  /* Indirect sorting, compare the elements pointed to.  */
+  if (p->var == 3)
+    return (*p->cmp) (*(const void **) a, *(const void **) b, p->arg);
+
+  return (*p->cmp) (a, b, p->arg);
+}
+
+static void
+msort_insertion (const struct msort_param *p, char *b, size_t n)
+{
+  const size_t s = p->s;
+  char *tmp = p->t;
+  size_t i, lo, hi, mid;
+
+  for (i = 1; i < n; i++)
+    {
+      char *x = b + i * s;
+
+      /* Already in place, the common case for presorted input.  */
+      if (msort_cmp (p, x - s, x) <= 0)
+	continue;
+
+      /* Insert after all elements comparing equal, to stay stable.  */
+      lo = 0;
+      hi = i - 1;
+      while (lo < hi)
+	{
+	  mid = lo + (hi - lo) / 2;
+	  if (msort_cmp (p, b + mid * s, x) <= 0)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+
+      memcpy (tmp, x, s);
+      memmove (b + (lo + 1) * s, b + lo * s, (i - lo) * s);
+      memcpy (b + lo * s, tmp, s);
+    }
+}
+
 static void
 msort_with_tmp (const struct msort_param *p, void *b, size_t n)
 {
@@ -79,6 +127,12 @@ msort_with_tmp (const struct msort_param *p, void *b, size_t n)
   if (n <= 1)
     return;
 
+  if (n <= MSORT_INSERTION_THRESHOLD)
+    {
+      msort_insertion (p, b, n);
+      return;
+    }
+
   n1 = n / 2;
   n2 = n - n1;
   b1 = b;
@@ -87,6 +141,10 @@ msort_with_tmp (const struct msort_param *p, void *b, size_t n)
   msort_with_tmp (p, b1, n1);
   msort_with_tmp (p, b2, n2);
 
+  /* The halves don't overlap, nothing to merge.  */
+  if (msort_cmp (p, b2 - s, b2) <= 0)
+    return;
+
   switch (p->var)
     {
     case 0:
@@ -43,12 +43,24 @@
 #include "glib_trace.h"
 
 #define QUARK_BLOCK_SIZE         2048
-#define QUARK_STRING_BLOCK_SIZE (4096 - sizeof (gsize))
+#define QUARK_STRING_BLOCK_SIZE (16384 - sizeof (gsize))
+#define QUARK_TABLE_MIN_SIZE     1024
+
+/* An open addressing hash table of quarks, keyed by their strings.
+ * Quarks are never removed, and a full table is replaced by a larger
+ * copy (leaking the old one, like the quarks array), so existing quarks
+ * can be looked up without taking quark_global.
+ */
+typedef struct
+{
+  guint  mask;
+  GQuark quarks[1]; /* Flexible array, 0 marks an empty slot */
+} QuarkTable;
 
 static inline GQuark  quark_new (gchar *string);
 
 G_LOCK_DEFINE_STATIC (quark_global);
-static GHashTable    *quark_ht = NULL;
+static QuarkTable    *quark_table = NULL;
 static gchar        **quarks = NULL;
 static gint           quark_seq_id = 0;
 static gchar         *quark_block = NULL;
@@ -106,6 +118,69 @@ static gint           quark_block_offset = 0;
  * Since: 2.34
  */
 
+/* Doesn't need quark_global */
+static GQuark
+quark_lookup (const gchar *string)
+{
+  QuarkTable *table;
+  GQuark quark;
+  guint i;
+
+  table = g_atomic_pointer_get (&quark_table);
+  if (table == NULL)
+    return 0;
+
+  for (i = g_str_hash (string) & table->mask;
+       (quark = g_atomic_int_get ((gint *) &table->quarks[i])) != 0;
+       i = (i + 1) & table->mask)
+    {
+      /* the quarks array is published before the table slot */
+      gchar **strings = g_atomic_pointer_get (&quarks);
+
+      if (strcmp (strings[quark], string) == 0)
+        return quark;
+    }
+
+  return 0;
+}
+
+/* HOLDS: quark_global_lock */
+static void
+quark_table_add (QuarkTable *table,
+                 GQuark      quark)
+{
+  guint i;
+
+  i = g_str_hash (quarks[quark]) & table->mask;
+  while (table->quarks[i] != 0)
+    i = (i + 1) & table->mask;
+  g_atomic_int_set ((gint *) &table->quarks[i], quark);
+}
+
+/* HOLDS: quark_global_lock */
+static void
+quark_table_insert (GQuark quark)
+{
+  QuarkTable *table;
+  guint size;
+  GQuark q;
+
+  /* keep the table at most half full */
+  if (quark_table != NULL && quark < (quark_table->mask + 1) / 2)
+    {
+      quark_table_add (quark_table, quark);
+      return;
+    }
+
+  size = quark_table ? (quark_table->mask + 1) * 2 : QUARK_TABLE_MIN_SIZE;
+  table = g_malloc0 (sizeof (QuarkTable) + (size - 1) * sizeof (GQuark));
+  table->mask = size - 1;
+  for (q = 1; q <= quark; q++)
+    quark_table_add (table, q);
+
+  g_atomic_pointer_set (&quark_table, table);
+}
+
 /**
  * g_quark_try_string:
  * @string: (allow-none): a string.
@@ -121,17 +196,10 @@ static gint           quark_block_offset = 0;
 GQuark
 g_quark_try_string (const gchar *string)
 {
-  GQuark quark = 0;
-
   if (string == NULL)
     return 0;
 
-  G_LOCK (quark_global);
-  if (quark_ht)
-    quark = GPOINTER_TO_UINT (g_hash_table_lookup (quark_ht, string));
-  G_UNLOCK (quark_global);
-  
-  return quark;
+  return quark_lookup (string);
 }
 
 /* HOLDS: quark_global_lock */
@@ -167,11 +235,9 @@ static inline GQuark
 quark_from_string (const gchar *string,
                    gboolean     duplicate)
 {
-  GQuark quark = 0;
-
-  if (quark_ht)
-    quark = GPOINTER_TO_UINT (g_hash_table_lookup (quark_ht, string));
+  GQuark quark;
 
+  quark = quark_lookup (string);
   if (!quark)
     {
       quark = quark_new (duplicate ? quark_strdup (string) : (gchar *)string);
@@ -200,6 +266,10 @@ g_quark_from_string (const gchar *string)
   if (!string)
     return 0;
 
+  quark = quark_lookup (string);
+  if (quark)
+    return quark;
+
   G_LOCK (quark_global);
   quark = quark_from_string (string, TRUE);
   G_UNLOCK (quark_global);
@@ -235,6 +305,10 @@ g_quark_from_static_string (const gchar *string)
   if (!string)
     return 0;
 
+  quark = quark_lookup (string);
+  if (quark)
+    return quark;
+
   G_LOCK (quark_global);
   quark = quark_from_string (string, FALSE);
   G_UNLOCK (quark_global);
@@ -285,18 +359,16 @@ quark_new (gchar *string)
        */
       g_atomic_pointer_set (&quarks, quarks_new);
     }
-  if (!quark_ht)
+  if (quark_seq_id == 0)
     {
-      g_assert (quark_seq_id == 0);
-      quark_ht = g_hash_table_new (g_str_hash, g_str_equal);
       quarks[quark_seq_id] = NULL;
       g_atomic_int_inc (&quark_seq_id);
     }
 
   quark = quark_seq_id;
   g_atomic_pointer_set (&quarks[quark], string);
-  g_hash_table_insert (quark_ht, string, GUINT_TO_POINTER (quark));
   g_atomic_int_inc (&quark_seq_id);
+  quark_table_insert (quark);
 
   return quark;
 }
@@ -322,6 +394,10 @@ g_intern_string (const gchar *string)
   if (!string)
     return NULL;
 
+  quark = quark_lookup (string);
+  if (quark)
+    return g_quark_to_string (quark);
+
   G_LOCK (quark_global);
   quark = quark_from_string (string, TRUE);
   result = quarks[quark];
@@ -352,6 +428,10 @@ g_intern_static_string (const gchar *string)
   if (!string)
     return NULL;
 
+  quark = quark_lookup (string);
+  if (quark)
+    return g_quark_to_string (quark);
+
   G_LOCK (quark_global);
   quark = quark_from_string (string, FALSE);
   result = quarks[quark];
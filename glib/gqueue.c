@@ -48,6 +48,28 @@
  * To remove elements, use g_queue_pop_head() and g_queue_pop_tail().
  *
  * To free the entire queue, use g_queue_free().
+ *
+ * The functions that take or return a #GList link, such as
+ * g_queue_push_tail_link() and g_queue_pop_head_link(), never allocate
+ * or free anything.  This makes it possible to embed the link in the
+ * structure that is being queued, so that queueing and dequeueing it
+ * doesn't need any memory allocation:
+ * |[
+ * typedef struct {
+ *   GList link;
+ *   gint priority;
+ * } Job;
+ *
+ * job->link.data = job;
+ * g_queue_push_tail_link (&amp;queue, &amp;job->link);
+ * ...
+ * job = g_queue_pop_head_link (&amp;queue)->data;
+ * ]|
+ * A link must be in at most one queue at a time, and must only be
+ * removed with the link functions (g_queue_pop_head_link(),
+ * g_queue_unlink(), ...), which leave it ready to be queued again.
+ * g_queue_clear(), g_queue_free() and g_queue_delete_link() must not be
+ * used on queues holding embedded links, since they free the links.
  */
 #include "config.h"
 
@@ -1036,6 +1058,78 @@ g_queue_insert_after (GQueue   *queue,
     g_queue_insert_before (queue, sibling->next, data);
 }
 
+/**
+ * g_queue_insert_before_link:
+ * @queue: a #GQueue
+ * @sibling: (allow-none): a #GList link that <emphasis>must</emphasis> be
+ *   part of @queue, or %NULL to push at the tail of the queue
+ * @link_: a #GList link to insert, which must not be part of any queue
+ *
+ * Inserts @link_ into @queue before @sibling.
+ *
+ * Like g_queue_push_tail_link(), this does not allocate any memory, so
+ * it can be used with links embedded in other structures.
+ *
+ * Since: 2.40
+ **/
+void
+g_queue_insert_before_link (GQueue *queue,
+                            GList  *sibling,
+                            GList  *link_)
+{
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (link_ != NULL);
+  g_return_if_fail (link_->prev == NULL);
+  g_return_if_fail (link_->next == NULL);
+
+  if (sibling == NULL)
+    {
+      g_queue_push_tail_link (queue, link_);
+      return;
+    }
+
+  link_->next = sibling;
+  link_->prev = sibling->prev;
+  if (sibling->prev)
+    sibling->prev->next = link_;
+  else
+    queue->head = link_;
+  sibling->prev = link_;
+  queue->length++;
+}
+
+/**
+ * g_queue_insert_after_link:
+ * @queue: a #GQueue
+ * @sibling: (allow-none): a #GList link that <emphasis>must</emphasis> be
+ *   part of @queue, or %NULL to push at the head of the queue
+ * @link_: a #GList link to insert, which must not be part of any queue
+ *
+ * Inserts @link_ into @queue after @sibling.
+ *
+ * Like g_queue_push_head_link(), this does not allocate any memory, so
+ * it can be used with links embedded in other structures.
+ *
+ * Since: 2.40
+ **/
+void
+g_queue_insert_after_link (GQueue *queue,
+                           GList  *sibling,
+                           GList  *link_)
+{
+  g_return_if_fail (queue != NULL);
+  g_return_if_fail (link_ != NULL);
+  g_return_if_fail (link_->prev == NULL);
+  g_return_if_fail (link_->next == NULL);
+
+  if (sibling == NULL)
+    g_queue_push_head_link (queue, link_);
+  else if (sibling == queue->tail)
+    g_queue_push_tail_link (queue, link_);
+  else
+    g_queue_insert_before_link (queue, sibling->next, link_);
+}
+
 /**
  * g_queue_insert_sorted:
  * @queue: a #GQueue
@@ -152,6 +152,14 @@ void     g_queue_insert_sorted  (GQueue           *queue,
                                  gpointer          data,
                                  GCompareDataFunc  func,
                                  gpointer          user_data);
+GLIB_AVAILABLE_IN_2_40
+void     g_queue_insert_before_link (GQueue       *queue,
+                                     GList        *sibling,
+                                     GList        *link_);
+GLIB_AVAILABLE_IN_2_40
+void     g_queue_insert_after_link  (GQueue       *queue,
+                                     GList        *sibling,
+                                     GList        *link_);
 
 GLIB_AVAILABLE_IN_ALL
 void     g_queue_push_head_link (GQueue           *queue,
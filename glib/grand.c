@@ -113,6 +113,17 @@
  * environment variable <envar>G_RANDOM_VERSION</envar> to the value of
  * '2.0'. Use the GLib-2.0 algorithms only if you have sequences of
  * numbers generated with Glib-2.0 that you need to reproduce exactly.
+ *
+ * The Mersenne Twister keeps 2.5 kilobytes of state. Code that needs
+ * many generators, for example one per thread, can instead create them
+ * with g_rand_new_with_algorithm() and %G_RAND_ALGORITHM_XOSHIRO256,
+ * which uses the xoshiro256** generator by David Blackman and Sebastiano
+ * Vigna. Its state is only 32 bytes and it is faster, at the price of
+ * producing a different sequence of numbers for the same seed.
+ *
+ * To get many random numbers at once, g_rand_fill() and
+ * g_rand_double_array() are cheaper than calling g_rand_int() or
+ * g_rand_double() in a loop.
  **/
 
 /**
@@ -168,10 +179,91 @@ get_random_version (void)
 
 struct _GRand
 {
-  guint32 mt[N]; /* the array for the state vector  */
-  guint mti; 
+  GRandAlgorithm algorithm;
+  guint mti;
+  union
+  {
+    guint32 mt[N]; /* the array for the state vector  */
+    guint64 xs[4]; /* xoshiro256** state */
+  } state;
 };
 
+static gsize
+g_rand_size (GRandAlgorithm algorithm)
+{
+  if (algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    return G_STRUCT_OFFSET (GRand, state) + sizeof (guint64) * 4;
+
+  return sizeof (GRand);
+}
+
+static GRand *
+g_rand_alloc (GRandAlgorithm algorithm)
+{
+  GRand *rand = g_malloc0 (g_rand_size (algorithm));
+
+  rand->algorithm = algorithm;
+
+  return rand;
+}
+
+static inline guint64
+rotl64 (guint64 x,
+        int     k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/* See http://xoshiro.di.unimi.it/ */
+static inline guint64
+xoshiro256_next (guint64 *s)
+{
+  guint64 result = rotl64 (s[1] * 5, 7) * 9;
+  guint64 t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl64 (s[3], 45);
+
+  return result;
+}
+
+/* splitmix64, to spread the seed over the xoshiro256** state */
+static guint64
+splitmix64_next (guint64 *x)
+{
+  guint64 z = (*x += G_GUINT64_CONSTANT (0x9e3779b97f4a7c15));
+
+  z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT (0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT (0x94d049bb133111eb);
+
+  return z ^ (z >> 31);
+}
+
+static void
+xoshiro256_seed (GRand         *rand,
+                 const guint32 *seed,
+                 guint          seed_length)
+{
+  guint64 x = seed_length;
+  guint i;
+
+  /* fold all the seed words into the splitmix64 state, mixing between
+   * them so that different arrays give different states
+   */
+  for (i = 0; i < seed_length; i++)
+    {
+      x ^= seed[i];
+      x = splitmix64_next (&x);
+    }
+
+  for (i = 0; i < 4; i++)
+    rand->state.xs[i] = splitmix64_next (&x);
+}
+
 /**
  * g_rand_new_with_seed:
  * @seed: a value to initialize the random number generator.
@@ -183,7 +275,7 @@ struct _GRand
 GRand*
 g_rand_new_with_seed (guint32 seed)
 {
-  GRand *rand = g_new0 (GRand, 1);
+  GRand *rand = g_rand_alloc (G_RAND_ALGORITHM_MERSENNE_TWISTER);
   g_rand_set_seed (rand, seed);
   return rand;
 }
@@ -202,25 +294,14 @@ g_rand_new_with_seed (guint32 seed)
 GRand*
 g_rand_new_with_seed_array (const guint32 *seed, guint seed_length)
 {
-  GRand *rand = g_new0 (GRand, 1);
+  GRand *rand = g_rand_alloc (G_RAND_ALGORITHM_MERSENNE_TWISTER);
   g_rand_set_seed_array (rand, seed, seed_length);
   return rand;
 }
 
-/**
- * g_rand_new:
- * 
- * Creates a new random number generator initialized with a seed taken
- * either from <filename>/dev/urandom</filename> (if existing) or from 
- * the current time (as a fallback).  On Windows, the seed is taken from
- * rand_s().
- * 
- * Return value: the new #GRand.
- **/
-GRand* 
-g_rand_new (void)
+static void
+get_random_seed (guint32 seed[4])
 {
-  guint32 seed[4];
 #ifdef G_OS_UNIX
   static gboolean dev_urandom_exists = TRUE;
   GTimeVal now;
@@ -243,7 +324,7 @@ g_rand_new (void)
 	  do
 	    {
 	      errno = 0;
-	      r = fread (seed, sizeof (seed), 1, dev_urandom);
+	      r = fread (seed, sizeof (guint32) * 4, 1, dev_urandom);
 	    }
 	  while G_UNLIKELY (errno == EINTR);
 
@@ -267,13 +348,59 @@ g_rand_new (void)
 #else /* G_OS_WIN32 */
   gint i;
 
-  for (i = 0; i < G_N_ELEMENTS (seed); i++)
+  for (i = 0; i < 4; i++)
     rand_s (&seed[i]);
 #endif
+}
+
+/**
+ * g_rand_new:
+ * 
+ * Creates a new random number generator initialized with a seed taken
+ * either from <filename>/dev/urandom</filename> (if existing) or from 
+ * the current time (as a fallback).  On Windows, the seed is taken from
+ * rand_s().
+ * 
+ * Return value: the new #GRand.
+ **/
+GRand* 
+g_rand_new (void)
+{
+  guint32 seed[4];
+
+  get_random_seed (seed);
 
   return g_rand_new_with_seed_array (seed, 4);
 }
 
+/**
+ * g_rand_new_with_algorithm:
+ * @algorithm: the #GRandAlgorithm to use
+ *
+ * Creates a new random number generator that uses @algorithm, seeded
+ * like g_rand_new(). Use g_rand_set_seed() or g_rand_set_seed_array()
+ * on it to get a reproducible sequence.
+ *
+ * Return value: the new #GRand.
+ *
+ * Since: 2.40
+ **/
+GRand *
+g_rand_new_with_algorithm (GRandAlgorithm algorithm)
+{
+  guint32 seed[4];
+  GRand *rand;
+
+  g_return_val_if_fail (algorithm == G_RAND_ALGORITHM_MERSENNE_TWISTER ||
+                        algorithm == G_RAND_ALGORITHM_XOSHIRO256, NULL);
+
+  rand = g_rand_alloc (algorithm);
+  get_random_seed (seed);
+  g_rand_set_seed_array (rand, seed, 4);
+
+  return rand;
+}
+
 /**
  * g_rand_free:
  * @rand_: a #GRand.
@@ -307,8 +434,8 @@ g_rand_copy (GRand* rand)
 
   g_return_val_if_fail (rand != NULL, NULL);
 
-  new_rand = g_new0 (GRand, 1);
-  memcpy (new_rand, rand, sizeof (GRand));
+  new_rand = g_malloc (g_rand_size (rand->algorithm));
+  memcpy (new_rand, rand, g_rand_size (rand->algorithm));
 
   return new_rand;
 }
@@ -325,6 +452,12 @@ g_rand_set_seed (GRand* rand, guint32 seed)
 {
   g_return_if_fail (rand != NULL);
 
+  if (rand->algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    {
+      xoshiro256_seed (rand, &seed, 1);
+      return;
+    }
+
   switch (get_random_version ())
     {
     case 20:
@@ -336,9 +469,9 @@ g_rand_set_seed (GRand* rand, guint32 seed)
       if (seed == 0) /* This would make the PRNG produce only zeros */
 	seed = 0x6b842128; /* Just set it to another number */
       
-      rand->mt[0]= seed;
+      rand->state.mt[0]= seed;
       for (rand->mti=1; rand->mti<N; rand->mti++)
-	rand->mt[rand->mti] = (69069 * rand->mt[rand->mti-1]);
+	rand->state.mt[rand->mti] = (69069 * rand->state.mt[rand->mti-1]);
       
       break;
     case 22:
@@ -346,10 +479,10 @@ g_rand_set_seed (GRand* rand, guint32 seed)
       /* In the previous version (see above), MSBs of the    */
       /* seed affect only MSBs of the array mt[].            */
       
-      rand->mt[0]= seed;
+      rand->state.mt[0]= seed;
       for (rand->mti=1; rand->mti<N; rand->mti++)
-	rand->mt[rand->mti] = 1812433253UL * 
-	  (rand->mt[rand->mti-1] ^ (rand->mt[rand->mti-1] >> 30)) + rand->mti; 
+	rand->state.mt[rand->mti] = 1812433253UL * 
+	  (rand->state.mt[rand->mti-1] ^ (rand->state.mt[rand->mti-1] >> 30)) + rand->mti; 
       break;
     default:
       g_assert_not_reached ();
@@ -378,20 +511,26 @@ g_rand_set_seed_array (GRand* rand, const guint32 *seed, guint seed_length)
   g_return_if_fail (rand != NULL);
   g_return_if_fail (seed_length >= 1);
 
+  if (rand->algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    {
+      xoshiro256_seed (rand, seed, seed_length);
+      return;
+    }
+
   g_rand_set_seed (rand, 19650218UL);
 
   i=1; j=0;
   k = (N>seed_length ? N : seed_length);
   for (; k; k--)
     {
-      rand->mt[i] = (rand->mt[i] ^
-		     ((rand->mt[i-1] ^ (rand->mt[i-1] >> 30)) * 1664525UL))
+      rand->state.mt[i] = (rand->state.mt[i] ^
+		     ((rand->state.mt[i-1] ^ (rand->state.mt[i-1] >> 30)) * 1664525UL))
 	      + seed[j] + j; /* non linear */
-      rand->mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
+      rand->state.mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
       i++; j++;
       if (i>=N)
         {
-	  rand->mt[0] = rand->mt[N-1];
+	  rand->state.mt[0] = rand->state.mt[N-1];
 	  i=1;
 	}
       if (j>=seed_length)
@@ -399,19 +538,19 @@ g_rand_set_seed_array (GRand* rand, const guint32 *seed, guint seed_length)
     }
   for (k=N-1; k; k--)
     {
-      rand->mt[i] = (rand->mt[i] ^
-		     ((rand->mt[i-1] ^ (rand->mt[i-1] >> 30)) * 1566083941UL))
+      rand->state.mt[i] = (rand->state.mt[i] ^
+		     ((rand->state.mt[i-1] ^ (rand->state.mt[i-1] >> 30)) * 1566083941UL))
 	      - i; /* non linear */
-      rand->mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
+      rand->state.mt[i] &= 0xffffffffUL; /* for WORDSIZE > 32 machines */
       i++;
       if (i>=N)
         {
-	  rand->mt[0] = rand->mt[N-1];
+	  rand->state.mt[0] = rand->state.mt[N-1];
 	  i=1;
 	}
     }
 
-  rand->mt[0] = 0x80000000UL; /* MSB is 1; assuring non-zero initial array */ 
+  rand->state.mt[0] = 0x80000000UL; /* MSB is 1; assuring non-zero initial array */ 
 }
 
 /**
@@ -432,39 +571,107 @@ g_rand_set_seed_array (GRand* rand, const guint32 *seed, guint seed_length)
  *
  * Return value: A random number.
  **/
-guint32
-g_rand_int (GRand* rand)
+static void
+mt_generate (GRand *rand)
 {
   guint32 y;
   static const guint32 mag01[2]={0x0, MATRIX_A};
   /* mag01[x] = x * MATRIX_A  for x=0,1 */
+  int kk;
 
-  g_return_val_if_fail (rand != NULL, 0);
-
-  if (rand->mti >= N) { /* generate N words at one time */
-    int kk;
-    
-    for (kk=0;kk<N-M;kk++) {
-      y = (rand->mt[kk]&UPPER_MASK)|(rand->mt[kk+1]&LOWER_MASK);
-      rand->mt[kk] = rand->mt[kk+M] ^ (y >> 1) ^ mag01[y & 0x1];
-    }
-    for (;kk<N-1;kk++) {
-      y = (rand->mt[kk]&UPPER_MASK)|(rand->mt[kk+1]&LOWER_MASK);
-      rand->mt[kk] = rand->mt[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1];
-    }
-    y = (rand->mt[N-1]&UPPER_MASK)|(rand->mt[0]&LOWER_MASK);
-    rand->mt[N-1] = rand->mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1];
-    
-    rand->mti = 0;
+  for (kk=0;kk<N-M;kk++) {
+    y = (rand->state.mt[kk]&UPPER_MASK)|(rand->state.mt[kk+1]&LOWER_MASK);
+    rand->state.mt[kk] = rand->state.mt[kk+M] ^ (y >> 1) ^ mag01[y & 0x1];
   }
-  
-  y = rand->mt[rand->mti++];
+  for (;kk<N-1;kk++) {
+    y = (rand->state.mt[kk]&UPPER_MASK)|(rand->state.mt[kk+1]&LOWER_MASK);
+    rand->state.mt[kk] = rand->state.mt[kk+(M-N)] ^ (y >> 1) ^ mag01[y & 0x1];
+  }
+  y = (rand->state.mt[N-1]&UPPER_MASK)|(rand->state.mt[0]&LOWER_MASK);
+  rand->state.mt[N-1] = rand->state.mt[M-1] ^ (y >> 1) ^ mag01[y & 0x1];
+
+  rand->mti = 0;
+}
+
+static inline guint32
+mt_temper (guint32 y)
+{
   y ^= TEMPERING_SHIFT_U(y);
   y ^= TEMPERING_SHIFT_S(y) & TEMPERING_MASK_B;
   y ^= TEMPERING_SHIFT_T(y) & TEMPERING_MASK_C;
   y ^= TEMPERING_SHIFT_L(y);
-  
-  return y; 
+
+  return y;
+}
+
+guint32
+g_rand_int (GRand* rand)
+{
+  g_return_val_if_fail (rand != NULL, 0);
+
+  if (rand->algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    return xoshiro256_next (rand->state.xs) >> 32;
+
+  if (rand->mti >= N) /* generate N words at one time */
+    mt_generate (rand);
+
+  return mt_temper (rand->state.mt[rand->mti++]);
+}
+
+/**
+ * g_rand_fill:
+ * @rand_: a #GRand.
+ * @buffer: (array length=n_values): the array to fill
+ * @n_values: the number of values to store in @buffer
+ *
+ * Fills @buffer with @n_values random #guint32, equally distributed
+ * over the range [0..2^32-1]. The values are the same that calling
+ * g_rand_int() @n_values times would have returned, but generating
+ * them in bulk is considerably faster.
+ *
+ * Since: 2.40
+ **/
+void
+g_rand_fill (GRand   *rand,
+             guint32 *buffer,
+             gsize    n_values)
+{
+  gsize i;
+
+  g_return_if_fail (rand != NULL);
+  g_return_if_fail (n_values == 0 || buffer != NULL);
+
+  if (rand->algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    {
+      guint64 s[4];
+
+      /* keep the state in registers */
+      memcpy (s, rand->state.xs, sizeof s);
+      for (i = 0; i < n_values; i++)
+        buffer[i] = xoshiro256_next (s) >> 32;
+      memcpy (rand->state.xs, s, sizeof s);
+
+      return;
+    }
+
+  while (n_values > 0)
+    {
+      const guint32 *mt;
+      gsize n;
+
+      if (rand->mti >= N)
+        mt_generate (rand);
+
+      /* temper a whole run of the state at once */
+      n = MIN (n_values, (gsize) (N - rand->mti));
+      mt = rand->state.mt + rand->mti;
+      for (i = 0; i < n; i++)
+        buffer[i] = mt_temper (mt[i]);
+
+      rand->mti += n;
+      buffer += n;
+      n_values -= n;
+    }
 }
 
 /* transform [0..2^32] -> [0..1] */
@@ -563,9 +770,15 @@ g_rand_int_range (GRand* rand, gint32 begin, gint32 end)
 gdouble 
 g_rand_double (GRand* rand)
 {    
+  gdouble retval;
+
+  /* 53 bits, from the top of one 64 bit value */
+  if (rand->algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    return (xoshiro256_next (rand->state.xs) >> 11) * (1.0 / 9007199254740992.0);
+
   /* We set all 52 bits after the point for this, not only the first
      32. Thats why we need two calls to g_rand_int */
-  gdouble retval = g_rand_int (rand) * G_RAND_DOUBLE_TRANSFORM;
+  retval = g_rand_int (rand) * G_RAND_DOUBLE_TRANSFORM;
   retval = (retval + g_rand_int (rand)) * G_RAND_DOUBLE_TRANSFORM;
 
   /* The following might happen due to very bad rounding luck, but
@@ -576,6 +789,69 @@ g_rand_double (GRand* rand)
   return retval;
 }
 
+/**
+ * g_rand_double_array:
+ * @rand_: a #GRand.
+ * @array: (array length=n_values): the array to fill
+ * @n_values: the number of values to store in @array
+ *
+ * Fills @array with @n_values random #gdouble, equally distributed
+ * over the range [0..1). The values are the same that calling
+ * g_rand_double() @n_values times would have returned, but generating
+ * them in bulk is considerably faster.
+ *
+ * Since: 2.40
+ **/
+void
+g_rand_double_array (GRand   *rand,
+                     gdouble *array,
+                     gsize    n_values)
+{
+  gsize i;
+
+  g_return_if_fail (rand != NULL);
+  g_return_if_fail (n_values == 0 || array != NULL);
+
+  if (rand->algorithm == G_RAND_ALGORITHM_XOSHIRO256)
+    {
+      guint64 s[4];
+
+      memcpy (s, rand->state.xs, sizeof s);
+      for (i = 0; i < n_values; i++)
+        array[i] = (xoshiro256_next (s) >> 11) * (1.0 / 9007199254740992.0);
+      memcpy (rand->state.xs, s, sizeof s);
+
+      return;
+    }
+
+  for (i = 0; i < n_values; i++)
+    {
+      guint32 hi, lo;
+      gdouble d;
+
+      /* as in g_rand_double(), including the retry */
+      do
+        {
+          if (rand->mti >= N - 1)
+            {
+              hi = g_rand_int (rand);
+              lo = g_rand_int (rand);
+            }
+          else
+            {
+              hi = mt_temper (rand->state.mt[rand->mti]);
+              lo = mt_temper (rand->state.mt[rand->mti + 1]);
+              rand->mti += 2;
+            }
+
+          d = (hi * G_RAND_DOUBLE_TRANSFORM + lo) * G_RAND_DOUBLE_TRANSFORM;
+        }
+      while (d >= 1.0);
+
+      array[i] = d;
+    }
+}
+
 /**
  * g_rand_double_range:
  * @rand_: a #GRand.
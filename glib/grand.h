@@ -37,6 +37,23 @@ G_BEGIN_DECLS
 
 typedef struct _GRand           GRand;
 
+/**
+ * GRandAlgorithm:
+ * @G_RAND_ALGORITHM_MERSENNE_TWISTER: the Mersenne Twister, as used by
+ *     g_rand_new() and the <function>g_random_*</function> functions
+ * @G_RAND_ALGORITHM_XOSHIRO256: xoshiro256**, which is faster and has
+ *     a much smaller state
+ *
+ * The pseudo-random number generators that a #GRand can use.
+ *
+ * Since: 2.40
+ */
+typedef enum
+{
+  G_RAND_ALGORITHM_MERSENNE_TWISTER,
+  G_RAND_ALGORITHM_XOSHIRO256
+} GRandAlgorithm;
+
 /* GRand - a good and fast random number generator: Mersenne Twister
  * see http://www.math.sci.hiroshima-u.ac.jp/~m-mat/MT/emt.html for more info.
  * The range functions return a value in the intervall [begin, end).
@@ -53,6 +70,8 @@ GRand*  g_rand_new_with_seed_array (const guint32 *seed,
 				    guint seed_length);
 GLIB_AVAILABLE_IN_ALL
 GRand*  g_rand_new            (void);
+GLIB_AVAILABLE_IN_2_40
+GRand*  g_rand_new_with_algorithm (GRandAlgorithm algorithm);
 GLIB_AVAILABLE_IN_ALL
 void    g_rand_free           (GRand   *rand_);
 GLIB_AVAILABLE_IN_ALL
@@ -73,8 +92,16 @@ GLIB_AVAILABLE_IN_ALL
 gint32  g_rand_int_range      (GRand   *rand_,
 			       gint32   begin,
 			       gint32   end);
+GLIB_AVAILABLE_IN_2_40
+void    g_rand_fill           (GRand   *rand_,
+			       guint32 *buffer,
+			       gsize    n_values);
 GLIB_AVAILABLE_IN_ALL
 gdouble g_rand_double         (GRand   *rand_);
+GLIB_AVAILABLE_IN_2_40
+void    g_rand_double_array   (GRand   *rand_,
+			       gdouble *array,
+			       gsize    n_values);
 GLIB_AVAILABLE_IN_ALL
 gdouble g_rand_double_range   (GRand   *rand_,
 			       gdouble  begin,
@@ -37,6 +37,7 @@
 #include "gstrfuncs.h"
 #include "gatomic.h"
 #include "gthread.h"
+#include "garray.h"
 
 /**
  * SECTION:gregex
@@ -121,6 +122,7 @@
                               G_REGEX_RAW               | \
                               G_REGEX_NO_AUTO_CAPTURE   | \
                               G_REGEX_OPTIMIZE          | \
+                              G_REGEX_JIT               | \
                               G_REGEX_FIRSTLINE         | \
                               G_REGEX_DUPNAMES          | \
                               G_REGEX_NEWLINE_CR        | \
@@ -133,7 +135,8 @@
 /* Mask of all GRegexCompileFlags values that are (not) passed trough to PCRE */
 #define G_REGEX_COMPILE_PCRE_MASK (G_REGEX_COMPILE_MASK & ~G_REGEX_COMPILE_NONPCRE_MASK)
 #define G_REGEX_COMPILE_NONPCRE_MASK (G_REGEX_RAW              | \
-                                      G_REGEX_OPTIMIZE)
+                                      G_REGEX_OPTIMIZE         | \
+                                      G_REGEX_JIT)
 
 /* Mask of all the possible values for GRegexMatchFlags. */
 #define G_REGEX_MATCH_MASK (G_REGEX_MATCH_ANCHORED         | \
@@ -190,6 +193,7 @@ G_STATIC_ASSERT (G_REGEX_MATCH_NOTEMPTY_ATSTART == PCRE_NOTEMPTY_ATSTART);
  * it should be ok to reuse them for different things.
  */
 G_STATIC_ASSERT (G_REGEX_OPTIMIZE          == PCRE_NO_UTF8_CHECK);
+G_STATIC_ASSERT (G_REGEX_JIT               == PCRE_AUTO_CALLOUT);
 G_STATIC_ASSERT (G_REGEX_RAW               == PCRE_UTF8);
 
 /* if the string is in UTF-8 use g_utf8_ functions, else use
@@ -226,6 +230,32 @@ struct _GRegex
   pcre_extra *extra;            /* data stored when G_REGEX_OPTIMIZE is used */
 };
 
+/* JIT compiled patterns run on a stack of their own; PCRE's default
+ * is a small one on the machine stack, so give each thread a larger
+ * one that can grow as needed.
+ */
+#ifdef PCRE_CONFIG_JIT
+#define JIT_STACK_START_SIZE (32 * 1024)
+#define JIT_STACK_MAX_SIZE   (1024 * 1024)
+
+static GPrivate jit_stack_private = G_PRIVATE_INIT ((GDestroyNotify) pcre_jit_stack_free);
+
+static pcre_jit_stack *
+get_jit_stack (gpointer data)
+{
+  pcre_jit_stack *stack = g_private_get (&jit_stack_private);
+
+  if (stack == NULL)
+    {
+      /* on failure PCRE falls back to its default stack */
+      stack = pcre_jit_stack_alloc (JIT_STACK_START_SIZE, JIT_STACK_MAX_SIZE);
+      g_private_set (&jit_stack_private, stack);
+    }
+
+  return stack;
+}
+#endif
+
 /* TRUE if ret is an error code, FALSE otherwise. */
 #define IS_PCRE_ERROR(ret) ((ret) < PCRE_ERROR_NOMATCH && (ret) != PCRE_ERROR_PARTIAL)
 
@@ -303,6 +333,10 @@ match_error (gint errcode)
       return _("short utf8");
     case PCRE_ERROR_RECURSELOOP:
       return _("recursion loop");
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+    case PCRE_ERROR_JIT_STACKLIMIT:
+      return _("JIT stack limit reached");
+#endif
     default:
       break;
     }
@@ -552,6 +586,27 @@ translate_compile_error (gint *errcode, const gchar **errmsg)
 
 /* GMatchInfo */
 
+static void
+match_info_reset (GMatchInfo  *match_info,
+                  const gchar *string,
+                  gssize       string_len,
+                  gint         start_position,
+                  gint         match_options)
+{
+  if (string_len < 0)
+    string_len = strlen (string);
+
+  match_info->string = string;
+  match_info->string_len = string_len;
+  match_info->matches = PCRE_ERROR_NOMATCH;
+  match_info->pos = start_position;
+  match_info->match_opts = match_options;
+
+  /* Set an invalid position for the previous match. */
+  match_info->offsets[0] = -1;
+  match_info->offsets[1] = -1;
+}
+
 static GMatchInfo *
 match_info_new (const GRegex *regex,
                 const gchar  *string,
@@ -562,17 +617,9 @@ match_info_new (const GRegex *regex,
 {
   GMatchInfo *match_info;
 
-  if (string_len < 0)
-    string_len = strlen (string);
-
   match_info = g_new0 (GMatchInfo, 1);
   match_info->ref_count = 1;
   match_info->regex = g_regex_ref ((GRegex *)regex);
-  match_info->string = string;
-  match_info->string_len = string_len;
-  match_info->matches = PCRE_ERROR_NOMATCH;
-  match_info->pos = start_position;
-  match_info->match_opts = match_options;
 
   if (is_dfa)
     {
@@ -591,9 +638,8 @@ match_info_new (const GRegex *regex,
     }
 
   match_info->offsets = g_new0 (gint, match_info->n_offsets);
-  /* Set an invalid position for the previous match. */
-  match_info->offsets[0] = -1;
-  match_info->offsets[1] = -1;
+  match_info_reset (match_info, string, string_len, start_position,
+                    match_options);
 
   return match_info;
 }
@@ -790,6 +836,71 @@ g_match_info_next (GMatchInfo  *match_info,
   return match_info->matches >= 0;
 }
 
+/**
+ * g_match_info_rematch:
+ * @match_info: a #GMatchInfo structure
+ * @string: (array length=string_len): the string to scan for matches
+ * @string_len: the length of @string, or -1 if @string is nul-terminated
+ * @start_position: starting index of the string to match
+ * @match_options: match options
+ * @error: location to store the error occurring, or %NULL to ignore errors
+ *
+ * Scans for a match in @string for the pattern of the #GRegex that
+ * @match_info was obtained for, reusing @match_info instead of creating
+ * a new one.  This behaves exactly like calling g_regex_match_full()
+ * with the same arguments, except that no memory is allocated, which
+ * makes a difference when matching one #GRegex against many short
+ * strings:
+ *
+ * |[
+ * GMatchInfo *match_info = NULL;
+ *
+ * while ((line = read_line (input)))
+ *   {
+ *     if (match_info == NULL)
+ *       g_regex_match (regex, line, 0, &match_info);
+ *     else
+ *       g_match_info_rematch (match_info, line, -1, 0, 0, NULL);
+ *
+ *     while (g_match_info_matches (match_info))
+ *       {
+ *         handle_match (match_info);
+ *         g_match_info_next (match_info, NULL);
+ *       }
+ *   }
+ * g_match_info_free (match_info);
+ * ]|
+ *
+ * Any strings previously fetched from @match_info stay valid, but
+ * positions and substrings fetched afterwards refer to @string.
+ * @match_info must have been obtained from g_regex_match() or
+ * g_regex_match_full(), not from g_regex_match_all().
+ *
+ * Returns: %TRUE is the string matched, %FALSE otherwise
+ *
+ * Since: 2.40
+ */
+gboolean
+g_match_info_rematch (GMatchInfo        *match_info,
+                      const gchar       *string,
+                      gssize             string_len,
+                      gint               start_position,
+                      GRegexMatchFlags   match_options,
+                      GError           **error)
+{
+  g_return_val_if_fail (match_info != NULL, FALSE);
+  g_return_val_if_fail (match_info->workspace == NULL, FALSE);
+  g_return_val_if_fail (string != NULL, FALSE);
+  g_return_val_if_fail (start_position >= 0, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  g_return_val_if_fail ((match_options & ~G_REGEX_MATCH_MASK) == 0, FALSE);
+
+  match_info_reset (match_info, string, string_len, start_position,
+                    match_options);
+
+  return g_match_info_next (match_info, error);
+}
+
 /**
  * g_match_info_matches:
  * @match_info: a #GMatchInfo structure
@@ -1261,7 +1372,11 @@ g_regex_unref (GRegex *regex)
       if (regex->pcre_re != NULL)
         pcre_free (regex->pcre_re);
       if (regex->extra != NULL)
+#ifdef PCRE_CONFIG_JIT
+        pcre_free_study (regex->extra);
+#else
         pcre_free (regex->extra);
+#endif
       g_free (regex);
     }
 }
@@ -1293,6 +1408,7 @@ g_regex_new (const gchar         *pattern,
   gint erroffset;
   gint errcode;
   gboolean optimize = FALSE;
+  gint study_options = 0;
   static volatile gsize initialised = 0;
   unsigned long int pcre_compile_options;
   GRegexCompileFlags nonpcre_compile_options;
@@ -1331,6 +1447,17 @@ g_regex_new (const gchar         *pattern,
   if (compile_options & G_REGEX_OPTIMIZE)
     optimize = TRUE;
 
+  /* G_REGEX_JIT has the value of PCRE_AUTO_CALLOUT, which we don't want
+   * to pass on since callouts are not implemented. */
+  if (compile_options & G_REGEX_JIT)
+    {
+      optimize = TRUE;
+#ifdef PCRE_CONFIG_JIT
+      study_options |= PCRE_STUDY_JIT_COMPILE;
+#endif
+      compile_options &= ~G_REGEX_JIT;
+    }
+
   /* In GRegex the string are, by default, UTF-8 encoded. PCRE
    * instead uses UTF-8 only if required with PCRE_UTF8. */
   if (compile_options & G_REGEX_RAW)
@@ -1416,7 +1543,7 @@ g_regex_new (const gchar         *pattern,
 
   if (optimize)
     {
-      regex->extra = pcre_study (regex->pcre_re, 0, &errmsg);
+      regex->extra = pcre_study (regex->pcre_re, study_options, &errmsg);
       if (errmsg != NULL)
         {
           GError *tmp_error = g_error_new (G_REGEX_ERROR,
@@ -1430,6 +1557,11 @@ g_regex_new (const gchar         *pattern,
           g_regex_unref (regex);
           return NULL;
         }
+
+#ifdef PCRE_CONFIG_JIT
+      if (regex->extra != NULL && (study_options & PCRE_STUDY_JIT_COMPILE))
+        pcre_assign_jit_stack (regex->extra, get_jit_stack, NULL);
+#endif
     }
 
   return regex;
@@ -1617,6 +1749,42 @@ g_regex_match_simple (const gchar        *pattern,
   return result;
 }
 
+/* g_regex_match_full() for callers who only want to know whether
+ * there is a match: no #GMatchInfo is created and the offsets, which
+ * PCRE only needs as scratch space here, live on the stack.
+ */
+static gboolean
+regex_match_only (const GRegex      *regex,
+                  const gchar       *string,
+                  gssize             string_len,
+                  gint               start_position,
+                  GRegexMatchFlags   match_options,
+                  GError           **error)
+{
+  gint offsets[30];
+  gint matches;
+
+  if (string_len < 0)
+    string_len = strlen (string);
+
+  if (start_position > string_len)
+    return FALSE;
+
+  matches = pcre_exec (regex->pcre_re, regex->extra,
+                       string, string_len, start_position,
+                       regex->match_opts | match_options,
+                       offsets, G_N_ELEMENTS (offsets));
+  if (IS_PCRE_ERROR (matches))
+    {
+      g_set_error (error, G_REGEX_ERROR, G_REGEX_ERROR_MATCH,
+                   _("Error while matching regular expression %s: %s"),
+                   regex->pattern, match_error (matches));
+      return FALSE;
+    }
+
+  return matches >= 0;
+}
+
 /**
  * g_regex_match:
  * @regex: a #GRegex structure from g_regex_new()
@@ -1761,13 +1929,14 @@ g_regex_match_full (const GRegex      *regex,
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
   g_return_val_if_fail ((match_options & ~G_REGEX_MATCH_MASK) == 0, FALSE);
 
+  if (match_info == NULL)
+    return regex_match_only (regex, string, string_len, start_position,
+                             match_options, error);
+
   info = match_info_new (regex, string, string_len, start_position,
                          match_options, FALSE);
   match_ok = g_match_info_next (info, error);
-  if (match_info != NULL)
-    *match_info = info;
-  else
-    g_match_info_free (info);
+  *match_info = info;
 
   return match_ok;
 }
@@ -3133,3 +3302,482 @@ g_regex_escape_string (const gchar *string,
 
   return g_string_free (escaped, FALSE);
 }
+
+
+/* GRegexSet */
+
+/* Running hundreds of patterns over every string is slow, so before
+ * running a pattern g_regex_set_match() checks cheap conditions that
+ * any match must satisfy:
+ *
+ *  - if the pattern starts with literal text, that text must occur in
+ *    the string.  The literals of all the patterns are searched for in
+ *    a single pass with an Aho-Corasick automaton;
+ *  - otherwise, the first and the last literal byte that PCRE found
+ *    while compiling the pattern must occur in the string.
+ *
+ * Both are compared with ASCII case folded, which keeps them correct
+ * for caseless patterns.
+ */
+#define REGEX_SET_MAX_LITERAL 8
+
+typedef struct
+{
+  gint first_byte;      /* folded, or -1 */
+  gint required_byte;   /* folded, or -1 */
+  gint min_length;
+  guint literal_state;  /* end state of the literal prefix, or 0 */
+} RegexSetFilter;
+
+struct _GRegexSet
+{
+  volatile gint ref_count;
+  GRegex **regexes;
+  guint n_regexes;
+  RegexSetFilter *filters;
+
+  /* the Aho-Corasick automaton, as a complete DFA over byte classes */
+  guint8 byte_class[256];
+  guint n_classes;
+  guint n_states;
+  guint *transitions;   /* n_states * n_classes */
+  guint *fail;
+  guint *bfs_order;
+};
+
+/* Copies the literal text at the start of @pattern, folded to lower
+ * case, into @literal.  This only needs to be conservative: whatever it
+ * doesn't understand ends the literal.
+ */
+static gsize
+regex_literal_prefix (const gchar        *pattern,
+                      GRegexCompileFlags  compile_options,
+                      gchar              *literal)
+{
+  gboolean caseless = (compile_options & G_REGEX_CASELESS) != 0;
+  const gchar *p = pattern;
+  gsize len = 0;
+  gsize last_char = 0;
+
+  /* whitespace and comments are not literal, and an alternative
+   * doesn't have to start with the same text */
+  if ((compile_options & G_REGEX_EXTENDED) || strchr (pattern, '|'))
+    return 0;
+
+  if (*p == '^')
+    p++;
+
+  while (*p != '\0' && strchr ("\\.[]()^$*+?{}", *p) == NULL)
+    {
+      guchar c = *p;
+      gsize char_len = 1;
+
+      if (c >= 0x80 && !(compile_options & G_REGEX_RAW))
+        char_len = g_utf8_skip[c];
+
+      /* caseless matching can map these to non-ASCII characters (the
+       * Kelvin sign and the long s) */
+      if (caseless && (c >= 0x80 || g_ascii_tolower (c) == 'k' ||
+                       g_ascii_tolower (c) == 's'))
+        break;
+
+      if (len + char_len > REGEX_SET_MAX_LITERAL || strlen (p) < char_len)
+        break;
+
+      last_char = len;
+      while (char_len--)
+        literal[len++] = g_ascii_tolower (*p++);
+    }
+
+  /* the last character may be repeated zero times */
+  if (*p == '*' || *p == '?' || *p == '{')
+    len = last_char;
+
+  return len;
+}
+
+static void
+regex_set_filter_init (RegexSetFilter *filter,
+                       const GRegex   *regex)
+{
+  gint first_byte, required_byte;
+
+  pcre_fullinfo (regex->pcre_re, regex->extra,
+                 PCRE_INFO_FIRSTBYTE, &first_byte);
+  pcre_fullinfo (regex->pcre_re, regex->extra,
+                 PCRE_INFO_LASTLITERAL, &required_byte);
+  filter->min_length = 0;
+  pcre_fullinfo (regex->pcre_re, regex->extra,
+                 PCRE_INFO_MINLENGTH, &filter->min_length);
+  if (filter->min_length < 0)
+    filter->min_length = 0;
+
+  filter->first_byte = first_byte >= 0 ? (guchar) g_ascii_tolower (first_byte) : -1;
+  filter->required_byte = required_byte >= 0 ? (guchar) g_ascii_tolower (required_byte) : -1;
+  filter->literal_state = 0;
+}
+
+static void
+regex_set_build_automaton (GRegexSet  *regex_set,
+                           gchar     **literals,
+                           gsize      *literal_lens)
+{
+  guint n_regexes = regex_set->n_regexes;
+  guint max_states = 1;
+  guint head, tail;
+  guint i, c;
+
+  /* every byte that occurs in a literal gets a class of its own, all
+   * other bytes share class 0 */
+  regex_set->n_classes = 1;
+  for (i = 0; i < n_regexes; i++)
+    {
+      gsize j;
+
+      for (j = 0; j < literal_lens[i]; j++)
+        {
+          guchar b = literals[i][j];
+
+          if (regex_set->byte_class[b] == 0)
+            regex_set->byte_class[b] = regex_set->n_classes++;
+        }
+      max_states += literal_lens[i];
+    }
+
+  if (max_states == 1)
+    return;
+
+  /* upper case letters go to the class of their lower case form */
+  for (c = 'A'; c <= 'Z'; c++)
+    regex_set->byte_class[c] = regex_set->byte_class[(guchar) g_ascii_tolower (c)];
+
+  regex_set->transitions = g_new0 (guint, max_states * regex_set->n_classes);
+  regex_set->fail = g_new0 (guint, max_states);
+  regex_set->bfs_order = g_new (guint, max_states);
+  regex_set->n_states = 1;
+
+  /* the trie; 0 doubles as "no transition" since nothing leads back
+   * to the root */
+  for (i = 0; i < n_regexes; i++)
+    {
+      guint state = 0;
+      gsize j;
+
+      if (literal_lens[i] == 0)
+        continue;
+
+      for (j = 0; j < literal_lens[i]; j++)
+        {
+          guint *next = &regex_set->transitions[state * regex_set->n_classes +
+                                                regex_set->byte_class[(guchar) literals[i][j]]];
+          if (*next == 0)
+            *next = regex_set->n_states++;
+          state = *next;
+        }
+
+      regex_set->filters[i].literal_state = state;
+    }
+
+  /* breadth first: set the failure links and complete the DFA */
+  head = tail = 0;
+  regex_set->bfs_order[tail++] = 0;
+  while (head < tail)
+    {
+      guint state = regex_set->bfs_order[head++];
+      guint *row = &regex_set->transitions[state * regex_set->n_classes];
+      guint *fail_row = &regex_set->transitions[regex_set->fail[state] * regex_set->n_classes];
+
+      for (c = 0; c < regex_set->n_classes; c++)
+        {
+          if (row[c] != 0)
+            {
+              regex_set->fail[row[c]] = state == 0 ? 0 : fail_row[c];
+              regex_set->bfs_order[tail++] = row[c];
+            }
+          else if (state != 0)
+            row[c] = fail_row[c];
+        }
+    }
+}
+
+/**
+ * g_regex_set_new:
+ * @patterns: (array length=n_patterns): the regular expressions
+ * @n_patterns: the number of patterns, or -1 if @patterns is
+ *     %NULL-terminated
+ * @compile_options: compile options for all the regular expressions,
+ *     or 0
+ * @match_options: match options for all the regular expressions, or 0
+ * @error: return location for a #GError
+ *
+ * Compiles a set of regular expressions, which can then be matched
+ * against a string together with g_regex_set_match().
+ *
+ * This is meant for classifying strings against a large number of
+ * patterns.  g_regex_set_match() first looks for the literal text that
+ * the patterns start with, for all of them in a single pass over the
+ * string, and then only runs the patterns that can possibly match.
+ * The more patterns start with distinctive literal text, the less
+ * work is left for the regular expression engine.
+ *
+ * Returns: a #GRegexSet, or %NULL if one of the patterns failed to
+ *     compile. Release it with g_regex_set_unref().
+ *
+ * Since: 2.40
+ */
+GRegexSet *
+g_regex_set_new (const gchar * const  *patterns,
+                 gssize                n_patterns,
+                 GRegexCompileFlags    compile_options,
+                 GRegexMatchFlags      match_options,
+                 GError              **error)
+{
+  GRegexSet *regex_set;
+  gchar **literals;
+  gsize *literal_lens;
+  guint i;
+
+  g_return_val_if_fail (patterns != NULL || n_patterns == 0, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (n_patterns < 0)
+    n_patterns = g_strv_length ((gchar **) patterns);
+
+  regex_set = g_new0 (GRegexSet, 1);
+  regex_set->ref_count = 1;
+  regex_set->n_regexes = n_patterns;
+  regex_set->regexes = g_new0 (GRegex *, n_patterns);
+  regex_set->filters = g_new (RegexSetFilter, n_patterns);
+
+  for (i = 0; i < regex_set->n_regexes; i++)
+    {
+      regex_set->regexes[i] = g_regex_new (patterns[i], compile_options,
+                                           match_options, error);
+      if (regex_set->regexes[i] == NULL)
+        {
+          g_regex_set_unref (regex_set);
+          return NULL;
+        }
+
+      regex_set_filter_init (&regex_set->filters[i], regex_set->regexes[i]);
+    }
+
+  literals = g_new (gchar *, n_patterns);
+  literal_lens = g_new (gsize, n_patterns);
+  for (i = 0; i < regex_set->n_regexes; i++)
+    {
+      literals[i] = g_malloc (REGEX_SET_MAX_LITERAL);
+      literal_lens[i] = regex_literal_prefix (patterns[i], compile_options,
+                                              literals[i]);
+    }
+
+  regex_set_build_automaton (regex_set, literals, literal_lens);
+
+  for (i = 0; i < regex_set->n_regexes; i++)
+    g_free (literals[i]);
+  g_free (literals);
+  g_free (literal_lens);
+
+  return regex_set;
+}
+
+/**
+ * g_regex_set_ref:
+ * @regex_set: a #GRegexSet
+ *
+ * Increases the reference count of @regex_set by 1.
+ *
+ * Returns: @regex_set
+ *
+ * Since: 2.40
+ */
+GRegexSet *
+g_regex_set_ref (GRegexSet *regex_set)
+{
+  g_return_val_if_fail (regex_set != NULL, NULL);
+  g_atomic_int_inc (&regex_set->ref_count);
+  return regex_set;
+}
+
+/**
+ * g_regex_set_unref:
+ * @regex_set: a #GRegexSet
+ *
+ * Decreases the reference count of @regex_set by 1. When the reference
+ * count drops to 0, it frees all the memory used by the set.
+ *
+ * Since: 2.40
+ */
+void
+g_regex_set_unref (GRegexSet *regex_set)
+{
+  guint i;
+
+  g_return_if_fail (regex_set != NULL);
+
+  if (g_atomic_int_dec_and_test (&regex_set->ref_count))
+    {
+      for (i = 0; i < regex_set->n_regexes; i++)
+        if (regex_set->regexes[i] != NULL)
+          g_regex_unref (regex_set->regexes[i]);
+      g_free (regex_set->regexes);
+      g_free (regex_set->filters);
+      g_free (regex_set->transitions);
+      g_free (regex_set->fail);
+      g_free (regex_set->bfs_order);
+      g_free (regex_set);
+    }
+}
+
+/**
+ * g_regex_set_get_n_patterns:
+ * @regex_set: a #GRegexSet
+ *
+ * Gets the number of patterns in @regex_set.
+ *
+ * Returns: the number of patterns
+ *
+ * Since: 2.40
+ */
+guint
+g_regex_set_get_n_patterns (const GRegexSet *regex_set)
+{
+  g_return_val_if_fail (regex_set != NULL, 0);
+
+  return regex_set->n_regexes;
+}
+
+/**
+ * g_regex_set_get_regex:
+ * @regex_set: a #GRegexSet
+ * @index_: the index of a pattern
+ *
+ * Gets the compiled form of the pattern at @index_ in @regex_set, for
+ * example to extract the subpatterns of a match reported by
+ * g_regex_set_match().
+ *
+ * Returns: (transfer none): the #GRegex, owned by @regex_set
+ *
+ * Since: 2.40
+ */
+GRegex *
+g_regex_set_get_regex (const GRegexSet *regex_set,
+                       guint            index_)
+{
+  g_return_val_if_fail (regex_set != NULL, NULL);
+  g_return_val_if_fail (index_ < regex_set->n_regexes, NULL);
+
+  return regex_set->regexes[index_];
+}
+
+/**
+ * g_regex_set_match:
+ * @regex_set: a #GRegexSet
+ * @string: (array length=string_len): the string to scan for matches
+ * @string_len: the length of @string, or -1 if @string is nul-terminated
+ * @match_options: match options
+ * @matches: (element-type guint) (allow-none): a #GArray of #guint to
+ *     store the indexes of the matching patterns in, or %NULL
+ * @error: location to store the error occurring, or %NULL to ignore errors
+ *
+ * Finds the patterns of @regex_set that match @string.
+ *
+ * If @matches is not %NULL, it is cleared and then filled with the
+ * indexes of all the matching patterns, in increasing order.  Reusing
+ * the same array for many strings avoids allocating memory on each
+ * call.  If @matches is %NULL, matching stops at the first pattern that
+ * matches.
+ *
+ * Returns: %TRUE if at least one pattern matched
+ *
+ * Since: 2.40
+ */
+gboolean
+g_regex_set_match (const GRegexSet   *regex_set,
+                   const gchar       *string,
+                   gssize             string_len,
+                   GRegexMatchFlags   match_options,
+                   GArray            *matches,
+                   GError           **error)
+{
+  gboolean present[256] = { 0, };
+  guint8 stack_reached[1024];
+  guint8 *reached = NULL;
+  gboolean matched = FALSE;
+  guint state = 0;
+  guint i;
+
+  g_return_val_if_fail (regex_set != NULL, FALSE);
+  g_return_val_if_fail (string != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  g_return_val_if_fail ((match_options & ~G_REGEX_MATCH_MASK) == 0, FALSE);
+
+  if (string_len < 0)
+    string_len = strlen (string);
+
+  if (matches != NULL)
+    g_array_set_size (matches, 0);
+
+  if (regex_set->n_states > 0)
+    {
+      if (regex_set->n_states <= sizeof stack_reached)
+        reached = stack_reached;
+      else
+        reached = g_malloc (regex_set->n_states);
+      memset (reached, 0, regex_set->n_states);
+    }
+
+  for (i = 0; i < string_len; i++)
+    {
+      guchar c = string[i];
+
+      present[(guchar) g_ascii_tolower (c)] = TRUE;
+      if (reached)
+        {
+          state = regex_set->transitions[state * regex_set->n_classes +
+                                         regex_set->byte_class[c]];
+          reached[state] = TRUE;
+        }
+    }
+
+  /* a state was reached if any longer state failing to it was */
+  if (reached)
+    for (i = regex_set->n_states - 1; i > 0; i--)
+      {
+        guint s = regex_set->bfs_order[i];
+        if (reached[s])
+          reached[regex_set->fail[s]] = TRUE;
+      }
+
+  for (i = 0; i < regex_set->n_regexes; i++)
+    {
+      const RegexSetFilter *filter = &regex_set->filters[i];
+      GError *tmp_error = NULL;
+
+      if (string_len < filter->min_length ||
+          (filter->literal_state != 0 && !reached[filter->literal_state]) ||
+          (filter->first_byte >= 0 && !present[filter->first_byte]) ||
+          (filter->required_byte >= 0 && !present[filter->required_byte]))
+        continue;
+
+      if (regex_match_only (regex_set->regexes[i], string, string_len,
+                            0, match_options, &tmp_error))
+        {
+          matched = TRUE;
+          if (matches == NULL)
+            break;
+          g_array_append_val (matches, i);
+        }
+      else if (tmp_error != NULL)
+        {
+          g_propagate_error (error, tmp_error);
+          matched = FALSE;
+          break;
+        }
+    }
+
+  if (reached != stack_reached)
+    g_free (reached);
+
+  return matched;
+}
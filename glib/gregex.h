@@ -27,6 +27,7 @@
 #endif
 
 #include <glib/gerror.h>
+#include <glib/garray.h>
 #include <glib/gstring.h>
 
 G_BEGIN_DECLS
@@ -286,6 +287,10 @@ GQuark g_regex_error_quark (void);
  *    characters '\r', '\n' and '\r\n'. Since: 2.34
  * @G_REGEX_JAVASCRIPT_COMPAT: Changes behaviour so that it is compatible with
  *     JavaScript rather than PCRE. Since: 2.34
+ * @G_REGEX_JIT: Like #G_REGEX_OPTIMIZE, but also compile the pattern to
+ *     machine code, which usually makes matching much faster. This is
+ *     silently ignored if the PCRE library doesn't support JIT compilation.
+ *     Since: 2.40
  *
  * Flags specifying compile-time options.
  *
@@ -305,6 +310,7 @@ typedef enum
   G_REGEX_RAW               = 1 << 11,
   G_REGEX_NO_AUTO_CAPTURE   = 1 << 12,
   G_REGEX_OPTIMIZE          = 1 << 13,
+  G_REGEX_JIT               = 1 << 14,
   G_REGEX_FIRSTLINE         = 1 << 18,
   G_REGEX_DUPNAMES          = 1 << 19,
   G_REGEX_NEWLINE_CR        = 1 << 20,
@@ -415,6 +421,17 @@ typedef struct _GRegex		GRegex;
 
 typedef struct _GMatchInfo	GMatchInfo;
 
+/**
+ * GRegexSet:
+ *
+ * A set of compiled regular expressions that are matched against a
+ * string together, see g_regex_set_new(). This structure is opaque
+ * and its fields cannot be accessed directly.
+ *
+ * Since: 2.40
+ */
+typedef struct _GRegexSet	GRegexSet;
+
 /**
  * GRegexEvalCallback:
  * @match_info: the #GMatchInfo generated by the match.
@@ -569,6 +586,13 @@ void		  g_match_info_free		(GMatchInfo          *match_info);
 GLIB_AVAILABLE_IN_ALL
 gboolean	  g_match_info_next		(GMatchInfo          *match_info,
 						 GError             **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean	  g_match_info_rematch		(GMatchInfo          *match_info,
+						 const gchar         *string,
+						 gssize               string_len,
+						 gint                 start_position,
+						 GRegexMatchFlags     match_options,
+						 GError             **error);
 GLIB_AVAILABLE_IN_ALL
 gboolean	  g_match_info_matches		(const GMatchInfo    *match_info);
 GLIB_AVAILABLE_IN_ALL
@@ -598,6 +622,30 @@ gboolean	  g_match_info_fetch_named_pos	(const GMatchInfo    *match_info,
 GLIB_AVAILABLE_IN_ALL
 gchar		**g_match_info_fetch_all	(const GMatchInfo    *match_info);
 
+/* GRegexSet */
+GLIB_AVAILABLE_IN_2_40
+GRegexSet	 *g_regex_set_new		(const gchar * const  *patterns,
+						 gssize               n_patterns,
+						 GRegexCompileFlags   compile_options,
+						 GRegexMatchFlags     match_options,
+						 GError             **error);
+GLIB_AVAILABLE_IN_2_40
+GRegexSet	 *g_regex_set_ref		(GRegexSet           *regex_set);
+GLIB_AVAILABLE_IN_2_40
+void		  g_regex_set_unref		(GRegexSet           *regex_set);
+GLIB_AVAILABLE_IN_2_40
+guint		  g_regex_set_get_n_patterns	(const GRegexSet     *regex_set);
+GLIB_AVAILABLE_IN_2_40
+GRegex		 *g_regex_set_get_regex		(const GRegexSet     *regex_set,
+						 guint                index_);
+GLIB_AVAILABLE_IN_2_40
+gboolean	  g_regex_set_match		(const GRegexSet     *regex_set,
+						 const gchar         *string,
+						 gssize               string_len,
+						 GRegexMatchFlags     match_options,
+						 GArray              *matches,
+						 GError             **error);
+
 G_END_DECLS
 
 #endif  /*  __G_REGEX_H__ */
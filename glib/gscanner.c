@@ -264,6 +264,12 @@
  * @scope_0_fallback: specifies if a symbol is searched for in the
  *     default scope in addition to the current scope (the default is %FALSE).
  * @store_int64: use value.v_int64 rather than v_int
+ * @identifier_view: specifies that the string of an identifier token
+ *     is not copied, but points into a buffer owned by the scanner
+ *     that is reused for later identifiers (the default is %FALSE).
+ *     The string remains valid for as long as the token is current or
+ *     peeked, which is the same as without this option, but it must
+ *     never be freed or modified.  Since: 2.40
  *
  * Specifies the #GScanner parser configuration. Most settings can
  * be changed during the parsing phase and will affect the lexical
@@ -285,13 +291,33 @@
 /* --- typedefs --- */
 typedef	struct	_GScannerKey	GScannerKey;
 
+typedef	struct	_GRealScanner	GRealScanner;
+
 struct	_GScannerKey
 {
   guint		 scope_id;
+  guint		 symbol_hash;	/* hash of symbol alone, see KEY_HASH() */
   gchar		*symbol;
   gpointer	 value;
 };
 
+struct	_GRealScanner
+{
+  GScanner	 scanner;
+  
+  /* Identifiers are scanned into one of these instead of a fresh
+   * GString.  With identifier_view set, the token value points
+   * straight into the buffer; there are two of them so that peeking
+   * the next token does not clobber the current one.
+   */
+  GString	*identifier[2];
+};
+
+#define	KEY_HASH(scope_id, symbol_hash)	((symbol_hash) * 33 + (scope_id))
+
+/* symbols shorter than this are folded to lower case on the stack */
+#define	SYMBOL_BUFFER_SIZE	(64)
+
 
 /* --- variables --- */
 static const GScannerConfig g_scanner_config_template =
@@ -337,11 +363,15 @@ static const GScannerConfig g_scanner_config_template =
   FALSE			/* symbol_2_token */,
   FALSE			/* scope_0_fallback */,
   FALSE			/* store_int64 */,
+  FALSE			/* identifier_view */,
 };
 
 
 /* --- prototypes --- */
 static inline
+GScannerKey*	g_scanner_lookup_key	  (GScanner	*scanner,
+					   GScannerKey	*key);
+static inline
 GScannerKey*	g_scanner_lookup_internal (GScanner	*scanner,
 					   guint	 scope_id,
 					   const gchar	*symbol);
@@ -404,12 +434,14 @@ g_scanner_char_2_num (guchar	c,
 GScanner *
 g_scanner_new (const GScannerConfig *config_templ)
 {
+  GRealScanner *rscanner;
   GScanner *scanner;
   
   if (!config_templ)
     config_templ = &g_scanner_config_template;
   
-  scanner = g_new0 (GScanner, 1);
+  rscanner = g_new0 (GRealScanner, 1);
+  scanner = &rscanner->scanner;
   
   scanner->user_data = NULL;
   scanner->max_parse_errors = 1;
@@ -447,6 +479,7 @@ g_scanner_new (const GScannerConfig *config_templ)
   scanner->config->symbol_2_token	 = config_templ->symbol_2_token;
   scanner->config->scope_0_fallback	 = config_templ->scope_0_fallback;
   scanner->config->store_int64		 = config_templ->store_int64;
+  scanner->config->identifier_view	 = config_templ->identifier_view;
   
   scanner->token = G_TOKEN_NONE;
   scanner->value.v_int64 = 0;
@@ -465,32 +498,75 @@ g_scanner_new (const GScannerConfig *config_templ)
   scanner->buffer = NULL;
   scanner->scope_id = 0;
   
+  rscanner->identifier[0] = g_string_new (NULL);
+  rscanner->identifier[1] = g_string_new (NULL);
+  
   scanner->msg_handler = g_scanner_msg_handler;
   
   return scanner;
 }
 
-static inline void
-g_scanner_free_value (GTokenType     *token_p,
-		      GTokenValue     *value_p)
+static inline gboolean
+g_scanner_token_has_string (GTokenType token)
 {
-  switch (*token_p)
+  switch (token)
     {
     case G_TOKEN_STRING:
     case G_TOKEN_IDENTIFIER:
     case G_TOKEN_IDENTIFIER_NULL:
     case G_TOKEN_COMMENT_SINGLE:
     case G_TOKEN_COMMENT_MULTI:
-      g_free (value_p->v_string);
-      break;
+      return TRUE;
       
     default:
-      break;
+      return FALSE;
     }
+}
+
+/* Whether @value_p of a @token points into @buffer */
+static inline gboolean
+g_scanner_value_in_buffer (GTokenType	token,
+			   GTokenValue *value_p,
+			   GString     *buffer)
+{
+  return g_scanner_token_has_string (token) && value_p->v_string == buffer->str;
+}
+
+static inline void
+g_scanner_free_value (GScanner	     *scanner,
+		      GTokenType     *token_p,
+		      GTokenValue     *value_p)
+{
+  GRealScanner *rscanner = (GRealScanner *) scanner;
+  
+  if (g_scanner_token_has_string (*token_p) &&
+      !g_scanner_value_in_buffer (*token_p, value_p, rscanner->identifier[0]) &&
+      !g_scanner_value_in_buffer (*token_p, value_p, rscanner->identifier[1]))
+    g_free (value_p->v_string);
   
   *token_p = G_TOKEN_NONE;
 }
 
+/* Returns an empty identifier buffer that neither the current nor
+ * the peeked token refers to.  The token being scanned has already
+ * been freed, so at most one of the two buffers is in use.
+ */
+static GString *
+g_scanner_identifier_buffer (GScanner *scanner)
+{
+  GRealScanner *rscanner = (GRealScanner *) scanner;
+  GString *buffer;
+  
+  buffer = rscanner->identifier[0];
+  if (g_scanner_value_in_buffer (scanner->token, &scanner->value, buffer) ||
+      g_scanner_value_in_buffer (scanner->next_token, &scanner->next_value, buffer))
+    buffer = rscanner->identifier[1];
+  
+  g_string_truncate (buffer, 0);
+  
+  return buffer;
+}
+
 static void
 g_scanner_destroy_symbol_table_entry (gpointer _key,
 				      gpointer _value,
@@ -517,10 +593,12 @@ g_scanner_destroy (GScanner *scanner)
   g_hash_table_foreach (scanner->symbol_table, 
 			g_scanner_destroy_symbol_table_entry, NULL);
   g_hash_table_destroy (scanner->symbol_table);
-  g_scanner_free_value (&scanner->token, &scanner->value);
-  g_scanner_free_value (&scanner->next_token, &scanner->next_value);
+  g_scanner_free_value (scanner, &scanner->token, &scanner->value);
+  g_scanner_free_value (scanner, &scanner->next_token, &scanner->next_value);
   g_free (scanner->config);
   g_free (scanner->buffer);
+  g_string_free (((GRealScanner *) scanner)->identifier[0], TRUE);
+  g_string_free (((GRealScanner *) scanner)->identifier[1], TRUE);
   g_free (scanner);
 }
 
@@ -617,43 +695,83 @@ static guint
 g_scanner_key_hash (gconstpointer v)
 {
   const GScannerKey *key = v;
-  gchar *c;
-  guint h;
   
-  h = key->scope_id;
-  for (c = key->symbol; *c; c++)
+  return KEY_HASH (key->scope_id, key->symbol_hash);
+}
+
+static inline guint
+g_scanner_symbol_hash (const gchar *symbol)
+{
+  const gchar *c;
+  guint h = 0;
+  
+  for (c = symbol; *c; c++)
     h = (h << 5) - h + *c;
   
   return h;
 }
 
-static inline GScannerKey*
-g_scanner_lookup_internal (GScanner	*scanner,
-			   guint	 scope_id,
-			   const gchar	*symbol)
+/* Prepares @key for looking up @symbol in any scope.  If the scanner
+ * is case insensitive, the symbol is folded to lower case into @buffer
+ * (which must be SYMBOL_BUFFER_SIZE bytes long), or onto the heap if
+ * it doesn't fit.  Release the key with g_scanner_lookup_key_clear().
+ */
+static inline void
+g_scanner_lookup_key_init (GScanner	*scanner,
+			   GScannerKey	*key,
+			   const gchar	*symbol,
+			   gchar	*buffer)
 {
-  GScannerKey	*key_p;
-  GScannerKey key;
-  
-  key.scope_id = scope_id;
+  key->scope_id = 0;
+  key->value = NULL;
   
   if (!scanner->config->case_sensitive)
     {
+      gsize length;
       gchar *d;
       const gchar *c;
       
-      key.symbol = g_new (gchar, strlen (symbol) + 1);
-      for (d = key.symbol, c = symbol; *c; c++, d++)
+      length = strlen (symbol);
+      key->symbol = length < SYMBOL_BUFFER_SIZE ? buffer : g_malloc (length + 1);
+      for (d = key->symbol, c = symbol; *c; c++, d++)
 	*d = to_lower (*c);
       *d = 0;
-      key_p = g_hash_table_lookup (scanner->symbol_table, &key);
-      g_free (key.symbol);
     }
   else
-    {
-      key.symbol = (gchar*) symbol;
-      key_p = g_hash_table_lookup (scanner->symbol_table, &key);
-    }
+    key->symbol = (gchar*) symbol;
+  
+  key->symbol_hash = g_scanner_symbol_hash (key->symbol);
+}
+
+static inline void
+g_scanner_lookup_key_clear (GScannerKey *key,
+			    const gchar *symbol,
+			    gchar	*buffer)
+{
+  if (key->symbol != symbol && key->symbol != buffer)
+    g_free (key->symbol);
+}
+
+static inline GScannerKey*
+g_scanner_lookup_key (GScanner	  *scanner,
+		      GScannerKey *key)
+{
+  return g_hash_table_lookup (scanner->symbol_table, key);
+}
+
+static inline GScannerKey*
+g_scanner_lookup_internal (GScanner	*scanner,
+			   guint	 scope_id,
+			   const gchar	*symbol)
+{
+  gchar buffer[SYMBOL_BUFFER_SIZE];
+  GScannerKey	*key_p;
+  GScannerKey key;
+  
+  g_scanner_lookup_key_init (scanner, &key, symbol, buffer);
+  key.scope_id = scope_id;
+  key_p = g_scanner_lookup_key (scanner, &key);
+  g_scanner_lookup_key_clear (&key, symbol, buffer);
   
   return key_p;
 }
@@ -708,6 +826,7 @@ g_scanner_scope_add_symbol (GScanner	*scanner,
 	      c++;
 	    }
 	}
+      key->symbol_hash = g_scanner_symbol_hash (key->symbol);
       g_hash_table_insert (scanner->symbol_table, key, key);
     }
   else
@@ -977,7 +1096,7 @@ g_scanner_get_next_token (GScanner	*scanner)
   
   if (scanner->next_token != G_TOKEN_NONE)
     {
-      g_scanner_free_value (&scanner->token, &scanner->value);
+      g_scanner_free_value (scanner, &scanner->token, &scanner->value);
       
       scanner->token = scanner->next_token;
       scanner->value = scanner->next_value;
@@ -1652,7 +1771,7 @@ g_scanner_get_token_i (GScanner	*scanner,
 {
   do
     {
-      g_scanner_free_value (token_p, value_p);
+      g_scanner_free_value (scanner, token_p, value_p);
       g_scanner_get_token_ll (scanner, token_p, value_p, line_p, position_p);
     }
   while (((*token_p > 0 && *token_p < 256) &&
@@ -1721,6 +1840,7 @@ g_scanner_get_token_ll	(GScanner	*scanner,
   gboolean	   in_string_sq;
   gboolean	   in_string_dq;
   GString	  *gstring;
+  GString	  *identifier;
   GTokenValue	   value;
   guchar	   ch;
   
@@ -1739,6 +1859,7 @@ g_scanner_get_token_ll	(GScanner	*scanner,
   in_string_sq = FALSE;
   in_string_dq = FALSE;
   gstring = NULL;
+  identifier = NULL;
   
   do /* while (ch != 0) */
     {
@@ -2146,12 +2267,12 @@ g_scanner_get_token_ll	(GScanner	*scanner,
 			  g_scanner_peek_next_char (scanner)))
 		{
 		  token = G_TOKEN_IDENTIFIER;
-		  gstring = g_string_new (NULL);
-		  gstring = g_string_append_c (gstring, ch);
+		  identifier = g_scanner_identifier_buffer (scanner);
+		  g_string_append_c (identifier, ch);
 		  do
 		    {
 		      ch = g_scanner_get_char (scanner, line_p, position_p);
-		      gstring = g_string_append_c (gstring, ch);
+		      g_string_append_c (identifier, ch);
 		      ch = g_scanner_peek_next_char (scanner);
 		    }
 		  while (ch && strchr (config->cset_identifier_nth, ch));
@@ -2160,8 +2281,8 @@ g_scanner_get_token_ll	(GScanner	*scanner,
 	      else if (config->scan_identifier_1char)
 		{
 		  token = G_TOKEN_IDENTIFIER;
-		  value.v_identifier = g_new0 (gchar, 2);
-		  value.v_identifier[0] = ch;
+		  identifier = g_scanner_identifier_buffer (scanner);
+		  g_string_append_c (identifier, ch);
 		  ch = 0;
 		}
 	    }
@@ -2207,24 +2328,42 @@ g_scanner_get_token_ll	(GScanner	*scanner,
   
   if (token == G_TOKEN_IDENTIFIER)
     {
+      g_assert (identifier != NULL);
+      
       if (config->scan_symbols)
 	{
+	  gchar buffer[SYMBOL_BUFFER_SIZE];
+	  GScannerKey lookup_key;
 	  GScannerKey *key;
-	  guint scope_id;
 	  
-	  scope_id = scanner->scope_id;
-	  key = g_scanner_lookup_internal (scanner, scope_id, value.v_identifier);
-	  if (!key && scope_id && scanner->config->scope_0_fallback)
-	    key = g_scanner_lookup_internal (scanner, 0, value.v_identifier);
+	  /* the identifier is only copied out of the scanner's buffer
+	   * once we know that it isn't a symbol
+	   */
+	  g_scanner_lookup_key_init (scanner, &lookup_key, identifier->str, buffer);
+	  lookup_key.scope_id = scanner->scope_id;
+	  key = g_scanner_lookup_key (scanner, &lookup_key);
+	  if (!key && lookup_key.scope_id && scanner->config->scope_0_fallback)
+	    {
+	      lookup_key.scope_id = 0;
+	      key = g_scanner_lookup_key (scanner, &lookup_key);
+	    }
+	  g_scanner_lookup_key_clear (&lookup_key, identifier->str, buffer);
 	  
 	  if (key)
 	    {
-	      g_free (value.v_identifier);
 	      token = G_TOKEN_SYMBOL;
 	      value.v_symbol = key->value;
 	    }
 	}
       
+      if (token == G_TOKEN_IDENTIFIER)
+	{
+	  if (config->identifier_view)
+	    value.v_identifier = identifier->str;
+	  else
+	    value.v_identifier = g_strndup (identifier->str, identifier->len);
+	}
+      
       if (token == G_TOKEN_IDENTIFIER &&
 	  config->scan_identifier_NULL &&
 	  strlen (value.v_identifier) == 4)
@@ -163,6 +163,7 @@ struct	_GScannerConfig
   guint		symbol_2_token : 1;
   guint		scope_0_fallback : 1;		/* try scope 0 on lookups? */
   guint		store_int64 : 1; 		/* use value.v_int64 rather than v_int */
+  guint		identifier_view : 1;		/* identifiers point into a scanner buffer */
 
   /*< private >*/
   guint		padding_dummy;
@@ -23,6 +23,7 @@
 #include "gsequence.h"
 
 #include "gmem.h"
+#include "gqsort.h"
 #include "gtestutils.h"
 #include "gslice.h"
 /**
@@ -116,6 +117,10 @@ struct _GSequence
 struct _GSequenceNode
 {
   gint                  n_nodes;
+  guint                 is_end : 1; /* Set on the end node only, so that
+                                     * is_end() doesn't have to walk the
+                                     * tree to find the sequence
+                                     */
   GSequenceNode *       parent;
   GSequenceNode *       left;
   GSequenceNode *       right;
@@ -154,6 +159,8 @@ static void           node_insert_before (GSequenceNode            *node,
 static void           node_unlink        (GSequenceNode            *node);
 static void           node_join          (GSequenceNode            *left,
                                           GSequenceNode            *right);
+static void           node_build         (GSequenceNode           **nodes,
+                                          gint                      n_nodes);
 static void           node_insert_sorted (GSequenceNode            *node,
                                           GSequenceNode            *new,
                                           GSequenceNode            *end,
@@ -189,20 +196,7 @@ check_iter_access (GSequenceIter *iter)
 static gboolean
 is_end (GSequenceIter *iter)
 {
-  GSequence *seq;
-
-  if (iter->right)
-    return FALSE;
-
-  if (!iter->parent)
-    return TRUE;
-
-  if (iter->parent->right != iter)
-    return FALSE;
-
-  seq = get_sequence (iter);
-
-  return seq->end_node == iter;
+  return iter->is_end;
 }
 
 typedef struct
@@ -257,6 +251,7 @@ g_sequence_new (GDestroyNotify data_destroy)
   seq->data_destroy_notify = data_destroy;
 
   seq->end_node = node_new (seq);
+  seq->end_node->is_end = TRUE;
 
   seq->access_prohibited = FALSE;
 
@@ -852,6 +847,22 @@ g_sequence_lookup (GSequence *seq,
   return g_sequence_lookup_iter (seq, data, iter_compare, &info);
 }
 
+typedef struct
+{
+  GSequenceIterCompareFunc cmp_func;
+  gpointer                 cmp_data;
+} SortIterInfo;
+
+static gint
+node_array_compare (gconstpointer a,
+                    gconstpointer b,
+                    gpointer      data)
+{
+  const SortIterInfo *info = data;
+
+  return info->cmp_func (*(GSequenceNode **) a, *(GSequenceNode **) b, info->cmp_data);
+}
+
 /**
  * g_sequence_sort_iter:
  * @seq: a #GSequence
@@ -873,37 +884,40 @@ g_sequence_sort_iter (GSequence                *seq,
                       GSequenceIterCompareFunc  cmp_func,
                       gpointer                  cmp_data)
 {
-  GSequence *tmp;
-  GSequenceNode *begin, *end;
+  SortIterInfo info;
+  GSequenceNode **nodes;
+  GSequenceNode *node;
+  gint n_nodes, i;
 
   g_return_if_fail (seq != NULL);
   g_return_if_fail (cmp_func != NULL);
 
   check_seq_access (seq);
 
-  begin = g_sequence_get_begin_iter (seq);
-  end   = g_sequence_get_end_iter (seq);
+  n_nodes = g_sequence_get_length (seq);
+  if (n_nodes < 2)
+    return;
 
-  tmp = g_sequence_new (NULL);
-  tmp->real_sequence = seq;
+  /* Sort an array of the nodes with a stable merge sort, and rebuild
+   * the tree from it in linear time, rather than inserting the nodes
+   * one by one.  The nodes stay in @seq while they are compared, so
+   * g_sequence_iter_get_sequence() works from within @cmp_func.
+   */
+  nodes = g_new (GSequenceNode *, n_nodes + 1);
+  for (node = g_sequence_get_begin_iter (seq), i = 0; i < n_nodes; node = node_get_next (node), i++)
+    nodes[i] = node;
+  nodes[n_nodes] = seq->end_node;
 
-  g_sequence_move_range (g_sequence_get_begin_iter (tmp), begin, end);
+  info.cmp_func = cmp_func;
+  info.cmp_data = cmp_data;
 
   seq->access_prohibited = TRUE;
-  tmp->access_prohibited = TRUE;
-
-  while (g_sequence_get_length (tmp) > 0)
-    {
-      GSequenceNode *node = g_sequence_get_begin_iter (tmp);
-
-      node_insert_sorted (seq->end_node, node, seq->end_node,
-                          cmp_func, cmp_data);
-    }
-
-  tmp->access_prohibited = FALSE;
+  g_qsort_with_data (nodes, n_nodes, sizeof (GSequenceNode *), node_array_compare, &info);
   seq->access_prohibited = FALSE;
 
-  g_sequence_free (tmp);
+  node_build (nodes, n_nodes + 1);
+
+  g_free (nodes);
 }
 
 /**
@@ -1992,6 +2006,55 @@ node_unlink (GSequenceNode *node)
   node->parent = NULL;
 }
 
+/* Links the @n_nodes @nodes, which must all belong to one tree, into a
+ * treap with the nodes in array order.  This is the usual stack based
+ * construction of a cartesian tree: the stack holds the right spine of
+ * the tree built so far, and nodes popped off it are complete.
+ */
+static void
+node_build (GSequenceNode **nodes,
+            gint            n_nodes)
+{
+  GSequenceNode **stack;
+  GSequenceNode *last;
+  gint i, n_stack = 0;
+
+  stack = g_new (GSequenceNode *, n_nodes);
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      GSequenceNode *node = nodes[i];
+      guint priority = get_priority (node);
+
+      last = NULL;
+      while (n_stack > 0 && get_priority (stack[n_stack - 1]) < priority)
+        {
+          last = stack[--n_stack];
+          node_update_fields (last);
+        }
+
+      node->left = last;
+      if (last)
+        last->parent = node;
+
+      node->right = NULL;
+      if (n_stack > 0)
+        {
+          stack[n_stack - 1]->right = node;
+          node->parent = stack[n_stack - 1];
+        }
+      else
+        node->parent = NULL;
+
+      stack[n_stack++] = node;
+    }
+
+  while (n_stack > 0)
+    node_update_fields (stack[--n_stack]);
+
+  g_free (stack);
+}
+
 static void
 node_insert_sorted (GSequenceNode            *node,
                     GSequenceNode            *new,
@@ -39,6 +39,13 @@
 #include <windows.h>
 #include <process.h>
 #endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>           /* mmap() */
+#endif
+#ifdef __linux__
+#include <fcntl.h>              /* open() */
+#include <sys/syscall.h>        /* SYS_getcpu */
+#endif
 
 #include <stdio.h>              /* fputs/fprintf */
 
@@ -46,11 +53,13 @@
 
 #include "gmain.h"
 #include "gmem.h"               /* gslice.h */
+#include "gmem-internal.h"
 #include "gstrfuncs.h"
 #include "gutils.h"
 #include "gtrashstack.h"
 #include "gtestutils.h"
 #include "gthread.h"
+#include "gthreadprivate.h"
 #include "glib_trace.h"
 
 #include "valgrind.h"
@@ -172,6 +181,9 @@
  *   block sizes are limited to the system page size (no multiples thereof).
  *   as a fallback, on system without even valloc(), a malloc(3)-based page
  *   allocator with alloc-only behaviour is used.
+ * - the large chunk allocator, enabled with G_SLICE=large-chunks. chunks too
+ *   big for the slab allocator, up to LARGE_CHUNK_MAX, are carved from 2MB
+ *   regions that are backed by huge pages where possible, see [7].
  *
  * NOTES:
  * [1] some systems memalign(3) implementations may rely on boundary tagging for
@@ -189,6 +201,26 @@
  *     16KB.
  * [4] allocating ca. 8 chunks per block/page keeps a good balance between
  *     external and internal fragmentation (<= 12.5%). [Bonwick94]
+ * [5] on NUMA systems, the magazine cache and the slab rings are kept per node,
+ *     and each thread uses those of the node it last ran on when it visited
+ *     the magazine cache. slabs are carved up (and so first touched) by a
+ *     thread of their node, which places them there with the kernel's default
+ *     memory policy, and freed chunks always go back to the ring of the node
+ *     their slab belongs to. chunks freed by a thread of another node are not
+ *     sent back right away: they are reused on that node, and only return to
+ *     their own slab once their magazine gets trimmed from the cache.
+ * [6] per chunk size statistics are kept for G_SLICE_CONFIG_STATISTICS. the
+ *     counters updated on every alloc/free live in the thread memory, so they
+ *     need no locking; reading them sums up the counters of all live threads
+ *     (which is racy, but good enough for statistics) and of exited threads.
+ *     everything else is counted under the mutex that is held anyway.
+ * [7] large chunk sizes are rounded up to a quarter of a power of 2 (<= 25%
+ *     internal fragmentation), and each of these size classes has a free list.
+ *     new chunks are cut from the current region in address order. regions
+ *     come from explicit huge pages (MAP_HUGETLB) if the system has some
+ *     reserved, or else from a 2MB aligned mapping marked for transparent huge
+ *     pages. like the fallback page allocator, this is alloc-only: freed chunks
+ *     are kept on their free list, and regions are never given back.
  */
 
 /* --- macros and constants --- */
@@ -205,6 +237,13 @@
 #define SLAB_INDEX(al, asize)   ((asize) / P2ALIGNMENT - 1)                     /* asize must be P2ALIGNMENT aligned */
 #define SLAB_CHUNK_SIZE(al, ix) (((ix) + 1) * P2ALIGNMENT)
 #define SLAB_BPAGE_SIZE(al,csz) (8 * (csz) + SLAB_INFO_SIZE)
+#define NODE_SLOT(al, node, ix) ((node) * MAX_SLAB_INDEX (al) + (ix))         /* per node arrays, see [5] */
+#define MAX_NUMA_NODES          (64)
+#define LARGE_REGION_SIZE       (2 * 1024 * 1024)                               /* a huge page, see [7] */
+#define LARGE_CHUNK_MIN_SHIFT   (9)                                             /* above any MAX_SLAB_CHUNK_SIZE() */
+#define LARGE_CHUNK_MAX_SHIFT   (16)
+#define LARGE_CHUNK_MAX         (1 << LARGE_CHUNK_MAX_SHIFT)
+#define LARGE_CHUNK_CLASSES     (4 * (LARGE_CHUNK_MAX_SHIFT - LARGE_CHUNK_MIN_SHIFT + 1))
 
 /* optimized version of ALIGN (size, P2ALIGNMENT) */
 #if     GLIB_SIZEOF_SIZE_T * 2 == 8  /* P2ALIGNMENT */
@@ -230,6 +269,7 @@ struct _ChunkLink {
 struct _SlabInfo {
   ChunkLink *chunks;
   guint n_allocated;
+  guint node;
   SlabInfo *next, *prev;
 };
 typedef struct {
@@ -237,13 +277,23 @@ typedef struct {
   gsize      count;                     /* approximative chunks list length */
 } Magazine;
 typedef struct {
-  Magazine   *magazine1;                /* array of MAX_SLAB_INDEX (allocator) */
-  Magazine   *magazine2;                /* array of MAX_SLAB_INDEX (allocator) */
-} ThreadMemory;
+  gsize      n_allocs;                  /* through the magazine layer */
+  gsize      n_frees;
+  gsize      n_misses;                  /* magazine cache round trips */
+} ThreadStats;
+typedef struct _ThreadMemory ThreadMemory;
+struct _ThreadMemory {
+  Magazine     *magazine1;              /* array of MAX_SLAB_INDEX (allocator) */
+  Magazine     *magazine2;              /* array of MAX_SLAB_INDEX (allocator) */
+  ThreadStats  *stats;                  /* array of MAX_SLAB_INDEX (allocator), see [6] */
+  guint         node;                   /* see [5] */
+  ThreadMemory *next, *prev;            /* list of live threads */
+};
 typedef struct {
   gboolean always_malloc;
   gboolean bypass_magazines;
   gboolean debug_blocks;
+  gboolean large_chunks;
   gsize    working_set_msecs;
   guint    color_increment;
 } SliceConfig;
@@ -252,23 +302,40 @@ typedef struct {
   gsize         min_page_size, max_page_size;
   SliceConfig   config;
   gsize         max_slab_chunk_size_for_magazine_cache;
+  guint         n_nodes;
   /* magazine cache */
   GMutex        magazine_mutex;
-  ChunkLink   **magazines;                /* array of MAX_SLAB_INDEX (allocator) */
+  ChunkLink   **magazines;                /* array of n_nodes * MAX_SLAB_INDEX (allocator) */
   guint        *contention_counters;      /* array of MAX_SLAB_INDEX (allocator) */
   gint          mutex_counter;
   guint         stamp_counter;
   guint         last_stamp;
+  guint        *magazine_sizes;           /* array of MAX_SLAB_INDEX (allocator), 0 if automatic */
+  gsize        *n_trims;                  /* array of MAX_SLAB_INDEX (allocator) */
   /* slab allocator */
   GMutex        slab_mutex;
-  SlabInfo    **slab_stack;                /* array of MAX_SLAB_INDEX (allocator) */
+  SlabInfo    **slab_stack;                /* array of n_nodes * MAX_SLAB_INDEX (allocator) */
   guint        color_accu;
+  ThreadStats  *slab_stats;               /* array of MAX_SLAB_INDEX (allocator), bypassed magazines */
+  gsize        *n_slab_pages;             /* array of MAX_SLAB_INDEX (allocator) */
+  /* statistics, see [6] */
+  GMutex        stats_mutex;
+  ThreadMemory *thread_memories;
+  ThreadStats  *exited_thread_stats;      /* array of MAX_SLAB_INDEX (allocator) */
+  /* large chunk allocator, see [7] */
+  GMutex        large_mutex;
+  ChunkLink    *large_chunks[LARGE_CHUNK_CLASSES];
+  guint8       *large_next, *large_end;
 } Allocator;
 
 /* --- g-slice prototypes --- */
-static gpointer     slab_allocator_alloc_chunk       (gsize      chunk_size);
+static gpointer     slab_allocator_alloc_chunk       (gsize      chunk_size,
+                                                      guint      node);
 static void         slab_allocator_free_chunk        (gsize      chunk_size,
                                                       gpointer   mem);
+static gpointer     large_allocator_alloc_chunk      (gsize      chunk_size);
+static void         large_allocator_free_chunk       (gsize      chunk_size,
+                                                      gpointer   mem);
 static void         private_thread_memory_cleanup    (gpointer   data);
 static gpointer     allocator_memalign               (gsize      alignment,
                                                       gsize      memsize);
@@ -277,6 +344,9 @@ static void         allocator_memfree                (gsize      memsize,
 static inline void  magazine_cache_update_stamp      (void);
 static inline gsize allocator_get_magazine_threshold (Allocator *allocator,
                                                       guint      ix);
+static gboolean     allocator_has_size_class         (gint64     ix);
+static void         allocator_get_statistics         (guint      ix,
+                                                      gint64    *values);
 
 /* --- g-slice memory checker --- */
 static void     smc_notify_alloc  (void   *pointer,
@@ -285,13 +355,14 @@ static int      smc_notify_free   (void   *pointer,
                                    size_t  size);
 
 /* --- variables --- */
-static GPrivate    private_thread_memory = G_PRIVATE_INIT (private_thread_memory_cleanup);
+G_PRIVATE_TLS_DEFINE_STATIC (ThreadMemory *, thread_memory, private_thread_memory_cleanup)
 static gsize       sys_page_size = 0;
 static Allocator   allocator[1] = { { 0, }, };
 static SliceConfig slice_config = {
   FALSE,        /* always_malloc */
   FALSE,        /* bypass_magazines */
   FALSE,        /* debug_blocks */
+  FALSE,        /* large_chunks */
   15 * 1000,    /* working_set_msecs */
   1,            /* color increment, alt: 0x7fffffff */
 };
@@ -357,11 +428,64 @@ g_slice_get_config_state (GSliceConfig ckey,
       array[i++] = allocator_get_magazine_threshold (allocator, address);
       *n_values = i;
       return g_memdup (array, sizeof (array[0]) * *n_values);
+    case G_SLICE_CONFIG_STATISTICS:
+      if (!allocator_has_size_class (address))
+        return NULL;
+      allocator_get_statistics (address, array);
+      *n_values = 8;
+      return g_memdup (array, sizeof (array[0]) * *n_values);
+    case G_SLICE_CONFIG_MAGAZINE_SIZE:
+      if (!allocator_has_size_class (address))
+        return NULL;
+      array[i++] = SLAB_CHUNK_SIZE (allocator, address);
+      array[i++] = allocator->magazine_sizes[address];
+      array[i++] = allocator_get_magazine_threshold (allocator, address);
+      *n_values = i;
+      return g_memdup (array, sizeof (array[0]) * *n_values);
     default:
       return NULL;
     }
 }
 
+/**
+ * g_slice_set_config_state:
+ * @ckey: the configuration key, only %G_SLICE_CONFIG_MAGAZINE_SIZE is
+ *     supported
+ * @address: the index of a chunk size, as for g_slice_get_config_state()
+ * @value: the new value
+ *
+ * Changes per chunk size settings of the slice allocator while it is
+ * running.  For %G_SLICE_CONFIG_MAGAZINE_SIZE, @value is the number of
+ * chunks per magazine for chunks of that size (at least 4), or 0 to go
+ * back to sizes that adapt to lock contention.
+ *
+ * The matching g_slice_get_config_state() call returns the chunk size,
+ * the value set here and the magazine size in use.  With
+ * %G_SLICE_CONFIG_STATISTICS, it returns the chunk size followed by
+ * the number of allocations, frees, magazine hits, magazine misses
+ * (round trips to the magazine cache), magazines trimmed from the
+ * cache, slab pages held and the bytes of those pages that cannot hold
+ * chunks.
+ *
+ * Since: 2.40
+ */
+void
+g_slice_set_config_state (GSliceConfig ckey,
+                          gint64       address,
+                          gint64       value)
+{
+  switch (ckey)
+    {
+    case G_SLICE_CONFIG_MAGAZINE_SIZE:
+      g_return_if_fail (value == 0 || (value >= MIN_MAGAZINE_SIZE && value <= G_MAXUINT));
+      g_return_if_fail (allocator_has_size_class (address));
+      allocator->magazine_sizes[address] = value;
+      break;
+    default:
+      g_return_if_reached ();
+    }
+}
+
 static void
 slice_config_init (SliceConfig *config)
 {
@@ -376,6 +500,7 @@ slice_config_init (SliceConfig *config)
       const GDebugKey keys[] = {
         { "always-malloc", 1 << 0 },
         { "debug-blocks",  1 << 1 },
+        { "large-chunks",  1 << 2 },
       };
 
       flags = g_parse_debug_string (val, keys, G_N_ELEMENTS (keys));
@@ -383,6 +508,8 @@ slice_config_init (SliceConfig *config)
         config->always_malloc = TRUE;
       if (flags & (1 << 1))
         config->debug_blocks = TRUE;
+      if (flags & (1 << 2))
+        config->large_chunks = TRUE;
     }
   else
     {
@@ -397,6 +524,57 @@ slice_config_init (SliceConfig *config)
     }
 }
 
+/* the number of NUMA nodes, see [5]. this runs during initialization,
+ * so it may only use libc.
+ */
+static guint
+allocator_count_nodes (void)
+{
+  guint n_nodes = 1;
+#if defined (__linux__) && defined (SYS_getcpu)
+  /* the format is a list of ranges, like "0-3" or "0,2-3" */
+  char buffer[256];
+  ssize_t len = -1;
+  int fd = open ("/sys/devices/system/node/possible", O_RDONLY);
+  if (fd >= 0)
+    {
+      len = read (fd, buffer, sizeof (buffer) - 1);
+      close (fd);
+    }
+  if (len > 0)
+    {
+      guint node = 0;
+      ssize_t i;
+      for (i = 0; i < len; i++)
+        {
+          if (buffer[i] >= '0' && buffer[i] <= '9')
+            node = node * 10 + (buffer[i] - '0');
+          else
+            {
+              n_nodes = MAX (n_nodes, node + 1);
+              node = 0;
+            }
+        }
+      n_nodes = MAX (n_nodes, node + 1);
+    }
+#endif
+  return MIN (n_nodes, MAX_NUMA_NODES);
+}
+
+static inline guint
+allocator_current_node (void)
+{
+#if defined (__linux__) && defined (SYS_getcpu)
+  if (allocator->n_nodes > 1)
+    {
+      unsigned int cpu, node;
+      if (syscall (SYS_getcpu, &cpu, &node, NULL) == 0 && node < allocator->n_nodes)
+        return node;
+    }
+#endif
+  return 0;
+}
+
 static void
 g_slice_init_nomessage (void)
 {
@@ -433,18 +611,37 @@ g_slice_init_nomessage (void)
   /* we can only align to system page size */
   allocator->max_page_size = sys_page_size;
 #endif
+  allocator->n_nodes = allocator->config.always_malloc ? 1 : allocator_count_nodes ();
+#ifndef HAVE_MMAP
+  allocator->config.large_chunks = FALSE;
+#endif
+  if (allocator->config.always_malloc)
+    allocator->config.large_chunks = FALSE;
+  g_mutex_init (&allocator->large_mutex);
   if (allocator->config.always_malloc)
     {
       allocator->contention_counters = NULL;
       allocator->magazines = NULL;
+      allocator->magazine_sizes = NULL;
+      allocator->n_trims = NULL;
       allocator->slab_stack = NULL;
+      allocator->slab_stats = NULL;
+      allocator->n_slab_pages = NULL;
+      allocator->exited_thread_stats = NULL;
     }
   else
     {
       allocator->contention_counters = g_new0 (guint, MAX_SLAB_INDEX (allocator));
-      allocator->magazines = g_new0 (ChunkLink*, MAX_SLAB_INDEX (allocator));
-      allocator->slab_stack = g_new0 (SlabInfo*, MAX_SLAB_INDEX (allocator));
+      allocator->magazines = g_new0 (ChunkLink*, allocator->n_nodes * MAX_SLAB_INDEX (allocator));
+      allocator->magazine_sizes = g_new0 (guint, MAX_SLAB_INDEX (allocator));
+      allocator->n_trims = g_new0 (gsize, MAX_SLAB_INDEX (allocator));
+      allocator->slab_stack = g_new0 (SlabInfo*, allocator->n_nodes * MAX_SLAB_INDEX (allocator));
+      allocator->slab_stats = g_new0 (ThreadStats, MAX_SLAB_INDEX (allocator));
+      allocator->n_slab_pages = g_new0 (gsize, MAX_SLAB_INDEX (allocator));
+      allocator->exited_thread_stats = g_new0 (ThreadStats, MAX_SLAB_INDEX (allocator));
     }
+  g_mutex_init (&allocator->stats_mutex);
+  allocator->thread_memories = NULL;
 
   g_mutex_init (&allocator->magazine_mutex);
   allocator->mutex_counter = 0;
@@ -474,6 +671,10 @@ allocator_categorize (gsize aligned_chunk_size)
         return 2;       /* use slab allocator, see [2] */
       return 1;         /* use magazine cache */
     }
+  if (allocator->config.large_chunks &&
+      aligned_chunk_size > MAX_SLAB_CHUNK_SIZE (allocator) &&
+      aligned_chunk_size <= LARGE_CHUNK_MAX)
+    return 3;           /* use large chunk allocator, see [7] */
   return 0;             /* use malloc() */
 }
 
@@ -510,7 +711,7 @@ g_mutex_lock_a (GMutex *mutex,
 static inline ThreadMemory*
 thread_memory_from_self (void)
 {
-  ThreadMemory *tmem = g_private_get (&private_thread_memory);
+  ThreadMemory *tmem = thread_memory_get ();
   if (G_UNLIKELY (!tmem))
     {
       static GMutex init_mutex;
@@ -522,10 +723,19 @@ thread_memory_from_self (void)
       g_mutex_unlock (&init_mutex);
 
       n_magazines = MAX_SLAB_INDEX (allocator);
-      tmem = g_malloc0 (sizeof (ThreadMemory) + sizeof (Magazine) * 2 * n_magazines);
+      tmem = g_malloc0 (sizeof (ThreadMemory) + sizeof (Magazine) * 2 * n_magazines +
+                        sizeof (ThreadStats) * n_magazines);
       tmem->magazine1 = (Magazine*) (tmem + 1);
       tmem->magazine2 = &tmem->magazine1[n_magazines];
-      g_private_set (&private_thread_memory, tmem);
+      tmem->stats = (ThreadStats*) &tmem->magazine2[n_magazines];
+      tmem->node = allocator_current_node ();
+      g_mutex_lock (&allocator->stats_mutex);
+      tmem->next = allocator->thread_memories;
+      if (tmem->next)
+        tmem->next->prev = tmem;
+      allocator->thread_memories = tmem;
+      g_mutex_unlock (&allocator->stats_mutex);
+      thread_memory_set (tmem);
     }
   return tmem;
 }
@@ -587,6 +797,8 @@ allocator_get_magazine_threshold (Allocator *allocator,
   gsize chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
   guint threshold = MAX (MIN_MAGAZINE_SIZE, allocator->max_page_size / MAX (5 * chunk_size, 5 * 32));
   guint contention_counter = allocator->contention_counters[ix];
+  if (G_UNLIKELY (allocator->magazine_sizes[ix]))     /* G_SLICE_CONFIG_MAGAZINE_SIZE */
+    return allocator->magazine_sizes[ix];
   if (G_UNLIKELY (contention_counter))  /* single CPU bias */
     {
       /* adapt contention counter thresholds to chunk sizes */
@@ -641,11 +853,13 @@ magazine_chain_prepare_fields (ChunkLink *magazine_chunks)
 static void
 magazine_cache_trim (Allocator *allocator,
                      guint      ix,
+                     guint      node,
                      guint      stamp)
 {
   /* g_mutex_lock (allocator->mutex); done by caller */
   /* trim magazine cache from tail */
-  ChunkLink *current = magazine_chain_prev (allocator->magazines[ix]);
+  ChunkLink **magazines = &allocator->magazines[NODE_SLOT (allocator, node, ix)];
+  ChunkLink *current = magazine_chain_prev (*magazines);
   ChunkLink *trash = NULL;
   while (ABS (stamp - magazine_chain_uint_stamp (current)) >= allocator->config.working_set_msecs)
     {
@@ -660,10 +874,11 @@ magazine_cache_trim (Allocator *allocator,
       magazine_chain_stamp (current) = NULL;
       magazine_chain_prev (current) = trash;
       trash = current;
+      allocator->n_trims[ix]++;
       /* fixup list head if required */
-      if (current == allocator->magazines[ix])
+      if (current == *magazines)
         {
-          allocator->magazines[ix] = NULL;
+          *magazines = NULL;
           break;
         }
       current = prev;
@@ -691,14 +906,16 @@ magazine_cache_trim (Allocator *allocator,
 
 static void
 magazine_cache_push_magazine (guint      ix,
+                              guint      node,
                               ChunkLink *magazine_chunks,
                               gsize      count) /* must be >= MIN_MAGAZINE_SIZE */
 {
   ChunkLink *current = magazine_chain_prepare_fields (magazine_chunks);
+  ChunkLink **magazines = &allocator->magazines[NODE_SLOT (allocator, node, ix)];
   ChunkLink *next, *prev;
   g_mutex_lock (&allocator->magazine_mutex);
   /* add magazine at head */
-  next = allocator->magazines[ix];
+  next = *magazines;
   if (next)
     prev = magazine_chain_prev (next);
   else
@@ -711,30 +928,32 @@ magazine_cache_push_magazine (guint      ix,
   /* stamp magazine */
   magazine_cache_update_stamp();
   magazine_chain_stamp (current) = GUINT_TO_POINTER (allocator->last_stamp);
-  allocator->magazines[ix] = current;
+  *magazines = current;
   /* free old magazines beyond a certain threshold */
-  magazine_cache_trim (allocator, ix, allocator->last_stamp);
+  magazine_cache_trim (allocator, ix, node, allocator->last_stamp);
   /* g_mutex_unlock (allocator->mutex); was done by magazine_cache_trim() */
 }
 
 static ChunkLink*
 magazine_cache_pop_magazine (guint  ix,
+                             guint  node,
                              gsize *countp)
 {
+  ChunkLink **magazines = &allocator->magazines[NODE_SLOT (allocator, node, ix)];
   g_mutex_lock_a (&allocator->magazine_mutex, &allocator->contention_counters[ix]);
-  if (!allocator->magazines[ix])
+  if (!*magazines)
     {
       guint magazine_threshold = allocator_get_magazine_threshold (allocator, ix);
       gsize i, chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
       ChunkLink *chunk, *head;
       g_mutex_unlock (&allocator->magazine_mutex);
       g_mutex_lock (&allocator->slab_mutex);
-      head = slab_allocator_alloc_chunk (chunk_size);
+      head = slab_allocator_alloc_chunk (chunk_size, node);
       head->data = NULL;
       chunk = head;
       for (i = 1; i < magazine_threshold; i++)
         {
-          chunk->next = slab_allocator_alloc_chunk (chunk_size);
+          chunk->next = slab_allocator_alloc_chunk (chunk_size, node);
           chunk = chunk->next;
           chunk->data = NULL;
         }
@@ -745,13 +964,13 @@ magazine_cache_pop_magazine (guint  ix,
     }
   else
     {
-      ChunkLink *current = allocator->magazines[ix];
+      ChunkLink *current = *magazines;
       ChunkLink *prev = magazine_chain_prev (current);
       ChunkLink *next = magazine_chain_next (current);
       /* unlink */
       magazine_chain_next (prev) = next;
       magazine_chain_prev (next) = prev;
-      allocator->magazines[ix] = next == current ? NULL : next;
+      *magazines = next == current ? NULL : next;
       g_mutex_unlock (&allocator->magazine_mutex);
       /* clear special fields and hand out */
       *countp = (gsize) magazine_chain_count (current);
@@ -780,7 +999,7 @@ private_thread_memory_cleanup (gpointer data)
         {
           Magazine *mag = mags[j];
           if (mag->count >= MIN_MAGAZINE_SIZE)
-            magazine_cache_push_magazine (ix, mag->chunks, mag->count);
+            magazine_cache_push_magazine (ix, tmem->node, mag->chunks, mag->count);
           else
             {
               const gsize chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
@@ -794,6 +1013,20 @@ private_thread_memory_cleanup (gpointer data)
             }
         }
     }
+  g_mutex_lock (&allocator->stats_mutex);
+  for (ix = 0; allocator->exited_thread_stats && ix < n_magazines; ix++)
+    {
+      allocator->exited_thread_stats[ix].n_allocs += tmem->stats[ix].n_allocs;
+      allocator->exited_thread_stats[ix].n_frees += tmem->stats[ix].n_frees;
+      allocator->exited_thread_stats[ix].n_misses += tmem->stats[ix].n_misses;
+    }
+  if (tmem->prev)
+    tmem->prev->next = tmem->next;
+  else
+    allocator->thread_memories = tmem->next;
+  if (tmem->next)
+    tmem->next->prev = tmem->prev;
+  g_mutex_unlock (&allocator->stats_mutex);
   g_free (tmem);
 }
 
@@ -804,7 +1037,10 @@ thread_memory_magazine1_reload (ThreadMemory *tmem,
   Magazine *mag = &tmem->magazine1[ix];
   mem_assert (mag->chunks == NULL); /* ensure that we may reset mag->count */
   mag->count = 0;
-  mag->chunks = magazine_cache_pop_magazine (ix, &mag->count);
+  /* threads move between nodes, so look again on each trip to the cache */
+  tmem->node = allocator_current_node ();
+  mag->chunks = magazine_cache_pop_magazine (ix, tmem->node, &mag->count);
+  tmem->stats[ix].n_misses++;
 }
 
 static void
@@ -812,9 +1048,10 @@ thread_memory_magazine2_unload (ThreadMemory *tmem,
                                 guint         ix)
 {
   Magazine *mag = &tmem->magazine2[ix];
-  magazine_cache_push_magazine (ix, mag->chunks, mag->count);
+  magazine_cache_push_magazine (ix, tmem->node, mag->chunks, mag->count);
   mag->chunks = NULL;
   mag->count = 0;
+  tmem->stats[ix].n_misses++;
 }
 
 static inline void
@@ -848,6 +1085,7 @@ thread_memory_magazine1_alloc (ThreadMemory *tmem,
   ChunkLink *chunk = magazine_chain_pop_head (&mag->chunks);
   if (G_LIKELY (mag->count > 0))
     mag->count--;
+  tmem->stats[ix].n_allocs++;
   return chunk;
 }
 
@@ -862,6 +1100,7 @@ thread_memory_magazine2_free (ThreadMemory *tmem,
   chunk->next = mag->chunks;
   mag->chunks = chunk;
   mag->count++;
+  tmem->stats[ix].n_frees++;
 }
 
 /* --- API functions --- */
@@ -1009,11 +1248,16 @@ g_slice_alloc (gsize mem_size)
   else if (acat == 2)           /* allocate through slab allocator */
     {
       g_mutex_lock (&allocator->slab_mutex);
-      mem = slab_allocator_alloc_chunk (chunk_size);
+      mem = slab_allocator_alloc_chunk (chunk_size, tmem->node);
+      allocator->slab_stats[SLAB_INDEX (allocator, chunk_size)].n_allocs++;
       g_mutex_unlock (&allocator->slab_mutex);
     }
-  else                          /* delegate to system malloc */
+  else if (acat == 3)           /* allocate through large chunk allocator */
+    mem = large_allocator_alloc_chunk (chunk_size);
+  else                          /* delegate to system malloc, which samples */
     mem = g_malloc (mem_size);
+  if (acat != 0)
+    G_MEM_PROFILER_ALLOC (mem, mem_size);
   if (G_UNLIKELY (allocator->config.debug_blocks))
     smc_notify_alloc (mem, mem_size);
 
@@ -1095,6 +1339,8 @@ g_slice_free1 (gsize    mem_size,
   if (G_UNLIKELY (allocator->config.debug_blocks) &&
       !smc_notify_free (mem_block, mem_size))
     abort();
+  if (acat != 0)
+    G_MEM_PROFILER_FREE (mem_block);
   if (G_LIKELY (acat == 1))             /* allocate through magazine layer */
     {
       ThreadMemory *tmem = thread_memory_from_self();
@@ -1115,8 +1361,15 @@ g_slice_free1 (gsize    mem_size,
         memset (mem_block, 0, chunk_size);
       g_mutex_lock (&allocator->slab_mutex);
       slab_allocator_free_chunk (chunk_size, mem_block);
+      allocator->slab_stats[SLAB_INDEX (allocator, chunk_size)].n_frees++;
       g_mutex_unlock (&allocator->slab_mutex);
     }
+  else if (acat == 3)                   /* allocate through large chunk allocator */
+    {
+      if (G_UNLIKELY (g_mem_gc_friendly))
+        memset (mem_block, 0, chunk_size);
+      large_allocator_free_chunk (chunk_size, mem_block);
+    }
   else                                  /* delegate to system malloc */
     {
       if (G_UNLIKELY (g_mem_gc_friendly))
@@ -1168,6 +1421,13 @@ g_slice_free_chain_with_offset (gsize    mem_size,
    */
   gsize chunk_size = P2ALIGN (mem_size);
   guint acat = allocator_categorize (chunk_size);
+  if (G_UNLIKELY (g_mem_profiler_active) && acat != 0)
+    {
+      guint8 *current;
+
+      for (current = slice; current; current = *(gpointer*) (current + next_offset))
+        g_mem_profiler_forget (current);
+    }
   if (G_LIKELY (acat == 1))             /* allocate through magazine layer */
     {
       ThreadMemory *tmem = thread_memory_from_self();
@@ -1203,9 +1463,22 @@ g_slice_free_chain_with_offset (gsize    mem_size,
           if (G_UNLIKELY (g_mem_gc_friendly))
             memset (current, 0, chunk_size);
           slab_allocator_free_chunk (chunk_size, current);
+          allocator->slab_stats[SLAB_INDEX (allocator, chunk_size)].n_frees++;
         }
       g_mutex_unlock (&allocator->slab_mutex);
     }
+  else if (acat == 3)                   /* allocate through large chunk allocator */
+    while (slice)
+      {
+        guint8 *current = slice;
+        slice = *(gpointer*) (current + next_offset);
+        if (G_UNLIKELY (allocator->config.debug_blocks) &&
+            !smc_notify_free (current, mem_size))
+          abort();
+        if (G_UNLIKELY (g_mem_gc_friendly))
+          memset (current, 0, chunk_size);
+        large_allocator_free_chunk (chunk_size, current);
+      }
   else                                  /* delegate to system malloc */
     while (slice)
       {
@@ -1226,21 +1499,22 @@ allocator_slab_stack_push (Allocator *allocator,
                            guint      ix,
                            SlabInfo  *sinfo)
 {
+  SlabInfo **slab_stack = &allocator->slab_stack[NODE_SLOT (allocator, sinfo->node, ix)];
   /* insert slab at slab ring head */
-  if (!allocator->slab_stack[ix])
+  if (!*slab_stack)
     {
       sinfo->next = sinfo;
       sinfo->prev = sinfo;
     }
   else
     {
-      SlabInfo *next = allocator->slab_stack[ix], *prev = next->prev;
+      SlabInfo *next = *slab_stack, *prev = next->prev;
       next->prev = sinfo;
       prev->next = sinfo;
       sinfo->next = next;
       sinfo->prev = prev;
     }
-  allocator->slab_stack[ix] = sinfo;
+  *slab_stack = sinfo;
 }
 
 static gsize
@@ -1255,6 +1529,7 @@ allocator_aligned_page_size (Allocator *allocator,
 static void
 allocator_add_slab (Allocator *allocator,
                     guint      ix,
+                    guint      node,
                     gsize      chunk_size)
 {
   ChunkLink *chunk;
@@ -1281,6 +1556,7 @@ allocator_add_slab (Allocator *allocator,
   /* basic slab info setup */
   sinfo = (SlabInfo*) (mem + page_size - SLAB_INFO_SIZE);
   sinfo->n_allocated = 0;
+  sinfo->node = node;
   sinfo->chunks = NULL;
   /* figure cache colorization */
   n_chunks = ((guint8*) sinfo - mem) / chunk_size;
@@ -1301,23 +1577,26 @@ allocator_add_slab (Allocator *allocator,
   chunk->next = NULL;   /* last chunk */
   /* add slab to slab ring */
   allocator_slab_stack_push (allocator, ix, sinfo);
+  allocator->n_slab_pages[ix]++;
 }
 
 static gpointer
-slab_allocator_alloc_chunk (gsize chunk_size)
+slab_allocator_alloc_chunk (gsize chunk_size,
+                            guint node)
 {
   ChunkLink *chunk;
   guint ix = SLAB_INDEX (allocator, chunk_size);
+  SlabInfo **slab_stack = &allocator->slab_stack[NODE_SLOT (allocator, node, ix)];
   /* ensure non-empty slab */
-  if (!allocator->slab_stack[ix] || !allocator->slab_stack[ix]->chunks)
-    allocator_add_slab (allocator, ix, chunk_size);
+  if (!*slab_stack || !(*slab_stack)->chunks)
+    allocator_add_slab (allocator, ix, node, chunk_size);
   /* allocate chunk */
-  chunk = allocator->slab_stack[ix]->chunks;
-  allocator->slab_stack[ix]->chunks = chunk->next;
-  allocator->slab_stack[ix]->n_allocated++;
+  chunk = (*slab_stack)->chunks;
+  (*slab_stack)->chunks = chunk->next;
+  (*slab_stack)->n_allocated++;
   /* rotate empty slabs */
-  if (!allocator->slab_stack[ix]->chunks)
-    allocator->slab_stack[ix] = allocator->slab_stack[ix]->next;
+  if (!(*slab_stack)->chunks)
+    *slab_stack = (*slab_stack)->next;
   return chunk;
 }
 
@@ -1333,6 +1612,7 @@ slab_allocator_free_chunk (gsize    chunk_size,
   /* mask page address */
   guint8 *page = (guint8*) addr;
   SlabInfo *sinfo = (SlabInfo*) (page + page_size - SLAB_INFO_SIZE);
+  SlabInfo **slab_stack = &allocator->slab_stack[NODE_SLOT (allocator, sinfo->node, ix)];
   /* assert valid chunk count */
   mem_assert (sinfo->n_allocated > 0);
   /* add chunk to free list */
@@ -1348,8 +1628,8 @@ slab_allocator_free_chunk (gsize    chunk_size,
       SlabInfo *next = sinfo->next, *prev = sinfo->prev;
       next->prev = prev;
       prev->next = next;
-      if (allocator->slab_stack[ix] == sinfo)
-        allocator->slab_stack[ix] = next == sinfo ? NULL : next;
+      if (*slab_stack == sinfo)
+        *slab_stack = next == sinfo ? NULL : next;
       /* insert slab at head */
       allocator_slab_stack_push (allocator, ix, sinfo);
     }
@@ -1360,13 +1640,151 @@ slab_allocator_free_chunk (gsize    chunk_size,
       SlabInfo *next = sinfo->next, *prev = sinfo->prev;
       next->prev = prev;
       prev->next = next;
-      if (allocator->slab_stack[ix] == sinfo)
-        allocator->slab_stack[ix] = next == sinfo ? NULL : next;
+      if (*slab_stack == sinfo)
+        *slab_stack = next == sinfo ? NULL : next;
       /* free slab */
       allocator_memfree (page_size, page);
+      allocator->n_slab_pages[ix]--;
     }
 }
 
+/* --- large chunk allocator --- */
+static inline guint
+large_chunk_index (gsize  chunk_size,
+                   gsize *class_size)
+{
+  /* chunk_size is in (2^(shift-1), 2^shift], in steps of 2^(shift-3) */
+  guint shift = MAX (g_bit_storage (chunk_size - 1), LARGE_CHUNK_MIN_SHIFT);
+  gsize step = 1 << (shift - 3);
+  gsize n_steps = MAX ((chunk_size + step - 1) / step, 5);
+
+  *class_size = n_steps * step;
+  return (shift - LARGE_CHUNK_MIN_SHIFT) * 4 + (n_steps - 5);
+}
+
+static guint8 *
+large_allocator_new_region (void)
+{
+#ifdef HAVE_MMAP
+  guint8 *mem, *aligned;
+
+#ifdef MAP_HUGETLB
+  mem = mmap (NULL, LARGE_REGION_SIZE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mem != MAP_FAILED)
+    return mem;
+#endif
+
+  /* transparent huge pages need an aligned region, so map twice the size
+   * and cut off what is not needed
+   */
+  mem = mmap (NULL, 2 * LARGE_REGION_SIZE, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED)
+    mem_error ("failed to map %u bytes: %s\n", 2 * LARGE_REGION_SIZE, g_strerror (errno));
+  aligned = (guint8*) ALIGN ((gsize) mem, LARGE_REGION_SIZE);
+  if (aligned > mem)
+    munmap (mem, aligned - mem);
+  munmap (aligned + LARGE_REGION_SIZE, mem + LARGE_REGION_SIZE - aligned);
+#ifdef MADV_HUGEPAGE
+  madvise (aligned, LARGE_REGION_SIZE, MADV_HUGEPAGE);
+#endif
+  return aligned;
+#else
+  g_assert_not_reached ();
+  return NULL;
+#endif
+}
+
+static gpointer
+large_allocator_alloc_chunk (gsize chunk_size)
+{
+  gsize class_size;
+  guint ix = large_chunk_index (chunk_size, &class_size);
+  ChunkLink *chunk;
+  g_mutex_lock (&allocator->large_mutex);
+  chunk = allocator->large_chunks[ix];
+  if (chunk)
+    allocator->large_chunks[ix] = chunk->next;
+  else
+    {
+      /* the rest of a full region is wasted, which is < LARGE_CHUNK_MAX */
+      if ((gsize) (allocator->large_end - allocator->large_next) < class_size)
+        {
+          allocator->large_next = large_allocator_new_region ();
+          allocator->large_end = allocator->large_next + LARGE_REGION_SIZE;
+        }
+      chunk = (ChunkLink*) allocator->large_next;
+      allocator->large_next += class_size;
+    }
+  g_mutex_unlock (&allocator->large_mutex);
+  return chunk;
+}
+
+static void
+large_allocator_free_chunk (gsize    chunk_size,
+                            gpointer mem)
+{
+  gsize class_size;
+  guint ix = large_chunk_index (chunk_size, &class_size);
+  ChunkLink *chunk = mem;
+  g_mutex_lock (&allocator->large_mutex);
+  chunk->next = allocator->large_chunks[ix];
+  allocator->large_chunks[ix] = chunk;
+  g_mutex_unlock (&allocator->large_mutex);
+}
+
+/* --- statistics --- */
+static gboolean
+allocator_has_size_class (gint64 ix)
+{
+  if (G_UNLIKELY (sys_page_size == 0))
+    thread_memory_from_self ();         /* initializes the allocator */
+  return !allocator->config.always_malloc && ix >= 0 && ix < MAX_SLAB_INDEX (allocator);
+}
+
+static void
+allocator_get_statistics (guint   ix,
+                          gint64 *values)
+{
+  const gsize chunk_size = SLAB_CHUNK_SIZE (allocator, ix);
+  gsize page_size = allocator_aligned_page_size (allocator, SLAB_BPAGE_SIZE (allocator, chunk_size));
+  gsize n_chunks = (page_size - SLAB_INFO_SIZE) / chunk_size;
+  ThreadStats stats;
+  ThreadMemory *tmem;
+  gsize n_trims, n_pages;
+
+  g_mutex_lock (&allocator->stats_mutex);
+  stats = allocator->exited_thread_stats[ix];
+  for (tmem = allocator->thread_memories; tmem; tmem = tmem->next)
+    {
+      stats.n_allocs += tmem->stats[ix].n_allocs;
+      stats.n_frees += tmem->stats[ix].n_frees;
+      stats.n_misses += tmem->stats[ix].n_misses;
+    }
+  g_mutex_unlock (&allocator->stats_mutex);
+
+  g_mutex_lock (&allocator->magazine_mutex);
+  n_trims = allocator->n_trims[ix];
+  g_mutex_unlock (&allocator->magazine_mutex);
+
+  g_mutex_lock (&allocator->slab_mutex);
+  n_pages = allocator->n_slab_pages[ix];
+  values[1] = stats.n_allocs + allocator->slab_stats[ix].n_allocs;
+  values[2] = stats.n_frees + allocator->slab_stats[ix].n_frees;
+  g_mutex_unlock (&allocator->slab_mutex);
+
+  values[0] = chunk_size;
+  values[3] = stats.n_allocs + stats.n_frees - MIN (stats.n_misses, stats.n_allocs + stats.n_frees);
+  values[4] = stats.n_misses;
+  values[5] = n_trims;
+  values[6] = n_pages;
+  /* what the pages hold beyond their chunks: slab info, malloc padding
+   * and the remainder used for colorization
+   */
+  values[7] = n_pages * (page_size - NATIVE_MALLOC_PADDING - n_chunks * chunk_size);
+}
+
 /* --- memalign implementation --- */
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>             /* memalign() */
@@ -80,7 +80,9 @@ typedef enum {
   G_SLICE_CONFIG_WORKING_SET_MSECS,
   G_SLICE_CONFIG_COLOR_INCREMENT,
   G_SLICE_CONFIG_CHUNK_SIZES,
-  G_SLICE_CONFIG_CONTENTION_COUNTER
+  G_SLICE_CONFIG_CONTENTION_COUNTER,
+  G_SLICE_CONFIG_STATISTICS,
+  G_SLICE_CONFIG_MAGAZINE_SIZE
 } GSliceConfig;
 
 GLIB_DEPRECATED_IN_2_34
@@ -89,6 +91,8 @@ GLIB_DEPRECATED_IN_2_34
 gint64   g_slice_get_config	   (GSliceConfig ckey);
 GLIB_DEPRECATED_IN_2_34
 gint64*  g_slice_get_config_state  (GSliceConfig ckey, gint64 address, guint *n_values);
+GLIB_AVAILABLE_IN_2_40
+void     g_slice_set_config_state  (GSliceConfig ckey, gint64 address, gint64 value);
 
 #ifdef G_ENABLE_DEBUG
 GLIB_AVAILABLE_IN_ALL
@@ -31,7 +31,6 @@
 #include <signal.h>
 #include <string.h>
 #include <stdlib.h>   /* for fdwalk */
-#include <dirent.h>
 
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
@@ -41,6 +40,14 @@
 #include <sys/resource.h>
 #endif /* HAVE_SYS_RESOURCE_H */
 
+#ifdef HAVE_POSIX_SPAWN
+#include <spawn.h>
+#endif /* HAVE_POSIX_SPAWN */
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 #include "gspawn.h"
 #include "gthread.h"
 #include "glib/gstdio.h"
@@ -1029,6 +1036,19 @@ set_cloexec (void *data, gint fd)
   return 0;
 }
 
+static gint
+sane_open (const char *path, gint mode)
+{
+  gint ret;
+
+ retry:
+  ret = open (path, mode);
+  if (ret < 0 && errno == EINTR)
+    goto retry;
+
+  return ret;
+}
+
 #ifndef HAVE_FDWALK
 static int
 fdwalk (int (*cb)(void *data, int fd), void *data)
@@ -1041,39 +1061,62 @@ fdwalk (int (*cb)(void *data, int fd), void *data)
   struct rlimit rl;
 #endif
 
-#ifdef __linux__  
-  DIR *d;
-
-  if ((d = opendir("/proc/self/fd"))) {
-      struct dirent *de;
+#ifdef __linux__
+  /* Walk /proc/self/fd so that only descriptors which are actually
+   * open are visited. This runs between fork() and exec(), so read the
+   * directory with getdents64() into a buffer on the stack rather than
+   * going through opendir(), which allocates.
+   */
+  gint dir_fd;
 
-      while ((de = readdir(d))) {
-          glong l;
-          gchar *e = NULL;
+  dir_fd = sane_open ("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd >= 0)
+    {
+      union {
+        gchar buf[4096];
+        gint64 align;
+      } dents;
+      glong nread;
 
-          if (de->d_name[0] == '.')
-              continue;
-            
-          errno = 0;
-          l = strtol(de->d_name, &e, 10);
-          if (errno != 0 || !e || *e)
-              continue;
+      while ((nread = syscall (SYS_getdents64, dir_fd, dents.buf, sizeof (dents.buf))) > 0)
+        {
+          glong pos;
 
-          fd = (gint) l;
+          for (pos = 0; pos < nread; )
+            {
+              struct linux_dirent64 {
+                guint64        d_ino;
+                gint64         d_off;
+                unsigned short d_reclen;
+                unsigned char  d_type;
+                char           d_name[];
+              } *de = (struct linux_dirent64 *) (dents.buf + pos);
+              const gchar *p;
+
+              pos += de->d_reclen;
+
+              if (de->d_name[0] == '.')
+                continue;
+
+              fd = 0;
+              for (p = de->d_name; *p >= '0' && *p <= '9'; p++)
+                fd = fd * 10 + (*p - '0');
+              if (*p != '\0' || fd == dir_fd)
+                continue;
+
+              if ((res = cb (data, fd)) != 0)
+                break;
+            }
 
-          if ((glong) fd != l)
-              continue;
+          if (res != 0)
+            break;
+        }
 
-          if (fd == dirfd(d))
-              continue;
+      close_and_invalidate (&dir_fd);
 
-          if ((res = cb (data, fd)) != 0)
-              break;
-        }
-      
-      closedir(d);
-      return res;
-  }
+      if (nread >= 0 || res != 0)
+        return res;
+    }
 
   /* If /proc is not mounted or not accessible we fall back to the old
    * rlimit trick */
@@ -1088,6 +1131,15 @@ fdwalk (int (*cb)(void *data, int fd), void *data)
 #endif
       open_max = sysconf (_SC_OPEN_MAX);
 
+#ifdef F_MAXFD
+  /* Where the system can tell us the highest open descriptor, don't
+   * bother walking up to the (possibly huge) descriptor limit.
+   */
+  fd = fcntl (0, F_MAXFD);
+  if (fd >= 0 && fd < open_max)
+    open_max = fd + 1;
+#endif
+
   for (fd = 0; fd < open_max; fd++)
       if ((res = cb (data, fd)) != 0)
           break;
@@ -1096,26 +1148,29 @@ fdwalk (int (*cb)(void *data, int fd), void *data)
 }
 #endif
 
-static gint
-sane_dup2 (gint fd1, gint fd2)
+/* Marks every descriptor from @lowfd up as close-on-exec. */
+static void
+set_cloexec_from (gint lowfd)
 {
-  gint ret;
-
- retry:
-  ret = dup2 (fd1, fd2);
-  if (ret < 0 && errno == EINTR)
-    goto retry;
+#if defined(HAVE_CLOSE_RANGE) && defined(CLOSE_RANGE_CLOEXEC)
+  /* This is a single system call no matter how many descriptors are
+   * open or what RLIMIT_NOFILE is; it fails on kernels older than 5.11,
+   * in which case we walk the descriptors instead.
+   */
+  if (close_range (lowfd, G_MAXUINT, CLOSE_RANGE_CLOEXEC) == 0)
+    return;
+#endif
 
-  return ret;
+  fdwalk (set_cloexec, GINT_TO_POINTER (lowfd));
 }
 
 static gint
-sane_open (const char *path, gint mode)
+sane_dup2 (gint fd1, gint fd2)
 {
   gint ret;
 
  retry:
-  ret = open (path, mode);
+  ret = dup2 (fd1, fd2);
   if (ret < 0 && errno == EINTR)
     goto retry;
 
@@ -1159,7 +1214,7 @@ do_exec (gint                  child_err_report_fd,
    */
   if (close_descriptors)
     {
-      fdwalk (set_cloexec, GINT_TO_POINTER(3));
+      set_cloexec_from (3);
     }
   else
     {
@@ -1290,6 +1345,136 @@ read_ints (int      fd,
   return TRUE;
 }
 
+#ifdef HAVE_POSIX_SPAWN
+extern char **environ;
+
+/* fork() has to duplicate the page tables of the parent, which takes a
+ * noticeable amount of time when the parent is large. posix_spawn()
+ * (which glibc implements with clone (CLONE_VM | CLONE_VFORK)) avoids
+ * that, but can only be used when the child doesn't need to run any
+ * code of ours between fork and exec.
+ */
+static gboolean
+can_posix_spawn (gboolean              intermediate_child,
+                 const gchar          *working_directory,
+                 gboolean              close_descriptors,
+                 gboolean              search_path,
+                 gboolean              search_path_from_envp,
+                 GSpawnChildSetupFunc  child_setup)
+{
+  if (intermediate_child || working_directory || child_setup)
+    return FALSE;
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+  if (close_descriptors)
+    return FALSE;
+#endif
+
+  /* posix_spawnp() uses a different default search path than
+   * g_execute() when PATH is unset, and knows nothing about @envp.
+   */
+  if (search_path_from_envp || (search_path && g_getenv ("PATH") == NULL))
+    return FALSE;
+
+  return TRUE;
+}
+
+/* Returns 0 on success or an errno value; an exec failure is reported
+ * through the return value as well, with the child already reaped.
+ */
+static gint
+do_posix_spawn (gchar    **argv,
+                gchar    **envp,
+                gboolean   close_descriptors,
+                gboolean   search_path,
+                gboolean   stdout_to_null,
+                gboolean   stderr_to_null,
+                gboolean   child_inherits_stdin,
+                gboolean   file_and_argv_zero,
+                gint       stdin_fd,
+                gint       stdout_fd,
+                gint       stderr_fd,
+                GPid      *child_pid)
+{
+  posix_spawn_file_actions_t file_actions;
+  posix_spawnattr_t attr;
+  sigset_t default_signals;
+  pid_t pid;
+  gint err;
+
+  err = posix_spawnattr_init (&attr);
+  if (err != 0)
+    return err;
+
+  err = posix_spawn_file_actions_init (&file_actions);
+  if (err != 0)
+    {
+      posix_spawnattr_destroy (&attr);
+      return err;
+    }
+
+  /* Reset the same signals that the fork() path resets */
+  sigemptyset (&default_signals);
+  sigaddset (&default_signals, SIGCHLD);
+  sigaddset (&default_signals, SIGINT);
+  sigaddset (&default_signals, SIGTERM);
+  sigaddset (&default_signals, SIGHUP);
+  sigaddset (&default_signals, SIGPIPE);
+
+  err = posix_spawnattr_setsigdefault (&attr, &default_signals);
+  if (err == 0)
+    err = posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSIGDEF);
+
+  if (err == 0)
+    {
+      if (stdin_fd >= 0)
+        err = posix_spawn_file_actions_adddup2 (&file_actions, stdin_fd, 0);
+      else if (!child_inherits_stdin)
+        err = posix_spawn_file_actions_addopen (&file_actions, 0, "/dev/null", O_RDONLY, 0);
+    }
+
+  if (err == 0)
+    {
+      if (stdout_fd >= 0)
+        err = posix_spawn_file_actions_adddup2 (&file_actions, stdout_fd, 1);
+      else if (stdout_to_null)
+        err = posix_spawn_file_actions_addopen (&file_actions, 1, "/dev/null", O_WRONLY, 0);
+    }
+
+  if (err == 0)
+    {
+      if (stderr_fd >= 0)
+        err = posix_spawn_file_actions_adddup2 (&file_actions, stderr_fd, 2);
+      else if (stderr_to_null)
+        err = posix_spawn_file_actions_addopen (&file_actions, 2, "/dev/null", O_WRONLY, 0);
+    }
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+  if (err == 0 && close_descriptors)
+    err = posix_spawn_file_actions_addclosefrom_np (&file_actions, 3);
+#endif
+
+  if (err == 0)
+    {
+      gchar **child_argv = file_and_argv_zero ? argv + 1 : argv;
+      gchar **child_envp = envp ? envp : environ;
+
+      if (search_path)
+        err = posix_spawnp (&pid, argv[0], &file_actions, &attr, child_argv, child_envp);
+      else
+        err = posix_spawn (&pid, argv[0], &file_actions, &attr, child_argv, child_envp);
+    }
+
+  posix_spawn_file_actions_destroy (&file_actions);
+  posix_spawnattr_destroy (&attr);
+
+  if (err == 0)
+    *child_pid = pid;
+
+  return err;
+}
+#endif /* HAVE_POSIX_SPAWN */
+
 static gboolean
 fork_exec_with_pipes (gboolean              intermediate_child,
                       const gchar          *working_directory,
@@ -1335,6 +1520,55 @@ fork_exec_with_pipes (gboolean              intermediate_child,
   if (standard_error && !g_unix_open_pipe (stderr_pipe, FD_CLOEXEC, error))
     goto cleanup_and_fail;
 
+#ifdef HAVE_POSIX_SPAWN
+  if (can_posix_spawn (intermediate_child, working_directory,
+                       close_descriptors, search_path,
+                       search_path_from_envp, child_setup))
+    {
+      gint err;
+
+      err = do_posix_spawn (argv, envp, close_descriptors, search_path,
+                            stdout_to_null, stderr_to_null,
+                            child_inherits_stdin, file_and_argv_zero,
+                            stdin_pipe[0], stdout_pipe[1], stderr_pipe[1],
+                            &pid);
+      if (err == 0)
+        {
+          close_and_invalidate (&child_err_report_pipe[0]);
+          close_and_invalidate (&child_err_report_pipe[1]);
+          close_and_invalidate (&stdin_pipe[0]);
+          close_and_invalidate (&stdout_pipe[1]);
+          close_and_invalidate (&stderr_pipe[1]);
+
+          if (child_pid)
+            *child_pid = pid;
+
+          if (standard_input)
+            *standard_input = stdin_pipe[1];
+          if (standard_output)
+            *standard_output = stdout_pipe[0];
+          if (standard_error)
+            *standard_error = stderr_pipe[0];
+
+          return TRUE;
+        }
+
+      /* For a script without a #! line, fall back to the fork() path,
+       * which knows how to run it with /bin/sh.
+       */
+      if (err != ENOEXEC)
+        {
+          g_set_error (error,
+                       G_SPAWN_ERROR,
+                       exec_err_to_g_error (err),
+                       _("Failed to execute child process \"%s\" (%s)"),
+                       argv[0],
+                       g_strerror (err));
+          goto cleanup_and_fail;
+        }
+    }
+#endif /* HAVE_POSIX_SPAWN */
+
   pid = fork ();
 
   if (pid < 0)
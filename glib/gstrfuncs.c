@@ -37,6 +37,7 @@
 #include <string.h>
 #include <locale.h>
 #include <errno.h>
+#include <float.h>
 #include <ctype.h>              /* For tolower() */
 
 #ifdef HAVE_XLOCALE_H
@@ -655,45 +656,111 @@ g_strtod (const gchar *nptr,
     }
 }
 
-/**
- * g_ascii_strtod:
- * @nptr:    the string to convert to a numeric value.
- * @endptr:  if non-%NULL, it returns the character after
- *           the last character used in the conversion.
- *
- * Converts a string to a #gdouble value.
- *
- * This function behaves like the standard strtod() function
- * does in the C locale. It does this without actually changing
- * the current locale, since that would not be thread-safe.
- * A limitation of the implementation is that this function
- * will still accept localized versions of infinities and NANs.
- *
- * This function is typically used when reading configuration
- * files or other non-user input that should be locale independent.
- * To handle input from the user you should normally use the
- * locale-sensitive system strtod() function.
- *
- * To convert from a #gdouble to a string in a locale-insensitive
- * way, use g_ascii_dtostr().
- *
- * If the correct value would cause overflow, plus or minus <literal>HUGE_VAL</literal>
- * is returned (according to the sign of the value), and <literal>ERANGE</literal> is
- * stored in <literal>errno</literal>. If the correct value would cause underflow,
- * zero is returned and <literal>ERANGE</literal> is stored in <literal>errno</literal>.
- *
- * This function resets <literal>errno</literal> before calling strtod() so that
- * you can reliably detect overflow and underflow.
- *
- * Return value: the #gdouble value.
+/* Parses the plain decimal numbers that make up nearly all input
+ * exactly, without any locale handling: if the significand fits in the
+ * 53 bits of a double and the power of ten is at most 22, both are
+ * exactly representable and a single multiplication or division gives
+ * the correctly rounded result.  Everything else (long or large
+ * numbers, hex floats, infinities, NaNs) is left to strtod().
  */
-gdouble
-g_ascii_strtod (const gchar *nptr,
-                gchar      **endptr)
+static gboolean
+ascii_strtod_fast (const gchar  *nptr,
+                   gdouble      *value,
+                   gchar       **endptr)
 {
-#ifdef USE_XLOCALE
+#if defined (FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  static const gdouble powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const gchar *p = nptr;
+  gboolean negative = FALSE;
+  gboolean seen_digit = FALSE;
+  guint64 significand = 0;
+  gint n_digits = 0;
+  gint exponent = 0;
+  gdouble result;
+
+  while (g_ascii_isspace (*p))
+    p++;
+
+  if (*p == '+' || *p == '-')
+    negative = *p++ == '-';
+
+  if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+    return FALSE;
 
-  g_return_val_if_fail (nptr != NULL, 0);
+  for (; g_ascii_isdigit (*p); p++)
+    {
+      seen_digit = TRUE;
+      if (significand == 0 && *p == '0')
+        continue;
+      if (n_digits++ == 19)
+        return FALSE;
+      significand = significand * 10 + (*p - '0');
+    }
+
+  if (*p == '.')
+    for (p++; g_ascii_isdigit (*p); p++)
+      {
+        seen_digit = TRUE;
+        exponent--;
+        if (significand == 0 && *p == '0')
+          continue;
+        if (n_digits++ == 19)
+          return FALSE;
+        significand = significand * 10 + (*p - '0');
+      }
+
+  if (!seen_digit)
+    return FALSE;
+
+  if (*p == 'e' || *p == 'E')
+    {
+      const gchar *q = p + 1;
+      gboolean exponent_negative = FALSE;
+      gint e = 0;
+
+      if (*q == '+' || *q == '-')
+        exponent_negative = *q++ == '-';
+
+      /* a dangling 'e' is not part of the number */
+      if (g_ascii_isdigit (*q))
+        {
+          for (; g_ascii_isdigit (*q); q++)
+            if (e < 10000)
+              e = e * 10 + (*q - '0');
+
+          exponent += exponent_negative ? -e : e;
+          p = q;
+        }
+    }
+
+  if (significand == 0)
+    result = 0.0;
+  else if (significand > (G_GUINT64_CONSTANT (1) << 53) ||
+           exponent < -22 || exponent > 22)
+    return FALSE;
+  else if (exponent < 0)
+    result = (gdouble) significand / powers_of_ten[-exponent];
+  else
+    result = (gdouble) significand * powers_of_ten[exponent];
+
+  *value = negative ? -result : result;
+  *endptr = (gchar *) p;
+
+  return TRUE;
+#else
+  /* with excess precision the fast path could round twice */
+  return FALSE;
+#endif
+}
+
+static gdouble
+ascii_strtod_slow (const gchar *nptr,
+                   gchar      **endptr)
+{
+#ifdef USE_XLOCALE
 
   errno = 0;
 
@@ -712,8 +779,6 @@ g_ascii_strtod (const gchar *nptr,
   const char *end = NULL; /* Silence gcc */
   int strtod_errno;
 
-  g_return_val_if_fail (nptr != NULL, 0);
-
   fail_pos = NULL;
 
 #ifndef __BIONIC__
@@ -855,6 +920,58 @@ g_ascii_strtod (const gchar *nptr,
 #endif
 }
 
+/**
+ * g_ascii_strtod:
+ * @nptr:    the string to convert to a numeric value.
+ * @endptr:  if non-%NULL, it returns the character after
+ *           the last character used in the conversion.
+ *
+ * Converts a string to a #gdouble value.
+ *
+ * This function behaves like the standard strtod() function
+ * does in the C locale. It does this without actually changing
+ * the current locale, since that would not be thread-safe.
+ * A limitation of the implementation is that this function
+ * will still accept localized versions of infinities and NANs.
+ *
+ * This function is typically used when reading configuration
+ * files or other non-user input that should be locale independent.
+ * To handle input from the user you should normally use the
+ * locale-sensitive system strtod() function.
+ *
+ * To convert from a #gdouble to a string in a locale-insensitive
+ * way, use g_ascii_dtostr().
+ *
+ * If the correct value would cause overflow, plus or minus <literal>HUGE_VAL</literal>
+ * is returned (according to the sign of the value), and <literal>ERANGE</literal> is
+ * stored in <literal>errno</literal>. If the correct value would cause underflow,
+ * zero is returned and <literal>ERANGE</literal> is stored in <literal>errno</literal>.
+ *
+ * This function resets <literal>errno</literal> before calling strtod() so that
+ * you can reliably detect overflow and underflow.
+ *
+ * Return value: the #gdouble value.
+ */
+gdouble
+g_ascii_strtod (const gchar *nptr,
+                gchar      **endptr)
+{
+  gdouble value;
+  gchar *end;
+
+  g_return_val_if_fail (nptr != NULL, 0);
+
+  if (ascii_strtod_fast (nptr, &value, &end))
+    {
+      errno = 0;
+      if (endptr)
+        *endptr = end;
+      return value;
+    }
+
+  return ascii_strtod_slow (nptr, endptr);
+}
+
 
 /**
  * g_ascii_dtostr:
@@ -878,6 +995,36 @@ g_ascii_dtostr (gchar       *buffer,
                 gint         buf_len,
                 gdouble      d)
 {
+  /* "%.17g" prints integral values below 10^17 as plain integers;
+   * produce the same string without going through printf.
+   */
+  if (d > -1e17 && d < 1e17 && d == (gdouble) (gint64) d)
+    {
+      gchar digits[20];
+      gchar *p = digits + sizeof digits;
+      gint64 n = (gint64) d;
+      guint64 bits;
+      guint64 u;
+
+      memcpy (&bits, &d, sizeof bits);
+      u = n < 0 ? -(guint64) n : (guint64) n;
+
+      do
+        *--p = '0' + u % 10;
+      while ((u /= 10) != 0);
+
+      /* the sign bit, so that -0.0 gives "-0" like printf does */
+      if (bits >> 63)
+        *--p = '-';
+
+      if (digits + sizeof digits - p < buf_len)
+        {
+          memcpy (buffer, p, digits + sizeof digits - p);
+          buffer[digits + sizeof digits - p] = '\0';
+          return buffer;
+        }
+    }
+
   return g_ascii_formatd (buffer, buf_len, "%.17g", d);
 }
 
@@ -2276,6 +2423,8 @@ g_strchomp (gchar *string)
  * to represent empty elements, you'll need to check for the empty string
  * before calling g_strsplit().
  *
+ * To look at the pieces without copying them, use a #GStrSplitIter.
+ *
  * Return value: a newly-allocated %NULL-terminated array of strings. Use
  *    g_strfreev() to free it.
  */
@@ -2284,51 +2433,140 @@ g_strsplit (const gchar *string,
             const gchar *delimiter,
             gint         max_tokens)
 {
-  GSList *string_list = NULL, *slist;
-  gchar **str_array, *s;
-  guint n = 0;
-  const gchar *remainder;
+  GStrSplitIter iter;
+  const gchar *token;
+  gsize token_len;
+  gchar **str_array;
+  guint n = 0, n_allocated = 8;
 
   g_return_val_if_fail (string != NULL, NULL);
   g_return_val_if_fail (delimiter != NULL, NULL);
   g_return_val_if_fail (delimiter[0] != '\0', NULL);
 
-  if (max_tokens < 1)
-    max_tokens = G_MAXINT;
+  str_array = g_new (gchar*, n_allocated);
 
-  remainder = string;
-  s = strstr (remainder, delimiter);
-  if (s)
+  g_strsplit_iter_init (&iter, string, delimiter, max_tokens);
+  while (g_strsplit_iter_next (&iter, &token, &token_len))
     {
-      gsize delimiter_len = strlen (delimiter);
-
-      while (--max_tokens && s)
+      /* leave room for the terminating NULL */
+      if (n + 1 == n_allocated)
         {
-          gsize len;
-
-          len = s - remainder;
-          string_list = g_slist_prepend (string_list,
-                                         g_strndup (remainder, len));
-          n++;
-          remainder = s + delimiter_len;
-          s = strstr (remainder, delimiter);
+          n_allocated *= 2;
+          str_array = g_renew (gchar*, str_array, n_allocated);
         }
-    }
-  if (*string)
-    {
-      n++;
-      string_list = g_slist_prepend (string_list, g_strdup (remainder));
+
+      str_array[n++] = g_strndup (token, token_len);
     }
 
-  str_array = g_new (gchar*, n + 1);
+  str_array[n] = NULL;
 
-  str_array[n--] = NULL;
-  for (slist = string_list; slist; slist = slist->next)
-    str_array[n--] = slist->data;
+  return str_array;
+}
+
+typedef struct
+{
+  const gchar *remainder;
+  const gchar *delimiter;
+  gsize        delimiter_len;
+  gint         tokens_left;
+} RealStrSplitIter;
 
-  g_slist_free (string_list);
+G_STATIC_ASSERT (sizeof (RealStrSplitIter) <= sizeof (GStrSplitIter));
 
-  return str_array;
+/**
+ * g_strsplit_iter_init:
+ * @iter: an uninitialized #GStrSplitIter
+ * @string: a string to split
+ * @delimiter: a string which specifies the places at which to split
+ *     the string
+ * @max_tokens: the maximum number of pieces to split @string into.
+ *     If this is less than 1, the string is split completely.
+ *
+ * Initializes @iter to return the same pieces of @string as
+ * g_strsplit() would, without copying them.  @string and @delimiter
+ * must stay valid until you are done with @iter.
+ *
+ * |[
+ * GStrSplitIter iter;
+ * const gchar *token;
+ * gsize token_len;
+ *
+ * g_strsplit_iter_init (&iter, string, ",", -1);
+ * while (g_strsplit_iter_next (&iter, &token, &token_len))
+ *   {
+ *     /&ast; do something with the token_len bytes at token &ast;/
+ *   }
+ * ]|
+ *
+ * Since: 2.40
+ */
+void
+g_strsplit_iter_init (GStrSplitIter *iter,
+                      const gchar   *string,
+                      const gchar   *delimiter,
+                      gint           max_tokens)
+{
+  RealStrSplitIter *ri = (RealStrSplitIter *) iter;
+
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (string != NULL);
+  g_return_if_fail (delimiter != NULL);
+  g_return_if_fail (delimiter[0] != '\0');
+
+  /* as in g_strsplit(), the empty string has no pieces at all */
+  ri->remainder = *string ? string : NULL;
+  ri->delimiter = delimiter;
+  ri->delimiter_len = strlen (delimiter);
+  ri->tokens_left = max_tokens < 1 ? G_MAXINT : max_tokens;
+}
+
+/**
+ * g_strsplit_iter_next:
+ * @iter: an initialized #GStrSplitIter
+ * @token: (out) (transfer none): a location to store the start of the
+ *     next piece
+ * @token_len: (out): a location to store the length of the next piece
+ *
+ * Advances @iter to the next piece of the string.  The piece is not
+ * nul-terminated: it is the @token_len bytes at @token, within the
+ * string that was passed to g_strsplit_iter_init().
+ *
+ * Return value: %FALSE if there are no more pieces
+ *
+ * Since: 2.40
+ */
+gboolean
+g_strsplit_iter_next (GStrSplitIter  *iter,
+                      const gchar   **token,
+                      gsize          *token_len)
+{
+  RealStrSplitIter *ri = (RealStrSplitIter *) iter;
+  const gchar *s = NULL;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (token != NULL, FALSE);
+  g_return_val_if_fail (token_len != NULL, FALSE);
+
+  if (ri->remainder == NULL)
+    return FALSE;
+
+  /* the last piece is the remainder of the string */
+  if (--ri->tokens_left > 0)
+    s = strstr (ri->remainder, ri->delimiter);
+
+  *token = ri->remainder;
+  if (s)
+    {
+      *token_len = s - ri->remainder;
+      ri->remainder = s + ri->delimiter_len;
+    }
+  else
+    {
+      *token_len = strlen (ri->remainder);
+      ri->remainder = NULL;
+    }
+
+  return TRUE;
 }
 
 /**
@@ -276,6 +276,28 @@ GLIB_AVAILABLE_IN_ALL
 gchar **	      g_strsplit_set   (const gchar *string,
 					const gchar *delimiters,
 					gint         max_tokens) G_GNUC_MALLOC;
+
+typedef struct _GStrSplitIter GStrSplitIter;
+
+struct _GStrSplitIter
+{
+  /*< private >*/
+  gpointer      dummy1;
+  gpointer      dummy2;
+  gsize         dummy3;
+  gint          dummy4;
+};
+
+GLIB_AVAILABLE_IN_2_40
+void                  g_strsplit_iter_init (GStrSplitIter *iter,
+					    const gchar   *string,
+					    const gchar   *delimiter,
+					    gint           max_tokens);
+GLIB_AVAILABLE_IN_2_40
+gboolean              g_strsplit_iter_next (GStrSplitIter  *iter,
+					    const gchar   **token,
+					    gsize          *token_len);
+
 GLIB_AVAILABLE_IN_ALL
 gchar*                g_strjoinv       (const gchar  *separator,
 					gchar       **str_array) G_GNUC_MALLOC;
@@ -76,6 +76,9 @@
  * The GString struct contains the public fields of a GString.
  */
 
+/* Formatted text up to this size is built on the stack */
+#define STRING_PRINTF_BUF_SIZE 256
+
 
 #define MY_MAXSIZE ((gsize)-1)
 
@@ -1155,21 +1158,36 @@ g_string_append_vprintf (GString     *string,
                          const gchar *format,
                          va_list      args)
 {
+  gchar stack_buf[STRING_PRINTF_BUF_SIZE];
   gchar *buf;
+  va_list args2;
   gint len;
 
   g_return_if_fail (string != NULL);
   g_return_if_fail (format != NULL);
 
-  len = g_vasprintf (&buf, format, args);
+  /* Format into a stack buffer first, and only allocate if the output
+   * turns out to be longer.  Not formatting straight into @string is
+   * deliberate: the arguments may point into @string itself.
+   */
+  G_VA_COPY (args2, args);
+  len = g_vsnprintf (stack_buf, sizeof stack_buf, format, args2);
+  va_end (args2);
 
-  if (len >= 0)
-    {
-      g_string_maybe_expand (string, len);
-      memcpy (string->str + string->len, buf, len + 1);
-      string->len += len;
-      g_free (buf);
-    }
+  if (len < 0)
+    return;
+
+  if ((gsize) len < sizeof stack_buf)
+    buf = stack_buf;
+  else if (g_vasprintf (&buf, format, args) < 0)
+    return;
+
+  g_string_maybe_expand (string, len);
+  memcpy (string->str + string->len, buf, len + 1);
+  string->len += len;
+
+  if (buf != stack_buf)
+    g_free (buf);
 }
 
 /**
@@ -35,6 +35,7 @@
 #include "gstringchunk.h"
 
 #include "ghash.h"
+#include "ghashprivate.h"
 #include "gslist.h"
 #include "gmessages.h"
 
@@ -67,6 +68,10 @@
  *
  * To free the entire #GStringChunk use g_string_chunk_free(). It is
  * not possible to free individual strings.
+ *
+ * A #GStringChunk that is refilled over and over, for example once per
+ * request, can be emptied with g_string_chunk_reset(), which keeps its
+ * memory around for the next round.
  */
 
 /**
@@ -78,7 +83,9 @@
 struct _GStringChunk
 {
   GHashTable *const_table;
-  GSList     *storage_list;
+  GSList     *storage_list;     /* blocks of default_size, current first */
+  GSList     *spare_list;       /* unused blocks kept by g_string_chunk_reset() */
+  GSList     *big_list;         /* strings too long for a block, one each */
   gsize       storage_next;
   gsize       this_size;
   gsize       default_size;
@@ -126,6 +133,8 @@ g_string_chunk_new (gsize size)
 
   new_chunk->const_table  = NULL;
   new_chunk->storage_list = NULL;
+  new_chunk->spare_list   = NULL;
+  new_chunk->big_list     = NULL;
   new_chunk->storage_next = actual_size;
   new_chunk->default_size = actual_size;
   new_chunk->this_size    = actual_size;
@@ -133,6 +142,59 @@ g_string_chunk_new (gsize size)
   return new_chunk;
 }
 
+static void
+free_blocks (GSList *list)
+{
+  GSList *tmp_list;
+
+  for (tmp_list = list; tmp_list; tmp_list = tmp_list->next)
+    g_free (tmp_list->data);
+
+  g_slist_free (list);
+}
+
+/* Returns room for @size bytes */
+static gchar *
+g_string_chunk_alloc (GStringChunk *chunk,
+                      gsize         size)
+{
+  gchar *pos;
+
+  if (size > chunk->default_size)
+    {
+      pos = g_new (gchar, size);
+      chunk->big_list = g_slist_prepend (chunk->big_list, pos);
+
+      return pos;
+    }
+
+  if (chunk->storage_next + size > chunk->this_size)
+    {
+      GSList *block;
+
+      if (chunk->spare_list)
+        {
+          block = chunk->spare_list;
+          chunk->spare_list = block->next;
+        }
+      else
+        {
+          block = g_slist_alloc ();
+          block->data = g_new (gchar, chunk->default_size);
+        }
+
+      block->next = chunk->storage_list;
+      chunk->storage_list = block;
+      chunk->this_size = chunk->default_size;
+      chunk->storage_next = 0;
+    }
+
+  pos = ((gchar *) chunk->storage_list->data) + chunk->storage_next;
+  chunk->storage_next += size;
+
+  return pos;
+}
+
 /**
  * g_string_chunk_free:
  * @chunk: a #GStringChunk
@@ -144,17 +206,11 @@ g_string_chunk_new (gsize size)
 void
 g_string_chunk_free (GStringChunk *chunk)
 {
-  GSList *tmp_list;
-
   g_return_if_fail (chunk != NULL);
 
-  if (chunk->storage_list)
-    {
-      for (tmp_list = chunk->storage_list; tmp_list; tmp_list = tmp_list->next)
-        g_free (tmp_list->data);
-
-      g_slist_free (chunk->storage_list);
-    }
+  free_blocks (chunk->storage_list);
+  free_blocks (chunk->spare_list);
+  free_blocks (chunk->big_list);
 
   if (chunk->const_table)
     g_hash_table_destroy (chunk->const_table);
@@ -175,26 +231,57 @@ g_string_chunk_free (GStringChunk *chunk)
 void
 g_string_chunk_clear (GStringChunk *chunk)
 {
-  GSList *tmp_list;
-
   g_return_if_fail (chunk != NULL);
 
-  if (chunk->storage_list)
-    {
-      for (tmp_list = chunk->storage_list; tmp_list; tmp_list = tmp_list->next)
-        g_free (tmp_list->data);
+  free_blocks (chunk->storage_list);
+  free_blocks (chunk->spare_list);
+  free_blocks (chunk->big_list);
 
-      g_slist_free (chunk->storage_list);
-
-      chunk->storage_list = NULL;
-      chunk->storage_next = chunk->default_size;
-      chunk->this_size    = chunk->default_size;
-    }
+  chunk->storage_list = NULL;
+  chunk->spare_list   = NULL;
+  chunk->big_list     = NULL;
+  chunk->storage_next = chunk->default_size;
+  chunk->this_size    = chunk->default_size;
 
   if (chunk->const_table)
       g_hash_table_remove_all (chunk->const_table);
 }
 
+/**
+ * g_string_chunk_reset:
+ * @chunk: a #GStringChunk
+ *
+ * Removes all strings from the #GStringChunk, like
+ * g_string_chunk_clear(), but keeps the allocated blocks and the
+ * table used by g_string_chunk_insert_const() at their current size,
+ * so that refilling @chunk to the same extent does not need to
+ * allocate any memory. Only strings that were too long to fit in
+ * a block are freed.
+ *
+ * After calling g_string_chunk_reset() it is not safe to access
+ * any of the strings which were contained within it.
+ *
+ * Since: 2.40
+ */
+void
+g_string_chunk_reset (GStringChunk *chunk)
+{
+  g_return_if_fail (chunk != NULL);
+
+  /* oldest first, so that refilling uses the blocks in the same order */
+  chunk->spare_list = g_slist_concat (g_slist_reverse (chunk->storage_list),
+                                      chunk->spare_list);
+  chunk->storage_list = NULL;
+  chunk->storage_next = chunk->default_size;
+  chunk->this_size    = chunk->default_size;
+
+  free_blocks (chunk->big_list);
+  chunk->big_list = NULL;
+
+  if (chunk->const_table)
+    _g_hash_table_steal_all_keep_size (chunk->const_table);
+}
+
 /**
  * g_string_chunk_insert:
  * @chunk: a #GStringChunk
@@ -304,24 +391,73 @@ g_string_chunk_insert_len (GStringChunk *chunk,
   else
     size = len;
 
-  if ((chunk->storage_next + size + 1) > chunk->this_size)
-    {
-      gsize new_size = nearest_power (chunk->default_size, size + 1);
+  pos = g_string_chunk_alloc (chunk, size + 1);
 
-      chunk->storage_list = g_slist_prepend (chunk->storage_list,
-                                             g_new (gchar, new_size));
+  *(pos + size) = '\0';
 
-      chunk->this_size = new_size;
-      chunk->storage_next = 0;
-    }
+  memcpy (pos, string, size);
 
-  pos = ((gchar *) chunk->storage_list->data) + chunk->storage_next;
+  return pos;
+}
 
-  *(pos + size) = '\0';
+/**
+ * g_string_chunk_insert_len_many:
+ * @chunk: a #GStringChunk
+ * @strings: (array length=n_strings): the strings to insert
+ * @lengths: (array length=n_strings) (allow-none): the number of bytes
+ *     of each string to insert, or -1 for a nul-terminated string.
+ *     If %NULL, all strings are nul-terminated
+ * @n_strings: the number of strings
+ * @results: (out caller-allocates) (array length=n_strings): return
+ *     location for the copies of @strings
+ *
+ * Adds copies of @n_strings strings to the #GStringChunk, as if by
+ * calling g_string_chunk_insert_len() on each of them, and stores
+ * pointers to the copies in @results.
+ *
+ * The copies are stored next to each other where possible, which is
+ * cheaper than inserting the strings one by one.
+ *
+ * Since: 2.40
+ */
+void
+g_string_chunk_insert_len_many (GStringChunk        *chunk,
+                                const gchar * const *strings,
+                                const gssize        *lengths,
+                                gsize                n_strings,
+                                gchar              **results)
+{
+  gsize total, size, i;
+  gchar *pos;
 
-  memcpy (pos, string, size);
+  g_return_if_fail (chunk != NULL);
+  g_return_if_fail (n_strings == 0 || strings != NULL);
+  g_return_if_fail (n_strings == 0 || results != NULL);
 
-  chunk->storage_next += size + 1;
+#define STRING_SIZE(i) \
+  ((lengths == NULL || lengths[i] < 0) ? strlen (strings[i]) : (gsize) lengths[i])
 
-  return pos;
+  total = 0;
+  for (i = 0; i < n_strings && total <= chunk->default_size; i++)
+    total += STRING_SIZE (i) + 1;
+
+  if (total > chunk->default_size)
+    {
+      for (i = 0; i < n_strings; i++)
+        results[i] = g_string_chunk_insert_len (chunk, strings[i],
+                                                lengths ? lengths[i] : -1);
+      return;
+    }
+
+  pos = g_string_chunk_alloc (chunk, total);
+  for (i = 0; i < n_strings; i++)
+    {
+      size = STRING_SIZE (i);
+      memcpy (pos, strings[i], size);
+      pos[size] = '\0';
+      results[i] = pos;
+      pos += size + 1;
+    }
+
+#undef STRING_SIZE
 }
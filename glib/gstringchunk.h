@@ -53,6 +53,14 @@ gchar*        g_string_chunk_insert_len   (GStringChunk *chunk,
 GLIB_AVAILABLE_IN_ALL
 gchar*        g_string_chunk_insert_const (GStringChunk *chunk,
                                            const gchar  *string);
+GLIB_AVAILABLE_IN_2_40
+void          g_string_chunk_reset        (GStringChunk *chunk);
+GLIB_AVAILABLE_IN_2_40
+void          g_string_chunk_insert_len_many (GStringChunk        *chunk,
+                                              const gchar * const *strings,
+                                              const gssize        *lengths,
+                                              gsize                n_strings,
+                                              gchar              **results);
 
 G_END_DECLS
 
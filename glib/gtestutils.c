@@ -1868,6 +1868,170 @@ g_test_add_data_func_full (const char     *testpath,
                      (GTestFixtureFunc) data_free_func);
 }
 
+/* How long a benchmark runs before it is measured, how long each
+ * measured sample runs for, and how many samples are taken.
+ */
+#define BENCH_WARMUP_USEC  (100 * 1000)
+#define BENCH_SAMPLE_USEC  (5 * 1000)
+#define BENCH_N_SAMPLES    100
+
+typedef struct {
+  GTestBenchFunc func;
+  gconstpointer  data;
+} TestBench;
+
+static gint64
+test_bench_time (TestBench *bench,
+                 guint64    n_iterations)
+{
+  gint64 start;
+
+  start = g_get_monotonic_time ();
+  bench->func (n_iterations, bench->data);
+
+  return g_get_monotonic_time () - start;
+}
+
+/* libglib doesn't link against libm, so no sqrt() */
+static double
+test_bench_sqrt (double x)
+{
+  double r = x;
+  guint i;
+
+  if (x <= 0)
+    return 0;
+
+  for (i = 0; i < 64; i++)
+    r = (r + x / r) / 2;
+
+  return r;
+}
+
+static int
+test_bench_compare (const void *a,
+                    const void *b)
+{
+  double da = *(const double *) a, db = *(const double *) b;
+
+  return da < db ? -1 : da > db;
+}
+
+static void
+test_bench_run (gconstpointer user_data)
+{
+  TestBench *bench = (TestBench *) user_data;
+  double samples[BENCH_N_SAMPLES];
+  double mean, variance, median, p99;
+  guint64 n_iterations;
+  gint64 elapsed, warmup_end;
+  guint i;
+
+  /* Outside of perf mode, just make sure that the benchmark works */
+  if (!g_test_perf ())
+    {
+      bench->func (1, bench->data);
+      return;
+    }
+
+  /* Warm up, and find an iteration count that makes each sample take
+   * long enough for the clock to measure it precisely.
+   */
+  n_iterations = 1;
+  warmup_end = g_get_monotonic_time () + BENCH_WARMUP_USEC;
+  while (TRUE)
+    {
+      elapsed = test_bench_time (bench, n_iterations);
+
+      if (elapsed < BENCH_SAMPLE_USEC)
+        {
+          if (elapsed <= 0)
+            n_iterations *= 10;
+          else
+            n_iterations = MAX (n_iterations + 1,
+                                n_iterations * MIN (10.0, 1.2 * BENCH_SAMPLE_USEC / elapsed));
+        }
+      else if (g_get_monotonic_time () >= warmup_end)
+        break;
+    }
+
+  mean = 0;
+  for (i = 0; i < BENCH_N_SAMPLES; i++)
+    {
+      samples[i] = 1000.0 * test_bench_time (bench, n_iterations) / n_iterations;
+      mean += samples[i];
+    }
+  mean /= BENCH_N_SAMPLES;
+
+  variance = 0;
+  for (i = 0; i < BENCH_N_SAMPLES; i++)
+    variance += (samples[i] - mean) * (samples[i] - mean);
+  variance /= BENCH_N_SAMPLES - 1;
+
+  qsort (samples, BENCH_N_SAMPLES, sizeof (double), test_bench_compare);
+  median = (samples[(BENCH_N_SAMPLES - 1) / 2] + samples[BENCH_N_SAMPLES / 2]) / 2;
+  p99 = samples[(BENCH_N_SAMPLES * 99 + 99) / 100 - 1];
+
+  g_test_minimized_result (median,
+                           "%s: median %.2f ns, p99 %.2f ns, stddev %.2f ns per iteration "
+                           "(%d samples of %" G_GUINT64_FORMAT " iterations)",
+                           test_run_name, median, p99, test_bench_sqrt (variance),
+                           BENCH_N_SAMPLES, n_iterations);
+}
+
+/**
+ * g_test_add_bench:
+ * @testpath: /-separated test case path name for the benchmark.
+ * @bench_data: Data argument for the benchmark function.
+ * @bench_func: The function to benchmark.
+ *
+ * Create a new test case that measures how long @bench_func takes.
+ * @bench_func is called with the number of iterations of the
+ * operation being measured that it should run, and @bench_data.
+ *
+ * When performance tests are enabled (see g_test_perf()), @bench_func
+ * is first run for a while to warm up caches and find an iteration
+ * count for which a call takes long enough to be timed precisely.
+ * It is then called repeatedly with that count, and the median, 99th
+ * percentile and standard deviation of the time per iteration are
+ * reported with g_test_minimized_result(), where they end up in the
+ * test log (and in the TAP output) for tools such as gtester-report
+ * to track. Otherwise, @bench_func is called once with a single
+ * iteration, so that the benchmark is still checked to work.
+ *
+ * |[
+ * static void
+ * bench_hash_lookup (guint64       n_iterations,
+ *                    gconstpointer data)
+ * {
+ *   GHashTable *hash = (GHashTable *) data;
+ *   guint64 i;
+ *
+ *   for (i = 0; i < n_iterations; i++)
+ *     g_hash_table_lookup (hash, GUINT_TO_POINTER (i % 1000));
+ * }
+ * ]|
+ *
+ * Since: 2.40
+ */
+void
+g_test_add_bench (const char     *testpath,
+                  gconstpointer   bench_data,
+                  GTestBenchFunc  bench_func)
+{
+  TestBench *bench;
+
+  g_return_if_fail (testpath != NULL);
+  g_return_if_fail (testpath[0] == '/');
+  g_return_if_fail (bench_func != NULL);
+
+  bench = g_new (TestBench, 1);
+  bench->func = bench_func;
+  bench->data = bench_data;
+
+  g_test_add_data_func_full (testpath, bench, test_bench_run, g_free);
+}
+
 static gboolean
 g_test_suite_case_exists (GTestSuite *suite,
                           const char *test_path)
@@ -36,6 +36,8 @@ typedef struct GTestCase  GTestCase;
 typedef struct GTestSuite GTestSuite;
 typedef void (*GTestFunc)        (void);
 typedef void (*GTestDataFunc)    (gconstpointer user_data);
+typedef void (*GTestBenchFunc)   (guint64       n_iterations,
+                                  gconstpointer user_data);
 typedef void (*GTestFixtureFunc) (gpointer      fixture,
                                   gconstpointer user_data);
 
@@ -139,6 +141,11 @@ void    g_test_add_data_func_full       (const char     *testpath,
                                          GTestDataFunc   test_func,
                                          GDestroyNotify  data_free_func);
 
+GLIB_AVAILABLE_IN_2_40
+void    g_test_add_bench                (const char     *testpath,
+                                         gconstpointer   bench_data,
+                                         GTestBenchFunc  bench_func);
+
 /* tell about failure */
 GLIB_AVAILABLE_IN_2_30
 void    g_test_fail                     (void);
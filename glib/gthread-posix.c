@@ -70,6 +70,16 @@
 #include <windows.h>
 #endif
 
+/* Implement GMutex, GRecMutex and GCond directly on futex(2) where
+ * it is available, see the end of this file.
+ */
+#if defined(HAVE_FUTEX) && defined(G_ATOMIC_LOCK_FREE) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define USE_NATIVE_MUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
 static void
 g_thread_abort (gint         status,
                 const gchar *function)
@@ -79,6 +89,8 @@ g_thread_abort (gint         status,
   abort ();
 }
 
+#if !defined(USE_NATIVE_MUTEX)
+
 /* {{{1 GMutex */
 
 static pthread_mutex_t *
@@ -422,6 +434,8 @@ g_rec_mutex_trylock (GRecMutex *rec_mutex)
   return TRUE;
 }
 
+#endif /* !USE_NATIVE_MUTEX */
+
 /* {{{1 GRWLock */
 
 static pthread_rwlock_t *
@@ -631,6 +645,8 @@ g_rw_lock_reader_unlock (GRWLock *rw_lock)
   pthread_rwlock_unlock (g_rw_lock_get_impl (rw_lock));
 }
 
+#if !defined(USE_NATIVE_MUTEX)
+
 /* {{{1 GCond */
 
 static pthread_cond_t *
@@ -877,6 +893,8 @@ g_cond_wait_until (GCond  *cond,
   return FALSE;
 }
 
+#endif /* !USE_NATIVE_MUTEX */
+
 /* {{{1 GPrivate */
 
 /**
@@ -1194,5 +1212,406 @@ g_system_thread_set_name (const gchar *name)
 #endif
 }
 
+/* {{{1 GMutex, GRecMutex and GCond on futex(2) */
+
+#ifdef USE_NATIVE_MUTEX
+
+/* The state of a GMutex is kept inline, in i[0]: it is 0 when unlocked,
+ * 1 when locked and 2 when locked with other threads (possibly)
+ * sleeping on it, so that unlocking only has to enter the kernel in the
+ * last case.  This is the mutex from Ulrich Drepper's "Futexes Are
+ * Tricky".
+ *
+ * A thread finding the mutex locked first spins for a while, in case
+ * the owner is running on another CPU and leaves a short critical
+ * section soon, and only then goes to sleep.  As with glibc's
+ * PTHREAD_MUTEX_ADAPTIVE_NP the number of spins adapts to how long it
+ * took to get the mutex in the past; GMutex keeps that estimate in the
+ * otherwise unused i[1].
+ *
+ * GRecMutex uses i[0] in the same way, with the owning thread in p and
+ * the recursion depth in i[1].  GCond is a sequence number in i[0],
+ * incremented by every signal, that waiters sleep on until it changes.
+ */
+
+typedef enum
+{
+  G_MUTEX_STATE_EMPTY = 0,
+  G_MUTEX_STATE_OWNED,
+  G_MUTEX_STATE_CONTENDED
+} GMutexState;
+
+#define G_MUTEX_SPIN_MAX 100
+
+#ifndef FUTEX_WAIT_PRIVATE
+#define FUTEX_WAIT_PRIVATE FUTEX_WAIT
+#define FUTEX_WAKE_PRIVATE FUTEX_WAKE
+#endif
+
+#ifdef G_ENABLE_DEBUG
+static gsize g_mutex_n_contended;  /* locks that found the mutex taken */
+static gsize g_mutex_n_spun;       /* ... and got it while spinning */
+static gsize g_mutex_n_slept;      /* FUTEX_WAITs on a mutex */
+static gsize g_mutex_n_woken;      /* FUTEX_WAKEs on a mutex */
+#define G_MUTEX_COUNT(counter) g_atomic_pointer_add (&(counter), 1)
+#else
+#define G_MUTEX_COUNT(counter)
+#endif
+
+static inline guint
+g_mutex_exchange_acquire (guint *state,
+                          guint  value)
+{
+#ifdef __ATOMIC_ACQUIRE
+  return __atomic_exchange_n (state, value, __ATOMIC_ACQUIRE);
+#else
+  return __sync_lock_test_and_set (state, value);
+#endif
+}
+
+static inline guint
+g_mutex_exchange_release (guint *state,
+                          guint  value)
+{
+#ifdef __ATOMIC_RELEASE
+  return __atomic_exchange_n (state, value, __ATOMIC_RELEASE);
+#else
+  __sync_synchronize ();
+  return __sync_lock_test_and_set (state, value);
+#endif
+}
+
+static inline void
+g_mutex_cpu_relax (void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__ ("pause" ::: "memory");
+#elif defined(__aarch64__)
+  __asm__ __volatile__ ("yield" ::: "memory");
+#else
+  __asm__ __volatile__ ("" ::: "memory");
+#endif
+}
+
+static void
+g_mutex_futex_wait (guint                 *address,
+                    guint                  value,
+                    const struct timespec *timeout)
+{
+  syscall (__NR_futex, address, (gsize) FUTEX_WAIT_PRIVATE, (gsize) value, timeout);
+}
+
+static void
+g_mutex_futex_wake (guint *address,
+                    gint   n_waiters)
+{
+  syscall (__NR_futex, address, (gsize) FUTEX_WAKE_PRIVATE, (gsize) n_waiters, NULL);
+}
+
+static guint
+g_mutex_get_spin_max (void)
+{
+  static gint spin_max = -1;
+
+  /* Spinning is pointless when the owner cannot run meanwhile */
+  if G_UNLIKELY (spin_max < 0)
+    spin_max = g_get_num_processors () > 1 ? G_MUTEX_SPIN_MAX : 0;
+
+  return spin_max;
+}
+
+/* @spin_estimate is only ever written by the owner of the mutex, but
+ * read without it; being off by a bit does not matter.
+ */
+static void
+g_mutex_lock_slowpath (guint *state,
+                       guint *spin_estimate)
+{
+  gint max_spins;
+  gint spins;
+
+  G_MUTEX_COUNT (g_mutex_n_contended);
+
+  max_spins = g_mutex_get_spin_max ();
+  if (spin_estimate != NULL)
+    max_spins = MIN (max_spins, (gint) *spin_estimate * 2 + 10);
+
+  for (spins = 0; spins < max_spins; spins++)
+    {
+      g_mutex_cpu_relax ();
+
+      if (g_atomic_int_get (state) == G_MUTEX_STATE_EMPTY &&
+          g_atomic_int_compare_and_exchange (state, G_MUTEX_STATE_EMPTY, G_MUTEX_STATE_OWNED))
+        {
+          G_MUTEX_COUNT (g_mutex_n_spun);
+          break;
+        }
+    }
+
+  if (spins == max_spins)
+    while (g_mutex_exchange_acquire (state, G_MUTEX_STATE_CONTENDED) != G_MUTEX_STATE_EMPTY)
+      {
+        G_MUTEX_COUNT (g_mutex_n_slept);
+        g_mutex_futex_wait (state, G_MUTEX_STATE_CONTENDED, NULL);
+      }
+
+  if (spin_estimate != NULL)
+    *spin_estimate += (spins - (gint) *spin_estimate) / 8;
+}
+
+static void
+g_mutex_unlock_slowpath (guint *state,
+                         guint  prev)
+{
+  /* Only a stale or uninitialised state can get us here with 0 */
+  if G_UNLIKELY (prev == G_MUTEX_STATE_EMPTY)
+    {
+      fprintf (stderr, "GLib (gthread-posix.c): Attempt to unlock a mutex that was not locked.  Aborting.\n");
+      abort ();
+    }
+
+  G_MUTEX_COUNT (g_mutex_n_woken);
+  g_mutex_futex_wake (state, 1);
+}
+
+static void
+g_mutex_check_clear (guint       *state,
+                     const gchar *function)
+{
+  if G_UNLIKELY (*state != G_MUTEX_STATE_EMPTY)
+    {
+      fprintf (stderr, "GLib (gthread-posix.c): %s() called on an uninitialised or locked mutex.  Aborting.\n",
+               function);
+      abort ();
+    }
+}
+
+void
+g_mutex_init (GMutex *mutex)
+{
+  mutex->i[0] = G_MUTEX_STATE_EMPTY;
+  mutex->i[1] = 0;
+}
+
+void
+g_mutex_clear (GMutex *mutex)
+{
+  g_mutex_check_clear (&mutex->i[0], "g_mutex_clear");
+}
+
+void
+g_mutex_lock (GMutex *mutex)
+{
+  if G_UNLIKELY (!g_atomic_int_compare_and_exchange (&mutex->i[0], G_MUTEX_STATE_EMPTY, G_MUTEX_STATE_OWNED))
+    g_mutex_lock_slowpath (&mutex->i[0], &mutex->i[1]);
+}
+
+void
+g_mutex_unlock (GMutex *mutex)
+{
+  guint prev;
+
+  prev = g_mutex_exchange_release (&mutex->i[0], G_MUTEX_STATE_EMPTY);
+
+  if G_UNLIKELY (prev != G_MUTEX_STATE_OWNED)
+    g_mutex_unlock_slowpath (&mutex->i[0], prev);
+}
+
+gboolean
+g_mutex_trylock (GMutex *mutex)
+{
+  return g_atomic_int_compare_and_exchange (&mutex->i[0], G_MUTEX_STATE_EMPTY, G_MUTEX_STATE_OWNED);
+}
+
+/* Only the owner ever stores itself in p, so comparing p against the
+ * calling thread needs no barrier: it can only be equal if we wrote it.
+ */
+static inline gpointer
+g_rec_mutex_get_owner (GRecMutex *rec_mutex)
+{
+  return *(gpointer volatile *) &rec_mutex->p;
+}
+
+static inline gpointer
+g_rec_mutex_self (void)
+{
+  return GSIZE_TO_POINTER ((gsize) pthread_self ());
+}
+
+void
+g_rec_mutex_init (GRecMutex *rec_mutex)
+{
+  rec_mutex->p = NULL;
+  rec_mutex->i[0] = G_MUTEX_STATE_EMPTY;
+  rec_mutex->i[1] = 0;
+}
+
+void
+g_rec_mutex_clear (GRecMutex *rec_mutex)
+{
+  g_mutex_check_clear (&rec_mutex->i[0], "g_rec_mutex_clear");
+}
+
+void
+g_rec_mutex_lock (GRecMutex *rec_mutex)
+{
+  gpointer self = g_rec_mutex_self ();
+
+  if (g_rec_mutex_get_owner (rec_mutex) == self)
+    {
+      rec_mutex->i[1]++;
+      return;
+    }
+
+  if G_UNLIKELY (!g_atomic_int_compare_and_exchange (&rec_mutex->i[0], G_MUTEX_STATE_EMPTY, G_MUTEX_STATE_OWNED))
+    g_mutex_lock_slowpath (&rec_mutex->i[0], NULL);
+
+  rec_mutex->p = self;
+  rec_mutex->i[1] = 1;
+}
+
+void
+g_rec_mutex_unlock (GRecMutex *rec_mutex)
+{
+  guint prev;
+
+  if (--rec_mutex->i[1] > 0)
+    return;
+
+  rec_mutex->p = NULL;
+  prev = g_mutex_exchange_release (&rec_mutex->i[0], G_MUTEX_STATE_EMPTY);
+
+  if G_UNLIKELY (prev != G_MUTEX_STATE_OWNED)
+    g_mutex_unlock_slowpath (&rec_mutex->i[0], prev);
+}
+
+gboolean
+g_rec_mutex_trylock (GRecMutex *rec_mutex)
+{
+  gpointer self = g_rec_mutex_self ();
+
+  if (g_rec_mutex_get_owner (rec_mutex) == self)
+    {
+      rec_mutex->i[1]++;
+      return TRUE;
+    }
+
+  if (!g_atomic_int_compare_and_exchange (&rec_mutex->i[0], G_MUTEX_STATE_EMPTY, G_MUTEX_STATE_OWNED))
+    return FALSE;
+
+  rec_mutex->p = self;
+  rec_mutex->i[1] = 1;
+
+  return TRUE;
+}
+
+void
+g_cond_init (GCond *cond)
+{
+  cond->i[0] = 0;
+}
+
+void
+g_cond_clear (GCond *cond)
+{
+}
+
+void
+g_cond_wait (GCond  *cond,
+             GMutex *mutex)
+{
+  guint sampled = g_atomic_int_get (&cond->i[0]);
+
+  g_mutex_unlock (mutex);
+  g_mutex_futex_wait (&cond->i[0], sampled, NULL);
+  g_mutex_lock (mutex);
+}
+
+void
+g_cond_signal (GCond *cond)
+{
+  g_atomic_int_inc (&cond->i[0]);
+
+  g_mutex_futex_wake (&cond->i[0], 1);
+}
+
+void
+g_cond_broadcast (GCond *cond)
+{
+  g_atomic_int_inc (&cond->i[0]);
+
+  g_mutex_futex_wake (&cond->i[0], G_MAXINT);
+}
+
+gboolean
+g_cond_wait_until (GCond  *cond,
+                   GMutex *mutex,
+                   gint64  end_time)
+{
+  struct timespec now;
+  struct timespec span;
+  guint sampled;
+  gboolean success;
+  gint res;
+
+  if (end_time < 0)
+    return FALSE;
+
+  /* FUTEX_WAIT takes a relative timeout, measured on the same
+   * CLOCK_MONOTONIC as g_get_monotonic_time()
+   */
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  span.tv_sec = (end_time / 1000000) - now.tv_sec;
+  span.tv_nsec = ((end_time % 1000000) * 1000) - now.tv_nsec;
+  if (span.tv_nsec < 0)
+    {
+      span.tv_nsec += 1000000000;
+      span.tv_sec--;
+    }
+
+  if (span.tv_sec < 0)
+    return FALSE;
+
+  sampled = g_atomic_int_get (&cond->i[0]);
+  g_mutex_unlock (mutex);
+  res = syscall (__NR_futex, &cond->i[0], (gsize) FUTEX_WAIT_PRIVATE, (gsize) sampled, &span);
+  success = (res < 0 && errno == ETIMEDOUT) ? FALSE : TRUE;
+  g_mutex_lock (mutex);
+
+  return success;
+}
+
+#endif /* USE_NATIVE_MUTEX */
+
+#ifdef G_ENABLE_DEBUG
+/**
+ * g_mutex_debug_contention_statistics:
+ *
+ * Prints to stderr how often a #GMutex or #GRecMutex was found locked,
+ * how often it was then acquired by spinning, and how often threads had
+ * to sleep on, and be woken from, a mutex.  The counters cover all
+ * mutexes of the process, and are only kept by debug builds of GLib
+ * using the futex(2) based implementation.
+ *
+ * This is meant to be called from a debugger.
+ *
+ * Since: 2.40
+ */
+void
+g_mutex_debug_contention_statistics (void)
+{
+#ifdef USE_NATIVE_MUTEX
+  fprintf (stderr, "GMutex: %" G_GSIZE_FORMAT " contended, %" G_GSIZE_FORMAT " acquired spinning, "
+           "%" G_GSIZE_FORMAT " waits, %" G_GSIZE_FORMAT " wakeups\n",
+           (gsize) g_atomic_pointer_get (&g_mutex_n_contended),
+           (gsize) g_atomic_pointer_get (&g_mutex_n_spun),
+           (gsize) g_atomic_pointer_get (&g_mutex_n_slept),
+           (gsize) g_atomic_pointer_get (&g_mutex_n_woken));
+#else
+  fprintf (stderr, "GMutex: contention statistics are not available\n");
+#endif
+}
+#endif /* G_ENABLE_DEBUG */
+
 /* {{{1 Epilogue */
 /* vim:set foldmethod=marker: */
@@ -152,6 +152,14 @@ g_mutex_unlock (GMutex *mutex)
   g_thread_impl_vtable.ReleaseSRWLockExclusive (mutex);
 }
 
+#ifdef G_ENABLE_DEBUG
+void
+g_mutex_debug_contention_statistics (void)
+{
+  fprintf (stderr, "GMutex: contention statistics are not available\n");
+}
+#endif
+
 /* {{{1 GRecMutex */
 
 static CRITICAL_SECTION *
@@ -528,7 +528,7 @@ static GCond     g_once_cond;
 static GSList   *g_once_init_list = NULL;
 
 static void g_thread_cleanup (gpointer data);
-static GPrivate     g_thread_specific_private = G_PRIVATE_INIT (g_thread_cleanup);
+G_PRIVATE_TLS_DEFINE_STATIC (GRealThread *, g_thread_specific, g_thread_cleanup)
 
 G_LOCK_DEFINE_STATIC (g_thread_new);
 
@@ -717,6 +717,375 @@ void
   g_mutex_unlock (&g_once_mutex);
 }
 
+/* GBigRWLock {{{1 -------------------------------------------------------- */
+
+/**
+ * GBigRWLock:
+ *
+ * The GBigRWLock struct is an opaque data structure to represent a
+ * reader-writer lock that is optimised for data that is read by many
+ * threads at once and written only rarely, such as a registry that is
+ * filled in at startup.
+ *
+ * A #GRWLock keeps a single count of its readers, so every
+ * g_rw_lock_reader_lock() writes to the same cache line, and with many
+ * CPUs taking read locks at the same time that line becomes the
+ * bottleneck.  A GBigRWLock instead spreads its readers over one
+ * counter per CPU, each on a cache line of its own, so that readers on
+ * different CPUs do not touch each other's memory.  In exchange,
+ * g_big_rw_lock_writer_lock() has to look at every counter, and each
+ * lock takes a few kilobytes of memory on machines with many CPUs.
+ *
+ * A waiting writer keeps new readers out until it has had its turn, so
+ * unlike with #GRWLock, read locks cannot be taken recursively: the
+ * second read lock could wait for a writer that waits for the first.
+ *
+ * If a #GBigRWLock is allocated in static storage then it can be used
+ * without initialisation.  Otherwise, you should call
+ * g_big_rw_lock_init() on it and g_big_rw_lock_clear() when done.
+ *
+ * A GBigRWLock should only be accessed with the
+ * <function>g_big_rw_lock_</function> functions.
+ *
+ * Since: 2.40
+ */
+
+/* The counters are not truly per-CPU, as a thread may migrate between
+ * taking and releasing its read lock: every thread is assigned one of
+ * them, round-robin, the first time it takes a read lock.
+ */
+#define G_BIG_RW_LOCK_CACHE_LINE 64
+#define G_BIG_RW_LOCK_MAX_SLOTS  64
+
+typedef struct
+{
+  volatile gint readers;
+  gchar padding[G_BIG_RW_LOCK_CACHE_LINE - sizeof (gint)];
+} GBigRWLockSlot;
+
+typedef struct
+{
+  GMutex          mutex;       /* serialises writers, protects the waits */
+  GCond           cond;
+  volatile gint   writer;      /* a writer holds, or waits for, the lock */
+  guint           n_slots;     /* a power of two */
+  GBigRWLockSlot *slots;       /* aligned to a cache line */
+  gpointer        allocation;
+} GBigRWLockImpl;
+
+G_PRIVATE_TLS_DEFINE_STATIC (gpointer, g_big_rw_lock_slot, NULL)
+static gint g_big_rw_lock_next_slot;
+
+static guint
+g_big_rw_lock_get_slot (GBigRWLockImpl *impl)
+{
+  guint slot;
+
+  slot = GPOINTER_TO_UINT (g_big_rw_lock_slot_get ());
+  if G_UNLIKELY (slot == 0)
+    {
+      slot = (guint) g_atomic_int_add (&g_big_rw_lock_next_slot, 1) % G_BIG_RW_LOCK_MAX_SLOTS + 1;
+      g_big_rw_lock_slot_set (GUINT_TO_POINTER (slot));
+    }
+
+  return (slot - 1) & (impl->n_slots - 1);
+}
+
+static GBigRWLockImpl *
+g_big_rw_lock_impl_new (void)
+{
+  GBigRWLockImpl *impl;
+  guint n_processors;
+
+  impl = g_slice_new0 (GBigRWLockImpl);
+  g_mutex_init (&impl->mutex);
+  g_cond_init (&impl->cond);
+
+  n_processors = g_get_num_processors ();
+  impl->n_slots = 1;
+  while (impl->n_slots < n_processors && impl->n_slots < G_BIG_RW_LOCK_MAX_SLOTS)
+    impl->n_slots <<= 1;
+
+  impl->allocation = g_malloc0 ((impl->n_slots + 1) * sizeof (GBigRWLockSlot));
+  impl->slots = (GBigRWLockSlot *) (((gsize) impl->allocation + G_BIG_RW_LOCK_CACHE_LINE - 1) &
+                                    ~(gsize) (G_BIG_RW_LOCK_CACHE_LINE - 1));
+
+  return impl;
+}
+
+static void
+g_big_rw_lock_impl_free (GBigRWLockImpl *impl)
+{
+  g_mutex_clear (&impl->mutex);
+  g_cond_clear (&impl->cond);
+  g_free (impl->allocation);
+  g_slice_free (GBigRWLockImpl, impl);
+}
+
+static GBigRWLockImpl *
+g_big_rw_lock_get_impl (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_atomic_pointer_get (&rw_lock->p);
+
+  if G_UNLIKELY (impl == NULL)
+    {
+      impl = g_big_rw_lock_impl_new ();
+      if (!g_atomic_pointer_compare_and_exchange (&rw_lock->p, NULL, impl))
+        g_big_rw_lock_impl_free (impl);
+      impl = rw_lock->p;
+    }
+
+  return impl;
+}
+
+/* Returns %TRUE if no reader is left; call with impl->mutex held */
+static gboolean
+g_big_rw_lock_readers_drained (GBigRWLockImpl *impl)
+{
+  guint i;
+
+  for (i = 0; i < impl->n_slots; i++)
+    if (g_atomic_int_get (&impl->slots[i].readers) > 0)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Drops a read lock, waking up a writer waiting for the last one */
+static void
+g_big_rw_lock_release_slot (GBigRWLockImpl *impl,
+                            GBigRWLockSlot *slot)
+{
+  if (g_atomic_int_dec_and_test (&slot->readers) &&
+      g_atomic_int_get (&impl->writer))
+    {
+      g_mutex_lock (&impl->mutex);
+      g_cond_broadcast (&impl->cond);
+      g_mutex_unlock (&impl->mutex);
+    }
+}
+
+/**
+ * g_big_rw_lock_init:
+ * @rw_lock: an uninitialized #GBigRWLock
+ *
+ * Initializes a #GBigRWLock so that it can be used.
+ *
+ * This function is useful to initialize a lock that has been
+ * allocated on the stack, or as part of a larger structure.  It is not
+ * necessary to initialise a lock that has been statically allocated.
+ *
+ * To undo the effect of g_big_rw_lock_init() when a lock is no longer
+ * needed, use g_big_rw_lock_clear().
+ *
+ * Calling g_big_rw_lock_init() on an already initialized #GBigRWLock
+ * leads to undefined behaviour.
+ *
+ * Since: 2.40
+ */
+void
+g_big_rw_lock_init (GBigRWLock *rw_lock)
+{
+  rw_lock->p = g_big_rw_lock_impl_new ();
+}
+
+/**
+ * g_big_rw_lock_clear:
+ * @rw_lock: an initialized #GBigRWLock
+ *
+ * Frees the resources allocated to a lock with g_big_rw_lock_init().
+ *
+ * This function should not be used with a #GBigRWLock that has been
+ * statically allocated.
+ *
+ * Calling g_big_rw_lock_clear() when any thread holds the lock
+ * leads to undefined behaviour.
+ *
+ * Since: 2.40
+ */
+void
+g_big_rw_lock_clear (GBigRWLock *rw_lock)
+{
+  if (rw_lock->p != NULL)
+    g_big_rw_lock_impl_free (rw_lock->p);
+  rw_lock->p = NULL;
+}
+
+/**
+ * g_big_rw_lock_writer_lock:
+ * @rw_lock: a #GBigRWLock
+ *
+ * Obtain a write lock on @rw_lock.  If any thread already holds a read
+ * or write lock on @rw_lock, the current thread will block until all
+ * other threads have dropped their locks on @rw_lock.  New readers
+ * block meanwhile.
+ *
+ * Since: 2.40
+ */
+void
+g_big_rw_lock_writer_lock (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_big_rw_lock_get_impl (rw_lock);
+
+  g_mutex_lock (&impl->mutex);
+
+  while (impl->writer)
+    g_cond_wait (&impl->cond, &impl->mutex);
+
+  g_atomic_int_set (&impl->writer, TRUE);
+
+  while (!g_big_rw_lock_readers_drained (impl))
+    g_cond_wait (&impl->cond, &impl->mutex);
+
+  g_mutex_unlock (&impl->mutex);
+}
+
+/**
+ * g_big_rw_lock_writer_trylock:
+ * @rw_lock: a #GBigRWLock
+ *
+ * Tries to obtain a write lock on @rw_lock.  If any other thread holds
+ * a read or write lock on @rw_lock, it immediately returns %FALSE.
+ * Otherwise it locks @rw_lock and returns %TRUE.
+ *
+ * Returns: %TRUE if @rw_lock could be locked
+ *
+ * Since: 2.40
+ */
+gboolean
+g_big_rw_lock_writer_trylock (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_big_rw_lock_get_impl (rw_lock);
+  gboolean locked = FALSE;
+
+  if (!g_mutex_trylock (&impl->mutex))
+    return FALSE;
+
+  if (!impl->writer)
+    {
+      g_atomic_int_set (&impl->writer, TRUE);
+
+      locked = g_big_rw_lock_readers_drained (impl);
+      if (!locked)
+        {
+          /* Let in the readers that backed off meanwhile */
+          g_atomic_int_set (&impl->writer, FALSE);
+          g_cond_broadcast (&impl->cond);
+        }
+    }
+
+  g_mutex_unlock (&impl->mutex);
+
+  return locked;
+}
+
+/**
+ * g_big_rw_lock_writer_unlock:
+ * @rw_lock: a #GBigRWLock
+ *
+ * Release a write lock on @rw_lock.
+ *
+ * Calling g_big_rw_lock_writer_unlock() on a lock that is not held
+ * by the current thread leads to undefined behaviour.
+ *
+ * Since: 2.40
+ */
+void
+g_big_rw_lock_writer_unlock (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_big_rw_lock_get_impl (rw_lock);
+
+  g_mutex_lock (&impl->mutex);
+  g_atomic_int_set (&impl->writer, FALSE);
+  g_cond_broadcast (&impl->cond);
+  g_mutex_unlock (&impl->mutex);
+}
+
+/**
+ * g_big_rw_lock_reader_lock:
+ * @rw_lock: a #GBigRWLock
+ *
+ * Obtain a read lock on @rw_lock.  If another thread currently holds
+ * the write lock on @rw_lock or blocks waiting for it, the current
+ * thread will block.  Read locks can not be taken recursively.
+ *
+ * When no writer is around, this only increments a counter that is
+ * shared with few, if any, other threads.
+ *
+ * Since: 2.40
+ */
+void
+g_big_rw_lock_reader_lock (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_big_rw_lock_get_impl (rw_lock);
+  GBigRWLockSlot *slot = &impl->slots[g_big_rw_lock_get_slot (impl)];
+
+  while (TRUE)
+    {
+      /* A full barrier, so that either we see the writer, or the
+       * writer sees us when it looks at the counters.
+       */
+      g_atomic_int_inc (&slot->readers);
+
+      if G_LIKELY (!g_atomic_int_get (&impl->writer))
+        return;
+
+      g_big_rw_lock_release_slot (impl, slot);
+
+      g_mutex_lock (&impl->mutex);
+      while (impl->writer)
+        g_cond_wait (&impl->cond, &impl->mutex);
+      g_mutex_unlock (&impl->mutex);
+    }
+}
+
+/**
+ * g_big_rw_lock_reader_trylock:
+ * @rw_lock: a #GBigRWLock
+ *
+ * Tries to obtain a read lock on @rw_lock and returns %TRUE if
+ * the read lock was successfully obtained.  Otherwise it
+ * returns %FALSE.
+ *
+ * Returns: %TRUE if @rw_lock could be locked
+ *
+ * Since: 2.40
+ */
+gboolean
+g_big_rw_lock_reader_trylock (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_big_rw_lock_get_impl (rw_lock);
+  GBigRWLockSlot *slot = &impl->slots[g_big_rw_lock_get_slot (impl)];
+
+  g_atomic_int_inc (&slot->readers);
+
+  if G_LIKELY (!g_atomic_int_get (&impl->writer))
+    return TRUE;
+
+  g_big_rw_lock_release_slot (impl, slot);
+
+  return FALSE;
+}
+
+/**
+ * g_big_rw_lock_reader_unlock:
+ * @rw_lock: a #GBigRWLock
+ *
+ * Release a read lock on @rw_lock.
+ *
+ * Calling g_big_rw_lock_reader_unlock() on a lock that is not held
+ * by the current thread leads to undefined behaviour.
+ *
+ * Since: 2.40
+ */
+void
+g_big_rw_lock_reader_unlock (GBigRWLock *rw_lock)
+{
+  GBigRWLockImpl *impl = g_big_rw_lock_get_impl (rw_lock);
+
+  g_big_rw_lock_release_slot (impl, &impl->slots[g_big_rw_lock_get_slot (impl)]);
+}
+
 /* GThread {{{1 -------------------------------------------------------- */
 
 /**
@@ -780,7 +1149,7 @@ g_thread_proxy (gpointer data)
   g_assert (data);
 
   /* This has to happen before G_LOCK, as that might call g_thread_self */
-  g_private_set (&g_thread_specific_private, data);
+  g_thread_specific_set (thread);
 
   /* The lock makes sure that g_thread_new_internal() has a chance to
    * setup 'func' and 'data' before we make the call.
@@ -991,7 +1360,7 @@ g_thread_join (GThread *thread)
 GThread*
 g_thread_self (void)
 {
-  GRealThread* thread = g_private_get (&g_thread_specific_private);
+  GRealThread* thread = g_thread_specific_get ();
 
   if (!thread)
     {
@@ -1002,7 +1371,7 @@ g_thread_self (void)
       thread = g_slice_new0 (GRealThread);
       thread->ref_count = 1;
 
-      g_private_set (&g_thread_specific_private, thread);
+      g_thread_specific_set (thread);
     }
 
   return (GThread*) thread;
@@ -52,6 +52,7 @@ typedef struct _GThread         GThread;
 typedef union  _GMutex          GMutex;
 typedef struct _GRecMutex       GRecMutex;
 typedef struct _GRWLock         GRWLock;
+typedef struct _GBigRWLock      GBigRWLock;
 typedef struct _GCond           GCond;
 typedef struct _GPrivate        GPrivate;
 typedef struct _GOnce           GOnce;
@@ -70,6 +71,13 @@ struct _GRWLock
   guint i[2];
 };
 
+struct _GBigRWLock
+{
+  /*< private >*/
+  gpointer p;
+  guint i[2];
+};
+
 struct _GCond
 {
   /*< private >*/
@@ -171,6 +179,10 @@ GLIB_AVAILABLE_IN_ALL
 gboolean        g_mutex_trylock                 (GMutex         *mutex);
 GLIB_AVAILABLE_IN_ALL
 void            g_mutex_unlock                  (GMutex         *mutex);
+#ifdef G_ENABLE_DEBUG
+GLIB_AVAILABLE_IN_2_40
+void            g_mutex_debug_contention_statistics (void);
+#endif
 
 GLIB_AVAILABLE_IN_2_32
 void            g_rw_lock_init                  (GRWLock        *rw_lock);
@@ -189,6 +201,23 @@ gboolean        g_rw_lock_reader_trylock        (GRWLock        *rw_lock);
 GLIB_AVAILABLE_IN_2_32
 void            g_rw_lock_reader_unlock         (GRWLock        *rw_lock);
 
+GLIB_AVAILABLE_IN_2_40
+void            g_big_rw_lock_init              (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+void            g_big_rw_lock_clear             (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+void            g_big_rw_lock_writer_lock       (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_big_rw_lock_writer_trylock    (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+void            g_big_rw_lock_writer_unlock     (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+void            g_big_rw_lock_reader_lock       (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_big_rw_lock_reader_trylock    (GBigRWLock     *rw_lock);
+GLIB_AVAILABLE_IN_2_40
+void            g_big_rw_lock_reader_unlock     (GBigRWLock     *rw_lock);
+
 GLIB_AVAILABLE_IN_2_32
 void            g_rec_mutex_init                (GRecMutex      *rec_mutex);
 GLIB_AVAILABLE_IN_2_32
@@ -26,14 +26,28 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gthreadpool.h"
 
 #include "gasyncqueue.h"
 #include "gasyncqueueprivate.h"
+#include "gatomic.h"
 #include "gmain.h"
+#include "gslice.h"
+#include "gstrfuncs.h"
 #include "gtestutils.h"
+#include "gthreadprivate.h"
 #include "gtimer.h"
 
+#ifdef __linux__
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 /**
  * SECTION:thread_pools
  * @title: Thread Pools
@@ -69,12 +83,40 @@
  * controlled by g_thread_pool_get_max_unused_threads() and
  * g_thread_pool_set_max_unused_threads(). All currently unused threads
  * can be stopped by calling g_thread_pool_stop_unused_threads().
+ *
+ * Tasks that are pushed from within the threads of a pool, while
+ * all of the threads that the pool may have are busy, do not go
+ * through the shared queue of the pool. Each thread keeps them in
+ * a queue of its own and processes them after its current task,
+ * unless an idle thread of the pool takes them over first. This
+ * makes pools that split their work into many small tasks scale
+ * much better. Pools with a sort function always use the shared
+ * queue, so that the order of their tasks is kept.
+ *
+ * The threads of latency critical pools can be tied to a set of
+ * processors with g_thread_pool_set_cpu_affinity(), given a
+ * scheduling priority with g_thread_pool_set_thread_priority() and
+ * named with g_thread_pool_set_thread_name(). Threads take these
+ * settings on when they start working for the pool and give them
+ * up again when they leave it, so they are most useful for
+ * exclusive pools.
+ *
+ * g_thread_pool_get_stats() tells how busy a pool is: how many tasks
+ * went through it and how many threads came and went. If timing was
+ * turned on with g_thread_pool_set_timing_stats(), it also tells how
+ * long tasks waited in the queue and ran, and how long the threads
+ * were busy and idle.
  */
 
 #define DEBUG_MSG(x)
 /* #define DEBUG_MSG(args) g_printerr args ; g_printerr ("\n");    */
 
 typedef struct _GRealThreadPool GRealThreadPool;
+typedef struct _GThreadPoolDeque GThreadPoolDeque;
+typedef struct _GThreadPoolWorker GThreadPoolWorker;
+
+#define THREAD_POOL_MAX_DEQUES  64
+#define THREAD_POOL_DEQUE_SIZE  256     /* a power of 2 */
 
 /**
  * GThreadPool:
@@ -86,6 +128,40 @@ typedef struct _GRealThreadPool GRealThreadPool;
  * public read-only members, but the underlying struct is bigger,
  * so you must not copy this struct.
  */
+
+/**
+ * GThreadPoolStats:
+ * @tasks_pushed: the number of tasks pushed to the pool
+ * @tasks_completed: the number of tasks that finished running
+ * @threads_started: how often a thread started working for the pool
+ * @threads_exited: how often a thread stopped working for the pool
+ * @run_time: the time spent running tasks, in microseconds, which is
+ *     how long the threads of the pool were busy
+ * @idle_time: the time the threads of the pool spent waiting for
+ *     tasks, in microseconds
+ * @wait_time: the time tasks spent in the queue before they ran, in
+ *     microseconds, summed over all tasks
+ * @max_wait_time: the longest time a task spent in the queue
+ * @wait_histogram: the number of tasks by the time they spent in the
+ *     queue: element 0 counts the tasks that waited less than a
+ *     microsecond, element i those that waited at least 2^(i-1) and
+ *     less than 2^i microseconds, and the last element all that
+ *     waited longer
+ *
+ * What happened in a #GThreadPool, see g_thread_pool_get_stats().
+ * All times are only measured if g_thread_pool_set_timing_stats()
+ * was used.
+ *
+ * Since: 2.40
+ */
+
+/**
+ * G_THREAD_POOL_STATS_N_BUCKETS:
+ *
+ * The number of elements in #GThreadPoolStats.wait_histogram.
+ *
+ * Since: 2.40
+ */
 struct _GRealThreadPool
 {
   GThreadPool pool;
@@ -98,8 +174,65 @@ struct _GRealThreadPool
   gboolean waiting;
   GCompareDataFunc sort_func;
   gpointer sort_user_data;
+  /* work stealing, see g_thread_pool_push_local() */
+  gint n_idle;
+  gint n_local;
+  gint n_deques;
+  GThreadPoolDeque *deques[THREAD_POOL_MAX_DEQUES];
+  /* thread settings, see g_thread_pool_worker_apply_policy() */
+  guint policy_serial;
+  guint thread_index;
+  gchar *thread_name;
+  guint *cpus;
+  guint n_cpus;
+  gboolean spread_cpus;
+  gboolean has_priority;
+  gint priority;
+  /* see g_thread_pool_get_stats(), protected by the queue's lock */
+  gboolean timing;
+  GThreadPoolStats stats;
+};
+
+/* A Chase-Lev deque of the tasks that one thread pushed to its own
+ * pool: the owner pushes and pops at the bottom, other threads of the
+ * pool steal from the top.  It has a fixed size; once it is full,
+ * tasks go to the shared queue.
+ */
+struct _GThreadPoolDeque
+{
+  gint top;
+  gint bottom;
+  gboolean in_use;
+  gpointer tasks[THREAD_POOL_DEQUE_SIZE];
+};
+
+/* The pool a thread works for, set while it is attached to one */
+struct _GThreadPoolWorker
+{
+  GRealThreadPool *pool;
+  GThreadPoolDeque *deque;
+  guint32 seed;
+  guint policy_serial;          /* of the settings applied, or 0 */
+  gboolean policy_saved;
+  gboolean idle;                /* counted in the pool's n_idle */
+#ifdef __linux__
+  cpu_set_t saved_affinity;
+  gint saved_priority;
+#endif
+  /* counted without the lock, see g_thread_pool_worker_flush_stats() */
+  gboolean has_stats;
+  GThreadPoolStats stats;
 };
 
+/* A task of a pool with timing stats, remembering when it was pushed */
+typedef struct
+{
+  gpointer data;
+  gint64   push_time;
+} GThreadPoolTimedTask;
+
+static GPrivate current_worker;
+
 /* The following is just an address to mark the wakeup order for a
  * thread, it could be any address (as long, as it isn't a valid
  * GThreadPool address)
@@ -114,6 +247,10 @@ static gint max_unused_threads = 2;
 static gint kill_unused_threads = 0;
 static guint max_idle_time = 15 * 1000;
 
+/* The stats of the unused threads, see g_thread_pool_get_stats() */
+G_LOCK_DEFINE_STATIC (unused_stats);
+static GThreadPoolStats unused_stats;
+
 static void             g_thread_pool_queue_push_unlocked (GRealThreadPool  *pool,
                                                            gpointer          data);
 static void             g_thread_pool_free_internal       (GRealThreadPool  *pool);
@@ -122,13 +259,431 @@ static gboolean         g_thread_pool_start_thread        (GRealThreadPool  *poo
                                                            GError          **error);
 static void             g_thread_pool_wakeup_and_stop_all (GRealThreadPool  *pool);
 static GRealThreadPool* g_thread_pool_wait_for_new_pool   (void);
-static gpointer         g_thread_pool_wait_for_new_task   (GRealThreadPool  *pool);
+static gpointer         g_thread_pool_wait_for_new_task   (GThreadPoolWorker *worker);
+
+static gboolean
+g_thread_pool_deque_push (GThreadPoolDeque *deque,
+                          gpointer          task)
+{
+  gint bottom = deque->bottom;
+  gint top = g_atomic_int_get (&deque->top);
+
+  if ((guint) bottom - (guint) top >= THREAD_POOL_DEQUE_SIZE)
+    return FALSE;
+
+  g_atomic_pointer_set (&deque->tasks[(guint) bottom % THREAD_POOL_DEQUE_SIZE], task);
+  g_atomic_int_set (&deque->bottom, (guint) bottom + 1);
+
+  return TRUE;
+}
+
+static gpointer
+g_thread_pool_deque_pop (GThreadPoolDeque *deque)
+{
+  gint bottom = (guint) deque->bottom - 1;
+  gint top;
+  gpointer task;
+
+  g_atomic_int_set (&deque->bottom, bottom);
+  top = g_atomic_int_get (&deque->top);
+
+  if ((gint) ((guint) bottom - (guint) top) < 0)
+    {
+      /* empty */
+      g_atomic_int_set (&deque->bottom, top);
+      return NULL;
+    }
+
+  task = g_atomic_pointer_get (&deque->tasks[(guint) bottom % THREAD_POOL_DEQUE_SIZE]);
+
+  if (bottom == top)
+    {
+      /* the last task, which a thief may be taking as well */
+      if (!g_atomic_int_compare_and_exchange (&deque->top, top, (guint) top + 1))
+        task = NULL;
+      g_atomic_int_set (&deque->bottom, (guint) top + 1);
+    }
+
+  return task;
+}
+
+static gpointer
+g_thread_pool_deque_steal (GThreadPoolDeque *deque)
+{
+  gint top = g_atomic_int_get (&deque->top);
+  gint bottom = g_atomic_int_get (&deque->bottom);
+  gpointer task;
+
+  if ((gint) ((guint) bottom - (guint) top) <= 0)
+    return NULL;
+
+  task = g_atomic_pointer_get (&deque->tasks[(guint) top % THREAD_POOL_DEQUE_SIZE]);
+
+  if (!g_atomic_int_compare_and_exchange (&deque->top, top, (guint) top + 1))
+    return NULL;
+
+  return task;
+}
+
+static gpointer
+g_thread_pool_timed_task_new (gpointer data)
+{
+  GThreadPoolTimedTask *timed = g_slice_new (GThreadPoolTimedTask);
+
+  timed->data = data;
+  timed->push_time = g_get_monotonic_time ();
+
+  return timed;
+}
+
+static gint
+g_thread_pool_timed_task_compare (gconstpointer a,
+                                  gconstpointer b,
+                                  gpointer      user_data)
+{
+  GRealThreadPool *pool = user_data;
+  const GThreadPoolTimedTask *ta = a;
+  const GThreadPoolTimedTask *tb = b;
+
+  return pool->sort_func (ta->data, tb->data, pool->sort_user_data);
+}
+
+static void
+g_thread_pool_stats_add (GThreadPoolStats       *stats,
+                         const GThreadPoolStats *other)
+{
+  guint i;
+
+  stats->tasks_pushed += other->tasks_pushed;
+  stats->tasks_completed += other->tasks_completed;
+  stats->threads_started += other->threads_started;
+  stats->threads_exited += other->threads_exited;
+  stats->run_time += other->run_time;
+  stats->idle_time += other->idle_time;
+  stats->wait_time += other->wait_time;
+  stats->max_wait_time = MAX (stats->max_wait_time, other->max_wait_time);
+  for (i = 0; i < G_THREAD_POOL_STATS_N_BUCKETS; i++)
+    stats->wait_histogram[i] += other->wait_histogram[i];
+}
+
+static void
+g_thread_pool_stats_add_wait (GThreadPoolStats *stats,
+                              gint64            wait)
+{
+  guint bucket = 0;
+
+  if (wait < 0)
+    wait = 0;
+
+  stats->wait_time += wait;
+  stats->max_wait_time = MAX (stats->max_wait_time, (guint64) wait);
+
+  while (wait > 0 && bucket < G_THREAD_POOL_STATS_N_BUCKETS - 1)
+    {
+      wait >>= 1;
+      bucket++;
+    }
+  stats->wait_histogram[bucket]++;
+}
+
+/* Called with the queue locked, to hand over what the worker
+ * counted while running tasks.
+ */
+static void
+g_thread_pool_worker_flush_stats (GThreadPoolWorker *worker)
+{
+  if (worker->has_stats)
+    {
+      g_thread_pool_stats_add (&worker->pool->stats, &worker->stats);
+      memset (&worker->stats, 0, sizeof (GThreadPoolStats));
+      worker->has_stats = FALSE;
+    }
+}
+
+/* Runs @task, or just drops it if @run is %FALSE, while the queue
+ * is unlocked.
+ */
+static void
+g_thread_pool_worker_run_task (GThreadPoolWorker *worker,
+                               gpointer           task,
+                               gboolean           run)
+{
+  GRealThreadPool *pool = worker->pool;
+  GThreadPoolTimedTask *timed;
+  gint64 push_time, start;
+
+  worker->has_stats = TRUE;
+
+  if (!pool->timing)
+    {
+      if (run)
+        {
+          pool->pool.func (task, pool->pool.user_data);
+          worker->stats.tasks_completed++;
+        }
+      return;
+    }
+
+  timed = task;
+  task = timed->data;
+  push_time = timed->push_time;
+  g_slice_free (GThreadPoolTimedTask, timed);
+
+  if (run)
+    {
+      start = g_get_monotonic_time ();
+      g_thread_pool_stats_add_wait (&worker->stats, start - push_time);
+      pool->pool.func (task, pool->pool.user_data);
+      worker->stats.tasks_completed++;
+      worker->stats.run_time += g_get_monotonic_time () - start;
+    }
+}
+
+/* Called with the pool's queue locked, whenever the thread starts
+ * working for the pool or picks up a task, to take on the thread
+ * settings of the pool if they changed.  Errors are ignored: the
+ * settings are only hints to the scheduler.
+ */
+static void
+g_thread_pool_worker_apply_policy (GThreadPoolWorker *worker)
+{
+  GRealThreadPool *pool = worker->pool;
+  guint index;
+
+  if (G_LIKELY (worker->policy_serial == pool->policy_serial))
+    return;
+
+  worker->policy_serial = pool->policy_serial;
+  index = pool->thread_index++;
+
+#ifdef __linux__
+  if (!worker->policy_saved)
+    {
+      pid_t tid = syscall (SYS_gettid);
+
+      if (sched_getaffinity (0, sizeof (cpu_set_t), &worker->saved_affinity) != 0)
+        CPU_ZERO (&worker->saved_affinity);
+      errno = 0;
+      worker->saved_priority = getpriority (PRIO_PROCESS, tid);
+      if (errno != 0)
+        worker->saved_priority = 0;
+      worker->policy_saved = TRUE;
+    }
+
+  if (pool->n_cpus > 0)
+    {
+      cpu_set_t set;
+      guint i;
+
+      CPU_ZERO (&set);
+      for (i = 0; i < pool->n_cpus; i++)
+        if (pool->cpus[i] < CPU_SETSIZE &&
+            (!pool->spread_cpus || i == index % pool->n_cpus))
+          CPU_SET (pool->cpus[i], &set);
+      if (CPU_COUNT (&set) > 0)
+        sched_setaffinity (0, sizeof (cpu_set_t), &set);
+    }
+  else if (CPU_COUNT (&worker->saved_affinity) > 0)
+    sched_setaffinity (0, sizeof (cpu_set_t), &worker->saved_affinity);
+
+  setpriority (PRIO_PROCESS, syscall (SYS_gettid),
+               pool->has_priority ? pool->priority : worker->saved_priority);
+#endif
+
+  if (pool->thread_name)
+    {
+      gchar name[16];
+
+      g_snprintf (name, sizeof name, "%s-%u", pool->thread_name, index);
+      g_system_thread_set_name (name);
+    }
+  else
+    g_system_thread_set_name ("pool");
+}
+
+/* Gives up the settings of the pool the thread leaves */
+static void
+g_thread_pool_worker_restore_policy (GThreadPoolWorker *worker)
+{
+  if (worker->policy_serial == 0)
+    return;
+
+  worker->policy_serial = 0;
+
+#ifdef __linux__
+  if (CPU_COUNT (&worker->saved_affinity) > 0)
+    sched_setaffinity (0, sizeof (cpu_set_t), &worker->saved_affinity);
+  setpriority (PRIO_PROCESS, syscall (SYS_gettid), worker->saved_priority);
+#endif
+
+  g_system_thread_set_name ("pool");
+}
+
+/* Called with the queue locked, when @worker starts working for @pool */
+static void
+g_thread_pool_worker_attach (GThreadPoolWorker *worker,
+                             GRealThreadPool   *pool)
+{
+  gint i;
+
+  worker->pool = pool;
+  worker->deque = NULL;
+  pool->stats.threads_started++;
+
+  g_thread_pool_worker_apply_policy (worker);
+
+  if (pool->sort_func)
+    return;
+
+  for (i = 0; i < pool->n_deques; i++)
+    if (!pool->deques[i]->in_use)
+      {
+        worker->deque = pool->deques[i];
+        break;
+      }
+
+  if (worker->deque == NULL && pool->n_deques < THREAD_POOL_MAX_DEQUES)
+    {
+      worker->deque = g_new0 (GThreadPoolDeque, 1);
+      pool->deques[pool->n_deques] = worker->deque;
+      g_atomic_int_inc (&pool->n_deques);
+    }
+
+  if (worker->deque)
+    worker->deque->in_use = TRUE;
+}
+
+/* Called with the queue locked.  Only a thread with an empty deque
+ * waits for new tasks, so the deque can be handed over as it is.
+ */
+static void
+g_thread_pool_worker_detach (GThreadPoolWorker *worker)
+{
+  if (worker->deque)
+    worker->deque->in_use = FALSE;
+
+  g_thread_pool_worker_restore_policy (worker);
+  g_thread_pool_worker_flush_stats (worker);
+  worker->pool->stats.threads_exited++;
+
+  worker->pool = NULL;
+  worker->deque = NULL;
+}
+
+/* The next task that was pushed locally, either to our own deque or,
+ * when that is empty, to the deque of another thread of the pool.
+ */
+static gpointer
+g_thread_pool_worker_next_task (GThreadPoolWorker *worker)
+{
+  GRealThreadPool *pool = worker->pool;
+  gpointer task = NULL;
+  gint n_deques, start, i;
+
+  if (g_atomic_int_get (&pool->n_local) == 0)
+    return NULL;
+
+  if (worker->deque)
+    task = g_thread_pool_deque_pop (worker->deque);
+
+  if (task == NULL)
+    {
+      n_deques = g_atomic_int_get (&pool->n_deques);
+
+      /* xorshift, to pick a random victim without taking a lock */
+      worker->seed ^= worker->seed << 13;
+      worker->seed ^= worker->seed >> 17;
+      worker->seed ^= worker->seed << 5;
+      start = n_deques ? worker->seed % n_deques : 0;
+
+      for (i = 0; i < n_deques && task == NULL; i++)
+        {
+          GThreadPoolDeque *victim = pool->deques[(start + i) % n_deques];
+
+          if (victim != worker->deque)
+            task = g_thread_pool_deque_steal (victim);
+        }
+    }
+
+  if (task)
+    g_atomic_int_add (&pool->n_local, -1);
+
+  return task;
+}
+
+/* Pushes @data to the deque of the current thread, if it works for
+ * @pool and all of the threads of @pool are busy: nobody would pick it
+ * up from the shared queue right away anyway.
+ */
+static gboolean
+g_thread_pool_push_local (GRealThreadPool *pool,
+                          gpointer         data)
+{
+  GThreadPoolWorker *worker = g_private_get (&current_worker);
+
+  if (worker == NULL || worker->pool != pool || worker->deque == NULL)
+    return FALSE;
+
+  if (g_atomic_pointer_get (&pool->sort_func) != NULL ||
+      g_atomic_int_get (&pool->n_idle) > 0)
+    return FALSE;
+
+  if (pool->max_threads == -1 ||
+      g_atomic_int_get (&pool->num_threads) < g_atomic_int_get (&pool->max_threads))
+    return FALSE;
+
+  if (pool->timing)
+    data = g_thread_pool_timed_task_new (data);
+
+  /* count it first, so that a thief never sees n_local at 0 */
+  g_atomic_int_inc (&pool->n_local);
+  if (!g_thread_pool_deque_push (worker->deque, data))
+    {
+      g_atomic_int_add (&pool->n_local, -1);
+      if (pool->timing)
+        g_slice_free (GThreadPoolTimedTask, data);
+      return FALSE;
+    }
+
+  /* A thread that went idle since the checks above may have looked at
+   * the deques before the task was there, and one that left the pool
+   * makes room for a new one: take the task back, for the shared queue
+   * to wake or start a thread.  Idle threads count themselves before
+   * they steal, and leaving ones stop counting only once they are gone,
+   * see g_thread_pool_wait_for_new_task().
+   */
+  if (g_atomic_int_get (&pool->n_idle) > 0 ||
+      g_atomic_int_get (&pool->num_threads) < g_atomic_int_get (&pool->max_threads))
+    {
+      /* a thief may have taken it already, which is just as good */
+      if (g_thread_pool_deque_pop (worker->deque) != NULL)
+        {
+          g_atomic_int_add (&pool->n_local, -1);
+          if (pool->timing)
+            g_slice_free (GThreadPoolTimedTask, data);
+          return FALSE;
+        }
+    }
+
+  worker->stats.tasks_pushed++;
+  worker->has_stats = TRUE;
+
+  return TRUE;
+}
 
 static void
 g_thread_pool_queue_push_unlocked (GRealThreadPool *pool,
                                    gpointer         data)
 {
-  if (pool->sort_func)
+  if (pool->timing)
+    data = g_thread_pool_timed_task_new (data);
+
+  if (pool->sort_func && pool->timing)
+    g_async_queue_push_sorted_unlocked (pool->queue,
+                                        data,
+                                        g_thread_pool_timed_task_compare,
+                                        pool);
+  else if (pool->sort_func)
     g_async_queue_push_sorted_unlocked (pool->queue,
                                         data,
                                         pool->sort_func,
@@ -146,12 +701,14 @@ g_thread_pool_wait_for_new_pool (void)
   gint local_max_idle_time;
   gint last_wakeup_thread_serial;
   gboolean have_relayed_thread_marker = FALSE;
+  gint64 idle_start;
 
   local_max_unused_threads = g_atomic_int_get (&max_unused_threads);
   local_max_idle_time = g_atomic_int_get (&max_idle_time);
   last_wakeup_thread_serial = g_atomic_int_get (&wakeup_thread_serial);
 
   g_atomic_int_inc (&unused_threads);
+  idle_start = g_get_monotonic_time ();
 
   do
     {
@@ -223,12 +780,21 @@ g_thread_pool_wait_for_new_pool (void)
 
   g_atomic_int_add (&unused_threads, -1);
 
+  G_LOCK (unused_stats);
+  unused_stats.idle_time += g_get_monotonic_time () - idle_start;
+  if (pool)
+    unused_stats.tasks_completed++;
+  else
+    unused_stats.threads_exited++;
+  G_UNLOCK (unused_stats);
+
   return pool;
 }
 
 static gpointer
-g_thread_pool_wait_for_new_task (GRealThreadPool *pool)
+g_thread_pool_wait_for_new_task (GThreadPoolWorker *worker)
 {
+  GRealThreadPool *pool = worker->pool;
   gpointer task = NULL;
 
   if (pool->running || (!pool->immediate &&
@@ -241,28 +807,49 @@ g_thread_pool_wait_for_new_task (GRealThreadPool *pool)
           DEBUG_MSG (("superfluous thread %p in pool %p.",
                       g_thread_self (), pool));
         }
-      else if (pool->pool.exclusive)
-        {
-          /* Exclusive threads stay attached to the pool. */
-          task = g_async_queue_pop_unlocked (pool->queue);
-
-          DEBUG_MSG (("thread %p in exclusive pool %p waits for task "
-                      "(%d running, %d unprocessed).",
-                      g_thread_self (), pool, pool->num_threads,
-                      g_async_queue_length_unlocked (pool->queue)));
-        }
       else
         {
-          /* A thread will wait for new tasks for at most 1/2
-           * second before going to the global pool.
+          /* Tasks pushed locally by busy threads come first.  The
+           * thread counts as idle before it looks, so that any task
+           * pushed meanwhile is either found or handed to the queue,
+           * see g_thread_pool_push_local().
            */
-          DEBUG_MSG (("thread %p in pool %p waits for up to a 1/2 second for task "
-                      "(%d running, %d unprocessed).",
-                      g_thread_self (), pool, pool->num_threads,
-                      g_async_queue_length_unlocked (pool->queue)));
+          worker->idle = TRUE;
+          g_atomic_int_inc (&pool->n_idle);
+          task = g_thread_pool_worker_next_task (worker);
+
+          if (task == NULL && pool->pool.exclusive)
+            {
+              /* Exclusive threads stay attached to the pool. */
+              task = g_async_queue_pop_unlocked (pool->queue);
+
+              DEBUG_MSG (("thread %p in exclusive pool %p waits for task "
+                          "(%d running, %d unprocessed).",
+                          g_thread_self (), pool, pool->num_threads,
+                          g_async_queue_length_unlocked (pool->queue)));
+            }
+          else if (task == NULL)
+            {
+              /* A thread will wait for new tasks for at most 1/2
+               * second before going to the global pool.
+               */
+              DEBUG_MSG (("thread %p in pool %p waits for up to a 1/2 second for task "
+                          "(%d running, %d unprocessed).",
+                          g_thread_self (), pool, pool->num_threads,
+                          g_async_queue_length_unlocked (pool->queue)));
 
-          task = g_async_queue_timeout_pop_unlocked (pool->queue,
-						     G_USEC_PER_SEC / 2);
+              task = g_async_queue_timeout_pop_unlocked (pool->queue,
+                                                         G_USEC_PER_SEC / 2);
+            }
+
+          /* A thread that got nothing keeps counting as idle until it
+           * has left the pool.
+           */
+          if (task != NULL)
+            {
+              worker->idle = FALSE;
+              g_atomic_int_add (&pool->n_idle, -1);
+            }
         }
     }
   else
@@ -284,20 +871,40 @@ static gpointer
 g_thread_pool_thread_proxy (gpointer data)
 {
   GRealThreadPool *pool;
+  GThreadPoolWorker worker;
 
   pool = data;
 
   DEBUG_MSG (("thread %p started for pool %p.", g_thread_self (), pool));
 
+  worker.seed = GPOINTER_TO_UINT (&worker) | 1;
+  worker.policy_serial = 0;
+  worker.policy_saved = FALSE;
+  worker.idle = FALSE;
+  worker.has_stats = FALSE;
+  memset (&worker.stats, 0, sizeof (GThreadPoolStats));
+  g_private_set (&current_worker, &worker);
+
   g_async_queue_lock (pool->queue);
+  g_thread_pool_worker_attach (&worker, pool);
 
   while (TRUE)
     {
       gpointer task;
+      gint64 idle_start = 0;
+
+      if (pool->timing)
+        idle_start = g_get_monotonic_time ();
+
+      task = g_thread_pool_wait_for_new_task (&worker);
+
+      if (pool->timing)
+        pool->stats.idle_time += g_get_monotonic_time () - idle_start;
 
-      task = g_thread_pool_wait_for_new_task (pool);
       if (task)
         {
+          g_thread_pool_worker_apply_policy (&worker);
+
           if (pool->running || !pool->immediate)
             {
               /* A task was received and the thread pool is active,
@@ -306,9 +913,21 @@ g_thread_pool_thread_proxy (gpointer data)
               g_async_queue_unlock (pool->queue);
               DEBUG_MSG (("thread %p in pool %p calling func.",
                           g_thread_self (), pool));
-              pool->pool.func (task, pool->pool.user_data);
+              g_thread_pool_worker_run_task (&worker, task, TRUE);
+
+              /* Then process the tasks that were pushed locally,
+               * which are dropped if the pool is stopped immediately.
+               */
+              while ((task = g_thread_pool_worker_next_task (&worker)))
+                g_thread_pool_worker_run_task (&worker, task,
+                                               g_atomic_int_get (&pool->running) ||
+                                               !g_atomic_int_get (&pool->immediate));
+
               g_async_queue_lock (pool->queue);
+              g_thread_pool_worker_flush_stats (&worker);
             }
+          else
+            g_thread_pool_worker_run_task (&worker, task, FALSE);
         }
       else
         {
@@ -317,8 +936,16 @@ g_thread_pool_thread_proxy (gpointer data)
 
           DEBUG_MSG (("thread %p leaving pool %p for global pool.",
                       g_thread_self (), pool));
+          g_thread_pool_worker_detach (&worker);
           pool->num_threads--;
 
+          /* only now, see g_thread_pool_push_local() */
+          if (worker.idle)
+            {
+              worker.idle = FALSE;
+              g_atomic_int_add (&pool->n_idle, -1);
+            }
+
           if (!pool->running)
             {
               if (!pool->waiting)
@@ -367,6 +994,7 @@ g_thread_pool_thread_proxy (gpointer data)
             break;
 
           g_async_queue_lock (pool->queue);
+          g_thread_pool_worker_attach (&worker, pool);
 
           DEBUG_MSG (("thread %p entering pool %p from global pool.",
                       g_thread_self (), pool));
@@ -414,6 +1042,13 @@ g_thread_pool_start_thread (GRealThreadPool  *pool,
       g_thread_unref (thread);
     }
 
+  G_LOCK (unused_stats);
+  if (success)
+    unused_stats.tasks_pushed++;
+  else
+    unused_stats.threads_started++;
+  G_UNLOCK (unused_stats);
+
   /* See comment in g_thread_pool_thread_proxy as to why this is done
    * here and not there
    */
@@ -485,6 +1120,19 @@ g_thread_pool_new (GFunc      func,
   retval->waiting = FALSE;
   retval->sort_func = NULL;
   retval->sort_user_data = NULL;
+  retval->n_idle = 0;
+  retval->n_local = 0;
+  retval->n_deques = 0;
+  retval->policy_serial = 0;
+  retval->thread_index = 0;
+  retval->thread_name = NULL;
+  retval->cpus = NULL;
+  retval->n_cpus = 0;
+  retval->spread_cpus = FALSE;
+  retval->has_priority = FALSE;
+  retval->priority = 0;
+  retval->timing = FALSE;
+  memset (&retval->stats, 0, sizeof (GThreadPoolStats));
 
   G_LOCK (init);
   if (!unused_thread_queue)
@@ -550,6 +1198,9 @@ g_thread_pool_push (GThreadPool  *pool,
 
   result = TRUE;
 
+  if (g_thread_pool_push_local (real, data))
+    return TRUE;
+
   g_async_queue_lock (real->queue);
 
   if (g_async_queue_length_unlocked (real->queue) >= 0)
@@ -564,12 +1215,92 @@ g_thread_pool_push (GThreadPool  *pool,
         }
     }
 
+  real->stats.tasks_pushed++;
   g_thread_pool_queue_push_unlocked (real, data);
   g_async_queue_unlock (real->queue);
 
   return result;
 }
 
+/**
+ * g_thread_pool_push_many:
+ * @pool: a #GThreadPool
+ * @data: (array length=n_data): the new tasks for @pool
+ * @n_data: the number of tasks in @data
+ * @error: return location for error, or %NULL
+ *
+ * Inserts all tasks of @data into the list of tasks to be executed
+ * by @pool, as if g_thread_pool_push() had been called for each of
+ * them, but taking the lock of the pool's queue only once. New
+ * threads are started as needed for the additional tasks.
+ *
+ * An error can only occur when a new thread couldn't be created. In
+ * that case all of @data is still appended to the queue of work to do.
+ *
+ * Return value: %TRUE on success, %FALSE if an error occurred
+ *
+ * Since: 2.40
+ */
+gboolean
+g_thread_pool_push_many (GThreadPool  *pool,
+                         gpointer     *data,
+                         guint         n_data,
+                         GError      **error)
+{
+  GRealThreadPool *real;
+  gboolean result;
+  gint length;
+  guint i;
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_val_if_fail (real, FALSE);
+  g_return_val_if_fail (real->running, FALSE);
+  g_return_val_if_fail (data || n_data == 0, FALSE);
+
+  result = TRUE;
+
+  while (n_data > 0 && g_thread_pool_push_local (real, *data))
+    {
+      data++;
+      n_data--;
+    }
+
+  if (n_data == 0)
+    return TRUE;
+
+  g_async_queue_lock (real->queue);
+
+  /* Every task that no waiting thread will pick up may start a thread */
+  length = g_async_queue_length_unlocked (real->queue);
+  for (i = 0; i < n_data && length + (gint) i >= 0; i++)
+    {
+      GError *local_error = NULL;
+
+      if (real->max_threads != -1 && real->num_threads >= real->max_threads)
+        break;
+
+      if (!g_thread_pool_start_thread (real, &local_error))
+        {
+          g_propagate_error (error, local_error);
+          result = FALSE;
+          break;
+        }
+    }
+
+  real->stats.tasks_pushed += n_data;
+
+  if (real->sort_func || real->timing)
+    for (i = 0; i < n_data; i++)
+      g_thread_pool_queue_push_unlocked (real, data[i]);
+  else
+    g_async_queue_push_many_unlocked (real->queue, data, n_data);
+
+  g_async_queue_unlock (real->queue);
+
+  return result;
+}
+
 /**
  * g_thread_pool_set_max_threads:
  * @pool: a #GThreadPool
@@ -625,7 +1356,8 @@ g_thread_pool_set_max_threads (GThreadPool  *pool,
   if (pool->exclusive)
     to_start = real->max_threads - real->num_threads;
   else
-    to_start = g_async_queue_length_unlocked (real->queue);
+    to_start = g_async_queue_length_unlocked (real->queue) +
+               g_atomic_int_get (&real->n_local);
 
   for ( ; to_start > 0; to_start--)
     {
@@ -717,7 +1449,7 @@ g_thread_pool_unprocessed (GThreadPool *pool)
 
   unprocessed = g_async_queue_length (real->queue);
 
-  return MAX (unprocessed, 0);
+  return MAX (unprocessed, 0) + g_atomic_int_get (&real->n_local);
 }
 
 /**
@@ -797,10 +1529,17 @@ g_thread_pool_free (GThreadPool *pool,
 static void
 g_thread_pool_free_internal (GRealThreadPool* pool)
 {
+  gint i;
+
   g_return_if_fail (pool);
   g_return_if_fail (pool->running == FALSE);
   g_return_if_fail (pool->num_threads == 0);
 
+  for (i = 0; i < pool->n_deques; i++)
+    g_free (pool->deques[i]);
+  g_free (pool->thread_name);
+  g_free (pool->cpus);
+
   g_async_queue_unref (pool->queue);
   g_cond_clear (&pool->cond);
 
@@ -945,7 +1684,11 @@ g_thread_pool_set_sort_function (GThreadPool      *pool,
   real->sort_func = func;
   real->sort_user_data = user_data;
 
-  if (func)
+  if (func && real->timing)
+    g_async_queue_sort_unlocked (real->queue,
+                                 g_thread_pool_timed_task_compare,
+                                 real);
+  else if (func)
     g_async_queue_sort_unlocked (real->queue,
                                  real->sort_func,
                                  real->sort_user_data);
@@ -953,6 +1696,215 @@ g_thread_pool_set_sort_function (GThreadPool      *pool,
   g_async_queue_unlock (real->queue);
 }
 
+/**
+ * g_thread_pool_set_cpu_affinity:
+ * @pool: a #GThreadPool
+ * @cpus: (array length=n_cpus) (allow-none): the processors the
+ *     threads may run on
+ * @n_cpus: the number of processors in @cpus, or 0 to lift the
+ *     restriction
+ * @spread: whether to spread the threads over @cpus
+ *
+ * Restricts the threads working for @pool to the processors in
+ * @cpus. If @spread is %FALSE, every thread may run on any of them.
+ * If @spread is %TRUE, each thread is pinned to a single one of them,
+ * going round @cpus as threads join the pool, so that they keep
+ * their caches warm and do not compete with each other.
+ *
+ * Threads take this setting on before they run their next task, and
+ * give it up when they leave @pool. As the threads of non-exclusive
+ * pools come and go, this is mostly useful for exclusive pools.
+ *
+ * This is only supported on Linux; elsewhere it has no effect.
+ *
+ * Since: 2.40
+ */
+void
+g_thread_pool_set_cpu_affinity (GThreadPool *pool,
+                                const guint *cpus,
+                                guint        n_cpus,
+                                gboolean     spread)
+{
+  GRealThreadPool *real;
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_if_fail (real);
+  g_return_if_fail (real->running);
+  g_return_if_fail (cpus != NULL || n_cpus == 0);
+
+  g_async_queue_lock (real->queue);
+
+  g_free (real->cpus);
+  real->cpus = g_memdup (cpus, n_cpus * sizeof (guint));
+  real->n_cpus = n_cpus;
+  real->spread_cpus = spread;
+  real->thread_index = 0;
+  real->policy_serial++;
+
+  g_async_queue_unlock (real->queue);
+}
+
+/**
+ * g_thread_pool_set_thread_priority:
+ * @pool: a #GThreadPool
+ * @set: whether to change the priority of the threads
+ * @priority: the nice value for the threads, from -20 (most
+ *     favourable) to 19
+ *
+ * Sets the scheduling priority of the threads working for @pool, like
+ * the nice value of a process.  If @set is %FALSE, the threads keep
+ * the priority they were created with. Raising the priority usually
+ * requires special privileges; if it is refused, the threads keep
+ * running at their previous priority.
+ *
+ * Like g_thread_pool_set_cpu_affinity(), this is applied before the
+ * next task, and only supported on Linux.
+ *
+ * Since: 2.40
+ */
+void
+g_thread_pool_set_thread_priority (GThreadPool *pool,
+                                   gboolean     set,
+                                   gint         priority)
+{
+  GRealThreadPool *real;
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_if_fail (real);
+  g_return_if_fail (real->running);
+  g_return_if_fail (priority >= -20 && priority <= 19);
+
+  g_async_queue_lock (real->queue);
+
+  real->has_priority = set;
+  real->priority = priority;
+  real->policy_serial++;
+
+  g_async_queue_unlock (real->queue);
+}
+
+/**
+ * g_thread_pool_set_thread_name:
+ * @pool: a #GThreadPool
+ * @prefix: (allow-none): the name prefix for the threads, or %NULL
+ *
+ * Gives the threads working for @pool a name, for debuggers and
+ * tools like top. Each thread is called @prefix followed by a dash
+ * and a number; as most systems limit thread names to 15 characters,
+ * @prefix should be short.
+ *
+ * Like g_thread_pool_set_cpu_affinity(), this is applied before the
+ * next task.
+ *
+ * Since: 2.40
+ */
+void
+g_thread_pool_set_thread_name (GThreadPool *pool,
+                               const gchar *prefix)
+{
+  GRealThreadPool *real;
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_if_fail (real);
+  g_return_if_fail (real->running);
+
+  g_async_queue_lock (real->queue);
+
+  g_free (real->thread_name);
+  real->thread_name = g_strdup (prefix);
+  real->thread_index = 0;
+  real->policy_serial++;
+
+  g_async_queue_unlock (real->queue);
+}
+
+/**
+ * g_thread_pool_set_timing_stats:
+ * @pool: a #GThreadPool
+ * @enabled: whether to measure times
+ *
+ * Turns on measuring the times reported by g_thread_pool_get_stats():
+ * how long tasks wait in the queue and how long they run, and how
+ * long the threads of @pool wait for tasks. This costs a couple of
+ * clock reads and a small allocation for each task, so it is off by
+ * default.
+ *
+ * This can only be changed before the first task is pushed to @pool.
+ *
+ * Since: 2.40
+ */
+void
+g_thread_pool_set_timing_stats (GThreadPool *pool,
+                                gboolean     enabled)
+{
+  GRealThreadPool *real;
+  gboolean unused;
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_if_fail (real);
+  g_return_if_fail (real->running);
+
+  g_async_queue_lock (real->queue);
+
+  unused = real->stats.tasks_pushed == 0;
+  if (unused)
+    real->timing = enabled != FALSE;
+
+  g_async_queue_unlock (real->queue);
+
+  g_return_if_fail (unused);
+}
+
+/**
+ * g_thread_pool_get_stats:
+ * @pool: (allow-none): a #GThreadPool, or %NULL
+ * @stats: (out caller-allocates): return location for the stats
+ *
+ * Fills in @stats with what happened in @pool since it was created.
+ * The tasks that are running right now are not accounted for before
+ * they finish. The times are only measured if they were turned on
+ * with g_thread_pool_set_timing_stats(); otherwise they are 0.
+ *
+ * If @pool is %NULL, the stats of the unused threads that GLib keeps
+ * for all non-exclusive pools are returned instead: the threads that
+ * were started and that exited, in #GThreadPoolStats.threads_started
+ * and #GThreadPoolStats.threads_exited, and how long they were unused,
+ * as #GThreadPoolStats.idle_time. #GThreadPoolStats.tasks_pushed
+ * counts how often an unused thread was handed to a pool and
+ * #GThreadPoolStats.tasks_completed how often an unused thread
+ * picked up such a request.
+ *
+ * Since: 2.40
+ */
+void
+g_thread_pool_get_stats (GThreadPool      *pool,
+                         GThreadPoolStats *stats)
+{
+  GRealThreadPool *real;
+
+  g_return_if_fail (stats != NULL);
+
+  if (pool == NULL)
+    {
+      G_LOCK (unused_stats);
+      *stats = unused_stats;
+      G_UNLOCK (unused_stats);
+      return;
+    }
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_if_fail (real->running);
+
+  g_async_queue_lock (real->queue);
+  *stats = real->stats;
+  g_async_queue_unlock (real->queue);
+}
+
 /**
  * g_thread_pool_set_max_idle_time:
  * @interval: the maximum @interval (in milliseconds)
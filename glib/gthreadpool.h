@@ -36,6 +36,7 @@
 G_BEGIN_DECLS
 
 typedef struct _GThreadPool GThreadPool;
+typedef struct _GThreadPoolStats GThreadPoolStats;
 
 /* Thread Pools
  */
@@ -47,6 +48,24 @@ struct _GThreadPool
   gboolean exclusive;
 };
 
+#define G_THREAD_POOL_STATS_N_BUCKETS 24
+
+struct _GThreadPoolStats
+{
+  guint64 tasks_pushed;
+  guint64 tasks_completed;
+  guint64 threads_started;
+  guint64 threads_exited;
+  guint64 run_time;
+  guint64 idle_time;
+  guint64 wait_time;
+  guint64 max_wait_time;
+  guint64 wait_histogram[G_THREAD_POOL_STATS_N_BUCKETS];
+
+  /*< private >*/
+  guint64 padding[8];
+};
+
 GLIB_AVAILABLE_IN_ALL
 GThreadPool *   g_thread_pool_new               (GFunc            func,
                                                  gpointer         user_data,
@@ -61,12 +80,35 @@ GLIB_AVAILABLE_IN_ALL
 gboolean        g_thread_pool_push              (GThreadPool     *pool,
                                                  gpointer         data,
                                                  GError         **error);
+GLIB_AVAILABLE_IN_2_40
+gboolean        g_thread_pool_push_many         (GThreadPool     *pool,
+                                                 gpointer        *data,
+                                                 guint            n_data,
+                                                 GError         **error);
 GLIB_AVAILABLE_IN_ALL
 guint           g_thread_pool_unprocessed       (GThreadPool     *pool);
 GLIB_AVAILABLE_IN_ALL
 void            g_thread_pool_set_sort_function (GThreadPool      *pool,
                                                  GCompareDataFunc  func,
                                                  gpointer          user_data);
+GLIB_AVAILABLE_IN_2_40
+void            g_thread_pool_set_cpu_affinity  (GThreadPool      *pool,
+                                                 const guint      *cpus,
+                                                 guint             n_cpus,
+                                                 gboolean          spread);
+GLIB_AVAILABLE_IN_2_40
+void            g_thread_pool_set_thread_priority (GThreadPool    *pool,
+                                                 gboolean          set,
+                                                 gint              priority);
+GLIB_AVAILABLE_IN_2_40
+void            g_thread_pool_set_thread_name   (GThreadPool      *pool,
+                                                 const gchar      *prefix);
+GLIB_AVAILABLE_IN_2_40
+void            g_thread_pool_set_timing_stats  (GThreadPool      *pool,
+                                                 gboolean          enabled);
+GLIB_AVAILABLE_IN_2_40
+void            g_thread_pool_get_stats         (GThreadPool      *pool,
+                                                 GThreadPoolStats *stats);
 GLIB_AVAILABLE_IN_ALL
 gboolean        g_thread_pool_set_max_threads   (GThreadPool     *pool,
                                                  gint             max_threads,
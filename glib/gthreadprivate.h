@@ -36,6 +36,58 @@ struct  _GRealThread
   gpointer retval;
 };
 
+/* G_PRIVATE_TLS_DEFINE_STATIC (Type, name, notify) defines a GPrivate
+ * holding a pointer of type @Type, for per-thread state on hot paths,
+ * and the name_get() and name_set() functions to access it.
+ *
+ * Where the compiler supports it, the value is cached in a __thread
+ * variable in the static TLS block.  Reading it is then a single load
+ * instead of a pthread_getspecific().  The GPrivate is still set, so
+ * that @notify (which may be %NULL) runs when the thread exits.  The
+ * cache is cleared just before that, so code running later in the
+ * thread's exit gets %NULL, as it would from g_private_get().
+ */
+#ifdef HAVE_TLS
+#define G_THREAD_LOCAL __thread __attribute__((tls_model ("initial-exec")))
+
+#define G_PRIVATE_TLS_DEFINE_STATIC(Type, name, notify)                 \
+  static G_THREAD_LOCAL Type name##_tls;                                \
+  static void                                                           \
+  name##_tls_notify (gpointer data)                                     \
+  {                                                                     \
+    GDestroyNotify name##_notify = (notify);                            \
+                                                                        \
+    name##_tls = NULL;                                                  \
+    if (name##_notify != NULL)                                          \
+      name##_notify (data);                                             \
+  }                                                                     \
+  static GPrivate name##_private = G_PRIVATE_INIT (name##_tls_notify);  \
+  static inline Type                                                    \
+  name##_get (void)                                                     \
+  {                                                                     \
+    return name##_tls;                                                  \
+  }                                                                     \
+  static inline void                                                    \
+  name##_set (Type value)                                               \
+  {                                                                     \
+    name##_tls = value;                                                 \
+    g_private_set (&name##_private, value);                             \
+  }
+#else
+#define G_PRIVATE_TLS_DEFINE_STATIC(Type, name, notify)                 \
+  static GPrivate name##_private = G_PRIVATE_INIT (notify);             \
+  static inline Type                                                    \
+  name##_get (void)                                                     \
+  {                                                                     \
+    return g_private_get (&name##_private);                             \
+  }                                                                     \
+  static inline void                                                    \
+  name##_set (Type value)                                               \
+  {                                                                     \
+    g_private_set (&name##_private, value);                             \
+  }
+#endif
+
 /* system thread implementation (gthread-posix.c, gthread-win32.c) */
 void            g_system_thread_wait            (GRealThread  *thread);
 
@@ -34,6 +34,7 @@
 #include "gfileutils.h"
 #include "gstrfuncs.h"
 #include "ghash.h"
+#include "gqueue.h"
 #include "gthread.h"
 #include "gbytes.h"
 #include "gslice.h"
@@ -187,11 +188,19 @@ struct _GTimeZone
   GArray  *t_info;         /* Array of TransitionInfo */
   GArray  *transitions;    /* Array of Transition */
   gint     ref_count;
+  guint    last_interval;  /* hint for find_universal_interval() */
 };
 
 G_LOCK_DEFINE_STATIC (time_zones);
 static GHashTable/*<string?, GTimeZone>*/ *time_zones;
 
+/* The most recently requested named zones, each holding a reference,
+ * so that creating and dropping the same few zones over and over
+ * doesn't reparse their tzfiles every time.  Protected by time_zones.
+ */
+#define RECENT_TIME_ZONES 32
+static GQueue/*<GTimeZone>*/ recent_time_zones = G_QUEUE_INIT;
+
 #define MIN_TZYEAR 1916 /* Daylight Savings started in WWI */
 #define MAX_TZYEAR 2999 /* And it's not likely ever to go away, but
                            there's no point in getting carried
@@ -1296,6 +1305,36 @@ rules_from_identifier (const gchar   *identifier,
 }
 
 /* Construction {{{1 */
+/* Moves @tz to the front of the recently used zones, taking a
+ * reference if it wasn't there yet.  Returns the zone that dropped off
+ * the end, if any; the caller must unref it after releasing the lock.
+ */
+static GTimeZone *
+keep_recent_time_zone (GTimeZone *tz)
+{
+  GList *link;
+
+  link = g_queue_find (&recent_time_zones, tz);
+  if (link != NULL)
+    {
+      if (link != recent_time_zones.head)
+        {
+          g_queue_unlink (&recent_time_zones, link);
+          g_queue_push_head_link (&recent_time_zones, link);
+        }
+
+      return NULL;
+    }
+
+  g_atomic_int_inc (&tz->ref_count);
+  g_queue_push_head (&recent_time_zones, tz);
+
+  if (recent_time_zones.length > RECENT_TIME_ZONES)
+    return g_queue_pop_tail (&recent_time_zones);
+
+  return NULL;
+}
+
 /**
  * g_time_zone_new:
  * @identifier: (allow-none): a timezone identifier
@@ -1374,6 +1413,7 @@ GTimeZone *
 g_time_zone_new (const gchar *identifier)
 {
   GTimeZone *tz = NULL;
+  GTimeZone *evicted = NULL;
   TimeZoneRule *rules;
   gint rules_num;
 
@@ -1387,7 +1427,12 @@ g_time_zone_new (const gchar *identifier)
       if (tz)
         {
           g_atomic_int_inc (&tz->ref_count);
+          evicted = keep_recent_time_zone (tz);
           G_UNLOCK (time_zones);
+
+          if (evicted)
+            g_time_zone_unref (evicted);
+
           return tz;
         }
     }
@@ -1452,14 +1497,20 @@ g_time_zone_new (const gchar *identifier)
 #endif
     }
 
+  g_atomic_int_inc (&tz->ref_count);
   if (tz->t_info != NULL)
     {
       if (identifier)
-        g_hash_table_insert (time_zones, tz->name, tz);
+        {
+          g_hash_table_insert (time_zones, tz->name, tz);
+          evicted = keep_recent_time_zone (tz);
+        }
     }
-  g_atomic_int_inc (&tz->ref_count);
   G_UNLOCK (time_zones);
 
+  if (evicted)
+    g_time_zone_unref (evicted);
+
   return tz;
 }
 
@@ -1562,6 +1613,38 @@ interval_end (GTimeZone *tz,
   return G_MAXINT64;
 }
 
+/* Returns the interval containing @time_ in UTC: the first one that
+ * ends at or after it.  Lookups tend to come in runs for nearby times,
+ * so the interval found last time is checked before searching.
+ */
+static guint
+find_universal_interval (GTimeZone *tz,
+                         gint64     time_)
+{
+  guint hint, lo, hi;
+
+  hint = g_atomic_int_get (&tz->last_interval);
+  if (hint <= tz->transitions->len &&
+      interval_start (tz, hint) <= time_ && time_ <= interval_end (tz, hint))
+    return hint;
+
+  lo = 0;
+  hi = tz->transitions->len;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (time_ < TRANSITION(mid).time)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+
+  g_atomic_int_set (&tz->last_interval, lo);
+
+  return lo;
+}
+
 inline static gint32
 interval_offset (GTimeZone *tz,
                  guint      interval)
@@ -1673,11 +1756,8 @@ g_time_zone_adjust_time (GTimeZone *tz,
 
   intervals = tz->transitions->len;
 
-  /* find the interval containing *time UTC
-   * TODO: this could be binary searched (or better) */
-  for (i = 0; i <= intervals; i++)
-    if (*time_ <= interval_end (tz, i))
-      break;
+  /* find the interval containing *time UTC */
+  i = find_universal_interval (tz, *time_);
 
   g_assert (interval_start (tz, i) <= *time_ && *time_ <= interval_end (tz, i));
 
@@ -1764,9 +1844,7 @@ g_time_zone_find_interval (GTimeZone *tz,
   if (tz->transitions == NULL)
     return 0;
   intervals = tz->transitions->len;
-  for (i = 0; i <= intervals; i++)
-    if (time_ <= interval_end (tz, i))
-      break;
+  i = find_universal_interval (tz, time_);
 
   if (type == G_TIME_TYPE_UNIVERSAL)
     return i;
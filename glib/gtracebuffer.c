@@ -0,0 +1,373 @@
+/*
+ * Copyright © 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include "gtracebuffer.h"
+
+#include "genviron.h"
+#include "gfileutils.h"
+#include "gmain.h"
+#include "gmem.h"
+#include "gmessages.h"
+#include "gstrfuncs.h"
+#include "gstring.h"
+#include "gthread.h"
+#include "gunicode.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+
+/* An in-process event recorder for when dtrace/systemtap (see
+ * glib_trace.h) is not available.
+ *
+ * It is enabled by setting G_TRACE_BUFFER to a filename.  Every thread
+ * that records an event gets its own fixed-size ring buffer, so
+ * recording takes no locks: only the owning thread ever writes to a
+ * buffer, and once it is full the oldest events are overwritten.  The
+ * buffers are written to the file when the process exits, as a Chrome
+ * trace (chrome://tracing) if the filename ends in ".json" and in the
+ * compact binary format below otherwise.
+ *
+ * The binary format is in host byte order: the 8 byte magic
+ * "GLIBTRCE", the event size and the number of threads as guint32,
+ * then for every thread its index and its number of events as guint32
+ * followed by that many GTraceEvent records, oldest first.
+ */
+
+#define TRACE_BUFFER_MAGIC         "GLIBTRCE"
+#define TRACE_BUFFER_DEFAULT_SIZE  16384
+#define TRACE_BUFFER_MIN_SIZE      64
+#define TRACE_BUFFER_MAX_SIZE      (1 << 24)
+#define TRACE_EVENT_NAME_LEN       30
+
+typedef struct
+{
+  guint64 timestamp;    /* monotonic, in nanoseconds */
+  guint64 object;
+  gint64  arg;
+  guint8  type;
+  guint8  phase;
+  gchar   name[TRACE_EVENT_NAME_LEN];
+} GTraceEvent;
+
+G_STATIC_ASSERT (sizeof (GTraceEvent) == 56);
+
+typedef struct _GTraceBuffer GTraceBuffer;
+
+struct _GTraceBuffer
+{
+  GTraceBuffer *next;
+  guint         thread_index;
+  guint64       position;
+  GTraceEvent   events[1];
+};
+
+static const gchar * const trace_event_kinds[] = {
+  "dispatch", "poll", "task-new", "task-return", "task-callback",
+  "emit", "ref", "unref"
+};
+
+static const gchar * const trace_event_categories[] = {
+  "source", "poll", "task", "task", "task",
+  "signal", "object", "object"
+};
+
+static gchar        *trace_filename;
+static guint         trace_buffer_size;  /* a power of two */
+static GMutex        trace_buffers_lock;
+static GTraceBuffer *trace_buffers;
+static guint         trace_n_threads;
+
+/* No destroy notify: the events of threads that have exited are kept
+ * until the buffers are dumped.
+ */
+static GPrivate      trace_buffer_private;
+
+static void
+g_trace_buffer_dump_at_exit (void)
+{
+  GError *error = NULL;
+
+  if (!g_trace_buffer_dump (trace_filename, &error))
+    {
+      g_printerr ("GLib: failed to write trace buffer: %s\n", error->message);
+      g_error_free (error);
+    }
+}
+
+/*
+ * g_trace_buffer_enabled:
+ *
+ * Returns whether G_TRACE_BUFFER was set when this was first called.
+ * Callers check this before g_trace_buffer_record(), so that recording
+ * costs nothing but a branch when tracing is off.
+ */
+gboolean
+g_trace_buffer_enabled (void)
+{
+  static gsize initialised;
+  static gboolean enabled;
+
+  if (g_once_init_enter (&initialised))
+    {
+      const gchar *filename;
+      const gchar *size_string;
+      guint size;
+
+      filename = g_getenv ("G_TRACE_BUFFER");
+      if (filename != NULL && filename[0] != '\0')
+        {
+          size = TRACE_BUFFER_DEFAULT_SIZE;
+          size_string = g_getenv ("G_TRACE_BUFFER_SIZE");
+          if (size_string != NULL)
+            size = CLAMP (strtoul (size_string, NULL, 10),
+                          TRACE_BUFFER_MIN_SIZE, TRACE_BUFFER_MAX_SIZE);
+
+          trace_buffer_size = TRACE_BUFFER_MIN_SIZE;
+          while (trace_buffer_size < size)
+            trace_buffer_size <<= 1;
+
+          trace_filename = g_strdup (filename);
+          atexit (g_trace_buffer_dump_at_exit);
+          enabled = TRUE;
+        }
+
+      g_once_init_leave (&initialised, 1);
+    }
+
+  return enabled;
+}
+
+static guint64
+trace_now (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (guint64) ts.tv_sec * G_GUINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+  return (guint64) g_get_monotonic_time () * 1000;
+#endif
+}
+
+static GTraceBuffer *
+trace_buffer_new_for_thread (void)
+{
+  GTraceBuffer *buffer;
+
+  buffer = g_malloc0 (G_STRUCT_OFFSET (GTraceBuffer, events) +
+                      trace_buffer_size * sizeof (GTraceEvent));
+
+  g_mutex_lock (&trace_buffers_lock);
+  buffer->thread_index = trace_n_threads++;
+  buffer->next = trace_buffers;
+  trace_buffers = buffer;
+  g_mutex_unlock (&trace_buffers_lock);
+
+  g_private_set (&trace_buffer_private, buffer);
+
+  return buffer;
+}
+
+/*
+ * g_trace_buffer_record:
+ * @type: what happened
+ * @phase: whether this begins or ends a span, or is a single instant
+ * @name: (allow-none): the source, signal or type name.  At most
+ *     TRACE_EVENT_NAME_LEN - 1 bytes of it are kept.
+ * @object: the source, task or instance the event is about
+ * @arg: a type-specific value: the poll timeout or the old ref count
+ *
+ * Appends an event to the calling thread's ring buffer.
+ */
+void
+g_trace_buffer_record (GTraceEventType  type,
+                       GTracePhase      phase,
+                       const gchar     *name,
+                       gconstpointer    object,
+                       gint64           arg)
+{
+  GTraceBuffer *buffer;
+  GTraceEvent *event;
+
+  if (trace_buffer_size == 0)
+    return;
+
+  buffer = g_private_get (&trace_buffer_private);
+  if (G_UNLIKELY (buffer == NULL))
+    buffer = trace_buffer_new_for_thread ();
+
+  event = &buffer->events[buffer->position & (trace_buffer_size - 1)];
+  event->timestamp = trace_now ();
+  event->object = GPOINTER_TO_SIZE (object);
+  event->arg = arg;
+  event->type = type;
+  event->phase = phase;
+  if (name != NULL)
+    strncpy (event->name, name, TRACE_EVENT_NAME_LEN - 1);
+  else
+    event->name[0] = '\0';
+  event->name[TRACE_EVENT_NAME_LEN - 1] = '\0';
+
+  buffer->position++;
+}
+
+static void
+trace_append_json_string (GString     *out,
+                          const gchar *str)
+{
+  const gchar *end;
+
+  /* The name may have been cut in the middle of a character */
+  g_utf8_validate (str, -1, &end);
+
+  g_string_append_c (out, '"');
+  for (; str < end; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        g_string_append_printf (out, "\\%c", *str);
+      else if ((guchar) *str < 0x20)
+        g_string_append_printf (out, "\\u%04x", (guchar) *str);
+      else
+        g_string_append_c (out, *str);
+    }
+  g_string_append_c (out, '"');
+}
+
+static void
+trace_append_json_event (GString           *out,
+                         gint               pid,
+                         guint              tid,
+                         const GTraceEvent *event)
+{
+  if (event->type >= G_N_ELEMENTS (trace_event_kinds))
+    return;
+
+  if (out->str[out->len - 1] == '}')
+    g_string_append (out, ",\n");
+
+  g_string_append (out, "{\"name\":");
+  trace_append_json_string (out, event->name[0] ? event->name : trace_event_kinds[event->type]);
+  g_string_append_printf (out, ",\"cat\":\"%s\",\"ph\":\"%c\","
+                          "\"ts\":%" G_GUINT64_FORMAT ".%03u,\"pid\":%d,\"tid\":%u,",
+                          trace_event_categories[event->type], event->phase,
+                          event->timestamp / 1000, (guint) (event->timestamp % 1000),
+                          pid, tid);
+  if (event->phase == G_TRACE_PHASE_INSTANT)
+    g_string_append (out, "\"s\":\"t\",");
+  g_string_append_printf (out, "\"args\":{\"kind\":\"%s\",\"object\":\"0x%" G_GINT64_MODIFIER "x\","
+                          "\"arg\":%" G_GINT64_FORMAT "}}",
+                          trace_event_kinds[event->type], event->object, event->arg);
+}
+
+static void
+trace_append_guint32 (GString *out,
+                      guint32  value)
+{
+  g_string_append_len (out, (const gchar *) &value, sizeof value);
+}
+
+/*
+ * g_trace_buffer_dump:
+ * @filename: the file to write
+ * @error: return location for a #GError
+ *
+ * Writes the events recorded so far by all threads to @filename, in the
+ * format chosen by its suffix.  This is done automatically at exit;
+ * threads still recording while this runs may have their newest events
+ * torn.
+ *
+ * Returns: %TRUE if the file was written
+ */
+gboolean
+g_trace_buffer_dump (const gchar  *filename,
+                     GError      **error)
+{
+  GTraceBuffer *buffer;
+  gboolean json;
+  GString *out;
+  gboolean ret;
+  gint pid;
+
+  json = g_str_has_suffix (filename, ".json");
+#ifdef G_OS_UNIX
+  pid = getpid ();
+#else
+  pid = 0;
+#endif
+
+  out = g_string_new (NULL);
+  if (json)
+    g_string_append (out, "{\"traceEvents\":[\n");
+  else
+    {
+      g_string_append_len (out, TRACE_BUFFER_MAGIC, 8);
+      trace_append_guint32 (out, sizeof (GTraceEvent));
+      trace_append_guint32 (out, 0);
+    }
+
+  g_mutex_lock (&trace_buffers_lock);
+
+  if (!json)
+    {
+      guint32 n_threads = trace_n_threads;
+
+      memcpy (out->str + 12, &n_threads, sizeof n_threads);
+    }
+
+  for (buffer = trace_buffers; buffer != NULL; buffer = buffer->next)
+    {
+      guint64 end = buffer->position;
+      guint64 start = end > trace_buffer_size ? end - trace_buffer_size : 0;
+      guint64 i;
+
+      if (!json)
+        {
+          trace_append_guint32 (out, buffer->thread_index);
+          trace_append_guint32 (out, end - start);
+        }
+
+      for (i = start; i < end; i++)
+        {
+          const GTraceEvent *event = &buffer->events[i & (trace_buffer_size - 1)];
+
+          if (json)
+            trace_append_json_event (out, pid, buffer->thread_index, event);
+          else
+            g_string_append_len (out, (const gchar *) event, sizeof (GTraceEvent));
+        }
+    }
+
+  g_mutex_unlock (&trace_buffers_lock);
+
+  if (json)
+    g_string_append (out, "\n]}\n");
+
+  ret = g_file_set_contents (filename, out->str, out->len, error);
+  g_string_free (out, TRUE);
+
+  return ret;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_TRACE_BUFFER_H__
+#define __G_TRACE_BUFFER_H__
+
+#include <glib/gerror.h>
+
+typedef enum
+{
+  G_TRACE_EVENT_SOURCE_DISPATCH,
+  G_TRACE_EVENT_POLL,
+  G_TRACE_EVENT_TASK_NEW,
+  G_TRACE_EVENT_TASK_RETURN,
+  G_TRACE_EVENT_TASK_CALLBACK,
+  G_TRACE_EVENT_SIGNAL_EMIT,
+  G_TRACE_EVENT_OBJECT_REF,
+  G_TRACE_EVENT_OBJECT_UNREF
+} GTraceEventType;
+
+/* The values are the Chrome trace event phases */
+typedef enum
+{
+  G_TRACE_PHASE_BEGIN   = 'B',
+  G_TRACE_PHASE_END     = 'E',
+  G_TRACE_PHASE_INSTANT = 'i'
+} GTracePhase;
+
+gboolean        g_trace_buffer_enabled  (void);
+void            g_trace_buffer_record   (GTraceEventType  type,
+                                         GTracePhase      phase,
+                                         const gchar     *name,
+                                         gconstpointer    object,
+                                         gint64           arg);
+gboolean        g_trace_buffer_dump     (const gchar     *filename,
+                                         GError         **error);
+
+#endif
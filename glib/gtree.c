@@ -57,7 +57,12 @@
  * get the height of a #GTree, use g_tree_height().
  *
  * To traverse a #GTree, calling a function for each node visited in
- * the traversal, use g_tree_foreach().
+ * the traversal, use g_tree_foreach().  To start the traversal at a
+ * given key, use g_tree_foreach_from().
+ *
+ * To create a #GTree from data that is already sorted, use
+ * g_tree_new_from_sorted(), which is much faster than inserting the
+ * key/value pairs one by one.
  *
  * To remove a key/value pair use g_tree_remove().
  *
@@ -229,6 +234,110 @@ g_tree_new_full (GCompareDataFunc key_compare_func,
   return tree;
 }
 
+static GTreeNode *
+g_tree_node_build (GTreeNode **nodes,
+                   guint       n_nodes,
+                   guint       begin,
+                   guint       end,
+                   gint       *height)
+{
+  GTreeNode *node;
+  gint left_height, right_height;
+  guint mid;
+
+  if (begin == end)
+    {
+      *height = 0;
+      return NULL;
+    }
+
+  mid = begin + (end - begin) / 2;
+  node = nodes[mid];
+
+  /* where there is no child, link to the neighbour in sorted order */
+  node->left = g_tree_node_build (nodes, n_nodes, begin, mid, &left_height);
+  node->left_child = node->left != NULL;
+  if (!node->left_child)
+    node->left = mid > 0 ? nodes[mid - 1] : NULL;
+
+  node->right = g_tree_node_build (nodes, n_nodes, mid + 1, end, &right_height);
+  node->right_child = node->right != NULL;
+  if (!node->right_child)
+    node->right = mid + 1 < n_nodes ? nodes[mid + 1] : NULL;
+
+  node->balance = right_height - left_height;
+  *height = 1 + MAX (left_height, right_height);
+
+  return node;
+}
+
+/**
+ * g_tree_new_from_sorted:
+ * @key_compare_func: qsort()-style comparison function.
+ * @key_compare_data: data to pass to comparison function.
+ * @key_destroy_func: a function to free the memory allocated for the key
+ *   used when removing the entry from the #GTree or %NULL if you don't
+ *   want to supply such a function.
+ * @value_destroy_func: a function to free the memory allocated for the
+ *   value used when removing the entry from the #GTree or %NULL if you
+ *   don't want to supply such a function.
+ * @keys: (array length=n_nodes): the keys, sorted in ascending order
+ *   according to @key_compare_func and without duplicates
+ * @values: (array length=n_nodes) (allow-none): the values for @keys,
+ *   or %NULL to insert %NULL for all of them
+ * @n_nodes: the number of elements in @keys and @values
+ *
+ * Creates a new #GTree like g_tree_new_full() and fills it with the
+ * given key/value pairs.  The tree is built directly in linear time,
+ * without comparing any keys, so @keys must be strictly ascending or
+ * the resulting tree will be broken.
+ *
+ * The tree takes ownership of the keys and values like g_tree_insert()
+ * does.
+ *
+ * Return value: a new #GTree.
+ *
+ * Since: 2.40
+ **/
+GTree *
+g_tree_new_from_sorted (GCompareDataFunc  key_compare_func,
+                        gpointer          key_compare_data,
+                        GDestroyNotify    key_destroy_func,
+                        GDestroyNotify    value_destroy_func,
+                        gpointer         *keys,
+                        gpointer         *values,
+                        guint             n_nodes)
+{
+  GTreeNode **nodes;
+  GTree *tree;
+  gint height;
+  guint i;
+
+  g_return_val_if_fail (key_compare_func != NULL, NULL);
+  g_return_val_if_fail (keys != NULL || n_nodes == 0, NULL);
+
+  tree = g_tree_new_full (key_compare_func, key_compare_data,
+                          key_destroy_func, value_destroy_func);
+  if (n_nodes == 0)
+    return tree;
+
+  /* allocating in order keeps neighbouring nodes close together */
+  nodes = g_new (GTreeNode *, n_nodes);
+  for (i = 0; i < n_nodes; i++)
+    nodes[i] = g_tree_node_new (keys[i], values ? values[i] : NULL);
+
+  tree->root = g_tree_node_build (nodes, n_nodes, 0, n_nodes, &height);
+  tree->nnodes = n_nodes;
+
+  g_free (nodes);
+
+#ifdef G_TREE_DEBUG
+  g_tree_node_check (tree->root);
+#endif
+
+  return tree;
+}
+
 static inline GTreeNode *
 g_tree_first_node (GTree *tree)
 {
@@ -924,6 +1033,65 @@ g_tree_foreach (GTree         *tree,
     }
 }
 
+/**
+ * g_tree_foreach_from:
+ * @tree: a #GTree.
+ * @key: the key to start at.
+ * @func: the function to call for each node visited.
+ *     If this function returns %TRUE, the traversal is stopped.
+ * @user_data: user data to pass to the function.
+ *
+ * Like g_tree_foreach(), but starts with the first key/value pair
+ * whose key is not less than @key, instead of the first one in the
+ * tree.  Finding the start takes O(log n), so this is an efficient way
+ * to walk a range of keys: return %TRUE from @func once the end of the
+ * range has been passed.
+ *
+ * Since: 2.40
+ **/
+void
+g_tree_foreach_from (GTree         *tree,
+                     gconstpointer  key,
+                     GTraverseFunc  func,
+                     gpointer       user_data)
+{
+  GTreeNode *node, *lower_bound = NULL;
+  gint cmp;
+
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (func != NULL);
+
+  node = tree->root;
+  while (node)
+    {
+      cmp = tree->key_compare (key, node->key, tree->key_compare_data);
+      if (cmp == 0)
+        {
+          lower_bound = node;
+          break;
+        }
+      else if (cmp < 0)
+        {
+          lower_bound = node;
+          if (!node->left_child)
+            break;
+          node = node->left;
+        }
+      else
+        {
+          if (!node->right_child)
+            break;
+          node = node->right;
+        }
+    }
+
+  for (node = lower_bound; node; node = g_tree_node_next (node))
+    {
+      if ((*func) (node->key, node->value, user_data))
+        break;
+    }
+}
+
 /**
  * g_tree_traverse:
  * @tree: a #GTree.
@@ -53,6 +53,14 @@ GTree*   g_tree_new_full        (GCompareDataFunc  key_compare_func,
                                  gpointer          key_compare_data,
                                  GDestroyNotify    key_destroy_func,
                                  GDestroyNotify    value_destroy_func);
+GLIB_AVAILABLE_IN_2_40
+GTree*   g_tree_new_from_sorted (GCompareDataFunc  key_compare_func,
+                                 gpointer          key_compare_data,
+                                 GDestroyNotify    key_destroy_func,
+                                 GDestroyNotify    value_destroy_func,
+                                 gpointer         *keys,
+                                 gpointer         *values,
+                                 guint             n_nodes);
 GLIB_AVAILABLE_IN_ALL
 GTree*   g_tree_ref             (GTree            *tree);
 GLIB_AVAILABLE_IN_ALL
@@ -85,6 +93,11 @@ GLIB_AVAILABLE_IN_ALL
 void     g_tree_foreach         (GTree            *tree,
                                  GTraverseFunc	   func,
                                  gpointer	   user_data);
+GLIB_AVAILABLE_IN_2_40
+void     g_tree_foreach_from    (GTree            *tree,
+                                 gconstpointer     key,
+                                 GTraverseFunc     func,
+                                 gpointer          user_data);
 
 GLIB_DEPRECATED
 void     g_tree_traverse        (GTree            *tree,
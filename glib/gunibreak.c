@@ -23,6 +23,7 @@
 #include <stdlib.h>
 
 #include "gunibreak.h"
+#include "gmessages.h"
 
 #define TPROP_PART1(Page, Char) \
   ((break_property_table_part1[Page] >= G_UNICODE_MAX_TABLE_INDEX) \
@@ -41,6 +42,14 @@
       ? TPROP_PART2 (((Char) - 0xe0000) >> 8, (Char) & 0xff) \
       : G_UNICODE_BREAK_UNKNOWN))
 
+/* Page 0 is never uniform, so break_property_table_part1[0] is always an
+ * index into break_property_data, and that row is a direct lookup table
+ * for U+0000 through U+00FF.  The index is a compile-time constant
+ * load, so this costs a single memory access.
+ */
+#define PROP_LATIN1(Char) \
+  (break_property_data[break_property_table_part1[0]][Char])
+
 /**
  * g_unichar_break_type:
  * @c: a Unicode character
@@ -57,5 +66,79 @@
 GUnicodeBreakType
 g_unichar_break_type (gunichar c)
 {
+  if (c < 0x100)
+    return PROP_LATIN1 (c);
+
   return PROP (c);
 }
+
+/**
+ * g_utf8_get_break_types:
+ * @str: a UTF-8 encoded string
+ * @len: the maximum length of @str to use, in bytes.  If @len < 0,
+ *     then the string is nul-terminated.
+ * @types: (out caller-allocates) (array): return location for the
+ *     break types
+ *
+ * Determines the break type of each character in @str, as if by
+ * calling g_unichar_break_type() on each of them in turn.
+ *
+ * @types must have room for at least as many elements as there are
+ * characters in @str; g_utf8_strlen() returns this number, and @len
+ * is always sufficient.  If @len is not negative, only complete
+ * characters within the first @len bytes are classified.
+ *
+ * @str must be valid UTF-8.
+ *
+ * Return value: the number of elements stored in @types
+ *
+ * Since: 2.40
+ */
+gsize
+g_utf8_get_break_types (const gchar       *str,
+                        gssize             len,
+                        GUnicodeBreakType *types)
+{
+  const guchar *p = (const guchar *) str;
+  const guchar *end;
+  gsize n = 0;
+
+  g_return_val_if_fail (str != NULL || len == 0, 0);
+  g_return_val_if_fail (types != NULL || len == 0, 0);
+
+  if (len < 0)
+    {
+      while (*p)
+        {
+          if (*p < 0x80)
+            types[n++] = PROP_LATIN1 (*p++);
+          else
+            {
+              types[n++] = g_unichar_break_type (g_utf8_get_char ((const gchar *) p));
+              p = (const guchar *) g_utf8_next_char (p);
+            }
+        }
+
+      return n;
+    }
+
+  end = p + len;
+  while (p < end)
+    {
+      if (*p < 0x80)
+        types[n++] = PROP_LATIN1 (*p++);
+      else
+        {
+          const guchar *next = (const guchar *) g_utf8_next_char (p);
+
+          /* Don't run off the end with a partial character */
+          if (next > end)
+            break;
+
+          types[n++] = g_unichar_break_type (g_utf8_get_char ((const gchar *) p));
+          p = next;
+        }
+    }
+
+  return n;
+}
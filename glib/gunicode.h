@@ -572,6 +572,10 @@ GUnicodeType g_unichar_type (gunichar c) G_GNUC_CONST;
 /* Return the line break property for a given character */
 GLIB_AVAILABLE_IN_ALL
 GUnicodeBreakType g_unichar_break_type (gunichar c) G_GNUC_CONST;
+GLIB_AVAILABLE_IN_2_40
+gsize g_utf8_get_break_types (const gchar       *str,
+                              gssize             len,
+                              GUnicodeBreakType *types);
 
 /* Returns the combining class for a given character */
 GLIB_AVAILABLE_IN_ALL
@@ -754,6 +758,16 @@ GLIB_AVAILABLE_IN_ALL
 gchar *g_utf8_casefold (const gchar *str,
                         gssize       len) G_GNUC_MALLOC;
 
+GLIB_AVAILABLE_IN_2_40
+gboolean g_utf8_strup_in_place    (gchar  *str,
+                                   gssize  len);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_utf8_strdown_in_place  (gchar  *str,
+                                   gssize  len);
+GLIB_AVAILABLE_IN_2_40
+gboolean g_utf8_casefold_in_place (gchar  *str,
+                                   gssize  len);
+
 /**
  * GNormalizeMode:
  * @G_NORMALIZE_DEFAULT: standardize differences that do not affect the
@@ -804,6 +818,26 @@ GLIB_AVAILABLE_IN_ALL
 gchar *g_utf8_collate_key_for_filename (const gchar *str,
                                         gssize       len) G_GNUC_MALLOC;
 
+typedef struct _GCollator GCollator;
+
+GLIB_AVAILABLE_IN_2_40
+GCollator *g_collator_new                      (void);
+GLIB_AVAILABLE_IN_2_40
+void       g_collator_free                     (GCollator          *collator);
+GLIB_AVAILABLE_IN_2_40
+gchar     *g_collator_collate_key              (GCollator          *collator,
+                                                const gchar        *str,
+                                                gssize              len) G_GNUC_MALLOC;
+GLIB_AVAILABLE_IN_2_40
+gchar     *g_collator_collate_key_for_filename (GCollator          *collator,
+                                                const gchar        *str,
+                                                gssize              len) G_GNUC_MALLOC;
+GLIB_AVAILABLE_IN_2_40
+gchar    **g_collator_collate_keys             (GCollator          *collator,
+                                                const gchar * const *strs,
+                                                gssize              n_strs,
+                                                gboolean            for_filename) G_GNUC_MALLOC;
+
 
 /* private */
 gchar *_g_utf8_make_valid (const gchar *name);
@@ -31,6 +31,7 @@
 #endif
 
 #include "gmem.h"
+#include "gslice.h"
 #include "gunicode.h"
 #include "gunicodeprivate.h"
 #include "gstring.h"
@@ -41,6 +42,16 @@
 #include "gconvert.h"
 #endif
 
+#if defined (HAVE_NEWLOCALE) && defined (HAVE_USELOCALE) && \
+    defined (__STDC_ISO_10646__) && !defined (HAVE_CARBON)
+#define USE_XLOCALE 1
+#endif
+
+#if defined (USE_XLOCALE) && defined (HAVE_XLOCALE_H)
+/* Needed on BSD/OS X for newlocale() */
+#include <xlocale.h>
+#endif
+
 
 #ifdef _MSC_VER
 /* Workaround for bug in MSVCR80.DLL */
@@ -351,6 +362,32 @@ carbon_collate_key_for_filename (const gchar *str,
 
 #endif /* HAVE_CARBON */
 
+#if defined(__STDC_ISO_10646__) && !defined(HAVE_CARBON)
+static gboolean
+collation_is_code_point_order (const gchar *locale)
+{
+  return locale != NULL &&
+         (strcmp (locale, "C") == 0 || strcmp (locale, "POSIX") == 0);
+}
+
+/* In the C locale wcsxfrm() leaves the characters alone, so the
+ * collation key is just the normalized string, and ASCII is already
+ * normalized.  Returns %NULL if @str isn't valid UTF-8.
+ */
+static gchar *
+code_point_collate_key (const gchar *str,
+                        gssize       len)
+{
+  const gchar *p;
+
+  for (p = str; (len < 0 || p < str + len) && *p; p++)
+    if ((guchar) *p >= 0x80)
+      return g_utf8_normalize (str, len, G_NORMALIZE_ALL_COMPOSE);
+
+  return g_strndup (str, p - str);
+}
+#endif /* __STDC_ISO_10646__ && !HAVE_CARBON */
+
 /**
  * g_utf8_collate_key:
  * @str: a UTF-8 encoded string.
@@ -391,6 +428,13 @@ g_utf8_collate_key (const gchar *str,
 
   g_return_val_if_fail (str != NULL, NULL);
 
+  if (collation_is_code_point_order (setlocale (LC_COLLATE, NULL)))
+    {
+      result = code_point_collate_key (str, len);
+      if (result)
+        return result;
+    }
+
   str_norm = _g_utf8_normalize_wc (str, len, G_NORMALIZE_ALL_COMPOSE);
 
   xfrm_len = wcsxfrm (NULL, (wchar_t *)str_norm, 0);
@@ -470,47 +514,159 @@ g_utf8_collate_key (const gchar *str,
   return result;
 }
 
-/* This is a collation key that is very very likely to sort before any
-   collation key that libc strxfrm generates. We use this before any
-   special case (dot or number) to make sure that its sorted before
-   anything else.
- */
-#define COLLATION_SENTINEL "\1\1\1"
+struct _GCollator
+{
+  gboolean code_point_order;
+#ifdef USE_XLOCALE
+  locale_t locale;
+#endif
+  gunichar *wc;		/* scratch space for normalized ASCII */
+  gsize wc_size;
+  wchar_t *xfrm;	/* scratch space for wcsxfrm() */
+  gsize xfrm_size;
+  GString *key;
+};
 
 /**
- * g_utf8_collate_key_for_filename:
- * @str: a UTF-8 encoded string.
- * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ * GCollator:
  *
- * Converts a string into a collation key that can be compared
- * with other collation keys produced by the same function using strcmp(). 
- * 
- * In order to sort filenames correctly, this function treats the dot '.' 
- * as a special case. Most dictionary orderings seem to consider it
- * insignificant, thus producing the ordering "event.c" "eventgenerator.c"
- * "event.h" instead of "event.c" "event.h" "eventgenerator.c". Also, we
- * would like to treat numbers intelligently so that "file1" "file10" "file5"
- * is sorted as "file1" "file5" "file10".
- * 
- * Note that this function depends on the 
- * <link linkend="setlocale">current locale</link>.
+ * An opaque structure holding what g_utf8_collate_key() would look up
+ * for every string, plus scratch space, so that collation keys for many
+ * strings can be computed more cheaply.
  *
- * Return value: a newly allocated string. This string should
- *   be freed with g_free() when you are done with it.
+ * A #GCollator must only be used by one thread at a time.
  *
- * Since: 2.8
+ * Since: 2.40
  */
-gchar*
-g_utf8_collate_key_for_filename (const gchar *str,
-				 gssize       len)
+
+static void
+collator_append_key (GCollator   *collator,
+		     const gchar *str,
+		     gssize       len,
+		     GString     *result)
 {
+#if defined(__STDC_ISO_10646__) && !defined(HAVE_CARBON)
+  gunichar *str_norm;
+  gsize ascii_len;
+  gsize xfrm_len;
+  gsize old_len;
+  gchar *p;
+  gsize i;
+#ifdef USE_XLOCALE
+  locale_t old_locale = (locale_t) 0;
+#endif
+
+  for (ascii_len = 0; (len < 0 || ascii_len < (gsize) len) && str[ascii_len]; ascii_len++)
+    if ((guchar) str[ascii_len] >= 0x80)
+      break;
+
+  if ((len >= 0 && ascii_len == (gsize) len) || str[ascii_len] == '\0')
+    {
+      /* ASCII is already normalized */
+      if (collator->code_point_order)
+        {
+          g_string_append_len (result, str, ascii_len);
+          return;
+        }
+
+      if (ascii_len >= collator->wc_size)
+        {
+          collator->wc_size = MAX (ascii_len + 1, collator->wc_size * 2);
+          collator->wc = g_renew (gunichar, collator->wc, collator->wc_size);
+        }
+      for (i = 0; i < ascii_len; i++)
+        collator->wc[i] = str[i];
+      collator->wc[ascii_len] = 0;
+      str_norm = collator->wc;
+    }
+  else
+    {
+      if (collator->code_point_order)
+        {
+          gchar *key = g_utf8_normalize (str, len, G_NORMALIZE_ALL_COMPOSE);
+
+          if (key)
+            {
+              g_string_append (result, key);
+              g_free (key);
+              return;
+            }
+        }
+
+      str_norm = _g_utf8_normalize_wc (str, len, G_NORMALIZE_ALL_COMPOSE);
+    }
+
+#ifdef USE_XLOCALE
+  if (collator->locale != (locale_t) 0)
+    old_locale = uselocale (collator->locale);
+#endif
+
+  xfrm_len = wcsxfrm (collator->xfrm, (wchar_t *)str_norm, collator->xfrm_size);
+  if (xfrm_len >= collator->xfrm_size)
+    {
+      collator->xfrm_size = MAX (xfrm_len + 1, collator->xfrm_size * 2);
+      collator->xfrm = g_renew (wchar_t, collator->xfrm, collator->xfrm_size);
+      wcsxfrm (collator->xfrm, (wchar_t *)str_norm, collator->xfrm_size);
+    }
+
+#ifdef USE_XLOCALE
+  if (old_locale != (locale_t) 0)
+    uselocale (old_locale);
+#endif
+
+  /* utf8_encode() writes at most 6 bytes per value */
+  old_len = result->len;
+  g_string_set_size (result, old_len + 6 * xfrm_len);
+  p = result->str + old_len;
+  for (i = 0; i < xfrm_len; i++)
+    p += utf8_encode (p, collator->xfrm[i]);
+  g_string_truncate (result, p - result->str);
+
+  if (str_norm != collator->wc)
+    g_free (str_norm);
+#else
+  gchar *key = g_utf8_collate_key (str, len);
+
+  g_string_append (result, key);
+  g_free (key);
+#endif
+}
+
+/* This is a collation key that is very very likely to sort before any
+   collation key that libc strxfrm generates. We use this before any
+   special case (dot or number) to make sure that its sorted before
+   anything else.
+ */
+#define COLLATION_SENTINEL "\1\1\1"
+
 #ifndef HAVE_CARBON
+static void
+append_collate_key (GCollator   *collator,
+		    const gchar *str,
+		    gssize       len,
+		    GString     *result)
+{
+  if (collator)
+    collator_append_key (collator, str, len, result);
+  else
+    {
+      gchar *collate_key = g_utf8_collate_key (str, len);
+
+      g_string_append (result, collate_key);
+      g_free (collate_key);
+    }
+}
+
+static gchar *
+collate_key_for_filename (GCollator   *collator,
+			  const gchar *str,
+			  gssize       len)
+{
   GString *result;
   GString *append;
   const gchar *p;
   const gchar *prev;
   const gchar *end;
-  gchar *collate_key;
   gint digits;
   gint leading_zeros;
 
@@ -575,11 +731,7 @@ g_utf8_collate_key_for_filename (const gchar *str,
 	{
 	case '.':
 	  if (prev != p) 
-	    {
-	      collate_key = g_utf8_collate_key (prev, p - prev);
-	      g_string_append (result, collate_key);
-	      g_free (collate_key);
-	    }
+	    append_collate_key (collator, prev, p - prev, result);
 	  
 	  g_string_append (result, COLLATION_SENTINEL "\1");
 	  
@@ -598,11 +750,7 @@ g_utf8_collate_key_for_filename (const gchar *str,
 	case '8':
 	case '9':
 	  if (prev != p) 
-	    {
-	      collate_key = g_utf8_collate_key (prev, p - prev);
-	      g_string_append (result, collate_key);
-	      g_free (collate_key);
-	    }
+	    append_collate_key (collator, prev, p - prev, result);
 	  
 	  g_string_append (result, COLLATION_SENTINEL "\2");
 	  
@@ -666,17 +814,211 @@ g_utf8_collate_key_for_filename (const gchar *str,
     }
   
   if (prev != p) 
-    {
-      collate_key = g_utf8_collate_key (prev, p - prev);
-      g_string_append (result, collate_key);
-      g_free (collate_key);
-    }
+    append_collate_key (collator, prev, p - prev, result);
   
   g_string_append (result, append->str);
   g_string_free (append, TRUE);
 
   return g_string_free (result, FALSE);
+}
+#endif /* !HAVE_CARBON */
+
+/**
+ * g_utf8_collate_key_for_filename:
+ * @str: a UTF-8 encoded string.
+ * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ *
+ * Converts a string into a collation key that can be compared
+ * with other collation keys produced by the same function using strcmp(). 
+ * 
+ * In order to sort filenames correctly, this function treats the dot '.' 
+ * as a special case. Most dictionary orderings seem to consider it
+ * insignificant, thus producing the ordering "event.c" "eventgenerator.c"
+ * "event.h" instead of "event.c" "event.h" "eventgenerator.c". Also, we
+ * would like to treat numbers intelligently so that "file1" "file10" "file5"
+ * is sorted as "file1" "file5" "file10".
+ * 
+ * Note that this function depends on the 
+ * <link linkend="setlocale">current locale</link>.
+ *
+ * Return value: a newly allocated string. This string should
+ *   be freed with g_free() when you are done with it.
+ *
+ * Since: 2.8
+ */
+gchar*
+g_utf8_collate_key_for_filename (const gchar *str,
+				 gssize       len)
+{
+#ifndef HAVE_CARBON
+  return collate_key_for_filename (NULL, str, len);
 #else /* HAVE_CARBON */
   return carbon_collate_key_for_filename (str, len);
 #endif
 }
+
+/**
+ * g_collator_new:
+ *
+ * Creates a new #GCollator for the collation rules of the
+ * <link linkend="setlocale">current locale</link>.  Where the platform
+ * allows it, the collator keeps using these rules even if the locale
+ * is changed later.
+ *
+ * The keys generated by a #GCollator are the same as the ones
+ * g_utf8_collate_key() and g_utf8_collate_key_for_filename() return in
+ * the locale the collator was created in.
+ *
+ * Return value: a new #GCollator. Use g_collator_free() to free it.
+ *
+ * Since: 2.40
+ */
+GCollator *
+g_collator_new (void)
+{
+  GCollator *collator;
+
+  collator = g_slice_new0 (GCollator);
+  collator->key = g_string_new (NULL);
+
+#if defined(__STDC_ISO_10646__) && !defined(HAVE_CARBON)
+  {
+    const gchar *locale = setlocale (LC_COLLATE, NULL);
+
+    collator->code_point_order = collation_is_code_point_order (locale);
+#ifdef USE_XLOCALE
+    if (!collator->code_point_order && locale != NULL)
+      collator->locale = newlocale (LC_COLLATE_MASK, locale, (locale_t) 0);
+#endif
+  }
+#endif
+
+  return collator;
+}
+
+/**
+ * g_collator_free:
+ * @collator: a #GCollator
+ *
+ * Frees @collator.
+ *
+ * Since: 2.40
+ */
+void
+g_collator_free (GCollator *collator)
+{
+  g_return_if_fail (collator != NULL);
+
+#ifdef USE_XLOCALE
+  if (collator->locale != (locale_t) 0)
+    freelocale (collator->locale);
+#endif
+  g_free (collator->wc);
+  g_free (collator->xfrm);
+  g_string_free (collator->key, TRUE);
+  g_slice_free (GCollator, collator);
+}
+
+/**
+ * g_collator_collate_key:
+ * @collator: a #GCollator
+ * @str: a UTF-8 encoded string.
+ * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ *
+ * Like g_utf8_collate_key(), but uses the collation rules of @collator.
+ *
+ * Return value: a newly allocated string. This string should
+ *   be freed with g_free() when you are done with it.
+ *
+ * Since: 2.40
+ */
+gchar *
+g_collator_collate_key (GCollator   *collator,
+			const gchar *str,
+			gssize       len)
+{
+  g_return_val_if_fail (collator != NULL, NULL);
+  g_return_val_if_fail (str != NULL, NULL);
+
+  g_string_truncate (collator->key, 0);
+  collator_append_key (collator, str, len, collator->key);
+
+  return g_strndup (collator->key->str, collator->key->len);
+}
+
+/**
+ * g_collator_collate_key_for_filename:
+ * @collator: a #GCollator
+ * @str: a UTF-8 encoded string.
+ * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ *
+ * Like g_utf8_collate_key_for_filename(), but uses the collation
+ * rules of @collator.
+ *
+ * Return value: a newly allocated string. This string should
+ *   be freed with g_free() when you are done with it.
+ *
+ * Since: 2.40
+ */
+gchar *
+g_collator_collate_key_for_filename (GCollator   *collator,
+				     const gchar *str,
+				     gssize       len)
+{
+  g_return_val_if_fail (collator != NULL, NULL);
+  g_return_val_if_fail (str != NULL, NULL);
+
+#ifndef HAVE_CARBON
+  return collate_key_for_filename (collator, str, len);
+#else
+  return carbon_collate_key_for_filename (str, len);
+#endif
+}
+
+/**
+ * g_collator_collate_keys:
+ * @collator: a #GCollator
+ * @strs: (array length=n_strs): UTF-8 encoded strings
+ * @n_strs: the number of strings in @strs, or -1 if @strs is
+ *     %NULL-terminated
+ * @for_filename: whether to generate keys like
+ *     g_collator_collate_key_for_filename() instead of
+ *     g_collator_collate_key()
+ *
+ * Generates the collation keys for all of @strs at once.
+ *
+ * Return value: (transfer full): a newly allocated %NULL-terminated
+ *   array with the collation key for each string in @strs. Use
+ *   g_strfreev() to free it.
+ *
+ * Since: 2.40
+ */
+gchar **
+g_collator_collate_keys (GCollator          *collator,
+			 const gchar * const *strs,
+			 gssize               n_strs,
+			 gboolean             for_filename)
+{
+  gchar **keys;
+  gsize i, n;
+
+  g_return_val_if_fail (collator != NULL, NULL);
+  g_return_val_if_fail (strs != NULL || n_strs == 0, NULL);
+
+  if (n_strs < 0)
+    for (n = 0; strs[n] != NULL; n++);
+  else
+    n = n_strs;
+
+  keys = g_new (gchar *, n + 1);
+  for (i = 0; i < n; i++)
+    {
+      if (for_filename)
+        keys[i] = g_collator_collate_key_for_filename (collator, strs[i], -1);
+      else
+        keys[i] = g_collator_collate_key (collator, strs[i], -1);
+    }
+  keys[n] = NULL;
+
+  return keys;
+}
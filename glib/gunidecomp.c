@@ -49,6 +49,7 @@
 #include "gunicode.h"
 #include "gunidecomp.h"
 #include "gmem.h"
+#include "gstrfuncs.h"
 #include "gunicomp.h"
 #include "gunicodeprivate.h"
 
@@ -355,6 +356,48 @@ combine (gunichar  a,
   return FALSE;
 }
 
+/* Canonically composes the decomposed and reordered @wc_buffer in
+ * place, returning the new length.
+ */
+static gsize
+compose_wc (gunichar *wc_buffer,
+            gsize     n_wc)
+{
+  gsize i, j;
+  gsize last_start = 0;
+  int last_cc = 0;
+
+  for (i = 0; i < n_wc; i++)
+    {
+      int cc = COMBINING_CLASS (wc_buffer[i]);
+
+      if (i > 0 &&
+          (last_cc == 0 || last_cc < cc) &&
+          combine (wc_buffer[last_start], wc_buffer[i],
+                   &wc_buffer[last_start]))
+        {
+          for (j = i + 1; j < n_wc; j++)
+            wc_buffer[j-1] = wc_buffer[j];
+          n_wc--;
+          i--;
+
+          if (i == last_start)
+            last_cc = 0;
+          else
+            last_cc = COMBINING_CLASS (wc_buffer[i-1]);
+
+          continue;
+        }
+
+      if (cc == 0)
+        last_start = i;
+
+      last_cc = cc;
+    }
+
+  return n_wc;
+}
+
 gunichar *
 _g_utf8_normalize_wc (const gchar    *str,
 		      gssize          max_len,
@@ -452,43 +495,138 @@ _g_utf8_normalize_wc (const gchar    *str,
   /* All decomposed and reordered */ 
 
   if (do_compose && n_wc > 0)
+    n_wc = compose_wc (wc_buffer, n_wc);
+
+  wc_buffer[n_wc] = 0;
+
+  return wc_buffer;
+}
+
+/* Quick check for whether @str is already in normalization form @mode,
+ * in the spirit of the NFC_QC/NFD_QC properties of UAX #15, but derived
+ * from the decomposition and composition tables we already have.
+ *
+ * Every character is checked against what _g_utf8_normalize_wc() would
+ * do to it: it must not decompose (or, when composing, must compose
+ * back to itself), must not need canonical reordering against its
+ * predecessor and must not combine with the preceding starter.  ASCII
+ * never takes part in any of that, so ASCII runs are skipped wholesale.
+ *
+ * Returns %TRUE with the byte length of @str in @length if it is
+ * normalized, and %FALSE if it isn't, might not be or is not valid
+ * UTF-8; the caller then has to do the full normalization.
+ */
+static gboolean
+utf8_is_normalized (const gchar    *str,
+                    gssize          max_len,
+                    GNormalizeMode  mode,
+                    gsize          *length)
+{
+  gboolean do_compat = (mode == G_NORMALIZE_NFKC ||
+                        mode == G_NORMALIZE_NFKD);
+  gboolean do_compose = (mode == G_NORMALIZE_NFC ||
+                         mode == G_NORMALIZE_NFKC);
+  const gchar *p = str;
+  const gchar *end = max_len < 0 ? NULL : str + max_len;
+  gboolean have_starter = FALSE;
+  gunichar starter = 0;
+  int order_cc = 0;
+  int compose_cc = 0;
+
+  while ((end == NULL || p < end) && *p)
     {
-      gsize i, j;
-      int last_cc = 0;
-      last_start = 0;
-      
-      for (i = 0; i < n_wc; i++)
-	{
-	  int cc = COMBINING_CLASS (wc_buffer[i]);
+      gunichar decomp_buf[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+      gsize decomp_len;
+      const gchar *decomp;
+      gboolean decomposes = TRUE;
+      gunichar wc;
+      int first_cc, cc;
 
-	  if (i > 0 &&
-	      (last_cc == 0 || last_cc < cc) &&
-	      combine (wc_buffer[last_start], wc_buffer[i],
-		       &wc_buffer[last_start]))
-	    {
-	      for (j = i + 1; j < n_wc; j++)
-		wc_buffer[j-1] = wc_buffer[j];
-	      n_wc--;
-	      i--;
-	      
-	      if (i == last_start)
-		last_cc = 0;
-	      else
-		last_cc = COMBINING_CLASS (wc_buffer[i-1]);
-	      
-	      continue;
-	    }
+      if ((guchar) *p < 0x80)
+        {
+          do
+            p++;
+          while ((end == NULL || p < end) && *p != '\0' && (guchar) *p < 0x80);
+
+          starter = (guchar) p[-1];
+          have_starter = TRUE;
+          order_cc = compose_cc = 0;
+          continue;
+        }
 
-	  if (cc == 0)
-	    last_start = i;
+      wc = g_utf8_get_char_validated (p, end == NULL ? -1 : end - p);
+      if (wc & 0x80000000)
+        return FALSE;
 
-	  last_cc = cc;
-	}
+      if (wc >= SBase && wc < SBase + SCount)
+        {
+          decompose_hangul (wc, decomp_buf, &decomp_len);
+        }
+      else if ((decomp = find_decomposition (wc, do_compat)) != NULL)
+        {
+          /* decompositions are never empty */
+          decomp_len = 0;
+          do
+            {
+              decomp_buf[decomp_len++] = g_utf8_get_char (decomp);
+              decomp = g_utf8_next_char (decomp);
+            }
+          while (*decomp != '\0');
+        }
+      else
+        {
+          decomp_buf[0] = wc;
+          decomp_len = 1;
+          decomposes = FALSE;
+        }
+
+      first_cc = COMBINING_CLASS (decomp_buf[0]);
+      if (first_cc != 0 && order_cc > first_cc)
+        return FALSE;
+
+      if (do_compose)
+        {
+          if (decomposes)
+            {
+              if (first_cc != 0)
+                return FALSE;
+
+              g_unicode_canonical_ordering (decomp_buf, decomp_len);
+              if (compose_wc (decomp_buf, decomp_len) != 1 || decomp_buf[0] != wc)
+                return FALSE;
+            }
+
+          cc = COMBINING_CLASS (wc);
+          if (!have_starter)
+            {
+              if (cc != 0)
+                return FALSE;
+            }
+          else if (compose_cc == 0 || compose_cc < first_cc)
+            {
+              gunichar composed;
+
+              if (combine (starter, decomp_buf[0], &composed))
+                return FALSE;
+            }
+
+          if (cc == 0)
+            {
+              starter = wc;
+              have_starter = TRUE;
+            }
+          compose_cc = cc;
+        }
+      else if (decomposes)
+        return FALSE;
+
+      order_cc = COMBINING_CLASS (decomp_buf[decomp_len - 1]);
+      p = g_utf8_next_char (p);
     }
 
-  wc_buffer[n_wc] = 0;
+  *length = p - str;
 
-  return wc_buffer;
+  return TRUE;
 }
 
 /**
@@ -532,9 +670,14 @@ g_utf8_normalize (const gchar    *str,
 		  gssize          len,
 		  GNormalizeMode  mode)
 {
-  gunichar *result_wc = _g_utf8_normalize_wc (str, len, mode);
+  gunichar *result_wc;
   gchar *result;
+  gsize length;
+
+  if (utf8_is_normalized (str, len, mode, &length))
+    return g_strndup (str, length);
 
+  result_wc = _g_utf8_normalize_wc (str, len, mode);
   result = g_ucs4_to_utf8 (result_wc, -1, NULL, NULL, NULL);
   g_free (result_wc);
 
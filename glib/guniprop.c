@@ -778,13 +778,14 @@ get_locale_type (void)
 
 static gint
 output_marks (const char **p_inout,
+	      const char  *end,
 	      char        *out_buffer,
 	      gboolean     remove_dot)
 {
   const char *p = *p_inout;
   gint len = 0;
   
-  while (*p)
+  while ((end == NULL || p < end) && *p)
     {
       gunichar c = g_utf8_get_char (p);
       
@@ -824,11 +825,60 @@ output_special_case (gchar *out_buffer,
   return len;
 }
 
+/* Copies the run of ASCII characters at the start of @str to
+ * @out_buffer, flipping the case of the letters between @first and
+ * @last, and returns its length.  The run ends at the first non-ASCII
+ * or nul byte or after @max_len bytes.  @out_buffer may be %NULL to
+ * only measure the run, or @str itself to convert in place.
+ */
+static gsize
+ascii_case_run (const gchar *str,
+                gsize        max_len,
+                gchar       *out_buffer,
+                gchar        first,
+                gchar        last)
+{
+  const guint64 ones = G_GUINT64_CONSTANT (0x0101010101010101);
+  const guint64 highs = G_GUINT64_CONSTANT (0x8080808080808080);
+  const gchar *p = str;
+  const gchar *end = str + max_len;
+
+  while (end - p >= 8)
+    {
+      guint64 word;
+
+      memcpy (&word, p, 8);
+
+      /* any byte with the high bit set, or any nul byte */
+      if ((word | ((word - ones) & ~word)) & highs)
+        break;
+
+      if (out_buffer)
+        {
+          guint64 letters;
+
+          /* with the high bits clear nothing carries between bytes */
+          letters = (word + (0x80 - first) * ones) & ~(word + (0x7f - last) * ones) & highs;
+          word ^= letters >> 2;
+          memcpy (out_buffer + (p - str), &word, 8);
+        }
+
+      p += 8;
+    }
+
+  for (; p < end && *p != '\0' && (guchar) *p < 0x80; p++)
+    if (out_buffer)
+      out_buffer[p - str] = (*p >= first && *p <= last) ? *p ^ 0x20 : *p;
+
+  return p - str;
+}
+
 static gsize
 real_toupper (const gchar *str,
 	      gssize       max_len,
 	      gchar       *out_buffer,
-	      LocaleType   locale_type)
+	      LocaleType   locale_type,
+	      gboolean    *same_length)
 {
   const gchar *p = str;
   const char *last = NULL;
@@ -837,10 +887,21 @@ real_toupper (const gchar *str,
 
   while ((max_len < 0 || p < str + max_len) && *p)
     {
-      gunichar c = g_utf8_get_char (p);
-      int t = TYPE (c);
+      gunichar c;
+      int t;
       gunichar val;
 
+      if (max_len >= 0 && locale_type == LOCALE_NORMAL && (guchar) *p < 0x80)
+	{
+	  gsize run = ascii_case_run (p, str + max_len - p,
+				      out_buffer ? out_buffer + len : NULL, 'a', 'z');
+	  p += run;
+	  len += run;
+	  continue;
+	}
+
+      c = g_utf8_get_char (p);
+      t = TYPE (c);
       last = p;
       p = g_utf8_next_char (p);
 
@@ -866,7 +927,12 @@ real_toupper (const gchar *str,
 			len += g_unichar_to_utf8 (g_unichar_toupper (decomp[i]), out_buffer ? out_buffer + len : NULL);
 		    }
 		  
-		  len += output_marks (&p, out_buffer ? out_buffer + len : NULL, TRUE);
+		  len += output_marks (&p, max_len < 0 ? NULL : str + max_len,
+				       out_buffer ? out_buffer + len : NULL, TRUE);
+
+		  /* the decomposition is written before the marks are read */
+		  if (same_length)
+		    *same_length = FALSE;
 
 		  continue;
 		}
@@ -886,7 +952,8 @@ real_toupper (const gchar *str,
 	  /* Nasty, need to move it after other combining marks .. this would go away if
 	   * we normalized first.
 	   */
-	  len += output_marks (&p, out_buffer ? out_buffer + len : NULL, FALSE);
+	  len += output_marks (&p, max_len < 0 ? NULL : str + max_len,
+			       out_buffer ? out_buffer + len : NULL, FALSE);
 
 	  /* And output as GREEK CAPITAL LETTER IOTA */
 	  len += g_unichar_to_utf8 (0x399, out_buffer ? out_buffer + len : NULL); 	  
@@ -934,6 +1001,8 @@ real_toupper (const gchar *str,
 	  len += char_len;
 	}
 
+      if (same_length && len != (gsize) (p - str))
+	*same_length = FALSE;
     }
 
   return len;
@@ -963,28 +1032,71 @@ g_utf8_strup (const gchar *str,
 
   g_return_val_if_fail (str != NULL, NULL);
 
+  if (len < 0)
+    len = strlen (str);
+
   locale_type = get_locale_type ();
   
   /*
    * We use a two pass approach to keep memory management simple
    */
-  result_len = real_toupper (str, len, NULL, locale_type);
+  result_len = real_toupper (str, len, NULL, locale_type, NULL);
   result = g_malloc (result_len + 1);
-  real_toupper (str, len, result, locale_type);
+  real_toupper (str, len, result, locale_type, NULL);
   result[result_len] = '\0';
 
   return result;
 }
 
+/**
+ * g_utf8_strup_in_place:
+ * @str: a UTF-8 encoded string
+ * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ *
+ * Like g_utf8_strup(), but converts @str in place instead of
+ * allocating a new string.  This is only possible if the conversion
+ * doesn't change the length in bytes of any of the characters, as is
+ * the case for most text and always for ASCII.  Otherwise @str is
+ * left unchanged and you have to use g_utf8_strup().
+ *
+ * Return value: %TRUE if @str was converted, %FALSE if it was
+ *    left unchanged
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_utf8_strup_in_place (gchar  *str,
+		       gssize  len)
+{
+  gboolean same_length = TRUE;
+  LocaleType locale_type;
+
+  g_return_val_if_fail (str != NULL, FALSE);
+
+  if (len < 0)
+    len = strlen (str);
+
+  locale_type = get_locale_type ();
+
+  real_toupper (str, len, NULL, locale_type, &same_length);
+  if (!same_length)
+    return FALSE;
+
+  real_toupper (str, len, str, locale_type, NULL);
+
+  return TRUE;
+}
+
 /* traverses the string checking for characters with combining class == 230
  * until a base character is found */
 static gboolean
-has_more_above (const gchar *str)
+has_more_above (const gchar *str,
+                const gchar *end)
 {
   const gchar *p = str;
   gint combining_class;
 
-  while (*p)
+  while ((end == NULL || p < end) && *p)
     {
       combining_class = g_unichar_combining_class (g_utf8_get_char (p));
       if (combining_class == 230)
@@ -1002,7 +1114,8 @@ static gsize
 real_tolower (const gchar *str,
 	      gssize       max_len,
 	      gchar       *out_buffer,
-	      LocaleType   locale_type)
+	      LocaleType   locale_type,
+	      gboolean    *same_length)
 {
   const gchar *p = str;
   const char *last = NULL;
@@ -1010,10 +1123,21 @@ real_tolower (const gchar *str,
 
   while ((max_len < 0 || p < str + max_len) && *p)
     {
-      gunichar c = g_utf8_get_char (p);
-      int t = TYPE (c);
+      gunichar c;
+      int t;
       gunichar val;
 
+      if (max_len >= 0 && locale_type == LOCALE_NORMAL && (guchar) *p < 0x80)
+	{
+	  gsize run = ascii_case_run (p, str + max_len - p,
+				      out_buffer ? out_buffer + len : NULL, 'A', 'Z');
+	  p += run;
+	  len += run;
+	  continue;
+	}
+
+      c = g_utf8_get_char (p);
+      t = TYPE (c);
       last = p;
       p = g_utf8_next_char (p);
 
@@ -1054,7 +1178,7 @@ real_tolower (const gchar *str,
         }
       else if (locale_type == LOCALE_LITHUANIAN && 
                (c == 'I' || c == 'J' || c == 0x012e) && 
-               has_more_above (p))
+               has_more_above (p, max_len < 0 ? NULL : str + max_len))
         {
           len += g_unichar_to_utf8 (g_unichar_tolower (c), out_buffer ? out_buffer + len : NULL); 
           len += g_unichar_to_utf8 (0x0307, out_buffer ? out_buffer + len : NULL); 
@@ -1123,6 +1247,8 @@ real_tolower (const gchar *str,
 	  len += char_len;
 	}
 
+      if (same_length && len != (gsize) (p - str))
+	*same_length = FALSE;
     }
 
   return len;
@@ -1151,19 +1277,88 @@ g_utf8_strdown (const gchar *str,
 
   g_return_val_if_fail (str != NULL, NULL);
 
+  if (len < 0)
+    len = strlen (str);
+
   locale_type = get_locale_type ();
   
   /*
    * We use a two pass approach to keep memory management simple
    */
-  result_len = real_tolower (str, len, NULL, locale_type);
+  result_len = real_tolower (str, len, NULL, locale_type, NULL);
   result = g_malloc (result_len + 1);
-  real_tolower (str, len, result, locale_type);
+  real_tolower (str, len, result, locale_type, NULL);
   result[result_len] = '\0';
 
   return result;
 }
 
+/**
+ * g_utf8_strdown_in_place:
+ * @str: a UTF-8 encoded string
+ * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ *
+ * Like g_utf8_strdown(), but converts @str in place instead of
+ * allocating a new string.  This is only possible if the conversion
+ * doesn't change the length in bytes of any of the characters, as is
+ * the case for most text and always for ASCII.  Otherwise @str is
+ * left unchanged and you have to use g_utf8_strdown().
+ *
+ * Return value: %TRUE if @str was converted, %FALSE if it was
+ *    left unchanged
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_utf8_strdown_in_place (gchar  *str,
+			 gssize  len)
+{
+  gboolean same_length = TRUE;
+  LocaleType locale_type;
+
+  g_return_val_if_fail (str != NULL, FALSE);
+
+  if (len < 0)
+    len = strlen (str);
+
+  locale_type = get_locale_type ();
+
+  real_tolower (str, len, NULL, locale_type, &same_length);
+  if (!same_length)
+    return FALSE;
+
+  real_tolower (str, len, str, locale_type, NULL);
+
+  return TRUE;
+}
+
+/* returns the special case folding of @ch, if any */
+static const gchar *
+casefold_lookup (gunichar ch)
+{
+  int start = 0;
+  int end = G_N_ELEMENTS (casefold_table);
+
+  if (ch >= casefold_table[start].ch &&
+      ch <= casefold_table[end - 1].ch)
+    {
+      while (TRUE)
+	{
+	  int half = (start + end) / 2;
+	  if (ch == casefold_table[half].ch)
+	    return casefold_table[half].data;
+	  else if (half == start)
+	    break;
+	  else if (ch > casefold_table[half].ch)
+	    start = half;
+	  else
+	    end = half;
+	}
+    }
+
+  return NULL;
+}
+
 /**
  * g_utf8_casefold:
  * @str: a UTF-8 encoded string
@@ -1190,47 +1385,126 @@ g_utf8_casefold (const gchar *str,
 {
   GString *result;
   const char *p;
+  const char *end;
 
   g_return_val_if_fail (str != NULL, NULL);
 
-  result = g_string_new (NULL);
+  if (len < 0)
+    len = strlen (str);
+
+  result = g_string_sized_new (len);
   p = str;
-  while ((len < 0 || p < str + len) && *p)
+  end = str + len;
+  while (p < end && *p)
     {
-      gunichar ch = g_utf8_get_char (p);
+      gunichar ch;
+      const gchar *folded;
 
-      int start = 0;
-      int end = G_N_ELEMENTS (casefold_table);
-
-      if (ch >= casefold_table[start].ch &&
-          ch <= casefold_table[end - 1].ch)
+      if ((guchar) *p < 0x80)
 	{
-	  while (TRUE)
-	    {
-	      int half = (start + end) / 2;
-	      if (ch == casefold_table[half].ch)
-		{
-		  g_string_append (result, casefold_table[half].data);
-		  goto next;
-		}
-	      else if (half == start)
-		break;
-	      else if (ch > casefold_table[half].ch)
-		start = half;
-	      else
-		end = half;
-	    }
+	  gsize old_len = result->len;
+	  gsize run;
+
+	  g_string_set_size (result, old_len + (end - p));
+	  run = ascii_case_run (p, end - p, result->str + old_len, 'A', 'Z');
+	  g_string_truncate (result, old_len + run);
+	  p += run;
+	  continue;
 	}
 
-      g_string_append_unichar (result, g_unichar_tolower (ch));
-      
-    next:
+      ch = g_utf8_get_char (p);
+      folded = casefold_lookup (ch);
+
+      if (folded)
+	g_string_append (result, folded);
+      else
+	g_string_append_unichar (result, g_unichar_tolower (ch));
+
       p = g_utf8_next_char (p);
     }
 
   return g_string_free (result, FALSE); 
 }
 
+/**
+ * g_utf8_casefold_in_place:
+ * @str: a UTF-8 encoded string
+ * @len: length of @str, in bytes, or -1 if @str is nul-terminated.
+ *
+ * Like g_utf8_casefold(), but converts @str in place instead of
+ * allocating a new string.  This is only possible if case folding
+ * doesn't change the length in bytes of any of the characters, as is
+ * the case for most text and always for ASCII.  Otherwise @str is
+ * left unchanged and you have to use g_utf8_casefold().
+ *
+ * Return value: %TRUE if @str was converted, %FALSE if it was
+ *    left unchanged
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_utf8_casefold_in_place (gchar  *str,
+			  gssize  len)
+{
+  gchar *p;
+  gchar *end;
+
+  g_return_val_if_fail (str != NULL, FALSE);
+
+  if (len < 0)
+    len = strlen (str);
+
+  end = str + len;
+
+  for (p = str; p < end && *p; p = g_utf8_next_char (p))
+    {
+      gunichar ch;
+      const gchar *folded;
+      gint folded_len;
+
+      if ((guchar) *p < 0x80)
+	{
+	  p += ascii_case_run (p, end - p, NULL, 'A', 'Z');
+	  if (p == end || *p == '\0')
+	    break;
+	}
+
+      ch = g_utf8_get_char (p);
+      folded = casefold_lookup (ch);
+
+      if (folded)
+	folded_len = strlen (folded);
+      else
+	folded_len = g_unichar_to_utf8 (g_unichar_tolower (ch), NULL);
+
+      if (folded_len != g_utf8_skip[*(guchar *)p])
+	return FALSE;
+    }
+
+  for (p = str; p < end && *p; p = g_utf8_next_char (p))
+    {
+      gunichar ch;
+      const gchar *folded;
+
+      if ((guchar) *p < 0x80)
+	{
+	  p += ascii_case_run (p, end - p, p, 'A', 'Z');
+	  if (p == end || *p == '\0')
+	    break;
+	}
+
+      ch = g_utf8_get_char (p);
+      folded = casefold_lookup (ch);
+
+      if (folded)
+	memcpy (p, folded, strlen (folded));
+      else
+	g_unichar_to_utf8 (g_unichar_tolower (ch), p);
+    }
+
+  return TRUE;
+}
+
 /**
  * g_unichar_get_mirror_char:
  * @ch: a Unicode character
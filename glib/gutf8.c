@@ -42,6 +42,19 @@
 #include "gthread.h"
 #include "glibintl.h"
 
+/* On x86 processors with SSSE3, g_utf8_validate() checks 16 bytes at
+ * a time; utf8_init_accel() picks the implementation.
+ */
+#if defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined (__x86_64__) || defined (__i386__))
+#define UTF8_X86_ACCEL 1
+#include <immintrin.h>
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define UTF8_COMPUTE(Char, Mask, Len)					      \
   if (Char < 128)							      \
     {									      \
@@ -206,6 +219,59 @@ g_utf8_prev_char (const gchar *p)
     }
 }
 
+/* Counts the bytes in the @len bytes at @str that are not continuation
+ * bytes.  For valid UTF-8 this is the number of characters that start
+ * in that range.
+ */
+static gsize
+utf8_count_chars (const gchar *str,
+                  gsize        len)
+{
+  gsize n = 0;
+
+#ifdef __SSE2__
+  /* continuation bytes are 0x80 to 0xbf, the smallest signed bytes */
+  const __m128i last_continuation = _mm_set1_epi8 ((gchar) 0xbf);
+
+  while (len >= 16)
+    {
+      __m128i counts = _mm_setzero_si128 ();
+      gsize blocks, i;
+
+      /* the byte counters overflow after 255 blocks */
+      blocks = MIN (len / 16, 255);
+      for (i = 0; i < blocks; i++, str += 16)
+        {
+          __m128i bytes = _mm_loadu_si128 ((const __m128i *) str);
+
+          counts = _mm_sub_epi8 (counts, _mm_cmpgt_epi8 (bytes, last_continuation));
+        }
+
+      counts = _mm_sad_epu8 (counts, _mm_setzero_si128 ());
+      n += _mm_cvtsi128_si32 (counts) + _mm_cvtsi128_si32 (_mm_srli_si128 (counts, 8));
+      len -= blocks * 16;
+    }
+#else
+  const guint64 highs = G_GUINT64_CONSTANT (0x8080808080808080);
+
+  for (; len >= 8; len -= 8, str += 8)
+    {
+      guint64 word, continuations;
+
+      memcpy (&word, str, 8);
+
+      /* the high bit of each byte that is 10xxxxxx */
+      continuations = word & ~(word << 1) & highs;
+      n += 8 - (((continuations >> 7) * G_GUINT64_CONSTANT (0x0101010101010101)) >> 56);
+    }
+#endif
+
+  for (; len > 0; len--, str++)
+    n += (*str & 0xc0) != 0x80;
+
+  return n;
+}
+
 /**
  * g_utf8_strlen:
  * @p: pointer to the start of a UTF-8 encoded string
@@ -225,37 +291,29 @@ glong
 g_utf8_strlen (const gchar *p,
                gssize       max)
 {
-  glong len = 0;
-  const gchar *start = p;
+  glong len;
+  const gchar *end;
+  const gchar *last;
   g_return_val_if_fail (p != NULL || max == 0, 0);
 
   if (max < 0)
-    {
-      while (*p)
-        {
-          p = g_utf8_next_char (p);
-          ++len;
-        }
-    }
-  else
-    {
-      if (max == 0 || !*p)
-        return 0;
+    return utf8_count_chars (p, strlen (p));
 
-      p = g_utf8_next_char (p);
+  if (max == 0)
+    return 0;
 
-      while (p - start < max && *p)
-        {
-          ++len;
-          p = g_utf8_next_char (p);
-        }
+  end = memchr (p, '\0', max);
+  if (end != NULL)
+    return utf8_count_chars (p, end - p);
 
-      /* only do the last len increment if we got a complete
-       * char (don't count partial chars)
-       */
-      if (p - start <= max)
-        ++len;
-    }
+  len = utf8_count_chars (p, max);
+
+  /* don't count the last character if it is only partly within @max */
+  last = p + max - 1;
+  while (last > p && (*last & 0xc0) == 0x80)
+    last--;
+  if (g_utf8_next_char (last) > p + max)
+    len--;
 
   return len;
 }
@@ -349,9 +407,37 @@ g_utf8_offset_to_pointer  (const gchar *str,
 {
   const gchar *s = str;
 
-  if (offset > 0) 
-    while (offset--)
-      s = g_utf8_next_char (s);
+  if (offset > 0)
+    {
+      /* every character takes at least one byte, so the next @offset
+       * bytes are all in the string and can be counted in bulk.  if
+       * that stops inside a character, step back to its start.
+       */
+      while (offset >= 64)
+        {
+          glong len = offset;
+
+          offset -= utf8_count_chars (s, len);
+          s += len;
+
+          if ((*s & 0xc0) == 0x80)
+            {
+              const gchar *lead = s - 1;
+
+              while (lead > s - 4 && (*lead & 0xc0) == 0x80)
+                lead--;
+
+              if ((*lead & 0xc0) != 0x80)
+                {
+                  s = lead;
+                  offset++;
+                }
+            }
+        }
+
+      while (offset--)
+        s = g_utf8_next_char (s);
+    }
   else
     {
       const char *s1;
@@ -397,11 +483,12 @@ g_utf8_pointer_to_offset (const gchar *str,
   if (pos < str) 
     offset = - g_utf8_pointer_to_offset (pos, str);
   else
-    while (s < pos)
-      {
-	s = g_utf8_next_char (s);
-	offset++;
-      }
+    {
+      /* the characters starting before @pos, including one that @pos
+       * points into the middle of
+       */
+      offset = utf8_count_chars (s, pos - s);
+    }
   
   return offset;
 }
@@ -1442,72 +1529,6 @@ g_ucs4_to_utf16 (const gunichar  *str,
   val |= (*(guchar *)p) & 0x3f;                     \
  } G_STMT_END
 
-static const gchar *
-fast_validate (const char *str)
-
-{
-  gunichar val = 0;
-  gunichar min = 0;
-  const gchar *p;
-
-  for (p = str; *p; p++)
-    {
-      if (*(guchar *)p < 128)
-	/* done */;
-      else 
-	{
-	  const gchar *last;
-	  
-	  last = p;
-	  if ((*(guchar *)p & 0xe0) == 0xc0) /* 110xxxxx */
-	    {
-	      if (G_UNLIKELY ((*(guchar *)p & 0x1e) == 0))
-		goto error;
-	      p++;
-	      if (G_UNLIKELY ((*(guchar *)p & 0xc0) != 0x80)) /* 10xxxxxx */
-		goto error;
-	    }
-	  else
-	    {
-	      if ((*(guchar *)p & 0xf0) == 0xe0) /* 1110xxxx */
-		{
-		  min = (1 << 11);
-		  val = *(guchar *)p & 0x0f;
-		  goto TWO_REMAINING;
-		}
-	      else if ((*(guchar *)p & 0xf8) == 0xf0) /* 11110xxx */
-		{
-		  min = (1 << 16);
-		  val = *(guchar *)p & 0x07;
-		}
-	      else
-		goto error;
-	      
-	      p++;
-	      CONTINUATION_CHAR;
-	    TWO_REMAINING:
-	      p++;
-	      CONTINUATION_CHAR;
-	      p++;
-	      CONTINUATION_CHAR;
-	      
-	      if (G_UNLIKELY (val < min))
-		goto error;
-
-	      if (G_UNLIKELY (!UNICODE_VALID(val)))
-		goto error;
-	    } 
-	  
-	  continue;
-	  
-	error:
-	  return last;
-	}
-    }
-
-  return p;
-}
-
 static const gchar *
 fast_validate_len (const char *str,
 		   gssize      max_len)
@@ -1585,6 +1606,192 @@ fast_validate_len (const char *str,
   return p;
 }
 
+/* Validates a prefix of @str in bulk, and returns where fast_validate_len()
+ * has to take over: this is always the start of a character, and
+ * everything before it is valid UTF-8 without NUL bytes.
+ */
+typedef const gchar * (* Utf8ValidateBlocks) (const gchar *str,
+                                              gsize        len);
+
+/* skips over words of ASCII characters */
+static const gchar *
+utf8_validate_blocks_ascii (const gchar *str,
+                            gsize        len)
+{
+  const guint64 ones = G_GUINT64_CONSTANT (0x0101010101010101);
+  const guint64 highs = G_GUINT64_CONSTANT (0x8080808080808080);
+  const gchar *p = str;
+
+  for (; len >= 8; len -= 8, p += 8)
+    {
+      guint64 word;
+
+      memcpy (&word, p, 8);
+
+      /* any byte with the high bit set, or any NUL byte */
+      if ((word | ((word - ones) & ~word)) & highs)
+        break;
+    }
+
+  return p;
+}
+
+#ifdef UTF8_X86_ACCEL
+/* John Keiser and Daniel Lemire, "Validating UTF-8 In Less Than One
+ * Instruction Per Byte".  Each byte is checked against the one
+ * before it with three table lookups on nibbles; the bits of the
+ * tables stand for the different kinds of error.
+ */
+#define TOO_SHORT      (1 << 0)  /* lead byte or ASCII followed by a lead byte or ASCII */
+#define TOO_LONG       (1 << 1)  /* ASCII followed by a continuation byte */
+#define OVERLONG_3     (1 << 2)  /* 11100000 100_____ */
+#define TOO_LARGE      (1 << 3)  /* 11110100 1001____ and above */
+#define SURROGATE      (1 << 4)  /* 11101101 101_____ */
+#define OVERLONG_2     (1 << 5)  /* 1100000_ 10______ */
+#define TOO_LARGE_1000 (1 << 6)  /* 11110101 1000____ and above */
+#define OVERLONG_4     (1 << 6)  /* 11110000 1000____ */
+#define TWO_CONTS      (1 << 7)  /* continuation byte after a continuation byte */
+#define CARRY          (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+__attribute__ ((target ("ssse3")))
+static const gchar *
+utf8_validate_blocks_ssse3 (const gchar *str,
+                            gsize        len)
+{
+  /* indexed by the high nibble of the previous byte */
+  const __m128i byte_1_high = _mm_setr_epi8 (TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                                             TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                                             TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                                             TOO_SHORT | OVERLONG_2,
+                                             TOO_SHORT,
+                                             TOO_SHORT | OVERLONG_3 | SURROGATE,
+                                             (gchar) (TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+  /* indexed by the low nibble of the previous byte */
+  const __m128i byte_1_low = _mm_setr_epi8 (CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                                            CARRY | OVERLONG_2,
+                                            CARRY,
+                                            CARRY,
+                                            CARRY | TOO_LARGE,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                            CARRY | TOO_LARGE | TOO_LARGE_1000);
+  /* indexed by the high nibble of the byte itself */
+  const __m128i byte_2_high = _mm_setr_epi8 (TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                             TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                             (gchar) (TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+                                             (gchar) (TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+                                             (gchar) (TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+                                             (gchar) (TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+                                             TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+  /* the largest byte values that don't start a sequence running past
+   * the end of the block
+   */
+  const __m128i max_complete = _mm_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, -1,
+                                              (gchar) 0xef, (gchar) 0xdf, (gchar) 0xbf);
+  const __m128i nibble = _mm_set1_epi8 (0x0f);
+  const __m128i zero = _mm_setzero_si128 ();
+  __m128i prev = zero;
+  __m128i prev_incomplete = zero;
+  const gchar *p = str;
+  gint i;
+
+  for (; len >= 16; len -= 16, p += 16)
+    {
+      __m128i input, error;
+
+      input = _mm_loadu_si128 ((const __m128i *) p);
+
+      /* the scalar code reports where a NUL is */
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (input, zero)))
+        break;
+
+      if (_mm_movemask_epi8 (input) == 0)
+        {
+          /* ASCII is only wrong after an unfinished sequence */
+          error = prev_incomplete;
+          prev_incomplete = zero;
+        }
+      else
+        {
+          __m128i prev1, prev2, prev3, special, must23;
+
+          prev1 = _mm_alignr_epi8 (input, prev, 15);
+          prev2 = _mm_alignr_epi8 (input, prev, 14);
+          prev3 = _mm_alignr_epi8 (input, prev, 13);
+
+          special = _mm_and_si128 (_mm_and_si128 (_mm_shuffle_epi8 (byte_1_high, _mm_and_si128 (_mm_srli_epi16 (prev1, 4), nibble)),
+                                                  _mm_shuffle_epi8 (byte_1_low, _mm_and_si128 (prev1, nibble))),
+                                   _mm_shuffle_epi8 (byte_2_high, _mm_and_si128 (_mm_srli_epi16 (input, 4), nibble)));
+
+          /* the second and third continuation bytes of 3 and 4 byte
+           * sequences, which must be continuation bytes and so have
+           * TWO_CONTS set in @special
+           */
+          must23 = _mm_or_si128 (_mm_subs_epu8 (prev2, _mm_set1_epi8 (0xe0 - 0x80)),
+                                 _mm_subs_epu8 (prev3, _mm_set1_epi8 ((gchar) (0xf0 - 0x80))));
+          error = _mm_xor_si128 (_mm_and_si128 (must23, _mm_set1_epi8 ((gchar) 0x80)), special);
+
+          prev_incomplete = _mm_subs_epu8 (input, max_complete);
+        }
+
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (error, zero)) != 0xFFFF)
+        break;
+
+      prev = input;
+    }
+
+  /* the character containing the byte before @p may not be finished,
+   * or be wrong in a way only found in the next block
+   */
+  for (i = 0; i < 3 && p > str && ((guchar) p[-1] & 0xc0) == 0x80; i++)
+    p--;
+  if (p > str && (guchar) p[-1] >= 0xc0)
+    p--;
+
+  return p;
+}
+
+#undef TOO_SHORT
+#undef TOO_LONG
+#undef OVERLONG_3
+#undef TOO_LARGE
+#undef SURROGATE
+#undef OVERLONG_2
+#undef TOO_LARGE_1000
+#undef OVERLONG_4
+#undef TWO_CONTS
+#undef CARRY
+#endif /* UTF8_X86_ACCEL */
+
+static Utf8ValidateBlocks
+utf8_init_accel (void)
+{
+  static gsize impl = 0;
+
+  if (g_once_init_enter (&impl))
+    {
+      Utf8ValidateBlocks blocks = utf8_validate_blocks_ascii;
+
+#ifdef UTF8_X86_ACCEL
+      if (__builtin_cpu_supports ("ssse3"))
+        blocks = utf8_validate_blocks_ssse3;
+#endif
+
+      g_once_init_leave (&impl, (gsize) blocks);
+    }
+
+  return (Utf8ValidateBlocks) impl;
+}
+
 /**
  * g_utf8_validate:
  * @str: (array length=max_len) (element-type guint8): a pointer to character data
@@ -1616,11 +1823,17 @@ g_utf8_validate (const char   *str,
 
 {
   const gchar *p;
+  gsize len;
 
-  if (max_len < 0)
-    p = fast_validate (str);
-  else
-    p = fast_validate_len (str, max_len);
+  /* strlen() is much faster than the validation, and lets the bulk
+   * validation know how far it can read
+   */
+  len = max_len < 0 ? strlen (str) : (gsize) max_len;
+
+  p = str;
+  if (len >= 16)
+    p = utf8_init_accel () (str, len);
+  p = fast_validate_len (p, len - (p - str));
 
   if (end)
     *end = p;
@@ -1022,6 +1022,135 @@ g_variant_get_child_value (GVariant *value,
   }
 }
 
+/* < private >
+ * g_variant_get_serialised_children:
+ * @value: a container #GVariant
+ * @children: an array with room for g_variant_n_children() items
+ *
+ * If @value is in serialised form, fills @children with the serialised
+ * form of each of its children, as per
+ * g_variant_serialised_get_children(), and returns %TRUE.  The data
+ * pointers are only valid for as long as @value is.
+ *
+ * If @value is in tree form then %FALSE is returned and @children is
+ * left untouched.
+ */
+gboolean
+g_variant_get_serialised_children (GVariant           *value,
+                                   GVariantSerialised *children)
+{
+  if (~g_atomic_int_get (&value->state) & STATE_SERIALISED)
+    return FALSE;
+
+  {
+    GVariantSerialised serialised = {
+      value->type_info,
+      (gpointer) value->contents.serialised.data,
+      value->size
+    };
+
+    g_variant_serialised_get_children (serialised, children);
+  }
+
+  return TRUE;
+}
+
+/* < private >
+ * g_variant_find_dict_key:
+ * @dictionary: a dictionary #GVariant with string or object path keys
+ * @key: the key to look for
+ *
+ * Finds the index of the first entry of @dictionary with the key @key,
+ * or -1 if there is no such entry.
+ *
+ * For a dictionary in serialised form, the keys are compared in place
+ * without creating child instances for each entry that is visited.
+ */
+gssize
+g_variant_find_dict_key (GVariant    *dictionary,
+                         const gchar *key)
+{
+  gsize n, i;
+
+  n = g_variant_n_children (dictionary);
+
+  if (~g_atomic_int_get (&dictionary->state) & STATE_SERIALISED)
+    {
+      gssize index_ = -1;
+
+      g_variant_lock (dictionary);
+
+      if (~dictionary->state & STATE_SERIALISED)
+        {
+          for (i = 0; i < n; i++)
+            {
+              GVariant *entry_key;
+              gboolean matches;
+
+              entry_key = g_variant_get_child_value (dictionary->contents.tree.children[i], 0);
+              matches = strcmp (g_variant_get_string (entry_key, NULL), key) == 0;
+              g_variant_unref (entry_key);
+
+              if (matches)
+                {
+                  index_ = i;
+                  break;
+                }
+            }
+
+          g_variant_unlock (dictionary);
+
+          return index_;
+        }
+
+      g_variant_unlock (dictionary);
+    }
+
+  {
+    GVariantSerialised serialised = {
+      dictionary->type_info,
+      (gpointer) dictionary->contents.serialised.data,
+      dictionary->size
+    };
+    gboolean trusted;
+
+    trusted = (dictionary->state & STATE_TRUSTED) != 0;
+
+    for (i = 0; i < n; i++)
+      {
+        GVariantSerialised s_entry, s_key;
+        const gchar *entry_key;
+
+        s_entry = g_variant_serialised_get_child (serialised, i);
+        s_key = g_variant_serialised_get_child (s_entry, 0);
+        g_variant_type_info_unref (s_entry.type_info);
+
+        entry_key = (const gchar *) s_key.data;
+
+        /* mirror what g_variant_get_string() returns for invalid keys */
+        if (!trusted)
+          {
+            if (g_variant_type_info_get_type_char (s_key.type_info) == G_VARIANT_CLASS_OBJECT_PATH)
+              {
+                if (!g_variant_serialiser_is_object_path (s_key.data, s_key.size))
+                  entry_key = "/";
+              }
+            else if (!g_variant_serialiser_is_string (s_key.data, s_key.size))
+              entry_key = "";
+          }
+        else if (entry_key == NULL)
+          entry_key = "";
+
+        g_variant_type_info_unref (s_key.type_info);
+
+        if (strcmp (entry_key, key) == 0)
+          return i;
+      }
+
+    return -1;
+  }
+}
+
 /**
  * g_variant_store:
  * @value: the #GVariant to store
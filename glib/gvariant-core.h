@@ -22,6 +22,7 @@
 #define __G_VARIANT_CORE_H__
 
 #include <glib/gvarianttypeinfo.h>
+#include <glib/gvariant-serialiser.h>
 #include <glib/gvariant.h>
 #include <glib/gbytes.h>
 
@@ -36,4 +37,10 @@ gboolean                g_variant_is_trusted                            (GVarian
 
 GVariantTypeInfo *      g_variant_get_type_info                         (GVariant            *value);
 
+gboolean                g_variant_get_serialised_children               (GVariant            *value,
+                                                                         GVariantSerialised  *children);
+
+gssize                  g_variant_find_dict_key                         (GVariant            *dictionary,
+                                                                         const gchar         *key);
+
 #endif /* __G_VARIANT_CORE_H__ */
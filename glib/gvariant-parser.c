@@ -1546,31 +1546,20 @@ unicode_unescape (const gchar  *src,
   return TRUE;
 }
 
-static AST *
-string_parse (TokenStream  *stream,
-              va_list      *app,
-              GError      **error)
+/* Unescapes the quoted string constant @token into @str, which must
+ * have room for at least as many bytes as @token.
+ */
+static gboolean
+string_unescape (const gchar  *token,
+                 gchar        *str,
+                 SourceRef    *ref,
+                 GError      **error)
 {
-  static const ASTClass string_class = {
-    string_get_pattern,
-    maybe_wrapper, string_get_value,
-    string_free
-  };
-  String *string;
-  SourceRef ref;
-  gchar *token;
-  gsize length;
   gchar quote;
-  gchar *str;
   gint i, j;
 
-  token_stream_start_ref (stream, &ref);
-  token = token_stream_get (stream);
-  token_stream_end_ref (stream, &ref);
-  length = strlen (token);
   quote = token[0];
 
-  str = g_malloc (length);
   g_assert (quote == '"' || quote == '\'');
   j = 0;
   i = 1;
@@ -1578,40 +1567,28 @@ string_parse (TokenStream  *stream,
     switch (token[i])
       {
       case '\0':
-        parser_set_error (error, &ref, NULL,
+        parser_set_error (error, ref, NULL,
                           G_VARIANT_PARSE_ERROR_UNTERMINATED_STRING_CONSTANT,
                           "unterminated string constant");
-        g_free (token);
-        g_free (str);
-        return NULL;
+        return FALSE;
 
       case '\\':
         switch (token[++i])
           {
           case '\0':
-            parser_set_error (error, &ref, NULL,
+            parser_set_error (error, ref, NULL,
                               G_VARIANT_PARSE_ERROR_UNTERMINATED_STRING_CONSTANT,
                               "unterminated string constant");
-            g_free (token);
-            g_free (str);
-            return NULL;
+            return FALSE;
 
           case 'u':
-            if (!unicode_unescape (token, &i, str, &j, 4, &ref, error))
-              {
-                g_free (token);
-                g_free (str);
-                return NULL;
-              }
+            if (!unicode_unescape (token, &i, str, &j, 4, ref, error))
+              return FALSE;
             continue;
 
           case 'U':
-            if (!unicode_unescape (token, &i, str, &j, 8, &ref, error))
-              {
-                g_free (token);
-                g_free (str);
-                return NULL;
-              }
+            if (!unicode_unescape (token, &i, str, &j, 8, ref, error))
+              return FALSE;
             continue;
 
           case 'a': str[j++] = '\a'; i++; continue;
@@ -1628,6 +1605,38 @@ string_parse (TokenStream  *stream,
         str[j++] = token[i++];
       }
   str[j++] = '\0';
+
+  return TRUE;
+}
+
+static AST *
+string_parse (TokenStream  *stream,
+              va_list      *app,
+              GError      **error)
+{
+  static const ASTClass string_class = {
+    string_get_pattern,
+    maybe_wrapper, string_get_value,
+    string_free
+  };
+  String *string;
+  SourceRef ref;
+  gchar *token;
+  gsize length;
+  gchar *str;
+
+  token_stream_start_ref (stream, &ref);
+  token = token_stream_get (stream);
+  token_stream_end_ref (stream, &ref);
+  length = strlen (token);
+
+  str = g_malloc (length);
+  if (!string_unescape (token, str, &ref, error))
+    {
+      g_free (token);
+      g_free (str);
+      return NULL;
+    }
   g_free (token);
 
   string = g_slice_new (String);
@@ -2304,6 +2313,506 @@ parse (TokenStream  *stream,
   return result;
 }
 
+/* When g_variant_parse() is given a definite container type, most large
+ * inputs (arrays of numbers and strings, dictionaries, tuples and
+ * variants holding simple values) can be converted straight into a
+ * value in a single pass, without building an AST and without any type
+ * inference.  Items are added to a #GVariantBuilder in serialised mode
+ * as they are read, so basic-typed items are not even allocated as
+ * separate #GVariant instances.
+ *
+ * The fast path gives up as soon as it sees anything that it does not
+ * handle, or anything that would be an error.  In that case the normal
+ * parser is run again from the start, so any error messages come from
+ * there.  For the input that it does accept, the result is always
+ * identical to that of the normal parser.
+ */
+typedef struct
+{
+  TokenStream *stream;
+  GString     *token;   /* nul-terminated copy of the current token */
+  GString     *string;  /* unescaped string constant */
+} FastParser;
+
+static const gchar *
+fast_parser_get_token (FastParser *parser)
+{
+  TokenStream *stream = parser->stream;
+
+  if (!token_stream_prepare (stream))
+    return NULL;
+
+  g_string_truncate (parser->token, 0);
+  g_string_append_len (parser->token, stream->this,
+                       stream->stream - stream->this);
+
+  return parser->token->str;
+}
+
+static gboolean fast_parse_value (FastParser         *parser,
+                                  const GVariantType *type,
+                                  GVariantBuilder    *builder);
+
+/* Consumes an optional type declaration.  With an explicit type, the
+ * normal parser only checks that the declaration is valid, so we do the
+ * same.  If @decl_type is non-%NULL the declared type is returned there.
+ */
+static gboolean
+fast_parse_typedecl (FastParser    *parser,
+                     GVariantType **decl_type)
+{
+  static const gchar * const keywords[] = {
+    "boolean", "b", "byte", "y", "int16", "n", "uint16", "q",
+    "int32", "i", "handle", "h", "uint32", "u", "int64", "x",
+    "uint64", "t", "double", "d", "string", "s",
+    "objectpath", "o", "signature", "g"
+  };
+  TokenStream *stream = parser->stream;
+  GVariantType *type;
+  const gchar *token;
+  gint i;
+
+  if (token_stream_peek (stream, '@'))
+    {
+      token = fast_parser_get_token (parser);
+
+      if (!g_variant_type_string_is_valid (token + 1))
+        return FALSE;
+
+      type = g_variant_type_new (token + 1);
+
+      if (!g_variant_type_is_definite (type))
+        {
+          g_variant_type_free (type);
+          return FALSE;
+        }
+
+      if (decl_type)
+        *decl_type = type;
+      else
+        g_variant_type_free (type);
+
+      token_stream_next (stream);
+      return TRUE;
+    }
+
+  if (token_stream_is_keyword (stream))
+    for (i = 0; i < G_N_ELEMENTS (keywords); i += 2)
+      if (token_stream_consume (stream, keywords[i]))
+        {
+          if (decl_type)
+            *decl_type = g_variant_type_new (keywords[i + 1]);
+
+          return TRUE;
+        }
+
+  if (decl_type)
+    *decl_type = NULL;
+
+  return TRUE;
+}
+
+static gboolean
+fast_parse_number (FastParser      *parser,
+                   gchar            type_char,
+                   GVariantBuilder *builder)
+{
+  TokenStream *stream = parser->stream;
+  const gchar *token;
+  gboolean negative;
+  guint64 abs_val;
+  gdouble dbl_val;
+  gchar *end;
+
+  if (!token_stream_is_numeric (stream) &&
+      !token_stream_peek_string (stream, "inf") &&
+      !token_stream_peek_string (stream, "nan"))
+    return FALSE;
+
+  token = fast_parser_get_token (parser);
+
+  if (type_char == 'd')
+    {
+      errno = 0;
+      dbl_val = g_ascii_strtod (token, &end);
+      if ((dbl_val != 0.0 && errno == ERANGE) || *end != '\0')
+        return FALSE;
+
+      token_stream_next (stream);
+      g_variant_builder_add (builder, "d", dbl_val);
+      return TRUE;
+    }
+
+  negative = token[0] == '-';
+  if (token[0] == '-')
+    token++;
+
+  errno = 0;
+  abs_val = g_ascii_strtoull (token, &end, 0);
+  if ((abs_val == G_MAXUINT64 && errno == ERANGE) || *end != '\0')
+    return FALSE;
+
+  if (abs_val == 0)
+    negative = FALSE;
+
+  switch (type_char)
+    {
+    case 'y':
+      if (negative || abs_val > G_MAXUINT8)
+        return FALSE;
+      g_variant_builder_add (builder, "y", (guchar) abs_val);
+      break;
+
+    case 'n':
+      if (abs_val - negative > G_MAXINT16)
+        return FALSE;
+      g_variant_builder_add (builder, "n", (gint16) (negative ? -abs_val : abs_val));
+      break;
+
+    case 'q':
+      if (negative || abs_val > G_MAXUINT16)
+        return FALSE;
+      g_variant_builder_add (builder, "q", (guint16) abs_val);
+      break;
+
+    case 'i':
+    case 'h':
+      if (abs_val - negative > G_MAXINT32)
+        return FALSE;
+      g_variant_builder_add (builder, type_char == 'i' ? "i" : "h",
+                             (gint32) (negative ? -abs_val : abs_val));
+      break;
+
+    case 'u':
+      if (negative || abs_val > G_MAXUINT32)
+        return FALSE;
+      g_variant_builder_add (builder, "u", (guint32) abs_val);
+      break;
+
+    case 'x':
+      if (abs_val - negative > G_MAXINT64)
+        return FALSE;
+      g_variant_builder_add (builder, "x", (gint64) (negative ? -abs_val : abs_val));
+      break;
+
+    case 't':
+      if (negative)
+        return FALSE;
+      g_variant_builder_add (builder, "t", (guint64) abs_val);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  token_stream_next (stream);
+
+  return TRUE;
+}
+
+static gboolean
+fast_parse_string (FastParser      *parser,
+                   gchar            type_char,
+                   GVariantBuilder *builder)
+{
+  TokenStream *stream = parser->stream;
+  const gchar *token;
+  SourceRef ref = { 0, 0 };
+  const gchar *str;
+
+  if (!token_stream_peek (stream, '\'') && !token_stream_peek (stream, '"'))
+    return FALSE;
+
+  token = fast_parser_get_token (parser);
+
+  g_string_set_size (parser->string, parser->token->len);
+  if (!string_unescape (token, parser->string->str, &ref, NULL))
+    return FALSE;
+  str = parser->string->str;
+
+  switch (type_char)
+    {
+    case 's':
+      if (!g_utf8_validate (str, -1, NULL))
+        return FALSE;
+      g_variant_builder_add (builder, "s", str);
+      break;
+
+    case 'o':
+      if (!g_variant_is_object_path (str))
+        return FALSE;
+      g_variant_builder_add (builder, "o", str);
+      break;
+
+    case 'g':
+      if (!g_variant_is_signature (str))
+        return FALSE;
+      g_variant_builder_add (builder, "g", str);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  token_stream_next (stream);
+
+  return TRUE;
+}
+
+/* The type that the normal parser would infer for the contents of a
+ * variant, for the simple cases only.
+ */
+static GVariantType *
+fast_parse_infer (FastParser *parser)
+{
+  TokenStream *stream = parser->stream;
+  GVariantType *type;
+  const gchar *token;
+
+  if (token_stream_peek (stream, '\'') || token_stream_peek (stream, '"'))
+    return g_variant_type_copy (G_VARIANT_TYPE_STRING);
+
+  if (token_stream_peek_string (stream, "true") ||
+      token_stream_peek_string (stream, "false"))
+    return g_variant_type_copy (G_VARIANT_TYPE_BOOLEAN);
+
+  if (token_stream_is_numeric (stream) ||
+      token_stream_peek_string (stream, "inf") ||
+      token_stream_peek_string (stream, "nan"))
+    {
+      /* the same rule as number_get_pattern() */
+      token = fast_parser_get_token (parser);
+
+      if (strchr (token, '.') ||
+          (!g_str_has_prefix (token, "0x") && strchr (token, 'e')) ||
+          strstr (token, "inf") ||
+          strstr (token, "nan"))
+        return g_variant_type_copy (G_VARIANT_TYPE_DOUBLE);
+
+      return g_variant_type_copy (G_VARIANT_TYPE_INT32);
+    }
+
+  if (token_stream_peek (stream, '<'))
+    return g_variant_type_copy (G_VARIANT_TYPE_VARIANT);
+
+  if (token_stream_peek (stream, '@') || token_stream_is_keyword (stream))
+    {
+      /* the normal parser would treat "nothing" and "just" as maybes */
+      if (token_stream_peek (stream, 'n') || token_stream_peek (stream, 'j'))
+        return NULL;
+
+      if (fast_parse_typedecl (parser, &type))
+        return type;
+    }
+
+  return NULL;
+}
+
+/* Parses the bracketed contents of a container of type @type into
+ * @builder, which has been initialised or opened for @type.
+ */
+static gboolean
+fast_parse_contents (FastParser         *parser,
+                     const GVariantType *type,
+                     GVariantBuilder    *builder)
+{
+  TokenStream *stream = parser->stream;
+
+  if (g_variant_type_is_array (type))
+    {
+      const GVariantType *element = g_variant_type_element (type);
+      gboolean need_comma = FALSE;
+
+      if (g_variant_type_is_dict_entry (element) &&
+          token_stream_consume (stream, "{"))
+        {
+          if (token_stream_consume (stream, "}"))
+            return TRUE;
+
+          do
+            {
+              g_variant_builder_open (builder, element);
+
+              if (!fast_parse_value (parser, g_variant_type_key (element), builder) ||
+                  !token_stream_consume (stream, ":") ||
+                  !fast_parse_value (parser, g_variant_type_value (element), builder))
+                return FALSE;
+
+              g_variant_builder_close (builder);
+
+              if (token_stream_consume (stream, "}"))
+                return TRUE;
+            }
+          while (token_stream_consume (stream, ","));
+
+          return FALSE;
+        }
+
+      if (!token_stream_consume (stream, "["))
+        return FALSE;
+
+      while (!token_stream_consume (stream, "]"))
+        {
+          if (need_comma && !token_stream_consume (stream, ","))
+            return FALSE;
+
+          if (!fast_parse_value (parser, element, builder))
+            return FALSE;
+
+          need_comma = TRUE;
+        }
+
+      return TRUE;
+    }
+
+  else if (g_variant_type_is_tuple (type))
+    {
+      const GVariantType *item = g_variant_type_first (type);
+      gboolean need_comma = FALSE;
+      gboolean first = TRUE;
+
+      if (!token_stream_consume (stream, "("))
+        return FALSE;
+
+      while (!token_stream_consume (stream, ")"))
+        {
+          if (item == NULL)
+            return FALSE;
+
+          if (need_comma && !token_stream_consume (stream, ","))
+            return FALSE;
+
+          if (!fast_parse_value (parser, item, builder))
+            return FALSE;
+
+          /* as in tuple_parse(), a comma is always required after the
+           * first item
+           */
+          if (first)
+            {
+              if (!token_stream_consume (stream, ","))
+                return FALSE;
+
+              first = FALSE;
+            }
+          else
+            need_comma = TRUE;
+
+          item = g_variant_type_next (item);
+        }
+
+      return item == NULL;
+    }
+
+  else if (g_variant_type_is_dict_entry (type))
+    {
+      return token_stream_consume (stream, "{") &&
+             fast_parse_value (parser, g_variant_type_key (type), builder) &&
+             token_stream_consume (stream, ",") &&
+             fast_parse_value (parser, g_variant_type_value (type), builder) &&
+             token_stream_consume (stream, "}");
+    }
+
+  else if (g_variant_type_is_variant (type))
+    {
+      GVariantType *child_type;
+      gboolean success;
+
+      if (!token_stream_consume (stream, "<"))
+        return FALSE;
+
+      child_type = fast_parse_infer (parser);
+      if (child_type == NULL)
+        return FALSE;
+
+      success = fast_parse_value (parser, child_type, builder) &&
+                token_stream_consume (stream, ">");
+      g_variant_type_free (child_type);
+
+      return success;
+    }
+
+  return FALSE;
+}
+
+/* Parses one value of type @type and adds it to @builder */
+static gboolean
+fast_parse_value (FastParser         *parser,
+                  const GVariantType *type,
+                  GVariantBuilder    *builder)
+{
+  TokenStream *stream = parser->stream;
+  gchar type_char;
+
+  if (!fast_parse_typedecl (parser, NULL))
+    return FALSE;
+
+  type_char = g_variant_type_peek_string (type)[0];
+
+  switch (type_char)
+    {
+    case 'b':
+      if (token_stream_consume (stream, "true"))
+        g_variant_builder_add (builder, "b", TRUE);
+      else if (token_stream_consume (stream, "false"))
+        g_variant_builder_add (builder, "b", FALSE);
+      else
+        return FALSE;
+      return TRUE;
+
+    case 'y': case 'n': case 'q': case 'i': case 'u':
+    case 'x': case 't': case 'h': case 'd':
+      return fast_parse_number (parser, type_char, builder);
+
+    case 's': case 'o': case 'g':
+      return fast_parse_string (parser, type_char, builder);
+
+    case 'a': case '(': case '{': case 'v':
+      g_variant_builder_open (builder, type);
+      if (!fast_parse_contents (parser, type, builder))
+        return FALSE;
+      g_variant_builder_close (builder);
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Returns a new floating value, or %NULL if the normal parser must be
+ * used instead.  @stream is left in an undefined state in that case.
+ */
+static GVariant *
+fast_parse (TokenStream        *stream,
+            const GVariantType *type)
+{
+  GVariantBuilder builder;
+  FastParser parser;
+  GVariant *result = NULL;
+
+  if (!g_variant_type_is_definite (type) ||
+      !(g_variant_type_is_array (type) || g_variant_type_is_tuple (type) ||
+        g_variant_type_is_dict_entry (type)))
+    return NULL;
+
+  parser.stream = stream;
+  parser.token = g_string_new (NULL);
+  parser.string = g_string_new (NULL);
+
+  g_variant_builder_init_serialised (&builder, type);
+
+  if (fast_parse_typedecl (&parser, NULL) &&
+      fast_parse_contents (&parser, type, &builder))
+    result = g_variant_builder_end (&builder);
+  else
+    g_variant_builder_clear (&builder);
+
+  g_string_free (parser.token, TRUE);
+  g_string_free (parser.string, TRUE);
+
+  return result;
+}
+
 /**
  * g_variant_parse:
  * @type: (allow-none): a #GVariantType, or %NULL
@@ -2363,41 +2872,50 @@ g_variant_parse (const GVariantType  *type,
   stream.stream = text;
   stream.end = limit;
 
-  if ((ast = parse (&stream, NULL, error)))
+  if (type != NULL)
+    result = fast_parse (&stream, type);
+
+  if (result == NULL)
     {
-      if (type == NULL)
-        result = ast_resolve (ast, error);
-      else
-        result = ast_get_value (ast, type, error);
+      stream.stream = text;
+      stream.this = NULL;
 
-      if (result != NULL)
+      if ((ast = parse (&stream, NULL, error)))
         {
-          g_variant_ref_sink (result);
+          if (type == NULL)
+            result = ast_resolve (ast, error);
+          else
+            result = ast_get_value (ast, type, error);
 
-          if (endptr == NULL)
-            {
-              while (stream.stream != limit &&
-                     g_ascii_isspace (*stream.stream))
-                stream.stream++;
+          ast_free (ast);
+        }
+    }
 
-              if (stream.stream != limit && *stream.stream != '\0')
-                {
-                  SourceRef ref = { stream.stream - text,
-                                    stream.stream - text };
+  if (result != NULL)
+    {
+      g_variant_ref_sink (result);
 
-                  parser_set_error (error, &ref, NULL,
-                                    G_VARIANT_PARSE_ERROR_INPUT_NOT_AT_END,
-                                    "expected end of input");
-                  g_variant_unref (result);
+      if (endptr == NULL)
+        {
+          while (stream.stream != limit &&
+                 g_ascii_isspace (*stream.stream))
+            stream.stream++;
 
-                  result = NULL;
-                }
+          if (stream.stream != limit && *stream.stream != '\0')
+            {
+              SourceRef ref = { stream.stream - text,
+                                stream.stream - text };
+
+              parser_set_error (error, &ref, NULL,
+                                G_VARIANT_PARSE_ERROR_INPUT_NOT_AT_END,
+                                "expected end of input");
+              g_variant_unref (result);
+
+              result = NULL;
             }
-          else
-            *endptr = stream.stream;
         }
-
-      ast_free (ast);
+      else
+        *endptr = stream.stream;
     }
 
   return result;
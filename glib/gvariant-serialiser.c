@@ -27,9 +27,22 @@
 
 #include <glib/gtestutils.h>
 #include <glib/gstrfuncs.h>
+#include <glib/gthread.h>
 #include <glib/gtypes.h>
 
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* On x86 processors with SSSE3, arrays of integers are byteswapped 16
+ * bytes at a time; gvs_byteswap_init_accel() picks the implementation.
+ */
+#if defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined (__x86_64__) || defined (__i386__))
+#define GVS_BYTESWAP_X86_ACCEL 1
+#include <immintrin.h>
+#endif
 
 
 /* GVariantSerialiser
@@ -688,6 +701,72 @@ gvs_variable_sized_array_get_child (GVariantSerialised value,
   return child;
 }
 
+/* Same as calling gvs_variable_sized_array_get_child() for each child
+ * in turn, except that the framing offsets are decoded in a single
+ * pass and the type_info field of the children is left unset.
+ */
+static void
+gvs_variable_sized_array_get_children (GVariantSerialised  value,
+                                       GVariantSerialised *children,
+                                       gsize               n_children)
+{
+  GVariantTypeInfo *element_info;
+  const guchar *offsets;
+  gsize offset_size;
+  gsize last_end;
+  guint alignment;
+  gsize prev_end;
+  gsize i;
+
+  if (n_children == 0)
+    return;
+
+  element_info = g_variant_type_info_element (value.type_info);
+  g_variant_type_info_query (element_info, &alignment, NULL);
+
+  offset_size = gvs_get_offset_size (value.size);
+
+  last_end = gvs_read_unaligned_le (value.data + value.size -
+                                    offset_size, offset_size);
+  offsets = value.data + last_end;
+
+  prev_end = 0;
+  for (i = 0; i < n_children; i++)
+    {
+      gsize start, end;
+
+      switch (offset_size)
+        {
+        case 1:
+          end = offsets[i];
+          break;
+
+        case 2:
+          end = offsets[2 * i] | (offsets[2 * i + 1] << 8);
+          break;
+
+        default:
+          end = gvs_read_unaligned_le ((guchar *) offsets + offset_size * i,
+                                       offset_size);
+          break;
+        }
+
+      start = prev_end + ((-prev_end) & alignment);
+      prev_end = end;
+
+      if (start < end && end <= value.size)
+        {
+          children[i].data = value.data + start;
+          children[i].size = end - start;
+        }
+      else
+        {
+          children[i].data = NULL;
+          children[i].size = 0;
+        }
+    }
+}
+
 static gsize
 gvs_variable_sized_array_needed_size (GVariantTypeInfo         *type_info,
                                       GVariantSerialisedFiller  gvs_filler,
@@ -1371,6 +1450,60 @@ g_variant_serialised_get_child (GVariantSerialised serialised,
            index_, g_variant_serialised_n_children (serialised));
 }
 
+/* < private >
+ * g_variant_serialised_get_children:
+ * @serialised: a #GVariantSerialised for a container
+ * @children: an array with room for
+ *            g_variant_serialised_n_children() items
+ *
+ * Fills @children with the result of calling
+ * g_variant_serialised_get_child() for each child of @serialised.
+ *
+ * Unlike g_variant_serialised_get_child(), no reference is held on the
+ * type_info of the children: it is the element type of @serialised and
+ * is only valid as long as @serialised is.
+ *
+ * For arrays of variable-sized elements the framing offsets are decoded
+ * in a single pass, rather than being re-read for each child.
+ */
+void
+g_variant_serialised_get_children (GVariantSerialised  serialised,
+                                   GVariantSerialised *children)
+{
+  gsize n_children;
+  gsize i;
+
+  g_variant_serialised_check (serialised);
+
+  n_children = g_variant_serialised_n_children (serialised);
+
+  if (g_variant_type_info_get_type_char (serialised.type_info) == G_VARIANT_TYPE_INFO_CHAR_ARRAY)
+    {
+      gsize fixed_size;
+
+      g_variant_type_info_query_element (serialised.type_info, NULL, &fixed_size);
+
+      if (!fixed_size)
+        {
+          GVariantTypeInfo *element_info;
+
+          element_info = g_variant_type_info_element (serialised.type_info);
+          gvs_variable_sized_array_get_children (serialised, children, n_children);
+
+          for (i = 0; i < n_children; i++)
+            children[i].type_info = element_info;
+
+          return;
+        }
+    }
+
+  for (i = 0; i < n_children; i++)
+    {
+      children[i] = g_variant_serialised_get_child (serialised, i);
+      g_variant_type_info_unref (children[i].type_info);
+    }
+}
+
 /* < private >
  * g_variant_serialiser_serialise:
  * @serialised: a #GVariantSerialised, properly set up
@@ -1440,8 +1573,164 @@ g_variant_serialiser_needed_size (GVariantTypeInfo         *type_info,
   g_assert_not_reached ();
 }
 
+/* < private >
+ * g_variant_serialiser_array_size:
+ * @body_size: the size of the serialised elements, including padding
+ * @n_offsets: the number of framing offsets
+ *
+ * Determines the total size of a variable-sized array whose elements
+ * have already been serialised into @body_size bytes.  This is used by
+ * #GVariantBuilder when it serialises elements as they are added.
+ */
+gsize
+g_variant_serialiser_array_size (gsize body_size,
+                                 gsize n_offsets)
+{
+  return gvs_calculate_total_size (body_size, n_offsets);
+}
+
+/* < private >
+ * g_variant_serialiser_write_offsets:
+ * @data: the serialised array
+ * @size: the total size of @data, from g_variant_serialiser_array_size()
+ * @offsets: the end offsets of each element
+ * @n_offsets: the length of @offsets
+ *
+ * Writes the framing offsets of a variable-sized array to the end of
+ * @data, in the format that g_variant_serialiser_serialise() would.
+ */
+void
+g_variant_serialiser_write_offsets (guchar      *data,
+                                    gsize        size,
+                                    const gsize *offsets,
+                                    gsize        n_offsets)
+{
+  guint offset_size;
+  guchar *out;
+  gsize i;
+
+  offset_size = gvs_get_offset_size (size);
+  out = data + size - n_offsets * offset_size;
+
+  for (i = 0; i < n_offsets; i++)
+    {
+      gvs_write_unaligned_le (out, offsets[i], offset_size);
+      out += offset_size;
+    }
+}
+
 /* Byteswapping {{{2 */
 
+/* Byteswaps as many whole 16 byte blocks of @width byte integers at
+ * @data as fit in @size bytes.  Returns the number of bytes swapped.
+ */
+typedef gsize (* GvsByteswapBlocks) (guchar *data,
+                                     gsize   size,
+                                     gsize   width);
+
+static GvsByteswapBlocks gvs_byteswap_blocks;
+
+#ifdef GVS_BYTESWAP_X86_ACCEL
+__attribute__ ((target ("ssse3")))
+static gsize
+gvs_byteswap_blocks_ssse3 (guchar *data,
+                           gsize   size,
+                           gsize   width)
+{
+  __m128i mask;
+  gsize i;
+
+  switch (width)
+    {
+    case 2:
+      mask = _mm_setr_epi8 (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+      break;
+
+    case 4:
+      mask = _mm_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+      break;
+
+    case 8:
+      mask = _mm_setr_epi8 (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  for (i = 0; i + 16 <= size; i += 16)
+    {
+      __m128i block = _mm_loadu_si128 ((const __m128i *) (data + i));
+
+      _mm_storeu_si128 ((__m128i *) (data + i), _mm_shuffle_epi8 (block, mask));
+    }
+
+  return i;
+}
+#endif /* GVS_BYTESWAP_X86_ACCEL */
+
+static void
+gvs_byteswap_init_accel (void)
+{
+  static gsize initialised = 0;
+
+  if (g_once_init_enter (&initialised))
+    {
+#ifdef GVS_BYTESWAP_X86_ACCEL
+      if (__builtin_cpu_supports ("ssse3"))
+        gvs_byteswap_blocks = gvs_byteswap_blocks_ssse3;
+#endif
+
+      g_once_init_leave (&initialised, 1);
+    }
+}
+
+/* Byteswaps the @size bytes at @data as an array of @width byte
+ * integers, which must be aligned to @width.
+ */
+static void
+gvs_byteswap_integers (guchar *data,
+                       gsize   size,
+                       gsize   width)
+{
+  gsize i = 0;
+
+  gvs_byteswap_init_accel ();
+
+  if (gvs_byteswap_blocks != NULL)
+    i = gvs_byteswap_blocks (data, size, width);
+
+  switch (width)
+    {
+    case 2:
+      for (; i < size; i += 2)
+        {
+          guint16 *ptr = (guint16 *) (data + i);
+          *ptr = GUINT16_SWAP_LE_BE (*ptr);
+        }
+      break;
+
+    case 4:
+      for (; i < size; i += 4)
+        {
+          guint32 *ptr = (guint32 *) (data + i);
+          *ptr = GUINT32_SWAP_LE_BE (*ptr);
+        }
+      break;
+
+    case 8:
+      for (; i < size; i += 8)
+        {
+          guint64 *ptr = (guint64 *) (data + i);
+          *ptr = GUINT64_SWAP_LE_BE (*ptr);
+        }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
 /* < private >
  * g_variant_serialised_byteswap:
  * @value: a #GVariantSerialised
@@ -1515,6 +1804,40 @@ g_variant_serialised_byteswap (GVariantSerialised serialised)
     {
       gsize children, i;
 
+      /* arrays of fixed-sized elements are swapped in place without
+       * looking up each child.  if the elements are integers then the
+       * whole array is swapped at once.
+       */
+      if (g_variant_type_info_get_type_char (serialised.type_info) == G_VARIANT_TYPE_INFO_CHAR_ARRAY)
+        {
+          GVariantSerialised child;
+          gsize element_size;
+          guint element_alignment;
+
+          g_variant_type_info_query_element (serialised.type_info, &element_alignment, &element_size);
+
+          if (element_size)
+            {
+              children = serialised.size / element_size;
+
+              if (element_alignment + 1 == element_size)
+                {
+                  gvs_byteswap_integers (serialised.data, children * element_size, element_size);
+                  return;
+                }
+
+              child.type_info = g_variant_type_info_element (serialised.type_info);
+              child.size = element_size;
+              for (i = 0; i < children; i++)
+                {
+                  child.data = serialised.data + i * element_size;
+                  g_variant_serialised_byteswap (child);
+                }
+
+              return;
+            }
+        }
+
       children = g_variant_serialised_n_children (serialised);
       for (i = 0; i < children; i++)
         {
@@ -1583,7 +1906,76 @@ g_variant_serialised_is_normal (GVariantSerialised serialised)
 /* Validity-checking functions {{{2
  *
  * Checks if strings, object paths and signature strings are valid.
+ *
+ * Most strings are plain ASCII, so they are first skipped over a block
+ * at a time for as long as the blocks hold nothing but bytes in the
+ * range 0x01 to 0x7f; those are valid UTF-8 on their own.  The rest
+ * of the string, if any, goes through g_utf8_validate().  Object paths
+ * and signatures may only contain ASCII anyway, so they don't need the
+ * UTF-8 check at all.
+ */
+
+#ifdef __SSE2__
+#define STRING_BLOCK_SIZE 16
+
+static inline gboolean
+string_block_is_ascii (const gchar *block)
+{
+  __m128i bytes = _mm_loadu_si128 ((const __m128i *) block);
+  __m128i nuls = _mm_cmpeq_epi8 (bytes, _mm_setzero_si128 ());
+
+  /* the top bit of each byte is set for 0x80 to 0xff, and for nul */
+  return _mm_movemask_epi8 (_mm_or_si128 (bytes, nuls)) == 0;
+}
+
+/* Whether the block only has [A-Z][a-z][0-9]_ and slashes, and no two
+ * slashes in sequence.  @after_slash is whether the byte before the
+ * block is a slash.
  */
+static inline gboolean
+object_path_block_is_valid (const gchar *block,
+                            gboolean     after_slash)
+{
+  __m128i bytes = _mm_loadu_si128 ((const __m128i *) block);
+  __m128i folded = _mm_or_si128 (bytes, _mm_set1_epi8 (0x20));
+  __m128i valid, slashes;
+  guint slash_mask;
+
+  /* Bytes from 0x80 on are negative here, so fail all the ranges */
+  valid = _mm_and_si128 (_mm_cmpgt_epi8 (bytes, _mm_set1_epi8 ('0' - 1)),
+                         _mm_cmplt_epi8 (bytes, _mm_set1_epi8 ('9' + 1)));
+  valid = _mm_or_si128 (valid,
+                        _mm_and_si128 (_mm_cmpgt_epi8 (folded, _mm_set1_epi8 ('a' - 1)),
+                                       _mm_cmplt_epi8 (folded, _mm_set1_epi8 ('z' + 1))));
+  valid = _mm_or_si128 (valid, _mm_cmpeq_epi8 (bytes, _mm_set1_epi8 ('_')));
+  slashes = _mm_cmpeq_epi8 (bytes, _mm_set1_epi8 ('/'));
+  valid = _mm_or_si128 (valid, slashes);
+
+  if (_mm_movemask_epi8 (valid) != 0xffff)
+    return FALSE;
+
+  slash_mask = _mm_movemask_epi8 (slashes);
+
+  return (slash_mask & ((slash_mask << 1) | (after_slash ? 1 : 0))) == 0;
+}
+#else
+#define STRING_BLOCK_SIZE 8
+
+static inline gboolean
+string_block_is_ascii (const gchar *block)
+{
+  guint64 word;
+
+  memcpy (&word, block, sizeof word);
+
+  /* The top bit of a byte is set for 0x80 to 0xff, and by subtracting
+   * one from a nul.  The borrow from that may flag the next byte too,
+   * which doesn't matter since this one already fails.
+   */
+  return (((word - G_GUINT64_CONSTANT (0x0101010101010101)) | word) &
+          G_GUINT64_CONSTANT (0x8080808080808080)) == 0;
+}
+#endif
 
 /* < private >
  * g_variant_serialiser_is_string:
@@ -1597,18 +1989,23 @@ gboolean
 g_variant_serialiser_is_string (gconstpointer data,
                                 gsize         size)
 {
+  const gchar *string = data;
   const gchar *expected_end;
   const gchar *end;
 
   if (size == 0)
     return FALSE;
 
-  expected_end = ((gchar *) data) + size - 1;
+  expected_end = string + size - 1;
 
   if (*expected_end != '\0')
     return FALSE;
 
-  g_utf8_validate (data, size, &end);
+  while (expected_end - string >= STRING_BLOCK_SIZE &&
+         string_block_is_ascii (string))
+    string += STRING_BLOCK_SIZE;
+
+  g_utf8_validate (string, expected_end - string + 1, &end);
 
   return end == expected_end;
 }
@@ -1630,14 +2027,26 @@ g_variant_serialiser_is_object_path (gconstpointer data,
   const gchar *string = data;
   gsize i;
 
-  if (!g_variant_serialiser_is_string (data, size))
+  /* Only ASCII is allowed below, so there's no need to validate UTF-8;
+   * the nul terminator has to be there, and be the only one.
+   */
+  if (size == 0 || string[size - 1] != '\0')
     return FALSE;
 
   /* The path must begin with an ASCII '/' (integer 47) character */
   if (string[0] != '/')
     return FALSE;
 
-  for (i = 1; string[i]; i++)
+  i = 1;
+
+#ifdef __SSE2__
+  /* The block that fails, if any, is looked at again below */
+  while (size - 1 - i >= STRING_BLOCK_SIZE &&
+         object_path_block_is_valid (string + i, string[i - 1] == '/'))
+    i += STRING_BLOCK_SIZE;
+#endif
+
+  for (; string[i]; i++)
     /* Each element must only contain the ASCII characters
      * "[A-Z][a-z][0-9]_"
      */
@@ -1656,6 +2065,10 @@ g_variant_serialiser_is_object_path (gconstpointer data,
     else
       return FALSE;
 
+  /* No nul may be embedded */
+  if (i != size - 1)
+    return FALSE;
+
   /* A trailing '/' character is not allowed unless the path is the
    * root path (a single '/' character).
    */
@@ -1682,12 +2095,15 @@ g_variant_serialiser_is_signature (gconstpointer data,
   const gchar *string = data;
   gsize first_invalid;
 
-  if (!g_variant_serialiser_is_string (data, size))
+  if (size == 0 || string[size - 1] != '\0')
     return FALSE;
 
-  /* make sure no non-definite characters appear */
+  /* make sure no non-definite characters appear; as those are all
+   * ASCII, this also takes care of the checks for being a valid string,
+   * given that the only nul is the one at the end
+   */
   first_invalid = strspn (string, "ybnqiuxthdvasog(){}");
-  if (string[first_invalid])
+  if (first_invalid != size - 1)
     return FALSE;
 
   /* make sure each type string is well-formed */
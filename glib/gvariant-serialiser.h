@@ -38,6 +38,9 @@ gsize                           g_variant_serialised_n_children         (GVarian
 GLIB_AVAILABLE_IN_ALL
 GVariantSerialised              g_variant_serialised_get_child          (GVariantSerialised        container,
                                                                          gsize                     index);
+GLIB_AVAILABLE_IN_ALL
+void                            g_variant_serialised_get_children       (GVariantSerialised        container,
+                                                                         GVariantSerialised       *children);
 
 /* serialisation */
 typedef void                  (*GVariantSerialisedFiller)               (GVariantSerialised       *serialised,
@@ -55,6 +58,15 @@ void                            g_variant_serialiser_serialise          (GVarian
                                                                          const gpointer           *children,
                                                                          gsize                     n_children);
 
+GLIB_AVAILABLE_IN_ALL
+gsize                           g_variant_serialiser_array_size         (gsize                     body_size,
+                                                                         gsize                     n_offsets);
+GLIB_AVAILABLE_IN_ALL
+void                            g_variant_serialiser_write_offsets      (guchar                   *data,
+                                                                         gsize                     size,
+                                                                         const gsize              *offsets,
+                                                                         gsize                     n_offsets);
+
 /* misc */
 GLIB_AVAILABLE_IN_ALL
 gboolean                        g_variant_serialised_is_normal          (GVariantSerialised        value);
@@ -1023,6 +1023,9 @@ g_variant_lookup (GVariant    *dictionary,
  * returned.  If @expected_type was specified then any non-%NULL return
  * value will have this type.
  *
+ * This function is currently implemented with a linear scan.  If you
+ * plan to do many lookups then #GVariantDict may be more efficient.
+ *
  * Returns: (transfer full): the value of the dictionary key, or %NULL
  *
  * Since: 2.28
@@ -1032,9 +1035,9 @@ g_variant_lookup_value (GVariant           *dictionary,
                         const gchar        *key,
                         const GVariantType *expected_type)
 {
-  GVariantIter iter;
   GVariant *entry;
   GVariant *value;
+  gssize index_;
 
   g_return_val_if_fail (g_variant_is_of_type (dictionary,
                                               G_VARIANT_TYPE ("a{s*}")) ||
@@ -1042,26 +1045,12 @@ g_variant_lookup_value (GVariant           *dictionary,
                                               G_VARIANT_TYPE ("a{o*}")),
                         NULL);
 
-  g_variant_iter_init (&iter, dictionary);
-
-  while ((entry = g_variant_iter_next_value (&iter)))
-    {
-      GVariant *entry_key;
-      gboolean matches;
-
-      entry_key = g_variant_get_child_value (entry, 0);
-      matches = strcmp (g_variant_get_string (entry_key, NULL), key) == 0;
-      g_variant_unref (entry_key);
-
-      if (matches)
-        break;
-
-      g_variant_unref (entry);
-    }
+  index_ = g_variant_find_dict_key (dictionary, key);
 
-  if (entry == NULL)
+  if (index_ < 0)
     return NULL;
 
+  entry = g_variant_get_child_value (dictionary, index_);
   value = g_variant_get_child_value (entry, 1);
   g_variant_unref (entry);
 
@@ -1574,6 +1563,102 @@ g_variant_new_strv (const gchar * const *strv,
                                       strings, length, TRUE);
 }
 
+/* Gets borrowed pointers to the strings in @value, which is an array of
+ * strings, object paths or bytestrings, as a %NULL-terminated array.
+ * Each string is what g_variant_get_string() or
+ * g_variant_get_bytestring() would return for that child.
+ *
+ * If @value is in serialised form then its framing offsets are decoded
+ * in one pass and no child instances are created.
+ */
+static const gchar **
+g_variant_get_string_array (GVariant *value,
+                            gsize    *length)
+{
+  GVariantSerialised *children;
+  const gchar **strv;
+  gboolean trusted;
+  gchar element;
+  gsize n;
+  gsize i;
+
+  n = g_variant_n_children (value);
+  strv = g_new (const gchar *, n + 1);
+  children = g_new (GVariantSerialised, n);
+
+  element = g_variant_get_type_string (value)[1];
+  trusted = g_variant_is_trusted (value);
+
+  if (g_variant_get_serialised_children (value, children))
+    {
+      for (i = 0; i < n; i++)
+        {
+          const gchar *string = (const gchar *) children[i].data;
+          gsize size = children[i].size;
+
+          switch (element)
+            {
+            case G_VARIANT_CLASS_STRING:
+              if (!trusted && !g_variant_serialiser_is_string (string, size))
+                string = "";
+              break;
+
+            case G_VARIANT_CLASS_OBJECT_PATH:
+              if (!trusted && !g_variant_serialiser_is_object_path (string, size))
+                string = "/";
+              break;
+
+            default: /* bytestring */
+              if (!size || string[size - 1] != '\0')
+                string = "";
+              break;
+            }
+
+          strv[i] = string;
+        }
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        {
+          GVariant *child;
+
+          child = g_variant_get_child_value (value, i);
+          if (element == G_VARIANT_CLASS_ARRAY)
+            strv[i] = g_variant_get_bytestring (child);
+          else
+            strv[i] = g_variant_get_string (child, NULL);
+          g_variant_unref (child);
+        }
+    }
+  strv[n] = NULL;
+
+  g_free (children);
+
+  if (length)
+    *length = n;
+
+  return strv;
+}
+
+/* The same as g_variant_get_string_array(), but with copies of the
+ * strings.
+ */
+static gchar **
+g_variant_dup_string_array (GVariant *value,
+                            gsize    *length)
+{
+  gchar **strv;
+  gsize i;
+
+  strv = (gchar **) g_variant_get_string_array (value, length);
+
+  for (i = 0; strv[i]; i++)
+    strv[i] = g_strdup (strv[i]);
+
+  return strv;
+}
+
 /**
  * g_variant_get_strv:
  * @value: an array of strings #GVariant
@@ -1598,30 +1683,11 @@ const gchar **
 g_variant_get_strv (GVariant *value,
                     gsize    *length)
 {
-  const gchar **strv;
-  gsize n;
-  gsize i;
-
   TYPE_CHECK (value, G_VARIANT_TYPE_STRING_ARRAY, NULL);
 
   g_variant_get_data (value);
-  n = g_variant_n_children (value);
-  strv = g_new (const gchar *, n + 1);
-
-  for (i = 0; i < n; i++)
-    {
-      GVariant *string;
-
-      string = g_variant_get_child_value (value, i);
-      strv[i] = g_variant_get_string (string, NULL);
-      g_variant_unref (string);
-    }
-  strv[i] = NULL;
-
-  if (length)
-    *length = n;
 
-  return strv;
+  return g_variant_get_string_array (value, length);
 }
 
 /**
@@ -1648,29 +1714,9 @@ gchar **
 g_variant_dup_strv (GVariant *value,
                     gsize    *length)
 {
-  gchar **strv;
-  gsize n;
-  gsize i;
-
   TYPE_CHECK (value, G_VARIANT_TYPE_STRING_ARRAY, NULL);
 
-  n = g_variant_n_children (value);
-  strv = g_new (gchar *, n + 1);
-
-  for (i = 0; i < n; i++)
-    {
-      GVariant *string;
-
-      string = g_variant_get_child_value (value, i);
-      strv[i] = g_variant_dup_string (string, NULL);
-      g_variant_unref (string);
-    }
-  strv[i] = NULL;
-
-  if (length)
-    *length = n;
-
-  return strv;
+  return g_variant_dup_string_array (value, length);
 }
 
 /**
@@ -1734,30 +1780,11 @@ const gchar **
 g_variant_get_objv (GVariant *value,
                     gsize    *length)
 {
-  const gchar **strv;
-  gsize n;
-  gsize i;
-
   TYPE_CHECK (value, G_VARIANT_TYPE_OBJECT_PATH_ARRAY, NULL);
 
   g_variant_get_data (value);
-  n = g_variant_n_children (value);
-  strv = g_new (const gchar *, n + 1);
-
-  for (i = 0; i < n; i++)
-    {
-      GVariant *string;
-
-      string = g_variant_get_child_value (value, i);
-      strv[i] = g_variant_get_string (string, NULL);
-      g_variant_unref (string);
-    }
-  strv[i] = NULL;
-
-  if (length)
-    *length = n;
 
-  return strv;
+  return g_variant_get_string_array (value, length);
 }
 
 /**
@@ -1784,29 +1811,9 @@ gchar **
 g_variant_dup_objv (GVariant *value,
                     gsize    *length)
 {
-  gchar **strv;
-  gsize n;
-  gsize i;
-
   TYPE_CHECK (value, G_VARIANT_TYPE_OBJECT_PATH_ARRAY, NULL);
 
-  n = g_variant_n_children (value);
-  strv = g_new (gchar *, n + 1);
-
-  for (i = 0; i < n; i++)
-    {
-      GVariant *string;
-
-      string = g_variant_get_child_value (value, i);
-      strv[i] = g_variant_dup_string (string, NULL);
-      g_variant_unref (string);
-    }
-  strv[i] = NULL;
-
-  if (length)
-    *length = n;
-
-  return strv;
+  return g_variant_dup_string_array (value, length);
 }
 
 
@@ -1971,30 +1978,11 @@ const gchar **
 g_variant_get_bytestring_array (GVariant *value,
                                 gsize    *length)
 {
-  const gchar **strv;
-  gsize n;
-  gsize i;
-
   TYPE_CHECK (value, G_VARIANT_TYPE_BYTESTRING_ARRAY, NULL);
 
   g_variant_get_data (value);
-  n = g_variant_n_children (value);
-  strv = g_new (const gchar *, n + 1);
-
-  for (i = 0; i < n; i++)
-    {
-      GVariant *string;
-
-      string = g_variant_get_child_value (value, i);
-      strv[i] = g_variant_get_bytestring (string);
-      g_variant_unref (string);
-    }
-  strv[i] = NULL;
-
-  if (length)
-    *length = n;
 
-  return strv;
+  return g_variant_get_string_array (value, length);
 }
 
 /**
@@ -2021,30 +2009,11 @@ gchar **
 g_variant_dup_bytestring_array (GVariant *value,
                                 gsize    *length)
 {
-  gchar **strv;
-  gsize n;
-  gsize i;
-
   TYPE_CHECK (value, G_VARIANT_TYPE_BYTESTRING_ARRAY, NULL);
 
   g_variant_get_data (value);
-  n = g_variant_n_children (value);
-  strv = g_new (gchar *, n + 1);
-
-  for (i = 0; i < n; i++)
-    {
-      GVariant *string;
 
-      string = g_variant_get_child_value (value, i);
-      strv[i] = g_variant_dup_bytestring (string, NULL);
-      g_variant_unref (string);
-    }
-  strv[i] = NULL;
-
-  if (length)
-    *length = n;
-
-  return strv;
+  return g_variant_dup_string_array (value, length);
 }
 
 /* Type checking and querying {{{1 */
@@ -3166,6 +3135,21 @@ struct stack_builder
    */
   guint trusted : 1;
 
+  /* set to '1' if the builder was initialised with
+   * g_variant_builder_init_serialised() for a definite array type.
+   * items are then serialised directly into 'data' as they are added
+   * and 'children' is unused.  for variable-sized elements the end
+   * offset of each item is recorded in 'offsets', which has room for
+   * 'allocated_children' entries.
+   */
+  guint serialised : 1;
+
+  GVariantTypeInfo *element_info;
+  guchar *data;
+  gsize data_size;
+  gsize allocated_data;
+  gsize *offsets;
+
   gsize magic;
 };
 
@@ -3303,10 +3287,19 @@ g_variant_builder_clear (GVariantBuilder *builder)
 
   g_variant_type_free (GVSB(builder)->type);
 
-  for (i = 0; i < GVSB(builder)->offset; i++)
-    g_variant_unref (GVSB(builder)->children[i]);
+  if (GVSB(builder)->serialised)
+    {
+      g_variant_type_info_unref (GVSB(builder)->element_info);
+      g_free (GVSB(builder)->offsets);
+      g_free (GVSB(builder)->data);
+    }
+  else
+    {
+      for (i = 0; i < GVSB(builder)->offset; i++)
+        g_variant_unref (GVSB(builder)->children[i]);
 
-  g_free (GVSB(builder)->children);
+      g_free (GVSB(builder)->children);
+    }
 
   if (GVSB(builder)->parent)
     {
@@ -3429,6 +3422,49 @@ g_variant_builder_init (GVariantBuilder    *builder,
                                    GVSB(builder)->allocated_children);
 }
 
+/**
+ * g_variant_builder_init_serialised: (skip)
+ * @builder: a #GVariantBuilder
+ * @type: a container type
+ *
+ * Initialises a #GVariantBuilder structure in the same way as
+ * g_variant_builder_init(), but if @type is a definite array type then
+ * each item is serialised into the array as soon as it is added,
+ * rather than being kept as a separate #GVariant until
+ * g_variant_builder_end() is called.
+ *
+ * This makes a large difference when building big arrays.  In
+ * particular, adding items of a basic type with g_variant_builder_add()
+ * using a format string that consists of just the type character (such
+ * as "s" or "u") does not allocate any memory per item at all.
+ *
+ * If @type is not a definite array type then this function is
+ * equivalent to g_variant_builder_init().  The builder is otherwise used
+ * in exactly the same way, and the result of g_variant_builder_end() is
+ * the same.
+ *
+ * Since: 2.40
+ **/
+void
+g_variant_builder_init_serialised (GVariantBuilder    *builder,
+                                   const GVariantType *type)
+{
+  g_return_if_fail (type != NULL);
+
+  g_variant_builder_init (builder, type);
+
+  if (!g_variant_type_is_array (type) || !g_variant_type_is_definite (type))
+    return;
+
+  g_free (GVSB(builder)->children);
+  GVSB(builder)->children = NULL;
+  GVSB(builder)->allocated_children = 0;
+
+  GVSB(builder)->serialised = TRUE;
+  GVSB(builder)->element_info =
+    g_variant_type_info_get (GVSB(builder)->expected_type);
+}
+
 static void
 g_variant_builder_make_room (struct stack_builder *builder)
 {
@@ -3440,6 +3476,53 @@ g_variant_builder_make_room (struct stack_builder *builder)
     }
 }
 
+/* Reserves @size bytes for the next item of a serialised-mode builder,
+ * after any padding needed for alignment, and returns a pointer to
+ * them.  The caller must fill them in.
+ */
+static guchar *
+g_variant_builder_append_item (struct stack_builder *builder,
+                               gsize                 size)
+{
+  gsize fixed_size;
+  guint alignment;
+  gsize start;
+
+  g_variant_type_info_query (builder->element_info, &alignment, &fixed_size);
+
+  start = builder->data_size;
+
+  if (!fixed_size)
+    {
+      /* variable-sized items are padded to their alignment and have
+       * their end offset recorded for the framing offsets
+       */
+      start += (-start) & alignment;
+
+      if (builder->offset == builder->allocated_children)
+        {
+          builder->allocated_children = MAX (8, builder->allocated_children * 2);
+          builder->offsets = g_renew (gsize, builder->offsets,
+                                      builder->allocated_children);
+        }
+
+      builder->offsets[builder->offset] = start + size;
+    }
+
+  if (start + size > builder->allocated_data)
+    {
+      builder->allocated_data = MAX (start + size,
+                                     MAX (64, builder->allocated_data * 2));
+      builder->data = g_realloc (builder->data, builder->allocated_data);
+    }
+
+  memset (builder->data + builder->data_size, 0, start - builder->data_size);
+  builder->data_size = start + size;
+  builder->offset++;
+
+  return builder->data + start;
+}
+
 /**
  * g_variant_builder_add_value:
  * @builder: a #GVariantBuilder
@@ -3473,6 +3556,18 @@ g_variant_builder_add_value (GVariantBuilder *builder,
 
   GVSB(builder)->trusted &= g_variant_is_trusted (value);
 
+  if (GVSB(builder)->serialised)
+    {
+      gsize size;
+
+      g_variant_ref_sink (value);
+      size = g_variant_get_size (value);
+      g_variant_store (value, g_variant_builder_append_item (GVSB(builder), size));
+      g_variant_unref (value);
+
+      return;
+    }
+
   if (!GVSB(builder)->uniform_item_types)
     {
       /* advance our expected type pointers */
@@ -3523,7 +3618,12 @@ g_variant_builder_open (GVariantBuilder    *builder,
                                                   type));
 
   parent = g_slice_dup (GVariantBuilder, builder);
-  g_variant_builder_init (builder, type);
+
+  if (GVSB(parent)->serialised)
+    g_variant_builder_init_serialised (builder, type);
+  else
+    g_variant_builder_init (builder, type);
+
   GVSB(builder)->parent = parent;
 
   /* push the prev_item_type down into the subcontainer */
@@ -3595,6 +3695,44 @@ g_variant_make_array_type (GVariant *element)
   return g_variant_type_new_array (g_variant_get_type (element));
 }
 
+/*< private >
+ * g_variant_builder_end_serialised:
+ * @builder: a #GVariantBuilder in serialised mode
+ *
+ * Appends the framing offsets (if any) to the data that was serialised
+ * so far and wraps it up as a #GVariant.
+ */
+static GVariant *
+g_variant_builder_end_serialised (GVariantBuilder *builder)
+{
+  GVariant *value;
+  GBytes *bytes;
+  gsize size;
+
+  size = GVSB(builder)->data_size;
+
+  if (GVSB(builder)->offsets != NULL)
+    {
+      size = g_variant_serialiser_array_size (size, GVSB(builder)->offset);
+      GVSB(builder)->data = g_realloc (GVSB(builder)->data, size);
+      g_variant_serialiser_write_offsets (GVSB(builder)->data, size,
+                                          GVSB(builder)->offsets,
+                                          GVSB(builder)->offset);
+    }
+  else if (size < GVSB(builder)->allocated_data)
+    GVSB(builder)->data = g_realloc (GVSB(builder)->data, size);
+
+  bytes = g_bytes_new_take (GVSB(builder)->data, size);
+  value = g_variant_new_from_bytes (GVSB(builder)->type, bytes,
+                                    GVSB(builder)->trusted);
+  g_bytes_unref (bytes);
+
+  GVSB(builder)->data = NULL;
+  g_variant_builder_clear (builder);
+
+  return value;
+}
+
 /**
  * g_variant_builder_end:
  * @builder: a #GVariantBuilder
@@ -3632,6 +3770,9 @@ g_variant_builder_end (GVariantBuilder *builder)
                         g_variant_type_is_definite (GVSB(builder)->type),
                         NULL);
 
+  if (GVSB(builder)->serialised)
+    return g_variant_builder_end_serialised (builder);
+
   if (g_variant_type_is_definite (GVSB(builder)->type))
     my_type = g_variant_type_copy (GVSB(builder)->type);
 
@@ -3666,6 +3807,447 @@ g_variant_builder_end (GVariantBuilder *builder)
   return value;
 }
 
+/* GVariantDict {{{1 */
+
+/**
+ * GVariantDict:
+ *
+ * #GVariantDict is a mutable interface to #GVariant dictionaries.
+ *
+ * It can be used for doing a sequence of dictionary lookups in an
+ * efficient way on an existing #GVariant dictionary or it can be used
+ * to construct new dictionaries with a hashtable-like interface.  It
+ * can also be used for taking existing dictionaries and modifying them
+ * in order to create new ones.
+ *
+ * #GVariantDict can only be used with %G_VARIANT_TYPE_VARDICT
+ * dictionaries.
+ *
+ * It is possible to use #GVariantDict allocated on the stack or on the
+ * heap.  When using a stack-allocated #GVariantDict, you begin with a
+ * call to g_variant_dict_init() and free the resources with a call to
+ * g_variant_dict_clear().
+ *
+ * Heap-allocated #GVariantDict follows normal refcounting rules: you
+ * allocate it with g_variant_dict_new() and use g_variant_dict_ref()
+ * and g_variant_dict_unref().
+ *
+ * g_variant_dict_end() is used to convert the #GVariantDict back into a
+ * dictionary-type #GVariant.  When used with stack-allocated instances,
+ * this also implicitly frees all associated memory, but for
+ * heap-allocated instances, you must still call g_variant_dict_unref()
+ * afterwards.
+ *
+ * Since: 2.40
+ **/
+
+struct stack_dict
+{
+  GHashTable *values;
+  gsize magic;
+};
+
+G_STATIC_ASSERT (sizeof (struct stack_dict) <= sizeof (GVariantDict));
+
+struct heap_dict
+{
+  struct stack_dict dict;
+  gint ref_count;
+  gsize magic;
+};
+
+#define GVSD(d)                 ((struct stack_dict *) (d))
+#define GVHD(d)                 ((struct heap_dict *) (d))
+#define GVSD_MAGIC              ((gsize) 2579507750u)
+#define GVHD_MAGIC              ((gsize) 2450270775u)
+#define is_valid_dict(d)        (d != NULL && \
+                                 GVSD(d)->magic == GVSD_MAGIC)
+#define is_valid_heap_dict(d)   (GVHD(d)->magic == GVHD_MAGIC)
+
+/**
+ * g_variant_dict_new:
+ * @from_asv: (allow-none): the #GVariant with which to initialise the
+ *   dictionary
+ *
+ * Allocates and initialises a new #GVariantDict.
+ *
+ * You should call g_variant_dict_unref() on the return value when it
+ * is no longer needed.  The memory will not be automatically freed by
+ * any other call.
+ *
+ * In some cases it may be easier to place a #GVariantDict directly on
+ * the stack of the calling function and initialise it with
+ * g_variant_dict_init().  This is particularly useful when you are
+ * using #GVariantDict to construct a #GVariant.
+ *
+ * Returns: (transfer full): a #GVariantDict
+ *
+ * Since: 2.40
+ **/
+GVariantDict *
+g_variant_dict_new (GVariant *from_asv)
+{
+  GVariantDict *dict;
+
+  dict = g_slice_alloc (sizeof (struct heap_dict));
+  g_variant_dict_init (dict, from_asv);
+  GVHD(dict)->magic = GVHD_MAGIC;
+  GVHD(dict)->ref_count = 1;
+
+  return dict;
+}
+
+/**
+ * g_variant_dict_init: (skip)
+ * @dict: a #GVariantDict
+ * @from_asv: (allow-none): the initial value for @dict
+ *
+ * Initialises a #GVariantDict structure.
+ *
+ * If @from_asv is given, it is used to initialise the dictionary.  Each
+ * entry is unpacked once, so later lookups do not need to scan
+ * @from_asv again.
+ *
+ * This function completely ignores the previous contents of @dict.  On
+ * one hand this means that it is valid to pass in completely
+ * uninitialised memory.  On the other hand, this means that if you are
+ * initialising over top of an existing #GVariantDict you need to first
+ * call g_variant_dict_clear() in order to avoid leaking memory.
+ *
+ * You must not call g_variant_dict_ref() or g_variant_dict_unref() on a
+ * #GVariantDict that was initialised with this function.  If you ever
+ * pass a reference to a #GVariantDict outside of the control of your
+ * own code then you should assume that the person receiving that
+ * reference may try to use reference counting; you should use
+ * g_variant_dict_new() instead of this function.
+ *
+ * Since: 2.40
+ **/
+void
+g_variant_dict_init (GVariantDict *dict,
+                     GVariant     *from_asv)
+{
+  GVariantIter iter;
+  gchar *key;
+  GVariant *value;
+
+  GVSD(dict)->values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+  GVSD(dict)->magic = GVSD_MAGIC;
+
+  if (from_asv)
+    {
+      g_variant_iter_init (&iter, from_asv);
+      while (g_variant_iter_next (&iter, "{sv}", &key, &value))
+        g_hash_table_insert (GVSD(dict)->values, key, value);
+    }
+}
+
+/**
+ * g_variant_dict_lookup:
+ * @dict: a #GVariantDict
+ * @key: the key to lookup in the dictionary
+ * @format_string: a GVariant format string
+ * @...: the arguments to unpack the value into
+ *
+ * Looks up a value in a #GVariantDict.
+ *
+ * This function is a wrapper around g_variant_dict_lookup_value() and
+ * g_variant_get().  In the case that %NULL would have been returned,
+ * this function returns %FALSE.  Otherwise, it unpacks the returned
+ * value and returns %TRUE.
+ *
+ * @format_string determines the C types that are used for unpacking the
+ * values and also determines if the values are copied or borrowed, see the
+ * section on <link linkend='gvariant-format-strings-pointers'>GVariant
+ * Format Strings</link>.
+ *
+ * Returns: %TRUE if a value was unpacked
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_dict_lookup (GVariantDict *dict,
+                       const gchar  *key,
+                       const gchar  *format_string,
+                       ...)
+{
+  GVariant *value;
+  va_list ap;
+
+  g_return_val_if_fail (is_valid_dict (dict), FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+  g_return_val_if_fail (format_string != NULL, FALSE);
+
+  value = g_hash_table_lookup (GVSD(dict)->values, key);
+
+  if (value == NULL || !g_variant_check_format_string (value, format_string, FALSE))
+    return FALSE;
+
+  va_start (ap, format_string);
+  g_variant_get_va (value, format_string, NULL, &ap);
+  va_end (ap);
+
+  return TRUE;
+}
+
+/**
+ * g_variant_dict_lookup_value:
+ * @dict: a #GVariantDict
+ * @key: the key to lookup in the dictionary
+ * @expected_type: (allow-none): a #GVariantType, or %NULL
+ *
+ * Looks up a value in a #GVariantDict.
+ *
+ * If @key is not found in @dictionary, %NULL is returned.
+ *
+ * The @expected_type string specifies what type of value is expected.
+ * If the value associated with @key has a different type then %NULL is
+ * returned.
+ *
+ * If the key is found and the value has the correct type, it is
+ * returned.  If @expected_type was specified then any non-%NULL return
+ * value will have this type.
+ *
+ * Returns: (transfer full): the value of the dictionary key, or %NULL
+ *
+ * Since: 2.40
+ **/
+GVariant *
+g_variant_dict_lookup_value (GVariantDict       *dict,
+                             const gchar        *key,
+                             const GVariantType *expected_type)
+{
+  GVariant *result;
+
+  g_return_val_if_fail (is_valid_dict (dict), NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  result = g_hash_table_lookup (GVSD(dict)->values, key);
+
+  if (result && (!expected_type || g_variant_is_of_type (result, expected_type)))
+    return g_variant_ref (result);
+
+  return NULL;
+}
+
+/**
+ * g_variant_dict_contains:
+ * @dict: a #GVariantDict
+ * @key: the key to lookup in the dictionary
+ *
+ * Checks if @key exists in @dict.
+ *
+ * Returns: %TRUE if @key is in @dict
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_dict_contains (GVariantDict *dict,
+                         const gchar  *key)
+{
+  g_return_val_if_fail (is_valid_dict (dict), FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  return g_hash_table_contains (GVSD(dict)->values, key);
+}
+
+/**
+ * g_variant_dict_insert:
+ * @dict: a #GVariantDict
+ * @key: the key to insert a value for
+ * @format_string: a #GVariant varargs format string
+ * @...: arguments, as per @format_string
+ *
+ * Inserts a value into a #GVariantDict.
+ *
+ * This call is a convenience wrapper that is exactly equivalent to
+ * calling g_variant_new() followed by g_variant_dict_insert_value().
+ *
+ * Since: 2.40
+ **/
+void
+g_variant_dict_insert (GVariantDict *dict,
+                       const gchar  *key,
+                       const gchar  *format_string,
+                       ...)
+{
+  va_list ap;
+
+  g_return_if_fail (is_valid_dict (dict));
+  g_return_if_fail (key != NULL);
+  g_return_if_fail (format_string != NULL);
+
+  va_start (ap, format_string);
+  g_variant_dict_insert_value (dict, key, g_variant_new_va (format_string, NULL, &ap));
+  va_end (ap);
+}
+
+/**
+ * g_variant_dict_insert_value:
+ * @dict: a #GVariantDict
+ * @key: the key to insert a value for
+ * @value: the value to insert
+ *
+ * Inserts (or replaces) a key in a #GVariantDict.
+ *
+ * @value is consumed if it is floating.
+ *
+ * Since: 2.40
+ **/
+void
+g_variant_dict_insert_value (GVariantDict *dict,
+                             const gchar  *key,
+                             GVariant     *value)
+{
+  g_return_if_fail (is_valid_dict (dict));
+  g_return_if_fail (key != NULL);
+  g_return_if_fail (value != NULL);
+
+  g_hash_table_insert (GVSD(dict)->values, g_strdup (key), g_variant_ref_sink (value));
+}
+
+/**
+ * g_variant_dict_remove:
+ * @dict: a #GVariantDict
+ * @key: the key to remove
+ *
+ * Removes a key and its associated value from a #GVariantDict.
+ *
+ * Returns: %TRUE if the key was found and removed
+ *
+ * Since: 2.40
+ **/
+gboolean
+g_variant_dict_remove (GVariantDict *dict,
+                       const gchar  *key)
+{
+  g_return_val_if_fail (is_valid_dict (dict), FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  return g_hash_table_remove (GVSD(dict)->values, key);
+}
+
+/**
+ * g_variant_dict_clear:
+ * @dict: a #GVariantDict
+ *
+ * Releases all memory associated with a #GVariantDict without freeing
+ * the #GVariantDict structure itself.
+ *
+ * It typically only makes sense to do this on a stack-allocated
+ * #GVariantDict if you want to abort building the value part-way
+ * through.  This function need not be called if you call
+ * g_variant_dict_end() and it also doesn't need to be called on dicts
+ * allocated with g_variant_dict_new (see g_variant_dict_unref() for
+ * that).
+ *
+ * It is valid to call this function on either an initialised
+ * #GVariantDict or one that was previously cleared by an earlier call
+ * to g_variant_dict_clear() but it is not valid to call this function
+ * on uninitialised memory.
+ *
+ * Since: 2.40
+ **/
+void
+g_variant_dict_clear (GVariantDict *dict)
+{
+  if (GVSD(dict)->magic == 0)
+    /* all-zeros case */
+    return;
+
+  g_return_if_fail (is_valid_dict (dict));
+
+  g_hash_table_unref (GVSD(dict)->values);
+  GVSD(dict)->values = NULL;
+
+  GVSD(dict)->magic = 0;
+}
+
+/**
+ * g_variant_dict_end:
+ * @dict: a #GVariantDict
+ *
+ * Returns the current value of @dict as a #GVariant of type
+ * %G_VARIANT_TYPE_VARDICT, clearing it in the process.
+ *
+ * It is not permissible to use @dict in any way after this call except
+ * for reference counting operations (in the case of a heap-allocated
+ * #GVariantDict) or by reinitialising it with g_variant_dict_init() (in
+ * the case of stack-allocated).
+ *
+ * Returns: (transfer none): a new, floating, #GVariant
+ *
+ * Since: 2.40
+ **/
+GVariant *
+g_variant_dict_end (GVariantDict *dict)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_return_val_if_fail (is_valid_dict (dict), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+  g_hash_table_iter_init (&iter, GVSD(dict)->values);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_variant_builder_add (&builder, "{sv}", (const gchar *) key, (GVariant *) value);
+
+  g_variant_dict_clear (dict);
+
+  return g_variant_builder_end (&builder);
+}
+
+/**
+ * g_variant_dict_ref:
+ * @dict: a heap-allocated #GVariantDict
+ *
+ * Increases the reference count on @dict.
+ *
+ * Don't call this on stack-allocated #GVariantDict instances or bad
+ * things will happen.
+ *
+ * Returns: (transfer full): a new reference to @dict
+ *
+ * Since: 2.40
+ **/
+GVariantDict *
+g_variant_dict_ref (GVariantDict *dict)
+{
+  g_return_val_if_fail (is_valid_heap_dict (dict), NULL);
+
+  GVHD(dict)->ref_count++;
+
+  return dict;
+}
+
+/**
+ * g_variant_dict_unref:
+ * @dict: (transfer full): a heap-allocated #GVariantDict
+ *
+ * Decreases the reference count on @dict.
+ *
+ * In the event that there are no more references, releases all memory
+ * associated with the #GVariantDict.
+ *
+ * Don't call this on stack-allocated #GVariantDict instances or bad
+ * things will happen.
+ *
+ * Since: 2.40
+ **/
+void
+g_variant_dict_unref (GVariantDict *dict)
+{
+  g_return_if_fail (is_valid_heap_dict (dict));
+
+  if (--GVHD(dict)->ref_count == 0)
+    {
+      g_variant_dict_clear (dict);
+      g_slice_free (struct heap_dict, (struct heap_dict *) dict);
+    }
+}
+
 /* Format strings {{{1 */
 /*< private >
  * g_variant_format_string_scan:
@@ -4883,6 +5465,114 @@ g_variant_get_va (GVariant     *value,
 
 /* Varargs-enabled Utility Functions {{{1 */
 
+/*< private >
+ * g_variant_builder_add_basic:
+ * @builder: a #GVariantBuilder
+ * @format_string: a #GVariant varargs format string
+ * @app: a pointer to a #va_list
+ *
+ * If @builder is in serialised mode and @format_string is just the
+ * basic type character of its elements then this writes the argument
+ * directly into the array being built, without creating a #GVariant
+ * for it, and returns %TRUE.  Otherwise @app is left untouched and
+ * %FALSE is returned.
+ */
+static gboolean
+g_variant_builder_add_basic (GVariantBuilder *builder,
+                             const gchar     *format_string,
+                             va_list         *app)
+{
+  const gchar *type_string;
+  const gchar *string;
+  guchar *data;
+  gsize size;
+
+  if (!is_valid_builder (builder) || !GVSB(builder)->serialised)
+    return FALSE;
+
+  type_string =
+    g_variant_type_info_get_type_string (GVSB(builder)->element_info);
+
+  if (format_string == NULL || format_string[0] != type_string[0] ||
+      format_string[1] != '\0' || type_string[1] != '\0')
+    return FALSE;
+
+  switch (type_string[0])
+    {
+    case 'b':
+      *g_variant_builder_append_item (GVSB(builder), 1) =
+        va_arg (*app, gboolean);
+      return TRUE;
+
+    case 'y':
+      *g_variant_builder_append_item (GVSB(builder), 1) =
+        (guchar) va_arg (*app, guint);
+      return TRUE;
+
+    case 'n':
+    case 'q':
+      {
+        guint16 value = va_arg (*app, guint);
+
+        data = g_variant_builder_append_item (GVSB(builder), sizeof value);
+        memcpy (data, &value, sizeof value);
+        return TRUE;
+      }
+
+    case 'i':
+    case 'u':
+    case 'h':
+      {
+        guint32 value = va_arg (*app, guint);
+
+        data = g_variant_builder_append_item (GVSB(builder), sizeof value);
+        memcpy (data, &value, sizeof value);
+        return TRUE;
+      }
+
+    case 'x':
+    case 't':
+      {
+        guint64 value = va_arg (*app, guint64);
+
+        data = g_variant_builder_append_item (GVSB(builder), sizeof value);
+        memcpy (data, &value, sizeof value);
+        return TRUE;
+      }
+
+    case 'd':
+      {
+        gdouble value = va_arg (*app, gdouble);
+
+        data = g_variant_builder_append_item (GVSB(builder), sizeof value);
+        memcpy (data, &value, sizeof value);
+        return TRUE;
+      }
+
+    case 's':
+    case 'o':
+    case 'g':
+      string = va_arg (*app, const gchar *);
+
+      /* the same checks as g_variant_new_string() and friends */
+      g_return_val_if_fail (string != NULL, TRUE);
+      g_return_val_if_fail (type_string[0] != 's' ||
+                            g_utf8_validate (string, -1, NULL), TRUE);
+      g_return_val_if_fail (type_string[0] != 'o' ||
+                            g_variant_is_object_path (string), TRUE);
+      g_return_val_if_fail (type_string[0] != 'g' ||
+                            g_variant_is_signature (string), TRUE);
+
+      size = strlen (string) + 1;
+      data = g_variant_builder_append_item (GVSB(builder), size);
+      memcpy (data, string, size);
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
 /**
  * g_variant_builder_add: (skp)
  * @builder: a #GVariantBuilder
@@ -4927,6 +5617,13 @@ g_variant_builder_add (GVariantBuilder *builder,
   va_list ap;
 
   va_start (ap, format_string);
+
+  if (g_variant_builder_add_basic (builder, format_string, &ap))
+    {
+      va_end (ap);
+      return;
+    }
+
   variant = g_variant_new_va (format_string, NULL, &ap);
   va_end (ap);
 
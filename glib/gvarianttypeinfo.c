@@ -709,9 +709,33 @@ g_variant_type_info_member_info (GVariantTypeInfo *info,
 }
 
 /* == new/ref/unref == */
-static GRecMutex g_variant_type_info_lock;
+/* Lookups of already-interned types only take the lock for reading, so
+ * threads constructing values of the same types do not serialise on
+ * it.  The lock is taken for writing to insert a new info and to drop
+ * the last reference; any other unref is a lock-free decrement.  An
+ * info in the table therefore always has a non-zero ref_count while
+ * readers can see it.
+ */
+static GRWLock g_variant_type_info_lock;
 static GHashTable *g_variant_type_info_table;
 
+static void
+g_variant_type_info_free (GVariantTypeInfo *info)
+{
+  ContainerInfo *container = (ContainerInfo *) info;
+
+  g_free (container->type_string);
+
+  if (info->container_class == GV_ARRAY_INFO_CLASS)
+    array_info_free (info);
+
+  else if (info->container_class == GV_TUPLE_INFO_CLASS)
+    tuple_info_free (info);
+
+  else
+    g_assert_not_reached ();
+}
+
 /* < private >
  * g_variant_type_info_get:
  * @type: a #GVariantType
@@ -737,45 +761,66 @@ g_variant_type_info_get (const GVariantType *type)
       type_char == G_VARIANT_TYPE_INFO_CHAR_TUPLE ||
       type_char == G_VARIANT_TYPE_INFO_CHAR_DICT_ENTRY)
     {
-      GVariantTypeInfo *info;
+      GVariantTypeInfo *info = NULL;
+      GVariantTypeInfo *existing;
+      ContainerInfo *container;
       gchar *type_string;
 
       type_string = g_variant_type_dup_string (type);
 
-      g_rec_mutex_lock (&g_variant_type_info_lock);
+      g_rw_lock_reader_lock (&g_variant_type_info_lock);
+      if (g_variant_type_info_table != NULL)
+        info = g_hash_table_lookup (g_variant_type_info_table, type_string);
+      if (info != NULL)
+        g_variant_type_info_ref (info);
+      g_rw_lock_reader_unlock (&g_variant_type_info_lock);
+
+      if (info != NULL)
+        {
+          g_free (type_string);
+          return info;
+        }
+
+      /* Building the info gets the infos of the element or member
+       * types, so do it before taking the lock for writing.
+       */
+      if (type_char == G_VARIANT_TYPE_INFO_CHAR_MAYBE ||
+          type_char == G_VARIANT_TYPE_INFO_CHAR_ARRAY)
+        {
+          container = array_info_new (type);
+        }
+      else /* tuple or dict entry */
+        {
+          container = tuple_info_new (type);
+        }
+
+      info = (GVariantTypeInfo *) container;
+      container->type_string = type_string;
+      container->ref_count = 1;
+
+      g_rw_lock_writer_lock (&g_variant_type_info_lock);
 
       if (g_variant_type_info_table == NULL)
         g_variant_type_info_table = g_hash_table_new (g_str_hash,
                                                       g_str_equal);
-      info = g_hash_table_lookup (g_variant_type_info_table, type_string);
 
-      if (info == NULL)
-        {
-          ContainerInfo *container;
+      /* another thread may have inserted the same type meanwhile */
+      existing = g_hash_table_lookup (g_variant_type_info_table, type_string);
 
-          if (type_char == G_VARIANT_TYPE_INFO_CHAR_MAYBE ||
-              type_char == G_VARIANT_TYPE_INFO_CHAR_ARRAY)
-            {
-              container = array_info_new (type);
-            }
-          else /* tuple or dict entry */
-            {
-              container = tuple_info_new (type);
-            }
+      if (existing != NULL)
+        g_variant_type_info_ref (existing);
+      else
+        g_hash_table_insert (g_variant_type_info_table, type_string, info);
 
-          info = (GVariantTypeInfo *) container;
-          container->type_string = type_string;
-          container->ref_count = 1;
+      g_rw_lock_writer_unlock (&g_variant_type_info_lock);
 
-          g_hash_table_insert (g_variant_type_info_table, type_string, info);
-          type_string = NULL;
+      if (existing != NULL)
+        {
+          g_variant_type_info_free (info);
+          info = existing;
         }
-      else
-        g_variant_type_info_ref (info);
 
-      g_rec_mutex_unlock (&g_variant_type_info_lock);
       g_variant_type_info_check (info, 0);
-      g_free (type_string);
 
       return info;
     }
@@ -833,8 +878,27 @@ g_variant_type_info_unref (GVariantTypeInfo *info)
   if (info->container_class)
     {
       ContainerInfo *container = (ContainerInfo *) info;
+      gint ref_count;
+
+      /* fast path: this is not the last reference */
+      do
+        {
+          ref_count = g_atomic_int_get (&container->ref_count);
+          g_assert_cmpint (ref_count, >, 0);
+
+          if (ref_count == 1)
+            break;
+        }
+      while (!g_atomic_int_compare_and_exchange (&container->ref_count,
+                                                 ref_count, ref_count - 1));
 
-      g_rec_mutex_lock (&g_variant_type_info_lock);
+      if (ref_count > 1)
+        return;
+
+      /* possibly the last reference: a concurrent lookup may still add
+       * one, so decide under the lock
+       */
+      g_rw_lock_writer_lock (&g_variant_type_info_lock);
       if (g_atomic_int_dec_and_test (&container->ref_count))
         {
           g_hash_table_remove (g_variant_type_info_table,
@@ -844,21 +908,12 @@ g_variant_type_info_unref (GVariantTypeInfo *info)
               g_hash_table_unref (g_variant_type_info_table);
               g_variant_type_info_table = NULL;
             }
-          g_rec_mutex_unlock (&g_variant_type_info_lock);
-
-          g_free (container->type_string);
-
-          if (info->container_class == GV_ARRAY_INFO_CLASS)
-            array_info_free (info);
-
-          else if (info->container_class == GV_TUPLE_INFO_CLASS)
-            tuple_info_free (info);
+          g_rw_lock_writer_unlock (&g_variant_type_info_lock);
 
-          else
-            g_assert_not_reached ();
+          g_variant_type_info_free (info);
         }
       else
-        g_rec_mutex_unlock (&g_variant_type_info_lock);
+        g_rw_lock_writer_unlock (&g_variant_type_info_lock);
     }
 }
 
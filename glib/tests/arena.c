@@ -0,0 +1,197 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ */
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+
+#include <string.h>
+#include "glib.h"
+
+static void
+test_alloc (void)
+{
+  GArena *arena;
+  gpointer mem[1000];
+  gchar *big;
+  guint i;
+
+  arena = g_arena_new (0);
+
+  g_assert (g_arena_alloc (arena, 0) == NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (mem); i++)
+    {
+      mem[i] = g_arena_alloc (arena, i % 37 + 1);
+      g_assert_cmpuint (GPOINTER_TO_SIZE (mem[i]) % (2 * sizeof (gsize)), ==, 0);
+      memset (mem[i], i & 0xff, i % 37 + 1);
+    }
+
+  big = g_arena_alloc0 (arena, 100000);
+  for (i = 0; i < 100000; i++)
+    g_assert_cmpint (big[i], ==, 0);
+
+  for (i = 0; i < G_N_ELEMENTS (mem); i++)
+    {
+      guint8 *bytes = mem[i];
+      guint j;
+
+      for (j = 0; j < i % 37 + 1; j++)
+        g_assert_cmpuint (bytes[j], ==, i & 0xff);
+    }
+
+  g_assert_cmpstr (g_arena_strdup (arena, "arena"), ==, "arena");
+  g_assert (g_arena_strdup (arena, NULL) == NULL);
+
+  g_arena_free (arena);
+}
+
+static void
+test_realloc (void)
+{
+  GArena *arena;
+  gchar *mem, *grown, *other;
+
+  arena = g_arena_new (1024);
+
+  mem = g_arena_alloc (arena, 16);
+  strcpy (mem, "0123456789");
+
+  /* the last allocation grows in place */
+  grown = g_arena_realloc (arena, mem, 16, 64);
+  g_assert (grown == mem);
+
+  /* but not anymore once something else was allocated */
+  other = g_arena_alloc (arena, 16);
+  grown = g_arena_realloc (arena, mem, 64, 128);
+  g_assert (grown != mem);
+  g_assert (grown != other);
+  g_assert_cmpstr (grown, ==, "0123456789");
+
+  g_assert (g_arena_realloc (arena, grown, 128, 8) == grown);
+
+  g_arena_free (arena);
+}
+
+static void
+test_reset (void)
+{
+  GArena *arena;
+  gpointer first, again;
+  guint i;
+
+  arena = g_arena_new (1024);
+
+  first = g_arena_alloc (arena, 8);
+  for (i = 0; i < 100; i++)
+    g_arena_alloc (arena, 100);
+  g_arena_alloc (arena, 10000);
+
+  /* blocks are reused after a reset */
+  g_arena_reset (arena);
+  again = g_arena_alloc (arena, 8);
+  g_assert (again != NULL);
+  for (i = 0; i < 100; i++)
+    memset (g_arena_alloc (arena, 100), 0, 100);
+  memset (g_arena_alloc (arena, 10000), 0, 10000);
+
+  g_arena_reset (arena);
+  g_arena_reset (arena);
+  g_assert (first != NULL);
+
+  g_arena_free (arena);
+}
+
+static void
+test_ptr_array (void)
+{
+  GArena *arena;
+  GPtrArray *array;
+  gpointer *pdata;
+  guint i;
+
+  arena = g_arena_new (0);
+
+  array = g_ptr_array_new_in_arena (arena, 0, g_free);
+  for (i = 0; i < 1000; i++)
+    g_ptr_array_add (array, g_strdup_printf ("%u", i));
+  g_ptr_array_remove_index (array, 0);
+  g_assert_cmpuint (array->len, ==, 999);
+  g_assert_cmpstr (g_ptr_array_index (array, 0), ==, "1");
+  g_ptr_array_unref (array);
+
+  array = g_ptr_array_new_in_arena (arena, 4, NULL);
+  for (i = 0; i < 100; i++)
+    g_ptr_array_add (array, GUINT_TO_POINTER (i));
+  pdata = g_ptr_array_free (array, FALSE);
+  for (i = 0; i < 100; i++)
+    g_assert (pdata[i] == GUINT_TO_POINTER (i));
+
+  g_arena_free (arena);
+}
+
+static void
+test_hash_table (void)
+{
+  GArena *arena;
+  GHashTable *hash_table;
+  gint round;
+  guint i;
+
+  arena = g_arena_new (0);
+
+  for (round = 0; round < 3; round++)
+    {
+      hash_table = g_hash_table_new_in_arena (arena, g_str_hash, g_str_equal,
+                                              g_free, NULL);
+      for (i = 0; i < 10000; i++)
+        g_hash_table_insert (hash_table, g_strdup_printf ("%u", i), GUINT_TO_POINTER (i));
+      for (i = 0; i < 10000; i++)
+        {
+          gchar key[16];
+
+          g_snprintf (key, sizeof key, "%u", i);
+          if (i % 2 == 0)
+            g_assert (g_hash_table_remove (hash_table, key));
+        }
+      g_assert_cmpuint (g_hash_table_size (hash_table), ==, 5000);
+      for (i = 0; i < 10000; i++)
+        {
+          gchar key[16];
+
+          g_snprintf (key, sizeof key, "%u", i);
+          g_assert (g_hash_table_lookup (hash_table, key) == (i % 2 ? GUINT_TO_POINTER (i) : NULL));
+        }
+      g_hash_table_unref (hash_table);
+
+      /* without notifiers, the table can be left to the arena */
+      hash_table = g_hash_table_new_in_arena (arena, NULL, NULL, NULL, NULL);
+      for (i = 0; i < 1000; i++)
+        g_hash_table_insert (hash_table, GUINT_TO_POINTER (i), GUINT_TO_POINTER (i + 1));
+      g_assert_cmpuint (g_hash_table_size (hash_table), ==, 1000);
+      g_assert (g_hash_table_lookup (hash_table, GUINT_TO_POINTER (500)) == GUINT_TO_POINTER (501));
+
+      g_arena_reset (arena);
+    }
+
+  g_arena_free (arena);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/arena/alloc", test_alloc);
+  g_test_add_func ("/arena/realloc", test_realloc);
+  g_test_add_func ("/arena/reset", test_reset);
+  g_test_add_func ("/arena/ptr-array", test_ptr_array);
+  g_test_add_func ("/arena/hash-table", test_hash_table);
+
+  return g_test_run ();
+}
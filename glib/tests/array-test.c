@@ -306,6 +306,68 @@ array_sort_with_data (void)
   g_array_free (garray, TRUE);
 }
 
+typedef struct
+{
+  gint key;
+  gint index;
+} SortItem;
+
+static int
+sort_item_compare_data (gconstpointer p1, gconstpointer p2, gpointer data)
+{
+  const SortItem *i1 = p1;
+  const SortItem *i2 = p2;
+
+  return i1->key - i2->key;
+}
+
+static void
+array_sort_parallel (void)
+{
+  GArray *garray;
+  SortItem item, prev;
+  gint i;
+
+  /* big enough to be sorted in several threads, with uneven chunks;
+   * the few distinct keys check that the sort is stable
+   */
+  garray = g_array_new (FALSE, FALSE, sizeof (SortItem));
+  for (i = 0; i < 200001; i++)
+    {
+      item.key = g_random_int_range (0, 100);
+      item.index = i;
+      g_array_append_val (garray, item);
+    }
+  g_array_sort_parallel (garray, sort_item_compare_data, NULL);
+
+  g_assert_cmpint (garray->len, ==, 200001);
+  prev = g_array_index (garray, SortItem, 0);
+  for (i = 1; i < garray->len; i++)
+    {
+      item = g_array_index (garray, SortItem, i);
+      g_assert_cmpint (prev.key, <=, item.key);
+      if (prev.key == item.key)
+        g_assert_cmpint (prev.index, <, item.index);
+      prev = item;
+    }
+
+  /* already sorted input */
+  g_array_sort_parallel (garray, sort_item_compare_data, NULL);
+  prev = g_array_index (garray, SortItem, 0);
+  for (i = 1; i < garray->len; i++)
+    {
+      item = g_array_index (garray, SortItem, i);
+      g_assert_cmpint (prev.key, <=, item.key);
+      prev = item;
+    }
+
+  /* small arrays are sorted serially */
+  g_array_set_size (garray, 10);
+  g_array_sort_parallel (garray, sort_item_compare_data, NULL);
+
+  g_array_free (garray, TRUE);
+}
+
 static gint num_clear_func_invocations = 0;
 
 static void
@@ -560,6 +622,31 @@ pointer_array_sort_with_data (void)
   g_ptr_array_free (gparray, TRUE);
 }
 
+static void
+pointer_array_sort_parallel (void)
+{
+  GPtrArray *gparray;
+  gint i;
+  gint prev, cur;
+
+  gparray = g_ptr_array_new ();
+  for (i = 0; i < 300000; i++)
+    g_ptr_array_add (gparray, GINT_TO_POINTER (g_random_int_range (0, 10000)));
+
+  g_ptr_array_sort_parallel (gparray, ptr_compare_data, NULL);
+
+  g_assert_cmpint (gparray->len, ==, 300000);
+  prev = -1;
+  for (i = 0; i < 300000; i++)
+    {
+      cur = GPOINTER_TO_INT (g_ptr_array_index (gparray, i));
+      g_assert_cmpint (prev, <=, cur);
+      prev = cur;
+    }
+
+  g_ptr_array_free (gparray, TRUE);
+}
+
 static void
 byte_array_append (void)
 {
@@ -856,6 +943,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/array/large-size/subprocess", array_large_size_subprocess);
   g_test_add_func ("/array/sort", array_sort);
   g_test_add_func ("/array/sort-with-data", array_sort_with_data);
+  g_test_add_func ("/array/sort-parallel", array_sort_parallel);
   g_test_add_func ("/array/clear-func", array_clear_func);
 
   /* pointer arrays */
@@ -864,6 +952,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/pointerarray/free-func", pointer_array_free_func);
   g_test_add_func ("/pointerarray/sort", pointer_array_sort);
   g_test_add_func ("/pointerarray/sort-with-data", pointer_array_sort_with_data);
+  g_test_add_func ("/pointerarray/sort-parallel", pointer_array_sort_parallel);
 
   /* byte arrays */
   g_test_add_func ("/bytearray/append", byte_array_append);
@@ -207,6 +207,265 @@ test_async_queue_timed (void)
   g_async_queue_unref (q);
 }
 
+static void
+test_async_queue_many (void)
+{
+  GAsyncQueue *q;
+  gpointer items[10];
+  gpointer out[4];
+  gint i;
+
+  q = g_async_queue_new ();
+
+  for (i = 0; i < 10; i++)
+    items[i] = GINT_TO_POINTER (i + 1);
+  g_async_queue_push_many (q, items, 10);
+  g_async_queue_push_many (q, items, 0);
+  g_assert_cmpint (g_async_queue_length (q), ==, 10);
+
+  g_assert_cmpuint (g_async_queue_pop_many (q, out, 4, 0), ==, 4);
+  for (i = 0; i < 4; i++)
+    g_assert_cmpint (GPOINTER_TO_INT (out[i]), ==, i + 1);
+  g_assert_cmpint (GPOINTER_TO_INT (g_async_queue_pop (q)), ==, 5);
+
+  g_assert_cmpuint (g_async_queue_pop_many (q, out, 4, 0), ==, 4);
+  g_assert_cmpuint (g_async_queue_pop_many (q, out, 4, G_USEC_PER_SEC), ==, 1);
+  g_assert_cmpint (GPOINTER_TO_INT (out[0]), ==, 10);
+  g_assert_cmpuint (g_async_queue_pop_many (q, out, 4, 0), ==, 0);
+  g_assert_cmpuint (g_async_queue_pop_many (q, out, 4, G_USEC_PER_SEC / 100), ==, 0);
+
+  g_async_queue_unref (q);
+}
+
+static void
+test_concurrent_queue_basic (void)
+{
+  GConcurrentQueue *cq;
+  gint i;
+
+  cq = g_concurrent_queue_new_full (5, destroy_notify);
+
+  g_assert (g_concurrent_queue_try_pop (cq) == NULL);
+  g_assert_cmpint (g_concurrent_queue_length (cq), ==, 0);
+
+  /* the capacity is rounded up to 8 */
+  for (i = 1; i <= 8; i++)
+    g_assert (g_concurrent_queue_try_push (cq, GINT_TO_POINTER (i)));
+  g_assert (!g_concurrent_queue_try_push (cq, GINT_TO_POINTER (9)));
+  g_assert_cmpint (g_concurrent_queue_length (cq), ==, 8);
+
+  for (i = 1; i <= 4; i++)
+    g_assert_cmpint (GPOINTER_TO_INT (g_concurrent_queue_pop (cq)), ==, i);
+
+  /* wrap around */
+  for (i = 9; i <= 12; i++)
+    g_concurrent_queue_push (cq, GINT_TO_POINTER (i));
+  for (i = 5; i <= 10; i++)
+    g_assert_cmpint (GPOINTER_TO_INT (g_concurrent_queue_try_pop (cq)), ==, i);
+  g_assert_cmpint (g_concurrent_queue_length (cq), ==, 2);
+
+  destroy_count = 0;
+  g_concurrent_queue_ref (cq);
+  g_concurrent_queue_unref (cq);
+  g_assert_cmpint (destroy_count, ==, 0);
+  g_concurrent_queue_unref (cq);
+  g_assert_cmpint (destroy_count, ==, 2);
+}
+
+#define CQ_ITEMS 10000
+
+static gpointer
+concurrent_producer (gpointer data)
+{
+  GConcurrentQueue *cq = data;
+  gint i;
+
+  for (i = 1; i <= CQ_ITEMS; i++)
+    g_concurrent_queue_push (cq, GINT_TO_POINTER (i));
+
+  return NULL;
+}
+
+static gpointer
+concurrent_consumer (gpointer data)
+{
+  GConcurrentQueue *cq = data;
+  gint64 sum = 0;
+  gint v;
+
+  while ((v = GPOINTER_TO_INT (g_concurrent_queue_pop (cq))) != -1)
+    sum += v;
+
+  return g_memdup (&sum, sizeof sum);
+}
+
+static void
+test_concurrent_queue_threads (void)
+{
+  GConcurrentQueue *cq;
+  GThread *producers[4], *consumers[4];
+  gint64 sum = 0;
+  gint i;
+
+  /* small enough that both sides have to wait for each other */
+  cq = g_concurrent_queue_new (16);
+
+  for (i = 0; i < 4; i++)
+    consumers[i] = g_thread_new ("consumer", concurrent_consumer, cq);
+  for (i = 0; i < 4; i++)
+    producers[i] = g_thread_new ("producer", concurrent_producer, cq);
+
+  for (i = 0; i < 4; i++)
+    g_thread_join (producers[i]);
+  for (i = 0; i < 4; i++)
+    g_concurrent_queue_push (cq, GINT_TO_POINTER (-1));
+  for (i = 0; i < 4; i++)
+    {
+      gint64 *s = g_thread_join (consumers[i]);
+
+      sum += *s;
+      g_free (s);
+    }
+
+  g_assert_cmpint (sum, ==, 4 * (gint64) CQ_ITEMS * (CQ_ITEMS + 1) / 2);
+  g_assert_cmpint (g_concurrent_queue_length (cq), ==, 0);
+
+  g_concurrent_queue_unref (cq);
+}
+
+static void
+test_concurrent_queue_timed (void)
+{
+  GConcurrentQueue *cq;
+  gint64 start, diff;
+
+  cq = g_concurrent_queue_new (0);
+
+  start = g_get_monotonic_time ();
+  g_assert (g_concurrent_queue_timeout_pop (cq, G_USEC_PER_SEC / 10) == NULL);
+  diff = g_get_monotonic_time () - start;
+  g_assert_cmpint (diff, >=, G_USEC_PER_SEC / 10);
+  g_assert_cmpint (diff, <, G_USEC_PER_SEC);
+
+  g_concurrent_queue_push (cq, cq);
+  g_assert (g_concurrent_queue_timeout_pop (cq, G_USEC_PER_SEC / 10) == cq);
+
+  g_concurrent_queue_unref (cq);
+}
+
+static void
+test_concurrent_queue_many (void)
+{
+  GConcurrentQueue *cq;
+  gpointer items[10], out[10];
+  gint i;
+
+  for (i = 0; i < 10; i++)
+    items[i] = GINT_TO_POINTER (i + 1);
+
+  cq = g_concurrent_queue_new (8);
+
+  g_assert_cmpuint (g_concurrent_queue_pop_many (cq, out, 10, 0), ==, 0);
+
+  /* only part of the items fit */
+  g_assert_cmpuint (g_concurrent_queue_try_push_many (cq, items, 10), ==, 8);
+  g_assert_cmpuint (g_concurrent_queue_try_push_many (cq, items, 10), ==, 0);
+  g_assert_cmpint (g_concurrent_queue_length (cq), ==, 8);
+
+  g_assert_cmpuint (g_concurrent_queue_pop_many (cq, out, 3, 0), ==, 3);
+  for (i = 0; i < 3; i++)
+    g_assert (out[i] == items[i]);
+
+  g_assert_cmpuint (g_concurrent_queue_try_push_many (cq, items + 8, 2), ==, 2);
+  g_assert_cmpuint (g_concurrent_queue_pop_many (cq, out, 10, 0), ==, 7);
+  for (i = 0; i < 7; i++)
+    g_assert (out[i] == items[i + 3]);
+
+  g_concurrent_queue_push_many (cq, items, 5);
+  g_assert (g_concurrent_queue_pop (cq) == items[0]);
+  g_assert_cmpuint (g_concurrent_queue_pop_many (cq, out, 10, G_USEC_PER_SEC), ==, 4);
+
+  g_concurrent_queue_unref (cq);
+}
+
+#define CQ_BATCH 7
+
+static gpointer
+concurrent_batch_producer (gpointer data)
+{
+  GConcurrentQueue *cq = data;
+  gpointer batch[CQ_BATCH];
+  gint i, n;
+
+  for (i = 1; i <= CQ_ITEMS; i += n)
+    {
+      for (n = 0; n < CQ_BATCH && i + n <= CQ_ITEMS; n++)
+        batch[n] = GINT_TO_POINTER (i + n);
+      g_concurrent_queue_push_many (cq, batch, n);
+    }
+
+  return NULL;
+}
+
+static void
+test_concurrent_queue_spsc (void)
+{
+  GConcurrentQueue *cq;
+  GThread *producer;
+  gpointer items[5];
+  gint expected = 1;
+  guint i, n;
+
+  cq = g_concurrent_queue_new_with_flags (16, G_CONCURRENT_QUEUE_SINGLE_PRODUCER |
+                                              G_CONCURRENT_QUEUE_SINGLE_CONSUMER, NULL);
+  producer = g_thread_new ("producer", concurrent_batch_producer, cq);
+
+  /* a single producer keeps the order */
+  while (expected <= CQ_ITEMS)
+    {
+      n = g_concurrent_queue_pop_many (cq, items, G_N_ELEMENTS (items), G_USEC_PER_SEC);
+      g_assert_cmpuint (n, >, 0);
+      for (i = 0; i < n; i++)
+        g_assert_cmpint (GPOINTER_TO_INT (items[i]), ==, expected++);
+    }
+
+  g_thread_join (producer);
+  g_assert (g_concurrent_queue_try_pop (cq) == NULL);
+  g_concurrent_queue_unref (cq);
+}
+
+static void
+test_concurrent_queue_mpsc (void)
+{
+  GConcurrentQueue *cq;
+  GThread *producers[4];
+  gpointer items[5];
+  gint64 sum = 0;
+  gint received = 0;
+  guint i, n;
+
+  cq = g_concurrent_queue_new_with_flags (16, G_CONCURRENT_QUEUE_SINGLE_CONSUMER, NULL);
+
+  for (i = 0; i < 4; i++)
+    producers[i] = g_thread_new ("producer", concurrent_producer, cq);
+
+  while (received < 4 * CQ_ITEMS)
+    {
+      n = g_concurrent_queue_pop_many (cq, items, G_N_ELEMENTS (items), G_USEC_PER_SEC);
+      g_assert_cmpuint (n, >, 0);
+      for (i = 0; i < n; i++)
+        sum += GPOINTER_TO_INT (items[i]);
+      received += n;
+    }
+
+  for (i = 0; i < 4; i++)
+    g_thread_join (producers[i]);
+
+  g_assert_cmpint (sum, ==, 4 * (gint64) CQ_ITEMS * (CQ_ITEMS + 1) / 2);
+  g_assert (g_concurrent_queue_try_pop (cq) == NULL);
+  g_concurrent_queue_unref (cq);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -216,6 +475,13 @@ main (int argc, char *argv[])
   g_test_add_func ("/asyncqueue/destroy", test_async_queue_destroy);
   g_test_add_func ("/asyncqueue/threads", test_async_queue_threads);
   g_test_add_func ("/asyncqueue/timed", test_async_queue_timed);
+  g_test_add_func ("/asyncqueue/many", test_async_queue_many);
+  g_test_add_func ("/concurrentqueue/basic", test_concurrent_queue_basic);
+  g_test_add_func ("/concurrentqueue/threads", test_concurrent_queue_threads);
+  g_test_add_func ("/concurrentqueue/timed", test_concurrent_queue_timed);
+  g_test_add_func ("/concurrentqueue/many", test_concurrent_queue_many);
+  g_test_add_func ("/concurrentqueue/spsc", test_concurrent_queue_spsc);
+  g_test_add_func ("/concurrentqueue/mpsc", test_concurrent_queue_mpsc);
 
   return g_test_run ();
 }
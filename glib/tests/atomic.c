@@ -213,6 +213,107 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   g_assert (g_atomic_pointer_get (cspp) == csp);
 }
 
+static void
+test_ordered (void)
+{
+  const gint *csp;
+  const gint * const *cspp;
+  guint u, u2;
+  gint s, s2;
+  gpointer vp, vp2;
+  int *ip, *ip2;
+  gsize gs, gs2;
+  gboolean res;
+
+  csp = &s;
+  cspp = &csp;
+
+  g_atomic_int_store_release (&u, 5);
+  u2 = g_atomic_int_load_acquire (&u);
+  g_assert_cmpint (u2, ==, 5);
+  g_atomic_int_store_relaxed (&u, 6);
+  u2 = g_atomic_int_load_relaxed (&u);
+  g_assert_cmpint (u2, ==, 6);
+  res = g_atomic_int_compare_and_exchange_full (&u, 5, 7, &u2);
+  g_assert (!res);
+  g_assert_cmpint (u2, ==, 6);
+  g_assert_cmpint (u, ==, 6);
+  res = g_atomic_int_compare_and_exchange_full (&u, 6, 7, &u2);
+  g_assert (res);
+  g_assert_cmpint (u2, ==, 6);
+  g_assert_cmpint (u, ==, 7);
+
+  g_atomic_int_store_release (&s, -5);
+  s2 = g_atomic_int_load_acquire (&s);
+  g_assert_cmpint (s2, ==, -5);
+  g_atomic_int_store_relaxed (&s, -6);
+  s2 = g_atomic_int_load_relaxed (&s);
+  g_assert_cmpint (s2, ==, -6);
+  res = g_atomic_int_compare_and_exchange_full (&s, -6, 7, &s2);
+  g_assert (res);
+  g_assert_cmpint (s2, ==, -6);
+  g_assert_cmpint (s, ==, 7);
+
+  g_atomic_pointer_store_release (&vp, &u);
+  vp2 = g_atomic_pointer_load_acquire (&vp);
+  g_assert (vp2 == &u);
+  g_atomic_pointer_store_relaxed (&vp, NULL);
+  vp2 = g_atomic_pointer_load_relaxed (&vp);
+  g_assert (vp2 == NULL);
+  res = g_atomic_pointer_compare_and_exchange_full (&vp, &u, &s, &vp2);
+  g_assert (!res);
+  g_assert (vp2 == NULL);
+  res = g_atomic_pointer_compare_and_exchange_full (&vp, NULL, &s, &vp2);
+  g_assert (res);
+  g_assert (vp2 == NULL);
+  g_assert (vp == &s);
+
+  g_atomic_pointer_store_release (&ip, &s);
+  ip2 = g_atomic_pointer_load_acquire (&ip);
+  g_assert (ip2 == &s);
+  res = g_atomic_pointer_compare_and_exchange_full (&ip, &s, NULL, &ip2);
+  g_assert (res);
+  g_assert (ip2 == &s);
+  g_assert (ip == NULL);
+
+  g_atomic_pointer_store_relaxed (&gs, 8);
+  gs2 = (gsize) g_atomic_pointer_load_relaxed (&gs);
+  g_assert (gs2 == 8);
+  res = g_atomic_pointer_compare_and_exchange_full (&gs, 8, 9, &gs2);
+  g_assert (res);
+  g_assert (gs2 == 8);
+  g_assert (gs == 9);
+
+  g_assert (g_atomic_int_load_acquire (csp) == s);
+  g_assert (g_atomic_pointer_load_acquire (cspp) == csp);
+
+  /* repeat, without the macros */
+  (g_atomic_int_store_release) ((gint *) &u, 5);
+  u2 = (g_atomic_int_load_acquire) ((gint *) &u);
+  g_assert_cmpint (u2, ==, 5);
+  (g_atomic_int_store_relaxed) ((gint *) &u, 6);
+  u2 = (g_atomic_int_load_relaxed) ((gint *) &u);
+  g_assert_cmpint (u2, ==, 6);
+  res = (g_atomic_int_compare_and_exchange_full) ((gint *) &u, 6, 7, &s2);
+  g_assert (res);
+  g_assert_cmpint (s2, ==, 6);
+  g_assert_cmpint (u, ==, 7);
+
+  (g_atomic_pointer_store_release) (&vp, &u);
+  vp2 = (g_atomic_pointer_load_acquire) (&vp);
+  g_assert (vp2 == &u);
+  (g_atomic_pointer_store_relaxed) (&vp, NULL);
+  vp2 = (g_atomic_pointer_load_relaxed) (&vp);
+  g_assert (vp2 == NULL);
+  res = (g_atomic_pointer_compare_and_exchange_full) (&vp, &u, &s, &vp2);
+  g_assert (!res);
+  g_assert (vp2 == NULL);
+  g_assert (vp == NULL);
+
+  g_assert ((g_atomic_int_load_acquire) (csp) == s);
+  g_assert ((g_atomic_pointer_load_acquire) (cspp) == csp);
+}
+
 #define THREADS 10
 #define ROUNDS 10000
 
@@ -267,6 +368,7 @@ main (int argc, char **argv)
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/atomic/types", test_types);
+  g_test_add_func ("/atomic/ordered", test_ordered);
   g_test_add_func ("/atomic/threaded", test_threaded);
 
   return g_test_run ();
@@ -374,6 +374,127 @@ test_base64_decode_smallblock (gconstpointer blocksize_p)
     }
 }
 
+/* encodes @len bytes of data one bit at a time */
+static gchar *
+reference_encode (const guchar *in,
+                  gsize         len,
+                  gboolean      break_lines)
+{
+  const gchar *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  GString *out = g_string_new (NULL);
+  gsize bit, n_bits = len * 8;
+
+  for (bit = 0; bit < n_bits; bit += 6)
+    {
+      guint index = 0, j;
+
+      for (j = bit; j < bit + 6; j++)
+        index = (index << 1) | (j < n_bits ? (in[j / 8] >> (7 - j % 8)) & 1 : 0);
+      g_string_append_c (out, alphabet[index]);
+
+      if (break_lines && out->len % 77 == 76)
+        g_string_append_c (out, '\n');
+    }
+
+  while (out->len % (break_lines ? 77 : 76) % 4 != 0)
+    g_string_append_c (out, '=');
+
+  if (break_lines && len > 0)
+    g_string_append_c (out, '\n');
+
+  return g_string_free (out, FALSE);
+}
+
+/* Lengths and chunk sizes around the 12 and 16 byte blocks that are
+ * handled in bulk, and the 76 character lines.
+ */
+static void
+test_base64_blocks (void)
+{
+  gsize len, chunk, i;
+  gint break_lines;
+
+  for (break_lines = 0; break_lines <= 1; break_lines++)
+    for (len = 0; len <= 200; len++)
+      for (chunk = 1; chunk <= len + 1; chunk += (chunk < 20) ? 1 : 37)
+        {
+          gchar *expected, *text;
+          guchar *decoded;
+          gsize text_len, decoded_len;
+          gint state = 0, save = 0;
+          guint decode_save = 0;
+
+          expected = reference_encode (data, len, break_lines);
+
+          text = g_malloc ((len / 3 + 1) * 4 + 4 + len / 50 + 2);
+          text_len = 0;
+          for (i = 0; i < len; i += chunk)
+            text_len += g_base64_encode_step (data + i, MIN (chunk, len - i), break_lines,
+                                              text + text_len, &state, &save);
+          text_len += g_base64_encode_close (break_lines, text + text_len, &state, &save);
+
+          /* the close always adds a newline when breaking lines */
+          if (break_lines && len == 0)
+            g_assert_cmpint (text_len, ==, 1);
+          else
+            {
+              g_assert_cmpint (text_len, ==, strlen (expected));
+              g_assert (memcmp (text, expected, text_len) == 0);
+            }
+
+          decoded = g_malloc (text_len / 4 * 3 + 3);
+          state = 0;
+          decoded_len = 0;
+          for (i = 0; i < text_len; i += chunk)
+            decoded_len += g_base64_decode_step (text + i, MIN (chunk, text_len - i),
+                                                 decoded + decoded_len, &state, &decode_save);
+          g_assert_cmpint (decoded_len, ==, len);
+          g_assert (memcmp (decoded, data, len) == 0);
+
+          g_free (decoded);
+          g_free (text);
+          g_free (expected);
+        }
+}
+
+/* characters outside the alphabet are skipped wherever they are */
+static void
+test_base64_decode_skip (void)
+{
+  gchar *text, *noisy;
+  guchar *decoded;
+  gsize len, i, j;
+
+  text = g_base64_encode (data, 300);
+  len = strlen (text);
+
+  for (i = 0; i < 256; i++)
+    {
+      GString *s;
+
+      if (g_ascii_isalnum (i) || i == '+' || i == '/' || i == '=' || i == 0)
+        continue;
+
+      /* insert the character at a different offset each time */
+      s = g_string_new (NULL);
+      for (j = 0; j < len; j++)
+        {
+          if (j % 23 == i % 23)
+            g_string_append_c (s, i);
+          g_string_append_c (s, text[j]);
+        }
+      noisy = g_string_free (s, FALSE);
+
+      decoded = g_base64_decode (noisy, &j);
+      g_assert_cmpint (j, ==, 300);
+      g_assert (memcmp (decoded, data, 300) == 0);
+
+      g_free (decoded);
+      g_free (noisy);
+    }
+
+  g_free (text);
+}
 
 int
 main (int argc, char *argv[])
@@ -407,6 +528,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/base64/decode", test_base64_decode);
   g_test_add_func ("/base64/decode-inplace", test_base64_decode_inplace);
   g_test_add_func ("/base64/encode-decode", test_base64_encode_decode);
+  g_test_add_func ("/base64/blocks", test_base64_blocks);
+  g_test_add_func ("/base64/decode-skip", test_base64_decode_skip);
 
   g_test_add_data_func ("/base64/incremental/smallblock/1", GINT_TO_POINTER(1),
                         test_base64_decode_smallblock);
@@ -0,0 +1,426 @@
+/* GLIB - Library of useful routines for C programming
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Microbenchmarks for the GLib data structures.
+ *
+ * Run with "make bench", or "./benchmark -m perf" to get the numbers;
+ * as part of "make check" each benchmark only runs a single iteration.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#define N_KEYS 4096
+
+static guint keys[N_KEYS];
+
+static void
+init_keys (void)
+{
+  guint i;
+
+  for (i = 0; i < N_KEYS; i++)
+    keys[i] = g_random_int ();
+}
+
+/* GHashTable */
+
+/* A hash table filled from empty doubles its size once it is about 94%
+ * full, so a table of 65536 buckets holds between about 30800 and
+ * 61700 entries; picking the number of entries picks the load factor.
+ */
+#define HASH_SIZE 65536
+
+typedef struct {
+  GHashTable *hash;
+  guint       n_entries;
+} HashBench;
+
+static HashBench *
+hash_bench_new (gdouble load)
+{
+  HashBench *bench;
+  guint i;
+
+  bench = g_new (HashBench, 1);
+  bench->hash = g_hash_table_new (NULL, NULL);
+  bench->n_entries = load * HASH_SIZE;
+
+  /* even keys are present, odd ones are not */
+  for (i = 0; i < bench->n_entries; i++)
+    g_hash_table_insert (bench->hash, GUINT_TO_POINTER (2 * i + 2), GUINT_TO_POINTER (i));
+
+  return bench;
+}
+
+static void
+hash_bench_free (HashBench *bench)
+{
+  g_hash_table_unref (bench->hash);
+  g_free (bench);
+}
+
+static void
+bench_hash_lookup_hit (guint64       n_iterations,
+                       gconstpointer data)
+{
+  const HashBench *bench = data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      guint key = 2 * (keys[i % N_KEYS] % bench->n_entries) + 2;
+
+      if (!g_hash_table_contains (bench->hash, GUINT_TO_POINTER (key)))
+        g_assert_not_reached ();
+    }
+}
+
+static void
+bench_hash_lookup_miss (guint64       n_iterations,
+                        gconstpointer data)
+{
+  const HashBench *bench = data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      guint key = 2 * (keys[i % N_KEYS] % bench->n_entries) + 1;
+
+      if (g_hash_table_contains (bench->hash, GUINT_TO_POINTER (key)))
+        g_assert_not_reached ();
+    }
+}
+
+/* Removes and reinserts entries, so the load factor stays the same */
+static void
+bench_hash_remove_insert (guint64       n_iterations,
+                          gconstpointer data)
+{
+  const HashBench *bench = data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      guint key = 2 * (keys[i % N_KEYS] % bench->n_entries) + 2;
+
+      g_hash_table_remove (bench->hash, GUINT_TO_POINTER (key));
+      g_hash_table_insert (bench->hash, GUINT_TO_POINTER (key), GUINT_TO_POINTER (key));
+    }
+}
+
+static void
+bench_hash_fill (guint64       n_iterations,
+                 gconstpointer data)
+{
+  guint n_entries = GPOINTER_TO_UINT (data);
+  guint64 i;
+  guint j;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      GHashTable *hash = g_hash_table_new (NULL, NULL);
+
+      for (j = 0; j < n_entries; j++)
+        g_hash_table_insert (hash, GUINT_TO_POINTER (keys[j % N_KEYS] + j), NULL);
+      g_hash_table_unref (hash);
+    }
+}
+
+/* GSequence and GTree */
+
+#define N_SORTED 10000
+
+static gint
+compare_uint (gconstpointer a,
+              gconstpointer b,
+              gpointer      user_data)
+{
+  guint ua = GPOINTER_TO_UINT (a), ub = GPOINTER_TO_UINT (b);
+
+  return ua < ub ? -1 : ua > ub;
+}
+
+static GSequence *
+sequence_new (void)
+{
+  GSequence *seq;
+  guint i;
+
+  seq = g_sequence_new (NULL);
+  for (i = 0; i < N_SORTED; i++)
+    g_sequence_insert_sorted (seq, GUINT_TO_POINTER (g_random_int ()), compare_uint, NULL);
+
+  return seq;
+}
+
+static void
+bench_sequence_insert_remove (guint64       n_iterations,
+                              gconstpointer data)
+{
+  GSequence *seq = (GSequence *) data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      GSequenceIter *iter;
+
+      iter = g_sequence_insert_sorted (seq, GUINT_TO_POINTER (keys[i % N_KEYS]), compare_uint, NULL);
+      g_sequence_remove (iter);
+    }
+}
+
+static void
+bench_sequence_search (guint64       n_iterations,
+                       gconstpointer data)
+{
+  GSequence *seq = (GSequence *) data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    g_sequence_search (seq, GUINT_TO_POINTER (keys[i % N_KEYS]), compare_uint, NULL);
+}
+
+static GTree *
+tree_new (void)
+{
+  GTree *tree;
+  guint i;
+
+  tree = g_tree_new_full (compare_uint, NULL, NULL, NULL);
+  for (i = 0; i < N_SORTED; i++)
+    g_tree_insert (tree, GUINT_TO_POINTER (2 * i + 2), NULL);
+
+  return tree;
+}
+
+static void
+bench_tree_lookup (guint64       n_iterations,
+                   gconstpointer data)
+{
+  GTree *tree = (GTree *) data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    g_tree_lookup (tree, GUINT_TO_POINTER (2 * (keys[i % N_KEYS] % N_SORTED) + 2));
+}
+
+static void
+bench_tree_insert_remove (guint64       n_iterations,
+                          gconstpointer data)
+{
+  GTree *tree = (GTree *) data;
+  guint64 i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      gpointer key = GUINT_TO_POINTER (2 * (keys[i % N_KEYS] % N_SORTED) + 1);
+
+      g_tree_insert (tree, key, NULL);
+      g_tree_remove (tree, key);
+    }
+}
+
+/* GArray */
+
+static gint
+compare_uint_ptr (gconstpointer a,
+                  gconstpointer b)
+{
+  guint ua = *(const guint *) a, ub = *(const guint *) b;
+
+  return ua < ub ? -1 : ua > ub;
+}
+
+static void
+bench_array_sort (guint64       n_iterations,
+                  gconstpointer data)
+{
+  guint n_elements = GPOINTER_TO_UINT (data);
+  GArray *array;
+  guint64 i;
+  guint j;
+
+  array = g_array_sized_new (FALSE, FALSE, sizeof (guint), n_elements);
+  for (i = 0; i < n_iterations; i++)
+    {
+      g_array_set_size (array, 0);
+      for (j = 0; j < n_elements; j++)
+        g_array_append_val (array, keys[(j * 7 + i) % N_KEYS]);
+      g_array_sort (array, compare_uint_ptr);
+    }
+  g_array_unref (array);
+}
+
+/* GSlice vs. malloc */
+
+#define N_BLOCKS 256
+
+static void
+bench_slice (guint64       n_iterations,
+             gconstpointer data)
+{
+  gsize block_size = GPOINTER_TO_SIZE (data);
+  gpointer blocks[N_BLOCKS];
+  guint64 i;
+  guint j;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      for (j = 0; j < N_BLOCKS; j++)
+        blocks[j] = g_slice_alloc (block_size);
+      for (j = 0; j < N_BLOCKS; j++)
+        g_slice_free1 (block_size, blocks[j]);
+    }
+}
+
+static void
+bench_malloc (guint64       n_iterations,
+              gconstpointer data)
+{
+  gsize block_size = GPOINTER_TO_SIZE (data);
+  gpointer blocks[N_BLOCKS];
+  guint64 i;
+  guint j;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      for (j = 0; j < N_BLOCKS; j++)
+        blocks[j] = malloc (block_size);
+      for (j = 0; j < N_BLOCKS; j++)
+        free (blocks[j]);
+    }
+}
+
+/* GAsyncQueue */
+
+typedef struct {
+  GAsyncQueue *queue;
+  guint64      n_items;
+} QueueProducer;
+
+static gpointer
+queue_producer (gpointer data)
+{
+  QueueProducer *producer = data;
+  guint64 i;
+
+  for (i = 0; i < producer->n_items; i++)
+    g_async_queue_push (producer->queue, GUINT_TO_POINTER (1));
+
+  return NULL;
+}
+
+/* One iteration is one item passed from one thread to another */
+static void
+bench_async_queue (guint64       n_iterations,
+                   gconstpointer data)
+{
+  QueueProducer producer;
+  GThread *thread;
+  guint64 i;
+
+  producer.queue = g_async_queue_new ();
+  producer.n_items = n_iterations;
+
+  thread = g_thread_new ("producer", queue_producer, &producer);
+  for (i = 0; i < n_iterations; i++)
+    g_async_queue_pop (producer.queue);
+  g_thread_join (thread);
+
+  g_async_queue_unref (producer.queue);
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const struct {
+    const gchar *name;
+    gdouble      load;
+  } loads[] = {
+    { "load-50", 0.5 },
+    { "load-70", 0.7 },
+    { "load-90", 0.9 }
+  };
+  static const gsize block_sizes[] = { 16, 64, 256 };
+  HashBench *hash_benches[G_N_ELEMENTS (loads)];
+  GSequence *seq;
+  GTree *tree;
+  gchar *path;
+  guint i;
+  int ret;
+
+  g_test_init (&argc, &argv, NULL);
+
+  init_keys ();
+
+  for (i = 0; i < G_N_ELEMENTS (loads); i++)
+    {
+      HashBench *bench = hash_bench_new (loads[i].load);
+
+      hash_benches[i] = bench;
+
+      path = g_strdup_printf ("/bench/hash/lookup-hit/%s", loads[i].name);
+      g_test_add_bench (path, bench, bench_hash_lookup_hit);
+      g_free (path);
+
+      path = g_strdup_printf ("/bench/hash/lookup-miss/%s", loads[i].name);
+      g_test_add_bench (path, bench, bench_hash_lookup_miss);
+      g_free (path);
+
+      path = g_strdup_printf ("/bench/hash/remove-insert/%s", loads[i].name);
+      g_test_add_bench (path, bench, bench_hash_remove_insert);
+      g_free (path);
+    }
+  g_test_add_bench ("/bench/hash/fill/1000", GUINT_TO_POINTER (1000), bench_hash_fill);
+
+  seq = sequence_new ();
+  g_test_add_bench ("/bench/sequence/insert-remove", seq, bench_sequence_insert_remove);
+  g_test_add_bench ("/bench/sequence/search", seq, bench_sequence_search);
+
+  tree = tree_new ();
+  g_test_add_bench ("/bench/tree/lookup", tree, bench_tree_lookup);
+  g_test_add_bench ("/bench/tree/insert-remove", tree, bench_tree_insert_remove);
+
+  g_test_add_bench ("/bench/array/sort/100", GUINT_TO_POINTER (100), bench_array_sort);
+  g_test_add_bench ("/bench/array/sort/10000", GUINT_TO_POINTER (10000), bench_array_sort);
+
+  for (i = 0; i < G_N_ELEMENTS (block_sizes); i++)
+    {
+      path = g_strdup_printf ("/bench/slice/%" G_GSIZE_FORMAT, block_sizes[i]);
+      g_test_add_bench (path, GSIZE_TO_POINTER (block_sizes[i]), bench_slice);
+      g_free (path);
+
+      path = g_strdup_printf ("/bench/malloc/%" G_GSIZE_FORMAT, block_sizes[i]);
+      g_test_add_bench (path, GSIZE_TO_POINTER (block_sizes[i]), bench_malloc);
+      g_free (path);
+    }
+
+  g_test_add_bench ("/bench/async-queue/throughput", NULL, bench_async_queue);
+
+  ret = g_test_run ();
+
+  for (i = 0; i < G_N_ELEMENTS (loads); i++)
+    hash_bench_free (hash_benches[i]);
+  g_sequence_free (seq);
+  g_tree_unref (tree);
+
+  return ret;
+}
@@ -331,6 +331,125 @@ test_null (void)
   g_assert (size == 0);
 }
 
+static void
+assert_bytes_list (GBytesList  *list,
+                   const gchar *expected)
+{
+  GString *contents;
+  guint i;
+
+  contents = g_string_new (NULL);
+  for (i = 0; i < g_bytes_list_get_n_bytes (list); i++)
+    {
+      GBytes *bytes = g_bytes_list_get_nth (list, i);
+      gconstpointer data;
+      gsize size;
+
+      data = g_bytes_get_data (bytes, &size);
+      g_assert_cmpuint (size, >, 0);
+      g_string_append_len (contents, data, size);
+    }
+
+  g_assert_cmpuint (g_bytes_list_get_size (list), ==, contents->len);
+  g_assert_cmpstr (contents->str, ==, expected);
+  g_string_free (contents, TRUE);
+}
+
+static void
+test_list_basic (void)
+{
+  GBytesList *list;
+  GBytes *bytes, *flat;
+  gchar *str;
+  gint i;
+
+  list = g_bytes_list_new ();
+  assert_bytes_list (list, "");
+
+  bytes = g_bytes_new_static ("body", 4);
+  g_bytes_list_append (list, bytes);
+  g_bytes_unref (bytes);
+  bytes = g_bytes_new_static ("head:", 5);
+  g_bytes_list_prepend (list, bytes);
+  g_bytes_unref (bytes);
+  bytes = g_bytes_new_static ("", 0);
+  g_bytes_list_append (list, bytes);
+  g_bytes_unref (bytes);
+  g_assert_cmpuint (g_bytes_list_get_n_bytes (list), ==, 2);
+  assert_bytes_list (list, "head:body");
+
+  /* grow at both ends */
+  for (i = 0; i < 100; i++)
+    {
+      bytes = g_bytes_new_static ("<", 1);
+      g_bytes_list_prepend (list, bytes);
+      g_bytes_unref (bytes);
+      bytes = g_bytes_new_static (">", 1);
+      g_bytes_list_append (list, bytes);
+      g_bytes_unref (bytes);
+    }
+  g_assert_cmpuint (g_bytes_list_get_n_bytes (list), ==, 202);
+  str = g_malloc (210);
+  memset (str, '<', 100);
+  memcpy (str + 100, "head:body", 9);
+  memset (str + 109, '>', 100);
+  str[209] = '\0';
+  assert_bytes_list (list, str);
+
+  flat = g_bytes_list_flatten (list);
+  g_assert_cmpuint (g_bytes_list_get_n_bytes (list), ==, 1);
+  g_assert (g_bytes_list_get_nth (list, 0) == flat);
+  g_assert_cmpuint (g_bytes_get_size (flat), ==, strlen (str));
+  g_assert (memcmp (g_bytes_get_data (flat, NULL), str, strlen (str)) == 0);
+  bytes = g_bytes_list_flatten (list);
+  g_assert (bytes == flat);
+  g_bytes_unref (bytes);
+  g_bytes_unref (flat);
+
+  g_bytes_list_free (list);
+  g_free (str);
+}
+
+static void
+test_list_split (void)
+{
+  const gchar *pieces[] = { "abc", "defg", "h", "ijkl" };
+  GBytesList *list, *tail;
+  GBytes *bytes;
+  gsize offset;
+  guint i;
+
+  for (offset = 0; offset <= 12; offset++)
+    {
+      gchar *full = g_strdup ("abcdefghijkl");
+
+      list = g_bytes_list_new ();
+      for (i = 0; i < G_N_ELEMENTS (pieces); i++)
+        {
+          bytes = g_bytes_new_static (pieces[i], strlen (pieces[i]));
+          g_bytes_list_append (list, bytes);
+          g_bytes_unref (bytes);
+        }
+
+      tail = g_bytes_list_split (list, offset);
+      assert_bytes_list (tail, full + offset);
+      full[offset] = '\0';
+      assert_bytes_list (list, full);
+
+      /* the halves are still usable lists */
+      bytes = g_bytes_new_static ("!", 1);
+      g_bytes_list_append (list, bytes);
+      g_bytes_list_prepend (tail, bytes);
+      g_bytes_unref (bytes);
+      g_assert_cmpuint (g_bytes_list_get_size (list), ==, offset + 1);
+      g_assert_cmpuint (g_bytes_list_get_size (tail), ==, 12 - offset + 1);
+
+      g_bytes_list_free (list);
+      g_bytes_list_free (tail);
+      g_free (full);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -353,6 +472,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/bytes/to-array/two-refs", test_to_array_two_refs);
   g_test_add_func ("/bytes/to-array/non-malloc", test_to_array_non_malloc);
   g_test_add_func ("/bytes/null", test_null);
+  g_test_add_func ("/bytes/list/basic", test_list_basic);
+  g_test_add_func ("/bytes/list/split", test_list_split);
 
   return g_test_run ();
 }
@@ -769,6 +769,380 @@ const gchar *SHA512_sums[] = {
   "9da644c289075656b5339317f7100d954b49e67e6c3f981451bf7982c52f003016470c781fa0af61a965fc0ae50f1bbc8d94ffe91e10dc09f27dbe5b1fc2827c"
 };
 
+const char *CRC32C_sums[] = {
+  "00000000",
+  "c4c21e9d",
+  "9426ea26",
+  "00c29bf3",
+  "92fe8395",
+  "764592d7",
+  "117bd392",
+  "388beccc",
+  "ae1d513f",
+  "c46c03cc",
+  "fcca5898",
+  "ca0dde44",
+  "44f5f0d6",
+  "989e0fa4",
+  "9266df01",
+  "6d3a9ac8",
+  "3bf9991e",
+  "a907a60a",
+  "06e3d389",
+  "537e5cf4",
+  "46675bb9",
+  "92b82655",
+  "725265a9",
+  "5618b0ef",
+  "9e908bd2",
+  "02c3f57f",
+  "5d497653",
+  "2f809c46",
+  "62b19a7c",
+  "3af3fe68",
+  "29fb4ff8",
+  "0b5e117a",
+  "fe0eb267",
+  "0c9061c7",
+  "11010661",
+  "e17ccce8",
+  "17f083fa",
+  "594bf4fe",
+  "1748b4c2",
+  "79f6c217",
+  "b62d88c9",
+  "4fa887ac",
+  "82ef2ee6",
+  "22620404",
+  "190097b3",
+  "d39c5c25",
+  "6d7b604b",
+  "194f8ed7",
+  "27ebf909",
+  "d2a75b3d",
+  "7b38f515",
+  "e404a8b6",
+  "637ff23e",
+  "ac4d7dcc",
+  "fca279e6",
+  "bb95e268",
+  "860ca258",
+  "de3e6e0a",
+  "6d76c279",
+  "7b87248c",
+  "435dff6c",
+  "7791dddd",
+  "1e4ce12a",
+  "99c15ac3",
+  "9b4d0f95",
+  "40b301dc",
+  "ec1040f5",
+  "f6c69f81",
+  "538e79b8",
+  "81fd3c83",
+  "da2e2e4f",
+  "807170a2",
+  "eaccebb2",
+  "2104135a",
+  "574e0aef",
+  "a86efdef",
+  "cf4b274c",
+  "dd791d14",
+  "c10d3a2d",
+  "5e848c07",
+  "164a97cc",
+  "6aa733c0",
+  "8be0ae93",
+  "5fcb8de5",
+  "a45eaa04",
+  "c4664037",
+  "253d082a",
+  "6b91a829",
+  "f256afb2",
+  "211c891e",
+  "3094e821",
+  "89b145a5",
+  "e5f3cd70",
+  "a3fd1704",
+  "aa91961f",
+  "e7db354e",
+  "9f24a421",
+  "25664ace",
+  "24d9e456",
+  "93df749c",
+  "661a744f",
+  "6dcee663",
+  "67e189ab",
+  "70ace4eb",
+  "7f8d4f71",
+  "85c68e6e",
+  "bffb3744",
+  "727f26b8",
+  "5516a937",
+  "ac7b1497",
+  "408437c7",
+  "88c4b90c",
+  "3f0bd6e6",
+  "bb564bc7",
+  "5cf50f9b",
+  "daf3267c",
+  "2a157bbb",
+  "461e309e",
+  "fc482aab",
+  "49fe8b38",
+  "e22a07fe",
+  "49e0e915",
+  "c2979742",
+  "90370e74",
+  "682a96b4",
+  "072712cf",
+  "04462bd0",
+  "be7f5b97",
+  "b1f38410",
+  "622fe964",
+  "64e05c3f",
+  "af44d6f9",
+  "c374df0b",
+  "f4e223f3",
+  "22140909",
+  "aa107f01",
+  "3311d04c",
+  "2ce0f07b",
+  "420f74ce",
+  "a25f07cb",
+  "02ff3af3",
+  "f62870fb",
+  "e68260de",
+  "5ca8dbb0",
+  "f940c1ed",
+  "c322db1c",
+  "baaf8ebc",
+  "8d2ccf18",
+  "8f1094b4",
+  "b7de82e9",
+  "f69d5143",
+  "b5acd7c1",
+  "01e6fdb8",
+  "4a0d1174",
+  "96a3fdc4",
+  "c5515116",
+  "a9f90ec2",
+  "50df72b2",
+  "2d86d2af",
+  "fa3fdb7f",
+  "2a35b746",
+  "61ba1bcc",
+  "f0575cec",
+  "dc43ed19",
+  "5885abe6",
+  "8ec0d1a6",
+  "2d58cd0c",
+  "3fae4a92",
+  "504925f6",
+  "9e96da47",
+  "44a16bd2",
+  "24b82377",
+  "a33c5cea",
+  "7c50eb52",
+  "c2a22740",
+  "a6c81b43",
+  "09dafac3",
+  "5c47832a",
+  "d4c09e71",
+  "42f754a0",
+  "92bcb65a",
+  "de2ade1e",
+  "8c4da63e",
+  "1cbce5bc"
+};
+
+const char *XXH64_sums[] = {
+  "ef46db3751d8e999",
+  "5b4d6af247a3cf7b",
+  "4d9dd5b2d0613c90",
+  "4108f90b5de14d15",
+  "cdf13a49d263200f",
+  "f0d7a3adcfa8c683",
+  "645e5d666ac3e66d",
+  "c6fce9d72e310949",
+  "d07b38a78a153b0b",
+  "9d1214db001dfc69",
+  "db3919475ab1cf22",
+  "61cbdf23c67af875",
+  "b2ed38017844f789",
+  "ed6dc8c5841a51e4",
+  "5e5ddb1fae229e50",
+  "59bf1a33358c7d98",
+  "0f7e67014943a311",
+  "6bf87c8b1fd9ed1a",
+  "a2d31bb8d44b0557",
+  "c9b4e7b3c328d9e0",
+  "457cd2650fe6aa94",
+  "3c5831248b534326",
+  "645c543cb504efad",
+  "b91f8b1617c11212",
+  "e5bcc54f9811d5de",
+  "1eb61388311e1536",
+  "54ad75ab2f5cbf06",
+  "425f794b47c2bd48",
+  "1dcd16dd15317465",
+  "2fca2d55fcc6c2cf",
+  "cbd47a9c2bf5830b",
+  "3f8d95ab32c127d9",
+  "e2bbc9136629a4ee",
+  "6d92fe2ebab7db31",
+  "20c50c763d3e7180",
+  "2d27cba0d24872de",
+  "9457ee2b0cace793",
+  "675af3b6c6f51195",
+  "b3e5ae9ec090534c",
+  "e01509ec7bdd4b5e",
+  "581a9e84f2ab44ef",
+  "9d60cef4bf4427b0",
+  "ab06bcadc103bf7d",
+  "0b242d361fda71bc",
+  "44ad33705751ad73",
+  "4e3f771fa5fc96ce",
+  "684fd2bc5f547bf5",
+  "a522aabca20e7755",
+  "c837c630869b5678",
+  "cc14895d38cdb996",
+  "349a908c5a89108c",
+  "e8da97b6335e322e",
+  "44df07597c14305c",
+  "3e889221eb596151",
+  "0ec49be6225f9152",
+  "80fb820491ad1667",
+  "cfc6384a64f226ad",
+  "e9c87a586b4c5acc",
+  "e9f113b6c9d0e874",
+  "ff45221ae73ecd7e",
+  "1dba15ba5792ee08",
+  "3e61b8e9eef99567",
+  "a9beba1d3842765c",
+  "23099fdeccf4bb7e",
+  "88213f45efcbf7ba",
+  "176c52a3056c833a",
+  "75e8b6de87cfb8a0",
+  "8556df798cbbd734",
+  "1126227704684df3",
+  "fcce3f9bcfd38281",
+  "82038580d5055c17",
+  "6447664ac5c0670e",
+  "6db487181d716565",
+  "de401d06eab0829c",
+  "ff75a5e3236d6e00",
+  "1cbe403b2eeac18a",
+  "34df908f964988af",
+  "64a023918c360244",
+  "daa8b7e95c4f66fa",
+  "cbe585aa185b2094",
+  "77225f6bd275609d",
+  "8fe29ec6aa2ff1b1",
+  "cf4f49d7b5a5dbc3",
+  "6b8d814da048a454",
+  "de37261dfe25b651",
+  "63f900cf2337c673",
+  "f7ab0bba5cff27e7",
+  "be97ef76d6959d79",
+  "5ef6eb490170ab55",
+  "cc09d33b411967f2",
+  "22a4b02c5a6f9ea6",
+  "d032179db215e4fe",
+  "fa49983b43fc6dec",
+  "34fe5e21ba870d0d",
+  "c7808f7a7b2401fb",
+  "cfa0553367d2b2ff",
+  "34ae991f8164a3cd",
+  "351762b53c5bb000",
+  "ba0ee68da1d17d46",
+  "ad8f314895dc3e57",
+  "80e72f1c838da2ee",
+  "3f8ec0e1b2bd35a3",
+  "ce1b5411627c764c",
+  "c5ab77b31d852162",
+  "e3e9b80e5a947ebd",
+  "2c766ee3f58e9b8b",
+  "a23ced1ed11008ea",
+  "94cff40a7adf19cd",
+  "93fd01e6cacac6dc",
+  "d5d3e6e4a23a2ac6",
+  "2496c49ca2d3e84b",
+  "02cbd805183e499d",
+  "2bbb4306296af12d",
+  "f2c27758a70f01ba",
+  "39f10c0a29a2c452",
+  "2cc34b92c8d839d5",
+  "39439dc91b98fc66",
+  "8b91e78b6016948d",
+  "6b2d2404ffbddea3",
+  "16ce8c7be3418a9e",
+  "cb2414badf198cf2",
+  "db17b66e055a0eb3",
+  "c53bf37052100439",
+  "e1eb3bdfc04e3b59",
+  "ad01c9f52a93ea51",
+  "44548d8d65f89bc7",
+  "573b8411217a31ac",
+  "66d237ad7bffa584",
+  "4b33f4273c9baa3d",
+  "e15f9d6474d09869",
+  "ac14994b8eb1aed3",
+  "047fc09d972c7457",
+  "89527d88b5f59bd4",
+  "fc628be37e0174de",
+  "64927cb4d56545ca",
+  "874854b691270f31",
+  "bd8bd446bcb154d1",
+  "86244c551c6dec4d",
+  "85e76b59d55e1fe3",
+  "4d7f66fe55b7e77f",
+  "1087e665acf8432d",
+  "c7c3e73a6a37677f",
+  "2b5c0d288345280b",
+  "727270f58c214200",
+  "99641fa6f9e7b702",
+  "cfda07931fb45852",
+  "ad6ce7e523bc6382",
+  "517e6acdd03d351b",
+  "e2927f53d7bd40c1",
+  "34f9564559ab72fa",
+  "eb9353d63a5fcbe9",
+  "6eae586037dabb60",
+  "19d5230909b64125",
+  "8e5721ab7fbcde0f",
+  "d59d2c0a466e7c26",
+  "b62aefb20f31ac35",
+  "adde49dc9cfa2539",
+  "38ad826716240065",
+  "7b2d26fdebe32c8e",
+  "6f79baa5314592d1",
+  "b04fd3f969352389",
+  "23557a5e8ce2a903",
+  "2d742e576fa67531",
+  "73bfe4ad0cf60baf",
+  "d3566f15288ecd9c",
+  "20cd1f610e29fcde",
+  "7a33dc9d4ffd2faf",
+  "f0224b7a2fede7bd",
+  "15617ebb70186d18",
+  "5904b06f0e45c92a",
+  "afc2e58eb2d2045e",
+  "0eacc2b4aad146e1",
+  "6ed563877972f744",
+  "72da26e0da4c485c",
+  "aee33b0f6c090f11",
+  "3b60389a7faa8515",
+  "63508aaff1f2b00f",
+  "1c37ed17b31713ca",
+  "6dd661266ace0404",
+  "916aecc99e5293d3",
+  "e508c333a8eb5194",
+  "e5de68e6395a37db",
+  "53c363fa04f7aa97",
+  "6acd76ac0fa2b8f2"
+};
+
 typedef struct {
   GChecksumType  checksum_type;
   const gchar   *sum;
@@ -988,6 +1362,100 @@ add_checksum_bytes_test (GChecksumType   type,
   g_free (path);
 }
 
+static void
+test_checksum_many (gconstpointer d)
+{
+  const ChecksumComputeTest *test = d;
+  const guchar *data[FIXED_LEN + 1];
+  gsize lengths[FIXED_LEN + 1];
+  gsize len, expected_len;
+  guint8 *digests, *expected;
+  gint i;
+
+  len = g_checksum_type_get_length (test->checksum_type);
+  for (i = 0; i <= FIXED_LEN; i++)
+    {
+      /* in descending order, so that inputs finish at different times */
+      data[i] = (const guchar *) FIXED_STR;
+      lengths[i] = FIXED_LEN - i;
+    }
+
+  digests = g_malloc (len * (FIXED_LEN + 1));
+  g_compute_checksum_for_data_many (test->checksum_type, data, lengths,
+                                    FIXED_LEN + 1, digests);
+
+  for (i = 0; i <= FIXED_LEN; i++)
+    {
+      expected = sum_to_digest (test->sums[FIXED_LEN - i], &expected_len);
+      g_assert_cmpint (expected_len, ==, len);
+      g_assert (memcmp (digests + i * len, expected, len) == 0);
+      g_free (expected);
+    }
+
+  g_free (digests);
+}
+
+static void
+add_checksum_many_test (GChecksumType   type,
+                        const gchar    *type_name,
+                        const gchar   **sums)
+{
+  ChecksumComputeTest *test;
+  gchar *path;
+
+  test = g_new0 (ChecksumComputeTest, 1);
+  test->checksum_type = type;
+  test->sums = sums;
+
+  path = g_strdup_printf ("/checksum/%s/many", type_name);
+  g_test_add_data_func_full (path, test, test_checksum_many, g_free);
+  g_free (path);
+}
+
+/* enough data to be split over several threads */
+static void
+test_checksum_many_large (void)
+{
+  const gint n_data = 200;
+  const guchar **data;
+  gsize *lengths;
+  guint8 *buffer, *digests, digest[32];
+  gsize len;
+  gint i;
+
+  buffer = g_malloc (64 * 1024);
+  for (i = 0; i < 64 * 1024; i++)
+    buffer[i] = g_test_rand_int ();
+
+  data = g_new (const guchar *, n_data);
+  lengths = g_new (gsize, n_data);
+  for (i = 0; i < n_data; i++)
+    {
+      lengths[i] = g_test_rand_int_range (0, 32 * 1024);
+      data[i] = buffer + g_test_rand_int_range (0, 32 * 1024);
+    }
+
+  digests = g_malloc (32 * n_data);
+  g_compute_checksum_for_data_many (G_CHECKSUM_SHA256, data, lengths, n_data, digests);
+
+  for (i = 0; i < n_data; i++)
+    {
+      GChecksum *checksum;
+
+      checksum = g_checksum_new (G_CHECKSUM_SHA256);
+      g_checksum_update (checksum, data[i], lengths[i]);
+      len = sizeof digest;
+      g_checksum_get_digest (checksum, digest, &len);
+      g_assert (memcmp (digests + 32 * i, digest, 32) == 0);
+      g_checksum_free (checksum);
+    }
+
+  g_free (digests);
+  g_free (lengths);
+  g_free (data);
+  g_free (buffer);
+}
+
 static void
 test_unsupported (void)
 {
@@ -1008,21 +1476,39 @@ main (int argc, char *argv[])
     add_checksum_test (G_CHECKSUM_MD5, "MD5", MD5_sums[length], length);
   add_checksum_string_test (G_CHECKSUM_MD5, "MD5", MD5_sums);
   add_checksum_bytes_test (G_CHECKSUM_MD5, "MD5", MD5_sums);
+  add_checksum_many_test (G_CHECKSUM_MD5, "MD5", MD5_sums);
 
   for (length = 0; length <= FIXED_LEN; length++)
     add_checksum_test (G_CHECKSUM_SHA1, "SHA1", SHA1_sums[length], length);
   add_checksum_string_test (G_CHECKSUM_SHA1, "SHA1", SHA1_sums);
   add_checksum_bytes_test (G_CHECKSUM_SHA1, "SHA1", SHA1_sums);
+  add_checksum_many_test (G_CHECKSUM_SHA1, "SHA1", SHA1_sums);
 
   for (length = 0; length <= FIXED_LEN; length++)
     add_checksum_test (G_CHECKSUM_SHA256, "SHA256", SHA256_sums[length], length);
   add_checksum_string_test (G_CHECKSUM_SHA256, "SHA256", SHA256_sums);
   add_checksum_bytes_test (G_CHECKSUM_SHA256, "SHA256", SHA256_sums);
+  add_checksum_many_test (G_CHECKSUM_SHA256, "SHA256", SHA256_sums);
 
   for (length = 0; length <= FIXED_LEN; length++)
     add_checksum_test (G_CHECKSUM_SHA512, "SHA512", SHA512_sums[length], length);
   add_checksum_string_test (G_CHECKSUM_SHA512, "SHA512", SHA512_sums);
   add_checksum_bytes_test (G_CHECKSUM_SHA512, "SHA512", SHA512_sums);
+  add_checksum_many_test (G_CHECKSUM_SHA512, "SHA512", SHA512_sums);
+
+  for (length = 0; length <= FIXED_LEN; length++)
+    add_checksum_test (G_CHECKSUM_CRC32C, "CRC32C", CRC32C_sums[length], length);
+  add_checksum_string_test (G_CHECKSUM_CRC32C, "CRC32C", CRC32C_sums);
+  add_checksum_bytes_test (G_CHECKSUM_CRC32C, "CRC32C", CRC32C_sums);
+  add_checksum_many_test (G_CHECKSUM_CRC32C, "CRC32C", CRC32C_sums);
+
+  for (length = 0; length <= FIXED_LEN; length++)
+    add_checksum_test (G_CHECKSUM_XXH64, "XXH64", XXH64_sums[length], length);
+  add_checksum_string_test (G_CHECKSUM_XXH64, "XXH64", XXH64_sums);
+  add_checksum_bytes_test (G_CHECKSUM_XXH64, "XXH64", XXH64_sums);
+  add_checksum_many_test (G_CHECKSUM_XXH64, "XXH64", XXH64_sums);
+
+  g_test_add_func ("/checksum/many-large", test_checksum_many_large);
 
   return g_test_run ();
 }
@@ -188,6 +188,92 @@ const gchar *file_sorted1[] = {
   NULL
 };
 
+static void
+test_collator_keys (void)
+{
+  const gchar **inputs[] = { input0, input1 };
+  GCollator *collator;
+  gint i, j;
+
+  collator = g_collator_new ();
+
+  for (i = 0; i < G_N_ELEMENTS (inputs); i++)
+    {
+      gchar **keys, **file_keys;
+
+      keys = g_collator_collate_keys (collator, inputs[i], -1, FALSE);
+      file_keys = g_collator_collate_keys (collator, inputs[i], -1, TRUE);
+
+      for (j = 0; inputs[i][j]; j++)
+        {
+          gchar *key;
+
+          key = g_utf8_collate_key (inputs[i][j], -1);
+          g_assert_cmpstr (keys[j], ==, key);
+          g_free (key);
+
+          key = g_collator_collate_key (collator, inputs[i][j], -1);
+          g_assert_cmpstr (keys[j], ==, key);
+          g_free (key);
+
+          key = g_utf8_collate_key_for_filename (inputs[i][j], -1);
+          g_assert_cmpstr (file_keys[j], ==, key);
+          g_free (key);
+
+          key = g_collator_collate_key_for_filename (collator, inputs[i][j], -1);
+          g_assert_cmpstr (file_keys[j], ==, key);
+          g_free (key);
+        }
+      g_assert (keys[j] == NULL);
+      g_assert (file_keys[j] == NULL);
+
+      g_strfreev (keys);
+      g_strfreev (file_keys);
+    }
+
+  g_collator_free (collator);
+}
+
+static void
+test_collator_c_locale (void)
+{
+  const gchar *strs[] = { "banana", "Zebra", "\xef\xac\x81sh", "apple" };
+  GCollator *collator;
+  gchar *old_locale;
+  gchar **keys;
+  gchar *key;
+
+  old_locale = g_strdup (setlocale (LC_COLLATE, NULL));
+  setlocale (LC_COLLATE, "C");
+  collator = g_collator_new ();
+
+  /* code point order, on the compatibility composed form */
+  keys = g_collator_collate_keys (collator, strs, G_N_ELEMENTS (strs), FALSE);
+  g_assert_cmpstr (keys[0], ==, "banana");
+  g_assert_cmpstr (keys[1], ==, "Zebra");
+  g_assert_cmpstr (keys[2], ==, "fish");
+  g_assert_cmpstr (keys[3], ==, "apple");
+  g_assert (keys[4] == NULL);
+  g_strfreev (keys);
+
+  key = g_utf8_collate_key ("banana split", 6);
+  g_assert_cmpstr (key, ==, "banana");
+  g_free (key);
+
+  key = g_collator_collate_key (collator, "e\xcc\x81", -1);
+  g_assert_cmpstr (key, ==, "\xc3\xa9");
+  g_free (key);
+
+  /* keeps the rules it was created with */
+  setlocale (LC_COLLATE, old_locale);
+  key = g_collator_collate_key (collator, "Zebra", -1);
+  g_assert_cmpstr (key, ==, "Zebra");
+  g_free (key);
+
+  g_collator_free (collator);
+  g_free (old_locale);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -200,10 +286,14 @@ main (int argc, char *argv[])
 
   g_setenv ("LC_ALL", "en_US", TRUE);
   locale = setlocale (LC_ALL, "");
+
+  g_test_add_func ("/unicode/collator/keys", test_collator_keys);
+  g_test_add_func ("/unicode/collator/c-locale", test_collator_c_locale);
+
   if (locale == NULL || strcmp (locale, "en_US") != 0)
     {
       g_test_message ("No suitable locale, skipping test");
-      return 0;
+      return g_test_run ();
     }
 
   test[0].input = input0;
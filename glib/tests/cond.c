@@ -232,6 +232,41 @@ test_cond2 (void)
   barrier_clear (&b);
 }
 
+static void
+test_wait_until (void)
+{
+  gint64 until;
+  GMutex lock;
+  GCond cond;
+
+  /* We should not wake up, other than spuriously, until the specified
+   * time has passed.
+   */
+  g_mutex_init (&lock);
+  g_cond_init (&cond);
+
+  until = g_get_monotonic_time () + G_TIME_SPAN_SECOND / 10;
+
+  /* Could still have spurious wakeups, so we must loop... */
+  g_mutex_lock (&lock);
+  while (g_cond_wait_until (&cond, &lock, until))
+    ;
+
+  /* Make sure it's after the until time */
+  g_assert_cmpint (until, <=, g_get_monotonic_time ());
+
+  /* Make sure it returns FALSE on timeout */
+  until = g_get_monotonic_time () + G_TIME_SPAN_SECOND / 50;
+  g_assert (g_cond_wait_until (&cond, &lock, until) == FALSE);
+
+  /* ... and immediately for a time in the past */
+  g_assert (g_cond_wait_until (&cond, &lock, until) == FALSE);
+
+  g_mutex_unlock (&lock);
+  g_mutex_clear (&lock);
+  g_cond_clear (&cond);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -239,6 +274,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/thread/cond1", test_cond1);
   g_test_add_func ("/thread/cond2", test_cond2);
+  g_test_add_func ("/thread/cond/wait-until", test_wait_until);
 
   return g_test_run ();
 }
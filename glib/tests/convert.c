@@ -702,6 +702,76 @@ test_no_conv (void)
   g_error_free (error);
 }
 
+/* converters are cached and reused, check that no state leaks from
+ * one conversion to the next */
+static gpointer
+converter_reuse_thread (gpointer data)
+{
+  const gchar *charsets[] = { "ISO-8859-1", "ISO-8859-15", "UTF-16LE",
+                              "UTF-16BE", "UCS-4LE", "CP1252" };
+  gint i, j;
+
+  for (i = 0; i < 50; i++)
+    for (j = 0; j < G_N_ELEMENTS (charsets); j++)
+      {
+        GError *error = NULL;
+        gchar *converted, *back;
+        gsize bytes_written;
+
+        converted = g_convert ("caf\xc3\xa9", -1, charsets[j], "UTF-8",
+                               NULL, &bytes_written, &error);
+        g_assert_no_error (error);
+        back = g_convert (converted, bytes_written, "UTF-8", charsets[j],
+                          NULL, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpstr (back, ==, "caf\xc3\xa9");
+        g_free (converted);
+        g_free (back);
+      }
+
+  return NULL;
+}
+
+static void
+test_converter_reuse (void)
+{
+  GThread *threads[4];
+  GError *error = NULL;
+  gchar *out;
+  gint i;
+
+  /* a failed conversion doesn't break the next one */
+  out = g_convert ("a\xe2\x82\xac", -1, "ISO-8859-1", "UTF-8", NULL, NULL, &error);
+  g_assert_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_ILLEGAL_SEQUENCE);
+  g_assert (out == NULL);
+  g_clear_error (&error);
+
+  out = g_convert ("a\xc3\xa9", -1, "ISO-8859-1", "UTF-8", NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (out, ==, "a\xe9");
+  g_free (out);
+
+  /* nor does one that stops in the middle of a shift sequence */
+  out = g_convert ("\xe6\x97\xa5\xff", -1, "ISO-2022-JP", "UTF-8", NULL, NULL, &error);
+  if (error && error->code == G_CONVERT_ERROR_NO_CONVERSION)
+    g_clear_error (&error);
+  else
+    {
+      g_assert_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_ILLEGAL_SEQUENCE);
+      g_clear_error (&error);
+
+      out = g_convert ("abc", -1, "ISO-2022-JP", "UTF-8", NULL, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpstr (out, ==, "abc");
+      g_free (out);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("convert", converter_reuse_thread, NULL);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -714,6 +784,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/conversion/unicode", test_unicode_conversions);
   g_test_add_func ("/conversion/filename-utf8", test_filename_utf8);
   g_test_add_func ("/conversion/filename-display", test_filename_display);
+  g_test_add_func ("/conversion/converter-reuse", test_converter_reuse);
 
   return g_test_run ();
 }
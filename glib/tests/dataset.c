@@ -43,6 +43,74 @@ test_quark_string (void)
   g_free (copy);
 }
 
+#define N_QUARK_THREADS 4
+#define N_THREAD_QUARKS 5000
+
+typedef struct {
+  gint    offset;
+  GQuark *results;
+} QuarkThreadData;
+
+static gpointer
+quark_thread (gpointer data)
+{
+  QuarkThreadData *td = data;
+  gchar name[32];
+  gint i;
+
+  /* all threads create the same quarks concurrently, in a different
+   * order, enough of them to make the quark table grow
+   */
+  for (i = 0; i < N_THREAD_QUARKS; i++)
+    {
+      g_snprintf (name, sizeof name, "quark-thread-%d", (i * 7 + td->offset) % N_THREAD_QUARKS);
+      g_quark_from_string (name);
+    }
+
+  for (i = 0; i < N_THREAD_QUARKS; i++)
+    {
+      g_snprintf (name, sizeof name, "quark-thread-%d", i);
+      td->results[i] = g_quark_try_string (name);
+    }
+
+  return NULL;
+}
+
+static void
+test_quark_threaded (void)
+{
+  GThread *threads[N_QUARK_THREADS];
+  QuarkThreadData data[N_QUARK_THREADS];
+  GQuark *results[N_QUARK_THREADS];
+  gint i, j;
+
+  for (i = 0; i < N_QUARK_THREADS; i++)
+    {
+      results[i] = g_new (GQuark, N_THREAD_QUARKS);
+      data[i].offset = i * 1000;
+      data[i].results = results[i];
+      threads[i] = g_thread_new ("quark", quark_thread, &data[i]);
+    }
+  for (i = 0; i < N_QUARK_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  for (j = 0; j < N_THREAD_QUARKS; j++)
+    {
+      gchar *name = g_strdup_printf ("quark-thread-%d", j);
+
+      g_assert (results[0][j] != 0);
+      g_assert_cmpstr (g_quark_to_string (results[0][j]), ==, name);
+      g_assert (g_intern_string (name) == g_quark_to_string (results[0][j]));
+      for (i = 1; i < N_QUARK_THREADS; i++)
+        g_assert (results[i][j] == results[0][j]);
+
+      g_free (name);
+    }
+
+  for (i = 0; i < N_QUARK_THREADS; i++)
+    g_free (results[i]);
+}
+
 static void
 test_dataset_basic (void)
 {
@@ -200,6 +268,55 @@ test_datalist_clear (void)
   g_test_trap_assert_passed ();
 }
 
+static void
+test_datalist_many (void)
+{
+  GData *list;
+  GQuark keys[100];
+  GDestroyNotify old_destroy;
+  gchar *name;
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+      name = g_strdup_printf ("datalist-many-%d", i);
+      keys[i] = g_quark_from_string (name);
+      g_free (name);
+    }
+
+  g_datalist_init (&list);
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    g_datalist_id_set_data (&list, keys[i], GINT_TO_POINTER (i + 1));
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    g_assert_cmpint (GPOINTER_TO_INT (g_datalist_id_get_data (&list, keys[i])), ==, i + 1);
+  g_assert_cmpint (GPOINTER_TO_INT (g_datalist_get_data (&list, "datalist-many-42")), ==, 43);
+  g_assert (g_datalist_get_data (&list, "datalist-many-unset") == NULL);
+
+  /* removing moves the last element around */
+  for (i = 0; i < G_N_ELEMENTS (keys); i += 2)
+    g_datalist_id_remove_data (&list, keys[i]);
+  g_assert (g_datalist_id_replace_data (&list, keys[1], GINT_TO_POINTER (2), NULL, NULL, &old_destroy));
+  g_assert (g_datalist_id_replace_data (&list, keys[3], GINT_TO_POINTER (4), GINT_TO_POINTER (-4), NULL, &old_destroy));
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+      gpointer expected;
+
+      if (i % 2 == 0 || i == 1)
+        expected = NULL;
+      else if (i == 3)
+        expected = GINT_TO_POINTER (-4);
+      else
+        expected = GINT_TO_POINTER (i + 1);
+
+      g_assert (g_datalist_id_get_data (&list, keys[i]) == expected);
+    }
+
+  g_datalist_clear (&list);
+  g_assert (list == NULL);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -207,6 +324,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/quark/basic", test_quark_basic);
   g_test_add_func ("/quark/string", test_quark_string);
+  g_test_add_func ("/quark/threaded", test_quark_threaded);
   g_test_add_func ("/dataset/basic", test_dataset_basic);
   g_test_add_func ("/dataset/id", test_dataset_id);
   g_test_add_func ("/dataset/full", test_dataset_full);
@@ -214,6 +332,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/dataset/destroy", test_dataset_destroy);
   g_test_add_func ("/datalist/recursive-clear", test_datalist_clear);
   g_test_add_func ("/datalist/recursive-clear/subprocess", test_datalist_clear_subprocess);
+  g_test_add_func ("/datalist/many", test_datalist_many);
 
   return g_test_run ();
 }
@@ -768,6 +768,141 @@ test_set_contents (void)
   g_free (name);
 }
 
+static void
+check_file_contents (const gchar *name,
+                     const gchar *expected)
+{
+  GError *error = NULL;
+  gchar *buf;
+  gsize len;
+  gboolean ret;
+
+  ret = g_file_get_contents (name, &buf, &len, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_assert_cmpstr (buf, ==, expected);
+  g_free (buf);
+}
+
+static void
+test_set_contents_full (void)
+{
+  GFileSetContentsFlags flags[] = {
+    G_FILE_SET_CONTENTS_NONE,
+    G_FILE_SET_CONTENTS_CONSISTENT,
+    G_FILE_SET_CONTENTS_CONSISTENT | G_FILE_SET_CONTENTS_ONLY_EXISTING,
+    G_FILE_SET_CONTENTS_CONSISTENT | G_FILE_SET_CONTENTS_DURABLE,
+    G_FILE_SET_CONTENTS_DURABLE,
+    G_FILE_SET_CONTENTS_CONSISTENT | G_FILE_SET_CONTENTS_ANONYMOUS,
+    G_FILE_SET_CONTENTS_DURABLE | G_FILE_SET_CONTENTS_ANONYMOUS
+  };
+  GError *error = NULL;
+  gchar *dir, *name;
+  GStatBuf statbuf;
+  GDir *d;
+  guint i;
+  gboolean ret;
+
+  dir = g_dir_make_tmp ("set-contents-XXXXXX", &error);
+  g_assert_no_error (error);
+  name = g_build_filename (dir, "file", NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (flags); i++)
+    {
+      gchar *contents = g_strdup_printf ("contents %u", i);
+
+      ret = g_file_set_contents_full (name, contents, -1, flags[i], 0600, &error);
+      g_assert_no_error (error);
+      g_assert (ret);
+      check_file_contents (name, contents);
+
+#ifndef G_OS_WIN32
+      g_assert (g_stat (name, &statbuf) == 0);
+      g_assert_cmpint (statbuf.st_mode & 0777, ==, 0600);
+#endif
+
+      g_free (contents);
+    }
+
+  /* no temporary files are left behind */
+  d = g_dir_open (dir, 0, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (g_dir_read_name (d), ==, "file");
+  g_assert (g_dir_read_name (d) == NULL);
+  g_dir_close (d);
+
+  g_remove (name);
+  g_rmdir (dir);
+  g_free (name);
+  g_free (dir);
+}
+
+static void
+test_sync_group (void)
+{
+  GError *error = NULL;
+  GFileSyncGroup *group;
+  gchar *dir, *names[3];
+  GDir *d;
+  guint i;
+  gboolean ret;
+
+  dir = g_dir_make_tmp ("sync-group-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      gchar *base = g_strdup_printf ("file%u", i);
+      names[i] = g_build_filename (dir, base, NULL);
+      g_free (base);
+      ret = g_file_set_contents (names[i], "old", -1, &error);
+      g_assert_no_error (error);
+      g_assert (ret);
+    }
+
+  group = g_file_sync_group_new (G_FILE_SET_CONTENTS_CONSISTENT |
+                                 G_FILE_SET_CONTENTS_DURABLE |
+                                 G_FILE_SET_CONTENTS_ANONYMOUS);
+
+  /* nothing changes until the group is committed */
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      ret = g_file_sync_group_set_contents (group, names[i], "new", -1, 0666, &error);
+      g_assert_no_error (error);
+      g_assert (ret);
+      check_file_contents (names[i], "old");
+    }
+
+  ret = g_file_sync_group_commit (group, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    check_file_contents (names[i], "new");
+
+  /* freeing the group discards what was not committed */
+  ret = g_file_sync_group_set_contents (group, names[0], "discarded", -1, 0666, &error);
+  g_assert_no_error (error);
+  g_assert (ret);
+  g_file_sync_group_free (group);
+  check_file_contents (names[0], "new");
+
+  d = g_dir_open (dir, 0, &error);
+  g_assert_no_error (error);
+  for (i = 0; g_dir_read_name (d) != NULL; i++)
+    ;
+  g_assert_cmpuint (i, ==, G_N_ELEMENTS (names));
+  g_dir_close (d);
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      g_remove (names[i]);
+      g_free (names[i]);
+    }
+  g_rmdir (dir);
+  g_free (dir);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -787,6 +922,8 @@ main (int   argc,
   g_test_add_func ("/fileutils/mkstemp", test_mkstemp);
   g_test_add_func ("/fileutils/mkdtemp", test_mkdtemp);
   g_test_add_func ("/fileutils/set-contents", test_set_contents);
+  g_test_add_func ("/fileutils/set-contents-full", test_set_contents_full);
+  g_test_add_func ("/fileutils/sync-group", test_sync_group);
 
   return g_test_run ();
 }
@@ -1577,6 +1577,145 @@ test_posix_parse (void)
   g_time_zone_unref (tz);
 }
 
+static void
+test_formatter (void)
+{
+  const gchar *formats[] = {
+    "%a %A %b %B %h %c %x %X %r",
+    "%C %d %e %F %g %G %H %I %j %k %l %m %M %p %P %R %s %S %T",
+    "%u %V %w %y %Y %z %:z %::z %:::z %Z %% %n %t",
+    "%-d %_d %0e %_H %-m %O-d %_Y",
+    "x%Y-%m-%dT%H:%M:%S%:z%"
+  };
+  GDateTimeFormatter *formatter;
+  GDateTime *dt;
+  GTimeZone *tz;
+  GString *str;
+  gchar *expected, *formatted;
+  gint i;
+
+  tz = g_time_zone_new ("-03:30");
+  dt = g_date_time_new (tz, 2013, 2, 3, 14, 5, 6.5);
+  str = g_string_new (NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      expected = g_date_time_format (dt, formats[i]);
+      formatter = g_date_time_formatter_new (formats[i]);
+      g_assert (formatter != NULL);
+
+      formatted = g_date_time_formatter_format (formatter, dt);
+      g_assert_cmpstr (formatted, ==, expected);
+      g_free (formatted);
+
+      g_string_assign (str, "prefix ");
+      g_assert (g_date_time_formatter_append (formatter, dt, str));
+      g_assert (g_str_has_prefix (str->str, "prefix "));
+      g_assert_cmpstr (str->str + 7, ==, expected);
+
+      g_date_time_formatter_free (formatter);
+      g_free (expected);
+    }
+
+  formatter = g_date_time_formatter_new ("%d.%m.%Y %H:%M");
+  g_string_truncate (str, 0);
+  g_assert (g_date_time_formatter_append (formatter, dt, str));
+  g_assert_cmpstr (str->str, ==, "03.02.2013 14:05");
+  g_date_time_formatter_free (formatter);
+
+  g_assert (g_date_time_formatter_new ("%Y %Q") == NULL);
+  g_assert (g_date_time_formatter_new ("%:d") == NULL);
+  g_assert (g_date_time_formatter_new ("%::::z") == NULL);
+
+  g_string_free (str, TRUE);
+  g_date_time_unref (dt);
+  g_time_zone_unref (tz);
+}
+
+static void
+test_format_iso8601 (void)
+{
+  GDateTime *dt;
+  GTimeZone *tz;
+  gchar *str;
+
+  dt = g_date_time_new_utc (2013, 2, 3, 14, 5, 6);
+  str = g_date_time_format_iso8601 (dt);
+  g_assert_cmpstr (str, ==, "2013-02-03T14:05:06Z");
+  g_free (str);
+  g_date_time_unref (dt);
+
+  dt = g_date_time_new_utc (987, 12, 31, 23, 59, 59.25);
+  str = g_date_time_format_iso8601 (dt);
+  g_assert_cmpstr (str, ==, "0987-12-31T23:59:59.250000Z");
+  g_free (str);
+  g_date_time_unref (dt);
+
+  tz = g_time_zone_new ("+05:30");
+  dt = g_date_time_new (tz, 2013, 2, 3, 0, 0, 0.000001);
+  str = g_date_time_format_iso8601 (dt);
+  g_assert_cmpstr (str, ==, "2013-02-03T00:00:00.000001+05:30");
+  g_free (str);
+  g_date_time_unref (dt);
+  g_time_zone_unref (tz);
+
+  tz = g_time_zone_new ("-00:30");
+  dt = g_date_time_new (tz, 2013, 2, 3, 0, 0, 0);
+  str = g_date_time_format_iso8601 (dt);
+  g_assert_cmpstr (str, ==, "2013-02-03T00:00:00-00:30");
+  g_free (str);
+  g_date_time_unref (dt);
+  g_time_zone_unref (tz);
+}
+
+static void
+test_interval_order (void)
+{
+  GTimeZone *tz;
+  gint intervals[520];
+  gint64 t;
+  gint i;
+
+  tz = g_time_zone_new ("EST5EDT,M3.2.0,M11.1.0");
+
+  /* the result mustn't depend on what was looked up before */
+  for (i = 0; i < G_N_ELEMENTS (intervals); i++)
+    {
+      t = 1262304000 + (gint64) i * 7 * 86400;
+      intervals[i] = g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, t);
+      if (i > 0)
+        g_assert_cmpint (intervals[i], >=, intervals[i - 1]);
+    }
+  g_assert_cmpint (intervals[0], <, intervals[G_N_ELEMENTS (intervals) - 1]);
+
+  for (i = G_N_ELEMENTS (intervals) - 1; i >= 0; i -= 3)
+    {
+      t = 1262304000 + (gint64) i * 7 * 86400;
+      g_assert_cmpint (g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, t), ==, intervals[i]);
+      g_assert_cmpint (g_time_zone_find_interval (tz, G_TIME_TYPE_UNIVERSAL, 0), <, intervals[i]);
+    }
+
+  g_time_zone_unref (tz);
+}
+
+static void
+test_zone_cache (void)
+{
+  GTimeZone *tz1, *tz2;
+
+  tz1 = g_time_zone_new ("EST5EDT,M3.2.0,M11.1.0");
+  tz2 = g_time_zone_new ("EST5EDT,M3.2.0,M11.1.0");
+  g_assert (tz1 == tz2);
+  g_time_zone_unref (tz2);
+
+  /* recently used zones are kept around */
+  g_time_zone_unref (tz1);
+  tz2 = g_time_zone_new ("EST5EDT,M3.2.0,M11.1.0");
+  g_assert (tz1 == tz2);
+  g_assert_cmpint (g_time_zone_get_offset (tz2, 0), ==, -5 * 3600);
+  g_time_zone_unref (tz2);
+}
+
 gint
 main (gint   argc,
       gchar *argv[])
@@ -1627,10 +1766,14 @@ main (gint   argc,
   g_test_add_func ("/GDateTime/dst", test_GDateTime_dst);
   g_test_add_func ("/GDateTime/test_z", test_z);
   g_test_add_func ("/GDateTime/test-all-dates", test_all_dates);
+  g_test_add_func ("/GDateTime/formatter", test_formatter);
+  g_test_add_func ("/GDateTime/format-iso8601", test_format_iso8601);
   g_test_add_func ("/GTimeZone/find-interval", test_find_interval);
   g_test_add_func ("/GTimeZone/adjust-time", test_adjust_time);
   g_test_add_func ("/GTimeZone/no-header", test_no_header);
   g_test_add_func ("/GTimeZone/posix-parse", test_posix_parse);
+  g_test_add_func ("/GTimeZone/interval-order", test_interval_order);
+  g_test_add_func ("/GTimeZone/cache", test_zone_cache);
 
   return g_test_run ();
 }
@@ -1039,6 +1039,52 @@ test_gvarianttypeinfo (void)
   g_variant_type_info_assert_no_infos ();
 }
 
+#define TYPEINFO_THREADS        4
+#define TYPEINFO_ITERATIONS     2000
+
+static gpointer
+typeinfo_thread (gpointer data)
+{
+  const gchar * const types[] = { "as", "a{sv}", "(ii)", "a(sa{sv})", "mai" };
+  GVariantTypeInfo *held;
+  gint i;
+
+  /* keep one info alive so that the lookups race against both the
+   * lock-free and the final unref paths
+   */
+  held = g_variant_type_info_get (G_VARIANT_TYPE (types[0]));
+
+  for (i = 0; i < TYPEINFO_ITERATIONS; i++)
+    {
+      const gchar *type_string = types[i % G_N_ELEMENTS (types)];
+      GVariantTypeInfo *info;
+
+      info = g_variant_type_info_get (G_VARIANT_TYPE (type_string));
+      g_assert_cmpstr (g_variant_type_info_get_type_string (info), ==,
+                       type_string);
+      g_variant_type_info_unref (info);
+    }
+
+  g_variant_type_info_unref (held);
+
+  return NULL;
+}
+
+static void
+test_gvarianttypeinfo_threaded (void)
+{
+  GThread *threads[TYPEINFO_THREADS];
+  gint i;
+
+  for (i = 0; i < TYPEINFO_THREADS; i++)
+    threads[i] = g_thread_new ("typeinfo", typeinfo_thread, NULL);
+
+  for (i = 0; i < TYPEINFO_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  g_variant_type_info_assert_no_infos ();
+}
+
 #define MAX_FIXED_MULTIPLIER    256
 #define MAX_INSTANCE_SIZE       1024
 #define MAX_ARRAY_CHILDREN      128
@@ -1868,6 +1914,67 @@ test_strings (void)
     }
 }
 
+/* Puts the bad byte, or slash, at every position of strings of a
+ * range of lengths, to catch mistakes at the edges of the blocks the
+ * string checks work on.
+ */
+static void
+test_strings_long (void)
+{
+  gchar buffer[80];
+  gsize size;
+  gsize i;
+
+  for (size = 2; size <= sizeof buffer; size++)
+    {
+      memset (buffer, 'a', size - 1);
+      buffer[0] = '/';
+      buffer[size - 1] = '\0';
+
+      g_assert (g_variant_serialiser_is_string (buffer, size));
+      g_assert (g_variant_serialiser_is_object_path (buffer, size));
+
+      for (i = 1; i < size - 1; i++)
+        {
+          buffer[i] = '\xff';
+          g_assert (!g_variant_serialiser_is_string (buffer, size));
+          g_assert (!g_variant_serialiser_is_object_path (buffer, size));
+
+          buffer[i] = '\0';
+          g_assert (!g_variant_serialiser_is_string (buffer, size));
+          g_assert (!g_variant_serialiser_is_object_path (buffer, size));
+
+          buffer[i] = '-';
+          g_assert (g_variant_serialiser_is_string (buffer, size));
+          g_assert (!g_variant_serialiser_is_object_path (buffer, size));
+
+          buffer[i] = 'Z';
+          g_assert (g_variant_serialiser_is_object_path (buffer, size));
+
+          /* "/" is fine in the middle, "//" and a trailing "/" are not */
+          buffer[i] = '/';
+          g_assert (g_variant_serialiser_is_object_path (buffer, size) ==
+                    (i > 1 && i < size - 2));
+
+          if (i + 1 < size - 1)
+            {
+              buffer[i + 1] = '/';
+              g_assert (!g_variant_serialiser_is_object_path (buffer, size));
+
+              /* U+00E9, in two bytes */
+              buffer[i] = '\xc3';
+              buffer[i + 1] = '\xa9';
+              g_assert (g_variant_serialiser_is_string (buffer, size));
+              g_assert (!g_variant_serialiser_is_object_path (buffer, size));
+
+              buffer[i + 1] = 'a';
+            }
+
+          buffer[i] = 'a';
+        }
+    }
+}
+
 typedef struct _TreeInstance TreeInstance;
 struct _TreeInstance
 {
@@ -3521,6 +3628,125 @@ test_builder_memory (void)
   g_variant_type_info_assert_no_infos ();
 }
 
+static void
+check_builder_serialised (GVariant *expected,
+                          GVariant *value)
+{
+  g_variant_ref_sink (expected);
+  g_variant_ref_sink (value);
+
+  g_assert (g_variant_is_normal_form (value));
+  g_assert_cmpstr (g_variant_get_type_string (value), ==,
+                   g_variant_get_type_string (expected));
+  g_assert_cmpuint (g_variant_get_size (value), ==,
+                    g_variant_get_size (expected));
+  g_assert (memcmp (g_variant_get_data (value), g_variant_get_data (expected),
+                    g_variant_get_size (value)) == 0);
+
+  g_variant_unref (expected);
+  g_variant_unref (value);
+}
+
+static void
+test_builder_serialised (void)
+{
+  const gint counts[] = { 0, 1, 7, 300, 70000 };
+  GVariantBuilder eb, sb;
+  gint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (counts); i++)
+    {
+      /* variable-sized elements, exercising every offset size */
+      g_variant_builder_init (&eb, G_VARIANT_TYPE ("as"));
+      g_variant_builder_init_serialised (&sb, G_VARIANT_TYPE ("as"));
+      for (j = 0; j < counts[i]; j++)
+        {
+          gchar *str = g_strdup_printf ("item %d", j);
+          g_variant_builder_add (&eb, "s", str);
+          g_variant_builder_add (&sb, "s", str);
+          g_free (str);
+        }
+      check_builder_serialised (g_variant_builder_end (&eb),
+                                g_variant_builder_end (&sb));
+
+      /* fixed-sized elements */
+      g_variant_builder_init (&eb, G_VARIANT_TYPE ("at"));
+      g_variant_builder_init_serialised (&sb, G_VARIANT_TYPE ("at"));
+      for (j = 0; j < counts[i]; j++)
+        {
+          g_variant_builder_add (&eb, "t", (guint64) j << 33);
+          g_variant_builder_add (&sb, "t", (guint64) j << 33);
+        }
+      check_builder_serialised (g_variant_builder_end (&eb),
+                                g_variant_builder_end (&sb));
+    }
+
+  /* every basic type through the direct path */
+  g_variant_builder_init (&eb, G_VARIANT_TYPE ("(abayanaqaiauahaxadaoag)"));
+  g_variant_builder_init (&sb, G_VARIANT_TYPE ("(abayanaqaiauahaxadaoag)"));
+#define ADD_BOTH(type, fmt, ...) \
+  g_variant_builder_open (&eb, G_VARIANT_TYPE (type));                    \
+  g_variant_builder_add (&eb, fmt, __VA_ARGS__);                          \
+  g_variant_builder_add (&eb, fmt, __VA_ARGS__);                          \
+  g_variant_builder_close (&eb);                                          \
+  {                                                                       \
+    GVariantBuilder ab;                                                   \
+    g_variant_builder_init_serialised (&ab, G_VARIANT_TYPE (type));       \
+    g_variant_builder_add (&ab, fmt, __VA_ARGS__);                        \
+    g_variant_builder_add (&ab, fmt, __VA_ARGS__);                        \
+    g_variant_builder_add_value (&sb, g_variant_builder_end (&ab));       \
+  }
+  ADD_BOTH ("ab", "b", TRUE);
+  ADD_BOTH ("ay", "y", 200);
+  ADD_BOTH ("an", "n", -1234);
+  ADD_BOTH ("aq", "q", 60000);
+  ADD_BOTH ("ai", "i", -123456);
+  ADD_BOTH ("au", "u", 4000000000u);
+  ADD_BOTH ("ah", "h", 3);
+  ADD_BOTH ("ax", "x", G_GINT64_CONSTANT (-1) << 40);
+  ADD_BOTH ("ad", "d", 3.25);
+  ADD_BOTH ("ao", "o", "/some/path");
+  ADD_BOTH ("ag", "g", "a{sv}");
+#undef ADD_BOTH
+  check_builder_serialised (g_variant_builder_end (&eb),
+                            g_variant_builder_end (&sb));
+
+  /* containers, nested builders and values added with add_value() */
+  g_variant_builder_init (&eb, G_VARIANT_TYPE ("aa{sv}"));
+  g_variant_builder_init_serialised (&sb, G_VARIANT_TYPE ("aa{sv}"));
+  for (i = 0; i < 5; i++)
+    {
+      g_variant_builder_open (&eb, G_VARIANT_TYPE ("a{sv}"));
+      g_variant_builder_open (&sb, G_VARIANT_TYPE ("a{sv}"));
+      for (j = 0; j < i; j++)
+        {
+          g_variant_builder_add (&eb, "{sv}", "key", g_variant_new_int32 (j));
+          g_variant_builder_add (&sb, "{sv}", "key", g_variant_new_int32 (j));
+          g_variant_builder_add_value (&eb, g_variant_new_parsed ("{'x', <(byte 1, 'y')>}"));
+          g_variant_builder_add_value (&sb, g_variant_new_parsed ("{'x', <(byte 1, 'y')>}"));
+        }
+      g_variant_builder_close (&eb);
+      g_variant_builder_close (&sb);
+    }
+  check_builder_serialised (g_variant_builder_end (&eb),
+                            g_variant_builder_end (&sb));
+
+  /* non-array types fall back to the normal builder */
+  g_variant_builder_init_serialised (&sb, G_VARIANT_TYPE ("(si)"));
+  g_variant_builder_add (&sb, "s", "x");
+  g_variant_builder_add (&sb, "i", 1);
+  check_builder_serialised (g_variant_new ("(si)", "x", 1),
+                            g_variant_builder_end (&sb));
+
+  /* abandoning a builder part-way through */
+  g_variant_builder_init_serialised (&sb, G_VARIANT_TYPE ("aas"));
+  g_variant_builder_open (&sb, G_VARIANT_TYPE ("as"));
+  g_variant_builder_add (&sb, "s", "some value");
+  g_variant_builder_clear (&sb);
+
+  g_variant_type_info_assert_no_infos ();
+}
+
 static void
 test_hashing (void)
 {
@@ -3641,6 +3867,88 @@ test_gv_byteswap (void)
   g_free (string);
 }
 
+static void
+test_gv_byteswap_fixed_arrays (void)
+{
+  GVariantBuilder builder;
+  GVariant *value, *swapped, *swapped2;
+  GVariant *arrays[5];
+  guint i;
+
+  /* lengths that are not a multiple of the 16 byte blocks swapped at
+   * once, so that the tails are covered too
+   */
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("(anaiaxa(ni)a(yqt))"));
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("an"));
+  for (i = 0; i < 37; i++)
+    g_variant_builder_add (&builder, "n", (gint16) (i * 0x0102));
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("ai"));
+  for (i = 0; i < 37; i++)
+    g_variant_builder_add (&builder, "i", (gint32) (i * 0x01020304));
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("ax"));
+  for (i = 0; i < 37; i++)
+    g_variant_builder_add (&builder, "x", (gint64) (i * G_GINT64_CONSTANT (0x0102030405060708)));
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(ni)"));
+  for (i = 0; i < 37; i++)
+    g_variant_builder_add (&builder, "(ni)", (gint16) (i * 0x0102), (gint32) (i * 0x01020304));
+  g_variant_builder_close (&builder);
+
+  g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(yqt)"));
+  for (i = 0; i < 37; i++)
+    g_variant_builder_add (&builder, "(yqt)", (guchar) i, (guint16) (i * 0x0102),
+                           (guint64) (i * G_GUINT64_CONSTANT (0x0102030405060708)));
+  g_variant_builder_close (&builder);
+
+  value = g_variant_ref_sink (g_variant_builder_end (&builder));
+  swapped = g_variant_byteswap (value);
+  g_assert (g_variant_is_normal_form (swapped));
+
+  for (i = 0; i < 5; i++)
+    arrays[i] = g_variant_get_child_value (swapped, i);
+
+  for (i = 0; i < 37; i++)
+    {
+      gint16 n;
+      gint32 i32;
+      gint64 x;
+      guchar y;
+      guint16 q;
+      guint64 t;
+
+      g_variant_get_child (arrays[0], i, "n", &n);
+      g_assert_cmpint (n, ==, (gint16) GUINT16_SWAP_LE_BE ((guint16) (i * 0x0102)));
+      g_variant_get_child (arrays[1], i, "i", &i32);
+      g_assert_cmpint (i32, ==, (gint32) GUINT32_SWAP_LE_BE ((guint32) (i * 0x01020304)));
+      g_variant_get_child (arrays[2], i, "x", &x);
+      g_assert_cmpint (x, ==, (gint64) GUINT64_SWAP_LE_BE ((guint64) (i * G_GINT64_CONSTANT (0x0102030405060708))));
+      g_variant_get_child (arrays[3], i, "(ni)", &n, &i32);
+      g_assert_cmpint (n, ==, (gint16) GUINT16_SWAP_LE_BE ((guint16) (i * 0x0102)));
+      g_assert_cmpint (i32, ==, (gint32) GUINT32_SWAP_LE_BE ((guint32) (i * 0x01020304)));
+      g_variant_get_child (arrays[4], i, "(yqt)", &y, &q, &t);
+      g_assert_cmpint (y, ==, i);
+      g_assert_cmpint (q, ==, GUINT16_SWAP_LE_BE ((guint16) (i * 0x0102)));
+      g_assert_cmpint (t, ==, GUINT64_SWAP_LE_BE ((guint64) (i * G_GUINT64_CONSTANT (0x0102030405060708))));
+    }
+
+  for (i = 0; i < 5; i++)
+    g_variant_unref (arrays[i]);
+
+  /* swapping back gives the original value */
+  swapped2 = g_variant_byteswap (swapped);
+  g_assert (g_variant_equal (swapped2, value));
+
+  g_variant_unref (swapped2);
+  g_variant_unref (swapped);
+  g_variant_unref (value);
+}
+
 static void
 test_parser (void)
 {
@@ -3766,6 +4074,95 @@ test_parses (void)
   g_variant_type_info_assert_no_infos ();
 }
 
+static void
+test_parse_typed (void)
+{
+  const gchar *tests[] = {
+    "ai",          "[1, -2, 0x10, 010, +5]",
+    "ay",          "[0, 255]",
+    "an",          "[-32768, 32767]",
+    "aq",          "[65535]",
+    "au",          "[4294967295, 0]",
+    "ax",          "[-9223372036854775808, 9223372036854775807]",
+    "at",          "[18446744073709551615]",
+    "ah",          "[3, -1]",
+    "ad",          "[1, 1.5, -2e3, inf, -inf]",
+    "ab",          "[true, false]",
+    "as",          "['a', \"b\", 'c\\td', '\\u00e9\\U0001d11e', '']",
+    "ao",          "['/', '/a/b']",
+    "ag",          "['', 'a{sv}']",
+    "a{sv}",       "{'a': <5>, 'b': <'x'>, 'c': <1.5>, 'd': <true>, 'e': <@u 7>, 'f': <uint64 8>, 'g': <<2>>}",
+    "a{sv}",       "{}",
+    "a{sv}",       "[{'a', <5>}]",
+    "a{ss}",       "{'a': 'b', 'c': 'd'}",
+    "a{is}",       "{1: 'one', -2: 'minus two'}",
+    "(i)",         "(1,)",
+    "(is)",        "(1, 'a')",
+    "(isb)",       "(1, 'a', true)",
+    "()",          "()",
+    "{sv}",        "{'a', <5>}",
+    "aai",         "[[1, 2], [], [3]]",
+    "a(ias)",      "[(1, ['a']), (2, [])]",
+    "as",          "@as ['a']",
+    "as",          "[string 'a', @s 'b']",
+    "av",          "[<[1, 2]>, <nothing>, <just 5>, <(1, 2)>]",
+    "ams",         "[just 'a', nothing]",
+    "ay",          "b'abc'",
+    "a{sv}",       "{'a': <5>,}",
+    "(ii)",        "(1, 2,)",
+    "(ii)",        "(1,)",
+    "(i)",         "(1, 2)",
+    "ai",          "[1,]",
+    "ai",          "[1 2]",
+    "ai",          "[1.5]",
+    "ay",          "[256]",
+    "ai",          "[2147483648]",
+    "as",          "['a]",
+    "ao",          "['a']",
+    "ag",          "['zzz']",
+    "a{sv}",       "{'a', <5>}",
+    "{sv}",        "{'a': <5>}",
+    "ai",          "[1, 2",
+  };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i += 2)
+    {
+      GError *typed_error = NULL;
+      GError *error = NULL;
+      GVariant *typed;
+      GVariant *value;
+      gchar *annotated;
+
+      typed = g_variant_parse (G_VARIANT_TYPE (tests[i]), tests[i + 1],
+                               NULL, NULL, &typed_error);
+
+      /* with a type annotation and no explicit type, the fast path is
+       * never taken
+       */
+      annotated = g_strdup_printf ("@%s %s", tests[i], tests[i + 1]);
+      value = g_variant_parse (NULL, annotated, NULL, NULL, &error);
+      g_free (annotated);
+
+      if (value == NULL)
+        {
+          g_assert (typed == NULL);
+          g_assert (typed_error != NULL);
+          g_error_free (typed_error);
+          g_error_free (error);
+          continue;
+        }
+
+      g_assert_no_error (typed_error);
+      g_assert (g_variant_is_normal_form (typed));
+      g_assert (g_variant_equal (typed, value));
+      g_variant_unref (typed);
+      g_variant_unref (value);
+    }
+
+  g_variant_type_info_assert_no_infos ();
+}
+
 static void
 test_parse_failures (void)
 {
@@ -4033,6 +4430,114 @@ test_bytestring (void)
   g_variant_unref (untrusted_empty);
 }
 
+static void
+check_string_array (GVariant *value)
+{
+  const gchar **strv;
+  gchar **dup;
+  gsize length;
+  gsize i;
+
+  if (g_variant_is_of_type (value, G_VARIANT_TYPE_STRING_ARRAY))
+    {
+      strv = g_variant_get_strv (value, &length);
+      dup = g_variant_dup_strv (value, NULL);
+    }
+  else if (g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH_ARRAY))
+    {
+      strv = g_variant_get_objv (value, &length);
+      dup = g_variant_dup_objv (value, NULL);
+    }
+  else
+    {
+      strv = g_variant_get_bytestring_array (value, &length);
+      dup = g_variant_dup_bytestring_array (value, NULL);
+    }
+
+  g_assert_cmpuint (length, ==, g_variant_n_children (value));
+  g_assert (strv[length] == NULL);
+  g_assert (dup[length] == NULL);
+
+  for (i = 0; i < length; i++)
+    {
+      GVariant *child;
+      const gchar *expected;
+
+      child = g_variant_get_child_value (value, i);
+      if (g_variant_is_of_type (child, G_VARIANT_TYPE_BYTESTRING))
+        expected = g_variant_get_bytestring (child);
+      else
+        expected = g_variant_get_string (child, NULL);
+      g_assert_cmpstr (strv[i], ==, expected);
+      g_assert_cmpstr (dup[i], ==, expected);
+      g_variant_unref (child);
+    }
+
+  g_free (strv);
+  g_strfreev (dup);
+}
+
+static void
+test_string_arrays (void)
+{
+  const gint counts[] = { 0, 1, 100, 10000, 70000 };
+  GVariant *value;
+  gint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (counts); i++)
+    {
+      GPtrArray *strings, *paths;
+
+      strings = g_ptr_array_new_with_free_func (g_free);
+      paths = g_ptr_array_new_with_free_func (g_free);
+      for (j = 0; j < counts[i]; j++)
+        {
+          g_ptr_array_add (strings, g_strdup_printf ("%*d", j % 13, j));
+          g_ptr_array_add (paths, g_strdup_printf ("/p%d", j));
+        }
+      g_ptr_array_add (strings, NULL);
+      g_ptr_array_add (paths, NULL);
+
+      value = g_variant_ref_sink (g_variant_new_strv ((const gchar **) strings->pdata, -1));
+      check_string_array (value);
+      g_variant_get_data (value);
+      check_string_array (value);
+      g_variant_unref (value);
+
+      value = g_variant_ref_sink (g_variant_new_objv ((const gchar **) paths->pdata, -1));
+      g_variant_get_data (value);
+      check_string_array (value);
+      g_variant_unref (value);
+
+      value = g_variant_ref_sink (g_variant_new_bytestring_array ((const gchar **) strings->pdata, -1));
+      g_variant_get_data (value);
+      check_string_array (value);
+      g_variant_unref (value);
+
+      g_ptr_array_unref (strings);
+      g_ptr_array_unref (paths);
+    }
+
+  /* untrusted data with invalid items */
+  value = g_variant_new_from_data (G_VARIANT_TYPE_STRING_ARRAY,
+                                   "ab\0cd\3\5", 7, FALSE, NULL, NULL);
+  g_variant_ref_sink (value);
+  check_string_array (value);
+  g_variant_unref (value);
+
+  value = g_variant_new_from_data (G_VARIANT_TYPE_OBJECT_PATH_ARRAY,
+                                   "/a\0xx\0\3\6", 8, FALSE, NULL, NULL);
+  g_variant_ref_sink (value);
+  check_string_array (value);
+  g_variant_unref (value);
+
+  value = g_variant_new_from_data (G_VARIANT_TYPE_BYTESTRING_ARRAY,
+                                   "ab\0cd\3\5", 7, FALSE, NULL, NULL);
+  g_variant_ref_sink (value);
+  check_string_array (value);
+  g_variant_unref (value);
+}
+
 static void
 test_lookup_value (void)
 {
@@ -4047,27 +4552,79 @@ test_lookup_value (void)
     { "@a{sv} {'x':  <5>}",   "x",  "5"   },
     { "@a{sv} {'x':  <'y'>}", "y"         }
   };
-  gint i;
+  gint i, j;
 
   for (i = 0; i < G_N_ELEMENTS (cases); i++)
+    /* tree form, serialised form and untrusted serialised form */
+    for (j = 0; j < 3; j++)
+      {
+        GVariant *dictionary;
+        GVariant *value;
+        gchar *p;
+
+        dictionary = g_variant_parse (NULL, cases[i].dict, NULL, NULL, NULL);
+
+        if (j > 0)
+          {
+            GVariant *tmp = dictionary;
+
+            dictionary = g_variant_new_from_data (g_variant_get_type (tmp),
+                                                  g_memdup (g_variant_get_data (tmp),
+                                                            g_variant_get_size (tmp)),
+                                                  g_variant_get_size (tmp),
+                                                  j == 1, g_free, NULL);
+            g_variant_ref_sink (dictionary);
+            g_variant_unref (tmp);
+          }
+
+        value = g_variant_lookup_value (dictionary, cases[i].key, NULL);
+        g_variant_unref (dictionary);
+
+        if (value == NULL && cases[i].value == NULL)
+          continue;
+
+        g_assert (value && cases[i].value);
+        p = g_variant_print (value, FALSE);
+        g_assert_cmpstr (cases[i].value, ==, p);
+        g_variant_unref (value);
+        g_free (p);
+      }
+}
+
+static void
+test_lookup_value_many (void)
+{
+  GVariantBuilder builder;
+  GVariant *dictionary;
+  GVariant *value;
+  gint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{si}"));
+  for (i = 0; i < 1000; i++)
     {
-      GVariant *dictionary;
-      GVariant *value;
-      gchar *p;
-      
-      dictionary = g_variant_parse (NULL, cases[i].dict, NULL, NULL, NULL);
-      value = g_variant_lookup_value (dictionary, cases[i].key, NULL);
-      g_variant_unref (dictionary);
-
-      if (value == NULL && cases[i].value == NULL)
-        continue;
-
-      g_assert (value && cases[i].value);
-      p = g_variant_print (value, FALSE);
-      g_assert_cmpstr (cases[i].value, ==, p);
+      gchar *key = g_strdup_printf ("key%d", i);
+      g_variant_builder_add (&builder, "{si}", key, i);
+      g_free (key);
+    }
+  dictionary = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  /* force serialised form */
+  g_variant_get_data (dictionary);
+
+  for (i = 0; i < 1000; i += 37)
+    {
+      gchar *key = g_strdup_printf ("key%d", i);
+      value = g_variant_lookup_value (dictionary, key, G_VARIANT_TYPE_INT32);
+      g_assert (value != NULL);
+      g_assert_cmpint (g_variant_get_int32 (value), ==, i);
       g_variant_unref (value);
-      g_free (p);
+      g_free (key);
     }
+
+  g_assert (g_variant_lookup_value (dictionary, "key1000", NULL) == NULL);
+  g_assert (g_variant_lookup_value (dictionary, "", NULL) == NULL);
+
+  g_variant_unref (dictionary);
 }
 
 static void
@@ -4105,6 +4662,66 @@ test_lookup (void)
   g_variant_unref (dict);
 }
 
+static void
+test_variant_dict (void)
+{
+  GVariantDict dict;
+  GVariantDict *heap;
+  GVariant *orig;
+  GVariant *result;
+  GVariant *value;
+  const gchar *str;
+  gint num;
+
+  orig = g_variant_ref_sink (g_variant_new_parsed ("{'a': <5>, 'b': <'c'>}"));
+
+  g_variant_dict_init (&dict, orig);
+  g_assert (g_variant_dict_contains (&dict, "a"));
+  g_assert (!g_variant_dict_contains (&dict, "x"));
+  g_assert (g_variant_dict_lookup (&dict, "a", "i", &num));
+  g_assert_cmpint (num, ==, 5);
+  g_assert (!g_variant_dict_lookup (&dict, "a", "&s", &str));
+  g_assert (g_variant_dict_lookup (&dict, "b", "&s", &str));
+  g_assert_cmpstr (str, ==, "c");
+  g_assert (!g_variant_dict_lookup (&dict, "q", "&s", &str));
+
+  g_assert (g_variant_dict_lookup_value (&dict, "b", G_VARIANT_TYPE_INT32) == NULL);
+  value = g_variant_dict_lookup_value (&dict, "b", NULL);
+  g_assert_cmpstr (g_variant_get_string (value, NULL), ==, "c");
+  g_variant_unref (value);
+
+  g_variant_dict_insert (&dict, "c", "u", 42);
+  g_variant_dict_insert_value (&dict, "a", g_variant_new_string ("replaced"));
+  g_assert (g_variant_dict_remove (&dict, "b"));
+  g_assert (!g_variant_dict_remove (&dict, "b"));
+
+  result = g_variant_ref_sink (g_variant_dict_end (&dict));
+  g_assert (g_variant_is_of_type (result, G_VARIANT_TYPE_VARDICT));
+  g_assert_cmpint (g_variant_n_children (result), ==, 2);
+  g_assert (g_variant_lookup (result, "a", "&s", &str));
+  g_assert_cmpstr (str, ==, "replaced");
+  g_assert (g_variant_lookup (result, "c", "u", &num));
+  g_assert_cmpint (num, ==, 42);
+  g_variant_unref (result);
+
+  /* clearing twice is allowed */
+  g_variant_dict_init (&dict, NULL);
+  g_variant_dict_clear (&dict);
+  g_variant_dict_clear (&dict);
+
+  heap = g_variant_dict_new (orig);
+  g_variant_dict_ref (heap);
+  g_variant_dict_unref (heap);
+  result = g_variant_ref_sink (g_variant_dict_end (heap));
+  g_assert_cmpint (g_variant_n_children (result), ==, 2);
+  g_assert (g_variant_lookup (result, "a", "i", &num));
+  g_assert_cmpint (num, ==, 5);
+  g_variant_unref (result);
+  g_variant_dict_unref (heap);
+
+  g_variant_unref (orig);
+}
+
 static void
 test_compare (void)
 {
@@ -4339,11 +4956,13 @@ main (int argc, char **argv)
 
   g_test_add_func ("/gvariant/type", test_gvarianttype);
   g_test_add_func ("/gvariant/typeinfo", test_gvarianttypeinfo);
+  g_test_add_func ("/gvariant/typeinfo/threaded", test_gvarianttypeinfo_threaded);
   g_test_add_func ("/gvariant/serialiser/maybe", test_maybes);
   g_test_add_func ("/gvariant/serialiser/array", test_arrays);
   g_test_add_func ("/gvariant/serialiser/tuple", test_tuples);
   g_test_add_func ("/gvariant/serialiser/variant", test_variants);
   g_test_add_func ("/gvariant/serialiser/strings", test_strings);
+  g_test_add_func ("/gvariant/serialiser/strings-long", test_strings_long);
   g_test_add_func ("/gvariant/serialiser/byteswap", test_byteswaps);
 
   for (i = 1; i <= 20; i += 4)
@@ -4365,17 +4984,23 @@ main (int argc, char **argv)
   g_test_add_func ("/gvariant/varargs/subprocess/empty-array", test_varargs_empty_array);
   g_test_add_func ("/gvariant/valist", test_valist);
   g_test_add_func ("/gvariant/builder-memory", test_builder_memory);
+  g_test_add_func ("/gvariant/builder-serialised", test_builder_serialised);
   g_test_add_func ("/gvariant/hashing", test_hashing);
   g_test_add_func ("/gvariant/byteswap", test_gv_byteswap);
+  g_test_add_func ("/gvariant/byteswap/fixed-arrays", test_gv_byteswap_fixed_arrays);
   g_test_add_func ("/gvariant/parser", test_parses);
   g_test_add_func ("/gvariant/parse-failures", test_parse_failures);
+  g_test_add_func ("/gvariant/parse-typed", test_parse_typed);
   g_test_add_func ("/gvariant/parse-positional", test_parse_positional);
   g_test_add_func ("/gvariant/parse/subprocess/bad-format-char", test_parse_bad_format_char);
   g_test_add_func ("/gvariant/parse/subprocess/bad-format-string", test_parse_bad_format_string);
   g_test_add_func ("/gvariant/parse/subprocess/bad-args", test_parse_bad_args);
   g_test_add_func ("/gvariant/floating", test_floating);
   g_test_add_func ("/gvariant/bytestring", test_bytestring);
+  g_test_add_func ("/gvariant/string-arrays", test_string_arrays);
   g_test_add_func ("/gvariant/lookup-value", test_lookup_value);
+  g_test_add_func ("/gvariant/lookup-value-many", test_lookup_value_many);
+  g_test_add_func ("/gvariant/variant-dict", test_variant_dict);
   g_test_add_func ("/gvariant/lookup", test_lookup);
   g_test_add_func ("/gvariant/compare", test_compare);
   g_test_add_func ("/gvariant/fixed-array", test_fixed_array);
@@ -484,6 +484,46 @@ string_hash_test (void)
   g_hash_table_destroy (h);
 }
 
+static void
+str_hash_fast_test (void)
+{
+  gchar buf[64], copy[64];
+  GHashTable *h, *hashes;
+  gchar *key;
+  gint i;
+
+  /* equal strings hash equally, whatever their alignment */
+  for (i = 0; i < 40; i++)
+    {
+      memset (buf, 'a' + i % 26, i);
+      buf[i] = '\0';
+      strcpy (copy + 1, buf);
+      g_assert_cmpuint (g_str_hash_fast (buf), ==, g_str_hash_fast (copy + 1));
+    }
+
+  h = g_hash_table_new_full (g_str_hash_fast, g_str_equal, g_free, NULL);
+  hashes = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < 10000; i++)
+    {
+      key = g_strdup_printf ("X-Header-%d", i);
+      g_hash_table_add (hashes, GUINT_TO_POINTER (g_str_hash_fast (key)));
+      g_hash_table_insert (h, key, GINT_TO_POINTER (i));
+    }
+
+  /* a 32 bit hash of 10000 keys should be (nearly) collision free */
+  g_assert_cmpuint (g_hash_table_size (hashes), >=, 9990);
+
+  for (i = 0; i < 10000; i++)
+    {
+      g_snprintf (buf, sizeof buf, "X-Header-%d", i);
+      g_assert_cmpint (GPOINTER_TO_INT (g_hash_table_lookup (h, buf)), ==, i);
+    }
+  g_assert (!g_hash_table_contains (h, "X-Header-"));
+
+  g_hash_table_unref (hashes);
+  g_hash_table_unref (h);
+}
+
 static void
 set_check (gpointer key,
            gpointer value,
@@ -1048,6 +1088,7 @@ struct _GHashTable
   gpointer        *keys;
   guint           *hashes;
   gpointer        *values;
+  guint8          *ctrl;
 
   GHashFunc        hash_func;
   GEqualFunc       key_equal_func;
@@ -1058,6 +1099,8 @@ struct _GHashTable
 #endif
   GDestroyNotify   key_destroy_func;
   GDestroyNotify   value_destroy_func;
+
+  gpointer         resize;
 };
 
 static void
@@ -1095,6 +1138,18 @@ check_data (GHashTable *h)
         {
           g_assert_cmpint (h->hashes[i], ==, h->hash_func (h->keys[i]));
         }
+
+      /* The control bytes follow the hash values; small tables have
+       * none, and no tombstones either.
+       */
+      if (h->ctrl == NULL)
+        g_assert_cmpint (h->hashes[i], !=, 1);
+      else if (h->hashes[i] == 0)
+        g_assert_cmpint (h->ctrl[i], ==, 0x80);
+      else if (h->hashes[i] == 1)
+        g_assert_cmpint (h->ctrl[i], ==, 0xfe);
+      else
+        g_assert_cmpint (h->ctrl[i], <, 0x80);
     }
 }
 
@@ -1127,11 +1182,14 @@ trivial_key_destroy (gpointer key)
 }
 
 static void
-test_internal_consistency (void)
+check_internal_consistency (gboolean small)
 {
   GHashTable *h;
+  gint t = small ? 0 : 1;  /* small tables leave no tombstones */
 
   h = g_hash_table_new_full (g_str_hash, g_str_equal, trivial_key_destroy, NULL);
+  if (!small)
+    g_hash_table_reserve (h, 100);
 
   check_counts (h, 0, 0);
   check_consistency (h);
@@ -1145,21 +1203,22 @@ test_internal_consistency (void)
 
   check_counts (h, 6, 0);
   check_consistency (h);
+  g_assert ((h->ctrl == NULL) == small);
 
   g_hash_table_remove (h, "a");
-  check_counts (h, 5, 1);
+  check_counts (h, 5, 1 * t);
   check_consistency (h);
 
   g_hash_table_remove (h, "b");
-  check_counts (h, 4, 2);
+  check_counts (h, 4, 2 * t);
   check_consistency (h);
 
   g_hash_table_insert (h, "c", "c");
-  check_counts (h, 4, 2);
+  check_counts (h, 4, 2 * t);
   check_consistency (h);
 
   g_hash_table_insert (h, "a", "A");
-  check_counts (h, 5, 1);
+  check_counts (h, 5, 1 * t);
   check_consistency (h);
 
   g_hash_table_remove_all (h);
@@ -1169,6 +1228,188 @@ test_internal_consistency (void)
   g_hash_table_unref (h);
 }
 
+static void
+test_internal_consistency (void)
+{
+  check_internal_consistency (TRUE);
+  check_internal_consistency (FALSE);
+}
+
+static void
+test_incremental_resize (void)
+{
+  GHashTable *h;
+  gboolean seen_resize = FALSE;
+  gint n = 200000;
+  gint i, j;
+
+  h = g_hash_table_new (NULL, NULL);
+
+  /* Keys start at 2, so that check_data() finds their hash values
+   * unchanged.
+   */
+
+  /* Large tables are moved to bigger arrays a step at a time; lookups
+   * have to keep working in between.
+   */
+  for (i = 1; i <= n; i++)
+    {
+      g_hash_table_insert (h, GINT_TO_POINTER (i + 1), GINT_TO_POINTER (-i));
+
+      if (h->resize != NULL)
+        {
+          seen_resize = TRUE;
+
+          for (j = MAX (1, i - 100); j <= i; j++)
+            g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (j + 1)) == GINT_TO_POINTER (-j));
+        }
+
+      if (i % 10000 == 0)
+        {
+          check_counts (h, i, 0);
+          check_data (h);
+        }
+    }
+
+  g_assert (seen_resize);
+
+  for (i = 1; i <= n; i++)
+    g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (i + 1)) == GINT_TO_POINTER (-i));
+
+  /* ...and the same on the way down */
+  seen_resize = FALSE;
+  for (i = 1; i <= n - 10; i++)
+    {
+      g_assert (g_hash_table_remove (h, GINT_TO_POINTER (i + 1)));
+
+      if (h->resize != NULL)
+        seen_resize = TRUE;
+    }
+
+  g_assert (seen_resize);
+  g_assert_cmpint (g_hash_table_size (h), ==, 10);
+
+  for (i = n - 9; i <= n; i++)
+    g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (i + 1)) == GINT_TO_POINTER (-i));
+
+  g_hash_table_unref (h);
+}
+
+static void
+test_incremental_resize_set_to_map (void)
+{
+  GHashTable *h;
+  gint n = 260000;
+  gint i;
+
+  h = g_hash_table_new (NULL, NULL);
+
+  /* Fill a set until a resize starts; keys start at 2 for check_data() */
+  for (i = 2; i < n && h->resize == NULL; i++)
+    g_hash_table_add (h, GINT_TO_POINTER (i));
+  g_assert (h->resize != NULL);
+
+  /* Turn it into a map while only a few buckets have been moved, then
+   * move the rest in one go.
+   */
+  g_hash_table_insert (h, GINT_TO_POINTER (n), GINT_TO_POINTER (-1));
+  g_hash_table_reserve (h, g_hash_table_size (h) + 1);
+  g_assert (h->resize == NULL);
+
+  check_data (h);
+  g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (n)) == GINT_TO_POINTER (-1));
+  for (i--; i >= 2; i--)
+    g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (i)) == GINT_TO_POINTER (i));
+
+  g_hash_table_unref (h);
+}
+
+static void
+test_reserve (void)
+{
+  GHashTable *h;
+  gint size;
+  gint i;
+
+  h = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_reserve (h, 1000);
+  size = h->size;
+  g_assert_cmpint (size, >=, 1000);
+
+  /* Neither shrinking before the reserved size is reached... */
+  for (i = 2; i < 502; i++)
+    g_hash_table_add (h, GINT_TO_POINTER (i));
+  g_hash_table_remove_all (h);
+  g_assert_cmpint (h->size, ==, size);
+
+  /* ...nor growing up to it resizes the table */
+  for (i = 2; i < 1002; i++)
+    {
+      g_hash_table_add (h, GINT_TO_POINTER (i));
+      g_assert_cmpint (h->size, ==, size);
+    }
+
+  check_consistency (h);
+
+  g_hash_table_reserve (h, 10);
+  g_assert_cmpint (h->size, ==, size);
+
+  /* Once reached, the reservation is gone */
+  g_hash_table_remove_all (h);
+  g_assert_cmpint (h->size, <, size);
+
+  g_hash_table_unref (h);
+}
+
+static void
+test_insert_bulk (void)
+{
+  GHashTable *h;
+  gchar *keys[2000];
+  gchar *values[2000];
+  gint i;
+
+  h = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  for (i = 0; i < 2000; i++)
+    {
+      /* Every key twice, so the second copies replace the first ones */
+      keys[i] = g_strdup_printf ("%d", i % 1000);
+      values[i] = g_strdup_printf ("%d", i);
+    }
+
+  g_hash_table_insert_bulk (h, (gpointer *) keys, (gpointer *) values, 2000);
+  g_assert_cmpint (g_hash_table_size (h), ==, 1000);
+  check_consistency (h);
+
+  for (i = 0; i < 1000; i++)
+    {
+      gchar key[10];
+      gchar value[10];
+
+      g_snprintf (key, sizeof key, "%d", i);
+      g_snprintf (value, sizeof value, "%d", i + 1000);
+      g_assert_cmpstr (g_hash_table_lookup (h, key), ==, value);
+    }
+
+  g_hash_table_insert_bulk (h, NULL, NULL, 0);
+  g_assert_cmpint (g_hash_table_size (h), ==, 1000);
+
+  g_hash_table_unref (h);
+
+  /* Without values, as a set */
+  h = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (i = 0; i < 2000; i++)
+    keys[i] = g_strdup_printf ("%d", i);
+  g_hash_table_insert_bulk (h, (gpointer *) keys, NULL, 2000);
+  g_assert_cmpint (g_hash_table_size (h), ==, 2000);
+  g_assert (h->keys == h->values);
+  for (i = 0; i < 2000; i++)
+    g_assert (g_hash_table_lookup (h, keys[i]) == keys[i]);
+  g_hash_table_unref (h);
+}
+
 static void
 my_key_free (gpointer v)
 {
@@ -1291,6 +1532,257 @@ test_set_to_strv (void)
   g_strfreev (strv);
 }
 
+static gint concurrent_destroyed;
+
+static void
+concurrent_destroy (gpointer data)
+{
+  concurrent_destroyed++;
+  g_free (data);
+}
+
+static void
+concurrent_count (gpointer key,
+                  gpointer value,
+                  gpointer user_data)
+{
+  gint *count = user_data;
+
+  g_assert_cmpstr (key, ==, value);
+  (*count)++;
+}
+
+static gpointer
+concurrent_dup (gconstpointer src,
+                gpointer      data)
+{
+  return g_strdup (src);
+}
+
+static void
+test_concurrent (void)
+{
+  GConcurrentHashTable *h;
+  gchar *copy;
+  gint count;
+  gint i;
+
+  h = g_concurrent_hash_table_new_full (g_str_hash, g_str_equal,
+                                        concurrent_destroy, concurrent_destroy);
+  concurrent_destroyed = 0;
+
+  for (i = 0; i < 10000; i++)
+    g_assert (g_concurrent_hash_table_insert (h, g_strdup_printf ("%d", i),
+                                              g_strdup_printf ("%d", i)));
+  g_assert_cmpint (g_concurrent_hash_table_size (h), ==, 10000);
+
+  for (i = 0; i < 10000; i++)
+    {
+      gchar key[10];
+
+      g_snprintf (key, sizeof key, "%d", i);
+      g_assert_cmpstr (g_concurrent_hash_table_lookup (h, key), ==, key);
+      g_assert (g_concurrent_hash_table_contains (h, key));
+    }
+  g_assert (!g_concurrent_hash_table_contains (h, "10000"));
+  g_assert (g_concurrent_hash_table_lookup (h, "10000") == NULL);
+
+  /* Inserting an existing key frees the new key and the old value */
+  g_assert (!g_concurrent_hash_table_insert (h, g_strdup ("5"), g_strdup ("5")));
+  g_assert_cmpint (concurrent_destroyed, ==, 2);
+  g_assert (!g_concurrent_hash_table_replace (h, g_strdup ("5"), g_strdup ("5")));
+  g_assert_cmpint (concurrent_destroyed, ==, 4);
+  g_assert_cmpint (g_concurrent_hash_table_size (h), ==, 10000);
+
+  copy = g_concurrent_hash_table_lookup_copy (h, "42", concurrent_dup, NULL);
+  g_assert_cmpstr (copy, ==, "42");
+  g_assert (copy != g_concurrent_hash_table_lookup (h, "42"));
+  g_free (copy);
+  g_assert (g_concurrent_hash_table_lookup_copy (h, "x", concurrent_dup, NULL) == NULL);
+
+  count = 0;
+  g_concurrent_hash_table_foreach (h, concurrent_count, &count);
+  g_assert_cmpint (count, ==, 10000);
+
+  /* Remove most of them again, so that the table shrinks */
+  for (i = 0; i < 9990; i++)
+    {
+      gchar key[10];
+
+      g_snprintf (key, sizeof key, "%d", i);
+      g_assert (g_concurrent_hash_table_remove (h, key));
+      g_assert (!g_concurrent_hash_table_remove (h, key));
+    }
+  g_assert_cmpint (g_concurrent_hash_table_size (h), ==, 10);
+  g_assert_cmpint (concurrent_destroyed, ==, 4 + 2 * 9990);
+  g_assert_cmpstr (g_concurrent_hash_table_lookup (h, "9995"), ==, "9995");
+
+  count = 0;
+  g_concurrent_hash_table_foreach (h, concurrent_count, &count);
+  g_assert_cmpint (count, ==, 10);
+
+  g_concurrent_hash_table_remove_all (h);
+  g_assert_cmpint (g_concurrent_hash_table_size (h), ==, 0);
+  g_assert_cmpint (concurrent_destroyed, ==, 4 + 2 * 10000);
+  g_assert (g_concurrent_hash_table_lookup (h, "9995") == NULL);
+
+  g_concurrent_hash_table_insert (h, g_strdup ("a"), g_strdup ("a"));
+  g_concurrent_hash_table_ref (h);
+  g_concurrent_hash_table_unref (h);
+  g_assert_cmpint (concurrent_destroyed, ==, 4 + 2 * 10000);
+  g_concurrent_hash_table_unref (h);
+  g_assert_cmpint (concurrent_destroyed, ==, 6 + 2 * 10000);
+}
+
+/* Values are refcounted and poisoned when their last reference goes:
+ * readers must never see a poisoned value.
+ */
+#define CONCURRENT_KEYS 256
+#define CONCURRENT_READERS 4
+
+typedef struct
+{
+  gint ref_count;
+  gint key;
+} ConcurrentValue;
+
+static void
+concurrent_value_unref (gpointer data)
+{
+  ConcurrentValue *value = data;
+
+  if (g_atomic_int_dec_and_test (&value->ref_count))
+    {
+      value->key = -1;
+      g_free (value);
+    }
+}
+
+static gpointer
+concurrent_value_ref (gconstpointer src,
+                      gpointer      data)
+{
+  ConcurrentValue *value = (ConcurrentValue *) src;
+
+  g_atomic_int_inc (&value->ref_count);
+
+  return value;
+}
+
+static gint concurrent_stop;
+
+static gpointer
+concurrent_reader (gpointer data)
+{
+  GConcurrentHashTable *h = data;
+  guint lookups = 0;
+  gint i = 0;
+
+  while (!g_atomic_int_get (&concurrent_stop) || lookups < 1000)
+    {
+      ConcurrentValue *value;
+
+      value = g_concurrent_hash_table_lookup_copy (h, GINT_TO_POINTER (i),
+                                                   concurrent_value_ref, NULL);
+      if (value)
+        {
+          g_assert_cmpint (value->key, ==, i);
+          concurrent_value_unref (value);
+        }
+
+      i = (i + 1) % CONCURRENT_KEYS;
+      lookups++;
+    }
+
+  return NULL;
+}
+
+static void
+test_concurrent_threads (void)
+{
+  GConcurrentHashTable *h;
+  GThread *threads[CONCURRENT_READERS];
+  gint round;
+  gint i;
+
+  h = g_concurrent_hash_table_new_full (g_direct_hash, NULL,
+                                        NULL, concurrent_value_unref);
+  concurrent_stop = 0;
+
+  for (i = 0; i < CONCURRENT_READERS; i++)
+    threads[i] = g_thread_new ("reader", concurrent_reader, h);
+
+  for (round = 0; round < 20; round++)
+    {
+      for (i = 0; i < CONCURRENT_KEYS; i++)
+        {
+          ConcurrentValue *value = g_new (ConcurrentValue, 1);
+
+          value->ref_count = 1;
+          value->key = i;
+          g_concurrent_hash_table_insert (h, GINT_TO_POINTER (i), value);
+        }
+
+      for (i = round % 2; i < CONCURRENT_KEYS; i += 2)
+        g_concurrent_hash_table_remove (h, GINT_TO_POINTER (i));
+
+      if (round % 5 == 4)
+        g_concurrent_hash_table_remove_all (h);
+    }
+
+  g_atomic_int_set (&concurrent_stop, 1);
+  for (i = 0; i < CONCURRENT_READERS; i++)
+    g_thread_join (threads[i]);
+
+  g_concurrent_hash_table_unref (h);
+}
+
+static void
+test_small (void)
+{
+  GHashTable *h;
+  gint i;
+
+  /* A set: stays a set through promotion and demotion */
+  h = g_hash_table_new (NULL, NULL);
+  for (i = 2; i < 9; i++)
+    g_hash_table_add (h, GINT_TO_POINTER (i));
+  g_assert (h->ctrl == NULL);
+  g_assert (h->keys == h->values);
+  check_consistency (h);
+
+  for (i = 9; i < 100; i++)
+    g_hash_table_add (h, GINT_TO_POINTER (i));
+  g_assert (h->ctrl != NULL);
+  g_assert (h->keys == h->values);
+  check_consistency (h);
+
+  for (i = 3; i < 100; i++)
+    g_assert (g_hash_table_remove (h, GINT_TO_POINTER (i)));
+  g_assert (h->ctrl == NULL);
+  g_assert (h->keys == h->values);
+  g_assert_cmpint (g_hash_table_size (h), ==, 1);
+  g_assert (g_hash_table_contains (h, GINT_TO_POINTER (2)));
+  check_consistency (h);
+  g_hash_table_unref (h);
+
+  /* A map, with removals and reinsertions while small */
+  h = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < 1000; i++)
+    {
+      gint key = i % 11 + 2;
+
+      if (i % 3 == 0)
+        g_hash_table_remove (h, GINT_TO_POINTER (key));
+      else
+        g_hash_table_insert (h, GINT_TO_POINTER (key), GINT_TO_POINTER (i));
+
+      check_consistency (h);
+      g_assert ((h->ctrl == NULL) == (h->size == 8));
+    }
+  g_hash_table_unref (h);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1305,6 +1797,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/hash/int64", int64_hash_test);
   g_test_add_func ("/hash/double", double_hash_test);
   g_test_add_func ("/hash/string", string_hash_test);
+  g_test_add_func ("/hash/str-hash-fast", str_hash_fast_test);
   g_test_add_func ("/hash/set", set_hash_test);
   g_test_add_func ("/hash/set-ref", set_ref_hash_test);
   g_test_add_func ("/hash/ref", test_hash_ref);
@@ -1319,6 +1812,13 @@ main (int argc, char *argv[])
   g_test_add_func ("/hash/iter-replace", test_iter_replace);
   g_test_add_func ("/hash/set-insert-corruption", test_set_insert_corruption);
   g_test_add_func ("/hash/set-to-strv", test_set_to_strv);
+  g_test_add_func ("/hash/incremental-resize", test_incremental_resize);
+  g_test_add_func ("/hash/incremental-resize-set-to-map", test_incremental_resize_set_to_map);
+  g_test_add_func ("/hash/reserve", test_reserve);
+  g_test_add_func ("/hash/insert-bulk", test_insert_bulk);
+  g_test_add_func ("/hash/small", test_small);
+  g_test_add_func ("/hash/concurrent", test_concurrent);
+  g_test_add_func ("/hash/concurrent-threads", test_concurrent_threads);
 
   return g_test_run ();
 
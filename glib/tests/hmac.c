@@ -286,6 +286,55 @@ test_hmac_for_string (void)
   g_free (string);
 }
 
+static void
+test_hmac_verify (void)
+{
+  const guchar key[] = "secret key";
+  const guchar *messages[] = {
+    (const guchar *) "",
+    (const guchar *) "a",
+    (const guchar *) "The quick brown fox jumps over the lazy dog"
+  };
+  guint8 digest[32];
+  gsize len, i;
+  GHmac *template, *hmac;
+
+  template = g_hmac_new (G_CHECKSUM_SHA256, key, sizeof key - 1);
+
+  for (i = 0; i < G_N_ELEMENTS (messages); i++)
+    {
+      gsize msg_len = strlen ((const gchar *) messages[i]);
+
+      hmac = g_hmac_new (G_CHECKSUM_SHA256, key, sizeof key - 1);
+      g_hmac_update (hmac, messages[i], msg_len);
+      len = sizeof digest;
+      g_hmac_get_digest (hmac, digest, &len);
+      g_assert_cmpint (len, ==, 32);
+      g_hmac_unref (hmac);
+
+      g_assert (g_hmac_verify_for_data (template, messages[i], msg_len, digest, len));
+
+      /* a wrong byte anywhere, or a wrong length, fails */
+      digest[31] ^= 1;
+      g_assert (!g_hmac_verify_for_data (template, messages[i], msg_len, digest, len));
+      digest[31] ^= 1;
+      digest[0] ^= 0x80;
+      g_assert (!g_hmac_verify_for_data (template, messages[i], msg_len, digest, len));
+      digest[0] ^= 0x80;
+      g_assert (!g_hmac_verify_for_data (template, messages[i], msg_len, digest, len - 1));
+
+      hmac = g_hmac_copy (template);
+      g_hmac_update (hmac, messages[i], msg_len);
+      g_assert (g_hmac_verify_digest (hmac, digest, len));
+      g_hmac_unref (hmac);
+    }
+
+  /* the template was left alone */
+  g_hmac_update (template, messages[2], strlen ((const gchar *) messages[2]));
+  g_assert (g_hmac_verify_digest (template, digest, sizeof digest));
+  g_hmac_unref (template);
+}
+
 int
 main (int argc,
     char **argv)
@@ -313,6 +362,7 @@ main (int argc,
   g_test_add_func ("/hmac/copy", test_hmac_copy);
   g_test_add_func ("/hmac/for-data", test_hmac_for_data);
   g_test_add_func ("/hmac/for-string", test_hmac_for_string);
+  g_test_add_func ("/hmac/verify", test_hmac_verify);
 
   return g_test_run ();
 }
@@ -1,4 +1,5 @@
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <locale.h>
 #include <string.h>
 #include <stdlib.h>
@@ -1566,6 +1567,106 @@ test_roundtrip (void)
   g_key_file_free (kf);
 }
 
+static GKeyFile *
+load_file_data (const gchar    *data,
+                GKeyFileFlags   flags,
+                GError        **error)
+{
+  GKeyFile *keyfile;
+  gchar *path;
+  gint fd;
+
+  fd = g_file_open_tmp ("keyfile-XXXXXX", &path, NULL);
+  g_assert (fd != -1);
+  g_close (fd, NULL);
+  g_assert (g_file_set_contents (path, data, -1, NULL));
+
+  keyfile = g_key_file_new ();
+  if (!g_key_file_load_from_file (keyfile, path, flags, error))
+    {
+      g_key_file_free (keyfile);
+      keyfile = NULL;
+    }
+
+  g_unlink (path);
+  g_free (path);
+
+  return keyfile;
+}
+
+static void
+test_read_only (void)
+{
+  GKeyFile *kf, *ro;
+  GError *error = NULL;
+  gchar *data, *ro_data;
+  gchar **groups;
+  gchar *value;
+  const gchar contents[] =
+    "# top comment\n"
+    "[first]\n"
+    "a=1\n"
+    "\n"
+    "[second]\r\n"
+    "b = 2\r\n"
+    "name[de]=zwei\n"
+    "  # comment\n"
+    "[third]  \n"
+    "c=3\n"
+    "[second]\n"
+    "b=22\n"
+    "d=4\n"
+    "[fourth]\n"
+    "e=5";
+
+  kf = load_file_data (contents, G_KEY_FILE_KEEP_TRANSLATIONS, &error);
+  g_assert_no_error (error);
+  ro = load_file_data (contents, G_KEY_FILE_READ_ONLY | G_KEY_FILE_KEEP_TRANSLATIONS, &error);
+  g_assert_no_error (error);
+
+  g_assert (g_key_file_has_group (ro, "third"));
+  g_assert (!g_key_file_has_group (ro, "fifth"));
+  groups = g_key_file_get_groups (ro, NULL);
+  g_assert_cmpint (g_strv_length (groups), ==, 4);
+  g_assert_cmpstr (groups[3], ==, "fourth");
+  g_strfreev (groups);
+
+  check_integer_value (ro, "third", "c", 3);
+  check_integer_value (ro, "second", "b", 22);
+  check_integer_value (ro, "fourth", "e", 5);
+  check_locale_string_value (ro, "second", "name", "de", "zwei");
+  value = g_key_file_get_value (ro, "third", "b", &error);
+  check_error (&error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND);
+  g_assert (value == NULL);
+
+  g_key_file_set_integer (ro, "fourth", "f", 6);
+  g_key_file_set_integer (kf, "fourth", "f", 6);
+  g_assert (g_key_file_remove_group (ro, "first", NULL));
+  g_assert (g_key_file_remove_group (kf, "first", NULL));
+
+  data = g_key_file_to_data (kf, NULL, NULL);
+  ro_data = g_key_file_to_data (ro, NULL, NULL);
+  g_assert_cmpstr (ro_data, ==, data);
+  g_free (data);
+  g_free (ro_data);
+
+  g_key_file_free (kf);
+  g_key_file_free (ro);
+
+  /* errors in groups that are parsed later are still reported */
+  ro = load_file_data ("[a]\nx=1\n[b]\ny=2\nnot a key\n", G_KEY_FILE_READ_ONLY, &error);
+  check_error (&error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_PARSE);
+  g_assert (ro == NULL);
+
+  ro = load_file_data ("[a]\n[b]\ny[=2\n", G_KEY_FILE_READ_ONLY, &error);
+  check_error (&error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_PARSE);
+  g_assert (ro == NULL);
+
+  ro = load_file_data ("[a]\nEncoding=ISO-8859-1\n[b]\n", G_KEY_FILE_READ_ONLY, &error);
+  check_error (&error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_UNKNOWN_ENCODING);
+  g_assert (ro == NULL);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1608,6 +1709,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/keyfile/limbo", test_limbo);
   g_test_add_func ("/keyfile/utf8", test_utf8);
   g_test_add_func ("/keyfile/roundtrip", test_roundtrip);
+  g_test_add_func ("/keyfile/read-only", test_read_only);
 
   return g_test_run ();
 }
@@ -21,6 +21,7 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include "glib-private.h"
 #include <string.h>
 
@@ -352,6 +353,109 @@ test_invoke (void)
   g_main_context_unref (ctx);
 }
 
+#define N_INVOKE_THREADS 4
+#define N_INVOCATIONS_PER_THREAD 10000
+
+typedef struct
+{
+  gint thread_id;
+  gint seq;
+} Invocation;
+
+static gint last_seq[N_INVOKE_THREADS];
+static volatile gint n_invocations_run;
+static volatile gint n_invocations_freed;
+
+static gboolean
+record_invocation (gpointer data)
+{
+  Invocation *invocation = data;
+
+  /* Invocations from one thread must run in the order they were made */
+  g_assert_cmpint (invocation->seq, ==, last_seq[invocation->thread_id] + 1);
+  last_seq[invocation->thread_id] = invocation->seq;
+  g_atomic_int_inc (&n_invocations_run);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+free_invocation (gpointer data)
+{
+  g_free (data);
+  g_atomic_int_inc (&n_invocations_freed);
+}
+
+static gpointer
+invoke_thread (gpointer data)
+{
+  GMainContext *ctx = data;
+  static volatile gint next_thread_id;
+  gint thread_id;
+  gint i;
+
+  thread_id = g_atomic_int_add (&next_thread_id, 1);
+
+  for (i = 1; i <= N_INVOCATIONS_PER_THREAD; i++)
+    {
+      Invocation *invocation = g_new (Invocation, 1);
+
+      invocation->thread_id = thread_id;
+      invocation->seq = i;
+      g_main_context_invoke_full (ctx, G_PRIORITY_DEFAULT,
+                                  record_invocation, invocation, free_invocation);
+    }
+
+  return NULL;
+}
+
+static gint n_repeats;
+
+static gboolean
+repeat_three_times (gpointer data)
+{
+  return ++n_repeats < 3;
+}
+
+static void
+test_invoke_queue (void)
+{
+  GThread *threads[N_INVOKE_THREADS];
+  GMainContext *ctx;
+  gint i;
+
+  ctx = g_main_context_new ();
+
+  /* The context isn't owned by anyone here, so everything gets queued */
+  for (i = 0; i < N_INVOKE_THREADS; i++)
+    threads[i] = g_thread_new ("invoker", invoke_thread, ctx);
+
+  while (g_atomic_int_get (&n_invocations_run) < N_INVOKE_THREADS * N_INVOCATIONS_PER_THREAD)
+    g_main_context_iteration (ctx, TRUE);
+
+  for (i = 0; i < N_INVOKE_THREADS; i++)
+    {
+      g_thread_join (threads[i]);
+      g_assert_cmpint (last_seq[i], ==, N_INVOCATIONS_PER_THREAD);
+    }
+
+  g_assert_cmpint (n_invocations_freed, ==, N_INVOKE_THREADS * N_INVOCATIONS_PER_THREAD);
+  g_assert (!g_main_context_iteration (ctx, FALSE));
+
+  /* A function returning TRUE is called again, like an idle */
+  g_main_context_invoke_full (ctx, G_PRIORITY_HIGH, repeat_three_times, NULL, NULL);
+  g_assert_cmpint (n_repeats, ==, 0);
+  while (g_main_context_iteration (ctx, FALSE));
+  g_assert_cmpint (n_repeats, ==, 3);
+
+  /* Invocations still queued when the context goes away get freed */
+  n_invocations_freed = 0;
+  g_main_context_invoke_full (ctx, G_PRIORITY_DEFAULT_IDLE, record_invocation,
+                              g_new0 (Invocation, 1), free_invocation);
+  g_main_context_unref (ctx);
+  g_assert_cmpint (n_invocations_freed, ==, 1);
+}
+
 /* We can't use timeout sources here because on slow or heavily-loaded
  * machines, the test program might not get enough cycles to hit the
  * timeouts at the expected times. So instead we define a source that
@@ -998,6 +1102,284 @@ test_ready_time (void)
   g_source_destroy (source);
 }
 
+typedef struct
+{
+  GSource parent;
+  gint n_dispatched;
+} CountingSource;
+
+static gboolean
+counting_dispatch (GSource     *source,
+                   GSourceFunc  callback,
+                   gpointer     user_data)
+{
+  ((CountingSource *) source)->n_dispatched++;
+
+  g_source_set_ready_time (source, -1);
+
+  return TRUE;
+}
+
+#define N_TIMER_SOURCES 100
+
+static void
+test_timer_heap (void)
+{
+  GSourceFuncs source_funcs = {
+    NULL, NULL, counting_dispatch
+  };
+  CountingSource *sources[N_TIMER_SOURCES];
+  GMainContext *context;
+  gint64 tomorrow;
+  gint i;
+
+  context = g_main_context_new ();
+  tomorrow = g_get_monotonic_time () + G_TIME_SPAN_DAY;
+
+  /* Attach with ready times in an arbitrary order, some not set at all */
+  for (i = 0; i < N_TIMER_SOURCES; i++)
+    {
+      sources[i] = (CountingSource *) g_source_new (&source_funcs, sizeof (CountingSource));
+      if (i % 5 != 0)
+        g_source_set_ready_time ((GSource *) sources[i], tomorrow + (i * 7919) % N_TIMER_SOURCES);
+      g_source_attach ((GSource *) sources[i], context);
+    }
+
+  while (g_main_context_iteration (context, FALSE));
+  for (i = 0; i < N_TIMER_SOURCES; i++)
+    g_assert_cmpint (sources[i]->n_dispatched, ==, 0);
+
+  /* Expire every third source, whether in the heap already or not */
+  for (i = 0; i < N_TIMER_SOURCES; i += 3)
+    g_source_set_ready_time ((GSource *) sources[i], 0);
+
+  while (g_main_context_iteration (context, FALSE));
+  for (i = 0; i < N_TIMER_SOURCES; i++)
+    g_assert_cmpint (sources[i]->n_dispatched, ==, (i % 3 == 0) ? 1 : 0);
+
+  /* Remove some from the middle of the heap, push others back, and
+   * expire the rest
+   */
+  for (i = 0; i < N_TIMER_SOURCES; i++)
+    {
+      if (i % 3 == 0)
+        continue;
+      else if (i % 7 == 0)
+        g_source_destroy ((GSource *) sources[i]);
+      else if (i % 2 == 0)
+        g_source_set_ready_time ((GSource *) sources[i], tomorrow + G_TIME_SPAN_HOUR);
+      else
+        g_source_set_ready_time ((GSource *) sources[i], g_get_monotonic_time () - i);
+    }
+
+  while (g_main_context_iteration (context, FALSE));
+  for (i = 0; i < N_TIMER_SOURCES; i++)
+    {
+      if (i % 3 == 0)
+        g_assert_cmpint (sources[i]->n_dispatched, ==, 1);
+      else if (i % 7 == 0 || i % 2 == 0)
+        g_assert_cmpint (sources[i]->n_dispatched, ==, 0);
+      else
+        g_assert_cmpint (sources[i]->n_dispatched, ==, 1);
+    }
+
+  for (i = 0; i < N_TIMER_SOURCES; i++)
+    {
+      g_source_destroy ((GSource *) sources[i]);
+      g_source_unref ((GSource *) sources[i]);
+    }
+
+  g_main_context_unref (context);
+}
+
+static void
+test_dispatch_budget (void)
+{
+  GSourceFuncs source_funcs = {
+    NULL, NULL, counting_dispatch
+  };
+  CountingSource *sources[5];
+  CountingSource *low;
+  GSourceStatistics statistics;
+  GMainContext *context;
+  guint max_dispatches;
+  gint64 max_time;
+  gint i;
+
+  context = g_main_context_new ();
+  g_main_context_set_statistics_enabled (context, TRUE);
+  g_main_context_set_dispatch_budget (context, 2, 0);
+  g_main_context_get_dispatch_budget (context, &max_dispatches, &max_time);
+  g_assert_cmpuint (max_dispatches, ==, 2);
+  g_assert_cmpint (max_time, ==, 0);
+
+  for (i = 0; i < 5; i++)
+    {
+      sources[i] = (CountingSource *) g_source_new (&source_funcs, sizeof (CountingSource));
+      g_source_set_ready_time ((GSource *) sources[i], 0);
+      g_source_attach ((GSource *) sources[i], context);
+    }
+
+  low = (CountingSource *) g_source_new (&source_funcs, sizeof (CountingSource));
+  g_source_set_priority ((GSource *) low, G_PRIORITY_LOW);
+  g_source_set_ready_time ((GSource *) low, 0);
+  g_source_attach ((GSource *) low, context);
+
+  /* Two at a time, in order, with the left-overs going first */
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (sources[0]->n_dispatched + sources[1]->n_dispatched, ==, 2);
+  g_assert_cmpint (sources[2]->n_dispatched + sources[3]->n_dispatched + sources[4]->n_dispatched, ==, 0);
+  g_assert_cmpuint (g_main_context_get_deferred_dispatches (context), ==, 3);
+
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (sources[2]->n_dispatched + sources[3]->n_dispatched, ==, 2);
+  g_assert_cmpint (sources[4]->n_dispatched, ==, 0);
+  g_assert_cmpuint (g_main_context_get_deferred_dispatches (context), ==, 4);
+
+  /* The lower priority source has to wait for all of them */
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (sources[4]->n_dispatched, ==, 1);
+  g_assert_cmpint (low->n_dispatched, ==, 0);
+
+  g_assert (g_source_get_statistics ((GSource *) sources[4], &statistics));
+  g_assert_cmpuint (statistics.n_deferrals, ==, 2);
+
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (low->n_dispatched, ==, 1);
+  g_assert (!g_main_context_iteration (context, FALSE));
+
+  for (i = 0; i < 5; i++)
+    g_assert_cmpint (sources[i]->n_dispatched, ==, 1);
+
+  /* Left-overs are released with the context */
+  for (i = 0; i < 5; i++)
+    g_source_set_ready_time ((GSource *) sources[i], 0);
+  g_assert (g_main_context_iteration (context, FALSE));
+
+  for (i = 0; i < 5; i++)
+    g_source_unref ((GSource *) sources[i]);
+  g_source_unref ((GSource *) low);
+  g_main_context_unref (context);
+}
+
+static gboolean
+stalling_cb (gpointer user_data)
+{
+  g_usleep (200 * 1000);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_watchdog_subprocess (void)
+{
+  GSourceStatistics statistics;
+  GMainContext *context;
+  GSource *source;
+
+  context = g_main_context_new ();
+  g_main_context_set_statistics_enabled (context, TRUE);
+  g_main_context_set_watchdog (context, 50);
+  g_assert_cmpuint (g_main_context_get_watchdog (context), ==, 50);
+
+  source = g_idle_source_new ();
+  g_source_set_name (source, "stalling idle");
+  g_source_set_callback (source, stalling_cb, NULL, NULL);
+  g_source_attach (source, context);
+
+  g_assert (g_main_context_iteration (context, FALSE));
+
+  /* Reported once, however long it runs */
+  g_assert_cmpuint (g_main_context_get_stalls (context), ==, 1);
+  g_assert (g_source_get_statistics (source, &statistics));
+  g_assert_cmpuint (statistics.n_stalls, ==, 1);
+  g_source_unref (source);
+
+  g_main_context_set_watchdog (context, 0);
+  g_assert_cmpuint (g_main_context_get_watchdog (context), ==, 0);
+
+  /* Finalizing the context stops the watchdog as well */
+  g_main_context_set_watchdog (context, 1000);
+  g_main_context_unref (context);
+}
+
+static void
+test_watchdog (void)
+{
+  g_test_trap_subprocess ("/mainloop/watchdog/subprocess", 0, 0);
+  g_test_trap_assert_passed ();
+  g_test_trap_assert_stderr ("*stalled: dispatch of source 'stalling idle'*");
+}
+
+static gboolean
+sleepy_dispatch (GSource     *source,
+                 GSourceFunc  callback,
+                 gpointer     user_data)
+{
+  g_usleep (1000);
+
+  g_source_set_ready_time (source, -1);
+
+  return TRUE;
+}
+
+static void
+test_statistics (void)
+{
+  GSourceFuncs source_funcs = {
+    NULL, NULL, sleepy_dispatch
+  };
+  GSourceStatistics statistics;
+  GMainContext *context;
+  GSource *source;
+  gchar *dump;
+  gint i;
+
+  context = g_main_context_new ();
+  g_assert (!g_main_context_get_statistics_enabled (context));
+
+  source = g_source_new (&source_funcs, sizeof (GSource));
+  g_source_set_name (source, "sleepy source");
+  g_source_attach (source, context);
+
+  /* Nothing is collected while disabled */
+  g_source_set_ready_time (source, 0);
+  while (g_main_context_iteration (context, FALSE));
+  g_assert (!g_source_get_statistics (source, &statistics));
+
+  g_main_context_set_statistics_enabled (context, TRUE);
+  g_assert (g_main_context_get_statistics_enabled (context));
+
+  for (i = 0; i < 3; i++)
+    {
+      g_source_set_ready_time (source, 0);
+      while (g_main_context_iteration (context, FALSE));
+    }
+
+  g_assert (g_source_get_statistics (source, &statistics));
+  g_assert_cmpuint (statistics.n_dispatches, ==, 3);
+  g_assert_cmpint (statistics.total_dispatch_time, >=, 3000);
+  g_assert_cmpint (statistics.max_dispatch_time, >=, 1000);
+  g_assert_cmpint (statistics.max_dispatch_time, <=, statistics.total_dispatch_time);
+  g_assert_cmpint (statistics.max_latency, >=, 0);
+  g_assert_cmpint (statistics.max_latency, <=, statistics.total_latency);
+
+  dump = g_main_context_dump_statistics (context);
+  g_assert (strstr (dump, "sleepy source") != NULL);
+  g_free (dump);
+
+  /* ...and what was collected is kept once disabled again */
+  g_main_context_set_statistics_enabled (context, FALSE);
+  g_source_set_ready_time (source, 0);
+  while (g_main_context_iteration (context, FALSE));
+  g_assert (g_source_get_statistics (source, &statistics));
+  g_assert_cmpuint (statistics.n_dispatches, ==, 3);
+
+  g_source_destroy (source);
+  g_source_unref (source);
+  g_main_context_unref (context);
+}
+
 static void
 test_wakeup(void)
 {
@@ -1403,8 +1785,358 @@ test_source_unix_fd_api (void)
   close (fds_b[1]);
 }
 
+static void
+check_priorities_in_context (GMainContext *context)
+{
+  GSourceFuncs no_funcs = {
+    NULL, NULL, return_true
+  };
+  gint priorities[] = { G_PRIORITY_HIGH, G_PRIORITY_DEFAULT,
+                        G_PRIORITY_HIGH_IDLE, G_PRIORITY_LOW };
+  GSource *sources[G_N_ELEMENTS (priorities)];
+  gint fds[G_N_ELEMENTS (priorities)][2];
+  gchar c;
+  gint i, j;
+  gint s;
+
+  /* Sources without a check function, each alone at its priority, so
+   * that the check pass only has a reason to look at the one whose fd
+   * polled ready.
+   */
+  for (i = 0; i < G_N_ELEMENTS (priorities); i++)
+    {
+      s = pipe (fds[i]);
+      g_assert (s == 0);
+
+      sources[i] = g_source_new (&no_funcs, sizeof (FlagSource));
+      g_source_set_priority (sources[i], priorities[i]);
+      g_source_add_unix_fd (sources[i], fds[i][0], G_IO_IN);
+      g_source_attach (sources[i], context);
+    }
+
+  g_assert (!g_main_context_iteration (context, FALSE));
+
+  for (i = 0; i < G_N_ELEMENTS (priorities); i++)
+    {
+      s = write (fds[i][1], "x", 1);
+      g_assert_cmpint (s, ==, 1);
+
+      g_assert (g_main_context_iteration (context, TRUE));
+      for (j = 0; j < G_N_ELEMENTS (priorities); j++)
+        g_assert_cmpint (((FlagSource *) sources[j])->flagged, ==, i == j);
+      clear_flag (sources[i]);
+
+      s = read (fds[i][0], &c, 1);
+      g_assert_cmpint (s, ==, 1);
+    }
+
+  /* A source that moves to another priority while its fd is ready */
+  s = write (fds[0][1], "x", 1);
+  g_assert_cmpint (s, ==, 1);
+  g_assert (g_main_context_iteration (context, FALSE));
+  assert_flagged (sources[0]);
+  clear_flag (sources[0]);
+  g_source_set_priority (sources[0], G_PRIORITY_DEFAULT_IDLE);
+  g_assert (g_main_context_iteration (context, FALSE));
+  assert_flagged (sources[0]);
+  clear_flag (sources[0]);
+  s = read (fds[0][0], &c, 1);
+  g_assert_cmpint (s, ==, 1);
+
+  g_assert (!g_main_context_iteration (context, FALSE));
+
+  for (i = 0; i < G_N_ELEMENTS (priorities); i++)
+    {
+      assert_not_flagged (sources[i]);
+      g_source_destroy (sources[i]);
+      g_source_unref (sources[i]);
+      close (fds[i][0]);
+      close (fds[i][1]);
+    }
+}
+
+static void
+test_check_priorities (void)
+{
+  GMainContext *context;
+
+  context = g_main_context_new ();
+  check_priorities_in_context (context);
+  g_main_context_unref (context);
+
+  context = g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_EPOLL);
+  check_priorities_in_context (context);
+  g_main_context_unref (context);
+}
+
+static gint n_custom_polls;
+
+static gint
+counting_poll (GPollFD *fds,
+               guint    nfds,
+               gint     timeout)
+{
+  n_custom_polls++;
+
+  return g_poll (fds, nfds, timeout);
+}
+
+static void
+test_epoll_context (void)
+{
+  GSourceFuncs no_funcs = {
+    NULL, NULL, return_true
+  };
+  GMainContext *context;
+  GSource *source_a;
+  GSource *source_b;
+  GSource *source_c;
+  gpointer tag_a, tag_b;
+  gchar *filename;
+  gint fds[2];
+  gint file_fd;
+  gint s;
+
+  context = g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_EPOLL);
+
+  s = pipe (fds);
+  g_assert (s == 0);
+
+  /* two sources sharing the same fd */
+  source_a = g_source_new (&no_funcs, sizeof (FlagSource));
+  source_b = g_source_new (&no_funcs, sizeof (FlagSource));
+  tag_a = g_source_add_unix_fd (source_a, fds[0], G_IO_IN);
+  tag_b = g_source_add_unix_fd (source_b, fds[0], G_IO_IN);
+  g_source_attach (source_a, context);
+  g_source_attach (source_b, context);
+
+  while (g_main_context_iteration (context, FALSE));
+  assert_not_flagged (source_a);
+  assert_not_flagged (source_b);
+
+  s = write (fds[1], "x", 1);
+  g_assert_cmpint (s, ==, 1);
+  g_assert (g_main_context_iteration (context, TRUE));
+  assert_flagged (source_a);
+  assert_flagged (source_b);
+  clear_flag (source_a);
+  clear_flag (source_b);
+
+  /* stop watching on 'a' only */
+  g_source_modify_unix_fd (source_a, tag_a, 0);
+  g_assert (g_main_context_iteration (context, FALSE));
+  assert_not_flagged (source_a);
+  assert_flagged (source_b);
+  clear_flag (source_b);
+
+  /* ...and on 'b', so that nothing is ready anymore */
+  g_source_remove_unix_fd (source_b, tag_b);
+  g_assert (!g_main_context_iteration (context, FALSE));
+  assert_not_flagged (source_a);
+  assert_not_flagged (source_b);
+
+  g_source_modify_unix_fd (source_a, tag_a, G_IO_IN);
+  g_assert (g_main_context_iteration (context, FALSE));
+  assert_flagged (source_a);
+  clear_flag (source_a);
+
+  g_source_destroy (source_a);
+  g_source_destroy (source_b);
+  g_source_unref (source_a);
+  g_source_unref (source_b);
+  g_assert (!g_main_context_iteration (context, FALSE));
+
+  /* epoll refuses regular files; they should still always poll ready */
+  file_fd = g_file_open_tmp (NULL, &filename, NULL);
+  g_assert_cmpint (file_fd, >=, 0);
+  source_c = g_source_new (&no_funcs, sizeof (FlagSource));
+  g_source_add_unix_fd (source_c, file_fd, G_IO_IN);
+  g_source_attach (source_c, context);
+  g_assert (g_main_context_iteration (context, TRUE));
+  assert_flagged (source_c);
+  g_source_destroy (source_c);
+  g_source_unref (source_c);
+  close (file_fd);
+  g_unlink (filename);
+  g_free (filename);
+
+  /* an explicit poll function always takes precedence */
+  g_main_context_set_poll_func (context, counting_poll);
+  source_a = g_source_new (&no_funcs, sizeof (FlagSource));
+  g_source_add_unix_fd (source_a, fds[0], G_IO_IN);
+  g_source_attach (source_a, context);
+  g_assert (g_main_context_iteration (context, FALSE));
+  assert_flagged (source_a);
+  g_assert_cmpint (n_custom_polls, >, 0);
+  g_source_destroy (source_a);
+  g_source_unref (source_a);
+
+  close (fds[1]);
+  close (fds[0]);
+
+  g_main_context_unref (context);
+}
+
+static gboolean
+deferred_fd_cb (gint         fd,
+                GIOCondition condition,
+                gpointer     user_data)
+{
+  gint *n_dispatched = user_data;
+
+  /* never dispatched after the pipe was drained */
+  g_assert_cmpint (condition, ==, G_IO_IN);
+  (*n_dispatched)++;
+
+  return G_SOURCE_CONTINUE;
+}
+
+typedef enum {
+  DEFERRED_FD_POLL,
+  DEFERRED_FD_POLL_FUNC,
+  DEFERRED_FD_EPOLL
+} DeferredFdBackend;
+
+static void
+test_deferred_fd (gconstpointer data)
+{
+  DeferredFdBackend backend = GPOINTER_TO_INT (data);
+  GMainContext *context;
+  GSource *sources[2];
+  gint n_dispatched[2] = { 0, 0 };
+  gint fds[2];
+  gchar c = 'x';
+  gint i;
+
+  if (backend == DEFERRED_FD_EPOLL)
+    context = g_main_context_new_with_flags (G_MAIN_CONTEXT_FLAGS_EPOLL);
+  else
+    context = g_main_context_new ();
+  if (backend == DEFERRED_FD_POLL_FUNC)
+    g_main_context_set_poll_func (context, counting_poll);
+  g_main_context_set_dispatch_budget (context, 1, 0);
+
+  g_assert (pipe (fds) == 0);
+  for (i = 0; i < 2; i++)
+    {
+      sources[i] = g_unix_fd_source_new (fds[0], G_IO_IN);
+      g_source_set_callback (sources[i], (GSourceFunc) deferred_fd_cb, &n_dispatched[i], NULL);
+      g_source_attach (sources[i], context);
+    }
+
+  /* One of them is dispatched, the other one is left over */
+  g_assert (write (fds[1], &c, 1) == 1);
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (n_dispatched[0] + n_dispatched[1], ==, 1);
+  g_assert_cmpuint (g_main_context_get_deferred_dispatches (context), ==, 1);
+
+  /* ...and it is dropped once its fd is no longer ready */
+  g_assert (read (fds[0], &c, 1) == 1);
+  g_assert (!g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (n_dispatched[0] + n_dispatched[1], ==, 1);
+
+  /* A left-over that is still ready gets the revents of the new poll,
+   * and goes before the other one, which is left over in turn
+   */
+  g_assert (write (fds[1], &c, 1) == 1);
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (n_dispatched[0], ==, 2);
+  g_assert_cmpint (n_dispatched[1], ==, 1);
+  g_assert_cmpuint (g_main_context_get_deferred_dispatches (context), ==, 3);
+
+  for (i = 0; i < 2; i++)
+    {
+      g_source_destroy (sources[i]);
+      g_source_unref (sources[i]);
+    }
+  close (fds[1]);
+  close (fds[0]);
+
+  g_main_context_unref (context);
+}
+
 #endif
 
+static gboolean
+trace_buffer_idle_cb (gpointer data)
+{
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_trace_buffer_subprocess (void)
+{
+  GSource *source;
+
+  g_assert (GLIB_PRIVATE_CALL (g_trace_buffer_enabled) ());
+
+  source = g_idle_source_new ();
+  g_source_set_name (source, "trace-buffer-idle");
+  g_source_set_callback (source, trace_buffer_idle_cb, NULL, NULL);
+  g_source_attach (source, NULL);
+  g_source_unref (source);
+
+  while (g_main_context_iteration (NULL, FALSE));
+
+  /* the buffer is written out at exit */
+}
+
+static void
+test_trace_buffer (void)
+{
+  gchar *dir, *json, *binary;
+  gchar *contents;
+  gsize length;
+  guint32 event_size, n_threads;
+
+  /* This also makes sure that this process doesn't start tracing once
+   * G_TRACE_BUFFER is set for the subprocesses.
+   */
+  if (GLIB_PRIVATE_CALL (g_trace_buffer_enabled) ())
+    {
+      g_test_skip ("G_TRACE_BUFFER is already set");
+      return;
+    }
+
+  dir = g_dir_make_tmp ("glib-trace-buffer-XXXXXX", NULL);
+  g_assert (dir != NULL);
+  json = g_build_filename (dir, "trace.json", NULL);
+  binary = g_build_filename (dir, "trace", NULL);
+
+  g_setenv ("G_TRACE_BUFFER", json, TRUE);
+  g_test_trap_subprocess ("/mainloop/trace-buffer/subprocess", 0, 0);
+  g_test_trap_assert_passed ();
+
+  g_assert (g_file_get_contents (json, &contents, NULL, NULL));
+  g_assert (g_str_has_prefix (contents, "{\"traceEvents\":["));
+  g_assert (strstr (contents, "{\"name\":\"trace-buffer-idle\",\"cat\":\"source\",\"ph\":\"B\"") != NULL);
+  g_assert (strstr (contents, "{\"name\":\"trace-buffer-idle\",\"cat\":\"source\",\"ph\":\"E\"") != NULL);
+  g_assert (strstr (contents, "\"cat\":\"poll\"") != NULL);
+  g_free (contents);
+
+  g_setenv ("G_TRACE_BUFFER", binary, TRUE);
+  g_test_trap_subprocess ("/mainloop/trace-buffer/subprocess", 0, 0);
+  g_test_trap_assert_passed ();
+  g_unsetenv ("G_TRACE_BUFFER");
+
+  g_assert (g_file_get_contents (binary, &contents, &length, NULL));
+  g_assert_cmpuint (length, >, 16);
+  g_assert (memcmp (contents, "GLIBTRCE", 8) == 0);
+  memcpy (&event_size, contents + 8, sizeof event_size);
+  memcpy (&n_threads, contents + 12, sizeof n_threads);
+  g_assert_cmpuint (n_threads, >=, 1);
+  g_assert_cmpuint ((length - 16 - 8 * n_threads) % event_size, ==, 0);
+  g_free (contents);
+
+  g_remove (json);
+  g_remove (binary);
+  g_rmdir (dir);
+  g_free (json);
+  g_free (binary);
+  g_free (dir);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1416,6 +2148,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/mainloop/timeouts", test_timeouts);
   g_test_add_func ("/mainloop/priorities", test_priorities);
   g_test_add_func ("/mainloop/invoke", test_invoke);
+  g_test_add_func ("/mainloop/invoke-queue", test_invoke_queue);
   g_test_add_func ("/mainloop/child_sources", test_child_sources);
   g_test_add_func ("/mainloop/recursive_child_sources", test_recursive_child_sources);
   g_test_add_func ("/mainloop/swapping_child_sources", test_swapping_child_sources);
@@ -1423,13 +2156,25 @@ main (int argc, char *argv[])
   g_test_add_func ("/mainloop/source_time", test_source_time);
   g_test_add_func ("/mainloop/overflow", test_mainloop_overflow);
   g_test_add_func ("/mainloop/ready-time", test_ready_time);
+  g_test_add_func ("/mainloop/timer-heap", test_timer_heap);
+  g_test_add_func ("/mainloop/statistics", test_statistics);
+  g_test_add_func ("/mainloop/dispatch-budget", test_dispatch_budget);
+  g_test_add_func ("/mainloop/watchdog", test_watchdog);
+  g_test_add_func ("/mainloop/watchdog/subprocess", test_watchdog_subprocess);
   g_test_add_func ("/mainloop/wakeup", test_wakeup);
   g_test_add_func ("/mainloop/remove-invalid", test_remove_invalid);
 #ifdef G_OS_UNIX
   g_test_add_func ("/mainloop/unix-fd", test_unix_fd);
   g_test_add_func ("/mainloop/unix-fd-source", test_unix_fd_source);
   g_test_add_func ("/mainloop/source-unix-fd-api", test_source_unix_fd_api);
+  g_test_add_func ("/mainloop/epoll-context", test_epoll_context);
+  g_test_add_func ("/mainloop/check-priorities", test_check_priorities);
+  g_test_add_data_func ("/mainloop/deferred-fd", GINT_TO_POINTER (DEFERRED_FD_POLL), test_deferred_fd);
+  g_test_add_data_func ("/mainloop/deferred-fd/poll-func", GINT_TO_POINTER (DEFERRED_FD_POLL_FUNC), test_deferred_fd);
+  g_test_add_data_func ("/mainloop/deferred-fd/epoll", GINT_TO_POINTER (DEFERRED_FD_EPOLL), test_deferred_fd);
 #endif
+  g_test_add_func ("/mainloop/trace-buffer", test_trace_buffer);
+  g_test_add_func ("/mainloop/trace-buffer/subprocess", test_trace_buffer_subprocess);
 
   return g_test_run ();
 }
@@ -180,6 +180,77 @@ test_gbytes (void)
   g_bytes_unref (bytes);
 }
 
+static void
+test_full (void)
+{
+  GMappedFile *file;
+  GError *error = NULL;
+  gchar *data, *contents;
+  gsize len, i;
+  gchar *tmp_path;
+
+  tmp_path = g_build_filename (g_get_user_runtime_dir (), "glib-test-mapped-full", NULL);
+
+  len = 3 * 1024 * 1024 + 123;
+  data = g_malloc (len);
+  for (i = 0; i < len; i++)
+    data[i] = (gchar) (i * 7 + (i >> 12));
+  g_file_set_contents (tmp_path, data, len, &error);
+  g_assert_no_error (error);
+
+  /* an unaligned window */
+  file = g_mapped_file_new_full (tmp_path,
+                                 G_MAPPED_FILE_FLAGS_SEQUENTIAL | G_MAPPED_FILE_FLAGS_WILLNEED,
+                                 5000, 100, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_mapped_file_get_length (file), ==, 100);
+  g_assert (memcmp (g_mapped_file_get_contents (file), data + 5000, 100) == 0);
+  g_mapped_file_unref (file);
+
+  /* up to the end */
+  file = g_mapped_file_new_full (tmp_path,
+                                 G_MAPPED_FILE_FLAGS_RANDOM | G_MAPPED_FILE_FLAGS_POPULATE,
+                                 len - 10, 0, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_mapped_file_get_length (file), ==, 10);
+  g_assert (memcmp (g_mapped_file_get_contents (file), data + len - 10, 10) == 0);
+  g_mapped_file_unref (file);
+
+  file = g_mapped_file_new_full (tmp_path, G_MAPPED_FILE_FLAGS_NONE, len, 0, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_mapped_file_get_length (file), ==, 0);
+  g_assert (g_mapped_file_get_contents (file) == NULL);
+  g_mapped_file_unref (file);
+
+  file = g_mapped_file_new_full (tmp_path, G_MAPPED_FILE_FLAGS_NONE, len - 10, 11, &error);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+  g_assert (file == NULL);
+  g_clear_error (&error);
+
+  /* huge page alignment, and writing to a private copy */
+  file = g_mapped_file_new_full (tmp_path,
+                                 G_MAPPED_FILE_FLAGS_HUGEPAGES | G_MAPPED_FILE_FLAGS_WRITABLE,
+                                 1, 0, &error);
+  g_assert_no_error (error);
+  contents = g_mapped_file_get_contents (file);
+  g_assert_cmpuint (g_mapped_file_get_length (file), ==, len - 1);
+  g_assert (memcmp (contents, data + 1, len - 1) == 0);
+#ifdef __linux__
+  g_assert_cmpuint (((gsize) contents) % (2 * 1024 * 1024), ==, 1);
+#endif
+  contents[0] = 'x';
+  g_mapped_file_unref (file);
+
+  file = g_mapped_file_new (tmp_path, FALSE, &error);
+  g_assert_no_error (error);
+  g_assert (memcmp (g_mapped_file_get_contents (file), data, len) == 0);
+  g_mapped_file_unref (file);
+
+  g_unlink (tmp_path);
+  g_free (tmp_path);
+  g_free (data);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -194,6 +265,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/mappedfile/writable", test_writable);
   g_test_add_func ("/mappedfile/writable_fd", test_writable_fd);
   g_test_add_func ("/mappedfile/gbytes", test_gbytes);
+  g_test_add_func ("/mappedfile/full", test_full);
 
   return g_test_run ();
 }
@@ -145,7 +145,8 @@ test_in_chunks (const gchar *contents,
 }
 
 static int
-test_file (const gchar *filename)
+test_file (const gchar       *filename,
+           GMarkupParseFlags  flags)
 {
   gchar *contents;
   gsize  length;
@@ -164,7 +165,7 @@ test_file (const gchar *filename)
       return 1;
     }
 
-  context = g_markup_parse_context_new (&parser, 0, NULL, NULL);
+  context = g_markup_parse_context_new (&parser, flags, NULL, NULL);
   g_assert (g_markup_parse_context_get_user_data (context) == NULL);
   g_markup_parse_context_get_position (context, &line, &col);
   g_assert (line == 1 && col == 1);
@@ -247,12 +248,19 @@ test_parse (gconstpointer d)
   gchar *expected_file;
   gchar *expected;
   GError *error = NULL;
+  gchar *borrowed;
   gint res;
 
+  /* borrowing the text must not make any difference */
   depth = 0;
   string = g_string_sized_new (0);
+  test_file (filename, G_MARKUP_BORROW_TEXT);
+  borrowed = g_string_free (string, FALSE);
 
-  res = test_file (filename);
+  depth = 0;
+  string = g_string_sized_new (0);
+
+  res = test_file (filename, 0);
 
   if (strstr (filename, "valid"))
     g_assert_cmpint (res, ==, 0);
@@ -263,6 +271,8 @@ test_parse (gconstpointer d)
   g_file_get_contents (expected_file, &expected, NULL, &error);
   g_assert_no_error (error);
   g_assert_cmpstr (string->str, ==, expected);
+  g_assert_cmpstr (borrowed, ==, expected);
+  g_free (borrowed);
   g_free (expected);
   g_free (expected_file);
 
@@ -286,7 +296,7 @@ main (int argc, char *argv[])
   if (argc > 1)
     {
       string = g_string_sized_new (0);
-      test_file (argv[1]);
+      test_file (argv[1], 0);
       g_print ("%s", string->str);
       return 0;
     }
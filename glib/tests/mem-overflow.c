@@ -24,6 +24,8 @@
 #pragma GCC optimize (1)
 
 #include "glib.h"
+#include <glib/gstdio.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 static gsize a = G_MAXSIZE / 10 + 10;
@@ -194,6 +196,88 @@ empty_alloc (void)
   g_test_trap_assert_passed ();
 }
 
+/* Returns the sum of the live bytes of all call stacks in the profile */
+static gsize
+profiler_live_bytes (const gchar *filename)
+{
+  gchar *contents;
+  gchar **lines;
+  gboolean entry_start = TRUE;
+  gsize live = 0;
+  guint i;
+
+  g_assert (g_file_get_contents (filename, &contents, NULL, NULL));
+  g_assert (g_str_has_prefix (contents, "# GLib heap profile, one sample every 1 bytes\n"));
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i]; i++)
+    {
+      gsize entry_live, entry_total, entry_samples;
+
+      if (lines[i][0] == '#')
+        continue;
+
+      if (lines[i][0] == '\0')
+        entry_start = TRUE;
+      else if (entry_start)
+        {
+          g_assert_cmpint (sscanf (lines[i], "%" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT,
+                                   &entry_live, &entry_total, &entry_samples), ==, 3);
+          g_assert_cmpuint (entry_live, <=, entry_total);
+          g_assert_cmpuint (entry_samples, >, 0);
+          live += entry_live;
+          entry_start = FALSE;
+        }
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return live;
+}
+
+static void
+profiler (void)
+{
+  gpointer blocks[20];
+  gchar *filename;
+  gsize live;
+  gint fd;
+  guint i;
+
+  fd = g_file_open_tmp ("glib-heap-profile-XXXXXX", &filename, NULL);
+  g_assert_cmpint (fd, >=, 0);
+  g_close (fd, NULL);
+
+  /* Sample every allocation */
+  g_mem_profiler_start (1);
+
+  /* Reading the profile the first time allocates some caches */
+  g_assert (g_mem_profiler_dump (filename, NULL));
+  profiler_live_bytes (filename);
+
+  for (i = 0; i < 10; i++)
+    blocks[i] = g_malloc (100);
+  for (i = 10; i < 20; i++)
+    blocks[i] = g_slice_alloc (24);
+
+  g_assert (g_mem_profiler_dump (filename, NULL));
+  live = profiler_live_bytes (filename);
+
+  for (i = 0; i < 10; i++)
+    g_free (blocks[i]);
+  for (i = 10; i < 20; i++)
+    g_slice_free1 (24, blocks[i]);
+
+  g_assert (g_mem_profiler_dump (filename, NULL));
+  g_assert_cmpuint (live - profiler_live_bytes (filename), ==, 10 * 100 + 10 * 24);
+
+  g_mem_profiler_stop ();
+
+  g_remove (filename);
+  g_free (filename);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -226,6 +310,7 @@ main (int   argc,
 
   g_test_add_func ("/mem/empty-alloc", empty_alloc);
   g_test_add_func ("/mem/empty-alloc/subprocess", empty_alloc_subprocess);
+  g_test_add_func ("/mem/profiler", profiler);
 
   return g_test_run();
 }
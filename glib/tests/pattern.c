@@ -147,7 +147,17 @@ static MatchTest match_tests[] =
   { "fooooooo*a*bc", "fooooooo_a_bd_a_bc", TRUE },
   { "x*?", "x", FALSE },
   { "abc*", "abc", TRUE },
-  { "*", "abc", TRUE }
+  { "*", "abc", TRUE },
+  { "a*a", "a", FALSE },
+  { "a*a", "aa", TRUE },
+  { "ab*?*ba", "aba", FALSE },
+  { "ab*?*ba", "ab\xc3\x84" "ba", TRUE },
+  { "*?\xc3\xa4*", "\xc3\xa4\xc3\xa4", TRUE },
+  { "*?\xc3\xa4*", "x\xc3\xb6", FALSE },
+  { "*a?c*x*", "abcabcaxc", TRUE },
+  { "*a?c*x*", "abcabca", FALSE },
+  { "a*b?c*d", "aXbYcZd", TRUE },
+  { "a*b?c*d", "abcd", FALSE }
 };
 
 static void
@@ -208,6 +218,82 @@ test_equal (gconstpointer d)
   g_pattern_spec_free (p2);
 }
 
+static void
+test_set (void)
+{
+  const gchar *patterns[] = {
+    "*.c",
+    "*.h",
+    "src/*",
+    "src/*.c",
+    "README",
+    "*test*",
+    "*",
+    "src/?.c",
+    "docs/*/index.html",
+    "*.c"
+  };
+  struct {
+    const gchar *string;
+    const gchar *matches;
+  } tests[] = {
+    { "main.c", "0 6 9" },
+    { "src/main.c", "0 2 3 6 9" },
+    { "src/x.c", "0 2 3 6 7 9" },
+    { "README", "4 6" },
+    { "tests/test.h", "1 5 6" },
+    { "docs/api/index.html", "6 8" },
+    { "", "6" }
+  };
+  GPatternSpecSet *set;
+  GArray *matches;
+  guint i, j;
+
+  set = g_pattern_spec_set_new ();
+  for (i = 0; i < G_N_ELEMENTS (patterns); i++)
+    g_assert_cmpuint (g_pattern_spec_set_add (set, patterns[i]), ==, i);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (guint));
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      GString *found = g_string_new (NULL);
+
+      g_assert (g_pattern_spec_set_match (set, strlen (tests[i].string), tests[i].string, matches));
+      for (j = 0; j < matches->len; j++)
+        g_string_append_printf (found, "%s%u", j ? " " : "",
+                                g_array_index (matches, guint, j));
+      g_assert_cmpstr (found->str, ==, tests[i].matches);
+      g_string_free (found, TRUE);
+
+      g_assert (g_pattern_spec_set_match (set, strlen (tests[i].string), tests[i].string, NULL));
+    }
+  g_array_unref (matches);
+  g_pattern_spec_set_free (set);
+
+  /* must agree with the patterns taken one by one */
+  set = g_pattern_spec_set_new ();
+  for (i = 0; i < G_N_ELEMENTS (match_tests); i++)
+    g_pattern_spec_set_add (set, match_tests[i].pattern);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (guint));
+  for (i = 0; i < G_N_ELEMENTS (match_tests); i++)
+    {
+      const gchar *string = match_tests[i].string;
+      guint n = 0;
+
+      g_pattern_spec_set_match (set, strlen (string), string, matches);
+      for (j = 0; j < G_N_ELEMENTS (match_tests); j++)
+        if (g_pattern_match_simple (match_tests[j].pattern, string))
+          {
+            g_assert_cmpuint (n, <, matches->len);
+            g_assert_cmpuint (g_array_index (matches, guint, n), ==, j);
+            n++;
+          }
+      g_assert_cmpuint (n, ==, matches->len);
+    }
+  g_array_unref (matches);
+  g_pattern_spec_set_free (set);
+}
 
 int
 main (int argc, char** argv)
@@ -238,6 +324,8 @@ main (int argc, char** argv)
       g_free (path);
     }
 
+  g_test_add_func ("/pattern/set", test_set);
+
   return g_test_run ();
 }
 
@@ -1078,6 +1078,60 @@ test_free_full (void)
   g_slice_free (QueueItem, three);
 }
 
+typedef struct
+{
+  GList link;
+  int x;
+} EmbeddedItem;
+
+static void
+test_embedded_links (void)
+{
+  EmbeddedItem items[5];
+  GQueue queue = G_QUEUE_INIT;
+  GList *link;
+  gint i, round;
+
+  for (i = 0; i < 5; i++)
+    {
+      items[i].link.data = &items[i];
+      items[i].link.prev = items[i].link.next = NULL;
+      items[i].x = i;
+    }
+
+  /* links can be queued and dequeued again and again */
+  for (round = 0; round < 2; round++)
+    {
+      g_queue_insert_before_link (&queue, NULL, &items[4].link);
+      g_queue_insert_after_link (&queue, NULL, &items[0].link);
+      g_queue_insert_before_link (&queue, &items[4].link, &items[2].link);
+      g_queue_insert_after_link (&queue, &items[0].link, &items[1].link);
+      g_queue_insert_after_link (&queue, &items[2].link, &items[3].link);
+      check_integrity (&queue);
+      g_assert_cmpint (queue.length, ==, 5);
+
+      for (i = 0, link = queue.head; link; i++, link = link->next)
+        g_assert_cmpint (((EmbeddedItem *) link->data)->x, ==, i);
+
+      g_queue_unlink (&queue, &items[2].link);
+      g_assert (items[2].link.prev == NULL && items[2].link.next == NULL);
+      g_queue_insert_after_link (&queue, queue.tail, &items[2].link);
+      check_integrity (&queue);
+      g_assert (g_queue_peek_tail (&queue) == &items[2]);
+
+      g_assert (g_queue_pop_head_link (&queue)->data == &items[0]);
+      g_assert (g_queue_pop_tail_link (&queue)->data == &items[2]);
+      g_assert (g_queue_pop_head_link (&queue)->data == &items[1]);
+      g_assert (g_queue_pop_head_link (&queue)->data == &items[3]);
+      g_assert (g_queue_pop_head_link (&queue)->data == &items[4]);
+      g_assert (g_queue_is_empty (&queue));
+      check_integrity (&queue);
+
+      for (i = 0; i < 5; i++)
+        g_assert (items[i].link.prev == NULL && items[i].link.next == NULL);
+    }
+}
+
 
 int main (int argc, char *argv[])
 {
@@ -1093,6 +1147,7 @@ int main (int argc, char *argv[])
   g_test_add_func ("/queue/static", test_static);
   g_test_add_func ("/queue/clear", test_clear);
   g_test_add_func ("/queue/free-full", test_free_full);
+  g_test_add_func ("/queue/embedded-links", test_embedded_links);
 
   seed = g_test_rand_int_range (0, G_MAXINT);
   path = g_strdup_printf ("/queue/random/seed:%u", seed);
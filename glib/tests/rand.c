@@ -162,6 +162,93 @@ test_double_range (void)
   g_assert (d < G_MAXDOUBLE);
 }
 
+static void
+test_fill (gconstpointer data)
+{
+  GRandAlgorithm algorithm = GPOINTER_TO_INT (data);
+  guint32 seed[] = { 1, 2, 3, 4 };
+  guint32 buffer[1500];
+  gdouble doubles[1500];
+  GRand *r1, *r2;
+  gint i;
+
+  r1 = g_rand_new_with_algorithm (algorithm);
+  g_rand_set_seed_array (r1, seed, G_N_ELEMENTS (seed));
+  r2 = g_rand_copy (r1);
+
+  /* odd sizes, to cross the Mersenne Twister's block boundaries */
+  g_rand_fill (r1, buffer, 7);
+  g_rand_fill (r1, buffer + 7, G_N_ELEMENTS (buffer) - 7);
+  for (i = 0; i < G_N_ELEMENTS (buffer); i++)
+    g_assert_cmpuint (buffer[i], ==, g_rand_int (r2));
+
+  g_rand_double_array (r1, doubles, 311);
+  g_rand_double_array (r1, doubles + 311, G_N_ELEMENTS (doubles) - 311);
+  for (i = 0; i < G_N_ELEMENTS (doubles); i++)
+    {
+      g_assert_cmpfloat (doubles[i], ==, g_rand_double (r2));
+      g_assert_cmpfloat (doubles[i], >=, 0.0);
+      g_assert_cmpfloat (doubles[i], <, 1.0);
+    }
+
+  g_assert_cmpuint (g_rand_int (r1), ==, g_rand_int (r2));
+
+  g_rand_free (r1);
+  g_rand_free (r2);
+}
+
+static void
+test_xoshiro (void)
+{
+  guint32 first[10];
+  gint counts[10] = { 0, };
+  GRand *r1, *r2;
+  gint i;
+
+  r1 = g_rand_new_with_algorithm (G_RAND_ALGORITHM_XOSHIRO256);
+  r2 = g_rand_new_with_algorithm (G_RAND_ALGORITHM_XOSHIRO256);
+
+  /* the same seed gives the same sequence */
+  g_rand_set_seed (r1, 42);
+  g_rand_set_seed (r2, 42);
+  for (i = 0; i < G_N_ELEMENTS (first); i++)
+    {
+      first[i] = g_rand_int (r1);
+      g_assert_cmpuint (first[i], ==, g_rand_int (r2));
+    }
+
+  /* and a different one a different sequence */
+  g_rand_set_seed (r2, 43);
+  for (i = 0; i < G_N_ELEMENTS (first); i++)
+    if (first[i] != g_rand_int (r2))
+      break;
+  g_assert_cmpint (i, <, G_N_ELEMENTS (first));
+
+  /* which doesn't match the Mersenne Twister either */
+  g_rand_free (r2);
+  r2 = g_rand_new_with_seed (42);
+  for (i = 0; i < G_N_ELEMENTS (first); i++)
+    if (first[i] != g_rand_int (r2))
+      break;
+  g_assert_cmpint (i, <, G_N_ELEMENTS (first));
+
+  for (i = 0; i < 100000; i++)
+    {
+      gint32 v = g_rand_int_range (r1, 0, G_N_ELEMENTS (counts));
+
+      g_assert_cmpint (v, >=, 0);
+      g_assert_cmpint (v, <, G_N_ELEMENTS (counts));
+      counts[v]++;
+    }
+
+  /* very rough uniformity check */
+  for (i = 0; i < G_N_ELEMENTS (counts); i++)
+    g_assert_cmpint (ABS (counts[i] - 10000), <, 1000);
+
+  g_rand_free (r1);
+  g_rand_free (r2);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -171,6 +258,13 @@ main (int   argc,
 
   g_test_add_func ("/rand/test-rand", test_rand);
   g_test_add_func ("/rand/double-range", test_double_range);
+  g_test_add_data_func ("/rand/fill/mersenne-twister",
+                        GINT_TO_POINTER (G_RAND_ALGORITHM_MERSENNE_TWISTER),
+                        test_fill);
+  g_test_add_data_func ("/rand/fill/xoshiro256",
+                        GINT_TO_POINTER (G_RAND_ALGORITHM_XOSHIRO256),
+                        test_fill);
+  g_test_add_func ("/rand/xoshiro256", test_xoshiro);
 
   return g_test_run();
 }
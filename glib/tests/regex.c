@@ -2102,6 +2102,214 @@ test_max_lookbehind (void)
   g_regex_unref (regex);
 }
 
+static void
+test_rematch (void)
+{
+  GRegex *regex;
+  GMatchInfo *match_info;
+  GError *error = NULL;
+  gchar *word;
+
+  regex = g_regex_new ("(\\w+)=(\\d+)", 0, 0, NULL);
+
+  g_assert (g_regex_match (regex, "a=1 b=2", 0, &match_info));
+  word = g_match_info_fetch (match_info, 1);
+  g_assert_cmpstr (word, ==, "a");
+  g_free (word);
+
+  g_assert (g_match_info_rematch (match_info, "xx yy=10 z=3", -1, 0, 0, &error));
+  g_assert_no_error (error);
+  word = g_match_info_fetch (match_info, 0);
+  g_assert_cmpstr (word, ==, "yy=10");
+  g_free (word);
+  g_assert (g_match_info_get_string (match_info) != NULL);
+  g_assert_cmpstr (g_match_info_get_string (match_info), ==, "xx yy=10 z=3");
+  g_assert (g_match_info_next (match_info, NULL));
+  word = g_match_info_fetch (match_info, 2);
+  g_assert_cmpstr (word, ==, "3");
+  g_free (word);
+  g_assert (!g_match_info_next (match_info, NULL));
+
+  /* length and start position are honoured */
+  g_assert (!g_match_info_rematch (match_info, "k=7", 2, 0, 0, NULL));
+  g_assert (!g_match_info_matches (match_info));
+  g_assert (!g_match_info_rematch (match_info, "k=7", -1, 1, 0, NULL));
+  g_assert (g_match_info_rematch (match_info, "k=7", -1, 0, 0, NULL));
+  g_assert (g_match_info_matches (match_info));
+
+  g_match_info_free (match_info);
+
+  /* matching without a GMatchInfo */
+  g_assert (g_regex_match (regex, "a=1", 0, NULL));
+  g_assert (!g_regex_match (regex, "a=", 0, NULL));
+  g_assert (!g_regex_match_full (regex, "a=1", -1, 4, 0, NULL, NULL));
+  g_assert (g_regex_match_full (regex, "-a=1", -1, 1, G_REGEX_MATCH_ANCHORED, NULL, NULL));
+  g_assert (!g_regex_match_full (regex, "-a=1", -1, 0, G_REGEX_MATCH_ANCHORED, NULL, NULL));
+
+  g_regex_unref (regex);
+
+  /* more subpatterns than the offsets kept on the stack */
+  regex = g_regex_new ("(a)(b)(c)(d)(e)(f)(g)(h)(i)(j)(k)(l)\\12", 0, 0, NULL);
+  g_assert (g_regex_match (regex, "abcdefghijkll", 0, NULL));
+  g_assert (!g_regex_match (regex, "abcdefghijklk", 0, NULL));
+  g_regex_unref (regex);
+}
+
+static void
+check_regex_set (const gchar * const *patterns,
+                 GRegexCompileFlags   compile_options,
+                 const gchar * const *strings)
+{
+  GRegexSet *regex_set;
+  GArray *matches;
+  gint i, j;
+
+  regex_set = g_regex_set_new (patterns, -1, compile_options, 0, NULL);
+  g_assert (regex_set != NULL);
+  g_assert_cmpuint (g_regex_set_get_n_patterns (regex_set), ==, g_strv_length ((gchar **) patterns));
+
+  matches = g_array_new (FALSE, FALSE, sizeof (guint));
+  for (i = 0; strings[i]; i++)
+    {
+      GArray *expected = g_array_new (FALSE, FALSE, sizeof (guint));
+      gboolean any;
+
+      for (j = 0; patterns[j]; j++)
+        if (g_regex_match (g_regex_set_get_regex (regex_set, j), strings[i], 0, NULL))
+          g_array_append_val (expected, j);
+
+      any = g_regex_set_match (regex_set, strings[i], -1, 0, matches, NULL);
+      g_assert_cmpint (any, ==, expected->len > 0);
+      g_assert_cmpuint (matches->len, ==, expected->len);
+      for (j = 0; j < expected->len; j++)
+        g_assert_cmpuint (g_array_index (matches, guint, j), ==, g_array_index (expected, guint, j));
+
+      g_assert_cmpint (g_regex_set_match (regex_set, strings[i], -1, 0, NULL, NULL), ==, any);
+
+      g_array_unref (expected);
+    }
+
+  g_array_unref (matches);
+  g_regex_set_unref (regex_set);
+}
+
+static void
+test_regex_set (void)
+{
+  const gchar *patterns[] = {
+    "error", "^warn", "disk (\\d+) full", "[0-9]+ms$", "(?i)timeout",
+    "\\bconn(ect|ection) refused", "x*", "caf\xc3\xa9", "^$", "a|b",
+    "(?=.*user)(?=.*root)", "LOGIN", "[^a-z]{3}", NULL
+  };
+  const gchar *strings[] = {
+    "error: disk 3 full", "warn: request took 120ms", "TIMEOUT while waiting",
+    "connection refused", "a caf\xc3\xa9", "", "login as root user",
+    "LOGIN ok", "nothing", "ERROR", "123", NULL
+  };
+  GRegexSet *regex_set;
+  GError *error = NULL;
+  const gchar *bad[] = { "ok", "(unclosed", NULL };
+
+  check_regex_set (patterns, 0, strings);
+  check_regex_set (patterns, G_REGEX_OPTIMIZE, strings);
+  check_regex_set (patterns, G_REGEX_CASELESS, strings);
+
+  regex_set = g_regex_set_new (bad, -1, 0, 0, &error);
+  g_assert_error (error, G_REGEX_ERROR, G_REGEX_ERROR_UNMATCHED_PARENTHESIS);
+  g_assert (regex_set == NULL);
+  g_clear_error (&error);
+
+  regex_set = g_regex_set_new (NULL, 0, 0, 0, NULL);
+  g_assert (!g_regex_set_match (regex_set, "abc", -1, 0, NULL, NULL));
+  g_regex_set_unref (regex_set);
+}
+
+static gpointer
+jit_match_thread (gpointer data)
+{
+  GRegex *regex = data;
+  gchar *line;
+  gint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      line = g_strdup_printf ("%d: [warn] disk %d full", i, i % 7);
+      g_assert (g_regex_match (regex, line, 0, NULL));
+      g_free (line);
+    }
+
+  return NULL;
+}
+
+static void
+test_jit (void)
+{
+  const gchar *patterns[] = {
+    "(\\d+): \\[(\\w+)\\] (.*)",
+    "^(?:a|b)*c$",
+    "(?<=\\d{3})foo",
+    "\\p{Lu}\\p{Ll}+",
+    "(a+)+b"
+  };
+  const gchar *strings[] = {
+    "12: [info] started", "ababababc", "123foo", "x Hello \xc3\x89t\xc3\xa9",
+    "aaaaaaaaaaaaaaaaaaaaaaaab", "", "nothing here"
+  };
+  GThread *threads[4];
+  GRegex *regex, *jit;
+  GMatchInfo *info;
+  gint i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (patterns); i++)
+    {
+      regex = g_regex_new (patterns[i], 0, 0, NULL);
+      jit = g_regex_new (patterns[i], G_REGEX_JIT, 0, NULL);
+      g_assert (jit != NULL);
+
+      for (j = 0; j < G_N_ELEMENTS (strings); j++)
+        {
+          GMatchInfo *jit_info;
+          gchar **groups, **jit_groups;
+
+          g_regex_match (regex, strings[j], 0, &info);
+          g_regex_match (jit, strings[j], 0, &jit_info);
+          g_assert_cmpint (g_match_info_matches (info), ==, g_match_info_matches (jit_info));
+
+          if (g_match_info_matches (info))
+            {
+              groups = g_match_info_fetch_all (info);
+              jit_groups = g_match_info_fetch_all (jit_info);
+              g_assert_cmpuint (g_strv_length (groups), ==, g_strv_length (jit_groups));
+              for (k = 0; groups[k] != NULL; k++)
+                g_assert_cmpstr (groups[k], ==, jit_groups[k]);
+              g_strfreev (groups);
+              g_strfreev (jit_groups);
+            }
+
+          g_match_info_free (info);
+          g_match_info_free (jit_info);
+        }
+
+      g_regex_unref (regex);
+      g_regex_unref (jit);
+    }
+
+  /* partial matches, which the JIT code may not handle itself */
+  jit = g_regex_new ("abc", G_REGEX_JIT, 0, NULL);
+  g_assert (!g_regex_match (jit, "xab", G_REGEX_MATCH_PARTIAL, &info));
+  g_assert (g_match_info_is_partial_match (info));
+  g_match_info_free (info);
+  g_regex_unref (jit);
+
+  /* the same pattern used from several threads */
+  jit = g_regex_new (patterns[0], G_REGEX_JIT, 0, NULL);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("regex", jit_match_thread, jit);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+  g_regex_unref (jit);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -2121,6 +2329,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/regex/multiline", test_multiline);
   g_test_add_func ("/regex/explicit-crlf", test_explicit_crlf);
   g_test_add_func ("/regex/max-lookbehind", test_max_lookbehind);
+  g_test_add_func ("/regex/rematch", test_rematch);
+  g_test_add_func ("/regex/jit", test_jit);
+  g_test_add_func ("/regex/set", test_regex_set);
 
   /* TEST_NEW(pattern, compile_opts, match_opts) */
   TEST_NEW("[A-Z]+", G_REGEX_CASELESS | G_REGEX_EXTENDED | G_REGEX_OPTIMIZE, G_REGEX_MATCH_NOTBOL | G_REGEX_MATCH_PARTIAL);
@@ -2141,6 +2352,7 @@ main (int argc, char *argv[])
   /* Check that flags are correct if the pattern modifies them */
   /* TEST_NEW_CHECK_FLAGS(pattern, compile_opts, match_ops, real_compile_opts, real_match_opts) */
   TEST_NEW_CHECK_FLAGS ("a", G_REGEX_OPTIMIZE, 0, G_REGEX_OPTIMIZE, 0);
+  TEST_NEW_CHECK_FLAGS ("a", G_REGEX_JIT, 0, G_REGEX_JIT, 0);
   TEST_NEW_CHECK_FLAGS ("a", G_REGEX_RAW, 0, G_REGEX_RAW, 0);
   TEST_NEW_CHECK_FLAGS ("(?i)a", 0, 0, G_REGEX_CASELESS, 0);
   TEST_NEW_CHECK_FLAGS ("(?m)a", 0, 0, G_REGEX_MULTILINE, 0);
@@ -269,6 +269,102 @@ test_rwlock8 (void)
   g_rw_lock_clear (&even_lock);
 }
 
+static void
+test_big_rwlock_basic (void)
+{
+  static GBigRWLock static_lock;
+  GBigRWLock lock;
+  gboolean ret;
+
+  g_big_rw_lock_writer_lock (&static_lock);
+  g_big_rw_lock_writer_unlock (&static_lock);
+
+  g_big_rw_lock_init (&lock);
+
+  ret = g_big_rw_lock_reader_trylock (&lock);
+  g_assert (ret);
+  ret = g_big_rw_lock_writer_trylock (&lock);
+  g_assert (!ret);
+  g_big_rw_lock_reader_unlock (&lock);
+
+  g_big_rw_lock_writer_lock (&lock);
+  ret = g_big_rw_lock_reader_trylock (&lock);
+  g_assert (!ret);
+  ret = g_big_rw_lock_writer_trylock (&lock);
+  g_assert (!ret);
+  g_big_rw_lock_writer_unlock (&lock);
+
+  ret = g_big_rw_lock_writer_trylock (&lock);
+  g_assert (ret);
+  g_big_rw_lock_writer_unlock (&lock);
+
+  g_big_rw_lock_reader_lock (&lock);
+  g_big_rw_lock_reader_unlock (&lock);
+
+  g_big_rw_lock_clear (&lock);
+}
+
+static GBigRWLock big_even_lock;
+
+static gpointer
+big_writer_func (gpointer data)
+{
+  gint i;
+
+  for (i = 0; i < 10000; i++)
+    {
+      g_big_rw_lock_writer_lock (&big_even_lock);
+
+      g_assert (even % 2 == 0);
+      even += 1;
+      g_thread_yield ();
+      even += 1;
+      g_assert (even % 2 == 0);
+
+      g_big_rw_lock_writer_unlock (&big_even_lock);
+    }
+
+  return NULL;
+}
+
+static gpointer
+big_reader_func (gpointer data)
+{
+  gint i;
+
+  for (i = 0; i < 100000; i++)
+    {
+      g_big_rw_lock_reader_lock (&big_even_lock);
+      g_assert (even % 2 == 0);
+      g_big_rw_lock_reader_unlock (&big_even_lock);
+    }
+
+  return NULL;
+}
+
+/* Like test_rwlock8, for GBigRWLock */
+static void
+test_big_rwlock_even (void)
+{
+  gint i;
+
+  even = 0;
+
+  for (i = 0; i < 2; i++)
+    writers[i] = g_thread_new ("a", big_writer_func, NULL);
+
+  for (i = 0; i < 10; i++)
+    readers[i] = g_thread_new ("b", big_reader_func, NULL);
+
+  for (i = 0; i < 2; i++)
+    g_thread_join (writers[i]);
+
+  for (i = 0; i < 10; i++)
+    g_thread_join (readers[i]);
+
+  g_assert_cmpint (even, ==, 2 * 10000 * 2);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -282,6 +378,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/thread/rwlock6", test_rwlock6);
   g_test_add_func ("/thread/rwlock7", test_rwlock7);
   g_test_add_func ("/thread/rwlock8", test_rwlock8);
+  g_test_add_func ("/thread/big-rwlock/basic", test_big_rwlock_basic);
+  g_test_add_func ("/thread/big-rwlock/even", test_big_rwlock_even);
 
   return g_test_run ();
 }
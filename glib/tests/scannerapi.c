@@ -131,6 +131,52 @@ test_scanner_tokens (ScannerFixture *fix,
   return;
 }
 
+static void
+test_scanner_identifiers (ScannerFixture *fix,
+                          gconstpointer   test_data)
+{
+  gchar long_symbol[100];
+  gchar *text;
+
+  memset (long_symbol, 'x', sizeof long_symbol - 1);
+  long_symbol[sizeof long_symbol - 1] = '\0';
+
+  g_scanner_scope_add_symbol (fix->scanner, 0, "width", GINT_TO_POINTER (1));
+  g_scanner_scope_add_symbol (fix->scanner, 0, long_symbol, GINT_TO_POINTER (2));
+  g_scanner_scope_add_symbol (fix->scanner, 1, "height", GINT_TO_POINTER (3));
+  fix->scanner->config->scope_0_fallback = TRUE;
+  fix->scanner->config->identifier_view = TRUE;
+  g_scanner_set_scope (fix->scanner, 1);
+
+  long_symbol[0] = 'X';
+  text = g_strconcat ("Width HEIGHT foo bar ", long_symbol, " baz", NULL);
+  g_scanner_input_text (fix->scanner, text, strlen (text));
+
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_SYMBOL);
+  g_assert_cmpint (GPOINTER_TO_INT (g_scanner_cur_value (fix->scanner).v_symbol), ==, 1);
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_SYMBOL);
+  g_assert_cmpint (GPOINTER_TO_INT (g_scanner_cur_value (fix->scanner).v_symbol), ==, 3);
+
+  /* peeking must not clobber the current identifier */
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_IDENTIFIER);
+  g_assert_cmpint (g_scanner_peek_next_token (fix->scanner), ==, G_TOKEN_IDENTIFIER);
+  g_assert_cmpstr (g_scanner_cur_value (fix->scanner).v_identifier, ==, "foo");
+  g_assert_cmpstr (fix->scanner->next_value.v_identifier, ==, "bar");
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_IDENTIFIER);
+  g_assert_cmpstr (g_scanner_cur_value (fix->scanner).v_identifier, ==, "bar");
+
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_SYMBOL);
+  g_assert_cmpint (GPOINTER_TO_INT (g_scanner_cur_value (fix->scanner).v_symbol), ==, 2);
+
+  /* switching back to owned strings mid-stream is fine */
+  fix->scanner->config->identifier_view = FALSE;
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_IDENTIFIER);
+  g_assert_cmpstr (g_scanner_cur_value (fix->scanner).v_identifier, ==, "baz");
+  g_assert_cmpint (g_scanner_get_next_token (fix->scanner), ==, G_TOKEN_EOF);
+
+  g_free (text);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -142,6 +188,7 @@ main (int   argc,
   g_test_add ("/scanner/error/subprocess", ScannerFixture, 0, scanner_fixture_setup, test_scanner_error_subprocess, scanner_fixture_teardown);
   g_test_add ("/scanner/symbols", ScannerFixture, 0, scanner_fixture_setup, test_scanner_symbols, scanner_fixture_teardown);
   g_test_add ("/scanner/tokens", ScannerFixture, 0, scanner_fixture_setup, test_scanner_tokens, scanner_fixture_teardown);
+  g_test_add ("/scanner/identifiers", ScannerFixture, 0, scanner_fixture_setup, test_scanner_identifiers, scanner_fixture_teardown);
 
   return g_test_run();
 }
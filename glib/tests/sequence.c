@@ -16,6 +16,7 @@ struct _GSequence
 struct _GSequenceNode
 {
   gint                  n_nodes;
+  guint                 is_end : 1;
   GSequenceNode *       parent;
   GSequenceNode *       left;
   GSequenceNode *       right;
@@ -70,6 +71,7 @@ g_sequence_check (GSequence *seq)
 
   g_assert (seq->end_node == node);
   g_assert (node->data == seq);
+  g_assert (node->is_end);
 
 }
 
@@ -1,3 +1,4 @@
+#include <string.h>
 #include <glib.h>
 
 /* We test deprecated functionality here */
@@ -16,6 +17,146 @@ test_slice_config (void)
   g_test_trap_assert_failed ();
 }
 
+static gint
+find_size_class (gsize chunk_size)
+{
+  gint n_classes = g_slice_get_config (G_SLICE_CONFIG_CHUNK_SIZES);
+  gint i;
+
+  for (i = 0; i < n_classes; i++)
+    {
+      gint64 *state;
+      guint n;
+      gboolean found;
+
+      state = g_slice_get_config_state (G_SLICE_CONFIG_STATISTICS, i, &n);
+      if (state == NULL)
+        return -1;
+      g_assert_cmpint (n, ==, 8);
+      found = state[0] == chunk_size;
+      g_free (state);
+
+      if (found)
+        return i;
+    }
+
+  return -1;
+}
+
+static void
+test_slice_statistics (void)
+{
+  gpointer chunks[1000];
+  gint64 *before, *after;
+  guint n;
+  gint ix;
+  gint i;
+
+  /* Allocate the chunk once so that it is the right size class */
+  g_slice_free1 (40, g_slice_alloc (40));
+  ix = find_size_class (((40 + 2 * sizeof (gsize) - 1) / (2 * sizeof (gsize))) * 2 * sizeof (gsize));
+  if (ix < 0)
+    {
+      g_test_message ("slice allocator disabled, skipping");
+      return;
+    }
+
+  before = g_slice_get_config_state (G_SLICE_CONFIG_STATISTICS, ix, &n);
+  for (i = 0; i < 1000; i++)
+    chunks[i] = g_slice_alloc (40);
+  after = g_slice_get_config_state (G_SLICE_CONFIG_STATISTICS, ix, &n);
+
+  g_assert_cmpint (after[1] - before[1], ==, 1000);   /* allocations */
+  g_assert_cmpint (after[2] - before[2], ==, 0);      /* frees */
+  g_assert_cmpint (after[4], >, before[4]);           /* magazine misses */
+  g_assert_cmpint (after[6], >, 0);                   /* slab pages */
+  g_assert_cmpint (after[7], >=, 0);                  /* wasted bytes */
+  g_free (before);
+  g_free (after);
+
+  before = g_slice_get_config_state (G_SLICE_CONFIG_STATISTICS, ix, &n);
+  for (i = 0; i < 1000; i++)
+    g_slice_free1 (40, chunks[i]);
+  after = g_slice_get_config_state (G_SLICE_CONFIG_STATISTICS, ix, &n);
+
+  g_assert_cmpint (after[1] - before[1], ==, 0);
+  g_assert_cmpint (after[2] - before[2], ==, 1000);
+  g_assert_cmpint (after[3] - before[3] + after[4] - before[4], ==, 1000);
+  g_free (before);
+  g_free (after);
+}
+
+static void
+test_slice_magazine_size (void)
+{
+  gint64 *state;
+  guint n;
+  gint ix;
+
+  ix = find_size_class (2 * 2 * sizeof (gsize));
+  if (ix < 0)
+    {
+      g_test_message ("slice allocator disabled, skipping");
+      return;
+    }
+
+  g_slice_set_config_state (G_SLICE_CONFIG_MAGAZINE_SIZE, ix, 100);
+  state = g_slice_get_config_state (G_SLICE_CONFIG_MAGAZINE_SIZE, ix, &n);
+  g_assert_cmpint (n, ==, 3);
+  g_assert_cmpint (state[1], ==, 100);
+  g_assert_cmpint (state[2], ==, 100);
+  g_free (state);
+
+  g_slice_set_config_state (G_SLICE_CONFIG_MAGAZINE_SIZE, ix, 0);
+  state = g_slice_get_config_state (G_SLICE_CONFIG_MAGAZINE_SIZE, ix, &n);
+  g_assert_cmpint (state[1], ==, 0);
+  g_assert_cmpint (state[2], >=, 4);
+  g_free (state);
+}
+
+static void
+test_slice_large_chunks_subprocess (void)
+{
+  gpointer chunks[200];
+  gpointer again;
+  gsize size;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (chunks); i++)
+    {
+      size = 1000 + i * 317;
+      chunks[i] = g_slice_alloc (size);
+      g_assert_cmpuint (GPOINTER_TO_SIZE (chunks[i]) % (2 * sizeof (gsize)), ==, 0);
+      memset (chunks[i], i, size);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (chunks); i++)
+    {
+      guint8 *bytes = chunks[i];
+
+      size = 1000 + i * 317;
+      g_assert_cmpuint (bytes[0], ==, i & 0xff);
+      g_assert_cmpuint (bytes[size - 1], ==, i & 0xff);
+      g_slice_free1 (size, chunks[i]);
+    }
+
+  /* freed chunks of a size class are handed out again */
+  chunks[0] = g_slice_alloc (20000);
+  g_slice_free1 (20000, chunks[0]);
+  again = g_slice_alloc (19999);
+  g_assert (again == chunks[0]);
+  g_slice_free1 (19999, again);
+}
+
+static void
+test_slice_large_chunks (void)
+{
+  g_setenv ("G_SLICE", "large-chunks", TRUE);
+  g_test_trap_subprocess ("/slice/large-chunks/subprocess", 0, 0);
+  g_unsetenv ("G_SLICE");
+  g_test_trap_assert_passed ();
+}
+
 int
 main (int argc, char **argv)
 {
@@ -31,6 +172,10 @@ main (int argc, char **argv)
 
   g_test_add_func ("/slice/config", test_slice_config);
   g_test_add_func ("/slice/config/subprocess", test_slice_config_subprocess);
+  g_test_add_func ("/slice/statistics", test_slice_statistics);
+  g_test_add_func ("/slice/magazine-size", test_slice_magazine_size);
+  g_test_add_func ("/slice/large-chunks", test_slice_large_chunks);
+  g_test_add_func ("/slice/large-chunks/subprocess", test_slice_large_chunks_subprocess);
 
   return g_test_run ();
 }
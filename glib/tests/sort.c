@@ -116,6 +116,48 @@ test_sort_big (void)
   g_free (data);
 }
 
+static void
+test_sort_patterns (void)
+{
+  SortItem *data;
+  gint n, i, pattern;
+
+  data = g_malloc (1000 * sizeof (SortItem));
+  for (n = 0; n <= 1000; n = n < 40 ? n + 1 : n * 2)
+    for (pattern = 0; pattern < 4; pattern++)
+      {
+        for (i = 0; i < n; i++)
+          {
+            switch (pattern)
+              {
+              case 0: /* sorted */
+                data[i].val = i;
+                break;
+              case 1: /* reversed */
+                data[i].val = n - i;
+                break;
+              case 2: /* few distinct values */
+                data[i].val = i % 3;
+                break;
+              default: /* sorted with a few random values appended */
+                data[i].val = i < n - 3 ? i : g_random_int_range (0, n);
+                break;
+              }
+            data[i].i = i;
+          }
+
+        g_qsort_with_data (data, n, sizeof (SortItem), item_compare_data, NULL);
+
+        for (i = 1; i < n; i++)
+          {
+            g_assert_cmpint (data[i -1].val, <=, data[i].val);
+            if (data[i -1].val == data[i].val)
+              g_assert_cmpint (data[i -1].i, <, data[i].i);
+          }
+      }
+  g_free (data);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -124,6 +166,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/sort/basic", test_sort_basic);
   g_test_add_func ("/sort/stable", test_sort_stable);
   g_test_add_func ("/sort/big", test_sort_big);
+  g_test_add_func ("/sort/patterns", test_sort_patterns);
 
   return g_test_run ();
 }
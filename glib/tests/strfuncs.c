@@ -808,6 +808,52 @@ test_strsplit (void)
   strv_check (g_strsplit (",,x,,y,,z,,", ",,", 2), "", "x,,y,,z,,", NULL);
 }
 
+static void
+strsplit_iter_check (const gchar *string,
+                     const gchar *delimiter,
+                     gint         max_tokens)
+{
+  GStrSplitIter iter;
+  const gchar *token;
+  gsize token_len;
+  gchar **strv;
+  guint i = 0;
+
+  strv = g_strsplit (string, delimiter, max_tokens);
+
+  g_strsplit_iter_init (&iter, string, delimiter, max_tokens);
+  while (g_strsplit_iter_next (&iter, &token, &token_len))
+    {
+      g_assert (strv[i] != NULL);
+      g_assert_cmpuint (token_len, ==, strlen (strv[i]));
+      g_assert (strncmp (token, strv[i], token_len) == 0);
+      g_assert (token >= string && token + token_len <= string + strlen (string));
+      i++;
+    }
+  g_assert (strv[i] == NULL);
+  g_assert (!g_strsplit_iter_next (&iter, &token, &token_len));
+
+  g_strfreev (strv);
+}
+
+static void
+test_strsplit_iter (void)
+{
+  const gchar *strings[] = { "", "x", "x,y", "x,y,", ",x,y,z,", ",,x,,y,,z,,",
+                             "a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r,s,t" };
+  const gchar *delimiters[] = { ",", ",,", "x" };
+  guint i, j;
+  gint max_tokens;
+
+  for (i = 0; i < G_N_ELEMENTS (strings); i++)
+    for (j = 0; j < G_N_ELEMENTS (delimiters); j++)
+      for (max_tokens = -1; max_tokens <= 4; max_tokens++)
+        strsplit_iter_check (strings[i], delimiters[j], max_tokens);
+
+  strv_check (g_strsplit ("a,b,c,d,e,f,g,h,i,j", ",", 0),
+              "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", NULL);
+}
+
 static void
 test_strsplit_set (void)
 {
@@ -1015,6 +1061,33 @@ test_strtod (void)
   check_strtod_number (-0.75, "%0.2f", "-0.75");
   check_strtod_number (-0.75, "%5.2f", "-0.75");
   check_strtod_number (1e99, "%.0e", "1e+99");
+
+  /* around the limits of the exact fast path */
+  check_strtod_string ("9007199254740993", 9007199254740992.0, FALSE, 0);
+  check_strtod_string ("9007199254740993e0", 9007199254740992.0, FALSE, 0);
+  check_strtod_string ("0.1", 0.1, FALSE, 0);
+  check_strtod_string ("1e22", 1e22, FALSE, 0);
+  check_strtod_string ("1e23", 1e23, FALSE, 0);
+  check_strtod_string ("1e-22", 1e-22, FALSE, 0);
+  check_strtod_string ("1e-23", 1e-23, FALSE, 0);
+  check_strtod_string ("0.000000000000000000000000000001", 1e-30, FALSE, 0);
+  check_strtod_string ("12345678901234567890.5", 12345678901234567890.5, FALSE, 0);
+  check_strtod_string ("2.5e", 2.5, TRUE, 3);
+  check_strtod_string ("2.5e+", 2.5, TRUE, 3);
+  check_strtod_string ("3.", 3.0, FALSE, 0);
+  check_strtod_string (".", 0.0, TRUE, 0);
+  check_strtod_string ("-", 0.0, TRUE, 0);
+  d = g_ascii_strtod ("-0", NULL);
+  g_assert (d == 0.0 && signbit (d));
+
+  /* integral values, which have their own formatting path */
+  g_assert_cmpstr (g_ascii_dtostr (buffer, sizeof (buffer), 0.0), ==, "0");
+  g_assert_cmpstr (g_ascii_dtostr (buffer, sizeof (buffer), -0.0), ==, "-0");
+  g_assert_cmpstr (g_ascii_dtostr (buffer, sizeof (buffer), -42.0), ==, "-42");
+  g_assert_cmpstr (g_ascii_dtostr (buffer, sizeof (buffer), 99999999999999984.0), ==, "99999999999999984");
+  g_assert_cmpstr (g_ascii_dtostr (buffer, sizeof (buffer), 1e17), ==, "1e+17");
+  g_assert_cmpstr (g_ascii_dtostr (buffer, sizeof (buffer), 0.5), ==, "0.5");
+  g_assert_cmpstr (g_ascii_dtostr (buffer, 3, 12345.0), ==, "12");
 }
 
 static void
@@ -1353,6 +1426,7 @@ main (int   argc,
   g_test_add_func ("/strfuncs/has-prefix", test_has_prefix);
   g_test_add_func ("/strfuncs/has-suffix", test_has_suffix);
   g_test_add_func ("/strfuncs/strsplit", test_strsplit);
+  g_test_add_func ("/strfuncs/strsplit-iter", test_strsplit_iter);
   g_test_add_func ("/strfuncs/strsplit-set", test_strsplit_set);
   g_test_add_func ("/strfuncs/strv-length", test_strv_length);
   g_test_add_func ("/strfuncs/strtod", test_strtod);
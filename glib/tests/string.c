@@ -75,6 +75,82 @@ test_string_chunk_insert (void)
   g_string_chunk_free (chunk);
 }
 
+static void
+test_string_chunk_reset (void)
+{
+  GStringChunk *chunk;
+  gchar *first = NULL, *str, *long_str;
+  gchar *name;
+  gint round, i;
+
+  chunk = g_string_chunk_new (64);
+  long_str = g_strnfill (200, 'x');
+
+  for (round = 0; round < 3; round++)
+    {
+      for (i = 0; i < 100; i++)
+        {
+          name = g_strdup_printf ("name-%d", i);
+          str = g_string_chunk_insert_const (chunk, name);
+          if (i == 0)
+            {
+              /* reset storage is reused */
+              if (round > 0)
+                g_assert (str == first);
+              first = str;
+            }
+          g_assert_cmpstr (str, ==, name);
+          g_assert (g_string_chunk_insert_const (chunk, name) == str);
+          g_free (name);
+        }
+
+      str = g_string_chunk_insert (chunk, long_str);
+      g_assert_cmpstr (str, ==, long_str);
+
+      g_string_chunk_reset (chunk);
+    }
+
+  g_free (long_str);
+  g_string_chunk_free (chunk);
+}
+
+static void
+test_string_chunk_insert_many (void)
+{
+  const gchar *strings[] = { "one", "two\0three", "", "four" };
+  const gssize lengths[] = { -1, 9, 0, 2 };
+  gchar *long_strings[20];
+  gchar *results[20];
+  GStringChunk *chunk;
+  gint i;
+
+  chunk = g_string_chunk_new (32);
+
+  g_string_chunk_insert_len_many (chunk, strings, NULL, 4, results);
+  g_assert_cmpstr (results[0], ==, "one");
+  g_assert_cmpstr (results[1], ==, "two");
+  g_assert_cmpstr (results[2], ==, "");
+  g_assert_cmpstr (results[3], ==, "four");
+
+  g_string_chunk_insert_len_many (chunk, strings, lengths, 4, results);
+  g_assert_cmpstr (results[0], ==, "one");
+  g_assert (memcmp (results[1], "two\0three", 10) == 0);
+  g_assert_cmpstr (results[2], ==, "");
+  g_assert_cmpstr (results[3], ==, "fo");
+
+  /* more than fits in a block */
+  for (i = 0; i < 20; i++)
+    long_strings[i] = g_strdup_printf ("string number %d", i);
+  g_string_chunk_insert_len_many (chunk, (const gchar **) long_strings, NULL, 20, results);
+  for (i = 0; i < 20; i++)
+    {
+      g_assert_cmpstr (results[i], ==, long_strings[i]);
+      g_free (long_strings[i]);
+    }
+
+  g_string_chunk_free (chunk);
+}
+
 static void
 test_string_new (void)
 {
@@ -495,6 +571,34 @@ test_string_to_bytes (void)
   g_bytes_unref (bytes);
 }
 
+static void
+test_string_printf_long (void)
+{
+  GString *string;
+  gchar *long_str;
+
+  long_str = g_strnfill (1000, 'x');
+
+  string = g_string_new ("a");
+  g_string_append_printf (string, "%s%d", long_str, 5);
+  g_assert_cmpint (string->len, ==, 1002);
+  g_assert_cmpint (string->str[0], ==, 'a');
+  g_assert_cmpint (string->str[1000], ==, 'x');
+  g_assert_cmpint (string->str[1001], ==, '5');
+
+  /* the arguments may point into the string itself */
+  g_string_printf (string, "%s", "abc");
+  g_string_append_printf (string, "-%s-", string->str);
+  g_assert_cmpstr (string->str, ==, "abc-abc-");
+
+  g_string_append_printf (string, "%s%s", long_str, string->str);
+  g_assert_cmpint (string->len, ==, 8 + 1000 + 8);
+  g_assert (g_str_has_suffix (string->str, "xabc-abc-"));
+
+  g_string_free (string, TRUE);
+  g_free (long_str);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -503,6 +607,8 @@ main (int   argc,
 
   g_test_add_func ("/string/test-string-chunks", test_string_chunks);
   g_test_add_func ("/string/test-string-chunk-insert", test_string_chunk_insert);
+  g_test_add_func ("/string/test-string-chunk-reset", test_string_chunk_reset);
+  g_test_add_func ("/string/test-string-chunk-insert-many", test_string_chunk_insert_many);
   g_test_add_func ("/string/test-string-new", test_string_new);
   g_test_add_func ("/string/test-string-printf", test_string_printf);
   g_test_add_func ("/string/test-string-assign", test_string_assign);
@@ -519,6 +625,7 @@ main (int   argc,
   g_test_add_func ("/string/test-string-up-down", test_string_up_down);
   g_test_add_func ("/string/test-string-set-size", test_string_set_size);
   g_test_add_func ("/string/test-string-to-bytes", test_string_to_bytes);
+  g_test_add_func ("/string/test-string-printf-long", test_string_printf_long);
 
   return g_test_run();
 }
@@ -85,6 +85,18 @@ test_timer (void)
   g_test_maximized_result (5, "bogus-quantity: %ddummies", 5); /* simple API test */
 }
 
+static void
+bench_checksum (guint64       n_iterations,
+                gconstpointer data)
+{
+  guint64 i;
+
+  g_assert_cmpuint (n_iterations, >, 0);
+
+  for (i = 0; i < n_iterations; i++)
+    g_free (g_compute_checksum_for_string (G_CHECKSUM_SHA1, data, -1));
+}
+
 #ifdef G_OS_UNIX
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 
@@ -579,6 +591,7 @@ main (int   argc,
   g_test_add ("/misc/primetoul", Fixturetest, (void*) 0xc0cac01a, fixturetest_setup, fixturetest_test, fixturetest_teardown);
   if (g_test_perf())
     g_test_add_func ("/misc/timer", test_timer);
+  g_test_add_bench ("/misc/bench", "hello world", bench_checksum);
 
 #ifdef G_OS_UNIX
   g_test_add_func ("/forking/fail assertion", test_fork_fail);
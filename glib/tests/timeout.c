@@ -1,4 +1,7 @@
+#include "config.h"
+
 #include <glib.h>
+#include <string.h>
 #include <unistd.h>
 
 static GMainLoop *loop;
@@ -96,6 +99,160 @@ test_rounding (void)
   g_main_loop_unref (loop);
 }
 
+static gboolean
+record_time (gpointer data)
+{
+  gint64 *fired = data;
+
+  *fired = g_get_monotonic_time ();
+
+  return G_SOURCE_REMOVE;
+}
+
+static gint timerfd_polls;
+static gint timed_polls;
+
+#ifdef HAVE_TIMERFD
+static gboolean
+is_timerfd (gint fd)
+{
+  gchar *path, target[64];
+  gssize len;
+
+  path = g_strdup_printf ("/proc/self/fd/%d", fd);
+  len = readlink (path, target, sizeof target - 1);
+  g_free (path);
+
+  if (len < 0)
+    return FALSE;
+  target[len] = '\0';
+
+  return strcmp (target, "anon_inode:[timerfd]") == 0;
+}
+#endif
+
+static gint
+seconds_poll (GPollFD *ufds,
+              guint    nfds,
+              gint     timeout)
+{
+  if (timeout >= 0)
+    g_atomic_int_inc (&timed_polls);
+#ifdef HAVE_TIMERFD
+  else
+    {
+      guint i;
+
+      for (i = 0; i < nfds; i++)
+        if (is_timerfd (ufds[i].fd))
+          {
+            g_atomic_int_inc (&timerfd_polls);
+            break;
+          }
+    }
+#endif
+
+  return g_poll (ufds, nfds, timeout);
+}
+
+static gpointer
+run_context (gpointer data)
+{
+  GMainContext *context = data;
+  gint64 fired = 0;
+  GSource *source;
+
+  g_main_context_set_poll_func (context, seconds_poll);
+
+  source = g_timeout_source_new_seconds (1);
+  g_source_set_callback (source, record_time, &fired, NULL);
+  g_source_attach (source, context);
+  g_source_unref (source);
+
+  while (fired == 0)
+    g_main_context_iteration (context, TRUE);
+
+  return g_memdup (&fired, sizeof fired);
+}
+
+static void
+test_seconds_contexts (void)
+{
+  GMainContext *contexts[2];
+  GThread *threads[2];
+  gint64 *fired[2];
+  gint64 phase;
+  gint i;
+
+  /* Seconds timeouts in different contexts all land on the same
+   * point within the second, whether they are woken by the poll
+   * timeout or by a timer of their own.
+   */
+  for (i = 0; i < 2; i++)
+    {
+      contexts[i] = g_main_context_new ();
+      threads[i] = g_thread_new ("seconds", run_context, contexts[i]);
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      fired[i] = g_thread_join (threads[i]);
+      g_main_context_unref (contexts[i]);
+    }
+
+  phase = ABS (*fired[0] - *fired[1]) % 1000000;
+  g_assert_cmpint (MIN (phase, 1000000 - phase), <, 250000);
+
+  /* Where there is a timerfd, the contexts wait on it rather than on a
+   * poll timeout.
+   */
+#ifdef HAVE_TIMERFD
+  g_assert_cmpint (timerfd_polls, >, 0);
+  g_assert_cmpint (timed_polls, ==, 0);
+#else
+  g_assert_cmpint (timed_polls, >, 0);
+#endif
+
+  g_free (fired[0]);
+  g_free (fired[1]);
+}
+
+static gboolean
+check_coarse_time (gpointer data)
+{
+  GSource *source = g_main_current_source ();
+  gint64 *before = data;
+  gint64 coarse;
+
+  coarse = g_source_get_coarse_time (source);
+  g_assert_cmpint (coarse, >=, *before - 100000);
+  g_assert_cmpint (coarse, <=, g_get_monotonic_time ());
+  g_assert_cmpint (g_source_get_coarse_time (source), ==, coarse);
+
+  *before = -1;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_coarse_time (void)
+{
+  gint64 before;
+  gint64 coarse;
+
+  /* The coarse clock shares the base of the fine one and lags by no
+   * more than a tick.
+   */
+  before = g_get_monotonic_time ();
+  coarse = g_get_coarse_monotonic_time ();
+  g_assert_cmpint (coarse, >=, before - 100000);
+  g_assert_cmpint (coarse, <=, g_get_monotonic_time ());
+
+  g_timeout_add_seconds (1, check_coarse_time, &before);
+  while (before != -1)
+    g_main_context_iteration (NULL, TRUE);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -103,6 +260,8 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/timeout/seconds", test_seconds);
   g_test_add_func ("/timeout/rounding", test_rounding);
+  g_test_add_func ("/timeout/seconds-contexts", test_seconds_contexts);
+  g_test_add_func ("/timeout/coarse-time", test_coarse_time);
 
   return g_test_run ();
 }
@@ -339,6 +339,113 @@ test_tree_traverse (void)
   g_free (result);
 }
 
+static gint
+int_compare (gconstpointer a,
+             gconstpointer b,
+             gpointer      user_data)
+{
+  return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
+}
+
+static gboolean
+collect_func (gpointer key, gpointer value, gpointer data)
+{
+  GArray *array = data;
+
+  g_array_append_val (array, key);
+
+  return array->len == 5;
+}
+
+static void
+test_tree_from_sorted (void)
+{
+  gpointer keys[100], values[100];
+  GArray *visited;
+  GTree *tree;
+  gint n, i, height;
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+      keys[i] = GINT_TO_POINTER (2 * i + 2);
+      values[i] = GINT_TO_POINTER (-i);
+    }
+
+  visited = g_array_new (FALSE, FALSE, sizeof (gpointer));
+
+  for (n = 0; n <= G_N_ELEMENTS (keys); n++)
+    {
+      tree = g_tree_new_from_sorted (int_compare, NULL, NULL, NULL, keys, values, n);
+      g_assert_cmpint (g_tree_nnodes (tree), ==, n);
+
+      /* the tree is as flat as possible */
+      for (height = 0; (1 << height) <= n; height++);
+      g_assert_cmpint (g_tree_height (tree), ==, height);
+
+      for (i = 0; i < n; i++)
+        {
+          g_assert (g_tree_lookup (tree, keys[i]) == values[i]);
+          g_assert (g_tree_lookup (tree, GINT_TO_POINTER (2 * i + 1)) == NULL);
+        }
+
+      /* the threading between nodes survives modifications */
+      for (i = 0; i < n; i += 3)
+        g_assert (g_tree_remove (tree, keys[i]));
+      g_tree_insert (tree, GINT_TO_POINTER (1), NULL);
+      g_tree_insert (tree, GINT_TO_POINTER (1000), NULL);
+
+      g_array_set_size (visited, 0);
+      g_tree_foreach_from (tree, GINT_TO_POINTER (2), collect_func, visited);
+      for (i = 1; i < visited->len; i++)
+        g_assert_cmpint (GPOINTER_TO_INT (g_array_index (visited, gpointer, i - 1)), <,
+                         GPOINTER_TO_INT (g_array_index (visited, gpointer, i)));
+      g_assert_cmpint (g_tree_nnodes (tree), ==, n - (n + 2) / 3 + 2);
+
+      g_tree_unref (tree);
+    }
+
+  g_array_free (visited, TRUE);
+}
+
+static void
+test_tree_foreach_from (void)
+{
+  gpointer keys[20];
+  GArray *visited;
+  GTree *tree;
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    keys[i] = GINT_TO_POINTER (10 * i);
+
+  tree = g_tree_new_from_sorted (int_compare, NULL, NULL, NULL, keys, NULL, G_N_ELEMENTS (keys));
+  visited = g_array_new (FALSE, FALSE, sizeof (gpointer));
+
+  /* between two keys */
+  g_tree_foreach_from (tree, GINT_TO_POINTER (35), collect_func, visited);
+  g_assert_cmpint (visited->len, ==, 5);
+  for (i = 0; i < 5; i++)
+    g_assert_cmpint (GPOINTER_TO_INT (g_array_index (visited, gpointer, i)), ==, 40 + 10 * i);
+
+  /* on a key */
+  g_array_set_size (visited, 0);
+  g_tree_foreach_from (tree, GINT_TO_POINTER (170), collect_func, visited);
+  g_assert_cmpint (visited->len, ==, 3);
+  g_assert_cmpint (GPOINTER_TO_INT (g_array_index (visited, gpointer, 0)), ==, 170);
+
+  /* before the first and after the last key */
+  g_array_set_size (visited, 0);
+  g_tree_foreach_from (tree, GINT_TO_POINTER (-5), collect_func, visited);
+  g_assert_cmpint (GPOINTER_TO_INT (g_array_index (visited, gpointer, 0)), ==, 0);
+
+  g_array_set_size (visited, 0);
+  g_tree_foreach_from (tree, GINT_TO_POINTER (191), collect_func, visited);
+  g_assert_cmpint (visited->len, ==, 0);
+
+  g_array_free (visited, TRUE);
+  g_tree_unref (tree);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -348,6 +455,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/tree/remove", test_tree_remove);
   g_test_add_func ("/tree/destroy", test_tree_destroy);
   g_test_add_func ("/tree/traverse", test_tree_traverse);
+  g_test_add_func ("/tree/from-sorted", test_tree_from_sorted);
+  g_test_add_func ("/tree/foreach-from", test_tree_foreach_from);
 
   return g_test_run ();
 }
@@ -25,6 +25,8 @@
 /* We are testing some deprecated APIs here */
 #define GLIB_DISABLE_DEPRECATION_WARNINGS
 
+#include <string.h>
+
 #include "glib.h"
 
 static void
@@ -140,6 +142,33 @@ test_unichar_break_type (void)
     }
 }
 
+static void
+test_utf8_break_types (void)
+{
+  const gchar *str = "a (\xc2\xa0\xe2\x80\x94\xf0\x9f\x87\xb6 1)\n";
+  GUnicodeBreakType types[16];
+  const gchar *p;
+  gsize n, i;
+
+  n = g_utf8_get_break_types (str, -1, types);
+  g_assert_cmpuint (n, ==, g_utf8_strlen (str, -1));
+
+  for (p = str, i = 0; *p; p = g_utf8_next_char (p), i++)
+    g_assert_cmpint (types[i], ==, g_unichar_break_type (g_utf8_get_char (p)));
+  g_assert_cmpuint (i, ==, n);
+
+  /* a partial character at the end is not classified */
+  n = g_utf8_get_break_types (str, 7, types);
+  g_assert_cmpuint (n, ==, 4);
+  g_assert_cmpint (types[3], ==, G_UNICODE_BREAK_NON_BREAKING_GLUE);
+
+  n = g_utf8_get_break_types (str, strlen (str), types);
+  g_assert_cmpuint (n, ==, g_utf8_strlen (str, -1));
+  g_assert_cmpint (types[n - 1], ==, G_UNICODE_BREAK_LINE_FEED);
+
+  g_assert_cmpuint (g_utf8_get_break_types (NULL, 0, NULL), ==, 0);
+}
+
 static void
 test_unichar_script (void)
 {
@@ -680,6 +709,151 @@ test_fully_decompose_len (void)
   }
 }
 
+static void
+test_normalize (void)
+{
+  const struct {
+    const gchar *str;
+    gssize len;
+    GNormalizeMode mode;
+    const gchar *expected;
+  } tests[] = {
+    /* already normalized, returned as a copy */
+    { "plain ascii", -1, G_NORMALIZE_NFC, "plain ascii" },
+    { "plain ascii", 5, G_NORMALIZE_NFD, "plain" },
+    { "d\xc3\xa9j\xc3\xa0 vu", -1, G_NORMALIZE_NFC, "d\xc3\xa9j\xc3\xa0 vu" },
+    { "e\xcc\x81", -1, G_NORMALIZE_NFD, "e\xcc\x81" },
+    { "\xea\xb0\x81", -1, G_NORMALIZE_NFC, "\xea\xb0\x81" },
+    { "\xc2\xa0", -1, G_NORMALIZE_NFC, "\xc2\xa0" },
+    /* composes with the preceding starter */
+    { "e\xcc\x81", -1, G_NORMALIZE_NFC, "\xc3\xa9" },
+    { "\xc3\xaa\xcc\x81", -1, G_NORMALIZE_NFC, "\xe1\xba\xbf" },
+    { "\xe1\x84\x80\xe1\x85\xa1", -1, G_NORMALIZE_NFC, "\xea\xb0\x80" },
+    { "\xea\xb0\x80\xe1\x86\xa8", -1, G_NORMALIZE_NFC, "\xea\xb0\x81" },
+    { "\xe0\xad\x87\xe0\xac\xbe", -1, G_NORMALIZE_NFC, "\xe0\xad\x8b" },
+    { "\xe1\xac\x85\xe1\xac\xb5", -1, G_NORMALIZE_NFC, "\xe1\xac\x86" },
+    /* needs reordering */
+    { "\xc3\xa9\xcc\xa3", -1, G_NORMALIZE_NFC, "\xe1\xba\xb9\xcc\x81" },
+    { "a\xcc\x81\xcc\xa3", -1, G_NORMALIZE_NFD, "a\xcc\xa3\xcc\x81" },
+    /* decomposes */
+    { "\xc3\xa9", -1, G_NORMALIZE_NFD, "e\xcc\x81" },
+    { "\xc2\xa0", -1, G_NORMALIZE_NFKD, " " },
+    { "\xef\xac\x81", -1, G_NORMALIZE_NFKC, "fi" },
+    { "\xe2\x84\xab", -1, G_NORMALIZE_NFC, "\xc3\x85" },
+    /* invalid */
+    { "abc\xff", -1, G_NORMALIZE_NFC, NULL },
+  };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      gchar *normalized;
+
+      normalized = g_utf8_normalize (tests[i].str, tests[i].len, tests[i].mode);
+      g_assert_cmpstr (normalized, ==, tests[i].expected);
+      g_free (normalized);
+    }
+}
+
+static void
+test_strup_strdown_ascii (void)
+{
+  gchar ascii[300];
+  gchar *str, *expected;
+  gint i;
+
+  /* long enough for whole words, with the letters at every offset */
+  for (i = 0; i < G_N_ELEMENTS (ascii) - 1; i++)
+    ascii[i] = 1 + i % 127;
+  ascii[i] = '\0';
+
+  for (i = 0; i < 16; i++)
+    {
+      str = g_utf8_strup (ascii + i, -1);
+      expected = g_ascii_strup (ascii + i, -1);
+      g_assert_cmpstr (str, ==, expected);
+      g_free (str);
+      g_free (expected);
+
+      str = g_utf8_strdown (ascii + i, -1);
+      expected = g_ascii_strdown (ascii + i, -1);
+      g_assert_cmpstr (str, ==, expected);
+      g_free (str);
+
+      str = g_utf8_casefold (ascii + i, -1);
+      g_assert_cmpstr (str, ==, expected);
+      g_free (str);
+      g_free (expected);
+
+      str = g_utf8_strdown (ascii, 20 + i);
+      expected = g_ascii_strdown (ascii, 20 + i);
+      g_assert_cmpstr (str, ==, expected);
+      g_free (str);
+      g_free (expected);
+    }
+
+  str = g_utf8_strup ("abcdefgh\xc3\xa9ijklmnopqrst\xc3\x9fuvwxyz", -1);
+  g_assert_cmpstr (str, ==, "ABCDEFGH\xc3\x89IJKLMNOPQRSTSSUVWXYZ");
+  g_free (str);
+  str = g_utf8_strdown ("ABCDEFGH\xc3\x89IJKLMNOPQRST\xce\xa3 UVWXYZ", -1);
+  g_assert_cmpstr (str, ==, "abcdefgh\xc3\xa9ijklmnopqrst\xcf\x82 uvwxyz");
+  g_free (str);
+  str = g_utf8_casefold ("ABCDEFGH\xc3\x89IJKLMNOPQRST\xc3\x9fUVWXYZ", -1);
+  g_assert_cmpstr (str, ==, "abcdefgh\xc3\xa9ijklmnopqrstssuvwxyz");
+  g_free (str);
+}
+
+static void
+test_case_in_place (void)
+{
+  gchar *str;
+
+  str = g_strdup ("Hello W\xc3\xb6rld, \xce\xa3\xce\xb5");
+  g_assert (g_utf8_strup_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "HELLO W\xc3\x96RLD, \xce\xa3\xce\x95");
+  g_assert (g_utf8_strdown_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "hello w\xc3\xb6rld, \xcf\x83\xce\xb5");
+  g_free (str);
+
+  str = g_strdup ("ABC DEF");
+  g_assert (g_utf8_strdown_in_place (str, 3));
+  g_assert_cmpstr (str, ==, "abc DEF");
+  g_assert (g_utf8_casefold_in_place (str + 4, -1));
+  g_assert_cmpstr (str, ==, "abc def");
+  g_free (str);
+
+  /* sharp s maps to "SS" and "ss", which is still two bytes */
+  str = g_strdup ("stra\xc3\x9f" "e");
+  g_assert (g_utf8_strup_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "STRASSE");
+  g_free (str);
+  str = g_strdup ("stra\xc3\x9f" "e");
+  g_assert (g_utf8_casefold_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "strasse");
+  g_free (str);
+
+  /* the length of a character changes, so nothing is converted;
+   * U+0149 uppercases to U+02BC U+004E and U+0130 casefolds to
+   * U+0069 U+0307 */
+  str = g_strdup ("abc\xc5\x89\xc4\xb0");
+  g_assert (!g_utf8_strup_in_place (str, -1));
+  g_assert (!g_utf8_casefold_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "abc\xc5\x89\xc4\xb0");
+  g_free (str);
+
+  /* U+023A LATIN CAPITAL LETTER A WITH STROKE lowercases to 3 bytes */
+  str = g_strdup ("\xc8\xba");
+  g_assert (!g_utf8_strdown_in_place (str, -1));
+  g_assert (!g_utf8_casefold_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "\xc8\xba");
+  g_free (str);
+
+  str = g_strdup ("\xc3\x85ngstr\xc3\xb6m");
+  g_assert (g_utf8_casefold_in_place (str, -1));
+  g_assert_cmpstr (str, ==, "\xc3\xa5ngstr\xc3\xb6m");
+  g_free (str);
+}
+
 static void
 test_iso15924 (void)
 {
@@ -839,6 +1013,7 @@ main (int   argc,
   g_test_add_func ("/unicode/validate", test_unichar_validate);
   g_test_add_func ("/unicode/character-type", test_unichar_character_type);
   g_test_add_func ("/unicode/break-type", test_unichar_break_type);
+  g_test_add_func ("/unicode/utf8-break-types", test_utf8_break_types);
   g_test_add_func ("/unicode/script", test_unichar_script);
   g_test_add_func ("/unicode/combining-class", test_combining_class);
   g_test_add_func ("/unicode/mirror", test_mirror);
@@ -853,8 +1028,11 @@ main (int   argc,
   g_test_add_func ("/unicode/canonical-decomposition", test_canonical_decomposition);
   g_test_add_func ("/unicode/decompose-tail", test_decompose_tail);
   g_test_add_func ("/unicode/fully-decompose-len", test_fully_decompose_len);
+  g_test_add_func ("/unicode/normalize", test_normalize);
   g_test_add_func ("/unicode/iso15924", test_iso15924);
   g_test_add_func ("/unicode/cases", test_cases);
+  g_test_add_func ("/unicode/strup-strdown-ascii", test_strup_strdown_ascii);
+  g_test_add_func ("/unicode/case-in-place", test_case_in_place);
 
   return g_test_run();
 }
@@ -81,6 +81,23 @@ test_length (void)
   g_assert (g_utf8_strlen (longline, strlen (longline)) == 762);
   g_assert (g_utf8_strlen (longline, 1024) == 762);
 
+  /* every prefix, including those that end inside a character */
+  {
+    const gchar *p = longline;
+    glong n = 0;
+    gsize i;
+
+    for (i = 0; i < strlen (longline); i++)
+      {
+        if (g_utf8_next_char (p) - longline <= (gssize) i)
+          {
+            p = g_utf8_next_char (p);
+            n++;
+          }
+        g_assert_cmpint (g_utf8_strlen (longline, i), ==, n);
+      }
+  }
+
   g_assert (g_utf8_strlen (NULL, 0) == 0);
 
   g_assert (g_utf8_strlen ("a\340\250\201c", -1) == 3);
@@ -18,6 +18,7 @@
  */
 
 #include "glib.h"
+#include <string.h>
 
 #define UNICODE_VALID(Char)                   \
     ((Char) < 0x110000 &&                     \
@@ -284,6 +285,149 @@ do_test (gconstpointer d)
   g_assert (end - test->text == test->offset);
 }
 
+/* a straightforward validator to compare with, following the same
+ * rules: no overlong forms, surrogates or values above 0x10FFFF
+ */
+static const gchar *
+reference_validate (const gchar *str,
+                    gsize        len)
+{
+  const guchar *p = (const guchar *) str;
+  const guchar *end = p + len;
+
+  while (p < end && *p)
+    {
+      gunichar c, min;
+      gsize n, i;
+
+      if (*p < 0x80)
+        {
+          p++;
+          continue;
+        }
+      else if ((*p & 0xe0) == 0xc0)
+        {
+          n = 1;
+          c = *p & 0x1f;
+          min = 0x80;
+        }
+      else if ((*p & 0xf0) == 0xe0)
+        {
+          n = 2;
+          c = *p & 0x0f;
+          min = 0x800;
+        }
+      else if ((*p & 0xf8) == 0xf0)
+        {
+          n = 3;
+          c = *p & 0x07;
+          min = 0x10000;
+        }
+      else
+        break;
+
+      if (end - p <= n)
+        break;
+
+      for (i = 1; i <= n; i++)
+        {
+          if ((p[i] & 0xc0) != 0x80)
+            return (const gchar *) p;
+          c = (c << 6) | (p[i] & 0x3f);
+        }
+
+      if (c < min || c > 0x10ffff || (c >= 0xd800 && c < 0xe000))
+        break;
+
+      p += n + 1;
+    }
+
+  return (const gchar *) p;
+}
+
+static void
+check_against_reference (const gchar *str,
+                         gsize        len)
+{
+  const gchar *expected, *end;
+  gboolean valid;
+
+  expected = reference_validate (str, len);
+  valid = g_utf8_validate (str, len, &end);
+  g_assert (end == expected);
+  g_assert (valid == (end == str + len));
+
+  /* and as a nul-terminated string, if it is one */
+  if (memchr (str, '\0', len) == NULL)
+    {
+      gchar *copy = g_strndup (str, len);
+
+      valid = g_utf8_validate (copy, -1, &end);
+      g_assert (end - copy == expected - str);
+      g_assert (valid == (end == copy + len));
+      g_free (copy);
+    }
+}
+
+/* Long strings, which are validated in bulk where possible, with
+ * invalid sequences at every position of the blocks.
+ */
+static void
+test_bulk (void)
+{
+  const gchar *valid_pieces[] = {
+    "a", "The quick brown fox ", "\xc3\xa9", "\xe2\x82\xac",
+    "\xf0\x9d\x84\x9e", "\xef\xbf\xbf", "\xf4\x8f\xbf\xbf", "\xed\x9f\xbf"
+  };
+  const gchar *invalid_pieces[] = {
+    "\x80", "\xbf\xbf", "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xe0\x9f\xbf",
+    "\xed\xa0\x80", "\xed\xbf\xbf", "\xf0\x80\x80\x80", "\xf0\x8f\xbf\xbf",
+    "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xff",
+    "\xc3", "\xe2\x82", "\xf0\x9d\x84", "\xc3" "a", "\xe2\x82" "a", "\xf0\x9d\x84" "a",
+    "\xc3\xa9\xa9", "\0"
+  };
+  GString *s;
+  guint i, j, k;
+
+  s = g_string_new (NULL);
+
+  for (i = 0; i < 2000; i++)
+    {
+      gint n_pieces = g_test_rand_int_range (1, 40);
+
+      g_string_truncate (s, 0);
+      for (j = 0; j < n_pieces; j++)
+        {
+          if (g_test_rand_int_range (0, 30) == 0)
+            {
+              /* the NUL piece is one byte long */
+              k = g_test_rand_int_range (0, G_N_ELEMENTS (invalid_pieces));
+              g_string_append_len (s, invalid_pieces[k], MAX (1, strlen (invalid_pieces[k])));
+            }
+          else
+            g_string_append (s, valid_pieces[g_test_rand_int_range (0, G_N_ELEMENTS (valid_pieces))]);
+        }
+
+      check_against_reference (s->str, s->len);
+    }
+
+  /* every pair of bytes after a lead byte, at every offset in a block */
+  for (i = 0; i < 16; i++)
+    for (j = 0x80; j < 0x100; j++)
+      for (k = 0; k < 0x100; k++)
+        {
+          g_string_truncate (s, 0);
+          g_string_append_len (s, "0123456789abcdef", i);
+          g_string_append_c (s, j);
+          g_string_append_c (s, k);
+          g_string_append (s, "\xe2\x82\xac" "0123456789abcdef0123456789abcdef");
+
+          check_against_reference (s->str, s->len);
+        }
+
+  g_string_free (s, TRUE);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -299,5 +443,7 @@ main (int argc, char *argv[])
       g_free (path);
     }
 
+  g_test_add_func ("/utf8/validate/bulk", test_bulk);
+
   return g_test_run ();
 }
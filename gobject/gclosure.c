@@ -1061,6 +1061,28 @@ _g_closure_is_void (GClosure *closure,
   return FALSE;
 }
 
+/* If @closure calls the class member at some offset in the instance's
+ * class, as made by g_signal_type_cclosure_new(), store that offset.
+ */
+gboolean
+_g_closure_get_class_offset (GClosure *closure,
+                             guint    *offset)
+{
+  GRealClosure *real_closure;
+
+  if (closure->is_invalid)
+    return FALSE;
+
+  real_closure = G_REAL_CLOSURE (closure);
+
+  if (real_closure->meta_marshal != g_type_class_meta_marshal)
+    return FALSE;
+
+  *offset = GPOINTER_TO_UINT (real_closure->meta_marshal_data);
+
+  return TRUE;
+}
+
 static void
 g_type_iface_meta_marshalv (GClosure *closure,
 			    GValue   *return_value,
@@ -0,0 +1,359 @@
+/* GObject - GLib Type, Object, Parameter and Signal Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include "gmarshal-internal.h"
+#include "gobject.h"
+#include "gboxed.h"
+#include "genums.h"
+#include "gsignal.h"
+#include "gvaluetypes.h"
+
+/* Marshallers for signals whose arguments are all pointers (strings,
+ * objects, boxed types, ...) or int-sized integers (booleans, ints,
+ * enums, flags), and which return nothing or a boolean.
+ *
+ * To the C calling convention these are just two kinds of argument, so
+ * a handful of call shapes covers every such signal with up to
+ * MAX_WORD_PARAMS arguments.  g_signal_newv() uses them instead of the
+ * libffi based generic marshaller, and they come with a va_list
+ * variant so that emission doesn't need to box the arguments.
+ */
+
+#define MAX_WORD_PARAMS 3
+
+typedef union
+{
+  gpointer p;
+  gint     i;
+} Word;
+
+static gboolean
+word_is_int (GType type)
+{
+  switch (G_TYPE_FUNDAMENTAL (type & ~G_SIGNAL_TYPE_STATIC_SCOPE))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+word_is_pointer (GType type)
+{
+  type &= ~G_SIGNAL_TYPE_STATIC_SCOPE;
+
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_STRING:
+    case G_TYPE_POINTER:
+    case G_TYPE_BOXED:
+    case G_TYPE_PARAM:
+    case G_TYPE_OBJECT:
+    case G_TYPE_VARIANT:
+      return TRUE;
+    case G_TYPE_INTERFACE:
+      return g_type_is_a (type, G_TYPE_OBJECT);
+    default:
+      return FALSE;
+    }
+}
+
+gboolean
+_g_cclosure_marshal_words_supported (GType        return_type,
+                                     guint        n_params,
+                                     const GType *param_types)
+{
+  guint i;
+
+  return_type &= ~G_SIGNAL_TYPE_STATIC_SCOPE;
+  if (return_type != G_TYPE_NONE && return_type != G_TYPE_BOOLEAN)
+    return FALSE;
+
+  if (n_params > MAX_WORD_PARAMS)
+    return FALSE;
+
+  for (i = 0; i < n_params; i++)
+    if (!word_is_int (param_types[i]) && !word_is_pointer (param_types[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Take the same references that collecting the argument into a GValue
+ * would, like the other va_list marshallers do.
+ */
+static gpointer
+word_pointer_ref (GType    type,
+                  gpointer arg)
+{
+  gboolean static_scope = (type & G_SIGNAL_TYPE_STATIC_SCOPE) != 0;
+
+  type &= ~G_SIGNAL_TYPE_STATIC_SCOPE;
+  if (arg == NULL)
+    return NULL;
+
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_OBJECT:
+    case G_TYPE_INTERFACE:
+      return g_object_ref (arg);
+    case G_TYPE_STRING:
+      return static_scope ? arg : g_strdup (arg);
+    case G_TYPE_BOXED:
+      return static_scope ? arg : g_boxed_copy (type, arg);
+    case G_TYPE_PARAM:
+      return static_scope ? arg : g_param_spec_ref (arg);
+    case G_TYPE_VARIANT:
+      return static_scope ? arg : g_variant_ref_sink (arg);
+    default:
+      return arg;
+    }
+}
+
+static void
+word_pointer_unref (GType    type,
+                    gpointer arg)
+{
+  gboolean static_scope = (type & G_SIGNAL_TYPE_STATIC_SCOPE) != 0;
+
+  type &= ~G_SIGNAL_TYPE_STATIC_SCOPE;
+  if (arg == NULL)
+    return;
+
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_OBJECT:
+    case G_TYPE_INTERFACE:
+      g_object_unref (arg);
+      break;
+    case G_TYPE_STRING:
+      if (!static_scope)
+        g_free (arg);
+      break;
+    case G_TYPE_BOXED:
+      if (!static_scope)
+        g_boxed_free (type, arg);
+      break;
+    case G_TYPE_PARAM:
+      if (!static_scope)
+        g_param_spec_unref (arg);
+      break;
+    case G_TYPE_VARIANT:
+      if (!static_scope)
+        g_variant_unref (arg);
+      break;
+    default:
+      break;
+    }
+}
+
+static gint
+word_value_get_int (const GValue *value)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      return g_value_get_boolean (value);
+    case G_TYPE_UINT:
+      return g_value_get_uint (value);
+    case G_TYPE_ENUM:
+      return g_value_get_enum (value);
+    case G_TYPE_FLAGS:
+      return g_value_get_flags (value);
+    default:
+      return g_value_get_int (value);
+    }
+}
+
+/* Bit i of @pointer_mask is set if argument i is a pointer */
+#define WORD_SHAPE(n_params, pointer_mask) (((n_params) << MAX_WORD_PARAMS) | (pointer_mask))
+
+#define WORD_CALL(params, args)                                 \
+  G_STMT_START {                                                \
+    if (has_return)                                             \
+      return ((gboolean (*) params) callback) args;             \
+    ((void (*) params) callback) args;                          \
+    return FALSE;                                               \
+  } G_STMT_END
+
+#define P gpointer
+#define I gint
+
+static gboolean
+word_call (gpointer    callback,
+           gboolean    has_return,
+           gpointer    data1,
+           gpointer    data2,
+           guint       n_params,
+           guint       pointer_mask,
+           const Word *a)
+{
+  switch (WORD_SHAPE (n_params, pointer_mask))
+    {
+    case WORD_SHAPE (0, 0):
+      WORD_CALL ((P, P), (data1, data2));
+    case WORD_SHAPE (1, 0):
+      WORD_CALL ((P, I, P), (data1, a[0].i, data2));
+    case WORD_SHAPE (1, 1):
+      WORD_CALL ((P, P, P), (data1, a[0].p, data2));
+    case WORD_SHAPE (2, 0):
+      WORD_CALL ((P, I, I, P), (data1, a[0].i, a[1].i, data2));
+    case WORD_SHAPE (2, 1):
+      WORD_CALL ((P, P, I, P), (data1, a[0].p, a[1].i, data2));
+    case WORD_SHAPE (2, 2):
+      WORD_CALL ((P, I, P, P), (data1, a[0].i, a[1].p, data2));
+    case WORD_SHAPE (2, 3):
+      WORD_CALL ((P, P, P, P), (data1, a[0].p, a[1].p, data2));
+    case WORD_SHAPE (3, 0):
+      WORD_CALL ((P, I, I, I, P), (data1, a[0].i, a[1].i, a[2].i, data2));
+    case WORD_SHAPE (3, 1):
+      WORD_CALL ((P, P, I, I, P), (data1, a[0].p, a[1].i, a[2].i, data2));
+    case WORD_SHAPE (3, 2):
+      WORD_CALL ((P, I, P, I, P), (data1, a[0].i, a[1].p, a[2].i, data2));
+    case WORD_SHAPE (3, 3):
+      WORD_CALL ((P, P, P, I, P), (data1, a[0].p, a[1].p, a[2].i, data2));
+    case WORD_SHAPE (3, 4):
+      WORD_CALL ((P, I, I, P, P), (data1, a[0].i, a[1].i, a[2].p, data2));
+    case WORD_SHAPE (3, 5):
+      WORD_CALL ((P, P, I, P, P), (data1, a[0].p, a[1].i, a[2].p, data2));
+    case WORD_SHAPE (3, 6):
+      WORD_CALL ((P, I, P, P, P), (data1, a[0].i, a[1].p, a[2].p, data2));
+    case WORD_SHAPE (3, 7):
+      WORD_CALL ((P, P, P, P, P), (data1, a[0].p, a[1].p, a[2].p, data2));
+    default:
+      g_assert_not_reached ();
+      return FALSE;
+    }
+}
+
+#undef P
+#undef I
+
+void
+_g_cclosure_marshal_words (GClosure     *closure,
+                           GValue       *return_value,
+                           guint         n_param_values,
+                           const GValue *param_values,
+                           gpointer      invocation_hint G_GNUC_UNUSED,
+                           gpointer      marshal_data)
+{
+  GCClosure *cc = (GCClosure*) closure;
+  gpointer data1, data2;
+  Word words[MAX_WORD_PARAMS];
+  guint pointer_mask = 0;
+  gboolean has_return;
+  gboolean v_return;
+  guint i;
+
+  g_return_if_fail (n_param_values >= 1 && n_param_values <= MAX_WORD_PARAMS + 1);
+
+  for (i = 0; i < n_param_values - 1; i++)
+    {
+      const GValue *value = param_values + i + 1;
+
+      if (word_is_int (G_VALUE_TYPE (value)))
+        words[i].i = word_value_get_int (value);
+      else
+        {
+          words[i].p = g_value_peek_pointer (value);
+          pointer_mask |= 1 << i;
+        }
+    }
+
+  if (G_CCLOSURE_SWAP_DATA (closure))
+    {
+      data1 = closure->data;
+      data2 = g_value_peek_pointer (param_values + 0);
+    }
+  else
+    {
+      data1 = g_value_peek_pointer (param_values + 0);
+      data2 = closure->data;
+    }
+
+  has_return = return_value != NULL && G_VALUE_HOLDS_BOOLEAN (return_value);
+  v_return = word_call (marshal_data ? marshal_data : cc->callback, has_return,
+                        data1, data2, n_param_values - 1, pointer_mask, words);
+
+  if (has_return)
+    g_value_set_boolean (return_value, v_return);
+}
+
+void
+_g_cclosure_marshal_wordsv (GClosure *closure,
+                            GValue   *return_value,
+                            gpointer  instance,
+                            va_list   args,
+                            gpointer  marshal_data,
+                            int       n_params,
+                            GType    *param_types)
+{
+  GCClosure *cc = (GCClosure*) closure;
+  gpointer data1, data2;
+  Word words[MAX_WORD_PARAMS];
+  guint pointer_mask = 0;
+  gboolean has_return;
+  gboolean v_return;
+  va_list args_copy;
+  int i;
+
+  g_return_if_fail (n_params <= MAX_WORD_PARAMS);
+
+  G_VA_COPY (args_copy, args);
+  for (i = 0; i < n_params; i++)
+    {
+      if (word_is_int (param_types[i]))
+        words[i].i = va_arg (args_copy, gint);
+      else
+        {
+          words[i].p = word_pointer_ref (param_types[i], va_arg (args_copy, gpointer));
+          pointer_mask |= 1 << i;
+        }
+    }
+  va_end (args_copy);
+
+  if (G_CCLOSURE_SWAP_DATA (closure))
+    {
+      data1 = closure->data;
+      data2 = instance;
+    }
+  else
+    {
+      data1 = instance;
+      data2 = closure->data;
+    }
+
+  has_return = return_value != NULL && G_VALUE_HOLDS_BOOLEAN (return_value);
+  v_return = word_call (marshal_data ? marshal_data : cc->callback, has_return,
+                        data1, data2, n_params, pointer_mask, words);
+
+  if (has_return)
+    g_value_set_boolean (return_value, v_return);
+
+  for (i = 0; i < n_params; i++)
+    if (pointer_mask & (1 << i))
+      word_pointer_unref (param_types[i], words[i].p);
+}
@@ -0,0 +1,45 @@
+/* GObject - GLib Type, Object, Parameter and Signal Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __G_MARSHAL_INTERNAL_H__
+#define __G_MARSHAL_INTERNAL_H__
+
+#include "gclosure.h"
+
+G_BEGIN_DECLS
+
+gboolean _g_cclosure_marshal_words_supported (GType         return_type,
+                                              guint         n_params,
+                                              const GType  *param_types);
+
+void     _g_cclosure_marshal_words           (GClosure     *closure,
+                                              GValue       *return_value,
+                                              guint         n_param_values,
+                                              const GValue *param_values,
+                                              gpointer      invocation_hint,
+                                              gpointer      marshal_data);
+void     _g_cclosure_marshal_wordsv          (GClosure     *closure,
+                                              GValue       *return_value,
+                                              gpointer      instance,
+                                              va_list       args,
+                                              gpointer      marshal_data,
+                                              int           n_params,
+                                              GType        *param_types);
+
+G_END_DECLS
+
+#endif /* __G_MARSHAL_INTERNAL_H__ */
@@ -109,6 +109,13 @@
 #define OBJECT_HAS_TOGGLE_REF(object) \
     ((g_datalist_get_flags (&(object)->qdata) & OBJECT_HAS_TOGGLE_REF_FLAG) != 0)
 #define OBJECT_FLOATING_FLAG 0x2
+/* Only objects that have handler lists need to go through
+ * g_signal_handlers_destroy(), which takes the global signal lock.
+ */
+#define OBJECT_SIGNAL_HANDLER_MASK(object) \
+    GPOINTER_TO_SIZE (g_datalist_id_get_data (&(object)->qdata, quark_signal_handlers))
+#define OBJECT_HAS_SIGNAL_HANDLERS(object) \
+    (OBJECT_SIGNAL_HANDLER_MASK (object) != 0)
 
 #define CLASS_HAS_PROPS_FLAG 0x1
 #define CLASS_HAS_PROPS(class) \
@@ -122,6 +129,29 @@
 #define CLASS_HAS_DERIVED_CLASS(class) \
     ((class)->flags & CLASS_HAS_DERIVED_CLASS_FLAG)
 
+#define CONSTRUCT_PLAN_PSPEC_CACHE_SIZE 16
+
+/* What g_object_new() needs to know about a class, built on first use
+ * and kept in class->construct_plan: the construct properties with
+ * their default values, and a cache of the pspecs that property names
+ * passed to g_object_new(), g_object_set() and g_object_get() resolved
+ * to, indexed by the address of the name.
+ *
+ * If properties are installed after the plan was built, it is marked
+ * stale and a new one is built.  Old plans may still be in use by
+ * other threads, so they are only freed along with the class.
+ */
+typedef struct _GObjectConstructPlan GObjectConstructPlan;
+struct _GObjectConstructPlan
+{
+  GObjectConstructPlan  *previous;
+  gint                   stale;         /* atomic */
+  guint                  n_construct_pspecs;
+  GParamSpec           **construct_pspecs;
+  const GValue         **construct_defaults;
+  GParamSpec * volatile  pspec_cache[CONSTRUCT_PLAN_PSPEC_CACHE_SIZE];
+};
+
 /* --- signals --- */
 enum {
   NOTIFY,
@@ -191,21 +221,37 @@ struct _GObjectNotifyQueue
 
 /* --- variables --- */
 G_LOCK_DEFINE_STATIC (closure_array_mutex);
-G_LOCK_DEFINE_STATIC (weak_refs_mutex);
-G_LOCK_DEFINE_STATIC (toggle_refs_mutex);
 static GQuark	            quark_closure_array = 0;
 static GQuark	            quark_weak_refs = 0;
 static GQuark	            quark_toggle_refs = 0;
 static GQuark               quark_notify_queue;
 static GQuark               quark_in_construction;
+static GQuark               quark_signal_handlers;
 static GParamSpecPool      *pspec_pool = NULL;
 static gulong	            gobject_signals[LAST_SIGNAL] = { 0, };
 static guint (*floating_flag_handler) (GObject*, gint) = object_floating_flag_handler;
-/* qdata pointing to GSList<GWeakRef *>, protected by weak_locations_lock */
+/* qdata pointing to GSList<GWeakRef *>, protected by weak_locations_locks */
 static GQuark	            quark_weak_locations = 0;
-static GRWLock              weak_locations_lock;
 
-G_LOCK_DEFINE_STATIC(notify_lock);
+/* Per-object state (notify queue, weak refs, toggle refs and weak
+ * locations) is protected by one of a set of locks picked by the
+ * address of the object, so that threads working on unrelated objects
+ * rarely contend.  The qdata pointer has no spare bits left for a lock
+ * of its own.
+ */
+#define OBJECT_LOCK_COUNT 64
+static GMutex               notify_locks[OBJECT_LOCK_COUNT];
+static GMutex               weak_refs_locks[OBJECT_LOCK_COUNT];
+static GMutex               toggle_refs_locks[OBJECT_LOCK_COUNT];
+static GRWLock              weak_locations_locks[OBJECT_LOCK_COUNT];
+
+static inline guint
+object_lock_index (gconstpointer object)
+{
+  gsize addr = GPOINTER_TO_SIZE (object);
+
+  return ((addr >> 4) ^ (addr >> 10)) % OBJECT_LOCK_COUNT;
+}
 
 /* --- functions --- */
 static void
@@ -221,15 +267,16 @@ static GObjectNotifyQueue*
 g_object_notify_queue_freeze (GObject  *object,
                               gboolean  conditional)
 {
+  GMutex *lock = &notify_locks[object_lock_index (object)];
   GObjectNotifyQueue *nqueue;
 
-  G_LOCK(notify_lock);
+  g_mutex_lock (lock);
   nqueue = g_datalist_id_get_data (&object->qdata, quark_notify_queue);
   if (!nqueue)
     {
       if (conditional)
         {
-          G_UNLOCK(notify_lock);
+          g_mutex_unlock (lock);
           return NULL;
         }
 
@@ -245,7 +292,7 @@ g_object_notify_queue_freeze (GObject  *object,
                G_OBJECT_TYPE_NAME (object), object);
   else
     nqueue->freeze_count++;
-  G_UNLOCK(notify_lock);
+  g_mutex_unlock (lock);
 
   return nqueue;
 }
@@ -255,17 +302,18 @@ g_object_notify_queue_thaw (GObject            *object,
                             GObjectNotifyQueue *nqueue)
 {
   GParamSpec *pspecs_mem[16], **pspecs, **free_me = NULL;
+  GMutex *lock = &notify_locks[object_lock_index (object)];
   GSList *slist;
   guint n_pspecs = 0;
 
   g_return_if_fail (nqueue->freeze_count > 0);
   g_return_if_fail (g_atomic_int_get(&object->ref_count) > 0);
 
-  G_LOCK(notify_lock);
+  g_mutex_lock (lock);
 
   /* Just make sure we never get into some nasty race condition */
   if (G_UNLIKELY(nqueue->freeze_count == 0)) {
-    G_UNLOCK(notify_lock);
+    g_mutex_unlock (lock);
     g_warning ("%s: property-changed notification for %s(%p) is not frozen",
                G_STRFUNC, G_OBJECT_TYPE_NAME (object), object);
     return;
@@ -273,7 +321,7 @@ g_object_notify_queue_thaw (GObject            *object,
 
   nqueue->freeze_count--;
   if (nqueue->freeze_count) {
-    G_UNLOCK(notify_lock);
+    g_mutex_unlock (lock);
     return;
   }
 
@@ -285,7 +333,7 @@ g_object_notify_queue_thaw (GObject            *object,
     }
   g_datalist_id_set_data (&object->qdata, quark_notify_queue, NULL);
 
-  G_UNLOCK(notify_lock);
+  g_mutex_unlock (lock);
 
   if (n_pspecs)
     G_OBJECT_GET_CLASS (object)->dispatch_properties_changed (object, n_pspecs, pspecs);
@@ -297,7 +345,9 @@ g_object_notify_queue_add (GObject            *object,
                            GObjectNotifyQueue *nqueue,
                            GParamSpec         *pspec)
 {
-  G_LOCK(notify_lock);
+  GMutex *lock = &notify_locks[object_lock_index (object)];
+
+  g_mutex_lock (lock);
 
   g_return_if_fail (nqueue->n_pspecs < 65535);
 
@@ -307,7 +357,25 @@ g_object_notify_queue_add (GObject            *object,
       nqueue->n_pspecs++;
     }
 
-  G_UNLOCK(notify_lock);
+  g_mutex_unlock (lock);
+}
+
+/* Whether a property change notification on @object could be observed
+ * at all: by a signal handler, by a class that overrides ::notify or
+ * dispatch_properties_changed(), or by a class closure installed with
+ * g_signal_override_class_handler().  ::notify doesn't support emission
+ * hooks.  If nothing is listening, the notify queue can be skipped.
+ */
+static inline gboolean
+object_needs_notify (GObject *object)
+{
+  GObjectClass *class = G_OBJECT_GET_CLASS (object);
+
+  return class->notify != NULL ||
+         class->dispatch_properties_changed != g_object_dispatch_properties_changed ||
+         !_g_signal_has_trivial_emission (gobject_signals[NOTIFY]) ||
+         (OBJECT_SIGNAL_HANDLER_MASK (object) &
+          G_SIGNAL_HANDLER_MASK_FOR (gobject_signals[NOTIFY])) != 0;
 }
 
 #ifdef	G_ENABLE_DEBUG
@@ -415,6 +483,7 @@ g_object_base_class_init (GObjectClass *class)
 
   /* reset instance specific fields and methods that don't get inherited */
   class->construct_properties = pclass ? g_slist_copy (pclass->construct_properties) : NULL;
+  class->construct_plan = NULL;
   class->get_property = NULL;
   class->set_property = NULL;
 }
@@ -428,6 +497,13 @@ g_object_base_class_finalize (GObjectClass *class)
 
   g_slist_free (class->construct_properties);
   class->construct_properties = NULL;
+  while (class->construct_plan)
+    {
+      GObjectConstructPlan *plan = class->construct_plan;
+
+      class->construct_plan = plan->previous;
+      g_free (plan);
+    }
   list = g_param_spec_pool_list_owned (pspec_pool, G_OBJECT_CLASS_TYPE (class));
   for (node = list; node; node = node->next)
     {
@@ -451,6 +527,7 @@ g_object_do_class_init (GObjectClass *class)
   quark_toggle_refs = g_quark_from_static_string ("GObject-toggle-references");
   quark_notify_queue = g_quark_from_static_string ("GObject-notify-queue");
   quark_in_construction = g_quark_from_static_string ("GObject-in-construction");
+  quark_signal_handlers = g_quark_from_static_string ("GObject-signal-handlers");
   pspec_pool = g_param_spec_pool_new (TRUE);
 
   class->constructor = g_object_constructor;
@@ -501,6 +578,97 @@ g_object_do_class_init (GObjectClass *class)
   g_type_add_interface_check (NULL, object_interface_check_properties);
 }
 
+static void
+object_class_invalidate_construct_plan (GObjectClass *class)
+{
+  GObjectConstructPlan *plan;
+
+  plan = g_atomic_pointer_get (&class->construct_plan);
+  if (plan)
+    g_atomic_int_set (&plan->stale, TRUE);
+}
+
+static GObjectConstructPlan *
+object_class_get_construct_plan (GObjectClass *class)
+{
+  GObjectConstructPlan *plan, *new_plan;
+  GSList *node;
+  guint n, i;
+
+  plan = g_atomic_pointer_get (&class->construct_plan);
+  if G_LIKELY (plan && !g_atomic_int_get (&plan->stale))
+    return plan;
+
+  n = g_slist_length (class->construct_properties);
+  new_plan = g_malloc0 (sizeof (GObjectConstructPlan) +
+                        n * (sizeof (GParamSpec *) + sizeof (GValue *)));
+  new_plan->previous = plan;
+  new_plan->n_construct_pspecs = n;
+  new_plan->construct_pspecs = (GParamSpec **) (new_plan + 1);
+  new_plan->construct_defaults = (const GValue **) (new_plan->construct_pspecs + n);
+
+  for (node = class->construct_properties, i = 0; node; node = node->next, i++)
+    {
+      new_plan->construct_pspecs[i] = node->data;
+      new_plan->construct_defaults[i] = g_param_spec_get_default_value (node->data);
+    }
+
+  if (!g_atomic_pointer_compare_and_exchange (&class->construct_plan, plan, new_plan))
+    {
+      /* another thread got there first */
+      g_free (new_plan);
+      new_plan = g_atomic_pointer_get (&class->construct_plan);
+    }
+
+  return new_plan;
+}
+
+/* pspec names are canonical; like the pspec pool, accept '_' for '-' */
+static inline gboolean
+pspec_name_matches (const gchar *pspec_name,
+                    const gchar *name)
+{
+  while (*pspec_name == *name || (*pspec_name == '-' && *name == '_'))
+    {
+      if (*name == '\0')
+        return TRUE;
+
+      pspec_name++;
+      name++;
+    }
+
+  return FALSE;
+}
+
+/* Looks up the property called @name on instances of @class, without
+ * taking the pspec pool lock on a hit.  Callers nearly always pass the
+ * same string literals, so the result is remembered by the address of
+ * @name.  The name of the cached pspec is compared against @name, so a
+ * different string at a reused address just misses the cache.
+ */
+static GParamSpec *
+object_class_lookup_pspec (GObjectClass *class,
+                           const gchar  *name)
+{
+  GObjectConstructPlan *plan;
+  GParamSpec *pspec;
+  gsize slot;
+
+  plan = object_class_get_construct_plan (class);
+  slot = GPOINTER_TO_SIZE (name);
+  slot = (slot ^ (slot >> 4)) % CONSTRUCT_PLAN_PSPEC_CACHE_SIZE;
+
+  pspec = plan->pspec_cache[slot];
+  if (pspec && pspec_name_matches (pspec->name, name))
+    return pspec;
+
+  pspec = g_param_spec_pool_lookup (pspec_pool, name, G_OBJECT_CLASS_TYPE (class), TRUE);
+  if (pspec)
+    plan->pspec_cache[slot] = pspec;
+
+  return pspec;
+}
+
 static inline void
 install_property_internal (GType       g_type,
 			   guint       property_id,
@@ -570,6 +738,8 @@ g_object_class_install_property (GObjectClass *class,
   pspec = g_param_spec_pool_lookup (pspec_pool, pspec->name, g_type_parent (G_OBJECT_CLASS_TYPE (class)), TRUE);
   if (pspec && pspec->flags & (G_PARAM_CONSTRUCT | G_PARAM_CONSTRUCT_ONLY))
     class->construct_properties = g_slist_remove (class->construct_properties, pspec);
+
+  object_class_invalidate_construct_plan (class);
 }
 
 /**
@@ -691,6 +861,8 @@ g_object_class_install_properties (GObjectClass  *oclass,
       if (pspec && pspec->flags & (G_PARAM_CONSTRUCT | G_PARAM_CONSTRUCT_ONLY))
         oclass->construct_properties = g_slist_remove (oclass->construct_properties, pspec);
     }
+
+  object_class_invalidate_construct_plan (oclass);
 }
 
 /**
@@ -1017,11 +1189,31 @@ g_object_do_get_property (GObject     *object,
 static void
 g_object_real_dispose (GObject *object)
 {
-  g_signal_handlers_destroy (object);
+  if (OBJECT_HAS_SIGNAL_HANDLERS (object))
+    g_signal_handlers_destroy (object);
   g_datalist_id_set_data (&object->qdata, quark_closure_array, NULL);
   g_datalist_id_set_data (&object->qdata, quark_weak_refs, NULL);
 }
 
+/* Called by gsignal.c, with the signal lock held, whenever the set of
+ * signals with handlers on @object changes.
+ */
+void
+_g_object_set_signal_handler_mask (GObject *object,
+                                   gsize    mask)
+{
+  g_datalist_id_set_data (&object->qdata, quark_signal_handlers, GSIZE_TO_POINTER (mask));
+}
+
+/* Called by gsignal.c, without the signal lock, to see if an emission
+ * on @object can be skipped.
+ */
+gsize
+_g_object_get_signal_handler_mask (GObject *object)
+{
+  return OBJECT_SIGNAL_HANDLER_MASK (object);
+}
+
 static void
 g_object_finalize (GObject *object)
 {
@@ -1132,7 +1324,7 @@ g_object_notify_by_spec_internal (GObject    *object,
 
   notify_pspec = get_notify_pspec (pspec);
 
-  if (notify_pspec != NULL)
+  if (notify_pspec != NULL && object_needs_notify (object))
     {
       GObjectNotifyQueue *nqueue;
 
@@ -1179,10 +1371,7 @@ g_object_notify (GObject     *object,
    * (by, e.g. calling g_object_class_find_property())
    * because g_object_notify_queue_add() does that
    */
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_TYPE (object),
-				    TRUE);
+  pspec = object_class_lookup_pspec (G_OBJECT_GET_CLASS (object), property_name);
 
   if (!pspec)
     g_warning ("%s: object class '%s' has no property named '%s'",
@@ -1377,7 +1566,8 @@ object_set_property (GObject             *object,
 
       notify_pspec = get_notify_pspec (pspec);
 
-      if (notify_pspec != NULL)
+      /* nqueue is NULL if nothing is listening */
+      if (notify_pspec != NULL && nqueue != NULL)
         g_object_notify_queue_add (object, nqueue, notify_pspec);
     }
   g_value_unset (&tmp_value);
@@ -1581,10 +1771,10 @@ g_object_new_with_custom_constructor (GObjectClass          *class,
   gboolean newly_constructed;
   GObjectConstructParam *cparams;
   GObject *object;
+  GObjectConstructPlan *plan;
   GValue *cvalues;
   gint n_cparams;
   gint cvals_used;
-  GSList *node;
   gint i;
 
   /* If we have ->constructed() then we have to do a lot more work.
@@ -1598,11 +1788,11 @@ g_object_new_with_custom_constructor (GObjectClass          *class,
    */
 
   /* Create the array of GObjectConstructParams for constructor() */
-  n_cparams = g_slist_length (class->construct_properties);
+  plan = object_class_get_construct_plan (class);
+  n_cparams = plan->n_construct_pspecs;
   cparams = g_new (GObjectConstructParam, n_cparams);
   cvalues = g_new0 (GValue, n_cparams);
   cvals_used = 0;
-  i = 0;
 
   /* As above, we may find the value in the passed-in params list.
    *
@@ -1611,13 +1801,13 @@ g_object_new_with_custom_constructor (GObjectClass          *class,
    * default value from the class, we had better not pass that in
    * and risk it being modified, so we create a new one.
    * */
-  for (node = class->construct_properties; node; node = node->next)
+  for (i = 0; i < n_cparams; i++)
     {
       GParamSpec *pspec;
       GValue *value;
       gint j;
 
-      pspec = node->data;
+      pspec = plan->construct_pspecs[i];
       value = NULL; /* to silence gcc... */
 
       for (j = 0; j < n_params; j++)
@@ -1636,7 +1826,6 @@ g_object_new_with_custom_constructor (GObjectClass          *class,
 
       cparams[i].pspec = pspec;
       cparams[i].value = value;
-      i++;
     }
 
   /* construct object from construction parameters */
@@ -1723,7 +1912,8 @@ g_object_new_internal (GObjectClass          *class,
 
   if (CLASS_HAS_PROPS (class))
     {
-      GSList *node;
+      GObjectConstructPlan *plan;
+      guint i;
 
       /* This will have been setup in g_object_init() */
       nqueue = g_datalist_id_get_data (&object->qdata, quark_notify_queue);
@@ -1733,14 +1923,15 @@ g_object_new_internal (GObjectClass          *class,
        * properties, but they may come from either the class default
        * values or the passed-in parameter list.
        */
-      for (node = class->construct_properties; node; node = node->next)
+      plan = object_class_get_construct_plan (class);
+      for (i = 0; i < plan->n_construct_pspecs; i++)
         {
           const GValue *value;
           GParamSpec *pspec;
           gint j;
 
-          pspec = node->data;
-          value = NULL; /* to silence gcc... */
+          pspec = plan->construct_pspecs[i];
+          value = plan->construct_defaults[i];
 
           for (j = 0; j < n_params; j++)
             if (params[j].pspec == pspec)
@@ -1749,9 +1940,6 @@ g_object_new_internal (GObjectClass          *class,
                 break;
               }
 
-          if (j == n_params)
-            value = g_param_spec_get_default_value (pspec);
-
           object_set_property (object, pspec, value, nqueue);
         }
     }
@@ -1825,7 +2013,7 @@ g_object_newv (GType       object_type,
           GParamSpec *pspec;
           gint k;
 
-          pspec = g_param_spec_pool_lookup (pspec_pool, parameters[i].name, object_type, TRUE);
+          pspec = object_class_lookup_pspec (class, parameters[i].name);
 
           if G_UNLIKELY (!pspec)
             {
@@ -1919,7 +2107,7 @@ g_object_new_valist (GType        object_type,
           GParamSpec *pspec;
           gint i;
 
-          pspec = g_param_spec_pool_lookup (pspec_pool, name, object_type, TRUE);
+          pspec = object_class_lookup_pspec (class, name);
 
           if G_UNLIKELY (!pspec)
             {
@@ -2053,7 +2241,7 @@ g_object_set_valist (GObject	 *object,
   g_return_if_fail (G_IS_OBJECT (object));
   
   g_object_ref (object);
-  nqueue = g_object_notify_queue_freeze (object, FALSE);
+  nqueue = object_needs_notify (object) ? g_object_notify_queue_freeze (object, FALSE) : NULL;
   
   name = first_property_name;
   while (name)
@@ -2062,10 +2250,7 @@ g_object_set_valist (GObject	 *object,
       GParamSpec *pspec;
       gchar *error = NULL;
       
-      pspec = g_param_spec_pool_lookup (pspec_pool,
-					name,
-					G_OBJECT_TYPE (object),
-					TRUE);
+      pspec = object_class_lookup_pspec (G_OBJECT_GET_CLASS (object), name);
       if (!pspec)
 	{
 	  g_warning ("%s: object class '%s' has no property named '%s'",
@@ -2105,7 +2290,8 @@ g_object_set_valist (GObject	 *object,
       name = va_arg (var_args, gchar*);
     }
 
-  g_object_notify_queue_thaw (object, nqueue);
+  if (nqueue)
+    g_object_notify_queue_thaw (object, nqueue);
   g_object_unref (object);
 }
 
@@ -2143,10 +2329,7 @@ g_object_get_valist (GObject	 *object,
       GParamSpec *pspec;
       gchar *error;
       
-      pspec = g_param_spec_pool_lookup (pspec_pool,
-					name,
-					G_OBJECT_TYPE (object),
-					TRUE);
+      pspec = object_class_lookup_pspec (G_OBJECT_GET_CLASS (object), name);
       if (!pspec)
 	{
 	  g_warning ("%s: object class '%s' has no property named '%s'",
@@ -2281,12 +2464,9 @@ g_object_set_property (GObject	    *object,
   g_return_if_fail (G_IS_VALUE (value));
   
   g_object_ref (object);
-  nqueue = g_object_notify_queue_freeze (object, FALSE);
+  nqueue = object_needs_notify (object) ? g_object_notify_queue_freeze (object, FALSE) : NULL;
   
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_TYPE (object),
-				    TRUE);
+  pspec = object_class_lookup_pspec (G_OBJECT_GET_CLASS (object), property_name);
   if (!pspec)
     g_warning ("%s: object class '%s' has no property named '%s'",
 	       G_STRFUNC,
@@ -2303,7 +2483,8 @@ g_object_set_property (GObject	    *object,
   else
     object_set_property (object, pspec, value, nqueue);
   
-  g_object_notify_queue_thaw (object, nqueue);
+  if (nqueue)
+    g_object_notify_queue_thaw (object, nqueue);
   g_object_unref (object);
 }
 
@@ -2336,10 +2517,7 @@ g_object_get_property (GObject	   *object,
   
   g_object_ref (object);
   
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_TYPE (object),
-				    TRUE);
+  pspec = object_class_lookup_pspec (G_OBJECT_GET_CLASS (object), property_name);
   if (!pspec)
     g_warning ("%s: object class '%s' has no property named '%s'",
 	       G_STRFUNC,
@@ -2649,7 +2827,7 @@ g_object_weak_ref (GObject    *object,
   g_return_if_fail (notify != NULL);
   g_return_if_fail (object->ref_count >= 1);
 
-  G_LOCK (weak_refs_mutex);
+  g_mutex_lock (&weak_refs_locks[object_lock_index (object)]);
   wstack = g_datalist_id_remove_no_notify (&object->qdata, quark_weak_refs);
   if (wstack)
     {
@@ -2666,7 +2844,7 @@ g_object_weak_ref (GObject    *object,
   wstack->weak_refs[i].notify = notify;
   wstack->weak_refs[i].data = data;
   g_datalist_id_set_data_full (&object->qdata, quark_weak_refs, wstack, weak_refs_notify);
-  G_UNLOCK (weak_refs_mutex);
+  g_mutex_unlock (&weak_refs_locks[object_lock_index (object)]);
 }
 
 /**
@@ -2688,7 +2866,7 @@ g_object_weak_unref (GObject    *object,
   g_return_if_fail (G_IS_OBJECT (object));
   g_return_if_fail (notify != NULL);
 
-  G_LOCK (weak_refs_mutex);
+  g_mutex_lock (&weak_refs_locks[object_lock_index (object)]);
   wstack = g_datalist_id_get_data (&object->qdata, quark_weak_refs);
   if (wstack)
     {
@@ -2706,7 +2884,7 @@ g_object_weak_unref (GObject    *object,
 	    break;
 	  }
     }
-  G_UNLOCK (weak_refs_mutex);
+  g_mutex_unlock (&weak_refs_locks[object_lock_index (object)]);
   if (!found_one)
     g_warning ("%s: couldn't find weak ref %p(%p)", G_STRFUNC, notify, data);
 }
@@ -2870,10 +3048,10 @@ toggle_refs_notify (GObject *object,
 {
   ToggleRefStack tstack, *tstackptr;
 
-  G_LOCK (toggle_refs_mutex);
+  g_mutex_lock (&toggle_refs_locks[object_lock_index (object)]);
   tstackptr = g_datalist_id_get_data (&object->qdata, quark_toggle_refs);
   tstack = *tstackptr;
-  G_UNLOCK (toggle_refs_mutex);
+  g_mutex_unlock (&toggle_refs_locks[object_lock_index (object)]);
 
   /* Reentrancy here is not as tricky as it seems, because a toggle reference
    * will only be notified when there is exactly one of them.
@@ -2935,7 +3113,7 @@ g_object_add_toggle_ref (GObject       *object,
 
   g_object_ref (object);
 
-  G_LOCK (toggle_refs_mutex);
+  g_mutex_lock (&toggle_refs_locks[object_lock_index (object)]);
   tstack = g_datalist_id_remove_no_notify (&object->qdata, quark_toggle_refs);
   if (tstack)
     {
@@ -2960,7 +3138,7 @@ g_object_add_toggle_ref (GObject       *object,
   tstack->toggle_refs[i].data = data;
   g_datalist_id_set_data_full (&object->qdata, quark_toggle_refs, tstack,
 			       (GDestroyNotify)g_free);
-  G_UNLOCK (toggle_refs_mutex);
+  g_mutex_unlock (&toggle_refs_locks[object_lock_index (object)]);
 }
 
 /**
@@ -2987,7 +3165,7 @@ g_object_remove_toggle_ref (GObject       *object,
   g_return_if_fail (G_IS_OBJECT (object));
   g_return_if_fail (notify != NULL);
 
-  G_LOCK (toggle_refs_mutex);
+  g_mutex_lock (&toggle_refs_locks[object_lock_index (object)]);
   tstack = g_datalist_id_get_data (&object->qdata, quark_toggle_refs);
   if (tstack)
     {
@@ -3008,7 +3186,7 @@ g_object_remove_toggle_ref (GObject       *object,
 	    break;
 	  }
     }
-  G_UNLOCK (toggle_refs_mutex);
+  g_mutex_unlock (&toggle_refs_locks[object_lock_index (object)]);
 
   if (found_one)
     g_object_unref (object);
@@ -3045,6 +3223,8 @@ g_object_ref (gpointer _object)
     toggle_refs_notify (object, FALSE);
 
   TRACE (GOBJECT_OBJECT_REF(object,G_TYPE_FROM_INSTANCE(object),old_val));
+  _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_OBJECT_REF, G_TRACE_PHASE_INSTANT,
+                               G_OBJECT_TYPE_NAME (object), object, old_val);
 
   return object;
 }
@@ -3082,6 +3262,8 @@ g_object_unref (gpointer _object)
 	goto retry_atomic_decrement1;
 
       TRACE (GOBJECT_OBJECT_UNREF(object,G_TYPE_FROM_INSTANCE(object),old_ref));
+      _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_OBJECT_UNREF, G_TRACE_PHASE_INSTANT,
+                                   G_OBJECT_TYPE_NAME (object), object, old_ref);
 
       /* if we went from 2->1 we need to notify toggle refs if any */
       if (old_ref == 2 && has_toggle_ref) /* The last ref being held in this case is owned by the toggle_ref */
@@ -3104,7 +3286,7 @@ g_object_unref (gpointer _object)
 
       if (weak_locations != NULL)
         {
-          g_rw_lock_writer_lock (&weak_locations_lock);
+          g_rw_lock_writer_lock (&weak_locations_locks[object_lock_index (object)]);
 
           /* It is possible that one of the weak references beat us to
            * the lock. Make sure the refcount is still what we expected
@@ -3113,7 +3295,7 @@ g_object_unref (gpointer _object)
           old_ref = g_atomic_int_get (&object->ref_count);
           if (old_ref != 1)
             {
-              g_rw_lock_writer_unlock (&weak_locations_lock);
+              g_rw_lock_writer_unlock (&weak_locations_locks[object_lock_index (object)]);
               goto retry_atomic_decrement1;
             }
 
@@ -3128,7 +3310,7 @@ g_object_unref (gpointer _object)
               *weak_locations = g_slist_delete_link (*weak_locations, *weak_locations);
             }
 
-          g_rw_lock_writer_unlock (&weak_locations_lock);
+          g_rw_lock_writer_unlock (&weak_locations_locks[object_lock_index (object)]);
         }
 
       /* we are about to remove the last reference */
@@ -3148,6 +3330,8 @@ g_object_unref (gpointer _object)
 	    goto retry_atomic_decrement2;
 
 	  TRACE (GOBJECT_OBJECT_UNREF(object,G_TYPE_FROM_INSTANCE(object),old_ref));
+	  _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_OBJECT_UNREF, G_TRACE_PHASE_INSTANT,
+	                               G_OBJECT_TYPE_NAME (object), object, old_ref);
 
           /* if we went from 2->1 we need to notify toggle refs if any */
           if (old_ref == 2 && has_toggle_ref) /* The last ref being held in this case is owned by the toggle_ref */
@@ -3158,13 +3342,16 @@ g_object_unref (gpointer _object)
 
       /* we are still in the process of taking away the last ref */
       g_datalist_id_set_data (&object->qdata, quark_closure_array, NULL);
-      g_signal_handlers_destroy (object);
+      if (OBJECT_HAS_SIGNAL_HANDLERS (object))
+        g_signal_handlers_destroy (object);
       g_datalist_id_set_data (&object->qdata, quark_weak_refs, NULL);
       
       /* decrement the last reference */
       old_ref = g_atomic_int_add (&object->ref_count, -1);
 
       TRACE (GOBJECT_OBJECT_UNREF(object,G_TYPE_FROM_INSTANCE(object),old_ref));
+      _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_OBJECT_UNREF, G_TRACE_PHASE_INSTANT,
+                                   G_OBJECT_TYPE_NAME (object), object, old_ref);
 
       /* may have been re-referenced meanwhile */
       if (G_LIKELY (old_ref == 1))
@@ -4208,14 +4395,23 @@ g_weak_ref_get (GWeakRef *weak_ref)
 
   g_return_val_if_fail (weak_ref!= NULL, NULL);
 
-  g_rw_lock_reader_lock (&weak_locations_lock);
-
-  object_or_null = weak_ref->priv.p;
-
-  if (object_or_null != NULL)
-    g_object_ref (object_or_null);
+  /* The pointer can only change away from an object while that
+   * object's lock is held for writing, so if it is unchanged once we
+   * hold the lock for reading, the object is still alive.
+   */
+  while ((object_or_null = g_atomic_pointer_get (&weak_ref->priv.p)) != NULL)
+    {
+      GRWLock *lock = &weak_locations_locks[object_lock_index (object_or_null)];
 
-  g_rw_lock_reader_unlock (&weak_locations_lock);
+      g_rw_lock_reader_lock (lock);
+      if (weak_ref->priv.p == object_or_null)
+        {
+          g_object_ref (object_or_null);
+          g_rw_lock_reader_unlock (lock);
+          break;
+        }
+      g_rw_lock_reader_unlock (lock);
+    }
 
   return object_or_null;
 }
@@ -4240,13 +4436,42 @@ g_weak_ref_set (GWeakRef *weak_ref,
   GSList **weak_locations;
   GObject *new_object;
   GObject *old_object;
+  GRWLock *first_lock, *second_lock;
 
   g_return_if_fail (weak_ref != NULL);
   g_return_if_fail (object == NULL || G_IS_OBJECT (object));
 
   new_object = object;
 
-  g_rw_lock_writer_lock (&weak_locations_lock);
+ retry:
+  /* Both the old and the new object's locks are needed; take them in
+   * address order so that two concurrent setters can't deadlock.
+   */
+  old_object = g_atomic_pointer_get (&weak_ref->priv.p);
+  first_lock = old_object ? &weak_locations_locks[object_lock_index (old_object)] : NULL;
+  second_lock = new_object ? &weak_locations_locks[object_lock_index (new_object)] : NULL;
+  if (first_lock == second_lock)
+    second_lock = NULL;
+  else if (first_lock == NULL || (second_lock != NULL && second_lock < first_lock))
+    {
+      GRWLock *tmp = first_lock;
+      first_lock = second_lock;
+      second_lock = tmp;
+    }
+
+  if (first_lock)
+    g_rw_lock_writer_lock (first_lock);
+  if (second_lock)
+    g_rw_lock_writer_lock (second_lock);
+
+  if (weak_ref->priv.p != old_object)
+    {
+      if (second_lock)
+        g_rw_lock_writer_unlock (second_lock);
+      if (first_lock)
+        g_rw_lock_writer_unlock (first_lock);
+      goto retry;
+    }
 
   /* We use the extra level of indirection here so that if we have ever
    * had a weak pointer installed at any point in time on this object,
@@ -4263,7 +4488,6 @@ g_weak_ref_set (GWeakRef *weak_ref,
    * races.
    */
 
-  old_object = weak_ref->priv.p;
   if (new_object != old_object)
     {
       weak_ref->priv.p = new_object;
@@ -4293,5 +4517,8 @@ g_weak_ref_set (GWeakRef *weak_ref,
         }
     }
 
-  g_rw_lock_writer_unlock (&weak_locations_lock);
+  if (second_lock)
+    g_rw_lock_writer_unlock (second_lock);
+  if (first_lock)
+    g_rw_lock_writer_unlock (first_lock);
 }
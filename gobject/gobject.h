@@ -347,9 +347,10 @@ struct  _GObjectClass
 
   /*< private >*/
   gsize		flags;
+  gpointer	construct_plan;
 
   /* padding */
-  gpointer	pdummy[6];
+  gpointer	pdummy[5];
 };
 /**
  * GObjectConstructParam:
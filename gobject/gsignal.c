@@ -32,6 +32,7 @@
 #include "gsignal.h"
 #include "gtype-private.h"
 #include "gbsearcharray.h"
+#include "gmarshal-internal.h"
 #include "gvaluecollector.h"
 #include "gvaluetypes.h"
 #include "gobject.h"
@@ -228,6 +229,13 @@ struct _SignalNode
   GHookList         *emission_hooks;
 
   GClosure *single_va_closure;
+
+  /* TRUE while emitting on an instance without handlers does nothing,
+   * unless the class member at trivial_class_offset is set; read
+   * without holding the signal lock
+   */
+  volatile gint      trivial_emission;
+  guint              trivial_class_offset;
 };
 
 #define	SINGLE_VA_CLOSURE_EMPTY_MAGIC GINT_TO_POINTER(1)	/* indicates single_va_closure is valid but empty */
@@ -310,8 +318,13 @@ G_LOCK_DEFINE_STATIC (g_signal_mutex);
 
 
 /* --- signal nodes --- */
+/* g_signal_nodes only grows and the arrays it outgrows are kept around,
+ * so that signal_node_lookup_unlocked() can index it without the lock.
+ */
 static guint          g_n_signal_nodes = 0;
+static guint          g_n_signal_nodes_alloc = 0;
 static SignalNode   **g_signal_nodes = NULL;
+static GSList        *g_signal_nodes_retired = NULL;
 
 static inline SignalNode*
 LOOKUP_SIGNAL_NODE (register guint signal_id)
@@ -322,6 +335,40 @@ LOOKUP_SIGNAL_NODE (register guint signal_id)
     return NULL;
 }
 
+static inline SignalNode*
+signal_node_lookup_unlocked (guint signal_id)
+{
+  SignalNode **nodes;
+
+  /* the count is published after the array that holds it */
+  if (signal_id >= (guint) g_atomic_int_get (&g_n_signal_nodes))
+    return NULL;
+  nodes = g_atomic_pointer_get (&g_signal_nodes);
+
+  return nodes[signal_id];
+}
+
+static void
+signal_nodes_append (SignalNode *node)
+{
+  if (g_n_signal_nodes == g_n_signal_nodes_alloc)
+    {
+      SignalNode **nodes;
+
+      g_n_signal_nodes_alloc = MAX (g_n_signal_nodes_alloc * 2, 64);
+      nodes = g_new (SignalNode*, g_n_signal_nodes_alloc);
+      if (g_signal_nodes)
+        {
+          memcpy (nodes, g_signal_nodes, sizeof (SignalNode*) * g_n_signal_nodes);
+          g_signal_nodes_retired = g_slist_prepend (g_signal_nodes_retired, g_signal_nodes);
+        }
+      g_atomic_pointer_set (&g_signal_nodes, nodes);
+    }
+
+  g_signal_nodes[g_n_signal_nodes] = node;
+  g_atomic_int_set (&g_n_signal_nodes, g_n_signal_nodes + 1);
+}
+
 
 /* --- functions --- */
 static inline guint
@@ -403,6 +450,7 @@ handler_list_ensure (guint    signal_id,
       hlbsa = g_bsearch_array_create (&g_signal_hlbsa_bconfig);
       hlbsa = g_bsearch_array_insert (hlbsa, &g_signal_hlbsa_bconfig, &key);
       g_hash_table_insert (g_handler_list_bsa_ht, instance, hlbsa);
+
     }
   else
     {
@@ -591,6 +639,37 @@ handler_new (gboolean after)
   return handler;
 }
 
+/* Keep the summary of signals with handlers on a GObject in sync, for
+ * g_signal_emit_valist() and g_object_notify() to check without locking.
+ */
+static void
+handler_mask_update (gpointer instance)
+{
+  GBSearchArray *hlbsa;
+  gsize mask = 0;
+
+  if (G_TYPE_FUNDAMENTAL (G_TYPE_FROM_INSTANCE (instance)) != G_TYPE_OBJECT)
+    return;
+
+  hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  if (hlbsa)
+    {
+      guint i;
+
+      mask = G_SIGNAL_HANDLER_MASK_ANY;
+      for (i = 0; i < hlbsa->n_nodes; i++)
+        {
+          HandlerList *hlist = g_bsearch_array_get_nth (hlbsa, &g_signal_hlbsa_bconfig, i);
+
+          if (hlist->handlers)
+            mask |= G_SIGNAL_HANDLER_MASK_FOR (hlist->signal_id);
+        }
+    }
+
+  if (mask != _g_object_get_signal_handler_mask (instance))
+    _g_object_set_signal_handler_mask (instance, mask);
+}
+
 static inline void
 handler_ref (Handler *handler)
 {
@@ -647,6 +726,9 @@ handler_unref_R (guint    signal_id,
                   hlist->tail_after = handler->prev;
                 }
             }
+
+          if (hlist && !hlist->handlers)
+            handler_mask_update (instance);
         }
 
       SIGNAL_UNLOCK ();
@@ -699,6 +781,15 @@ handler_insert (guint    signal_id,
 
   if (!handler->next)
     hlist->tail_after = handler;
+
+  handler_mask_update (instance);
+}
+
+static inline void
+node_invalidate_single_va_closure (SignalNode *node)
+{
+  node->single_va_closure_is_valid = FALSE;
+  g_atomic_int_set (&node->trivial_emission, FALSE);
 }
 
 static void
@@ -706,6 +797,8 @@ node_update_single_va_closure (SignalNode *node)
 {
   GClosure *closure = NULL;
   gboolean is_after = FALSE;
+  gboolean trivial;
+  guint offset;
 
   /* Fast path single-handler without boxing the arguments in GValues */
   if (G_TYPE_IS_OBJECT (node->itype) &&
@@ -740,6 +833,30 @@ node_update_single_va_closure (SignalNode *node)
   node->single_va_closure_is_valid = TRUE;
   node->single_va_closure = closure;
   node->single_va_closure_is_after = is_after;
+
+  /* a class closure that only calls a class member is a no-op while
+   * that member is NULL
+   */
+  offset = 0;
+  trivial = (node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE) == G_TYPE_NONE &&
+            (closure == SINGLE_VA_CLOSURE_EMPTY_MAGIC ||
+             (closure != NULL && _g_closure_get_class_offset (closure, &offset)));
+  node->trivial_class_offset = offset;
+  g_atomic_int_set (&node->trivial_emission, trivial);
+}
+
+/* Whether emitting @signal_id only runs its handlers and its default
+ * class closure: there are no emission hooks, and no class closures
+ * overridden with g_signal_override_class_handler() or
+ * g_signal_override_class_closure().  This is read without the signal
+ * lock, and is %FALSE until it has been worked out.
+ */
+gboolean
+_g_signal_has_trivial_emission (guint signal_id)
+{
+  SignalNode *node = signal_node_lookup_unlocked (signal_id);
+
+  return node != NULL && g_atomic_int_get (&node->trivial_emission);
 }
 
 static inline void
@@ -832,9 +949,7 @@ _g_signal_init (void)
       g_signal_key_bsa = g_bsearch_array_create (&g_signal_key_bconfig);
       
       /* invalid (0) signal_id */
-      g_n_signal_nodes = 1;
-      g_signal_nodes = g_renew (SignalNode*, g_signal_nodes, g_n_signal_nodes);
-      g_signal_nodes[0] = NULL;
+      signal_nodes_append (NULL);
     }
   SIGNAL_UNLOCK ();
 }
@@ -980,7 +1095,7 @@ g_signal_add_emission_hook (guint               signal_id,
       SIGNAL_UNLOCK ();
       return 0;
     }
-    node->single_va_closure_is_valid = FALSE;
+    node_invalidate_single_va_closure (node);
   if (!node->emission_hooks)
     {
       node->emission_hooks = g_new (GHookList, 1);
@@ -1032,7 +1147,7 @@ g_signal_remove_emission_hook (guint  signal_id,
   else if (!node->emission_hooks || !g_hook_destroy (node->emission_hooks, hook_id))
     g_warning ("%s: signal \"%s\" had no hook (%lu) to remove", G_STRLOC, node->name, hook_id);
 
-  node->single_va_closure_is_valid = FALSE;
+  node_invalidate_single_va_closure (node);
 
  out:
   SIGNAL_UNLOCK ();
@@ -1534,7 +1649,7 @@ signal_add_class_closure (SignalNode *node,
 {
   ClassClosure key;
 
-  node->single_va_closure_is_valid = FALSE;
+  node_invalidate_single_va_closure (node);
 
   if (!node->class_closure_bsa)
     node->class_closure_bsa = g_bsearch_array_create (&g_class_closure_bconfig);
@@ -1669,11 +1784,12 @@ g_signal_newv (const gchar       *signal_name,
     {
       SignalKey key;
       
-      signal_id = g_n_signal_nodes++;
+      signal_id = g_n_signal_nodes;
       node = g_new (SignalNode, 1);
       node->signal_id = signal_id;
-      g_signal_nodes = g_renew (SignalNode*, g_signal_nodes, g_n_signal_nodes);
-      g_signal_nodes[signal_id] = node;
+      node->trivial_emission = FALSE;
+      node->trivial_class_offset = 0;
+      signal_nodes_append (node);
       node->itype = itype;
       node->name = name;
       key.itype = itype;
@@ -1690,7 +1806,7 @@ g_signal_newv (const gchar       *signal_name,
   node->destroyed = FALSE;
 
   /* setup reinitializable portion */
-  node->single_va_closure_is_valid = FALSE;
+  node_invalidate_single_va_closure (node);
   node->flags = signal_flags & G_SIGNAL_FLAGS_MASK;
   node->n_params = n_params;
   node->param_types = g_memdup (param_types, sizeof (GType) * n_params);
@@ -1744,10 +1860,16 @@ g_signal_newv (const gchar       *signal_name,
       ADD_CHECK (VARIANT)
     }
 
-  if (c_marshaller == NULL)
+  if (c_marshaller == NULL || c_marshaller == g_cclosure_marshal_generic)
     {
       if (builtin_c_marshaller)
 	c_marshaller = builtin_c_marshaller;
+      else if (_g_cclosure_marshal_words_supported (return_type, n_params, param_types))
+        {
+          /* avoid libffi for signals with only pointer and int arguments */
+          c_marshaller = _g_cclosure_marshal_words;
+          va_marshaller = _g_cclosure_marshal_wordsv;
+        }
       else
 	{
 	  c_marshaller = g_cclosure_marshal_generic;
@@ -1790,7 +1912,7 @@ g_signal_set_va_marshaller (guint              signal_id,
 	    _g_closure_set_va_marshal (cc->closure, va_marshaller);
 	}
 
-      node->single_va_closure_is_valid = FALSE;
+      node_invalidate_single_va_closure (node);
     }
 
   SIGNAL_UNLOCK ();
@@ -1866,7 +1988,7 @@ signal_destroy_R (SignalNode *signal_node)
   signal_node->destroyed = TRUE;
   
   /* reentrancy caution, zero out real contents first */
-  signal_node->single_va_closure_is_valid = FALSE;
+  node_invalidate_single_va_closure (signal_node);
   signal_node->n_params = 0;
   signal_node->param_types = NULL;
   signal_node->return_type = 0;
@@ -2639,6 +2761,7 @@ g_signal_handlers_destroy (gpointer instance)
       
       /* reentrancy caution, delete instance trace first */
       g_hash_table_remove (g_handler_list_bsa_ht, instance);
+      handler_mask_update (instance);
       
       for (i = 0; i < hlbsa->n_nodes; i++)
         {
@@ -3109,6 +3232,23 @@ g_signal_emit_valist (gpointer instance,
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (signal_id > 0);
 
+  /* Emitting a signal without emission hooks, return value or class
+   * closure to run on an object without handlers for it does nothing,
+   * so don't serialise on the signal lock for it.
+   */
+  node = signal_node_lookup_unlocked (signal_id);
+  if (node && g_atomic_int_get (&node->trivial_emission) &&
+      (!detail || (node->flags & G_SIGNAL_DETAILED)) &&
+#ifdef	G_ENABLE_DEBUG
+      !COND_DEBUG (SIGNALS, g_trace_instance_signals != instance &&
+                   g_trap_instance_signals == instance) &&
+#endif	/* G_ENABLE_DEBUG */
+      g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype) &&
+      (_g_object_get_signal_handler_mask (instance) & G_SIGNAL_HANDLER_MASK_FOR (signal_id)) == 0 &&
+      (node->trivial_class_offset == 0 ||
+       G_STRUCT_MEMBER (gpointer, ((GTypeInstance *) instance)->g_class, node->trivial_class_offset) == NULL))
+    return;
+
   SIGNAL_LOCK ();
   node = LOOKUP_SIGNAL_NODE (signal_id);
   if (!node || !g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
@@ -3225,6 +3365,8 @@ g_signal_emit_valist (gpointer instance,
 	  SIGNAL_UNLOCK ();
 
 	  TRACE(GOBJECT_SIGNAL_EMIT(signal_id, detail, instance, instance_type));
+	  _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_SIGNAL_EMIT, G_TRACE_PHASE_BEGIN,
+	                               node->name, instance, detail);
 
 	  if (rtype != G_TYPE_NONE)
 	    g_value_init (&emission_return, rtype);
@@ -3283,6 +3425,8 @@ g_signal_emit_valist (gpointer instance,
 	    }
 	  
 	  TRACE(GOBJECT_SIGNAL_EMIT_END(signal_id, detail, instance, instance_type));
+	  _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_SIGNAL_EMIT, G_TRACE_PHASE_END,
+	                               node->name, instance, detail);
 
           if (closure != NULL)
             g_object_unref (instance);
@@ -3461,6 +3605,8 @@ signal_emit_unlocked_R (SignalNode   *node,
 #endif	/* G_ENABLE_DEBUG */
 
   TRACE(GOBJECT_SIGNAL_EMIT(node->signal_id, detail, instance, G_TYPE_FROM_INSTANCE (instance)));
+  _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_SIGNAL_EMIT, G_TRACE_PHASE_BEGIN,
+                               node->name, instance, detail);
 
   SIGNAL_LOCK ();
   signal_id = node->signal_id;
@@ -3722,6 +3868,8 @@ signal_emit_unlocked_R (SignalNode   *node,
     g_value_unset (&accu);
 
   TRACE(GOBJECT_SIGNAL_EMIT_END(node->signal_id, detail, instance, G_TYPE_FROM_INSTANCE (instance)));
+  _G_TYPE_TRACE_BUFFER_RECORD (G_TRACE_EVENT_SIGNAL_EMIT, G_TRACE_PHASE_END,
+                               node->name, instance, detail);
 
   return return_value_altered;
 }
@@ -25,6 +25,8 @@
 
 #include "gboxed.h"
 #include "gclosure.h"
+#include "gobject.h"
+#include "glib-private.h"
 
 G_BEGIN_DECLS
 
@@ -51,6 +53,14 @@ void    _g_param_spec_types_init (void); /* sync with gparamspecs.c */
 void    _g_value_transforms_init (void); /* sync with gvaluetransform.c */
 void    _g_signal_init           (void); /* sync with gsignal.c */
 
+/* for gobject.c and gsignal.c; set from G_TRACE_BUFFER in gtype.c */
+extern gboolean _g_type_trace_buffer_enabled;
+
+#define _G_TYPE_TRACE_BUFFER_RECORD(type, phase, name, object, arg) G_STMT_START { \
+  if (G_UNLIKELY (_g_type_trace_buffer_enabled))                                \
+    GLIB_PRIVATE_CALL (g_trace_buffer_record) (type, phase, name, object, arg); \
+} G_STMT_END
+
 /* for gboxed.c */
 gpointer        _g_type_boxed_copy      (GType          type,
                                          gpointer       value);
@@ -74,6 +84,20 @@ void        _g_closure_invoke_va (GClosure       *closure,
 
 gboolean    g_type_is_in_init    (GType type);
 
+/* Summary of the signals with handlers connected to a GObject, kept by
+ * gsignal.c in the object's qdata: bit 0 is set while the object has
+ * handler lists at all, the other bits are a lossy map of signal ids.
+ */
+#define G_SIGNAL_HANDLER_MASK_ANY               ((gsize) 1)
+#define G_SIGNAL_HANDLER_MASK_FOR(signal_id)    ((gsize) 2 << ((signal_id) % (sizeof (gsize) * 8 - 1)))
+
+void        _g_object_set_signal_handler_mask (GObject *object,
+                                               gsize    mask); /* sync with gobject.c */
+gsize       _g_object_get_signal_handler_mask (GObject *object); /* sync with gobject.c */
+gboolean    _g_closure_get_class_offset (GClosure *closure,
+                                         guint    *offset); /* sync with gclosure.c */
+gboolean    _g_signal_has_trivial_emission (guint signal_id); /* sync with gsignal.c */
+
 G_END_DECLS
 
 #endif /* __G_TYPE_PRIVATE_H__ */
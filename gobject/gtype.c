@@ -141,6 +141,11 @@
 #define DEBUG_CODE(debug_type, code_block)  /* code_block */
 #endif  /* G_ENABLE_DEBUG */
 
+/* Not part of the public GTypeDebugFlags, only settable through
+ * GOBJECT_DEBUG=class-init.
+ */
+#define TYPE_DEBUG_CLASS_INIT (1 << 2)
+
 #define TYPE_FUNDAMENTAL_FLAG_MASK (G_TYPE_FLAG_CLASSED | \
 				    G_TYPE_FLAG_INSTANTIATABLE | \
 				    G_TYPE_FLAG_DERIVABLE | \
@@ -248,6 +253,7 @@ struct _TypeNode
 #define MAX_N_CHILDREN				(4095)
 #define	MAX_N_INTERFACES			(255) /* Limited by offsets being 8 bits */
 #define	MAX_N_PREREQUISITES			(511)
+#define	IFACE_CACHE_SIZE			(4)
 #define NODE_TYPE(node)				(node->supers[0])
 #define NODE_PARENT_TYPE(node)			(node->supers[1])
 #define NODE_FUNDAMENTAL_TYPE(node)		(node->supers[node->n_supers])
@@ -314,6 +320,7 @@ struct _IFaceData
   GClassFinalizeFunc dflt_finalize;
   gconstpointer      dflt_data;
   gpointer           dflt_vtable;
+  int volatile       dflt_vtable_ready; /* atomic - g_type_default_interface_ref reads it unlocked */
 };
 
 struct _ClassData
@@ -346,6 +353,7 @@ struct _InstanceData
   guint16            private_size;
   guint16            n_preallocs;
   GInstanceInitFunc  instance_init;
+  GType volatile     iface_cache[IFACE_CACHE_SIZE]; /* unlocked - see type_instance_conforms_to_I */
 };
 
 union _TypeData
@@ -380,6 +388,7 @@ static GQuark          static_quark_iface_holder = 0;
 static GQuark          static_quark_dependants_array = 0;
 static guint           type_registration_serial = 0;
 GTypeDebugFlags	       _g_type_debug_flags = 0;
+gboolean               _g_type_trace_buffer_enabled = FALSE;
 
 /* --- type nodes --- */
 static GHashTable       *static_type_nodes_ht = NULL;
@@ -1948,6 +1957,11 @@ type_iface_ensure_dflt_vtable_Wm (TypeNode *iface)
   if (!iface->data->iface.dflt_vtable)
     {
       GTypeInterface *vtable = g_malloc0 (iface->data->iface.vtable_size);
+      gint64 start_time = 0;
+
+      if (_g_type_debug_flags & TYPE_DEBUG_CLASS_INIT)
+        start_time = g_get_monotonic_time ();
+
       iface->data->iface.dflt_vtable = vtable;
       vtable->g_type = NODE_TYPE (iface);
       vtable->g_instance_type = 0;
@@ -1961,6 +1975,11 @@ type_iface_ensure_dflt_vtable_Wm (TypeNode *iface)
             iface->data->iface.dflt_init (vtable, (gpointer) iface->data->iface.dflt_data);
           G_WRITE_LOCK (&type_rw_lock);
         }
+      g_atomic_int_set (&iface->data->iface.dflt_vtable_ready, TRUE);
+
+      if (_g_type_debug_flags & TYPE_DEBUG_CLASS_INIT)
+        g_message ("default vtable init of '%s' took %.3f ms", NODE_NAME (iface),
+                   (g_get_monotonic_time () - start_time) / 1000.);
     }
 }
 
@@ -2104,8 +2123,12 @@ type_class_init_Wm (TypeNode   *node,
   IFaceEntries *entries;
   IFaceEntry *entry;
   TypeNode *bnode, *pnode;
+  gint64 start_time = 0;
   guint i;
   
+  if (_g_type_debug_flags & TYPE_DEBUG_CLASS_INIT)
+    start_time = g_get_monotonic_time ();
+
   /* Accessing data->class will work for instantiable types
    * too because ClassData is a subset of InstanceData
    */
@@ -2253,6 +2276,11 @@ type_class_init_Wm (TypeNode   *node,
     }
   
   g_atomic_int_set (&node->data->class.init_state, INITIALIZED);
+
+  /* the time includes classes first referenced from within class_init */
+  if (_g_type_debug_flags & TYPE_DEBUG_CLASS_INIT)
+    g_message ("class init of '%s' took %.3f ms", NODE_NAME (node),
+               (g_get_monotonic_time () - start_time) / 1000.);
 }
 
 static void
@@ -3196,6 +3224,17 @@ g_type_default_interface_ref (GType g_type)
   TypeNode *node;
   gpointer dflt_vtable;
 
+  /* optimize for common code path: an initialized vtable can be
+   * handed out without taking any lock
+   */
+  node = lookup_type_node_I (g_type);
+  if (node && NODE_IS_IFACE (node) && type_data_ref_U (node))
+    {
+      if (G_LIKELY (g_atomic_int_get (&node->data->iface.dflt_vtable_ready)))
+        return node->data->iface.dflt_vtable;
+      type_data_unref_U (node, FALSE);
+    }
+
   G_WRITE_LOCK (&type_rw_lock);
 
   node = lookup_type_node_I (g_type);
@@ -3208,7 +3247,10 @@ g_type_default_interface_ref (GType g_type)
       return NULL;
     }
 
-  if (!node->data || !node->data->iface.dflt_vtable)
+  /* a vtable which is not ready yet is being initialized by another
+   * thread (wait for it) or by a recursive call from this one
+   */
+  if (!node->data || !g_atomic_int_get (&node->data->iface.dflt_vtable_ready))
     {
       G_WRITE_UNLOCK (&type_rw_lock);
       g_rec_mutex_lock (&class_init_rec_mutex); /* required locking order: 1) class_init_rec_mutex, 2) type_rw_lock */
@@ -3489,6 +3531,45 @@ type_node_conforms_to_U (TypeNode *node,
   return type_node_check_conformities_UorL (node, iface_node, support_interfaces, support_prerequisites, FALSE);
 }
 
+/* Interfaces are never removed from a type once added, so a successful
+ * interface check on an instance can be remembered in the data of its
+ * type without any locking.  The cache holds the interfaces that most
+ * recently matched; a racing update can at worst duplicate or drop an
+ * entry, which only costs another full lookup.
+ */
+static inline gboolean
+type_instance_conforms_to_I (TypeNode *node,
+			     TypeNode *iface_node)
+{
+  TypeData *data;
+  GType iface_type;
+  guint i;
+
+  if (!NODE_IS_IFACE (iface_node))
+    return type_node_conforms_to_U (node, iface_node, TRUE, FALSE);
+
+  /* instances hold a reference on their class, so data can't go away */
+  data = node->data;
+  iface_type = NODE_TYPE (iface_node);
+
+  if (data)
+    for (i = 0; i < IFACE_CACHE_SIZE; i++)
+      if (data->instance.iface_cache[i] == iface_type)
+	return TRUE;
+
+  if (!type_lookup_iface_vtable_I (node, iface_node, NULL))
+    return FALSE;
+
+  if (data)
+    {
+      for (i = IFACE_CACHE_SIZE - 1; i > 0; i--)
+	data->instance.iface_cache[i] = data->instance.iface_cache[i - 1];
+      data->instance.iface_cache[0] = iface_type;
+    }
+
+  return TRUE;
+}
+
 /**
  * g_type_is_a:
  * @type: Type to check anchestry for.
@@ -3972,7 +4053,7 @@ g_type_check_instance_is_a (GTypeInstance *type_instance,
   
   node = lookup_type_node_I (type_instance->g_class->g_type);
   iface = lookup_type_node_I (iface_type);
-  check = node && node->is_instantiatable && iface && type_node_conforms_to_U (node, iface, TRUE, FALSE);
+  check = node && node->is_instantiatable && iface && type_instance_conforms_to_I (node, iface);
   
   return check;
 }
@@ -4008,7 +4089,7 @@ g_type_check_instance_cast (GTypeInstance *type_instance,
 	  node = lookup_type_node_I (type_instance->g_class->g_type);
 	  is_instantiatable = node && node->is_instantiatable;
 	  iface = lookup_type_node_I (iface_type);
-	  check = is_instantiatable && iface && type_node_conforms_to_U (node, iface, TRUE, FALSE);
+	  check = is_instantiatable && iface && type_instance_conforms_to_I (node, iface);
 	  if (check)
 	    return type_instance;
 	  
@@ -4332,10 +4413,13 @@ gobject_init_ctor (void)
       GDebugKey debug_keys[] = {
         { "objects", G_TYPE_DEBUG_OBJECTS },
         { "signals", G_TYPE_DEBUG_SIGNALS },
+        { "class-init", TYPE_DEBUG_CLASS_INIT },
       };
 
       _g_type_debug_flags = g_parse_debug_string (env_string, debug_keys, G_N_ELEMENTS (debug_keys));
     }
+
+  _g_type_trace_buffer_enabled = GLIB_PRIVATE_CALL (g_trace_buffer_enabled) ();
   
   /* quarks */
   static_quark_type_flags = g_quark_from_static_string ("-g-type-private--GTypeFlags");
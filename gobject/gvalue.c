@@ -121,6 +121,20 @@ typedef struct {
   GValueTransform func;
 } TransformEntry;
 
+/* A remembered result of transform_func_lookup(), which may be NULL.
+ * The sequence number is odd while the entry is being written, so that
+ * it can be read without a lock, seqlock style.
+ */
+typedef struct {
+  volatile gint   seq;
+  gint            generation;
+  GType           src_type;
+  GType           dest_type;
+  GValueTransform func;
+} TransformCacheEntry;
+
+#define TRANSFORM_CACHE_SIZE 64
+
 
 /* --- prototypes --- */
 static gint	transform_entries_cmp	(gconstpointer bsearch_node1,
@@ -134,6 +148,10 @@ static GBSearchConfig transform_bconfig = {
   transform_entries_cmp,
   G_BSEARCH_ARRAY_ALIGN_POWER2,
 };
+static TransformCacheEntry transform_cache[TRANSFORM_CACHE_SIZE];
+/* bumped whenever a transform function is registered; starts at 1 so
+ * that the zeroed cache entries are invalid */
+static volatile gint transform_cache_generation = 1;
 
 
 /* --- functions --- */
@@ -375,7 +393,7 @@ g_value_set_instance (GValue  *value,
 }
 
 static GValueTransform
-transform_func_lookup (GType src_type,
+transform_func_search (GType src_type,
 		       GType dest_type)
 {
   TransformEntry entry;
@@ -407,6 +425,74 @@ transform_func_lookup (GType src_type,
   return NULL;
 }
 
+static inline TransformCacheEntry *
+transform_cache_entry (GType src_type,
+                       GType dest_type)
+{
+  return &transform_cache[((src_type >> 2) * 31 + (dest_type >> 2)) % TRANSFORM_CACHE_SIZE];
+}
+
+static gboolean
+transform_cache_lookup (GType            src_type,
+                        GType            dest_type,
+                        GValueTransform *func)
+{
+  TransformCacheEntry *entry = transform_cache_entry (src_type, dest_type);
+  gboolean hit;
+  gint seq;
+
+  seq = g_atomic_int_get (&entry->seq);
+  if (seq & 1)
+    return FALSE;
+
+  hit = (entry->generation == g_atomic_int_get (&transform_cache_generation) &&
+         entry->src_type == src_type &&
+         entry->dest_type == dest_type);
+  *func = entry->func;
+
+  /* the entry must not have changed while we read it */
+  return hit && g_atomic_int_get (&entry->seq) == seq;
+}
+
+static void
+transform_cache_store (GType           src_type,
+                       GType           dest_type,
+                       GValueTransform func,
+                       gint            generation)
+{
+  TransformCacheEntry *entry = transform_cache_entry (src_type, dest_type);
+  gint seq;
+
+  /* if another thread is writing this entry, leave it to them */
+  seq = g_atomic_int_get (&entry->seq);
+  if ((seq & 1) || !g_atomic_int_compare_and_exchange (&entry->seq, seq, seq + 1))
+    return;
+
+  entry->generation = generation;
+  entry->src_type = src_type;
+  entry->dest_type = dest_type;
+  entry->func = func;
+
+  g_atomic_int_inc (&entry->seq);
+}
+
+static GValueTransform
+transform_func_lookup (GType src_type,
+		       GType dest_type)
+{
+  GValueTransform func;
+  gint generation;
+
+  if (transform_cache_lookup (src_type, dest_type, &func))
+    return func;
+
+  generation = g_atomic_int_get (&transform_cache_generation);
+  func = transform_func_search (src_type, dest_type);
+  transform_cache_store (src_type, dest_type, func, generation);
+
+  return func;
+}
+
 static gint
 transform_entries_cmp (gconstpointer bsearch_node1,
 		       gconstpointer bsearch_node2)
@@ -458,6 +544,9 @@ g_value_register_transform_func (GType           src_type,
 
   entry.func = transform_func;
   transform_array = g_bsearch_array_replace (transform_array, &transform_bconfig, &entry);
+
+  /* forget cached lookups, including ones that found nothing */
+  g_atomic_int_inc (&transform_cache_generation);
 }
 
 /**
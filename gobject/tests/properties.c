@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <gstdio.h>
 #include <glib-object.h>
 
@@ -215,6 +216,87 @@ properties_notify (void)
   g_object_unref (obj);
 }
 
+static void
+count_notify (GObject    *gobject,
+              GParamSpec *pspec,
+              gint       *counter)
+{
+  (*counter)++;
+}
+
+static void
+properties_notify_late_handler (void)
+{
+  TestObject *obj = g_object_new (test_object_get_type (), NULL);
+  gint counter = 0;
+
+  /* nothing is listening yet, so these notifications go nowhere */
+  g_object_set (obj, "foo", 47, NULL);
+  g_object_notify_by_pspec (G_OBJECT (obj), properties[PROP_FOO]);
+  g_assert_cmpint (obj->foo, ==, 47);
+
+  g_signal_connect (obj, "notify", G_CALLBACK (count_notify), &counter);
+
+  g_object_set (obj, "foo", 48, NULL);
+  g_assert_cmpint (counter, ==, 1);
+
+  g_object_freeze_notify (G_OBJECT (obj));
+  g_object_set (obj, "foo", 49, "bar", FALSE, NULL);
+  g_object_notify_by_pspec (G_OBJECT (obj), properties[PROP_FOO]);
+  g_assert_cmpint (counter, ==, 1);
+  g_object_thaw_notify (G_OBJECT (obj));
+  g_assert_cmpint (counter, ==, 3);
+
+  g_object_unref (obj);
+}
+
+typedef struct _OverrideObject {
+  TestObject parent_instance;
+} OverrideObject;
+
+typedef struct _OverrideObjectClass {
+  TestObjectClass parent_class;
+} OverrideObjectClass;
+
+static GType override_object_get_type (void);
+G_DEFINE_TYPE (OverrideObject, override_object, test_object_get_type ());
+
+static gint override_notify_count = 0;
+
+static void
+override_object_notify (GObject    *gobject,
+                        GParamSpec *pspec)
+{
+  override_notify_count++;
+}
+
+static void
+override_object_class_init (OverrideObjectClass *klass)
+{
+  g_signal_override_class_handler ("notify", override_object_get_type (),
+                                   G_CALLBACK (override_object_notify));
+}
+
+static void
+override_object_init (OverrideObject *self)
+{
+}
+
+static void
+properties_notify_override (void)
+{
+  TestObject *obj = g_object_new (override_object_get_type (), NULL);
+
+  /* an overridden class handler listens without any handler connected */
+  g_object_set (obj, "foo", 47, NULL);
+  g_assert_cmpint (override_notify_count, ==, 1);
+
+  g_object_notify_by_pspec (G_OBJECT (obj), properties[PROP_FOO]);
+  g_assert_cmpint (override_notify_count, ==, 2);
+
+  g_object_unref (obj);
+}
+
 static void
 properties_construct (void)
 {
@@ -260,6 +342,70 @@ properties_construct (void)
   g_object_unref (obj);
 }
 
+static void
+properties_construct_names (void)
+{
+  TestObject *obj;
+  gchar *name;
+  gint i;
+
+  for (i = 0; i < 3; i++)
+    {
+      obj = g_object_new (test_object_get_type (), "foo", i, "baz", "boo", NULL);
+      g_assert_cmpint (obj->foo, ==, i);
+      g_assert_cmpstr (obj->baz, ==, "boo");
+      g_object_unref (obj);
+    }
+
+  /* the same address holding different names must not be confused */
+  name = g_strdup ("foo");
+  obj = g_object_new (test_object_get_type (), name, 7, NULL);
+  g_assert_cmpint (obj->foo, ==, 7);
+  g_object_unref (obj);
+
+  strcpy (name, "bar");
+  obj = g_object_new (test_object_get_type (), name, FALSE, NULL);
+  g_assert_cmpint (obj->foo, ==, 42);
+  g_assert (!obj->bar);
+  g_object_unref (obj);
+  g_free (name);
+}
+
+static void
+properties_set_get_names (void)
+{
+  TestObject *obj;
+  GValue value = G_VALUE_INIT;
+  gchar *name;
+  gchar *baz;
+  gint foo;
+
+  obj = g_object_new (test_object_get_type (), NULL);
+
+  g_object_set (obj, "foo", 1, "baz", "one", NULL);
+  g_object_get (obj, "foo", &foo, "baz", &baz, NULL);
+  g_assert_cmpint (foo, ==, 1);
+  g_assert_cmpstr (baz, ==, "one");
+  g_free (baz);
+
+  /* a name at a reused address must be looked up again */
+  name = g_strdup ("foo");
+  g_value_init (&value, G_TYPE_INT);
+  g_value_set_int (&value, 2);
+  g_object_set_property (G_OBJECT (obj), name, &value);
+  g_value_unset (&value);
+  g_assert_cmpint (obj->foo, ==, 2);
+
+  strcpy (name, "baz");
+  g_value_init (&value, G_TYPE_STRING);
+  g_object_get_property (G_OBJECT (obj), name, &value);
+  g_assert_cmpstr (g_value_get_string (&value), ==, "one");
+  g_value_unset (&value);
+  g_free (name);
+
+  g_object_unref (obj);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -269,7 +415,11 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/properties/install", properties_install);
   g_test_add_func ("/properties/notify", properties_notify);
+  g_test_add_func ("/properties/notify-late-handler", properties_notify_late_handler);
+  g_test_add_func ("/properties/notify-override", properties_notify_override);
   g_test_add_func ("/properties/construct", properties_construct);
+  g_test_add_func ("/properties/construct-names", properties_construct_names);
+  g_test_add_func ("/properties/set-get-names", properties_set_get_names);
 
   return g_test_run ();
 }
@@ -347,6 +347,32 @@ test_class_init (TestClass *klass)
                 G_TYPE_VARIANT,
 		G_TYPE_INT64,
 		G_TYPE_UINT64);
+  g_signal_new ("word-marshaller",
+                G_TYPE_FROM_CLASS (klass),
+                G_SIGNAL_RUN_LAST,
+                0,
+                NULL, NULL,
+                NULL,
+                G_TYPE_NONE,
+                3,
+                G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_OBJECT);
+  g_signal_new ("word-marshaller-boolean-return",
+                G_TYPE_FROM_CLASS (klass),
+                G_SIGNAL_RUN_LAST,
+                0,
+                NULL, NULL,
+                NULL,
+                G_TYPE_BOOLEAN,
+                2,
+                test_enum_get_type (), G_TYPE_POINTER);
+  g_signal_new ("empty-emission",
+                G_TYPE_FROM_CLASS (klass),
+                G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                0,
+                NULL, NULL,
+                NULL,
+                G_TYPE_NONE,
+                0);
 }
 
 static void
@@ -441,6 +467,73 @@ test_generic_marshaller_signal_2 (void)
   g_object_unref (test);
 }
 
+static void
+on_word_marshaller (Test        *obj,
+                    const gchar *v_string,
+                    gboolean     v_boolean,
+                    GObject     *v_object,
+                    gint        *count)
+{
+  g_assert_cmpstr (v_string, ==, "word");
+  g_assert (v_boolean);
+  g_assert (v_object == (GObject *) obj);
+  (*count)++;
+}
+
+static gboolean
+on_word_marshaller_boolean_return (Test     *obj,
+                                   TestEnum  v_enum,
+                                   gint     *count)
+{
+  g_assert_cmpint (v_enum, ==, TEST_ENUM_BAR);
+  (*count)++;
+
+  return TRUE;
+}
+
+static void
+test_word_marshaller (void)
+{
+  Test *test;
+  GValue args[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  GValue result = G_VALUE_INIT;
+  gboolean retval = FALSE;
+  gint count = 0;
+  guint id;
+
+  test = g_object_new (test_get_type (), NULL);
+
+  g_signal_connect (test, "word-marshaller", G_CALLBACK (on_word_marshaller), &count);
+  g_signal_connect (test, "word-marshaller-boolean-return",
+                    G_CALLBACK (on_word_marshaller_boolean_return), NULL);
+
+  /* va_list emission */
+  g_signal_emit_by_name (test, "word-marshaller", "word", TRUE, test);
+  g_assert_cmpint (count, ==, 1);
+  g_signal_emit_by_name (test, "word-marshaller-boolean-return", TEST_ENUM_BAR, &count, &retval);
+  g_assert (retval);
+  g_assert_cmpint (count, ==, 2);
+
+  /* GValue emission */
+  id = g_signal_lookup ("word-marshaller-boolean-return", test_get_type ());
+  g_value_init (&args[0], test_get_type ());
+  g_value_set_object (&args[0], test);
+  g_value_init (&args[1], test_enum_get_type ());
+  g_value_set_enum (&args[1], TEST_ENUM_BAR);
+  g_value_init (&args[2], G_TYPE_POINTER);
+  g_value_set_pointer (&args[2], &count);
+  g_value_init (&result, G_TYPE_BOOLEAN);
+  g_signal_emitv (args, id, 0, &result);
+  g_assert (g_value_get_boolean (&result));
+  g_assert_cmpint (count, ==, 3);
+
+  g_value_unset (&args[0]);
+  g_value_unset (&args[1]);
+  g_value_unset (&args[2]);
+  g_value_unset (&result);
+  g_object_unref (test);
+}
+
 static TestEnum
 on_generic_marshaller_enum_return_signed_1 (Test *obj)
 {
@@ -874,6 +967,68 @@ test_emission_hook (void)
   g_assert_cmpint (count, ==, 2);
 }
 
+static void
+count_handler (GObject *instance,
+               gint    *count)
+{
+  (*count)++;
+}
+
+static void
+count_class_handler (GObject *instance,
+                     gpointer data)
+{
+  g_object_set_data (instance, "count", GINT_TO_POINTER (1));
+}
+
+static void
+test_empty_emission (void)
+{
+  GObject *test1, *test2;
+  gint count = 0;
+  gulong handler;
+  gulong hook;
+  guint id;
+
+  test1 = g_object_new (test_get_type (), NULL);
+  test2 = g_object_new (test_get_type (), NULL);
+  id = g_signal_lookup ("empty-emission", test_get_type ());
+
+  /* nothing to run; repeated emissions may skip the signal lock */
+  g_signal_emit (test1, id, 0);
+  g_signal_emit (test1, id, g_quark_from_static_string ("detail"));
+
+  /* a handler on one object must be seen, without affecting the other */
+  handler = g_signal_connect (test2, "empty-emission", G_CALLBACK (count_handler), &count);
+  g_signal_emit (test2, id, 0);
+  g_assert_cmpint (count, ==, 1);
+  g_signal_emit (test1, id, 0);
+  g_assert_cmpint (count, ==, 1);
+  g_signal_handler_disconnect (test2, handler);
+  g_signal_emit (test2, id, 0);
+  g_assert_cmpint (count, ==, 1);
+  handler = g_signal_connect (test2, "empty-emission::detail", G_CALLBACK (count_handler), &count);
+  g_signal_emit (test2, id, g_quark_from_static_string ("detail"));
+  g_assert_cmpint (count, ==, 2);
+  g_signal_handler_disconnect (test2, handler);
+
+  /* so must emission hooks and class handlers added later */
+  hook = g_signal_add_emission_hook (id, 0, hook_func, &count, NULL);
+  g_signal_emit (test1, id, 0);
+  g_assert_cmpint (count, ==, 3);
+  g_signal_remove_emission_hook (id, hook);
+  g_signal_emit (test1, id, 0);
+  g_assert_cmpint (count, ==, 3);
+
+  g_signal_override_class_handler ("empty-emission", test_get_type (),
+                                   G_CALLBACK (count_class_handler));
+  g_signal_emit (test1, id, 0);
+  g_assert (g_object_get_data (test1, "count") != NULL);
+
+  g_object_unref (test1);
+  g_object_unref (test2);
+}
+
 static gboolean
 in_set (const gchar *s,
         const gchar *set[])
@@ -913,6 +1068,9 @@ test_introspection (void)
     "all-types-generic",
     "all-types-null",
     "all-types-empty",
+    "word-marshaller",
+    "word-marshaller-boolean-return",
+    "empty-emission",
     NULL
   };
   GSignalQuery query;
@@ -1039,6 +1197,46 @@ test_stop_emission (void)
   g_object_unref (test1);
 }
 
+static void
+count_destroy (gpointer data, GClosure *closure)
+{
+  gint *count = data;
+
+  (*count)++;
+}
+
+static void
+test_destroy_handlers (void)
+{
+  GObject *test1, *test2;
+  gint count = 0;
+
+  /* handlers are destroyed when the object goes away, including
+   * the ones that were connected and then disconnected again
+   */
+  test1 = g_object_new (test_get_type (), NULL);
+  g_signal_connect_data (test1, "simple", G_CALLBACK (dont_reach),
+                         &count, count_destroy, 0);
+  g_object_unref (test1);
+  g_assert_cmpint (count, ==, 1);
+
+  test2 = g_object_new (test_get_type (), NULL);
+  g_signal_handler_disconnect (test2,
+                               g_signal_connect_data (test2, "simple", G_CALLBACK (dont_reach),
+                                                      &count, count_destroy, 0));
+  g_assert_cmpint (count, ==, 2);
+  g_signal_connect_data (test2, "simple", G_CALLBACK (dont_reach),
+                         &count, count_destroy, G_CONNECT_AFTER);
+  g_object_run_dispose (test2);
+  g_assert_cmpint (count, ==, 3);
+  g_object_unref (test2);
+  g_assert_cmpint (count, ==, 3);
+
+  /* objects without handlers are finalized as usual */
+  test1 = g_object_new (test_get_type (), NULL);
+  g_object_unref (test1);
+}
+
 /* --- */
 
 int
@@ -1056,11 +1254,14 @@ main (int argc,
   g_test_add_func ("/gobject/signals/generic-marshaller-enum-return-unsigned", test_generic_marshaller_signal_enum_return_unsigned);
   g_test_add_func ("/gobject/signals/generic-marshaller-int-return", test_generic_marshaller_signal_int_return);
   g_test_add_func ("/gobject/signals/generic-marshaller-uint-return", test_generic_marshaller_signal_uint_return);
+  g_test_add_func ("/gobject/signals/word-marshaller", test_word_marshaller);
   g_test_add_func ("/gobject/signals/connect", test_connect);
   g_test_add_func ("/gobject/signals/emission-hook", test_emission_hook);
+  g_test_add_func ("/gobject/signals/empty-emission", test_empty_emission);
   g_test_add_func ("/gobject/signals/introspection", test_introspection);
   g_test_add_func ("/gobject/signals/block-handler", test_block_handler);
   g_test_add_func ("/gobject/signals/stop-emission", test_stop_emission);
+  g_test_add_func ("/gobject/signals/destroy-handlers", test_destroy_handlers);
 
   return g_test_run ();
 }
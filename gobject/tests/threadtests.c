@@ -215,6 +215,54 @@ test_threaded_object_init (void)
   g_thread_join (creator);
 }
 
+typedef struct {
+  GTypeInterface parent_iface;
+  gint magic;
+} SlowFaceInterface;
+typedef GObject SlowFace;
+static GType slow_face_get_type (void);
+G_DEFINE_INTERFACE (SlowFace, slow_face, G_TYPE_OBJECT);
+static void
+slow_face_default_init (SlowFaceInterface *iface)
+{
+  g_usleep (10 * 1000); /* give the other threads a chance to see a partial vtable */
+  iface->magic = 42;
+}
+
+static gpointer
+default_interface_ref_thread (gpointer data)
+{
+  SlowFaceInterface *iface;
+  int i;
+
+  g_mutex_lock (&sync_mutex);
+  g_mutex_unlock (&sync_mutex);
+
+  for (i = 0; i < 1000; i++)
+    {
+      iface = g_type_default_interface_ref (slow_face_get_type ());
+      g_assert_cmpint (iface->magic, ==, 42);
+      g_type_default_interface_unref (iface);
+    }
+
+  return NULL;
+}
+
+static void
+test_threaded_default_interface_ref (void)
+{
+  GThread *threads[4];
+  int i;
+
+  g_mutex_lock (&sync_mutex);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("ref", default_interface_ref_thread, NULL);
+  g_mutex_unlock (&sync_mutex);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+}
+
 typedef struct {
     MyTester0 *strong;
     guint unref_delay;
@@ -335,6 +383,66 @@ test_threaded_weak_ref (void)
              get_wins, unref_wins);
 }
 
+typedef struct {
+    GWeakRef   *weak;
+    MyTester0 **objects;
+    guint       n_objects;
+} WeakRefSetData;
+
+static gpointer
+weak_ref_set_in_thread (gpointer p)
+{
+  WeakRefSetData *data = p;
+  guint i;
+
+  for (i = 0; i < 10000; i++)
+    {
+      MyTester0 *strong;
+
+      g_weak_ref_set (data->weak, data->objects[g_random_int_range (0, data->n_objects)]);
+
+      strong = g_weak_ref_get (data->weak);
+      g_assert (strong != NULL);
+      g_assert (G_IS_OBJECT (strong));
+      g_object_unref (strong);
+    }
+
+  return NULL;
+}
+
+static void
+test_threaded_weak_ref_set (void)
+{
+  MyTester0 *objects[8];
+  GThread *threads[4];
+  WeakRefSetData data;
+  GWeakRef weak;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (objects); i++)
+    objects[i] = g_object_new (my_tester0_get_type (), NULL);
+
+  /* threads keep moving one weak ref between objects, which needs the
+   * locks of both the old and the new object
+   */
+  g_weak_ref_init (&weak, objects[0]);
+  data.weak = &weak;
+  data.objects = objects;
+  data.n_objects = G_N_ELEMENTS (objects);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("weak-ref-set", weak_ref_set_in_thread, &data);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+
+  /* dropping the object the ref points to last must still clear it */
+  for (i = 0; i < G_N_ELEMENTS (objects); i++)
+    g_object_unref (objects[i]);
+  g_assert (g_weak_ref_get (&weak) == NULL);
+
+  g_weak_ref_clear (&weak);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -343,7 +451,9 @@ main (int   argc,
 
   /* g_test_add_func ("/GObject/threaded-class-init", test_threaded_class_init); */
   g_test_add_func ("/GObject/threaded-object-init", test_threaded_object_init);
+  g_test_add_func ("/GObject/threaded-default-interface-ref", test_threaded_default_interface_ref);
   g_test_add_func ("/GObject/threaded-weak-ref", test_threaded_weak_ref);
+  g_test_add_func ("/GObject/threaded-weak-ref/set", test_threaded_weak_ref_set);
 
   return g_test_run();
 }
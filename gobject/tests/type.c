@@ -128,6 +128,51 @@ test_interface_check (void)
   g_type_remove_interface_check (&check_called, check_func);
 }
 
+static void
+test_instance_is_a (void)
+{
+  const GInterfaceInfo iface_info = { NULL, NULL, NULL };
+  GType ifaces[7];
+  GType type;
+  GObject *o;
+  gint i, j;
+
+  /* more interfaces than are remembered per type, plus one that isn't
+   * implemented at all
+   */
+  for (i = 0; i < G_N_ELEMENTS (ifaces); i++)
+    {
+      gchar *name = g_strdup_printf ("IsAIface%d", i);
+
+      ifaces[i] = g_type_register_static_simple (G_TYPE_INTERFACE, name,
+                                                 sizeof (GTypeInterface),
+                                                 NULL, 0, NULL, 0);
+      g_free (name);
+    }
+
+  type = g_type_register_static_simple (G_TYPE_OBJECT, "IsAObject",
+                                        sizeof (GObjectClass), NULL,
+                                        sizeof (GObject), NULL, 0);
+  for (i = 0; i < G_N_ELEMENTS (ifaces) - 1; i++)
+    g_type_add_interface_static (type, ifaces[i], &iface_info);
+
+  o = g_object_new (type, NULL);
+
+  for (j = 0; j < 3; j++)
+    for (i = 0; i < G_N_ELEMENTS (ifaces); i++)
+      {
+        gboolean expected = i < G_N_ELEMENTS (ifaces) - 1;
+
+        g_assert_cmpint (G_TYPE_CHECK_INSTANCE_TYPE (o, ifaces[i]), ==, expected);
+        g_assert_cmpint (G_TYPE_CHECK_INSTANCE_TYPE (o, ifaces[i]), ==, expected);
+      }
+
+  g_assert (G_TYPE_CHECK_INSTANCE_TYPE (o, G_TYPE_OBJECT));
+  g_assert (!G_TYPE_CHECK_INSTANCE_TYPE (o, baz_get_type ()));
+
+  g_object_unref (o);
+}
+
 static void
 test_next_base (void)
 {
@@ -146,6 +191,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/type/registration-serial", test_registration_serial);
   g_test_add_func ("/type/interface-prerequisite", test_interface_prerequisite);
   g_test_add_func ("/type/interface-check", test_interface_check);
+  g_test_add_func ("/type/instance-is-a", test_instance_is_a);
   g_test_add_func ("/type/next-base", test_next_base);
 
   return g_test_run ();
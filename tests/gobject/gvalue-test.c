@@ -383,6 +383,37 @@ test_copying (void)
   }
 }
 
+static void
+pointer_to_int (const GValue *src_value,
+                GValue       *dest_value)
+{
+  g_value_set_int (dest_value, GPOINTER_TO_INT (g_value_get_pointer (src_value)));
+}
+
+static void
+test_transform_registration (void)
+{
+  GValue src = G_VALUE_INIT;
+  GValue dest = G_VALUE_INIT;
+  GType type;
+
+  type = g_pointer_type_register_static ("TestTransformPointer");
+  g_value_init (&src, type);
+  g_value_set_pointer (&src, GINT_TO_POINTER (42));
+  g_value_init (&dest, G_TYPE_INT);
+
+  /* a failed lookup must not stick once a function is registered */
+  g_assert (!g_value_type_transformable (type, G_TYPE_INT));
+  g_assert (!g_value_transform (&src, &dest));
+
+  g_value_register_transform_func (type, G_TYPE_INT, pointer_to_int);
+  g_assert (g_value_type_transformable (type, G_TYPE_INT));
+  g_assert (g_value_transform (&src, &dest));
+  g_assert_cmpint (g_value_get_int (&dest), ==, 42);
+
+  g_value_unset (&src);
+  g_value_unset (&dest);
+}
 
 int
 main (int argc, char *argv[])
@@ -393,6 +424,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/gvalue/gtype", test_gtype_value);
   g_test_add_func ("/gvalue/collection", test_collection);
   g_test_add_func ("/gvalue/copying", test_copying);
+  g_test_add_func ("/gvalue/transform-registration", test_transform_registration);
 
   return g_test_run ();
 }
@@ -138,6 +138,203 @@ liststore_interface_peek_same_run (gpointer klass)
     }
 }
 
+/* An object with an int property and a signal without class handler,
+ * for the contention tests below.
+ */
+
+typedef struct {
+  GObject parent_instance;
+  gint value;
+} PerfObject;
+
+typedef struct {
+  GObjectClass parent_class;
+} PerfObjectClass;
+
+enum {
+  PROP_0,
+  PROP_VALUE
+};
+
+static guint perf_object_changed_signal;
+
+static GType perf_object_get_type (void);
+G_DEFINE_TYPE (PerfObject, perf_object, G_TYPE_OBJECT)
+
+static void
+perf_object_set_property (GObject      *object,
+                          guint         prop_id,
+                          const GValue *value,
+                          GParamSpec   *pspec)
+{
+  ((PerfObject *) object)->value = g_value_get_int (value);
+}
+
+static void
+perf_object_get_property (GObject    *object,
+                          guint       prop_id,
+                          GValue     *value,
+                          GParamSpec *pspec)
+{
+  g_value_set_int (value, ((PerfObject *) object)->value);
+}
+
+static void
+perf_object_init (PerfObject *object)
+{
+}
+
+static void
+perf_object_class_init (PerfObjectClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->set_property = perf_object_set_property;
+  object_class->get_property = perf_object_get_property;
+
+  g_object_class_install_property (object_class, PROP_VALUE,
+                                   g_param_spec_int ("value", "Value", "Value",
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READWRITE));
+
+  perf_object_changed_signal = g_signal_new ("changed", G_TYPE_FROM_CLASS (class),
+                                             G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                                             NULL, G_TYPE_NONE, 0);
+}
+
+#define N_CONTENTION_OPS 1000
+
+/* One object that every thread works on */
+static gpointer
+shared_object_setup (void)
+{
+  static volatile gsize shared = 0;
+
+  if (g_once_init_enter (&shared))
+    g_once_init_leave (&shared, (gsize) g_object_new (perf_object_get_type (), NULL));
+
+  return g_object_ref ((gpointer) shared);
+}
+
+/* One object per thread */
+static gpointer
+private_object_setup (void)
+{
+  return g_object_new (perf_object_get_type (), NULL);
+}
+
+static void
+ref_unref_run (gpointer data)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    {
+      g_object_ref (data);
+      g_object_unref (data);
+    }
+}
+
+static void
+weak_ref_get_run (gpointer data)
+{
+  GWeakRef weak_ref;
+  guint i;
+
+  g_weak_ref_init (&weak_ref, data);
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    g_object_unref (g_weak_ref_get (&weak_ref));
+  g_weak_ref_clear (&weak_ref);
+}
+
+static void
+weak_notify (gpointer  data,
+             GObject  *where_the_object_was)
+{
+}
+
+static void
+weak_ref_add_remove_run (gpointer data)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    {
+      g_object_weak_ref (data, weak_notify, NULL);
+      g_object_weak_unref (data, weak_notify, NULL);
+    }
+}
+
+static void
+freeze_thaw_run (gpointer data)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    {
+      g_object_freeze_notify (data);
+      g_object_thaw_notify (data);
+    }
+}
+
+static void
+emit_run (gpointer data)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    g_signal_emit (data, perf_object_changed_signal, 0);
+}
+
+static void
+changed_handler (gpointer object,
+                 gpointer data)
+{
+}
+
+static gpointer
+private_object_with_handler_setup (void)
+{
+  gpointer object = private_object_setup ();
+
+  g_signal_connect (object, "changed", G_CALLBACK (changed_handler), NULL);
+
+  return object;
+}
+
+static void
+set_get_property_run (gpointer data)
+{
+  gint value;
+  guint i;
+
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    {
+      g_object_set (data, "value", i, NULL);
+      g_object_get (data, "value", &value, NULL);
+    }
+}
+
+static gpointer
+liststore_object_setup (void)
+{
+  register_types ();
+  return g_object_new (liststore, NULL);
+}
+
+static void
+interface_cast_run (gpointer data)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTENTION_OPS; i++)
+    {
+      G_TYPE_CHECK_INSTANCE_CAST (data, liststore_interfaces[0], GTypeInstance);
+      G_TYPE_CHECK_INSTANCE_CAST (data, liststore_interfaces[2], GTypeInstance);
+      G_TYPE_CHECK_INSTANCE_CAST (data, liststore_interfaces[4], GTypeInstance);
+    }
+}
+
 #if 0
 /* DUMB test doing nothing */
 
@@ -166,6 +363,7 @@ no_teardown (gpointer data)
 typedef struct _PerformanceTest PerformanceTest;
 struct _PerformanceTest {
   const char *name;
+  guint n_ops;  /* operations done by one call to run() */
 
   gpointer (*setup) (void);
   void (*run) (gpointer data);
@@ -175,22 +373,92 @@ struct _PerformanceTest {
 
 static const PerformanceTest tests[] = {
   { "liststore-is-a",
+    6000,
     register_types,
     liststore_is_a_run,
     no_reset,
     no_teardown },
   { "liststore-interface-peek",
+    5000,
     liststore_get_class,
     liststore_interface_peek_run,
     no_reset,
     g_type_class_unref },
   { "liststore-interface-peek-same",
+    5000,
     liststore_get_class,
     liststore_interface_peek_same_run,
     no_reset,
     g_type_class_unref },
+  { "interface-cast",
+    3 * N_CONTENTION_OPS,
+    liststore_object_setup,
+    interface_cast_run,
+    no_reset,
+    g_object_unref },
+  { "ref-unref-shared",
+    N_CONTENTION_OPS,
+    shared_object_setup,
+    ref_unref_run,
+    no_reset,
+    g_object_unref },
+  { "ref-unref-private",
+    N_CONTENTION_OPS,
+    private_object_setup,
+    ref_unref_run,
+    no_reset,
+    g_object_unref },
+  { "weak-ref-get-shared",
+    N_CONTENTION_OPS,
+    shared_object_setup,
+    weak_ref_get_run,
+    no_reset,
+    g_object_unref },
+  { "weak-ref-get-private",
+    N_CONTENTION_OPS,
+    private_object_setup,
+    weak_ref_get_run,
+    no_reset,
+    g_object_unref },
+  { "weak-ref-add-remove-private",
+    N_CONTENTION_OPS,
+    private_object_setup,
+    weak_ref_add_remove_run,
+    no_reset,
+    g_object_unref },
+  { "notify-freeze-thaw-shared",
+    N_CONTENTION_OPS,
+    shared_object_setup,
+    freeze_thaw_run,
+    no_reset,
+    g_object_unref },
+  { "notify-freeze-thaw-private",
+    N_CONTENTION_OPS,
+    private_object_setup,
+    freeze_thaw_run,
+    no_reset,
+    g_object_unref },
+  { "emit-no-handlers-private",
+    N_CONTENTION_OPS,
+    private_object_setup,
+    emit_run,
+    no_reset,
+    g_object_unref },
+  { "emit-handler-private",
+    N_CONTENTION_OPS,
+    private_object_with_handler_setup,
+    emit_run,
+    no_reset,
+    g_object_unref },
+  { "property-set-get-private",
+    2 * N_CONTENTION_OPS,
+    private_object_setup,
+    set_get_property_run,
+    no_reset,
+    g_object_unref },
 #if 0
   { "nothing",
+    1,
     no_setup,
     no_run,
     no_reset,
@@ -201,6 +469,8 @@ static const PerformanceTest tests[] = {
 static gboolean verbose = FALSE;
 static int n_threads = 0;
 static gboolean list = FALSE;
+static gboolean scale = FALSE;
+static gboolean json = FALSE;
 static int test_length = DEFAULT_TEST_TIME;
 
 static GOptionEntry cmd_entries[] = {
@@ -212,6 +482,10 @@ static GOptionEntry cmd_entries[] = {
    "Time to run each test in seconds", NULL},
   {"list", 'l', 0, G_OPTION_ARG_NONE, &list, 
    "List all available tests and exit", NULL},
+  {"scale", 0, 0, G_OPTION_ARG_NONE, &scale,
+   "Run each test with 1, 2, 4, ... up to --threads threads", NULL},
+  {"json", 'j', 0, G_OPTION_ARG_NONE, &json,
+   "Print results as JSON", NULL},
   {NULL}
 };
 
@@ -264,10 +538,21 @@ compare_doubles (gconstpointer a, gconstpointer b)
   return 0;
 }
 
+static double
+percentile (GArray *sorted,
+            double  p)
+{
+  return g_array_index (sorted, double, (guint) ((sorted->len - 1) * p)) * 1000;
+}
+
 static void
-print_results (GArray *array)
+print_results (const PerformanceTest *test,
+               guint                  threads,
+               GArray                *array,
+               double                 wall_time,
+               gboolean               first)
 {
-  double min, max, avg;
+  double min, max, avg, ops_per_sec;
   guint i;
 
   g_array_sort (array, compare_doubles);
@@ -282,32 +567,48 @@ print_results (GArray *array)
       avg += g_array_index (array, double, i);
     }
   avg = avg / array->len * 1000;
-
-  g_print ("  %u runs, min/avg/max = %.3f/%.3f/%.3f ms\n", array->len, min, avg, max);
+  ops_per_sec = (double) array->len * test->n_ops / wall_time;
+
+  if (json)
+    g_print ("%s\n  { \"test\": \"%s\", \"threads\": %u, \"runs\": %u, "
+             "\"ops_per_sec\": %.0f, \"min_ms\": %.4f, \"avg_ms\": %.4f, "
+             "\"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f }",
+             first ? "" : ",", test->name, threads, array->len, ops_per_sec,
+             min, avg, percentile (array, 0.5), percentile (array, 0.9),
+             percentile (array, 0.99), max);
+  else
+    g_print ("  %u threads, %u runs, %.0f ops/s, min/avg/p50/p90/p99/max = "
+             "%.3f/%.3f/%.3f/%.3f/%.3f/%.3f ms\n",
+             threads, array->len, ops_per_sec, min, avg,
+             percentile (array, 0.5), percentile (array, 0.9),
+             percentile (array, 0.99), max);
 }
 
 static void
-run_test (const PerformanceTest *test)
+run_test_with_threads (const PerformanceTest *test,
+                       guint                  threads_to_run,
+                       gboolean               first)
 {
   GArray *results;
+  GTimer *wall;
 
-  g_print ("Running test \"%s\"\n", test->name);
+  wall = g_timer_new ();
 
-  if (n_threads == 0) {
+  if (threads_to_run == 0) {
     results = run_test_thread ((gpointer) test);
   } else {
     guint i;
     GThread **threads;
     GArray *thread_results;
       
-    threads = g_new (GThread *, n_threads);
-    for (i = 0; i < n_threads; i++) {
+    threads = g_new (GThread *, threads_to_run);
+    for (i = 0; i < threads_to_run; i++) {
       threads[i] = g_thread_create (run_test_thread, (gpointer) test, TRUE, NULL);
       g_assert (threads[i] != NULL);
     }
 
     results = g_array_new (FALSE, FALSE, sizeof (double));
-    for (i = 0; i < n_threads; i++) {
+    for (i = 0; i < threads_to_run; i++) {
       thread_results = g_thread_join (threads[i]);
       g_array_append_vals (results, thread_results->data, thread_results->len);
       g_array_free (thread_results, TRUE);
@@ -315,8 +616,32 @@ run_test (const PerformanceTest *test)
     g_free (threads);
   }
 
-  print_results (results);
+  print_results (test, MAX (threads_to_run, 1), results,
+                 g_timer_elapsed (wall, NULL), first);
   g_array_free (results, TRUE);
+  g_timer_destroy (wall);
+}
+
+static void
+run_test (const PerformanceTest *test,
+          gboolean               first)
+{
+  guint threads;
+
+  if (!json)
+    g_print ("Running test \"%s\"\n", test->name);
+
+  if (!scale)
+    {
+      run_test_with_threads (test, n_threads, first);
+      return;
+    }
+
+  for (threads = 1; threads <= MAX (n_threads, 1); threads *= 2)
+    {
+      run_test_with_threads (test, threads, first);
+      first = FALSE;
+    }
 }
 
 static const PerformanceTest *
@@ -357,20 +682,34 @@ main (int   argc,
       return 0;
     }
 
+  if (scale && n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  if (json)
+    g_print ("[");
+
   if (argc > 1)
     {
+      gboolean first = TRUE;
+
       for (i = 1; i < argc; i++)
 	{
 	  test = find_test (argv[i]);
 	  if (test)
-	    run_test (test);
+            {
+              run_test (test, first);
+              first = FALSE;
+            }
 	}
     }
   else
     {
       for (i = 0; i < G_N_ELEMENTS (tests); i++)
-	run_test (&tests[i]);
+	run_test (&tests[i], i == 0);
     }
 
+  if (json)
+    g_print ("\n]\n");
+
   return 0;
 }
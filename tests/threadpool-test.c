@@ -37,6 +37,17 @@ static gulong sort_thread_counter = 0;
 
 static GThreadPool *idle_pool = NULL;
 
+static GThreadPool *tree_pool = NULL;
+static gint tree_task_counter = 0;
+static gint many_task_sum = 0;
+
+static GThreadPool *steal_pool = NULL;
+static GMutex steal_mutex;
+static GCond steal_cond;
+static gboolean steal_child_pushed = FALSE;
+static gboolean steal_child_done = FALSE;
+static gboolean steal_child_in_time = FALSE;
+
 static GMainLoop *main_loop = NULL;
 
 static void
@@ -368,6 +379,153 @@ test_thread_idle_time (void)
 		 GUINT_TO_POINTER (interval));
 }
 
+static void
+test_thread_tree_entry_func (gpointer data, gpointer user_data)
+{
+  guint depth = GPOINTER_TO_UINT (data);
+  guint i;
+
+  /* the tasks pushed from here go to this thread's own queue */
+  if (depth > 1)
+    for (i = 0; i < 4; i++)
+      g_thread_pool_push (tree_pool, GUINT_TO_POINTER (depth - 1), NULL);
+
+  g_atomic_int_inc (&tree_task_counter);
+}
+
+static void
+test_thread_tree (void)
+{
+  /* 1 + 4 + ... + 4^6 tasks */
+  const gint n_tasks = 5461;
+  /* the settings are only hints, so any processors will do */
+  const guint cpus[] = { 0, 1 };
+  GThreadPoolStats stats;
+
+  tree_pool = g_thread_pool_new (test_thread_tree_entry_func, NULL, 4, TRUE, NULL);
+  g_thread_pool_set_cpu_affinity (tree_pool, cpus, G_N_ELEMENTS (cpus), TRUE);
+  g_thread_pool_set_thread_priority (tree_pool, TRUE, 5);
+  g_thread_pool_set_timing_stats (tree_pool, TRUE);
+
+  g_thread_pool_push (tree_pool, GUINT_TO_POINTER (7), NULL);
+
+  while (g_atomic_int_get (&tree_task_counter) < n_tasks)
+    g_usleep (1000);
+
+  g_assert_cmpint (g_atomic_int_get (&tree_task_counter), ==, n_tasks);
+  g_assert_cmpuint (g_thread_pool_unprocessed (tree_pool), ==, 0);
+
+  do
+    {
+      g_usleep (1000);
+      g_thread_pool_get_stats (tree_pool, &stats);
+    }
+  while (stats.tasks_completed < (guint64) n_tasks);
+  g_assert_cmpuint (stats.tasks_pushed, ==, n_tasks);
+
+  g_thread_pool_free (tree_pool, FALSE, TRUE);
+}
+
+static void
+test_thread_many_entry_func (gpointer data, gpointer user_data)
+{
+  g_atomic_int_add (&many_task_sum, GPOINTER_TO_INT (data));
+}
+
+static void
+test_thread_many (void)
+{
+  GThreadPool *pool;
+  GThreadPoolStats stats;
+  gpointer tasks[100];
+  guint64 n_waits = 0;
+  gint i, j;
+
+  pool = g_thread_pool_new (test_thread_many_entry_func, NULL, 3, FALSE, NULL);
+  g_thread_pool_set_thread_name (pool, "many");
+  g_thread_pool_set_timing_stats (pool, TRUE);
+
+  for (i = 0; i < 10; i++)
+    {
+      for (j = 0; j < 100; j++)
+        tasks[j] = GINT_TO_POINTER (i * 100 + j + 1);
+      g_assert (g_thread_pool_push_many (pool, tasks, 100, NULL));
+    }
+  g_assert (g_thread_pool_push_many (pool, tasks, 0, NULL));
+
+  do
+    {
+      g_usleep (1000);
+      g_thread_pool_get_stats (pool, &stats);
+    }
+  while (stats.tasks_completed < 1000);
+
+  g_assert_cmpuint (stats.tasks_pushed, ==, 1000);
+  g_assert_cmpuint (stats.tasks_completed, ==, 1000);
+  g_assert_cmpuint (stats.threads_started, >=, 1);
+  for (j = 0; j < G_THREAD_POOL_STATS_N_BUCKETS; j++)
+    n_waits += stats.wait_histogram[j];
+  g_assert_cmpuint (n_waits, ==, 1000);
+  g_assert_cmpuint (stats.max_wait_time * 1000, >=, stats.wait_time);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  g_thread_pool_get_stats (NULL, &stats);
+  g_assert_cmpuint (stats.threads_started, >=, 1);
+
+  g_assert_cmpint (many_task_sum, ==, 1000 * 1001 / 2);
+}
+
+static void
+test_thread_steal_entry_func (gpointer data, gpointer user_data)
+{
+  gint64 end_time;
+
+  if (GPOINTER_TO_INT (data) == 2)
+    {
+      g_mutex_lock (&steal_mutex);
+      steal_child_done = TRUE;
+      g_cond_broadcast (&steal_cond);
+      g_mutex_unlock (&steal_mutex);
+      return;
+    }
+
+  /* the only thread of the pool is busy, so the child is pushed to
+   * this thread's own queue
+   */
+  g_thread_pool_push (steal_pool, GINT_TO_POINTER (2), NULL);
+
+  g_mutex_lock (&steal_mutex);
+  steal_child_pushed = TRUE;
+  g_cond_broadcast (&steal_cond);
+
+  /* ...and a thread started after that has to steal it */
+  end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  while (!steal_child_done)
+    if (!g_cond_wait_until (&steal_cond, &steal_mutex, end_time))
+      break;
+  steal_child_in_time = steal_child_done;
+  g_mutex_unlock (&steal_mutex);
+}
+
+static void
+test_thread_steal (void)
+{
+  steal_pool = g_thread_pool_new (test_thread_steal_entry_func, NULL, 1, FALSE, NULL);
+
+  g_thread_pool_push (steal_pool, GINT_TO_POINTER (1), NULL);
+
+  g_mutex_lock (&steal_mutex);
+  while (!steal_child_pushed)
+    g_cond_wait (&steal_cond, &steal_mutex);
+  g_mutex_unlock (&steal_mutex);
+
+  g_thread_pool_set_max_threads (steal_pool, 2, NULL);
+  g_thread_pool_free (steal_pool, FALSE, TRUE);
+
+  g_assert (steal_child_in_time);
+}
+
 static gboolean
 test_check_start_and_stop (gpointer user_data)
 {
@@ -406,6 +564,15 @@ test_check_start_and_stop (gpointer user_data)
     case 7:
       test_thread_idle_time ();
       break;
+    case 8:
+      test_thread_tree ();
+      break;
+    case 9:
+      test_thread_many ();
+      break;
+    case 10:
+      test_thread_steal ();
+      break;
     default:
       DEBUG_MSG (("***** END OF TESTS *****"));
       g_main_loop_quit (main_loop);